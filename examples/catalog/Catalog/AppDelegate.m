@@ -17,15 +17,33 @@
 #import "AppDelegate.h"
 
 #import "CatalogViewController.h"
+#import "LaunchBenchmark.h"
+#import "ScrollPerformanceHarness.h"
 
 @implementation AppDelegate
 
 - (BOOL)application:(UIApplication *)application didFinishLaunchingWithOptions:(NSDictionary *)launchOptions {
   self.window = [[UIWindow alloc] initWithFrame:[UIScreen mainScreen].bounds];
   self.window.backgroundColor = [UIColor whiteColor];
+
+  // Launch arguments land in the argument domain of the user defaults.
+  if ([[NSUserDefaults standardUserDefaults] boolForKey:LaunchBenchmarkLaunchArgument]) {
+    LaunchBenchmarkViewController* benchmarkController = [[LaunchBenchmarkViewController alloc] init];
+    self.window.rootViewController = [[UINavigationController alloc] initWithRootViewController:benchmarkController];
+    [self.window makeKeyAndVisible];
+    LaunchBenchmarkMarkDidFinishLaunching();
+    return YES;
+  }
+
   CatalogViewController* catalogController = [[CatalogViewController alloc] init];
   self.window.rootViewController = [[UINavigationController alloc] initWithRootViewController:catalogController];
   [self.window makeKeyAndVisible];
+
+  if ([[NSUserDefaults standardUserDefaults] boolForKey:ScrollPerformanceHarnessLaunchArgument]) {
+    dispatch_async(dispatch_get_main_queue(), ^{
+      [catalogController runScrollPerformanceHarness];
+    });
+  }
   return YES;
 }
 
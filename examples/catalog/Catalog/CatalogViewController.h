@@ -18,4 +18,8 @@
 
 // All docs are in the .m.
 @interface CatalogViewController : UITableViewController
+
+// Runs ScrollPerformanceHarness over the catalog's synthetic list screens.
+- (BOOL)runScrollPerformanceHarness;
+
 @end
@@ -72,6 +72,9 @@
 // Web Controller
 #import "ExtraActionsWebViewController.h"
 
+// Performance
+#import "ScrollPerformanceHarness.h"
+
 #import "NimbusModels.h"
 #import "NimbusWebController.h"
 
@@ -100,6 +103,9 @@
   // retain them. We must store the instances in this class.
   NITableViewModel* _model;
   NITableViewActions* _actions;
+
+  // Kept while the scroll performance harness drives the catalog's screens.
+  ScrollPerformanceHarness* _scrollPerformanceHarness;
 }
 
 - (id)initWithStyle:(UITableViewStyle)style {
@@ -406,7 +412,15 @@
                                                    animated:YES];
 
         return NO;
-      }]
+      }],
+
+     @"Performance",
+
+     // Selector actions are sent to the target we gave the actions object, this controller.
+     [_actions attachToObject:
+      [NISubtitleCellObject objectWithTitle:@"Scroll Performance"
+                                   subtitle:@"Measure frame times of every list screen"]
+                  tapSelector:@selector(runScrollPerformanceHarness)]
      ];
 
     // When we create the model we must provide it with a delegate that implements the
@@ -440,4 +454,14 @@
   self.tableView.delegate = [_actions forwardingTo:self];
 }
 
+- (BOOL)runScrollPerformanceHarness {
+  if (nil == _scrollPerformanceHarness) {
+    _scrollPerformanceHarness = [[ScrollPerformanceHarness alloc] initWithNavigationController:self.navigationController];
+  }
+  [_scrollPerformanceHarness runWithCompletion:^(NSArray* reports, NSString* reportPath) {
+    NSLog(@"Scroll performance report written to %@", reportPath);
+  }];
+  return YES;
+}
+
 @end
@@ -0,0 +1,32 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <UIKit/UIKit.h>
+
+// The launch argument that replaces the catalog with the launch benchmark's first screen, e.g.
+// -LaunchBenchmark YES
+extern NSString* const LaunchBenchmarkLaunchArgument;
+
+// Records the moment main() starts. Call it before anything else in main().
+void LaunchBenchmarkMarkMain(void);
+
+// Records the end of application:didFinishLaunchingWithOptions: and starts waiting for the first
+// frame.
+void LaunchBenchmarkMarkDidFinishLaunching(void);
+
+// All docs are in the .m.
+@interface LaunchBenchmarkViewController : UITableViewController
+@end
@@ -0,0 +1,305 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "LaunchBenchmark.h"
+
+#import "NimbusCSS.h"
+#import "NimbusCore.h"
+#import "NimbusModels.h"
+#import "NimbusNetworkImage.h"
+#import <sys/sysctl.h>
+
+//
+// What's going on in this file:
+//
+// This benchmark measures how much of a cold launch is spent in Nimbus. When the catalog is
+// launched with -LaunchBenchmark YES it shows this controller instead of the catalog. The
+// controller builds a typical first screen: a header styled by an NIDOM from a stylesheet, a
+// table of cell objects built by an NITableViewModel and an NICellFactory, and an
+// NINetworkImageView that loads a fixture image from the bundle.
+//
+// The benchmark records:
+//
+// - pre-main: from the process being created to main() running, i.e. dyld, +load methods and
+//   static initializers.
+// - didFinishLaunching: from main() to the end of application:didFinishLaunchingWithOptions:.
+// - first frame: from main() to the first run loop pass that has committed the window's layers.
+// - the time each Nimbus module spends building the first screen.
+//
+// Each module's work is also wrapped in a signpost so that a launch recorded with Instruments'
+// os_signpost tool shows it next to the app's own code. Signposts are only emitted when the
+// catalog is built with NI_SIGNPOSTS=1.
+//
+// When the first frame is on screen and the fixture image has loaded, the benchmark logs the
+// report and writes it to LaunchBenchmark.json in the app's Documents directory.
+// scripts/run_launch_benchmark.sh cold-launches the catalog repeatedly in the simulator and
+// collects the reports along with the current commit, so that regressions show up across
+// commits. Measure Release builds; Debug builds mostly measure the lack of optimization.
+//
+// You will find the following Nimbus features used:
+//
+// [core]
+// NI_SIGNPOST_BEGIN
+// NI_SIGNPOST_END
+// NIPathForBundleResource
+// NIPathForDocumentsResource
+//
+// [css]
+// NIStylesheet
+// NIDOM
+//
+// [models]
+// NITableViewModel
+// NICellFactory
+//
+// [networkimage]
+// NINetworkImageView
+//
+// This controller requires the following frameworks:
+//
+// Foundation.framework
+// UIKit.framework
+//
+
+NSString* const LaunchBenchmarkLaunchArgument = @"LaunchBenchmark";
+
+// The number of rows on the first screen.
+static const NSInteger kNumberOfRows = 40;
+
+static NSString* const kStylesheet =
+  @".header {"
+  @"  background-color: #f7f7f7;"
+  @"  height: 120px;"
+  @"}"
+  @".headerTitle {"
+  @"  color: #333333;"
+  @"  font-size: 22;"
+  @"  font-weight: bold;"
+  @"  text-shadow: rgba(255, 255, 255, 0.8) 0 1;"
+  @"  left: 110px;"
+  @"  top: 20px;"
+  @"  width: 200px;"
+  @"  height: 30px;"
+  @"}"
+  @".headerSubtitle {"
+  @"  color: #777777;"
+  @"  font-size: 14;"
+  @"  -ios-number-of-lines: 2;"
+  @"  left: 110px;"
+  @"  top: 54px;"
+  @"  width: 200px;"
+  @"  height: 40px;"
+  @"}"
+  @".headerImage {"
+  @"  left: 10px;"
+  @"  top: 10px;"
+  @"  width: 90px;"
+  @"  height: 90px;"
+  @"}";
+
+static CFAbsoluteTime sMainTime = 0;
+static CFAbsoluteTime sDidFinishLaunchingTime = 0;
+static CFAbsoluteTime sFirstFrameTime = 0;
+static __weak LaunchBenchmarkViewController* sController = nil;
+
+@interface LaunchBenchmarkViewController () <NINetworkImageViewDelegate>
+@property (nonatomic, strong) NIStylesheet* stylesheet;
+@property (nonatomic, strong) NIDOM* dom;
+@property (nonatomic, strong) NITableViewModel* model;
+@property (nonatomic, strong) NINetworkImageView* imageView;
+@property (nonatomic, strong) NSMutableDictionary* phaseDurations; // Of NSNumber, in seconds.
+@property (nonatomic) CFAbsoluteTime imageRequestTime;
+@property (nonatomic) BOOL didLoadImage;
+@property (nonatomic) BOOL didReport;
+- (void)firstFrameDidCommit;
+@end
+
+#pragma mark - Launch Markers
+
+// The time the kernel created this process, i.e. before dyld started loading the app.
+static CFAbsoluteTime ProcessStartTime(void) {
+  struct kinfo_proc info;
+  size_t size = sizeof(info);
+  int mib[] = { CTL_KERN, KERN_PROC, KERN_PROC_PID, getpid() };
+  if (0 != sysctl(mib, sizeof(mib) / sizeof(mib[0]), &info, &size, NULL, 0)) {
+    return 0;
+  }
+  struct timeval startTime = info.kp_proc.p_starttime;
+  return (startTime.tv_sec + startTime.tv_usec / 1e6) - kCFAbsoluteTimeIntervalSince1970;
+}
+
+void LaunchBenchmarkMarkMain(void) {
+  sMainTime = CFAbsoluteTimeGetCurrent();
+}
+
+void LaunchBenchmarkMarkDidFinishLaunching(void) {
+  sDidFinishLaunchingTime = CFAbsoluteTimeGetCurrent();
+
+  // Core Animation commits the window's layers from a before-waiting observer of its own, so the
+  // first before-waiting pass after launch ends with the first frame handed to the render
+  // server. Ordering this observer last puts it after that commit.
+  CFRunLoopObserverRef observer =
+    CFRunLoopObserverCreateWithHandler(kCFAllocatorDefault, kCFRunLoopBeforeWaiting, NO, LONG_MAX,
+                                       ^(CFRunLoopObserverRef observer, CFRunLoopActivity activity) {
+      sFirstFrameTime = CFAbsoluteTimeGetCurrent();
+      [sController firstFrameDidCommit];
+    });
+  CFRunLoopAddObserver(CFRunLoopGetMain(), observer, kCFRunLoopCommonModes);
+  CFRelease(observer);
+}
+
+@implementation LaunchBenchmarkViewController
+
+
+- (id)initWithStyle:(UITableViewStyle)style {
+  if ((self = [super initWithStyle:UITableViewStylePlain])) {
+    self.title = @"Launch Benchmark";
+    _phaseDurations = [NSMutableDictionary dictionary];
+    sController = self;
+  }
+  return self;
+}
+
+- (void)measurePhase:(NSString *)name block:(void (^)(void))block {
+  CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+  block();
+  NSTimeInterval duration = CFAbsoluteTimeGetCurrent() - start;
+  self.phaseDurations[name] = @([self.phaseDurations[name] doubleValue] + duration);
+}
+
+- (void)viewDidLoad {
+  [super viewDidLoad];
+
+  [self measurePhase:@"css" block:^{
+    NI_SIGNPOST_BEGIN(NISignpostCategoryCSS, "Launch Stylesheet", self);
+    self.stylesheet = [[NIStylesheet alloc] init];
+    [self.stylesheet loadFromData:[kStylesheet dataUsingEncoding:NSUTF8StringEncoding]
+                       pathPrefix:nil
+                         delegate:nil];
+    self.dom = [NIDOM domWithStylesheet:self.stylesheet];
+    NI_SIGNPOST_END(NISignpostCategoryCSS, "Launch Stylesheet", self);
+  }];
+
+  UIView* header = [[UIView alloc] initWithFrame:CGRectMake(0, 0, self.view.bounds.size.width, 120)];
+  UILabel* titleLabel = [[UILabel alloc] init];
+  titleLabel.text = @"Nimbus";
+  UILabel* subtitleLabel = [[UILabel alloc] init];
+  subtitleLabel.text = @"An iOS framework whose growth is bounded by O(documentation).";
+  self.imageView = [[NINetworkImageView alloc] init];
+  self.imageView.delegate = self;
+  [header addSubview:self.imageView];
+  [header addSubview:titleLabel];
+  [header addSubview:subtitleLabel];
+
+  [self measurePhase:@"css" block:^{
+    NI_SIGNPOST_BEGIN(NISignpostCategoryCSS, "Launch Style Views", self);
+    [self.dom registerView:header withCSSClass:@"header"];
+    [self.dom registerView:titleLabel withCSSClass:@"headerTitle"];
+    [self.dom registerView:subtitleLabel withCSSClass:@"headerSubtitle"];
+    [self.dom registerView:self.imageView withCSSClass:@"headerImage"];
+    NI_SIGNPOST_END(NISignpostCategoryCSS, "Launch Style Views", self);
+  }];
+  self.tableView.tableHeaderView = header;
+
+  [self measurePhase:@"models" block:^{
+    NI_SIGNPOST_BEGIN(NISignpostCategoryModels, "Launch Table Model", self);
+    NSMutableArray* contents = [NSMutableArray array];
+    for (NSInteger ix = 0; ix < kNumberOfRows; ++ix) {
+      if (0 == ix % 10) {
+        [contents addObject:[NSString stringWithFormat:@"Section %zd", ix / 10 + 1]];
+      }
+      [contents addObject:[NISubtitleCellObject objectWithTitle:[NSString stringWithFormat:@"Row %zd", ix + 1]
+                                                       subtitle:@"Built by NICellFactory"]];
+    }
+    self.model = [[NITableViewModel alloc] initWithSectionedArray:contents
+                                                         delegate:(id)[NICellFactory class]];
+    self.tableView.dataSource = self.model;
+    NI_SIGNPOST_END(NISignpostCategoryModels, "Launch Table Model", self);
+  }];
+
+  // The fixture goes through the same file URL path as any other image. It is timed from here
+  // until the image view reports it as loaded.
+  NI_SIGNPOST_BEGIN(NISignpostCategoryImages, "Launch Image", self);
+  self.imageRequestTime = CFAbsoluteTimeGetCurrent();
+  NSURL* fixtureURL = [NSURL fileURLWithPath:NIPathForBundleResource(nil, @"dilly.jpg")];
+  [self.imageView setPathToNetworkImage:[fixtureURL absoluteString]];
+}
+
+- (void)viewWillAppear:(BOOL)animated {
+  [super viewWillAppear:animated];
+
+  // The first layout of the table view is when the cell factory creates the visible cells.
+  [self measurePhase:@"models" block:^{
+    NI_SIGNPOST_BEGIN(NISignpostCategoryModels, "Launch Cells", self);
+    [self.tableView layoutIfNeeded];
+    NI_SIGNPOST_END(NISignpostCategoryModels, "Launch Cells", self);
+  }];
+}
+
+#pragma mark - NINetworkImageViewDelegate
+
+- (void)networkImageView:(NINetworkImageView *)imageView didLoadImage:(UIImage *)image {
+  NI_SIGNPOST_END(NISignpostCategoryImages, "Launch Image", self);
+  self.phaseDurations[@"networkimage"] = @(CFAbsoluteTimeGetCurrent() - self.imageRequestTime);
+  self.didLoadImage = YES;
+  [self reportIfFinished];
+}
+
+- (void)networkImageView:(NINetworkImageView *)imageView didFailWithError:(NSError *)error {
+  NI_SIGNPOST_END(NISignpostCategoryImages, "Launch Image", self);
+  NSLog(@"[Launch benchmark] The fixture image failed to load: %@", error);
+  self.didLoadImage = YES;
+  [self reportIfFinished];
+}
+
+#pragma mark - Reporting
+
+- (void)firstFrameDidCommit {
+  [self reportIfFinished];
+}
+
+- (void)reportIfFinished {
+  if (self.didReport || !self.didLoadImage || 0 == sFirstFrameTime) {
+    return;
+  }
+  self.didReport = YES;
+
+  CFAbsoluteTime processStartTime = ProcessStartTime();
+  NSDictionary* report = @{
+    @"device": [UIDevice currentDevice].model,
+    @"system": [UIDevice currentDevice].systemVersion,
+    @"date": [[NSDate date] description],
+    @"units": @"ms",
+    @"preMain": @((processStartTime > 0) ? (sMainTime - processStartTime) * 1000 : 0),
+    @"didFinishLaunching": @((sDidFinishLaunchingTime - sMainTime) * 1000),
+    @"firstFrame": @((sFirstFrameTime - sMainTime) * 1000),
+    @"modules": @{
+      @"css": @([self.phaseDurations[@"css"] doubleValue] * 1000),
+      @"models": @([self.phaseDurations[@"models"] doubleValue] * 1000),
+      @"networkimage": @([self.phaseDurations[@"networkimage"] doubleValue] * 1000),
+    },
+  };
+  NSData* json = [NSJSONSerialization dataWithJSONObject:report options:NSJSONWritingPrettyPrinted error:nil];
+  [json writeToFile:NIPathForDocumentsResource(@"LaunchBenchmark.json") atomically:YES];
+
+  NSLog(@"[Launch benchmark] pre-main %.1fms, didFinishLaunching %.1fms, first frame %.1fms, css %.1fms, models %.1fms, networkimage %.1fms",
+        [report[@"preMain"] doubleValue], [report[@"didFinishLaunching"] doubleValue],
+        [report[@"firstFrame"] doubleValue], [report[@"modules"][@"css"] doubleValue],
+        [report[@"modules"][@"models"] doubleValue],
+        [report[@"modules"][@"networkimage"] doubleValue]);
+}
+
+@end
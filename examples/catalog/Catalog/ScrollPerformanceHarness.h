@@ -0,0 +1,33 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <UIKit/UIKit.h>
+
+// The launch argument that runs the harness as soon as the catalog starts, e.g.
+// -ScrollPerformanceHarness YES
+extern NSString* const ScrollPerformanceHarnessLaunchArgument;
+
+// All docs are in the .m.
+@interface ScrollPerformanceHarness : NSObject
+
+- (id)initWithNavigationController:(UINavigationController *)navigationController;
+
+- (void)runWithCompletion:(void (^)(NSArray* reports, NSString* reportPath))completion;
+
+@property (nonatomic, readonly, getter = isRunning) BOOL running;
+
+@end
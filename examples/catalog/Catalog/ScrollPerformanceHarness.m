@@ -0,0 +1,307 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "ScrollPerformanceHarness.h"
+
+#import "ScrollPerformanceViewControllers.h"
+
+#import "NimbusCore.h"
+#import <QuartzCore/QuartzCore.h>
+
+//
+// What's going on in this file:
+//
+// This harness measures how smoothly the catalog's table and collection screens scroll. For
+// each screen it pushes a controller full of synthetic rows, waits for the screen to settle and
+// then moves the scroll view at a fixed velocity on every CADisplayLink tick, bouncing between
+// the ends of the content. The time between ticks is recorded for every frame.
+//
+// When every screen has been measured the harness writes a report with the 50th, 95th and 99th
+// percentile frame times and the number of hitches (frames that took more than one and a half
+// frame durations) to ScrollPerformance.json in the app's Documents directory and logs a
+// summary. Compare reports from the same device to catch regressions in the model and image
+// pipelines.
+//
+// Run it from the "Performance" section of the catalog, or launch the catalog with
+// -ScrollPerformanceHarness YES to run it unattended.
+//
+// You will find the following Nimbus features used:
+//
+// [core]
+// NIPathForDocumentsResource
+//
+// This controller requires the following frameworks:
+//
+// Foundation.framework
+// UIKit.framework
+// QuartzCore.framework
+//
+
+NSString* const ScrollPerformanceHarnessLaunchArgument = @"ScrollPerformanceHarness";
+
+// How long each screen is left alone after being pushed before it is measured.
+static const NSTimeInterval kSettleDuration = 1;
+// How long each screen is scrolled at each velocity.
+static const NSTimeInterval kScrollDuration = 8;
+// Frames longer than this many frame durations count as hitches.
+static const CGFloat kHitchThreshold = 1.5;
+
+// One screen at one velocity.
+@interface ScrollPerformanceScenario : NSObject
+@property (nonatomic, copy) NSString* name;
+@property (nonatomic) NSUInteger numberOfRows;
+@property (nonatomic) CGFloat velocity; // Points per second.
+@property (nonatomic, copy) UIViewController* (^createController)(void);
+@end
+
+@implementation ScrollPerformanceScenario
+@end
+
+@interface ScrollPerformanceHarness ()
+@property (nonatomic, weak) UINavigationController* navigationController;
+@property (nonatomic, strong) NSMutableArray* pendingScenarios;
+@property (nonatomic, strong) NSMutableArray* reports;
+@property (nonatomic, copy) void (^completion)(NSArray* reports, NSString* reportPath);
+@property (nonatomic, readwrite, getter = isRunning) BOOL running;
+
+// The scenario being measured.
+@property (nonatomic, strong) ScrollPerformanceScenario* scenario;
+@property (nonatomic, weak) UIScrollView* scrollView;
+@property (nonatomic, strong) CADisplayLink* displayLink;
+@property (nonatomic) CFTimeInterval startTimestamp;
+@property (nonatomic) CFTimeInterval lastTimestamp;
+@property (nonatomic) CGFloat direction;
+@property (nonatomic, strong) NSMutableData* frameTimes; // Of double, in seconds.
+@end
+
+@implementation ScrollPerformanceHarness
+
+- (void)dealloc {
+  [_displayLink invalidate];
+}
+
+- (id)initWithNavigationController:(UINavigationController *)navigationController {
+  if ((self = [super init])) {
+    _navigationController = navigationController;
+  }
+  return self;
+}
+
+#pragma mark - Scenarios
+
+- (void)addScenariosWithName:(NSString *)name rowCounts:(NSArray *)rowCounts createController:(UIViewController* (^)(NSUInteger numberOfRows))createController {
+  // Slow drags and fast flings stress different things: cell configuration versus layout and
+  // image decoding keeping up.
+  for (NSNumber* rowCount in rowCounts) {
+    for (NSNumber* velocity in @[@(1500), @(6000)]) {
+      ScrollPerformanceScenario* scenario = [[ScrollPerformanceScenario alloc] init];
+      scenario.name = name;
+      scenario.numberOfRows = [rowCount unsignedIntegerValue];
+      scenario.velocity = [velocity floatValue];
+      scenario.createController = ^UIViewController *{
+        return createController([rowCount unsignedIntegerValue]);
+      };
+      [self.pendingScenarios addObject:scenario];
+    }
+  }
+}
+
+- (void)addAllScenarios {
+  NSArray* rowCounts = @[@(1000), @(10000), @(50000)];
+  NSDictionary* tableContents = @{
+    @"Subtitle Cells": @(ScrollPerformanceTableContentSubtitleCells),
+    @"Block Cells": @(ScrollPerformanceTableContentBlockCells),
+    @"Attributed Label Cells": @(ScrollPerformanceTableContentAttributedLabelCells),
+    @"Network Image Cells": @(ScrollPerformanceTableContentNetworkImageCells),
+  };
+  for (NSString* name in [[tableContents allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+    ScrollPerformanceTableContent content = [tableContents[name] intValue];
+    [self addScenariosWithName:name rowCounts:rowCounts createController:^UIViewController *(NSUInteger numberOfRows) {
+      return [[ScrollPerformanceTableViewController alloc] initWithContent:content numberOfRows:numberOfRows];
+    }];
+  }
+  [self addScenariosWithName:@"Collection Color Cells" rowCounts:rowCounts createController:^UIViewController *(NSUInteger numberOfRows) {
+    return [[ScrollPerformanceCollectionViewController alloc] initWithNumberOfItems:numberOfRows];
+  }];
+}
+
+#pragma mark - Running
+
+- (void)runWithCompletion:(void (^)(NSArray *, NSString *))completion {
+  if (self.running || nil == self.navigationController) {
+    return;
+  }
+  self.running = YES;
+  self.completion = completion;
+  self.pendingScenarios = [NSMutableArray array];
+  self.reports = [NSMutableArray array];
+  [self addAllScenarios];
+
+  // Keep the harness alive until it finishes, even if whoever started it lets go.
+  [self runNextScenarioRetainingHarness:self];
+}
+
+- (void)runNextScenarioRetainingHarness:(ScrollPerformanceHarness *)harness {
+  if (0 == self.pendingScenarios.count || nil == self.navigationController) {
+    [self finish];
+    return;
+  }
+  self.scenario = self.pendingScenarios[0];
+  [self.pendingScenarios removeObjectAtIndex:0];
+
+  UIViewController* controller = self.scenario.createController();
+  [self.navigationController pushViewController:controller animated:NO];
+
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kSettleDuration * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+    [harness startScrollingView:[harness scrollViewOfController:controller]];
+  });
+}
+
+- (UIScrollView *)scrollViewOfController:(UIViewController *)controller {
+  if ([controller isKindOfClass:[UITableViewController class]]) {
+    return [(UITableViewController *)controller tableView];
+  } else if ([controller isKindOfClass:[UICollectionViewController class]]) {
+    return [(UICollectionViewController *)controller collectionView];
+  }
+  return nil;
+}
+
+- (void)startScrollingView:(UIScrollView *)scrollView {
+  self.scrollView = scrollView;
+  self.frameTimes = [NSMutableData data];
+  self.startTimestamp = 0;
+  self.lastTimestamp = 0;
+  self.direction = 1;
+  self.displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(displayLinkDidFire:)];
+  [self.displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+}
+
+- (void)displayLinkDidFire:(CADisplayLink *)displayLink {
+  UIScrollView* scrollView = self.scrollView;
+  if (0 == self.lastTimestamp) {
+    self.startTimestamp = displayLink.timestamp;
+    self.lastTimestamp = displayLink.timestamp;
+    return;
+  }
+
+  double frameTime = displayLink.timestamp - self.lastTimestamp;
+  [self.frameTimes appendBytes:&frameTime length:sizeof(frameTime)];
+  self.lastTimestamp = displayLink.timestamp;
+
+  // Move by the time that actually passed so that a slow frame doesn't slow the scroll down.
+  CGFloat maxOffset = MAX(0, scrollView.contentSize.height - scrollView.bounds.size.height);
+  CGFloat offset = scrollView.contentOffset.y + self.direction * self.scenario.velocity * (CGFloat)frameTime;
+  if (offset >= maxOffset) {
+    offset = maxOffset;
+    self.direction = -1;
+  } else if (offset <= 0) {
+    offset = 0;
+    self.direction = 1;
+  }
+  scrollView.contentOffset = CGPointMake(scrollView.contentOffset.x, offset);
+
+  if (nil == scrollView || displayLink.timestamp - self.startTimestamp >= kScrollDuration) {
+    [self finishScenarioWithExpectedFrameTime:displayLink.duration];
+  }
+}
+
+- (void)finishScenarioWithExpectedFrameTime:(CFTimeInterval)expectedFrameTime {
+  [self.displayLink invalidate];
+  self.displayLink = nil;
+
+  [self.reports addObject:[self reportForFrameTimes:self.frameTimes expectedFrameTime:expectedFrameTime]];
+  [self.navigationController popViewControllerAnimated:NO];
+  self.scenario = nil;
+  self.frameTimes = nil;
+
+  // Let the popped controller deallocate before the next one is built.
+  dispatch_async(dispatch_get_main_queue(), ^{
+    [self runNextScenarioRetainingHarness:self];
+  });
+}
+
+#pragma mark - Reporting
+
+static double PercentileOfSortedFrameTimes(const double* frameTimes, NSUInteger count, double percentile) {
+  if (0 == count) {
+    return 0;
+  }
+  NSUInteger index = (NSUInteger)ceil(percentile * count) - 1;
+  return frameTimes[MIN(index, count - 1)];
+}
+
+static int CompareFrameTimes(const void* a, const void* b) {
+  double first = *(const double *)a;
+  double second = *(const double *)b;
+  return (first < second) ? -1 : ((first > second) ? 1 : 0);
+}
+
+- (NSDictionary *)reportForFrameTimes:(NSData *)frameTimeData expectedFrameTime:(CFTimeInterval)expectedFrameTime {
+  NSUInteger count = frameTimeData.length / sizeof(double);
+  NSMutableData* sortedData = [frameTimeData mutableCopy];
+  double* sorted = sortedData.mutableBytes;
+  qsort(sorted, count, sizeof(double), CompareFrameTimes);
+
+  NSUInteger numberOfHitches = 0;
+  for (NSUInteger ix = 0; ix < count; ++ix) {
+    if (sorted[ix] > expectedFrameTime * kHitchThreshold) {
+      ++numberOfHitches;
+    }
+  }
+
+  return @{
+    @"screen": self.scenario.name,
+    @"rows": @(self.scenario.numberOfRows),
+    @"velocity": @(self.scenario.velocity),
+    @"frames": @(count),
+    @"p50": @(PercentileOfSortedFrameTimes(sorted, count, 0.50) * 1000),
+    @"p95": @(PercentileOfSortedFrameTimes(sorted, count, 0.95) * 1000),
+    @"p99": @(PercentileOfSortedFrameTimes(sorted, count, 0.99) * 1000),
+    @"hitches": @(numberOfHitches),
+  };
+}
+
+- (void)finish {
+  NSString* reportPath = NIPathForDocumentsResource(@"ScrollPerformance.json");
+  NSDictionary* document = @{
+    @"device": [UIDevice currentDevice].model,
+    @"system": [UIDevice currentDevice].systemVersion,
+    @"date": [[NSDate date] description],
+    @"units": @"ms",
+    @"screens": self.reports,
+  };
+  NSData* json = [NSJSONSerialization dataWithJSONObject:document options:NSJSONWritingPrettyPrinted error:nil];
+  if (![json writeToFile:reportPath atomically:YES]) {
+    reportPath = nil;
+  }
+
+  for (NSDictionary* report in self.reports) {
+    NSLog(@"[Scroll performance] %@ (%@ rows @ %@pt/s): p50 %.1fms p95 %.1fms p99 %.1fms, %@ hitches in %@ frames",
+          report[@"screen"], report[@"rows"], report[@"velocity"],
+          [report[@"p50"] doubleValue], [report[@"p95"] doubleValue], [report[@"p99"] doubleValue],
+          report[@"hitches"], report[@"frames"]);
+  }
+
+  self.running = NO;
+  void (^completion)(NSArray *, NSString *) = self.completion;
+  self.completion = nil;
+  if (nil != completion) {
+    completion([self.reports copy], reportPath);
+  }
+}
+
+@end
@@ -0,0 +1,239 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "ScrollPerformanceViewControllers.h"
+
+#import "ColorCell.h"
+
+#import "NimbusAttributedLabel.h"
+#import "NimbusCollections.h"
+#import "NimbusCore.h"
+#import "NimbusModels.h"
+#import "NimbusNetworkImage.h"
+
+//
+// What's going on in this file:
+//
+// These controllers are the synthetic screens driven by ScrollPerformanceHarness. Each one fills
+// a table or collection view with thousands of generated rows that use the same Nimbus cells as
+// the rest of the catalog, so that scrolling them exercises the models, cell factories,
+// attributed labels and network images at a realistic scale.
+//
+// You will find the following Nimbus features used:
+//
+// [models]
+// NITableViewModel
+// NICellFactory
+// NICellObject
+// NISubtitleCellObject
+// NIDrawRectBlockCellObject
+//
+// [collections]
+// NICollectionViewModel
+// NICollectionViewCellFactory
+//
+// [attributedlabel]
+// NIAttributedLabel
+//
+// [networkimage]
+// NINetworkImageView
+//
+// This controller requires the following frameworks:
+//
+// Foundation.framework
+// UIKit.framework
+// CoreText.framework
+// QuartzCore.framework
+//
+
+static const CGFloat kRowHeight = 60;
+
+// A cell that displays its object's userInfo string in an attributed label with link detection.
+@interface ScrollPerformanceAttributedLabelCell : UITableViewCell <NICell>
+@property (nonatomic, strong) NIAttributedLabel* label;
+@end
+
+@implementation ScrollPerformanceAttributedLabelCell
+
+- (id)initWithStyle:(UITableViewCellStyle)style reuseIdentifier:(NSString *)reuseIdentifier {
+  if ((self = [super initWithStyle:style reuseIdentifier:reuseIdentifier])) {
+    _label = [[NIAttributedLabel alloc] initWithFrame:CGRectZero];
+    _label.numberOfLines = 2;
+    _label.font = [UIFont systemFontOfSize:14];
+    _label.autoDetectLinks = YES;
+    _label.autoresizingMask = UIViewAutoresizingFlexibleDimensions;
+    [self.contentView addSubview:_label];
+  }
+  return self;
+}
+
+- (void)layoutSubviews {
+  [super layoutSubviews];
+  self.label.frame = CGRectInset(self.contentView.bounds, 10, 5);
+}
+
+- (BOOL)shouldUpdateCellWithObject:(NICellObject *)object {
+  self.label.text = object.userInfo;
+  return YES;
+}
+
+@end
+
+// A cell that loads its object's userInfo URL into a network image view.
+@interface ScrollPerformanceNetworkImageCell : UITableViewCell <NICell>
+@property (nonatomic, strong) NINetworkImageView* networkImageView;
+@end
+
+@implementation ScrollPerformanceNetworkImageCell
+
+- (id)initWithStyle:(UITableViewCellStyle)style reuseIdentifier:(NSString *)reuseIdentifier {
+  if ((self = [super initWithStyle:style reuseIdentifier:reuseIdentifier])) {
+    _networkImageView = [[NINetworkImageView alloc] initWithFrame:CGRectMake(5, 5, kRowHeight - 10, kRowHeight - 10)];
+    [self.contentView addSubview:_networkImageView];
+  }
+  return self;
+}
+
+- (void)prepareForReuse {
+  [super prepareForReuse];
+  [self.networkImageView prepareForReuse];
+}
+
+- (BOOL)shouldUpdateCellWithObject:(NICellObject *)object {
+  [self.networkImageView setPathToNetworkImage:object.userInfo forDisplaySize:self.networkImageView.bounds.size];
+  return YES;
+}
+
+@end
+
+@interface ScrollPerformanceTableViewController ()
+@property (nonatomic, strong) NITableViewModel* model;
+@end
+
+@implementation ScrollPerformanceTableViewController
+
++ (NSString *)titleForContent:(ScrollPerformanceTableContent)content {
+  switch (content) {
+    case ScrollPerformanceTableContentSubtitleCells: return @"Subtitle Cells";
+    case ScrollPerformanceTableContentBlockCells: return @"Block Cells";
+    case ScrollPerformanceTableContentAttributedLabelCells: return @"Attributed Label Cells";
+    case ScrollPerformanceTableContentNetworkImageCells: return @"Network Image Cells";
+  }
+  return nil;
+}
+
++ (id)objectForRow:(NSUInteger)row content:(ScrollPerformanceTableContent)content drawBlock:(NICellDrawRectBlock)drawBlock {
+  switch (content) {
+    case ScrollPerformanceTableContentSubtitleCells:
+      return [NISubtitleCellObject objectWithTitle:[NSString stringWithFormat:@"Row %lu", (unsigned long)row]
+                                          subtitle:@"A synthetic row for measuring scroll performance"];
+    case ScrollPerformanceTableContentBlockCells:
+      return [NIDrawRectBlockCellObject objectWithBlock:drawBlock
+                                                 object:[NSString stringWithFormat:@"Row %lu", (unsigned long)row]];
+    case ScrollPerformanceTableContentAttributedLabelCells:
+      return [NICellObject objectWithCellClass:[ScrollPerformanceAttributedLabelCell class]
+                                      userInfo:[NSString stringWithFormat:@"Row %lu links to http://nimbuskit.info/%lu and mentions nothing else of note.",
+                                                (unsigned long)row, (unsigned long)row]];
+    case ScrollPerformanceTableContentNetworkImageCells:
+      // Identicons are generated from the hash, so every row gets a distinct image.
+      return [NICellObject objectWithCellClass:[ScrollPerformanceNetworkImageCell class]
+                                      userInfo:[NSString stringWithFormat:@"http://www.gravatar.com/avatar/%@?s=100&d=identicon",
+                                                NIMD5HashFromString([NSString stringWithFormat:@"%lu", (unsigned long)row])]];
+  }
+  return nil;
+}
+
+- (id)initWithContent:(ScrollPerformanceTableContent)content numberOfRows:(NSUInteger)numberOfRows {
+  if ((self = [super initWithStyle:UITableViewStylePlain])) {
+    self.title = [NSString stringWithFormat:@"%@ (%lu)", [[self class] titleForContent:content], (unsigned long)numberOfRows];
+
+    NICellDrawRectBlock drawBlock = ^CGFloat(CGRect rect, id object, UITableViewCell *cell) {
+      [[UIColor whiteColor] set];
+      UIRectFill(rect);
+      [[UIColor blackColor] set];
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+      [object drawAtPoint:CGPointMake(10, 5) withFont:[UIFont boldSystemFontOfSize:16]];
+#pragma clang diagnostic pop
+      return 0;
+    };
+
+    NSMutableArray* objects = [NSMutableArray arrayWithCapacity:numberOfRows];
+    for (NSUInteger row = 0; row < numberOfRows; ++row) {
+      [objects addObject:[[self class] objectForRow:row content:content drawBlock:drawBlock]];
+    }
+    _model = [[NITableViewModel alloc] initWithListArray:objects delegate:(id)[NICellFactory class]];
+  }
+  return self;
+}
+
+- (id)initWithStyle:(UITableViewStyle)style {
+  return [self initWithContent:ScrollPerformanceTableContentSubtitleCells numberOfRows:1000];
+}
+
+- (void)viewDidLoad {
+  [super viewDidLoad];
+
+  self.tableView.rowHeight = kRowHeight;
+  self.tableView.dataSource = self.model;
+}
+
+- (BOOL)shouldAutorotateToInterfaceOrientation:(UIInterfaceOrientation)toInterfaceOrientation {
+  return NIIsSupportedOrientation(toInterfaceOrientation);
+}
+
+@end
+
+@interface ScrollPerformanceCollectionViewController ()
+@property (nonatomic, strong) NICollectionViewModel* model;
+@end
+
+@implementation ScrollPerformanceCollectionViewController
+
+- (id)initWithNumberOfItems:(NSUInteger)numberOfItems {
+  UICollectionViewFlowLayout* flowLayout = [[UICollectionViewFlowLayout alloc] init];
+  flowLayout.itemSize = CGSizeMake(70, 70);
+  if ((self = [super initWithCollectionViewLayout:flowLayout])) {
+    self.title = [NSString stringWithFormat:@"Color Cells (%lu)", (unsigned long)numberOfItems];
+
+    NSMutableArray* objects = [NSMutableArray arrayWithCapacity:numberOfItems];
+    for (NSUInteger item = 0; item < numberOfItems; ++item) {
+      UIColor* color = [UIColor colorWithHue:(CGFloat)(item % 360) / 360 saturation:0.8 brightness:0.9 alpha:1];
+      [objects addObject:[Color colorWithColor:color]];
+    }
+    _model = [[NICollectionViewModel alloc] initWithListArray:objects
+                                                     delegate:(id)[NICollectionViewCellFactory class]];
+  }
+  return self;
+}
+
+- (id)initWithCollectionViewLayout:(UICollectionViewLayout *)layout {
+  return [self initWithNumberOfItems:1000];
+}
+
+- (void)viewDidLoad {
+  [super viewDidLoad];
+
+  self.collectionView.backgroundColor = [UIColor whiteColor];
+  self.collectionView.dataSource = self.model;
+}
+
+- (BOOL)shouldAutorotateToInterfaceOrientation:(UIInterfaceOrientation)toInterfaceOrientation {
+  return NIIsSupportedOrientation(toInterfaceOrientation);
+}
+
+@end
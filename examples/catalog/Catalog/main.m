@@ -17,8 +17,10 @@
 #import <UIKit/UIKit.h>
 
 #import "AppDelegate.h"
+#import "LaunchBenchmark.h"
 
 int main(int argc, char *argv[]) {
+  LaunchBenchmarkMarkMain();
   @autoreleasepool {
     return UIApplicationMain(argc, argv, nil, NSStringFromClass([AppDelegate class]));
   }
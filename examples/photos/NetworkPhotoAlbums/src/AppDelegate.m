@@ -19,6 +19,7 @@
 #import "FacebookPhotoAlbumViewController.h"
 #import "CatalogTableViewController.h"
 #import "NimbusOverview.h"
+#import "PhotoAlbumBenchmark.h"
 
 
 @implementation AppDelegate
@@ -40,6 +41,11 @@
   _rootViewController = [[UINavigationController alloc] initWithRootViewController:catalogVC];
   self.window.rootViewController = _rootViewController;
 
+  if ([PhotoAlbumBenchmark isEnabled]) {
+    UINavigationController* navigationController = (UINavigationController *)_rootViewController;
+    [navigationController pushViewController:[PhotoAlbumBenchmark startBenchmark] animated:NO];
+  }
+
   [self.window makeKeyAndVisible];
 
   [NIOverview addOverviewToWindow:self.window];
@@ -21,6 +21,7 @@
 #import "NIOverviewView.h"
 #import "NIOverviewPageView.h"
 #import "AFNetworking.h"
+#import "PhotoAlbumBenchmark.h"
 
 #ifdef DEBUG
 @interface NetworkPhotoAlbumViewController()
@@ -82,7 +83,11 @@
   NSString* photoIndexKey = [self cacheKeyForPhotoIndex:photoIndex];
 
   AFHTTPRequestOperation* readOp = [[AFHTTPRequestOperation alloc] initWithRequest:request];
-  AFImageResponseSerializer* responseSerializer = [AFImageResponseSerializer serializer];
+  // When the benchmark is running it measures the time spent decoding each image.
+  PhotoAlbumBenchmark* benchmark = [PhotoAlbumBenchmark activeBenchmark];
+  AFImageResponseSerializer* responseSerializer = ((nil != benchmark)
+                                                   ? [benchmark imageResponseSerializer]
+                                                   : [AFImageResponseSerializer serializer]);
   responseSerializer.imageScale = 1;
   readOp.responseSerializer = responseSerializer;
 
@@ -107,6 +112,8 @@
       [self.photoScrubberView didLoadThumbnail:image atIndex:photoIndex];
     }
 
+    [benchmark controller:self didLoadImage:image photoSize:photoSize];
+
     [_activeRequests removeObject:identifierKey];
 
   } failure:nil];
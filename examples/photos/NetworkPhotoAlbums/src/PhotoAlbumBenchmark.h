@@ -0,0 +1,71 @@
+//
+// Copyright 2011-2014 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+@class AFImageResponseSerializer;
+@class NetworkPhotoAlbumViewController;
+
+/**
+ * A reproducible benchmark of the photo album's image pipeline.
+ *
+ * Launch the app with -PhotoAlbumBenchmark YES to replace the catalog with a Dribbble album that
+ * flips through its photos on its own. All of the album's requests are answered from recorded
+ * fixtures by PhotoAlbumFixtureURLProtocol at a simulated latency and bandwidth, so every run
+ * downloads the same bytes at the same pace. Record the fixtures once by also passing
+ * -PhotoAlbumBenchmarkRecord YES with a network connection.
+ *
+ * These launch arguments configure the run:
+ *
+ * - PhotoAlbumBenchmarkAPIPath       The Dribbble album to open. Default: /shots
+ * - PhotoAlbumBenchmarkLatency       Seconds before each response starts. Default: 0.05
+ * - PhotoAlbumBenchmarkBandwidth     Bytes per second for each response, or 0 for no limit.
+ *                                    Default: 262144
+ * - PhotoAlbumBenchmarkFlipInterval  Seconds spent on each photo. Default: 0.5
+ * - PhotoAlbumBenchmarkPageCount     The number of photos to flip through, or 0 for the whole
+ *                                    album. Default: 0
+ *
+ * Once the last photo has loaded, the benchmark logs its report and writes it as JSON to
+ * Documents/PhotoAlbumBenchmark.json. The report has the time to first image, the decode time
+ * of each image, peak resident memory, the hit rate of each image cache and the bytes
+ * transferred.
+ */
+@interface PhotoAlbumBenchmark : NSObject
+
++ (BOOL)isEnabled;
+
+// The running benchmark, or nil outside of benchmark mode.
++ (PhotoAlbumBenchmark *)activeBenchmark;
+
+// Registers the fixture protocol and returns the album controller to show. Call once at launch.
++ (UIViewController *)startBenchmark;
+
+@property (nonatomic, readonly) BOOL isRecording;
+@property (nonatomic, readonly) NSTimeInterval latency;
+@property (nonatomic, readonly) NSUInteger bandwidth;
+
+// Decodes images like AFImageResponseSerializer while timing each decode.
+- (AFImageResponseSerializer *)imageResponseSerializer;
+
+// Called on the main thread whenever the album stores a downloaded image.
+- (void)controller:(NetworkPhotoAlbumViewController *)controller
+      didLoadImage:(UIImage *)image
+         photoSize:(NIPhotoScrollViewPhotoSize)photoSize;
+
+// Thread-safe. Called by the fixture protocol as it delivers response bodies.
+- (void)didTransferNumberOfBytes:(NSUInteger)numberOfBytes;
+
+@end
@@ -0,0 +1,261 @@
+//
+// Copyright 2011-2014 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "PhotoAlbumBenchmark.h"
+
+#import "DribbblePhotoAlbumViewController.h"
+#import "PhotoAlbumFixtureURLProtocol.h"
+#import "AFNetworking.h"
+
+#import <mach/mach.h>
+
+static NSString* const kEnabledKey = @"PhotoAlbumBenchmark";
+static NSString* const kRecordKey = @"PhotoAlbumBenchmarkRecord";
+static NSString* const kAPIPathKey = @"PhotoAlbumBenchmarkAPIPath";
+static NSString* const kLatencyKey = @"PhotoAlbumBenchmarkLatency";
+static NSString* const kBandwidthKey = @"PhotoAlbumBenchmarkBandwidth";
+static NSString* const kFlipIntervalKey = @"PhotoAlbumBenchmarkFlipInterval";
+static NSString* const kPageCountKey = @"PhotoAlbumBenchmarkPageCount";
+
+static PhotoAlbumBenchmark* sActiveBenchmark = nil;
+
+static unsigned long long PhotoAlbumBenchmarkResidentBytes(void) {
+  struct mach_task_basic_info info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  kern_return_t result = task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                                   (task_info_t)&info, &count);
+  return (KERN_SUCCESS == result) ? info.resident_size : 0;
+}
+
+@interface PhotoAlbumBenchmark()
+@property (nonatomic, copy) NSString* apiPath;
+@property (nonatomic, assign) NSTimeInterval flipInterval;
+@property (nonatomic, assign) NSInteger pageCount;
+
+@property (nonatomic, weak) DribbblePhotoAlbumViewController* controller;
+@property (nonatomic, strong) NSTimer* flipTimer;
+@property (nonatomic, assign) CFAbsoluteTime startTime;
+@property (nonatomic, assign) NSTimeInterval timeToFirstThumbnail;
+@property (nonatomic, assign) NSTimeInterval timeToFirstPhoto;
+@property (nonatomic, assign) NSInteger numberOfPagesFlipped;
+@property (nonatomic, assign) unsigned long long peakResidentBytes;
+
+// Guarded by @synchronized(self) because images are decoded and bytes are delivered on the
+// networking threads.
+@property (nonatomic, strong) NSMutableArray* decodeTimes;
+@property (nonatomic, assign) unsigned long long numberOfBytesTransferred;
+
+- (void)didDecodeImageInTime:(NSTimeInterval)time;
+@end
+
+@interface PhotoAlbumBenchmarkImageResponseSerializer : AFImageResponseSerializer
+@property (nonatomic, strong) PhotoAlbumBenchmark* benchmark;
+@end
+
+
+@implementation PhotoAlbumBenchmarkImageResponseSerializer
+
+
+- (id)responseObjectForResponse:(NSURLResponse *)response
+                           data:(NSData *)data
+                          error:(NSError *__autoreleasing *)error {
+  // The superclass decodes and inflates the image, so this is the full cost of processing it.
+  CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+  id image = [super responseObjectForResponse:response data:data error:error];
+  if (nil != image) {
+    [self.benchmark didDecodeImageInTime:CFAbsoluteTimeGetCurrent() - start];
+  }
+  return image;
+}
+
+@end
+
+
+@implementation PhotoAlbumBenchmark
+
+
++ (BOOL)isEnabled {
+  return [[NSUserDefaults standardUserDefaults] boolForKey:kEnabledKey];
+}
+
++ (PhotoAlbumBenchmark *)activeBenchmark {
+  return sActiveBenchmark;
+}
+
++ (UIViewController *)startBenchmark {
+  NIDASSERT(nil == sActiveBenchmark);
+  sActiveBenchmark = [[self alloc] init];
+  [NSURLProtocol registerClass:[PhotoAlbumFixtureURLProtocol class]];
+  return [sActiveBenchmark start];
+}
+
+- (id)init {
+  if ((self = [super init])) {
+    NSUserDefaults* defaults = [NSUserDefaults standardUserDefaults];
+    [defaults registerDefaults:@{kAPIPathKey: @"/shots",
+                                 kLatencyKey: @0.05,
+                                 kBandwidthKey: @262144,
+                                 kFlipIntervalKey: @0.5,
+                                 kPageCountKey: @0}];
+    _isRecording = [defaults boolForKey:kRecordKey];
+    _apiPath = [defaults stringForKey:kAPIPathKey];
+    _latency = MAX(0, [defaults doubleForKey:kLatencyKey]);
+    _bandwidth = (NSUInteger)MAX(0, [defaults integerForKey:kBandwidthKey]);
+    _flipInterval = MAX(0.05, [defaults doubleForKey:kFlipIntervalKey]);
+    _pageCount = MAX(0, [defaults integerForKey:kPageCountKey]);
+
+    _timeToFirstThumbnail = -1;
+    _timeToFirstPhoto = -1;
+    _decodeTimes = [NSMutableArray array];
+  }
+  return self;
+}
+
+- (UIViewController *)start {
+  DribbblePhotoAlbumViewController* controller =
+      [[DribbblePhotoAlbumViewController alloc] initWith:self.apiPath];
+  self.controller = controller;
+
+  self.startTime = CFAbsoluteTimeGetCurrent();
+  self.flipTimer = [NSTimer scheduledTimerWithTimeInterval:self.flipInterval
+                                                    target:self
+                                                  selector:@selector(flip)
+                                                  userInfo:nil
+                                                   repeats:YES];
+  return controller;
+}
+
+- (void)sampleMemory {
+  self.peakResidentBytes = MAX(self.peakResidentBytes, PhotoAlbumBenchmarkResidentBytes());
+}
+
+- (void)flip {
+  [self sampleMemory];
+
+  NIPhotoAlbumScrollView* albumView = self.controller.photoAlbumView;
+  if (nil == albumView) {
+    // The controller went away before the run finished.
+    [self finish];
+    return;
+  }
+  if (0 == albumView.numberOfPages) {
+    // The album information hasn't loaded yet.
+    return;
+  }
+
+  BOOL isAtLastPage = (![albumView hasNext]
+                       || (self.pageCount > 0 && self.numberOfPagesFlipped + 1 >= self.pageCount));
+  if (!isAtLastPage) {
+    [albumView moveToNextAnimated:YES];
+    self.numberOfPagesFlipped++;
+
+  } else if (0 == self.controller.queue.operationCount) {
+    // Every request, including the prefetches around the last page, has completed.
+    [self finish];
+  }
+}
+
+- (void)finish {
+  [self.flipTimer invalidate];
+  self.flipTimer = nil;
+
+  NSDictionary* report = [self report];
+  NSLog(@"Photo album benchmark: %@", report);
+
+  NSData* data = [NSJSONSerialization dataWithJSONObject:report
+                                                 options:NSJSONWritingPrettyPrinted
+                                                   error:nil];
+  [data writeToFile:NIPathForDocumentsResource(@"PhotoAlbumBenchmark.json") atomically:YES];
+}
+
+- (NSDictionary *)report {
+  NSArray* decodeTimes = nil;
+  unsigned long long numberOfBytesTransferred = 0;
+  @synchronized(self) {
+    decodeTimes = [self.decodeTimes sortedArrayUsingSelector:@selector(compare:)];
+    numberOfBytesTransferred = self.numberOfBytesTransferred;
+  }
+
+  double totalDecodeTime = 0;
+  for (NSNumber* time in decodeTimes) {
+    totalDecodeTime += [time doubleValue];
+  }
+  NSUInteger numberOfImages = decodeTimes.count;
+
+  NSMutableDictionary* report = [NSMutableDictionary dictionary];
+  [report setObject:self.apiPath forKey:@"apiPath"];
+  [report setObject:@(self.isRecording) forKey:@"recording"];
+  [report setObject:@(self.latency) forKey:@"latency"];
+  [report setObject:@(self.bandwidth) forKey:@"bandwidth"];
+  [report setObject:@(CFAbsoluteTimeGetCurrent() - self.startTime) forKey:@"duration"];
+  [report setObject:@(self.numberOfPagesFlipped + 1) forKey:@"numberOfPages"];
+  [report setObject:@(self.timeToFirstThumbnail) forKey:@"timeToFirstThumbnail"];
+  [report setObject:@(self.timeToFirstPhoto) forKey:@"timeToFirstPhoto"];
+  [report setObject:@(numberOfImages) forKey:@"numberOfImages"];
+  [report setObject:decodeTimes forKey:@"decodeTimes"];
+  if (numberOfImages > 0) {
+    [report setObject:@(totalDecodeTime / numberOfImages) forKey:@"meanDecodeTime"];
+    [report setObject:[decodeTimes objectAtIndex:numberOfImages / 2] forKey:@"medianDecodeTime"];
+    [report setObject:[decodeTimes lastObject] forKey:@"maxDecodeTime"];
+  }
+  [report setObject:@(self.peakResidentBytes) forKey:@"peakResidentBytes"];
+  [report setObject:@(self.controller.highQualityImageCache.statistics.hitRate)
+             forKey:@"highQualityCacheHitRate"];
+  [report setObject:@(self.controller.thumbnailImageCache.statistics.hitRate)
+             forKey:@"thumbnailCacheHitRate"];
+  [report setObject:@(numberOfBytesTransferred) forKey:@"bytesTransferred"];
+  return report;
+}
+
+#pragma mark - Public
+
+
+- (AFImageResponseSerializer *)imageResponseSerializer {
+  PhotoAlbumBenchmarkImageResponseSerializer* serializer =
+      [PhotoAlbumBenchmarkImageResponseSerializer serializer];
+  serializer.benchmark = self;
+  return serializer;
+}
+
+- (void)controller:(NetworkPhotoAlbumViewController *)controller
+      didLoadImage:(UIImage *)image
+         photoSize:(NIPhotoScrollViewPhotoSize)photoSize {
+  [self sampleMemory];
+
+  NSTimeInterval elapsed = CFAbsoluteTimeGetCurrent() - self.startTime;
+  if (NIPhotoScrollViewPhotoSizeThumbnail == photoSize) {
+    if (self.timeToFirstThumbnail < 0) {
+      self.timeToFirstThumbnail = elapsed;
+    }
+
+  } else if (self.timeToFirstPhoto < 0) {
+    self.timeToFirstPhoto = elapsed;
+  }
+}
+
+- (void)didDecodeImageInTime:(NSTimeInterval)time {
+  @synchronized(self) {
+    [self.decodeTimes addObject:@(time)];
+  }
+}
+
+- (void)didTransferNumberOfBytes:(NSUInteger)numberOfBytes {
+  @synchronized(self) {
+    self.numberOfBytesTransferred += numberOfBytes;
+  }
+}
+
+@end
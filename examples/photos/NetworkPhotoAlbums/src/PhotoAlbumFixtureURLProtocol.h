@@ -0,0 +1,33 @@
+//
+// Copyright 2011-2014 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Answers HTTP requests from recorded fixtures at a simulated latency and bandwidth.
+ *
+ * Fixtures are stored as one file per response, named by the MD5 hash of its URL, with a
+ * manifest.plist that maps each URL to its file, status code and MIME type. Each manifest is
+ * read once and kept in memory. Recorded fixtures are written to Documents/PhotoAlbumFixtures
+ * and are preferred over a PhotoAlbumFixtures folder in the app bundle. A request without a
+ * fixture fails rather than falling through to the network, so a replay never depends on the
+ * network.
+ *
+ * While the active benchmark is recording, requests are forwarded to the network and their
+ * responses are saved as fixtures.
+ */
+@interface PhotoAlbumFixtureURLProtocol : NSURLProtocol
+@end
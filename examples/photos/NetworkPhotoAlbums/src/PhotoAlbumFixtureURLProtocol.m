@@ -0,0 +1,223 @@
+//
+// Copyright 2011-2014 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "PhotoAlbumFixtureURLProtocol.h"
+
+#import "PhotoAlbumBenchmark.h"
+
+static NSString* const kHandledRequestKey = @"PhotoAlbumFixtureURLProtocolHandled";
+static NSString* const kManifestFileName = @"manifest.plist";
+
+// Responses are delivered in slices this often to simulate the bandwidth.
+static const NSTimeInterval kDeliveryInterval = 0.05;
+
+@interface PhotoAlbumFixtureURLProtocol() <NSURLConnectionDataDelegate>
+@property (nonatomic, strong) NSTimer* deliveryTimer;
+@property (nonatomic, strong) NSData* responseData;
+@property (nonatomic, assign) NSUInteger numberOfBytesDelivered;
+@property (nonatomic, strong) NSURLConnection* recordingConnection;
+@property (nonatomic, strong) NSHTTPURLResponse* recordedResponse;
+@property (nonatomic, strong) NSMutableData* recordedData;
+@end
+
+
+@implementation PhotoAlbumFixtureURLProtocol
+
+
++ (NSString *)recordedFixturesPath {
+  return NIPathForDocumentsResource(@"PhotoAlbumFixtures");
+}
+
++ (NSString *)bundledFixturesPath {
+  return NIPathForBundleResource(nil, @"PhotoAlbumFixtures");
+}
+
+// Each manifest is read from disk the first time it is needed and kept in memory after that.
+// Must be called while synchronized on the class.
++ (NSMutableDictionary *)manifestAtPath:(NSString *)path {
+  static NSMutableDictionary* manifests = nil;
+  if (nil == manifests) {
+    manifests = [NSMutableDictionary dictionary];
+  }
+  NSMutableDictionary* manifest = [manifests objectForKey:path];
+  if (nil == manifest) {
+    NSString* manifestPath = [path stringByAppendingPathComponent:kManifestFileName];
+    manifest = [NSMutableDictionary dictionaryWithContentsOfFile:manifestPath];
+    if (nil == manifest) {
+      manifest = [NSMutableDictionary dictionary];
+    }
+    [manifests setObject:manifest forKey:path];
+  }
+  return manifest;
+}
+
+// Returns the fixture recorded for the URL along with the directory it lives in.
++ (NSDictionary *)fixtureForURL:(NSURL *)url directory:(NSString **)pDirectory {
+  @synchronized(self) {
+    for (NSString* path in @[[self recordedFixturesPath], [self bundledFixturesPath]]) {
+      NSDictionary* fixture = [[self manifestAtPath:path] objectForKey:url.absoluteString];
+      if (nil != fixture) {
+        *pDirectory = path;
+        return fixture;
+      }
+    }
+  }
+  return nil;
+}
+
++ (void)recordResponse:(NSHTTPURLResponse *)response data:(NSData *)data forURL:(NSURL *)url {
+  // Requests complete on many threads at once and share one manifest.
+  @synchronized(self) {
+    NSString* path = [self recordedFixturesPath];
+    [[NSFileManager defaultManager] createDirectoryAtPath:path
+                              withIntermediateDirectories:YES
+                                               attributes:nil
+                                                    error:nil];
+    NSMutableDictionary* manifest = [self manifestAtPath:path];
+    // Named after the URL so that recording a URL again replaces its file rather than leaving
+    // the old one behind under another name.
+    NSString* fileName = [NIMD5HashFromString(url.absoluteString)
+                          stringByAppendingPathExtension:@"dat"];
+    [data writeToFile:[path stringByAppendingPathComponent:fileName] atomically:YES];
+
+    NSString* mimeType = ((nil != response.MIMEType)
+                          ? response.MIMEType
+                          : @"application/octet-stream");
+    [manifest setObject:@{@"file": fileName,
+                          @"statusCode": [NSNumber numberWithInteger:response.statusCode],
+                          @"MIMEType": mimeType}
+                 forKey:url.absoluteString];
+    [manifest writeToFile:[path stringByAppendingPathComponent:kManifestFileName] atomically:YES];
+  }
+}
+
+#pragma mark - NSURLProtocol
+
+
++ (BOOL)canInitWithRequest:(NSURLRequest *)request {
+  NSString* scheme = request.URL.scheme.lowercaseString;
+  return (([scheme isEqualToString:@"http"] || [scheme isEqualToString:@"https"])
+          && nil == [self propertyForKey:kHandledRequestKey inRequest:request]);
+}
+
++ (NSURLRequest *)canonicalRequestForRequest:(NSURLRequest *)request {
+  return request;
+}
+
+- (void)startLoading {
+  if ([PhotoAlbumBenchmark activeBenchmark].isRecording) {
+    NSMutableURLRequest* request = [self.request mutableCopy];
+    [[self class] setProperty:@YES forKey:kHandledRequestKey inRequest:request];
+    self.recordedData = [NSMutableData data];
+    self.recordingConnection = [NSURLConnection connectionWithRequest:request delegate:self];
+    return;
+  }
+
+  NSString* directory = nil;
+  NSDictionary* fixture = [[self class] fixtureForURL:self.request.URL directory:&directory];
+  if (nil == fixture) {
+    NSLog(@"No fixture for %@. Record fixtures with -PhotoAlbumBenchmarkRecord YES.",
+          self.request.URL);
+    [self.client URLProtocol:self didFailWithError:
+     [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorResourceUnavailable userInfo:nil]];
+    return;
+  }
+
+  self.responseData = [NSData dataWithContentsOfFile:
+                       [directory stringByAppendingPathComponent:[fixture objectForKey:@"file"]]];
+  NSDictionary* headers = @{@"Content-Type": [fixture objectForKey:@"MIMEType"],
+                            @"Content-Length": [NSString stringWithFormat:@"%zd",
+                                                self.responseData.length]};
+  NSHTTPURLResponse* response =
+      [[NSHTTPURLResponse alloc] initWithURL:self.request.URL
+                                  statusCode:[[fixture objectForKey:@"statusCode"] integerValue]
+                                 HTTPVersion:@"HTTP/1.1"
+                                headerFields:headers];
+  [self.client URLProtocol:self
+        didReceiveResponse:response
+        cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+
+  // Timers fire on this thread's run loop, which is the thread the client expects to hear from.
+  NSTimeInterval latency = [PhotoAlbumBenchmark activeBenchmark].latency;
+  self.deliveryTimer = [NSTimer timerWithTimeInterval:kDeliveryInterval
+                                               target:self
+                                             selector:@selector(deliverNextSlice)
+                                             userInfo:nil
+                                              repeats:YES];
+  self.deliveryTimer.fireDate = [NSDate dateWithTimeIntervalSinceNow:latency];
+  [[NSRunLoop currentRunLoop] addTimer:self.deliveryTimer forMode:NSRunLoopCommonModes];
+}
+
+- (void)stopLoading {
+  [self.deliveryTimer invalidate];
+  self.deliveryTimer = nil;
+  [self.recordingConnection cancel];
+  self.recordingConnection = nil;
+}
+
+#pragma mark - Replay
+
+
+- (void)deliverNextSlice {
+  NSUInteger bandwidth = [PhotoAlbumBenchmark activeBenchmark].bandwidth;
+  NSUInteger remaining = self.responseData.length - self.numberOfBytesDelivered;
+  NSUInteger sliceLength = ((0 == bandwidth)
+                            ? remaining
+                            : MIN(remaining, MAX((NSUInteger)1,
+                                                 (NSUInteger)(bandwidth * kDeliveryInterval))));
+  if (sliceLength > 0) {
+    NSData* slice = [self.responseData subdataWithRange:NSMakeRange(self.numberOfBytesDelivered,
+                                                                    sliceLength)];
+    self.numberOfBytesDelivered += sliceLength;
+    [[PhotoAlbumBenchmark activeBenchmark] didTransferNumberOfBytes:sliceLength];
+    [self.client URLProtocol:self didLoadData:slice];
+  }
+
+  if (self.numberOfBytesDelivered >= self.responseData.length) {
+    [self.deliveryTimer invalidate];
+    self.deliveryTimer = nil;
+    [self.client URLProtocolDidFinishLoading:self];
+  }
+}
+
+#pragma mark - NSURLConnectionDataDelegate
+
+
+- (void)connection:(NSURLConnection *)connection didReceiveResponse:(NSURLResponse *)response {
+  self.recordedResponse = (NSHTTPURLResponse *)response;
+  [self.client URLProtocol:self
+        didReceiveResponse:response
+        cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+}
+
+- (void)connection:(NSURLConnection *)connection didReceiveData:(NSData *)data {
+  [self.recordedData appendData:data];
+  [[PhotoAlbumBenchmark activeBenchmark] didTransferNumberOfBytes:data.length];
+  [self.client URLProtocol:self didLoadData:data];
+}
+
+- (void)connectionDidFinishLoading:(NSURLConnection *)connection {
+  [[self class] recordResponse:self.recordedResponse
+                          data:self.recordedData
+                        forURL:self.request.URL];
+  [self.client URLProtocolDidFinishLoading:self];
+}
+
+- (void)connection:(NSURLConnection *)connection didFailWithError:(NSError *)error {
+  [self.client URLProtocol:self didFailWithError:error];
+}
+
+@end
@@ -0,0 +1,60 @@
+#!/bin/bash
+# Cold-launches the catalog's launch benchmark in the booted simulator and appends one JSON line
+# per launch, tagged with the current commit, to the results file. Run it on each commit and
+# compare the medians to catch launch regressions.
+#
+# usage: scripts/run_launch_benchmark.sh [number of launches] [results file]
+
+set -e
+
+LAUNCHES=${1:-10}
+RESULTS=${2:-launch_benchmark.jsonl}
+BUNDLE_ID=com.jeffverkoeyen.Nimbus
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+BUILD_DIR="$ROOT/build/launch_benchmark"
+COMMIT=$(git -C "$ROOT" rev-parse --short HEAD)
+
+# Release builds, because Debug builds mostly measure the lack of optimization.
+xcodebuild -project "$ROOT/examples/catalog/NimbusCatalog.xcodeproj" -target Nimbus \
+  -configuration Release -sdk iphonesimulator SYMROOT="$BUILD_DIR" build > /dev/null
+xcrun simctl install booted "$BUILD_DIR/Release-iphonesimulator/Nimbus.app"
+
+REPORT="$(xcrun simctl get_app_container booted $BUNDLE_ID data)/Documents/LaunchBenchmark.json"
+
+for ((run = 1; run <= LAUNCHES; run++)); do
+  rm -f "$REPORT"
+  xcrun simctl terminate booted $BUNDLE_ID > /dev/null 2>&1 || true
+  xcrun simctl launch booted $BUNDLE_ID -LaunchBenchmark YES > /dev/null
+
+  wait=0
+  while [[ ! -f "$REPORT" && $wait -lt 60 ]]; do
+    sleep 1
+    wait=$((wait + 1))
+  done
+  if [[ ! -f "$REPORT" ]]; then
+    echo "Launch $run did not write a report." >&2
+    exit 1
+  fi
+
+  python -c "import json, sys; report = json.load(open(sys.argv[1])); \
+report.update(commit=sys.argv[2], run=int(sys.argv[3])); print(json.dumps(report, sort_keys=True))" \
+    "$REPORT" "$COMMIT" "$run" >> "$RESULTS"
+done
+xcrun simctl terminate booted $BUNDLE_ID > /dev/null 2>&1 || true
+
+python - "$RESULTS" "$COMMIT" <<'PYTHON'
+import json, sys
+
+runs = [json.loads(line) for line in open(sys.argv[1]) if line.strip()]
+runs = [run for run in runs if run['commit'] == sys.argv[2]]
+
+def median(values):
+  values = sorted(values)
+  return values[len(values) // 2]
+
+print('Median of %d launches at %s:' % (len(runs), sys.argv[2]))
+for key in ('preMain', 'didFinishLaunching', 'firstFrame'):
+  print('  %-20s %8.1fms' % (key, median([run[key] for run in runs])))
+for module in sorted(runs[0]['modules']):
+  print('  %-20s %8.1fms' % (module, median([run['modules'][module] for run in runs])))
+PYTHON
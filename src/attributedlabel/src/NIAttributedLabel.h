@@ -32,6 +32,9 @@ extern "C" {
  *
  * This method is used in NIAttributedLabel to calculate its size after all additional
  * styling attributes have been set.
+ *
+ * The typesetting is shared through NIAttributedLabelLayoutCache, so measuring a string and
+ * then drawing it in a label at the same width typesets it once.
  */
 CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedString, CGSize size, NSInteger numberOfLines);
 
@@ -79,6 +82,8 @@ extern NSString* const NIAttributedLabelLinkAttributeName; // Value is an NSText
 // Please use attributedText instead. MAINTENANCE: Remove by Feb 28, 2014.
 @property (nonatomic, copy) NSAttributedString* attributedString __NI_DEPRECATED_METHOD;
 
+- (void)appendAttributedString:(NSAttributedString *)attributedString;
+
 @property (nonatomic) BOOL                autoDetectLinks;    // Default: NO
 @property (nonatomic) NSTextCheckingType  dataDetectorTypes;  // Default: NSTextCheckingTypeLink
 @property (nonatomic) BOOL                deferLinkDetection; // Default: NO
@@ -91,6 +96,7 @@ extern NSString* const NIAttributedLabelLinkAttributeName; // Value is an NSText
 @property (nonatomic)         BOOL          linksHaveUnderlines;            // Default: NO
 @property (nonatomic, copy)   NSDictionary* attributesForLinks;             // Default: nil
 @property (nonatomic, copy)   NSDictionary* attributesForHighlightedLink;   // Default: nil
+@property (nonatomic)         BOOL          highlightsLinksInOverlay;       // Default: NO
 @property (nonatomic)         CGFloat       lineHeight;
 
 @property (nonatomic)         NIVerticalTextAlignment   verticalTextAlignment;  // Default: NIVerticalTextAlignmentTop
@@ -103,6 +109,8 @@ extern NSString* const NIAttributedLabelLinkAttributeName; // Value is an NSText
 
 @property (nonatomic, copy) NSString* tailTruncationString;
 
+@property (nonatomic) BOOL displaysAsynchronously; // Default: NO
+
 - (void)setFont:(UIFont *)font            range:(NSRange)range;
 - (void)setStrokeColor:(UIColor *)color   range:(NSRange)range;
 - (void)setStrokeWidth:(CGFloat)width     range:(NSRange)range;
@@ -113,6 +121,8 @@ extern NSString* const NIAttributedLabelLinkAttributeName; // Value is an NSText
 - (void)insertImage:(UIImage *)image atIndex:(NSInteger)index;
 - (void)insertImage:(UIImage *)image atIndex:(NSInteger)index margins:(UIEdgeInsets)margins;
 - (void)insertImage:(UIImage *)image atIndex:(NSInteger)index margins:(UIEdgeInsets)margins verticalTextAlignment:(NIVerticalTextAlignment)verticalTextAlignment;
+- (void)insertImageWithURL:(NSURL *)url size:(CGSize)size atIndex:(NSInteger)index;
+- (void)insertImageWithURL:(NSURL *)url size:(CGSize)size placeholderImage:(UIImage *)placeholderImage atIndex:(NSInteger)index margins:(UIEdgeInsets)margins verticalTextAlignment:(NIVerticalTextAlignment)verticalTextAlignment;
 
 - (void)invalidateAccessibleElements;
 
@@ -168,6 +178,26 @@ extern NSString* const NIAttributedLabelLinkAttributeName; // Value is an NSText
  * @fn NIAttributedLabel::attributedString
  */
 
+/**
+ * Appends an attributed string to the label's text.
+ *
+ * The result is the same as assigning the combined string to attributedText, except that explicit
+ * links and inserted images are kept, and the work done is proportional to the appended text
+ * rather than to all of it. This makes it the method to use for text that grows continuously, such
+ * as a live transcript.
+ *
+ * - Links in the appended string are added to the explicit links.
+ * - If links have already been detected, only the last paragraph is detected again.
+ * - Lines before the last paragraph keep their typesetting and only the rest is typeset again.
+ *   This applies when the label is top aligned, has no inserted images and has been laid out
+ *   before; otherwise the whole text is laid out again when it is next displayed.
+ *
+ * The label's size is still measured from the whole text, so labels that size themselves to fit
+ * their text don't benefit from the kept lines.
+ *
+ * @fn NIAttributedLabel::appendAttributedString:
+ */
+
 /** @name Accessing and Detecting Links */
 
 /**
@@ -281,6 +311,22 @@ extern NSString* const NIAttributedLabelLinkAttributeName; // Value is an NSText
  * @fn NIAttributedLabel::attributesForHighlightedLink
  */
 
+/**
+ * A Boolean value indicating whether touched links are highlighted in layers above the text.
+ *
+ * By default this is disabled, and touching a link redraws the whole label, once on touch down
+ * and again on touch up. When enabled, the highlightedLinkBackgroundColor is filled into a shape
+ * layer built from the link's cached rects and the label's own drawing is left alone. If
+ * attributesForHighlightedLink are set, only the link's glyphs are drawn again with them, into a
+ * layer that covers just the link, without laying out the label's text again.
+ *
+ * The restyled glyphs are drawn over the label's backgroundColor, so labels with a clear
+ * background may show the original glyphs through them. Labels with inserted images only show
+ * the highlight color.
+ *
+ * @fn NIAttributedLabel::highlightsLinksInOverlay
+ */
+
 /** @name Modifying Rich Text Styles for All Text */
 
 /**
@@ -373,6 +419,26 @@ extern NSString* const NIAttributedLabelLinkAttributeName; // Value is an NSText
  * @fn NIAttributedLabel::tailTruncationString
  */
 
+/** @name Rendering */
+
+/**
+ * Whether the label lays out and draws its text on a background queue.
+ *
+ * By default this is NO.
+ *
+ * When enabled, the glyphs are typeset and rendered into a bitmap off the main thread and the
+ * label's drawRect: only composites that bitmap and the touched link's highlight. Until the first
+ * bitmap is ready the label draws no text. Changing the text, its attributes or the label's frame
+ * discards any rendering still in flight.
+ *
+ * Labels with inserted images always draw synchronously.
+ *
+ * Useful for labels in scrolling lists, where typesetting long text on the main thread would
+ * otherwise cost frames.
+ *
+ * @fn NIAttributedLabel::displaysAsynchronously
+ */
+
 /** @name Modifying Rich Text Styles in Ranges */
 
 /**
@@ -459,6 +525,38 @@ extern NSString* const NIAttributedLabelLinkAttributeName; // Value is an NSText
  * @fn NIAttributedLabel::insertImage:atIndex:margins:verticalTextAlignment:
  */
 
+/**
+ * Inserts an image that is downloaded from the given URL inline at the given index.
+ *
+ * The image is laid out at the given size straight away, so the text never moves when it
+ * arrives. Until then nothing is drawn in its place.
+ *
+ * @sa NIAttributedLabel::insertImageWithURL:size:placeholderImage:atIndex:margins:verticalTextAlignment:
+ * @fn NIAttributedLabel::insertImageWithURL:size:atIndex:
+ */
+
+/**
+ * Inserts an image that is downloaded from the given URL inline at the given index.
+ *
+ * The image's box is laid out at the given size plus margins while the placeholder is shown, so
+ * when the image arrives only its box is redrawn and the text is not typeset again.
+ *
+ * Images are decoded at their display size off the main thread and stored in
+ * Nimbus::imageMemoryCache, so the same image at the same size is shown immediately in other
+ * labels and downloaded only once while it is in flight. Downloads go through
+ * Nimbus::networkOperationQueue, and URLs that failed recently, according to
+ * Nimbus::failedNetworkPathFilter, aren't requested again. Responses other than 2xx keep the
+ * placeholder. Only 404 and 410 responses and bodies that aren't images are recorded as failed.
+ *
+ * @param url The URL of the image.
+ * @param size The size to display the image at in points.
+ * @param placeholderImage The image to draw until the image has loaded. May be nil.
+ * @param index The index into the receiver's text at which to insert the image.
+ * @param margins The space around the image on all sides in points.
+ * @param verticalTextAlignment The position of the text relative to the image.
+ * @fn NIAttributedLabel::insertImageWithURL:size:placeholderImage:atIndex:margins:verticalTextAlignment:
+ */
+
 /** @name Accessibility */
 
 /**
@@ -17,6 +17,9 @@
 
 #import "NIAttributedLabel.h"
 
+#import "NIAttributedLabel+Private.h"
+#import "NIAttributedLabelLayoutCache.h"
+#import "NIAttributedLabelLayoutDescriptor.h"
 #import "NSMutableAttributedString+NimbusAttributedLabel.h"
 #import <QuartzCore/QuartzCore.h>
 
@@ -51,47 +54,101 @@ CGFloat NIImageDelegateGetDescentCallback(void* refCon);
 CGFloat NIImageDelegateGetWidthCallback(void* refCon);
 
 CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedString, CGSize constraintSize, NSInteger numberOfLines) {
-  if (nil == attributedString) {
-    return CGSizeZero;
-  }
-
-  CFAttributedStringRef attributedStringRef = (__bridge CFAttributedStringRef)attributedString;
-  CTFramesetterRef framesetter = CTFramesetterCreateWithAttributedString(attributedStringRef);
-  NIDASSERT(NULL != framesetter);
-  if (NULL == framesetter) {
-    return CGSizeZero;
+  return [[NIAttributedLabelLayoutCache sharedCache] sizeOfAttributedString:attributedString
+                                                          constrainedToSize:constraintSize
+                                                              numberOfLines:numberOfLines];
+}
+
+// Detection results are kept for this many bytes of detected text, least recently used first out.
+static const unsigned long long kMaximumNumberOfLinkMatchBytes = 256 * 1024;
+
+// Data detectors are expensive to create and, like all regular expressions, immutable and safe to
+// share between threads, so each combination of types gets one for the whole process.
+static NSDataDetector* NIDataDetectorForTypes(NSTextCheckingType types) {
+  static NSMutableDictionary* detectors = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    detectors = [[NSMutableDictionary alloc] init];
+  });
+
+  @synchronized(detectors) {
+    NSDataDetector* detector = [detectors objectForKey:@(types)];
+    if (nil == detector) {
+      NSError* error = nil;
+      detector = [NSDataDetector dataDetectorWithTypes:(NSTextCheckingTypes)types error:&error];
+      NIDASSERT(nil == error);
+      if (nil != detector) {
+        [detectors setObject:detector forKey:@(types)];
+      }
+    }
+    return detector;
   }
-  CFRange range = CFRangeMake(0, 0);
+}
 
-  // This logic adapted from @mattt's TTTAttributedLabel
-  // https://github.com/mattt/TTTAttributedLabel
+// The links found in one string, kept so that the same text shown again is not detected again.
+@interface NIAttributedLabelLinkMatches : NSObject
+@property (nonatomic, copy) NSString* string;
+@property (nonatomic, copy) NSArray* matches; // Of NSTextCheckingResult.
+@end
 
-  if (numberOfLines == 1) {
-    constraintSize = CGSizeMake(CGFLOAT_MAX, CGFLOAT_MAX);
+@implementation NIAttributedLabelLinkMatches
+@end
 
-  } else if (numberOfLines > 0 && nil != framesetter) {
-    CGMutablePathRef path = CGPathCreateMutable();
-    CGPathAddRect(path, NULL, CGRectMake(0, 0, constraintSize.width, constraintSize.height));
-    CTFrameRef frame = CTFramesetterCreateFrame(framesetter, CFRangeMake(0, 0), path, NULL);
-    CFArrayRef lines = CTFrameGetLines(frame);
+static NIMemoryCache* NILinkMatchesCache(void) {
+  static NIMemoryCache* cache = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    cache = [[NIMemoryCache alloc] init];
+  });
+  return cache;
+}
 
-    if (nil != lines && CFArrayGetCount(lines) > 0) {
-      NSInteger lastVisibleLineIndex = MIN(numberOfLines, CFArrayGetCount(lines)) - 1;
-      CTLineRef lastVisibleLine = CFArrayGetValueAtIndex(lines, lastVisibleLineIndex);
+static NSString* NILinkMatchesCacheName(NSString* string, NSTextCheckingType types) {
+  return [NSString stringWithFormat:@"%lu-%llu", (unsigned long)[string hash], (unsigned long long)types];
+}
 
-      CFRange rangeToLayout = CTLineGetStringRange(lastVisibleLine);
-      range = CFRangeMake(0, rangeToLayout.location + rangeToLayout.length);
-    }
+// Returns nil if the string has not been detected with these types recently.
+static NSArray* NICachedLinkMatchesInString(NSString* string, NSTextCheckingType types) {
+  NIAttributedLabelLinkMatches* linkMatches = [NILinkMatchesCache() objectWithName:NILinkMatchesCacheName(string, types)];
+  if (nil != linkMatches && [linkMatches.string isEqualToString:string]) {
+    return linkMatches.matches;
+  }
+  return nil;
+}
 
-    CFRelease(frame);
-    CFRelease(path);
+// Safe to call from any thread.
+static NSArray* NILinkMatchesInString(NSString* string, NSTextCheckingType types) {
+  NSArray* matches = NICachedLinkMatchesInString(string, types);
+  if (nil != matches) {
+    return matches;
   }
 
-  CGSize newSize = CTFramesetterSuggestFrameSizeWithConstraints(framesetter, range, NULL, constraintSize, NULL);
+  matches = [NIDataDetectorForTypes(types) matchesInString:string options:0 range:NSMakeRange(0, string.length)];
 
-  CFRelease(framesetter);
+  NIAttributedLabelLinkMatches* linkMatches = [[NIAttributedLabelLinkMatches alloc] init];
+  linkMatches.string = string;
+  linkMatches.matches = matches;
+
+  // Either a miss or a different string with the same hash, which takes the older one's place.
+  NIMemoryCache* cache = NILinkMatchesCache();
+  unsigned long long cost = (unsigned long long)MAX(1, string.length) * sizeof(unichar);
+  [cache storeObject:linkMatches withName:NILinkMatchesCacheName(string, types) cost:cost];
 
-  return CGSizeMake(NICGFloatCeil(newSize.width), NICGFloatCeil(newSize.height));
+  unsigned long long numberOfBytes = [cache numberOfBytesInMemoryBudget];
+  if (numberOfBytes > kMaximumNumberOfLinkMatchBytes) {
+    [cache reduceMemoryUsageByNumberOfBytes:numberOfBytes - kMaximumNumberOfLinkMatchBytes];
+  }
+  return matches;
+}
+
+// All labels that display asynchronously share one serial rendering queue.
+static dispatch_queue_t NIAttributedLabelRenderingQueue(void) {
+  static dispatch_queue_t queue = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    queue = dispatch_queue_create("com.nimbuskit.attributedlabel.rendering", DISPATCH_QUEUE_SERIAL);
+  });
+  return queue;
 }
 
 @interface NIAttributedLabelImage : NSObject
@@ -107,13 +164,521 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
 @property (nonatomic) CGFloat fontAscent;
 @property (nonatomic) CGFloat fontDescent;
 
+// Images loaded from a URL are laid out at a fixed size while image is still the placeholder.
+@property (nonatomic, strong)   NSURL*        url;
+@property (nonatomic)           CGSize        imageSize;
+
+@property (nonatomic)           CGRect        displayRect; // Where it was last drawn, in label coordinates.
+
 @end
 
 @implementation NIAttributedLabelImage
 
 - (CGSize)boxSize {
-  return CGSizeMake(self.image.size.width + self.margins.left + self.margins.right,
-                    self.image.size.height + self.margins.top + self.margins.bottom);
+  CGSize imageSize = (nil != self.url) ? self.imageSize : self.image.size;
+  return CGSizeMake(imageSize.width + self.margins.left + self.margins.right,
+                    imageSize.height + self.margins.top + self.margins.bottom);
+}
+
+@end
+
+// Inline images being downloaded, keyed by cache name, with the blocks waiting for each.
+// Only accessed on the main thread.
+static NSMutableDictionary* NIInlineImageRequests(void) {
+  static NSMutableDictionary* requests = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    requests = [[NSMutableDictionary alloc] init];
+  });
+  return requests;
+}
+
+static NSString* NIInlineImageCacheName(NSURL* url, CGSize size) {
+  return [NSString stringWithFormat:@"NIAttributedLabel:%@:%@", url.absoluteString, NSStringFromCGSize(size)];
+}
+
+static BOOL NIIsSuccessfulStatusCode(NSInteger statusCode) {
+  return statusCode >= 200 && statusCode < 300;
+}
+
+// Decodes the image at the size it is displayed at so that drawing it is a plain copy.
+static UIImage* NIInlineImageFromData(NSData* data, CGSize size) {
+  UIImage* image = [UIImage imageWithData:data];
+  if (nil == image || size.width <= 0 || size.height <= 0) {
+    return image;
+  }
+  UIGraphicsBeginImageContextWithOptions(size, NO, [UIScreen mainScreen].scale);
+  [image drawInRect:CGRectMake(0, 0, size.width, size.height)];
+  UIImage* decodedImage = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  return decodedImage;
+}
+
+// Line and link geometry of one layout in the label's coordinates. Built once per layout so that
+// touch tracking finds lines with a binary search and reuses each link's rects.
+//
+// An index is usually built from a CTFrame. One can also be extended with appended text, in
+// which case its trailing lines come from a separately typeset frame whose string indices start
+// at a later offset; every string index going in or out of the index is absolute.
+@interface NIAttributedLabelLineIndex : NSObject
+
+- (id)initWithTextFrame:(CTFrameRef)textFrame transform:(CGAffineTransform)transform verticalOffset:(CGFloat)verticalOffset;
+
+- (NIAttributedLabelLineIndex *)indexByTypesettingAttributedString:(NSAttributedString *)attributedString
+                                                   fromStringIndex:(NSUInteger)stringIndex
+                                                              rect:(CGRect)rect;
+
+- (CFIndex)numberOfLines;
+- (CTLineRef)lineAtIndex:(CFIndex)index;
+- (CGPoint)originOfLineAtIndex:(CFIndex)index; // CoreText coordinates.
+- (CFIndex)stringOffsetOfLineAtIndex:(CFIndex)index; // Add to the line's own string indices.
+- (CFRange)stringRangeOfLineAtIndex:(CFIndex)index;
+- (CGRect)boundsOfLineAtIndex:(CFIndex)index;
+
+// The first line whose bounds, outset vertically by margin, end below y. Lines after it start
+// lower still, so callers walk forward from here until a line starts below y.
+- (CFIndex)indexOfFirstLineEndingBelowY:(CGFloat)y margin:(CGFloat)margin;
+
+- (NSArray *)rectsForRange:(NSRange)range; // Of NSValue with CGRect, memoized.
+
+// The line at the index truncated to the width, memoized and shared through the layout cache.
+- (CTLineRef)truncatedLineAtIndex:(CFIndex)index
+               ofAttributedString:(NSAttributedString *)attributedString
+                            width:(CGFloat)width
+             tailTruncationString:(NSString *)tailTruncationString;
+
+@end
+
+// Returns the CoreText-space bounds of the part of range that falls in the index's line.
+static CGRect NIRectForRangeInLine(NSRange range, NIAttributedLabelLineIndex* lineIndex, CFIndex lineNumber) {
+  CTLineRef line = [lineIndex lineAtIndex:lineNumber];
+  CGPoint lineOrigin = [lineIndex originOfLineAtIndex:lineNumber];
+  CFIndex stringOffset = [lineIndex stringOffsetOfLineAtIndex:lineNumber];
+
+  CGRect rectForRange = CGRectZero;
+  CFArrayRef runs = CTLineGetGlyphRuns(line);
+  CFIndex runCount = CFArrayGetCount(runs);
+
+  // Iterate through each of the "runs" (i.e. a chunk of text) and find the runs that
+  // intersect with the range.
+  for (CFIndex k = 0; k < runCount; k++) {
+    CTRunRef run = CFArrayGetValueAtIndex(runs, k);
+
+    CFRange stringRunRange = CTRunGetStringRange(run);
+    NSRange lineRunRange = NSMakeRange(stringOffset + stringRunRange.location, stringRunRange.length);
+    NSRange intersectedRunRange = NSIntersectionRange(lineRunRange, range);
+
+    if (intersectedRunRange.length == 0) {
+      // This run doesn't intersect the range, so skip it.
+      continue;
+    }
+
+    CGFloat ascent = 0.0f;
+    CGFloat descent = 0.0f;
+    CGFloat leading = 0.0f;
+
+    // Use of 'leading' doesn't properly highlight Japanese-character link.
+    CGFloat width = (CGFloat)CTRunGetTypographicBounds(run,
+                                                       CFRangeMake(0, 0),
+                                                       &ascent,
+                                                       &descent,
+                                                       NULL); //&leading);
+    CGFloat height = ascent + descent;
+
+    CGFloat xOffset = CTLineGetOffsetForStringIndex(line, stringRunRange.location, nil);
+
+    CGRect linkRect = CGRectMake(lineOrigin.x + xOffset - leading, lineOrigin.y - descent, width + leading, height);
+
+    linkRect.origin.y = NICGFloatRound(linkRect.origin.y);
+    linkRect.origin.x = NICGFloatRound(linkRect.origin.x);
+    linkRect.size.width = NICGFloatRound(linkRect.size.width);
+    linkRect.size.height = NICGFloatRound(linkRect.size.height);
+
+    if (CGRectIsEmpty(rectForRange)) {
+      rectForRange = linkRect;
+
+    } else {
+      rectForRange = CGRectUnion(rectForRange, linkRect);
+    }
+  }
+
+  return rectForRange;
+}
+
+@implementation NIAttributedLabelLineIndex {
+  CFArrayRef _lines;
+  CFIndex _numberOfLines;
+  CGPoint* _lineOrigins;   // CoreText coordinates.
+  CFIndex* _stringOffsets;
+  CGRect* _lineBounds;     // Label coordinates, top to bottom.
+  CGAffineTransform _transform;
+  CGFloat _verticalOffset;
+  NSMutableDictionary* _rectsForRanges;
+  NSMutableDictionary* _truncatedLines; // NSString index, width and token => CTLineRef
+}
+
+- (void)dealloc {
+  free(_lineOrigins);
+  free(_stringOffsets);
+  free(_lineBounds);
+  if (NULL != _lines) {
+    CFRelease(_lines);
+  }
+}
+
+// Takes ownership of lines and of the malloc'd origins and offsets.
+- (id)initWithLines:(CFArrayRef)lines
+        lineOrigins:(CGPoint *)lineOrigins
+      stringOffsets:(CFIndex *)stringOffsets
+          transform:(CGAffineTransform)transform
+     verticalOffset:(CGFloat)verticalOffset {
+  if ((self = [super init])) {
+    _lines = lines;
+    _numberOfLines = CFArrayGetCount(lines);
+    _lineOrigins = lineOrigins;
+    _stringOffsets = stringOffsets;
+    _transform = transform;
+    _verticalOffset = verticalOffset;
+    _rectsForRanges = [[NSMutableDictionary alloc] init];
+    _truncatedLines = [[NSMutableDictionary alloc] init];
+
+    _lineBounds = calloc((size_t)MAX(1, _numberOfLines), sizeof(CGRect));
+    for (CFIndex i = 0; i < _numberOfLines; i++) {
+      CTLineRef line = CFArrayGetValueAtIndex(lines, i);
+      CGFloat ascent = 0.0f;
+      CGFloat descent = 0.0f;
+      CGFloat leading = 0.0f;
+      CGFloat width = (CGFloat)CTLineGetTypographicBounds(line, &ascent, &descent, &leading);
+      CGRect flippedRect = CGRectMake(_lineOrigins[i].x, _lineOrigins[i].y - descent, width, ascent + descent);
+      _lineBounds[i] = CGRectOffset(CGRectApplyAffineTransform(flippedRect, transform), 0, verticalOffset);
+    }
+  }
+  return self;
+}
+
+- (id)initWithTextFrame:(CTFrameRef)textFrame transform:(CGAffineTransform)transform verticalOffset:(CGFloat)verticalOffset {
+  CFArrayRef lines = CTFrameGetLines(textFrame);
+  CFIndex count = CFArrayGetCount(lines);
+  CGPoint* lineOrigins = calloc((size_t)MAX(1, count), sizeof(CGPoint));
+  CTFrameGetLineOrigins(textFrame, CFRangeMake(0, 0), lineOrigins);
+  CFIndex* stringOffsets = calloc((size_t)MAX(1, count), sizeof(CFIndex));
+
+  return [self initWithLines:(CFArrayRef)CFRetain(lines)
+                 lineOrigins:lineOrigins
+               stringOffsets:stringOffsets
+                   transform:transform
+              verticalOffset:verticalOffset];
+}
+
+- (NIAttributedLabelLineIndex *)indexByTypesettingAttributedString:(NSAttributedString *)attributedString
+                                                   fromStringIndex:(NSUInteger)stringIndex
+                                                              rect:(CGRect)rect {
+  // Keep every line that ends before the string index. The last of them is typeset again along
+  // with the new text purely as a vertical anchor: the following lines sit relative to its
+  // baseline exactly as they would in a frame of the whole string.
+  CFIndex numberOfKeptLines = [self indexOfFirstLineEndingAfterStringIndex:stringIndex];
+  if (0 == numberOfKeptLines) {
+    return nil;
+  }
+  CFIndex anchorIndex = numberOfKeptLines - 1;
+  CFRange anchorRange = [self stringRangeOfLineAtIndex:anchorIndex];
+  if ((NSUInteger)anchorRange.location >= attributedString.length) {
+    return nil;
+  }
+
+  NSRange tailRange = NSMakeRange(anchorRange.location, attributedString.length - anchorRange.location);
+  NSAttributedString* tail = [attributedString attributedSubstringFromRange:tailRange];
+  CTFramesetterRef framesetter = CTFramesetterCreateWithAttributedString((__bridge CFAttributedStringRef)tail);
+  if (NULL == framesetter) {
+    return nil;
+  }
+  CGMutablePathRef path = CGPathCreateMutable();
+  CGPathAddRect(path, NULL, rect);
+  CTFrameRef tailFrame = CTFramesetterCreateFrame(framesetter, CFRangeMake(0, 0), path, NULL);
+  CGPathRelease(path);
+  CFRelease(framesetter);
+  if (NULL == tailFrame) {
+    return nil;
+  }
+
+  CFArrayRef tailLines = CTFrameGetLines(tailFrame);
+  CFIndex tailCount = CFArrayGetCount(tailLines);
+  if (0 == tailCount
+      || CTLineGetStringRange(CFArrayGetValueAtIndex(tailLines, 0)).length != anchorRange.length) {
+    // The anchor line broke differently on its own, so its position can't be trusted.
+    CFRelease(tailFrame);
+    return nil;
+  }
+  CGPoint tailOrigins[tailCount];
+  CTFrameGetLineOrigins(tailFrame, CFRangeMake(0, 0), tailOrigins);
+
+  CFMutableArrayRef lines = CFArrayCreateMutable(kCFAllocatorDefault, numberOfKeptLines + tailCount - 1, &kCFTypeArrayCallBacks);
+  CGPoint* lineOrigins = calloc((size_t)(numberOfKeptLines + tailCount - 1), sizeof(CGPoint));
+  CFIndex* stringOffsets = calloc((size_t)(numberOfKeptLines + tailCount - 1), sizeof(CFIndex));
+
+  for (CFIndex i = 0; i < numberOfKeptLines; i++) {
+    CFArrayAppendValue(lines, [self lineAtIndex:i]);
+    lineOrigins[i] = _lineOrigins[i];
+    stringOffsets[i] = _stringOffsets[i];
+  }
+
+  CFIndex count = numberOfKeptLines;
+  CGFloat anchorY = _lineOrigins[anchorIndex].y;
+  for (CFIndex i = 1; i < tailCount; i++) {
+    CTLineRef line = CFArrayGetValueAtIndex(tailLines, i);
+    CGPoint origin = tailOrigins[i];
+    origin.y = anchorY - (tailOrigins[0].y - origin.y);
+
+    CGFloat descent = 0.0f;
+    CTLineGetTypographicBounds(line, NULL, &descent, NULL);
+    if (origin.y - descent < 0) {
+      // Like a frame, stop at the first line that no longer fits.
+      break;
+    }
+    CFArrayAppendValue(lines, line);
+    lineOrigins[count] = origin;
+    stringOffsets[count] = anchorRange.location;
+    count++;
+  }
+  CFRelease(tailFrame);
+
+  return [[[self class] alloc] initWithLines:lines
+                                 lineOrigins:lineOrigins
+                               stringOffsets:stringOffsets
+                                   transform:_transform
+                              verticalOffset:_verticalOffset];
+}
+
+- (CFIndex)numberOfLines {
+  return _numberOfLines;
+}
+
+- (CTLineRef)lineAtIndex:(CFIndex)index {
+  return CFArrayGetValueAtIndex(_lines, index);
+}
+
+- (CGPoint)originOfLineAtIndex:(CFIndex)index {
+  return _lineOrigins[index];
+}
+
+- (CFIndex)stringOffsetOfLineAtIndex:(CFIndex)index {
+  return _stringOffsets[index];
+}
+
+- (CFRange)stringRangeOfLineAtIndex:(CFIndex)index {
+  CFRange range = CTLineGetStringRange([self lineAtIndex:index]);
+  range.location += _stringOffsets[index];
+  return range;
+}
+
+- (CGRect)boundsOfLineAtIndex:(CFIndex)index {
+  return _lineBounds[index];
+}
+
+- (CFIndex)indexOfFirstLineEndingBelowY:(CGFloat)y margin:(CGFloat)margin {
+  CFIndex low = 0;
+  CFIndex high = _numberOfLines;
+  while (low < high) {
+    CFIndex mid = low + (high - low) / 2;
+    if (CGRectGetMaxY(_lineBounds[mid]) + margin < y) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+// The first line whose text ends after the given string index.
+- (CFIndex)indexOfFirstLineEndingAfterStringIndex:(NSUInteger)stringIndex {
+  CFIndex low = 0;
+  CFIndex high = _numberOfLines;
+  while (low < high) {
+    CFIndex mid = low + (high - low) / 2;
+    CFRange lineRange = [self stringRangeOfLineAtIndex:mid];
+    if ((NSUInteger)(lineRange.location + lineRange.length) <= stringIndex) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+- (NSArray *)rectsForRange:(NSRange)range {
+  NSValue* key = [NSValue valueWithRange:range];
+  NSArray* rects = [_rectsForRanges objectForKey:key];
+  if (nil != rects) {
+    return rects;
+  }
+
+  NSMutableArray* mutableRects = [NSMutableArray array];
+  for (CFIndex i = [self indexOfFirstLineEndingAfterStringIndex:range.location]; i < _numberOfLines; i++) {
+    if ((NSUInteger)[self stringRangeOfLineAtIndex:i].location >= NSMaxRange(range)) {
+      break;
+    }
+
+    CGRect rect = NIRectForRangeInLine(range, self, i);
+    if (!CGRectIsEmpty(rect)) {
+      rect = CGRectApplyAffineTransform(rect, _transform);
+      rect = CGRectOffset(rect, 0, _verticalOffset);
+      [mutableRects addObject:[NSValue valueWithCGRect:rect]];
+    }
+  }
+  rects = [mutableRects copy];
+  [_rectsForRanges setObject:rects forKey:key];
+  return rects;
+}
+
+- (CTLineRef)truncatedLineAtIndex:(CFIndex)index
+               ofAttributedString:(NSAttributedString *)attributedString
+                            width:(CGFloat)width
+             tailTruncationString:(NSString *)tailTruncationString {
+  NSString* key = [NSString stringWithFormat:@"%ld:%g:%@", (long)index, (double)width, tailTruncationString];
+  CTLineRef line = (__bridge CTLineRef)[_truncatedLines objectForKey:key];
+  if (NULL == line) {
+    line = [[NIAttributedLabelLayoutCache sharedCache] copyTruncatedLineForAttributedString:attributedString
+                                                                                  lineRange:[self stringRangeOfLineAtIndex:index]
+                                                                                      width:width
+                                                                       tailTruncationString:tailTruncationString];
+    if (NULL == line) {
+      return NULL;
+    }
+    [_truncatedLines setObject:(__bridge id)line forKey:key];
+    CFRelease(line);
+  }
+  return line;
+}
+
+@end
+
+// Draws the first numberOfLines lines of lineIndex into ctx, truncating the last line when needed.
+// Only touches its arguments so that it can be called from the background rendering queue.
+static void NIAttributedLabelDrawLines(CGContextRef ctx, NSAttributedString* attributedString,
+                                       NIAttributedLabelLineIndex* lineIndex, CGRect rect, NSInteger numberOfLines,
+                                       BOOL truncatesLastLine, NSString* tailTruncationString) {
+  // This logic adapted from @mattt's TTTAttributedLabel
+  // https://github.com/mattt/TTTAttributedLabel
+
+  // When only part of the label is redrawn, e.g. an inline image that finished loading, the lines
+  // outside of it are skipped. They are given a line's height of slack for shadows.
+  CGRect clipRect = CGContextGetClipBoundingBox(ctx);
+
+  for (CFIndex i = 0; i < numberOfLines; i++) {
+    CGPoint lineOrigin = [lineIndex originOfLineAtIndex:i];
+    lineOrigin.y -= rect.origin.y; // adjust for verticalTextAlignment
+    CTLineRef line = [lineIndex lineAtIndex:i];
+
+    CGFloat ascent = 0.0f;
+    CGFloat descent = 0.0f;
+    CTLineGetTypographicBounds(line, &ascent, &descent, NULL);
+    CGFloat lineHeight = ascent + descent;
+    if (lineOrigin.y - descent - lineHeight > CGRectGetMaxY(clipRect)
+        || lineOrigin.y + ascent + lineHeight < CGRectGetMinY(clipRect)) {
+      continue;
+    }
+
+    CGContextSetTextPosition(ctx, lineOrigin.x, lineOrigin.y);
+
+    BOOL shouldDrawLine = YES;
+
+    if (truncatesLastLine && i == numberOfLines - 1) {
+      // Does the last line need truncation?
+      CFRange lastLineRange = [lineIndex stringRangeOfLineAtIndex:i];
+      if (lastLineRange.location + lastLineRange.length < (CFIndex)attributedString.length) {
+        NSString* tokenString = ((nil == tailTruncationString)
+                                 ? kEllipsesCharacter
+                                 : tailTruncationString);
+        CTLineRef truncatedLine = [lineIndex truncatedLineAtIndex:i
+                                               ofAttributedString:attributedString
+                                                            width:rect.size.width
+                                             tailTruncationString:tokenString];
+        if (NULL != truncatedLine) {
+          CTLineDraw(truncatedLine, ctx);
+          shouldDrawLine = NO;
+        }
+      }
+    }
+
+    if (shouldDrawLine) {
+      CTLineDraw(line, ctx);
+    }
+  }
+}
+
+// An immutable snapshot of everything needed to draw a label's text off the main thread.
+@interface NIAttributedLabelRendering : NSObject
+
+- (BOOL)isEquivalentToRendering:(NIAttributedLabelRendering *)rendering;
+- (UIImage *)render; // Safe to call from any thread.
+
+@property (nonatomic, copy)   NSAttributedString* attributedString;
+@property (nonatomic)         CGRect              bounds;
+@property (nonatomic)         CGRect              textRect; // Offset for verticalTextAlignment.
+@property (nonatomic)         NSInteger           numberOfLines;
+@property (nonatomic)         BOOL                truncatesLastLine;
+@property (nonatomic, copy)   NSString*           tailTruncationString;
+@property (nonatomic, strong) UIColor*            shadowColor;
+@property (nonatomic)         CGSize              shadowOffset;
+@property (nonatomic)         CGFloat             shadowBlur;
+@property (nonatomic)         CGFloat             scale;
+
+@property (nonatomic)         NSUInteger generation; // The label's text generation when snapshotted.
+@property (assign)            BOOL       cancelled;  // Atomic.
+@property (nonatomic, strong) UIImage*   image;      // Only set on the main thread.
+
+@end
+
+@implementation NIAttributedLabelRendering
+
+- (BOOL)isEquivalentToRendering:(NIAttributedLabelRendering *)rendering {
+  return (nil != rendering
+          && self.generation == rendering.generation
+          && CGRectEqualToRect(self.bounds, rendering.bounds)
+          && CGRectEqualToRect(self.textRect, rendering.textRect)
+          && self.numberOfLines == rendering.numberOfLines
+          && self.truncatesLastLine == rendering.truncatesLastLine
+          && self.scale == rendering.scale
+          && self.shadowBlur == rendering.shadowBlur
+          && CGSizeEqualToSize(self.shadowOffset, rendering.shadowOffset)
+          && (self.shadowColor == rendering.shadowColor || [self.shadowColor isEqual:rendering.shadowColor])
+          && (self.tailTruncationString == rendering.tailTruncationString
+              || [self.tailTruncationString isEqualToString:rendering.tailTruncationString])
+          && [self.attributedString isEqualToAttributedString:rendering.attributedString]);
+}
+
+- (UIImage *)render {
+  if (self.bounds.size.width <= 0 || self.bounds.size.height <= 0) {
+    return nil;
+  }
+  CTFrameRef textFrame = [[NIAttributedLabelLayoutCache sharedCache] copyFrameForAttributedString:self.attributedString
+                                                                                              rect:self.bounds];
+  if (NULL == textFrame) {
+    return nil;
+  }
+  NIAttributedLabelLineIndex* lineIndex = [[NIAttributedLabelLineIndex alloc] initWithTextFrame:textFrame
+                                                                                      transform:CGAffineTransformIdentity
+                                                                                 verticalOffset:0];
+  CFRelease(textFrame);
+  CFIndex lineCount = lineIndex.numberOfLines;
+  NSInteger numberOfLines = self.numberOfLines > 0 ? MIN(self.numberOfLines, lineCount) : lineCount;
+
+  UIGraphicsBeginImageContextWithOptions(self.bounds.size, NO, self.scale);
+  CGContextRef ctx = UIGraphicsGetCurrentContext();
+
+  // CoreText context coordinates are the opposite to UIKit so we flip the bounds
+  CGContextConcatCTM(ctx, CGAffineTransformScale(CGAffineTransformMakeTranslation(0, self.bounds.size.height), 1.f, -1.f));
+
+  if (nil != self.shadowColor) {
+    CGContextSetShadowWithColor(ctx, self.shadowOffset, self.shadowBlur, self.shadowColor.CGColor);
+  }
+
+  NIAttributedLabelDrawLines(ctx, self.attributedString, lineIndex, self.textRect, numberOfLines,
+                             self.truncatesLastLine, self.tailTruncationString);
+
+  UIImage* image = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  return image;
 }
 
 @end
@@ -123,6 +688,7 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
 @property (nonatomic, strong) NSMutableAttributedString* mutableAttributedString;
 
 @property (nonatomic) CTFrameRef textFrame; // CFType, manually managed lifetime, see setter.
+@property (nonatomic, strong) NIAttributedLabelLineIndex* lineIndex; // Built lazily from textFrame unless appended to.
 
 @property (assign)            BOOL detectingLinks; // Atomic.
 @property (nonatomic)         BOOL linksHaveBeenDetected;
@@ -137,17 +703,21 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
 
 @property (nonatomic, strong) NSTextCheckingResult* actionSheetLink;
 
-@property (nonatomic, copy) NSArray* accessibleElements;
+// Used when highlightsLinksInOverlay is enabled. Both only ever cover the highlighted link.
+@property (nonatomic, strong) CAShapeLayer* linkHighlightLayer;
+@property (nonatomic, strong) CALayer*      linkHighlightGlyphsLayer;
 
-@property (nonatomic, strong) NSMutableArray *images;
-
-@end
+// Elements are made as they are asked for; slots that haven't been asked for yet hold NSNull.
+// There's one slot per link rect followed by one for the label's text.
+@property (nonatomic, strong) NSMutableArray* accessibleElements;
+@property (nonatomic, copy)   NSArray* accessibleLinkRects; // Of @[NSTextCheckingResult, NSValue with CGRect].
+@property (nonatomic)         BOOL accessibleElementsIncludeLinks;
 
-@interface NIAttributedLabel (ConversionUtilities)
+@property (nonatomic, strong) NSMutableArray *images;
 
-+ (CTTextAlignment)alignmentFromUITextAlignment:(NSTextAlignment)alignment;
-+ (CTLineBreakMode)lineBreakModeFromUILineBreakMode:(NSLineBreakMode)lineBreakMode;
-+ (NSMutableAttributedString *)mutableAttributedStringFromLabel:(UILabel *)label;
+@property (nonatomic)         NSUInteger                  textGeneration;
+@property (nonatomic, strong) NIAttributedLabelRendering* renderedText;
+@property (nonatomic, strong) NIAttributedLabelRendering* pendingRendering;
 
 @end
 
@@ -157,6 +727,7 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
 
 - (void)dealloc {
   [_longPressTimer invalidate];
+  _pendingRendering.cancelled = YES;
 
   // The property is marked 'assign', but retain count for this CFType is managed here and via
   // the setter.
@@ -167,34 +738,29 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
 
 - (CTFrameRef)textFrame {
   if (NULL == _textFrame) {
+    // Shares the typesetting with sizeThatFits: and with any other label showing the same text.
     NSMutableAttributedString* attributedStringWithLinks = [self mutableAttributedStringWithAdditions];
-    CFAttributedStringRef attributedString = (__bridge CFAttributedStringRef)attributedStringWithLinks;
-    CTFramesetterRef framesetter = CTFramesetterCreateWithAttributedString(attributedString);
-    NIDASSERT(NULL != framesetter);
-    if (NULL == framesetter) {
-      return NULL;
-    }
-
-    CGMutablePathRef path = CGPathCreateMutable();
-    NIDASSERT(NULL != path);
-    if (NULL == path) {
-      CFRelease(framesetter);
-      return NULL;
-    }
-
-    CGPathAddRect(path, NULL, self.bounds);
-    CTFrameRef textFrame = CTFramesetterCreateFrame(framesetter, CFRangeMake(0, 0), path, NULL);
+    CTFrameRef textFrame = [[NIAttributedLabelLayoutCache sharedCache] copyFrameForAttributedString:attributedStringWithLinks
+                                                                                                 rect:self.bounds];
+    NIDASSERT(NULL != textFrame);
     self.textFrame = textFrame;
     if (textFrame) {
       CFRelease(textFrame);
     }
-    CGPathRelease(path);
-    CFRelease(framesetter);
   }
 
   return _textFrame;
 }
 
+- (NIAttributedLabelLineIndex *)lineIndex {
+  if (nil == _lineIndex && NULL != self.textFrame) {
+    _lineIndex = [[NIAttributedLabelLineIndex alloc] initWithTextFrame:self.textFrame
+                                                           transform:[self _transformForCoreText]
+                                                      verticalOffset:[self _verticalOffsetForBounds:self.bounds]];
+  }
+  return _lineIndex;
+}
+
 - (void)setTextFrame:(CTFrameRef)textFrame {
   // The property is marked 'assign', but retain count for this CFType is managed via this setter
   // and -dealloc.
@@ -233,7 +799,14 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
 
 - (void)resetTextFrame {
   self.textFrame = NULL;
-  self.accessibleElements = nil;
+  self.lineIndex = nil;
+  // The elements hold the old text and their frames in window coordinates, which change with
+  // the label's frame even when an equal text frame comes back from the layout cache.
+  [self invalidateAccessibleElements];
+
+  // Any background rendering of the old text is now stale.
+  self.textGeneration++;
+  [self cancelPendingRendering];
 }
 
 - (void)attributedTextDidChange {
@@ -270,13 +843,9 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
 - (void)setText:(NSString *)text {
   [super setText:text];
 
-  self.attributedText = [[self class] mutableAttributedStringFromLabel:self];
-
-  // Apply NIAttributedLabel-specific styles.
-  [self.mutableAttributedString setUnderlineStyle:_underlineStyle modifier:_underlineStyleModifier];
-  [self.mutableAttributedString setStrokeWidth:_strokeWidth];
-  [self.mutableAttributedString setStrokeColor:_strokeColor];
-  [self.mutableAttributedString setKern:_textKern];
+  // Built by a layout descriptor so that text measured without a label matches what we draw.
+  NIAttributedLabelLayoutDescriptor* descriptor = [NIAttributedLabelLayoutDescriptor descriptorWithLabel:self];
+  self.attributedText = [descriptor attributedStringWithString:text];
 }
 
 // Deprecated.
@@ -312,6 +881,64 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
   }
 }
 
+- (void)appendAttributedString:(NSAttributedString *)attributedString {
+  if (0 == attributedString.length) {
+    return;
+  }
+  if (0 == self.mutableAttributedString.length) {
+    self.attributedText = attributedString;
+    return;
+  }
+
+  NSString* oldString = self.mutableAttributedString.string;
+  NSUInteger oldLength = oldString.length;
+
+  // Everything before the paragraph that the new text continues is unaffected by it.
+  NSRange lastBreak = [oldString rangeOfCharacterFromSet:[NSCharacterSet newlineCharacterSet]
+                                                 options:NSBackwardsSearch
+                                                   range:NSMakeRange(0, oldLength)];
+  NSUInteger paragraphStart = (NSNotFound == lastBreak.location) ? 0 : NSMaxRange(lastBreak);
+
+  [self.mutableAttributedString appendAttributedString:attributedString];
+  NSString* string = self.mutableAttributedString.string;
+
+  NSArray* appendedLinks = [self _linksInAttributedString:self.mutableAttributedString
+                                                     range:NSMakeRange(oldLength, attributedString.length)];
+  if (appendedLinks.count > 0) {
+    NSMutableArray* explicitLinkLocations = [self.explicitLinkLocations mutableCopy] ?: [NSMutableArray array];
+    [explicitLinkLocations addObjectsFromArray:appendedLinks];
+    self.explicitLinkLocations = explicitLinkLocations;
+  }
+
+  if (self.autoDetectLinks && self.linksHaveBeenDetected) {
+    // Links found in earlier paragraphs still stand; only the last paragraph is detected again.
+    NSMutableArray* links = [NSMutableArray array];
+    for (NSTextCheckingResult* result in self.detectedlinkLocations) {
+      if (NSMaxRange(result.range) <= paragraphStart) {
+        [links addObject:result];
+      }
+    }
+    [links addObjectsFromArray:[NIDataDetectorForTypes(self.dataDetectorTypes) matchesInString:string
+                                                                                        options:0
+                                                                                          range:NSMakeRange(paragraphStart, string.length - paragraphStart)]];
+    self.detectedlinkLocations = links;
+  }
+
+  // Keep the lines that are already typeset when we can place new lines without measuring the
+  // whole text, i.e. when the text hangs from the top and has no inline images.
+  NIAttributedLabelLineIndex* lineIndex = nil;
+  if (nil != _lineIndex
+      && NIVerticalTextAlignmentTop == self.verticalTextAlignment
+      && 0 == self.images.count) {
+    lineIndex = [_lineIndex indexByTypesettingAttributedString:[self mutableAttributedStringWithAdditions]
+                                               fromStringIndex:paragraphStart
+                                                          rect:self.bounds];
+  }
+
+  [self attributedTextDidChange];
+  self.lineIndex = lineIndex;
+}
+
 - (void)setAutoDetectLinks:(BOOL)autoDetectLinks {
   _autoDetectLinks = autoDetectLinks;
 
@@ -414,6 +1041,15 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
   [self attributedTextDidChange];
 }
 
+- (void)setVerticalTextAlignment:(NIVerticalTextAlignment)verticalTextAlignment {
+  if (_verticalTextAlignment != verticalTextAlignment) {
+    _verticalTextAlignment = verticalTextAlignment;
+
+    // The line index holds line origins offset for the old alignment.
+    [self attributedTextDidChange];
+  }
+}
+
 - (void)setShadowBlur:(CGFloat)shadowBlur {
   if (_shadowBlur != shadowBlur) {
     _shadowBlur = shadowBlur;
@@ -422,6 +1058,18 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
   }
 }
 
+- (void)setDisplaysAsynchronously:(BOOL)displaysAsynchronously {
+  if (_displaysAsynchronously != displaysAsynchronously) {
+    _displaysAsynchronously = displaysAsynchronously;
+
+    if (!_displaysAsynchronously) {
+      [self cancelPendingRendering];
+      self.renderedText = nil;
+    }
+    [self setNeedsDisplay];
+  }
+}
+
 - (void)setStrokeWidth:(CGFloat)strokeWidth {
   if (_strokeWidth != strokeWidth) {
     _strokeWidth = strokeWidth;
@@ -530,14 +1178,14 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
 - (void)setExplicitLinkLocations:(NSMutableArray *)explicitLinkLocations {
   if (_explicitLinkLocations != explicitLinkLocations) {
     _explicitLinkLocations = explicitLinkLocations;
-    self.accessibleElements = nil;
+    [self invalidateAccessibleElements];
   }
 }
 
 - (void)setDetectedlinkLocations:(NSArray *)detectedlinkLocations{
   if (_detectedlinkLocations != detectedlinkLocations) {
     _detectedlinkLocations = detectedlinkLocations;
-    self.accessibleElements = nil;
+    [self invalidateAccessibleElements];
   }
 }
 
@@ -560,24 +1208,33 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
 }
 
 - (NSArray *)_matchesFromAttributedString:(NSString *)string {
-  NSError* error = nil;
-  NSDataDetector* linkDetector = [NSDataDetector dataDetectorWithTypes:(NSTextCheckingTypes)self.dataDetectorTypes
-                                                                 error:&error];
-  NSRange range = NSMakeRange(0, string.length);
-
-  return [linkDetector matchesInString:string options:0 range:range];
+  return NILinkMatchesInString(string, self.dataDetectorTypes);
 }
 
 - (void)_deferLinkDetection {
   if (!self.detectingLinks) {
+    NSString* string = [self.mutableAttributedString.string copy];
+
+    // Text that was shown recently, e.g. in a reused cell, gets its links without waiting.
+    NSArray* cachedMatches = NICachedLinkMatchesInString(string, self.dataDetectorTypes);
+    if (nil != cachedMatches) {
+      self.detectedlinkLocations = cachedMatches;
+      self.linksHaveBeenDetected = YES;
+      return;
+    }
+
     self.detectingLinks = YES;
 
-    NSString* string = [self.mutableAttributedString.string copy];
     dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
       NSArray* matches = [self _matchesFromAttributedString:string];
       self.detectingLinks = NO;
 
       dispatch_async(dispatch_get_main_queue(), ^{
+        // The text changed while we were detecting, so detect the new text on the next draw.
+        if (![self.mutableAttributedString.string isEqualToString:string]) {
+          [self setNeedsDisplay];
+          return;
+        }
         self.detectedlinkLocations = matches;
         self.linksHaveBeenDetected = YES;
 
@@ -605,16 +1262,6 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
   }
 }
 
-- (CGRect)getLineBounds:(CTLineRef)line point:(CGPoint) point {
-  CGFloat ascent = 0.0f;
-  CGFloat descent = 0.0f;
-  CGFloat leading = 0.0f;
-  CGFloat width = (CGFloat)CTLineGetTypographicBounds(line, &ascent, &descent, &leading);
-  CGFloat height = ascent + descent;
-
-  return CGRectMake(point.x, point.y - descent, width, height);
-}
-
 - (NSTextCheckingResult *)linkAtIndex:(CFIndex)i {
   NSTextCheckingResult* foundResult = nil;
 
@@ -641,20 +1288,25 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
   return foundResult;
 }
 
-- (void)_processLinksInAttributedString:(NSAttributedString *)attributedString {
-  // Pull any attributes matching the link attribute from the attributed string and store them as
-  // the current set of explicit links. This properly handles the value of the attribute being
-  // either an NSURL or an NSString.
+- (NSMutableArray *)_linksInAttributedString:(NSAttributedString *)attributedString range:(NSRange)range {
+  // Pull any attributes matching the link attribute from the attributed string. This properly
+  // handles the value of the attribute being either an NSURL or an NSString.
   __block NSMutableArray *links = [NSMutableArray array];
   [attributedString enumerateAttribute:NIAttributedLabelLinkAttributeName
-                               inRange:NSMakeRange(0, attributedString.length)
+                               inRange:range
                                options:0
                             usingBlock:^(NSTextCheckingResult *value, NSRange range, BOOL *stop) {
                               if (value != nil) {
                                 [links addObject:value];
                               }
                             }];
-  self.explicitLinkLocations = links;
+  return links;
+}
+
+- (void)_processLinksInAttributedString:(NSAttributedString *)attributedString {
+  // Store the string's links as the current set of explicit links.
+  self.explicitLinkLocations = [self _linksInAttributedString:attributedString
+                                                        range:NSMakeRange(0, attributedString.length)];
 }
 
 - (CGFloat)_verticalOffsetForBounds:(CGRect)bounds {
@@ -685,30 +1337,24 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
     return nil;
   }
 
-  CFArrayRef lines = CTFrameGetLines(self.textFrame);
-  if (!lines) return nil;
-  CFIndex count = CFArrayGetCount(lines);
-
-  CGPoint origins[count];
-  CTFrameGetLineOrigins(self.textFrame, CFRangeMake(0,0), origins);
-
-  CGAffineTransform transform = [self _transformForCoreText];
-  CGFloat verticalOffset = [self _verticalOffsetForBounds:self.bounds];
+  NIAttributedLabelLineIndex* lineIndex = self.lineIndex;
+  CFIndex count = lineIndex.numberOfLines;
 
-  for (int i = 0; i < count; i++) {
-    CGPoint linePoint = origins[i];
-
-    CTLineRef line = CFArrayGetValueAtIndex(lines, i);
-    CGRect flippedRect = [self getLineBounds:line point:linePoint];
-    CGRect rect = CGRectApplyAffineTransform(flippedRect, transform);
-
-    rect = CGRectInset(rect, 0, -kVMargin);
-    rect = CGRectOffset(rect, 0, verticalOffset);
+  for (CFIndex i = [lineIndex indexOfFirstLineEndingBelowY:point.y margin:kVMargin]; i < count; i++) {
+    CGRect rect = CGRectInset([lineIndex boundsOfLineAtIndex:i], 0, -kVMargin);
+    if (CGRectGetMinY(rect) > point.y) {
+      // This and every following line starts below the point.
+      break;
+    }
 
     if (CGRectContainsPoint(rect, point)) {
       CGPoint relativePoint = CGPointMake(point.x-CGRectGetMinX(rect),
                                           point.y-CGRectGetMinY(rect));
-      CFIndex idx = CTLineGetStringIndexForPosition(line, relativePoint);
+      CFIndex idx = CTLineGetStringIndexForPosition([lineIndex lineAtIndex:i], relativePoint);
+      if (kCFNotFound == idx) {
+        continue;
+      }
+      idx += [lineIndex stringOffsetOfLineAtIndex:i];
 
       NSUInteger offset = 0;
       for (NIAttributedLabelImage *labelImage in self.images) {
@@ -726,126 +1372,26 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
   return nil;
 }
 
-- (CGRect)_rectForRange:(NSRange)range inLine:(CTLineRef)line lineOrigin:(CGPoint)lineOrigin {
-  CGRect rectForRange = CGRectZero;
-  CFArrayRef runs = CTLineGetGlyphRuns(line);
-  CFIndex runCount = CFArrayGetCount(runs);
-
-  // Iterate through each of the "runs" (i.e. a chunk of text) and find the runs that
-  // intersect with the range.
-  for (CFIndex k = 0; k < runCount; k++) {
-    CTRunRef run = CFArrayGetValueAtIndex(runs, k);
-
-    CFRange stringRunRange = CTRunGetStringRange(run);
-    NSRange lineRunRange = NSMakeRange(stringRunRange.location, stringRunRange.length);
-    NSRange intersectedRunRange = NSIntersectionRange(lineRunRange, range);
-
-    if (intersectedRunRange.length == 0) {
-      // This run doesn't intersect the range, so skip it.
-      continue;
-    }
-
-    CGFloat ascent = 0.0f;
-    CGFloat descent = 0.0f;
-    CGFloat leading = 0.0f;
-
-    // Use of 'leading' doesn't properly highlight Japanese-character link.
-    CGFloat width = (CGFloat)CTRunGetTypographicBounds(run,
-                                                       CFRangeMake(0, 0),
-                                                       &ascent,
-                                                       &descent,
-                                                       NULL); //&leading);
-    CGFloat height = ascent + descent;
-
-    CGFloat xOffset = CTLineGetOffsetForStringIndex(line, CTRunGetStringRange(run).location, nil);
-
-    CGRect linkRect = CGRectMake(lineOrigin.x + xOffset - leading, lineOrigin.y - descent, width + leading, height);
-
-    linkRect.origin.y = NICGFloatRound(linkRect.origin.y);
-    linkRect.origin.x = NICGFloatRound(linkRect.origin.x);
-    linkRect.size.width = NICGFloatRound(linkRect.size.width);
-    linkRect.size.height = NICGFloatRound(linkRect.size.height);
-
-    if (CGRectIsEmpty(rectForRange)) {
-      rectForRange = linkRect;
-
-    } else {
-      rectForRange = CGRectUnion(rectForRange, linkRect);
-    }
-  }
-
-  return rectForRange;
-}
-
 - (BOOL)isPoint:(CGPoint)point nearLink:(NSTextCheckingResult *)link {
-  CFArrayRef lines = CTFrameGetLines(self.textFrame);
-  if (nil == lines) {
-    return NO;
-  }
-  CFIndex count = CFArrayGetCount(lines);
-  CGPoint lineOrigins[count];
-  CTFrameGetLineOrigins(self.textFrame, CFRangeMake(0, 0), lineOrigins);
-
-  CGAffineTransform transform = [self _transformForCoreText];
-  CGFloat verticalOffset = [self _verticalOffsetForBounds:self.bounds];
-
-  NSRange linkRange = link.range;
-
-  BOOL isNearLink = NO;
-  for (int i = 0; i < count; i++) {
-    CTLineRef line = CFArrayGetValueAtIndex(lines, i);
-
-    CGRect linkRect = [self _rectForRange:linkRange inLine:line lineOrigin:lineOrigins[i]];
-
-    if (!CGRectIsEmpty(linkRect)) {
-      linkRect = CGRectApplyAffineTransform(linkRect, transform);
-      linkRect = CGRectOffset(linkRect, 0, verticalOffset);
-      linkRect = CGRectInset(linkRect, -kTouchGutter, -kTouchGutter);
-      if (CGRectContainsPoint(linkRect, point)) {
-        isNearLink = YES;
-        break;
-      }
+  for (NSValue* rectValue in [self.lineIndex rectsForRange:link.range]) {
+    CGRect linkRect = CGRectInset([rectValue CGRectValue], -kTouchGutter, -kTouchGutter);
+    if (CGRectContainsPoint(linkRect, point)) {
+      return YES;
     }
   }
-
-  return isNearLink;
+  return NO;
 }
 
 - (NSArray *)_rectsForLink:(NSTextCheckingResult *)link {
-  CFArrayRef lines = CTFrameGetLines(self.textFrame);
-  if (nil == lines) {
-    return nil;
-  }
-  CFIndex count = CFArrayGetCount(lines);
-  CGPoint lineOrigins[count];
-  CTFrameGetLineOrigins(self.textFrame, CFRangeMake(0, 0), lineOrigins);
-
-  CGAffineTransform transform = [self _transformForCoreText];
-  CGFloat verticalOffset = [self _verticalOffsetForBounds:self.bounds];
-
-  NSRange linkRange = link.range;
-
-  NSMutableArray* rects = [NSMutableArray array];
-  for (int i = 0; i < count; i++) {
-    CTLineRef line = CFArrayGetValueAtIndex(lines, i);
-
-    CGRect linkRect = [self _rectForRange:linkRange inLine:line lineOrigin:lineOrigins[i]];
-
-    if (!CGRectIsEmpty(linkRect)) {
-      linkRect = CGRectApplyAffineTransform(linkRect, transform);
-      linkRect = CGRectOffset(linkRect, 0, verticalOffset);
-      [rects addObject:[NSValue valueWithCGRect:linkRect]];
-    }
-  }
-
-  return [rects copy];
+  return [self.lineIndex rectsForRange:link.range];
 }
 
 - (void)setTouchedLink:(NSTextCheckingResult *)touchedLink {
   if (_touchedLink != touchedLink) {
     _touchedLink = touchedLink;
 
-    if (self.attributesForHighlightedLink.count > 0) {
+    // The overlay draws the highlighted attributes itself, so the text keeps its layout.
+    if (self.attributesForHighlightedLink.count > 0 && !self.highlightsLinksInOverlay) {
       [self attributedTextDidChange];
     }
   }
@@ -869,7 +1415,7 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
     [super touchesBegan:touches withEvent:event];
   }
 
-  [self setNeedsDisplay];
+  [self linkHighlightDidChange];
 }
 
 - (void)touchesMoved:(NSSet *)touches withEvent:(UIEvent *)event {
@@ -894,7 +1440,7 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
       if (oldTouchedLink != self.touchedLink) {
         [self.longPressTimer invalidate];
         self.longPressTimer = nil;
-        [self setNeedsDisplay];
+        [self linkHighlightDidChange];
       }
     }
 
@@ -932,7 +1478,7 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
 
     self.touchedLink = nil;
     self.originalLink = nil;
-    [self setNeedsDisplay];
+    [self linkHighlightDidChange];
 
   } else {
     [super touchesEnded:touches withEvent:event];
@@ -948,7 +1494,7 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
   self.touchedLink = nil;
   self.originalLink = nil;
 
-  [self setNeedsDisplay];
+  [self linkHighlightDidChange];
 }
 
 - (UIActionSheet *)actionSheetForResult:(NSTextCheckingResult *)result {
@@ -1046,7 +1592,8 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
     if (self.attributesForLinks.count > 0) {
       [attributedString addAttributes:self.attributesForLinks range:result.range];
     }
-    if (self.attributesForHighlightedLink.count > 0 && NSEqualRanges(result.range, self.touchedLink.range)) {
+    if (self.attributesForHighlightedLink.count > 0 && !self.highlightsLinksInOverlay
+        && NSEqualRanges(result.range, self.touchedLink.range)) {
       [attributedString addAttributes:self.attributesForHighlightedLink range:result.range];
     }
   }
@@ -1136,8 +1683,8 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
 }
 
 - (NSInteger)numberOfDisplayedLines {
-  CFArrayRef lines = CTFrameGetLines(self.textFrame);
-  return self.numberOfLines > 0 ? MIN(self.numberOfLines, CFArrayGetCount(lines)) : CFArrayGetCount(lines);
+  CFIndex count = self.lineIndex.numberOfLines;
+  return self.numberOfLines > 0 ? MIN(self.numberOfLines, count) : count;
 }
 
 - (void)drawImages {
@@ -1208,38 +1755,37 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
 
       CGRect imageRect = UIEdgeInsetsInsetRect(rect, flippedMargins);
       imageRect = CGRectOffset(imageRect, 0, -[self _verticalOffsetForBounds:self.bounds]);
-      CGContextDrawImage(ctx, imageRect, labelImage.image.CGImage);
+      labelImage.displayRect = CGRectApplyAffineTransform(imageRect, [self _transformForCoreText]);
+      if (nil != labelImage.image) {
+        CGContextDrawImage(ctx, imageRect, labelImage.image.CGImage);
+      }
     }
   }
 }
 
 - (void)drawHighlightWithRect:(CGRect)rect {
-  if ((nil == self.touchedLink && nil == self.actionSheetLink) || nil == self.highlightedLinkBackgroundColor) {
+  if ((nil == self.touchedLink && nil == self.actionSheetLink) || nil == self.highlightedLinkBackgroundColor
+      || self.highlightsLinksInOverlay) {
     return;
   }
   [self.highlightedLinkBackgroundColor setFill];
 
   NSRange linkRange = nil != self.touchedLink ? self.touchedLink.range : self.actionSheetLink.range;
 
-  CFArrayRef lines = CTFrameGetLines(self.textFrame);
-  CFIndex count = CFArrayGetCount(lines);
-  CGPoint lineOrigins[count];
-  CTFrameGetLineOrigins(self.textFrame, CFRangeMake(0, 0), lineOrigins);
+  NIAttributedLabelLineIndex* lineIndex = self.lineIndex;
   NSInteger numberOfLines = [self numberOfDisplayedLines];
 
   CGContextRef ctx = UIGraphicsGetCurrentContext();
 
   for (CFIndex i = 0; i < numberOfLines; i++) {
-    CTLineRef line = CFArrayGetValueAtIndex(lines, i);
-
-    CFRange stringRange = CTLineGetStringRange(line);
+    CFRange stringRange = [lineIndex stringRangeOfLineAtIndex:i];
     NSRange lineRange = NSMakeRange(stringRange.location, stringRange.length);
     NSRange intersectedRange = NSIntersectionRange(lineRange, linkRange);
     if (intersectedRange.length == 0) {
       continue;
     }
 
-    CGRect highlightRect = [self _rectForRange:linkRange inLine:line lineOrigin:lineOrigins[i]];
+    CGRect highlightRect = NIRectForRangeInLine(linkRange, lineIndex, i);
     highlightRect = CGRectOffset(highlightRect, 0, -rect.origin.y);
 
     if (!CGRectIsEmpty(highlightRect)) {
@@ -1265,76 +1811,210 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
   }
 }
 
-- (void)drawAttributedString:(NSAttributedString *)attributedString rect:(CGRect)rect {
-  CGContextRef ctx = UIGraphicsGetCurrentContext();
+#pragma mark - Link Highlight Overlay
 
-  // This logic adapted from @mattt's TTTAttributedLabel
-  // https://github.com/mattt/TTTAttributedLabel
+- (void)setHighlightsLinksInOverlay:(BOOL)highlightsLinksInOverlay {
+  if (_highlightsLinksInOverlay != highlightsLinksInOverlay) {
+    _highlightsLinksInOverlay = highlightsLinksInOverlay;
 
-  CFArrayRef lines = CTFrameGetLines(self.textFrame);
-  NSInteger numberOfLines = [self numberOfDisplayedLines];
+    [self updateLinkHighlightOverlay];
+    if (self.attributesForHighlightedLink.count > 0 && nil != self.touchedLink) {
+      [self attributedTextDidChange];
+    } else {
+      [self setNeedsDisplay];
+    }
+  }
+}
 
-  BOOL truncatesLastLine = (self.lineBreakMode == NSLineBreakByTruncatingTail);
-  CGPoint lineOrigins[numberOfLines];
-  CTFrameGetLineOrigins(self.textFrame, CFRangeMake(0, numberOfLines), lineOrigins);
+- (void)linkHighlightDidChange {
+  if (self.highlightsLinksInOverlay) {
+    [self updateLinkHighlightOverlay];
+  } else {
+    [self setNeedsDisplay];
+  }
+}
 
-  for (CFIndex lineIndex = 0; lineIndex < numberOfLines; lineIndex++) {
-    CGPoint lineOrigin = lineOrigins[lineIndex];
-    lineOrigin.y -= rect.origin.y; // adjust for verticalTextAlignment
-    CGContextSetTextPosition(ctx, lineOrigin.x, lineOrigin.y);
-    CTLineRef line = CFArrayGetValueAtIndex(lines, lineIndex);
+// Shows the highlight of the touched link, or of the link whose action sheet is showing, above
+// the text. The background is a path built from the link's cached rects; only the glyphs of the
+// link are drawn again, and only when attributesForHighlightedLink restyles them.
+- (void)updateLinkHighlightOverlay {
+  NSTextCheckingResult* link = (nil != self.touchedLink) ? self.touchedLink : self.actionSheetLink;
+  NSArray* rects = (self.highlightsLinksInOverlay && nil != link) ? [self _rectsForLink:link] : nil;
 
-    BOOL shouldDrawLine = YES;
+  [CATransaction begin];
+  [CATransaction setDisableActions:YES];
 
-    if (truncatesLastLine && lineIndex == numberOfLines - 1) {
-      // Does the last line need truncation?
-      CFRange lastLineRange = CTLineGetStringRange(line);
-      if (lastLineRange.location + lastLineRange.length < (CFIndex)attributedString.length) {
-        CTLineTruncationType truncationType = kCTLineTruncationEnd;
-        NSUInteger truncationAttributePosition = lastLineRange.location + lastLineRange.length - 1;
-
-        NSAttributedString* tokenAttributedString;
-        {
-          NSDictionary *tokenAttributes = [attributedString attributesAtIndex:truncationAttributePosition
-                                                               effectiveRange:NULL];
-          NSString* tokenString = ((nil == self.tailTruncationString)
-                                   ? kEllipsesCharacter
-                                   : self.tailTruncationString);
-          tokenAttributedString = [[NSAttributedString alloc] initWithString:tokenString attributes:tokenAttributes];
-        }
+  if (nil == self.highlightedLinkBackgroundColor || 0 == rects.count) {
+    self.linkHighlightLayer.hidden = YES;
+  } else {
+    if (nil == self.linkHighlightLayer) {
+      self.linkHighlightLayer = [CAShapeLayer layer];
+      [self.layer addSublayer:self.linkHighlightLayer];
+    }
+    UIBezierPath* path = [UIBezierPath bezierPath];
+    for (NSValue* rectValue in rects) {
+      [path appendPath:[UIBezierPath bezierPathWithRoundedRect:rectValue.CGRectValue cornerRadius:1]];
+    }
+    self.linkHighlightLayer.frame = self.bounds;
+    self.linkHighlightLayer.path = path.CGPath;
+    self.linkHighlightLayer.fillColor = self.highlightedLinkBackgroundColor.CGColor;
+    self.linkHighlightLayer.hidden = NO;
+  }
 
-        CTLineRef truncationToken = CTLineCreateWithAttributedString((__bridge CFAttributedStringRef)tokenAttributedString);
+  UIImage* glyphs = nil;
+  CGRect glyphsRect = CGRectZero;
+  if (self.attributesForHighlightedLink.count > 0 && rects.count > 0 && 0 == self.images.count) {
+    for (NSValue* rectValue in rects) {
+      glyphsRect = CGRectIsEmpty(glyphsRect) ? rectValue.CGRectValue : CGRectUnion(glyphsRect, rectValue.CGRectValue);
+    }
+    glyphsRect = CGRectIntegral(glyphsRect);
+    glyphs = [self highlightedGlyphsOfLink:link rects:rects inRect:glyphsRect];
+  }
+  if (nil == glyphs) {
+    self.linkHighlightGlyphsLayer.hidden = YES;
+  } else {
+    if (nil == self.linkHighlightGlyphsLayer) {
+      self.linkHighlightGlyphsLayer = [CALayer layer];
+      [self.layer addSublayer:self.linkHighlightGlyphsLayer];
+    }
+    self.linkHighlightGlyphsLayer.frame = glyphsRect;
+    self.linkHighlightGlyphsLayer.contents = (__bridge id)glyphs.CGImage;
+    self.linkHighlightGlyphsLayer.contentsScale = glyphs.scale;
+    self.linkHighlightGlyphsLayer.hidden = NO;
+  }
 
-        NSMutableAttributedString *truncationString = [[attributedString attributedSubstringFromRange:NSMakeRange(lastLineRange.location, lastLineRange.length)] mutableCopy];
-        if (lastLineRange.length > 0) {
-          // Remove any whitespace at the end of the line.
-          unichar lastCharacter = [[truncationString string] characterAtIndex:lastLineRange.length - 1];
-          if ([[NSCharacterSet whitespaceAndNewlineCharacterSet] characterIsMember:lastCharacter]) {
-            [truncationString deleteCharactersInRange:NSMakeRange(lastLineRange.length - 1, 1)];
-          }
-        }
-        [truncationString appendAttributedString:tokenAttributedString];
+  [CATransaction commit];
+}
 
-        CTLineRef truncationLine = CTLineCreateWithAttributedString((__bridge CFAttributedStringRef)truncationString);
-        CTLineRef truncatedLine = CTLineCreateTruncatedLine(truncationLine, rect.size.width, truncationType, truncationToken);
-        if (!truncatedLine) {
-          // If the line is not as wide as the truncationToken, truncatedLine is NULL
-          truncatedLine = CFRetain(truncationToken);
-        }
-        CFRelease(truncationLine);
-        CFRelease(truncationToken);
+// Draws the link restyled with attributesForHighlightedLink, clipped to its rects and covering
+// the glyphs beneath with the label's background and highlight colors.
+- (UIImage *)highlightedGlyphsOfLink:(NSTextCheckingResult *)link rects:(NSArray *)rects inRect:(CGRect)glyphsRect {
+  NSMutableAttributedString* attributedString = [self mutableAttributedStringWithAdditions];
+  if (nil == attributedString || NSMaxRange(link.range) > attributedString.length) {
+    return nil;
+  }
+  [attributedString addAttributes:self.attributesForHighlightedLink range:link.range];
 
-        CTLineDraw(truncatedLine, ctx);
-        CFRelease(truncatedLine);
+  CTFrameRef textFrame = [[NIAttributedLabelLayoutCache sharedCache] copyFrameForAttributedString:attributedString
+                                                                                              rect:self.bounds];
+  if (NULL == textFrame) {
+    return nil;
+  }
+  NIAttributedLabelLineIndex* lineIndex = [[NIAttributedLabelLineIndex alloc] initWithTextFrame:textFrame
+                                                                                      transform:CGAffineTransformIdentity
+                                                                                 verticalOffset:0];
+  CFRelease(textFrame);
+  CFIndex lineCount = lineIndex.numberOfLines;
+  NSInteger numberOfLines = self.numberOfLines > 0 ? MIN(self.numberOfLines, lineCount) : lineCount;
 
-        shouldDrawLine = NO;
-      }
+  CGRect textRect = self.bounds;
+  if (NIVerticalTextAlignmentTop != self.verticalTextAlignment) {
+    textRect.origin.y = [self _verticalOffsetForBounds:textRect];
+  }
+
+  CGFloat scale = (nil != self.window) ? self.window.screen.scale : [UIScreen mainScreen].scale;
+  UIGraphicsBeginImageContextWithOptions(glyphsRect.size, NO, scale);
+  CGContextRef ctx = UIGraphicsGetCurrentContext();
+  CGContextTranslateCTM(ctx, -glyphsRect.origin.x, -glyphsRect.origin.y);
+
+  NSUInteger numberOfRects = rects.count;
+  CGRect clipRects[numberOfRects];
+  for (NSUInteger ix = 0; ix < numberOfRects; ++ix) {
+    clipRects[ix] = [[rects objectAtIndex:ix] CGRectValue];
+  }
+  CGContextClipToRects(ctx, clipRects, numberOfRects);
+
+  if (nil != self.backgroundColor) {
+    [self.backgroundColor setFill];
+    CGContextFillRect(ctx, glyphsRect);
+  }
+  if (nil != self.highlightedLinkBackgroundColor) {
+    [self.highlightedLinkBackgroundColor setFill];
+    CGContextFillRect(ctx, glyphsRect);
+  }
+
+  CGContextConcatCTM(ctx, [self _transformForCoreText]);
+  if (nil != self.shadowColor) {
+    CGContextSetShadowWithColor(ctx, self.shadowOffset, self.shadowBlur, self.shadowColor.CGColor);
+  }
+  NIAttributedLabelDrawLines(ctx, attributedString, lineIndex, textRect, numberOfLines,
+                             (self.lineBreakMode == NSLineBreakByTruncatingTail), self.tailTruncationString);
+
+  UIImage* image = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  return image;
+}
+
+- (void)drawAttributedString:(NSAttributedString *)attributedString rect:(CGRect)rect {
+  NIAttributedLabelDrawLines(UIGraphicsGetCurrentContext(), attributedString, self.lineIndex, rect,
+                             [self numberOfDisplayedLines],
+                             (self.lineBreakMode == NSLineBreakByTruncatingTail),
+                             self.tailTruncationString);
+}
+
+- (NIAttributedLabelRendering *)renderingForAttributedString:(NSAttributedString *)attributedString rect:(CGRect)rect {
+  NIAttributedLabelRendering* rendering = [[NIAttributedLabelRendering alloc] init];
+  rendering.attributedString = attributedString;
+  rendering.bounds = self.bounds;
+  rendering.textRect = rect;
+  rendering.numberOfLines = self.numberOfLines;
+  rendering.truncatesLastLine = (self.lineBreakMode == NSLineBreakByTruncatingTail);
+  rendering.tailTruncationString = self.tailTruncationString;
+  rendering.shadowColor = self.shadowColor;
+  rendering.shadowOffset = self.shadowOffset;
+  rendering.shadowBlur = self.shadowBlur;
+  rendering.scale = (nil != self.window) ? self.window.screen.scale : [UIScreen mainScreen].scale;
+  rendering.generation = self.textGeneration;
+  return rendering;
+}
+
+- (void)cancelPendingRendering {
+  self.pendingRendering.cancelled = YES;
+  self.pendingRendering = nil;
+}
+
+- (void)scheduleRendering:(NIAttributedLabelRendering *)rendering {
+  if ([rendering isEquivalentToRendering:self.pendingRendering]) {
+    return;
+  }
+  [self cancelPendingRendering];
+  self.pendingRendering = rendering;
+
+  __weak NIAttributedLabel* weakSelf = self;
+  dispatch_async(NIAttributedLabelRenderingQueue(), ^{
+    if (rendering.cancelled) {
+      return;
     }
+    UIImage* image = [rendering render];
+    dispatch_async(dispatch_get_main_queue(), ^{
+      [weakSelf didFinishRendering:rendering image:image];
+    });
+  });
+}
 
-    if (shouldDrawLine) {
-      CTLineDraw(line, ctx);
+- (void)didFinishRendering:(NIAttributedLabelRendering *)rendering image:(UIImage *)image {
+  if (rendering.cancelled || rendering != self.pendingRendering) {
+    return;
+  }
+  self.pendingRendering = nil;
+  rendering.image = image;
+  self.renderedText = rendering;
+  [self setNeedsDisplay];
+}
+
+- (void)drawRenderedAttributedString:(NSAttributedString *)attributedString rect:(CGRect)rect {
+  NIAttributedLabelRendering* rendering = [self renderingForAttributedString:attributedString rect:rect];
+  if (![rendering isEquivalentToRendering:self.renderedText]) {
+    [self scheduleRendering:rendering];
+
+    // Keep showing the previous rendering of the same text (e.g. while a touched link's attributes
+    // are applied) rather than flashing empty, but never show text that has since been replaced.
+    if (self.renderedText.generation != rendering.generation
+        || !CGSizeEqualToSize(self.renderedText.bounds.size, rendering.bounds.size)) {
+      return;
     }
   }
+  [self.renderedText.image drawInRect:self.bounds];
 }
 
 - (void)drawTextInRect:(CGRect)rect {
@@ -1358,6 +2038,16 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
     CGAffineTransform transform = [self _transformForCoreText];
     CGContextConcatCTM(ctx, transform);
 
+    // Inline images are drawn by the label itself, so labels with images always draw synchronously.
+    if (self.displaysAsynchronously && 0 == self.images.count) {
+      // Only the link highlight is drawn here; the glyphs come from the background rendering.
+      [self drawHighlightWithRect:rect];
+      CGContextRestoreGState(ctx);
+
+      [self drawRenderedAttributedString:attributedStringWithLinks rect:rect];
+      return;
+    }
+
     [self drawImages];
     [self drawHighlightWithRect:rect];
 
@@ -1378,46 +2068,68 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
 
 - (void)invalidateAccessibleElements {
   self.accessibleElements = nil;
+  self.accessibleLinkRects = nil;
 }
 
-- (NSArray *)accessibleElements {
-  if (nil != _accessibleElements) {
-    return _accessibleElements;
+// Decides how many elements there are without making any of them. Link elements are only offered
+// while VoiceOver is running, and finding their rects needs the text frame, so a label that is
+// never read by VoiceOver never lays out its links for it. The rects come from the line index's
+// memoized link rects, so they are only measured once per text frame. The elements are dropped
+// whenever the text frame is reset.
+- (void)prepareAccessibleElements {
+  BOOL includeLinks = UIAccessibilityIsVoiceOverRunning();
+  if (nil != _accessibleElements && includeLinks == self.accessibleElementsIncludeLinks) {
+    return;
   }
 
-  NSMutableArray* accessibleElements = [NSMutableArray array];
-
-  // NSArray arrayWithArray:self.detectedlinkLocations ensures that we're not working with a nil
-  // array.
-  NSArray* allLinks = [[NSArray arrayWithArray:self.detectedlinkLocations]
-                       arrayByAddingObjectsFromArray:self.explicitLinkLocations];
-
-  for (NSTextCheckingResult* result in allLinks) {
-    NSArray* rectsForLink = [self _rectsForLink:result];
-    if (!NIIsArrayWithObjects(rectsForLink)) {
-      continue;
+  NSMutableArray* linkRects = [NSMutableArray array];
+  if (includeLinks) {
+    // NSArray arrayWithArray:self.detectedlinkLocations ensures that we're not working with a nil
+    // array.
+    NSArray* allLinks = [[NSArray arrayWithArray:self.detectedlinkLocations]
+                         arrayByAddingObjectsFromArray:self.explicitLinkLocations];
+    for (NSTextCheckingResult* result in allLinks) {
+      for (NSValue* rectValue in [self _rectsForLink:result]) {
+        [linkRects addObject:@[ result, rectValue ]];
+      }
     }
+  }
 
-    NSString* label = [self.mutableAttributedString.string substringWithRange:result.range];
-    for (NSValue* rectValue in rectsForLink) {
-      UIAccessibilityElement* element = [[UIAccessibilityElement alloc] initWithAccessibilityContainer:self];
-      element.accessibilityLabel = label;
-      element.accessibilityFrame = [self convertRect:rectValue.CGRectValue toView:self.window];
-      element.accessibilityTraits = UIAccessibilityTraitLink;
-      [accessibleElements addObject:element];
-    }
+  self.accessibleLinkRects = linkRects;
+  self.accessibleElements = [NSMutableArray arrayWithCapacity:linkRects.count + 1];
+  for (NSUInteger ix = 0; ix <= linkRects.count; ++ix) {
+    [self.accessibleElements addObject:[NSNull null]];
   }
+  self.accessibleElementsIncludeLinks = includeLinks;
+}
 
-  // Add this label's text as the "bottom-most" accessibility element, i.e. the last element in the
-  // array. This gives link priorities.
-  UIAccessibilityElement* element = [[UIAccessibilityElement alloc] initWithAccessibilityContainer:self];
-  element.accessibilityLabel = self.attributedText.string;
-  element.accessibilityFrame = [self convertRect:self.bounds toView:self.window];
-  element.accessibilityTraits = UIAccessibilityTraitNone;
-  [accessibleElements addObject:element];
+- (UIAccessibilityElement *)accessibleElementAtIndex:(NSUInteger)index {
+  [self prepareAccessibleElements];
+  if (index >= self.accessibleElements.count) {
+    return nil;
+  }
+  id element = [self.accessibleElements objectAtIndex:index];
+  if (![element isKindOfClass:[NSNull class]]) {
+    return element;
+  }
+
+  element = [[UIAccessibilityElement alloc] initWithAccessibilityContainer:self];
+  if (index < self.accessibleLinkRects.count) {
+    NSTextCheckingResult* result = [[self.accessibleLinkRects objectAtIndex:index] objectAtIndex:0];
+    NSValue* rectValue = [[self.accessibleLinkRects objectAtIndex:index] objectAtIndex:1];
+    [element setAccessibilityLabel:[self.mutableAttributedString.string substringWithRange:result.range]];
+    [element setAccessibilityFrame:[self convertRect:rectValue.CGRectValue toView:self.window]];
+    [element setAccessibilityTraits:UIAccessibilityTraitLink];
 
-  _accessibleElements = [accessibleElements copy];
-  return _accessibleElements;
+  } else {
+    // Add this label's text as the "bottom-most" accessibility element, i.e. the last element in
+    // the array. This gives link priorities.
+    [element setAccessibilityLabel:self.attributedText.string];
+    [element setAccessibilityFrame:[self convertRect:self.bounds toView:self.window]];
+    [element setAccessibilityTraits:UIAccessibilityTraitNone];
+  }
+  [self.accessibleElements replaceObjectAtIndex:index withObject:element];
+  return element;
 }
 
 - (BOOL)isAccessibilityElement {
@@ -1425,15 +2137,21 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
 }
 
 - (NSInteger)accessibilityElementCount  {
+  [self prepareAccessibleElements];
   return self.accessibleElements.count;
 }
 
 - (id)accessibilityElementAtIndex:(NSInteger)index {
-  return [self.accessibleElements objectAtIndex:index];
+  if (index < 0) {
+    return nil;
+  }
+  return [self accessibleElementAtIndex:(NSUInteger)index];
 }
 
 - (NSInteger)indexOfAccessibilityElement:(id)element {
-  return [self.accessibleElements indexOfObject:element];
+  // Only elements that have been made can be asked about.
+  [self prepareAccessibleElements];
+  return [self.accessibleElements indexOfObjectIdenticalTo:element];
 }
 
 #pragma mark - UIActionSheetDelegate
@@ -1478,12 +2196,12 @@ CGSize NISizeOfAttributedStringConstrainedToSize(NSAttributedString* attributedS
   }
 
   self.actionSheetLink = nil;
-  [self setNeedsDisplay];
+  [self linkHighlightDidChange];
 }
 
 - (void)actionSheetCancel:(UIActionSheet *)actionSheet {
   self.actionSheetLink = nil;
-  [self setNeedsDisplay];
+  [self linkHighlightDidChange];
 }
 
 #pragma mark - Inline Image Support
@@ -1530,7 +2248,7 @@ CGFloat NIImageDelegateGetDescentCallback(void* refCon) {
 
 CGFloat NIImageDelegateGetWidthCallback(void* refCon) {
   NIAttributedLabelImage *labelImage = (__bridge NIAttributedLabelImage *)refCon;
-  return labelImage.image.size.width + labelImage.margins.left + labelImage.margins.right;
+  return labelImage.boxSize.width;
 }
 
 - (void)insertImage:(UIImage *)image atIndex:(NSInteger)index {
@@ -1553,6 +2271,103 @@ CGFloat NIImageDelegateGetWidthCallback(void* refCon) {
   [self.images addObject:labelImage];
 }
 
+- (void)insertImageWithURL:(NSURL *)url size:(CGSize)size atIndex:(NSInteger)index {
+  [self insertImageWithURL:url size:size placeholderImage:nil atIndex:index margins:UIEdgeInsetsZero verticalTextAlignment:NIVerticalTextAlignmentBottom];
+}
+
+- (void)insertImageWithURL:(NSURL *)url size:(CGSize)size placeholderImage:(UIImage *)placeholderImage atIndex:(NSInteger)index margins:(UIEdgeInsets)margins verticalTextAlignment:(NIVerticalTextAlignment)verticalTextAlignment {
+  NIDASSERT(nil != url);
+  NIAttributedLabelImage* labelImage = [[NIAttributedLabelImage alloc] init];
+  labelImage.index = index;
+  labelImage.image = placeholderImage;
+  labelImage.url = url;
+  labelImage.imageSize = size;
+  labelImage.margins = margins;
+  labelImage.verticalTextAlignment = verticalTextAlignment;
+  if (nil == self.images) {
+    self.images = [NSMutableArray array];
+  }
+  [self.images addObject:labelImage];
+
+  [self _loadInlineImage:labelImage];
+}
+
+- (void)_loadInlineImage:(NIAttributedLabelImage *)labelImage {
+  NSURL* url = labelImage.url;
+  CGSize size = labelImage.imageSize;
+  NSString* cacheName = NIInlineImageCacheName(url, size);
+
+  UIImage* cachedImage = [[Nimbus imageMemoryCache] objectWithName:cacheName];
+  if (nil != cachedImage) {
+    labelImage.image = cachedImage;
+    return;
+  }
+  if ([[Nimbus failedNetworkPathFilter] mightContainString:url.absoluteString]) {
+    // This path failed moments ago, so it would most likely fail again. Keep the placeholder.
+    return;
+  }
+
+  __weak NIAttributedLabel* weakSelf = self;
+  __weak NIAttributedLabelImage* weakLabelImage = labelImage;
+  void (^completion)(UIImage* image) = ^(UIImage* image) {
+    [weakSelf _inlineImage:weakLabelImage didLoadImage:image];
+  };
+
+  // Labels showing the same image, e.g. an emoji, share one download.
+  NSMutableDictionary* requests = NIInlineImageRequests();
+  NSMutableArray* completions = [requests objectForKey:cacheName];
+  if (nil != completions) {
+    [completions addObject:[completion copy]];
+    return;
+  }
+  [requests setObject:[NSMutableArray arrayWithObject:[completion copy]] forKey:cacheName];
+
+  [NSURLConnection sendAsynchronousRequest:[NSURLRequest requestWithURL:url]
+                                     queue:[Nimbus networkOperationQueue]
+                         completionHandler:^(NSURLResponse* response, NSData* data, NSError* error) {
+                           // Error pages often come with a body, which must not be shown.
+                           NSInteger statusCode = ([response isKindOfClass:[NSHTTPURLResponse class]]
+                                                   ? [(NSHTTPURLResponse *)response statusCode]
+                                                   : 200);
+                           BOOL isSuccess = (nil == error && NIIsSuccessfulStatusCode(statusCode));
+                           UIImage* image = (isSuccess && nil != data) ? NIInlineImageFromData(data, size) : nil;
+                           if (nil != image) {
+                             [[Nimbus imageMemoryCache] storeObject:image withName:cacheName];
+                           } else {
+                             if (isSuccess) {
+                               error = [NSError errorWithDomain:NSURLErrorDomain
+                                                           code:NSURLErrorCannotDecodeContentData
+                                                       userInfo:@{NSURLErrorFailingURLErrorKey: url}];
+                             }
+                             // Timeouts, going offline and server errors may not happen next time.
+                             if (NIIsPermanentLoadFailure(response, error)) {
+                               [[Nimbus failedNetworkPathFilter] addString:url.absoluteString];
+                             }
+                           }
+
+                           dispatch_async(dispatch_get_main_queue(), ^{
+                             NSArray* waitingCompletions = [requests objectForKey:cacheName];
+                             [requests removeObjectForKey:cacheName];
+                             for (void (^waitingCompletion)(UIImage*) in waitingCompletions) {
+                               waitingCompletion(image);
+                             }
+                           });
+                         }];
+}
+
+- (void)_inlineImage:(NIAttributedLabelImage *)labelImage didLoadImage:(UIImage *)image {
+  if (nil == image || nil == labelImage || ![self.images containsObject:labelImage]) {
+    return;
+  }
+  labelImage.image = image;
+
+  // The image's box was laid out at its final size, so nothing around it moves. Only the box is
+  // redrawn; if it hasn't been drawn yet it will be drawn with the image the first time.
+  if (!CGRectIsEmpty(labelImage.displayRect)) {
+    [self setNeedsDisplayInRect:labelImage.displayRect];
+  }
+}
+
 @end
 
 @implementation NIAttributedLabel (ConversionUtilities)
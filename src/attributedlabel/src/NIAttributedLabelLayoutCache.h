@@ -0,0 +1,136 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+#import <CoreText/CoreText.h>
+
+/**
+ * A process-wide cache of CoreText layouts for attributed strings.
+ *
+ * Typesetting an attributed string is the expensive part of measuring and drawing it. The cache
+ * keeps one framesetter for each attributed string along with the frames and sizes that have
+ * been laid out from it, so a label that is measured for its height and then drawn at that
+ * width typesets its text once. Entries are keyed by the string's text, and their attributes are
+ * compared with isEqualToAttributedString: on every lookup.
+ *
+ * The cache is bounded by an estimate of the memory its layouts use, evicting the least recently
+ * used strings first, and it sheds layouts under memory pressure.
+ *
+ * Strings with embedded images are never cached because their run delegates point back at the
+ * label that created them.
+ *
+ * The cache is safe to use from any thread.
+ *
+ * @ingroup NimbusAttributedLabel
+ */
+@interface NIAttributedLabelLayoutCache : NSObject
+
++ (NIAttributedLabelLayoutCache *)sharedCache;
+
+@property (nonatomic) unsigned long long maxNumberOfBytes; // Default: 1 MB
+
+- (CTFramesetterRef)copyFramesetterForAttributedString:(NSAttributedString *)attributedString CF_RETURNS_RETAINED;
+- (CTFrameRef)copyFrameForAttributedString:(NSAttributedString *)attributedString rect:(CGRect)rect CF_RETURNS_RETAINED;
+- (CGSize)sizeOfAttributedString:(NSAttributedString *)attributedString constrainedToSize:(CGSize)constraintSize numberOfLines:(NSInteger)numberOfLines;
+- (CTLineRef)copyTruncatedLineForAttributedString:(NSAttributedString *)attributedString
+                                         lineRange:(CFRange)lineRange
+                                             width:(CGFloat)width
+                              tailTruncationString:(NSString *)tailTruncationString CF_RETURNS_RETAINED;
+
+- (unsigned long long)numberOfBytes;
+- (void)removeAllLayouts;
+
+@end
+
+/** @name Accessing the Shared Cache */
+
+/**
+ * Returns the cache used by every NIAttributedLabel.
+ *
+ * @fn NIAttributedLabelLayoutCache::sharedCache
+ */
+
+/** @name Bounding the Cache */
+
+/**
+ * The estimated number of bytes of layouts that the cache may hold.
+ *
+ * When storing a layout takes the cache past this limit, the least recently used strings are
+ * evicted until it fits again. Setting this to 0 disables caching, so every call typesets its
+ * string from scratch.
+ *
+ * By default this is 1 MB.
+ *
+ * @fn NIAttributedLabelLayoutCache::maxNumberOfBytes
+ */
+
+/**
+ * The estimated number of bytes of layouts that the cache currently holds.
+ *
+ * @fn NIAttributedLabelLayoutCache::numberOfBytes
+ */
+
+/**
+ * Removes every cached layout.
+ *
+ * @fn NIAttributedLabelLayoutCache::removeAllLayouts
+ */
+
+/** @name Laying Out Attributed Strings */
+
+/**
+ * Returns a framesetter for the given attributed string, typesetting it only if no framesetter
+ * for an equal string is cached.
+ *
+ * The caller is responsible for releasing the framesetter.
+ *
+ * @fn NIAttributedLabelLayoutCache::copyFramesetterForAttributedString:
+ */
+
+/**
+ * Returns the frame of the given attributed string laid out in the given rect.
+ *
+ * The caller is responsible for releasing the frame.
+ *
+ * @fn NIAttributedLabelLayoutCache::copyFrameForAttributedString:rect:
+ */
+
+/**
+ * Returns the size of the given attributed string when laid out within the given size, showing
+ * at most the given number of lines. A numberOfLines of 0 shows every line.
+ *
+ * This is the calculation behind NISizeOfAttributedStringConstrainedToSize.
+ *
+ * @fn NIAttributedLabelLayoutCache::sizeOfAttributedString:constrainedToSize:numberOfLines:
+ */
+
+/**
+ * Returns the given line of the attributed string truncated at its tail to fit the width, with
+ * the truncation string in the attributes of the line's last character.
+ *
+ * Truncated lines are cached with the string's other layouts, so a label that is redrawn, e.g.
+ * after a link is highlighted and unhighlighted, or that is reused for the same text, doesn't
+ * truncate its last line again.
+ *
+ * The caller is responsible for releasing the line.
+ *
+ * @fn NIAttributedLabelLayoutCache::copyTruncatedLineForAttributedString:lineRange:width:tailTruncationString:
+ * @param lineRange             The range of the line in the attributed string.
+ * @param tailTruncationString  The string that replaces the truncated text, e.g. an ellipsis.
+ * @returns NULL if the range is empty or not within the string.
+ */
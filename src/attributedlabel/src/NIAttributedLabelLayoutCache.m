@@ -0,0 +1,397 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIAttributedLabelLayoutCache.h"
+
+#import "NimbusCore.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// A rough estimate of what one laid out character costs in glyphs, positions and runs.
+static const unsigned long long kEstimatedBytesPerCharacter = 64;
+
+// Labels are laid out at a handful of sizes at most; past this we start over.
+static const NSUInteger kMaximumNumberOfFramesPerLayout = 4;
+
+static CTFrameRef NICreateFrameWithFramesetter(CTFramesetterRef framesetter, CGRect rect) {
+  CGMutablePathRef path = CGPathCreateMutable();
+  NIDASSERT(NULL != path);
+  if (NULL == path) {
+    return NULL;
+  }
+  CGPathAddRect(path, NULL, rect);
+  NI_SIGNPOST_BEGIN(NISignpostCategoryText, "Layout", path);
+  CTFrameRef frame = CTFramesetterCreateFrame(framesetter, CFRangeMake(0, 0), path, NULL);
+  NI_SIGNPOST_END(NISignpostCategoryText, "Layout", path);
+  CGPathRelease(path);
+  return frame;
+}
+
+static CGSize NISizeWithFramesetter(CTFramesetterRef framesetter, CGSize constraintSize, NSInteger numberOfLines) {
+  CFRange range = CFRangeMake(0, 0);
+
+  // This logic adapted from @mattt's TTTAttributedLabel
+  // https://github.com/mattt/TTTAttributedLabel
+
+  if (numberOfLines == 1) {
+    constraintSize = CGSizeMake(CGFLOAT_MAX, CGFLOAT_MAX);
+
+  } else if (numberOfLines > 0) {
+    CTFrameRef frame = NICreateFrameWithFramesetter(framesetter, CGRectMake(0, 0, constraintSize.width, constraintSize.height));
+    CFArrayRef lines = (NULL != frame) ? CTFrameGetLines(frame) : NULL;
+
+    if (nil != lines && CFArrayGetCount(lines) > 0) {
+      NSInteger lastVisibleLineIndex = MIN(numberOfLines, CFArrayGetCount(lines)) - 1;
+      CTLineRef lastVisibleLine = CFArrayGetValueAtIndex(lines, lastVisibleLineIndex);
+
+      CFRange rangeToLayout = CTLineGetStringRange(lastVisibleLine);
+      range = CFRangeMake(0, rangeToLayout.location + rangeToLayout.length);
+    }
+
+    if (NULL != frame) {
+      CFRelease(frame);
+    }
+  }
+
+  NI_SIGNPOST_BEGIN(NISignpostCategoryText, "Measure", framesetter);
+  CGSize newSize = CTFramesetterSuggestFrameSizeWithConstraints(framesetter, range, NULL, constraintSize, NULL);
+  NI_SIGNPOST_END(NISignpostCategoryText, "Measure", framesetter);
+
+  return CGSizeMake(NICGFloatCeil(newSize.width), NICGFloatCeil(newSize.height));
+}
+
+// Typesets the given line of the string again with the token appended and truncates it to the
+// width, so that the token always shows in the style of the text it replaces.
+static CTLineRef NICreateTruncatedLine(NSAttributedString* attributedString, CFRange lineRange,
+                                       CGFloat width, NSString* tailTruncationString) {
+  NSUInteger truncationAttributePosition = lineRange.location + lineRange.length - 1;
+  NSDictionary *tokenAttributes = [attributedString attributesAtIndex:truncationAttributePosition
+                                                       effectiveRange:NULL];
+  NSAttributedString* tokenAttributedString = [[NSAttributedString alloc] initWithString:tailTruncationString
+                                                                              attributes:tokenAttributes];
+  CTLineRef truncationToken = CTLineCreateWithAttributedString((__bridge CFAttributedStringRef)tokenAttributedString);
+
+  NSMutableAttributedString *truncationString = [[attributedString attributedSubstringFromRange:NSMakeRange(lineRange.location, lineRange.length)] mutableCopy];
+  if (lineRange.length > 0) {
+    // Remove any whitespace at the end of the line.
+    unichar lastCharacter = [[truncationString string] characterAtIndex:lineRange.length - 1];
+    if ([[NSCharacterSet whitespaceAndNewlineCharacterSet] characterIsMember:lastCharacter]) {
+      [truncationString deleteCharactersInRange:NSMakeRange(lineRange.length - 1, 1)];
+    }
+  }
+  [truncationString appendAttributedString:tokenAttributedString];
+
+  CTLineRef truncationLine = CTLineCreateWithAttributedString((__bridge CFAttributedStringRef)truncationString);
+  CTLineRef truncatedLine = CTLineCreateTruncatedLine(truncationLine, width, kCTLineTruncationEnd, truncationToken);
+  if (!truncatedLine) {
+    // If the line is not as wide as the truncationToken, truncatedLine is NULL
+    truncatedLine = CFRetain(truncationToken);
+  }
+  CFRelease(truncationLine);
+  CFRelease(truncationToken);
+  return truncatedLine;
+}
+
+/**
+ * The typeset result of one attributed string: its framesetter and whatever has been laid out
+ * from it.
+ */
+@interface NIAttributedLabelLayout : NSObject
+
+- (id)initWithAttributedString:(NSAttributedString *)attributedString name:(NSString *)name;
+
+@property (nonatomic, readonly, copy) NSAttributedString* attributedString;
+@property (nonatomic, readonly, copy) NSString* name;
+@property (nonatomic, readonly) CTFramesetterRef framesetter;
+
+- (CTFrameRef)copyFrameForRect:(CGRect)rect didCreateFrame:(BOOL *)didCreateFrame CF_RETURNS_RETAINED;
+- (CGSize)sizeConstrainedToSize:(CGSize)constraintSize numberOfLines:(NSInteger)numberOfLines;
+- (CTLineRef)copyTruncatedLineForRange:(CFRange)lineRange
+                                 width:(CGFloat)width
+                  tailTruncationString:(NSString *)tailTruncationString
+                         didCreateLine:(BOOL *)didCreateLine CF_RETURNS_RETAINED;
+- (unsigned long long)cost;
+
+@end
+
+@implementation NIAttributedLabelLayout {
+  NSMutableDictionary* _frames; // NSString rect => CTFrameRef
+  NSMutableDictionary* _sizes;  // NSString constraint and number of lines => NSValue CGSize
+  NSMutableDictionary* _truncatedLines; // NSString range, width and token => CTLineRef
+  NSUInteger _truncatedLinesLength;
+}
+
+- (void)dealloc {
+  if (NULL != _framesetter) {
+    CFRelease(_framesetter);
+  }
+}
+
+- (id)initWithAttributedString:(NSAttributedString *)attributedString name:(NSString *)name {
+  if ((self = [super init])) {
+    _attributedString = [attributedString copy];
+    _name = [name copy];
+    _framesetter = CTFramesetterCreateWithAttributedString((__bridge CFAttributedStringRef)_attributedString);
+    _frames = [[NSMutableDictionary alloc] init];
+    _sizes = [[NSMutableDictionary alloc] init];
+    _truncatedLines = [[NSMutableDictionary alloc] init];
+  }
+  return self;
+}
+
+// Framesetters aren't documented as safe to lay out from several threads at once, so every use
+// of one goes through the layout's lock.
+- (CTFrameRef)copyFrameForRect:(CGRect)rect didCreateFrame:(BOOL *)didCreateFrame {
+  NSString* key = NSStringFromCGRect(rect);
+  @synchronized(self) {
+    CTFrameRef frame = (__bridge CTFrameRef)_frames[key];
+    if (NULL != frame) {
+      *didCreateFrame = NO;
+      return (CTFrameRef)CFRetain(frame);
+    }
+
+    frame = NICreateFrameWithFramesetter(_framesetter, rect);
+    if (NULL != frame) {
+      if (_frames.count >= kMaximumNumberOfFramesPerLayout) {
+        [_frames removeAllObjects];
+      }
+      _frames[key] = (__bridge id)frame;
+    }
+    *didCreateFrame = (NULL != frame);
+    return frame;
+  }
+}
+
+- (CGSize)sizeConstrainedToSize:(CGSize)constraintSize numberOfLines:(NSInteger)numberOfLines {
+  NSString* key = [NSString stringWithFormat:@"%@:%zd", NSStringFromCGSize(constraintSize), numberOfLines];
+  @synchronized(self) {
+    NSValue* size = _sizes[key];
+    if (nil == size) {
+      size = [NSValue valueWithCGSize:NISizeWithFramesetter(_framesetter, constraintSize, numberOfLines)];
+      _sizes[key] = size;
+    }
+    return [size CGSizeValue];
+  }
+}
+
+- (CTLineRef)copyTruncatedLineForRange:(CFRange)lineRange
+                                 width:(CGFloat)width
+                  tailTruncationString:(NSString *)tailTruncationString
+                         didCreateLine:(BOOL *)didCreateLine {
+  NSString* key = [NSString stringWithFormat:@"%ld:%ld:%g:%@",
+                   (long)lineRange.location, (long)lineRange.length, (double)width, tailTruncationString];
+  @synchronized(self) {
+    CTLineRef line = (__bridge CTLineRef)_truncatedLines[key];
+    if (NULL != line) {
+      *didCreateLine = NO;
+      return (CTLineRef)CFRetain(line);
+    }
+
+    line = NICreateTruncatedLine(_attributedString, lineRange, width, tailTruncationString);
+    if (NULL != line) {
+      if (_truncatedLines.count >= kMaximumNumberOfFramesPerLayout) {
+        [_truncatedLines removeAllObjects];
+        _truncatedLinesLength = 0;
+      }
+      _truncatedLines[key] = (__bridge id)line;
+      _truncatedLinesLength += (NSUInteger)lineRange.length;
+    }
+    *didCreateLine = (NULL != line);
+    return line;
+  }
+}
+
+- (unsigned long long)cost {
+  NSUInteger numberOfFrames = 0;
+  NSUInteger truncatedLinesLength = 0;
+  @synchronized(self) {
+    numberOfFrames = _frames.count;
+    truncatedLinesLength = _truncatedLinesLength;
+  }
+  // The framesetter and each frame hold their own lines.
+  return ((unsigned long long)MAX(1, _attributedString.length) * kEstimatedBytesPerCharacter * (1 + numberOfFrames)
+          + (unsigned long long)truncatedLinesLength * kEstimatedBytesPerCharacter);
+}
+
+@end
+
+
+@implementation NIAttributedLabelLayoutCache {
+  NIMemoryCache* _layouts;
+}
+
++ (NIAttributedLabelLayoutCache *)sharedCache {
+  static NIAttributedLabelLayoutCache* sharedCache = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sharedCache = [[NIAttributedLabelLayoutCache alloc] init];
+  });
+  return sharedCache;
+}
+
+- (id)init {
+  if ((self = [super init])) {
+    _layouts = [[NIMemoryCache alloc] init];
+    _maxNumberOfBytes = 1024 * 1024;
+  }
+  return self;
+}
+
+#pragma mark - Private
+
+// Run delegates keep an unretained pointer back to the label's image, so a cached framesetter
+// could outlive what its string points at.
+- (BOOL)canCacheAttributedString:(NSAttributedString *)attributedString {
+  __block BOOL hasRunDelegate = NO;
+  [attributedString enumerateAttribute:(__bridge NSString *)kCTRunDelegateAttributeName
+                               inRange:NSMakeRange(0, attributedString.length)
+                               options:0
+                            usingBlock:^(id value, NSRange range, BOOL *stop) {
+                              if (nil != value) {
+                                hasRunDelegate = YES;
+                                *stop = YES;
+                              }
+                            }];
+  return !hasRunDelegate;
+}
+
+- (void)storeLayout:(NIAttributedLabelLayout *)layout {
+  [_layouts storeObject:layout withName:layout.name cost:[layout cost]];
+
+  unsigned long long maxNumberOfBytes = self.maxNumberOfBytes;
+  unsigned long long numberOfBytes = [_layouts numberOfBytesInMemoryBudget];
+  if (numberOfBytes > maxNumberOfBytes) {
+    [_layouts reduceMemoryUsageByNumberOfBytes:numberOfBytes - maxNumberOfBytes];
+  }
+}
+
+// Returns nil if the string shouldn't be cached.
+- (NIAttributedLabelLayout *)layoutForAttributedString:(NSAttributedString *)attributedString {
+  if (nil == attributedString
+      || 0 == self.maxNumberOfBytes
+      || ![self canCacheAttributedString:attributedString]) {
+    return nil;
+  }
+
+  // NSAttributedString's hash only reflects the length, so strings of the same length would
+  // keep replacing each other. The text itself tells strings apart; only the attributes are
+  // left to compare on a hit.
+  NSString* name = [attributedString.string copy];
+  NIAttributedLabelLayout* layout = [_layouts objectWithName:name];
+  if (nil != layout && [layout.attributedString isEqualToAttributedString:attributedString]) {
+    return layout;
+  }
+
+  // Either a miss or the same text with other attributes, which takes the older one's place.
+  layout = [[NIAttributedLabelLayout alloc] initWithAttributedString:attributedString name:name];
+  if (NULL == layout.framesetter) {
+    return nil;
+  }
+  [self storeLayout:layout];
+  return layout;
+}
+
+#pragma mark - Public
+
+- (CTFramesetterRef)copyFramesetterForAttributedString:(NSAttributedString *)attributedString {
+  if (nil == attributedString) {
+    return NULL;
+  }
+  NIAttributedLabelLayout* layout = [self layoutForAttributedString:attributedString];
+  if (nil == layout) {
+    return CTFramesetterCreateWithAttributedString((__bridge CFAttributedStringRef)attributedString);
+  }
+  return (CTFramesetterRef)CFRetain(layout.framesetter);
+}
+
+- (CTFrameRef)copyFrameForAttributedString:(NSAttributedString *)attributedString rect:(CGRect)rect {
+  if (nil == attributedString) {
+    return NULL;
+  }
+  NIAttributedLabelLayout* layout = [self layoutForAttributedString:attributedString];
+  if (nil == layout) {
+    CTFramesetterRef framesetter = CTFramesetterCreateWithAttributedString((__bridge CFAttributedStringRef)attributedString);
+    if (NULL == framesetter) {
+      return NULL;
+    }
+    CTFrameRef frame = NICreateFrameWithFramesetter(framesetter, rect);
+    CFRelease(framesetter);
+    return frame;
+  }
+
+  BOOL didCreateFrame = NO;
+  CTFrameRef frame = [layout copyFrameForRect:rect didCreateFrame:&didCreateFrame];
+  if (didCreateFrame) {
+    // The layout grew, so charge the cache for it.
+    [self storeLayout:layout];
+  }
+  return frame;
+}
+
+- (CGSize)sizeOfAttributedString:(NSAttributedString *)attributedString constrainedToSize:(CGSize)constraintSize numberOfLines:(NSInteger)numberOfLines {
+  if (nil == attributedString) {
+    return CGSizeZero;
+  }
+  NIAttributedLabelLayout* layout = [self layoutForAttributedString:attributedString];
+  if (nil == layout) {
+    CTFramesetterRef framesetter = CTFramesetterCreateWithAttributedString((__bridge CFAttributedStringRef)attributedString);
+    NIDASSERT(NULL != framesetter);
+    if (NULL == framesetter) {
+      return CGSizeZero;
+    }
+    CGSize size = NISizeWithFramesetter(framesetter, constraintSize, numberOfLines);
+    CFRelease(framesetter);
+    return size;
+  }
+  return [layout sizeConstrainedToSize:constraintSize numberOfLines:numberOfLines];
+}
+
+- (CTLineRef)copyTruncatedLineForAttributedString:(NSAttributedString *)attributedString
+                                         lineRange:(CFRange)lineRange
+                                             width:(CGFloat)width
+                              tailTruncationString:(NSString *)tailTruncationString {
+  if (nil == attributedString || nil == tailTruncationString || lineRange.length <= 0
+      || (NSUInteger)(lineRange.location + lineRange.length) > attributedString.length) {
+    return NULL;
+  }
+  NIAttributedLabelLayout* layout = [self layoutForAttributedString:attributedString];
+  if (nil == layout) {
+    return NICreateTruncatedLine(attributedString, lineRange, width, tailTruncationString);
+  }
+
+  BOOL didCreateLine = NO;
+  CTLineRef line = [layout copyTruncatedLineForRange:lineRange
+                                               width:width
+                                tailTruncationString:tailTruncationString
+                                       didCreateLine:&didCreateLine];
+  if (didCreateLine) {
+    [self storeLayout:layout];
+  }
+  return line;
+}
+
+- (unsigned long long)numberOfBytes {
+  return [_layouts numberOfBytesInMemoryBudget];
+}
+
+- (void)removeAllLayouts {
+  [_layouts removeAllObjects];
+}
+
+@end
@@ -0,0 +1,106 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+#import <CoreText/CoreText.h>
+
+@class NIAttributedLabel;
+
+/**
+ * A description of how an NIAttributedLabel styles and lays out its text, without the label.
+ *
+ * Table and collection view heights are usually needed long before, and far more often than,
+ * the cells that display them. A descriptor captures the label settings that affect layout so
+ * that text can be measured without creating or configuring a view. It builds attributed strings
+ * the same way NIAttributedLabel's setText: does and measures them with the same
+ * NIAttributedLabelLayoutCache, so a height computed on a background thread is exactly the height
+ * the label draws, and the label reuses the typesetting done to compute it.
+ *
+ * Descriptors are cheap to create from any thread. Once configured, a descriptor may be shared
+ * between threads as long as it is no longer mutated; use copy to take a snapshot of one that is.
+ *
+ * @ingroup NimbusAttributedLabel
+ */
+@interface NIAttributedLabelLayoutDescriptor : NSObject <NSCopying>
+
++ (instancetype)descriptorWithLabel:(UILabel *)label;
+
+@property (nonatomic, strong) UIFont*                   font;                   // Default: [UIFont systemFontOfSize:17]
+@property (nonatomic, strong) UIColor*                  textColor;              // Default: [UIColor blackColor]
+@property (nonatomic)         NSTextAlignment           textAlignment;          // Default: NSTextAlignmentLeft
+@property (nonatomic)         NSLineBreakMode           lineBreakMode;          // Default: NSLineBreakByTruncatingTail
+@property (nonatomic)         CGFloat                   lineHeight;             // Default: 0
+@property (nonatomic)         NSInteger                 numberOfLines;          // Default: 1
+@property (nonatomic)         CTUnderlineStyle          underlineStyle;         // Default: kCTUnderlineStyleNone
+@property (nonatomic)         CTUnderlineStyleModifiers underlineStyleModifier; // Default: kCTUnderlinePatternSolid
+@property (nonatomic)         CGFloat                   strokeWidth;            // Default: 0
+@property (nonatomic, strong) UIColor*                  strokeColor;            // Default: nil
+@property (nonatomic)         CGFloat                   textKern;               // Default: 0
+
+- (NSMutableAttributedString *)attributedStringWithString:(NSString *)string;
+
++ (CGSize)sizeOfString:(NSString *)string constrainedToWidth:(CGFloat)width descriptor:(NIAttributedLabelLayoutDescriptor *)descriptor;
++ (CGSize)sizeOfAttributedString:(NSAttributedString *)attributedString constrainedToWidth:(CGFloat)width descriptor:(NIAttributedLabelLayoutDescriptor *)descriptor;
+
+@end
+
+/** @name Creating Descriptors */
+
+/**
+ * Returns a descriptor with the label's current text settings.
+ *
+ * When given an NIAttributedLabel, its line height, underline, stroke and kern settings are
+ * captured as well. Like any view access this must happen on the main thread; the returned
+ * descriptor can then be used anywhere.
+ *
+ * @fn NIAttributedLabelLayoutDescriptor::descriptorWithLabel:
+ */
+
+/** @name Building Attributed Strings */
+
+/**
+ * Returns a new attributed string of the given string styled with the descriptor's settings.
+ *
+ * This is the string NIAttributedLabel builds when its text is set with these settings. Returns
+ * nil for an empty string, like the label does.
+ *
+ * @fn NIAttributedLabelLayoutDescriptor::attributedStringWithString:
+ */
+
+/** @name Measuring Text */
+
+/**
+ * Returns the size of the string styled with the descriptor's settings when laid out at the
+ * given width.
+ *
+ * Safe to call from any thread.
+ *
+ * @fn NIAttributedLabelLayoutDescriptor::sizeOfString:constrainedToWidth:descriptor:
+ */
+
+/**
+ * Returns the size of an already styled attributed string when laid out at the given width.
+ *
+ * Only the descriptor's numberOfLines applies; the string's own attributes are used as they are,
+ * just as they are when the string is assigned to a label's attributedText. Link styling that a
+ * label adds while displaying is not included.
+ *
+ * Safe to call from any thread.
+ *
+ * @fn NIAttributedLabelLayoutDescriptor::sizeOfAttributedString:constrainedToWidth:descriptor:
+ */
@@ -0,0 +1,117 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIAttributedLabelLayoutDescriptor.h"
+
+#import "NIAttributedLabel+Private.h"
+#import "NIAttributedLabelLayoutCache.h"
+#import "NSMutableAttributedString+NimbusAttributedLabel.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+@implementation NIAttributedLabelLayoutDescriptor
+
+- (id)init {
+  if ((self = [super init])) {
+    // Mirrors UILabel's own defaults.
+    _font = [UIFont systemFontOfSize:17];
+    _textColor = [UIColor blackColor];
+    _textAlignment = NSTextAlignmentLeft;
+    _lineBreakMode = NSLineBreakByTruncatingTail;
+    _numberOfLines = 1;
+    _underlineStyle = kCTUnderlineStyleNone;
+    _underlineStyleModifier = kCTUnderlinePatternSolid;
+  }
+  return self;
+}
+
++ (instancetype)descriptorWithLabel:(UILabel *)label {
+  NIAttributedLabelLayoutDescriptor* descriptor = [[self alloc] init];
+  descriptor.font = label.font;
+  descriptor.textColor = label.textColor;
+  descriptor.textAlignment = label.textAlignment;
+  descriptor.lineBreakMode = label.lineBreakMode;
+  descriptor.numberOfLines = label.numberOfLines;
+
+  if ([label isKindOfClass:[NIAttributedLabel class]]) {
+    NIAttributedLabel* attributedLabel = (NIAttributedLabel *)label;
+    descriptor.lineHeight = attributedLabel.lineHeight;
+    descriptor.underlineStyle = attributedLabel.underlineStyle;
+    descriptor.underlineStyleModifier = attributedLabel.underlineStyleModifier;
+    descriptor.strokeWidth = attributedLabel.strokeWidth;
+    descriptor.strokeColor = attributedLabel.strokeColor;
+    descriptor.textKern = attributedLabel.textKern;
+  }
+  return descriptor;
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+  NIAttributedLabelLayoutDescriptor* copy = [[[self class] allocWithZone:zone] init];
+  copy.font = self.font;
+  copy.textColor = self.textColor;
+  copy.textAlignment = self.textAlignment;
+  copy.lineBreakMode = self.lineBreakMode;
+  copy.lineHeight = self.lineHeight;
+  copy.numberOfLines = self.numberOfLines;
+  copy.underlineStyle = self.underlineStyle;
+  copy.underlineStyleModifier = self.underlineStyleModifier;
+  copy.strokeWidth = self.strokeWidth;
+  copy.strokeColor = self.strokeColor;
+  copy.textKern = self.textKern;
+  return copy;
+}
+
+- (NSMutableAttributedString *)attributedStringWithString:(NSString *)string {
+  if (0 == string.length) {
+    return nil;
+  }
+  NSMutableAttributedString* attributedString = [[NSMutableAttributedString alloc] initWithString:string];
+
+  [attributedString setFont:self.font];
+  [attributedString setTextColor:self.textColor];
+
+  CTTextAlignment textAlignment = [NIAttributedLabel alignmentFromUITextAlignment:self.textAlignment];
+  CTLineBreakMode lineBreak = [NIAttributedLabel lineBreakModeFromUILineBreakMode:self.lineBreakMode];
+  [attributedString setTextAlignment:textAlignment lineBreakMode:lineBreak lineHeight:self.lineHeight];
+
+  [attributedString setUnderlineStyle:self.underlineStyle modifier:self.underlineStyleModifier];
+  [attributedString setStrokeWidth:self.strokeWidth];
+  [attributedString setStrokeColor:self.strokeColor];
+  [attributedString setKern:self.textKern];
+
+  return attributedString;
+}
+
++ (CGSize)sizeOfString:(NSString *)string constrainedToWidth:(CGFloat)width descriptor:(NIAttributedLabelLayoutDescriptor *)descriptor {
+  return [self sizeOfAttributedString:[descriptor attributedStringWithString:string]
+                   constrainedToWidth:width
+                           descriptor:descriptor];
+}
+
++ (CGSize)sizeOfAttributedString:(NSAttributedString *)attributedString constrainedToWidth:(CGFloat)width descriptor:(NIAttributedLabelLayoutDescriptor *)descriptor {
+  if (nil == attributedString) {
+    return CGSizeZero;
+  }
+  // The same measurement NIAttributedLabel's sizeThatFits: makes.
+  return [[NIAttributedLabelLayoutCache sharedCache] sizeOfAttributedString:attributedString
+                                                          constrainedToSize:CGSizeMake(width, CGFLOAT_MAX)
+                                                              numberOfLines:descriptor.numberOfLines];
+}
+
+@end
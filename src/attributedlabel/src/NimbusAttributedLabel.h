@@ -237,3 +237,5 @@ myLabel.textKern = -6.0;
 
 #import "NimbusCore.h"
 #import "NIAttributedLabel.h"
+#import "NIAttributedLabelLayoutCache.h"
+#import "NIAttributedLabelLayoutDescriptor.h"
@@ -0,0 +1,243 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NimbusAttributedLabel.h"
+#import "NIAttributedLabelLayoutCache.h"
+#import "NITestAllocationLogging.h"
+
+// The corpora approximate the text that a feed or chat screen lays out while scrolling.
+static const NSInteger kCorpusSize = 100;
+static const CGFloat kLabelWidth = 300;
+static const NSInteger kHitTestGridSize = 20;
+
+@interface NIAttributedLabel (Benchmarking)
+- (void)detectLinks;
+- (NSTextCheckingResult *)linkAtPoint:(CGPoint)point;
+@end
+
+static NSArray* NIBenchmarkCorpusFromPhrases(NSArray* phrases, NSInteger phrasesPerText,
+                                             NSString* separator) {
+  NSMutableArray* texts = [NSMutableArray arrayWithCapacity:kCorpusSize];
+  for (NSInteger ix = 0; ix < kCorpusSize; ++ix) {
+    NSMutableArray* parts = [NSMutableArray arrayWithCapacity:phrasesPerText];
+    for (NSInteger jx = 0; jx < phrasesPerText; ++jx) {
+      [parts addObject:[phrases objectAtIndex:(ix * 7 + jx) % phrases.count]];
+    }
+    [texts addObject:[parts componentsJoinedByString:separator]];
+  }
+  return texts;
+}
+
+// Short messages of a line or two, the common case in chat transcripts.
+static NSArray* NIBenchmarkChatCorpus(void) {
+  return NIBenchmarkCorpusFromPhrases(@[@"On my way", @"Running ten minutes late, sorry!",
+                                        @"Did you see the game last night?", @"lol",
+                                        @"Can you send me the address?", @"Sounds good to me.",
+                                        @"Let's grab lunch tomorrow", @"Thanks again for today"],
+                                      2, @" ");
+}
+
+// Long posts with a link in most sentences, the worst case for link detection and hit testing.
+static NSArray* NIBenchmarkLinkCorpus(void) {
+  return NIBenchmarkCorpusFromPhrases(@[@"The release notes are up at http://nimbuskit.info/news.",
+                                        @"Read the wiki at https://github.com/jverkoey/nimbus.",
+                                        @"We talked about it at www.example.com/forum/1234.",
+                                        @"Everything else is unchanged from last week's build.",
+                                        @"Results live at https://example.org/perf?run=42.",
+                                        @"Ping me if http://docs.example.com/label is unclear."],
+                                      30, @" ");
+}
+
+// Chinese and Japanese paragraphs, which fall back to other fonts and break lines anywhere.
+static NSArray* NIBenchmarkCJKCorpus(void) {
+  return NIBenchmarkCorpusFromPhrases(@[@"今天天气很好，我们去公园散步吧。",
+                                        @"这个问题我们明天再讨论。",
+                                        @"東京駅で午後三時に会いましょう。",
+                                        @"新しいバージョンがリリースされました。",
+                                        @"请把文件发到我的邮箱。",
+                                        @"週末は家族と過ごす予定です。"],
+                                      8, @"");
+}
+
+// Emoji with modifiers and joiners, which produce long glyph clusters in an emoji font.
+static NSArray* NIBenchmarkEmojiCorpus(void) {
+  return NIBenchmarkCorpusFromPhrases(@[@"🎉🎉🎉", @"Happy birthday! 🎂🥳", @"👍🏽", @"😂😂😂😂",
+                                        @"👨‍👩‍👧‍👦 family trip ✈️🏖️", @"❤️🔥", @"Good morning ☀️☕️",
+                                        @"🙏🏻 thank you"],
+                                      4, @" ");
+}
+
+static NSDictionary* NIBenchmarkCorpora(void) {
+  return @{@"Chat": NIBenchmarkChatCorpus(),
+           @"Links": NIBenchmarkLinkCorpus(),
+           @"CJK": NIBenchmarkCJKCorpus(),
+           @"Emoji": NIBenchmarkEmojiCorpus()};
+}
+
+static NIAttributedLabel* NIBenchmarkLabel(NSString* text) {
+  NIAttributedLabel* label = [[NIAttributedLabel alloc] initWithFrame:CGRectZero];
+  label.numberOfLines = 0;
+  label.font = [UIFont systemFontOfSize:15];
+  label.autoDetectLinks = YES;
+  label.text = text;
+  CGSize size = [label sizeThatFits:CGSizeMake(kLabelWidth, CGFLOAT_MAX)];
+  label.frame = CGRectMake(0, 0, kLabelWidth, ceil(size.height));
+  return label;
+}
+
+static void NIBenchmarkDrawLabel(NIAttributedLabel* label) {
+  UIGraphicsBeginImageContextWithOptions(label.bounds.size, NO, 1);
+  [label drawRect:label.bounds];
+  UIGraphicsEndImageContext();
+}
+
+@interface NIAttributedLabelPerformanceTests : XCTestCase {
+@private
+  NSDictionary* _corpora;
+  NSInteger _generation;
+}
+
+@end
+
+
+@implementation NIAttributedLabelPerformanceTests
+
+
+- (void)setUp {
+  _corpora = NIBenchmarkCorpora();
+  [[NIAttributedLabelLayoutCache sharedCache] removeAllLayouts];
+}
+
+- (void)tearDown {
+  _corpora = nil;
+  [[NIAttributedLabelLayoutCache sharedCache] removeAllLayouts];
+}
+
+// Measures time and, on iOS 13 and later, the physical memory the block uses at its peak.
+- (void)measurePhaseWithBlock:(void (^)(void))block {
+  if ([self respondsToSelector:@selector(measureWithMetrics:block:)]) {
+    [self measureWithMetrics:@[[[XCTClockMetric alloc] init], [[XCTMemoryMetric alloc] init]]
+                       block:block];
+  } else {
+    [self measureBlock:block];
+  }
+}
+
+// Link matches are memoized per string, so cold link detection needs text it hasn't seen yet.
+- (NSArray *)freshTextsFromCorpus:(NSArray *)corpus {
+  ++_generation;
+  NSMutableArray* texts = [NSMutableArray arrayWithCapacity:corpus.count];
+  for (NSString* text in corpus) {
+    [texts addObject:[text stringByAppendingFormat:@" #%zd", _generation]];
+  }
+  return texts;
+}
+
+// Logs the allocations of the phase for each corpus, then measures the phase over all of them.
+- (void)measureCorporaWithPhase:(NSString *)phase
+                          block:(void (^)(NSString* name, NSArray* corpus))block {
+  NSArray* names = [[_corpora allKeys] sortedArrayUsingSelector:@selector(compare:)];
+  for (NSString* name in names) {
+    NITestLogAllocationsOfPhase([NSString stringWithFormat:@"%@ (%@)", phase, name], ^{
+      block(name, [_corpora objectForKey:name]);
+    });
+  }
+  [self measurePhaseWithBlock:^{
+    for (NSString* name in names) {
+      block(name, [_corpora objectForKey:name]);
+    }
+  }];
+}
+
+- (void)testPerformanceOfSizeThatFits {
+  [self measureCorporaWithPhase:@"sizeThatFits:" block:^(NSString* name, NSArray* corpus) {
+    [[NIAttributedLabelLayoutCache sharedCache] removeAllLayouts];
+    NIAttributedLabel* label = [[NIAttributedLabel alloc] initWithFrame:CGRectZero];
+    label.numberOfLines = 0;
+    for (NSString* text in corpus) {
+      label.text = text;
+      [label sizeThatFits:CGSizeMake(kLabelWidth, CGFLOAT_MAX)];
+    }
+  }];
+}
+
+- (void)testPerformanceOfFirstDraw {
+  [self measureCorporaWithPhase:@"First draw" block:^(NSString* name, NSArray* corpus) {
+    [[NIAttributedLabelLayoutCache sharedCache] removeAllLayouts];
+    for (NSString* text in [self freshTextsFromCorpus:corpus]) {
+      NIBenchmarkDrawLabel(NIBenchmarkLabel(text));
+    }
+  }];
+}
+
+- (void)testPerformanceOfRedraw {
+  NSMutableDictionary* labelsByCorpus = [NSMutableDictionary dictionary];
+  for (NSString* name in _corpora) {
+    NSMutableArray* labels = [NSMutableArray array];
+    for (NSString* text in [_corpora objectForKey:name]) {
+      NIAttributedLabel* label = NIBenchmarkLabel(text);
+      NIBenchmarkDrawLabel(label);
+      [labels addObject:label];
+    }
+    [labelsByCorpus setObject:labels forKey:name];
+  }
+
+  [self measureCorporaWithPhase:@"Redraw" block:^(NSString* name, NSArray* corpus) {
+    for (NIAttributedLabel* label in [labelsByCorpus objectForKey:name]) {
+      NIBenchmarkDrawLabel(label);
+    }
+  }];
+}
+
+- (void)testPerformanceOfLinkDetection {
+  [self measureCorporaWithPhase:@"Link detection" block:^(NSString* name, NSArray* corpus) {
+    NIAttributedLabel* label = [[NIAttributedLabel alloc] initWithFrame:CGRectZero];
+    label.autoDetectLinks = YES;
+    for (NSString* text in [self freshTextsFromCorpus:corpus]) {
+      label.text = text;
+      [label detectLinks];
+    }
+  }];
+}
+
+- (void)testPerformanceOfLinkHitTesting {
+  NIAttributedLabel* label = NIBenchmarkLabel([NIBenchmarkLinkCorpus() firstObject]);
+  NIBenchmarkDrawLabel(label);
+
+  CGSize size = label.bounds.size;
+  NITestLogAllocationsOfPhase(@"linkAtPoint:", ^{
+    [label linkAtPoint:CGPointMake(size.width / 2, size.height / 2)];
+  });
+  [self measurePhaseWithBlock:^{
+    NSInteger numberOfHits = 0;
+    for (NSInteger row = 0; row < kHitTestGridSize; ++row) {
+      for (NSInteger column = 0; column < kHitTestGridSize; ++column) {
+        CGPoint point = CGPointMake((column + 0.5) * size.width / kHitTestGridSize,
+                                    (row + 0.5) * size.height / kHitTestGridSize);
+        if (nil != [label linkAtPoint:point]) {
+          ++numberOfHits;
+        }
+      }
+    }
+    XCTAssertTrue(numberOfHits > 0, @"A post full of links should have links to hit.");
+  }];
+}
+
+@end
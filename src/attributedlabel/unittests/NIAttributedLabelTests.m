@@ -19,15 +19,375 @@
 #import <XCTest/XCTest.h>
 
 #import "NimbusAttributedLabel.h"
+#import "NITestURLProtocol.h"
 
 @interface NIAttributedLabelTests : XCTestCase
 @end
 
+@interface NIAttributedLabel (Testing)
+@property (nonatomic, strong) NSTextCheckingResult* touchedLink;
+- (void)linkHighlightDidChange;
+- (NSTextCheckingResult *)linkAtPoint:(CGPoint)point;
+@property (assign) BOOL detectingLinks;
+@property (nonatomic, copy) NSArray* detectedlinkLocations;
+- (NSArray *)_matchesFromAttributedString:(NSString *)string;
+- (void)detectLinks;
+@end
 
 @implementation NIAttributedLabelTests
 
+// Returns the label's drawing as PNG data.
+static NSData* NIPNGDataForLabel(NIAttributedLabel* label) {
+  UIGraphicsBeginImageContextWithOptions(label.bounds.size, NO, 1);
+  [label drawRect:label.bounds];
+  UIImage* image = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  return UIImagePNGRepresentation(image);
+}
+
+// Returns the number of pixels the label leaves non-transparent when drawn.
+static NSInteger NIOpaquePixelCountForLabel(NIAttributedLabel* label) {
+  UIGraphicsBeginImageContextWithOptions(label.bounds.size, NO, 1);
+  [label drawRect:label.bounds];
+  CGImageRef image = UIGraphicsGetImageFromCurrentImageContext().CGImage;
+
+  size_t width = CGImageGetWidth(image);
+  size_t height = CGImageGetHeight(image);
+  uint8_t* pixels = calloc(width * height * 4, 1);
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGContextRef ctx = CGBitmapContextCreate(pixels, width, height, 8, width * 4, colorSpace,
+                                           (CGBitmapInfo)kCGImageAlphaPremultipliedLast);
+  CGContextDrawImage(ctx, CGRectMake(0, 0, width, height), image);
+  UIGraphicsEndImageContext();
+
+  NSInteger count = 0;
+  for (size_t i = 0; i < width * height; ++i) {
+    if (pixels[i * 4 + 3] > 0) {
+      count++;
+    }
+  }
+  CGContextRelease(ctx);
+  CGColorSpaceRelease(colorSpace);
+  free(pixels);
+  return count;
+}
+
 
 - (void)testNothing {
 }
 
+- (void)testLayoutCacheSharesFramesetters {
+  NIAttributedLabelLayoutCache* cache = [[NIAttributedLabelLayoutCache alloc] init];
+  NSAttributedString* string = [[NSAttributedString alloc] initWithString:@"Nimbus"];
+  NSAttributedString* equalString = [[NSMutableAttributedString alloc] initWithString:@"Nimbus"];
+
+  CTFramesetterRef framesetter = [cache copyFramesetterForAttributedString:string];
+  CTFramesetterRef equalFramesetter = [cache copyFramesetterForAttributedString:equalString];
+  XCTAssertTrue(NULL != framesetter, @"The string should have been typeset.");
+  XCTAssertTrue(framesetter == equalFramesetter, @"Equal strings should share a framesetter.");
+  CFRelease(framesetter);
+  CFRelease(equalFramesetter);
+
+  CTFrameRef frame = [cache copyFrameForAttributedString:string rect:CGRectMake(0, 0, 100, 100)];
+  CTFrameRef sameFrame = [cache copyFrameForAttributedString:equalString rect:CGRectMake(0, 0, 100, 100)];
+  XCTAssertTrue(frame == sameFrame, @"Frames laid out in the same rect should be shared.");
+  CFRelease(frame);
+  CFRelease(sameFrame);
+  XCTAssertTrue(cache.numberOfBytes > 0, @"The layout should be charged to the cache.");
+
+  CGSize size = [cache sizeOfAttributedString:string constrainedToSize:CGSizeMake(100, CGFLOAT_MAX) numberOfLines:0];
+  XCTAssertTrue(CGSizeEqualToSize(size, NISizeOfAttributedStringConstrainedToSize(string, CGSizeMake(100, CGFLOAT_MAX), 0)),
+                @"The cache should measure the same as the uncached function.");
+
+  [cache removeAllLayouts];
+  XCTAssertEqual(cache.numberOfBytes, 0ULL, @"Every layout should have been removed.");
+}
+
+- (void)testLayoutCacheTellsStringsApart {
+  NIAttributedLabelLayoutCache* cache = [[NIAttributedLabelLayoutCache alloc] init];
+  NSAttributedString* string = [[NSAttributedString alloc] initWithString:@"Nimbus"];
+  NSAttributedString* sameLengthString = [[NSAttributedString alloc] initWithString:@"Kitten"];
+  NSAttributedString* boldString =
+      [[NSAttributedString alloc] initWithString:@"Nimbus"
+                                      attributes:@{NSFontAttributeName: [UIFont boldSystemFontOfSize:20]}];
+
+  CTFramesetterRef framesetter = [cache copyFramesetterForAttributedString:string];
+  CTFramesetterRef sameLengthFramesetter = [cache copyFramesetterForAttributedString:sameLengthString];
+  CTFramesetterRef sameFramesetter = [cache copyFramesetterForAttributedString:string];
+  XCTAssertTrue(framesetter != sameLengthFramesetter, @"Different text should be typeset separately.");
+  XCTAssertTrue(framesetter == sameFramesetter, @"Strings of the same length should not replace each other.");
+
+  CTFramesetterRef boldFramesetter = [cache copyFramesetterForAttributedString:boldString];
+  XCTAssertTrue(framesetter != boldFramesetter, @"The same text with other attributes should be typeset again.");
+
+  CFRelease(framesetter);
+  CFRelease(sameLengthFramesetter);
+  CFRelease(sameFramesetter);
+  CFRelease(boldFramesetter);
+}
+
+- (void)testLayoutCacheSharesTruncatedLines {
+  NIAttributedLabelLayoutCache* cache = [[NIAttributedLabelLayoutCache alloc] init];
+  NSAttributedString* string = [[NSAttributedString alloc] initWithString:@"A line of text that is too long to fit"];
+  CFRange lineRange = CFRangeMake(0, (CFIndex)string.length);
+
+  CTLineRef line = [cache copyTruncatedLineForAttributedString:string lineRange:lineRange width:40 tailTruncationString:@"\u2026"];
+  CTLineRef sameLine = [cache copyTruncatedLineForAttributedString:string lineRange:lineRange width:40 tailTruncationString:@"\u2026"];
+  CTLineRef widerLine = [cache copyTruncatedLineForAttributedString:string lineRange:lineRange width:80 tailTruncationString:@"\u2026"];
+  XCTAssertTrue(NULL != line, @"The line should have been truncated.");
+  XCTAssertTrue(line == sameLine, @"Truncating the same line to the same width should reuse the result.");
+  XCTAssertTrue(line != widerLine, @"Each width should be truncated separately.");
+  XCTAssertTrue(CTLineGetTypographicBounds(line, NULL, NULL, NULL) <= 40 + 1, @"The line should fit the width.");
+  CFRelease(line);
+  CFRelease(sameLine);
+  CFRelease(widerLine);
+}
+
+- (void)testLayoutCacheCanBeDisabled {
+  NIAttributedLabelLayoutCache* cache = [[NIAttributedLabelLayoutCache alloc] init];
+  cache.maxNumberOfBytes = 0;
+  NSAttributedString* string = [[NSAttributedString alloc] initWithString:@"Nimbus"];
+
+  CTFramesetterRef framesetter = [cache copyFramesetterForAttributedString:string];
+  CTFramesetterRef otherFramesetter = [cache copyFramesetterForAttributedString:string];
+  XCTAssertTrue(framesetter != otherFramesetter, @"Nothing should be cached.");
+  CFRelease(framesetter);
+  CFRelease(otherFramesetter);
+  XCTAssertEqual(cache.numberOfBytes, 0ULL, @"Nothing should be cached.");
+}
+
+- (void)testAccessibleElementsOnlyExposeLinksToVoiceOver {
+  NIAttributedLabel* label = [[NIAttributedLabel alloc] initWithFrame:CGRectMake(0, 0, 200, 40)];
+  label.text = @"Visit nimbuskit.info";
+  [label addLink:[NSURL URLWithString:@"http://nimbuskit.info"] range:NSMakeRange(6, 14)];
+  if (UIAccessibilityIsVoiceOverRunning()) {
+    return;
+  }
+
+  XCTAssertEqual([label accessibilityElementCount], (NSInteger)1,
+                 @"Without VoiceOver only the label's text should be exposed.");
+  UIAccessibilityElement* element = [label accessibilityElementAtIndex:0];
+  XCTAssertEqualObjects(element.accessibilityLabel, @"Visit nimbuskit.info");
+  XCTAssertEqual([label accessibilityElementAtIndex:0], element, @"Elements should be made once.");
+  XCTAssertEqual([label indexOfAccessibilityElement:element], (NSInteger)0);
+}
+
+- (void)testAccessibleElementsFollowTheText {
+  NIAttributedLabel* label = [[NIAttributedLabel alloc] initWithFrame:CGRectMake(0, 0, 200, 40)];
+  label.text = @"Before";
+  if (UIAccessibilityIsVoiceOverRunning()) {
+    return;
+  }
+  XCTAssertEqualObjects([[label accessibilityElementAtIndex:0] accessibilityLabel], @"Before");
+
+  label.text = @"After";
+  XCTAssertEqualObjects([[label accessibilityElementAtIndex:0] accessibilityLabel], @"After",
+                        @"A label without links should still rebuild its element for new text.");
+
+  label.frame = CGRectMake(0, 0, 100, 40);
+  XCTAssertEqual([[label accessibilityElementAtIndex:0] accessibilityFrame].size.width, (CGFloat)100,
+                 @"The element should follow the label's bounds.");
+}
+
+- (void)testInlineImagesOnlyShowSuccessfulResponses {
+  [NSURLProtocol registerClass:[NITestURLProtocol class]];
+  NIImageMemoryCache* originalCache = [Nimbus imageMemoryCache];
+  NIBloomFilter* originalFilter = [Nimbus failedNetworkPathFilter];
+  NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] init];
+  NIBloomFilter* filter = [[NIBloomFilter alloc] initWithCapacity:64 falsePositiveRate:0.001 retentionInterval:60];
+  [Nimbus setImageMemoryCache:cache];
+  [Nimbus setFailedNetworkPathFilter:filter];
+
+  NSURL* imageURL = [NSURL URLWithString:@"http://images.nimbus.test/image.png"];
+  NSURL* missingURL = [NSURL URLWithString:@"http://images.nimbus.test/missing.png"];
+  NSURL* unavailableURL = [NSURL URLWithString:@"http://images.nimbus.test/unavailable.png"];
+  NSURL* garbageURL = [NSURL URLWithString:@"http://images.nimbus.test/garbage.png"];
+  UIGraphicsBeginImageContextWithOptions(CGSizeMake(4, 4), YES, 1);
+  [[UIColor redColor] setFill];
+  UIRectFill(CGRectMake(0, 0, 4, 4));
+  NSData* imageData = UIImagePNGRepresentation(UIGraphicsGetImageFromCurrentImageContext());
+  UIGraphicsEndImageContext();
+  [NITestURLProtocol setData:imageData statusCode:200 headerFields:nil forURL:imageURL];
+  [NITestURLProtocol setData:imageData statusCode:404 headerFields:nil forURL:missingURL];
+  [NITestURLProtocol setData:imageData statusCode:503 headerFields:nil forURL:unavailableURL];
+  [NITestURLProtocol setData:[@"garbage" dataUsingEncoding:NSUTF8StringEncoding]
+                  statusCode:200
+                headerFields:nil
+                      forURL:garbageURL];
+  NIAttributedLabel* label = [[NIAttributedLabel alloc] initWithFrame:CGRectMake(0, 0, 200, 40)];
+  label.text = @"abcd";
+  NSInteger index = 0;
+  for (NSURL* url in @[imageURL, missingURL, unavailableURL, garbageURL]) {
+    [label insertImageWithURL:url size:CGSizeMake(4, 4) atIndex:index++];
+  }
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while ((0 == cache.count
+          || ![filter mightContainString:missingURL.absoluteString]
+          || ![filter mightContainString:garbageURL.absoluteString])
+         && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  // Let the 503 finish too.
+  [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+
+  XCTAssertEqual(cache.count, (NSUInteger)1, @"Only the successful response should be decoded.");
+  XCTAssertTrue([filter mightContainString:missingURL.absoluteString], @"A 404 will fail again.");
+  XCTAssertTrue([filter mightContainString:garbageURL.absoluteString], @"A body that isn't an image will fail again.");
+  XCTAssertFalse([filter mightContainString:unavailableURL.absoluteString], @"Server errors are transient.");
+  XCTAssertFalse([filter mightContainString:imageURL.absoluteString]);
+
+  [Nimbus setImageMemoryCache:originalCache];
+  [Nimbus setFailedNetworkPathFilter:originalFilter];
+  [NSURLProtocol unregisterClass:[NITestURLProtocol class]];
+  [NITestURLProtocol reset];
+}
+
+- (void)testDetectedLinksAreCachedByStringAndTypes {
+  NSString* text = [NSString stringWithFormat:@"Visit http://nimbuskit.info or call 555-123-4567 %@",
+                    [[NSProcessInfo processInfo] globallyUniqueString]];
+  NIAttributedLabel* label = [[NIAttributedLabel alloc] initWithFrame:CGRectMake(0, 0, 200, 40)];
+  label.dataDetectorTypes = NSTextCheckingTypeLink;
+  NIAttributedLabel* otherLabel = [[NIAttributedLabel alloc] initWithFrame:CGRectMake(0, 0, 200, 40)];
+  otherLabel.dataDetectorTypes = NSTextCheckingTypeLink;
+
+  NSArray* matches = [label _matchesFromAttributedString:text];
+  XCTAssertEqual(matches.count, (NSUInteger)1);
+  XCTAssertEqual([otherLabel _matchesFromAttributedString:[text mutableCopy]], matches,
+                 @"The same string and types should hit the cache.");
+
+  otherLabel.dataDetectorTypes = NSTextCheckingTypeLink | NSTextCheckingTypePhoneNumber;
+  NSArray* otherMatches = [otherLabel _matchesFromAttributedString:text];
+  XCTAssertNotEqual(otherMatches, matches, @"Other types should miss the cache.");
+  XCTAssertEqual(otherMatches.count, (NSUInteger)2, @"The phone number should be detected too.");
+}
+
+- (void)testStaleDeferredLinkDetectionIsNotApplied {
+  NIAttributedLabel* label = [[NIAttributedLabel alloc] initWithFrame:CGRectMake(0, 0, 200, 40)];
+  label.autoDetectLinks = YES;
+  label.deferLinkDetection = YES;
+  label.text = [NSString stringWithFormat:@"http://nimbuskit.info %@",
+                [[NSProcessInfo processInfo] globallyUniqueString]];
+  [label detectLinks];
+  XCTAssertTrue(label.detectingLinks, @"Uncached text should be detected in the background.");
+
+  // The main queue can't apply the detection before the text changes.
+  label.text = @"No links here";
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  while (label.detectingLinks && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+
+  XCTAssertFalse(label.detectingLinks, @"The detection should have finished.");
+  XCTAssertEqual(label.detectedlinkLocations.count, (NSUInteger)0,
+                 @"The links of the replaced text should not be applied.");
+}
+
+- (void)testLinksMoveWithTheVerticalTextAlignment {
+  NIAttributedLabel* label = [[NIAttributedLabel alloc] initWithFrame:CGRectMake(0, 0, 200, 100)];
+  label.text = @"nimbuskit.info";
+  [label addLink:[NSURL URLWithString:@"http://nimbuskit.info"] range:NSMakeRange(0, 14)];
+  XCTAssertNotNil([label linkAtPoint:CGPointMake(5, 5)], @"The text should hang from the top.");
+
+  label.verticalTextAlignment = NIVerticalTextAlignmentBottom;
+  XCTAssertNil([label linkAtPoint:CGPointMake(5, 5)], @"The old line positions should be forgotten.");
+  XCTAssertNotNil([label linkAtPoint:CGPointMake(5, 95)], @"The link should be found at the bottom.");
+}
+
+- (void)testHighlightsLinksInOverlayLeavesTheTextAlone {
+  NIAttributedLabel* label = [[NIAttributedLabel alloc] initWithFrame:CGRectMake(0, 0, 200, 40)];
+  label.backgroundColor = [UIColor whiteColor];
+  label.text = @"Visit nimbuskit.info";
+  label.attributesForHighlightedLink = @{NSForegroundColorAttributeName: [UIColor redColor]};
+  label.highlightsLinksInOverlay = YES;
+  NSURL* url = [NSURL URLWithString:@"http://nimbuskit.info"];
+  [label addLink:url range:NSMakeRange(6, 14)];
+  NSData* unhighlighted = NIPNGDataForLabel(label);
+
+  label.touchedLink = [NSTextCheckingResult linkCheckingResultWithRange:NSMakeRange(6, 14) URL:url];
+  [label linkHighlightDidChange];
+  XCTAssertEqualObjects(NIPNGDataForLabel(label), unhighlighted, @"The label itself should not draw the highlight.");
+
+  NSPredicate* visible = [NSPredicate predicateWithFormat:@"hidden == NO"];
+  XCTAssertEqual([label.layer.sublayers filteredArrayUsingPredicate:visible].count, (NSUInteger)2,
+                 @"The highlight and the restyled glyphs should be shown above the text.");
+
+  label.touchedLink = nil;
+  [label linkHighlightDidChange];
+  XCTAssertEqual([label.layer.sublayers filteredArrayUsingPredicate:visible].count, (NSUInteger)0,
+                 @"The overlay should be hidden once the link is released.");
+}
+
+- (void)testDisplaysAsynchronously {
+  NIAttributedLabel* label = [[NIAttributedLabel alloc] initWithFrame:CGRectMake(0, 0, 200, 40)];
+  label.backgroundColor = [UIColor clearColor];
+  label.text = @"Nimbus";
+  XCTAssertTrue(NIOpaquePixelCountForLabel(label) > 0, @"Synchronous labels draw immediately.");
+
+  label.displaysAsynchronously = YES;
+  XCTAssertEqual(NIOpaquePixelCountForLabel(label), (NSInteger)0, @"The text should be rendered in the background.");
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  NSInteger count = 0;
+  while (0 == count && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+    count = NIOpaquePixelCountForLabel(label);
+  }
+  XCTAssertTrue(count > 0, @"The background rendering should be drawn once it finishes.");
+
+  label.text = @"Changed";
+  XCTAssertEqual(NIOpaquePixelCountForLabel(label), (NSInteger)0, @"Renderings of replaced text must not be drawn.");
+}
+
+- (void)testLayoutDescriptorMatchesLabel {
+  NIAttributedLabel* label = [[NIAttributedLabel alloc] initWithFrame:CGRectMake(0, 0, 120, 40)];
+  label.font = [UIFont boldSystemFontOfSize:15];
+  label.numberOfLines = 0;
+  label.lineHeight = 22;
+  label.textKern = 1;
+  label.text = @"Measuring text without a label should match the label exactly.";
+
+  NIAttributedLabelLayoutDescriptor* descriptor = [NIAttributedLabelLayoutDescriptor descriptorWithLabel:label];
+  XCTAssertTrue([[descriptor attributedStringWithString:label.text] isEqualToAttributedString:label.attributedText],
+                @"The descriptor should build the label's string.");
+
+  CGSize size = [NIAttributedLabelLayoutDescriptor sizeOfString:label.text constrainedToWidth:120 descriptor:descriptor];
+  XCTAssertTrue(CGSizeEqualToSize(size, [label sizeThatFits:CGSizeMake(120, CGFLOAT_MAX)]),
+                @"The descriptor should measure what the label lays out.");
+
+  descriptor.numberOfLines = 1;
+  CGSize oneLineSize = [NIAttributedLabelLayoutDescriptor sizeOfString:label.text constrainedToWidth:120 descriptor:descriptor];
+  XCTAssertTrue(oneLineSize.height < size.height, @"numberOfLines should limit the height.");
+
+  XCTAssertTrue(CGSizeEqualToSize([NIAttributedLabelLayoutDescriptor sizeOfString:@"" constrainedToWidth:120 descriptor:descriptor], CGSizeZero),
+                @"Empty strings have no size.");
+}
+
+- (void)testAppendingTextMatchesSettingIt {
+  NSDictionary* attributes = @{NSFontAttributeName: [UIFont systemFontOfSize:14]};
+  NSAttributedString* first = [[NSAttributedString alloc] initWithString:@"The first paragraph stays as it was.\nThe second one" attributes:attributes];
+  NSAttributedString* appended = [[NSAttributedString alloc] initWithString:@" keeps growing.\nA third, to http://nimbuskit.info" attributes:attributes];
+
+  NIAttributedLabel* label = [[NIAttributedLabel alloc] initWithFrame:CGRectMake(0, 0, 160, 200)];
+  label.numberOfLines = 0;
+  label.autoDetectLinks = YES;
+  label.attributedText = first;
+  NIPNGDataForLabel(label); // Lays out the first text so that its lines can be kept.
+  [label appendAttributedString:appended];
+
+  NSMutableAttributedString* combined = [first mutableCopy];
+  [combined appendAttributedString:appended];
+  NIAttributedLabel* otherLabel = [[NIAttributedLabel alloc] initWithFrame:label.frame];
+  otherLabel.numberOfLines = 0;
+  otherLabel.autoDetectLinks = YES;
+  otherLabel.attributedText = combined;
+
+  XCTAssertTrue([label.attributedText isEqualToAttributedString:otherLabel.attributedText],
+                @"Appending should produce the combined text.");
+  XCTAssertEqualObjects(NIPNGDataForLabel(label), NIPNGDataForLabel(otherLabel),
+                        @"Appended text should be drawn as if it had been set all at once.");
+}
+
 @end
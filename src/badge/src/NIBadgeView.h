@@ -17,6 +17,8 @@
 
 #import <UIKit/UIKit.h>
 
+@class NIImageMemoryCache;
+
 /**
  * A view that mimics the iOS notification badge style.
  *
@@ -32,6 +34,13 @@
  *  @image html badge.png "A default NIBadgeView"
  *  @image html badgetinted.png "A NIBadgeView on tintColor-supporting devices"
  *
+ * <h2>Cached Rendering</h2>
+ *
+ * When the same few badges are shown on many cells or tabs, set cachesRenderedImages to YES.
+ * Each badge is then rendered once per unique combination of text, font, colors, shadow, style
+ * and size into an image that is kept in renderedImageCache, and every badge view that looks
+ * the same displays that one image as its layer contents.
+ *
  * @ingroup NimbusBadge
  */
 @interface NIBadgeView : UIView
@@ -47,6 +56,10 @@
 @property (nonatomic, assign) CGSize shadowOffset;
 @property (nonatomic, assign) CGFloat shadowBlur;
 
+// Rendering
+@property (nonatomic, assign) BOOL cachesRenderedImages; // Default: NO
++ (NIImageMemoryCache *)renderedImageCache;
+
 @end
 
 /** @name Accessing the Text Attributes */
@@ -139,3 +152,22 @@
  * @sa shadowColor
  * @fn NIBadgeView::shadowBlur
  */
+
+/** @name Caching Rendered Badges */
+
+/**
+ * Whether the rendered badge is shared through renderedImageCache.
+ *
+ * When NO each badge view renders itself every time it is displayed.
+ *
+ * @fn NIBadgeView::cachesRenderedImages
+ */
+
+/**
+ * The cache of rendered badge images shared by every badge view that caches rendered images.
+ *
+ * Badge images are small, so the cache is limited to 256 thousand pixels by default, and it
+ * empties itself under memory pressure like any other NIImageMemoryCache.
+ *
+ * @fn NIBadgeView::renderedImageCache
+ */
@@ -33,6 +33,23 @@ static const CGFloat kHorizontalMargins = 20.f;
 static const CGFloat kVerticalMargins = 10.f;
 static const CGFloat kBadgeLineSize = 2.0f;
 
+static const unsigned long long kRenderedImageCacheMaxNumberOfPixels = 256 * 1024;
+
+// Returns a string that uniquely identifies the color, or @"-" for nil.
+static NSString* NIBadgeStringFromColor(UIColor* color) {
+  if (nil == color) {
+    return @"-";
+  }
+  CGColorRef cgColor = color.CGColor;
+  const CGFloat* components = CGColorGetComponents(cgColor);
+  size_t numberOfComponents = CGColorGetNumberOfComponents(cgColor);
+  NSMutableString* string = [NSMutableString stringWithCapacity:numberOfComponents * 6];
+  for (size_t ix = 0; ix < numberOfComponents; ++ix) {
+    [string appendFormat:@"%.3f,", components[ix]];
+  }
+  return string;
+}
+
 @implementation NIBadgeView
 
 @synthesize tintColor = _tintColor;
@@ -41,6 +58,16 @@ static const CGFloat kBadgeLineSize = 2.0f;
   sUsesSolidTint = NIIsTintColorGloballySupported();
 }
 
++ (NIImageMemoryCache *)renderedImageCache {
+  static NIImageMemoryCache* cache = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    cache = [[NIImageMemoryCache alloc] init];
+    cache.maxNumberOfPixels = kRenderedImageCacheMaxNumberOfPixels;
+  });
+  return cache;
+}
+
 - (void)_configureDefaults {
   self.contentScaleFactor = NIScreenScale();
 
@@ -143,7 +170,53 @@ static const CGFloat kBadgeLineSize = 2.0f;
   [self setNeedsDisplay];
 }
 
-- (void)drawRect:(CGRect)rect {
+- (void)setCachesRenderedImages:(BOOL)cachesRenderedImages {
+  _cachesRenderedImages = cachesRenderedImages;
+
+  [self setNeedsDisplay];
+}
+
+- (NSString *)renderedImageKeyForSize:(CGSize)size scale:(CGFloat)scale {
+  return [NSString stringWithFormat:@"%@|%@|%.1f|%@|%@|%@|%.1fx%.1f|%.1f|%d|%.1fx%.1f@%.1f",
+          self.text, self.font.fontName, self.font.pointSize,
+          NIBadgeStringFromColor(self.tintColor), NIBadgeStringFromColor(self.textColor),
+          NIBadgeStringFromColor(self.shadowColor), self.shadowOffset.width, self.shadowOffset.height,
+          self.shadowBlur, sUsesSolidTint, size.width, size.height, scale];
+}
+
+// The badge is rendered into an image that becomes the layer's contents, rather than drawn in
+// drawRect:, so that badge views that look the same can share one image.
+- (void)displayLayer:(CALayer *)layer {
+  CGSize size = self.bounds.size;
+  if (size.width <= 0 || size.height <= 0) {
+    layer.contents = nil;
+    return;
+  }
+
+  CGFloat scale = self.contentScaleFactor;
+  NSString* key = nil;
+  UIImage* image = nil;
+  if (self.cachesRenderedImages) {
+    key = [self renderedImageKeyForSize:size scale:scale];
+    image = [[[self class] renderedImageCache] objectWithName:key];
+  }
+
+  if (nil == image) {
+    UIGraphicsBeginImageContextWithOptions(size, NO, scale);
+    [self drawBadgeInRect:CGRectMake(0, 0, size.width, size.height)];
+    image = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+
+    if (nil != key && nil != image) {
+      [[[self class] renderedImageCache] storeObject:image withName:key];
+    }
+  }
+
+  layer.contents = (id)image.CGImage;
+  layer.contentsScale = scale;
+}
+
+- (void)drawBadgeInRect:(CGRect)rect {
   CGContextRef context = UIGraphicsGetCurrentContext();
 
   CGSize textSize = [self.text sizeWithFont:self.font];
@@ -18,16 +18,77 @@
 
 #import <XCTest/XCTest.h>
 
-#import "NimbusOverview.h"
+#import "NimbusCore.h"
+#import "NimbusBadge.h"
 
-@interface NIOverviewTests : XCTestCase
+@interface NIBadgeTests : XCTestCase
 @end
 
 
-@implementation NIOverviewTests
+@implementation NIBadgeTests
 
 
-- (void)testNothing {
+- (void)setUp {
+  [[NIBadgeView renderedImageCache] removeAllObjects];
+}
+
+- (NIBadgeView *)badgeWithText:(NSString *)text cachesRenderedImages:(BOOL)cachesRenderedImages {
+  NIBadgeView* badge = [[NIBadgeView alloc] initWithFrame:CGRectMake(0, 0, 40, 30)];
+  badge.text = text;
+  badge.cachesRenderedImages = cachesRenderedImages;
+  return badge;
+}
+
+// Renders the badge the way Core Animation would and returns the layer's contents.
+- (id)renderedContentsOfBadge:(NIBadgeView *)badge {
+  [badge displayLayer:badge.layer];
+  return badge.layer.contents;
+}
+
+- (void)testIdenticalBadgesShareOneImage {
+  NIBadgeView* badge = [self badgeWithText:@"3" cachesRenderedImages:YES];
+  NIBadgeView* otherBadge = [self badgeWithText:@"3" cachesRenderedImages:YES];
+
+  id contents = [self renderedContentsOfBadge:badge];
+  XCTAssertNotNil(contents, @"The badge should have been rendered.");
+  XCTAssertEqual([self renderedContentsOfBadge:otherBadge], contents,
+                 @"A badge that looks the same should reuse the cached image.");
+  XCTAssertEqual([[NIBadgeView renderedImageCache] count], (NSUInteger)1);
+}
+
+- (void)testBadgesThatLookDifferentGetTheirOwnImages {
+  NIBadgeView* badge = [self badgeWithText:@"3" cachesRenderedImages:YES];
+  id contents = [self renderedContentsOfBadge:badge];
+
+  NIBadgeView* otherText = [self badgeWithText:@"4" cachesRenderedImages:YES];
+  XCTAssertNotEqual([self renderedContentsOfBadge:otherText], contents, @"The text should be part of the key.");
+
+  NIBadgeView* otherTint = [self badgeWithText:@"3" cachesRenderedImages:YES];
+  otherTint.tintColor = [UIColor blueColor];
+  XCTAssertNotEqual([self renderedContentsOfBadge:otherTint], contents, @"The tint should be part of the key.");
+
+  NIBadgeView* otherFont = [self badgeWithText:@"3" cachesRenderedImages:YES];
+  otherFont.font = [UIFont systemFontOfSize:badge.font.pointSize + 4];
+  XCTAssertNotEqual([self renderedContentsOfBadge:otherFont], contents, @"The font should be part of the key.");
+
+  NIBadgeView* otherScale = [self badgeWithText:@"3" cachesRenderedImages:YES];
+  otherScale.contentScaleFactor = (badge.contentScaleFactor == 1) ? 2 : 1;
+  XCTAssertNotEqual([self renderedContentsOfBadge:otherScale], contents, @"The scale should be part of the key.");
+
+  XCTAssertEqual([[NIBadgeView renderedImageCache] count], (NSUInteger)5,
+                 @"Each badge should have its own cache entry.");
+}
+
+- (void)testBadgesThatDontCacheBypassTheCache {
+  NIBadgeView* badge = [self badgeWithText:@"3" cachesRenderedImages:NO];
+  NIBadgeView* otherBadge = [self badgeWithText:@"3" cachesRenderedImages:NO];
+
+  id contents = [self renderedContentsOfBadge:badge];
+  XCTAssertNotNil(contents, @"The badge should have been rendered.");
+  XCTAssertNotEqual([self renderedContentsOfBadge:otherBadge], contents,
+                    @"Each badge should render its own image.");
+  XCTAssertEqual([[NIBadgeView renderedImageCache] count], (NSUInteger)0,
+                 @"Nothing should have been stored in the cache.");
 }
 
 @end
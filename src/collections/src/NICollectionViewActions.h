@@ -38,16 +38,57 @@
  *
  * If you use the delegate forwarders your collection view's data source must be an instance of
  * NICollectionViewModel.
+ *
+ * The actions can also be set as the collection view's delegate with
+ * @link NICollectionViewActions::forwardingTo: forwardingTo:@endlink, in which case every
+ * other UICollectionViewDelegate method is forwarded to the given delegate.
+ *
+@code
+collectionView.delegate = [self.actions forwardingTo:self];
+@endcode
  *
  * @ingroup CollectionViewTools
  */
-@interface NICollectionViewActions : NIActions
+@interface NICollectionViewActions : NIActions <UICollectionViewDelegate>
+
+#pragma mark Forwarding
+
+- (id<UICollectionViewDelegate>)forwardingTo:(id<UICollectionViewDelegate>)forwardDelegate;
+- (void)removeForwarding:(id<UICollectionViewDelegate>)forwardDelegate;
+
+#pragma mark Collection View Delegate
 
 - (BOOL)collectionView:(UICollectionView *)collectionView shouldHighlightItemAtIndexPath:(NSIndexPath *)indexPath;
 - (void)collectionView:(UICollectionView *)collectionView didSelectItemAtIndexPath:(NSIndexPath *)indexPath;
 
 @end
 
+/** @name Forwarding */
+
+/**
+ * Sets the delegate that collection view methods should be forwarded to.
+ *
+ * Methods that the actions don't implement are sent straight to the first forward delegate that
+ * implements them; which delegate that is gets worked out whenever a delegate is added or
+ * removed. didSelectItemAtIndexPath: is forwarded after the object's actions have run.
+ *
+ * @param forwardDelegate The delegate to forward invocations to.
+ * @returns self so that this method can be chained.
+ * @fn NICollectionViewActions::forwardingTo:
+ */
+
+/**
+ * Removes the delegate from the forwarding chain.
+ *
+ * If a forwarded delegate is about to be released but this object may live on, you must remove
+ * the forwarding in order to avoid invalid access errors at runtime.
+ *
+ * @param forwardDelegate The delegate to stop forwarding invocations to.
+ * @fn NICollectionViewActions::removeForwarding:
+ */
+
+/** @name Collection View Delegate */
+
 /**
  * Asks the receiver whether the object at the given index path is actionable.
  *
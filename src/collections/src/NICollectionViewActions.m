@@ -19,14 +19,56 @@
 #import "NICollectionViewCellFactory.h"
 #import "NimbusCore.h"
 #import "NIActions+Subclassing.h"
-#import <objc/runtime.h>
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "Nimbus requires ARC support."
 #endif
 
+@interface NICollectionViewActions()
+@property (nonatomic, strong) NSMutableSet* forwardDelegates;
+@property (nonatomic, strong) NIForwardingTable* forwardingTable; // Rebuilt when forwardDelegates changes.
+@end
+
 @implementation NICollectionViewActions
 
+- (id)initWithTarget:(id)target {
+  if ((self = [super initWithTarget:target])) {
+    _forwardDelegates = NICreateNonRetainingMutableSet();
+  }
+  return self;
+}
+
+#pragma mark - Forward Invocations
+
+
+- (BOOL)respondsToSelector:(SEL)selector {
+  if ([super respondsToSelector:selector]) {
+    return YES;
+  }
+  return (nil != [self.forwardingTable delegateForSelector:selector]);
+}
+
+- (id)forwardingTargetForSelector:(SEL)selector {
+  id delegate = [self.forwardingTable delegateForSelector:selector];
+  return (nil != delegate) ? delegate : [super forwardingTargetForSelector:selector];
+}
+
+- (void)forwardDelegatesDidChange {
+  self.forwardingTable = [[NIForwardingTable alloc] initWithProtocol:@protocol(UICollectionViewDelegate)
+                                                          delegates:self.forwardDelegates];
+}
+
+- (id<UICollectionViewDelegate>)forwardingTo:(id<UICollectionViewDelegate>)forwardDelegate {
+  [self.forwardDelegates addObject:forwardDelegate];
+  [self forwardDelegatesDidChange];
+  return self;
+}
+
+- (void)removeForwarding:(id<UICollectionViewDelegate>)forwardDelegate {
+  [self.forwardDelegates removeObject:forwardDelegate];
+  [self forwardDelegatesDidChange];
+}
+
 
 #pragma mark - UICollectionViewDelegate
 
@@ -122,6 +164,13 @@
       }
     }
   }
+
+  // Forward the invocation along.
+  for (id<UICollectionViewDelegate> delegate in self.forwardDelegates) {
+    if ([delegate respondsToSelector:_cmd]) {
+      [delegate collectionView:collectionView didSelectItemAtIndexPath:indexPath];
+    }
+  }
 }
 
 @end
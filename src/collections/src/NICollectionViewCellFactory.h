@@ -105,6 +105,110 @@ _model.delegate = (id)[NICollectionViewCellFactory class];
  */
 + (Class)collectionViewCellClassForItemAtIndexPath:(NSIndexPath *)indexPath model:(NICollectionViewModel *)model;
 
+/**
+ * Returns the size of the item at a given index path.
+ *
+ * Call this from the flow layout delegate's collectionView:layout:sizeForItemAtIndexPath:
+ *
+ * @code
+- (CGSize)collectionView:(UICollectionView *)collectionView layout:(UICollectionViewLayout *)collectionViewLayout sizeForItemAtIndexPath:(NSIndexPath *)indexPath {
+  return [self.cellFactory collectionView:collectionView layout:collectionViewLayout sizeForItemAtIndexPath:indexPath model:self.model];
+}
+ * @endcode
+ *
+ * The size is asked of the mapped cell class with sizeForObject:atIndexPath:collectionView:
+ * the first time and is then cached, so invalidating the layout only looks the sizes up. Sizes
+ * are cached for each object, compared by pointer, and for each collection view size, so a
+ * collection view that rotates keeps the sizes of both orientations. The cache is emptied
+ * whenever the model is modified; call invalidateItemSizeForObject: when an object changes in a
+ * way that changes its size.
+ *
+ * @returns The size returned by the cell class, or the flow layout's itemSize if the cell class
+ *               does not implement sizeForObject:atIndexPath:collectionView: or returns a zero
+ *               size.
+ */
+- (CGSize)collectionView:(UICollectionView *)collectionView layout:(UICollectionViewLayout *)collectionViewLayout sizeForItemAtIndexPath:(NSIndexPath *)indexPath model:(NICollectionViewModel *)model;
+
+/**
+ * Drops the cached sizes of the given object at every collection view size.
+ */
+- (void)invalidateItemSizeForObject:(id)object;
+
+/**
+ * Drops every cached size.
+ */
+- (void)invalidateItemSizes;
+
+/**
+ * Map a supplementary element kind to a view's class.
+ *
+ * Once mapped, the factory registers, dequeues and configures the views of this kind in
+ * collectionViewModel:collectionView:viewForSupplementaryElementOfKind:atIndexPath:. Views of the
+ * UICollectionElementKindSectionHeader and UICollectionElementKindSectionFooter kinds are given
+ * the section's header and footer titles respectively; views of any other kind are given nil.
+ *
+ * The view class should ideally implement the NICollectionViewSupplementaryView protocol.
+ */
+- (void)mapSupplementaryElementOfKind:(NSString *)kind toViewClass:(Class)viewClass;
+
+/**
+ * Map a supplementary element kind to a nib containing the view.
+ *
+ * A class mapping for the same kind takes precedence over a nib mapping.
+ */
+- (void)mapSupplementaryElementOfKind:(NSString *)kind toViewNib:(UINib *)viewNib;
+
+/**
+ * Creates a supplementary view of a kind that has been mapped to a view class or nib.
+ *
+ * This method signature matches the optional NICollectionViewModelDelegate method so that
+ * setting this factory as the model's delegate is enough to display mapped headers and footers.
+ *
+ * @returns nil if the kind has not been mapped.
+ */
+- (UICollectionReusableView *)collectionViewModel:(NICollectionViewModel *)collectionViewModel
+                                   collectionView:(UICollectionView *)collectionView
+                viewForSupplementaryElementOfKind:(NSString *)kind
+                                      atIndexPath:(NSIndexPath *)indexPath;
+
+/**
+ * Returns the size of the header of a given section.
+ *
+ * Call this from the flow layout delegate's
+ * collectionView:layout:referenceSizeForHeaderInSection:
+ *
+ * @code
+- (CGSize)collectionView:(UICollectionView *)collectionView layout:(UICollectionViewLayout *)collectionViewLayout referenceSizeForHeaderInSection:(NSInteger)section {
+  return [self.cellFactory collectionView:collectionView layout:collectionViewLayout referenceSizeForHeaderInSection:section model:self.model];
+}
+ * @endcode
+ *
+ * Sizes are cached like item sizes: for each section and for each collection view size, and
+ * they are dropped whenever the model is modified.
+ *
+ * @returns The size returned by the mapped view class, or the flow layout's headerReferenceSize
+ *               if the view class does not implement
+ *               sizeForObject:ofKind:inSection:collectionView:.
+ */
+- (CGSize)collectionView:(UICollectionView *)collectionView layout:(UICollectionViewLayout *)collectionViewLayout referenceSizeForHeaderInSection:(NSInteger)section model:(NICollectionViewModel *)model;
+
+/**
+ * Returns the size of the footer of a given section.
+ *
+ * Call this from the flow layout delegate's
+ * collectionView:layout:referenceSizeForFooterInSection: as with the header sizes.
+ *
+ * @returns The size returned by the mapped view class, or the flow layout's footerReferenceSize
+ *               if the view class does not implement
+ *               sizeForObject:ofKind:inSection:collectionView:.
+ */
+- (CGSize)collectionView:(UICollectionView *)collectionView layout:(UICollectionViewLayout *)collectionViewLayout referenceSizeForFooterInSection:(NSInteger)section model:(NICollectionViewModel *)model;
+
+/**
+ * Drops every cached header and footer size.
+ */
+- (void)invalidateSupplementaryViewSizes;
+
 @end
 
 /**
@@ -164,6 +268,51 @@ _model.delegate = (id)[NICollectionViewCellFactory class];
  */
 + (BOOL)shouldAppendObjectClassToReuseIdentifier;
 
+/**
+ * Asks the receiver to calculate its size.
+ *
+ * The following is an appropriate implementation in your collectionView's layout delegate.
+ *
+ * @code
+- (CGSize)collectionView:(UICollectionView *)collectionView layout:(UICollectionViewLayout *)collectionViewLayout sizeForItemAtIndexPath:(NSIndexPath *)indexPath {
+  return [self.cellFactory collectionView:collectionView layout:collectionViewLayout sizeForItemAtIndexPath:indexPath model:self.model];
+}
+ * @endcode
+ *
+ * You may find it helpful to use the collection view's bounds to size the cell.
+ */
++ (CGSize)sizeForObject:(id)object atIndexPath:(NSIndexPath *)indexPath collectionView:(UICollectionView *)collectionView;
+
+@end
+
+/**
+ * The protocol for a supplementary view created in the NICollectionViewCellFactory.
+ *
+ * Views that implement this protocol are given the title of their section when they are mapped
+ * to the header or footer kinds.
+ *
+ * @ingroup CollectionViewCellFactory
+ */
+@protocol NICollectionViewSupplementaryView <NSObject>
+@required
+
+/**
+ * Called both when a view is created and when it is reused.
+ *
+ * Implement this method to customize the view's properties for display using the given object.
+ */
+- (BOOL)shouldUpdateViewWithObject:(id)object;
+
+@optional
+
+/**
+ * Asks the receiver to calculate its size.
+ *
+ * Returning a zero size hides the view for the section, which is useful for sections without
+ * titles.
+ */
++ (CGSize)sizeForObject:(id)object ofKind:(NSString *)kind inSection:(NSInteger)section collectionView:(UICollectionView *)collectionView;
+
 @end
 
 /**
@@ -16,15 +16,25 @@
 
 #import "NICollectionViewCellFactory.h"
 
+#import "NICollectionViewModel+Private.h"
 #import "NimbusCore.h"
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "Nimbus requires ARC support."
 #endif
 
+// Rotating between two orientations only ever needs the sizes of two collection view sizes.
+static const NSUInteger kMaximumNumberOfCachedItemSizeBounds = 2;
+
 @interface NICollectionViewCellFactory()
 @property (nonatomic, copy) NSMutableDictionary* objectToCellMap;
 @property (nonatomic, copy) NSMutableSet* registeredObjectClasses;
+@property (nonatomic, strong) NSMutableDictionary* boundsSizeToItemSizes; // NSValue of CGSize => NSMapTable
+@property (nonatomic, weak) NICollectionViewModel* itemSizeModel;
+@property (nonatomic, assign) NSUInteger itemSizeModelMutationCount;
+@property (nonatomic, strong) NSMutableDictionary* kindToViewClass; // NSString => Class
+@property (nonatomic, strong) NSMutableDictionary* kindToViewNib; // NSString => UINib
+@property (nonatomic, strong) NSMutableDictionary* boundsSizeToSupplementarySizes; // NSValue of CGSize => NSMutableDictionary
 @end
 
 
@@ -36,6 +46,8 @@
   if ((self = [super init])) {
     _objectToCellMap = [[NSMutableDictionary alloc] init];
     _registeredObjectClasses = [[NSMutableSet alloc] init];
+    _kindToViewClass = [[NSMutableDictionary alloc] init];
+    _kindToViewNib = [[NSMutableDictionary alloc] init];
   }
   return self;
 }
@@ -171,6 +183,183 @@
   return collectionViewCellClass;
 }
 
+- (CGSize)collectionView:(UICollectionView *)collectionView layout:(UICollectionViewLayout *)collectionViewLayout sizeForItemAtIndexPath:(NSIndexPath *)indexPath model:(NICollectionViewModel *)model {
+  id object = [model objectAtIndexPath:indexPath];
+  if (nil == object) {
+    return [self collectionView:collectionView layout:collectionViewLayout sizeForObject:object atIndexPath:indexPath];
+  }
+
+  NSMapTable* itemSizes = [self itemSizesForCollectionView:collectionView model:model];
+  NSValue* size = [itemSizes objectForKey:object];
+  if (nil == size) {
+    size = [NSValue valueWithCGSize:[self collectionView:collectionView layout:collectionViewLayout sizeForObject:object atIndexPath:indexPath]];
+    [itemSizes setObject:size forKey:object];
+  }
+  return [size CGSizeValue];
+}
+
+- (CGSize)collectionView:(UICollectionView *)collectionView layout:(UICollectionViewLayout *)collectionViewLayout sizeForObject:(id)object atIndexPath:(NSIndexPath *)indexPath {
+  CGSize size = CGSizeZero;
+  if ([collectionViewLayout isKindOfClass:[UICollectionViewFlowLayout class]]) {
+    size = [(UICollectionViewFlowLayout *)collectionViewLayout itemSize];
+  }
+  Class collectionViewCellClass = [self collectionViewCellClassFromObject:object];
+  if ([collectionViewCellClass respondsToSelector:@selector(sizeForObject:atIndexPath:collectionView:)]) {
+    CGSize cellSize = [collectionViewCellClass sizeForObject:object atIndexPath:indexPath collectionView:collectionView];
+    if (cellSize.width > 0 && cellSize.height > 0) {
+      size = cellSize;
+    }
+  }
+  return size;
+}
+
+- (void)invalidateSizesIfModelChanged:(NICollectionViewModel *)model {
+  // Objects may be moved to index paths where they have a different size, and sections may be
+  // renamed or moved.
+  if (self.itemSizeModel != model || self.itemSizeModelMutationCount != model.mutationCount) {
+    [self invalidateItemSizes];
+    [self invalidateSupplementaryViewSizes];
+    self.itemSizeModel = model;
+    self.itemSizeModelMutationCount = model.mutationCount;
+  }
+}
+
+- (NSMapTable *)itemSizesForCollectionView:(UICollectionView *)collectionView model:(NICollectionViewModel *)model {
+  [self invalidateSizesIfModelChanged:model];
+
+  NSValue* boundsSize = [NSValue valueWithCGSize:collectionView.bounds.size];
+  NSMapTable* itemSizes = [self.boundsSizeToItemSizes objectForKey:boundsSize];
+  if (nil == itemSizes) {
+    if (nil == self.boundsSizeToItemSizes) {
+      self.boundsSizeToItemSizes = [NSMutableDictionary dictionary];
+    } else if (self.boundsSizeToItemSizes.count >= kMaximumNumberOfCachedItemSizeBounds) {
+      [self.boundsSizeToItemSizes removeAllObjects];
+    }
+    itemSizes = [NSMapTable mapTableWithKeyOptions:(NSPointerFunctionsWeakMemory
+                                                    | NSPointerFunctionsObjectPointerPersonality)
+                                      valueOptions:NSPointerFunctionsStrongMemory];
+    [self.boundsSizeToItemSizes setObject:itemSizes forKey:boundsSize];
+  }
+  return itemSizes;
+}
+
+- (void)invalidateItemSizeForObject:(id)object {
+  if (nil == object) {
+    return;
+  }
+  for (NSMapTable* itemSizes in [self.boundsSizeToItemSizes objectEnumerator]) {
+    [itemSizes removeObjectForKey:object];
+  }
+}
+
+- (void)invalidateItemSizes {
+  [self.boundsSizeToItemSizes removeAllObjects];
+}
+
+- (void)mapSupplementaryElementOfKind:(NSString *)kind toViewClass:(Class)viewClass {
+  [self.kindToViewClass setObject:viewClass forKey:kind];
+  [self invalidateSupplementaryViewSizes];
+}
+
+- (void)mapSupplementaryElementOfKind:(NSString *)kind toViewNib:(UINib *)viewNib {
+  [self.kindToViewNib setObject:viewNib forKey:kind];
+  [self invalidateSupplementaryViewSizes];
+}
+
+- (id)objectForSupplementaryElementOfKind:(NSString *)kind inSection:(NSInteger)section model:(NICollectionViewModel *)model {
+  if (section < 0 || (NSUInteger)section >= model.sections.count) {
+    return nil;
+  }
+  NICollectionViewModelSection* modelSection = [model.sections objectAtIndex:section];
+  if ([kind isEqualToString:UICollectionElementKindSectionHeader]) {
+    return modelSection.headerTitle;
+  } else if ([kind isEqualToString:UICollectionElementKindSectionFooter]) {
+    return modelSection.footerTitle;
+  }
+  return nil;
+}
+
+- (UICollectionReusableView *)collectionViewModel:(NICollectionViewModel *)collectionViewModel
+                                   collectionView:(UICollectionView *)collectionView
+                viewForSupplementaryElementOfKind:(NSString *)kind
+                                      atIndexPath:(NSIndexPath *)indexPath {
+  UICollectionReusableView* view = nil;
+
+  Class viewClass = [self.kindToViewClass objectForKey:kind];
+  UINib* viewNib = [self.kindToViewNib objectForKey:kind];
+  if (nil != viewClass) {
+    NSString* identifier = NSStringFromClass(viewClass);
+    [collectionView registerClass:viewClass forSupplementaryViewOfKind:kind withReuseIdentifier:identifier];
+    view = [collectionView dequeueReusableSupplementaryViewOfKind:kind withReuseIdentifier:identifier forIndexPath:indexPath];
+
+  } else if (nil != viewNib) {
+    NSString* identifier = [kind stringByAppendingString:@".nib"];
+    [collectionView registerNib:viewNib forSupplementaryViewOfKind:kind withReuseIdentifier:identifier];
+    view = [collectionView dequeueReusableSupplementaryViewOfKind:kind withReuseIdentifier:identifier forIndexPath:indexPath];
+  }
+
+  // Allow the view to configure itself with the section's information.
+  if ([view respondsToSelector:@selector(shouldUpdateViewWithObject:)]) {
+    id object = [self objectForSupplementaryElementOfKind:kind inSection:indexPath.section model:collectionViewModel];
+    [(id<NICollectionViewSupplementaryView>)view shouldUpdateViewWithObject:object];
+  }
+
+  return view;
+}
+
+- (CGSize)collectionView:(UICollectionView *)collectionView layout:(UICollectionViewLayout *)collectionViewLayout referenceSizeForHeaderInSection:(NSInteger)section model:(NICollectionViewModel *)model {
+  return [self collectionView:collectionView layout:collectionViewLayout sizeForSupplementaryElementOfKind:UICollectionElementKindSectionHeader inSection:section model:model];
+}
+
+- (CGSize)collectionView:(UICollectionView *)collectionView layout:(UICollectionViewLayout *)collectionViewLayout referenceSizeForFooterInSection:(NSInteger)section model:(NICollectionViewModel *)model {
+  return [self collectionView:collectionView layout:collectionViewLayout sizeForSupplementaryElementOfKind:UICollectionElementKindSectionFooter inSection:section model:model];
+}
+
+- (CGSize)collectionView:(UICollectionView *)collectionView layout:(UICollectionViewLayout *)collectionViewLayout sizeForSupplementaryElementOfKind:(NSString *)kind inSection:(NSInteger)section model:(NICollectionViewModel *)model {
+  [self invalidateSizesIfModelChanged:model];
+
+  NSValue* boundsSize = [NSValue valueWithCGSize:collectionView.bounds.size];
+  NSMutableDictionary* kindToSizes = [self.boundsSizeToSupplementarySizes objectForKey:boundsSize];
+  if (nil == kindToSizes) {
+    if (nil == self.boundsSizeToSupplementarySizes) {
+      self.boundsSizeToSupplementarySizes = [NSMutableDictionary dictionary];
+    } else if (self.boundsSizeToSupplementarySizes.count >= kMaximumNumberOfCachedItemSizeBounds) {
+      [self.boundsSizeToSupplementarySizes removeAllObjects];
+    }
+    kindToSizes = [NSMutableDictionary dictionary];
+    [self.boundsSizeToSupplementarySizes setObject:kindToSizes forKey:boundsSize];
+  }
+  NSMutableDictionary* sectionToSize = [kindToSizes objectForKey:kind];
+  if (nil == sectionToSize) {
+    sectionToSize = [NSMutableDictionary dictionary];
+    [kindToSizes setObject:sectionToSize forKey:kind];
+  }
+
+  NSNumber* sectionKey = @(section);
+  NSValue* size = [sectionToSize objectForKey:sectionKey];
+  if (nil == size) {
+    CGSize viewSize = CGSizeZero;
+    if ([collectionViewLayout isKindOfClass:[UICollectionViewFlowLayout class]]) {
+      UICollectionViewFlowLayout* flowLayout = (UICollectionViewFlowLayout *)collectionViewLayout;
+      viewSize = ([kind isEqualToString:UICollectionElementKindSectionFooter]
+                  ? flowLayout.footerReferenceSize
+                  : flowLayout.headerReferenceSize);
+    }
+    Class viewClass = [self.kindToViewClass objectForKey:kind];
+    if ([viewClass respondsToSelector:@selector(sizeForObject:ofKind:inSection:collectionView:)]) {
+      id object = [self objectForSupplementaryElementOfKind:kind inSection:section model:model];
+      viewSize = [viewClass sizeForObject:object ofKind:kind inSection:section collectionView:collectionView];
+    }
+    size = [NSValue valueWithCGSize:viewSize];
+    [sectionToSize setObject:size forKey:sectionKey];
+  }
+  return [size CGSizeValue];
+}
+
+- (void)invalidateSupplementaryViewSizes {
+  [self.boundsSizeToSupplementarySizes removeAllObjects];
+}
+
 @end
 
 
@@ -16,19 +16,38 @@
 
 #import <Foundation/Foundation.h>
 
+#import "NICollectionViewModelDiff.h"
+#import "NIModelDiff.h"
+
 @interface NICollectionViewModel()
 
 @property (nonatomic, strong) NSArray* sections; // Array of NICollectionViewModelSection
 @property (nonatomic, strong) NSArray* sectionIndexTitles;
 @property (nonatomic, strong) NSDictionary* sectionPrefixToSectionIndex;
+@property (nonatomic, strong) NSMapTable* objectIndex; // Object => NSIndexPath of its first item
+@property (nonatomic, assign) BOOL objectIndexHasDuplicates;
+@property (nonatomic, assign) NSUInteger mutationCount; // Incremented by every change to a mutable model
+@property (nonatomic, strong) NIPrefetchWindow* prefetchWindow; // Created on first use
 
 - (void)_resetCompiledData;
 - (void)_compileDataWithListArray:(NSArray *)listArray;
 - (void)_compileDataWithSectionedArray:(NSArray *)sectionedArray;
 
+// Finds the object without the object index.
+- (NSIndexPath *)_scanIndexPathForObject:(id)object;
+
+// Keeping the object index up to date. Each does nothing without an objectIndexType.
+- (void)_rebuildObjectIndex;
+- (void)_indexObject:(id)object atIndexPath:(NSIndexPath *)indexPath;
+- (void)_unindexObject:(id)object atIndexPath:(NSIndexPath *)indexPath;
+- (void)_reindexObjects:(NSArray *)objects;
+- (void)_offsetIndexedRowsInSection:(NSUInteger)sectionIndex fromRow:(NSUInteger)row
+                       sectionDelta:(NSInteger)sectionDelta rowDelta:(NSInteger)rowDelta;
+- (void)_offsetIndexedSectionsFromSection:(NSUInteger)sectionIndex by:(NSInteger)delta;
+
 @end
 
-@interface NICollectionViewModelSection : NSObject
+@interface NICollectionViewModelSection : NSObject <NIModelDiffSection>
 
 + (id)section;
 
@@ -37,3 +56,17 @@
 @property (nonatomic, strong) NSArray* rows;
 
 @end
+
+@interface NICollectionViewModelDiff ()
+
++ (NSArray *)sectionsForSectionedArray:(NSArray *)sectionedArray;
++ (NICollectionViewModelDiff *)diffFromSections:(NSArray *)fromSections toSections:(NSArray *)toSections;
+
+@property (nonatomic, readonly, strong) NSArray* toSections; // Array of NICollectionViewModelSection
+@property (nonatomic, readonly, copy) NSArray* fromSectionTitles; // NSString or NSNull
+@property (nonatomic, readonly, copy) NSArray* fromSectionRowCounts; // NSNumber
+
+// Whether the diff was computed from sections with the same titles and numbers of items.
+- (BOOL)isDiffFromSections:(NSArray *)sections;
+
+@end
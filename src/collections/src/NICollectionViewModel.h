@@ -20,6 +20,7 @@
 #import "NIPreprocessorMacros.h" /* for weak */
 
 @protocol NICollectionViewModelDelegate;
+@class NIPrefetchWindow;
 
 
 #pragma mark Sectioned Array Objects
@@ -27,6 +28,12 @@
 // Classes used when creating NICollectionViewModels.
 @class NICollectionViewModelFooter;  // Provides the information for a footer.
 
+typedef enum {
+  NICollectionViewModelObjectIndexNone, // indexPathForObject: compares every item with isEqual:.
+  NICollectionViewModelObjectIndexEquality, // Items are indexed by hash and isEqual:.
+  NICollectionViewModelObjectIndexIdentity, // Items are indexed by pointer.
+} NICollectionViewModelObjectIndex;
+
 /**
  * A non-mutable collection view model that complies to the UICollectionViewDataSource protocol.
  *
@@ -55,13 +62,23 @@
 
 - (id)objectAtIndexPath:(NSIndexPath *)indexPath;
 
-// This method is not appropriate for performance critical codepaths.
+// Scans the model unless objectIndexType is set.
 - (NSIndexPath *)indexPathForObject:(id)object;
 
+// Immediately indexes every item.
+@property (nonatomic, assign) NICollectionViewModelObjectIndex objectIndexType; // Default: NICollectionViewModelObjectIndexNone
+
 #pragma mark Creating Collection View Cells
 
 @property (nonatomic, weak) id<NICollectionViewModelDelegate> delegate;
 
+#pragma mark Prefetching
+
+// Call from the collection view delegate's scrollViewDidScroll:.
+- (void)prefetchObjectsForCollectionView:(UICollectionView *)collectionView;
+
+@property (nonatomic, readonly, strong) NIPrefetchWindow* prefetchWindow;
+
 @end
 
 /**
@@ -190,11 +207,27 @@
 /**
  * Returns the index path of the given object within the model.
  *
- * If the model does not contain the object then nil will be returned.
+ * If the model does not contain the object then nil will be returned. If it contains the object
+ * more than once then the first index path is returned.
+ *
+ * This scans every item unless NICollectionViewModel::objectIndexType is set, in which case it
+ * is a single lookup.
  *
  * @fn NICollectionViewModel::indexPathForObject:
  */
 
+/**
+ * How indexPathForObject: finds objects.
+ *
+ * Works like NITableViewModel::objectIndexType: the index maps each item to its index path and
+ * NIMutableCollectionViewModel keeps it up to date. Identity indexing never calls hash or
+ * isEqual:; equality indexing requires that objects keep their hash while in the model.
+ *
+ * NICollectionViewModelObjectIndexNone by default.
+ *
+ * @fn NICollectionViewModel::objectIndexType
+ */
+
 
 /** @name Creating Collection View Cells */
 
@@ -203,3 +236,30 @@
  *
  * @fn NICollectionViewModel::delegate
  */
+
+/** @name Prefetching */
+
+/**
+ * Prepares the objects of the items that are about to scroll on screen.
+ *
+ * Objects that conform to NIPrefetchingObject are sent prepareForDisplayInBackground on a
+ * background queue once their item enters the look-ahead window, so that images or text layout
+ * are ready by the time collectionView:cellForItemAtIndexPath: is called. The window grows with
+ * the scroll velocity and follows the scrolling axis. Call this from scrollViewDidScroll::
+ *
+@code
+- (void)scrollViewDidScroll:(UIScrollView *)scrollView {
+  [self.model prefetchObjectsForCollectionView:self.collectionView];
+}
+@endcode
+ *
+ * @fn NICollectionViewModel::prefetchObjectsForCollectionView:
+ */
+
+/**
+ * The look-ahead window used by prefetchObjectsForCollectionView:.
+ *
+ * Use this to tune how far ahead objects are prepared.
+ *
+ * @fn NICollectionViewModel::prefetchWindow
+ */
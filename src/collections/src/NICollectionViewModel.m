@@ -62,6 +62,8 @@
   self.sections = nil;
   self.sectionIndexTitles = nil;
   self.sectionPrefixToSectionIndex = nil;
+  [self.objectIndex removeAllObjects];
+  self.objectIndexHasDuplicates = NO;
 }
 
 - (void)_compileDataWithListArray:(NSArray *)listArray {
@@ -72,6 +74,7 @@
     section.rows = listArray;
     self.sections = [NSArray arrayWithObject:section];
   }
+  [self _rebuildObjectIndex];
 }
 
 - (void)_compileDataWithSectionedArray:(NSArray *)sectionedArray {
@@ -133,6 +136,119 @@
 
   // Update the compiled information for this data source.
   self.sections = sections;
+  [self _rebuildObjectIndex];
+}
+
+#pragma mark - Object Index
+
+
+- (NSIndexPath *)_scanIndexPathForObject:(id)object {
+  BOOL matchesIdentity = (NICollectionViewModelObjectIndexIdentity == _objectIndexType);
+  NSArray *sections = self.sections;
+  for (NSUInteger sectionIndex = 0; sectionIndex < [sections count]; sectionIndex++) {
+    NSArray* rows = [[sections objectAtIndex:sectionIndex] rows];
+    NSUInteger rowIndex = (matchesIdentity
+                           ? [rows indexOfObjectIdenticalTo:object]
+                           : [rows indexOfObject:object]);
+    if (NSNotFound != rowIndex) {
+      return [NSIndexPath indexPathForRow:rowIndex inSection:sectionIndex];
+    }
+  }
+  return nil;
+}
+
+- (void)_rebuildObjectIndex {
+  self.objectIndexHasDuplicates = NO;
+  if (NICollectionViewModelObjectIndexNone == _objectIndexType) {
+    self.objectIndex = nil;
+    return;
+  }
+
+  NSPointerFunctionsOptions personality = ((NICollectionViewModelObjectIndexIdentity == _objectIndexType)
+                                           ? NSPointerFunctionsObjectPointerPersonality
+                                           : NSPointerFunctionsObjectPersonality);
+  self.objectIndex = [[NSMapTable alloc] initWithKeyOptions:(NSPointerFunctionsStrongMemory | personality)
+                                               valueOptions:NSPointerFunctionsStrongMemory
+                                                   capacity:0];
+  NSUInteger sectionIndex = 0;
+  for (NICollectionViewModelSection* section in self.sections) {
+    NSUInteger rowIndex = 0;
+    for (id object in section.rows) {
+      [self _indexObject:object atIndexPath:[NSIndexPath indexPathForRow:rowIndex inSection:sectionIndex]];
+      ++rowIndex;
+    }
+    ++sectionIndex;
+  }
+}
+
+- (void)_indexObject:(id)object atIndexPath:(NSIndexPath *)indexPath {
+  if (nil == self.objectIndex) {
+    return;
+  }
+  NSIndexPath* firstIndexPath = [self.objectIndex objectForKey:object];
+  if (nil != firstIndexPath) {
+    self.objectIndexHasDuplicates = YES;
+    // Like the scan, the index finds the first of several equal objects.
+    if (NSOrderedDescending != [firstIndexPath compare:indexPath]) {
+      return;
+    }
+  }
+  [self.objectIndex setObject:indexPath forKey:object];
+}
+
+- (void)_unindexObject:(id)object atIndexPath:(NSIndexPath *)indexPath {
+  if ([[self.objectIndex objectForKey:object] isEqual:indexPath]) {
+    [self.objectIndex removeObjectForKey:object];
+  }
+}
+
+- (void)_reindexObjects:(NSArray *)objects {
+  // A removed object can only still be in the model if something was added twice.
+  if (nil == self.objectIndex || !self.objectIndexHasDuplicates) {
+    return;
+  }
+  for (id object in objects) {
+    if (nil == [self.objectIndex objectForKey:object]) {
+      NSIndexPath* indexPath = [self _scanIndexPathForObject:object];
+      if (nil != indexPath) {
+        [self.objectIndex setObject:indexPath forKey:object];
+      }
+    }
+  }
+}
+
+- (void)_offsetIndexedRowsInSection:(NSUInteger)sectionIndex fromRow:(NSUInteger)row
+                       sectionDelta:(NSInteger)sectionDelta rowDelta:(NSInteger)rowDelta {
+  if (nil == self.objectIndex) {
+    return;
+  }
+  NSArray* rows = [[self.sections objectAtIndex:sectionIndex] rows];
+  if (row >= rows.count) {
+    return;
+  }
+  // Rows that moved down are visited last to first so that an updated index path is never
+  // mistaken for the previous index path of a later duplicate.
+  NSEnumerationOptions options = (rowDelta > 0) ? NSEnumerationReverse : 0;
+  NSIndexSet* rowIndexes = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(row, rows.count - row)];
+  [rows enumerateObjectsAtIndexes:rowIndexes options:options usingBlock:^(id object, NSUInteger rowIndex, BOOL *stop) {
+    NSIndexPath* previousIndexPath = [NSIndexPath indexPathForRow:(NSInteger)rowIndex - rowDelta
+                                                        inSection:(NSInteger)sectionIndex - sectionDelta];
+    if ([[self.objectIndex objectForKey:object] isEqual:previousIndexPath]) {
+      [self.objectIndex setObject:[NSIndexPath indexPathForRow:rowIndex inSection:sectionIndex]
+                           forKey:object];
+    }
+  }];
+}
+
+- (void)_offsetIndexedSectionsFromSection:(NSUInteger)sectionIndex by:(NSInteger)delta {
+  if (nil == self.objectIndex) {
+    return;
+  }
+  NSUInteger numberOfSections = self.sections.count;
+  for (NSUInteger ix = sectionIndex; ix < numberOfSections; ++ix) {
+    NSUInteger offsetSectionIndex = (delta > 0) ? numberOfSections - 1 - (ix - sectionIndex) : ix;
+    [self _offsetIndexedRowsInSection:offsetSectionIndex fromRow:0 sectionDelta:delta rowDelta:0];
+  }
 }
 
 #pragma mark - UICollectionViewDataSource
@@ -202,18 +318,17 @@
   if (nil == object) {
     return nil;
   }
-
-  NSArray *sections = self.sections;
-  for (NSUInteger sectionIndex = 0; sectionIndex < [sections count]; sectionIndex++) {
-    NSArray* rows = [[sections objectAtIndex:sectionIndex] rows];
-    for (NSUInteger rowIndex = 0; rowIndex < [rows count]; rowIndex++) {
-      if ([object isEqual:[rows objectAtIndex:rowIndex]]) {
-        return [NSIndexPath indexPathForRow:rowIndex inSection:sectionIndex];
-      }
-    }
+  if (nil != self.objectIndex) {
+    return [self.objectIndex objectForKey:object];
   }
+  return [self _scanIndexPathForObject:object];
+}
 
-  return nil;
+- (void)setObjectIndexType:(NICollectionViewModelObjectIndex)objectIndexType {
+  if (_objectIndexType != objectIndexType) {
+    _objectIndexType = objectIndexType;
+    [self _rebuildObjectIndex];
+  }
 }
 
 - (NSString *)description {
@@ -228,6 +343,40 @@
   return result;
 }
 
+- (NIPrefetchWindow *)prefetchWindow {
+  if (nil == _prefetchWindow) {
+    _prefetchWindow = [[NIPrefetchWindow alloc] init];
+  }
+  return _prefetchWindow;
+}
+
+- (void)prefetchObjectsForCollectionView:(UICollectionView *)collectionView {
+  NIPrefetchWindow* prefetchWindow = self.prefetchWindow;
+  CGRect lookAheadRect = [prefetchWindow lookAheadRectForScrollView:collectionView];
+  NSArray* attributes = (CGRectIsEmpty(lookAheadRect)
+                         ? nil
+                         : [collectionView.collectionViewLayout layoutAttributesForElementsInRect:lookAheadRect]);
+
+  NSMutableArray* objects = [NSMutableArray arrayWithCapacity:attributes.count];
+  for (UICollectionViewLayoutAttributes* itemAttributes in attributes) {
+    if (UICollectionElementCategoryCell != itemAttributes.representedElementCategory) {
+      continue;
+    }
+    id object = [self objectAtIndexPath:itemAttributes.indexPath];
+    if (nil != object) {
+      [objects addObject:object];
+    }
+  }
+  NSMutableArray* visibleObjects = [NSMutableArray array];
+  for (NSIndexPath* indexPath in [collectionView indexPathsForVisibleItems]) {
+    id object = [self objectAtIndexPath:indexPath];
+    if (nil != object) {
+      [visibleObjects addObject:object];
+    }
+  }
+  [prefetchWindow prefetchObjects:objects visibleObjects:visibleObjects];
+}
+
 @end
 
 
@@ -0,0 +1,146 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+/**
+ * The changes that turn one sectioned array into another, in the form UICollectionView's
+ * batch updates expect.
+ *
+ * Sections are matched by header title and items by object. Each item is matched first to the
+ * identical object and then to an equal one, using hash and isEqual:, so the diff takes linear
+ * time. Equal but not identical items are reloaded; unmatched items are inserted or deleted;
+ * matched items whose position changed other than by the insertions and deletions around them
+ * are moved.
+ *
+ * Diffs only read the arrays they are given and may be computed on any thread. This lets a very
+ * large model compute its diff in the background and apply it on the main thread with
+ * NIMutableCollectionViewModel::applyDiff:withCollectionView:.
+ *
+ * @ingroup CollectionViewModels
+ */
+@interface NICollectionViewModelDiff : NSObject
+
+// Both arrays use the format of NICollectionViewModel::initWithSectionedArray:delegate:.
++ (NICollectionViewModelDiff *)diffFromSectionedArray:(NSArray *)fromSectionedArray toSectionedArray:(NSArray *)toSectionedArray;
+
+@property (nonatomic, readonly, copy) NSIndexSet* deletedSections;
+@property (nonatomic, readonly, copy) NSIndexSet* insertedSections;
+@property (nonatomic, readonly, copy) NSArray* movedFromSections; // NSNumber
+@property (nonatomic, readonly, copy) NSArray* movedToSections; // NSNumber
+
+@property (nonatomic, readonly, copy) NSArray* deletedIndexPaths;
+@property (nonatomic, readonly, copy) NSArray* insertedIndexPaths;
+@property (nonatomic, readonly, copy) NSArray* movedFromIndexPaths;
+@property (nonatomic, readonly, copy) NSArray* movedToIndexPaths;
+@property (nonatomic, readonly, copy) NSArray* reloadedIndexPaths;
+
+@property (nonatomic, readonly, assign) BOOL hasChanges;
+
+- (void)applyToCollectionView:(UICollectionView *)collectionView completion:(void (^)(BOOL finished))completion;
+
+@end
+
+/** @name Computing Diffs */
+
+/**
+ * Returns the changes from one sectioned array to another.
+ *
+ * @fn NICollectionViewModelDiff::diffFromSectionedArray:toSectionedArray:
+ */
+
+/** @name Changes */
+
+/**
+ * The indexes of the sections that were removed, in the old contents.
+ *
+ * The items of these sections are not listed in deletedIndexPaths.
+ *
+ * @fn NICollectionViewModelDiff::deletedSections
+ */
+
+/**
+ * The indexes of the sections that were added, in the new contents.
+ *
+ * The items of these sections are not listed in insertedIndexPaths.
+ *
+ * @fn NICollectionViewModelDiff::insertedSections
+ */
+
+/**
+ * The old indexes of the moved sections. movedToSections holds the new index at the same position.
+ *
+ * @fn NICollectionViewModelDiff::movedFromSections
+ */
+
+/**
+ * @fn NICollectionViewModelDiff::movedToSections
+ * @sa NICollectionViewModelDiff::movedFromSections
+ */
+
+/**
+ * The old index paths of the items that were removed.
+ *
+ * @fn NICollectionViewModelDiff::deletedIndexPaths
+ */
+
+/**
+ * The new index paths of the items that were added.
+ *
+ * @fn NICollectionViewModelDiff::insertedIndexPaths
+ */
+
+/**
+ * The old index paths of the moved items. movedToIndexPaths holds the new index path at the same
+ * position.
+ *
+ * @fn NICollectionViewModelDiff::movedFromIndexPaths
+ */
+
+/**
+ * @fn NICollectionViewModelDiff::movedToIndexPaths
+ * @sa NICollectionViewModelDiff::movedFromIndexPaths
+ */
+
+/**
+ * The old index paths of the items that were replaced by an equal object.
+ *
+ * An item that was replaced and moved is deleted and inserted instead.
+ *
+ * @fn NICollectionViewModelDiff::reloadedIndexPaths
+ */
+
+/**
+ * NO if the two arrays have the same sections and items.
+ *
+ * Footer titles are not compared; reload the collection view to show a changed footer.
+ *
+ * @fn NICollectionViewModelDiff::hasChanges
+ */
+
+/** @name Applying Diffs */
+
+/**
+ * Performs every change in one performBatchUpdates:completion: batch.
+ *
+ * The collection view's data source must already return the new contents.
+ *
+ * @fn NICollectionViewModelDiff::applyToCollectionView:completion:
+ * @param completion [optional] Called when the animations have finished, or right away if
+ *                        there are no changes.
+ */
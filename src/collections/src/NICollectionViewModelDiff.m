@@ -0,0 +1,141 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NICollectionViewModelDiff.h"
+
+#import "NICollectionViewModel.h"
+#import "NICollectionViewModel+Private.h"
+#import "NIModelDiff.h"
+#import "NimbusCore.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+@implementation NICollectionViewModelDiff {
+  NIModelDiff* _changes;
+}
+
++ (NICollectionViewModelDiff *)diffFromSectionedArray:(NSArray *)fromSectionedArray toSectionedArray:(NSArray *)toSectionedArray {
+  return [self diffFromSections:[self sectionsForSectionedArray:fromSectionedArray]
+                     toSections:[self sectionsForSectionedArray:toSectionedArray]];
+}
+
++ (NSArray *)sectionsForSectionedArray:(NSArray *)sectionedArray {
+  // Compiling the array only creates model objects, so this is safe off the main thread.
+  NICollectionViewModel* model = [[NICollectionViewModel alloc] initWithSectionedArray:sectionedArray delegate:nil];
+  return model.sections;
+}
+
++ (NICollectionViewModelDiff *)diffFromSections:(NSArray *)fromSections toSections:(NSArray *)toSections {
+  NICollectionViewModelDiff* diff = [[self alloc] init];
+  diff->_changes = [NIModelDiff diffFromSections:fromSections toSections:toSections];
+  return diff;
+}
+
+- (NSArray *)toSections {
+  return _changes.toSections;
+}
+
+- (NSArray *)fromSectionTitles {
+  return _changes.fromSectionTitles;
+}
+
+- (NSArray *)fromSectionRowCounts {
+  return _changes.fromSectionRowCounts;
+}
+
+- (NSIndexSet *)deletedSections {
+  return _changes.deletedSections;
+}
+
+- (NSIndexSet *)insertedSections {
+  return _changes.insertedSections;
+}
+
+- (NSArray *)movedFromSections {
+  return _changes.movedFromSections;
+}
+
+- (NSArray *)movedToSections {
+  return _changes.movedToSections;
+}
+
+- (NSArray *)deletedIndexPaths {
+  return _changes.deletedIndexPaths;
+}
+
+- (NSArray *)insertedIndexPaths {
+  return _changes.insertedIndexPaths;
+}
+
+- (NSArray *)movedFromIndexPaths {
+  return _changes.movedFromIndexPaths;
+}
+
+- (NSArray *)movedToIndexPaths {
+  return _changes.movedToIndexPaths;
+}
+
+- (NSArray *)reloadedIndexPaths {
+  return _changes.reloadedIndexPaths;
+}
+
+- (BOOL)hasChanges {
+  return _changes.hasChanges;
+}
+
+- (BOOL)isDiffFromSections:(NSArray *)sections {
+  return [_changes isDiffFromSections:sections];
+}
+
+- (void)applyToCollectionView:(UICollectionView *)collectionView completion:(void (^)(BOOL finished))completion {
+  if (!_changes.hasChanges) {
+    if (nil != completion) {
+      completion(YES);
+    }
+    return;
+  }
+
+  [collectionView performBatchUpdates:^{
+    if (_changes.deletedSections.count > 0) {
+      [collectionView deleteSections:_changes.deletedSections];
+    }
+    if (_changes.insertedSections.count > 0) {
+      [collectionView insertSections:_changes.insertedSections];
+    }
+    for (NSUInteger ix = 0; ix < _changes.movedFromSections.count; ++ix) {
+      [collectionView moveSection:[[_changes.movedFromSections objectAtIndex:ix] integerValue]
+                        toSection:[[_changes.movedToSections objectAtIndex:ix] integerValue]];
+    }
+    if (_changes.deletedIndexPaths.count > 0) {
+      [collectionView deleteItemsAtIndexPaths:_changes.deletedIndexPaths];
+    }
+    if (_changes.insertedIndexPaths.count > 0) {
+      [collectionView insertItemsAtIndexPaths:_changes.insertedIndexPaths];
+    }
+    for (NSUInteger ix = 0; ix < _changes.movedFromIndexPaths.count; ++ix) {
+      [collectionView moveItemAtIndexPath:[_changes.movedFromIndexPaths objectAtIndex:ix]
+                              toIndexPath:[_changes.movedToIndexPaths objectAtIndex:ix]];
+    }
+    if (_changes.reloadedIndexPaths.count > 0) {
+      [collectionView reloadItemsAtIndexPaths:_changes.reloadedIndexPaths];
+    }
+  } completion:completion];
+}
+
+@end
@@ -0,0 +1,58 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+#import "NICollectionViewModel.h"
+
+/**
+ * An immutable collection view model that may be created on any thread.
+ *
+ * Like NITableViewModelSnapshot, the snapshot keeps every item in one contiguous array with the
+ * offset of each section. Nothing about it changes once it is initialized and configured, so it
+ * can be built on a background queue and swapped in as the collection view's data source on the
+ * main thread:
+ *
+@code
+dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+  NICollectionViewModelSnapshot* model =
+      [[NICollectionViewModelSnapshot alloc] initWithSectionedArray:[self sectionedArrayForResponse:response]
+                                                           delegate:(id)[NICollectionViewCellFactory class]];
+  dispatch_async(dispatch_get_main_queue(), ^{
+    self.model = model;
+    self.collectionView.dataSource = model;
+    [self.collectionView reloadData];
+  });
+});
+@endcode
+ *
+ * Set the object index type before handing the snapshot to another thread.
+ *
+ * @ingroup CollectionViewModels
+ */
+@interface NICollectionViewModelSnapshot : NICollectionViewModel
+
+@property (nonatomic, readonly, assign) NSUInteger numberOfObjects;
+
+@end
+
+/**
+ * The number of items in all of the sections.
+ *
+ * @fn NICollectionViewModelSnapshot::numberOfObjects
+ */
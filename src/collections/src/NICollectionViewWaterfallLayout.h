@@ -0,0 +1,135 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+@class NICollectionViewCellFactory;
+@class NICollectionViewModel;
+
+/**
+ * A collection view layout that places items of varying heights in columns of equal width,
+ * each item going to the column that is currently shortest.
+ *
+ * Each item is as wide as a column and keeps the aspect ratio of the size that the cell
+ * factory returns for it, so cell classes size themselves with
+ * NICollectionViewCell::sizeForObject:atIndexPath:collectionView: exactly as they would for a
+ * flow layout. Items without a size are square.
+ *
+ * The attributes of every item are computed in one pass and published all at once, and are
+ * kept until the model, the collection view's width or the layout's configuration changes.
+ * When the only change is items appended to the last section, only the appended items are
+ * laid out; the attributes of the items before them are reused as they are.
+ *
+ * Use prepareLayoutForModel:completion: to build the attributes on a background queue before
+ * a new model is shown. Otherwise they are built in prepareLayout on the main thread.
+ *
+ * Headers, footers and decoration views are not laid out.
+ *
+ * @ingroup CollectionViewTools
+ */
+@interface NICollectionViewWaterfallLayout : UICollectionViewLayout
+
+@property (nonatomic, strong) NICollectionViewCellFactory* cellFactory;
+@property (nonatomic, strong) NICollectionViewModel* model;
+
+@property (nonatomic, assign) NSUInteger numberOfColumns;    // Default: 2
+@property (nonatomic, assign) CGFloat interitemSpacing;      // Default: 8
+@property (nonatomic, assign) CGFloat lineSpacing;           // Default: 8
+@property (nonatomic, assign) UIEdgeInsets sectionInset;     // Default: UIEdgeInsetsZero
+
+- (void)prepareLayoutForModel:(NICollectionViewModel *)model completion:(void (^)(void))completion;
+- (void)invalidateItemAttributes;
+
+@end
+
+/** @name Configuring the Layout */
+
+/**
+ * The cell factory that sizes the items.
+ *
+ * The factory's size cache is used, so an unchanged item is only sized once. When the factory
+ * is nil, every item is square.
+ *
+ * @fn NICollectionViewWaterfallLayout::cellFactory
+ */
+
+/**
+ * The model whose items are laid out.
+ *
+ * This must be the collection view's data source. Setting a new model does not drop the
+ * current attributes, so that a model with items appended only lays out the new items.
+ *
+ * @fn NICollectionViewWaterfallLayout::model
+ */
+
+/**
+ * The number of columns in each section.
+ *
+ * @fn NICollectionViewWaterfallLayout::numberOfColumns
+ */
+
+/**
+ * The horizontal space between columns.
+ *
+ * @fn NICollectionViewWaterfallLayout::interitemSpacing
+ */
+
+/**
+ * The vertical space between the items of a column.
+ *
+ * @fn NICollectionViewWaterfallLayout::lineSpacing
+ */
+
+/**
+ * The margins around the columns of each section.
+ *
+ * @fn NICollectionViewWaterfallLayout::sectionInset
+ */
+
+/** @name Building Attributes Ahead of Time */
+
+/**
+ * Builds the attributes for a model that is about to be shown.
+ *
+ * The items are sized on the main thread with the cell factory, whose cache makes this a lookup
+ * for every item that has been sized before. Their frames and attributes are then computed on a
+ * background queue from the sizes alone, so the model is not read off of the main thread. When
+ * the model's items start with the items of the current model and only the last section grew,
+ * only the new items are sized and laid out.
+ *
+ * The completion block is called on the main thread once the attributes are ready. Set the
+ * model as both the layout's model and the collection view's data source there and reload the
+ * collection view; prepareLayout then publishes the attributes without computing anything.
+ * If prepareLayoutForModel:completion: is called again before the attributes are ready, the
+ * earlier completion block is never called.
+ *
+ * Must be called from the main thread.
+ *
+ * @param model       The model that will be shown.
+ * @param completion  Called on the main thread when the attributes are ready. May be nil.
+ * @fn NICollectionViewWaterfallLayout::prepareLayoutForModel:completion:
+ */
+
+/**
+ * Drops the attributes of every item so that they are all computed again.
+ *
+ * Call this after calling NICollectionViewCellFactory::invalidateItemSizeForObject: for an
+ * object whose size changed.
+ *
+ * @fn NICollectionViewWaterfallLayout::invalidateItemAttributes
+ */
@@ -0,0 +1,411 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NICollectionViewWaterfallLayout.h"
+
+#import "NICollectionViewCellFactory.h"
+#import "NICollectionViewModel+Private.h"
+#import "NimbusCore.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// Everything about the layout that the frames depend on, copied so that it can be read on the
+// layout queue.
+typedef struct {
+  NSUInteger numberOfColumns;
+  CGFloat width;
+  CGFloat interitemSpacing;
+  CGFloat lineSpacing;
+  UIEdgeInsets sectionInset;
+} NIWaterfallLayoutGeometry;
+
+// One complete, immutable layout of a model. Published layouts are replaced, never modified.
+@interface NICollectionViewWaterfallLayoutResult : NSObject
+@property (nonatomic, weak) NICollectionViewModel* model;
+@property (nonatomic, assign) NSUInteger mutationCount;
+@property (nonatomic, assign) CGFloat width;
+@property (nonatomic, copy) NSArray* sectionObjects;    // Array of arrays of the laid out objects
+@property (nonatomic, copy) NSArray* sectionAttributes; // Array of arrays of UICollectionViewLayoutAttributes
+@property (nonatomic, copy) NSArray* columnHeights;     // The bottoms of the last section's columns
+@property (nonatomic, assign) CGFloat contentHeight;
+@end
+
+@implementation NICollectionViewWaterfallLayoutResult
+@end
+
+static dispatch_queue_t NICollectionViewWaterfallLayoutQueue(void) {
+  static dispatch_queue_t sQueue = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sQueue = dispatch_queue_create("com.nimbuskit.collections.waterfalllayout", DISPATCH_QUEUE_SERIAL);
+  });
+  return sQueue;
+}
+
+/**
+ * Lays out items of the given sizes.
+ *
+ * Without a base result, sectionSizes holds the sizes of every item in every section. With one,
+ * it holds only the sizes of the items appended to the base's last section, and the base's
+ * attributes are reused for every other item. Only reads its arguments, so it may be called on
+ * any thread.
+ */
+static NICollectionViewWaterfallLayoutResult* NIWaterfallLayoutResult(NSArray* sectionObjects,
+                                                                      NSArray* sectionSizes,
+                                                                      NICollectionViewWaterfallLayoutResult* baseResult,
+                                                                      NIWaterfallLayoutGeometry geometry) {
+  NSUInteger numberOfColumns = MAX(1, geometry.numberOfColumns);
+  UIEdgeInsets inset = geometry.sectionInset;
+  CGFloat columnWidth = MAX(0, (geometry.width - inset.left - inset.right
+                                - (numberOfColumns - 1) * geometry.interitemSpacing) / numberOfColumns);
+
+  CGFloat* columnHeights = calloc(numberOfColumns, sizeof(CGFloat));
+  NSMutableArray* sectionAttributes = nil;
+  NSUInteger firstSection = 0;
+  CGFloat contentHeight = 0;
+  if (nil != baseResult && baseResult.sectionAttributes.count > 0) {
+    sectionAttributes = [baseResult.sectionAttributes mutableCopy];
+    firstSection = sectionAttributes.count - 1;
+    [sectionAttributes replaceObjectAtIndex:firstSection
+                                 withObject:[[sectionAttributes objectAtIndex:firstSection] mutableCopy]];
+    for (NSUInteger column = 0; column < numberOfColumns && column < baseResult.columnHeights.count; ++column) {
+      columnHeights[column] = [[baseResult.columnHeights objectAtIndex:column] doubleValue];
+    }
+  } else {
+    baseResult = nil;
+    sectionAttributes = [NSMutableArray arrayWithCapacity:sectionObjects.count];
+  }
+
+  for (NSUInteger section = firstSection; section < sectionObjects.count; ++section) {
+    BOOL isBaseSection = (nil != baseResult && section == firstSection);
+    NSArray* sizes = (nil != baseResult) ? [sectionSizes firstObject] : [sectionSizes objectAtIndex:section];
+    NSMutableArray* attributes = nil;
+    if (isBaseSection) {
+      attributes = [sectionAttributes objectAtIndex:section];
+    } else {
+      attributes = [NSMutableArray arrayWithCapacity:sizes.count];
+      [sectionAttributes addObject:attributes];
+      for (NSUInteger column = 0; column < numberOfColumns; ++column) {
+        columnHeights[column] = contentHeight + inset.top;
+      }
+    }
+
+    NSUInteger firstItem = attributes.count;
+    for (NSUInteger ix = 0; ix < sizes.count; ++ix) {
+      NSUInteger shortestColumn = 0;
+      for (NSUInteger column = 1; column < numberOfColumns; ++column) {
+        if (columnHeights[column] < columnHeights[shortestColumn]) {
+          shortestColumn = column;
+        }
+      }
+
+      CGSize size = [[sizes objectAtIndex:ix] CGSizeValue];
+      CGFloat height = ((size.width > 0 && size.height > 0)
+                        ? NICGFloatRound(size.height * columnWidth / size.width)
+                        : columnWidth);
+
+      NSIndexPath* indexPath = [NSIndexPath indexPathForItem:firstItem + ix inSection:section];
+      UICollectionViewLayoutAttributes* itemAttributes =
+          [UICollectionViewLayoutAttributes layoutAttributesForCellWithIndexPath:indexPath];
+      itemAttributes.frame = CGRectMake(inset.left + shortestColumn * (columnWidth + geometry.interitemSpacing),
+                                        columnHeights[shortestColumn],
+                                        columnWidth, height);
+      [attributes addObject:itemAttributes];
+
+      columnHeights[shortestColumn] += height + geometry.lineSpacing;
+    }
+
+    CGFloat sectionBottom = columnHeights[0];
+    for (NSUInteger column = 1; column < numberOfColumns; ++column) {
+      sectionBottom = MAX(sectionBottom, columnHeights[column]);
+    }
+    if (attributes.count > 0) {
+      // There is no line after the last item of a column.
+      sectionBottom -= geometry.lineSpacing;
+    }
+    contentHeight = sectionBottom + inset.bottom;
+  }
+
+  NSMutableArray* lastColumnHeights = [NSMutableArray arrayWithCapacity:numberOfColumns];
+  for (NSUInteger column = 0; column < numberOfColumns; ++column) {
+    [lastColumnHeights addObject:@(columnHeights[column])];
+  }
+  free(columnHeights);
+
+  NICollectionViewWaterfallLayoutResult* result = [[NICollectionViewWaterfallLayoutResult alloc] init];
+  result.width = geometry.width;
+  result.sectionObjects = sectionObjects;
+  result.sectionAttributes = sectionAttributes;
+  result.columnHeights = lastColumnHeights;
+  result.contentHeight = contentHeight;
+  return result;
+}
+
+@implementation NICollectionViewWaterfallLayout {
+  NICollectionViewWaterfallLayoutResult* _result;
+  NICollectionViewWaterfallLayoutResult* _pendingResult;
+  // Incremented to drop the results of background layouts that have been superseded.
+  NSUInteger _generation;
+}
+
+- (id)init {
+  if ((self = [super init])) {
+    _numberOfColumns = 2;
+    _interitemSpacing = 8;
+    _lineSpacing = 8;
+    _sectionInset = UIEdgeInsetsZero;
+  }
+  return self;
+}
+
+#pragma mark - Configuration
+
+- (void)setModel:(NICollectionViewModel *)model {
+  if (_model != model) {
+    _model = model;
+    [self invalidateLayout];
+  }
+}
+
+- (void)setNumberOfColumns:(NSUInteger)numberOfColumns {
+  if (_numberOfColumns != numberOfColumns) {
+    _numberOfColumns = numberOfColumns;
+    [self invalidateItemAttributes];
+  }
+}
+
+- (void)setInteritemSpacing:(CGFloat)interitemSpacing {
+  if (_interitemSpacing != interitemSpacing) {
+    _interitemSpacing = interitemSpacing;
+    [self invalidateItemAttributes];
+  }
+}
+
+- (void)setLineSpacing:(CGFloat)lineSpacing {
+  if (_lineSpacing != lineSpacing) {
+    _lineSpacing = lineSpacing;
+    [self invalidateItemAttributes];
+  }
+}
+
+- (void)setSectionInset:(UIEdgeInsets)sectionInset {
+  if (!UIEdgeInsetsEqualToEdgeInsets(_sectionInset, sectionInset)) {
+    _sectionInset = sectionInset;
+    [self invalidateItemAttributes];
+  }
+}
+
+- (void)invalidateItemAttributes {
+  _result = nil;
+  _pendingResult = nil;
+  ++_generation;
+  [self invalidateLayout];
+}
+
+#pragma mark - Building Results
+
+- (NIWaterfallLayoutGeometry)geometryWithWidth:(CGFloat)width {
+  NIWaterfallLayoutGeometry geometry = {
+    .numberOfColumns = self.numberOfColumns,
+    .width = width,
+    .interitemSpacing = self.interitemSpacing,
+    .lineSpacing = self.lineSpacing,
+    .sectionInset = self.sectionInset,
+  };
+  return geometry;
+}
+
+- (BOOL)isResult:(NICollectionViewWaterfallLayoutResult *)result currentForModel:(NICollectionViewModel *)model width:(CGFloat)width {
+  return (nil != result && nil != model && result.model == model
+          && result.mutationCount == model.mutationCount && result.width == width);
+}
+
+// Copies the model's objects so that the result can be checked against later models. The objects
+// are read through the data source methods because snapshots don't keep them in their sections.
+- (NSArray *)sectionObjectsOfModel:(NICollectionViewModel *)model {
+  NSInteger numberOfSections = [model numberOfSectionsInCollectionView:self.collectionView];
+  NSMutableArray* sectionObjects = [NSMutableArray arrayWithCapacity:(NSUInteger)MAX(0, numberOfSections)];
+  for (NSInteger section = 0; section < numberOfSections; ++section) {
+    NSInteger numberOfItems = [model collectionView:self.collectionView numberOfItemsInSection:section];
+    NSMutableArray* objects = [NSMutableArray arrayWithCapacity:(NSUInteger)MAX(0, numberOfItems)];
+    for (NSInteger item = 0; item < numberOfItems; ++item) {
+      id object = [model objectAtIndexPath:[NSIndexPath indexPathForItem:item inSection:section]];
+      if (nil != object) {
+        [objects addObject:object];
+      }
+    }
+    [sectionObjects addObject:objects];
+  }
+  return sectionObjects;
+}
+
+// Returns the result if the given objects only add items to the end of its last section.
+- (NICollectionViewWaterfallLayoutResult *)baseResult:(NICollectionViewWaterfallLayoutResult *)result
+                                    forSectionObjects:(NSArray *)sectionObjects
+                                                width:(CGFloat)width {
+  NSArray* laidOutSectionObjects = result.sectionObjects;
+  if (nil == result || result.width != width || 0 == sectionObjects.count
+      || laidOutSectionObjects.count != sectionObjects.count) {
+    return nil;
+  }
+  NSUInteger lastSection = sectionObjects.count - 1;
+  for (NSUInteger section = 0; section < sectionObjects.count; ++section) {
+    NSArray* laidOutObjects = [laidOutSectionObjects objectAtIndex:section];
+    NSArray* objects = [sectionObjects objectAtIndex:section];
+    if (section < lastSection ? objects.count != laidOutObjects.count : objects.count < laidOutObjects.count) {
+      return nil;
+    }
+    // Pointer comparisons are far cheaper than sizing and laying out the items again.
+    for (NSUInteger ix = 0; ix < laidOutObjects.count; ++ix) {
+      if ([objects objectAtIndex:ix] != [laidOutObjects objectAtIndex:ix]) {
+        return nil;
+      }
+    }
+  }
+  return result;
+}
+
+- (NSArray *)sizesOfItemsInSection:(NSUInteger)section
+                         fromIndex:(NSUInteger)firstItem
+                     sectionObjects:(NSArray *)sectionObjects
+                             model:(NICollectionViewModel *)model {
+  NSUInteger numberOfItems = [[sectionObjects objectAtIndex:section] count];
+  NSMutableArray* sizes = [NSMutableArray arrayWithCapacity:numberOfItems - firstItem];
+  for (NSUInteger item = firstItem; item < numberOfItems; ++item) {
+    CGSize size = CGSizeZero;
+    if (nil != self.cellFactory) {
+      NSIndexPath* indexPath = [NSIndexPath indexPathForItem:item inSection:section];
+      size = [self.cellFactory collectionView:self.collectionView layout:self sizeForItemAtIndexPath:indexPath model:model];
+    }
+    [sizes addObject:[NSValue valueWithCGSize:size]];
+  }
+  return sizes;
+}
+
+// Everything that reads the model or asks for sizes happens here, on the main thread. The
+// returned block only does arithmetic on copies and may run anywhere.
+- (NICollectionViewWaterfallLayoutResult* (^)(void))resultBlockForModel:(NICollectionViewModel *)model width:(CGFloat)width {
+  NSArray* sectionObjects = [self sectionObjectsOfModel:model];
+  NICollectionViewWaterfallLayoutResult* baseResult = [self baseResult:_result forSectionObjects:sectionObjects width:width];
+
+  NSMutableArray* sectionSizes = [NSMutableArray array];
+  if (nil != baseResult) {
+    NSUInteger lastSection = sectionObjects.count - 1;
+    NSUInteger numberOfLaidOutItems = [[baseResult.sectionObjects objectAtIndex:lastSection] count];
+    [sectionSizes addObject:[self sizesOfItemsInSection:lastSection
+                                              fromIndex:numberOfLaidOutItems
+                                         sectionObjects:sectionObjects
+                                                  model:model]];
+  } else {
+    for (NSUInteger section = 0; section < sectionObjects.count; ++section) {
+      [sectionSizes addObject:[self sizesOfItemsInSection:section fromIndex:0 sectionObjects:sectionObjects model:model]];
+    }
+  }
+
+  NIWaterfallLayoutGeometry geometry = [self geometryWithWidth:width];
+  NSUInteger mutationCount = model.mutationCount;
+  return ^NICollectionViewWaterfallLayoutResult *{
+    NICollectionViewWaterfallLayoutResult* result = NIWaterfallLayoutResult(sectionObjects, sectionSizes, baseResult, geometry);
+    result.model = model;
+    result.mutationCount = mutationCount;
+    return result;
+  };
+}
+
+- (void)prepareLayoutForModel:(NICollectionViewModel *)model completion:(void (^)(void))completion {
+  NIDASSERT([NSThread isMainThread]);
+  CGFloat width = CGRectGetWidth(self.collectionView.bounds);
+  NICollectionViewWaterfallLayoutResult* (^resultBlock)(void) = [self resultBlockForModel:model width:width];
+
+  NSUInteger generation = ++_generation;
+  __weak NICollectionViewWaterfallLayout* weakSelf = self;
+  dispatch_async(NICollectionViewWaterfallLayoutQueue(), ^{
+    NICollectionViewWaterfallLayoutResult* result = resultBlock();
+    dispatch_async(dispatch_get_main_queue(), ^{
+      NICollectionViewWaterfallLayout* strongSelf = weakSelf;
+      if (nil == strongSelf || strongSelf->_generation != generation) {
+        return;
+      }
+      strongSelf->_pendingResult = result;
+      if (nil != completion) {
+        completion();
+      }
+    });
+  });
+}
+
+#pragma mark - UICollectionViewLayout
+
+- (void)prepareLayout {
+  [super prepareLayout];
+
+  NICollectionViewModel* model = self.model;
+  CGFloat width = CGRectGetWidth(self.collectionView.bounds);
+  if ([self isResult:_result currentForModel:model width:width]) {
+    return;
+  }
+
+  // Swapping in a finished result is a single assignment.
+  if ([self isResult:_pendingResult currentForModel:model width:width]) {
+    _result = _pendingResult;
+    _pendingResult = nil;
+    return;
+  }
+
+  if (nil == model) {
+    _result = nil;
+    return;
+  }
+  _result = [self resultBlockForModel:model width:width]();
+}
+
+- (CGSize)collectionViewContentSize {
+  return CGSizeMake(CGRectGetWidth(self.collectionView.bounds), _result.contentHeight);
+}
+
+- (NSArray *)layoutAttributesForElementsInRect:(CGRect)rect {
+  NSMutableArray* attributesInRect = [NSMutableArray array];
+  for (NSArray* attributes in _result.sectionAttributes) {
+    for (UICollectionViewLayoutAttributes* itemAttributes in attributes) {
+      if (CGRectIntersectsRect(itemAttributes.frame, rect)) {
+        [attributesInRect addObject:itemAttributes];
+      }
+    }
+  }
+  return attributesInRect;
+}
+
+- (UICollectionViewLayoutAttributes *)layoutAttributesForItemAtIndexPath:(NSIndexPath *)indexPath {
+  NSArray* sectionAttributes = _result.sectionAttributes;
+  if ((NSUInteger)indexPath.section >= sectionAttributes.count) {
+    return nil;
+  }
+  NSArray* attributes = [sectionAttributes objectAtIndex:indexPath.section];
+  if ((NSUInteger)indexPath.item >= attributes.count) {
+    return nil;
+  }
+  return [attributes objectAtIndex:indexPath.item];
+}
+
+- (BOOL)shouldInvalidateLayoutForBoundsChange:(CGRect)newBounds {
+  // Scrolling changes the bounds' origin, which never changes the layout.
+  return CGRectGetWidth(newBounds) != CGRectGetWidth(self.collectionView.bounds);
+}
+
+@end
@@ -16,6 +16,8 @@
 
 #import "NICollectionViewModel.h"
 
+@class NICollectionViewModelDiff;
+
 /**
  * The NIMutableCollectionViewModel class is a mutable collection view model.
  *
@@ -56,6 +58,11 @@
 - (NSIndexSet *)insertSectionWithTitle:(NSString *)title atIndex:(NSUInteger)index;
 - (NSIndexSet *)removeSectionAtIndex:(NSUInteger)index;
 
+- (NICollectionViewModelDiff *)setSectionedArray:(NSArray *)sectionedArray diffingWithCollectionView:(UICollectionView *)collectionView;
+- (void)applyDiff:(NICollectionViewModelDiff *)diff withCollectionView:(UICollectionView *)collectionView;
+
+- (NICollectionViewModelDiff *)performBatchUpdates:(void (^)(NIMutableCollectionViewModel* model))updates;
+
 @end
 
 /** @name Modifying Objects */
@@ -144,6 +151,67 @@
  * @fn NIMutableCollectionViewModel::removeSectionAtIndex:
  */
 
+/** @name Replacing the Contents */
+
+/**
+ * Replaces the model's contents and animates the difference in the collection view.
+ *
+ * Items that are in both the old and the new contents keep their cells and the collection view
+ * keeps its scroll position. All of the changes are applied in a single batch update.
+ *
+ * @param sectionedArray The new contents, in the format of
+ *                            NICollectionViewModel::initWithSectionedArray:delegate:.
+ * @param collectionView The collection view that displays this model.
+ * @returns The changes that were applied to the collection view.
+ * @fn NIMutableCollectionViewModel::setSectionedArray:diffingWithCollectionView:
+ * @sa NICollectionViewModelDiff
+ */
+
+/**
+ * Replaces the model's contents with the new contents of a diff and applies the diff to the
+ * collection view.
+ *
+ * Use this to compute the diff of a very large model off the main thread:
+ *
+@code
+dispatch_async(queue, ^{
+  NICollectionViewModelDiff* diff = [NICollectionViewModelDiff diffFromSectionedArray:oldContents
+                                                                     toSectionedArray:newContents];
+  dispatch_async(dispatch_get_main_queue(), ^{
+    [model applyDiff:diff withCollectionView:collectionView];
+  });
+});
+@endcode
+ *
+ * The diff must start from the model's current contents. If the model has changed since, the new
+ * contents are still adopted but the collection view is reloaded instead.
+ *
+ * @fn NIMutableCollectionViewModel::applyDiff:withCollectionView:
+ */
+
+/** @name Batching Modifications */
+
+/**
+ * Performs many modifications as one and returns their combined effect.
+ *
+ * The object index is brought up to date once, after the block returns, instead of after each
+ * modification. The index paths returned by the individual methods within the block are only
+ * valid at the time of the call and may be ignored. Instead, apply the returned diff to the
+ * collection view:
+ *
+@code
+NICollectionViewModelDiff* diff = [self.model performBatchUpdates:^(NIMutableCollectionViewModel* model) {
+  [model addObjectsFromArray:page];
+}];
+[diff applyToCollectionView:self.collectionView completion:nil];
+@endcode
+ *
+ * Batches may be nested. Only the outermost batch returns a diff; the inner ones return nil and
+ * their changes are included in the outer diff.
+ *
+ * @fn NIMutableCollectionViewModel::performBatchUpdates:
+ */
+
 /** @name Updating the Section Index */
 
 /**
@@ -27,6 +27,11 @@
 #endif
 
 
+@interface NIMutableCollectionViewModel ()
+@property (nonatomic, assign) NSInteger batchUpdateDepth;
+@end
+
+
 @implementation NIMutableCollectionViewModel
 
 
@@ -36,16 +41,22 @@
 - (NSArray *)addObject:(id)object {
   NICollectionViewModelSection* section = self.sections.count == 0 ? [self _appendSection] : self.sections.lastObject;
   [section.mutableRows addObject:object];
-  return [NSArray arrayWithObject:[NSIndexPath indexPathForRow:section.mutableRows.count - 1
-                                                     inSection:self.sections.count - 1]];
+  NSIndexPath* indexPath = [NSIndexPath indexPathForRow:section.mutableRows.count - 1
+                                              inSection:self.sections.count - 1];
+  [self _indexObject:object atIndexPath:indexPath];
+  ++self.mutationCount;
+  return [NSArray arrayWithObject:indexPath];
 }
 
 - (NSArray *)addObject:(id)object toSection:(NSUInteger)sectionIndex {
   NIDASSERT(sectionIndex >= 0 && sectionIndex < self.sections.count);
   NICollectionViewModelSection *section = [self.sections objectAtIndex:sectionIndex];
   [section.mutableRows addObject:object];
-  return [NSArray arrayWithObject:[NSIndexPath indexPathForRow:section.mutableRows.count - 1
-                                                     inSection:sectionIndex]];
+  NSIndexPath* indexPath = [NSIndexPath indexPathForRow:section.mutableRows.count - 1
+                                              inSection:sectionIndex];
+  [self _indexObject:object atIndexPath:indexPath];
+  ++self.mutationCount;
+  return [NSArray arrayWithObject:indexPath];
 }
 
 - (NSArray *)addObjectsFromArray:(NSArray *)array {
@@ -60,7 +71,11 @@
   NIDASSERT(sectionIndex >= 0 && sectionIndex < self.sections.count);
   NICollectionViewModelSection *section = [self.sections objectAtIndex:sectionIndex];
   [section.mutableRows insertObject:object atIndex:row];
-  return [NSArray arrayWithObject:[NSIndexPath indexPathForRow:row inSection:sectionIndex]];
+  [self _offsetIndexedRowsInSection:sectionIndex fromRow:row + 1 sectionDelta:0 rowDelta:1];
+  NSIndexPath* indexPath = [NSIndexPath indexPathForRow:row inSection:sectionIndex];
+  [self _indexObject:object atIndexPath:indexPath];
+  ++self.mutationCount;
+  return [NSArray arrayWithObject:indexPath];
 }
 
 - (NSArray *)removeObjectAtIndexPath:(NSIndexPath *)indexPath {
@@ -73,28 +88,100 @@
   if (indexPath.row >= (NSInteger)section.mutableRows.count) {
     return nil;
   }
+  id object = [section.mutableRows objectAtIndex:indexPath.row];
+  [self _unindexObject:object atIndexPath:indexPath];
   [section.mutableRows removeObjectAtIndex:indexPath.row];
+  [self _offsetIndexedRowsInSection:indexPath.section fromRow:indexPath.row sectionDelta:0 rowDelta:-1];
+  [self _reindexObjects:[NSArray arrayWithObject:object]];
+  ++self.mutationCount;
   return [NSArray arrayWithObject:indexPath];
 }
 
 - (NSIndexSet *)addSectionWithTitle:(NSString *)title {
   NICollectionViewModelSection* section = [self _appendSection];
   section.headerTitle = title;
+  ++self.mutationCount;
   return [NSIndexSet indexSetWithIndex:self.sections.count - 1];
 }
 
 - (NSIndexSet *)insertSectionWithTitle:(NSString *)title atIndex:(NSUInteger)index {
   NICollectionViewModelSection* section = [self _insertSectionAtIndex:index];
   section.headerTitle = title;
+  [self _offsetIndexedSectionsFromSection:index + 1 by:1];
+  ++self.mutationCount;
   return [NSIndexSet indexSetWithIndex:index];
 }
 
 - (NSIndexSet *)removeSectionAtIndex:(NSUInteger)index {
   NIDASSERT(index >= 0 && index < self.sections.count);
+  NSArray* rows = [[self.sections objectAtIndex:index] rows];
+  [rows enumerateObjectsUsingBlock:^(id object, NSUInteger rowIndex, BOOL *stop) {
+    [self _unindexObject:object atIndexPath:[NSIndexPath indexPathForRow:rowIndex inSection:index]];
+  }];
   [self.sections removeObjectAtIndex:index];
+  [self _offsetIndexedSectionsFromSection:index by:-1];
+  [self _reindexObjects:rows];
+  ++self.mutationCount;
   return [NSIndexSet indexSetWithIndex:index];
 }
 
+- (NICollectionViewModelDiff *)setSectionedArray:(NSArray *)sectionedArray diffingWithCollectionView:(UICollectionView *)collectionView {
+  NICollectionViewModelDiff* diff = [NICollectionViewModelDiff diffFromSections:self.sections
+                                                                     toSections:[NICollectionViewModelDiff sectionsForSectionedArray:sectionedArray]];
+  [self applyDiff:diff withCollectionView:collectionView];
+  return diff;
+}
+
+- (void)applyDiff:(NICollectionViewModelDiff *)diff withCollectionView:(UICollectionView *)collectionView {
+  BOOL isDiffFromContents = [diff isDiffFromSections:self.sections];
+
+  // A diff may be applied to more than one model, so each gets its own mutable sections.
+  NSMutableArray* sections = [NSMutableArray arrayWithCapacity:diff.toSections.count];
+  for (NICollectionViewModelSection* diffSection in diff.toSections) {
+    NICollectionViewModelSection* section = [NICollectionViewModelSection section];
+    section.headerTitle = diffSection.headerTitle;
+    section.footerTitle = diffSection.footerTitle;
+    section.rows = (nil != diffSection.rows) ? [diffSection.rows mutableCopy] : [NSMutableArray array];
+    [sections addObject:section];
+  }
+  self.sections = sections;
+  [self _rebuildObjectIndex];
+  ++self.mutationCount;
+
+  if (isDiffFromContents) {
+    [diff applyToCollectionView:collectionView completion:nil];
+  } else {
+    [collectionView reloadData];
+  }
+}
+
+- (NICollectionViewModelDiff *)performBatchUpdates:(void (^)(NIMutableCollectionViewModel* model))updates {
+  if (self.batchUpdateDepth > 0) {
+    ++self.batchUpdateDepth;
+    updates(self);
+    --self.batchUpdateDepth;
+    return nil;
+  }
+
+  // The items are modified in place, so the diff needs a copy of what they were.
+  NSMutableArray* fromSections = [NSMutableArray arrayWithCapacity:self.sections.count];
+  for (NICollectionViewModelSection* section in self.sections) {
+    NICollectionViewModelSection* fromSection = [NICollectionViewModelSection section];
+    fromSection.headerTitle = section.headerTitle;
+    fromSection.rows = [section.rows copy];
+    [fromSections addObject:fromSection];
+  }
+
+  // Without an object index the modifications skip keeping it up to date; it is rebuilt once below.
+  self.objectIndex = nil;
+  self.batchUpdateDepth = 1;
+  updates(self);
+  self.batchUpdateDepth = 0;
+
+  [self _rebuildObjectIndex];
+  return [NICollectionViewModelDiff diffFromSections:fromSections toSections:self.sections];
+}
+
 #pragma mark - Private
 
 
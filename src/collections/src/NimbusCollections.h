@@ -55,6 +55,9 @@
 #import "NICollectionViewActions.h"
 #import "NICollectionViewCellFactory.h"
 #import "NICollectionViewModel.h"
+#import "NICollectionViewModelDiff.h"
 #import "NIMutableCollectionViewModel.h"
+#import "NICollectionViewModelSnapshot.h"
+#import "NICollectionViewWaterfallLayout.h"
 
 /**@}*/
@@ -0,0 +1,122 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NimbusCore.h"
+#import "NimbusCollections.h"
+
+static NSUInteger sNumberOfSizedHeaders = 0;
+
+@interface NICellFactoryTestHeaderView : UICollectionReusableView <NICollectionViewSupplementaryView>
+@property (nonatomic, copy) NSString* title;
+@end
+
+@implementation NICellFactoryTestHeaderView
+
+- (BOOL)shouldUpdateViewWithObject:(id)object {
+  self.title = object;
+  return YES;
+}
+
++ (CGSize)sizeForObject:(id)object ofKind:(NSString *)kind inSection:(NSInteger)section collectionView:(UICollectionView *)collectionView {
+  ++sNumberOfSizedHeaders;
+  return CGSizeMake(CGRectGetWidth(collectionView.bounds), 20 + [(NSString *)object length]);
+}
+
+@end
+
+@interface NICellFactoryTestCell : UICollectionViewCell <NICollectionViewCell>
+@end
+
+@implementation NICellFactoryTestCell
+
+- (BOOL)shouldUpdateCellWithObject:(id)object {
+  return YES;
+}
+
+@end
+
+@interface NICollectionViewCellFactoryTests : XCTestCase
+@end
+
+
+@implementation NICollectionViewCellFactoryTests
+
+
+- (void)testHeaderSizesAreCachedUntilTheModelChanges {
+  NICollectionViewCellFactory* cellFactory = [[NICollectionViewCellFactory alloc] init];
+  [cellFactory mapSupplementaryElementOfKind:UICollectionElementKindSectionHeader
+                                 toViewClass:[NICellFactoryTestHeaderView class]];
+  NIMutableCollectionViewModel* model =
+      [[NIMutableCollectionViewModel alloc] initWithSectionedArray:@[@"A", @1, @"Bbb", @2] delegate:cellFactory];
+  UICollectionViewFlowLayout* layout = [[UICollectionViewFlowLayout alloc] init];
+  layout.footerReferenceSize = CGSizeMake(320, 5);
+  UICollectionView* collectionView = [[UICollectionView alloc] initWithFrame:CGRectMake(0, 0, 320, 480)
+                                                        collectionViewLayout:layout];
+
+  sNumberOfSizedHeaders = 0;
+  CGSize size = [cellFactory collectionView:collectionView layout:layout referenceSizeForHeaderInSection:1 model:model];
+  XCTAssertTrue(CGSizeEqualToSize(size, CGSizeMake(320, 23)), @"The view class should size the header for its title.");
+  size = [cellFactory collectionView:collectionView layout:layout referenceSizeForHeaderInSection:1 model:model];
+  XCTAssertTrue(CGSizeEqualToSize(size, CGSizeMake(320, 23)));
+  XCTAssertEqual(sNumberOfSizedHeaders, (NSUInteger)1, @"The size should have been cached.");
+
+  size = [cellFactory collectionView:collectionView layout:layout referenceSizeForHeaderInSection:0 model:model];
+  XCTAssertTrue(CGSizeEqualToSize(size, CGSizeMake(320, 21)), @"Each section should be sized for its own title.");
+
+  size = [cellFactory collectionView:collectionView layout:layout referenceSizeForFooterInSection:0 model:model];
+  XCTAssertTrue(CGSizeEqualToSize(size, CGSizeMake(320, 5)),
+                @"Unmapped kinds should use the flow layout's reference size.");
+
+  sNumberOfSizedHeaders = 0;
+  [model addObject:@3 toSection:1];
+  [cellFactory collectionView:collectionView layout:layout referenceSizeForHeaderInSection:1 model:model];
+  XCTAssertEqual(sNumberOfSizedHeaders, (NSUInteger)1, @"Modifying the model should drop the cached sizes.");
+}
+
+- (void)testMappedHeadersAreGivenTheirSectionTitles {
+  NICollectionViewCellFactory* cellFactory = [[NICollectionViewCellFactory alloc] init];
+  [cellFactory mapSupplementaryElementOfKind:UICollectionElementKindSectionHeader
+                                 toViewClass:[NICellFactoryTestHeaderView class]];
+  NICollectionViewModel* model =
+      [[NICollectionViewModel alloc] initWithSectionedArray:@[@"Fruits",
+                                                              [NICollectionViewCellObject objectWithCellClass:[NICellFactoryTestCell class]]]
+                                                   delegate:cellFactory];
+  UICollectionViewFlowLayout* layout = [[UICollectionViewFlowLayout alloc] init];
+  layout.itemSize = CGSizeMake(100, 100);
+  layout.headerReferenceSize = CGSizeMake(320, 30);
+  UIWindow* window = [[UIWindow alloc] initWithFrame:CGRectMake(0, 0, 320, 480)];
+  UICollectionView* collectionView = [[UICollectionView alloc] initWithFrame:window.bounds
+                                                        collectionViewLayout:layout];
+  collectionView.dataSource = model;
+  [window addSubview:collectionView];
+  [collectionView layoutIfNeeded];
+
+  NICellFactoryTestHeaderView* headerView = nil;
+  for (UIView* view in collectionView.subviews) {
+    if ([view isKindOfClass:[NICellFactoryTestHeaderView class]]) {
+      headerView = (NICellFactoryTestHeaderView *)view;
+    }
+  }
+  XCTAssertNotNil(headerView, @"The factory should have created the mapped header view.");
+  XCTAssertEqualObjects(headerView.title, @"Fruits", @"The header should be given its section's title.");
+}
+
+@end
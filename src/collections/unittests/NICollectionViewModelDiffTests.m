@@ -0,0 +1,100 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NimbusCore.h"
+#import "NimbusCollections.h"
+
+static NSIndexPath* NIItem(NSInteger item, NSInteger section) {
+  return [NSIndexPath indexPathForItem:item inSection:section];
+}
+
+@interface NICollectionViewModelDiffTests : XCTestCase
+@end
+
+
+@implementation NICollectionViewModelDiffTests
+
+
+- (void)testIdenticalContentsHaveNoChanges {
+  NSArray* contents = @[@"Section", @1, @2, @3];
+  NICollectionViewModelDiff* diff = [NICollectionViewModelDiff diffFromSectionedArray:contents
+                                                                     toSectionedArray:[contents copy]];
+  XCTAssertFalse(diff.hasChanges, @"The same contents should not change anything.");
+}
+
+- (void)testItemChangesWithinASection {
+  NICollectionViewModelDiff* diff = [NICollectionViewModelDiff diffFromSectionedArray:@[@1, @2, @3, @4]
+                                                                     toSectionedArray:@[@2, @1, @4, @5]];
+  XCTAssertEqualObjects(diff.deletedIndexPaths, @[NIItem(2, 0)], @"The 3 should be deleted.");
+  XCTAssertEqualObjects(diff.insertedIndexPaths, @[NIItem(3, 0)], @"The 5 should be inserted.");
+  XCTAssertTrue([diff.movedToIndexPaths containsObject:NIItem(0, 0)], @"The 2 should move up.");
+  XCTAssertFalse([diff.movedFromIndexPaths containsObject:NIItem(3, 0)],
+                 @"The 4 is only shifted by the deletion before it.");
+  XCTAssertEqual(diff.reloadedIndexPaths.count, (NSUInteger)0, @"Nothing should be reloaded.");
+}
+
+- (void)testSectionsAreMatchedByTitle {
+  NICollectionViewModelDiff* diff = [NICollectionViewModelDiff diffFromSectionedArray:@[@"A", @1, @"B", @2]
+                                                                     toSectionedArray:@[@"B", @2, @"C", @1]];
+  XCTAssertEqualObjects(diff.deletedSections, [NSIndexSet indexSetWithIndex:0], @"Section A should be deleted.");
+  XCTAssertEqualObjects(diff.insertedSections, [NSIndexSet indexSetWithIndex:1], @"Section C should be inserted.");
+  XCTAssertEqual(diff.deletedIndexPaths.count, (NSUInteger)0, @"Items of deleted sections go with them.");
+  XCTAssertEqual(diff.insertedIndexPaths.count, (NSUInteger)0, @"Items of inserted sections come with them.");
+}
+
+- (void)testEqualObjectsAreReloaded {
+  NSDictionary* oldItem = [NSDictionary dictionaryWithObject:@"Item" forKey:@"title"];
+  NSDictionary* newItem = [NSDictionary dictionaryWithObject:@"Item" forKey:@"title"];
+  NICollectionViewModelDiff* diff = [NICollectionViewModelDiff diffFromSectionedArray:@[@1, oldItem]
+                                                                     toSectionedArray:@[@1, newItem]];
+  XCTAssertEqualObjects(diff.reloadedIndexPaths, @[NIItem(1, 0)], @"Equal objects should be reloaded.");
+  XCTAssertEqual(diff.insertedIndexPaths.count + diff.deletedIndexPaths.count, (NSUInteger)0,
+                 @"Equal objects should be matched.");
+}
+
+- (void)testSettingSectionedArrayReplacesContents {
+  NIMutableCollectionViewModel* model = [[NIMutableCollectionViewModel alloc] initWithDelegate:nil];
+  model.objectIndexType = NICollectionViewModelObjectIndexEquality;
+  [model addObjectsFromArray:@[@1, @2, @3]];
+
+  NICollectionViewModelDiff* diff = [model setSectionedArray:@[@3, @"Second", @1, @4] diffingWithCollectionView:nil];
+  XCTAssertTrue(diff.hasChanges, @"The contents changed.");
+  XCTAssertEqual([model numberOfSectionsInCollectionView:nil], 2, @"There should be two sections.");
+  XCTAssertEqualObjects([model indexPathForObject:@1], NIItem(0, 1), @"The object index should be updated.");
+  XCTAssertNil([model indexPathForObject:@2], @"Removed objects should be gone.");
+
+  [model addObject:@5];
+  XCTAssertEqual([model collectionView:nil numberOfItemsInSection:1], 3, @"The new contents should be mutable.");
+}
+
+- (void)testApplyingAStaleDiffReplacesContents {
+  NIMutableCollectionViewModel* model = [[NIMutableCollectionViewModel alloc] initWithListArray:@[@1, @2]
+                                                                                       delegate:nil];
+  NICollectionViewModelDiff* diff = [NICollectionViewModelDiff diffFromSectionedArray:@[@7, @8]
+                                                                     toSectionedArray:@[@7, @8, @9]];
+
+  // The diff was not computed from the model's contents, so it falls back to reloading.
+  [model applyDiff:diff withCollectionView:nil];
+  XCTAssertEqual([model collectionView:nil numberOfItemsInSection:0], 3, @"The diff's contents should be applied.");
+  XCTAssertEqualObjects([model objectAtIndexPath:NIItem(2, 0)], @9, @"The diff's contents should be applied.");
+}
+
+@end
@@ -0,0 +1,173 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NimbusCore.h"
+#import "NimbusCollections.h"
+
+static NSUInteger sNumberOfSizedItems = 0;
+
+@interface NIWaterfallTestObject : NSObject <NICollectionViewCellObject>
++ (id)objectWithSize:(CGSize)size;
+@property (nonatomic, assign) CGSize size;
+@end
+
+@interface NIWaterfallTestCell : UICollectionViewCell <NICollectionViewCell>
+@end
+
+@implementation NIWaterfallTestObject
+
++ (id)objectWithSize:(CGSize)size {
+  NIWaterfallTestObject* object = [[self alloc] init];
+  object.size = size;
+  return object;
+}
+
+- (Class)collectionViewCellClass {
+  return [NIWaterfallTestCell class];
+}
+
+@end
+
+@implementation NIWaterfallTestCell
+
+- (BOOL)shouldUpdateCellWithObject:(id)object {
+  return YES;
+}
+
++ (CGSize)sizeForObject:(id)object atIndexPath:(NSIndexPath *)indexPath collectionView:(UICollectionView *)collectionView {
+  ++sNumberOfSizedItems;
+  return [(NIWaterfallTestObject *)object size];
+}
+
+@end
+
+@interface NICollectionViewWaterfallLayoutTests : XCTestCase
+@end
+
+
+@implementation NICollectionViewWaterfallLayoutTests
+
+
+// The layout only keeps a weak reference to the collection view, so the tests hold on to it.
+- (UICollectionView *)collectionViewForModel:(NICollectionViewModel *)model
+                                 cellFactory:(NICollectionViewCellFactory *)cellFactory {
+  NICollectionViewWaterfallLayout* layout = [[NICollectionViewWaterfallLayout alloc] init];
+  layout.cellFactory = cellFactory;
+  UICollectionView* collectionView = [[UICollectionView alloc] initWithFrame:CGRectMake(0, 0, 200, 400)
+                                                        collectionViewLayout:layout];
+  collectionView.dataSource = model;
+  layout.model = model;
+  return collectionView;
+}
+
+- (CGRect)frameOfItem:(NSInteger)item layout:(NICollectionViewWaterfallLayout *)layout {
+  return [layout layoutAttributesForItemAtIndexPath:[NSIndexPath indexPathForItem:item inSection:0]].frame;
+}
+
+- (void)testItemsGoToTheShortestColumn {
+  NICollectionViewCellFactory* cellFactory = [[NICollectionViewCellFactory alloc] init];
+  NICollectionViewModel* model =
+      [[NICollectionViewModel alloc] initWithListArray:@[[NIWaterfallTestObject objectWithSize:CGSizeMake(100, 50)],
+                                                         [NIWaterfallTestObject objectWithSize:CGSizeMake(100, 100)],
+                                                         [NIWaterfallTestObject objectWithSize:CGSizeMake(100, 200)],
+                                                         [NIWaterfallTestObject objectWithSize:CGSizeMake(100, 50)]]
+                                              delegate:cellFactory];
+  UICollectionView* collectionView = [self collectionViewForModel:model cellFactory:cellFactory];
+  NICollectionViewWaterfallLayout* layout = (NICollectionViewWaterfallLayout *)collectionView.collectionViewLayout;
+  [layout prepareLayout];
+
+  // Two 96pt columns with 8pt between them; heights keep each item's aspect ratio.
+  XCTAssertTrue(CGRectEqualToRect([self frameOfItem:0 layout:layout], CGRectMake(0, 0, 96, 48)));
+  XCTAssertTrue(CGRectEqualToRect([self frameOfItem:1 layout:layout], CGRectMake(104, 0, 96, 96)));
+  XCTAssertTrue(CGRectEqualToRect([self frameOfItem:2 layout:layout], CGRectMake(0, 56, 96, 192)),
+                @"The first column is the shortest.");
+  XCTAssertTrue(CGRectEqualToRect([self frameOfItem:3 layout:layout], CGRectMake(104, 104, 96, 48)),
+                @"The second column is the shortest.");
+  XCTAssertEqual(layout.collectionViewContentSize.height, (CGFloat)248,
+                 @"The content should end at the bottom of the tallest column.");
+}
+
+- (void)testItemsWithoutASizeAreSquare {
+  NICollectionViewModel* model = [[NICollectionViewModel alloc] initWithListArray:@[@1, @2, @3] delegate:nil];
+  UICollectionView* collectionView = [self collectionViewForModel:model cellFactory:nil];
+  NICollectionViewWaterfallLayout* layout = (NICollectionViewWaterfallLayout *)collectionView.collectionViewLayout;
+  layout.numberOfColumns = 3;
+  layout.interitemSpacing = 4;
+  [layout prepareLayout];
+
+  XCTAssertTrue(CGRectEqualToRect([self frameOfItem:2 layout:layout], CGRectMake(136, 0, 64, 64)));
+}
+
+- (void)testAppendedItemsReuseTheEarlierAttributes {
+  NICollectionViewCellFactory* cellFactory = [[NICollectionViewCellFactory alloc] init];
+  NIMutableCollectionViewModel* model = [[NIMutableCollectionViewModel alloc] initWithDelegate:cellFactory];
+  [model addObjectsFromArray:@[[NIWaterfallTestObject objectWithSize:CGSizeMake(100, 100)],
+                               [NIWaterfallTestObject objectWithSize:CGSizeMake(100, 50)]]];
+  UICollectionView* collectionView = [self collectionViewForModel:model cellFactory:cellFactory];
+  NICollectionViewWaterfallLayout* layout = (NICollectionViewWaterfallLayout *)collectionView.collectionViewLayout;
+  [layout prepareLayout];
+  UICollectionViewLayoutAttributes* firstAttributes =
+      [layout layoutAttributesForItemAtIndexPath:[NSIndexPath indexPathForItem:0 inSection:0]];
+
+  sNumberOfSizedItems = 0;
+  [model addObject:[NIWaterfallTestObject objectWithSize:CGSizeMake(100, 100)]];
+  [layout prepareLayout];
+
+  XCTAssertEqual(sNumberOfSizedItems, (NSUInteger)1, @"Only the appended item should be sized.");
+  XCTAssertEqual([layout layoutAttributesForItemAtIndexPath:[NSIndexPath indexPathForItem:0 inSection:0]],
+                 firstAttributes, @"The earlier attributes should be reused.");
+  XCTAssertTrue(CGRectEqualToRect([self frameOfItem:2 layout:layout], CGRectMake(104, 56, 96, 96)),
+                @"The appended item should go to the shortest column.");
+
+  sNumberOfSizedItems = 0;
+  [model insertObject:[NIWaterfallTestObject objectWithSize:CGSizeMake(100, 100)] atRow:0 inSection:0];
+  [layout prepareLayout];
+  XCTAssertEqual(sNumberOfSizedItems, (NSUInteger)4, @"An insertion should lay out every item again.");
+}
+
+- (void)testAttributesPreparedInTheBackgroundArePublished {
+  NICollectionViewCellFactory* cellFactory = [[NICollectionViewCellFactory alloc] init];
+  NICollectionViewModel* model =
+      [[NICollectionViewModel alloc] initWithListArray:@[[NIWaterfallTestObject objectWithSize:CGSizeMake(100, 100)]]
+                                              delegate:cellFactory];
+  UICollectionView* collectionView = [self collectionViewForModel:nil cellFactory:cellFactory];
+  NICollectionViewWaterfallLayout* layout = (NICollectionViewWaterfallLayout *)collectionView.collectionViewLayout;
+
+  __block BOOL isPrepared = NO;
+  [layout prepareLayoutForModel:model completion:^{
+    XCTAssertTrue([NSThread isMainThread], @"The completion should be called on the main thread.");
+    isPrepared = YES;
+  }];
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (!isPrepared && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertTrue(isPrepared, @"The attributes should have been prepared.");
+
+  sNumberOfSizedItems = 0;
+  collectionView.dataSource = model;
+  layout.model = model;
+  [layout prepareLayout];
+  XCTAssertEqual(sNumberOfSizedItems, (NSUInteger)0, @"The prepared attributes should be used as they are.");
+  XCTAssertTrue(CGRectEqualToRect([self frameOfItem:0 layout:layout], CGRectMake(0, 0, 96, 96)));
+}
+
+@end
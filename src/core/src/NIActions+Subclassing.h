@@ -35,3 +35,22 @@
 - (NIObjectActions *)actionForObjectOrClassOfObject:(id<NSObject>)object;
 
 @end
+
+/**
+ * The delegates that an actions object forwards a protocol's optional methods to.
+ *
+ * The delegate for each method is looked up once, when the delegates change, so finding where to
+ * forward a method is a single lookup keyed by its selector. Subclasses return it from
+ * forwardingTargetForSelector:, which makes forwarding a plain message send.
+ *
+ * Like the sets of delegates the tables are built from, tables don't retain the delegates.
+ */
+@interface NIForwardingTable : NSObject
+
+// Maps each optional method of the protocol and of the protocols it adopts to the first of the
+// delegates that implements it.
+- (id)initWithProtocol:(Protocol *)protocol delegates:(id<NSFastEnumeration>)delegates;
+
+- (id)delegateForSelector:(SEL)selector; // nil when no delegate implements the method.
+
+@end
@@ -104,6 +104,24 @@ NSArray *objects = @[
 - (id)attachToObject:(id<NSObject>)object detailSelector:(SEL)selector;
 - (id)attachToObject:(id<NSObject>)object navigationSelector:(SEL)selector;
 
+#pragma mark Mapping Many Objects
+
+- (NSArray *)attachToObjects:(NSArray *)objects tapBlock:(NIActionBlock)action;
+- (NSArray *)attachToObjects:(NSArray *)objects detailBlock:(NIActionBlock)action;
+- (NSArray *)attachToObjects:(NSArray *)objects navigationBlock:(NIActionBlock)action;
+
+- (NSArray *)attachToObjects:(NSArray *)objects tapSelector:(SEL)selector;
+- (NSArray *)attachToObjects:(NSArray *)objects detailSelector:(SEL)selector;
+- (NSArray *)attachToObjects:(NSArray *)objects navigationSelector:(SEL)selector;
+
+- (void)attachToObjectsMatchingPredicate:(NSPredicate *)predicate tapBlock:(NIActionBlock)action;
+- (void)attachToObjectsMatchingPredicate:(NSPredicate *)predicate detailBlock:(NIActionBlock)action;
+- (void)attachToObjectsMatchingPredicate:(NSPredicate *)predicate navigationBlock:(NIActionBlock)action;
+
+- (void)attachToObjectsMatchingPredicate:(NSPredicate *)predicate tapSelector:(SEL)selector;
+- (void)attachToObjectsMatchingPredicate:(NSPredicate *)predicate detailSelector:(SEL)selector;
+- (void)attachToObjectsMatchingPredicate:(NSPredicate *)predicate navigationSelector:(SEL)selector;
+
 #pragma mark Mapping Classes
 
 - (void)attachToClass:(Class)aClass tapBlock:(NIActionBlock)action;
@@ -311,6 +329,104 @@ NIActionBlock NIPushControllerAction(Class controllerClass);
  * @sa NIActions::attachToObject:navigationBlock:
  */
 
+/** @name Mapping Many Objects */
+
+/**
+ * Attaches a tap action to every object in the array.
+ *
+ * This method behaves like calling attachToObject:tapBlock: with each object, except that the
+ * objects share a single actions record and the block is only copied once. Use it when building
+ * models with many rows that share an action.
+ *
+ * @param objects The objects to attach the action to.
+ * @param action The tap action block.
+ * @returns The array of objects that you attached this action to.
+ * @fn NIActions::attachToObjects:tapBlock:
+ */
+
+/**
+ * Attaches a detail action to every object in the array.
+ *
+ * @see NIActions::attachToObjects:tapBlock:
+ * @fn NIActions::attachToObjects:detailBlock:
+ */
+
+/**
+ * Attaches a navigation action to every object in the array.
+ *
+ * @see NIActions::attachToObjects:tapBlock:
+ * @fn NIActions::attachToObjects:navigationBlock:
+ */
+
+/**
+ * Attaches a tap selector to every object in the array.
+ *
+ * @see NIActions::attachToObjects:tapBlock:
+ * @fn NIActions::attachToObjects:tapSelector:
+ */
+
+/**
+ * Attaches a detail selector to every object in the array.
+ *
+ * @see NIActions::attachToObjects:tapBlock:
+ * @fn NIActions::attachToObjects:detailSelector:
+ */
+
+/**
+ * Attaches a navigation selector to every object in the array.
+ *
+ * @see NIActions::attachToObjects:tapBlock:
+ * @fn NIActions::attachToObjects:navigationSelector:
+ */
+
+/**
+ * Attaches a tap action to every object that matches the predicate.
+ *
+ * Nothing is stored per object. The predicate is evaluated against an object when its actions
+ * are looked up, after any actions attached to the object itself and before any attached to its
+ * class. Predicates are evaluated in the order they were first attached and the first match
+ * wins. Attaching to an equal predicate again adds to the same actions.
+ *
+ * @param predicate The predicate that objects must match.
+ * @param action The tap action block.
+ * @fn NIActions::attachToObjectsMatchingPredicate:tapBlock:
+ */
+
+/**
+ * Attaches a detail action to every object that matches the predicate.
+ *
+ * @see NIActions::attachToObjectsMatchingPredicate:tapBlock:
+ * @fn NIActions::attachToObjectsMatchingPredicate:detailBlock:
+ */
+
+/**
+ * Attaches a navigation action to every object that matches the predicate.
+ *
+ * @see NIActions::attachToObjectsMatchingPredicate:tapBlock:
+ * @fn NIActions::attachToObjectsMatchingPredicate:navigationBlock:
+ */
+
+/**
+ * Attaches a tap selector to every object that matches the predicate.
+ *
+ * @see NIActions::attachToObjectsMatchingPredicate:tapBlock:
+ * @fn NIActions::attachToObjectsMatchingPredicate:tapSelector:
+ */
+
+/**
+ * Attaches a detail selector to every object that matches the predicate.
+ *
+ * @see NIActions::attachToObjectsMatchingPredicate:tapBlock:
+ * @fn NIActions::attachToObjectsMatchingPredicate:detailSelector:
+ */
+
+/**
+ * Attaches a navigation selector to every object that matches the predicate.
+ *
+ * @see NIActions::attachToObjectsMatchingPredicate:tapBlock:
+ * @fn NIActions::attachToObjectsMatchingPredicate:navigationSelector:
+ */
+
 /** @name Mapping Classes */
 
 /**
@@ -18,8 +18,10 @@
 #import "NIActions+Subclassing.h"
 
 #import <UIKit/UIKit.h>
+#import <objc/runtime.h>
 
 #import "NIDebuggingTools.h"
+#import "NINonRetainingCollections.h"
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "Nimbus requires ARC support."
@@ -29,7 +31,18 @@
 
 @property (nonatomic, strong) NSMutableDictionary* objectToAction;
 @property (nonatomic, strong) NSMutableDictionary* classToAction;
-@property (nonatomic, strong) NSMutableSet* objectSet;
+@property (nonatomic, strong) NSMutableDictionary* resolvedClassToAction;
+@property (nonatomic, strong) NIPointerSet* objectSet; // Keeps the attached objects alive
+@property (nonatomic, strong) NSMutableArray* predicates;
+@property (nonatomic, strong) NSMutableDictionary* predicateToAction;
+
+@end
+
+@interface NIObjectActions () <NSCopying>
+
+// Set when one actions object is attached to many objects at once. Shared actions are copied
+// before being changed for any single object.
+@property (nonatomic, getter = isShared) BOOL shared;
 
 @end
 
@@ -41,7 +54,10 @@
 
     _objectToAction = [[NSMutableDictionary alloc] init];
     _classToAction = [[NSMutableDictionary alloc] init];
-    _objectSet = [[NSMutableSet alloc] init];
+    _resolvedClassToAction = [[NSMutableDictionary alloc] init];
+    _objectSet = [[NIPointerSet alloc] initWithOptions:NIPointerCollectionOptionRetainKeys];
+    _predicates = [[NSMutableArray alloc] init];
+    _predicateToAction = [[NSMutableDictionary alloc] init];
   }
   return self;
 }
@@ -70,9 +86,56 @@
 - (NIObjectActions *)actionForObject:(id<NSObject>)object {
   id key = [self keyForObject:object];
   NIObjectActions* action = [self.objectToAction objectForKey:key];
+  if (nil == action || action.isShared) {
+    action = (nil == action) ? [[NIObjectActions alloc] init] : [action copy];
+    [self.objectToAction setObject:action forKey:key];
+  }
+  return action;
+}
+
+// Attaches one actions object to every object in the array. Objects that already have actions
+// attached get their own modified copy; objects that shared actions before keep sharing them.
+- (NSArray *)attachToObjects:(NSArray *)objects configuration:(void (^)(NIObjectActions* action))configuration {
+  NIObjectActions* newAction = nil;
+  NSMapTable* existingToModified = nil;
+  for (id<NSObject> object in objects) {
+    id key = [self keyForObject:object];
+    NIObjectActions* existing = [self.objectToAction objectForKey:key];
+    NIObjectActions* action = nil;
+    if (nil == existing) {
+      if (nil == newAction) {
+        newAction = [[NIObjectActions alloc] init];
+        newAction.shared = YES;
+        configuration(newAction);
+      }
+      action = newAction;
+
+    } else {
+      if (nil == existingToModified) {
+        existingToModified = [NSMapTable strongToStrongObjectsMapTable];
+      }
+      action = [existingToModified objectForKey:existing];
+      if (nil == action) {
+        action = [existing copy];
+        action.shared = YES;
+        configuration(action);
+        [existingToModified setObject:action forKey:existing];
+      }
+    }
+    [self.objectSet addObject:object];
+    [self.objectToAction setObject:action forKey:key];
+  }
+  return objects;
+}
+
+// Retrieves the NIObjectActions object for the given predicate or creates one if it doesn't yet
+// exist so that actions may be attached.
+- (NIObjectActions *)actionForPredicate:(NSPredicate *)predicate {
+  NIObjectActions* action = [self.predicateToAction objectForKey:predicate];
   if (nil == action) {
     action = [[NIObjectActions alloc] init];
-    [self.objectToAction setObject:action forKey:key];
+    [self.predicateToAction setObject:action forKey:predicate];
+    [self.predicates addObject:predicate];
   }
   return action;
 }
@@ -84,6 +147,9 @@
   if (nil == action) {
     action = [[NIObjectActions alloc] init];
     [self.classToAction setObject:action forKey:(id<NSCopying>)class];
+
+    // The new class may be a nearer ancestor than whatever subclasses were resolved to so far.
+    [self.resolvedClassToAction removeAllObjects];
   }
   return action;
 }
@@ -92,12 +158,44 @@
 - (NIObjectActions *)actionForObjectOrClassOfObject:(id<NSObject>)object {
   id key = [self keyForObject:object];
   NIObjectActions* action = [self.objectToAction objectForKey:key];
+  for (NSUInteger ix = 0; nil == action && ix < self.predicates.count; ++ix) {
+    NSPredicate* predicate = self.predicates[ix];
+    if ([predicate evaluateWithObject:object]) {
+      action = [self.predicateToAction objectForKey:predicate];
+    }
+  }
   if (nil == action) {
-    action = [self.class objectFromKeyClass:object.class map:self.classToAction];
+    action = [self actionForClassOfObject:object];
   }
   return action;
 }
 
+// Resolves the class of the object to the actions attached to it or its nearest ancestor.
+// Resolutions, including the lack of one, are remembered in resolvedClassToAction so that
+// classToAction only ever holds the classes that actions were attached to.
+- (NIObjectActions *)actionForClassOfObject:(id<NSObject>)object {
+  Class class = object.class;
+  id action = [self.resolvedClassToAction objectForKey:class];
+  if (nil == action) {
+    action = [self.class nearestObjectFromKeyClass:class map:self.classToAction];
+    [self.resolvedClassToAction setObject:(nil != action ? action : [NSNull null])
+                                   forKey:(id<NSCopying>)class];
+  }
+  return (action == [NSNull null]) ? nil : action;
+}
+
+// Walks up from keyClass until it finds a class with a mapping. The first class found is the
+// nearest mapped ancestor, so the rest of the map never needs to be looked at.
++ (id)nearestObjectFromKeyClass:(Class)keyClass map:(NSDictionary *)map {
+  for (Class class = keyClass; nil != class; class = [class superclass]) {
+    id object = [map objectForKey:class];
+    if (nil != object) {
+      return object;
+    }
+  }
+  return nil;
+}
+
 #pragma mark - Public
 
 - (id)attachToObject:(id<NSObject>)object tapBlock:(NIActionBlock)action {
@@ -136,6 +234,66 @@
   return object;
 }
 
+- (NSArray *)attachToObjects:(NSArray *)objects tapBlock:(NIActionBlock)action {
+  return [self attachToObjects:objects configuration:^(NIObjectActions* objectAction) {
+    objectAction.tapAction = action;
+  }];
+}
+
+- (NSArray *)attachToObjects:(NSArray *)objects detailBlock:(NIActionBlock)action {
+  return [self attachToObjects:objects configuration:^(NIObjectActions* objectAction) {
+    objectAction.detailAction = action;
+  }];
+}
+
+- (NSArray *)attachToObjects:(NSArray *)objects navigationBlock:(NIActionBlock)action {
+  return [self attachToObjects:objects configuration:^(NIObjectActions* objectAction) {
+    objectAction.navigateAction = action;
+  }];
+}
+
+- (NSArray *)attachToObjects:(NSArray *)objects tapSelector:(SEL)selector {
+  return [self attachToObjects:objects configuration:^(NIObjectActions* objectAction) {
+    objectAction.tapSelector = selector;
+  }];
+}
+
+- (NSArray *)attachToObjects:(NSArray *)objects detailSelector:(SEL)selector {
+  return [self attachToObjects:objects configuration:^(NIObjectActions* objectAction) {
+    objectAction.detailSelector = selector;
+  }];
+}
+
+- (NSArray *)attachToObjects:(NSArray *)objects navigationSelector:(SEL)selector {
+  return [self attachToObjects:objects configuration:^(NIObjectActions* objectAction) {
+    objectAction.navigateSelector = selector;
+  }];
+}
+
+- (void)attachToObjectsMatchingPredicate:(NSPredicate *)predicate tapBlock:(NIActionBlock)action {
+  [self actionForPredicate:predicate].tapAction = action;
+}
+
+- (void)attachToObjectsMatchingPredicate:(NSPredicate *)predicate detailBlock:(NIActionBlock)action {
+  [self actionForPredicate:predicate].detailAction = action;
+}
+
+- (void)attachToObjectsMatchingPredicate:(NSPredicate *)predicate navigationBlock:(NIActionBlock)action {
+  [self actionForPredicate:predicate].navigateAction = action;
+}
+
+- (void)attachToObjectsMatchingPredicate:(NSPredicate *)predicate tapSelector:(SEL)selector {
+  [self actionForPredicate:predicate].tapSelector = selector;
+}
+
+- (void)attachToObjectsMatchingPredicate:(NSPredicate *)predicate detailSelector:(SEL)selector {
+  [self actionForPredicate:predicate].detailSelector = selector;
+}
+
+- (void)attachToObjectsMatchingPredicate:(NSPredicate *)predicate navigationSelector:(SEL)selector {
+  [self actionForPredicate:predicate].navigateSelector = selector;
+}
+
 - (void)attachToClass:(Class)aClass tapBlock:(NIActionBlock)action {
   [self actionForClass:aClass].tapAction = action;
 }
@@ -189,19 +347,9 @@
   if (nil == object) {
     // No mapping found for this key class, but it may be a subclass of another object that does
     // have a mapping, so let's see what we can find.
-    Class superClass = nil;
-    for (Class class in map.allKeys) {
-      // We want to find the lowest node in the class hierarchy so that we pick the lowest ancestor
-      // in the hierarchy tree.
-      if ([keyClass isSubclassOfClass:class]
-          && (nil == superClass || [class isSubclassOfClass:superClass])) {
-        superClass = class;
-      }
-    }
-
-    if (nil != superClass) {
-      object = [map objectForKey:superClass];
+    object = [self nearestObjectFromKeyClass:keyClass map:map];
 
+    if (nil != object) {
       // Add this subclass to the map so that next time this result is instant.
       [map setObject:object forKey:(id<NSCopying>)keyClass];
     }
@@ -222,6 +370,18 @@
 @end
 
 @implementation NIObjectActions
+
+- (id)copyWithZone:(NSZone *)zone {
+  NIObjectActions* copy = [[[self class] allocWithZone:zone] init];
+  copy.tapAction = self.tapAction;
+  copy.detailAction = self.detailAction;
+  copy.navigateAction = self.navigateAction;
+  copy.tapSelector = self.tapSelector;
+  copy.detailSelector = self.detailSelector;
+  copy.navigateSelector = self.navigateSelector;
+  return copy;
+}
+
 @end
 
 NIActionBlock NIPushControllerAction(Class controllerClass) {
@@ -245,3 +405,59 @@ NIActionBlock NIPushControllerAction(Class controllerClass) {
     return NO;
   } copy];
 }
+
+@implementation NIForwardingTable {
+  CFMutableDictionaryRef _selectorToDelegate; // SEL => unretained delegate
+}
+
+- (void)dealloc {
+  CFRelease(_selectorToDelegate);
+}
+
+- (id)initWithProtocol:(Protocol *)protocol delegates:(id<NSFastEnumeration>)delegates {
+  if ((self = [super init])) {
+    // Selectors are unique pointers, so they are compared and hashed as such.
+    _selectorToDelegate = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+    [self addMethodsOfProtocol:protocol delegates:delegates visitedProtocols:[NSMutableSet set]];
+  }
+  return self;
+}
+
+- (void)addMethodsOfProtocol:(Protocol *)protocol
+                   delegates:(id<NSFastEnumeration>)delegates
+            visitedProtocols:(NSMutableSet *)visitedProtocols {
+  NSString* name = NSStringFromProtocol(protocol);
+  if ([visitedProtocols containsObject:name]) {
+    return;
+  }
+  [visitedProtocols addObject:name];
+
+  unsigned int numberOfMethods = 0;
+  struct objc_method_description* methods = protocol_copyMethodDescriptionList(protocol, NO, YES, &numberOfMethods);
+  for (unsigned int ix = 0; ix < numberOfMethods; ++ix) {
+    SEL selector = methods[ix].name;
+    if (NULL != CFDictionaryGetValue(_selectorToDelegate, selector)) {
+      continue;
+    }
+    for (id delegate in delegates) {
+      if ([delegate respondsToSelector:selector]) {
+        CFDictionarySetValue(_selectorToDelegate, selector, (__bridge const void *)delegate);
+        break;
+      }
+    }
+  }
+  free(methods);
+
+  unsigned int numberOfProtocols = 0;
+  Protocol* __unsafe_unretained* protocols = protocol_copyProtocolList(protocol, &numberOfProtocols);
+  for (unsigned int ix = 0; ix < numberOfProtocols; ++ix) {
+    [self addMethodsOfProtocol:protocols[ix] delegates:delegates visitedProtocols:visitedProtocols];
+  }
+  free(protocols);
+}
+
+- (id)delegateForSelector:(SEL)selector {
+  return (__bridge id)CFDictionaryGetValue(_selectorToDelegate, selector);
+}
+
+@end
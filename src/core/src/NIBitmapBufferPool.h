@@ -0,0 +1,167 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+#import "NIMemoryPressure.h"
+
+/**
+ * For reusing the memory behind bitmap contexts and the images drawn into them.
+ *
+ * @ingroup NimbusCore
+ * @defgroup Bitmap-Buffer-Pools Bitmap Buffer Pools
+ * @{
+ *
+ * Every new bitmap context allocates a fresh backing store, and the kernel has to map and zero
+ * its pages the first time they are touched. When the same sizes of image are drawn over and
+ * over, such as thumbnails in a scrolling list, a pool lets those backing stores be reused
+ * instead.
+ *
+ * <h2>Example Use</h2>
+ *
+@code
+NIBitmapBufferPool* pool = [NIBitmapBufferPool sharedPool];
+CGContextRef context = [pool newBitmapContextWithWidth:width
+                                                height:height
+                                            bitmapInfo:(CGBitmapInfo)kCGImageAlphaPremultipliedLast];
+// Draw into the context...
+CGImageRef imageRef = [pool newImageFromBitmapContext:context];
+CGContextRelease(context);
+
+UIImage* image = [UIImage imageWithCGImage:imageRef];
+CGImageRelease(imageRef);
+// The buffer returns to the pool once the image is deallocated.
+@endcode
+ */
+
+/**
+ * A thread-safe pool of bitmap backing stores grouped by size class.
+ *
+ * Buffer lengths are rounded up to a size class so that images of similar sizes can share
+ * buffers. Each size class is at most a quarter larger than the length it serves.
+ */
+@interface NIBitmapBufferPool : NSObject
+
++ (NIBitmapBufferPool *)sharedPool;
+
+// Designated initializer.
+- (id)initWithMaxNumberOfBytes:(NSUInteger)maxNumberOfBytes;
+
+@property (nonatomic, readonly) NSUInteger maxNumberOfBytes;
+@property (readonly) NSUInteger numberOfBytes;
+
+- (CGContextRef)newBitmapContextWithWidth:(size_t)width height:(size_t)height bitmapInfo:(CGBitmapInfo)bitmapInfo CF_RETURNS_RETAINED;
+- (CGImageRef)newImageFromBitmapContext:(CGContextRef)context CF_RETURNS_RETAINED;
+
+- (void)removeAllBuffers;
+- (void)reduceMemoryUsageForPressureLevel:(NIMemoryPressureLevel)level;
+
++ (size_t)sizeClassForLength:(size_t)length;
+
+@end
+
+/**@}*/// End of Bitmap Buffer Pools //////////////////////////////////////////////////////////////
+
+/** @name Creating a Pool */
+
+/**
+ * The pool shared by Nimbus' image processing and snapshotting.
+ *
+ * It holds on to at most 8 megabytes of unused buffers.
+ *
+ * @fn NIBitmapBufferPool::sharedPool
+ */
+
+/**
+ * Initializes a newly allocated pool that keeps at most maxNumberOfBytes of unused buffers.
+ *
+ * -init creates a pool that keeps at most 8 megabytes.
+ *
+ * @fn NIBitmapBufferPool::initWithMaxNumberOfBytes:
+ */
+
+/**
+ * The largest number of bytes of unused buffers that the pool will hold on to.
+ *
+ * Buffers that are returned to a full pool are freed.
+ *
+ * @fn NIBitmapBufferPool::maxNumberOfBytes
+ */
+
+/**
+ * The number of bytes of unused buffers currently held by the pool.
+ *
+ * @fn NIBitmapBufferPool::numberOfBytes
+ */
+
+/** @name Drawing with Pooled Buffers */
+
+/**
+ * Creates a 32 bit RGB bitmap context backed by a pooled buffer.
+ *
+ * The context starts out cleared even if its buffer has been used before. The buffer returns
+ * to the pool once the context and any images created from it with newImageFromBitmapContext:
+ * have been released.
+ *
+ * Returns NULL if the bitmap could not be created. The caller must release the context.
+ *
+ * @fn NIBitmapBufferPool::newBitmapContextWithWidth:height:bitmapInfo:
+ */
+
+/**
+ * Creates an image that shares the context's pooled buffer rather than copying it.
+ *
+ * Unlike CGBitmapContextCreateImage, the image does not copy the pixels on write, so the
+ * context must not be drawn into once the image has been created. Contexts that were not
+ * created by this pool are copied with CGBitmapContextCreateImage.
+ *
+ * The caller must release the image.
+ *
+ * @fn NIBitmapBufferPool::newImageFromBitmapContext:
+ */
+
+/** @name Reducing Memory Usage */
+
+/**
+ * Frees every unused buffer in the pool.
+ *
+ * Buffers that are still backing contexts or images are unaffected.
+ *
+ * @fn NIBitmapBufferPool::removeAllBuffers
+ */
+
+/**
+ * Frees unused buffers in response to memory pressure.
+ *
+ * Background and warning pressure free half of the unused bytes. Critical pressure frees all
+ * of them. The pool observes the shared NIMemoryPressureCoordinator, so this rarely needs to
+ * be called directly.
+ *
+ * @fn NIBitmapBufferPool::reduceMemoryUsageForPressureLevel:
+ */
+
+/** @name Size Classes */
+
+/**
+ * Returns the size of the buffer that the pool uses for a bitmap of the given length.
+ *
+ * Lengths are rounded up to a whole number of pages. Beyond four pages, each power of two is
+ * divided into four evenly spaced size classes.
+ *
+ * @fn NIBitmapBufferPool::sizeClassForLength:
+ */
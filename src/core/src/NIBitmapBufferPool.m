@@ -0,0 +1,280 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIBitmapBufferPool.h"
+
+#import "NIDebuggingTools.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+static const NSUInteger kNIBitmapBufferPoolDefaultMaxNumberOfBytes = 8 * 1024 * 1024;
+
+// Core Animation prefers rows that are aligned to a cache line.
+static const size_t kNIBitmapBufferRowAlignment = 64;
+
+@interface NIBitmapBufferPool()
+- (void)recycleData:(NSMutableData *)data;
+@end
+
+// A buffer checked out of the pool. It is retained by every context and image that draws from
+// it, and returns its memory to the pool when the last of them lets go.
+@interface NIBitmapBuffer : NSObject
+@property (nonatomic, strong) NSMutableData* data;
+@property (nonatomic, strong) NIBitmapBufferPool* pool;
+@end
+
+@implementation NIBitmapBuffer
+
+- (void)dealloc {
+  [_pool recycleData:_data];
+}
+
+@end
+
+static void NIBitmapContextReleaseBuffer(void* releaseInfo, void* data) {
+  CFBridgingRelease(releaseInfo);
+}
+
+static void NIDataProviderReleaseBuffer(void* info, const void* data, size_t size) {
+  CFBridgingRelease(info);
+}
+
+@implementation NIBitmapBufferPool {
+  NSMutableDictionary* _sizeClassesToData;
+  NSMapTable* _bytesToBuffersInUse;
+  NSUInteger _numberOfBytes;
+}
+
+- (void)dealloc {
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (id)initWithMaxNumberOfBytes:(NSUInteger)maxNumberOfBytes {
+  if ((self = [super init])) {
+    _maxNumberOfBytes = maxNumberOfBytes;
+    _sizeClassesToData = [[NSMutableDictionary alloc] init];
+    _bytesToBuffersInUse = [NSMapTable strongToWeakObjectsMapTable];
+
+    [[NIMemoryPressureCoordinator sharedCoordinator] addObserver:self
+                                                         selector:@selector(didReceiveMemoryPressure:)];
+  }
+  return self;
+}
+
+- (id)init {
+  return [self initWithMaxNumberOfBytes:kNIBitmapBufferPoolDefaultMaxNumberOfBytes];
+}
+
++ (NIBitmapBufferPool *)sharedPool {
+  static NIBitmapBufferPool* sPool = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sPool = [[NIBitmapBufferPool alloc] init];
+  });
+  return sPool;
+}
+
++ (size_t)sizeClassForLength:(size_t)length {
+  size_t pageSize = (size_t)getpagesize();
+  size_t numberOfPages = MAX((size_t)1, (length + pageSize - 1) / pageSize);
+  if (numberOfPages <= 4) {
+    return numberOfPages * pageSize;
+  }
+
+  // Find the power of two just below numberOfPages and split it into four steps.
+  size_t powerOfTwo = 4;
+  while (powerOfTwo * 2 < numberOfPages) {
+    powerOfTwo *= 2;
+  }
+  size_t step = powerOfTwo / 4;
+  return ((numberOfPages + step - 1) / step) * step * pageSize;
+}
+
+#pragma mark - Buffers
+
+- (NIBitmapBuffer *)bufferWithLength:(size_t)length {
+  size_t sizeClass = [[self class] sizeClassForLength:length];
+
+  NSMutableData* data = nil;
+  @synchronized(self) {
+    NSMutableArray* pooledData = [_sizeClassesToData objectForKey:@(sizeClass)];
+    data = [pooledData lastObject];
+    if (nil != data) {
+      [pooledData removeLastObject];
+      _numberOfBytes -= sizeClass;
+    }
+  }
+
+  if (nil == data) {
+    // Fresh data is already zeroed.
+    data = [[NSMutableData alloc] initWithLength:sizeClass];
+    if (nil == data) {
+      return nil;
+    }
+  } else {
+    bzero(data.mutableBytes, length);
+  }
+
+  NIBitmapBuffer* buffer = [[NIBitmapBuffer alloc] init];
+  buffer.data = data;
+  buffer.pool = self;
+
+  @synchronized(self) {
+    [_bytesToBuffersInUse setObject:buffer forKey:[NSValue valueWithPointer:data.mutableBytes]];
+  }
+  return buffer;
+}
+
+- (void)recycleData:(NSMutableData *)data {
+  @synchronized(self) {
+    [_bytesToBuffersInUse removeObjectForKey:[NSValue valueWithPointer:data.mutableBytes]];
+
+    if (_numberOfBytes + data.length > _maxNumberOfBytes) {
+      return;
+    }
+
+    NSNumber* sizeClass = @(data.length);
+    NSMutableArray* pooledData = [_sizeClassesToData objectForKey:sizeClass];
+    if (nil == pooledData) {
+      pooledData = [[NSMutableArray alloc] init];
+      [_sizeClassesToData setObject:pooledData forKey:sizeClass];
+    }
+    [pooledData addObject:data];
+    _numberOfBytes += data.length;
+  }
+}
+
+- (NSUInteger)numberOfBytes {
+  @synchronized(self) {
+    return _numberOfBytes;
+  }
+}
+
+#pragma mark - Drawing
+
+- (CGContextRef)newBitmapContextWithWidth:(size_t)width height:(size_t)height bitmapInfo:(CGBitmapInfo)bitmapInfo {
+  if (0 == width || 0 == height) {
+    return NULL;
+  }
+
+  size_t bytesPerRow = ((width * 4 + kNIBitmapBufferRowAlignment - 1) / kNIBitmapBufferRowAlignment
+                        * kNIBitmapBufferRowAlignment);
+  NIBitmapBuffer* buffer = [self bufferWithLength:bytesPerRow * height];
+  if (nil == buffer) {
+    return NULL;
+  }
+
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGContextRef context = CGBitmapContextCreateWithData(buffer.data.mutableBytes,
+                                                       width,
+                                                       height,
+                                                       8,
+                                                       bytesPerRow,
+                                                       colorSpace,
+                                                       bitmapInfo,
+                                                       NIBitmapContextReleaseBuffer,
+                                                       (__bridge_retained void *)buffer);
+  CGColorSpaceRelease(colorSpace);
+
+  if (NULL == context) {
+    // The release callback is only invoked for contexts that were created.
+    CFBridgingRelease((__bridge void *)buffer);
+  }
+  return context;
+}
+
+- (CGImageRef)newImageFromBitmapContext:(CGContextRef)context {
+  if (NULL == context) {
+    return NULL;
+  }
+
+  NIBitmapBuffer* buffer = nil;
+  @synchronized(self) {
+    buffer = [_bytesToBuffersInUse objectForKey:[NSValue valueWithPointer:CGBitmapContextGetData(context)]];
+  }
+  if (nil == buffer) {
+    return CGBitmapContextCreateImage(context);
+  }
+
+  size_t bytesPerRow = CGBitmapContextGetBytesPerRow(context);
+  size_t height = CGBitmapContextGetHeight(context);
+  CGDataProviderRef provider = CGDataProviderCreateWithData((__bridge_retained void *)buffer,
+                                                            buffer.data.mutableBytes,
+                                                            bytesPerRow * height,
+                                                            NIDataProviderReleaseBuffer);
+  if (NULL == provider) {
+    CFBridgingRelease((__bridge void *)buffer);
+    return NULL;
+  }
+
+  CGImageRef imageRef = CGImageCreate(CGBitmapContextGetWidth(context),
+                                      height,
+                                      CGBitmapContextGetBitsPerComponent(context),
+                                      CGBitmapContextGetBitsPerPixel(context),
+                                      bytesPerRow,
+                                      CGBitmapContextGetColorSpace(context),
+                                      CGBitmapContextGetBitmapInfo(context),
+                                      provider,
+                                      NULL,
+                                      false,
+                                      kCGRenderingIntentDefault);
+  CGDataProviderRelease(provider);
+  return imageRef;
+}
+
+#pragma mark - Memory Warnings
+
+- (void)trimToNumberOfBytes:(NSUInteger)numberOfBytes {
+  @synchronized(self) {
+    for (NSNumber* sizeClass in [_sizeClassesToData allKeys]) {
+      NSMutableArray* pooledData = [_sizeClassesToData objectForKey:sizeClass];
+      while (_numberOfBytes > numberOfBytes && pooledData.count > 0) {
+        [pooledData removeObjectAtIndex:0];
+        _numberOfBytes -= [sizeClass unsignedIntegerValue];
+      }
+      if (0 == pooledData.count) {
+        [_sizeClassesToData removeObjectForKey:sizeClass];
+      }
+    }
+  }
+}
+
+- (void)removeAllBuffers {
+  [self trimToNumberOfBytes:0];
+}
+
+- (void)reduceMemoryUsageForPressureLevel:(NIMemoryPressureLevel)level {
+  switch (level) {
+    case NIMemoryPressureLevelNormal:
+      break;
+    case NIMemoryPressureLevelBackground:
+    case NIMemoryPressureLevelWarning:
+      [self trimToNumberOfBytes:self.numberOfBytes / 2];
+      break;
+    case NIMemoryPressureLevelCritical:
+      [self removeAllBuffers];
+      break;
+  }
+}
+
+- (void)didReceiveMemoryPressure:(NSNotification *)notification {
+  [self reduceMemoryUsageForPressureLevel:NIMemoryPressureLevelFromNotification(notification)];
+}
+
+@end
@@ -0,0 +1,115 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+
+/**
+ * For remembering a large set of strings in a small, fixed amount of memory.
+ *
+ * A Bloom filter answers whether it has seen a string before. It never forgets a string it has
+ * seen, but it may claim to have seen a string that it hasn't. In return it uses a handful of
+ * bits per string no matter how long the strings are, which makes it a good fit for negative
+ * caches such as the set of image URLs that recently failed to load.
+ *
+ * @ingroup NimbusCore
+ * @defgroup Bloom-Filters Bloom Filters
+ * @{
+ */
+
+/**
+ * A thread-safe Bloom filter of strings that can forget strings as they age.
+ *
+ * When the filter has a retention interval, its bits are split into generations. Strings are
+ * added to the newest generation and looked up in all of them. Each time a generation's worth
+ * of the retention interval passes, the oldest generation is cleared and becomes the newest.
+ * A string is therefore remembered for at least the retention interval and at most a quarter
+ * longer.
+ */
+@interface NIBloomFilter : NSObject
+
+// Designated initializer.
+- (id)initWithCapacity:(NSUInteger)capacity falsePositiveRate:(double)falsePositiveRate retentionInterval:(NSTimeInterval)retentionInterval;
+
+@property (nonatomic, readonly) NSUInteger capacity;
+@property (nonatomic, readonly) double falsePositiveRate;
+@property (nonatomic, readonly) NSTimeInterval retentionInterval;
+
+- (void)addString:(NSString *)string;
+- (BOOL)mightContainString:(NSString *)string;
+- (void)removeAllStrings;
+
+@end
+
+/**@}*/// End of Bloom Filters ////////////////////////////////////////////////////////////////////
+
+/** @name Creating a Bloom Filter */
+
+/**
+ * Initializes a newly allocated Bloom filter sized for the given number of strings.
+ *
+ * The filter holds its false positive rate until capacity strings have been added within one
+ * generation. Past that the false positive rate climbs but nothing is lost. A retention
+ * interval of 0 means that strings are never forgotten.
+ *
+ * -init creates a filter for 1024 strings with a 1% false positive rate that never forgets.
+ *
+ * @fn NIBloomFilter::initWithCapacity:falsePositiveRate:retentionInterval:
+ */
+
+/**
+ * The number of strings the filter was sized for.
+ *
+ * @fn NIBloomFilter::capacity
+ */
+
+/**
+ * The chance that mightContainString: returns YES for a string that was never added, while the
+ * filter holds no more than capacity strings.
+ *
+ * @fn NIBloomFilter::falsePositiveRate
+ */
+
+/**
+ * The least amount of time that the filter remembers a string for.
+ *
+ * 0 means that strings are remembered until removeAllStrings is called.
+ *
+ * @fn NIBloomFilter::retentionInterval
+ */
+
+/** @name Using a Bloom Filter */
+
+/**
+ * Adds the string to the filter.
+ *
+ * Adding a string that is already in the filter restarts its retention interval.
+ *
+ * @fn NIBloomFilter::addString:
+ */
+
+/**
+ * Returns NO if the string has definitely not been added within the retention interval and
+ * YES if it probably has.
+ *
+ * @fn NIBloomFilter::mightContainString:
+ */
+
+/**
+ * Forgets every string in the filter.
+ *
+ * @fn NIBloomFilter::removeAllStrings
+ */
@@ -0,0 +1,162 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIBloomFilter.h"
+
+#import "NIDebuggingTools.h"
+#import "NIFoundationMethods.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// One generation is always being cleared out, so four generations of the retention interval
+// need five bit arrays.
+static const NSUInteger kNIBloomFilterNumberOfAgingGenerations = 4;
+static const NSUInteger kNIBloomFilterMaxNumberOfHashes = 16;
+
+@implementation NIBloomFilter {
+  uint8_t* _bits;
+  NSUInteger _numberOfGenerations;
+  NSUInteger _numberOfBitsPerGeneration;
+  NSUInteger _numberOfHashes;
+  NSUInteger _indexOfNewestGeneration;
+  NSTimeInterval _generationInterval;
+  NSTimeInterval _newestGenerationStartTime;
+}
+
+- (void)dealloc {
+  free(_bits);
+}
+
+- (id)initWithCapacity:(NSUInteger)capacity falsePositiveRate:(double)falsePositiveRate retentionInterval:(NSTimeInterval)retentionInterval {
+  NIDASSERT(falsePositiveRate > 0 && falsePositiveRate < 1);
+  NIDASSERT(retentionInterval >= 0);
+  if ((self = [super init])) {
+    _capacity = MAX((NSUInteger)1, capacity);
+    _falsePositiveRate = MIN(MAX(falsePositiveRate, 1e-9), 0.5);
+    _retentionInterval = MAX(0, retentionInterval);
+
+    // The optimal filter for n strings at false positive rate p has n * -ln(p) / ln(2)^2 bits
+    // and uses -log2(p) hashes. Rounding the bits up to a power of two turns modulo into a mask.
+    double optimalNumberOfBits = (double)_capacity * -log(_falsePositiveRate) / (M_LN2 * M_LN2);
+    _numberOfBitsPerGeneration = 64;
+    while (_numberOfBitsPerGeneration < optimalNumberOfBits) {
+      _numberOfBitsPerGeneration <<= 1;
+    }
+    _numberOfHashes = (NSUInteger)MAX(1.0, MIN((double)kNIBloomFilterMaxNumberOfHashes,
+                                               round(-log2(_falsePositiveRate))));
+
+    if (_retentionInterval > 0) {
+      _numberOfGenerations = kNIBloomFilterNumberOfAgingGenerations + 1;
+      _generationInterval = _retentionInterval / kNIBloomFilterNumberOfAgingGenerations;
+    } else {
+      _numberOfGenerations = 1;
+    }
+    _bits = calloc(_numberOfGenerations * _numberOfBitsPerGeneration / 8, sizeof(uint8_t));
+    _newestGenerationStartTime = [[NSDate date] timeIntervalSinceReferenceDate];
+  }
+  return self;
+}
+
+- (id)init {
+  return [self initWithCapacity:1024 falsePositiveRate:0.01 retentionInterval:0];
+}
+
+#pragma mark - Private
+
+- (uint8_t *)bitsOfGenerationAtIndex:(NSUInteger)index {
+  return _bits + index * (_numberOfBitsPerGeneration / 8);
+}
+
+// Clears out every generation that has outlived the retention interval.
+- (void)ageGenerations {
+  if (_generationInterval <= 0) {
+    return;
+  }
+  NSTimeInterval now = [[NSDate date] timeIntervalSinceReferenceDate];
+  NSTimeInterval elapsed = now - _newestGenerationStartTime;
+  if (elapsed < _generationInterval) {
+    return;
+  }
+  NSUInteger numberOfElapsedGenerations = (NSUInteger)(elapsed / _generationInterval);
+  NSUInteger numberOfGenerationsToClear = MIN(numberOfElapsedGenerations, _numberOfGenerations);
+  for (NSUInteger ix = 0; ix < numberOfGenerationsToClear; ++ix) {
+    _indexOfNewestGeneration = (_indexOfNewestGeneration + 1) % _numberOfGenerations;
+    memset([self bitsOfGenerationAtIndex:_indexOfNewestGeneration], 0, _numberOfBitsPerGeneration / 8);
+  }
+  _newestGenerationStartTime += numberOfElapsedGenerations * _generationInterval;
+}
+
+// Derives the bit for each hash from two independent halves of one 64-bit hash.
+static inline NSUInteger NIBloomFilterIndexOfBit(uint64_t h1, uint64_t h2, NSUInteger hashIndex, NSUInteger mask) {
+  return (NSUInteger)((h1 + hashIndex * h2) & mask);
+}
+
+#pragma mark - Public
+
+- (void)addString:(NSString *)string {
+  if (nil == string) {
+    return;
+  }
+  uint64_t hash = NIFNVHashFromString(string);
+  uint64_t h1 = hash & 0xFFFFFFFF;
+  uint64_t h2 = (hash >> 32) | 1;
+  NSUInteger mask = _numberOfBitsPerGeneration - 1;
+  @synchronized(self) {
+    [self ageGenerations];
+    uint8_t* bits = [self bitsOfGenerationAtIndex:_indexOfNewestGeneration];
+    for (NSUInteger ix = 0; ix < _numberOfHashes; ++ix) {
+      NSUInteger bit = NIBloomFilterIndexOfBit(h1, h2, ix, mask);
+      bits[bit >> 3] |= (uint8_t)(1 << (bit & 7));
+    }
+  }
+}
+
+- (BOOL)mightContainString:(NSString *)string {
+  if (nil == string) {
+    return NO;
+  }
+  uint64_t hash = NIFNVHashFromString(string);
+  uint64_t h1 = hash & 0xFFFFFFFF;
+  uint64_t h2 = (hash >> 32) | 1;
+  NSUInteger mask = _numberOfBitsPerGeneration - 1;
+  @synchronized(self) {
+    [self ageGenerations];
+    for (NSUInteger generation = 0; generation < _numberOfGenerations; ++generation) {
+      uint8_t* bits = [self bitsOfGenerationAtIndex:generation];
+      BOOL containsString = YES;
+      for (NSUInteger ix = 0; ix < _numberOfHashes && containsString; ++ix) {
+        NSUInteger bit = NIBloomFilterIndexOfBit(h1, h2, ix, mask);
+        containsString = (0 != (bits[bit >> 3] & (1 << (bit & 7))));
+      }
+      if (containsString) {
+        return YES;
+      }
+    }
+  }
+  return NO;
+}
+
+- (void)removeAllStrings {
+  @synchronized(self) {
+    memset(_bits, 0, _numberOfGenerations * _numberOfBitsPerGeneration / 8);
+    _newestGenerationStartTime = [[NSDate date] timeIntervalSinceReferenceDate];
+  }
+}
+
+@end
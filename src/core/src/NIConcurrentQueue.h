@@ -0,0 +1,125 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ * For handing objects from background threads to another thread without taking locks.
+ *
+ * Bursts of work that finishes on background threads, such as console logs or decoded images,
+ * are usually handed to the main thread with one dispatch_async per object. A concurrent
+ * queue collects the objects instead and drains them on the main thread in a single block per
+ * run loop turn.
+ *
+ * @ingroup NimbusCore
+ * @defgroup Concurrent-Queues Concurrent Queues
+ * @{
+ */
+
+/**
+ * A bounded, lock-free queue with a single consumer.
+ *
+ * This class is abstract. Use NISingleProducerQueue when only one thread ever enqueues objects
+ * and NIMultiProducerQueue when any thread may. In both cases only one thread at a time may
+ * dequeue objects.
+ */
+@interface NIConcurrentQueue : NSObject
+
+// Designated initializer.
+- (id)initWithCapacity:(NSUInteger)capacity;
+
+@property (nonatomic, readonly) NSUInteger capacity;
+
+- (BOOL)enqueueObject:(id)object;
+- (id)dequeueObject;
+- (NSArray *)dequeueAllObjects;
+
+@property (copy) void (^mainThreadDrainBlock)(NSArray* objects);
+
+@end
+
+/**
+ * A concurrent queue that one producer thread enqueues objects into.
+ */
+@interface NISingleProducerQueue : NIConcurrentQueue
+@end
+
+/**
+ * A concurrent queue that any number of producer threads enqueue objects into.
+ */
+@interface NIMultiProducerQueue : NIConcurrentQueue
+@end
+
+/**@}*/// End of Concurrent Queues ////////////////////////////////////////////////////////////////
+
+/** @name Creating a Concurrent Queue */
+
+/**
+ * Initializes a newly allocated queue that holds at most the given number of objects.
+ *
+ * The capacity is rounded up to a power of two. All storage is allocated up front.
+ *
+ * @fn NIConcurrentQueue::initWithCapacity:
+ */
+
+/**
+ * The most objects the queue can hold.
+ *
+ * @fn NIConcurrentQueue::capacity
+ */
+
+/** @name Moving Objects through the Queue */
+
+/**
+ * Adds an object to the end of the queue.
+ *
+ * Never blocks. If a mainThreadDrainBlock is set and no drain is pending, a drain is scheduled
+ * on the main queue.
+ *
+ * @returns NO if the queue is full and the object was not added.
+ * @fn NIConcurrentQueue::enqueueObject:
+ */
+
+/**
+ * Removes and returns the object at the front of the queue, or returns nil if it is empty.
+ *
+ * Must only be called from one thread at a time.
+ *
+ * @fn NIConcurrentQueue::dequeueObject
+ */
+
+/**
+ * Removes and returns every object in the queue, oldest first.
+ *
+ * Must only be called from one thread at a time.
+ *
+ * @fn NIConcurrentQueue::dequeueAllObjects
+ */
+
+/** @name Draining on the Main Thread */
+
+/**
+ * A block that is called on the main thread with the objects that have been enqueued.
+ *
+ * However many objects are enqueued before the main queue gets to the drain, they are all
+ * delivered to one call of the block. Setting this makes the main thread the queue's consumer,
+ * so don't dequeue objects anywhere else.
+ *
+ * This may be set from any thread. Objects enqueued while no block is set stay in the queue and
+ * are delivered, in order, once a block is set.
+ *
+ * @fn NIConcurrentQueue::mainThreadDrainBlock
+ */
@@ -0,0 +1,266 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NIConcurrentQueue.h"
+
+#import "NIDebuggingTools.h"
+
+#import <stdatomic.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// Keeps the indexes that producers and consumers write on separate cache lines so that they
+// don't invalidate each other's caches on every operation.
+#define NI_CACHE_LINE_SIZE 64
+
+@interface NIConcurrentQueue()
+@property (nonatomic) NSUInteger capacity;
+- (void)scheduleDrain;
+@end
+
+@implementation NIConcurrentQueue {
+  atomic_bool _drainIsScheduled;
+
+  // Read by producer threads, so only touched while synchronized on self.
+  void (^_mainThreadDrainBlock)(NSArray* objects);
+}
+
+- (id)init {
+  return [self initWithCapacity:1024];
+}
+
+- (id)initWithCapacity:(NSUInteger)capacity {
+  if ((self = [super init])) {
+    NSUInteger roundedCapacity = 2;
+    while (roundedCapacity < capacity) {
+      roundedCapacity <<= 1;
+    }
+    _capacity = roundedCapacity;
+    atomic_init(&_drainIsScheduled, false);
+  }
+  return self;
+}
+
+- (BOOL)enqueueObject:(id)object {
+  // Subclasses must implement this method.
+  NIDASSERT(NO);
+  return NO;
+}
+
+- (id)dequeueObject {
+  // Subclasses must implement this method.
+  NIDASSERT(NO);
+  return nil;
+}
+
+- (NSArray *)dequeueAllObjects {
+  NSMutableArray* objects = [NSMutableArray array];
+  id object = nil;
+  while (nil != (object = [self dequeueObject])) {
+    [objects addObject:object];
+  }
+  return objects;
+}
+
+- (void (^)(NSArray *))mainThreadDrainBlock {
+  @synchronized(self) {
+    return _mainThreadDrainBlock;
+  }
+}
+
+- (void)setMainThreadDrainBlock:(void (^)(NSArray *))mainThreadDrainBlock {
+  @synchronized(self) {
+    _mainThreadDrainBlock = [mainThreadDrainBlock copy];
+  }
+  // Deliver anything that was enqueued before there was a block to deliver it to.
+  [self scheduleDrain];
+}
+
+- (void)scheduleDrain {
+  if (atomic_exchange_explicit(&_drainIsScheduled, true, memory_order_acq_rel)) {
+    return;
+  }
+  if (nil == self.mainThreadDrainBlock) {
+    atomic_store_explicit(&_drainIsScheduled, false, memory_order_release);
+    return;
+  }
+  __weak NIConcurrentQueue* weakSelf = self;
+  dispatch_async(dispatch_get_main_queue(), ^{
+    NIConcurrentQueue* queue = weakSelf;
+    if (nil == queue) {
+      return;
+    }
+    // Clear the flag before draining so that an object enqueued mid-drain schedules the next
+    // drain rather than being stranded.
+    atomic_store_explicit(&queue->_drainIsScheduled, false, memory_order_release);
+    void (^drainBlock)(NSArray*) = queue.mainThreadDrainBlock;
+    if (nil == drainBlock) {
+      // Leave the objects queued for the next block rather than dropping them.
+      return;
+    }
+    // Drains only run on the main queue, so batches are delivered in the order they were
+    // enqueued.
+    NSArray* objects = [queue dequeueAllObjects];
+    if (objects.count > 0) {
+      drainBlock(objects);
+    }
+  });
+}
+
+@end
+
+/**
+ * Lamport's ring buffer. The producer owns the tail and the consumer owns the head, so each
+ * side only reads the other's index.
+ */
+@implementation NISingleProducerQueue {
+  void** _slots;
+  NSUInteger _mask;
+  atomic_size_t _head;
+  uint8_t _headPadding[NI_CACHE_LINE_SIZE - sizeof(atomic_size_t)];
+  atomic_size_t _tail;
+  uint8_t _tailPadding[NI_CACHE_LINE_SIZE - sizeof(atomic_size_t)];
+}
+
+- (void)dealloc {
+  // Release anything still in the queue.
+  while (nil != [self dequeueObject]) {}
+  free(_slots);
+}
+
+- (id)initWithCapacity:(NSUInteger)capacity {
+  if ((self = [super initWithCapacity:capacity])) {
+    _slots = calloc(self.capacity, sizeof(void *));
+    _mask = self.capacity - 1;
+    atomic_init(&_head, 0);
+    atomic_init(&_tail, 0);
+  }
+  return self;
+}
+
+- (BOOL)enqueueObject:(id)object {
+  NIDASSERT(nil != object);
+  if (nil == object) {
+    return NO;
+  }
+  size_t tail = atomic_load_explicit(&_tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&_head, memory_order_acquire);
+  if (tail - head >= self.capacity) {
+    return NO;
+  }
+  _slots[tail & _mask] = (void *)CFBridgingRetain(object);
+  atomic_store_explicit(&_tail, tail + 1, memory_order_release);
+
+  [self scheduleDrain];
+  return YES;
+}
+
+- (id)dequeueObject {
+  size_t head = atomic_load_explicit(&_head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&_tail, memory_order_acquire);
+  if (head == tail) {
+    return nil;
+  }
+  void* slot = _slots[head & _mask];
+  _slots[head & _mask] = NULL;
+  atomic_store_explicit(&_head, head + 1, memory_order_release);
+  return CFBridgingRelease(slot);
+}
+
+@end
+
+// A cell records which lap of the ring it is ready for, which lets producers claim cells with a
+// single compare-and-swap on the enqueue position.
+typedef struct {
+  atomic_size_t sequence;
+  void* object;
+} NIMultiProducerQueueCell;
+
+/**
+ * Dmitry Vyukov's bounded queue, restricted to a single consumer so that dequeuing needs no
+ * compare-and-swap.
+ */
+@implementation NIMultiProducerQueue {
+  NIMultiProducerQueueCell* _cells;
+  NSUInteger _mask;
+  atomic_size_t _enqueuePosition;
+  uint8_t _enqueuePadding[NI_CACHE_LINE_SIZE - sizeof(atomic_size_t)];
+  size_t _dequeuePosition;
+}
+
+- (void)dealloc {
+  while (nil != [self dequeueObject]) {}
+  free(_cells);
+}
+
+- (id)initWithCapacity:(NSUInteger)capacity {
+  if ((self = [super initWithCapacity:capacity])) {
+    _cells = calloc(self.capacity, sizeof(NIMultiProducerQueueCell));
+    _mask = self.capacity - 1;
+    for (NSUInteger ix = 0; ix < self.capacity; ++ix) {
+      atomic_init(&_cells[ix].sequence, ix);
+    }
+    atomic_init(&_enqueuePosition, 0);
+  }
+  return self;
+}
+
+- (BOOL)enqueueObject:(id)object {
+  NIDASSERT(nil != object);
+  if (nil == object) {
+    return NO;
+  }
+  NIMultiProducerQueueCell* cell = NULL;
+  size_t position = atomic_load_explicit(&_enqueuePosition, memory_order_relaxed);
+  while (YES) {
+    cell = &_cells[position & _mask];
+    size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+    if (0 == difference) {
+      if (atomic_compare_exchange_weak_explicit(&_enqueuePosition, &position, position + 1,
+                                                memory_order_relaxed, memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      // The consumer hasn't freed this cell from the previous lap yet.
+      return NO;
+    } else {
+      position = atomic_load_explicit(&_enqueuePosition, memory_order_relaxed);
+    }
+  }
+  cell->object = (void *)CFBridgingRetain(object);
+  atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+
+  [self scheduleDrain];
+  return YES;
+}
+
+- (id)dequeueObject {
+  NIMultiProducerQueueCell* cell = &_cells[_dequeuePosition & _mask];
+  size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+  if (sequence != _dequeuePosition + 1) {
+    return nil;
+  }
+  void* object = cell->object;
+  cell->object = NULL;
+  atomic_store_explicit(&cell->sequence, _dequeuePosition + _mask + 1, memory_order_release);
+  ++_dequeuePosition;
+  return CFBridgingRelease(object);
+}
+
+@end
@@ -71,8 +71,6 @@
  * @{
  */
 
-@class NILinkedListNode;
-
 __NI_DEPRECATED_METHOD // Use NSMutableOrderedSet instead. MAINTENANCE: Remove by Feb 28, 2014.
 @interface NILinkedListLocation : NSObject
 @end
@@ -126,6 +124,7 @@ __NI_DEPRECATED_METHOD // Use NSMutableOrderedSet instead. MAINTENANCE: Remove b
 + (NILinkedList *)linkedListWithArray:(NSArray *)array;
 
 - (id)initWithArray:(NSArray *)anArray;
+- (id)initWithCapacity:(NSUInteger)capacity;
 
 #pragma mark Extended Methods
 
@@ -146,6 +145,7 @@ __NI_DEPRECATED_METHOD // Use NSMutableOrderedSet instead. MAINTENANCE: Remove b
 // TODO (jverkoey August 3, 2011): Consider creating an NIMutableLinkedList implementation.
 
 - (NILinkedListLocation *)addObject:(id)object;
+- (void)appendObject:(id)object;
 - (void)addObjectsFromArray:(NSArray *)array;
 
 - (void)removeAllObjects;
@@ -156,6 +156,147 @@ __NI_DEPRECATED_METHOD // Use NSMutableOrderedSet instead. MAINTENANCE: Remove b
 @end
 
 
+/**
+ * A stable reference to an object in an NIUnrolledLinkedList.
+ *
+ * A location stays valid until its object is removed from the list, even as other objects are
+ * added and removed around it.
+ */
+@interface NIUnrolledLinkedListLocation : NSObject
+@end
+
+/**
+ * An unrolled linked list that stores runs of objects in each node.
+ *
+ * NIUnrolledLinkedList has the same interface and run-time guarantees as NILinkedList, but each
+ * node holds up to 32 objects in a contiguous array. Traversing the list touches one node per
+ * run of objects instead of one per object, and fast enumeration hands out each node's array
+ * directly without copying.
+ *
+ * Objects are only ever appended, so an object never moves to another node. Removing an object
+ * closes the gap within its node, and a node is recycled as soon as it is empty.
+ */
+@interface NIUnrolledLinkedList : NSObject <NSCopying, NSCoding, NSFastEnumeration>
+
+- (NSUInteger)count;
+
+- (id)firstObject;
+- (id)lastObject;
+
+#pragma mark Linked List Creation
+
++ (NIUnrolledLinkedList *)linkedList;
++ (NIUnrolledLinkedList *)linkedListWithArray:(NSArray *)array;
+
+- (id)initWithArray:(NSArray *)anArray;
+- (id)initWithCapacity:(NSUInteger)capacity;
+
+#pragma mark Extended Methods
+
+- (NSArray *)allObjects;
+- (NSEnumerator *)objectEnumerator;
+
+- (BOOL)containsObject:(id)anObject;
+
+- (NSString *)description;
+
+#pragma mark Methods for constant-time access.
+
+- (NIUnrolledLinkedListLocation *)locationOfObject:(id)object;
+- (id)objectAtLocation:(NIUnrolledLinkedListLocation *)location;
+- (void)removeObjectAtLocation:(NIUnrolledLinkedListLocation *)location;
+
+#pragma mark Mutable Operations
+
+- (NIUnrolledLinkedListLocation *)addObject:(id)object;
+- (void)appendObject:(id)object;
+- (void)addObjectsFromArray:(NSArray *)array;
+
+- (void)removeAllObjects;
+- (void)removeObject:(id)object;
+- (void)removeFirstObject;
+- (void)removeLastObject;
+
+@end
+
+
+/**
+ * A fixed-capacity circular buffer of objects.
+ *
+ * Objects can be added and removed at either end in constant time. Once the buffer is full,
+ * adding an object overwrites the object at the other end, which makes the ring buffer a good
+ * fit for sliding windows of history such as the most recent log entries.
+ *
+ * This collection implements NSFastEnumeration and enumerates its objects from first to last
+ * without copying them.
+ */
+@interface NIRingBuffer : NSObject <NSFastEnumeration>
+
+// Designated initializer.
+- (id)initWithCapacity:(NSUInteger)capacity;
+
+@property (nonatomic, readonly) NSUInteger capacity;
+- (NSUInteger)count;
+
+- (id)firstObject;
+- (id)lastObject;
+- (id)objectAtIndex:(NSUInteger)index;
+- (id)objectAtIndexedSubscript:(NSUInteger)index;
+
+- (NSArray *)allObjects;
+- (NSEnumerator *)objectEnumerator;
+
+- (id)addObject:(id)object;
+- (id)prependObject:(id)object;
+
+- (id)removeFirstObject;
+- (id)removeLastObject;
+- (void)removeAllObjects;
+
+@end
+
+
+/**
+ * A stable reference to an object in an NIPriorityQueue.
+ *
+ * Handles let an object be removed or repositioned after its priority changes without
+ * searching the queue for it.
+ */
+@interface NIPriorityQueueHandle : NSObject
+@end
+
+/**
+ * A priority queue backed by a 4-ary heap in a contiguous array.
+ *
+ * The queue orders its objects with a comparator. The first object is one that no other object
+ * in the queue is ordered before, so a comparator that sorts dates in ascending order makes a
+ * queue whose first object is the earliest date.
+ *
+ * A 4-ary heap is half as deep as a binary heap, so removals compare more objects per level
+ * but visit far fewer levels, and the children of each node sit next to each other in memory.
+ */
+@interface NIPriorityQueue : NSObject
+
+// Designated initializer.
+- (id)initWithComparator:(NSComparator)comparator;
+- (id)initWithComparator:(NSComparator)comparator objects:(NSArray *)objects;
+
+- (NSUInteger)count;
+- (id)firstObject;
+- (NSArray *)allObjects;
+
+- (NIPriorityQueueHandle *)addObject:(id)object;
+- (void)addObjectsFromArray:(NSArray *)objects;
+
+- (id)objectWithHandle:(NIPriorityQueueHandle *)handle;
+- (void)updateObjectWithHandle:(NIPriorityQueueHandle *)handle;
+
+- (id)removeFirstObject;
+- (void)removeObjectWithHandle:(NIPriorityQueueHandle *)handle;
+- (void)removeAllObjects;
+
+@end
+
 /**@}*/// End of Data Structures //////////////////////////////////////////////////////////////////
 
 /**
@@ -331,6 +472,18 @@ __NI_DEPRECATED_METHOD // Use NSMutableOrderedSet instead. MAINTENANCE: Remove b
  * @returns A linked list initialized to contain the objects in anArray.
  */
 
+/**
+ * Initializes a newly allocated linked list with room for the given number of objects.
+ *
+ * The linked list keeps its nodes in chunks that it allocates as it grows and reuses nodes
+ * once their objects have been removed. Reserving room up front means a list that never grows
+ * past its capacity never allocates nodes while objects are added and removed.
+ *
+ * @fn NILinkedList::initWithCapacity:
+ * @param capacity The number of objects to reserve room for.
+ * @returns An empty linked list.
+ */
+
 
 /** @name Querying a Linked List */
 
@@ -402,6 +555,17 @@ __NI_DEPRECATED_METHOD // Use NSMutableOrderedSet instead. MAINTENANCE: Remove b
  * @returns A location within the linked list.
  */
 
+/**
+ * Appends an object to the linked list without creating a location for it.
+ *
+ * Use this instead of addObject: when the location isn't needed, such as when the linked list
+ * is used as a queue, to avoid allocating a location object for every object that is added.
+ *
+ *      Run-time: O(1) constant
+ *
+ * @fn NILinkedList::appendObject:
+ */
+
 /**
  * Appends an array of objects to the linked list.
  *
@@ -451,11 +615,8 @@ __NI_DEPRECATED_METHOD // Use NSMutableOrderedSet instead. MAINTENANCE: Remove b
  * Searches for an object in the linked list.
  *
  * The NILinkedListLocation object will remain valid as long as the object is still in the
- * linked list. Once the object is removed from the linked list, however, the location object
- * is released from memory and should no longer be used.
- *
- * TODO (jverkoey July 1, 2011): Consider creating a wrapper object for the location so that
- *                               we can deal with incorrect usage more safely.
+ * linked list. Once the object is removed from the linked list the location no longer refers
+ * to anything, even if the list reuses its storage for another object.
  *
  *      Run-time: O(count) linear
  *
@@ -474,8 +635,8 @@ __NI_DEPRECATED_METHOD // Use NSMutableOrderedSet instead. MAINTENANCE: Remove b
 /**
  * Removes an object at a predetermined location.
  *
- * It is assumed that this location still exists in the linked list. If the object this
- * location refers to has since been removed then this method will have undefined results.
+ * If the object this location refers to has since been removed, or the location belongs to
+ * another linked list, then this method does nothing.
  *
  * This is provided as an optimization over the O(n) removal method but should be used with care.
  *
@@ -483,3 +644,398 @@ __NI_DEPRECATED_METHOD // Use NSMutableOrderedSet instead. MAINTENANCE: Remove b
  *
  * @fn NILinkedList::removeObjectAtLocation:
  */
+
+
+/** @name Creating an Unrolled Linked List */
+
+/**
+ * Returns a newly allocated, empty unrolled linked list.
+ *
+ * @fn NIUnrolledLinkedList::linkedList
+ */
+
+/**
+ * Returns a newly allocated unrolled linked list filled with the objects from an array.
+ *
+ * @fn NIUnrolledLinkedList::linkedListWithArray:
+ */
+
+/**
+ * Initializes a newly allocated unrolled linked list by placing in it the objects from an array.
+ *
+ * @fn NIUnrolledLinkedList::initWithArray:
+ */
+
+/**
+ * Initializes a newly allocated, empty unrolled linked list with enough nodes for the given
+ * number of objects.
+ *
+ * @fn NIUnrolledLinkedList::initWithCapacity:
+ */
+
+/** @name Querying an Unrolled Linked List */
+
+/**
+ * Returns the number of objects currently in the list.
+ *
+ *      Run-time: O(1) constant
+ *
+ * @fn NIUnrolledLinkedList::count
+ */
+
+/**
+ * Returns the first object in the list, or nil if the list is empty.
+ *
+ *      Run-time: O(1) constant
+ *
+ * @fn NIUnrolledLinkedList::firstObject
+ */
+
+/**
+ * Returns the last object in the list, or nil if the list is empty.
+ *
+ *      Run-time: O(1) constant
+ *
+ * @fn NIUnrolledLinkedList::lastObject
+ */
+
+/**
+ * Returns an array containing the list's objects, in order.
+ *
+ *      Run-time: Theta(count) linear
+ *
+ * @fn NIUnrolledLinkedList::allObjects
+ */
+
+/**
+ * Returns an enumerator that visits each object in the list, in order.
+ *
+ * @fn NIUnrolledLinkedList::objectEnumerator
+ */
+
+/**
+ * Returns YES if the list contains the given object, compared by pointer.
+ *
+ *      Run-time: O(count) linear
+ *
+ * @fn NIUnrolledLinkedList::containsObject:
+ */
+
+/**
+ * Returns a string that represents the list's objects as an array.
+ *
+ * @fn NIUnrolledLinkedList::description
+ */
+
+/** @name Adding Objects */
+
+/**
+ * Appends an object to the list and returns its location.
+ *
+ *      Run-time: O(1) constant
+ *
+ * @fn NIUnrolledLinkedList::addObject:
+ * @returns A location that refers to the object for as long as it is in the list.
+ */
+
+/**
+ * Appends an object to the list without creating a location for it.
+ *
+ *      Run-time: O(1) constant
+ *
+ * @fn NIUnrolledLinkedList::appendObject:
+ */
+
+/**
+ * Appends each object in the array to the list, in order.
+ *
+ *      Run-time: Theta(l) linear, where l is the number of objects in the array
+ *
+ * @fn NIUnrolledLinkedList::addObjectsFromArray:
+ */
+
+/** @name Removing Objects */
+
+/**
+ * Removes all objects from the list.
+ *
+ *      Run-time: Theta(count) linear
+ *
+ * @fn NIUnrolledLinkedList::removeAllObjects
+ */
+
+/**
+ * Removes the first occurrence of the object from the list, compared by pointer.
+ *
+ *      Run-time: O(count) linear
+ *
+ * @fn NIUnrolledLinkedList::removeObject:
+ */
+
+/**
+ * Removes the first object from the list.
+ *
+ *      Run-time: O(1) constant
+ *
+ * @fn NIUnrolledLinkedList::removeFirstObject
+ */
+
+/**
+ * Removes the last object from the list.
+ *
+ *      Run-time: O(1) constant
+ *
+ * @fn NIUnrolledLinkedList::removeLastObject
+ */
+
+/** @name Constant-Time Access */
+
+/**
+ * Searches for an object in the list and returns its location, or nil if it isn't in the list.
+ *
+ *      Run-time: O(count) linear
+ *
+ * @fn NIUnrolledLinkedList::locationOfObject:
+ */
+
+/**
+ * Returns the object at the location, or nil if it has been removed from the list.
+ *
+ * Only the location's own node is searched, so this is bounded by the node size.
+ *
+ *      Run-time: O(1) constant
+ *
+ * @fn NIUnrolledLinkedList::objectAtLocation:
+ */
+
+/**
+ * Removes the object at the location.
+ *
+ * Does nothing if the object has already been removed or the location belongs to another list.
+ *
+ *      Run-time: O(1) constant
+ *
+ * @fn NIUnrolledLinkedList::removeObjectAtLocation:
+ */
+
+
+/** @name Creating a Ring Buffer */
+
+/**
+ * Initializes a newly allocated ring buffer that holds at most the given number of objects.
+ *
+ * The storage for every object is allocated up front and the capacity never changes.
+ *
+ * @fn NIRingBuffer::initWithCapacity:
+ */
+
+/** @name Querying a Ring Buffer */
+
+/**
+ * The most objects the ring buffer can hold.
+ *
+ * @fn NIRingBuffer::capacity
+ */
+
+/**
+ * Returns the number of objects currently in the ring buffer.
+ *
+ * @fn NIRingBuffer::count
+ */
+
+/**
+ * Returns the first, or oldest, object in the ring buffer, or nil if it is empty.
+ *
+ * @fn NIRingBuffer::firstObject
+ */
+
+/**
+ * Returns the last, or newest, object in the ring buffer, or nil if it is empty.
+ *
+ * @fn NIRingBuffer::lastObject
+ */
+
+/**
+ * Returns the object at the given index, counting from the first object.
+ *
+ *      Run-time: O(1) constant
+ *
+ * @fn NIRingBuffer::objectAtIndex:
+ * @returns The object at index, or nil if index is beyond the end of the ring buffer.
+ */
+
+/**
+ * Returns the object at the given index, so that ring buffers can be subscripted like arrays.
+ *
+ * @fn NIRingBuffer::objectAtIndexedSubscript:
+ */
+
+/**
+ * Returns an array of the ring buffer's objects from first to last.
+ *
+ * @fn NIRingBuffer::allObjects
+ */
+
+/**
+ * Returns an enumerator over a snapshot of the ring buffer's objects from first to last.
+ *
+ * The ring buffer may be modified while the enumerator is in use.
+ *
+ * @fn NIRingBuffer::objectEnumerator
+ */
+
+/** @name Adding Objects */
+
+/**
+ * Adds an object after the last object.
+ *
+ * If the ring buffer is full, the first object is overwritten.
+ *
+ *      Run-time: O(1) constant
+ *
+ * @fn NIRingBuffer::addObject:
+ * @returns The object that was overwritten, or nil if the ring buffer wasn't full.
+ */
+
+/**
+ * Adds an object before the first object.
+ *
+ * If the ring buffer is full, the last object is overwritten.
+ *
+ *      Run-time: O(1) constant
+ *
+ * @fn NIRingBuffer::prependObject:
+ * @returns The object that was overwritten, or nil if the ring buffer wasn't full.
+ */
+
+/** @name Removing Objects */
+
+/**
+ * Removes and returns the first object, or returns nil if the ring buffer is empty.
+ *
+ *      Run-time: O(1) constant
+ *
+ * @fn NIRingBuffer::removeFirstObject
+ */
+
+/**
+ * Removes and returns the last object, or returns nil if the ring buffer is empty.
+ *
+ *      Run-time: O(1) constant
+ *
+ * @fn NIRingBuffer::removeLastObject
+ */
+
+/**
+ * Removes all objects from the ring buffer.
+ *
+ *      Run-time: Theta(count) linear
+ *
+ * @fn NIRingBuffer::removeAllObjects
+ */
+
+
+/** @name Creating a Priority Queue */
+
+/**
+ * Initializes a newly allocated, empty priority queue that orders its objects with the given
+ * comparator.
+ *
+ * @fn NIPriorityQueue::initWithComparator:
+ */
+
+/**
+ * Initializes a newly allocated priority queue containing the given objects.
+ *
+ * The heap is built in one pass, which is linear in the number of objects rather than the
+ * n log n cost of adding them one at a time.
+ *
+ *      Run-time: O(n) linear
+ *
+ * @fn NIPriorityQueue::initWithComparator:objects:
+ */
+
+/** @name Querying a Priority Queue */
+
+/**
+ * Returns the number of objects in the queue.
+ *
+ * @fn NIPriorityQueue::count
+ */
+
+/**
+ * Returns the object that is ordered first, or nil if the queue is empty.
+ *
+ *      Run-time: O(1) constant
+ *
+ * @fn NIPriorityQueue::firstObject
+ */
+
+/**
+ * Returns the objects in the queue in no particular order.
+ *
+ * @fn NIPriorityQueue::allObjects
+ */
+
+/** @name Adding Objects */
+
+/**
+ * Adds an object to the queue.
+ *
+ *      Run-time: O(log n)
+ *
+ * @fn NIPriorityQueue::addObject:
+ * @returns A handle that refers to the object for as long as it is in the queue.
+ */
+
+/**
+ * Adds the objects in the array to the queue.
+ *
+ * When the array is large compared to the queue, the heap is rebuilt in one pass instead.
+ *
+ * @fn NIPriorityQueue::addObjectsFromArray:
+ */
+
+/** @name Constant-Time Access */
+
+/**
+ * Returns the object the handle refers to, or nil if it is no longer in the queue.
+ *
+ * @fn NIPriorityQueue::objectWithHandle:
+ */
+
+/**
+ * Moves the object the handle refers to after its priority has changed.
+ *
+ * Call this whenever something the comparator looks at changes, in either direction.
+ *
+ *      Run-time: O(log n)
+ *
+ * @fn NIPriorityQueue::updateObjectWithHandle:
+ */
+
+/** @name Removing Objects */
+
+/**
+ * Removes and returns the object that is ordered first, or returns nil if the queue is empty.
+ *
+ *      Run-time: O(log n)
+ *
+ * @fn NIPriorityQueue::removeFirstObject
+ */
+
+/**
+ * Removes the object the handle refers to.
+ *
+ * Does nothing if the object has already been removed or the handle belongs to another queue.
+ *
+ *      Run-time: O(log n)
+ *
+ * @fn NIPriorityQueue::removeObjectWithHandle:
+ */
+
+/**
+ * Removes all objects from the queue.
+ *
+ * @fn NIPriorityQueue::removeAllObjects
+ */
@@ -23,49 +23,71 @@
 #endif
 
 // The internal representation of a single node.
-@interface NILinkedListNode : NSObject
-@property (nonatomic, strong) id object;
-@property (nonatomic, strong) NILinkedListNode* prev;
-@property (nonatomic, strong) NILinkedListNode* next;
-@end
-
-@implementation NILinkedListNode
-@end
+//
+// Nodes are plain structs carved out of chunks that the list owns, so adding and removing
+// objects reuses nodes from a free list rather than allocating. The object is retained by hand
+// because ARC doesn't manage object pointers in structs. The generation is bumped whenever the
+// node is released so that locations can tell a recycled node from the one they were made for.
+typedef struct NILinkedListNode NILinkedListNode;
+struct NILinkedListNode {
+  void* object;
+  NILinkedListNode* prev;
+  NILinkedListNode* next;
+  unsigned long generation;
+};
+
+typedef struct NILinkedListChunk NILinkedListChunk;
+struct NILinkedListChunk {
+  NILinkedListChunk* next;
+  NSUInteger numberOfNodes;
+  NILinkedListNode nodes[];
+};
+
+static const NSUInteger kNILinkedListMinimumChunkSize = 16;
+static const NSUInteger kNILinkedListMaximumChunkSize = 4096;
+
+static inline id NILinkedListNodeObject(NILinkedListNode* node) {
+  return (__bridge id)node->object;
+}
 
-@interface NILinkedListLocation()
+@interface NILinkedListLocation() {
+@public
+  NILinkedListNode* _node;
+  unsigned long _generation;
+}
 
-+ (id)locationWithNode:(NILinkedListNode *)node;
-- (id)initWithNode:(NILinkedListNode *)node;
-@property (nonatomic, weak) NILinkedListNode* node;
++ (id)locationWithList:(NILinkedList *)list node:(NILinkedListNode *)node;
+@property (nonatomic, weak) NILinkedList* list;
 
 @end
 
 @implementation NILinkedListLocation
 
-+ (id)locationWithNode:(NILinkedListNode *)node {
-  return [[self alloc] initWithNode:node];
-}
-
-- (id)initWithNode:(NILinkedListNode *)node {
-  if ((self = [super init])) {
-    _node = node;
-  }
-  return self;
++ (id)locationWithList:(NILinkedList *)list node:(NILinkedListNode *)node {
+  NILinkedListLocation* location = [[self alloc] init];
+  location.list = list;
+  location->_node = node;
+  location->_generation = node->generation;
+  return location;
 }
 
 - (BOOL)isEqual:(id)object {
-  return ([object isKindOfClass:[NILinkedListLocation class]]
-          && [object node] == self.node);
+  if (![object isKindOfClass:[NILinkedListLocation class]]) {
+    return NO;
+  }
+  NILinkedListLocation* location = object;
+  return (location->_node == _node && location->_generation == _generation);
 }
 
 @end
 
 @interface NILinkedList()
 // Exposed so that the linked list enumerator can iterate over the nodes directly.
-@property (nonatomic, readonly, strong) NILinkedListNode* head;
-@property (nonatomic, readonly, strong) NILinkedListNode* tail;
+@property (nonatomic, readonly) NILinkedListNode* head;
+@property (nonatomic, readonly) NILinkedListNode* tail;
 @property (nonatomic) NSUInteger count;
 @property (nonatomic) unsigned long modificationNumber;
+- (NILinkedListNode *)nodeAtLocation:(NILinkedListLocation *)location;
 @end
 
 /**
@@ -93,7 +115,7 @@
 @implementation NILinkedListEnumerator
 
 - (void)dealloc {
-  _iterator = nil;
+  _iterator = NULL;
 }
 
 - (id)initWithLinkedList:(NILinkedList *)ll {
@@ -109,8 +131,8 @@
 
   // Iteration step.
   if (nil != _iterator) {
-    object = _iterator.object;
-    _iterator = _iterator.next;
+    object = NILinkedListNodeObject(_iterator);
+    _iterator = _iterator->next;
 
   // Completion step.
   } else {
@@ -127,10 +149,21 @@
 
 #pragma mark -
 
-@implementation NILinkedList
+@implementation NILinkedList {
+  NILinkedListChunk* _chunks;
+  NILinkedListNode* _freeNodes;
+  NSUInteger _numberOfNodes;
+}
 
 - (void)dealloc {
   [self removeAllObjects];
+
+  NILinkedListChunk* chunk = _chunks;
+  while (NULL != chunk) {
+    NILinkedListChunk* next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
 }
 
 #pragma mark - Linked List Creation
@@ -143,8 +176,17 @@
   return [[[self class] alloc] initWithArray:array];
 }
 
+- (id)initWithCapacity:(NSUInteger)capacity {
+  if ((self = [super init])) {
+    if (capacity > 0) {
+      [self _addChunkWithNumberOfNodes:capacity];
+    }
+  }
+  return self;
+}
+
 - (id)initWithArray:(NSArray *)anArray {
-  if ((self = [self init])) {
+  if ((self = [self initWithCapacity:anArray.count])) {
     for (id object in anArray) {
       [self addObject:object];
     }
@@ -158,32 +200,123 @@
   _count = count;
 }
 
+- (void)_addChunkWithNumberOfNodes:(NSUInteger)numberOfNodes {
+  NILinkedListChunk* chunk = malloc(sizeof(NILinkedListChunk) + numberOfNodes * sizeof(NILinkedListNode));
+  NIDASSERT(NULL != chunk);
+  if (NULL == chunk) {
+    return; // COV_NF_LINE
+  }
+  chunk->numberOfNodes = numberOfNodes;
+  chunk->next = _chunks;
+  _chunks = chunk;
+  _numberOfNodes += numberOfNodes;
+
+  // Thread the new nodes onto the free list in order so that consecutive adds use adjacent
+  // memory.
+  for (NSUInteger ix = numberOfNodes; ix > 0; --ix) {
+    NILinkedListNode* node = &chunk->nodes[ix - 1];
+    node->object = NULL;
+    node->prev = NULL;
+    node->generation = 0;
+    node->next = _freeNodes;
+    _freeNodes = node;
+  }
+}
+
+- (NILinkedListNode *)_newNodeWithObject:(id)object {
+  if (NULL == _freeNodes) {
+    // Grow geometrically so that long lists only need a handful of chunks.
+    NSUInteger numberOfNodes = MIN(MAX(_numberOfNodes, kNILinkedListMinimumChunkSize),
+                                   kNILinkedListMaximumChunkSize);
+    [self _addChunkWithNumberOfNodes:numberOfNodes];
+    if (NULL == _freeNodes) {
+      return NULL; // COV_NF_LINE
+    }
+  }
+  NILinkedListNode* node = _freeNodes;
+  _freeNodes = node->next;
+
+  node->object = (void *)CFBridgingRetain(object);
+  node->prev = NULL;
+  node->next = NULL;
+  return node;
+}
+
+- (void)_releaseNode:(NILinkedListNode *)node {
+  CFRelease(node->object);
+  node->object = NULL;
+  node->prev = NULL;
+  ++node->generation;
+
+  node->next = _freeNodes;
+  _freeNodes = node;
+}
+
+- (NILinkedListNode *)_appendObject:(id)object {
+  // nil objects can not be added to a linked list.
+  NIDASSERT(nil != object);
+  if (nil == object) {
+    return NULL;
+  }
+
+  NILinkedListNode* node = [self _newNodeWithObject:object];
+  if (NULL == node) {
+    return NULL; // COV_NF_LINE
+  }
+
+  // Empty condition.
+  if (NULL == _tail) {
+    _head = node;
+    _tail = node;
+
+  } else {
+    // Non-empty condition.
+    _tail->next = node;
+    node->prev = _tail;
+    _tail = node;
+  }
+
+  ++_count;
+  ++_modificationNumber;
+
+  return node;
+}
+
 - (void)_removeNode:(NILinkedListNode *)node {
-  if (nil == node) {
+  if (NULL == node) {
     return;
   }
 
-  if (nil != node.prev) {
-    node.prev.next = node.next;
+  if (NULL != node->prev) {
+    node->prev->next = node->next;
 
   } else {
-    _head = node.next;
+    _head = node->next;
   }
 
-  if (nil != node.next) {
-    node.next.prev = node.prev;
+  if (NULL != node->next) {
+    node->next->prev = node->prev;
 
   } else {
-    _tail = node.prev;
+    _tail = node->prev;
   }
 
-  node.next = nil;
-  node.prev = nil;
+  [self _releaseNode:node];
 
   --_count;
   ++_modificationNumber;
 }
 
+// Returns the node a location refers to, or NULL if the location is stale or belongs to
+// another list.
+- (NILinkedListNode *)nodeAtLocation:(NILinkedListLocation *)location {
+  if (nil == location || location.list != self) {
+    return NULL;
+  }
+  NILinkedListNode* node = location->_node;
+  return (node->generation == location->_generation) ? node : NULL;
+}
+
 #pragma mark - NSCopying
 
 - (id)copyWithZone:(NSZone *)zone {
@@ -191,13 +324,11 @@
 
   NILinkedListNode* node = _head;
 
-  while (0 != node) {
-    [copy addObject:node.object];
-    node = node.next;
+  while (NULL != node) {
+    [copy appendObject:NILinkedListNodeObject(node)];
+    node = node->next;
   }
 
-  copy.count = self.count;
-
   return copy;
 }
 
@@ -207,9 +338,9 @@
   [coder encodeValueOfObjCType:@encode(NSUInteger) at:&_count];
 
   NILinkedListNode* node = _head;
-  while (0 != node) {
-    [coder encodeObject:node.object];
-    node = node.next;
+  while (NULL != node) {
+    [coder encodeObject:NILinkedListNodeObject(node)];
+    node = node->next;
   }
 }
 
@@ -223,7 +354,7 @@
     for (NSUInteger ix = 0; ix < count; ++ix) {
       id object = [decoder decodeObject];
 
-      [self addObject:object];
+      [self appendObject:object];
     }
 
     // Sanity check.
@@ -247,7 +378,7 @@
   NSUInteger numberOfItemsReturned = 0;
 
   // If there is no _tail (i.e. this is an empty list) then this will end immediately.
-  if ((void *)state->state != (__bridge void *)_tail) {
+  if ((void *)state->state != (void *)_tail) {
     state->itemsPtr = stackbuf;
 
     if (0 == state->state) {
@@ -260,9 +391,9 @@
 
     // Return *at most* the number of request objects.
     while ((0 != state->state) && (numberOfItemsReturned < len)) {
-      NILinkedListNode* node = (__bridge NILinkedListNode *)(void *)state->state;
-      stackbuf[numberOfItemsReturned] = node.object;
-      state->state = (unsigned long)node.next;
+      NILinkedListNode* node = (NILinkedListNode *)state->state;
+      stackbuf[numberOfItemsReturned] = NILinkedListNodeObject(node);
+      state->state = (unsigned long)node->next;
       ++numberOfItemsReturned;
     }
 
@@ -282,11 +413,11 @@
 #pragma mark - Public
 
 - (id)firstObject {
-  return (nil != _head) ? _head.object : nil;
+  return (NULL != _head) ? NILinkedListNodeObject(_head) : nil;
 }
 
 - (id)lastObject {
-  return (nil != _tail) ? _tail.object : nil;
+  return (NULL != _tail) ? NILinkedListNodeObject(_tail) : nil;
 }
 
 #pragma mark - Extended Methods
@@ -318,7 +449,8 @@
 }
 
 - (id)objectAtLocation:(NILinkedListLocation *)location {
-  return location.node.object;
+  NILinkedListNode* node = [self nodeAtLocation:location];
+  return (NULL != node) ? NILinkedListNodeObject(node) : nil;
 }
 
 - (NSEnumerator *)objectEnumerator {
@@ -327,13 +459,13 @@
 
 - (NILinkedListLocation *)locationOfObject:(id)object {
   NILinkedListNode* node = _head;
-  while (0 != node) {
-    if (node.object == object) {
-      return [NILinkedListLocation locationWithNode:node];
+  while (NULL != node) {
+    if (NILinkedListNodeObject(node) == object) {
+      return [NILinkedListLocation locationWithList:self node:node];
     }
-    node = node.next;
+    node = node->next;
   }
-  return 0;
+  return nil;
 }
 
 - (void)removeObjectAtLocation:(NILinkedListLocation *)location {
@@ -341,40 +473,21 @@
     return;
   }
 
-  [self _removeNode:location.node];
+  [self _removeNode:[self nodeAtLocation:location]];
 }
 
 - (NILinkedListLocation *)addObject:(id)object {
-  // nil objects can not be added to a linked list.
-  NIDASSERT(nil != object);
-  if (nil == object) {
-    return nil;
-  }
-
-  NILinkedListNode* node = [[NILinkedListNode alloc] init];
-  node.object = object;
-
-  // Empty condition.
-  if (nil == _tail) {
-    _head = node;
-    _tail = node;
-
-  } else {
-    // Non-empty condition.
-    _tail.next = node;
-    node.prev = _tail;
-    _tail = node;
-  }
-
-  ++self.count;
-  ++_modificationNumber;
+  NILinkedListNode* node = [self _appendObject:object];
+  return (NULL != node) ? [NILinkedListLocation locationWithList:self node:node] : nil;
+}
 
-  return [NILinkedListLocation locationWithNode:node];
+- (void)appendObject:(id)object {
+  [self _appendObject:object];
 }
 
 - (void)addObjectsFromArray:(NSArray *)array {
   for (id object in array) {
-    [self addObject:object];
+    [self appendObject:object];
   }
 }
 
@@ -382,24 +495,27 @@
 
 - (void)removeAllObjects {
   NILinkedListNode* node = _head;
-  while (nil != node) {
-    NILinkedListNode* next = node.next;
-    node.prev = nil;
-    node.next = nil;
+  while (NULL != node) {
+    NILinkedListNode* next = node->next;
+    [self _releaseNode:node];
     node = next;
   }
 
-  _head = nil;
-  _tail = nil;
-  
+  _head = NULL;
+  _tail = NULL;
+
   self.count = 0;
   ++_modificationNumber;
 }
 
 - (void)removeObject:(id)object {
-  NILinkedListLocation* location = [self locationOfObject:object];
-  if (0 != location) {
-    [self removeObjectAtLocation:location];
+  NILinkedListNode* node = _head;
+  while (NULL != node) {
+    if (NILinkedListNodeObject(node) == object) {
+      [self _removeNode:node];
+      return;
+    }
+    node = node->next;
   }
 }
 
@@ -412,3 +528,875 @@
 }
 
 @end
+
+
+// The internal representation of a single unrolled node.
+//
+// Objects occupy the slots [start, end) and are retained by hand like NILinkedList's nodes.
+// Each object carries a serial number that is unique within its list; locations remember the
+// node and serial number, so a location can find its object after the objects around it are
+// removed and can tell when its own object is gone. Objects are only appended, so they never
+// move between nodes and serial numbers increase from start to end.
+enum {
+  kNIUnrolledLinkedListNodeCapacity = 32,
+};
+
+typedef struct NIUnrolledLinkedListNode NIUnrolledLinkedListNode;
+struct NIUnrolledLinkedListNode {
+  NIUnrolledLinkedListNode* prev;
+  NIUnrolledLinkedListNode* next;
+  NSUInteger start;
+  NSUInteger end;
+  void* objects[kNIUnrolledLinkedListNodeCapacity];
+  unsigned long long serials[kNIUnrolledLinkedListNodeCapacity];
+};
+
+static inline id NIUnrolledLinkedListNodeObject(NIUnrolledLinkedListNode* node, NSUInteger index) {
+  return (__bridge id)node->objects[index];
+}
+
+@interface NIUnrolledLinkedListLocation() {
+@public
+  NIUnrolledLinkedListNode* _node;
+  unsigned long long _serial;
+}
+
++ (id)locationWithList:(NIUnrolledLinkedList *)list
+                  node:(NIUnrolledLinkedListNode *)node
+                 index:(NSUInteger)index;
+@property (nonatomic, weak) NIUnrolledLinkedList* list;
+
+@end
+
+@implementation NIUnrolledLinkedListLocation
+
++ (id)locationWithList:(NIUnrolledLinkedList *)list
+                  node:(NIUnrolledLinkedListNode *)node
+                 index:(NSUInteger)index {
+  NIUnrolledLinkedListLocation* location = [[self alloc] init];
+  location.list = list;
+  location->_node = node;
+  location->_serial = node->serials[index];
+  return location;
+}
+
+- (BOOL)isEqual:(id)object {
+  if (![object isKindOfClass:[NIUnrolledLinkedListLocation class]]) {
+    return NO;
+  }
+  NIUnrolledLinkedListLocation* location = object;
+  return (location.list == self.list && location->_serial == _serial);
+}
+
+- (NSUInteger)hash {
+  return (NSUInteger)_serial;
+}
+
+@end
+
+@interface NIUnrolledLinkedList()
+// Exposed so that the enumerator can iterate over the nodes directly.
+@property (nonatomic, readonly) NIUnrolledLinkedListNode* head;
+@end
+
+/**
+ * @internal
+ *
+ * An implementation of NSEnumerator for NIUnrolledLinkedList.
+ *
+ * The list is retained until the enumerator has returned its last object.
+ */
+@interface NIUnrolledLinkedListEnumerator : NSEnumerator {
+@private
+  NIUnrolledLinkedList* _ll;
+  NIUnrolledLinkedListNode* _node;
+  NSUInteger _index;
+}
+
+/**
+ * Designated initializer. Retains the linked list.
+ */
+- (id)initWithLinkedList:(NIUnrolledLinkedList *)ll;
+
+@end
+
+@implementation NIUnrolledLinkedListEnumerator
+
+- (id)initWithLinkedList:(NIUnrolledLinkedList *)ll {
+  if ((self = [super init])) {
+    _ll = ll;
+    _node = ll.head;
+    _index = (NULL != _node) ? _node->start : 0;
+  }
+  return self;
+}
+
+- (id)nextObject {
+  if (NULL == _node) {
+    _ll = nil;
+    return nil;
+  }
+
+  id object = NIUnrolledLinkedListNodeObject(_node, _index);
+  ++_index;
+  if (_index >= _node->end) {
+    _node = _node->next;
+    _index = (NULL != _node) ? _node->start : 0;
+  }
+  return object;
+}
+
+@end
+
+#pragma mark -
+
+@implementation NIUnrolledLinkedList {
+  NIUnrolledLinkedListNode* _tail;
+  NIUnrolledLinkedListNode* _freeNodes;
+  NSUInteger _count;
+  unsigned long long _nextSerial;
+  unsigned long _modificationNumber;
+}
+
+- (void)dealloc {
+  [self removeAllObjects];
+
+  // Every node is on the free list once the list is empty.
+  NIUnrolledLinkedListNode* node = _freeNodes;
+  while (NULL != node) {
+    NIUnrolledLinkedListNode* next = node->next;
+    free(node);
+    node = next;
+  }
+}
+
+#pragma mark - Linked List Creation
+
++ (NIUnrolledLinkedList *)linkedList {
+  return [[[self class] alloc] init];
+}
+
++ (NIUnrolledLinkedList *)linkedListWithArray:(NSArray *)array {
+  return [[[self class] alloc] initWithArray:array];
+}
+
+- (id)initWithCapacity:(NSUInteger)capacity {
+  if ((self = [super init])) {
+    NSUInteger numberOfNodes = ((capacity + kNIUnrolledLinkedListNodeCapacity - 1)
+                                / kNIUnrolledLinkedListNodeCapacity);
+    for (NSUInteger ix = 0; ix < numberOfNodes; ++ix) {
+      NIUnrolledLinkedListNode* node = malloc(sizeof(NIUnrolledLinkedListNode));
+      NIDASSERT(NULL != node);
+      if (NULL == node) {
+        break; // COV_NF_LINE
+      }
+      node->next = _freeNodes;
+      _freeNodes = node;
+    }
+  }
+  return self;
+}
+
+- (id)init {
+  return [self initWithCapacity:0];
+}
+
+- (id)initWithArray:(NSArray *)anArray {
+  if ((self = [self initWithCapacity:anArray.count])) {
+    [self addObjectsFromArray:anArray];
+  }
+  return self;
+}
+
+#pragma mark - Private
+
+- (NIUnrolledLinkedListNode *)_newTailNode {
+  NIUnrolledLinkedListNode* node = _freeNodes;
+  if (NULL != node) {
+    _freeNodes = node->next;
+
+  } else {
+    node = malloc(sizeof(NIUnrolledLinkedListNode));
+    NIDASSERT(NULL != node);
+    if (NULL == node) {
+      return NULL; // COV_NF_LINE
+    }
+  }
+
+  node->start = 0;
+  node->end = 0;
+  node->next = NULL;
+  node->prev = _tail;
+  if (NULL != _tail) {
+    _tail->next = node;
+
+  } else {
+    _head = node;
+  }
+  _tail = node;
+  return node;
+}
+
+- (NIUnrolledLinkedListNode *)_appendObject:(id)object {
+  // nil objects can not be added to a linked list.
+  NIDASSERT(nil != object);
+  if (nil == object) {
+    return NULL;
+  }
+
+  NIUnrolledLinkedListNode* node = _tail;
+  if (NULL == node || node->end >= kNIUnrolledLinkedListNodeCapacity) {
+    node = [self _newTailNode];
+    if (NULL == node) {
+      return NULL; // COV_NF_LINE
+    }
+  }
+
+  node->objects[node->end] = (void *)CFBridgingRetain(object);
+  node->serials[node->end] = ++_nextSerial;
+  ++node->end;
+
+  ++_count;
+  ++_modificationNumber;
+
+  return node;
+}
+
+- (void)_removeObjectInNode:(NIUnrolledLinkedListNode *)node atIndex:(NSUInteger)index {
+  CFRelease(node->objects[index]);
+
+  // Removing from either end of a node is constant time, which keeps removeFirstObject and
+  // removeLastObject cheap. Anything else closes the gap within this node only.
+  if (index == node->start) {
+    ++node->start;
+
+  } else {
+    NSUInteger numberOfTrailingObjects = node->end - index - 1;
+    memmove(&node->objects[index], &node->objects[index + 1],
+            numberOfTrailingObjects * sizeof(void *));
+    memmove(&node->serials[index], &node->serials[index + 1],
+            numberOfTrailingObjects * sizeof(unsigned long long));
+    --node->end;
+  }
+
+  if (node->start == node->end) {
+    if (NULL != node->prev) {
+      node->prev->next = node->next;
+
+    } else {
+      _head = node->next;
+    }
+    if (NULL != node->next) {
+      node->next->prev = node->prev;
+
+    } else {
+      _tail = node->prev;
+    }
+
+    node->prev = NULL;
+    node->next = _freeNodes;
+    _freeNodes = node;
+  }
+
+  --_count;
+  ++_modificationNumber;
+}
+
+// Returns the index of the location's object within its node, or NSNotFound if the location
+// belongs to another list or its object has been removed.
+- (NSUInteger)_indexOfLocation:(NIUnrolledLinkedListLocation *)location {
+  if (nil == location || location.list != self) {
+    return NSNotFound;
+  }
+  NIUnrolledLinkedListNode* node = location->_node;
+  for (NSUInteger ix = node->start; ix < node->end; ++ix) {
+    if (node->serials[ix] == location->_serial) {
+      return ix;
+    }
+  }
+  return NSNotFound;
+}
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone {
+  NIUnrolledLinkedList* copy = [[[self class] allocWithZone:zone] initWithCapacity:_count];
+
+  for (id object in self) {
+    [copy appendObject:object];
+  }
+
+  return copy;
+}
+
+#pragma mark - NSCoding
+
+- (void)encodeWithCoder:(NSCoder *)coder {
+  [coder encodeValueOfObjCType:@encode(NSUInteger) at:&_count];
+
+  for (id object in self) {
+    [coder encodeObject:object];
+  }
+}
+
+- (id)initWithCoder:(NSCoder *)decoder {
+  NSUInteger count = 0;
+  [decoder decodeValueOfObjCType:@encode(NSUInteger) at:&count];
+
+  if ((self = [self initWithCapacity:count])) {
+    for (NSUInteger ix = 0; ix < count; ++ix) {
+      [self appendObject:[decoder decodeObject]];
+    }
+
+    // Sanity check.
+    NIDASSERT(count == _count);
+  }
+  return self;
+}
+
+#pragma mark - NSFastEnumeration
+
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state
+                                  objects:(__unsafe_unretained id *)stackbuf
+                                    count:(NSUInteger)len {
+  if (0 == state->state) {
+    state->mutationsPtr = &_modificationNumber;
+    state->state = 1;
+    state->extra[0] = (unsigned long)_head;
+  }
+
+  // Hand out each node's objects directly, one node per call. Active nodes are never empty.
+  NIUnrolledLinkedListNode* node = (NIUnrolledLinkedListNode *)state->extra[0];
+  if (NULL == node) {
+    return 0;
+  }
+  state->itemsPtr = (__unsafe_unretained id *)(void *)&node->objects[node->start];
+  state->extra[0] = (unsigned long)node->next;
+  return node->end - node->start;
+}
+
+#pragma mark - Public
+
+- (NSUInteger)count {
+  return _count;
+}
+
+- (id)firstObject {
+  return (NULL != _head) ? NIUnrolledLinkedListNodeObject(_head, _head->start) : nil;
+}
+
+- (id)lastObject {
+  return (NULL != _tail) ? NIUnrolledLinkedListNodeObject(_tail, _tail->end - 1) : nil;
+}
+
+#pragma mark - Extended Methods
+
+- (NSArray *)allObjects {
+  NSMutableArray* mutableArrayOfObjects = [[NSMutableArray alloc] initWithCapacity:_count];
+
+  for (NIUnrolledLinkedListNode* node = _head; NULL != node; node = node->next) {
+    [mutableArrayOfObjects addObjectsFromArray:
+     [NSArray arrayWithObjects:(__unsafe_unretained id *)(void *)&node->objects[node->start]
+                         count:node->end - node->start]];
+  }
+
+  return [mutableArrayOfObjects copy];
+}
+
+- (BOOL)containsObject:(id)anObject {
+  return (nil != [self locationOfObject:anObject]);
+}
+
+- (NSString *)description {
+  return [[self allObjects] description];
+}
+
+- (id)objectAtLocation:(NIUnrolledLinkedListLocation *)location {
+  NSUInteger index = [self _indexOfLocation:location];
+  return (NSNotFound != index) ? NIUnrolledLinkedListNodeObject(location->_node, index) : nil;
+}
+
+- (NSEnumerator *)objectEnumerator {
+  return [[NIUnrolledLinkedListEnumerator alloc] initWithLinkedList:self];
+}
+
+- (NIUnrolledLinkedListLocation *)locationOfObject:(id)object {
+  for (NIUnrolledLinkedListNode* node = _head; NULL != node; node = node->next) {
+    for (NSUInteger ix = node->start; ix < node->end; ++ix) {
+      if (node->objects[ix] == (__bridge void *)object) {
+        return [NIUnrolledLinkedListLocation locationWithList:self node:node index:ix];
+      }
+    }
+  }
+  return nil;
+}
+
+- (void)removeObjectAtLocation:(NIUnrolledLinkedListLocation *)location {
+  NSUInteger index = [self _indexOfLocation:location];
+  if (NSNotFound != index) {
+    [self _removeObjectInNode:location->_node atIndex:index];
+  }
+}
+
+- (NIUnrolledLinkedListLocation *)addObject:(id)object {
+  NIUnrolledLinkedListNode* node = [self _appendObject:object];
+  return ((NULL != node)
+          ? [NIUnrolledLinkedListLocation locationWithList:self node:node index:node->end - 1]
+          : nil);
+}
+
+- (void)appendObject:(id)object {
+  [self _appendObject:object];
+}
+
+- (void)addObjectsFromArray:(NSArray *)array {
+  for (id object in array) {
+    [self appendObject:object];
+  }
+}
+
+#pragma mark - Mutable Methods
+
+- (void)removeAllObjects {
+  NIUnrolledLinkedListNode* node = _head;
+  while (NULL != node) {
+    NIUnrolledLinkedListNode* next = node->next;
+    for (NSUInteger ix = node->start; ix < node->end; ++ix) {
+      CFRelease(node->objects[ix]);
+    }
+    // An empty range keeps locations into this node from finding their released objects.
+    node->start = node->end = 0;
+    node->prev = NULL;
+    node->next = _freeNodes;
+    _freeNodes = node;
+    node = next;
+  }
+
+  _head = NULL;
+  _tail = NULL;
+
+  _count = 0;
+  ++_modificationNumber;
+}
+
+- (void)removeObject:(id)object {
+  for (NIUnrolledLinkedListNode* node = _head; NULL != node; node = node->next) {
+    for (NSUInteger ix = node->start; ix < node->end; ++ix) {
+      if (node->objects[ix] == (__bridge void *)object) {
+        [self _removeObjectInNode:node atIndex:ix];
+        return;
+      }
+    }
+  }
+}
+
+- (void)removeFirstObject {
+  if (NULL != _head) {
+    [self _removeObjectInNode:_head atIndex:_head->start];
+  }
+}
+
+- (void)removeLastObject {
+  if (NULL != _tail) {
+    [self _removeObjectInNode:_tail atIndex:_tail->end - 1];
+  }
+}
+
+@end
+
+
+@implementation NIRingBuffer {
+  __strong id* _objects;
+  NSUInteger _start;
+  NSUInteger _count;
+  unsigned long _modificationNumber;
+}
+
+- (void)dealloc {
+  // ARC doesn't release objects in malloc'd storage on its own.
+  [self removeAllObjects];
+  free((void *)_objects);
+}
+
+- (id)init {
+  return [self initWithCapacity:16];
+}
+
+- (id)initWithCapacity:(NSUInteger)capacity {
+  NIDASSERT(capacity > 0);
+  if ((self = [super init])) {
+    _capacity = MAX(capacity, (NSUInteger)1);
+    _objects = (__strong id *)calloc(_capacity, sizeof(id));
+  }
+  return self;
+}
+
+#pragma mark - Private
+
+// Maps an index counted from the first object onto a slot in the storage.
+- (NSUInteger)slotForIndex:(NSUInteger)index {
+  NSUInteger slot = _start + index;
+  return (slot >= _capacity) ? slot - _capacity : slot;
+}
+
+#pragma mark - NSFastEnumeration
+
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state
+                                  objects:(__unsafe_unretained id *)stackbuf
+                                    count:(NSUInteger)len {
+  if (0 == state->state) {
+    state->mutationsPtr = &_modificationNumber;
+    state->state = 1;
+    state->extra[0] = 0;
+  }
+
+  // Hand out the storage directly. The objects wrap around at most once, so this takes at
+  // most two calls.
+  NSUInteger index = state->extra[0];
+  if (index >= _count) {
+    return 0;
+  }
+  NSUInteger slot = [self slotForIndex:index];
+  NSUInteger numberOfItemsReturned = MIN(_count - index, _capacity - slot);
+  state->itemsPtr = (__unsafe_unretained id *)(void *)(_objects + slot);
+  state->extra[0] = index + numberOfItemsReturned;
+  return numberOfItemsReturned;
+}
+
+#pragma mark - Public
+
+- (NSUInteger)count {
+  return _count;
+}
+
+- (id)firstObject {
+  return (_count > 0) ? _objects[_start] : nil;
+}
+
+- (id)lastObject {
+  return (_count > 0) ? _objects[[self slotForIndex:_count - 1]] : nil;
+}
+
+- (id)objectAtIndex:(NSUInteger)index {
+  NIDASSERT(index < _count);
+  if (index >= _count) {
+    return nil;
+  }
+  return _objects[[self slotForIndex:index]];
+}
+
+- (id)objectAtIndexedSubscript:(NSUInteger)index {
+  return [self objectAtIndex:index];
+}
+
+- (NSArray *)allObjects {
+  NSMutableArray* objects = [NSMutableArray arrayWithCapacity:_count];
+  for (id object in self) {
+    [objects addObject:object];
+  }
+  return [objects copy];
+}
+
+- (NSEnumerator *)objectEnumerator {
+  return [[self allObjects] objectEnumerator];
+}
+
+- (id)addObject:(id)object {
+  NIDASSERT(nil != object);
+  if (nil == object) {
+    return nil;
+  }
+
+  id overwrittenObject = nil;
+  if (_count == _capacity) {
+    overwrittenObject = _objects[_start];
+    _objects[_start] = object;
+    _start = [self slotForIndex:1];
+
+  } else {
+    _objects[[self slotForIndex:_count]] = object;
+    ++_count;
+  }
+  ++_modificationNumber;
+  return overwrittenObject;
+}
+
+- (id)prependObject:(id)object {
+  NIDASSERT(nil != object);
+  if (nil == object) {
+    return nil;
+  }
+
+  id overwrittenObject = nil;
+  _start = [self slotForIndex:_capacity - 1];
+  if (_count == _capacity) {
+    // The slot before the first object is the last object's slot.
+    overwrittenObject = _objects[_start];
+
+  } else {
+    ++_count;
+  }
+  _objects[_start] = object;
+  ++_modificationNumber;
+  return overwrittenObject;
+}
+
+- (id)removeFirstObject {
+  if (0 == _count) {
+    return nil;
+  }
+  id object = _objects[_start];
+  _objects[_start] = nil;
+  _start = [self slotForIndex:1];
+  --_count;
+  ++_modificationNumber;
+  return object;
+}
+
+- (id)removeLastObject {
+  if (0 == _count) {
+    return nil;
+  }
+  NSUInteger slot = [self slotForIndex:_count - 1];
+  id object = _objects[slot];
+  _objects[slot] = nil;
+  --_count;
+  ++_modificationNumber;
+  return object;
+}
+
+- (void)removeAllObjects {
+  for (NSUInteger ix = 0; ix < _count; ++ix) {
+    _objects[[self slotForIndex:ix]] = nil;
+  }
+  _start = 0;
+  _count = 0;
+  ++_modificationNumber;
+}
+
+@end
+
+
+static const NSUInteger kNIPriorityQueueArity = 4;
+static const NSUInteger kNIPriorityQueueMinimumCapacity = 16;
+
+@interface NIPriorityQueueHandle() {
+@public
+  id _object;
+  NSUInteger _index;
+  __unsafe_unretained NIPriorityQueue* _queue;
+}
+@end
+
+@implementation NIPriorityQueueHandle
+@end
+
+@implementation NIPriorityQueue {
+  NSComparator _comparator;
+  __strong NIPriorityQueueHandle** _handles;
+  NSUInteger _count;
+  NSUInteger _capacity;
+}
+
+- (void)dealloc {
+  [self removeAllObjects];
+  free((void *)_handles);
+}
+
+- (id)initWithComparator:(NSComparator)comparator {
+  NIDASSERT(nil != comparator);
+  if ((self = [super init])) {
+    _comparator = [comparator copy];
+  }
+  return self;
+}
+
+- (id)initWithComparator:(NSComparator)comparator objects:(NSArray *)objects {
+  if ((self = [self initWithComparator:comparator])) {
+    [self addObjectsFromArray:objects];
+  }
+  return self;
+}
+
+#pragma mark - Private
+
+- (void)_ensureCapacity:(NSUInteger)capacity {
+  if (capacity <= _capacity) {
+    return;
+  }
+  NSUInteger newCapacity = MAX(_capacity, kNIPriorityQueueMinimumCapacity);
+  while (newCapacity < capacity) {
+    newCapacity *= 2;
+  }
+  // Moving strong references with realloc is fine because ownership moves with them, but the
+  // new slots must start out nil.
+  _handles = (__strong NIPriorityQueueHandle **)realloc((void *)_handles, newCapacity * sizeof(NIPriorityQueueHandle *));
+  memset((void *)(_handles + _capacity), 0, (newCapacity - _capacity) * sizeof(NIPriorityQueueHandle *));
+  _capacity = newCapacity;
+}
+
+- (BOOL)_handle:(NIPriorityQueueHandle *)handle1 isOrderedBeforeHandle:(NIPriorityQueueHandle *)handle2 {
+  return NSOrderedAscending == _comparator(handle1->_object, handle2->_object);
+}
+
+- (void)_placeHandle:(NIPriorityQueueHandle *)handle atIndex:(NSUInteger)index {
+  _handles[index] = handle;
+  handle->_index = index;
+}
+
+// Both sifts lift the handle out and move the others into the hole, which halves the writes
+// compared to swapping at every level.
+- (NSUInteger)_siftUpFromIndex:(NSUInteger)index {
+  NIPriorityQueueHandle* handle = _handles[index];
+  while (index > 0) {
+    NSUInteger parent = (index - 1) / kNIPriorityQueueArity;
+    if (![self _handle:handle isOrderedBeforeHandle:_handles[parent]]) {
+      break;
+    }
+    [self _placeHandle:_handles[parent] atIndex:index];
+    index = parent;
+  }
+  [self _placeHandle:handle atIndex:index];
+  return index;
+}
+
+- (void)_siftDownFromIndex:(NSUInteger)index {
+  NIPriorityQueueHandle* handle = _handles[index];
+  while (YES) {
+    NSUInteger firstChild = index * kNIPriorityQueueArity + 1;
+    if (firstChild >= _count) {
+      break;
+    }
+    NSUInteger lastChild = MIN(firstChild + kNIPriorityQueueArity, _count);
+    NSUInteger best = firstChild;
+    for (NSUInteger child = firstChild + 1; child < lastChild; ++child) {
+      if ([self _handle:_handles[child] isOrderedBeforeHandle:_handles[best]]) {
+        best = child;
+      }
+    }
+    if (![self _handle:_handles[best] isOrderedBeforeHandle:handle]) {
+      break;
+    }
+    [self _placeHandle:_handles[best] atIndex:index];
+    index = best;
+  }
+  [self _placeHandle:handle atIndex:index];
+}
+
+- (NIPriorityQueueHandle *)_appendObject:(id)object {
+  [self _ensureCapacity:_count + 1];
+  NIPriorityQueueHandle* handle = [[NIPriorityQueueHandle alloc] init];
+  handle->_object = object;
+  handle->_queue = self;
+  [self _placeHandle:handle atIndex:_count];
+  ++_count;
+  return handle;
+}
+
+- (BOOL)_containsHandle:(NIPriorityQueueHandle *)handle {
+  return (nil != handle && handle->_queue == self && NSNotFound != handle->_index);
+}
+
+- (void)_removeHandleAtIndex:(NSUInteger)index {
+  NIPriorityQueueHandle* handle = _handles[index];
+  handle->_index = NSNotFound;
+  handle->_object = nil;
+
+  --_count;
+  if (index != _count) {
+    // The last handle takes the removed handle's place and may belong above or below it.
+    [self _placeHandle:_handles[_count] atIndex:index];
+    _handles[_count] = nil;
+    [self _siftDownFromIndex:[self _siftUpFromIndex:index]];
+
+  } else {
+    _handles[_count] = nil;
+  }
+}
+
+#pragma mark - Public
+
+- (NSUInteger)count {
+  return _count;
+}
+
+- (id)firstObject {
+  return (_count > 0) ? _handles[0]->_object : nil;
+}
+
+- (NSArray *)allObjects {
+  NSMutableArray* objects = [NSMutableArray arrayWithCapacity:_count];
+  for (NSUInteger ix = 0; ix < _count; ++ix) {
+    [objects addObject:_handles[ix]->_object];
+  }
+  return [objects copy];
+}
+
+- (NIPriorityQueueHandle *)addObject:(id)object {
+  NIDASSERT(nil != object);
+  if (nil == object) {
+    return nil;
+  }
+  NIPriorityQueueHandle* handle = [self _appendObject:object];
+  [self _siftUpFromIndex:handle->_index];
+  return handle;
+}
+
+- (void)addObjectsFromArray:(NSArray *)objects {
+  // Heapifying touches every object once, while adding them one at a time costs log n each.
+  // Rebuilding wins once the batch is at least as large as the queue.
+  if (objects.count < _count) {
+    for (id object in objects) {
+      [self addObject:object];
+    }
+    return;
+  }
+
+  [self _ensureCapacity:_count + objects.count];
+  for (id object in objects) {
+    [self _appendObject:object];
+  }
+  if (_count > 1) {
+    for (NSUInteger index = (_count - 2) / kNIPriorityQueueArity + 1; index > 0; --index) {
+      [self _siftDownFromIndex:index - 1];
+    }
+  }
+}
+
+- (id)objectWithHandle:(NIPriorityQueueHandle *)handle {
+  return [self _containsHandle:handle] ? handle->_object : nil;
+}
+
+- (void)updateObjectWithHandle:(NIPriorityQueueHandle *)handle {
+  if (![self _containsHandle:handle]) {
+    return;
+  }
+  [self _siftDownFromIndex:[self _siftUpFromIndex:handle->_index]];
+}
+
+- (id)removeFirstObject {
+  if (0 == _count) {
+    return nil;
+  }
+  id object = _handles[0]->_object;
+  [self _removeHandleAtIndex:0];
+  return object;
+}
+
+- (void)removeObjectWithHandle:(NIPriorityQueueHandle *)handle {
+  if (![self _containsHandle:handle]) {
+    return;
+  }
+  [self _removeHandleAtIndex:handle->_index];
+}
+
+- (void)removeAllObjects {
+  for (NSUInteger ix = 0; ix < _count; ++ix) {
+    _handles[ix]->_index = NSNotFound;
+    _handles[ix]->_object = nil;
+    _handles[ix] = nil;
+  }
+  _count = 0;
+}
+
+@end
@@ -191,4 +191,70 @@ xx, ##__VA_ARGS__)
  */
 #define NIDINFO(xx, ...)  NIDCONDITIONLOG((NILOGLEVEL_INFO <= NIMaxLogLevel), xx, ##__VA_ARGS__)
 
+/**
+ * The subsystems that Nimbus signposts are grouped under in Instruments.
+ */
+typedef enum {
+  NISignpostCategoryImages,
+  NISignpostCategoryCSS,
+  NISignpostCategoryModels,
+  NISignpostCategoryText,
+  NISignpostCategoryCaches,
+} NISignpostCategory;
+
+/**
+ * Marks intervals and events on Nimbus's hot paths for the Instruments "os_signpost" tool.
+ *
+ * Signposts are only compiled when NI_SIGNPOSTS is defined to 1 in the target's preprocessor
+ * macros and the SDK provides os/signpost.h. Otherwise every macro compiles to nothing. They
+ * are recorded at run time only on iOS 12 and later.
+ *
+ * @code
+ *  NI_SIGNPOST_BEGIN(NISignpostCategoryImages, "Decode", image);
+ *  ...
+ *  NI_SIGNPOST_END(NISignpostCategoryImages, "Decode", image);
+ * @endcode
+ *
+ * The name must be a string literal. The object is any pointer, and it pairs the end of an
+ * interval with its beginning when intervals with the same name overlap. An optional
+ * os_log-style format string and arguments may follow the object.
+ */
+#if defined(NI_SIGNPOSTS) && NI_SIGNPOSTS && __has_include(<os/signpost.h>)
+#import <os/signpost.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Returns the shared log for the given signpost category.
+ */
+os_log_t NISignpostLog(NISignpostCategory category) NS_AVAILABLE_IOS(12_0);
+
+#if defined __cplusplus
+}
+#endif
+
+#define NI_SIGNPOST_EMIT(kind, category, name, object, ...) do { \
+if (&os_signpost_enabled != NULL) { \
+os_log_t ni_signpostLog = NISignpostLog(category); \
+if (os_signpost_enabled(ni_signpostLog)) { \
+kind(ni_signpostLog, \
+os_signpost_id_make_with_pointer(ni_signpostLog, (const void *)(uintptr_t)(object)), \
+name, ##__VA_ARGS__); \
+} } } while (0)
+
+#define NI_SIGNPOST_BEGIN(category, name, object, ...) \
+NI_SIGNPOST_EMIT(os_signpost_interval_begin, category, name, object, ##__VA_ARGS__)
+#define NI_SIGNPOST_END(category, name, object, ...) \
+NI_SIGNPOST_EMIT(os_signpost_interval_end, category, name, object, ##__VA_ARGS__)
+#define NI_SIGNPOST_EVENT(category, name, object, ...) \
+NI_SIGNPOST_EMIT(os_signpost_event_emit, category, name, object, ##__VA_ARGS__)
+
+#else
+#define NI_SIGNPOST_BEGIN(category, name, object, ...) ((void)0)
+#define NI_SIGNPOST_END(category, name, object, ...) ((void)0)
+#define NI_SIGNPOST_EVENT(category, name, object, ...) ((void)0)
+#endif // #if defined(NI_SIGNPOSTS) && NI_SIGNPOSTS && __has_include(<os/signpost.h>)
+
 /**@}*/// End of Debugging Tools //////////////////////////////////////////////////////////////////
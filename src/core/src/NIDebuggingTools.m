@@ -59,3 +59,23 @@ int NIIsInDebugger(void) {
 }
 
 #endif // #if defined(DEBUG) || defined(NI_DEBUG)
+
+#if defined(NI_SIGNPOSTS) && NI_SIGNPOSTS && __has_include(<os/signpost.h>)
+
+os_log_t NISignpostLog(NISignpostCategory category) {
+  static const char* sCategoryNames[] = {
+    "Images", "CSS", "Models", "Text", "Caches",
+  };
+  static const size_t kNumberOfCategories = sizeof(sCategoryNames) / sizeof(sCategoryNames[0]);
+  static os_log_t sLogs[sizeof(sCategoryNames) / sizeof(sCategoryNames[0])];
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    for (size_t ix = 0; ix < kNumberOfCategories; ++ix) {
+      sLogs[ix] = os_log_create("com.nimbuskit", sCategoryNames[ix]);
+    }
+  });
+  NIDASSERT((size_t)category < kNumberOfCategories);
+  return sLogs[(size_t)category % kNumberOfCategories];
+}
+
+#endif // #if defined(NI_SIGNPOSTS) && NI_SIGNPOSTS && __has_include(<os/signpost.h>)
@@ -0,0 +1,334 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "NIPreprocessorMacros.h"
+
+@class NIMemoryCache;
+
+/**
+ * For storing and accessing data on disk.
+ *
+ * NIDiskCache persists data across launches in the caches directory. NITieredCache puts an
+ * NIMemoryCache in front of an NIDiskCache so that objects survive a cold launch without being
+ * fetched or processed again.
+ *
+ * @ingroup NimbusCore
+ * @defgroup Disk-Caches Disk Caches
+ * @{
+ */
+
+/**
+ * A size-bounded, least-recently-used cache of data files on disk.
+ *
+ * Writes happen asynchronously on a serial queue owned by the cache. Reads map the file into
+ * memory rather than copying it, so reading a large file does not allocate a buffer of the
+ * same size. Data that has been stored but not yet written is returned from memory.
+ *
+ * The cache keeps a journal of its files in least-recently-used order along with their sizes.
+ * When the total size of the files passes maxNumberOfBytes, the least recently used files
+ * are deleted until the cache fits again.
+ */
+@interface NIDiskCache : NSObject
+
+// Designated initializer.
+- (id)initWithPath:(NSString *)path;
+- (id)initWithName:(NSString *)name;
+
+@property (nonatomic, readonly, copy) NSString* path;
+
+@property (nonatomic, readonly) unsigned long long numberOfBytes;
+@property (nonatomic) unsigned long long maxNumberOfBytes; // Default: 0 (unlimited)
+
+- (NSUInteger)count;
+
+- (void)storeData:(NSData *)data withName:(NSString *)name;
+- (void)storeData:(NSData *)data withName:(NSString *)name completion:(void (^)(BOOL success))completion;
+
+- (NSURL *)temporaryFileURL;
+- (void)storeFileAtURL:(NSURL *)fileURL withName:(NSString *)name;
+
+- (NSData *)dataWithName:(NSString *)name;
+- (void)dataWithName:(NSString *)name completion:(void (^)(NSData* data))completion;
+- (BOOL)containsDataWithName:(NSString *)name;
+
+- (void)removeDataWithName:(NSString *)name;
+- (void)removeAllData;
+
+- (void)waitUntilAllWritesAreFinished;
+
+@end
+
+/**
+ * A two-level cache that checks memory before disk.
+ *
+ * Objects found on disk are promoted into the memory cache. Objects stored in the tiered
+ * cache are stored in memory right away and written to disk asynchronously.
+ *
+ * The disk cache stores data, so the tiered cache needs to know how to turn objects into data
+ * and back. The image cache created by imageCacheWithMemoryCache:diskCache: stores images as
+ * PNG data.
+ */
+@interface NITieredCache : NSObject
+
+// Designated initializer.
+- (id)initWithMemoryCache:(NIMemoryCache *)memoryCache diskCache:(NIDiskCache *)diskCache;
+
++ (id)imageCacheWithMemoryCache:(NIMemoryCache *)memoryCache diskCache:(NIDiskCache *)diskCache;
+
+@property (nonatomic, readonly, strong) NIMemoryCache* memoryCache;
+@property (nonatomic, readonly, strong) NIDiskCache* diskCache;
+
+@property (nonatomic, copy) NSData* (^dataFromObject)(id object);
+@property (nonatomic, copy) id (^objectFromData)(NSData* data);
+
+- (void)storeObject:(id)object withName:(NSString *)name;
+- (void)storeObject:(id)object data:(NSData *)data withName:(NSString *)name;
+
+- (id)objectWithName:(NSString *)name;
+- (void)objectWithName:(NSString *)name completion:(void (^)(id object))completion;
+- (BOOL)containsObjectWithName:(NSString *)name;
+
+- (void)removeObjectWithName:(NSString *)name;
+- (void)removeAllObjects;
+
+@end
+
+/**@}*/// End of Disk Caches //////////////////////////////////////////////////////////////////////
+
+/** @name Creating a Disk Cache */
+
+/**
+ * Initializes a newly allocated disk cache that stores its files in the given directory.
+ *
+ * The directory is created if it does not exist. The directory should not be shared with
+ * anything else because the cache deletes files from it.
+ *
+ * @fn NIDiskCache::initWithPath:
+ */
+
+/**
+ * Initializes a newly allocated disk cache that stores its files in a directory with the
+ * given name in the caches directory.
+ *
+ * @see NIPathForCachesResource
+ * @fn NIDiskCache::initWithName:
+ */
+
+/** @name Querying a Disk Cache */
+
+/**
+ * The directory in which the cache stores its files.
+ *
+ * @fn NIDiskCache::path
+ */
+
+/**
+ * The total size of the files in the cache, including data that is still waiting to be
+ * written.
+ *
+ * @fn NIDiskCache::numberOfBytes
+ */
+
+/**
+ * The maximum total size of the files in the cache.
+ *
+ * Defaults to 0, which is special cased to represent an unlimited number of bytes.
+ *
+ * @fn NIDiskCache::maxNumberOfBytes
+ */
+
+/**
+ * Returns the number of files in the cache.
+ *
+ * @fn NIDiskCache::count
+ */
+
+/** @name Storing Data */
+
+/**
+ * Stores data in the cache asynchronously.
+ *
+ * @fn NIDiskCache::storeData:withName:
+ */
+
+/**
+ * Stores data in the cache asynchronously and calls completion on the main thread once the
+ * data has been written.
+ *
+ * @fn NIDiskCache::storeData:withName:completion:
+ */
+
+/**
+ * Returns the URL of a new file in the cache's directory that can be filled in before it is
+ * stored with storeFileAtURL:withName:.
+ *
+ * The file does not exist yet and is not part of the cache until it is stored. Files that are
+ * never stored are deleted when a cache is created for the directory in a later launch of the
+ * app, so other caches for the same directory never delete a file that is being filled in.
+ *
+ * @fn NIDiskCache::temporaryFileURL
+ */
+
+/**
+ * Moves a file into the cache, taking ownership of it.
+ *
+ * This is meant for large data that was written to a temporaryFileURL as it arrived, which can
+ * then be stored without ever having been held in memory. The file is mapped right away so
+ * that it can be read back before it has been moved, and is deleted if it is replaced before
+ * the move happens.
+ *
+ * @fn NIDiskCache::storeFileAtURL:withName:
+ */
+
+/** @name Accessing Data */
+
+/**
+ * Returns the data stored with the given name, or nil if there is none.
+ *
+ * The data is mapped into memory from disk. Reading the data counts as an access for the
+ * purpose of eviction.
+ *
+ * @fn NIDiskCache::dataWithName:
+ */
+
+/**
+ * Reads the data stored with the given name on the cache's queue and calls completion on the
+ * main thread with the result.
+ *
+ * @fn NIDiskCache::dataWithName:completion:
+ */
+
+/**
+ * Returns a Boolean value that indicates whether data with the given name is in the cache.
+ *
+ * Does not count as an access.
+ *
+ * @fn NIDiskCache::containsDataWithName:
+ */
+
+/** @name Removing Data */
+
+/**
+ * Removes the data stored with the given name.
+ *
+ * @fn NIDiskCache::removeDataWithName:
+ */
+
+/**
+ * Removes all data from the cache.
+ *
+ * @fn NIDiskCache::removeAllData
+ */
+
+/**
+ * Blocks the calling thread until every pending write has been committed to disk.
+ *
+ * @fn NIDiskCache::waitUntilAllWritesAreFinished
+ */
+
+/** @name Creating a Tiered Cache */
+
+/**
+ * Initializes a newly allocated tiered cache with the given caches.
+ *
+ * dataFromObject and objectFromData must be set before using the disk tier. Until then the
+ * tiered cache only uses the memory cache.
+ *
+ * @fn NITieredCache::initWithMemoryCache:diskCache:
+ */
+
+/**
+ * Returns a tiered cache that stores UIImages, encoding them as PNG data on disk.
+ *
+ * @fn NITieredCache::imageCacheWithMemoryCache:diskCache:
+ */
+
+/** @name Converting Objects */
+
+/**
+ * Turns an object into the data that is written to disk.
+ *
+ * Called on a background queue.
+ *
+ * @fn NITieredCache::dataFromObject
+ */
+
+/**
+ * Turns data read from disk into an object.
+ *
+ * Called on whichever thread read the data.
+ *
+ * @fn NITieredCache::objectFromData
+ */
+
+/** @name Storing Objects */
+
+/**
+ * Stores the object in memory and writes it to disk asynchronously.
+ *
+ * @fn NITieredCache::storeObject:withName:
+ */
+
+/**
+ * Stores the object in memory and writes the given data to disk asynchronously.
+ *
+ * Use this when the encoded form of the object is already at hand, such as the body of the
+ * response it was decoded from, to avoid encoding it again.
+ *
+ * @fn NITieredCache::storeObject:data:withName:
+ */
+
+/** @name Accessing Objects */
+
+/**
+ * Returns the object from memory, or from disk if it is not in memory.
+ *
+ * Objects read from disk are stored in the memory cache.
+ *
+ * @attention This may read from disk on the calling thread. Use
+ *                 objectWithName:completion: from the main thread.
+ * @fn NITieredCache::objectWithName:
+ */
+
+/**
+ * Looks the object up in memory and, failing that, on disk off the calling thread.
+ *
+ * completion is called on the main thread, immediately if the object is in memory.
+ *
+ * @fn NITieredCache::objectWithName:completion:
+ */
+
+/**
+ * Returns a Boolean value that indicates whether either tier has an object with the given name.
+ *
+ * @fn NITieredCache::containsObjectWithName:
+ */
+
+/** @name Removing Objects */
+
+/**
+ * Removes the object from both tiers.
+ *
+ * @fn NITieredCache::removeObjectWithName:
+ */
+
+/**
+ * Removes all objects from both tiers.
+ *
+ * @fn NITieredCache::removeAllObjects
+ */
@@ -0,0 +1,549 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NIDiskCache.h"
+
+#import "NIDebuggingTools.h"
+#import "NIFoundationMethods.h"
+#import "NIInMemoryCache.h"
+#import "NIPaths.h"
+
+#import <UIKit/UIKit.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+static NSString* const kJournalFileName = @"journal.plist";
+
+// Temporary files are hidden so that rebuilding the journal from the directory skips them.
+static NSString* const kTemporaryFilePrefix = @".partial-";
+
+// Identifies the temporary files made by this launch of the app. Several caches may share a
+// directory, so a new cache must only remove the files that earlier launches left behind.
+static NSString* NIDiskCacheTemporaryFileLaunchPrefix(void) {
+  static NSString* sLaunchPrefix = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sLaunchPrefix = [NSString stringWithFormat:@"%@%@-", kTemporaryFilePrefix, [[NSUUID UUID] UUIDString]];
+  });
+  return sLaunchPrefix;
+}
+
+// How long to wait after a change before writing the journal to disk. Changes that happen
+// within this window are written together.
+static const NSTimeInterval kJournalWriteDelay = 1;
+
+@interface NIDiskCache()
+// The file keys of the cache ordered from least to most recently used.
+@property (nonatomic, strong) NSMutableOrderedSet* lruKeys;
+// Mapping from a file key to its size in bytes.
+@property (nonatomic, strong) NSMutableDictionary* fileSizes;
+// Data that has been stored but not yet written, keyed by file key.
+@property (nonatomic, strong) NSMutableDictionary* pendingWrites;
+// All file operations happen in order on this queue.
+@property (nonatomic, strong) dispatch_queue_t ioQueue;
+@property (nonatomic) BOOL journalWriteScheduled;
+@end
+
+@implementation NIDiskCache
+
+- (void)dealloc {
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (id)initWithName:(NSString *)name {
+  return [self initWithPath:NIPathForCachesResource(name)];
+}
+
+- (id)initWithPath:(NSString *)path {
+  if ((self = [super init])) {
+    NIDASSERT(NIIsStringWithAnyText(path));
+    _path = [path copy];
+    _lruKeys = [NSMutableOrderedSet orderedSet];
+    _fileSizes = [NSMutableDictionary dictionary];
+    _pendingWrites = [NSMutableDictionary dictionary];
+    _ioQueue = dispatch_queue_create("com.nimbuskit.diskcache", DISPATCH_QUEUE_SERIAL);
+
+    [[NSFileManager defaultManager] createDirectoryAtPath:_path
+                              withIntermediateDirectories:YES
+                                               attributes:nil
+                                                    error:nil];
+    [self loadJournal];
+    [self removeTemporaryFiles];
+
+    // Make sure the journal has been written before the app can be killed.
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(writeJournal)
+                                                 name:UIApplicationDidEnterBackgroundNotification
+                                               object:nil];
+  }
+  return self;
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:
+          @"<%@"
+          @" path: %@"
+          @" count: %zd"
+          @" bytes: %llu"
+          @">",
+          [super description],
+          self.path,
+          self.count,
+          self.numberOfBytes];
+}
+
+#pragma mark - Journal
+
+- (NSString *)journalPath {
+  return [self.path stringByAppendingPathComponent:kJournalFileName];
+}
+
+- (void)loadJournal {
+  NSArray* journal = [NSArray arrayWithContentsOfFile:[self journalPath]];
+
+  if (nil != journal) {
+    for (NSArray* entry in journal) {
+      if (![entry isKindOfClass:[NSArray class]] || entry.count != 2) {
+        continue;
+      }
+      NSString* key = entry[0];
+      NSNumber* size = entry[1];
+      [self.lruKeys addObject:key];
+      self.fileSizes[key] = size;
+      _numberOfBytes += [size unsignedLongLongValue];
+    }
+
+  } else {
+    // There is no journal, so rebuild it from the files on disk, oldest first.
+    NSURL* directoryURL = [NSURL fileURLWithPath:self.path isDirectory:YES];
+    NSArray* keys = @[NSURLContentModificationDateKey, NSURLFileSizeKey];
+    NSArray* fileURLs = [[NSFileManager defaultManager] contentsOfDirectoryAtURL:directoryURL
+                                                      includingPropertiesForKeys:keys
+                                                                         options:NSDirectoryEnumerationSkipsHiddenFiles
+                                                                           error:nil];
+    NSMutableArray* files = [NSMutableArray arrayWithCapacity:fileURLs.count];
+    for (NSURL* fileURL in fileURLs) {
+      if ([fileURL.lastPathComponent isEqualToString:kJournalFileName]) {
+        continue;
+      }
+      NSDictionary* values = [fileURL resourceValuesForKeys:keys error:nil];
+      if (nil != values[NSURLFileSizeKey] && nil != values[NSURLContentModificationDateKey]) {
+        [files addObject:@[fileURL.lastPathComponent,
+                           values[NSURLFileSizeKey],
+                           values[NSURLContentModificationDateKey]]];
+      }
+    }
+    [files sortUsingComparator:^NSComparisonResult(NSArray* file1, NSArray* file2) {
+      return [file1[2] compare:file2[2]];
+    }];
+    for (NSArray* file in files) {
+      [self.lruKeys addObject:file[0]];
+      self.fileSizes[file[0]] = file[1];
+      _numberOfBytes += [file[1] unsignedLongLongValue];
+    }
+  }
+}
+
+- (NSArray *)journalSnapshot {
+  @synchronized(self) {
+    self.journalWriteScheduled = NO;
+
+    NSMutableArray* journal = [NSMutableArray arrayWithCapacity:self.lruKeys.count];
+    for (NSString* key in self.lruKeys) {
+      [journal addObject:@[key, self.fileSizes[key]]];
+    }
+    return journal;
+  }
+}
+
+- (void)writeJournal {
+  dispatch_sync(self.ioQueue, ^{
+    [[self journalSnapshot] writeToFile:[self journalPath] atomically:YES];
+  });
+}
+
+// Must be called while holding the lock.
+- (void)setNeedsJournalWrite {
+  if (self.journalWriteScheduled) {
+    return;
+  }
+  self.journalWriteScheduled = YES;
+
+  __weak NIDiskCache* weakSelf = self;
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kJournalWriteDelay * NSEC_PER_SEC)),
+                 self.ioQueue, ^{
+    NIDiskCache* strongSelf = weakSelf;
+    if (nil != strongSelf && strongSelf.journalWriteScheduled) {
+      [[strongSelf journalSnapshot] writeToFile:[strongSelf journalPath] atomically:YES];
+    }
+  });
+}
+
+#pragma mark - Internal
+
+- (NSString *)keyForName:(NSString *)name {
+  return NIHexStringFromHash128(NIHash128FromString(name));
+}
+
+- (NSString *)filePathForKey:(NSString *)key {
+  return [self.path stringByAppendingPathComponent:key];
+}
+
+// Must be called while holding the lock.
+- (void)removeEntryForKey:(NSString *)key {
+  if (![self.lruKeys containsObject:key]) {
+    return;
+  }
+  _numberOfBytes -= [self.fileSizes[key] unsignedLongLongValue];
+  [self.lruKeys removeObject:key];
+  [self.fileSizes removeObjectForKey:key];
+  [self.pendingWrites removeObjectForKey:key];
+
+  NSString* filePath = [self filePathForKey:key];
+  dispatch_async(self.ioQueue, ^{
+    [[NSFileManager defaultManager] removeItemAtPath:filePath error:nil];
+  });
+  [self setNeedsJournalWrite];
+}
+
+// Must be called while holding the lock.
+- (void)evictLeastRecentlyUsedData {
+  if (0 == self.maxNumberOfBytes) {
+    return;
+  }
+  while (_numberOfBytes > self.maxNumberOfBytes && self.lruKeys.count > 0) {
+    [self removeEntryForKey:self.lruKeys.firstObject];
+  }
+}
+
+// Data that came from a file is stored by moving that file into place rather than by writing
+// the data out again.
+- (void)storeData:(NSData *)data
+   fromFileAtPath:(NSString *)sourceFilePath
+         withName:(NSString *)name
+       completion:(void (^)(BOOL success))completion {
+  NIDASSERT(nil != name);
+  if (nil == data || nil == name) {
+    if (nil != completion) {
+      completion(NO);
+    }
+    return;
+  }
+
+  NSString* key = [self keyForName:name];
+  data = [data copy];
+
+  @synchronized(self) {
+    [self removeEntryForKey:key];
+
+    [self.lruKeys addObject:key];
+    self.fileSizes[key] = @(data.length);
+    self.pendingWrites[key] = data;
+    _numberOfBytes += data.length;
+
+    [self evictLeastRecentlyUsedData];
+    [self setNeedsJournalWrite];
+  }
+
+  NSString* filePath = [self filePathForKey:key];
+  dispatch_async(self.ioQueue, ^{
+    BOOL stillStored = NO;
+    @synchronized(self) {
+      // The data may have been removed or replaced before we got around to writing it.
+      stillStored = (self.pendingWrites[key] == data);
+    }
+
+    BOOL success = NO;
+    if (stillStored) {
+      if (nil != sourceFilePath) {
+        // Renaming replaces any existing file atomically, just like an atomic write.
+        success = (0 == rename([sourceFilePath fileSystemRepresentation], [filePath fileSystemRepresentation]));
+      } else {
+        success = [data writeToFile:filePath atomically:YES];
+      }
+      @synchronized(self) {
+        if (self.pendingWrites[key] == data) {
+          [self.pendingWrites removeObjectForKey:key];
+          if (!success) {
+            [self removeEntryForKey:key];
+          }
+        }
+      }
+    }
+    if (!success && nil != sourceFilePath) {
+      [[NSFileManager defaultManager] removeItemAtPath:sourceFilePath error:nil];
+    }
+
+    if (nil != completion) {
+      dispatch_async(dispatch_get_main_queue(), ^{
+        completion(success);
+      });
+    }
+  });
+}
+
+// Temporary files of earlier launches that were never stored belong to transfers that didn't
+// survive. The files of this launch may still be filled in by other caches for this directory.
+- (void)removeTemporaryFiles {
+  NSString* path = self.path;
+  NSString* launchPrefix = NIDiskCacheTemporaryFileLaunchPrefix();
+  dispatch_async(self.ioQueue, ^{
+    NSFileManager* fileManager = [NSFileManager defaultManager];
+    for (NSString* fileName in [fileManager contentsOfDirectoryAtPath:path error:nil]) {
+      if ([fileName hasPrefix:kTemporaryFilePrefix] && ![fileName hasPrefix:launchPrefix]) {
+        [fileManager removeItemAtPath:[path stringByAppendingPathComponent:fileName] error:nil];
+      }
+    }
+  });
+}
+
+#pragma mark - Public
+
+- (NSUInteger)count {
+  @synchronized(self) {
+    return self.lruKeys.count;
+  }
+}
+
+- (unsigned long long)numberOfBytes {
+  @synchronized(self) {
+    return _numberOfBytes;
+  }
+}
+
+- (void)setMaxNumberOfBytes:(unsigned long long)maxNumberOfBytes {
+  @synchronized(self) {
+    _maxNumberOfBytes = maxNumberOfBytes;
+    [self evictLeastRecentlyUsedData];
+  }
+}
+
+- (void)storeData:(NSData *)data withName:(NSString *)name {
+  [self storeData:data withName:name completion:nil];
+}
+
+- (void)storeData:(NSData *)data withName:(NSString *)name completion:(void (^)(BOOL success))completion {
+  [self storeData:data fromFileAtPath:nil withName:name completion:completion];
+}
+
+- (NSURL *)temporaryFileURL {
+  NSString* fileName = [NIDiskCacheTemporaryFileLaunchPrefix() stringByAppendingString:[[NSUUID UUID] UUIDString]];
+  return [NSURL fileURLWithPath:[self.path stringByAppendingPathComponent:fileName]];
+}
+
+- (void)storeFileAtURL:(NSURL *)fileURL withName:(NSString *)name {
+  NIDASSERT(fileURL.isFileURL);
+  NSData* data = [NSData dataWithContentsOfURL:fileURL options:NSDataReadingMappedAlways error:nil];
+  if (nil == data) {
+    [[NSFileManager defaultManager] removeItemAtURL:fileURL error:nil];
+    return;
+  }
+  [self storeData:data fromFileAtPath:fileURL.path withName:name completion:nil];
+}
+
+- (NSData *)dataWithName:(NSString *)name {
+  if (nil == name) {
+    return nil;
+  }
+  NSString* key = [self keyForName:name];
+
+  @synchronized(self) {
+    if (![self.lruKeys containsObject:key]) {
+      return nil;
+    }
+
+    // Reading counts as an access.
+    [self.lruKeys removeObject:key];
+    [self.lruKeys addObject:key];
+    [self setNeedsJournalWrite];
+
+    NSData* pendingData = self.pendingWrites[key];
+    if (nil != pendingData) {
+      return pendingData;
+    }
+  }
+
+  // Files are always replaced atomically, so a mapping stays valid even if the file is
+  // replaced or removed while the data is still in use.
+  NSData* data = [NSData dataWithContentsOfFile:[self filePathForKey:key]
+                                        options:NSDataReadingMappedAlways
+                                          error:nil];
+  if (nil == data) {
+    // The file was removed from underneath us.
+    @synchronized(self) {
+      if (nil == self.pendingWrites[key]) {
+        [self removeEntryForKey:key];
+      }
+    }
+  }
+  return data;
+}
+
+- (void)dataWithName:(NSString *)name completion:(void (^)(NSData* data))completion {
+  NIDASSERT(nil != completion);
+  dispatch_async(self.ioQueue, ^{
+    NSData* data = [self dataWithName:name];
+    dispatch_async(dispatch_get_main_queue(), ^{
+      completion(data);
+    });
+  });
+}
+
+- (BOOL)containsDataWithName:(NSString *)name {
+  if (nil == name) {
+    return NO;
+  }
+  @synchronized(self) {
+    return [self.lruKeys containsObject:[self keyForName:name]];
+  }
+}
+
+- (void)removeDataWithName:(NSString *)name {
+  if (nil == name) {
+    return;
+  }
+  @synchronized(self) {
+    [self removeEntryForKey:[self keyForName:name]];
+  }
+}
+
+- (void)removeAllData {
+  @synchronized(self) {
+    NSArray* keys = [self.lruKeys array];
+    [self.lruKeys removeAllObjects];
+    [self.fileSizes removeAllObjects];
+    [self.pendingWrites removeAllObjects];
+    _numberOfBytes = 0;
+
+    dispatch_async(self.ioQueue, ^{
+      NSFileManager* fileManager = [NSFileManager defaultManager];
+      for (NSString* key in keys) {
+        [fileManager removeItemAtPath:[self filePathForKey:key] error:nil];
+      }
+    });
+    [self setNeedsJournalWrite];
+  }
+}
+
+- (void)waitUntilAllWritesAreFinished {
+  [self writeJournal];
+}
+
+@end
+
+
+@implementation NITieredCache
+
+- (id)initWithMemoryCache:(NIMemoryCache *)memoryCache diskCache:(NIDiskCache *)diskCache {
+  if ((self = [super init])) {
+    NIDASSERT(nil != memoryCache);
+    _memoryCache = memoryCache;
+    _diskCache = diskCache;
+  }
+  return self;
+}
+
++ (id)imageCacheWithMemoryCache:(NIMemoryCache *)memoryCache diskCache:(NIDiskCache *)diskCache {
+  NITieredCache* cache = [[self alloc] initWithMemoryCache:memoryCache diskCache:diskCache];
+  cache.dataFromObject = ^NSData *(id object) {
+    return [object isKindOfClass:[UIImage class]] ? UIImagePNGRepresentation(object) : nil;
+  };
+  cache.objectFromData = ^id(NSData* data) {
+    return [UIImage imageWithData:data scale:[[UIScreen mainScreen] scale]];
+  };
+  return cache;
+}
+
+- (BOOL)usesDiskCache {
+  return (nil != self.diskCache && nil != self.dataFromObject && nil != self.objectFromData);
+}
+
+- (id)objectFromDiskWithName:(NSString *)name {
+  NSData* data = [self.diskCache dataWithName:name];
+  return (nil != data) ? self.objectFromData(data) : nil;
+}
+
+- (void)storeObject:(id)object withName:(NSString *)name {
+  [self storeObject:object data:nil withName:name];
+}
+
+- (void)storeObject:(id)object data:(NSData *)data withName:(NSString *)name {
+  if (nil == object || nil == name) {
+    return;
+  }
+  [self.memoryCache storeObject:object withName:name];
+
+  if ([self usesDiskCache]) {
+    if (nil != data) {
+      [self.diskCache storeData:data withName:name];
+
+    } else {
+      NSData* (^dataFromObject)(id) = self.dataFromObject;
+      NIDiskCache* diskCache = self.diskCache;
+      dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+        [diskCache storeData:dataFromObject(object) withName:name];
+      });
+    }
+  }
+}
+
+- (id)objectWithName:(NSString *)name {
+  id object = [self.memoryCache objectWithName:name];
+  if (nil == object && [self usesDiskCache]) {
+    object = [self objectFromDiskWithName:name];
+
+    // Promote the object so that the next access doesn't touch the disk.
+    [self.memoryCache storeObject:object withName:name];
+  }
+  return object;
+}
+
+- (void)objectWithName:(NSString *)name completion:(void (^)(id object))completion {
+  NIDASSERT(nil != completion);
+  id object = [self.memoryCache objectWithName:name];
+  if (nil != object || ![self usesDiskCache]) {
+    completion(object);
+    return;
+  }
+
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    id diskObject = [self objectFromDiskWithName:name];
+    [self.memoryCache storeObject:diskObject withName:name];
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+      completion(diskObject);
+    });
+  });
+}
+
+- (BOOL)containsObjectWithName:(NSString *)name {
+  return ([self.memoryCache containsObjectWithName:name]
+          || [self.diskCache containsDataWithName:name]);
+}
+
+- (void)removeObjectWithName:(NSString *)name {
+  [self.memoryCache removeObjectWithName:name];
+  [self.diskCache removeDataWithName:name];
+}
+
+- (void)removeAllObjects {
+  [self.memoryCache removeAllObjects];
+  [self.diskCache removeAllData];
+}
+
+@end
@@ -35,8 +35,22 @@ extern NSString* const NIImageErrorKey;
 typedef enum {
   /** The image is too small to be used. */
   NIImageTooSmall = 1,
+
+  /** The path recently failed to load and will not be requested again until later. */
+  NIPathFailedRecently = 2,
+
+  /** The JSON is malformed or doesn't contain the expected array. */
+  NIMalformedJSON = 3,
 } NINimbusErrorDomainCode;
 
+/**
+ * Returns YES if loading a resource failed in a way that asking again won't fix.
+ *
+ * Only 404 and 410 responses and content that can't be decoded count. Timeouts, lost
+ * connections, server errors and cancellations are transient and return NO.
+ */
+BOOL NIIsPermanentLoadFailure(NSURLResponse* response, NSError* error);
+
 
 /**@}*/// End of Errors ///////////////////////////////////////////////////////////////////////////
 
@@ -22,3 +22,20 @@
 
 NSString* const NINimbusErrorDomain = @"com.nimbus.error";
 NSString* const NIImageErrorKey = @"image";
+
+BOOL NIIsPermanentLoadFailure(NSURLResponse* response, NSError* error) {
+  if ([response isKindOfClass:[NSHTTPURLResponse class]]) {
+    NSInteger statusCode = [(NSHTTPURLResponse *)response statusCode];
+    if (404 == statusCode || 410 == statusCode) {
+      return YES;
+    }
+    if (statusCode >= 400) {
+      // The server may well answer differently next time.
+      return NO;
+    }
+  }
+  // Response serializers report undecodable content in their own domains, so only the code
+  // is checked.
+  return (NSURLErrorCannotDecodeContentData == error.code
+          || NSURLErrorCannotDecodeRawData == error.code);
+}
@@ -0,0 +1,175 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+#import <pthread.h>
+
+#if __has_include(<os/lock.h>)
+#import <os/lock.h>
+#define NI_FAST_LOCK_HAS_UNFAIR_LOCK 1
+#else
+#define NI_FAST_LOCK_HAS_UNFAIR_LOCK 0
+#endif
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * For guarding state with less overhead than @synchronized.
+ *
+ * @ingroup NimbusCore
+ * @defgroup Fast-Locks Fast Locks
+ * @{
+ *
+ * @synchronized looks its object up in a global table of recursive mutexes every time it is
+ * entered. A fast lock lives inside the object that it guards and is an os_unfair_lock where the
+ * OS provides one, or a pthread mutex where it does not. Locks are only made recursive when they
+ * are created with NIFastLockOptionRecursive, such as when a lock is held while calling out to
+ * methods that subclasses may implement by calling back in.
+ *
+ * Locks created with NIFastLockOptionCountsContention count how often they were taken and how
+ * often they had to wait, so that the cost of a lock can be measured rather than guessed at.
+ *
+ * <h2>Example Use</h2>
+ *
+@code
+@implementation MyCounter {
+  NIFastLock _lock;
+  NSInteger _count;
+}
+
+- (id)init {
+  if ((self = [super init])) {
+    NIFastLockInit(&_lock, NIFastLockOptionNone);
+  }
+  return self;
+}
+
+- (void)dealloc {
+  NIFastLockDestroy(&_lock);
+}
+
+- (NSInteger)increment {
+  NI_LOCK_SCOPE(&_lock);
+  return ++_count;
+}
+
+@end
+@endcode
+ */
+
+typedef enum {
+  NIFastLockOptionNone              = 0,
+  NIFastLockOptionRecursive         = 1 << 0,
+  NIFastLockOptionCountsContention  = 1 << 1,
+} NIFastLockOptions;
+
+// Embed it in the object whose state it guards and never copy it. The fields are private.
+typedef struct {
+#if NI_FAST_LOCK_HAS_UNFAIR_LOCK
+  os_unfair_lock unfairLock;
+#endif
+  pthread_mutex_t mutex; // Only used where os_unfair_lock is not available.
+  BOOL usesMutex;
+  NIFastLockOptions options;
+
+  // The thread holding a recursive lock and how many times it has taken it.
+  pthread_t owner;
+  NSUInteger depth;
+
+  // Updated with the __atomic builtins; <stdatomic.h> types can't be used from Objective-C++.
+  unsigned long long acquisitions;
+  unsigned long long contentions;
+} NIFastLock;
+
+typedef struct {
+  unsigned long long numberOfAcquisitions;
+  unsigned long long numberOfContentions;
+} NIFastLockStatistics;
+
+/**
+ * Prepares a lock for use. Every lock must be initialized before it is taken.
+ */
+void NIFastLockInit(NIFastLock* lock, NIFastLockOptions options);
+
+/**
+ * Releases any resources held by a lock that is no longer in use.
+ */
+void NIFastLockDestroy(NIFastLock* lock);
+
+/**
+ * Takes the lock, waiting for the thread that holds it if there is one.
+ *
+ * Taking a lock that the thread already holds deadlocks unless it is recursive.
+ */
+void NIFastLockLock(NIFastLock* lock);
+
+/**
+ * Takes the lock if no other thread holds it.
+ *
+ * @returns YES if the lock was taken.
+ */
+BOOL NIFastLockTryLock(NIFastLock* lock);
+
+/**
+ * Releases the lock. It must be released by the thread that took it.
+ */
+void NIFastLockUnlock(NIFastLock* lock);
+
+/**
+ * Returns how many times the lock has been taken and how many of those had to wait.
+ *
+ * Taking a recursive lock again while holding it is not counted. Both numbers are zero unless
+ * the lock was created with NIFastLockOptionCountsContention.
+ */
+NIFastLockStatistics NIFastLockGetStatistics(NIFastLock* lock);
+
+/**
+ * Sets the lock's counters back to zero.
+ */
+void NIFastLockResetStatistics(NIFastLock* lock);
+
+// Used by NI_LOCK_SCOPE.
+static inline NIFastLock* NIFastLockBeginScope(NIFastLock* lock) {
+  NIFastLockLock(lock);
+  return lock;
+}
+
+static inline void NIFastLockEndScope(NIFastLock** lock) {
+  NIFastLockUnlock(*lock);
+}
+
+#define NI_FAST_LOCK_CONCAT_(a, b) a##b
+#define NI_FAST_LOCK_CONCAT(a, b) NI_FAST_LOCK_CONCAT_(a, b)
+
+/**
+ * Takes the lock and holds it until the end of the enclosing scope.
+ *
+ * Stands in for @synchronized by putting it at the top of the block that was synchronized. The
+ * lock is released however the scope is left, including by return and break. Exceptions are not
+ * caught, so the lock is not released when one is thrown out of the scope.
+ */
+#define NI_LOCK_SCOPE(lock) \
+  NIFastLock* NI_FAST_LOCK_CONCAT(ni_lockScope, __LINE__) \
+      __attribute__((cleanup(NIFastLockEndScope), unused)) = NIFastLockBeginScope(lock)
+
+/**@}*/// End of Fast Locks ///////////////////////////////////////////////////////////////////////
+
+#if defined __cplusplus
+};
+#endif
@@ -0,0 +1,148 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NIFastLock.h"
+
+#import "NIDebuggingTools.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+void NIFastLockInit(NIFastLock* lock, NIFastLockOptions options) {
+  memset(lock, 0, sizeof(*lock));
+  lock->options = options;
+
+#if NI_FAST_LOCK_HAS_UNFAIR_LOCK
+  // os_unfair_lock is only available from iOS 10, and is weakly linked before that.
+  if (&os_unfair_lock_lock != NULL) {
+    lock->unfairLock = OS_UNFAIR_LOCK_INIT;
+  } else {
+    lock->usesMutex = YES;
+  }
+#else
+  lock->usesMutex = YES;
+#endif
+  if (lock->usesMutex) {
+    pthread_mutex_init(&lock->mutex, NULL);
+  }
+}
+
+void NIFastLockDestroy(NIFastLock* lock) {
+  NIDASSERT(0 == lock->depth);
+  if (lock->usesMutex) {
+    pthread_mutex_destroy(&lock->mutex);
+  }
+}
+
+static inline BOOL NIFastLockTryAcquire(NIFastLock* lock) {
+#if NI_FAST_LOCK_HAS_UNFAIR_LOCK
+  if (!lock->usesMutex) {
+    return os_unfair_lock_trylock(&lock->unfairLock);
+  }
+#endif
+  return (0 == pthread_mutex_trylock(&lock->mutex));
+}
+
+static inline void NIFastLockAcquire(NIFastLock* lock) {
+#if NI_FAST_LOCK_HAS_UNFAIR_LOCK
+  if (!lock->usesMutex) {
+    os_unfair_lock_lock(&lock->unfairLock);
+    return;
+  }
+#endif
+  pthread_mutex_lock(&lock->mutex);
+}
+
+static inline void NIFastLockRelease(NIFastLock* lock) {
+#if NI_FAST_LOCK_HAS_UNFAIR_LOCK
+  if (!lock->usesMutex) {
+    os_unfair_lock_unlock(&lock->unfairLock);
+    return;
+  }
+#endif
+  pthread_mutex_unlock(&lock->mutex);
+}
+
+// Only the thread that holds a recursive lock can find itself in the owner field, so the field
+// can be checked before the lock is taken.
+static inline BOOL NIFastLockIsHeldByCurrentThread(NIFastLock* lock) {
+  pthread_t owner = __atomic_load_n(&lock->owner, __ATOMIC_RELAXED);
+  return (NULL != owner && pthread_equal(owner, pthread_self()));
+}
+
+static inline void NIFastLockDidAcquire(NIFastLock* lock) {
+  if (lock->options & NIFastLockOptionRecursive) {
+    __atomic_store_n(&lock->owner, pthread_self(), __ATOMIC_RELAXED);
+    lock->depth = 1;
+  }
+  if (lock->options & NIFastLockOptionCountsContention) {
+    __atomic_fetch_add(&lock->acquisitions, 1, __ATOMIC_RELAXED);
+  }
+}
+
+void NIFastLockLock(NIFastLock* lock) {
+  if ((lock->options & NIFastLockOptionRecursive) && NIFastLockIsHeldByCurrentThread(lock)) {
+    lock->depth++;
+    return;
+  }
+
+  if (lock->options & NIFastLockOptionCountsContention) {
+    // The first attempt is what tells a wait apart from an uncontended acquisition.
+    if (!NIFastLockTryAcquire(lock)) {
+      __atomic_fetch_add(&lock->contentions, 1, __ATOMIC_RELAXED);
+      NIFastLockAcquire(lock);
+    }
+  } else {
+    NIFastLockAcquire(lock);
+  }
+  NIFastLockDidAcquire(lock);
+}
+
+BOOL NIFastLockTryLock(NIFastLock* lock) {
+  if ((lock->options & NIFastLockOptionRecursive) && NIFastLockIsHeldByCurrentThread(lock)) {
+    lock->depth++;
+    return YES;
+  }
+  if (!NIFastLockTryAcquire(lock)) {
+    return NO;
+  }
+  NIFastLockDidAcquire(lock);
+  return YES;
+}
+
+void NIFastLockUnlock(NIFastLock* lock) {
+  if (lock->options & NIFastLockOptionRecursive) {
+    NIDASSERT(NIFastLockIsHeldByCurrentThread(lock));
+    if (--lock->depth > 0) {
+      return;
+    }
+    __atomic_store_n(&lock->owner, (pthread_t)NULL, __ATOMIC_RELAXED);
+  }
+  NIFastLockRelease(lock);
+}
+
+NIFastLockStatistics NIFastLockGetStatistics(NIFastLock* lock) {
+  NIFastLockStatistics statistics;
+  statistics.numberOfAcquisitions = __atomic_load_n(&lock->acquisitions, __ATOMIC_RELAXED);
+  statistics.numberOfContentions = __atomic_load_n(&lock->contentions, __ATOMIC_RELAXED);
+  return statistics;
+}
+
+void NIFastLockResetStatistics(NIFastLock* lock) {
+  __atomic_store_n(&lock->acquisitions, 0ULL, __ATOMIC_RELAXED);
+  __atomic_store_n(&lock->contentions, 0ULL, __ATOMIC_RELAXED);
+}
@@ -19,6 +19,8 @@
 
 #import "NIPreprocessorMacros.h"
 
+@class NIMemoryCache;
+
 #if defined __cplusplus
 extern "C" {
 #endif
@@ -121,9 +123,31 @@ CGRect NIFrameOfCenteredViewWithinView(UIView* viewToCenter, UIView* containerVi
 
 /**
  * Returns the size of the string with given UILabel properties.
+ *
+ * Measurements are remembered in NIStringMeasurementCache, keyed by a hash of the string and
+ * every other argument, so measuring the same label again across reloads and rotations is a
+ * lookup. This is safe to call from any thread, which lets row heights be computed in the
+ * background.
  */
 CGSize NISizeOfStringWithLabelProperties(NSString *string, CGSize constrainedToSize, UIFont *font, NSLineBreakMode lineBreakMode, NSInteger numberOfLines);
 
+/**
+ * Returns the cache of measurements made by NISizeOfStringWithLabelProperties.
+ *
+ * Use the cache's statistics to see how often measurements are being reused.
+ */
+NIMemoryCache* NIStringMeasurementCache(void);
+
+/**
+ * Sets the number of measurements that NISizeOfStringWithLabelProperties remembers.
+ *
+ * The least recently used measurements are dropped first. Setting this to 0 turns the cache
+ * off and empties it.
+ *
+ * Default: 512
+ */
+void NISetMaxNumberOfStringMeasurements(NSUInteger maxNumberOfStringMeasurements);
+
 /**@}*/
 
 
@@ -174,6 +198,138 @@ NSString* NISHA1HashFromData(NSData* data);
 /**@}*/
 
 
+#pragma mark - Fast Hashing Methods
+
+/**
+ * For deriving cache keys and file names quickly.
+ *
+ * These are xxHash64-based non-cryptographic hashes. They are many times faster than
+ * NIMD5HashFromData and do not allocate, so prefer them whenever the hash is only used to
+ * identify something and never to protect it.
+ *
+ * @defgroup Fast-Hashing-Methods Fast Hashing Methods
+ * @{
+ */
+
+/**
+ * A 128-bit hash value.
+ */
+typedef struct {
+  uint64_t low;
+  uint64_t high;
+} NIHash128;
+
+/**
+ * The state of a streaming 64-bit hash.
+ *
+ * Treat the fields as private. Initialize the state with NIHashStateInit, feed it bytes with
+ * NIHashStateUpdate and read the hash with NIHashStateDigest. Hashing bytes in any number of
+ * pieces produces the same value as hashing them all at once.
+ */
+typedef struct {
+  uint64_t seed;
+  uint64_t totalLength;
+  uint64_t accumulators[4];
+  uint8_t buffer[32];
+  uint32_t bufferLength;
+} NIHashState;
+
+/**
+ * The state of a streaming 128-bit hash.
+ *
+ * Treat the fields as private.
+ */
+typedef struct {
+  NIHashState low;
+  NIHashState high;
+} NIHash128State;
+
+/**
+ * Resets the state so that it can hash a new stream of bytes.
+ *
+ * Hashes with different seeds are independent of one another.
+ */
+void NIHashStateInit(NIHashState* state, uint64_t seed);
+
+/**
+ * Feeds bytes to the hash.
+ */
+void NIHashStateUpdate(NIHashState* state, const void* bytes, size_t length);
+
+/**
+ * Feeds the UTF8 representation of the string to the hash without copying it to an NSData.
+ */
+void NIHashStateUpdateWithString(NIHashState* state, NSString* string);
+
+/**
+ * Returns the hash of every byte fed to the state so far.
+ *
+ * The state is not modified, so more bytes may be fed to it afterward.
+ */
+uint64_t NIHashStateDigest(const NIHashState* state);
+
+/**
+ * Resets the 128-bit state so that it can hash a new stream of bytes.
+ */
+void NIHash128StateInit(NIHash128State* state);
+
+/**
+ * Feeds bytes to the 128-bit hash.
+ */
+void NIHash128StateUpdate(NIHash128State* state, const void* bytes, size_t length);
+
+/**
+ * Feeds the UTF8 representation of the string to the 128-bit hash.
+ */
+void NIHash128StateUpdateWithString(NIHash128State* state, NSString* string);
+
+/**
+ * Returns the 128-bit hash of every byte fed to the state so far.
+ */
+NIHash128 NIHash128StateDigest(const NIHash128State* state);
+
+/**
+ * Calculates a 64-bit hash of the bytes.
+ */
+uint64_t NIHash64FromBytes(const void* bytes, size_t length);
+
+/**
+ * Calculates a 64-bit hash of the data.
+ */
+uint64_t NIHash64FromData(NSData* data);
+
+/**
+ * Calculates a 64-bit hash of the string.
+ *
+ * Treats the string as UTF8.
+ */
+uint64_t NIHash64FromString(NSString* string);
+
+/**
+ * Calculates a 128-bit hash of the bytes.
+ */
+NIHash128 NIHash128FromBytes(const void* bytes, size_t length);
+
+/**
+ * Calculates a 128-bit hash of the data.
+ */
+NIHash128 NIHash128FromData(NSData* data);
+
+/**
+ * Calculates a 128-bit hash of the string.
+ *
+ * Treats the string as UTF8.
+ */
+NIHash128 NIHash128FromString(NSString* string);
+
+/**
+ * Returns the hash as a 32 character lowercase hex string, suitable for use as a file name.
+ */
+NSString* NIHexStringFromHash128(NIHash128 hash);
+
+/**@}*/
+
+
 #pragma mark - NSString Methods
 
 /**
@@ -197,6 +353,14 @@ NSString* NIMD5HashFromString(NSString* string);
  */
 NSString* NISHA1HashFromString(NSString* string);
 
+/**
+ * Calculates a 64-bit FNV-1a hash of every UTF-16 character in the string.
+ *
+ * -[NSString hash] only samples the beginning and end of long strings, so strings such as URLs
+ * that differ only in the middle share a hash. Use this when every character needs to count.
+ */
+uint64_t NIFNVHashFromString(NSString* string);
+
 /**
  * Returns a Boolean value indicating whether the string is a NSString object that contains only
  * whitespace and newlines.
@@ -253,6 +417,32 @@ NSComparisonResult NICompareVersionStrings(NSString* string1, NSString* string2)
  */
 NSDictionary* NIQueryDictionaryFromStringUsingEncoding(NSString* string, NSStringEncoding encoding);
 
+/**
+ * A block invoked once for each parameter in a query string.
+ *
+ * @param key The percent-decoded parameter name.
+ * @param value The percent-decoded value, or nil if the parameter has no value.
+ * @param stop Set to YES to stop the enumeration.
+ */
+typedef void (^NIQueryParameterBlock)(NSString* key, NSString* value, BOOL* stop);
+
+/**
+ * Calls the block for each parameter of a URL query string, in order.
+ *
+ * The string is scanned once and each key and value is percent-decoded in place, so no
+ * intermediate arrays or strings are created. Parameters may be separated by & or ;. Empty
+ * parameters, parameters with more than one = and parameters that don't decode with the given
+ * encoding are skipped. With UTF-8, malformed percent escapes are kept as literal characters.
+ *
+ * The string is always scanned as UTF-8; the encoding only applies to the percent escapes. With
+ * encodings other than UTF-8 each key and value is decoded separately, and a parameter with a
+ * malformed escape is skipped.
+ *
+ * NIQueryDictionaryFromStringUsingEncoding is built on this.
+ */
+void NIEnumerateQueryParametersInStringUsingEncoding(NSString* string, NSStringEncoding encoding,
+                                                     NIQueryParameterBlock block);
+
 /**
  * Returns a string that has been escaped for use as a URL parameter.
  */
@@ -260,6 +450,9 @@ NSString* NIStringByAddingPercentEscapesForURLParameterString(NSString* paramete
 
 /**
  * Appends a dictionary of query parameters to a string, adding the ? character if necessary.
+ *
+ * The values are percent-escaped as they are written, and the result is built in a single
+ * buffer.
  */
 NSString* NIStringByAddingQueryDictionaryToString(NSString* string, NSDictionary* query);
 
@@ -17,6 +17,7 @@
 #import "NIFoundationMethods.h"
 
 #import "NIDebuggingTools.h"
+#import "NIInMemoryCache.h"
 #import <CommonCrypto/CommonDigest.h>
 #import <objc/runtime.h>
 
@@ -77,11 +78,7 @@ CGRect NIFrameOfCenteredViewWithinView(UIView* viewToCenter, UIView* containerVi
   return CGRectMake(origin.x, origin.y, viewSize.width, viewSize.height);
 }
 
-CGSize NISizeOfStringWithLabelProperties(NSString *string, CGSize constrainedToSize, UIFont *font, NSLineBreakMode lineBreakMode, NSInteger numberOfLines) {
-  if (string.length == 0) {
-    return CGSizeZero;
-  }
-
+static CGSize NIMeasureStringWithLabelProperties(NSString *string, CGSize constrainedToSize, UIFont *font, NSLineBreakMode lineBreakMode, NSInteger numberOfLines) {
   CGFloat lineHeight = font.lineHeight;
   CGSize size = CGSizeZero;
 
@@ -103,6 +100,140 @@ CGSize NISizeOfStringWithLabelProperties(NSString *string, CGSize constrainedToS
   return size;
 }
 
+// Unconstrained sizes are CGFLOAT_MAX, and converting that to an integer is undefined, so the
+// float's bits are hashed instead.
+static NSUInteger NIHashFromCGFloat(CGFloat value) {
+  if (value == 0) {
+    value = 0; // -0 is equal to 0 and must hash the same.
+  }
+  unsigned long long bits = 0;
+  memcpy(&bits, &value, sizeof(value));
+  return (NSUInteger)(bits ^ (bits >> 32));
+}
+
+// Identifies a measurement without building a name from the string itself.
+@interface NIStringMeasurementKey : NSObject <NIMemoryCacheKey>
+@end
+
+@implementation NIStringMeasurementKey {
+  NIHash128 _stringHash;
+  NSUInteger _stringLength;
+  NSString* _fontName;
+  CGFloat _pointSize;
+  CGSize _constrainedToSize;
+  NSLineBreakMode _lineBreakMode;
+  NSInteger _numberOfLines;
+}
+
+- (id)initWithString:(NSString *)string constrainedToSize:(CGSize)constrainedToSize font:(UIFont *)font lineBreakMode:(NSLineBreakMode)lineBreakMode numberOfLines:(NSInteger)numberOfLines {
+  if ((self = [super init])) {
+    _stringHash = NIHash128FromString(string);
+    _stringLength = string.length;
+    _fontName = [font.fontName copy];
+    _pointSize = font.pointSize;
+    _constrainedToSize = constrainedToSize;
+    _lineBreakMode = lineBreakMode;
+    _numberOfLines = numberOfLines;
+  }
+  return self;
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+  return self;
+}
+
+- (NSUInteger)hash {
+  return (NSUInteger)(_stringHash.low ^ [_fontName hash] ^ NIHashFromCGFloat(_pointSize)
+                      ^ (NIHashFromCGFloat(_constrainedToSize.width) << 8)
+                      ^ NIHashFromCGFloat(_constrainedToSize.height));
+}
+
+- (BOOL)isEqual:(id)object {
+  if (![object isKindOfClass:[NIStringMeasurementKey class]]) {
+    return NO;
+  }
+  NIStringMeasurementKey* other = object;
+  return (_stringHash.low == other->_stringHash.low
+          && _stringHash.high == other->_stringHash.high
+          && _stringLength == other->_stringLength
+          && _pointSize == other->_pointSize
+          && CGSizeEqualToSize(_constrainedToSize, other->_constrainedToSize)
+          && _lineBreakMode == other->_lineBreakMode
+          && _numberOfLines == other->_numberOfLines
+          && [_fontName isEqualToString:other->_fontName]);
+}
+
+- (NSString *)memoryCacheName {
+  return [NSString stringWithFormat:@"%@:%lu:%@:%g:%gx%g:%ld:%ld",
+          NIHexStringFromHash128(_stringHash), (unsigned long)_stringLength, _fontName,
+          (double)_pointSize, (double)_constrainedToSize.width, (double)_constrainedToSize.height,
+          (long)_lineBreakMode, (long)_numberOfLines];
+}
+
+@end
+
+static NSUInteger sMaxNumberOfStringMeasurements = 512;
+
+NIMemoryCache* NIStringMeasurementCache(void) {
+  static NIMemoryCache* sCache = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    // Heights are often computed on several threads at once.
+    sCache = [[NIMemoryCache alloc] initWithCapacity:sMaxNumberOfStringMeasurements numberOfSegments:4];
+  });
+  return sCache;
+}
+
+void NISetMaxNumberOfStringMeasurements(NSUInteger maxNumberOfStringMeasurements) {
+  NIMemoryCache* cache = NIStringMeasurementCache();
+  @synchronized(cache) {
+    sMaxNumberOfStringMeasurements = maxNumberOfStringMeasurements;
+  }
+  if (0 == maxNumberOfStringMeasurements) {
+    [cache removeAllObjects];
+  } else {
+    // Every measurement is stored with a cost of 1, so costs count measurements.
+    unsigned long long numberOfMeasurements = [cache numberOfBytesInMemoryBudget];
+    if (numberOfMeasurements > maxNumberOfStringMeasurements) {
+      [cache reduceMemoryUsageByNumberOfBytes:numberOfMeasurements - maxNumberOfStringMeasurements];
+    }
+  }
+}
+
+CGSize NISizeOfStringWithLabelProperties(NSString *string, CGSize constrainedToSize, UIFont *font, NSLineBreakMode lineBreakMode, NSInteger numberOfLines) {
+  if (string.length == 0) {
+    return CGSizeZero;
+  }
+
+  NIMemoryCache* cache = NIStringMeasurementCache();
+  NSUInteger maxNumberOfStringMeasurements;
+  @synchronized(cache) {
+    maxNumberOfStringMeasurements = sMaxNumberOfStringMeasurements;
+  }
+  if (0 == maxNumberOfStringMeasurements || nil == font) {
+    return NIMeasureStringWithLabelProperties(string, constrainedToSize, font, lineBreakMode, numberOfLines);
+  }
+
+  NIStringMeasurementKey* key = [[NIStringMeasurementKey alloc] initWithString:string
+                                                             constrainedToSize:constrainedToSize
+                                                                          font:font
+                                                                 lineBreakMode:lineBreakMode
+                                                                 numberOfLines:numberOfLines];
+  NSValue* measurement = [cache objectWithKey:key];
+  if (nil != measurement) {
+    return [measurement CGSizeValue];
+  }
+
+  CGSize size = NIMeasureStringWithLabelProperties(string, constrainedToSize, font, lineBreakMode, numberOfLines);
+  [cache storeObject:[NSValue valueWithCGSize:size] withKey:key expiresAfter:nil cost:1];
+
+  unsigned long long numberOfMeasurements = [cache numberOfBytesInMemoryBudget];
+  if (numberOfMeasurements > maxNumberOfStringMeasurements) {
+    [cache reduceMemoryUsageByNumberOfBytes:numberOfMeasurements - maxNumberOfStringMeasurements];
+  }
+  return size;
+}
+
 #pragma mark - NSRange
 
 NSRange NIMakeNSRangeFromCFRange(CFRange range) {
@@ -163,6 +294,229 @@ NSString* NISHA1HashFromData(NSData* data) {
           ];
 }
 
+#pragma mark - Fast Hashing
+
+static const uint64_t kHashPrime1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t kHashPrime2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t kHashPrime3 = 0x165667B19E3779F9ULL;
+static const uint64_t kHashPrime4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t kHashPrime5 = 0x27D4EB2F165667C5ULL;
+
+// The seed of the high half of a 128-bit hash. The low half uses a seed of 0, which makes it
+// identical to the 64-bit hash of the same bytes.
+static const uint64_t kHash128HighSeed = 0x9E3779B97F4A7C15ULL;
+
+static inline uint64_t NIHashRotateLeft(uint64_t value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t NIHashRead64(const uint8_t* bytes) {
+  uint64_t value;
+  memcpy(&value, bytes, sizeof(value));
+  return CFSwapInt64LittleToHost(value);
+}
+
+static inline uint32_t NIHashRead32(const uint8_t* bytes) {
+  uint32_t value;
+  memcpy(&value, bytes, sizeof(value));
+  return CFSwapInt32LittleToHost(value);
+}
+
+static inline uint64_t NIHashRound(uint64_t accumulator, uint64_t input) {
+  accumulator += input * kHashPrime2;
+  accumulator = NIHashRotateLeft(accumulator, 31);
+  return accumulator * kHashPrime1;
+}
+
+static inline uint64_t NIHashMergeRound(uint64_t hash, uint64_t accumulator) {
+  hash ^= NIHashRound(0, accumulator);
+  return hash * kHashPrime1 + kHashPrime4;
+}
+
+// Consumes one 32 byte stripe.
+static inline void NIHashConsumeStripe(uint64_t* accumulators, const uint8_t* bytes) {
+  accumulators[0] = NIHashRound(accumulators[0], NIHashRead64(bytes));
+  accumulators[1] = NIHashRound(accumulators[1], NIHashRead64(bytes + 8));
+  accumulators[2] = NIHashRound(accumulators[2], NIHashRead64(bytes + 16));
+  accumulators[3] = NIHashRound(accumulators[3], NIHashRead64(bytes + 24));
+}
+
+void NIHashStateInit(NIHashState* state, uint64_t seed) {
+  memset(state, 0, sizeof(*state));
+  state->seed = seed;
+  state->accumulators[0] = seed + kHashPrime1 + kHashPrime2;
+  state->accumulators[1] = seed + kHashPrime2;
+  state->accumulators[2] = seed;
+  state->accumulators[3] = seed - kHashPrime1;
+}
+
+void NIHashStateUpdate(NIHashState* state, const void* bytes, size_t length) {
+  if (NULL == bytes || 0 == length) {
+    return;
+  }
+  const uint8_t* input = bytes;
+  state->totalLength += length;
+
+  // Top up a partially filled stripe first.
+  if (state->bufferLength > 0) {
+    size_t numberOfBytesToCopy = MIN(length, sizeof(state->buffer) - state->bufferLength);
+    memcpy(state->buffer + state->bufferLength, input, numberOfBytesToCopy);
+    state->bufferLength += (uint32_t)numberOfBytesToCopy;
+    input += numberOfBytesToCopy;
+    length -= numberOfBytesToCopy;
+    if (state->bufferLength < sizeof(state->buffer)) {
+      return;
+    }
+    NIHashConsumeStripe(state->accumulators, state->buffer);
+    state->bufferLength = 0;
+  }
+
+  while (length >= sizeof(state->buffer)) {
+    NIHashConsumeStripe(state->accumulators, input);
+    input += sizeof(state->buffer);
+    length -= sizeof(state->buffer);
+  }
+
+  if (length > 0) {
+    memcpy(state->buffer, input, length);
+    state->bufferLength = (uint32_t)length;
+  }
+}
+
+// Hands the UTF8 representation of the string to the block in stack-sized chunks.
+static void NIHashEnumerateUTF8Chunks(NSString* string, void (^block)(const uint8_t* bytes, NSUInteger length)) {
+  uint8_t buffer[256];
+  NSRange remainingRange = NSMakeRange(0, string.length);
+  while (remainingRange.length > 0) {
+    NSUInteger usedLength = 0;
+    [string getBytes:buffer
+           maxLength:sizeof(buffer)
+          usedLength:&usedLength
+            encoding:NSUTF8StringEncoding
+             options:0
+               range:remainingRange
+      remainingRange:&remainingRange];
+    if (0 == usedLength) {
+      // The remaining characters can't be represented in UTF8 (e.g. an unpaired surrogate).
+      break;
+    }
+    block(buffer, usedLength);
+  }
+}
+
+void NIHashStateUpdateWithString(NIHashState* state, NSString* string) {
+  NIHashEnumerateUTF8Chunks(string, ^(const uint8_t* bytes, NSUInteger length) {
+    NIHashStateUpdate(state, bytes, length);
+  });
+}
+
+uint64_t NIHashStateDigest(const NIHashState* state) {
+  uint64_t hash;
+  if (state->totalLength >= sizeof(state->buffer)) {
+    const uint64_t* accumulators = state->accumulators;
+    hash = (NIHashRotateLeft(accumulators[0], 1) + NIHashRotateLeft(accumulators[1], 7)
+            + NIHashRotateLeft(accumulators[2], 12) + NIHashRotateLeft(accumulators[3], 18));
+    for (NSInteger ix = 0; ix < 4; ++ix) {
+      hash = NIHashMergeRound(hash, accumulators[ix]);
+    }
+  } else {
+    hash = state->seed + kHashPrime5;
+  }
+  hash += state->totalLength;
+
+  const uint8_t* tail = state->buffer;
+  uint32_t remainingLength = state->bufferLength;
+  while (remainingLength >= 8) {
+    hash ^= NIHashRound(0, NIHashRead64(tail));
+    hash = NIHashRotateLeft(hash, 27) * kHashPrime1 + kHashPrime4;
+    tail += 8;
+    remainingLength -= 8;
+  }
+  if (remainingLength >= 4) {
+    hash ^= (uint64_t)NIHashRead32(tail) * kHashPrime1;
+    hash = NIHashRotateLeft(hash, 23) * kHashPrime2 + kHashPrime3;
+    tail += 4;
+    remainingLength -= 4;
+  }
+  while (remainingLength > 0) {
+    hash ^= (*tail) * kHashPrime5;
+    hash = NIHashRotateLeft(hash, 11) * kHashPrime1;
+    ++tail;
+    --remainingLength;
+  }
+
+  hash ^= hash >> 33;
+  hash *= kHashPrime2;
+  hash ^= hash >> 29;
+  hash *= kHashPrime3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+void NIHash128StateInit(NIHash128State* state) {
+  NIHashStateInit(&state->low, 0);
+  NIHashStateInit(&state->high, kHash128HighSeed);
+}
+
+void NIHash128StateUpdate(NIHash128State* state, const void* bytes, size_t length) {
+  NIHashStateUpdate(&state->low, bytes, length);
+  NIHashStateUpdate(&state->high, bytes, length);
+}
+
+void NIHash128StateUpdateWithString(NIHash128State* state, NSString* string) {
+  NIHashEnumerateUTF8Chunks(string, ^(const uint8_t* bytes, NSUInteger length) {
+    NIHash128StateUpdate(state, bytes, length);
+  });
+}
+
+NIHash128 NIHash128StateDigest(const NIHash128State* state) {
+  NIHash128 hash;
+  hash.low = NIHashStateDigest(&state->low);
+  hash.high = NIHashStateDigest(&state->high);
+  return hash;
+}
+
+uint64_t NIHash64FromBytes(const void* bytes, size_t length) {
+  NIHashState state;
+  NIHashStateInit(&state, 0);
+  NIHashStateUpdate(&state, bytes, length);
+  return NIHashStateDigest(&state);
+}
+
+uint64_t NIHash64FromData(NSData* data) {
+  return NIHash64FromBytes([data bytes], [data length]);
+}
+
+uint64_t NIHash64FromString(NSString* string) {
+  NIHashState state;
+  NIHashStateInit(&state, 0);
+  NIHashStateUpdateWithString(&state, string);
+  return NIHashStateDigest(&state);
+}
+
+NIHash128 NIHash128FromBytes(const void* bytes, size_t length) {
+  NIHash128State state;
+  NIHash128StateInit(&state);
+  NIHash128StateUpdate(&state, bytes, length);
+  return NIHash128StateDigest(&state);
+}
+
+NIHash128 NIHash128FromData(NSData* data) {
+  return NIHash128FromBytes([data bytes], [data length]);
+}
+
+NIHash128 NIHash128FromString(NSString* string) {
+  NIHash128State state;
+  NIHash128StateInit(&state);
+  NIHash128StateUpdateWithString(&state, string);
+  return NIHash128StateDigest(&state);
+}
+
+NSString* NIHexStringFromHash128(NIHash128 hash) {
+  return [NSString stringWithFormat:@"%016llx%016llx",
+          (unsigned long long)hash.high, (unsigned long long)hash.low];
+}
+
 #pragma mark - NSString
 
 NSString* NIMD5HashFromString(NSString* string) {
@@ -173,6 +527,21 @@ NSString* NISHA1HashFromString(NSString* string) {
   return NISHA1HashFromData([string dataUsingEncoding:NSUTF8StringEncoding]);
 }
 
+uint64_t NIFNVHashFromString(NSString* string) {
+  uint64_t hash = 14695981039346656037ULL;
+  unichar buffer[64];
+  NSUInteger length = string.length;
+  for (NSUInteger location = 0; location < length; location += 64) {
+    NSRange range = NSMakeRange(location, MIN((NSUInteger)64, length - location));
+    [string getCharacters:buffer range:range];
+    for (NSUInteger ix = 0; ix < range.length; ++ix) {
+      hash ^= buffer[ix];
+      hash *= 1099511628211ULL;
+    }
+  }
+  return hash;
+}
+
 BOOL NIIsStringWithWhitespaceAndNewlines(NSString* string) {
   NSCharacterSet* notWhitespaceAndNewlines = [[NSCharacterSet whitespaceAndNewlineCharacterSet] invertedSet];
   return [string isKindOfClass:[NSString class]] && [string rangeOfCharacterFromSet:notWhitespaceAndNewlines].length == 0;
@@ -212,65 +581,254 @@ NSComparisonResult NICompareVersionStrings(NSString* string1, NSString* string2)
   return [oneAlpha compare:twoAlpha];
 }
 
-NSDictionary* NIQueryDictionaryFromStringUsingEncoding(NSString* string, NSStringEncoding encoding) {
-  NSCharacterSet* delimiterSet = [NSCharacterSet characterSetWithCharactersInString:@"&;"];
-  NSMutableDictionary* pairs = [NSMutableDictionary dictionary];
-  NSScanner* scanner = [[NSScanner alloc] initWithString:string];
+// Query strings are short, so most of them fit in a buffer on the stack.
+static const size_t kQueryStackBufferSize = 512;
+
+// A growable byte buffer that starts out on the stack.
+typedef struct {
+  uint8_t* bytes;
+  size_t length;
+  size_t capacity;
+  uint8_t stackBytes[kQueryStackBufferSize];
+} NIQueryBuffer;
+
+static void NIQueryBufferInit(NIQueryBuffer* buffer) {
+  buffer->bytes = buffer->stackBytes;
+  buffer->length = 0;
+  buffer->capacity = sizeof(buffer->stackBytes);
+}
+
+static void NIQueryBufferFree(NIQueryBuffer* buffer) {
+  if (buffer->bytes != buffer->stackBytes) {
+    free(buffer->bytes);
+  }
+  buffer->bytes = buffer->stackBytes;
+}
+
+static BOOL NIQueryBufferReserve(NIQueryBuffer* buffer, size_t additionalLength) {
+  size_t requiredCapacity = buffer->length + additionalLength;
+  if (requiredCapacity <= buffer->capacity) {
+    return YES;
+  }
+  size_t capacity = MAX(buffer->capacity * 2, requiredCapacity);
+  uint8_t* bytes = NULL;
+  if (buffer->bytes == buffer->stackBytes) {
+    bytes = malloc(capacity);
+    if (NULL != bytes) {
+      memcpy(bytes, buffer->bytes, buffer->length);
+    }
+  } else {
+    bytes = realloc(buffer->bytes, capacity);
+  }
+  if (NULL == bytes) {
+    return NO;
+  }
+  buffer->bytes = bytes;
+  buffer->capacity = capacity;
+  return YES;
+}
 
-  while (![scanner isAtEnd]) {
-    NSString* pairString = nil;
-    [scanner scanUpToCharactersFromSet:delimiterSet intoString:&pairString];
-    [scanner scanCharactersFromSet:delimiterSet intoString:NULL];
+static void NIQueryBufferAppendBytes(NIQueryBuffer* buffer, const void* bytes, size_t length) {
+  if (NIQueryBufferReserve(buffer, length)) {
+    memcpy(buffer->bytes + buffer->length, bytes, length);
+    buffer->length += length;
+  }
+}
 
-    NSArray* kvPair = [pairString componentsSeparatedByString:@"="];
-    if (kvPair.count == 1 || kvPair.count == 2) {
-      NSString* key = [kvPair[0] stringByReplacingPercentEscapesUsingEncoding:encoding];
+// Appends the string's bytes in the given encoding without creating an intermediate NSData.
+static void NIQueryBufferAppendString(NIQueryBuffer* buffer, NSString* string, NSStringEncoding encoding) {
+  size_t maximumLength = [string maximumLengthOfBytesUsingEncoding:encoding];
+  if (!NIQueryBufferReserve(buffer, maximumLength)) {
+    return;
+  }
+  NSUInteger usedLength = 0;
+  [string getBytes:buffer->bytes + buffer->length
+         maxLength:maximumLength
+        usedLength:&usedLength
+          encoding:encoding
+           options:NSStringEncodingConversionAllowLossy
+             range:NSMakeRange(0, string.length)
+    remainingRange:NULL];
+  buffer->length += usedLength;
+}
 
-      NSMutableArray* values = pairs[key];
-      if (nil == values) {
-        values = [NSMutableArray array];
-        pairs[key] = values;
+static int NIHexDigitValue(uint8_t character) {
+  if (character >= '0' && character <= '9') {
+    return character - '0';
+  } else if (character >= 'a' && character <= 'f') {
+    return character - 'a' + 10;
+  } else if (character >= 'A' && character <= 'F') {
+    return character - 'A' + 10;
+  }
+  return -1;
+}
+
+// Percent-decodes the bytes in place and returns the decoded length.
+static size_t NIPercentDecodeInPlace(uint8_t* bytes, size_t length) {
+  size_t writeIndex = 0;
+  for (size_t readIndex = 0; readIndex < length; ++readIndex) {
+    uint8_t character = bytes[readIndex];
+    if ('%' == character && readIndex + 2 < length) {
+      int high = NIHexDigitValue(bytes[readIndex + 1]);
+      int low = NIHexDigitValue(bytes[readIndex + 2]);
+      if (high >= 0 && low >= 0) {
+        character = (uint8_t)((high << 4) | low);
+        readIndex += 2;
       }
+    }
+    bytes[writeIndex++] = character;
+  }
+  return writeIndex;
+}
+
+// Decodes one key or value of the query. The bytes are UTF-8.
+static NSString* NIStringByDecodingQueryComponent(uint8_t* bytes, size_t length,
+                                                  NSStringEncoding encoding) {
+  if (NSUTF8StringEncoding == encoding) {
+    size_t decodedLength = NIPercentDecodeInPlace(bytes, length);
+    return [[NSString alloc] initWithBytes:bytes length:decodedLength encoding:NSUTF8StringEncoding];
+  }
+  // The escaped bytes are in another encoding than the literal characters around them, so the
+  // component can't be decoded as one run of bytes.
+  NSString* component = [[NSString alloc] initWithBytes:bytes length:length
+                                               encoding:NSUTF8StringEncoding];
+  return [component stringByReplacingPercentEscapesUsingEncoding:encoding];
+}
 
-      if (kvPair.count == 1) {
-        [values addObject:[NSNull null]];
+void NIEnumerateQueryParametersInStringUsingEncoding(NSString* string, NSStringEncoding encoding,
+                                                     NIQueryParameterBlock block) {
+  if (nil == block || 0 == string.length) {
+    return;
+  }
+  // The separators are only found by their byte values in an ASCII-compatible encoding, and
+  // UTF-8 never uses those byte values inside a multibyte character, so the string is always
+  // scanned as UTF-8 whatever encoding its escapes use.
+  NIQueryBuffer buffer;
+  NIQueryBufferInit(&buffer);
+  NIQueryBufferAppendString(&buffer, string, NSUTF8StringEncoding);
+
+  uint8_t* bytes = buffer.bytes;
+  const size_t length = buffer.length;
+  BOOL stop = NO;
+  size_t pairStart = 0;
+  while (!stop && pairStart < length) {
+    size_t pairEnd = pairStart;
+    size_t separatorIndex = NSNotFound;
+    NSInteger numberOfSeparators = 0;
+    while (pairEnd < length && '&' != bytes[pairEnd] && ';' != bytes[pairEnd]) {
+      if ('=' == bytes[pairEnd]) {
+        if (0 == numberOfSeparators) {
+          separatorIndex = pairEnd;
+        }
+        ++numberOfSeparators;
+      }
+      ++pairEnd;
+    }
 
-      } else if (kvPair.count == 2) {
-        NSString* value = [kvPair[1] stringByReplacingPercentEscapesUsingEncoding:encoding];
-        [values addObject:value];
+    if (pairEnd > pairStart && numberOfSeparators <= 1) {
+      size_t keyEnd = (NSNotFound == separatorIndex) ? pairEnd : separatorIndex;
+      NSString* key = NIStringByDecodingQueryComponent(bytes + pairStart, keyEnd - pairStart,
+                                                       encoding);
+      NSString* value = nil;
+      BOOL isValid = (nil != key);
+      if (isValid && NSNotFound != separatorIndex) {
+        size_t valueStart = separatorIndex + 1;
+        value = NIStringByDecodingQueryComponent(bytes + valueStart, pairEnd - valueStart,
+                                                 encoding);
+        isValid = (nil != value);
+      }
+      if (isValid) {
+        block(key, value, &stop);
       }
     }
+    pairStart = pairEnd + 1;
   }
+
+  NIQueryBufferFree(&buffer);
+}
+
+NSDictionary* NIQueryDictionaryFromStringUsingEncoding(NSString* string, NSStringEncoding encoding) {
+  NSMutableDictionary* pairs = [NSMutableDictionary dictionary];
+  NIEnumerateQueryParametersInStringUsingEncoding(string, encoding, ^(NSString* key, NSString* value, BOOL* stop) {
+    NSMutableArray* values = pairs[key];
+    if (nil == values) {
+      values = [NSMutableArray array];
+      pairs[key] = values;
+    }
+    [values addObject:(nil != value) ? value : [NSNull null]];
+  });
   return [pairs copy];
 }
 
-NSString* NIStringByAddingPercentEscapesForURLParameterString(NSString* parameter) {
-  CFStringRef buffer = CFURLCreateStringByAddingPercentEscapes(kCFAllocatorDefault,
-                                                               (__bridge CFStringRef)parameter,
-                                                               NULL,
-                                                               (__bridge CFStringRef)@"!*'();:@&=+$,/?%#[]",
-                                                               kCFStringEncodingUTF8);
+// Everything but the RFC 3986 unreserved characters is escaped in parameters.
+static BOOL NIIsUnreservedURLCharacter(uint8_t character) {
+  return ((character >= 'a' && character <= 'z')
+          || (character >= 'A' && character <= 'Z')
+          || (character >= '0' && character <= '9')
+          || '-' == character || '.' == character || '_' == character || '~' == character);
+}
+
+static void NIQueryBufferAppendPercentEscapedString(NIQueryBuffer* buffer, NSString* string) {
+  static const char kHexDigits[] = "0123456789ABCDEF";
+  NIQueryBuffer utf8;
+  NIQueryBufferInit(&utf8);
+  NIQueryBufferAppendString(&utf8, string, NSUTF8StringEncoding);
+
+  // Every byte expands to at most three.
+  if (NIQueryBufferReserve(buffer, utf8.length * 3)) {
+    uint8_t* output = buffer->bytes + buffer->length;
+    for (size_t ix = 0; ix < utf8.length; ++ix) {
+      uint8_t character = utf8.bytes[ix];
+      if (NIIsUnreservedURLCharacter(character)) {
+        *output++ = character;
+      } else {
+        *output++ = '%';
+        *output++ = kHexDigits[character >> 4];
+        *output++ = kHexDigits[character & 0xF];
+      }
+    }
+    buffer->length = output - buffer->bytes;
+  }
+  NIQueryBufferFree(&utf8);
+}
 
-  NSString* result = [NSString stringWithString:(__bridge NSString *)buffer];
-  CFRelease(buffer);
-  return result;
+static NSString* NIStringFromQueryBuffer(NIQueryBuffer* buffer) {
+  NSString* string = [[NSString alloc] initWithBytes:buffer->bytes
+                                              length:buffer->length
+                                            encoding:NSUTF8StringEncoding];
+  NIQueryBufferFree(buffer);
+  return string;
 }
 
-NSString* NIStringByAddingQueryDictionaryToString(NSString* string, NSDictionary* query) {
-  NSMutableArray* pairs = [NSMutableArray array];
-  for (NSString* key in [query keyEnumerator]) {
-    NSString* value = NIStringByAddingPercentEscapesForURLParameterString([query objectForKey:key]);
-    NSString* pair = [NSString stringWithFormat:@"%@=%@", key, value];
-    [pairs addObject:pair];
+NSString* NIStringByAddingPercentEscapesForURLParameterString(NSString* parameter) {
+  if (nil == parameter) {
+    return nil;
   }
+  NIQueryBuffer buffer;
+  NIQueryBufferInit(&buffer);
+  NIQueryBufferAppendPercentEscapedString(&buffer, parameter);
+  return NIStringFromQueryBuffer(&buffer);
+}
 
-  NSString* params = [pairs componentsJoinedByString:@"&"];
-  if ([string rangeOfString:@"?"].location == NSNotFound) {
-    return [string stringByAppendingFormat:@"?%@", params];
+NSString* NIStringByAddingQueryDictionaryToString(NSString* string, NSDictionary* query) {
+  NIQueryBuffer buffer;
+  NIQueryBufferInit(&buffer);
+  NIQueryBufferAppendString(&buffer, string, NSUTF8StringEncoding);
 
-  } else {
-    return [string stringByAppendingFormat:@"&%@", params];
+  // The separator is added even when there are no parameters.
+  NIQueryBufferAppendBytes(&buffer, ([string rangeOfString:@"?"].location == NSNotFound) ? "?" : "&", 1);
+  BOOL isFirstParameter = YES;
+  for (NSString* key in [query keyEnumerator]) {
+    id value = [query objectForKey:key];
+    if (!isFirstParameter) {
+      NIQueryBufferAppendBytes(&buffer, "&", 1);
+    }
+    isFirstParameter = NO;
+    NIQueryBufferAppendString(&buffer, key, NSUTF8StringEncoding);
+    NIQueryBufferAppendBytes(&buffer, "=", 1);
+    NIQueryBufferAppendPercentEscapedString(&buffer, [value isKindOfClass:[NSString class]] ? value : [value description]);
   }
+  return NIStringFromQueryBuffer(&buffer);
 }
 
 #pragma mark - General Purpose
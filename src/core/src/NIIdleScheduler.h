@@ -0,0 +1,142 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+
+/**
+ * For running deferred work while the main run loop has nothing else to do.
+ *
+ * Warming up caches, building views ahead of time and precomputing layout all make the app
+ * faster later, but doing them right away costs frames now. The idle scheduler runs such work
+ * in short slices just before the main run loop goes to sleep, and never while the user is
+ * tracking a scroll view.
+ *
+ * @ingroup NimbusCore
+ * @defgroup Idle-Scheduling Idle Scheduling
+ * @{
+ */
+
+/**
+ * The order in which idle tasks are run. Every task of a higher priority runs before any task
+ * of a lower one.
+ */
+typedef enum {
+  NIIdleTaskPriorityHigh,
+  NIIdleTaskPriorityDefault,
+  NIIdleTaskPriorityLow,
+} NIIdleTaskPriority;
+
+/**
+ * A slice of idle work. Return YES if the task has more work to do, in which case it is called
+ * again on a later slice, or NO once it is done.
+ */
+typedef BOOL (^NIIdleTaskBlock)(void);
+
+/**
+ * A handle for cancelling a scheduled idle task.
+ */
+@interface NIIdleTaskToken : NSObject
+
+- (void)cancel;
+
+@property (nonatomic, readonly, getter = isCancelled) BOOL cancelled;
+@property (nonatomic, readonly, getter = isFinished) BOOL finished;
+
+@end
+
+/**
+ * Runs tasks on the main thread whenever its run loop is about to wait in the default mode.
+ *
+ * Each time the run loop is about to go idle, tasks are run in priority order, first come first
+ * served within a priority, until timeBudget has been spent. If tasks are left the run loop is
+ * woken so that events are handled before the next slice. The scheduler only observes the
+ * default run loop mode, so it pauses on its own while UITrackingRunLoopMode is running.
+ *
+ * The scheduler must only be used from the main thread.
+ */
+@interface NIIdleScheduler : NSObject
+
++ (NIIdleScheduler *)sharedScheduler;
+
+@property (nonatomic) NSTimeInterval timeBudget; // Default: 0.004
+
+- (NIIdleTaskToken *)scheduleTaskWithPriority:(NIIdleTaskPriority)priority block:(NIIdleTaskBlock)block;
+- (void)cancelAllTasks;
+
+- (NSUInteger)numberOfTasks;
+
+@end
+
+/**@}*/// End of Idle Scheduling //////////////////////////////////////////////////////////////////
+
+/** @name Scheduling Idle Tasks */
+
+/**
+ * Returns the scheduler shared by all of Nimbus.
+ *
+ * @fn NIIdleScheduler::sharedScheduler
+ */
+
+/**
+ * The amount of time each idle slice may spend running tasks.
+ *
+ * A task that is running when the budget runs out is allowed to finish its call, so tasks
+ * should do a small, bounded amount of work per call and return YES to be called again. At
+ * least one task is run per slice.
+ *
+ * @fn NIIdleScheduler::timeBudget
+ */
+
+/**
+ * Schedules a task to be run the next time the main run loop is idle.
+ *
+ * @returns A token that cancels the task.
+ * @fn NIIdleScheduler::scheduleTaskWithPriority:block:
+ */
+
+/**
+ * Cancels every scheduled task.
+ *
+ * @fn NIIdleScheduler::cancelAllTasks
+ */
+
+/**
+ * Returns the number of tasks that have been scheduled and neither finished nor been
+ * cancelled.
+ *
+ * @fn NIIdleScheduler::numberOfTasks
+ */
+
+/** @name Cancelling Idle Tasks */
+
+/**
+ * Removes the task from its scheduler. A cancelled task is never called again.
+ *
+ * @fn NIIdleTaskToken::cancel
+ */
+
+/**
+ * Whether the task was cancelled.
+ *
+ * @fn NIIdleTaskToken::cancelled
+ */
+
+/**
+ * Whether the task ran to completion.
+ *
+ * @fn NIIdleTaskToken::finished
+ */
@@ -0,0 +1,187 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIIdleScheduler.h"
+
+#import "NIDebuggingTools.h"
+
+#import <QuartzCore/QuartzCore.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+static const NSUInteger kNIIdleTaskNumberOfPriorities = NIIdleTaskPriorityLow + 1;
+
+@interface NIIdleTaskToken ()
+@property (nonatomic, copy) NIIdleTaskBlock block;
+@property (nonatomic, weak) NIIdleScheduler* scheduler;
+@property (nonatomic, readwrite, getter = isCancelled) BOOL cancelled;
+@property (nonatomic, readwrite, getter = isFinished) BOOL finished;
+@end
+
+@interface NIIdleScheduler ()
+- (void)removeTask:(NIIdleTaskToken *)task;
+@end
+
+@implementation NIIdleTaskToken
+
+- (void)cancel {
+  if (self.cancelled || self.finished) {
+    return;
+  }
+  self.cancelled = YES;
+  self.block = nil;
+  [self.scheduler removeTask:self];
+}
+
+@end
+
+@implementation NIIdleScheduler {
+  // One queue of tasks per priority, oldest first.
+  NSMutableArray* _tasksByPriority[kNIIdleTaskNumberOfPriorities];
+  CFRunLoopObserverRef _observer;
+}
+
+- (void)dealloc {
+  [self stopObserving];
+}
+
+- (id)init {
+  if ((self = [super init])) {
+    for (NSUInteger ix = 0; ix < kNIIdleTaskNumberOfPriorities; ++ix) {
+      _tasksByPriority[ix] = [[NSMutableArray alloc] init];
+    }
+    _timeBudget = 0.004;
+  }
+  return self;
+}
+
++ (NIIdleScheduler *)sharedScheduler {
+  static NIIdleScheduler* sScheduler = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sScheduler = [[NIIdleScheduler alloc] init];
+  });
+  return sScheduler;
+}
+
+#pragma mark - Run Loop
+
+- (void)startObserving {
+  if (NULL != _observer) {
+    return;
+  }
+  __weak NIIdleScheduler* weakSelf = self;
+  _observer = CFRunLoopObserverCreateWithHandler(kCFAllocatorDefault, kCFRunLoopBeforeWaiting, YES, 0, ^(CFRunLoopObserverRef observer, CFRunLoopActivity activity) {
+    [weakSelf runTasks];
+  });
+  // Only the default mode is observed so that tracking a scroll view pauses idle work.
+  CFRunLoopAddObserver(CFRunLoopGetMain(), _observer, kCFRunLoopDefaultMode);
+  CFRunLoopWakeUp(CFRunLoopGetMain());
+}
+
+- (void)stopObserving {
+  if (NULL != _observer) {
+    CFRunLoopObserverInvalidate(_observer);
+    CFRelease(_observer);
+    _observer = NULL;
+  }
+}
+
+- (NIIdleTaskToken *)nextTask {
+  for (NSUInteger ix = 0; ix < kNIIdleTaskNumberOfPriorities; ++ix) {
+    NIIdleTaskToken* task = [_tasksByPriority[ix] firstObject];
+    if (nil != task) {
+      return task;
+    }
+  }
+  return nil;
+}
+
+- (void)runTasks {
+  CFTimeInterval deadline = CACurrentMediaTime() + self.timeBudget;
+  NIIdleTaskToken* task = nil;
+  do {
+    task = [self nextTask];
+    if (nil == task) {
+      break;
+    }
+    NIIdleTaskBlock block = task.block;
+    BOOL hasMoreWork = (nil != block && block());
+
+    // The block may have cancelled its own task or others.
+    if (!hasMoreWork && !task.cancelled) {
+      task.finished = YES;
+      task.block = nil;
+      [self removeTask:task];
+    }
+  } while (CACurrentMediaTime() < deadline);
+
+  if (nil == [self nextTask]) {
+    [self stopObserving];
+  } else {
+    // Let the run loop handle events before the next slice rather than sleeping until
+    // something else wakes it.
+    CFRunLoopWakeUp(CFRunLoopGetMain());
+  }
+}
+
+- (void)removeTask:(NIIdleTaskToken *)task {
+  for (NSUInteger ix = 0; ix < kNIIdleTaskNumberOfPriorities; ++ix) {
+    [_tasksByPriority[ix] removeObjectIdenticalTo:task];
+  }
+}
+
+#pragma mark - Public
+
+- (NIIdleTaskToken *)scheduleTaskWithPriority:(NIIdleTaskPriority)priority block:(NIIdleTaskBlock)block {
+  NIDASSERT([NSThread isMainThread]);
+  NIDASSERT(nil != block);
+  NIDASSERT(priority >= NIIdleTaskPriorityHigh && priority <= NIIdleTaskPriorityLow);
+  NIIdleTaskToken* task = [[NIIdleTaskToken alloc] init];
+  if (nil == block) {
+    task.finished = YES;
+    return task;
+  }
+  task.block = block;
+  task.scheduler = self;
+  NSUInteger index = MIN((NSUInteger)MAX(priority, NIIdleTaskPriorityHigh), kNIIdleTaskNumberOfPriorities - 1);
+  [_tasksByPriority[index] addObject:task];
+  [self startObserving];
+  return task;
+}
+
+- (void)cancelAllTasks {
+  for (NSUInteger ix = 0; ix < kNIIdleTaskNumberOfPriorities; ++ix) {
+    NSArray* tasks = [_tasksByPriority[ix] copy];
+    for (NIIdleTaskToken* task in tasks) {
+      [task cancel];
+    }
+  }
+  [self stopObserving];
+}
+
+- (NSUInteger)numberOfTasks {
+  NSUInteger numberOfTasks = 0;
+  for (NSUInteger ix = 0; ix < kNIIdleTaskNumberOfPriorities; ++ix) {
+    numberOfTasks += _tasksByPriority[ix].count;
+  }
+  return numberOfTasks;
+}
+
+@end
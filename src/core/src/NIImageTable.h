@@ -0,0 +1,183 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+/**
+ * For storing many decoded images of the same size in one memory-mapped file.
+ *
+ * @ingroup NimbusCore
+ * @defgroup Image-Tables Image Tables
+ * @{
+ *
+ * Avatars and grid thumbnails tend to come in a handful of fixed sizes. Keeping each of them
+ * in its own file means a file open, a decode and an allocation for every image that is
+ * shown. An image table instead packs images of one size into fixed-stride slots of a single
+ * file that stays mapped into memory. Images read from the table are backed directly by the
+ * mapped pages, so showing one costs no more than a dictionary lookup.
+ *
+ * <h2>Example Use</h2>
+ *
+@code
+NIImageTable* avatars = [[NIImageTable alloc] initWithName:@"avatars"
+                                                 imageSize:CGSizeMake(40, 40)
+                                                     scale:[UIScreen mainScreen].scale
+                                                  capacity:500];
+[avatars storeImage:downloadedAvatar withName:userID];
+
+// Later, possibly after a relaunch...
+UIImage* avatar = [avatars imageWithName:userID];
+@endcode
+ */
+
+/**
+ * A thread-safe, fixed-capacity table of same-size images in a memory-mapped file.
+ *
+ * Each slot holds the pixels of one image in the display's native 32 bit BGRA format along
+ * with a small header identifying the image. The header is written last, so a slot that was
+ * being written when the app was killed is simply ignored the next time the table is opened.
+ *
+ * When the table is full, the least recently used image whose slot is not backing a live
+ * UIImage is replaced.
+ */
+@interface NIImageTable : NSObject
+
+// Designated initializer.
+- (id)initWithPath:(NSString *)path imageSize:(CGSize)imageSize scale:(CGFloat)scale capacity:(NSUInteger)capacity;
+- (id)initWithName:(NSString *)name imageSize:(CGSize)imageSize scale:(CGFloat)scale capacity:(NSUInteger)capacity;
+
+@property (nonatomic, readonly, copy) NSString* path;
+@property (nonatomic, readonly) CGSize imageSize;
+@property (nonatomic, readonly) CGFloat scale;
+@property (nonatomic, readonly) NSUInteger capacity;
+
+- (NSUInteger)count;
+
+- (BOOL)storeImage:(UIImage *)image withName:(NSString *)name;
+
+- (UIImage *)imageWithName:(NSString *)name;
+- (BOOL)containsImageWithName:(NSString *)name;
+
+- (void)removeImageWithName:(NSString *)name;
+- (void)removeAllImages;
+
+@end
+
+/**@}*/// End of Image Tables /////////////////////////////////////////////////////////////////////
+
+/** @name Creating an Image Table */
+
+/**
+ * Initializes a newly allocated image table backed by the file at the given path.
+ *
+ * The file is created if it does not exist. Images already stored in the file are available
+ * right away as long as the image size, scale and capacity have not changed. Otherwise the
+ * file is reset.
+ *
+ * @fn NIImageTable::initWithPath:imageSize:scale:capacity:
+ */
+
+/**
+ * Initializes a newly allocated image table backed by a file with the given name in the
+ * caches directory.
+ *
+ * @see NIPathForCachesResource
+ * @fn NIImageTable::initWithName:imageSize:scale:capacity:
+ */
+
+/**
+ * The path of the file backing the table.
+ *
+ * @fn NIImageTable::path
+ */
+
+/**
+ * The size in points of every image in the table.
+ *
+ * @fn NIImageTable::imageSize
+ */
+
+/**
+ * The scale of every image in the table.
+ *
+ * @fn NIImageTable::scale
+ */
+
+/**
+ * The number of slots in the table.
+ *
+ * The file backing the table is capacity times the slot size, rounded up to whole pages. Only
+ * the pages of slots that are read are brought into memory, and the system can discard them
+ * under memory pressure because they are backed by the file.
+ *
+ * @fn NIImageTable::capacity
+ */
+
+/** @name Querying an Image Table */
+
+/**
+ * Returns the number of images in the table.
+ *
+ * @fn NIImageTable::count
+ */
+
+/** @name Storing Images */
+
+/**
+ * Draws the image into a slot of the table.
+ *
+ * The image is scaled to fill imageSize, keeping its aspect ratio and cropping whatever
+ * doesn't fit. Images that already have the table's size and scale are copied as is.
+ *
+ * Returns NO if the image could not be drawn or if every slot is backing a live image.
+ *
+ * @fn NIImageTable::storeImage:withName:
+ */
+
+/** @name Accessing Images */
+
+/**
+ * Returns the image with the given name, or nil if there is none.
+ *
+ * The image reads its pixels straight from the mapped file. Its slot will not be replaced
+ * until the image has been deallocated.
+ *
+ * @fn NIImageTable::imageWithName:
+ */
+
+/**
+ * Returns whether an image with the given name is in the table.
+ *
+ * @fn NIImageTable::containsImageWithName:
+ */
+
+/** @name Removing Images */
+
+/**
+ * Removes the image with the given name from the table.
+ *
+ * Images that were already returned by imageWithName: remain valid.
+ *
+ * @fn NIImageTable::removeImageWithName:
+ */
+
+/**
+ * Removes every image from the table.
+ *
+ * @fn NIImageTable::removeAllImages
+ */
@@ -0,0 +1,497 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIImageTable.h"
+
+#import "NIDebuggingTools.h"
+#import "NIFoundationMethods.h"
+#import "NIPaths.h"
+
+#import <fcntl.h>
+#import <sys/mman.h>
+#import <unistd.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// 'NITB' in little-endian order.
+static const uint32_t kNIImageTableSlotMagic = 0x4254494e;
+static const uint32_t kNIImageTableSlotVersion = 2;
+
+// Core Animation prefers rows that are aligned to a cache line.
+static const size_t kNIImageTableRowAlignment = 64;
+
+static const CGBitmapInfo kNIImageTableBitmapInfo = (kCGBitmapByteOrder32Little
+                                                     | kCGImageAlphaPremultipliedFirst);
+
+// Every slot starts with this header. The pixels follow immediately after it.
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t nameHash; // 0 while the slot is empty or being written.
+  uint64_t sequenceNumber;
+  uint32_t width;
+  uint32_t height;
+  uint32_t bytesPerRow;
+  uint32_t bitmapInfo;
+  uint8_t reserved[24];
+} NIImageTableSlotHeader;
+
+@interface NIImageTable()
+- (void)unpinSlot:(NSUInteger)slot;
+@end
+
+// Keeps a slot from being replaced while an image is reading from it.
+@interface NIImageTableSlotReference : NSObject
+@property (nonatomic, strong) NIImageTable* table;
+@property (nonatomic, assign) NSUInteger slot;
+@end
+
+@implementation NIImageTableSlotReference
+
+- (void)dealloc {
+  [_table unpinSlot:_slot];
+}
+
+@end
+
+static void NIImageTableReleaseSlot(void* info, const void* data, size_t size) {
+  CFBridgingRelease(info);
+}
+
+@implementation NIImageTable {
+  int _fileDescriptor;
+  uint8_t* _bytes;
+  size_t _numberOfBytes;
+
+  size_t _pixelWidth;
+  size_t _pixelHeight;
+  size_t _bytesPerRow;
+  size_t _slotStride;
+
+  // Mapping from a name hash to its slot.
+  NSMutableDictionary* _hashesToSlots;
+  // The name hashes of the table ordered from least to most recently used.
+  NSMutableOrderedSet* _lruHashes;
+  // The number of live images reading from each slot.
+  NSUInteger* _pinCounts;
+  uint64_t _sequenceNumber;
+}
+
+- (void)dealloc {
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
+
+  if (NULL != _bytes) {
+    munmap(_bytes, _numberOfBytes);
+  }
+  if (_fileDescriptor >= 0) {
+    close(_fileDescriptor);
+  }
+  free(_pinCounts);
+}
+
+- (id)initWithName:(NSString *)name imageSize:(CGSize)imageSize scale:(CGFloat)scale capacity:(NSUInteger)capacity {
+  return [self initWithPath:NIPathForCachesResource(name)
+                  imageSize:imageSize
+                      scale:scale
+                   capacity:capacity];
+}
+
+- (id)initWithPath:(NSString *)path imageSize:(CGSize)imageSize scale:(CGFloat)scale capacity:(NSUInteger)capacity {
+  if ((self = [super init])) {
+    NIDASSERT(NIIsStringWithAnyText(path));
+    NIDASSERT(imageSize.width > 0 && imageSize.height > 0);
+    NIDASSERT(scale > 0);
+    NIDASSERT(capacity > 0);
+
+    _path = [path copy];
+    _imageSize = imageSize;
+    _scale = scale;
+    _capacity = capacity;
+    _fileDescriptor = -1;
+
+    _pixelWidth = (size_t)NICGFloatCeil(imageSize.width * scale);
+    _pixelHeight = (size_t)NICGFloatCeil(imageSize.height * scale);
+    _bytesPerRow = ((_pixelWidth * 4 + kNIImageTableRowAlignment - 1) / kNIImageTableRowAlignment
+                    * kNIImageTableRowAlignment);
+
+    // Each slot starts on a page boundary so that reading one image never faults in its
+    // neighbours.
+    size_t pageSize = (size_t)getpagesize();
+    size_t slotLength = sizeof(NIImageTableSlotHeader) + _bytesPerRow * _pixelHeight;
+    _slotStride = (slotLength + pageSize - 1) / pageSize * pageSize;
+
+    _hashesToSlots = [[NSMutableDictionary alloc] init];
+    _lruHashes = [[NSMutableOrderedSet alloc] init];
+    _pinCounts = calloc(capacity, sizeof(NSUInteger));
+
+    [self openFile];
+    [self loadSlots];
+
+    // Make sure the mapped pages have been written before the app can be killed.
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(synchronize)
+                                                 name:UIApplicationDidEnterBackgroundNotification
+                                               object:nil];
+  }
+  return self;
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:
+          @"<%@"
+          @" path: %@"
+          @" imageSize: %@"
+          @" scale: %f"
+          @" count: %zd"
+          @" capacity: %zd"
+          @">",
+          [super description],
+          self.path,
+          NSStringFromCGSize(self.imageSize),
+          self.scale,
+          self.count,
+          self.capacity];
+}
+
+#pragma mark - File
+
+- (void)openFile {
+  [[NSFileManager defaultManager] createDirectoryAtPath:[self.path stringByDeletingLastPathComponent]
+                            withIntermediateDirectories:YES
+                                             attributes:nil
+                                                  error:nil];
+
+  _fileDescriptor = open([self.path fileSystemRepresentation], O_RDWR | O_CREAT, 0644);
+  if (_fileDescriptor < 0) {
+    NIDERROR(@"Unable to open image table at %@: %s", self.path, strerror(errno));
+    return;
+  }
+
+  // Extending the file fills it with zeroes, which reads back as empty slots.
+  _numberOfBytes = _slotStride * self.capacity;
+  if (0 != ftruncate(_fileDescriptor, (off_t)_numberOfBytes)) {
+    NIDERROR(@"Unable to size image table at %@: %s", self.path, strerror(errno));
+    return;
+  }
+
+  void* bytes = mmap(NULL, _numberOfBytes, PROT_READ | PROT_WRITE, MAP_SHARED, _fileDescriptor, 0);
+  if (MAP_FAILED == bytes) {
+    NIDERROR(@"Unable to map image table at %@: %s", self.path, strerror(errno));
+    return;
+  }
+  _bytes = bytes;
+}
+
+- (NIImageTableSlotHeader *)headerForSlot:(NSUInteger)slot {
+  return (NIImageTableSlotHeader *)(_bytes + slot * _slotStride);
+}
+
+- (uint8_t *)pixelsForSlot:(NSUInteger)slot {
+  return _bytes + slot * _slotStride + sizeof(NIImageTableSlotHeader);
+}
+
+- (BOOL)isValidHeader:(const NIImageTableSlotHeader *)header {
+  return (header->magic == kNIImageTableSlotMagic
+          && header->version == kNIImageTableSlotVersion
+          && header->nameHash != 0
+          && header->width == _pixelWidth
+          && header->height == _pixelHeight
+          && header->bytesPerRow == _bytesPerRow
+          && header->bitmapInfo == kNIImageTableBitmapInfo);
+}
+
+- (void)loadSlots {
+  if (NULL == _bytes) {
+    return;
+  }
+
+  NSMutableArray* slots = [NSMutableArray array];
+  for (NSUInteger slot = 0; slot < self.capacity; ++slot) {
+    NIImageTableSlotHeader* header = [self headerForSlot:slot];
+    if ([self isValidHeader:header]) {
+      [slots addObject:@(slot)];
+      _sequenceNumber = MAX(_sequenceNumber, header->sequenceNumber);
+    }
+  }
+
+  // Sequence numbers increase with every store, so they rebuild the least-recently-used order.
+  [slots sortUsingComparator:^NSComparisonResult(NSNumber* slot1, NSNumber* slot2) {
+    uint64_t sequenceNumber1 = [self headerForSlot:[slot1 unsignedIntegerValue]]->sequenceNumber;
+    uint64_t sequenceNumber2 = [self headerForSlot:[slot2 unsignedIntegerValue]]->sequenceNumber;
+    return (sequenceNumber1 < sequenceNumber2
+            ? NSOrderedAscending
+            : (sequenceNumber1 > sequenceNumber2 ? NSOrderedDescending : NSOrderedSame));
+  }];
+
+  for (NSNumber* slot in slots) {
+    NSNumber* hash = @([self headerForSlot:[slot unsignedIntegerValue]]->nameHash);
+    NSNumber* olderSlot = _hashesToSlots[hash];
+    if (nil != olderSlot) {
+      // An image was stored again while its old slot was in use.
+      [self headerForSlot:[olderSlot unsignedIntegerValue]]->nameHash = 0;
+      [_lruHashes removeObject:hash];
+    }
+    _hashesToSlots[hash] = slot;
+    [_lruHashes addObject:hash];
+  }
+}
+
+- (void)synchronize {
+  if (NULL != _bytes) {
+    msync(_bytes, _numberOfBytes, MS_ASYNC);
+  }
+}
+
+#pragma mark - Slots
+
+static uint64_t NIImageTableHashFromName(NSString* name) {
+  uint64_t hash = NIHash64FromString(name);
+  // 0 marks an empty slot.
+  return (0 == hash) ? 1 : hash;
+}
+
+// Must be called while synchronized on self.
+- (NSUInteger)slotForStoring {
+  if (_hashesToSlots.count < self.capacity) {
+    NSMutableIndexSet* usedSlots = [NSMutableIndexSet indexSet];
+    for (NSNumber* slot in [_hashesToSlots allValues]) {
+      [usedSlots addIndex:[slot unsignedIntegerValue]];
+    }
+    for (NSUInteger slot = 0; slot < self.capacity; ++slot) {
+      if (![usedSlots containsIndex:slot] && 0 == _pinCounts[slot]) {
+        return slot;
+      }
+    }
+  }
+
+  // Replace the least recently used image that nothing is reading from.
+  for (NSNumber* hash in _lruHashes) {
+    NSUInteger slot = [_hashesToSlots[hash] unsignedIntegerValue];
+    if (0 == _pinCounts[slot]) {
+      [self removeHash:hash];
+      return slot;
+    }
+  }
+  return NSNotFound;
+}
+
+// Must be called while synchronized on self.
+- (void)removeHash:(NSNumber *)hash {
+  NSNumber* slot = _hashesToSlots[hash];
+  if (nil == slot) {
+    return;
+  }
+  [self headerForSlot:[slot unsignedIntegerValue]]->nameHash = 0;
+  [_hashesToSlots removeObjectForKey:hash];
+  [_lruHashes removeObject:hash];
+}
+
+- (void)unpinSlot:(NSUInteger)slot {
+  @synchronized(self) {
+    NIDASSERT(_pinCounts[slot] > 0);
+    _pinCounts[slot]--;
+  }
+}
+
+#pragma mark - Drawing
+
+- (BOOL)drawImage:(UIImage *)image intoSlot:(NSUInteger)slot {
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGContextRef context = CGBitmapContextCreate([self pixelsForSlot:slot],
+                                               _pixelWidth,
+                                               _pixelHeight,
+                                               8,
+                                               _bytesPerRow,
+                                               colorSpace,
+                                               kNIImageTableBitmapInfo);
+  CGColorSpaceRelease(colorSpace);
+  if (NULL == context) {
+    return NO;
+  }
+
+  CGContextClearRect(context, CGRectMake(0, 0, _pixelWidth, _pixelHeight));
+
+  // Draw in points with UIKit's flipped coordinates so that the image's orientation is honored.
+  CGContextTranslateCTM(context, 0, _pixelHeight);
+  CGContextScaleCTM(context, self.scale, -self.scale);
+
+  CGSize imageSize = image.size;
+  CGFloat fillScale = MAX(self.imageSize.width / imageSize.width,
+                          self.imageSize.height / imageSize.height);
+  CGSize drawSize = CGSizeMake(imageSize.width * fillScale, imageSize.height * fillScale);
+  CGRect drawRect = CGRectMake((self.imageSize.width - drawSize.width) / 2,
+                               (self.imageSize.height - drawSize.height) / 2,
+                               drawSize.width,
+                               drawSize.height);
+
+  UIGraphicsPushContext(context);
+  [image drawInRect:drawRect];
+  UIGraphicsPopContext();
+
+  CGContextRelease(context);
+  return YES;
+}
+
+#pragma mark - Public
+
+- (NSUInteger)count {
+  @synchronized(self) {
+    return _hashesToSlots.count;
+  }
+}
+
+- (BOOL)storeImage:(UIImage *)image withName:(NSString *)name {
+  NIDASSERT(NIIsStringWithAnyText(name));
+  if (NULL == _bytes || nil == image || !NIIsStringWithAnyText(name)
+      || image.size.width <= 0 || image.size.height <= 0) {
+    return NO;
+  }
+
+  NSNumber* hash = @(NIImageTableHashFromName(name));
+  NSUInteger slot = NSNotFound;
+  @synchronized(self) {
+    NSNumber* existingSlot = _hashesToSlots[hash];
+    if (nil != existingSlot && 0 == _pinCounts[[existingSlot unsignedIntegerValue]]) {
+      slot = [existingSlot unsignedIntegerValue];
+      [self removeHash:hash];
+
+    } else {
+      // The old image, if any, stays in its slot until nothing is reading from it.
+      [self removeHash:hash];
+      slot = [self slotForStoring];
+    }
+
+    if (NSNotFound == slot) {
+      return NO;
+    }
+
+    // Pin the slot so that nothing else writes to it while it is being drawn.
+    _pinCounts[slot]++;
+  }
+
+  BOOL didDraw = [self drawImage:image intoSlot:slot];
+
+  @synchronized(self) {
+    _pinCounts[slot]--;
+    if (!didDraw) {
+      return NO;
+    }
+
+    // Another store of the same name may have finished first.
+    [self removeHash:hash];
+
+    NIImageTableSlotHeader* header = [self headerForSlot:slot];
+    header->magic = kNIImageTableSlotMagic;
+    header->version = kNIImageTableSlotVersion;
+    header->sequenceNumber = ++_sequenceNumber;
+    header->width = (uint32_t)_pixelWidth;
+    header->height = (uint32_t)_pixelHeight;
+    header->bytesPerRow = (uint32_t)_bytesPerRow;
+    header->bitmapInfo = kNIImageTableBitmapInfo;
+    // Written last so that a partially written slot is never mistaken for an image.
+    header->nameHash = [hash unsignedLongLongValue];
+
+    _hashesToSlots[hash] = @(slot);
+    [_lruHashes addObject:hash];
+  }
+  return YES;
+}
+
+- (UIImage *)imageWithName:(NSString *)name {
+  if (NULL == _bytes || !NIIsStringWithAnyText(name)) {
+    return nil;
+  }
+
+  NSNumber* hash = @(NIImageTableHashFromName(name));
+  NIImageTableSlotReference* reference = nil;
+  @synchronized(self) {
+    NSNumber* slot = _hashesToSlots[hash];
+    if (nil == slot) {
+      return nil;
+    }
+    [_lruHashes removeObject:hash];
+    [_lruHashes addObject:hash];
+
+    _pinCounts[[slot unsignedIntegerValue]]++;
+    reference = [[NIImageTableSlotReference alloc] init];
+    reference.table = self;
+    reference.slot = [slot unsignedIntegerValue];
+  }
+
+  CGDataProviderRef provider = CGDataProviderCreateWithData((__bridge_retained void *)reference,
+                                                            [self pixelsForSlot:reference.slot],
+                                                            _bytesPerRow * _pixelHeight,
+                                                            NIImageTableReleaseSlot);
+  if (NULL == provider) {
+    CFBridgingRelease((__bridge void *)reference);
+    return nil;
+  }
+
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGImageRef imageRef = CGImageCreate(_pixelWidth,
+                                      _pixelHeight,
+                                      8,
+                                      32,
+                                      _bytesPerRow,
+                                      colorSpace,
+                                      kNIImageTableBitmapInfo,
+                                      provider,
+                                      NULL,
+                                      false,
+                                      kCGRenderingIntentDefault);
+  CGColorSpaceRelease(colorSpace);
+  CGDataProviderRelease(provider);
+  if (NULL == imageRef) {
+    return nil;
+  }
+
+  UIImage* image = [UIImage imageWithCGImage:imageRef scale:self.scale orientation:UIImageOrientationUp];
+  CGImageRelease(imageRef);
+  return image;
+}
+
+- (BOOL)containsImageWithName:(NSString *)name {
+  if (!NIIsStringWithAnyText(name)) {
+    return NO;
+  }
+  NSNumber* hash = @(NIImageTableHashFromName(name));
+  @synchronized(self) {
+    return (nil != _hashesToSlots[hash]);
+  }
+}
+
+- (void)removeImageWithName:(NSString *)name {
+  if (!NIIsStringWithAnyText(name)) {
+    return;
+  }
+  NSNumber* hash = @(NIImageTableHashFromName(name));
+  @synchronized(self) {
+    [self removeHash:hash];
+  }
+}
+
+- (void)removeAllImages {
+  @synchronized(self) {
+    for (NSNumber* hash in [_hashesToSlots allKeys]) {
+      [self removeHash:hash];
+    }
+  }
+}
+
+@end
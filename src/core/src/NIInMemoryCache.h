@@ -16,7 +16,12 @@
 
 #import <Foundation/Foundation.h>
 
+#import "NIMemoryCacheAdmissionPolicy.h"
+#import "NIMemoryPressure.h"
 #import "NIPreprocessorMacros.h"
+#import "NIState.h"
+
+@class NIMemoryCacheStatistics;
 
 /**
  * For storing and accessing objects in memory.
@@ -29,40 +34,97 @@
  * @{
  */
 
+/**
+ * An object that can stand in for a name when storing and accessing objects in a cache.
+ *
+ * Building a name by formatting a string on every lookup can be expensive. A key holds the
+ * parts of the name as plain fields, so it can be hashed and compared without building the
+ * string. The cache builds the name once per distinct key and remembers it. Objects stored with
+ * a key can be accessed by the key's name and vice versa.
+ *
+ * Keys must be immutable, and two keys that are equal must have equal names.
+ */
+@protocol NIMemoryCacheKey <NSObject, NSCopying>
+@required
+
+/**
+ * The name that the key stands in for.
+ */
+- (NSString *)memoryCacheName;
+
+@end
+
 /**
  * An in-memory cache for storing objects with expiration support.
  *
  * The Nimbus in-memory object cache allows you to store objects in memory with an expiration
  * date attached. Objects with expiration dates drop out of the cache when they have expired.
  */
-@interface NIMemoryCache : NSObject
+@interface NIMemoryCache : NSObject <NIMemoryBudgetConsumer>
 
 // Designated initializer.
+- (id)initWithCapacity:(NSUInteger)capacity numberOfSegments:(NSUInteger)numberOfSegments;
 - (id)initWithCapacity:(NSUInteger)capacity;
 
+@property (nonatomic, readonly) NSUInteger numberOfSegments; // Default: 1
+
 - (NSUInteger)count;
 
 - (void)storeObject:(id)object withName:(NSString *)name;
 - (void)storeObject:(id)object withName:(NSString *)name expiresAfter:(NSDate *)expirationDate;
+- (void)storeObject:(id)object withName:(NSString *)name cost:(unsigned long long)cost;
+- (void)storeObject:(id)object withName:(NSString *)name expiresAfter:(NSDate *)expirationDate cost:(unsigned long long)cost;
+- (void)storeObjects:(NSArray *)objects withNames:(NSArray *)names expiresAfter:(NSDate *)expirationDate;
+- (void)storeObject:(id)object withKey:(id<NIMemoryCacheKey>)key expiresAfter:(NSDate *)expirationDate;
+- (void)storeObject:(id)object withKey:(id<NIMemoryCacheKey>)key expiresAfter:(NSDate *)expirationDate cost:(unsigned long long)cost;
 
 - (void)removeObjectWithName:(NSString *)name;
+- (void)removeObjectWithKey:(id<NIMemoryCacheKey>)key;
 - (void)removeAllObjectsWithPrefix:(NSString *)prefix;
 - (void)removeAllObjects;
 
+@property (nonatomic) BOOL indexesNamesByPrefix; // Default: NO
+- (NSArray *)namesOfObjectsWithPrefix:(NSString *)prefix;
+
 - (id)objectWithName:(NSString *)name;
+- (NSDictionary *)objectsWithNames:(NSArray *)names;
 - (BOOL)containsObjectWithName:(NSString *)name;
+- (id)objectWithKey:(id<NIMemoryCacheKey>)key;
+- (BOOL)containsObjectWithKey:(id<NIMemoryCacheKey>)key;
+- (NSString *)nameForKey:(id<NIMemoryCacheKey>)key;
 - (NSDate *)dateOfLastAccessWithName:(NSString *)name;
 
 - (NSString *)nameOfLeastRecentlyUsedObject;
 - (NSString *)nameOfMostRecentlyUsedObject;
+- (NSArray *)namesOfMostRecentlyUsedObjectsWithLimit:(NSUInteger)limit;
 
 - (void)reduceMemoryUsage;
+- (void)reduceMemoryUsageForPressureLevel:(NIMemoryPressureLevel)level;
+- (void)removeExpiredObjects;
+
+@property (nonatomic) NSTimeInterval expirationSweepInterval; // Default: 0 (no sweeping)
+
+@property (nonatomic, strong) id<NIMemoryCacheAdmissionPolicy> admissionPolicy; // Default: nil (LRU)
+
+@property (nonatomic) BOOL keepsWeakReferencesToEvictedObjects; // Default: NO
+@property (nonatomic) unsigned long long maxNumberOfEncodedBytes; // Default: 0 (no encoded tier)
+@property (nonatomic, copy) NSData* (^dataFromObject)(id object);
+@property (nonatomic, copy) id (^objectFromData)(NSData* data);
+
+@property (nonatomic) BOOL releasesRemovedObjectsInBackground; // Default: NO
+
+- (NIMemoryCacheStatistics *)statistics;
+- (void)resetStatistics;
+
+- (unsigned long long)numberOfBytesInMemoryBudget;
+- (void)reduceMemoryUsageByNumberOfBytes:(unsigned long long)numberOfBytes;
 
 // Subclassing
 
 - (BOOL)shouldSetObject:(id)object withName:(NSString *)name previousObject:(id)previousObject;
 - (void)didSetObject:(id)object withName:(NSString *)name;
 - (void)willRemoveObject:(id)object withName:(NSString *)name;
+- (void)didRemoveObject:(id)object withName:(NSString *)name;
 
 // Deprecated method. Use shouldSetObject:withName:previousObject: instead.
 - (BOOL)willSetObject:(id)object withName:(NSString *)name previousObject:(id)previousObject __NI_DEPRECATED_METHOD;
@@ -70,17 +132,27 @@
 @end
 
 /**
- * An in-memory cache for storing images with caps on the total number of pixels.
+ * An in-memory cache for storing images with caps on the total number of pixels and bytes.
  *
  * When reduceMemoryUsage is called, the least recently used images are removed from the cache
- * until the numberOfPixels is below maxNumberOfPixelsUnderStress.
+ * until the numberOfPixels is below maxNumberOfPixelsUnderStress and the numberOfBytes is below
+ * maxNumberOfBytesUnderStress. Milder memory pressure, and the app entering the background, only
+ * remove the least recently used half of the images.
  *
- * When an image is added to the cache that causes the memory usage to pass the max, the
+ * When an image is added to the cache that causes the memory usage to pass either max, the
  * least recently used images are removed from the cache until the numberOfPixels is below
- * maxNumberOfPixels.
+ * maxNumberOfPixels and the numberOfBytes is below maxNumberOfBytes.
+ *
+ * The number of bytes is measured from the decoded bitmap of each image, so grayscale and
+ * wide-color images are charged what they actually use. Images that share a CGImage are only
+ * charged once. If you know better than the cache what an image costs, store it with
+ * storeObject:withName:cost: and that cost will be charged instead.
+ *
+ * By default the image memory cache has no limit to its pixel or byte count. You must
+ * explicitly set these values in your application.
  *
- * By default the image memory cache has no limit to its pixel count. You must explicitly
- * set this value in your application.
+ * When the cache is created with more than one segment, the pixel limits apply to the sum of
+ * all segments and the least recently used images across all segments are removed first.
  *
  * @attention If the cache is too small to fit the newly added image, then all images
  *                 will end up being removed including the one being added.
@@ -95,19 +167,82 @@
 @property (nonatomic)           unsigned long long maxNumberOfPixels;             // Default: 0 (unlimited)
 @property (nonatomic)           unsigned long long maxNumberOfPixelsUnderStress;  // Default: 0 (unlimited)
 
+@property (nonatomic, readonly) unsigned long long numberOfBytes;
+
+@property (nonatomic)           unsigned long long maxNumberOfBytes;              // Default: 0 (unlimited)
+@property (nonatomic)           unsigned long long maxNumberOfBytesUnderStress;   // Default: 0 (unlimited)
+
+@property (nonatomic)           BOOL storesImagesInPurgeableMemory;               // Default: NO
+
+// Variants
+- (void)addVariantWithName:(NSString *)name size:(CGSize)size toGroup:(NSString *)group;
+- (NSString *)nameOfSmallestVariantInGroup:(NSString *)group coveringSize:(CGSize)size;
+
+@end
+
+/**
+ * A snapshot of the activity of an NIMemoryCache.
+ *
+ * Every cache counts its activity from the moment it is created or its statistics are reset.
+ * The counters are cheap enough to leave on in production builds.
+ */
+@interface NIMemoryCacheStatistics : NSObject
+
+@property (nonatomic, readonly) unsigned long long numberOfHits;
+@property (nonatomic, readonly) unsigned long long numberOfMisses;
+@property (nonatomic, readonly) double hitRate;
+
+@property (nonatomic, readonly) unsigned long long numberOfStores;
+
+@property (nonatomic, readonly) unsigned long long numberOfEvictions;
+@property (nonatomic, readonly) unsigned long long numberOfExpirations;
+@property (nonatomic, readonly) unsigned long long numberOfStressEvictions;
+@property (nonatomic, readonly) unsigned long long numberOfBytesEvicted;
+
+@property (nonatomic, readonly) unsigned long long numberOfLockHolds;
+@property (nonatomic, readonly) NSTimeInterval averageLockHoldTime;
+@property (nonatomic, readonly) unsigned long long numberOfContendedLocks;
+
 @end
 
 /**@}*/// End of In-Memory Cache //////////////////////////////////////////////////////////////////
 
 /** @name Creating an In-Memory Cache */
 
+/**
+ * Initializes a newly allocated cache with the given capacity and number of segments.
+ *
+ * A cache with a single segment guards all of its entries with one lock. A cache with more than
+ * one segment distributes its entries across the segments by the hash of their names. Each
+ * segment has its own lock and lru list, so threads working with different names rarely
+ * contend with one another. The subclassing methods are called on the segment that owns the
+ * object, which is an instance of the same class as the cache.
+ *
+ * Segmenting the cache is only worth it when many threads access the cache at once. Methods
+ * that look at the cache as a whole, such as count and nameOfLeastRecentlyUsedObject, visit
+ * every segment.
+ *
+ * @param capacity         The initial capacity of the cache, shared across the segments.
+ * @param numberOfSegments The number of independently locked segments. 0 is treated as 1.
+ * @returns An in-memory cache initialized with the given capacity.
+ * @fn NIMemoryCache::initWithCapacity:numberOfSegments:
+ */
+
 /**
  * Initializes a newly allocated cache with the given capacity.
  *
+ * The cache has a single segment.
+ *
  * @returns An in-memory cache initialized with the given capacity.
  * @fn NIMemoryCache::initWithCapacity:
  */
 
+/**
+ * The number of independently locked segments in this cache.
+ *
+ * @fn NIMemoryCache::numberOfSegments
+ */
+
 /** @name Storing Objects in the Cache */
 
 /**
@@ -134,6 +269,61 @@
  * @fn NIMemoryCache::storeObject:withName:expiresAfter:
  */
 
+/**
+ * Stores an object in the cache with an explicit cost.
+ *
+ * The cost is recorded alongside the object. NIMemoryCache does not use it, but subclasses
+ * that limit their size may. NIImageMemoryCache charges it against its byte limits in place of
+ * the decoded size of the image. A cost of 0 lets the cache decide.
+ *
+ * @param object  The object being stored in the cache.
+ * @param name    The name used as a key to store this object.
+ * @param cost    The cost of keeping this object in the cache.
+ * @fn NIMemoryCache::storeObject:withName:cost:
+ */
+
+/**
+ * Stores an object in the cache with an expiration date and an explicit cost.
+ *
+ * @param object          The object being stored in the cache.
+ * @param name            The name used as a key to store this object.
+ * @param expirationDate  A date after which this object is no longer valid in the cache.
+ * @param cost            The cost of keeping this object in the cache.
+ * @fn NIMemoryCache::storeObject:withName:expiresAfter:cost:
+ */
+
+/**
+ * Stores several objects in the cache at once.
+ *
+ * Equivalent to storing each object with storeObject:withName:expiresAfter:, except that the
+ * cache is locked once for all of the objects. The objects are stored in order, so the last
+ * object becomes the most recently used.
+ *
+ * @param objects         The objects being stored in the cache.
+ * @param names           The names used as keys, one for each object.
+ * @param expirationDate  A date after which these objects are no longer valid in the cache.
+ *                        May be nil.
+ * @fn NIMemoryCache::storeObjects:withNames:expiresAfter:
+ */
+
+/**
+ * Stores an object in the cache under the name of the given key.
+ *
+ * Equivalent to storeObject:withName:expiresAfter: with the key's name.
+ *
+ * @see NIMemoryCacheKey
+ * @fn NIMemoryCache::storeObject:withKey:expiresAfter:
+ */
+
+/**
+ * Stores an object in the cache under the name of the given key with an explicit cost.
+ *
+ * Equivalent to storeObject:withName:expiresAfter:cost: with the key's name.
+ *
+ * @see NIMemoryCacheKey
+ * @fn NIMemoryCache::storeObject:withKey:expiresAfter:cost:
+ */
+
 /** @name Removing Objects from the Cache */
 
 /**
@@ -143,10 +333,16 @@
  * @fn NIMemoryCache::removeObjectWithName:
  */
 
+/**
+ * Removes the object stored under the name of the given key.
+ *
+ * @fn NIMemoryCache::removeObjectWithKey:
+ */
+
 /**
  * Removes all objects from the cache with a given prefix.
  *
- * This method requires a scan of the cache entries.
+ * This method requires a scan of the cache entries unless indexesNamesByPrefix is enabled.
  *
  * @param prefix Any object name that has this prefix will be removed from the cache.
  * @fn NIMemoryCache::removeAllObjectsWithPrefix:
@@ -160,6 +356,29 @@
  * @fn NIMemoryCache::removeAllObjects
  */
 
+/**
+ * Whether the cache keeps an index of its names for prefix lookups.
+ *
+ * When enabled, the cache keeps its names in a radix trie. removeAllObjectsWithPrefix: and
+ * namesOfObjectsWithPrefix: then only visit the names that match the prefix rather than every
+ * name in the cache. Keeping the index costs a little extra work on every store and removal,
+ * so only enable it if you namespace your names and invalidate them by prefix.
+ *
+ * Defaults to NO.
+ *
+ * @fn NIMemoryCache::indexesNamesByPrefix
+ */
+
+/**
+ * Returns the names of all objects in the cache with a given prefix.
+ *
+ * Does not update the access time of the objects.
+ *
+ * @param prefix The prefix of the names to return.
+ * @returns The names of the objects that have the prefix, in no particular order.
+ * @fn NIMemoryCache::namesOfObjectsWithPrefix:
+ */
+
 /** @name Accessing Objects in the Cache */
 
 /**
@@ -173,6 +392,40 @@
  * @fn NIMemoryCache::objectWithName:
  */
 
+/**
+ * Retrieves the object stored under the name of the given key.
+ *
+ * Equivalent to objectWithName: with the key's name, except that the name is only built the
+ * first time the cache sees an equal key.
+ *
+ * @fn NIMemoryCache::objectWithKey:
+ */
+
+/**
+ * Returns whether an unexpired object is stored under the name of the given key.
+ *
+ * @fn NIMemoryCache::containsObjectWithKey:
+ */
+
+/**
+ * Returns the name of the given key, building it only if the cache hasn't seen an equal key
+ * recently.
+ *
+ * @fn NIMemoryCache::nameForKey:
+ */
+
+/**
+ * Retrieves several objects from the cache at once.
+ *
+ * Equivalent to calling objectWithName: for each name, except that the cache is locked once
+ * for all of the names and the clock is only read once. The objects that are found become the
+ * most recently used, in the order of the names.
+ *
+ * @returns A dictionary mapping each name that was found to its object. Names that aren't in
+ *               the cache, or that have expired, are left out.
+ * @fn NIMemoryCache::objectsWithNames:
+ */
+
 /**
  * Returns a Boolean value that indicates whether an object with the given name is present
  * in the cache.
@@ -182,6 +435,8 @@
  * If the object has expired then the object will be removed from the cache and NO will be
  * returned.
  *
+ * Objects that have been evicted to the weak or encoded tiers are not counted.
+ *
  * @returns YES if an object with the given name is present in the cache and has not expired,
  *               otherwise NO.
  * @fn NIMemoryCache::containsObjectWithName:
@@ -220,6 +475,15 @@
  * @fn NIMemoryCache::nameOfMostRecentlyUsedObject
  */
 
+/**
+ * Retrieve the names of the most recently used objects, most recent first.
+ *
+ * This will not update the access times of the objects. Expired objects are skipped.
+ *
+ * @param limit The most names to return.
+ * @fn NIMemoryCache::namesOfMostRecentlyUsedObjectsWithLimit:
+ */
+
 /** @name Reducing Memory Usage Explicitly */
 
 /**
@@ -228,12 +492,116 @@
  * Subclasses may add additional functionality to this implementation.
  * Subclasses should call super in order to prune expired objects.
  *
- * This will be called when <code>UIApplicationDidReceiveMemoryWarningNotification</code>
- * is posted.
+ * This will be called when the memory pressure becomes critical, which includes every
+ * <code>UIApplicationDidReceiveMemoryWarningNotification</code>.
  *
  * @fn NIMemoryCache::reduceMemoryUsage
  */
 
+/**
+ * Reduces the memory usage of the cache in proportion to the given memory pressure.
+ *
+ * NIMemoryCache removes its expired objects at every level and calls reduceMemoryUsage when the
+ * pressure is critical. NIImageMemoryCache also removes the least recently used half of its
+ * images at the warning and background levels.
+ *
+ * Every cache calls this when the NIMemoryPressureCoordinator reports a change. Subclasses
+ * should call super.
+ *
+ * @fn NIMemoryCache::reduceMemoryUsageForPressureLevel:
+ */
+
+/**
+ * Removes all expired objects from the cache without doing anything else to reduce memory usage.
+ *
+ * Objects with an expiration date are kept in order of expiration, so this only visits the
+ * objects that have actually expired.
+ *
+ * @fn NIMemoryCache::removeExpiredObjects
+ */
+
+/**
+ * How often expired objects are removed from the cache in the background.
+ *
+ * Sweeping the cache periodically frees the memory of expired objects before the system
+ * starts asking for it. Defaults to 0, which disables sweeping.
+ *
+ * @fn NIMemoryCache::expirationSweepInterval
+ */
+
+/** @name Choosing What to Evict */
+
+/**
+ * The policy that decides which objects are evicted when the cache is over its limits.
+ *
+ * Defaults to nil, which evicts the least recently used object. Set an NITinyLFUAdmissionPolicy
+ * to keep frequently used objects in the cache when it is scanned by objects that are only used
+ * once. Segments of a segmented cache share the policy.
+ *
+ * @fn NIMemoryCache::admissionPolicy
+ */
+
+/** @name Keeping Evicted Objects */
+
+/**
+ * Whether evicted objects can still be found while something else retains them.
+ *
+ * Objects evicted because the cache was over its limits or under memory pressure are kept in a
+ * table of weak references. Looking up such an object returns it for as long as it is alive,
+ * for example while an image view is still showing it, without storing it in the cache again
+ * or counting it against the cache's limits.
+ *
+ * Defaults to NO.
+ *
+ * @fn NIMemoryCache::keepsWeakReferencesToEvictedObjects
+ */
+
+/**
+ * The most bytes of encoded objects kept for evicted objects.
+ *
+ * When non-zero, evicted objects are encoded with dataFromObject and kept, least recently used
+ * first, up to this many bytes. Looking up an encoded object decodes it with objectFromData and
+ * stores it in the cache again. Encoded objects are usually much smaller than the objects
+ * themselves, so many more of them can be kept after the cache has been trimmed.
+ *
+ * Objects are encoded on the thread that evicts them once the cache has been unlocked, so other
+ * threads can keep reading the cache while an image is compressed.
+ *
+ * Defaults to 0, which disables the encoded tier.
+ *
+ * @fn NIMemoryCache::maxNumberOfEncodedBytes
+ */
+
+/**
+ * Whether the cache lets go of removed objects on a background queue.
+ *
+ * When enabled, the cache's last references to removed, replaced and cleared objects are handed
+ * to a low priority queue, so freeing large objects such as decoded images does not block the
+ * thread that caused the removal. Objects that are still retained elsewhere are unaffected.
+ *
+ * Defaults to NO.
+ *
+ * @fn NIMemoryCache::releasesRemovedObjectsInBackground
+ */
+
+/**
+ * Turns an evicted object into the data kept in the encoded tier.
+ *
+ * Returning nil skips the encoded tier for the object. NIImageMemoryCache encodes images as PNG
+ * data prefixed with their scale and orientation by default.
+ *
+ * @fn NIMemoryCache::dataFromObject
+ */
+
+/**
+ * Turns data from the encoded tier back into an object.
+ *
+ * NIImageMemoryCache decodes images with the scale and orientation they were encoded with by
+ * default.
+ *
+ * @fn NIMemoryCache::objectFromData
+ */
+
 /** @name Querying an In-Memory Cache */
 
 /**
@@ -243,6 +611,46 @@
  * @fn NIMemoryCache::count
  */
 
+/** @name Sharing the Memory Budget */
+
+/**
+ * The number of bytes the cache holds for the purposes of the global memory budget.
+ *
+ * NIMemoryCache counts the costs that its objects were stored with. NIImageMemoryCache counts
+ * its numberOfBytes.
+ *
+ * @see Nimbus::addMemoryBudgetConsumer:priority:
+ * @fn NIMemoryCache::numberOfBytesInMemoryBudget
+ */
+
+/**
+ * Evicts objects until the cache holds at least the given number of bytes fewer, or is empty.
+ *
+ * Objects are evicted least recently used first unless an admissionPolicy picks otherwise.
+ *
+ * Objects removed this way are counted as evictions.
+ *
+ * @fn NIMemoryCache::reduceMemoryUsageByNumberOfBytes:
+ */
+
+/** @name Measuring an In-Memory Cache */
+
+/**
+ * Returns a snapshot of the cache's activity since it was created or last reset.
+ *
+ * The counters are read without taking the cache lock, so a snapshot taken while other threads
+ * use the cache may be a few operations out of step with itself. A segmented cache returns the
+ * sum of its segments.
+ *
+ * @fn NIMemoryCache::statistics
+ */
+
+/**
+ * Sets all of the cache's counters back to zero.
+ *
+ * @fn NIMemoryCache::resetStatistics
+ */
+
 /**
  * @name Subclassing
  *
@@ -278,11 +686,26 @@
 /**
  * An object is about to be removed from the cache.
  *
+ * This is called while the cache is locked, so keep it to bookkeeping that must stay in step
+ * with the cache's contents. Do anything more expensive in didRemoveObject:withName:.
+ *
  * @param object  The object about to removed from the cache.
  * @param name    The cache name for the object about to be removed.
  * @fn NIMemoryCache::willRemoveObject:withName:
  */
 
+/**
+ * An object has been removed from the cache.
+ *
+ * Removals are collected while the cache is locked and reported once the lock has been
+ * released, so this may call back into the cache. Objects removed by removeAllObjects are not
+ * reported.
+ *
+ * @param object  The object that was removed from the cache.
+ * @param name    The cache name for the object that was removed.
+ * @fn NIMemoryCache::didRemoveObject:withName:
+ */
+
 // NIImageMemoryCache
 
 /** @name Querying an In-Memory Image Cache */
@@ -314,3 +737,170 @@
  *               to reduceMemoryUsage.
  * @fn NIImageMemoryCache::maxNumberOfPixelsUnderStress
  */
+
+/** @name Setting the Maximum Number of Bytes */
+
+/**
+ * Returns the total number of bytes used by the decoded images in the cache.
+ *
+ * Images that share a CGImage are counted once. Images stored with an explicit cost are
+ * counted by that cost.
+ *
+ * @returns The total number of bytes used by the images in the cache.
+ * @fn NIImageMemoryCache::numberOfBytes
+ */
+
+/**
+ * The maximum number of bytes this cache may ever store.
+ *
+ * Defaults to 0, which is special cased to represent an unlimited number of bytes.
+ *
+ * @fn NIImageMemoryCache::maxNumberOfBytes
+ */
+
+/**
+ * The maximum number of bytes this cache may store after a call to reduceMemoryUsage.
+ *
+ * Defaults to 0, which is special cased to represent an unlimited number of bytes.
+ *
+ * @fn NIImageMemoryCache::maxNumberOfBytesUnderStress
+ */
+
+/** @name Keeping Images in Purgeable Memory */
+
+/**
+ * Whether stored images are copied into purgeable memory.
+ *
+ * An ordinary cache only gives memory back by evicting images, and only once it has been told
+ * about memory pressure, by which point the system may already be terminating other apps. When
+ * this is enabled, each decoded image is copied into purgeable memory as it is stored. The copy
+ * is marked volatile whenever none of the images handed out for it are alive, which usually
+ * means that no view is showing it. The kernel can then reclaim volatile bitmaps cheaply and
+ * without notice.
+ *
+ * A lookup that finds its bitmap purged removes the entry and returns nil, so the caller loads
+ * the image from the next tier as for any other miss. NITieredCache and NINetworkImageView
+ * both fall back to their disk caches. Each lookup returns a new UIImage that draws from
+ * the shared bitmap.
+ *
+ * Only 8 bit per component RGB images are copied. Animated, wide color and grayscale images
+ * are stored as they are. containsObjectWithName: may return YES for an image that turns out
+ * to have been purged. Images stored before this is enabled stay as they are.
+ *
+ * Evicted purgeable images are not kept in the weak tier, because nothing else holds on to the
+ * purgeable copies. They still go to the encoded tier, encoded from their decoded bitmap.
+ *
+ * @fn NIImageMemoryCache::storesImagesInPurgeableMemory
+ */
+
+/** @name Finding Image Variants */
+
+/**
+ * Records that the named image is one size of a group of images that only differ in size.
+ *
+ * An image view that shows the same image at several sizes stores each size under its own
+ * name. Adding each of them to a group lets a lookup for a size that isn't cached find a larger
+ * one to scale down instead. The group is usually the image's URL combined with everything other
+ * than the size that affects how the image was processed.
+ *
+ * Groups only hold names, so evicted variants stay cheap and are forgotten the next time the
+ * group is searched. The least recently added groups are forgotten once there are many of them.
+ *
+ * @param name   The name the image was stored with.
+ * @param size   The size the image was processed for, in points.
+ * @param group  The group of variants to add the image to.
+ * @fn NIImageMemoryCache::addVariantWithName:size:toGroup:
+ */
+
+/**
+ * Returns the name of the smallest cached variant that is at least as large as the given size.
+ *
+ * Only variants with the same aspect ratio as the requested size are considered, so that
+ * scaling the variant down produces the same image as processing the original at the requested
+ * size.
+ *
+ * @returns The name of the variant, or nil if no cached variant covers the size.
+ * @fn NIImageMemoryCache::nameOfSmallestVariantInGroup:coveringSize:
+ */
+
+// NIMemoryCacheStatistics
+
+/** @name Lookups */
+
+/**
+ * The number of times objectWithName: found an unexpired object.
+ *
+ * @fn NIMemoryCacheStatistics::numberOfHits
+ */
+
+/**
+ * The number of times objectWithName: came back empty handed, including when the object had
+ * expired.
+ *
+ * @fn NIMemoryCacheStatistics::numberOfMisses
+ */
+
+/**
+ * The fraction of lookups that were hits, or 0 if there have been no lookups.
+ *
+ * @fn NIMemoryCacheStatistics::hitRate
+ */
+
+/**
+ * The number of objects the cache accepted.
+ *
+ * @fn NIMemoryCacheStatistics::numberOfStores
+ */
+
+/** @name Evictions */
+
+/**
+ * The number of least recently used objects removed to keep the cache under its limits.
+ *
+ * @fn NIMemoryCacheStatistics::numberOfEvictions
+ */
+
+/**
+ * The number of objects removed because they had expired.
+ *
+ * @fn NIMemoryCacheStatistics::numberOfExpirations
+ */
+
+/**
+ * The number of objects removed by reduceMemoryUsage to get under the limits for when the
+ * device is low on memory.
+ *
+ * @fn NIMemoryCacheStatistics::numberOfStressEvictions
+ */
+
+/**
+ * The number of bytes released by evictions of any kind.
+ *
+ * Objects stored with a cost release their cost. NIImageMemoryCache also counts the decoded
+ * size of images that were stored without one.
+ *
+ * @fn NIMemoryCacheStatistics::numberOfBytesEvicted
+ */
+
+/** @name Contention */
+
+/**
+ * The number of times a store, lookup, removal or sweep held the cache lock.
+ *
+ * @fn NIMemoryCacheStatistics::numberOfLockHolds
+ */
+
+/**
+ * The mean time, in seconds, that the cache lock was held by a store, lookup, removal or sweep.
+ *
+ * @fn NIMemoryCacheStatistics::averageLockHoldTime
+ */
+
+/**
+ * The number of times a thread had to wait for another to release the cache lock.
+ *
+ * Compared with numberOfLockHolds this tells whether a cache is worth splitting into more
+ * segments.
+ *
+ * @fn NIMemoryCacheStatistics::numberOfContendedLocks
+ */
@@ -16,22 +16,150 @@
 
 #import "NIInMemoryCache.h"
 
+#import "NIDataStructures.h"
 #import "NIDebuggingTools.h"
+#import "NIFastLock.h"
 #import "NIPreprocessorMacros.h"
 
 #import <UIKit/UIKit.h>
+#import <mach/mach_time.h>
+#import <stdatomic.h>
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "Nimbus requires ARC support."
 #endif
 
+@class NIMemoryCacheInfo;
+@class NIMemoryCachePrefixIndex;
+
+// Why an object left the cache. Everything but an explicit removal counts as an eviction.
+typedef enum {
+  NIMemoryCacheRemovalReasonExplicit,
+  NIMemoryCacheRemovalReasonCapacity,
+  NIMemoryCacheRemovalReasonExpiration,
+  NIMemoryCacheRemovalReasonStress,
+} NIMemoryCacheRemovalReason;
+
+// The counters behind NIMemoryCacheStatistics. The counters don't guard any other state, so
+// they are updated with relaxed atomics and never take the cache lock.
+typedef struct {
+  atomic_ullong hits;
+  atomic_ullong misses;
+  atomic_ullong stores;
+  atomic_ullong evictions;
+  atomic_ullong expirations;
+  atomic_ullong stressEvictions;
+  atomic_ullong bytesEvicted;
+  atomic_ullong lockHolds;
+  atomic_ullong lockHoldTicks;
+} NIMemoryCacheCounters;
+
+@interface NIMemoryCacheStatistics()
+@property (nonatomic) unsigned long long numberOfHits;
+@property (nonatomic) unsigned long long numberOfMisses;
+@property (nonatomic) unsigned long long numberOfStores;
+@property (nonatomic) unsigned long long numberOfEvictions;
+@property (nonatomic) unsigned long long numberOfExpirations;
+@property (nonatomic) unsigned long long numberOfStressEvictions;
+@property (nonatomic) unsigned long long numberOfBytesEvicted;
+@property (nonatomic) unsigned long long numberOfLockHolds;
+@property (nonatomic) NSTimeInterval totalLockHoldTime;
+@property (nonatomic) unsigned long long numberOfContendedLocks;
+- (void)addStatistics:(NIMemoryCacheStatistics *)statistics;
+@end
+
 @interface NIMemoryCache()
 // Mapping from a name (usually a URL) to an internal object.
 @property (nonatomic, strong) NSMutableDictionary* cacheMap;
-// A linked list of least recently used cache objects. Most recently used is the tail.
-@property (nonatomic, strong) NSMutableOrderedSet* lruCacheObjects;
+// An intrusive doubly-linked list of least recently used cache objects. The head is the least
+// recently used object and the tail is the most recently used object. The cache map owns every
+// info object, so the list does not retain its nodes.
+@property (nonatomic, unsafe_unretained) NIMemoryCacheInfo* lruHead;
+@property (nonatomic, unsafe_unretained) NIMemoryCacheInfo* lruTail;
+// The segments that own the cache entries when the cache has more than one segment, nil
+// otherwise. A segmented cache does not store any entries itself.
+@property (nonatomic, copy) NSArray* segments;
+// A min-heap of the cache objects that have an expiration date, ordered by expiration
+// date. Only the objects that have expired need to be visited when purging expired objects.
+@property (nonatomic, strong) NIPriorityQueue* expirationHeap;
+// A radix trie of the names in the cache when indexesNamesByPrefix is enabled, nil otherwise.
+@property (nonatomic, strong) NIMemoryCachePrefixIndex* prefixIndex;
+// The sum of the costs that the objects in the cache were stored with.
+@property (nonatomic) unsigned long long totalCost;
+
+// Evicted objects that are still alive elsewhere, when keepsWeakReferencesToEvictedObjects is
+// enabled, nil otherwise.
+@property (nonatomic, strong) NSMapTable* weakObjects;
+
+// The encoded form of evicted objects, costed by length, when maxNumberOfEncodedBytes is
+// non-zero, nil otherwise.
+@property (nonatomic, strong) NIMemoryCache* encodedCache;
+// Periodically removes expired objects when expirationSweepInterval is non-zero.
+@property (nonatomic, strong) dispatch_source_t expirationSweepTimer;
+// A snapshot of the lru list, ordered from least to most recently used. Only meant for debugging.
+- (NSArray *)lruCacheObjects;
+- (void)removeCacheInfoForName:(NSString *)name;
+- (void)removeCacheInfoForName:(NSString *)name reason:(NIMemoryCacheRemovalReason)reason;
+- (unsigned long long)numberOfBytesReleasedByRemovingCacheInfo:(NIMemoryCacheInfo *)info;
+- (void)demoteCacheInfo:(NIMemoryCacheInfo *)info;
+- (void)encodeCacheInfo:(NIMemoryCacheInfo *)info;
+- (id)objectToEncodeForObject:(id)object;
+- (void)removeLeastRecentlyUsedObjectsFromSegmentsWhile:(BOOL (^)(void))condition
+                                                 reason:(NIMemoryCacheRemovalReason)reason;
+- (void)didStoreObjectInSegment;
+- (NIFastLock *)cacheLock;
+- (void)recordLockHoldSinceTick:(uint64_t)tick;
+- (NIMemoryCacheInfo *)infoToEvict;
+- (void)finishRemovals;
 @end
 
+/**
+ * Returns the current value of the monotonic clock used to stamp cache accesses.
+ *
+ * Reading the clock does not allocate, which keeps cache hits cheap.
+ */
+static inline uint64_t NIMemoryCacheCurrentTick(void) {
+  return mach_absolute_time();
+}
+
+/**
+ * Converts a tick returned by NIMemoryCacheCurrentTick into a wall-clock date.
+ *
+ * The mapping is anchored once per process, so dates built from ticks preserve the relative
+ * ordering of the accesses they represent.
+ */
+static NSDate* NIMemoryCacheDateFromTick(uint64_t tick) {
+  static mach_timebase_info_data_t sTimebase;
+  static uint64_t sEpochTick = 0;
+  static CFAbsoluteTime sEpochTime = 0;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    mach_timebase_info(&sTimebase);
+    sEpochTick = mach_absolute_time();
+    sEpochTime = CFAbsoluteTimeGetCurrent();
+  });
+
+  double nanoseconds = 0;
+  if (tick >= sEpochTick) {
+    nanoseconds = (double)(tick - sEpochTick) * sTimebase.numer / sTimebase.denom;
+  } else {
+    nanoseconds = -(double)(sEpochTick - tick) * sTimebase.numer / sTimebase.denom;
+  }
+  return [NSDate dateWithTimeIntervalSinceReferenceDate:sEpochTime + nanoseconds / NSEC_PER_SEC];
+}
+
+/**
+ * Converts a number of ticks of the monotonic clock into seconds.
+ */
+static NSTimeInterval NIMemoryCacheSecondsFromTicks(uint64_t ticks) {
+  static mach_timebase_info_data_t sTimebase;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    mach_timebase_info(&sTimebase);
+  });
+  return (double)ticks * sTimebase.numer / sTimebase.denom / NSEC_PER_SEC;
+}
+
 /**
  * @brief A single cache item's information.
  *
@@ -39,409 +167,2374 @@
  */
 @interface NIMemoryCacheInfo : NSObject
 
-/**
- * @brief The name used to store this object in the cache.
- */
-@property (nonatomic, copy) NSString* name;
+/**
+ * @brief The name used to store this object in the cache.
+ */
+@property (nonatomic, copy) NSString* name;
+
+/**
+ * @brief The object stored in the cache.
+ */
+@property (nonatomic, strong) id object;
+
+/**
+ * @brief The date after which the image is no longer valid and should be removed from the cache.
+ */
+@property (nonatomic, strong) NSDate* expirationDate;
+
+/**
+ * @brief The expiration date as a time interval since the reference date.
+ *
+ * Used by the expiration heap so that comparing expiration dates doesn't need to message
+ * NSDate objects.
+ */
+@property (nonatomic) NSTimeInterval expirationTime;
+
+/**
+ * @brief The handle of this object in the cache's expiration heap, or nil.
+ *
+ * The heap retains the handle, so the handle is cleared whenever the object leaves the heap.
+ */
+@property (nonatomic, unsafe_unretained) NIPriorityQueueHandle* expirationHandle;
+
+/**
+ * @brief The cost the object was stored with, or 0 if none was given.
+ */
+@property (nonatomic) unsigned long long cost;
+
+/**
+ * @brief The number of bytes an NIImageMemoryCache charged for this object when it was stored.
+ *
+ * Exactly this many bytes are released again when the object is removed or replaced.
+ */
+@property (nonatomic) unsigned long long numberOfChargedBytes;
+
+/**
+ * @brief The monotonic tick of the last time this object was accessed.
+ *
+ * This property is updated every time the object is fetched from or stored into the cache.
+ */
+@property (nonatomic) uint64_t lastAccessTick;
+
+/**
+ * @brief The last time this object was accessed.
+ *
+ * Built lazily from lastAccessTick and reused until the object is accessed again.
+ */
+@property (nonatomic, readonly, strong) NSDate* lastAccessTime;
+
+/**
+ * @brief The neighbours of this object in the cache's lru list.
+ *
+ * The cache map retains the info objects, so these links are not retained.
+ */
+@property (nonatomic, unsafe_unretained) NIMemoryCacheInfo* lruPrev;
+@property (nonatomic, unsafe_unretained) NIMemoryCacheInfo* lruNext;
+
+/**
+ * @brief Determine whether this cache entry has past its expiration date.
+ *
+ * @returns YES if an expiration date has been specified and the expiration date has been passed.
+ *          NO in all other cases. Notably if there is no expiration date then this object will
+ *          never expire.
+ */
+- (BOOL)hasExpired;
+
+/**
+ * @brief Determine whether this cache entry had past its expiration date at the given time.
+ */
+- (BOOL)hasExpiredAtTime:(NSTimeInterval)time;
+
+@end
+
+/**
+ * Returns the current time as a time interval since the reference date.
+ *
+ * Goes through +[NSDate date] so that the unit tests can fake the current time.
+ */
+static NSTimeInterval NIMemoryCacheCurrentTime(void) {
+  return [[NSDate date] timeIntervalSinceReferenceDate];
+}
+
+/**
+ * @brief A node in a compact radix trie.
+ *
+ * Each node is reached by the edge label of the node, which is never empty except for the
+ * root. Children are keyed by the first character of their label.
+ */
+@interface NIMemoryCachePrefixIndexNode : NSObject
+@property (nonatomic, copy) NSString* label;
+@property (nonatomic, strong) NSMutableDictionary* children;
+@property (nonatomic) BOOL terminal;
+@end
+
+@implementation NIMemoryCachePrefixIndexNode
+@end
+
+/**
+ * @brief A compact radix trie of strings.
+ *
+ * Used by NIMemoryCache to find the names that start with a given prefix while only visiting
+ * the names that match.
+ */
+@interface NIMemoryCachePrefixIndex : NSObject
+- (void)addString:(NSString *)string;
+- (void)removeString:(NSString *)string;
+- (void)removeAllStrings;
+- (NSArray *)stringsWithPrefix:(NSString *)prefix;
+@end
+
+@implementation NIMemoryCachePrefixIndex {
+  NIMemoryCachePrefixIndexNode* _root;
+}
+
+- (id)init {
+  if ((self = [super init])) {
+    _root = [self nodeWithLabel:@""];
+  }
+  return self;
+}
+
+- (NIMemoryCachePrefixIndexNode *)nodeWithLabel:(NSString *)label {
+  NIMemoryCachePrefixIndexNode* node = [[NIMemoryCachePrefixIndexNode alloc] init];
+  node.label = label;
+  node.children = [NSMutableDictionary dictionary];
+  return node;
+}
+
+- (NSUInteger)lengthOfCommonPrefixOfString:(NSString *)string1 andString:(NSString *)string2 {
+  NSUInteger length = MIN(string1.length, string2.length);
+  NSUInteger ix = 0;
+  while (ix < length && [string1 characterAtIndex:ix] == [string2 characterAtIndex:ix]) {
+    ++ix;
+  }
+  return ix;
+}
+
+- (void)addString:(NSString *)string {
+  NIMemoryCachePrefixIndexNode* node = _root;
+  NSString* remainder = string;
+
+  while (remainder.length > 0) {
+    NSNumber* key = @([remainder characterAtIndex:0]);
+    NIMemoryCachePrefixIndexNode* child = node.children[key];
+
+    if (nil == child) {
+      child = [self nodeWithLabel:remainder];
+      child.terminal = YES;
+      node.children[key] = child;
+      return;
+    }
+
+    NSUInteger commonLength = [self lengthOfCommonPrefixOfString:child.label andString:remainder];
+    if (commonLength < child.label.length) {
+      // Split the edge at the point where the strings diverge.
+      NIMemoryCachePrefixIndexNode* split = [self nodeWithLabel:[child.label substringToIndex:commonLength]];
+      child.label = [child.label substringFromIndex:commonLength];
+      split.children[@([child.label characterAtIndex:0])] = child;
+      node.children[key] = split;
+      child = split;
+    }
+
+    node = child;
+    remainder = [remainder substringFromIndex:commonLength];
+  }
+
+  node.terminal = YES;
+}
+
+- (void)removeString:(NSString *)string {
+  NSMutableArray* path = [NSMutableArray arrayWithObject:_root];
+  NIMemoryCachePrefixIndexNode* node = _root;
+  NSString* remainder = string;
+
+  while (remainder.length > 0) {
+    NIMemoryCachePrefixIndexNode* child = node.children[@([remainder characterAtIndex:0])];
+    if (nil == child || ![remainder hasPrefix:child.label]) {
+      return;
+    }
+    [path addObject:child];
+    node = child;
+    remainder = [remainder substringFromIndex:child.label.length];
+  }
+
+  if (!node.terminal) {
+    return;
+  }
+  node.terminal = NO;
+
+  // Prune the nodes that no longer lead anywhere and merge nodes left with a single child.
+  for (NSInteger ix = path.count - 1; ix > 0; --ix) {
+    NIMemoryCachePrefixIndexNode* current = path[ix];
+    NIMemoryCachePrefixIndexNode* parent = path[ix - 1];
+    NSNumber* key = @([current.label characterAtIndex:0]);
+
+    if (!current.terminal && 0 == current.children.count) {
+      [parent.children removeObjectForKey:key];
+
+    } else if (!current.terminal && 1 == current.children.count) {
+      NIMemoryCachePrefixIndexNode* onlyChild = [[current.children allValues] firstObject];
+      onlyChild.label = [current.label stringByAppendingString:onlyChild.label];
+      parent.children[key] = onlyChild;
+      break;
+
+    } else {
+      break;
+    }
+  }
+}
+
+- (void)removeAllStrings {
+  [_root.children removeAllObjects];
+  _root.terminal = NO;
+}
+
+- (void)collectStringsFromNode:(NIMemoryCachePrefixIndexNode *)node
+                        prefix:(NSString *)prefix
+                     intoArray:(NSMutableArray *)strings {
+  if (node.terminal) {
+    [strings addObject:prefix];
+  }
+  for (NIMemoryCachePrefixIndexNode* child in [node.children objectEnumerator]) {
+    [self collectStringsFromNode:child
+                          prefix:[prefix stringByAppendingString:child.label]
+                       intoArray:strings];
+  }
+}
+
+- (NSArray *)stringsWithPrefix:(NSString *)prefix {
+  NIMemoryCachePrefixIndexNode* node = _root;
+  NSString* consumed = @"";
+  NSString* remainder = (nil != prefix) ? prefix : @"";
+
+  while (remainder.length > 0) {
+    NIMemoryCachePrefixIndexNode* child = node.children[@([remainder characterAtIndex:0])];
+    if (nil == child) {
+      return @[];
+    }
+    if (remainder.length <= child.label.length) {
+      // The prefix ends somewhere along this edge.
+      if (![child.label hasPrefix:remainder]) {
+        return @[];
+      }
+    } else if (![remainder hasPrefix:child.label]) {
+      return @[];
+    }
+    consumed = [consumed stringByAppendingString:child.label];
+    remainder = (remainder.length <= child.label.length) ? @"" : [remainder substringFromIndex:child.label.length];
+    node = child;
+  }
+
+  NSMutableArray* strings = [NSMutableArray array];
+  [self collectStringsFromNode:node prefix:consumed intoArray:strings];
+  return strings;
+}
+
+@end
+
+@implementation NIMemoryCacheStatistics
+
+- (NSTimeInterval)averageLockHoldTime {
+  return (_numberOfLockHolds > 0) ? _totalLockHoldTime / _numberOfLockHolds : 0;
+}
+
+- (double)hitRate {
+  unsigned long long numberOfLookups = _numberOfHits + _numberOfMisses;
+  return (numberOfLookups > 0) ? (double)_numberOfHits / numberOfLookups : 0;
+}
+
+- (void)addStatistics:(NIMemoryCacheStatistics *)statistics {
+  _numberOfHits += statistics.numberOfHits;
+  _numberOfMisses += statistics.numberOfMisses;
+  _numberOfStores += statistics.numberOfStores;
+  _numberOfEvictions += statistics.numberOfEvictions;
+  _numberOfExpirations += statistics.numberOfExpirations;
+  _numberOfStressEvictions += statistics.numberOfStressEvictions;
+  _numberOfBytesEvicted += statistics.numberOfBytesEvicted;
+  _numberOfLockHolds += statistics.numberOfLockHolds;
+  _totalLockHoldTime += statistics.totalLockHoldTime;
+  _numberOfContendedLocks += statistics.numberOfContendedLocks;
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:
+          @"<%@"
+          @" hits: %llu"
+          @" misses: %llu"
+          @" stores: %llu"
+          @" evictions: %llu"
+          @" expirations: %llu"
+          @" stress evictions: %llu"
+          @" bytes evicted: %llu"
+          @" average lock hold time: %f"
+          @" contended locks: %llu"
+          @">",
+          [super description],
+          self.numberOfHits,
+          self.numberOfMisses,
+          self.numberOfStores,
+          self.numberOfEvictions,
+          self.numberOfExpirations,
+          self.numberOfStressEvictions,
+          self.numberOfBytesEvicted,
+          self.averageLockHoldTime,
+          self.numberOfContendedLocks];
+}
+
+@end
+
+// How many key names a cache remembers.
+static const NSUInteger kNIMemoryCacheKeyNameLimit = 512;
+
+@implementation NIMemoryCache {
+  // Guards the entries. Recursive because the subclassing methods are called while it is held
+  // and may call back into the cache.
+  NIFastLock _lock;
+  NIMemoryCacheCounters _counters;
+  id<NIMemoryCacheAdmissionPolicy> _admissionPolicy;
+  NSCache* _keysToNames;
+
+  // Entries removed while the cache was locked, waiting for finishRemovals.
+  NSMutableArray* _removedInfos;
+  // Evicted entries waiting for finishRemovals to encode them, in the order they were evicted.
+  NSMutableArray* _infosToEncode;
+  // The entries of _infosToEncode by name until they have been encoded. Storing or removing an
+  // object drops its name, so that an encoding that finishes late is not kept.
+  NSMutableDictionary* _unencodedInfos;
+  // Entries that were replaced or cleared, kept only so that they can be released in the
+  // background.
+  NSMutableArray* _releasedInfos;
+}
+
+- (void)dealloc {
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
+
+  if (nil != _expirationSweepTimer) {
+    dispatch_source_cancel(_expirationSweepTimer);
+  }
+  NIFastLockDestroy(&_lock);
+}
+
+- (id)init {
+  return [self initWithCapacity:0];
+}
+
+- (id)initWithCapacity:(NSUInteger)capacity {
+  return [self initWithCapacity:capacity numberOfSegments:1];
+}
+
+- (id)initWithCapacity:(NSUInteger)capacity numberOfSegments:(NSUInteger)numberOfSegments {
+  if ((self = [super init])) {
+    NIFastLockInit(&_lock, NIFastLockOptionRecursive | NIFastLockOptionCountsContention);
+
+    if (numberOfSegments > 1) {
+      _cacheMap = [[NSMutableDictionary alloc] init];
+
+      NSMutableArray* segments = [NSMutableArray arrayWithCapacity:numberOfSegments];
+      for (NSUInteger ix = 0; ix < numberOfSegments; ++ix) {
+        NIMemoryCache* segment = [[[self class] alloc] initWithCapacity:capacity / numberOfSegments
+                                                       numberOfSegments:1];
+
+        // The segmented cache reduces the memory usage of its segments itself.
+        [[NSNotificationCenter defaultCenter] removeObserver:segment];
+        [segments addObject:segment];
+      }
+      _segments = [segments copy];
+
+    } else {
+      _cacheMap = [[NSMutableDictionary alloc] initWithCapacity:capacity];
+      _expirationHeap = [[NIPriorityQueue alloc] initWithComparator:
+                         ^NSComparisonResult(NIMemoryCacheInfo* info1, NIMemoryCacheInfo* info2) {
+        if (info1.expirationTime < info2.expirationTime) {
+          return NSOrderedAscending;
+        }
+        return (info1.expirationTime > info2.expirationTime) ? NSOrderedDescending : NSOrderedSame;
+      }];
+    }
+
+    _keysToNames = [[NSCache alloc] init];
+    _keysToNames.countLimit = kNIMemoryCacheKeyNameLimit;
+
+    // Automatically reduce memory usage when the system runs low on memory.
+    [[NIMemoryPressureCoordinator sharedCoordinator] addObserver:self
+                                                         selector:@selector(didReceiveMemoryPressure:)];
+  }
+  return self;
+}
+
+- (NSString *)description {
+  if (nil != self.segments) {
+    return [NSString stringWithFormat:
+            @"<%@"
+            @" segments: %@"
+            @">",
+            [super description],
+            self.segments];
+  }
+  return [NSString stringWithFormat:
+          @"<%@"
+          @" lruObjects: %@"
+          @" cache map: %@"
+          @">",
+          [super description],
+          self.lruCacheObjects,
+          self.cacheMap];
+}
+
+- (NSUInteger)numberOfSegments {
+  return (nil != self.segments) ? self.segments.count : 1;
+}
+
+#pragma mark - Segments
+
+- (NSUInteger)segmentIndexForName:(NSString *)name {
+  NSUInteger hash = [name hash];
+
+  // Mix the bits so that names that only differ in their last few characters end up in
+  // different segments.
+  hash ^= (hash >> 16);
+  hash *= 0x45d9f3b;
+  hash ^= (hash >> 16);
+
+  return hash % self.segments.count;
+}
+
+- (NIMemoryCache *)segmentForName:(NSString *)name {
+  return self.segments[[self segmentIndexForName:name]];
+}
+
+// Returns one index set per segment containing the indexes of the names that belong to it.
+- (NSArray *)indexesOfNamesBySegment:(NSArray *)names {
+  NSMutableArray* indexesBySegment = [NSMutableArray arrayWithCapacity:self.segments.count];
+  for (NSUInteger ix = 0; ix < self.segments.count; ++ix) {
+    [indexesBySegment addObject:[NSMutableIndexSet indexSet]];
+  }
+  [names enumerateObjectsUsingBlock:^(NSString* name, NSUInteger ix, BOOL* stop) {
+    [indexesBySegment[[self segmentIndexForName:name]] addIndex:ix];
+  }];
+  return indexesBySegment;
+}
+
+// Returns the segment whose least (or most) recently used object was accessed the longest
+// (or shortest) time ago.
+- (NIMemoryCache *)segmentWithLeastRecentlyUsedObject:(BOOL)leastRecentlyUsed {
+  NIMemoryCache* bestSegment = nil;
+  uint64_t bestTick = 0;
+  for (NIMemoryCache* segment in self.segments) {
+    {
+      NI_LOCK_SCOPE([segment cacheLock]);
+      NIMemoryCacheInfo* info = leastRecentlyUsed ? segment.lruHead : segment.lruTail;
+      if (nil != info
+          && (nil == bestSegment
+              || (leastRecentlyUsed
+                  ? info.lastAccessTick < bestTick
+                  : info.lastAccessTick > bestTick))) {
+        bestSegment = segment;
+        bestTick = info.lastAccessTick;
+      }
+    }
+  }
+  return bestSegment;
+}
+
+// Removes the least recently used objects across all segments while the condition holds.
+//
+// Only one segment lock is held at a time so that segments never wait on each other.
+- (void)removeLeastRecentlyUsedObjectsFromSegmentsWhile:(BOOL (^)(void))condition
+                                                 reason:(NIMemoryCacheRemovalReason)reason {
+  while (condition()) {
+    NIMemoryCache* segment = [self segmentWithLeastRecentlyUsedObject:YES];
+    if (nil == segment) {
+      break;
+    }
+    {
+      NI_LOCK_SCOPE([segment cacheLock]);
+      NIMemoryCacheInfo* info = [segment infoToEvict];
+      if (nil != info) {
+        [segment removeCacheInfoForName:info.name reason:reason];
+      }
+    }
+    [segment finishRemovals];
+  }
+}
+
+// Called after an object has been stored in one of the segments. Subclasses that limit the
+// size of the cache enforce their limits across all segments here.
+- (void)didStoreObjectInSegment {
+  // No-op
+}
+
+#pragma mark - Statistics
+
+- (NIFastLock *)cacheLock {
+  return &_lock;
+}
+
+- (void)recordLockHoldSinceTick:(uint64_t)tick {
+  atomic_fetch_add_explicit(&_counters.lockHolds, 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&_counters.lockHoldTicks, NIMemoryCacheCurrentTick() - tick,
+                            memory_order_relaxed);
+}
+
+- (void)recordRemovalOfNumberOfBytes:(unsigned long long)numberOfBytes
+                              reason:(NIMemoryCacheRemovalReason)reason {
+  switch (reason) {
+    case NIMemoryCacheRemovalReasonExplicit:
+      return;
+    case NIMemoryCacheRemovalReasonCapacity:
+      atomic_fetch_add_explicit(&_counters.evictions, 1, memory_order_relaxed);
+      break;
+    case NIMemoryCacheRemovalReasonExpiration:
+      atomic_fetch_add_explicit(&_counters.expirations, 1, memory_order_relaxed);
+      break;
+    case NIMemoryCacheRemovalReasonStress:
+      atomic_fetch_add_explicit(&_counters.stressEvictions, 1, memory_order_relaxed);
+      break;
+  }
+  NI_SIGNPOST_EVENT(NISignpostCategoryCaches, "Eviction", self,
+                    "reason %d, %llu bytes", (int)reason, numberOfBytes);
+  atomic_fetch_add_explicit(&_counters.bytesEvicted, numberOfBytes, memory_order_relaxed);
+}
+
+- (NIMemoryCacheStatistics *)statistics {
+  NIMemoryCacheStatistics* statistics = [[NIMemoryCacheStatistics alloc] init];
+  if (nil != self.segments) {
+    for (NIMemoryCache* segment in self.segments) {
+      [statistics addStatistics:[segment statistics]];
+    }
+    return statistics;
+  }
+  statistics.numberOfHits = atomic_load_explicit(&_counters.hits, memory_order_relaxed);
+  statistics.numberOfMisses = atomic_load_explicit(&_counters.misses, memory_order_relaxed);
+  statistics.numberOfStores = atomic_load_explicit(&_counters.stores, memory_order_relaxed);
+  statistics.numberOfEvictions = atomic_load_explicit(&_counters.evictions, memory_order_relaxed);
+  statistics.numberOfExpirations = atomic_load_explicit(&_counters.expirations, memory_order_relaxed);
+  statistics.numberOfStressEvictions = atomic_load_explicit(&_counters.stressEvictions, memory_order_relaxed);
+  statistics.numberOfBytesEvicted = atomic_load_explicit(&_counters.bytesEvicted, memory_order_relaxed);
+  statistics.numberOfLockHolds = atomic_load_explicit(&_counters.lockHolds, memory_order_relaxed);
+  statistics.totalLockHoldTime =
+      NIMemoryCacheSecondsFromTicks(atomic_load_explicit(&_counters.lockHoldTicks, memory_order_relaxed));
+  statistics.numberOfContendedLocks = NIFastLockGetStatistics(&_lock).numberOfContentions;
+  return statistics;
+}
+
+- (void)resetStatistics {
+  if (nil != self.segments) {
+    for (NIMemoryCache* segment in self.segments) {
+      [segment resetStatistics];
+    }
+    return;
+  }
+  atomic_store_explicit(&_counters.hits, 0, memory_order_relaxed);
+  atomic_store_explicit(&_counters.misses, 0, memory_order_relaxed);
+  atomic_store_explicit(&_counters.stores, 0, memory_order_relaxed);
+  atomic_store_explicit(&_counters.evictions, 0, memory_order_relaxed);
+  atomic_store_explicit(&_counters.expirations, 0, memory_order_relaxed);
+  atomic_store_explicit(&_counters.stressEvictions, 0, memory_order_relaxed);
+  atomic_store_explicit(&_counters.bytesEvicted, 0, memory_order_relaxed);
+  atomic_store_explicit(&_counters.lockHolds, 0, memory_order_relaxed);
+  atomic_store_explicit(&_counters.lockHoldTicks, 0, memory_order_relaxed);
+  NIFastLockResetStatistics(&_lock);
+}
+
+#pragma mark - Internal
+
+- (NSArray *)lruCacheObjects {
+  {
+    NI_LOCK_SCOPE(&_lock);
+    NSMutableArray* objects = [NSMutableArray arrayWithCapacity:self.cacheMap.count];
+    for (NIMemoryCacheInfo* info = self.lruHead; nil != info; info = info.lruNext) {
+      [objects addObject:info];
+    }
+    return objects;
+  }
+}
+
+- (BOOL)isInfoInLRUList:(NIMemoryCacheInfo *)info {
+  return (nil != info.lruPrev || self.lruHead == info);
+}
+
+- (void)unlinkInfoFromLRUList:(NIMemoryCacheInfo *)info {
+  if (![self isInfoInLRUList:info]) {
+    return;
+  }
+
+  if (nil != info.lruPrev) {
+    info.lruPrev.lruNext = info.lruNext;
+  } else {
+    self.lruHead = info.lruNext;
+  }
+
+  if (nil != info.lruNext) {
+    info.lruNext.lruPrev = info.lruPrev;
+  } else {
+    self.lruTail = info.lruPrev;
+  }
+
+  info.lruPrev = nil;
+  info.lruNext = nil;
+}
+
+- (void)appendInfoToLRUList:(NIMemoryCacheInfo *)info {
+  info.lruPrev = self.lruTail;
+  info.lruNext = nil;
+  if (nil != self.lruTail) {
+    self.lruTail.lruNext = info;
+  } else {
+    self.lruHead = info;
+  }
+  self.lruTail = info;
+}
+
+#pragma mark - Expiration Heap
+
+- (void)addInfoToExpirationHeap:(NIMemoryCacheInfo *)info {
+  if (nil == info.expirationDate) {
+    return;
+  }
+  info.expirationHandle = [self.expirationHeap addObject:info];
+}
+
+- (void)removeInfoFromExpirationHeap:(NIMemoryCacheInfo *)info {
+  if (nil == info.expirationHandle) {
+    return;
+  }
+  [self.expirationHeap removeObjectWithHandle:info.expirationHandle];
+  info.expirationHandle = nil;
+}
+
+#pragma mark - LRU
+
+- (void)updateAccessTimeForInfo:(NIMemoryCacheInfo *)info {
+  {
+    NI_LOCK_SCOPE(&_lock);
+    [self updateAccessTimeForInfo:info tick:NIMemoryCacheCurrentTick()];
+  }
+}
+
+// Must be called with the cache locked.
+- (void)updateAccessTimeForInfo:(NIMemoryCacheInfo *)info tick:(uint64_t)tick {
+  NIDASSERT(nil != info);
+  if (nil == info) {
+    return; // COV_NF_LINE
+  }
+  info.lastAccessTick = tick;
+
+  if (self.lruTail != info) {
+    [self unlinkInfoFromLRUList:info];
+    [self appendInfoToLRUList:info];
+  }
+}
+
+// Returns the entry that should be evicted next. Must be called with the cache locked.
+//
+// Without an admission policy this is the least recently used entry. With one, the oldest entry
+// in the admission window at the most recently used end of the list competes with the least
+// recently used entry and the policy picks the loser. A candidate that wins stays where it is
+// and falls out of the window as newer entries arrive.
+- (NIMemoryCacheInfo *)infoToEvict {
+  NIMemoryCacheInfo* victim = self.lruHead;
+  id<NIMemoryCacheAdmissionPolicy> admissionPolicy = _admissionPolicy;
+  if (nil == admissionPolicy || nil == victim) {
+    return victim;
+  }
+
+  NSUInteger windowSize = MAX((NSUInteger)1,
+                              (NSUInteger)(self.cacheMap.count * [admissionPolicy windowFraction]));
+  NIMemoryCacheInfo* candidate = self.lruTail;
+  for (NSUInteger ix = 1; ix < windowSize && nil != candidate.lruPrev; ++ix) {
+    candidate = candidate.lruPrev;
+  }
+  if (candidate == victim) {
+    return victim;
+  }
+  return ([admissionPolicy shouldAdmitName:candidate.name evictingName:victim.name]
+          ? victim
+          : candidate);
+}
+
+- (NIMemoryCacheInfo *)cacheInfoForName:(NSString *)name {
+  NIMemoryCacheInfo* info;
+  {
+    NI_LOCK_SCOPE(&_lock);
+    info = self.cacheMap[name];
+  }
+  return info;
+}
+
+- (void)setCacheInfo:(NIMemoryCacheInfo *)info forName:(NSString *)name {
+  {
+    NI_LOCK_SCOPE(&_lock);
+    NIDASSERT(nil != name);
+    if (nil == name) {
+      return;
+    }
+
+    NIMemoryCacheInfo* previousInfo = [self cacheInfoForName:name];
+    id previousObject = previousInfo.object;
+    if ([self shouldSetObject:info.object withName:name previousObject:previousObject]) {
+      // The list does not retain its nodes, so unlink any info we're replacing before the cache
+      // map releases it.
+      if (nil != previousInfo && previousInfo != info) {
+        [self unlinkInfoFromLRUList:previousInfo];
+        [self removeInfoFromExpirationHeap:previousInfo];
+        if (_releasesRemovedObjectsInBackground) {
+          [self addReleasedInfos:@[previousInfo]];
+        }
+      }
+      if (nil == previousInfo) {
+        [self.prefixIndex addString:name];
+        [self removeLowerTierObjectsWithName:name];
+      }
+      self.totalCost = self.totalCost - MIN(previousInfo.cost, self.totalCost) + info.cost;
+      self.cacheMap[name] = info;
+      [self removeInfoFromExpirationHeap:info];
+      [self addInfoToExpirationHeap:info];
+
+      // Storing in the cache counts as an access of the object, so we update the access time.
+      [self updateAccessTimeForInfo:info];
+      [_admissionPolicy recordAccessOfName:name];
+      atomic_fetch_add_explicit(&_counters.stores, 1, memory_order_relaxed);
+
+      [self didSetObject:info.object withName:name];
+    }
+  }
+}
+
+- (void)removeCacheInfoForName:(NSString *)name {
+  [self removeCacheInfoForName:name reason:NIMemoryCacheRemovalReasonExplicit];
+}
+
+- (void)removeCacheInfoForName:(NSString *)name reason:(NIMemoryCacheRemovalReason)reason {
+  {
+    NI_LOCK_SCOPE(&_lock);
+    NIDASSERT(nil != name);
+    if (nil == name) {
+      return;
+    }
+
+    NIMemoryCacheInfo* cacheInfo = [self cacheInfoForName:name];
+    if (nil == cacheInfo) {
+      return;
+    }
+    [self willRemoveObject:cacheInfo.object withName:name];
+    [self recordRemovalOfNumberOfBytes:[self numberOfBytesReleasedByRemovingCacheInfo:cacheInfo]
+                                reason:reason];
+    if (NIMemoryCacheRemovalReasonCapacity == reason || NIMemoryCacheRemovalReasonStress == reason) {
+      [self demoteCacheInfo:cacheInfo];
+    }
+
+    [self unlinkInfoFromLRUList:cacheInfo];
+    [self removeInfoFromExpirationHeap:cacheInfo];
+    [self.prefixIndex removeString:name];
+    self.totalCost -= MIN(cacheInfo.cost, self.totalCost);
+
+    // The entry outlives the cache map until finishRemovals so that didRemoveObject:withName:
+    // and the final release both happen once the cache has been unlocked.
+    if (nil == _removedInfos) {
+      _removedInfos = [[NSMutableArray alloc] init];
+    }
+    [_removedInfos addObject:cacheInfo];
+    [self.cacheMap removeObjectForKey:name];
+  }
+}
+
+// Must be called with the cache locked.
+- (void)addReleasedInfos:(NSArray *)infos {
+  if (nil == _releasedInfos) {
+    _releasedInfos = [[NSMutableArray alloc] init];
+  }
+  [_releasedInfos addObjectsFromArray:infos];
+}
+
+// Notifies the subclass of the entries removed since the last call and lets go of them. Must be
+// called without the cache locked, after any method that may have removed entries.
+- (void)finishRemovals {
+  NSArray* removedInfos = nil;
+  NSArray* releasedInfos = nil;
+  NSArray* infosToEncode = nil;
+  BOOL releasesInBackground = NO;
+  {
+    NI_LOCK_SCOPE(&_lock);
+    if (nil == _removedInfos && nil == _releasedInfos && nil == _infosToEncode) {
+      return;
+    }
+    releasesInBackground = _releasesRemovedObjectsInBackground;
+    removedInfos = _removedInfos;
+    releasedInfos = _releasedInfos;
+    infosToEncode = _infosToEncode;
+    _removedInfos = nil;
+    _releasedInfos = nil;
+    _infosToEncode = nil;
+  }
+
+  for (NIMemoryCacheInfo* info in removedInfos) {
+    [self didRemoveObject:info.object withName:info.name];
+  }
+
+  if (nil != infosToEncode) {
+    [self encodeCacheInfos:infosToEncode];
+  }
+
+  if (releasesInBackground) {
+    // The block holds the last references to the entries, so large objects such as decoded
+    // bitmaps are freed on the background queue rather than on the calling thread.
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+      (void)removedInfos;
+      (void)releasedInfos;
+    });
+  }
+}
+
+// Returns the number of bytes that stop being charged when the given entry is removed.
+- (unsigned long long)numberOfBytesReleasedByRemovingCacheInfo:(NIMemoryCacheInfo *)info {
+  return info.cost;
+}
+
+#pragma mark - Lower Tiers
+
+// Hands an evicted entry to the weak and encoded tiers. Must be called with the cache locked.
+- (void)demoteCacheInfo:(NIMemoryCacheInfo *)info {
+  [self.weakObjects setObject:info.object forKey:info.name];
+  [self encodeCacheInfo:info];
+}
+
+// Queues an evicted entry for the encoded tier. Encoding can be as slow as compressing an image,
+// so it waits for finishRemovals rather than holding up every reader. Must be called with the
+// cache locked.
+- (void)encodeCacheInfo:(NIMemoryCacheInfo *)info {
+  if (nil == self.encodedCache || nil == self.dataFromObject) {
+    return;
+  }
+  if (nil == _infosToEncode) {
+    _infosToEncode = [[NSMutableArray alloc] init];
+  }
+  if (nil == _unencodedInfos) {
+    _unencodedInfos = [[NSMutableDictionary alloc] init];
+  }
+  [_infosToEncode addObject:info];
+  _unencodedInfos[info.name] = info;
+}
+
+// Returns the object whose encoding is kept for an evicted object, or nil to skip it. Called
+// without the cache locked.
+- (id)objectToEncodeForObject:(id)object {
+  return object;
+}
+
+// Encodes evicted entries and stores them in the encoded tier. Must be called without the cache
+// locked.
+- (void)encodeCacheInfos:(NSArray *)infos {
+  NSData* (^dataFromObject)(id object) = nil;
+  {
+    NI_LOCK_SCOPE(&_lock);
+    dataFromObject = self.dataFromObject;
+  }
+
+  for (NIMemoryCacheInfo* info in infos) {
+    id object = [self objectToEncodeForObject:info.object];
+    NSData* data = (nil != object && nil != dataFromObject) ? dataFromObject(object) : nil;
+
+    {
+      NI_LOCK_SCOPE(&_lock);
+      // The object may have been stored again or removed while it was being encoded.
+      if (_unencodedInfos[info.name] != info) {
+        continue;
+      }
+      [_unencodedInfos removeObjectForKey:info.name];
+      if (nil == data || nil == self.encodedCache) {
+        continue;
+      }
+      [self.encodedCache storeObject:data
+                            withName:info.name
+                        expiresAfter:info.expirationDate
+                                cost:data.length];
+      unsigned long long numberOfEncodedBytes = [self.encodedCache numberOfBytesInMemoryBudget];
+      if (numberOfEncodedBytes > self.maxNumberOfEncodedBytes) {
+        [self.encodedCache reduceMemoryUsageByNumberOfBytes:numberOfEncodedBytes - self.maxNumberOfEncodedBytes];
+      }
+    }
+  }
+}
+
+// Drops any evicted copies of the named object. Must be called with the cache locked.
+- (void)removeLowerTierObjectsWithName:(NSString *)name {
+  [self.weakObjects removeObjectForKey:name];
+  [_unencodedInfos removeObjectForKey:name];
+  [self.encodedCache removeObjectWithName:name];
+}
+
+- (BOOL)hasLowerTiers {
+  {
+    NI_LOCK_SCOPE(&_lock);
+    return (nil != self.weakObjects || nil != self.encodedCache);
+  }
+}
+
+// Looks for an evicted object that is still alive or can be decoded. Decoded objects are
+// stored in the cache again. Must be called without the cache locked so that decoding doesn't
+// block other threads.
+- (id)objectFromLowerTiersWithName:(NSString *)name {
+  NIMemoryCache* encodedCache = nil;
+  id (^objectFromData)(NSData* data) = nil;
+  {
+    NI_LOCK_SCOPE(&_lock);
+    id object = [self.weakObjects objectForKey:name];
+    if (nil != object) {
+      return object;
+    }
+    encodedCache = self.encodedCache;
+    objectFromData = self.objectFromData;
+  }
+  if (nil == encodedCache || nil == objectFromData) {
+    return nil;
+  }
+
+  NSData* data = [encodedCache objectWithName:name];
+  if (nil == data) {
+    return nil;
+  }
+  NSDate* expirationDate = [encodedCache cacheInfoForName:name].expirationDate;
+  id object = objectFromData(data);
+  if (nil != object) {
+    [self storeObject:object withName:name expiresAfter:expirationDate];
+  }
+  return object;
+}
+
+#pragma mark - Subclassing
+
+// Deprecated method.
+- (BOOL)willSetObject:(id)object withName:(NSString *)name previousObject:(id)previousObject {
+  return [self shouldSetObject:object withName:name previousObject:previousObject];
+}
+
+- (BOOL)shouldSetObject:(id)object withName:(NSString *)name previousObject:(id)previousObject {
+  // Allow anything to be stored.
+  return YES;
+}
+
+- (void)didSetObject:(id)object withName:(NSString *)name {
+  // No-op
+}
+
+- (void)willRemoveObject:(id)object withName:(NSString *)name {
+  // No-op
+}
+
+- (void)didRemoveObject:(id)object withName:(NSString *)name {
+  // No-op
+}
+
+#pragma mark - Public
+
+- (void)storeObject:(id)object withName:(NSString *)name {
+  [self storeObject:object withName:name expiresAfter:nil cost:0];
+}
+
+- (void)storeObject:(id)object withName:(NSString *)name expiresAfter:(NSDate *)expirationDate {
+  [self storeObject:object withName:name expiresAfter:expirationDate cost:0];
+}
+
+- (void)storeObject:(id)object withName:(NSString *)name cost:(unsigned long long)cost {
+  [self storeObject:object withName:name expiresAfter:nil cost:cost];
+}
+
+- (void)storeObject:(id)object withName:(NSString *)name expiresAfter:(NSDate *)expirationDate cost:(unsigned long long)cost {
+  if (nil != self.segments) {
+    [[self segmentForName:name] storeObject:object withName:name expiresAfter:expirationDate cost:cost];
+    [self didStoreObjectInSegment];
+    return;
+  }
+  BOOL isExpired = NO;
+  {
+    NI_LOCK_SCOPE(&_lock);
+    // Don't store nil objects in the cache.
+    if (nil == object) {
+      return;
+    }
+    uint64_t lockTick = NIMemoryCacheCurrentTick();
+
+    isExpired = (nil != expirationDate && [[NSDate date] timeIntervalSinceDate:expirationDate] >= 0);
+    if (isExpired) {
+      // The object being stored is already expired so remove the object from the cache altogether,
+      // including any evicted copy that could otherwise still be found.
+      [self removeCacheInfoForName:name];
+      [self removeLowerTierObjectsWithName:name];
+
+    } else {
+      // Always create a new cache entry so that subclasses are told about the object being
+      // replaced, and so that a rejected object leaves the existing entry untouched.
+      NIMemoryCacheInfo* info = [[NIMemoryCacheInfo alloc] init];
+      info.name = name;
+      info.object = object;
+      info.expirationDate = expirationDate;
+      info.expirationTime = [expirationDate timeIntervalSinceReferenceDate];
+      info.cost = cost;
+
+      // Commit the changes to the cache.
+      [self setCacheInfo:info forName:name];
+    }
+    [self recordLockHoldSinceTick:lockTick];
+  }
+  [self finishRemovals];
+
+  if (isExpired) {
+    // We're done here.
+    return;
+  }
+
+  // The cache may have grown past its share of the memory budget.
+  [Nimbus setNeedsMemoryBudgetEnforcement];
+}
+
+- (void)storeObjects:(NSArray *)objects withNames:(NSArray *)names expiresAfter:(NSDate *)expirationDate {
+  NIDASSERT(objects.count == names.count);
+  NSUInteger count = MIN(objects.count, names.count);
+
+  if (nil != self.segments) {
+    // Hand each segment its share of the objects so that each segment is only locked once.
+    NSArray* indexesBySegment = [self indexesOfNamesBySegment:[names subarrayWithRange:NSMakeRange(0, count)]];
+    [self.segments enumerateObjectsUsingBlock:^(NIMemoryCache* segment, NSUInteger ix, BOOL* stop) {
+      NSIndexSet* indexes = indexesBySegment[ix];
+      if (indexes.count > 0) {
+        [segment storeObjects:[objects objectsAtIndexes:indexes]
+                    withNames:[names objectsAtIndexes:indexes]
+                 expiresAfter:expirationDate];
+      }
+    }];
+    [self didStoreObjectInSegment];
+    return;
+  }
+  BOOL isExpired = NO;
+  {
+    NI_LOCK_SCOPE(&_lock);
+    uint64_t lockTick = NIMemoryCacheCurrentTick();
+
+    isExpired = (nil != expirationDate && [[NSDate date] timeIntervalSinceDate:expirationDate] >= 0);
+    if (isExpired) {
+      // As with a single store, storing already expired objects removes them instead.
+      for (NSUInteger ix = 0; ix < count; ++ix) {
+        [self removeCacheInfoForName:names[ix]];
+        [self removeLowerTierObjectsWithName:names[ix]];
+      }
+
+    } else {
+      NSTimeInterval expirationTime = [expirationDate timeIntervalSinceReferenceDate];
+      for (NSUInteger ix = 0; ix < count; ++ix) {
+        NIMemoryCacheInfo* info = [[NIMemoryCacheInfo alloc] init];
+        info.name = names[ix];
+        info.object = objects[ix];
+        info.expirationDate = expirationDate;
+        info.expirationTime = expirationTime;
+        [self setCacheInfo:info forName:info.name];
+      }
+    }
+    [self recordLockHoldSinceTick:lockTick];
+  }
+  [self finishRemovals];
+
+  if (!isExpired) {
+    [Nimbus setNeedsMemoryBudgetEnforcement];
+  }
+}
+
+- (NSDictionary *)objectsWithNames:(NSArray *)names {
+  if (nil != self.segments) {
+    NSArray* indexesBySegment = [self indexesOfNamesBySegment:names];
+    NSMutableDictionary* objects = [NSMutableDictionary dictionaryWithCapacity:names.count];
+    [self.segments enumerateObjectsUsingBlock:^(NIMemoryCache* segment, NSUInteger ix, BOOL* stop) {
+      NSIndexSet* indexes = indexesBySegment[ix];
+      if (indexes.count > 0) {
+        [objects addEntriesFromDictionary:[segment objectsWithNames:[names objectsAtIndexes:indexes]]];
+      }
+    }];
+    return objects;
+  }
+  NSMutableDictionary* objects = [NSMutableDictionary dictionaryWithCapacity:names.count];
+  NSUInteger numberOfHits = 0;
+  {
+    NI_LOCK_SCOPE(&_lock);
+    uint64_t lockTick = NIMemoryCacheCurrentTick();
+
+    // Only read the wall clock if one of the objects can expire.
+    NSTimeInterval now = 0;
+    BOOL hasReadCurrentTime = NO;
+
+    for (NSString* name in names) {
+      [_admissionPolicy recordAccessOfName:name];
+
+      NIMemoryCacheInfo* info = self.cacheMap[name];
+      if (nil == info) {
+        continue;
+      }
+      if (nil != info.expirationDate) {
+        if (!hasReadCurrentTime) {
+          now = NIMemoryCacheCurrentTime();
+          hasReadCurrentTime = YES;
+        }
+        if ([info hasExpiredAtTime:now]) {
+          [self removeCacheInfoForName:name reason:NIMemoryCacheRemovalReasonExpiration];
+          continue;
+        }
+      }
+      [self updateAccessTimeForInfo:info tick:lockTick];
+      objects[name] = info.object;
+      ++numberOfHits;
+    }
+    [self recordLockHoldSinceTick:lockTick];
+  }
+  [self finishRemovals];
+
+  if (objects.count < names.count && [self hasLowerTiers]) {
+    for (NSString* name in names) {
+      if (nil == objects[name]) {
+        id object = [self objectFromLowerTiersWithName:name];
+        if (nil != object) {
+          objects[name] = object;
+          ++numberOfHits;
+        }
+      }
+    }
+  }
+  atomic_fetch_add_explicit(&_counters.hits, numberOfHits, memory_order_relaxed);
+  atomic_fetch_add_explicit(&_counters.misses, names.count - numberOfHits, memory_order_relaxed);
+  return objects;
+}
+
+- (id)objectWithName:(NSString *)name {
+  if (nil != self.segments) {
+    return [[self segmentForName:name] objectWithName:name];
+  }
+  id object = nil;
+  {
+    NI_LOCK_SCOPE(&_lock);
+    uint64_t lockTick = NIMemoryCacheCurrentTick();
+    NIMemoryCacheInfo* info = self.cacheMap[name];
+    [_admissionPolicy recordAccessOfName:name];
+
+    if (nil != info) {
+      if ([info hasExpired]) {
+        [self removeCacheInfoForName:name reason:NIMemoryCacheRemovalReasonExpiration];
+
+      } else {
+        // Update the access time whenever we fetch an object from the cache, without taking the
+        // lock a second time.
+        [self updateAccessTimeForInfo:info tick:lockTick];
+
+        object = info.object;
+      }
+    }
+
+    [self recordLockHoldSinceTick:lockTick];
+  }
+  [self finishRemovals];
+
+  if (nil == object && [self hasLowerTiers]) {
+    object = [self objectFromLowerTiersWithName:name];
+  }
+  atomic_fetch_add_explicit((nil != object) ? &_counters.hits : &_counters.misses, 1,
+                            memory_order_relaxed);
+  return object;
+}
+
+- (BOOL)containsObjectWithName:(NSString *)name {
+  if (nil != self.segments) {
+    return [[self segmentForName:name] containsObjectWithName:name];
+  }
+  BOOL containsObject = NO;
+  {
+    NI_LOCK_SCOPE(&_lock);
+    NIMemoryCacheInfo* info = [self cacheInfoForName:name];
+
+    if ([info hasExpired]) {
+      [self removeCacheInfoForName:name reason:NIMemoryCacheRemovalReasonExpiration];
+
+    } else {
+      containsObject = (nil != info);
+    }
+  }
+  [self finishRemovals];
+  return containsObject;
+}
+
+- (NSDate *)dateOfLastAccessWithName:(NSString *)name {
+  if (nil != self.segments) {
+    return [[self segmentForName:name] dateOfLastAccessWithName:name];
+  }
+  NSDate* lastAccessTime = nil;
+  {
+    NI_LOCK_SCOPE(&_lock);
+    NIMemoryCacheInfo* info = [self cacheInfoForName:name];
+
+    if ([info hasExpired]) {
+      [self removeCacheInfoForName:name reason:NIMemoryCacheRemovalReasonExpiration];
+
+    } else {
+      lastAccessTime = [info lastAccessTime];
+    }
+  }
+  [self finishRemovals];
+  return lastAccessTime;
+}
+
+- (NSString *)nameOfLeastRecentlyUsedObject {
+  if (nil != self.segments) {
+    return [[self segmentWithLeastRecentlyUsedObject:YES] nameOfLeastRecentlyUsedObject];
+  }
+  NSString* name = nil;
+  {
+    NI_LOCK_SCOPE(&_lock);
+    NIMemoryCacheInfo* info = self.lruHead;
+
+    if ([info hasExpired]) {
+      [self removeCacheInfoForName:info.name reason:NIMemoryCacheRemovalReasonExpiration];
+
+    } else {
+      name = info.name;
+    }
+  }
+  [self finishRemovals];
+  return name;
+}
+
+// Returns up to limit of the most recently used infos' names and ticks, most recent first.
+- (NSArray *)recentNamesAndTicksWithLimit:(NSUInteger)limit {
+  NSMutableArray* namesAndTicks = [NSMutableArray array];
+  NSTimeInterval now = NIMemoryCacheCurrentTime();
+  {
+    NI_LOCK_SCOPE(&_lock);
+    for (NIMemoryCacheInfo* info = self.lruTail;
+         nil != info && namesAndTicks.count < limit;
+         info = info.lruPrev) {
+      if (![info hasExpiredAtTime:now]) {
+        [namesAndTicks addObject:@[info.name, @(info.lastAccessTick)]];
+      }
+    }
+  }
+  return namesAndTicks;
+}
+
+- (NSArray *)namesOfMostRecentlyUsedObjectsWithLimit:(NSUInteger)limit {
+  NSMutableArray* namesAndTicks = [NSMutableArray array];
+  if (nil != self.segments) {
+    // Only one segment lock is held at a time, so the merged order is a close approximation.
+    for (NIMemoryCache* segment in self.segments) {
+      [namesAndTicks addObjectsFromArray:[segment recentNamesAndTicksWithLimit:limit]];
+    }
+    [namesAndTicks sortUsingComparator:^NSComparisonResult(NSArray* nameAndTick1, NSArray* nameAndTick2) {
+      return [nameAndTick2[1] compare:nameAndTick1[1]];
+    }];
+  } else {
+    [namesAndTicks addObjectsFromArray:[self recentNamesAndTicksWithLimit:limit]];
+  }
+
+  NSMutableArray* names = [NSMutableArray arrayWithCapacity:MIN(limit, namesAndTicks.count)];
+  for (NSArray* nameAndTick in namesAndTicks) {
+    if (names.count >= limit) {
+      break;
+    }
+    [names addObject:nameAndTick[0]];
+  }
+  return names;
+}
+
+- (NSString *)nameOfMostRecentlyUsedObject {
+  if (nil != self.segments) {
+    return [[self segmentWithLeastRecentlyUsedObject:NO] nameOfMostRecentlyUsedObject];
+  }
+  NSString* name = nil;
+  {
+    NI_LOCK_SCOPE(&_lock);
+    NIMemoryCacheInfo* info = self.lruTail;
+
+    if ([info hasExpired]) {
+      [self removeCacheInfoForName:info.name reason:NIMemoryCacheRemovalReasonExpiration];
+
+    } else {
+      name = info.name;
+    }
+  }
+  [self finishRemovals];
+  return name;
+}
+
+- (void)removeObjectWithName:(NSString *)name {
+  if (nil != self.segments) {
+    [[self segmentForName:name] removeObjectWithName:name];
+    return;
+  }
+  {
+    NI_LOCK_SCOPE(&_lock);
+    uint64_t lockTick = NIMemoryCacheCurrentTick();
+    [self removeCacheInfoForName:name];
+    [self removeLowerTierObjectsWithName:name];
+    [self recordLockHoldSinceTick:lockTick];
+  }
+  [self finishRemovals];
+}
+
+- (void)removeAllObjectsWithPrefix:(NSString *)prefix {
+  if (nil != self.segments) {
+    for (NIMemoryCache* segment in self.segments) {
+      [segment removeAllObjectsWithPrefix:prefix];
+    }
+    return;
+  }
+  {
+    NI_LOCK_SCOPE(&_lock);
+    for (NSString* name in [self namesOfObjectsWithPrefix:prefix]) {
+      [self removeCacheInfoForName:name];
+      [self removeLowerTierObjectsWithName:name];
+    }
+    for (NSString* name in [[self.weakObjects keyEnumerator] allObjects]) {
+      if ([name hasPrefix:prefix]) {
+        [self.weakObjects removeObjectForKey:name];
+      }
+    }
+    for (NSString* name in [_unencodedInfos allKeys]) {
+      if ([name hasPrefix:prefix]) {
+        [_unencodedInfos removeObjectForKey:name];
+      }
+    }
+    [self.encodedCache removeAllObjectsWithPrefix:prefix];
+  }
+  [self finishRemovals];
+}
+
+- (NSArray *)namesOfObjectsWithPrefix:(NSString *)prefix {
+  if (nil != self.segments) {
+    NSMutableArray* names = [NSMutableArray array];
+    for (NIMemoryCache* segment in self.segments) {
+      [names addObjectsFromArray:[segment namesOfObjectsWithPrefix:prefix]];
+    }
+    return names;
+  }
+  {
+    NI_LOCK_SCOPE(&_lock);
+    if (nil != self.prefixIndex) {
+      return [self.prefixIndex stringsWithPrefix:prefix];
+    }
+
+    NSMutableArray* names = [NSMutableArray array];
+    for (NSString* name in self.cacheMap) {
+      if ([name hasPrefix:prefix]) {
+        [names addObject:name];
+      }
+    }
+    return names;
+  }
+}
+
+- (BOOL)indexesNamesByPrefix {
+  if (nil != self.segments) {
+    return [self.segments.firstObject indexesNamesByPrefix];
+  }
+  {
+    NI_LOCK_SCOPE(&_lock);
+    return (nil != self.prefixIndex);
+  }
+}
+
+- (void)setIndexesNamesByPrefix:(BOOL)indexesNamesByPrefix {
+  if (nil != self.segments) {
+    for (NIMemoryCache* segment in self.segments) {
+      segment.indexesNamesByPrefix = indexesNamesByPrefix;
+    }
+    return;
+  }
+  {
+    NI_LOCK_SCOPE(&_lock);
+    if (indexesNamesByPrefix && nil == self.prefixIndex) {
+      self.prefixIndex = [[NIMemoryCachePrefixIndex alloc] init];
+      for (NSString* name in self.cacheMap) {
+        [self.prefixIndex addString:name];
+      }
+
+    } else if (!indexesNamesByPrefix) {
+      self.prefixIndex = nil;
+    }
+  }
+}
+
+- (id<NIMemoryCacheAdmissionPolicy>)admissionPolicy {
+  if (nil != self.segments) {
+    return [self.segments.firstObject admissionPolicy];
+  }
+  {
+    NI_LOCK_SCOPE(&_lock);
+    return _admissionPolicy;
+  }
+}
+
+- (void)setAdmissionPolicy:(id<NIMemoryCacheAdmissionPolicy>)admissionPolicy {
+  if (nil != self.segments) {
+    // The segments share one policy so that frequencies are counted across the whole cache.
+    for (NIMemoryCache* segment in self.segments) {
+      [segment setAdmissionPolicy:admissionPolicy];
+    }
+    return;
+  }
+  {
+    NI_LOCK_SCOPE(&_lock);
+    _admissionPolicy = admissionPolicy;
+  }
+}
+
+- (void)setKeepsWeakReferencesToEvictedObjects:(BOOL)keepsWeakReferencesToEvictedObjects {
+  _keepsWeakReferencesToEvictedObjects = keepsWeakReferencesToEvictedObjects;
+  if (nil != self.segments) {
+    for (NIMemoryCache* segment in self.segments) {
+      segment.keepsWeakReferencesToEvictedObjects = keepsWeakReferencesToEvictedObjects;
+    }
+    return;
+  }
+  {
+    NI_LOCK_SCOPE(&_lock);
+    if (keepsWeakReferencesToEvictedObjects && nil == self.weakObjects) {
+      self.weakObjects = [NSMapTable strongToWeakObjectsMapTable];
+
+    } else if (!keepsWeakReferencesToEvictedObjects) {
+      self.weakObjects = nil;
+    }
+  }
+}
+
+- (void)setReleasesRemovedObjectsInBackground:(BOOL)releasesRemovedObjectsInBackground {
+  if (nil != self.segments) {
+    for (NIMemoryCache* segment in self.segments) {
+      segment.releasesRemovedObjectsInBackground = releasesRemovedObjectsInBackground;
+    }
+  }
+  {
+    NI_LOCK_SCOPE(&_lock);
+    _releasesRemovedObjectsInBackground = releasesRemovedObjectsInBackground;
+  }
+}
+
+- (BOOL)releasesRemovedObjectsInBackground {
+  {
+    NI_LOCK_SCOPE(&_lock);
+    return _releasesRemovedObjectsInBackground;
+  }
+}
+
+- (void)setMaxNumberOfEncodedBytes:(unsigned long long)maxNumberOfEncodedBytes {
+  if (nil != self.segments) {
+    _maxNumberOfEncodedBytes = maxNumberOfEncodedBytes;
+    for (NIMemoryCache* segment in self.segments) {
+      segment.maxNumberOfEncodedBytes = maxNumberOfEncodedBytes / self.segments.count;
+    }
+    return;
+  }
+  {
+    NI_LOCK_SCOPE(&_lock);
+    _maxNumberOfEncodedBytes = maxNumberOfEncodedBytes;
+    if (0 == maxNumberOfEncodedBytes) {
+      self.encodedCache = nil;
+      return;
+    }
+    if (nil == self.encodedCache) {
+      self.encodedCache = [[NIMemoryCache alloc] init];
+    }
+    unsigned long long numberOfEncodedBytes = [self.encodedCache numberOfBytesInMemoryBudget];
+    if (numberOfEncodedBytes > maxNumberOfEncodedBytes) {
+      [self.encodedCache reduceMemoryUsageByNumberOfBytes:numberOfEncodedBytes - maxNumberOfEncodedBytes];
+    }
+  }
+}
+
+- (void)setDataFromObject:(NSData* (^)(id))dataFromObject {
+  _dataFromObject = [dataFromObject copy];
+  for (NIMemoryCache* segment in self.segments) {
+    segment.dataFromObject = dataFromObject;
+  }
+}
+
+- (void)setObjectFromData:(id (^)(NSData *))objectFromData {
+  _objectFromData = [objectFromData copy];
+  for (NIMemoryCache* segment in self.segments) {
+    segment.objectFromData = objectFromData;
+  }
+}
+
+- (void)removeAllObjects {
+  if (nil != self.segments) {
+    for (NIMemoryCache* segment in self.segments) {
+      [segment removeAllObjects];
+    }
+    return;
+  }
+  {
+    NI_LOCK_SCOPE(&_lock);
+    for (NIMemoryCacheInfo* info in [self.cacheMap objectEnumerator]) {
+      info.lruPrev = nil;
+      info.lruNext = nil;
+      info.expirationHandle = nil;
+    }
+    self.lruHead = nil;
+    self.lruTail = nil;
+    [self.expirationHeap removeAllObjects];
+    [self.prefixIndex removeAllStrings];
+    if (_releasesRemovedObjectsInBackground) {
+      [self addReleasedInfos:[self.cacheMap allValues]];
+    }
+    [self.cacheMap removeAllObjects];
+    self.totalCost = 0;
+    [self.weakObjects removeAllObjects];
+    [_unencodedInfos removeAllObjects];
+    [self.encodedCache removeAllObjects];
+  }
+  [self finishRemovals];
+}
+
+- (void)reduceMemoryUsage {
+  if (nil != self.segments) {
+    for (NIMemoryCache* segment in self.segments) {
+      [segment reduceMemoryUsage];
+    }
+    return;
+  }
+  [self removeExpiredObjects];
+}
+
+- (void)removeExpiredObjects {
+  if (nil != self.segments) {
+    for (NIMemoryCache* segment in self.segments) {
+      [segment removeExpiredObjects];
+    }
+    return;
+  }
+  {
+    NI_LOCK_SCOPE(&_lock);
+    if (0 == self.expirationHeap.count) {
+      return;
+    }
+    uint64_t lockTick = NIMemoryCacheCurrentTick();
+    NSTimeInterval now = NIMemoryCacheCurrentTime();
+
+    // The heap is ordered by expiration date, so we can stop at the first unexpired object.
+    NIMemoryCacheInfo* info = self.expirationHeap.firstObject;
+    while (nil != info && [info hasExpiredAtTime:now]) {
+      [self removeCacheInfoForName:info.name reason:NIMemoryCacheRemovalReasonExpiration];
+      info = self.expirationHeap.firstObject;
+    }
+    [self recordLockHoldSinceTick:lockTick];
+  }
+  [self finishRemovals];
+}
+
+- (void)setExpirationSweepInterval:(NSTimeInterval)expirationSweepInterval {
+  {
+    NI_LOCK_SCOPE(&_lock);
+    _expirationSweepInterval = expirationSweepInterval;
+
+    if (nil != self.expirationSweepTimer) {
+      dispatch_source_cancel(self.expirationSweepTimer);
+      self.expirationSweepTimer = nil;
+    }
+
+    if (expirationSweepInterval > 0) {
+      dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0);
+      dispatch_source_t timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, queue);
+      uint64_t interval = (uint64_t)(expirationSweepInterval * NSEC_PER_SEC);
+
+      // Give the system plenty of leeway so that the sweep can be coalesced with other work.
+      dispatch_source_set_timer(timer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)interval),
+                                interval, interval / 2);
+      __weak NIMemoryCache* weakSelf = self;
+      dispatch_source_set_event_handler(timer, ^{
+        [weakSelf removeExpiredObjects];
+      });
+      dispatch_resume(timer);
+      self.expirationSweepTimer = timer;
+    }
+  }
+}
+
+- (NSUInteger)count {
+  if (nil != self.segments) {
+    NSUInteger count = 0;
+    for (NIMemoryCache* segment in self.segments) {
+      count += [segment count];
+    }
+    return count;
+  }
+  {
+    NI_LOCK_SCOPE(&_lock);
+    return self.cacheMap.count;
+  }
+}
+
+#pragma mark - Keys
+
+- (NSString *)nameForKey:(id<NIMemoryCacheKey>)key {
+  // NSCache is thread-safe, so the cache doesn't need to be locked here.
+  NSString* name = [_keysToNames objectForKey:key];
+  if (nil == name) {
+    name = [key memoryCacheName];
+    if (nil != name) {
+      [_keysToNames setObject:name forKey:key];
+    }
+  }
+  return name;
+}
+
+- (void)storeObject:(id)object withKey:(id<NIMemoryCacheKey>)key expiresAfter:(NSDate *)expirationDate {
+  [self storeObject:object withName:[self nameForKey:key] expiresAfter:expirationDate];
+}
+
+- (void)storeObject:(id)object withKey:(id<NIMemoryCacheKey>)key expiresAfter:(NSDate *)expirationDate cost:(unsigned long long)cost {
+  [self storeObject:object withName:[self nameForKey:key] expiresAfter:expirationDate cost:cost];
+}
+
+- (id)objectWithKey:(id<NIMemoryCacheKey>)key {
+  return [self objectWithName:[self nameForKey:key]];
+}
+
+- (BOOL)containsObjectWithKey:(id<NIMemoryCacheKey>)key {
+  return [self containsObjectWithName:[self nameForKey:key]];
+}
+
+- (void)removeObjectWithKey:(id<NIMemoryCacheKey>)key {
+  [self removeObjectWithName:[self nameForKey:key]];
+}
+
+#pragma mark - NIMemoryBudgetConsumer
+
+- (unsigned long long)numberOfBytesInMemoryBudget {
+  if (nil != self.segments) {
+    unsigned long long numberOfBytes = 0;
+    for (NIMemoryCache* segment in self.segments) {
+      numberOfBytes += [segment numberOfBytesInMemoryBudget];
+    }
+    return numberOfBytes;
+  }
+  {
+    NI_LOCK_SCOPE(&_lock);
+    return self.totalCost;
+  }
+}
+
+- (void)reduceMemoryUsageByNumberOfBytes:(unsigned long long)numberOfBytes {
+  unsigned long long currentNumberOfBytes = [self numberOfBytesInMemoryBudget];
+  unsigned long long targetNumberOfBytes = currentNumberOfBytes - MIN(numberOfBytes, currentNumberOfBytes);
+
+  if (nil != self.segments) {
+    [self removeLeastRecentlyUsedObjectsFromSegmentsWhile:^BOOL{
+      return [self numberOfBytesInMemoryBudget] > targetNumberOfBytes;
+    } reason:NIMemoryCacheRemovalReasonCapacity];
+    return;
+  }
+  {
+    NI_LOCK_SCOPE(&_lock);
+    NIMemoryCacheInfo* info = nil;
+    while ([self numberOfBytesInMemoryBudget] > targetNumberOfBytes
+           && nil != (info = [self infoToEvict])) {
+      [self removeCacheInfoForName:info.name reason:NIMemoryCacheRemovalReasonCapacity];
+    }
+  }
+  [self finishRemovals];
+}
+
+#pragma mark - Memory Pressure
+
+- (void)reduceMemoryUsageForPressureLevel:(NIMemoryPressureLevel)level {
+  switch (level) {
+    case NIMemoryPressureLevelNormal:
+      break;
+    case NIMemoryPressureLevelBackground:
+    case NIMemoryPressureLevelWarning:
+      [self removeExpiredObjects];
+      break;
+    case NIMemoryPressureLevelCritical:
+      [self reduceMemoryUsage];
+      break;
+  }
+}
+
+- (void)didReceiveMemoryPressure:(NSNotification *)notification {
+  [self reduceMemoryUsageForPressureLevel:NIMemoryPressureLevelFromNotification(notification)];
+}
+
+@end
+
+@implementation NIMemoryCacheInfo
+
+@synthesize lastAccessTime = _lastAccessTime;
+
+- (void)setLastAccessTick:(uint64_t)lastAccessTick {
+  _lastAccessTick = lastAccessTick;
+
+  // The date is rebuilt the next time somebody asks for it.
+  _lastAccessTime = nil;
+}
+
+- (NSDate *)lastAccessTime {
+  if (nil == _lastAccessTime && 0 != _lastAccessTick) {
+    _lastAccessTime = NIMemoryCacheDateFromTick(_lastAccessTick);
+  }
+  return _lastAccessTime;
+}
+
+- (BOOL)hasExpired {
+  return (nil != _expirationDate && [self hasExpiredAtTime:NIMemoryCacheCurrentTime()]);
+}
+
+- (BOOL)hasExpiredAtTime:(NSTimeInterval)time {
+  return (nil != _expirationDate && time >= _expirationTime);
+}
 
-/**
- * @brief The object stored in the cache.
- */
-@property (nonatomic, strong) id object;
+- (NSString *)description {
+  return [NSString stringWithFormat:
+          @"<%@"
+          @" name: %@"
+          @" object: %@"
+          @" expiration date: %@"
+          @" last access time: %@"
+          @">",
+          [super description],
+          self.name,
+          self.object,
+          self.expirationDate,
+          self.lastAccessTime];
+}
+
+@end
+
+// Gives up the content access that an image made by NIPurgeableBitmap::image holds.
+static void NIPurgeableBitmapReleaseData(void* info, const void* data, size_t size) {
+  NSPurgeableData* purgeableData = (__bridge_transfer NSPurgeableData *)info;
+  [purgeableData endContentAccess];
+}
 
 /**
- * @brief The date after which the image is no longer valid and should be removed from the cache.
+ * @brief A decoded bitmap kept in purgeable memory in place of a cached image.
+ *
+ * The bitmap is only volatile while none of the images made from it are alive, so an image
+ * that is on screen can never lose its pixels. The system may reclaim a volatile bitmap at
+ * any time without notifying anyone, after which image returns nil.
  */
-@property (nonatomic, strong) NSDate* expirationDate;
+@interface NIPurgeableBitmap : NSObject
 
 /**
- * @brief The last time this image was accessed.
+ * @brief Copies the image into purgeable memory.
  *
- * This property is updated every time the image is fetched from or stored into the cache. It
- * is used when the memory peak has been reached as a fast means of removing least-recently-used
- * images. When the memory limit is reached, we sort the cache based on the last access times and
- * then prune images until we're under the memory limit again.
+ * Returns nil for images that can't be copied without losing information, such as animated,
+ * wide color or grayscale images.
  */
-@property (nonatomic, strong) NSDate* lastAccessTime;
++ (NIPurgeableBitmap *)bitmapWithImage:(UIImage *)image;
+
+@property (nonatomic, readonly) unsigned long long numberOfPixels;
+@property (nonatomic, readonly) unsigned long long numberOfBytes;
 
 /**
- * @brief Determine whether this cache entry has past its expiration date.
- *
- * @returns YES if an expiration date has been specified and the expiration date has been passed.
- *          NO in all other cases. Notably if there is no expiration date then this object will
- *          never expire.
+ * @brief Returns a new image that draws from the bitmap, or nil if the bitmap was purged.
  */
-- (BOOL)hasExpired;
+- (UIImage *)image;
 
 @end
 
-@implementation NIMemoryCache
-
-- (void)dealloc {
-  [[NSNotificationCenter defaultCenter] removeObserver:self];
+@implementation NIPurgeableBitmap {
+  NSPurgeableData* _data;
+  size_t _width;
+  size_t _height;
+  size_t _bytesPerRow;
+  CGColorSpaceRef _colorSpace;
+  CGFloat _scale;
+  UIImageOrientation _orientation;
 }
 
-- (id)init {
-  return [self initWithCapacity:0];
+- (void)dealloc {
+  CGColorSpaceRelease(_colorSpace);
 }
 
-- (id)initWithCapacity:(NSUInteger)capacity {
-  if ((self = [super init])) {
-    _cacheMap = [[NSMutableDictionary alloc] initWithCapacity:capacity];
-    _lruCacheObjects = [NSMutableOrderedSet orderedSet];
++ (NIPurgeableBitmap *)bitmapWithImage:(UIImage *)image {
+  CGImageRef imageRef = image.CGImage;
+  if (NULL == imageRef || image.images.count > 0
+      || 8 != CGImageGetBitsPerComponent(imageRef) || 32 != CGImageGetBitsPerPixel(imageRef)
+      || kCGColorSpaceModelRGB != CGColorSpaceGetModel(CGImageGetColorSpace(imageRef))) {
+    return nil;
+  }
+  size_t width = CGImageGetWidth(imageRef);
+  size_t height = CGImageGetHeight(imageRef);
+  if (0 == width || 0 == height) {
+    return nil;
+  }
 
-    // Automatically reduce memory usage when we get a memory warning.
-    [[NSNotificationCenter defaultCenter] addObserver:self
-                                             selector:@selector(reduceMemoryUsage)
-                                                 name:UIApplicationDidReceiveMemoryWarningNotification
-                                               object:nil];
+  NIPurgeableBitmap* bitmap = [[self alloc] init];
+  bitmap->_width = width;
+  bitmap->_height = height;
+  // Rows aligned to 64 bytes can be handed to the GPU without being copied.
+  bitmap->_bytesPerRow = (width * 4 + 63) & ~(size_t)63;
+  bitmap->_colorSpace = CGColorSpaceCreateDeviceRGB();
+  bitmap->_scale = image.scale;
+  bitmap->_orientation = image.imageOrientation;
+
+  // New purgeable data is being accessed until told otherwise.
+  NSPurgeableData* data = [[NSPurgeableData alloc] initWithLength:bitmap->_bytesPerRow * height];
+  CGContextRef context = CGBitmapContextCreate(data.mutableBytes, width, height, 8,
+                                               bitmap->_bytesPerRow, bitmap->_colorSpace,
+                                               [self bitmapInfo]);
+  if (NULL == context) {
+    return nil;
   }
-  return self;
-}
+  CGContextSetBlendMode(context, kCGBlendModeCopy);
+  CGContextDrawImage(context, CGRectMake(0, 0, width, height), imageRef);
+  CGContextRelease(context);
+  [data endContentAccess];
 
-- (NSString *)description {
-  return [NSString stringWithFormat:
-          @"<%@"
-          @" lruObjects: %@"
-          @" cache map: %@"
-          @">",
-          [super description],
-          self.lruCacheObjects,
-          self.cacheMap];
+  bitmap->_data = data;
+  return bitmap;
 }
 
-#pragma mark - Internal
++ (CGBitmapInfo)bitmapInfo {
+  return (CGBitmapInfo)kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Host;
+}
 
-- (void)updateAccessTimeForInfo:(NIMemoryCacheInfo *)info {
-  @synchronized(self) {
-    NIDASSERT(nil != info);
-    if (nil == info) {
-      return; // COV_NF_LINE
-    }
-    info.lastAccessTime = [NSDate date];
+- (unsigned long long)numberOfPixels {
+  return (unsigned long long)_width * _height;
+}
 
-    [self.lruCacheObjects removeObject:info];
-    [self.lruCacheObjects addObject:info];
-  }
+- (unsigned long long)numberOfBytes {
+  return (unsigned long long)_bytesPerRow * _height;
 }
 
-- (NIMemoryCacheInfo *)cacheInfoForName:(NSString *)name {
-  NIMemoryCacheInfo* info;
-  @synchronized(self) {
-    info = self.cacheMap[name];
+- (UIImage *)image {
+  if (![_data beginContentAccess]) {
+    return nil;
   }
-  return info;
+  // The provider holds the content access until the last image drawing from it goes away.
+  CGDataProviderRef provider = CGDataProviderCreateWithData((__bridge_retained void *)_data,
+                                                            _data.bytes, _data.length,
+                                                            NIPurgeableBitmapReleaseData);
+  if (NULL == provider) {
+    [_data endContentAccess];
+    return nil;
+  }
+  CGImageRef imageRef = CGImageCreate(_width, _height, 8, 32, _bytesPerRow, _colorSpace,
+                                      [[self class] bitmapInfo], provider, NULL, false,
+                                      kCGRenderingIntentDefault);
+  CGDataProviderRelease(provider);
+  if (NULL == imageRef) {
+    return nil;
+  }
+  UIImage* image = [UIImage imageWithCGImage:imageRef scale:_scale orientation:_orientation];
+  CGImageRelease(imageRef);
+  return image;
 }
 
-- (void)setCacheInfo:(NIMemoryCacheInfo *)info forName:(NSString *)name {
-  @synchronized(self) {
-    NIDASSERT(nil != name);
-    if (nil == name) {
-      return;
-    }
+@end
 
-    // Storing in the cache counts as an access of the object, so we update the access time.
-    [self updateAccessTimeForInfo:info];
+@interface NIImageMemoryCache()
+@property (nonatomic, assign) unsigned long long numberOfPixels;
+@property (nonatomic, assign) unsigned long long numberOfBytes;
+@end
 
-    id previousObject = [self cacheInfoForName:name].object;
-    if ([self shouldSetObject:info.object withName:name previousObject:previousObject]) {
-      self.cacheMap[name] = info;
-      [self didSetObject:info.object withName:name];
-    }
-  }
+// The objects an image memory cache holds: images, and images that were moved into purgeable
+// memory.
+static BOOL NIImageMemoryCacheIsImage(id object) {
+  return [object isKindOfClass:[UIImage class]] || [object isKindOfClass:[NIPurgeableBitmap class]];
 }
 
-- (void)removeCacheInfoForName:(NSString *)name {
-  @synchronized(self) {
-    NIDASSERT(nil != name);
-    if (nil == name) {
-      return;
-    }
+// Groups of variants beyond this many are forgotten, least recently added first.
+static const NSUInteger kNIImageMemoryCacheVariantGroupLimit = 1000;
 
-    NIMemoryCacheInfo* cacheInfo = [self cacheInfoForName:name];
-    [self willRemoveObject:cacheInfo.object withName:name];
+// The relative difference in aspect ratio below which a variant can be scaled to a size.
+static const CGFloat kNIImageMemoryCacheVariantAspectRatioTolerance = 0.01f;
 
-    [self.lruCacheObjects removeObject:cacheInfo];
-    [self.cacheMap removeObjectForKey:name];
-  }
-}
+// Prefixes the PNG data of images in the encoded tier.
+typedef struct {
+  Float32 scale;
+  int32_t orientation;
+} NIImageMemoryCacheEncodedHeader;
 
-#pragma mark - Subclassing
+@implementation NIImageMemoryCache {
+  // Maps a CGImageRef to the number of cached images that share it. Images that share a
+  // CGImage share its bitmap, so the bitmap is only charged once.
+  CFMutableDictionaryRef _imageReferenceCounts;
 
-// Deprecated method.
-- (BOOL)willSetObject:(id)object withName:(NSString *)name previousObject:(id)previousObject {
-  return [self shouldSetObject:object withName:name previousObject:previousObject];
+  // Group => NSMutableDictionary of variant name => NSValue of the variant's CGSize. Guarded by
+  // its own lock because the variants of a group may live in different segments.
+  NSCache* _variantGroups;
+  NIFastLock _variantGroupsLock;
 }
 
-- (BOOL)shouldSetObject:(id)object withName:(NSString *)name previousObject:(id)previousObject {
-  // Allow anything to be stored.
-  return YES;
+- (void)dealloc {
+  if (NULL != _imageReferenceCounts) {
+    CFRelease(_imageReferenceCounts);
+  }
+  NIFastLockDestroy(&_variantGroupsLock);
 }
 
-- (void)didSetObject:(id)object withName:(NSString *)name {
-  // No-op
+- (id)initWithCapacity:(NSUInteger)capacity numberOfSegments:(NSUInteger)numberOfSegments {
+  if ((self = [super initWithCapacity:capacity numberOfSegments:numberOfSegments])) {
+    // The cache retains the images, so the CGImages can not be freed out from under the keys.
+    _imageReferenceCounts = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+
+    _variantGroups = [[NSCache alloc] init];
+    _variantGroups.countLimit = kNIImageMemoryCacheVariantGroupLimit;
+    NIFastLockInit(&_variantGroupsLock, NIFastLockOptionNone);
+
+    // PNG keeps the encoded tier's pixels lossless, and the header keeps what PNG can't: the
+    // image's scale and orientation. Images evicted while they're still on screen are found
+    // through the weak tier without being decoded.
+    self.dataFromObject = ^NSData *(id object) {
+      if (![object isKindOfClass:[UIImage class]]) {
+        return nil;
+      }
+      UIImage* image = object;
+      NSData* pngData = UIImagePNGRepresentation(image);
+      if (nil == pngData) {
+        return nil;
+      }
+      NIImageMemoryCacheEncodedHeader header;
+      header.scale = (Float32)image.scale;
+      header.orientation = (int32_t)image.imageOrientation;
+      NSMutableData* data = [NSMutableData dataWithCapacity:sizeof(header) + pngData.length];
+      [data appendBytes:&header length:sizeof(header)];
+      [data appendData:pngData];
+      return data;
+    };
+    self.objectFromData = ^id(NSData* data) {
+      NIImageMemoryCacheEncodedHeader header;
+      if (data.length <= sizeof(header)) {
+        return nil;
+      }
+      [data getBytes:&header length:sizeof(header)];
+      NSData* pngData = [data subdataWithRange:NSMakeRange(sizeof(header), data.length - sizeof(header))];
+      CGImageRef imageRef = [[UIImage imageWithData:pngData] CGImage];
+      if (NULL == imageRef || header.scale <= 0) {
+        return nil;
+      }
+      return [UIImage imageWithCGImage:imageRef
+                                 scale:header.scale
+                           orientation:(UIImageOrientation)header.orientation];
+    };
+  }
+  return self;
 }
 
-- (void)willRemoveObject:(id)object withName:(NSString *)name {
-  // No-op
+- (unsigned long long)numberOfPixels {
+  if (nil != self.segments) {
+    unsigned long long numberOfPixels = 0;
+    for (NIImageMemoryCache* segment in self.segments) {
+      numberOfPixels += segment.numberOfPixels;
+    }
+    return numberOfPixels;
+  }
+  {
+    NI_LOCK_SCOPE([self cacheLock]);
+    return _numberOfPixels;
+  }
 }
 
-#pragma mark - Public
-
-- (void)storeObject:(id)object withName:(NSString *)name {
-  @synchronized(self) {
-    [self storeObject:object withName:name expiresAfter:nil];
+- (unsigned long long)numberOfBytes {
+  if (nil != self.segments) {
+    unsigned long long numberOfBytes = 0;
+    for (NIImageMemoryCache* segment in self.segments) {
+      numberOfBytes += segment.numberOfBytes;
+    }
+    return numberOfBytes;
+  }
+  {
+    NI_LOCK_SCOPE([self cacheLock]);
+    return _numberOfBytes;
   }
 }
 
-- (void)storeObject:(id)object withName:(NSString *)name expiresAfter:(NSDate *)expirationDate {
-  @synchronized(self) {
-    // Don't store nil objects in the cache.
-    if (nil == object) {
-      return;
-    }
+- (unsigned long long)numberOfBytesInMemoryBudget {
+  return self.numberOfBytes;
+}
 
-    if (nil != expirationDate && [[NSDate date] timeIntervalSinceDate:expirationDate] >= 0) {
-      // The object being stored is already expired so remove the object from the cache altogether.
-      [self removeObjectWithName:name];
+- (BOOL)isOverPixelLimit:(unsigned long long)maxNumberOfPixels
+               byteLimit:(unsigned long long)maxNumberOfBytes {
+  return ((maxNumberOfPixels > 0 && self.numberOfPixels > maxNumberOfPixels)
+          || (maxNumberOfBytes > 0 && self.numberOfBytes > maxNumberOfBytes));
+}
 
-      // We're done here.
-      return;
+// Removes the least recently used images, across all segments if there are any, until the
+// cache fits within the given limits.
+- (void)removeLeastRecentlyUsedImagesWhileOverPixelLimit:(unsigned long long)maxNumberOfPixels
+                                               byteLimit:(unsigned long long)maxNumberOfBytes
+                                                  reason:(NIMemoryCacheRemovalReason)reason {
+  if (0 == maxNumberOfPixels && 0 == maxNumberOfBytes) {
+    return;
+  }
+  if (nil != self.segments) {
+    [self removeLeastRecentlyUsedObjectsFromSegmentsWhile:^BOOL{
+      return [self isOverPixelLimit:maxNumberOfPixels byteLimit:maxNumberOfBytes];
+    } reason:reason];
+    return;
+  }
+  {
+    NI_LOCK_SCOPE([self cacheLock]);
+    // Remove the least recently used images, as picked by the admission policy, until the
+    // cache fits.
+    NIMemoryCacheInfo* info = nil;
+    while ([self isOverPixelLimit:maxNumberOfPixels byteLimit:maxNumberOfBytes]
+           && nil != (info = [self infoToEvict])) {
+      [self removeCacheInfoForName:info.name reason:reason];
     }
+  }
+}
 
-    NIMemoryCacheInfo* info = [self cacheInfoForName:name];
+- (void)didStoreObjectInSegment {
+  [self removeLeastRecentlyUsedImagesWhileOverPixelLimit:self.maxNumberOfPixels
+                                               byteLimit:self.maxNumberOfBytes
+                                                  reason:NIMemoryCacheRemovalReasonCapacity];
+}
 
-    // Create a new cache entry.
-    if (nil == info) {
-      info = [[NIMemoryCacheInfo alloc] init];
-      info.name = name;
+- (unsigned long long)numberOfPixelsUsedByImage:(id)image {
+  {
+    NI_LOCK_SCOPE([self cacheLock]);
+    if (nil == image) {
+      return 0;
+    }
+    if ([image isKindOfClass:[NIPurgeableBitmap class]]) {
+      return [(NIPurgeableBitmap *)image numberOfPixels];
     }
 
-    // Store the object in the cache item.
-    info.object = object;
-
-    // Override any existing expiration date.
-    info.expirationDate = expirationDate;
-
-    // Commit the changes to the cache.
-    [self setCacheInfo:info forName:name];
+    CGSize size = [(UIImage *)image size];
+    CGFloat scale = [(UIImage *)image scale];
+    return (unsigned long long)(size.width * size.height * scale * scale);
   }
 }
 
-- (id)objectWithName:(NSString *)name {
-  @synchronized(self) {
-    NIMemoryCacheInfo* info = [self cacheInfoForName:name];
+- (unsigned long long)numberOfBytesUsedByImageRef:(CGImageRef)imageRef {
+  return (unsigned long long)CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef);
+}
 
-    id object = nil;
+// Charges the decoded bitmaps of the image and returns the number of bytes newly charged.
+- (unsigned long long)retainBytesUsedByImage:(id)image {
+  if ([image isKindOfClass:[NIPurgeableBitmap class]]) {
+    // Purgeable bitmaps are never shared.
+    return [(NIPurgeableBitmap *)image numberOfBytes];
+  }
+  if ([image images].count > 0) {
+    // Animated images own one bitmap per frame.
+    unsigned long long numberOfBytes = 0;
+    for (UIImage* frame in [image images]) {
+      numberOfBytes += [self retainBytesUsedByImage:frame];
+    }
+    return numberOfBytes;
+  }
 
-    if (nil != info) {
-      if ([info hasExpired]) {
-        [self removeObjectWithName:name];
+  CGImageRef imageRef = [image CGImage];
+  if (NULL == imageRef) {
+    // Images that aren't backed by a CGImage are estimated at 32 bits per pixel.
+    return [self numberOfPixelsUsedByImage:image] * 4;
+  }
 
-      } else {
-        // Update the access time whenever we fetch an object from the cache.
-        [self updateAccessTimeForInfo:info];
+  NSUInteger referenceCount = (NSUInteger)CFDictionaryGetValue(_imageReferenceCounts, imageRef);
+  CFDictionarySetValue(_imageReferenceCounts, imageRef, (const void *)(referenceCount + 1));
+  return (0 == referenceCount) ? [self numberOfBytesUsedByImageRef:imageRef] : 0;
+}
 
-        object = info.object;
-      }
+// Releases the decoded bitmaps of the image and returns the number of bytes no longer charged.
+- (unsigned long long)releaseBytesUsedByImage:(id)image {
+  if ([image isKindOfClass:[NIPurgeableBitmap class]]) {
+    return [(NIPurgeableBitmap *)image numberOfBytes];
+  }
+  if ([image images].count > 0) {
+    unsigned long long numberOfBytes = 0;
+    for (UIImage* frame in [image images]) {
+      numberOfBytes += [self releaseBytesUsedByImage:frame];
     }
-
-    return object;
+    return numberOfBytes;
   }
-}
 
-- (BOOL)containsObjectWithName:(NSString *)name {
-  @synchronized(self) {
-    NIMemoryCacheInfo* info = [self cacheInfoForName:name];
+  CGImageRef imageRef = [image CGImage];
+  if (NULL == imageRef) {
+    return [self numberOfPixelsUsedByImage:image] * 4;
+  }
 
-    if ([info hasExpired]) {
-      [self removeObjectWithName:name];
-      return NO;
-    }
+  NSUInteger referenceCount = (NSUInteger)CFDictionaryGetValue(_imageReferenceCounts, imageRef);
+  NIDASSERT(referenceCount > 0);
+  if (referenceCount > 1) {
+    CFDictionarySetValue(_imageReferenceCounts, imageRef, (const void *)(referenceCount - 1));
+    return 0;
 
-    return (nil != info);
+  } else if (referenceCount == 1) {
+    CFDictionaryRemoveValue(_imageReferenceCounts, imageRef);
+    return [self numberOfBytesUsedByImageRef:imageRef];
   }
+  return 0;
 }
 
-- (NSDate *)dateOfLastAccessWithName:(NSString *)name {
-  @synchronized(self) {
-    NIMemoryCacheInfo* info = [self cacheInfoForName:name];
-
-    if ([info hasExpired]) {
-      [self removeObjectWithName:name];
-      return nil;
-    }
+// Stops charging the bytes of the given cache entry and returns the number of bytes released.
+- (unsigned long long)unchargeBytesForInfo:(NIMemoryCacheInfo *)info {
+  if (nil == info) {
+    return 0;
+  }
+  // Bitmaps shared with other entries are still charged to them, so images stored without a
+  // cost release whatever the reference counts say. Everything else releases what it was
+  // charged.
+  unsigned long long numberOfBytes = ((info.cost > 0 || !NIImageMemoryCacheIsImage(info.object))
+                                      ? info.numberOfChargedBytes
+                                      : [self releaseBytesUsedByImage:info.object]);
+  info.numberOfChargedBytes = 0;
+  numberOfBytes = MIN(numberOfBytes, _numberOfBytes);
+  _numberOfBytes -= numberOfBytes;
+  return numberOfBytes;
+}
 
-    return [info lastAccessTime];
+- (unsigned long long)numberOfBytesReleasedByRemovingCacheInfo:(NIMemoryCacheInfo *)info {
+  {
+    NI_LOCK_SCOPE([self cacheLock]);
+    return [self unchargeBytesForInfo:info];
   }
 }
 
-- (NSString *)nameOfLeastRecentlyUsedObject {
-  @synchronized(self) {
-    NIMemoryCacheInfo* info = [self.lruCacheObjects firstObject];
+- (void)removeAllObjects {
+  {
+    NI_LOCK_SCOPE([self cacheLock]);
+    [super removeAllObjects];
 
-    if ([info hasExpired]) {
-      [self removeObjectWithName:info.name];
-      return nil;
+    self.numberOfPixels = 0;
+    self.numberOfBytes = 0;
+    if (NULL != _imageReferenceCounts) {
+      CFDictionaryRemoveAllValues(_imageReferenceCounts);
     }
-
-    return info.name;
   }
+  [_variantGroups removeAllObjects];
 }
 
-- (NSString *)nameOfMostRecentlyUsedObject {
-  @synchronized(self) {
-    NIMemoryCacheInfo* info = [self.lruCacheObjects lastObject];
+- (void)reduceMemoryUsage {
+  // Remove all expired images first.
+  [super reduceMemoryUsage];
 
-    if ([info hasExpired]) {
-      [self removeObjectWithName:info.name];
-      return nil;
-    }
+  [self removeLeastRecentlyUsedImagesWhileOverPixelLimit:self.maxNumberOfPixelsUnderStress
+                                               byteLimit:self.maxNumberOfBytesUnderStress
+                                                  reason:NIMemoryCacheRemovalReasonStress];
+  [self finishRemovals];
+}
 
-    return info.name;
+- (void)reduceMemoryUsageForPressureLevel:(NIMemoryPressureLevel)level {
+  [super reduceMemoryUsageForPressureLevel:level];
+
+  if (NIMemoryPressureLevelWarning == level || NIMemoryPressureLevelBackground == level) {
+    {
+      NI_LOCK_SCOPE([self cacheLock]);
+      // Keep the most recently used half of the images rather than dropping all of them.
+      unsigned long long numberOfPixels = self.numberOfPixels;
+      unsigned long long numberOfBytes = self.numberOfBytes;
+      if (numberOfPixels > 1 || numberOfBytes > 1) {
+        [self removeLeastRecentlyUsedImagesWhileOverPixelLimit:MAX(numberOfPixels / 2, 1)
+                                                     byteLimit:MAX(numberOfBytes / 2, 1)
+                                                        reason:NIMemoryCacheRemovalReasonStress];
+      }
+    }
+    [self finishRemovals];
   }
 }
 
-- (void)removeObjectWithName:(NSString *)name {
-  @synchronized(self) {
-    [self removeCacheInfoForName:name];
+#pragma mark - Purgeable Memory
+
+- (void)setStoresImagesInPurgeableMemory:(BOOL)storesImagesInPurgeableMemory {
+  _storesImagesInPurgeableMemory = storesImagesInPurgeableMemory;
+  for (NIImageMemoryCache* segment in self.segments) {
+    segment.storesImagesInPurgeableMemory = storesImagesInPurgeableMemory;
   }
 }
 
-- (void)removeAllObjectsWithPrefix:(NSString *)prefix {
-  @synchronized(self) {
-    // Assertions fire if you try to modify the object you're iterating over, so we make a copy.
-    for (NSString* name in [self.cacheMap copy]) {
-      if ([name hasPrefix:prefix]) {
-        [self removeObjectWithName:name];
-      }
-    }
+// Nothing but the cache retains a purgeable bitmap, so a weak reference to one would be cleared
+// at once. The views that show it hold their own images instead. Evicted bitmaps therefore skip
+// the weak tier and are encoded from the image they draw, unless they have been purged.
+- (void)demoteCacheInfo:(NIMemoryCacheInfo *)info {
+  if (![info.object isKindOfClass:[NIPurgeableBitmap class]]) {
+    [super demoteCacheInfo:info];
+    return;
   }
+  [self encodeCacheInfo:info];
 }
 
-- (void)removeAllObjects {
-  @synchronized(self) {
-    [self.cacheMap removeAllObjects];
-    [self.lruCacheObjects removeAllObjects];
+- (id)objectToEncodeForObject:(id)object {
+  if ([object isKindOfClass:[NIPurgeableBitmap class]]) {
+    // Nil if the bitmap has been purged, which skips the encoded tier.
+    return [(NIPurgeableBitmap *)object image];
   }
+  return object;
 }
 
-- (void)reduceMemoryUsage {
-  @synchronized(self) {
-    // Assertions fire if you try to modify the object you're iterating over, so we make a copy.
-    for (id name in [self.cacheMap copy]) {
-      NIMemoryCacheInfo* info = [self cacheInfoForName:name];
+// Copies the image into purgeable memory if the cache keeps its images there.
+- (id)objectToStoreForImage:(id)image {
+  if (!_storesImagesInPurgeableMemory || ![image isKindOfClass:[UIImage class]]) {
+    return image;
+  }
+  NIPurgeableBitmap* bitmap = [NIPurgeableBitmap bitmapWithImage:image];
+  return (nil != bitmap) ? bitmap : image;
+}
 
-      if ([info hasExpired]) {
+// Returns the image to hand out for a stored object. Bitmaps that the system purged are
+// removed, which makes the lookup a miss that the caller fills from a lower tier such as disk.
+- (UIImage *)imageFromStoredObject:(id)object withName:(NSString *)name {
+  if (![object isKindOfClass:[NIPurgeableBitmap class]]) {
+    return object;
+  }
+  UIImage* image = [(NIPurgeableBitmap *)object image];
+  if (nil == image) {
+    {
+      NI_LOCK_SCOPE([self cacheLock]);
+      // The entry may have been replaced since it was read.
+      if ([self cacheInfoForName:name].object == object) {
         [self removeCacheInfoForName:name];
       }
     }
+    [self finishRemovals];
   }
+  return image;
 }
 
-- (NSUInteger)count {
-  @synchronized(self) {
-    return self.cacheMap.count;
+- (void)storeObject:(id)object withName:(NSString *)name expiresAfter:(NSDate *)expirationDate cost:(unsigned long long)cost {
+  // Segments make the copy, so that it happens once and outside of the top-level cache.
+  if (nil == self.segments) {
+    object = [self objectToStoreForImage:object];
   }
+  [super storeObject:object withName:name expiresAfter:expirationDate cost:cost];
 }
 
-@end
-
-@implementation NIMemoryCacheInfo
-
-- (BOOL)hasExpired {
-  return (nil != _expirationDate
-          && [[NSDate date] timeIntervalSinceDate:_expirationDate] >= 0);
+- (void)storeObjects:(NSArray *)objects withNames:(NSArray *)names expiresAfter:(NSDate *)expirationDate {
+  if (nil == self.segments && _storesImagesInPurgeableMemory) {
+    NSMutableArray* objectsToStore = [NSMutableArray arrayWithCapacity:objects.count];
+    for (id object in objects) {
+      [objectsToStore addObject:[self objectToStoreForImage:object]];
+    }
+    objects = objectsToStore;
+  }
+  [super storeObjects:objects withNames:names expiresAfter:expirationDate];
 }
 
-- (NSString *)description {
-  return [NSString stringWithFormat:
-          @"<%@"
-          @" name: %@"
-          @" object: %@"
-          @" expiration date: %@"
-          @" last access time: %@"
-          @">",
-          [super description],
-          self.name,
-          self.object,
-          self.expirationDate,
-          self.lastAccessTime];
+- (id)objectWithName:(NSString *)name {
+  return [self imageFromStoredObject:[super objectWithName:name] withName:name];
 }
 
-@end
-
-@interface NIImageMemoryCache()
-@property (nonatomic, assign) unsigned long long numberOfPixels;
-@end
+- (NSDictionary *)objectsWithNames:(NSArray *)names {
+  NSDictionary* objects = [super objectsWithNames:names];
+  if (nil != self.segments) {
+    return objects;
+  }
+  NSMutableDictionary* images = [NSMutableDictionary dictionaryWithCapacity:objects.count];
+  [objects enumerateKeysAndObjectsUsingBlock:^(NSString* name, id object, BOOL* stop) {
+    UIImage* image = [self imageFromStoredObject:object withName:name];
+    if (nil != image) {
+      images[name] = image;
+    }
+  }];
+  return images;
+}
 
-@implementation NIImageMemoryCache
+#pragma mark - Variants
 
-- (unsigned long long)numberOfPixelsUsedByImage:(UIImage *)image {
-  @synchronized(self) {
-    if (nil == image) {
-      return 0;
+- (void)addVariantWithName:(NSString *)name size:(CGSize)size toGroup:(NSString *)group {
+  NIDASSERT(nil != name && nil != group);
+  if (nil == name || nil == group || size.width <= 0 || size.height <= 0) {
+    return;
+  }
+  {
+    NI_LOCK_SCOPE(&_variantGroupsLock);
+    NSMutableDictionary* variants = [_variantGroups objectForKey:group];
+    if (nil == variants) {
+      variants = [NSMutableDictionary dictionary];
+      [_variantGroups setObject:variants forKey:group];
     }
-
-    return (unsigned long long)(image.size.width * image.size.height * [image scale] * [image scale]);
+    variants[name] = [NSValue valueWithCGSize:size];
   }
 }
 
-- (void)removeAllObjects {
-  @synchronized(self) {
-    [super removeAllObjects];
+- (NSString *)nameOfSmallestVariantInGroup:(NSString *)group coveringSize:(CGSize)size {
+  if (nil == group || size.width <= 0 || size.height <= 0) {
+    return nil;
+  }
+  NSDictionary* variants = nil;
+  {
+    NI_LOCK_SCOPE(&_variantGroupsLock);
+    variants = [[_variantGroups objectForKey:group] copy];
+  }
 
-    self.numberOfPixels = 0;
+  NSString* bestName = nil;
+  CGFloat bestArea = 0;
+  NSMutableArray* evictedNames = nil;
+  for (NSString* name in variants) {
+    CGSize variantSize = [variants[name] CGSizeValue];
+    if (variantSize.width < size.width || variantSize.height < size.height) {
+      continue;
+    }
+    // Cross-multiplying compares the aspect ratios without dividing.
+    CGFloat aspectRatioDifference = variantSize.width * size.height - variantSize.height * size.width;
+    if (ABS(aspectRatioDifference)
+        > kNIImageMemoryCacheVariantAspectRatioTolerance * variantSize.width * size.height) {
+      continue;
+    }
+    CGFloat area = variantSize.width * variantSize.height;
+    if (nil != bestName && area >= bestArea) {
+      continue;
+    }
+    if (![self containsObjectWithName:name]) {
+      if (nil == evictedNames) {
+        evictedNames = [NSMutableArray array];
+      }
+      [evictedNames addObject:name];
+      continue;
+    }
+    bestName = name;
+    bestArea = area;
   }
-}
 
-- (void)reduceMemoryUsage {
-  @synchronized(self) {
-    // Remove all expired images first.
-    [super reduceMemoryUsage];
-
-    if (self.maxNumberOfPixelsUnderStress > 0) {
-      // Remove the least recently used images by iterating over the linked list.
-      while (self.numberOfPixels > self.maxNumberOfPixelsUnderStress) {
-        NIMemoryCacheInfo* info = [self.lruCacheObjects firstObject];
-        [self removeCacheInfoForName:info.name];
+  if (nil != evictedNames) {
+    {
+      NI_LOCK_SCOPE(&_variantGroupsLock);
+      NSMutableDictionary* currentVariants = [_variantGroups objectForKey:group];
+      [currentVariants removeObjectsForKeys:evictedNames];
+      if (0 == currentVariants.count) {
+        [_variantGroups removeObjectForKey:group];
       }
     }
   }
+  return bestName;
 }
 
+#pragma mark - Subclassing
+
 - (BOOL)shouldSetObject:(id)object withName:(NSString *)name previousObject:(id)previousObject {
-  @synchronized(self) {
-    NIDASSERT(nil == object || [object isKindOfClass:[UIImage class]]);
-    if (![object isKindOfClass:[UIImage class]]) {
+  {
+    NI_LOCK_SCOPE([self cacheLock]);
+    NIDASSERT(nil == object || NIImageMemoryCacheIsImage(object));
+    if (!NIImageMemoryCacheIsImage(object)) {
       return NO;
     }
 
     _numberOfPixels -= [self numberOfPixelsUsedByImage:previousObject];
     _numberOfPixels += [self numberOfPixelsUsedByImage:object];
 
+    // The entry being replaced is still in the cache at this point. The new entry's bytes are
+    // charged once it's been stored, in didSetObject:withName:.
+    [self unchargeBytesForInfo:[self cacheInfoForName:name]];
+
     return YES;
   }
 }
 
 - (void)didSetObject:(id)object withName:(NSString *)name {
-  @synchronized(self) {
+  {
+    NI_LOCK_SCOPE([self cacheLock]);
+    NIMemoryCacheInfo* info = [self cacheInfoForName:name];
+    info.numberOfChargedBytes = (info.cost > 0) ? info.cost : [self retainBytesUsedByImage:object];
+    _numberOfBytes += info.numberOfChargedBytes;
+
     // Reduce the cache size after the object has been set in case the cache size is smaller
     // than the object that's being added and we need to remove this object right away.
-    if (self.maxNumberOfPixels > 0) {
-      // Remove least recently used images until we satisfy our memory constraints.
-      while (self.numberOfPixels > self.maxNumberOfPixels) {
-        NIMemoryCacheInfo* info = [self.lruCacheObjects firstObject];
-        [self removeCacheInfoForName:info.name];
-      }
-    }
+    [self removeLeastRecentlyUsedImagesWhileOverPixelLimit:self.maxNumberOfPixels
+                                                 byteLimit:self.maxNumberOfBytes
+                                                    reason:NIMemoryCacheRemovalReasonCapacity];
   }
 }
 
 - (void)willRemoveObject:(id)object withName:(NSString *)name {
-  @synchronized(self) {
-    NIDASSERT(nil == object || [object isKindOfClass:[UIImage class]]);
-    if (nil == object || ![object isKindOfClass:[UIImage class]]) {
+  {
+    NI_LOCK_SCOPE([self cacheLock]);
+    NIDASSERT(nil == object || NIImageMemoryCacheIsImage(object));
+    if (nil == object || !NIImageMemoryCacheIsImage(object)) {
       return;
     }
 
@@ -450,4 +2543,3 @@
 }
 
 @end
-
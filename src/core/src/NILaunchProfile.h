@@ -0,0 +1,89 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+
+/**
+ * For measuring what Nimbus costs on the launch path.
+ *
+ * Nimbus components build their shared state the first time they're used rather than at load
+ * time. The launch profile records how long each of those first uses took and how long after
+ * the process started it happened, so that anything that lands before the first frame stands
+ * out.
+ *
+ * Profiling is off unless NILaunchProfileSetEnabled(YES) is called or the NI_LAUNCH_PROFILE
+ * environment variable is set, e.g. in the scheme's Run arguments. When it is off, measured
+ * blocks run with only the cost of a boolean check.
+ *
+ * Work that isn't needed to draw the first frame can be scheduled with
+ * NIScheduleDeferredInitialization, which runs it on the NIIdleScheduler once the app is idle,
+ * and is measured the same way.
+ *
+ * @ingroup NimbusCore
+ * @defgroup Launch-Profiling Launch Profiling
+ * @{
+ */
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Turns the launch profile on or off.
+ */
+void NILaunchProfileSetEnabled(BOOL enabled);
+
+/**
+ * Returns YES if the launch profile is recording.
+ */
+BOOL NILaunchProfileIsEnabled(void);
+
+/**
+ * Runs the block and, if profiling is enabled, records how long it took and logs it with NIDINFO.
+ *
+ * Each component is recorded the first time it is measured only, so this can wrap a lazy
+ * initializer that is also reached later on.
+ *
+ * @param component A name for the work, e.g. @"NICSSRuleset color table".
+ */
+void NIMeasureFirstUse(NSString* component, void (^block)(void));
+
+/**
+ * Runs the block once, on the main thread, when the main run loop is next idle.
+ *
+ * Use this for initialization that would otherwise happen on first use, so that it is usually
+ * done by the time it's needed. The block must tolerate having been preceded by the on-demand
+ * path, which still has to exist for uses that come before the run loop is idle.
+ *
+ * Must be called on the main thread.
+ */
+void NIScheduleDeferredInitialization(NSString* component, void (^block)(void));
+
+/**
+ * Returns the recorded first uses in the order they happened.
+ *
+ * Each entry is a dictionary with the component name under @"component", its duration in
+ * seconds under @"duration" and its start, in seconds since the process was created, under
+ * @"timeSinceLaunch".
+ */
+NSArray* NILaunchProfileEntries(void);
+
+#if defined __cplusplus
+}
+#endif
+
+/**@}*/// End of Launch Profiling /////////////////////////////////////////////////////////////////
@@ -0,0 +1,115 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NILaunchProfile.h"
+
+#import "NIDebuggingTools.h"
+#import "NIIdleScheduler.h"
+#import <QuartzCore/QuartzCore.h>
+#import <stdatomic.h>
+#import <sys/sysctl.h>
+#import <unistd.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// -1 until the environment has been checked, then 0 or 1.
+static atomic_int sLaunchProfileEnabled = -1;
+
+// The entries also synchronize access to the set of measured components.
+static NSMutableArray* sEntries = nil;
+static NSMutableSet* sMeasuredComponents = nil;
+
+static NSMutableArray* NILaunchProfileMutableEntries(void) {
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sEntries = [[NSMutableArray alloc] init];
+    sMeasuredComponents = [[NSMutableSet alloc] init];
+  });
+  return sEntries;
+}
+
+void NILaunchProfileSetEnabled(BOOL enabled) {
+  atomic_store(&sLaunchProfileEnabled, enabled ? 1 : 0);
+}
+
+BOOL NILaunchProfileIsEnabled(void) {
+  int enabled = atomic_load_explicit(&sLaunchProfileEnabled, memory_order_relaxed);
+  if (enabled < 0) {
+    enabled = (NULL != getenv("NI_LAUNCH_PROFILE")) ? 1 : 0;
+    int expected = -1;
+    if (!atomic_compare_exchange_strong(&sLaunchProfileEnabled, &expected, enabled)) {
+      enabled = expected;
+    }
+  }
+  return enabled > 0;
+}
+
+// Returns the time since the process was created, in seconds.
+static NSTimeInterval NITimeSinceProcessStart(void) {
+  struct kinfo_proc process;
+  size_t size = sizeof(process);
+  int mib[] = { CTL_KERN, KERN_PROC, KERN_PROC_PID, getpid() };
+  if (0 != sysctl(mib, 4, &process, &size, NULL, 0)) {
+    return 0;
+  }
+  struct timeval startTime = process.kp_proc.p_starttime;
+  NSTimeInterval start = startTime.tv_sec + startTime.tv_usec / 1e6;
+  return [[NSDate date] timeIntervalSince1970] - start;
+}
+
+void NIMeasureFirstUse(NSString* component, void (^block)(void)) {
+  if (!NILaunchProfileIsEnabled()) {
+    block();
+    return;
+  }
+
+  NSTimeInterval timeSinceLaunch = NITimeSinceProcessStart();
+  CFTimeInterval startTime = CACurrentMediaTime();
+  block();
+  CFTimeInterval duration = CACurrentMediaTime() - startTime;
+
+  NSMutableArray* entries = NILaunchProfileMutableEntries();
+  @synchronized(entries) {
+    if ([sMeasuredComponents containsObject:component]) {
+      return;
+    }
+    [sMeasuredComponents addObject:component];
+    [entries addObject:@{@"component": component,
+                         @"duration": @(duration),
+                         @"timeSinceLaunch": @(timeSinceLaunch)}];
+  }
+  NIDINFO(@"%@: %.2f ms at %.0f ms%@", component, duration * 1000, timeSinceLaunch * 1000,
+          [NSThread isMainThread] ? @"" : @" (background)");
+}
+
+void NIScheduleDeferredInitialization(NSString* component, void (^block)(void)) {
+  NIDASSERT([NSThread isMainThread]);
+  void (^deferredBlock)(void) = [block copy];
+  [[NIIdleScheduler sharedScheduler] scheduleTaskWithPriority:NIIdleTaskPriorityLow block:^BOOL{
+    NIMeasureFirstUse(component, deferredBlock);
+    return NO;
+  }];
+}
+
+NSArray* NILaunchProfileEntries(void) {
+  NSMutableArray* entries = NILaunchProfileMutableEntries();
+  @synchronized(entries) {
+    return [entries copy];
+  }
+}
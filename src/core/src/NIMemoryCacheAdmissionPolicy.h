@@ -0,0 +1,160 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+@class NIMemoryCacheStatistics;
+
+/**
+ * For deciding which objects are worth keeping in an NIMemoryCache.
+ *
+ * Without an admission policy the cache evicts its least recently used object whenever it
+ * is over its limits. Least recently used eviction copes badly with scans: flinging once
+ * through a long feed of images pushes every frequently used image out of the cache, even
+ * though none of the images in the feed will be seen again.
+ *
+ * An admission policy remembers how often names have been accessed. When the cache is over
+ * its limits, the oldest object in a small window of recently stored objects competes with the
+ * least recently used object, and the policy picks which of the two is evicted. Objects that are
+ * accessed often win these competitions, so a scan only ever displaces the window.
+ *
+ * @ingroup In-Memory-Caches
+ * @{
+ */
+
+/**
+ * The interface an NIMemoryCache uses to ask for admission decisions.
+ *
+ * The cache calls the policy while it is locked. Policies shared by several caches, or by the
+ * segments of a segmented cache, must be thread-safe.
+ */
+@protocol NIMemoryCacheAdmissionPolicy <NSObject>
+
+@required
+
+/**
+ * The name was looked up or stored. Called for misses as well as hits.
+ */
+- (void)recordAccessOfName:(NSString *)name;
+
+/**
+ * Returns YES if the candidate should be kept and the victim evicted, NO if the candidate
+ * should be evicted instead.
+ *
+ * @param candidateName The oldest object in the window of recently stored objects.
+ * @param victimName    The least recently used object in the cache.
+ */
+- (BOOL)shouldAdmitName:(NSString *)candidateName evictingName:(NSString *)victimName;
+
+/**
+ * The fraction of the cache's objects, counted from the most recently used end, that are in
+ * the window and never compete for admission.
+ */
+- (double)windowFraction;
+
+@end
+
+/**
+ * The W-TinyLFU admission policy.
+ *
+ * Access frequencies are estimated with a count-min sketch of four rows of saturating 4-bit
+ * counters, so the policy uses a few bytes per expected object no matter how many distinct
+ * names it sees. Every counter is halved once the sketch has recorded ten times as many
+ * accesses as it has columns, which lets the policy forget names that used to be popular.
+ *
+ * A candidate is only admitted if it has been accessed more often than the victim.
+ */
+@interface NITinyLFUAdmissionPolicy : NSObject <NIMemoryCacheAdmissionPolicy>
+
+// Designated initializer.
+- (id)initWithExpectedNumberOfObjects:(NSUInteger)expectedNumberOfObjects;
+
+@property (nonatomic) double windowFraction; // Default: 0.01
+
+- (NSUInteger)estimatedFrequencyOfName:(NSString *)name;
+
+@end
+
+/**
+ * Replays recorded traces of cache lookups to compare admission policies.
+ *
+ * A trace is a list of names in the order they were looked up. Every lookup that misses stores
+ * the name, so the statistics of the replay show how well the cache would have done with a
+ * given policy.
+ */
+@interface NIMemoryCacheTraceReplay : NSObject
+
++ (NSArray *)traceWithContentsOfFile:(NSString *)path;
+
++ (NIMemoryCacheStatistics *)statisticsForReplayingTrace:(NSArray *)trace
+                                       numberOfObjects:(NSUInteger)numberOfObjects
+                                       admissionPolicy:(id<NIMemoryCacheAdmissionPolicy>)admissionPolicy;
+
+@end
+
+/**@}*/
+
+/** @name Creating a TinyLFU Policy */
+
+/**
+ * Initializes a newly allocated policy sized for a cache that holds around the given number of
+ * objects.
+ *
+ * The sketch gets one column per expected object, rounded up to a power of two.
+ *
+ * @fn NITinyLFUAdmissionPolicy::initWithExpectedNumberOfObjects:
+ */
+
+/**
+ * The fraction of the cache's objects that are admitted without competing.
+ *
+ * A larger window helps workloads where objects are accessed in short bursts. The W-TinyLFU
+ * paper found 1% to work well for most workloads.
+ *
+ * @fn NITinyLFUAdmissionPolicy::windowFraction
+ */
+
+/**
+ * Returns the estimated number of recent accesses of the given name.
+ *
+ * The estimate is never lower than the true count since the last aging, and saturates at 15.
+ *
+ * @fn NITinyLFUAdmissionPolicy::estimatedFrequencyOfName:
+ */
+
+/** @name Replaying Traces */
+
+/**
+ * Reads a trace from a text file with one name per line.
+ *
+ * Empty lines are skipped.
+ *
+ * @returns The names in the file, or nil if the file couldn't be read.
+ * @fn NIMemoryCacheTraceReplay::traceWithContentsOfFile:
+ */
+
+/**
+ * Replays the trace against a fresh cache that holds at most the given number of objects.
+ *
+ * Compare the hitRate of a replay with an admission policy against a replay with a nil policy,
+ * which is plain least recently used eviction.
+ *
+ * @param trace           The names in the order they were looked up.
+ * @param numberOfObjects The most objects the cache may hold.
+ * @param admissionPolicy The policy to replay with, or nil for least recently used eviction.
+ * @returns The statistics of the cache after the replay.
+ * @fn NIMemoryCacheTraceReplay::statisticsForReplayingTrace:numberOfObjects:admissionPolicy:
+ */
@@ -0,0 +1,158 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NIMemoryCacheAdmissionPolicy.h"
+
+#import "NIDebuggingTools.h"
+#import "NIFoundationMethods.h"
+#import "NIInMemoryCache.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+static const NSUInteger kNITinyLFUDepth = 4;
+static const uint8_t kNITinyLFUMaxCount = 15;
+
+@implementation NITinyLFUAdmissionPolicy {
+  uint8_t* _counters;
+  NSUInteger _width;
+  NSUInteger _numberOfAdditions;
+  NSUInteger _sampleSize;
+}
+
+- (void)dealloc {
+  free(_counters);
+}
+
+- (id)init {
+  return [self initWithExpectedNumberOfObjects:1024];
+}
+
+- (id)initWithExpectedNumberOfObjects:(NSUInteger)expectedNumberOfObjects {
+  if ((self = [super init])) {
+    _width = 16;
+    while (_width < expectedNumberOfObjects) {
+      _width <<= 1;
+    }
+    _counters = calloc(kNITinyLFUDepth * _width, sizeof(uint8_t));
+    _sampleSize = 10 * _width;
+    _windowFraction = 0.01;
+  }
+  return self;
+}
+
+// Derives one column per row from two halves of the hash.
+- (NSUInteger)indexOfCounterForHash:(uint64_t)hash row:(NSUInteger)row {
+  uint64_t h1 = hash;
+  uint64_t h2 = (hash >> 32) | 1;
+  return row * _width + (NSUInteger)((h1 + row * h2) & (_width - 1));
+}
+
+- (NSUInteger)frequencyForHash:(uint64_t)hash {
+  NSUInteger frequency = kNITinyLFUMaxCount;
+  for (NSUInteger row = 0; row < kNITinyLFUDepth; ++row) {
+    frequency = MIN(frequency, _counters[[self indexOfCounterForHash:hash row:row]]);
+  }
+  return frequency;
+}
+
+- (void)age {
+  for (NSUInteger ix = 0; ix < kNITinyLFUDepth * _width; ++ix) {
+    _counters[ix] >>= 1;
+  }
+  _numberOfAdditions /= 2;
+}
+
+- (NSUInteger)estimatedFrequencyOfName:(NSString *)name {
+  uint64_t hash = NIFNVHashFromString(name);
+  @synchronized(self) {
+    return [self frequencyForHash:hash];
+  }
+}
+
+#pragma mark - NIMemoryCacheAdmissionPolicy
+
+- (void)recordAccessOfName:(NSString *)name {
+  if (nil == name) {
+    return;
+  }
+  uint64_t hash = NIFNVHashFromString(name);
+  @synchronized(self) {
+    BOOL didIncrement = NO;
+    for (NSUInteger row = 0; row < kNITinyLFUDepth; ++row) {
+      NSUInteger index = [self indexOfCounterForHash:hash row:row];
+      if (_counters[index] < kNITinyLFUMaxCount) {
+        ++_counters[index];
+        didIncrement = YES;
+      }
+    }
+    // Saturated names don't move the sample forward, otherwise a single hot name would age
+    // the sketch on its own.
+    if (didIncrement && ++_numberOfAdditions >= _sampleSize) {
+      [self age];
+    }
+  }
+}
+
+- (BOOL)shouldAdmitName:(NSString *)candidateName evictingName:(NSString *)victimName {
+  uint64_t candidateHash = NIFNVHashFromString(candidateName);
+  uint64_t victimHash = NIFNVHashFromString(victimName);
+  @synchronized(self) {
+    return [self frequencyForHash:candidateHash] > [self frequencyForHash:victimHash];
+  }
+}
+
+@end
+
+@implementation NIMemoryCacheTraceReplay
+
++ (NSArray *)traceWithContentsOfFile:(NSString *)path {
+  NSError* error = nil;
+  NSString* contents = [NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:&error];
+  if (nil == contents) {
+    NIDERROR(@"Failed to read the trace at %@: %@", path, error);
+    return nil;
+  }
+  NSMutableArray* trace = [NSMutableArray array];
+  [contents enumerateLinesUsingBlock:^(NSString* line, BOOL* stop) {
+    if (line.length > 0) {
+      [trace addObject:line];
+    }
+  }];
+  return trace;
+}
+
++ (NIMemoryCacheStatistics *)statisticsForReplayingTrace:(NSArray *)trace
+                                       numberOfObjects:(NSUInteger)numberOfObjects
+                                       admissionPolicy:(id<NIMemoryCacheAdmissionPolicy>)admissionPolicy {
+  NIDASSERT(numberOfObjects > 0);
+  NIMemoryCache* cache = [[NIMemoryCache alloc] initWithCapacity:numberOfObjects];
+  cache.admissionPolicy = admissionPolicy;
+
+  // Each object costs one byte so that the byte count of the cache is its object count.
+  for (NSString* name in trace) {
+    if (nil == [cache objectWithName:name]) {
+      [cache storeObject:name withName:name cost:1];
+      if ([cache count] > numberOfObjects) {
+        [cache reduceMemoryUsageByNumberOfBytes:[cache count] - numberOfObjects];
+      }
+    }
+  }
+  return [cache statistics];
+}
+
+@end
@@ -0,0 +1,135 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "NIPreprocessorMacros.h"
+
+/**
+ * For responding to memory pressure in proportion to how bad it is.
+ *
+ * The system tells apps about memory pressure in a few different ways. NIMemoryPressureCoordinator
+ * listens to all of them and turns them into a single notification with a level.
+ *
+ * - A memory pressure dispatch source reports warning and critical levels as the system runs
+ *   low on memory and again when it recovers.
+ * - UIApplicationDidReceiveMemoryWarningNotification is treated as critical. The system sends
+ *   it for the same pressure as the dispatch source's critical level, so whichever arrives
+ *   second is not posted again.
+ * - Entering the background is reported as its own level so that caches can give back part of
+ *   their memory before the app is suspended and becomes a candidate for termination.
+ *
+ * Observers should trim in proportion to the level. A cache might drop to half of its size on
+ * a warning and down to its stress limit when the pressure is critical, keeping the most recently
+ * used objects around instead of throwing everything away.
+ *
+ * @ingroup NimbusCore
+ * @defgroup Memory-Pressure Memory Pressure
+ * @{
+ */
+
+/** The severity of the memory pressure. */
+typedef enum {
+  /** The system has recovered from memory pressure. */
+  NIMemoryPressureLevelNormal = 0,
+  /** The app is going into the background and should give back part of its memory. */
+  NIMemoryPressureLevelBackground,
+  /** The system is running low on memory. */
+  NIMemoryPressureLevelWarning,
+  /** The system is about to start terminating apps. */
+  NIMemoryPressureLevelCritical,
+} NIMemoryPressureLevel;
+
+/**
+ * Posted on the main thread when the memory pressure changes.
+ *
+ * The userInfo contains the new level as an NSNumber for NIMemoryPressureLevelKey.
+ */
+extern NSString* const NIMemoryPressureNotification;
+
+/** The key for the NIMemoryPressureLevel of an NIMemoryPressureNotification. */
+extern NSString* const NIMemoryPressureLevelKey;
+
+/**
+ * Returns the level of the given NIMemoryPressureNotification.
+ */
+NIMemoryPressureLevel NIMemoryPressureLevelFromNotification(NSNotification* notification);
+
+/**
+ * The process-wide source of NIMemoryPressureNotification notifications.
+ */
+@interface NIMemoryPressureCoordinator : NSObject
+
++ (NIMemoryPressureCoordinator *)sharedCoordinator;
+
+- (void)addObserver:(id)observer selector:(SEL)selector;
+- (void)removeObserver:(id)observer;
+
+@property (nonatomic, readonly) NIMemoryPressureLevel level;
+
+- (void)postMemoryPressureWithLevel:(NIMemoryPressureLevel)level;
+
+@end
+
+/**@}*/// End of Memory Pressure //////////////////////////////////////////////////////////////////
+
+/** @name Accessing the Coordinator */
+
+/**
+ * Returns the process-wide memory pressure coordinator.
+ *
+ * The coordinator starts listening to the system the first time it is accessed.
+ *
+ * @fn NIMemoryPressureCoordinator::sharedCoordinator
+ */
+
+/** @name Observing Memory Pressure */
+
+/**
+ * Registers the observer to receive NIMemoryPressureNotification notifications.
+ *
+ * The observer is registered with the default notification center, so removing the observer
+ * from the notification center also removes it from the coordinator. The selector is called
+ * with the notification on the main thread.
+ *
+ * @fn NIMemoryPressureCoordinator::addObserver:selector:
+ */
+
+/**
+ * Stops sending NIMemoryPressureNotification notifications to the observer.
+ *
+ * @fn NIMemoryPressureCoordinator::removeObserver:
+ */
+
+/**
+ * The most recently reported memory pressure level.
+ *
+ * Goes back to NIMemoryPressureLevelNormal once the system reports that it has recovered or the
+ * app returns to the foreground.
+ *
+ * @fn NIMemoryPressureCoordinator::level
+ */
+
+/** @name Simulating Memory Pressure */
+
+/**
+ * Posts an NIMemoryPressureNotification with the given level as though the system had
+ * reported it.
+ *
+ * Useful for testing how an app copes with memory pressure. Must be called on the main thread.
+ *
+ * @fn NIMemoryPressureCoordinator::postMemoryPressureWithLevel:
+ */
@@ -0,0 +1,169 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NIMemoryPressure.h"
+
+#import "NIDebuggingTools.h"
+
+#import <UIKit/UIKit.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// The memory pressure source and the memory warning report the same critical pressure within
+// this many seconds of each other.
+static const CFTimeInterval kSameCriticalPressureInterval = 1;
+
+NSString* const NIMemoryPressureNotification = @"NIMemoryPressureNotification";
+NSString* const NIMemoryPressureLevelKey = @"NIMemoryPressureLevelKey";
+
+NIMemoryPressureLevel NIMemoryPressureLevelFromNotification(NSNotification* notification) {
+  return (NIMemoryPressureLevel)[notification.userInfo[NIMemoryPressureLevelKey] intValue];
+}
+
+@interface NIMemoryPressureCoordinator()
+@property (nonatomic) NIMemoryPressureLevel level;
+@property (nonatomic, strong) dispatch_source_t memoryPressureSource;
+@end
+
+@implementation NIMemoryPressureCoordinator {
+  // When each system report of critical pressure was last posted.
+  CFAbsoluteTime _memoryPressureSourceCriticalTime;
+  CFAbsoluteTime _memoryWarningTime;
+}
+
+- (void)dealloc {
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
+
+  if (nil != _memoryPressureSource) {
+    dispatch_source_cancel(_memoryPressureSource);
+  }
+}
+
++ (NIMemoryPressureCoordinator *)sharedCoordinator {
+  static NIMemoryPressureCoordinator* sCoordinator = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sCoordinator = [[NIMemoryPressureCoordinator alloc] init];
+  });
+  return sCoordinator;
+}
+
+- (id)init {
+  if ((self = [super init])) {
+    NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
+    [nc addObserver:self
+           selector:@selector(didReceiveMemoryWarning:)
+               name:UIApplicationDidReceiveMemoryWarningNotification
+             object:nil];
+    [nc addObserver:self
+           selector:@selector(didEnterBackground:)
+               name:UIApplicationDidEnterBackgroundNotification
+             object:nil];
+    [nc addObserver:self
+           selector:@selector(willEnterForeground:)
+               name:UIApplicationWillEnterForegroundNotification
+             object:nil];
+
+#if defined(DISPATCH_SOURCE_TYPE_MEMORYPRESSURE)
+    // The memorypressure source type is only available on newer systems.
+    if (NULL != DISPATCH_SOURCE_TYPE_MEMORYPRESSURE) {
+      unsigned long mask = (DISPATCH_MEMORYPRESSURE_NORMAL
+                            | DISPATCH_MEMORYPRESSURE_WARN
+                            | DISPATCH_MEMORYPRESSURE_CRITICAL);
+      dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_MEMORYPRESSURE, 0, mask,
+                                                        dispatch_get_main_queue());
+      __weak NIMemoryPressureCoordinator* weakSelf = self;
+      dispatch_source_set_event_handler(source, ^{
+        unsigned long pressure = dispatch_source_get_data(source);
+        if (pressure & DISPATCH_MEMORYPRESSURE_CRITICAL) {
+          [weakSelf didReceiveCriticalMemoryPressure];
+
+        } else if (pressure & DISPATCH_MEMORYPRESSURE_WARN) {
+          [weakSelf postMemoryPressureWithLevel:NIMemoryPressureLevelWarning];
+
+        } else {
+          [weakSelf postMemoryPressureWithLevel:NIMemoryPressureLevelNormal];
+        }
+      });
+      dispatch_resume(source);
+      _memoryPressureSource = source;
+    }
+#endif
+  }
+  return self;
+}
+
+#pragma mark - Notifications
+
+- (void)didReceiveCriticalMemoryPressure {
+  CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+  if (now - _memoryWarningTime < kSameCriticalPressureInterval) {
+    return;
+  }
+  _memoryPressureSourceCriticalTime = now;
+  [self postMemoryPressureWithLevel:NIMemoryPressureLevelCritical];
+}
+
+- (void)didReceiveMemoryWarning:(NSNotification *)notification {
+  // The memory pressure source has usually reported the same pressure already.
+  CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+  if (now - _memoryPressureSourceCriticalTime < kSameCriticalPressureInterval) {
+    return;
+  }
+  _memoryWarningTime = now;
+
+  // Memory warnings have always meant purging caches down to their stress limits.
+  [self postMemoryPressureWithLevel:NIMemoryPressureLevelCritical];
+}
+
+- (void)didEnterBackground:(NSNotification *)notification {
+  [self postMemoryPressureWithLevel:NIMemoryPressureLevelBackground];
+}
+
+- (void)willEnterForeground:(NSNotification *)notification {
+  if (NIMemoryPressureLevelBackground == self.level) {
+    // There's nothing to trim when the pressure goes away, so the change isn't posted.
+    self.level = NIMemoryPressureLevelNormal;
+  }
+}
+
+#pragma mark - Public
+
+- (void)addObserver:(id)observer selector:(SEL)selector {
+  [[NSNotificationCenter defaultCenter] addObserver:observer
+                                           selector:selector
+                                               name:NIMemoryPressureNotification
+                                             object:self];
+}
+
+- (void)removeObserver:(id)observer {
+  [[NSNotificationCenter defaultCenter] removeObserver:observer
+                                                  name:NIMemoryPressureNotification
+                                                object:self];
+}
+
+- (void)postMemoryPressureWithLevel:(NIMemoryPressureLevel)level {
+  NIDASSERT([NSThread isMainThread]);
+
+  self.level = level;
+  [[NSNotificationCenter defaultCenter] postNotificationName:NIMemoryPressureNotification
+                                                      object:self
+                                                    userInfo:@{NIMemoryPressureLevelKey: @(level)}];
+}
+
+@end
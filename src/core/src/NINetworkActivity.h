@@ -32,6 +32,10 @@ extern "C" {
  * Two methods for keeping track of all active network tasks. These methods are threadsafe
  * and act as a simple counter. When the counter is positive, the network activity indicator
  * is displayed.
+ *
+ * The counter is atomic, so starting and finishing tasks never blocks. Changes to the indicator
+ * are coalesced and applied on the main thread at most once per display frame, so a burst of
+ * tasks costs one main-thread update rather than one per task.
  */
 
 /**
@@ -52,6 +56,92 @@ void NINetworkActivityTaskDidStart(void);
  */
 void NINetworkActivityTaskDidFinish(void);
 
+/**
+ * @name Task Metrics
+ * @{
+ *
+ * A lightweight telemetry surface for the network tasks that Nimbus starts.
+ *
+ * Each task keeps an NINetworkTaskMetrics by value while it runs. When the task finishes its
+ * metrics are copied into a fixed-size ring that is written without locks, so reporting is
+ * cheap enough to leave enabled in release builds. The Overview's network page reads the ring
+ * to graph throughput and per-host latency.
+ *
+ * @code
+ * NINetworkTaskMetrics metrics = NINetworkTaskMetricsDidStart(request.URL);
+ * ...
+ * NINetworkTaskMetricsDidReceiveBytes(&metrics, data.length);
+ * ...
+ * NINetworkTaskMetricsDidFinish(&metrics);
+ * @endcode
+ */
+
+/**
+ * The number of bytes reserved for a task's host name, including the terminating NUL.
+ */
+#define NI_NETWORK_TASK_HOST_LENGTH 64
+
+/**
+ * The timings and size of a single network task.
+ *
+ * Timestamps are CACurrentMediaTime() seconds.
+ */
+typedef struct {
+  CFTimeInterval startTimestamp;
+  CFTimeInterval timeToFirstByte; // Negative until the first byte is received.
+  CFTimeInterval duration;
+  unsigned long long numberOfBytes;
+  char host[NI_NETWORK_TASK_HOST_LENGTH];
+} NINetworkTaskMetrics;
+
+/**
+ * Returns new metrics for a task that is starting now.
+ *
+ * The task is counted by NINetworkTaskMetricsNumberOfActiveTasks until it finishes.
+ *
+ * This method is threadsafe.
+ */
+NINetworkTaskMetrics NINetworkTaskMetricsDidStart(NSURL* url);
+
+/**
+ * Adds received bytes to a task's metrics.
+ *
+ * The first call records the task's time to first byte.
+ */
+void NINetworkTaskMetricsDidReceiveBytes(NINetworkTaskMetrics* metrics,
+                                         unsigned long long numberOfBytes);
+
+/**
+ * Records a task's duration and adds its metrics to the ring of recently finished tasks.
+ *
+ * Every call to NINetworkTaskMetricsDidStart must be balanced by exactly one call to this
+ * method, whether the task succeeded, failed or was cancelled.
+ *
+ * This method is threadsafe and lock-free.
+ */
+void NINetworkTaskMetricsDidFinish(NINetworkTaskMetrics* metrics);
+
+/**
+ * Copies the metrics of recently finished tasks, oldest first.
+ *
+ * Tasks that are being recorded while the ring is copied are skipped.
+ *
+ * This method is threadsafe and lock-free.
+ *
+ *      @returns The number of metrics that were copied.
+ */
+NSUInteger NINetworkTaskMetricsCopyRecent(NINetworkTaskMetrics* metrics,
+                                          NSUInteger maximumNumberOfMetrics);
+
+/**
+ * Returns the number of tasks that have started but not yet finished.
+ *
+ * This method is threadsafe.
+ */
+NSInteger NINetworkTaskMetricsNumberOfActiveTasks(void);
+
+/**@}*/// End of Task Metrics
+
 /**
  * @name For Debugging Only
  * @{
@@ -70,9 +160,10 @@ void NINetworkActivityTaskDidFinish(void);
  * represent its state.
  *
  * When enabled, the networkActivityIndicatorVisible method on UIApplication will be swizzled
- * with a debugging method that checks the global network task count and verifies that state
- * is maintained correctly. If it is found that networkActivityIndicatorVisible is being accessed
- * directly, then an assertion will be fired.
+ * with a debugging method that verifies that Nimbus is the one changing the indicator. If it is
+ * found that networkActivityIndicatorVisible is being accessed directly, then an assertion will
+ * be fired. Unbalanced calls to NINetworkActivityTaskDidFinish fire an assertion whether or not
+ * debugging is enabled.
  *
  * If debugging was previously enabled, this does nothing.
  */
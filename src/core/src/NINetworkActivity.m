@@ -22,17 +22,31 @@
 #import "NIRuntimeClassModifications.h"
 #endif
 
-#import <pthread.h>
+#import <stdatomic.h>
+#import <QuartzCore/QuartzCore.h>
 #import <UIKit/UIKit.h>
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "Nimbus requires ARC support."
 #endif
 
-static int              gNetworkTaskCount = 0;
-static pthread_mutex_t  gMutex = PTHREAD_MUTEX_INITIALIZER;
+static atomic_int gNetworkTaskCount = 0;
+// Set while an indicator update is waiting to run on the main thread.
+static atomic_bool gIndicatorUpdateIsScheduled = false;
 static const NSTimeInterval kDelayBeforeDisablingActivity = 0.1;
+// Indicator updates are coalesced to at most one per display frame.
+static const NSTimeInterval kIndicatorUpdateInterval = 1.0 / 60.0;
+// Only accessed from the main thread.
 static NSTimer* gScheduledDelayTimer = nil;
+static BOOL gIsUpdatingIndicator = NO;
+
+// All changes to the indicator go through here so that debugging can tell them apart from
+// direct changes made by other code.
+static void NINetworkActivitySetIndicatorVisible(BOOL visible) {
+  gIsUpdatingIndicator = YES;
+  [UIApplication sharedApplication].networkActivityIndicatorVisible = visible;
+  gIsUpdatingIndicator = NO;
+}
 
 @interface NINetworkActivity : NSObject
 @end
@@ -45,59 +59,158 @@ static NSTimer* gScheduledDelayTimer = nil;
 // By delaying the turnoff of the network activity we avoid "flickering" effects when network
 // activity is starting and stopping rapidly.
 + (void)disableNetworkActivity {
-  pthread_mutex_lock(&gMutex);
-  if (nil != gScheduledDelayTimer) {
-    [UIApplication sharedApplication].networkActivityIndicatorVisible = NO;
+  gScheduledDelayTimer = nil;
+  if (0 == atomic_load_explicit(&gNetworkTaskCount, memory_order_relaxed)) {
+    NINetworkActivitySetIndicatorVisible(NO);
+  }
+}
+
+// Brings the indicator in line with the task count as of now, however many times the count
+// changed since the update was scheduled.
++ (void)updateNetworkActivityIndicator {
+  // Tasks that change the count after this point schedule another update. That takes a single
+  // total order over the flag and the count: with weaker orderings the load of the count could
+  // be satisfied before the store to the flag, and a task that saw the flag still set would not
+  // schedule the update that its change needs. Every access to either is therefore seq_cst.
+  atomic_store_explicit(&gIndicatorUpdateIsScheduled, false, memory_order_seq_cst);
+  int numberOfTasks = atomic_load_explicit(&gNetworkTaskCount, memory_order_seq_cst);
+
+  UIApplication* application = [UIApplication sharedApplication];
+  if (numberOfTasks > 0) {
+    [gScheduledDelayTimer invalidate];
     gScheduledDelayTimer = nil;
+    if (!application.networkActivityIndicatorVisible) {
+      NINetworkActivitySetIndicatorVisible(YES);
+    }
+
+  } else if (application.networkActivityIndicatorVisible && nil == gScheduledDelayTimer) {
+    gScheduledDelayTimer = [NSTimer scheduledTimerWithTimeInterval:kDelayBeforeDisablingActivity
+                                                            target:self
+                                                          selector:@selector(disableNetworkActivity)
+                                                          userInfo:nil
+                                                           repeats:NO];
   }
-  pthread_mutex_unlock(&gMutex);
 }
 
 @end
 
 
+static void NINetworkActivityScheduleIndicatorUpdate(void) {
+  if (atomic_exchange_explicit(&gIndicatorUpdateIsScheduled, true, memory_order_seq_cst)) {
+    return;
+  }
+  dispatch_time_t when = dispatch_time(DISPATCH_TIME_NOW,
+                                       (int64_t)(kIndicatorUpdateInterval * NSEC_PER_SEC));
+  dispatch_after(when, dispatch_get_main_queue(), ^{
+    [NINetworkActivity updateNetworkActivityIndicator];
+  });
+}
+
 void NINetworkActivityTaskDidStart(void) {
-  pthread_mutex_lock(&gMutex);
+  int previousNumberOfTasks = atomic_fetch_add_explicit(&gNetworkTaskCount, 1,
+                                                        memory_order_seq_cst);
+  // Only the transitions between idle and busy change the indicator.
+  if (0 == previousNumberOfTasks) {
+    NINetworkActivityScheduleIndicatorUpdate();
+  }
+}
 
-  BOOL enableNetworkActivityIndicator = (0 == gNetworkTaskCount);
+void NINetworkActivityTaskDidFinish(void) {
+  int previousNumberOfTasks = atomic_fetch_sub_explicit(&gNetworkTaskCount, 1,
+                                                        memory_order_seq_cst);
+  // If this asserts, you don't have enough stop requests to match your start requests.
+  NIDASSERT(previousNumberOfTasks > 0);
+  if (previousNumberOfTasks <= 0) {
+    // Undo the unbalanced decrement so that the count never goes negative.
+    atomic_fetch_add_explicit(&gNetworkTaskCount, 1, memory_order_seq_cst);
+    return;
+  }
 
-  ++gNetworkTaskCount;
-  [gScheduledDelayTimer invalidate];
-  gScheduledDelayTimer = nil;
+  if (1 == previousNumberOfTasks) {
+    NINetworkActivityScheduleIndicatorUpdate();
+  }
+}
+
+#pragma mark - Task Metrics
+
+// Must be a power of two so that slots can be found by masking.
+static const uint64_t kTaskMetricsCapacity = 256;
+
+// Each slot's sequence is odd while it is being written and 2 * (n + 1) once it holds the nth
+// finished task, so readers can detect torn or overwritten copies without taking a lock.
+typedef struct {
+  atomic_uint_fast64_t sequence;
+  NINetworkTaskMetrics metrics;
+} NINetworkTaskMetricsSlot;
 
-  if (enableNetworkActivityIndicator) {
-    [UIApplication sharedApplication].networkActivityIndicatorVisible = YES;
+static NINetworkTaskMetricsSlot gTaskMetricsSlots[kTaskMetricsCapacity];
+static atomic_uint_fast64_t gNumberOfFinishedTasks = 0;
+static atomic_long gNumberOfActiveTasks = 0;
+
+NINetworkTaskMetrics NINetworkTaskMetricsDidStart(NSURL* url) {
+  NINetworkTaskMetrics metrics;
+  memset(&metrics, 0, sizeof(metrics));
+  metrics.startTimestamp = CACurrentMediaTime();
+  metrics.timeToFirstByte = -1;
+
+  const char* host = [[url host] UTF8String];
+  if (NULL != host) {
+    strlcpy(metrics.host, host, sizeof(metrics.host));
   }
 
-  pthread_mutex_unlock(&gMutex);
+  atomic_fetch_add_explicit(&gNumberOfActiveTasks, 1, memory_order_relaxed);
+  return metrics;
 }
 
-void NINetworkActivityTaskDidFinish(void) {
-  pthread_mutex_lock(&gMutex);
+void NINetworkTaskMetricsDidReceiveBytes(NINetworkTaskMetrics* metrics,
+                                         unsigned long long numberOfBytes) {
+  if (metrics->timeToFirstByte < 0) {
+    metrics->timeToFirstByte = CACurrentMediaTime() - metrics->startTimestamp;
+  }
+  metrics->numberOfBytes += numberOfBytes;
+}
 
-  --gNetworkTaskCount;
-  // If this asserts, you don't have enough stop requests to match your start requests.
-  NIDASSERT(gNetworkTaskCount >= 0);
-  gNetworkTaskCount = MAX(0, gNetworkTaskCount);
+void NINetworkTaskMetricsDidFinish(NINetworkTaskMetrics* metrics) {
+  metrics->duration = CACurrentMediaTime() - metrics->startTimestamp;
 
-  if (gNetworkTaskCount == 0) {
-    [gScheduledDelayTimer invalidate];
-    gScheduledDelayTimer = nil;
+  long numberOfActiveTasks = atomic_fetch_sub_explicit(&gNumberOfActiveTasks, 1,
+                                                       memory_order_relaxed);
+  // If this asserts, you don't have enough finish calls to match your start calls.
+  NIDASSERT(numberOfActiveTasks > 0);
 
-    // Ensure that the timer is scheduled on the main loop, otherwise it will die when the thread
-    // dies.
-    dispatch_async(dispatch_get_main_queue(), ^{
-      pthread_mutex_lock(&gMutex);
-      gScheduledDelayTimer = [NSTimer scheduledTimerWithTimeInterval:kDelayBeforeDisablingActivity
-                                                              target:[NINetworkActivity class]
-                                                            selector:@selector(disableNetworkActivity)
-                                                            userInfo:nil
-                                                             repeats:NO];
-      pthread_mutex_unlock(&gMutex);
-    });
+  uint64_t index = atomic_fetch_add_explicit(&gNumberOfFinishedTasks, 1, memory_order_relaxed);
+  NINetworkTaskMetricsSlot* slot = &gTaskMetricsSlots[index & (kTaskMetricsCapacity - 1)];
+  atomic_store_explicit(&slot->sequence, 2 * index + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  slot->metrics = *metrics;
+  atomic_store_explicit(&slot->sequence, 2 * (index + 1), memory_order_release);
+}
+
+NSUInteger NINetworkTaskMetricsCopyRecent(NINetworkTaskMetrics* metrics,
+                                          NSUInteger maximumNumberOfMetrics) {
+  uint64_t end = atomic_load_explicit(&gNumberOfFinishedTasks, memory_order_acquire);
+  uint64_t count = MIN(MIN(end, kTaskMetricsCapacity), (uint64_t)maximumNumberOfMetrics);
+
+  NSUInteger numberOfCopiedMetrics = 0;
+  for (uint64_t index = end - count; index < end; ++index) {
+    NINetworkTaskMetricsSlot* slot = &gTaskMetricsSlots[index & (kTaskMetricsCapacity - 1)];
+    uint64_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (sequence != 2 * (index + 1)) {
+      // Still being written, or already overwritten by a newer task.
+      continue;
+    }
+    NINetworkTaskMetrics copy = slot->metrics;
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&slot->sequence, memory_order_relaxed) != sequence) {
+      continue;
+    }
+    metrics[numberOfCopiedMetrics++] = copy;
   }
+  return numberOfCopiedMetrics;
+}
 
-  pthread_mutex_unlock(&gMutex);
+NSInteger NINetworkTaskMetricsNumberOfActiveTasks(void) {
+  return MAX(0, atomic_load_explicit(&gNumberOfActiveTasks, memory_order_relaxed));
 }
 
 #pragma mark - Network Activity Debugging
@@ -121,16 +234,10 @@ void NISwizzleMethodsForNetworkActivityDebugging(void);
 
   // If either of the following assertions fail then you should look at the call stack to
   // determine what code is erroneously calling setNetworkActivityIndicatorVisible: directly.
-  if (visible) {
-    // The only time we should be enabling the network activity indicator is when the task
-    // count is one.
-    NIDASSERT(1 == gNetworkTaskCount);
-
-  } else {
-    // The only time we should be disabling the network activity indicator is when the task
-    // count is zero.
-    NIDASSERT(0 == gNetworkTaskCount);
-  }
+  // The task count is updated without a lock and the indicator is updated later on the main
+  // thread, so the count can't be compared against the indicator here. Instead, every change
+  // that Nimbus makes is flagged.
+  NIDASSERT(gIsUpdatingIndicator);
 }
 
 @end
@@ -62,4 +62,160 @@ NSMutableSet* NICreateNonRetainingMutableSet(void);
 };
 #endif
 
+/**
+ * Options for NIPointerSet and NIPointerMap.
+ */
+typedef enum {
+  NIPointerCollectionOptionNone       = 0,      // Keys are not retained.
+  NIPointerCollectionOptionRetainKeys = 1 << 0, // Keys are retained until they are removed.
+} NIPointerCollectionOptions;
+
+/**
+ * A set that compares its objects by pointer identity.
+ *
+ * Lookups never send hash or isEqual: to the objects; the pointer itself is hashed into an
+ * open-addressed table with linear probing. Sets of up to six objects are stored inline in the
+ * set itself without allocating a table.
+ *
+ * Unless created with NIPointerCollectionOptionRetainKeys, the set does not retain its objects
+ * and the same caveats as the other non-retaining collections apply.
+ */
+@interface NIPointerSet : NSObject <NSFastEnumeration>
+
+// Designated initializer.
+- (id)initWithOptions:(NIPointerCollectionOptions)options;
+
+- (NSUInteger)count;
+- (BOOL)containsObject:(id)object;
+- (NSArray *)allObjects;
+
+- (void)addObject:(id)object;
+- (void)removeObject:(id)object;
+- (void)removeAllObjects;
+
+@end
+
+/**
+ * A map from objects, compared by pointer identity, to strongly held objects.
+ *
+ * Keys are hashed by pointer like NIPointerSet. Fast enumeration visits the keys.
+ */
+@interface NIPointerMap : NSObject <NSFastEnumeration>
+
+// Designated initializer.
+- (id)initWithOptions:(NIPointerCollectionOptions)options;
+
+- (NSUInteger)count;
+- (id)objectForKey:(id)key;
+
+- (void)setObject:(id)object forKey:(id)key;
+- (void)removeObjectForKey:(id)key;
+- (void)removeAllObjects;
+
+@end
+
+/** @name Creating a Pointer Set */
+
+/**
+ * Initializes a newly allocated, empty set.
+ *
+ * @fn NIPointerSet::initWithOptions:
+ */
+
+/** @name Querying a Pointer Set */
+
+/**
+ * Returns the number of objects in the set.
+ *
+ * @fn NIPointerSet::count
+ */
+
+/**
+ * Returns YES if this exact object is in the set.
+ *
+ *      Run-time: O(1) expected
+ *
+ * @fn NIPointerSet::containsObject:
+ */
+
+/**
+ * Returns the objects in the set in no particular order.
+ *
+ * @fn NIPointerSet::allObjects
+ */
+
+/** @name Modifying a Pointer Set */
+
+/**
+ * Adds the object to the set if it isn't already in it.
+ *
+ *      Run-time: O(1) amortized
+ *
+ * @fn NIPointerSet::addObject:
+ */
+
+/**
+ * Removes the object from the set if it is in it.
+ *
+ *      Run-time: O(1) expected
+ *
+ * @fn NIPointerSet::removeObject:
+ */
+
+/**
+ * Removes every object from the set and returns it to its inline storage.
+ *
+ * @fn NIPointerSet::removeAllObjects
+ */
+
+/** @name Creating a Pointer Map */
+
+/**
+ * Initializes a newly allocated, empty map.
+ *
+ * @fn NIPointerMap::initWithOptions:
+ */
+
+/** @name Querying a Pointer Map */
+
+/**
+ * Returns the number of keys in the map.
+ *
+ * @fn NIPointerMap::count
+ */
+
+/**
+ * Returns the object for this exact key, or nil if the key isn't in the map.
+ *
+ *      Run-time: O(1) expected
+ *
+ * @fn NIPointerMap::objectForKey:
+ */
+
+/** @name Modifying a Pointer Map */
+
+/**
+ * Sets the object for the key, replacing any object already set for it.
+ *
+ * Setting a nil object removes the key.
+ *
+ *      Run-time: O(1) amortized
+ *
+ * @fn NIPointerMap::setObject:forKey:
+ */
+
+/**
+ * Removes the key and its object from the map if the key is in it.
+ *
+ *      Run-time: O(1) expected
+ *
+ * @fn NIPointerMap::removeObjectForKey:
+ */
+
+/**
+ * Removes every key and object from the map and returns it to its inline storage.
+ *
+ * @fn NIPointerMap::removeAllObjects
+ */
+
 /**@}*/// End of Non-Retaining Collections ////////////////////////////////////////////////////////
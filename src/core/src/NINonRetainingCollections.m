@@ -18,6 +18,8 @@
 
 #import "NINonRetainingCollections.h"
 
+#import "NIDebuggingTools.h"
+
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "Nimbus requires ARC support."
 #endif
@@ -34,3 +36,361 @@ NSMutableSet* NICreateNonRetainingMutableSet(void) {
   return (__bridge_transfer NSMutableSet *)CFSetCreateMutable(nil, 0, nil);
 }
 
+
+#pragma mark - Pointer Tables
+
+// An open-addressed hash table of pointers shared by NIPointerSet and NIPointerMap.
+//
+// The capacity is always a power of two. Keys are spread over the table by multiplying the
+// pointer by a large odd constant and taking the top bits, which mixes the low bits that are
+// always zero in object pointers. NULL marks an empty slot. Removals shift the following keys
+// back into the gap, so the table never needs tombstones.
+static const NSUInteger kNIPointerTableInlineCapacity = 8;
+
+typedef struct {
+  void** keys;
+  void** values;  // NULL for sets.
+  void** inlineKeys;
+  void** inlineValues;
+  NSUInteger capacity;
+  NSUInteger count;
+  unsigned int shift;
+} NIPointerTable;
+
+static void NIPointerTableInit(NIPointerTable* table, void** inlineKeys, void** inlineValues) {
+  table->inlineKeys = inlineKeys;
+  table->inlineValues = inlineValues;
+  table->keys = inlineKeys;
+  table->values = inlineValues;
+  table->capacity = kNIPointerTableInlineCapacity;
+  table->count = 0;
+  table->shift = 64 - 3; // log2(kNIPointerTableInlineCapacity) bits of the product.
+  memset(table->keys, 0, sizeof(void *) * table->capacity);
+  if (NULL != table->values) {
+    memset(table->values, 0, sizeof(void *) * table->capacity);
+  }
+}
+
+static void NIPointerTableFreeStorage(NIPointerTable* table) {
+  if (table->keys != table->inlineKeys) {
+    free(table->keys);
+    free(table->values);
+  }
+}
+
+static inline NSUInteger NIPointerTableIdealSlot(const NIPointerTable* table, const void* key) {
+  return (NSUInteger)(((uint64_t)(uintptr_t)key * 0x9E3779B97F4A7C15ULL) >> table->shift);
+}
+
+// Returns the slot holding the key, or the empty slot where it would go.
+static inline NSUInteger NIPointerTableSlot(const NIPointerTable* table, const void* key) {
+  const NSUInteger mask = table->capacity - 1;
+  NSUInteger slot = NIPointerTableIdealSlot(table, key);
+  while (NULL != table->keys[slot] && table->keys[slot] != key) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+static BOOL NIPointerTableGrow(NIPointerTable* table) {
+  NSUInteger capacity = table->capacity * 2;
+  void** keys = calloc(capacity, sizeof(void *));
+  void** values = (NULL != table->values) ? calloc(capacity, sizeof(void *)) : NULL;
+  NIDASSERT(NULL != keys && (NULL == table->values || NULL != values));
+  if (NULL == keys || (NULL != table->values && NULL == values)) {
+    free(keys); // COV_NF_START
+    free(values);
+    return NO; // COV_NF_END
+  }
+
+  NIPointerTable grown = *table;
+  grown.keys = keys;
+  grown.values = values;
+  grown.capacity = capacity;
+  grown.shift = table->shift - 1;
+  for (NSUInteger ix = 0; ix < table->capacity; ++ix) {
+    if (NULL != table->keys[ix]) {
+      NSUInteger slot = NIPointerTableSlot(&grown, table->keys[ix]);
+      grown.keys[slot] = table->keys[ix];
+      if (NULL != values) {
+        grown.values[slot] = table->values[ix];
+      }
+    }
+  }
+  NIPointerTableFreeStorage(table);
+  *table = grown;
+  return YES;
+}
+
+// Returns the slot for the key, claiming an empty one for it if needed. *pIsNew is set to YES
+// when the key was not already in the table.
+static NSUInteger NIPointerTableInsert(NIPointerTable* table, void* key, BOOL* pIsNew) {
+  NSUInteger slot = NIPointerTableSlot(table, key);
+  *pIsNew = (NULL == table->keys[slot]);
+  if (!*pIsNew) {
+    return slot;
+  }
+
+  // Keep the load under 3/4 so that probe sequences stay short.
+  if ((table->count + 1) * 4 > table->capacity * 3) {
+    if (!NIPointerTableGrow(table)) {
+      *pIsNew = NO; // COV_NF_LINE
+      return NSNotFound; // COV_NF_LINE
+    }
+    slot = NIPointerTableSlot(table, key);
+  }
+  table->keys[slot] = key;
+  ++table->count;
+  return slot;
+}
+
+static void NIPointerTableRemoveSlot(NIPointerTable* table, NSUInteger slot) {
+  const NSUInteger mask = table->capacity - 1;
+  NSUInteger gap = slot;
+  NSUInteger next = (gap + 1) & mask;
+  while (NULL != table->keys[next]) {
+    // A key may fill the gap if the gap lies between its ideal slot and where it sits now.
+    NSUInteger ideal = NIPointerTableIdealSlot(table, table->keys[next]);
+    if (((next - ideal) & mask) >= ((next - gap) & mask)) {
+      table->keys[gap] = table->keys[next];
+      if (NULL != table->values) {
+        table->values[gap] = table->values[next];
+      }
+      gap = next;
+    }
+    next = (next + 1) & mask;
+  }
+  table->keys[gap] = NULL;
+  if (NULL != table->values) {
+    table->values[gap] = NULL;
+  }
+  --table->count;
+}
+
+// Copies up to len keys starting from the slot in state->extra[0].
+static NSUInteger NIPointerTableEnumerate(const NIPointerTable* table,
+                                          NSFastEnumerationState* state,
+                                          __unsafe_unretained id* stackbuf,
+                                          NSUInteger len) {
+  NSUInteger slot = state->extra[0];
+  NSUInteger numberOfItemsReturned = 0;
+  while (slot < table->capacity && numberOfItemsReturned < len) {
+    if (NULL != table->keys[slot]) {
+      stackbuf[numberOfItemsReturned++] = (__bridge id)table->keys[slot];
+    }
+    ++slot;
+  }
+  state->extra[0] = slot;
+  state->itemsPtr = stackbuf;
+  return numberOfItemsReturned;
+}
+
+#pragma mark - NIPointerSet
+
+@implementation NIPointerSet {
+  NIPointerTable _table;
+  void* _inlineKeys[kNIPointerTableInlineCapacity];
+  NIPointerCollectionOptions _options;
+  unsigned long _mutations;
+}
+
+- (void)dealloc {
+  [self removeAllObjects];
+}
+
+- (id)init {
+  return [self initWithOptions:NIPointerCollectionOptionNone];
+}
+
+- (id)initWithOptions:(NIPointerCollectionOptions)options {
+  if ((self = [super init])) {
+    _options = options;
+    NIPointerTableInit(&_table, _inlineKeys, NULL);
+  }
+  return self;
+}
+
+- (NSUInteger)count {
+  return _table.count;
+}
+
+- (BOOL)containsObject:(id)object {
+  if (nil == object) {
+    return NO;
+  }
+  return (NULL != _table.keys[NIPointerTableSlot(&_table, (__bridge void *)object)]);
+}
+
+- (NSArray *)allObjects {
+  NSMutableArray* objects = [NSMutableArray arrayWithCapacity:_table.count];
+  for (id object in self) {
+    [objects addObject:object];
+  }
+  return objects;
+}
+
+- (void)addObject:(id)object {
+  NIDASSERT(nil != object);
+  if (nil == object) {
+    return;
+  }
+  BOOL isNew = NO;
+  NIPointerTableInsert(&_table, (__bridge void *)object, &isNew);
+  if (isNew) {
+    if (_options & NIPointerCollectionOptionRetainKeys) {
+      CFBridgingRetain(object);
+    }
+    ++_mutations;
+  }
+}
+
+- (void)removeObject:(id)object {
+  if (nil == object) {
+    return;
+  }
+  NSUInteger slot = NIPointerTableSlot(&_table, (__bridge void *)object);
+  if (NULL == _table.keys[slot]) {
+    return;
+  }
+  NIPointerTableRemoveSlot(&_table, slot);
+  ++_mutations;
+  if (_options & NIPointerCollectionOptionRetainKeys) {
+    CFRelease((__bridge CFTypeRef)object);
+  }
+}
+
+- (void)removeAllObjects {
+  if (_options & NIPointerCollectionOptionRetainKeys) {
+    for (NSUInteger ix = 0; ix < _table.capacity; ++ix) {
+      if (NULL != _table.keys[ix]) {
+        CFRelease(_table.keys[ix]);
+      }
+    }
+  }
+  NIPointerTableFreeStorage(&_table);
+  NIPointerTableInit(&_table, _inlineKeys, NULL);
+  ++_mutations;
+}
+
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state
+                                  objects:(__unsafe_unretained id *)stackbuf
+                                    count:(NSUInteger)len {
+  if (0 == state->state) {
+    state->mutationsPtr = &_mutations;
+    state->state = 1;
+    state->extra[0] = 0;
+  }
+  return NIPointerTableEnumerate(&_table, state, stackbuf, len);
+}
+
+@end
+
+#pragma mark - NIPointerMap
+
+@implementation NIPointerMap {
+  NIPointerTable _table;
+  void* _inlineKeys[kNIPointerTableInlineCapacity];
+  void* _inlineValues[kNIPointerTableInlineCapacity];
+  NIPointerCollectionOptions _options;
+  unsigned long _mutations;
+}
+
+- (void)dealloc {
+  [self removeAllObjects];
+}
+
+- (id)init {
+  return [self initWithOptions:NIPointerCollectionOptionNone];
+}
+
+- (id)initWithOptions:(NIPointerCollectionOptions)options {
+  if ((self = [super init])) {
+    _options = options;
+    NIPointerTableInit(&_table, _inlineKeys, _inlineValues);
+  }
+  return self;
+}
+
+- (NSUInteger)count {
+  return _table.count;
+}
+
+- (id)objectForKey:(id)key {
+  if (nil == key) {
+    return nil;
+  }
+  // Empty slots hold NULL values, so a miss needs no extra check.
+  return (__bridge id)_table.values[NIPointerTableSlot(&_table, (__bridge void *)key)];
+}
+
+- (void)setObject:(id)object forKey:(id)key {
+  NIDASSERT(nil != key);
+  if (nil == key) {
+    return;
+  }
+  if (nil == object) {
+    [self removeObjectForKey:key];
+    return;
+  }
+
+  BOOL isNew = NO;
+  NSUInteger slot = NIPointerTableInsert(&_table, (__bridge void *)key, &isNew);
+  if (NSNotFound == slot) {
+    return; // COV_NF_LINE
+  }
+  void* previousObject = _table.values[slot];
+  _table.values[slot] = (void *)CFBridgingRetain(object);
+  if (NULL != previousObject) {
+    CFRelease(previousObject);
+  }
+  if (isNew) {
+    if (_options & NIPointerCollectionOptionRetainKeys) {
+      CFBridgingRetain(key);
+    }
+    ++_mutations;
+  }
+}
+
+- (void)removeObjectForKey:(id)key {
+  if (nil == key) {
+    return;
+  }
+  NSUInteger slot = NIPointerTableSlot(&_table, (__bridge void *)key);
+  if (NULL == _table.keys[slot]) {
+    return;
+  }
+  void* object = _table.values[slot];
+  NIPointerTableRemoveSlot(&_table, slot);
+  ++_mutations;
+  CFRelease(object);
+  if (_options & NIPointerCollectionOptionRetainKeys) {
+    CFRelease((__bridge CFTypeRef)key);
+  }
+}
+
+- (void)removeAllObjects {
+  for (NSUInteger ix = 0; ix < _table.capacity; ++ix) {
+    if (NULL != _table.keys[ix]) {
+      CFRelease(_table.values[ix]);
+      if (_options & NIPointerCollectionOptionRetainKeys) {
+        CFRelease(_table.keys[ix]);
+      }
+    }
+  }
+  NIPointerTableFreeStorage(&_table);
+  NIPointerTableInit(&_table, _inlineKeys, _inlineValues);
+  ++_mutations;
+}
+
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state
+                                  objects:(__unsafe_unretained id *)stackbuf
+                                    count:(NSUInteger)len {
+  if (0 == state->state) {
+    state->mutationsPtr = &_mutations;
+    state->state = 1;
+    state->extra[0] = 0;
+  }
+  return NIPointerTableEnumerate(&_table, state, stackbuf, len);
+}
+
+@end
@@ -0,0 +1,219 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+
+#import "NIOperations.h"
+
+@class NIOperationPipeline;
+
+/**
+ * The work done by a block stage. Return the stage's result, or return nil and set the error to
+ * fail the pipeline.
+ */
+typedef id (^NIOperationPipelineStageBlock)(id input, NIOperation* operation, NSError** error);
+
+/**
+ * Called on the main thread once the last stage has finished or any stage has failed.
+ */
+typedef void (^NIOperationPipelineCompletionBlock)(NIOperationPipeline* pipeline, id result, NSError* error);
+
+/**
+ * One step of an NIOperationPipeline.
+ *
+ * A stage receives the result of the stage before it as its input and runs on the queue it was
+ * added with. Subclasses override resultForInput:error:, or a stage can be created with a block.
+ *
+ * Stages don't call the NIOperation notification methods, so nothing is performed on the main
+ * thread between stages. Observe the pipeline rather than its stages.
+ *
+ * @ingroup Operations
+ */
+@interface NIOperationPipelineStage : NIOperation
+
+- (id)initWithName:(NSString *)name block:(NIOperationPipelineStageBlock)block;
+
+@property (nonatomic, readonly, copy) NSString* name;
+@property (nonatomic, readonly, strong) id result;
+
+@property (nonatomic, readonly) NSTimeInterval waitDuration;
+@property (nonatomic, readonly) NSTimeInterval duration;
+
+// Subclassing
+
+- (id)resultForInput:(id)input error:(NSError **)error;
+
+@end
+
+/**
+ * A chain of operations that pass their results directly to one another.
+ *
+ * Each stage runs on its own queue once the previous stage has finished, so a load on a network
+ * queue can be followed by a parse and a layout pass on a background queue without returning
+ * to the main thread in between. The pipeline is cancelled as a unit, and records how long
+ * each stage waited and ran.
+ *
+ * @code
+ * NIOperationPipeline* pipeline = [[NIOperationPipeline alloc] init];
+ * [pipeline addStageWithName:@"parse" queue:parsingQueue block:^id(id data, NIOperation* operation, NSError** error) {
+ *   return [NSJSONSerialization JSONObjectWithData:data options:0 error:error];
+ * }];
+ * [pipeline addStageWithName:@"model" queue:parsingQueue block:^id(id json, NIOperation* operation, NSError** error) {
+ *   return [[NIMutableTableViewModel alloc] initWithListArray:json delegate:nil];
+ * }];
+ * [pipeline startWithInput:data completion:^(NIOperationPipeline* pipeline, id model, NSError* error) {
+ *   ...
+ * }];
+ * @endcode
+ *
+ * @ingroup Operations
+ */
+@interface NIOperationPipeline : NSObject
+
+- (void)addStage:(NIOperationPipelineStage *)stage queue:(NSOperationQueue *)queue;
+- (NIOperationPipelineStage *)addStageWithName:(NSString *)name queue:(NSOperationQueue *)queue block:(NIOperationPipelineStageBlock)block;
+
+@property (nonatomic, readonly, copy) NSArray* stages;
+
+- (void)startWithInput:(id)input completion:(NIOperationPipelineCompletionBlock)completion;
+- (void)cancel;
+
+@property (nonatomic, readonly, getter = isCancelled) BOOL cancelled;
+@property (nonatomic, readonly, getter = isFinished) BOOL finished;
+
+@property (nonatomic, readonly) NSTimeInterval duration;
+
+@end
+
+
+// NIOperationPipelineStage
+
+/** @name Creating a Stage */
+
+/**
+ * Initializes a stage that produces its result by calling the block on the stage's queue.
+ *
+ * @fn NIOperationPipelineStage::initWithName:block:
+ */
+
+/** @name Results */
+
+/**
+ * The name of the stage, used when reporting timings.
+ *
+ * @fn NIOperationPipelineStage::name
+ */
+
+/**
+ * The value returned by the stage, which becomes the input of the next stage.
+ *
+ * @fn NIOperationPipelineStage::result
+ */
+
+/** @name Timing */
+
+/**
+ * How long the stage waited for its queue after its input became available.
+ *
+ * 0 until the stage has started.
+ *
+ * @fn NIOperationPipelineStage::waitDuration
+ */
+
+/**
+ * How long the stage spent producing its result.
+ *
+ * 0 until the stage has finished.
+ *
+ * @fn NIOperationPipelineStage::duration
+ */
+
+/** @name Subclassing */
+
+/**
+ * Produces the stage's result. Called on the stage's queue.
+ *
+ * The default implementation calls the stage's block, or returns the input unchanged if the
+ * stage has no block. Check isCancelled during long-running work and return early if it is
+ * set.
+ *
+ * @fn NIOperationPipelineStage::resultForInput:error:
+ */
+
+
+// NIOperationPipeline
+
+/** @name Building a Pipeline */
+
+/**
+ * Appends a stage that will run on the given queue.
+ *
+ * Stages must be added before the pipeline is started.
+ *
+ * @fn NIOperationPipeline::addStage:queue:
+ */
+
+/**
+ * Appends a block stage that will run on the given queue.
+ *
+ * @returns The stage, whose timings can be read once the pipeline has finished.
+ * @fn NIOperationPipeline::addStageWithName:queue:block:
+ */
+
+/**
+ * The pipeline's stages in the order they run.
+ *
+ * @fn NIOperationPipeline::stages
+ */
+
+/** @name Running a Pipeline */
+
+/**
+ * Enqueues every stage. The first stage receives the input.
+ *
+ * The completion block is called on the main thread with the last stage's result, or with the
+ * error of the first stage that failed. It is not called if the pipeline is cancelled. The
+ * pipeline keeps itself alive until it completes or is cancelled.
+ *
+ * @fn NIOperationPipeline::startWithInput:completion:
+ */
+
+/**
+ * Cancels every stage that has not finished and drops the completion block.
+ *
+ * Cancelling any one stage, directly or through its queue, cancels the whole pipeline.
+ *
+ * @fn NIOperationPipeline::cancel
+ */
+
+/**
+ * @fn NIOperationPipeline::cancelled
+ */
+
+/**
+ * YES once the completion block has been called.
+ *
+ * @fn NIOperationPipeline::finished
+ */
+
+/** @name Timing */
+
+/**
+ * The time from startWithInput:completion: until the last stage finished or a stage failed.
+ *
+ * @fn NIOperationPipeline::duration
+ */
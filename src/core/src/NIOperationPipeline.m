@@ -0,0 +1,272 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIOperationPipeline.h"
+
+#import "NIDebuggingTools.h"
+#import <QuartzCore/QuartzCore.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+@interface NIOperationPipeline()
+@property (nonatomic, strong) NSMutableArray* mutableStages;
+@property (nonatomic, strong) NSMutableArray* queues;
+@property (nonatomic, strong) id input;
+@property (nonatomic, copy) NIOperationPipelineCompletionBlock completion;
+@property (nonatomic) BOOL started;
+@property (nonatomic, readwrite, getter = isCancelled) BOOL cancelled;
+@property (nonatomic, readwrite, getter = isFinished) BOOL finished;
+@property (nonatomic) CFTimeInterval startTime;
+@property (nonatomic) CFTimeInterval endTime;
+// Keeps the pipeline alive while its stages are in flight.
+@property (nonatomic, strong) NIOperationPipeline* retainedSelf;
+
+- (void)stage:(NIOperationPipelineStage *)stage didFinishWithResult:(id)result error:(NSError *)error;
+@end
+
+@interface NIOperationPipelineStage()
+@property (nonatomic, readwrite, copy) NSString* name;
+@property (nonatomic, readwrite, strong) id result;
+@property (nonatomic, copy) NIOperationPipelineStageBlock block;
+@property (nonatomic, weak) NIOperationPipeline* pipeline;
+@property (nonatomic, weak) NIOperationPipelineStage* previousStage;
+@property (nonatomic) CFTimeInterval readyTime;
+@property (nonatomic) CFTimeInterval startTime;
+@property (nonatomic) CFTimeInterval endTime;
+@end
+
+@implementation NIOperationPipelineStage
+
+- (id)initWithName:(NSString *)name block:(NIOperationPipelineStageBlock)block {
+  if ((self = [super init])) {
+    _name = [name copy];
+    _block = [block copy];
+  }
+  return self;
+}
+
+- (id)init {
+  return [self initWithName:NSStringFromClass([self class]) block:nil];
+}
+
+- (id)resultForInput:(id)input error:(NSError **)error {
+  if (nil == self.block) {
+    return input;
+  }
+  return self.block(input, self, error);
+}
+
+- (void)main {
+  NIOperationPipeline* pipeline = self.pipeline;
+  if (nil == pipeline) {
+    return;
+  }
+  if (self.isCancelled) {
+    [pipeline cancel];
+    return;
+  }
+
+  // The previous stage's result is read directly; it finished before this stage became ready.
+  NIOperationPipelineStage* previousStage = self.previousStage;
+  id input = (nil != previousStage) ? previousStage.result : pipeline.input;
+  self.readyTime = (nil != previousStage) ? previousStage.endTime : pipeline.startTime;
+  self.startTime = CACurrentMediaTime();
+
+  NSError* error = nil;
+  id result = [self resultForInput:input error:&error];
+  self.endTime = CACurrentMediaTime();
+
+  // The result of a cancelled stage is never passed on, even if the block ignored the cancel.
+  if (self.isCancelled) {
+    [pipeline cancel];
+    return;
+  }
+  if (nil == result && nil != error) {
+    [pipeline stage:self didFinishWithResult:nil error:error];
+  } else {
+    self.result = result;
+    [pipeline stage:self didFinishWithResult:result error:nil];
+  }
+}
+
+- (void)cancel {
+  [super cancel];
+  // A stage that is cancelled from outside the pipeline, for instance by its queue, takes the
+  // pipeline with it. Otherwise the next stage would run without an input, or the pipeline would
+  // keep itself alive waiting for a result that never comes. A queue doesn't call main on a
+  // stage that was cancelled before it started, so this can't be left to main.
+  [self.pipeline cancel];
+}
+
+- (NSTimeInterval)waitDuration {
+  return (self.startTime > 0) ? MAX(0, self.startTime - self.readyTime) : 0;
+}
+
+- (NSTimeInterval)duration {
+  return (self.endTime > 0) ? self.endTime - self.startTime : 0;
+}
+
+@end
+
+@implementation NIOperationPipeline
+
+- (id)init {
+  if ((self = [super init])) {
+    _mutableStages = [[NSMutableArray alloc] init];
+    _queues = [[NSMutableArray alloc] init];
+  }
+  return self;
+}
+
+- (NSString *)description {
+  NSMutableString* description = [NSMutableString stringWithFormat:@"<%@: %p duration: %.1fms",
+                                  NSStringFromClass([self class]), self, self.duration * 1000];
+  for (NIOperationPipelineStage* stage in self.stages) {
+    [description appendFormat:@" %@: %.1fms waiting %.1fms running",
+     stage.name, stage.waitDuration * 1000, stage.duration * 1000];
+  }
+  [description appendString:@">"];
+  return description;
+}
+
+#pragma mark - Building a Pipeline
+
+- (void)addStage:(NIOperationPipelineStage *)stage queue:(NSOperationQueue *)queue {
+  NIDASSERT(nil != stage && nil != queue);
+  if (nil == stage || nil == queue) {
+    return;
+  }
+  @synchronized(self) {
+    NIDASSERT(!self.started);
+    if (self.started) {
+      return;
+    }
+    NIOperationPipelineStage* previousStage = [self.mutableStages lastObject];
+    if (nil != previousStage) {
+      [stage addDependency:previousStage];
+    }
+    stage.previousStage = previousStage;
+    stage.pipeline = self;
+    [self.mutableStages addObject:stage];
+    [self.queues addObject:queue];
+  }
+}
+
+- (NIOperationPipelineStage *)addStageWithName:(NSString *)name queue:(NSOperationQueue *)queue block:(NIOperationPipelineStageBlock)block {
+  NIOperationPipelineStage* stage = [[NIOperationPipelineStage alloc] initWithName:name block:block];
+  [self addStage:stage queue:queue];
+  return stage;
+}
+
+- (NSArray *)stages {
+  @synchronized(self) {
+    return [self.mutableStages copy];
+  }
+}
+
+#pragma mark - Running a Pipeline
+
+- (void)startWithInput:(id)input completion:(NIOperationPipelineCompletionBlock)completion {
+  NSArray* stages = nil;
+  NSArray* queues = nil;
+  @synchronized(self) {
+    NIDASSERT(!self.started);
+    if (self.started || self.cancelled) {
+      return;
+    }
+    self.started = YES;
+    self.input = input;
+    self.completion = completion;
+    self.startTime = CACurrentMediaTime();
+    self.retainedSelf = self;
+    stages = [self.mutableStages copy];
+    queues = [self.queues copy];
+  }
+
+  if (0 == stages.count) {
+    [self stage:nil didFinishWithResult:input error:nil];
+    return;
+  }
+  for (NSUInteger ix = 0; ix < stages.count; ++ix) {
+    [queues[ix] addOperation:stages[ix]];
+  }
+}
+
+- (void)stage:(NIOperationPipelineStage *)stage didFinishWithResult:(id)result error:(NSError *)error {
+  NIOperationPipelineCompletionBlock completion = nil;
+  @synchronized(self) {
+    BOOL isLastStage = (nil == stage || stage == [self.mutableStages lastObject]);
+    if (self.cancelled || self.finished || (nil == error && !isLastStage)) {
+      return;
+    }
+    self.finished = YES;
+    self.endTime = CACurrentMediaTime();
+    completion = self.completion;
+    self.completion = nil;
+    self.input = nil;
+  }
+
+  if (nil != error) {
+    // Later stages would only run on a result that doesn't exist.
+    for (NIOperationPipelineStage* otherStage in self.stages) {
+      [otherStage cancel];
+    }
+  }
+
+  dispatch_async(dispatch_get_main_queue(), ^{
+    if (nil != completion) {
+      completion(self, result, error);
+    }
+    @synchronized(self) {
+      self.retainedSelf = nil;
+    }
+  });
+}
+
+- (void)cancel {
+  // Released when this method returns, which may be the last reference to the pipeline.
+  NIOperationPipeline* retainedSelf = nil;
+  @synchronized(self) {
+    if (self.cancelled || self.finished) {
+      return;
+    }
+    self.cancelled = YES;
+    self.endTime = CACurrentMediaTime();
+    self.completion = nil;
+    self.input = nil;
+    retainedSelf = self.retainedSelf;
+    self.retainedSelf = nil;
+  }
+  for (NIOperationPipelineStage* stage in self.stages) {
+    [stage cancel];
+  }
+}
+
+#pragma mark - Timing
+
+- (NSTimeInterval)duration {
+  @synchronized(self) {
+    if (0 == self.startTime || 0 == self.endTime) {
+      return 0;
+    }
+    return self.endTime - self.startTime;
+  }
+}
+
+@end
@@ -53,6 +53,7 @@ typedef void (^NIOperationDidFailBlock)(NIOperation* operation, NSError* error);
 @property (weak) id<NIOperationDelegate> delegate;
 @property (readonly, strong) NSError* lastError;
 @property (assign) NSInteger tag;
+@property (copy) NSString* deduplicationKey;
 
 @property (copy) NIOperationBlock didStartBlock;
 @property (copy) NIOperationBlock didFinishBlock;
@@ -66,6 +67,28 @@ typedef void (^NIOperationDidFailBlock)(NIOperation* operation, NSError* error);
 
 @end
 
+/**
+ * An operation queue that runs each logical piece of work once.
+ *
+ * Operations added with addNimbusOperation: that share a deduplicationKey with an operation
+ * that is still in the queue are not added. Instead, their delegate and blocks are attached to
+ * the operation in the queue and are notified when it starts, finishes or fails.
+ *
+ * The queue also understands NIOperation's tag, so priorities can follow the UI after the
+ * operations have been enqueued.
+ *
+ * @ingroup Operations
+ */
+@interface NIOperationQueue : NSOperationQueue
+
+- (NIOperation *)addNimbusOperation:(NIOperation *)operation;
+- (NIOperation *)operationWithDeduplicationKey:(NSString *)deduplicationKey;
+
+- (void)setQueuePriority:(NSOperationQueuePriority)queuePriority forOperationWithDeduplicationKey:(NSString *)deduplicationKey;
+- (void)setQueuePriority:(NSOperationQueuePriority)queuePriority forOperationsWithTag:(NSInteger)tag;
+
+@end
+
 /**
  * The delegate protocol for an NIOperation.
  *
@@ -132,9 +155,23 @@ typedef void (^NIOperationDidFailBlock)(NIOperation* operation, NSError* error);
 /**
  * A simple tagging mechanism for identifying operations.
  *
+ * NIOperationQueue can change the priority of every operation with a given tag.
+ *
  * @fn NIOperation::tag
  */
 
+/**
+ * Identifies the work that the operation does, such as the URL of the resource it loads.
+ *
+ * Two operations with the same key are expected to produce the same result. When an operation
+ * is added to an NIOperationQueue that already holds an unfinished operation with the same key,
+ * the new operation is attached to the existing one rather than run.
+ *
+ * Default: nil (never deduplicated)
+ *
+ * @fn NIOperation::deduplicationKey
+ */
+
 
 /** @name Blocks */
 
@@ -207,3 +244,51 @@ typedef void (^NIOperationDidFailBlock)(NIOperation* operation, NSError* error);
  *
  * @fn NIOperation::willFinish
  */
+
+
+// NIOperationQueue
+
+/** @name Adding Operations */
+
+/**
+ * Adds the operation to the queue unless an equivalent operation is already in it.
+ *
+ * If the queue holds an unfinished, uncancelled operation with the same deduplicationKey, the
+ * given operation is not added. Its delegate and blocks are attached to the existing operation
+ * instead and receive every notification sent after this point, with the existing operation
+ * passed as the operation argument. The existing operation's priority is raised to the new
+ * operation's priority if that is higher and the existing operation has not started yet.
+ *
+ * Cancelling the operation that does the work stops the notifications for every attached
+ * operation.
+ *
+ * @returns The operation that will do the work: either the given operation or the one it was
+ *               attached to.
+ * @fn NIOperationQueue::addNimbusOperation:
+ */
+
+/**
+ * Returns the unfinished operation in the queue with the given deduplication key, if any.
+ *
+ * @fn NIOperationQueue::operationWithDeduplicationKey:
+ */
+
+/** @name Changing Priorities */
+
+/**
+ * Changes the priority of the unfinished operation with the given deduplication key.
+ *
+ * Has no effect once the operation has started executing.
+ *
+ * @fn NIOperationQueue::setQueuePriority:forOperationWithDeduplicationKey:
+ */
+
+/**
+ * Changes the priority of every operation in the queue with the given tag that has not started
+ * executing.
+ *
+ * For example, tag operations with the section of the screen they load content for and raise
+ * the section that the user scrolls to.
+ *
+ * @fn NIOperationQueue::setQueuePriority:forOperationsWithTag:
+ */
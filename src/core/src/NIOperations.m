@@ -24,6 +24,17 @@
 #error "Nimbus requires ARC support."
 #endif
 
+// The KVO context used by NIOperationQueue to learn when deduplicated operations finish.
+static void* kNIOperationQueueIsFinishedContext = &kNIOperationQueueIsFinishedContext;
+
+@interface NIOperation()
+// Operations whose delegates and blocks are notified alongside this operation's. Guarded by
+// @synchronized(self).
+@property (nonatomic, strong) NSMutableArray* attachedOperations;
+// Set once didFinish or didFailWithError: has been delivered. Guarded by @synchronized(self).
+@property (nonatomic) BOOL hasDeliveredCompletion;
+@end
+
 @implementation NIOperation
 
 - (void)dealloc {
@@ -35,6 +46,30 @@
   _willFinishBlock = nil;
 }
 
+#pragma mark - Attached Operations
+
+- (BOOL)attachOperation:(NIOperation *)operation {
+  @synchronized(self) {
+    if (self.hasDeliveredCompletion || self.isCancelled || self.isFinished) {
+      return NO;
+    }
+    if (nil == self.attachedOperations) {
+      self.attachedOperations = [NSMutableArray array];
+    }
+    [self.attachedOperations addObject:operation];
+    return YES;
+  }
+}
+
+- (NSArray *)attachedOperationsMarkingCompletion:(BOOL)markCompletion {
+  @synchronized(self) {
+    if (markCompletion) {
+      self.hasDeliveredCompletion = YES;
+    }
+    return [self.attachedOperations copy];
+  }
+}
+
 #pragma mark - Initiate delegate notification from the NSOperation
 
 - (void)didStart {
@@ -58,12 +93,54 @@
 }
 
 - (void)willFinish {
+  [self notifyWillFinishForOperation:self];
+  for (NIOperation* attachedOperation in [self attachedOperationsMarkingCompletion:NO]) {
+    [attachedOperation notifyWillFinishForOperation:self];
+  }
+}
+
+#pragma mark - Notifying the Delegate and Blocks
+
+// Each of these notifies this operation's delegate and blocks of a change in the state of the
+// operation that is doing the work, which is either this operation or the one it is attached to.
+
+- (void)notifyDidStartForOperation:(NIOperation *)operation {
+  if ([self.delegate respondsToSelector:@selector(nimbusOperationDidStart:)]) {
+    [self.delegate nimbusOperationDidStart:operation];
+  }
+
+  if (nil != self.didStartBlock) {
+    self.didStartBlock(operation);
+  }
+}
+
+- (void)notifyWillFinishForOperation:(NIOperation *)operation {
   if ([self.delegate respondsToSelector:@selector(nimbusOperationWillFinish:)]) {
-    [self.delegate nimbusOperationWillFinish:self];
+    [self.delegate nimbusOperationWillFinish:operation];
   }
 
   if (nil != self.willFinishBlock) {
-    self.willFinishBlock(self);
+    self.willFinishBlock(operation);
+  }
+}
+
+- (void)notifyDidFinishForOperation:(NIOperation *)operation {
+  if ([self.delegate respondsToSelector:@selector(nimbusOperationDidFinish:)]) {
+    [self.delegate nimbusOperationDidFinish:operation];
+  }
+
+  if (nil != self.didFinishBlock) {
+    self.didFinishBlock(operation);
+  }
+}
+
+- (void)notifyDidFailForOperation:(NIOperation *)operation withError:(NSError *)error {
+  if ([self.delegate respondsToSelector:@selector(nimbusOperationDidFail:withError:)]) {
+    [self.delegate nimbusOperationDidFail:operation withError:error];
+  }
+
+  if (nil != self.didFailWithErrorBlock) {
+    self.didFailWithErrorBlock(operation, error);
   }
 }
 
@@ -73,12 +150,9 @@
   // This method should only be called on the main thread.
   NIDASSERT([NSThread isMainThread]);
 
-  if ([self.delegate respondsToSelector:@selector(nimbusOperationDidStart:)]) {
-    [self.delegate nimbusOperationDidStart:self];
-  }
-
-  if (nil != self.didStartBlock) {
-    self.didStartBlock(self);
+  [self notifyDidStartForOperation:self];
+  for (NIOperation* attachedOperation in [self attachedOperationsMarkingCompletion:NO]) {
+    [attachedOperation notifyDidStartForOperation:self];
   }
 }
 
@@ -86,12 +160,9 @@
   // This method should only be called on the main thread.
   NIDASSERT([NSThread isMainThread]);
 
-  if ([self.delegate respondsToSelector:@selector(nimbusOperationDidFinish:)]) {
-    [self.delegate nimbusOperationDidFinish:self];
-  }
-
-  if (nil != self.didFinishBlock) {
-    self.didFinishBlock(self);
+  [self notifyDidFinishForOperation:self];
+  for (NIOperation* attachedOperation in [self attachedOperationsMarkingCompletion:YES]) {
+    [attachedOperation notifyDidFinishForOperation:self];
   }
 }
 
@@ -99,12 +170,116 @@
   // This method should only be called on the main thread.
   NIDASSERT([NSThread isMainThread]);
 
-  if ([self.delegate respondsToSelector:@selector(nimbusOperationDidFail:withError:)]) {
-    [self.delegate nimbusOperationDidFail:self withError:error];
+  [self notifyDidFailForOperation:self withError:error];
+  for (NIOperation* attachedOperation in [self attachedOperationsMarkingCompletion:YES]) {
+    attachedOperation.lastError = error;
+    [attachedOperation notifyDidFailForOperation:self withError:error];
   }
+}
 
-  if (nil != self.didFailWithErrorBlock) {
-    self.didFailWithErrorBlock(self, error);
+@end
+
+@interface NIOperationQueue()
+// Unfinished operations by their deduplication keys. Guarded by @synchronized(self).
+@property (nonatomic, strong) NSMutableDictionary* operationsByDeduplicationKey;
+// Operations being observed for completion. Guarded by @synchronized(self).
+@property (nonatomic, strong) NSMutableSet* observedOperations;
+@end
+
+@implementation NIOperationQueue
+
+- (void)dealloc {
+  for (NIOperation* operation in _observedOperations) {
+    [operation removeObserver:self forKeyPath:@"isFinished" context:kNIOperationQueueIsFinishedContext];
+  }
+}
+
+- (id)init {
+  if ((self = [super init])) {
+    _operationsByDeduplicationKey = [[NSMutableDictionary alloc] init];
+    _observedOperations = [[NSMutableSet alloc] init];
+  }
+  return self;
+}
+
+#pragma mark - Adding Operations
+
+- (NIOperation *)addNimbusOperation:(NIOperation *)operation {
+  NSString* deduplicationKey = [operation.deduplicationKey copy];
+  if (nil == deduplicationKey) {
+    [self addOperation:operation];
+    return operation;
+  }
+
+  @synchronized(self) {
+    NIOperation* existingOperation = self.operationsByDeduplicationKey[deduplicationKey];
+    if (existingOperation == operation) {
+      return existingOperation;
+    }
+    if (nil != existingOperation && [existingOperation attachOperation:operation]) {
+      if (operation.queuePriority > existingOperation.queuePriority && !existingOperation.isExecuting) {
+        existingOperation.queuePriority = operation.queuePriority;
+      }
+      return existingOperation;
+    }
+
+    // Either nothing is doing this work or the operation that was doing it has been cancelled.
+    self.operationsByDeduplicationKey[deduplicationKey] = operation;
+    [self.observedOperations addObject:operation];
+    [operation addObserver:self
+                forKeyPath:@"isFinished"
+                   options:0
+                   context:kNIOperationQueueIsFinishedContext];
+  }
+  [self addOperation:operation];
+  return operation;
+}
+
+- (NIOperation *)operationWithDeduplicationKey:(NSString *)deduplicationKey {
+  if (nil == deduplicationKey) {
+    return nil;
+  }
+  @synchronized(self) {
+    return self.operationsByDeduplicationKey[deduplicationKey];
+  }
+}
+
+- (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context {
+  if (context != kNIOperationQueueIsFinishedContext) {
+    [super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+    return;
+  }
+  NIOperation* operation = object;
+  if (!operation.isFinished) {
+    return;
+  }
+  BOOL wasObserved = NO;
+  @synchronized(self) {
+    wasObserved = [self.observedOperations containsObject:operation];
+    [self.observedOperations removeObject:operation];
+    [self.operationsByDeduplicationKey removeObjectsForKeys:[self.operationsByDeduplicationKey allKeysForObject:operation]];
+  }
+  if (wasObserved) {
+    [operation removeObserver:self forKeyPath:@"isFinished" context:kNIOperationQueueIsFinishedContext];
+  }
+}
+
+#pragma mark - Changing Priorities
+
+- (void)setQueuePriority:(NSOperationQueuePriority)queuePriority forOperationWithDeduplicationKey:(NSString *)deduplicationKey {
+  NIOperation* operation = [self operationWithDeduplicationKey:deduplicationKey];
+  if (nil != operation && !operation.isExecuting && !operation.isFinished) {
+    operation.queuePriority = queuePriority;
+  }
+}
+
+- (void)setQueuePriority:(NSOperationQueuePriority)queuePriority forOperationsWithTag:(NSInteger)tag {
+  for (NSOperation* operation in self.operations) {
+    if ([operation isKindOfClass:[NIOperation class]]
+        && [(NIOperation *)operation tag] == tag
+        && !operation.isExecuting && !operation.isFinished) {
+      operation.queuePriority = queuePriority;
+    }
   }
 }
 
@@ -0,0 +1,137 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+/**
+ * For preparing the objects of a scroll view's cells before they are shown.
+ *
+ * Objects whose cells need decoded images or laid out text can do that work in the background
+ * while their cells are still off screen, so that the data source finds everything ready when it
+ * creates the cell. NITableViewModel and NICollectionViewModel drive a prefetch window for their
+ * objects when the scroll view delegate asks them to.
+ *
+ * @ingroup NimbusCore
+ * @defgroup Prefetching Prefetching
+ * @{
+ */
+
+/**
+ * An object that can prepare for display ahead of time.
+ */
+@protocol NIPrefetchingObject <NSObject>
+@required
+
+/**
+ * Called on a background queue when the object's cell is about to scroll on screen.
+ */
+- (void)prepareForDisplayInBackground;
+
+@optional
+
+/**
+ * Called on the main thread when the object's cell scrolled back out of the look-ahead window
+ * without being shown.
+ *
+ * This may be called while prepareForDisplayInBackground is still running.
+ */
+- (void)cancelPrepare;
+
+@end
+
+/**
+ * Tracks the region ahead of a scroll view's visible bounds and the objects prepared for it.
+ *
+ * The look-ahead region starts at the edge of the visible bounds in the direction of scrolling
+ * and grows with the scroll velocity, so a fast fling prepares more cells than a slow drag.
+ *
+ * The window must only be used from the main thread.
+ */
+@interface NIPrefetchWindow : NSObject
+
+@property (nonatomic) NSTimeInterval lookAheadInterval; // Default: 0.5
+@property (nonatomic) CGFloat minimumLookAheadScreens; // Default: 0.5
+@property (nonatomic) CGFloat maximumLookAheadScreens; // Default: 2
+
+- (CGRect)lookAheadRectForScrollView:(UIScrollView *)scrollView;
+
+- (void)prefetchObjects:(NSArray *)objects visibleObjects:(NSArray *)visibleObjects;
+- (void)cancelAllPrefetches;
+
+- (NSUInteger)numberOfPrefetchedObjects;
+
+@end
+
+/**@}*/// End of Prefetching /////////////////////////////////////////////////////////////////////
+
+/** @name Configuring the Window */
+
+/**
+ * How far ahead to look, as the time the scroll view takes to cover the distance at its current
+ * velocity.
+ *
+ * @fn NIPrefetchWindow::lookAheadInterval
+ */
+
+/**
+ * The smallest look-ahead distance, as a fraction of the scroll view's visible length. This is
+ * the distance used while the scroll view is at rest.
+ *
+ * @fn NIPrefetchWindow::minimumLookAheadScreens
+ */
+
+/**
+ * The largest look-ahead distance, as a multiple of the scroll view's visible length.
+ *
+ * @fn NIPrefetchWindow::maximumLookAheadScreens
+ */
+
+/** @name Prefetching */
+
+/**
+ * Returns the rect of content that is about to scroll on screen.
+ *
+ * The scroll velocity is measured between calls, so call this each time the scroll view
+ * scrolls. The rect is clipped to the scroll view's content and is empty at either end of it.
+ *
+ * @fn NIPrefetchWindow::lookAheadRectForScrollView:
+ */
+
+/**
+ * Makes the given objects the contents of the window.
+ *
+ * Objects that are new to the window and not visible are sent prepareForDisplayInBackground on
+ * a background queue. Objects that left the window are sent cancelPrepare unless they are now
+ * visible. Objects that don't conform to NIPrefetchingObject are ignored.
+ *
+ * @param objects         The objects of the cells in the look-ahead rect.
+ * @param visibleObjects  The objects of the cells on screen.
+ * @fn NIPrefetchWindow::prefetchObjects:visibleObjects:
+ */
+
+/**
+ * Sends cancelPrepare to every object in the window and empties it.
+ *
+ * @fn NIPrefetchWindow::cancelAllPrefetches
+ */
+
+/**
+ * Returns the number of objects in the window.
+ *
+ * @fn NIPrefetchWindow::numberOfPrefetchedObjects
+ */
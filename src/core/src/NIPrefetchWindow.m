@@ -0,0 +1,142 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIPrefetchWindow.h"
+
+#import "NIDebuggingTools.h"
+
+#import <QuartzCore/QuartzCore.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// Offsets measured further apart than this don't describe the current scroll.
+static const NSTimeInterval kMaximumVelocitySampleInterval = 0.25;
+
+@implementation NIPrefetchWindow {
+  NSHashTable* _prefetchedObjects;
+  CGPoint _lastContentOffset;
+  CFTimeInterval _lastContentOffsetTime;
+  CGPoint _velocity;
+  // +1 when scrolling towards the end of the content, -1 towards the start.
+  NSInteger _direction;
+}
+
+- (id)init {
+  if ((self = [super init])) {
+    _prefetchedObjects = [NSHashTable hashTableWithOptions:(NSPointerFunctionsStrongMemory
+                                                            | NSPointerFunctionsObjectPointerPersonality)];
+    _lookAheadInterval = 0.5;
+    _minimumLookAheadScreens = 0.5;
+    _maximumLookAheadScreens = 2;
+    _direction = 1;
+  }
+  return self;
+}
+
+- (CGRect)lookAheadRectForScrollView:(UIScrollView *)scrollView {
+  NIDASSERT([NSThread isMainThread]);
+  CGPoint contentOffset = scrollView.contentOffset;
+  CFTimeInterval now = CACurrentMediaTime();
+  CFTimeInterval elapsed = now - _lastContentOffsetTime;
+  if (_lastContentOffsetTime > 0 && elapsed > 0 && elapsed < kMaximumVelocitySampleInterval) {
+    _velocity = CGPointMake((contentOffset.x - _lastContentOffset.x) / elapsed,
+                            (contentOffset.y - _lastContentOffset.y) / elapsed);
+  } else {
+    _velocity = CGPointZero;
+  }
+  _lastContentOffset = contentOffset;
+  _lastContentOffsetTime = now;
+
+  CGRect bounds = scrollView.bounds;
+  CGSize contentSize = scrollView.contentSize;
+  BOOL isHorizontal = (contentSize.width > bounds.size.width && contentSize.height <= bounds.size.height);
+  CGFloat speed = isHorizontal ? _velocity.x : _velocity.y;
+  if (speed != 0) {
+    _direction = (speed > 0) ? 1 : -1;
+  }
+
+  CGFloat screenLength = isHorizontal ? bounds.size.width : bounds.size.height;
+  CGFloat distance = (CGFloat)fabs(speed) * (CGFloat)self.lookAheadInterval;
+  distance = MAX(distance, screenLength * self.minimumLookAheadScreens);
+  distance = MIN(distance, screenLength * self.maximumLookAheadScreens);
+
+  CGRect rect = bounds;
+  if (isHorizontal) {
+    rect.origin.x = (_direction > 0) ? CGRectGetMaxX(bounds) : CGRectGetMinX(bounds) - distance;
+    rect.size.width = distance;
+  } else {
+    rect.origin.y = (_direction > 0) ? CGRectGetMaxY(bounds) : CGRectGetMinY(bounds) - distance;
+    rect.size.height = distance;
+  }
+  CGRect content = CGRectMake(0, 0, contentSize.width, contentSize.height);
+  return CGRectIntersection(rect, content);
+}
+
+- (void)prefetchObjects:(NSArray *)objects visibleObjects:(NSArray *)visibleObjects {
+  NIDASSERT([NSThread isMainThread]);
+  NSHashTable* visible = [NSHashTable hashTableWithOptions:(NSPointerFunctionsStrongMemory
+                                                            | NSPointerFunctionsObjectPointerPersonality)];
+  for (id object in visibleObjects) {
+    [visible addObject:object];
+  }
+  NSHashTable* window = [NSHashTable hashTableWithOptions:(NSPointerFunctionsStrongMemory
+                                                           | NSPointerFunctionsObjectPointerPersonality)];
+  for (id object in objects) {
+    if ([object respondsToSelector:@selector(prepareForDisplayInBackground)]
+        && ![visible containsObject:object]) {
+      [window addObject:object];
+    }
+  }
+
+  for (id object in [_prefetchedObjects allObjects]) {
+    if (![window containsObject:object]) {
+      [_prefetchedObjects removeObject:object];
+      // Objects that scrolled on screen have been used rather than abandoned.
+      if (![visible containsObject:object] && [object respondsToSelector:@selector(cancelPrepare)]) {
+        [object cancelPrepare];
+      }
+    }
+  }
+
+  for (id<NIPrefetchingObject> object in window) {
+    if (![_prefetchedObjects containsObject:object]) {
+      [_prefetchedObjects addObject:object];
+      dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+        [object prepareForDisplayInBackground];
+      });
+    }
+  }
+}
+
+- (void)cancelAllPrefetches {
+  NIDASSERT([NSThread isMainThread]);
+  NSArray* objects = [_prefetchedObjects allObjects];
+  [_prefetchedObjects removeAllObjects];
+  for (id object in objects) {
+    if ([object respondsToSelector:@selector(cancelPrepare)]) {
+      [object cancelPrepare];
+    }
+  }
+}
+
+- (NSUInteger)numberOfPrefetchedObjects {
+  return _prefetchedObjects.count;
+}
+
+@end
@@ -67,6 +67,30 @@ void NISwapInstanceMethods(Class cls, SEL originalSel, SEL newSel);
  */
 void NISwapClassMethods(Class cls, SEL originalSel, SEL newSel);
 
+/**
+ * Replace a class's instance method implementation without affecting its superclasses.
+ *
+ * If cls inherits the method rather than implementing it, the new implementation is added to
+ * cls alone using the inherited method's type encoding. Either way the implementation that cls
+ * used until now is returned, so the new implementation can forward to it.
+ *
+ * This is the safe way to hook a method for a single class hierarchy. Swapping an inherited
+ * method with NISwapInstanceMethods changes it for every class that shares the superclass's
+ * implementation.
+ *
+ *      @returns The previous implementation, or NULL if cls doesn't respond to sel.
+ */
+IMP NIReplaceInstanceMethodImplementation(Class cls, SEL sel, IMP imp);
+
+/**
+ * Replace a class's class method implementation without affecting its superclasses.
+ *
+ * This is the class method equivalent of NIReplaceInstanceMethodImplementation.
+ *
+ *      @returns The previous implementation, or NULL if cls doesn't respond to sel.
+ */
+IMP NIReplaceClassMethodImplementation(Class cls, SEL sel, IMP imp);
+
 #if defined __cplusplus
 };
 #endif
@@ -35,3 +35,20 @@ void NISwapClassMethods(Class cls, SEL originalSel, SEL newSel) {
   Method newMethod = class_getClassMethod(cls, newSel);
   method_exchangeImplementations(originalMethod, newMethod);
 }
+
+IMP NIReplaceInstanceMethodImplementation(Class cls, SEL sel, IMP imp) {
+  Method method = class_getInstanceMethod(cls, sel);
+  if (NULL == method) {
+    return NULL;
+  }
+  IMP previousImp = method_getImplementation(method);
+  // Adding fails if cls implements the method itself, in which case it is replaced in place.
+  if (!class_addMethod(cls, sel, imp, method_getTypeEncoding(method))) {
+    previousImp = method_setImplementation(method, imp);
+  }
+  return previousImp;
+}
+
+IMP NIReplaceClassMethodImplementation(Class cls, SEL sel, IMP imp) {
+  return NIReplaceInstanceMethodImplementation(object_getClass(cls), sel, imp);
+}
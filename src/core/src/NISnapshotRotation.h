@@ -53,6 +53,9 @@
 @property (nonatomic, readonly, assign) CGRect frameBeforeRotation;
 @property (nonatomic, readonly, assign) CGRect frameAfterRotation;
 
+@property (nonatomic, assign) BOOL usesSnapshotViews; // Default: NO
+@property (nonatomic, assign) CGFloat snapshotScale; // Default: 0 (the screen's scale)
+
 - (void)willRotateToInterfaceOrientation:(UIInterfaceOrientation)toInterfaceOrientation duration:(NSTimeInterval)duration;
 - (void)willAnimateRotationToInterfaceOrientation:(UIInterfaceOrientation)toInterfaceOrientation duration:(NSTimeInterval)duration;
 - (void)didRotateFromInterfaceOrientation:(UIInterfaceOrientation)fromInterfaceOrientation;
@@ -167,6 +170,18 @@ UIImage* NISnapshotOfViewWithTransparency(UIView* view);
  */
 UIImageView* NISnapshotViewOfViewWithTransparency(UIView* view);
 
+/**
+ * Returns a UIImage snapshot of the given view with transparency, rendered at the given scale.
+ *
+ * Snapshots that are only shown briefly, or are scaled during an animation, rarely need every
+ * pixel. Half the screen's scale takes a quarter of the memory and rendering time.
+ *
+ * @param view A snapshot will be taken of this view.
+ * @param scale The scale of the image. 0 uses the screen's scale.
+ * @returns A UIImage with the snapshot of @c view.
+ */
+UIImage* NISnapshotOfViewWithTransparencyAtScale(UIView* view, CGFloat scale);
+
 #if defined __cplusplus
 }
 #endif
@@ -198,6 +213,29 @@ UIImageView* NISnapshotViewOfViewWithTransparency(UIView* view);
 
 /** @name Implementing UIViewController Autorotation */
 
+/** @name Configuring Snapshots */
+
+/**
+ * Whether the rotating view is captured with resizable snapshot views instead of images.
+ *
+ * Snapshot views are made by the render server from what is already on screen, so capturing
+ * one does not render the view hierarchy on the CPU or allocate a bitmap. They are only used on
+ * iOS 7 and higher, and only if the delegate doesn't implement fixedInsetsForSnapshotRotation:,
+ * because the insets are not known until after the first snapshot has been taken.
+ *
+ * @fn NISnapshotRotation::usesSnapshotViews
+ */
+
+/**
+ * The scale of the snapshot images.
+ *
+ * The snapshots are only visible for the length of the rotation animation, while they are being
+ * stretched and cross-faded, so a scale below the screen's is rarely noticeable. Their bitmaps
+ * come from the shared NIBitmapBufferPool at any scale.
+ *
+ * @fn NISnapshotRotation::snapshotScale
+ */
+
 /**
  * Prepares the animation for a rotation by taking a snapshot of the rotatingView in its current
  * state.
@@ -19,6 +19,7 @@
 
 #import "NISnapshotRotation.h"
 
+#import "NIBitmapBufferPool.h"
 #import "NIDebuggingTools.h"
 #import "NISDKAvailability.h"
 #import <QuartzCore/QuartzCore.h>
@@ -28,14 +29,31 @@
 #error "Nimbus Snapshot Rotation requires iOS 6 or higher."
 #endif
 
-UIImage* NISnapshotOfViewWithTransparencyOption(UIView* view, BOOL transparency);
+UIImage* NISnapshotOfViewWithOptions(UIView* view, BOOL transparency, CGFloat scale);
 
-UIImage* NISnapshotOfViewWithTransparencyOption(UIView* view, BOOL transparency) {
-  // Passing 0 as the last argument ensures that the image context will match the current device's
-  // scaling mode.
-  UIGraphicsBeginImageContextWithOptions(view.bounds.size, !transparency, 0);
+UIImage* NISnapshotOfViewWithOptions(UIView* view, BOOL transparency, CGFloat scale) {
+  // Snapshots are taken at the same size every time a view rotates, so their backing stores
+  // are reused from the shared pool.
+  if (scale <= 0) {
+    scale = [UIScreen mainScreen].scale;
+  }
+  CGSize size = view.bounds.size;
+  CGBitmapInfo bitmapInfo = (CGBitmapInfo)(transparency
+                                           ? kCGImageAlphaPremultipliedLast
+                                           : kCGImageAlphaNoneSkipLast);
+  NIBitmapBufferPool* pool = [NIBitmapBufferPool sharedPool];
+  CGContextRef cx = [pool newBitmapContextWithWidth:(size_t)ceil(size.width * scale)
+                                             height:(size_t)ceil(size.height * scale)
+                                         bitmapInfo:bitmapInfo];
+  if (NULL == cx) {
+    return nil;
+  }
 
-  CGContextRef cx = UIGraphicsGetCurrentContext();
+  // Match the flipped, scaled coordinate space that UIGraphicsBeginImageContextWithOptions
+  // would have given us.
+  CGContextTranslateCTM(cx, 0, CGBitmapContextGetHeight(cx));
+  CGContextScaleCTM(cx, scale, -scale);
+  UIGraphicsPushContext(cx);
 
   // Views that can scroll do so by modifying their bounds. We want to capture the part of the view
   // that is currently in the frame, so we offset by the bounds of the view accordingly.
@@ -51,14 +69,22 @@ UIImage* NISnapshotOfViewWithTransparencyOption(UIView* view, BOOL transparency)
     [view.layer renderInContext:cx];
   }
 
-  UIImage* image = UIGraphicsGetImageFromCurrentImageContext();
-  UIGraphicsEndImageContext();
+  UIGraphicsPopContext();
+
+  CGImageRef imageRef = [pool newImageFromBitmapContext:cx];
+  CGContextRelease(cx);
+
+  UIImage* image = nil;
+  if (NULL != imageRef) {
+    image = [UIImage imageWithCGImage:imageRef scale:scale orientation:UIImageOrientationUp];
+    CGImageRelease(imageRef);
+  }
 
   return image;
 }
 
 UIImage* NISnapshotOfView(UIView* view) {
-  return NISnapshotOfViewWithTransparencyOption(view, NO);
+  return NISnapshotOfViewWithOptions(view, NO, 0);
 }
 
 UIImageView* NISnapshotViewOfView(UIView* view) {
@@ -71,7 +97,11 @@ UIImageView* NISnapshotViewOfView(UIView* view) {
 }
 
 UIImage* NISnapshotOfViewWithTransparency(UIView* view) {
-  return NISnapshotOfViewWithTransparencyOption(view, YES);
+  return NISnapshotOfViewWithOptions(view, YES, 0);
+}
+
+UIImage* NISnapshotOfViewWithTransparencyAtScale(UIView* view, CGFloat scale) {
+  return NISnapshotOfViewWithOptions(view, YES, scale);
 }
 
 UIImageView* NISnapshotViewOfViewWithTransparency(UIView* view) {
@@ -88,8 +118,9 @@ UIImageView* NISnapshotViewOfViewWithTransparency(UIView* view) {
 @property (nonatomic, assign) CGRect frameBeforeRotation;
 @property (nonatomic, assign) CGRect frameAfterRotation;
 
-@property (nonatomic, strong) UIImageView* snapshotViewBeforeRotation;
-@property (nonatomic, strong) UIImageView* snapshotViewAfterRotation;
+// Image views, or resizable snapshot views when usesSnapshotViews applies.
+@property (nonatomic, strong) UIView* snapshotViewBeforeRotation;
+@property (nonatomic, strong) UIView* snapshotViewAfterRotation;
 @end
 
 @implementation NISnapshotRotation
@@ -109,6 +140,28 @@ UIImageView* NISnapshotViewOfViewWithTransparency(UIView* view) {
   return [self initWithDelegate:nil];
 }
 
+- (BOOL)shouldUseSnapshotViews {
+  return (self.usesSnapshotViews
+          && [UIView instancesRespondToSelector:@selector(resizableSnapshotViewFromRect:afterScreenUpdates:withCapInsets:)]
+          && ![self.delegate respondsToSelector:@selector(fixedInsetsForSnapshotRotation:)]);
+}
+
+- (UIView *)snapshotViewOfView:(UIView *)view afterScreenUpdates:(BOOL)afterScreenUpdates {
+  UIView* snapshotView = nil;
+#if __IPHONE_OS_VERSION_MAX_ALLOWED >= NIIOS_7_0
+  if ([self shouldUseSnapshotViews]) {
+    snapshotView = [view resizableSnapshotViewFromRect:view.bounds
+                                    afterScreenUpdates:afterScreenUpdates
+                                         withCapInsets:UIEdgeInsetsZero];
+  }
+#endif
+  if (nil == snapshotView) {
+    snapshotView = [[UIImageView alloc] initWithImage:NISnapshotOfViewWithTransparencyAtScale(view, self.snapshotScale)];
+  }
+  snapshotView.frame = view.frame;
+  return snapshotView;
+}
+
 - (void)willRotateToInterfaceOrientation:(UIInterfaceOrientation)toInterfaceOrientation duration:(NSTimeInterval)duration {
   if (!self.isSupportedOS) {
     return;
@@ -124,7 +177,8 @@ UIImageView* NISnapshotViewOfViewWithTransparency(UIView* view) {
   }
 
   self.frameBeforeRotation = rotationView.frame;
-  self.snapshotViewBeforeRotation = NISnapshotViewOfViewWithTransparency(rotationView);
+  // The view is still showing its current state, so the snapshot needn't wait for an update.
+  self.snapshotViewBeforeRotation = [self snapshotViewOfView:rotationView afterScreenUpdates:NO];
   [containerView insertSubview:self.snapshotViewBeforeRotation aboveSubview:rotationView];
 }
 
@@ -146,29 +200,29 @@ UIImageView* NISnapshotViewOfViewWithTransparency(UIView* view) {
   
   [UIView setAnimationsEnabled:NO];
   
-  self.snapshotViewAfterRotation = NISnapshotViewOfViewWithTransparency(rotationView);
+  self.snapshotViewAfterRotation = [self snapshotViewOfView:rotationView afterScreenUpdates:YES];
+  CGFloat heightBeforeRotation = self.snapshotViewBeforeRotation.frame.size.height;
+  CGFloat heightAfterRotation = self.snapshotViewAfterRotation.frame.size.height;
   // Set the new frame while maintaining the old frame's height.
   self.snapshotViewAfterRotation.frame = CGRectMake(self.frameBeforeRotation.origin.x,
                                                     self.frameBeforeRotation.origin.y,
                                                     self.frameBeforeRotation.size.width,
-                                                    self.snapshotViewAfterRotation.frame.size.height);
-  
-  UIImage* imageBeforeRotation = self.snapshotViewBeforeRotation.image;
-  UIImage* imageAfterRotation = self.snapshotViewAfterRotation.image;
+                                                    heightAfterRotation);
 
-  if ([self.delegate respondsToSelector:@selector(fixedInsetsForSnapshotRotation:)]) {
+  if ([self.delegate respondsToSelector:@selector(fixedInsetsForSnapshotRotation:)]
+      && [self.snapshotViewBeforeRotation isKindOfClass:[UIImageView class]]
+      && [self.snapshotViewAfterRotation isKindOfClass:[UIImageView class]]) {
     UIEdgeInsets fixedInsets = [self.delegate fixedInsetsForSnapshotRotation:self];
 
-    imageBeforeRotation = [imageBeforeRotation resizableImageWithCapInsets:fixedInsets resizingMode:UIImageResizingModeStretch];
-    imageAfterRotation = [imageAfterRotation resizableImageWithCapInsets:fixedInsets resizingMode:UIImageResizingModeStretch];
+    UIImageView* imageViewBeforeRotation = (UIImageView *)self.snapshotViewBeforeRotation;
+    UIImageView* imageViewAfterRotation = (UIImageView *)self.snapshotViewAfterRotation;
+    imageViewBeforeRotation.image = [imageViewBeforeRotation.image resizableImageWithCapInsets:fixedInsets resizingMode:UIImageResizingModeStretch];
+    imageViewAfterRotation.image = [imageViewAfterRotation.image resizableImageWithCapInsets:fixedInsets resizingMode:UIImageResizingModeStretch];
   }
 
-  self.snapshotViewBeforeRotation.image = imageBeforeRotation;
-  self.snapshotViewAfterRotation.image = imageAfterRotation;
-
   [UIView setAnimationsEnabled:YES];
 
-  if (imageAfterRotation.size.height < imageBeforeRotation.size.height) {
+  if (heightAfterRotation < heightBeforeRotation) {
     self.snapshotViewAfterRotation.alpha = 0;
 
     [containerView insertSubview:self.snapshotViewAfterRotation aboveSubview:self.snapshotViewBeforeRotation];
@@ -16,8 +16,64 @@
 
 #import <Foundation/Foundation.h>
 
+@class NIBloomFilter;
+@class NIDiskCache;
 @class NIImageMemoryCache;
 
+/**
+ * An object that holds memory on behalf of the app and can give it back on request.
+ *
+ * Conforming objects can be added to the global memory budget with
+ * Nimbus::addMemoryBudgetConsumer:priority:.
+ *
+ * @ingroup Core-State
+ */
+@protocol NIMemoryBudgetConsumer <NSObject>
+
+/**
+ * The number of bytes currently held by the consumer.
+ */
+- (unsigned long long)numberOfBytesInMemoryBudget;
+
+/**
+ * Releases at least the given number of bytes if the consumer holds that many, starting with
+ * the bytes the consumer values least.
+ *
+ * May be called on any thread.
+ */
+- (void)reduceMemoryUsageByNumberOfBytes:(unsigned long long)numberOfBytes;
+
+@end
+
+/**
+ * Priorities for consumers of the memory budget. Consumers with lower priorities give up their
+ * bytes first. Any integer may be used; these are provided as reference points.
+ *
+ * @ingroup Core-State
+ */
+extern const NSInteger NIMemoryBudgetPriorityLow;
+extern const NSInteger NIMemoryBudgetPriorityDefault;
+extern const NSInteger NIMemoryBudgetPriorityHigh;
+
+/**
+ * The kinds of network connection that Nimbus adapts its network concurrency to.
+ *
+ * @ingroup Core-State
+ */
+typedef enum {
+  NINetworkConnectionTypeUnknown = 0,
+  NINetworkConnectionTypeNone,
+  NINetworkConnectionTypeCellular,
+  NINetworkConnectionTypeWiFi,
+} NINetworkConnectionType;
+
+/**
+ * Posted on the main thread when the adaptive limits change.
+ *
+ * @ingroup Core-State
+ */
+extern NSString* const NIDeviceConditionsDidChangeNotification;
+
 /**
  * For modifying Nimbus state information.
  *
@@ -63,6 +119,26 @@
  */
 + (NSOperationQueue *)networkOperationQueue;
 
+/**
+ * Access the global filter of network paths that recently failed to load.
+ *
+ * Network image views skip paths in this filter rather than requesting them again. Only
+ * permanent failures are added; see NIIsPermanentLoadFailure(). If a filter
+ * hasn't been assigned via Nimbus::setFailedNetworkPathFilter: then one will be created
+ * automatically that remembers 1024 paths for five minutes.
+ */
++ (NIBloomFilter *)failedNetworkPathFilter;
+
+/**
+ * Access the global disk cache of images that have been processed for display.
+ *
+ * Network image views store the images they have cropped and resized here so that later
+ * launches don't need to download, decode, or process them again. If a cache hasn't been
+ * assigned via Nimbus::setProcessedImageDiskCache: then one named "NimbusProcessedImages" that
+ * holds up to 50 megabytes will be created automatically.
+ */
++ (NIDiskCache *)processedImageDiskCache;
+
 #pragma mark Modifying Global State /** @name Modifying Global State */
 
 /**
@@ -79,6 +155,155 @@
  */
 + (void)setNetworkOperationQueue:(NSOperationQueue *)queue;
 
+/**
+ * Set the global filter of network paths that recently failed to load.
+ *
+ * The filter's retention interval is how long a failed path waits before it is retried.
+ */
++ (void)setFailedNetworkPathFilter:(NIBloomFilter *)filter;
+
+/**
+ * Set the global disk cache of processed images.
+ *
+ * Setting nil stops network image views that use the global cache from storing processed
+ * images on disk.
+ */
++ (void)setProcessedImageDiskCache:(NIDiskCache *)diskCache;
+
+#pragma mark Sharing Memory /** @name Sharing Memory */
+
+/**
+ * The number of bytes that all of the memory budget consumers may hold between them.
+ *
+ * When the consumers hold more than the budget, the consumers with the lowest priority are
+ * asked to give up bytes first. Consumers with the same priority give up bytes in proportion to
+ * how many they hold. Defaults to 0, which is special cased to represent an unlimited budget.
+ */
++ (unsigned long long)memoryBudget;
+
+/**
+ * Set the number of bytes that all of the memory budget consumers may hold between them.
+ *
+ * The budget is enforced right away.
+ */
++ (void)setMemoryBudget:(unsigned long long)memoryBudget;
+
+/**
+ * Adds a consumer to the memory budget with the given priority.
+ *
+ * The consumer is not retained and is removed from the budget automatically when it is
+ * deallocated. Adding a consumer that has already been added changes its priority.
+ *
+ * The global image memory cache is added with NIMemoryBudgetPriorityDefault.
+ */
++ (void)addMemoryBudgetConsumer:(id<NIMemoryBudgetConsumer>)consumer priority:(NSInteger)priority;
+
+/**
+ * Removes a consumer from the memory budget.
+ */
++ (void)removeMemoryBudgetConsumer:(id<NIMemoryBudgetConsumer>)consumer;
+
+/**
+ * The number of bytes held by all of the memory budget consumers.
+ */
++ (unsigned long long)numberOfBytesInMemoryBudget;
+
+/**
+ * Asks the consumers to give up bytes until they fit in the memory budget.
+ *
+ * Runs synchronously on the calling thread.
+ */
++ (void)enforceMemoryBudget;
+
+/**
+ * Enforces the memory budget on a background queue in the near future.
+ *
+ * Consumers call this when they grow. Calls made before the budget is enforced are coalesced,
+ * and the call does nothing when there is no budget, so it is cheap enough to call on every
+ * store.
+ */
++ (void)setNeedsMemoryBudgetEnforcement;
+
+#pragma mark Adapting to Device Conditions /** @name Adapting to Device Conditions */
+
+/**
+ * Whether Nimbus adapts its concurrency to the network and to the state of the device.
+ *
+ * When enabled, the limits below are recomputed from the network connection type, the
+ * throughput of recent network tasks, Low Power Mode and the thermal state. The global network
+ * operation queue's maxConcurrentOperationCount is kept at
+ * Nimbus::adaptiveMaxConcurrentNetworkOperationCount. When disabled, the queue goes back to the
+ * system's default width and the other limits stop limiting. Defaults to YES.
+ *
+ * Must only be used from the main thread.
+ */
++ (BOOL)adaptsToDeviceConditions;
+
+/**
+ * Sets whether Nimbus adapts its concurrency to the network and to the state of the device.
+ */
++ (void)setAdaptsToDeviceConditions:(BOOL)adaptsToDeviceConditions;
+
+/**
+ * The type of the current network connection.
+ *
+ * Nimbus core doesn't watch reachability itself. The network image feature reports the
+ * connection type here, as may any other code that watches reachability.
+ */
++ (NINetworkConnectionType)networkConnectionType;
+
+/**
+ * Reports the type of the current network connection and updates the adaptive limits.
+ */
++ (void)setNetworkConnectionType:(NINetworkConnectionType)networkConnectionType;
+
+/**
+ * The number of bytes per second received by recent network tasks, or 0 if too few tasks have
+ * finished recently to tell.
+ *
+ * Computed from the task metrics of NINetworkActivity when the adaptive limits were last updated.
+ */
++ (double)recentNetworkThroughput;
+
+/**
+ * How many network operations should run at once.
+ *
+ * Wider on Wi-Fi and fast connections, narrower on cellular and slow connections, and halved
+ * in Low Power Mode or when the device has started to throttle itself.
+ */
++ (NSInteger)adaptiveMaxConcurrentNetworkOperationCount;
+
+/**
+ * How many images should be decoded or processed at once, or 0 for no limit.
+ *
+ * Starts at the number of active processors and backs off to a single image as the device
+ * heats up. Always 0 when Nimbus doesn't adapt to device conditions.
+ */
++ (NSInteger)adaptiveMaxConcurrentImageDecodeCount;
+
+/**
+ * The fraction of their usual depth that prefetchers should prefetch to, from 0 to 1.
+ *
+ * Always 1 when Nimbus doesn't adapt to device conditions.
+ */
++ (double)adaptivePrefetchDepthScale;
+
+/**
+ * Recomputes the adaptive limits now.
+ *
+ * Posts NIDeviceConditionsDidChangeNotification if any of them changed. Changes to the
+ * connection type, Low Power Mode and the thermal state are picked up automatically.
+ */
++ (void)updateForDeviceConditions;
+
+/**
+ * Recomputes the adaptive limits unless they were recomputed in the last few seconds.
+ *
+ * Network code calls this as tasks finish so that the limits follow the throughput. It is
+ * cheap enough to call for every task.
+ */
++ (void)setNeedsDeviceConditionsUpdate;
+
 @end
 
 /**@}*/// End of State ////////////////////////////////////////////////////////////////////////////
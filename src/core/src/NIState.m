@@ -16,14 +16,152 @@
 
 #import "NIState.h"
 
+#import "NIBloomFilter.h"
+#import "NIDebuggingTools.h"
+#import "NIDiskCache.h"
 #import "NIInMemoryCache.h"
+#import "NILaunchProfile.h"
+#import "NINetworkActivity.h"
+
+#import <QuartzCore/QuartzCore.h>
+#import <stdatomic.h>
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "Nimbus requires ARC support."
 #endif
 
+const NSInteger NIMemoryBudgetPriorityLow = -100;
+const NSInteger NIMemoryBudgetPriorityDefault = 0;
+const NSInteger NIMemoryBudgetPriorityHigh = 100;
+
+NSString* const NIDeviceConditionsDidChangeNotification = @"NIDeviceConditionsDidChangeNotification";
+
 static NIImageMemoryCache* sNimbusGlobalMemoryCache = nil;
 static NSOperationQueue* sNimbusGlobalOperationQueue = nil;
+static NIBloomFilter* sNimbusGlobalFailedNetworkPathFilter = nil;
+static NIDiskCache* sNimbusGlobalProcessedImageDiskCache = nil;
+static BOOL sNimbusGlobalProcessedImageDiskCacheIsSet = NO;
+
+// The memory budget is read on every store of every cache, so it's kept in atomics rather than
+// behind the lock that guards the consumers.
+static atomic_ullong sNimbusMemoryBudget = 0;
+static atomic_bool sNimbusMemoryBudgetEnforcementIsScheduled = false;
+
+// The adaptive limits are only touched on the main thread.
+static BOOL sNimbusAdaptsToDeviceConditions = YES;
+static NINetworkConnectionType sNimbusNetworkConnectionType = NINetworkConnectionTypeUnknown;
+static double sNimbusRecentNetworkThroughput = 0;
+static NSInteger sNimbusMaxConcurrentNetworkOperationCount = 4;
+static NSInteger sNimbusMaxConcurrentImageDecodeCount = 0;
+static double sNimbusPrefetchDepthScale = 1;
+static CFTimeInterval sNimbusDeviceConditionsUpdateTime = 0;
+
+// Throughput is only measured over tasks that finished this recently and were large enough for
+// their transfer time to outweigh their latency.
+static const CFTimeInterval kNIThroughputWindow = 30;
+static const unsigned long long kNIThroughputMinimumNumberOfBytes = 16 * 1024;
+static const double kNISlowNetworkThroughput = 64 * 1024;
+static const double kNIFastNetworkThroughput = 1024 * 1024;
+
+// setNeedsDeviceConditionsUpdate recomputes the limits at most this often.
+static const CFTimeInterval kNIDeviceConditionsUpdateInterval = 5;
+
+// A consumer of the memory budget. Consumers are held weakly so that they drop out of the budget
+// when they're deallocated.
+@interface NIMemoryBudgetEntry : NSObject
+@property (nonatomic, weak) id<NIMemoryBudgetConsumer> consumer;
+@property (nonatomic) NSInteger priority;
+@end
+
+@implementation NIMemoryBudgetEntry
+@end
+
+static NSMutableArray* NIMemoryBudgetEntries(void) {
+  static NSMutableArray* sEntries = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sEntries = [[NSMutableArray alloc] init];
+  });
+  return sEntries;
+}
+
+// Returns the live entries sorted by priority, lowest first, and drops the deallocated ones.
+static NSArray* NIMemoryBudgetLiveEntries(void) {
+  NSMutableArray* entries = NIMemoryBudgetEntries();
+  @synchronized(entries) {
+    [entries filterUsingPredicate:[NSPredicate predicateWithBlock:^BOOL(NIMemoryBudgetEntry* entry, NSDictionary* bindings) {
+      return (nil != entry.consumer);
+    }]];
+    return [entries sortedArrayUsingComparator:^NSComparisonResult(NIMemoryBudgetEntry* entry1, NIMemoryBudgetEntry* entry2) {
+      if (entry1.priority == entry2.priority) {
+        return NSOrderedSame;
+      }
+      return (entry1.priority < entry2.priority) ? NSOrderedAscending : NSOrderedDescending;
+    }];
+  }
+}
+
+// Returns the bytes per second received by recently finished tasks, or 0 if there weren't any.
+static double NIRecentNetworkThroughput(CFTimeInterval now) {
+  static const NSUInteger kMaximumNumberOfMetrics = 64;
+  NINetworkTaskMetrics metrics[kMaximumNumberOfMetrics];
+  NSUInteger numberOfMetrics = NINetworkTaskMetricsCopyRecent(metrics, kMaximumNumberOfMetrics);
+  unsigned long long numberOfBytes = 0;
+  CFTimeInterval duration = 0;
+  for (NSUInteger ix = 0; ix < numberOfMetrics; ++ix) {
+    NINetworkTaskMetrics* task = &metrics[ix];
+    if (task->startTimestamp + task->duration < now - kNIThroughputWindow
+        || task->numberOfBytes < kNIThroughputMinimumNumberOfBytes) {
+      continue;
+    }
+    // Time spent waiting for the first byte is latency rather than transfer time.
+    CFTimeInterval transferDuration = task->duration - MAX(0, task->timeToFirstByte);
+    if (transferDuration <= 0) {
+      continue;
+    }
+    numberOfBytes += task->numberOfBytes;
+    duration += transferDuration;
+  }
+  return (duration > 0) ? (double)numberOfBytes / duration : 0;
+}
+
+// Low Power Mode arrived in iOS 9 and thermal states in iOS 11, each with a notification that is
+// weakly linked on older systems.
+static BOOL NIIsLowPowerModeSupported(void) {
+  return (&NSProcessInfoPowerStateDidChangeNotification != NULL);
+}
+
+static BOOL NIIsThermalStateSupported(void) {
+  return (&NSProcessInfoThermalStateDidChangeNotification != NULL);
+}
+
+// Starts recomputing the adaptive limits whenever Low Power Mode or the thermal state changes.
+static void NIStartObservingDeviceConditions(void) {
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    dispatch_async(dispatch_get_main_queue(), ^{
+      NSNotificationCenter* notificationCenter = [NSNotificationCenter defaultCenter];
+      void (^update)(NSNotification*) = ^(NSNotification* notification) {
+        [Nimbus updateForDeviceConditions];
+      };
+      // Both notifications may be posted on any thread. Older systems have neither Low Power
+      // Mode nor thermal states, so there is nothing to observe there.
+      if (NIIsLowPowerModeSupported()) {
+        [notificationCenter addObserverForName:NSProcessInfoPowerStateDidChangeNotification
+                                        object:nil
+                                         queue:[NSOperationQueue mainQueue]
+                                    usingBlock:update];
+      }
+      if (NIIsThermalStateSupported()) {
+        [notificationCenter addObserverForName:NSProcessInfoThermalStateDidChangeNotification
+                                        object:nil
+                                         queue:[NSOperationQueue mainQueue]
+                                    usingBlock:update];
+      }
+      [Nimbus updateForDeviceConditions];
+    });
+  });
+}
 
 @implementation Nimbus
 
@@ -31,12 +169,18 @@ static NSOperationQueue* sNimbusGlobalOperationQueue = nil;
   if (sNimbusGlobalMemoryCache != imageMemoryCache) {
     sNimbusGlobalMemoryCache = nil;
     sNimbusGlobalMemoryCache = imageMemoryCache;
+    if (nil != imageMemoryCache) {
+      [self addMemoryBudgetConsumer:imageMemoryCache priority:NIMemoryBudgetPriorityDefault];
+    }
   }
 }
 
 + (NIImageMemoryCache *)imageMemoryCache {
   if (nil == sNimbusGlobalMemoryCache) {
-    sNimbusGlobalMemoryCache = [[NIImageMemoryCache alloc] init];
+    NIMeasureFirstUse(@"Nimbus image memory cache", ^{
+      sNimbusGlobalMemoryCache = [[NIImageMemoryCache alloc] init];
+      [self addMemoryBudgetConsumer:sNimbusGlobalMemoryCache priority:NIMemoryBudgetPriorityDefault];
+    });
   }
   return sNimbusGlobalMemoryCache;
 }
@@ -45,14 +189,317 @@ static NSOperationQueue* sNimbusGlobalOperationQueue = nil;
   if (sNimbusGlobalOperationQueue != queue) {
     sNimbusGlobalOperationQueue = nil;
     sNimbusGlobalOperationQueue = queue;
+    if (nil != queue && sNimbusAdaptsToDeviceConditions) {
+      queue.maxConcurrentOperationCount = sNimbusMaxConcurrentNetworkOperationCount;
+    }
   }
 }
 
 + (NSOperationQueue *)networkOperationQueue {
   if (nil == sNimbusGlobalOperationQueue) {
     sNimbusGlobalOperationQueue = [[NSOperationQueue alloc] init];
+    if (sNimbusAdaptsToDeviceConditions) {
+      sNimbusGlobalOperationQueue.maxConcurrentOperationCount = sNimbusMaxConcurrentNetworkOperationCount;
+    }
+    NIStartObservingDeviceConditions();
   }
   return sNimbusGlobalOperationQueue;
 }
 
++ (void)setFailedNetworkPathFilter:(NIBloomFilter *)filter {
+  @synchronized(self) {
+    sNimbusGlobalFailedNetworkPathFilter = filter;
+  }
+}
+
++ (NIBloomFilter *)failedNetworkPathFilter {
+  @synchronized(self) {
+    if (nil == sNimbusGlobalFailedNetworkPathFilter) {
+      sNimbusGlobalFailedNetworkPathFilter = [[NIBloomFilter alloc] initWithCapacity:1024
+                                                                   falsePositiveRate:0.001
+                                                                   retentionInterval:5 * 60];
+    }
+    return sNimbusGlobalFailedNetworkPathFilter;
+  }
+}
+
++ (void)setProcessedImageDiskCache:(NIDiskCache *)diskCache {
+  @synchronized(self) {
+    sNimbusGlobalProcessedImageDiskCache = diskCache;
+    sNimbusGlobalProcessedImageDiskCacheIsSet = YES;
+  }
+}
+
++ (NIDiskCache *)processedImageDiskCache {
+  @synchronized(self) {
+    // nil is a valid choice, so only create the default cache if nothing has been set.
+    if (!sNimbusGlobalProcessedImageDiskCacheIsSet) {
+      sNimbusGlobalProcessedImageDiskCache = [[NIDiskCache alloc] initWithName:@"NimbusProcessedImages"];
+      sNimbusGlobalProcessedImageDiskCache.maxNumberOfBytes = 50 * 1024 * 1024;
+      sNimbusGlobalProcessedImageDiskCacheIsSet = YES;
+    }
+    return sNimbusGlobalProcessedImageDiskCache;
+  }
+}
+
+#pragma mark - Memory Budget
+
++ (unsigned long long)memoryBudget {
+  return atomic_load_explicit(&sNimbusMemoryBudget, memory_order_relaxed);
+}
+
++ (void)setMemoryBudget:(unsigned long long)memoryBudget {
+  atomic_store_explicit(&sNimbusMemoryBudget, memoryBudget, memory_order_relaxed);
+  [self enforceMemoryBudget];
+}
+
++ (void)addMemoryBudgetConsumer:(id<NIMemoryBudgetConsumer>)consumer priority:(NSInteger)priority {
+  if (nil == consumer) {
+    return;
+  }
+  NSMutableArray* entries = NIMemoryBudgetEntries();
+  @synchronized(entries) {
+    for (NIMemoryBudgetEntry* entry in entries) {
+      if (entry.consumer == consumer) {
+        entry.priority = priority;
+        return;
+      }
+    }
+    NIMemoryBudgetEntry* entry = [[NIMemoryBudgetEntry alloc] init];
+    entry.consumer = consumer;
+    entry.priority = priority;
+    [entries addObject:entry];
+  }
+  [self setNeedsMemoryBudgetEnforcement];
+}
+
++ (void)removeMemoryBudgetConsumer:(id<NIMemoryBudgetConsumer>)consumer {
+  NSMutableArray* entries = NIMemoryBudgetEntries();
+  @synchronized(entries) {
+    [entries filterUsingPredicate:[NSPredicate predicateWithBlock:^BOOL(NIMemoryBudgetEntry* entry, NSDictionary* bindings) {
+      return (nil != entry.consumer && entry.consumer != consumer);
+    }]];
+  }
+}
+
++ (unsigned long long)numberOfBytesInMemoryBudget {
+  unsigned long long numberOfBytes = 0;
+  for (NIMemoryBudgetEntry* entry in NIMemoryBudgetLiveEntries()) {
+    numberOfBytes += [entry.consumer numberOfBytesInMemoryBudget];
+  }
+  return numberOfBytes;
+}
+
++ (void)enforceMemoryBudget {
+  unsigned long long memoryBudget = [self memoryBudget];
+  if (0 == memoryBudget) {
+    return;
+  }
+
+  // Hold on to the consumers so that none of them go away part way through.
+  NSMutableArray* consumers = [NSMutableArray array];
+  NSMutableArray* priorities = [NSMutableArray array];
+  NSMutableArray* sizes = [NSMutableArray array];
+  unsigned long long numberOfBytes = 0;
+  for (NIMemoryBudgetEntry* entry in NIMemoryBudgetLiveEntries()) {
+    id<NIMemoryBudgetConsumer> consumer = entry.consumer;
+    if (nil == consumer) {
+      continue;
+    }
+    unsigned long long size = [consumer numberOfBytesInMemoryBudget];
+    [consumers addObject:consumer];
+    [priorities addObject:@(entry.priority)];
+    [sizes addObject:@(size)];
+    numberOfBytes += size;
+  }
+  if (numberOfBytes <= memoryBudget) {
+    return;
+  }
+  unsigned long long excess = numberOfBytes - memoryBudget;
+
+  // Visit the consumers one priority at a time, lowest first.
+  NSUInteger start = 0;
+  while (start < consumers.count && excess > 0) {
+    NSInteger priority = [priorities[start] integerValue];
+    NSUInteger end = start;
+    unsigned long long sizeOfPriority = 0;
+    while (end < consumers.count && [priorities[end] integerValue] == priority) {
+      sizeOfPriority += [sizes[end] unsignedLongLongValue];
+      ++end;
+    }
+
+    // Consumers with the same priority give up bytes in proportion to how many they hold.
+    unsigned long long numberOfBytesToRelease = MIN(excess, sizeOfPriority);
+    unsigned long long remaining = numberOfBytesToRelease;
+    for (NSUInteger ix = start; ix < end && remaining > 0 && sizeOfPriority > 0; ++ix) {
+      unsigned long long size = [sizes[ix] unsignedLongLongValue];
+      unsigned long long share = (ix == end - 1)
+                                 ? remaining
+                                 : MIN(remaining, (unsigned long long)((double)numberOfBytesToRelease * size / sizeOfPriority));
+      if (share > 0) {
+        [consumers[ix] reduceMemoryUsageByNumberOfBytes:share];
+        remaining -= share;
+      }
+    }
+    excess -= numberOfBytesToRelease;
+    start = end;
+  }
+}
+
++ (void)setNeedsMemoryBudgetEnforcement {
+  if (0 == atomic_load_explicit(&sNimbusMemoryBudget, memory_order_relaxed)) {
+    return;
+  }
+  if (atomic_exchange_explicit(&sNimbusMemoryBudgetEnforcementIsScheduled, true, memory_order_relaxed)) {
+    return;
+  }
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+    atomic_store_explicit(&sNimbusMemoryBudgetEnforcementIsScheduled, false, memory_order_relaxed);
+    [self enforceMemoryBudget];
+  });
+}
+
+#pragma mark - Device Conditions
+
++ (BOOL)adaptsToDeviceConditions {
+  return sNimbusAdaptsToDeviceConditions;
+}
+
++ (void)setAdaptsToDeviceConditions:(BOOL)adaptsToDeviceConditions {
+  NIDASSERT([NSThread isMainThread]);
+  if (sNimbusAdaptsToDeviceConditions == adaptsToDeviceConditions) {
+    return;
+  }
+  if (adaptsToDeviceConditions) {
+    // Brought up to date before they're applied, so that the change is only posted once.
+    [self updateForDeviceConditions];
+  }
+  sNimbusAdaptsToDeviceConditions = adaptsToDeviceConditions;
+  sNimbusGlobalOperationQueue.maxConcurrentOperationCount = (adaptsToDeviceConditions
+                                                             ? sNimbusMaxConcurrentNetworkOperationCount
+                                                             : NSOperationQueueDefaultMaxConcurrentOperationCount);
+  [[NSNotificationCenter defaultCenter] postNotificationName:NIDeviceConditionsDidChangeNotification
+                                                      object:nil];
+}
+
++ (NINetworkConnectionType)networkConnectionType {
+  return sNimbusNetworkConnectionType;
+}
+
++ (void)setNetworkConnectionType:(NINetworkConnectionType)networkConnectionType {
+  NIDASSERT([NSThread isMainThread]);
+  if (sNimbusNetworkConnectionType != networkConnectionType) {
+    sNimbusNetworkConnectionType = networkConnectionType;
+    [self updateForDeviceConditions];
+  }
+}
+
++ (double)recentNetworkThroughput {
+  return sNimbusRecentNetworkThroughput;
+}
+
++ (NSInteger)adaptiveMaxConcurrentNetworkOperationCount {
+  return sNimbusMaxConcurrentNetworkOperationCount;
+}
+
++ (NSInteger)adaptiveMaxConcurrentImageDecodeCount {
+  return sNimbusAdaptsToDeviceConditions ? sNimbusMaxConcurrentImageDecodeCount : 0;
+}
+
++ (double)adaptivePrefetchDepthScale {
+  return sNimbusAdaptsToDeviceConditions ? sNimbusPrefetchDepthScale : 1;
+}
+
++ (void)updateForDeviceConditions {
+  NIDASSERT([NSThread isMainThread]);
+  NIStartObservingDeviceConditions();
+
+  CFTimeInterval now = CACurrentMediaTime();
+  sNimbusDeviceConditionsUpdateTime = now;
+  double throughput = NIRecentNetworkThroughput(now);
+
+  NSInteger networkOperationCount;
+  double prefetchDepthScale;
+  switch (sNimbusNetworkConnectionType) {
+    case NINetworkConnectionTypeWiFi:
+      networkOperationCount = 6;
+      prefetchDepthScale = 1;
+      break;
+    case NINetworkConnectionTypeCellular:
+      networkOperationCount = 3;
+      prefetchDepthScale = 0.5;
+      break;
+    case NINetworkConnectionTypeNone:
+      // Nothing can be fetched until the connection comes back.
+      networkOperationCount = 1;
+      prefetchDepthScale = 0;
+      break;
+    default:
+      networkOperationCount = 4;
+      prefetchDepthScale = 1;
+      break;
+  }
+
+  // What the connection actually delivers trumps what kind of connection it is.
+  if (throughput > 0 && throughput < kNISlowNetworkThroughput) {
+    networkOperationCount = MIN(networkOperationCount, 2);
+    prefetchDepthScale *= 0.5;
+  } else if (throughput >= kNIFastNetworkThroughput) {
+    networkOperationCount += 2;
+  }
+
+  NSProcessInfo* processInfo = [NSProcessInfo processInfo];
+  NSInteger imageDecodeCount = MAX(1, (NSInteger)processInfo.activeProcessorCount);
+  BOOL isLowPowerModeEnabled = NO;
+  if (NIIsLowPowerModeSupported()) {
+    isLowPowerModeEnabled = processInfo.isLowPowerModeEnabled;
+  }
+  if (isLowPowerModeEnabled) {
+    networkOperationCount = MAX(1, networkOperationCount / 2);
+    imageDecodeCount = MAX(1, imageDecodeCount / 2);
+    prefetchDepthScale *= 0.5;
+  }
+  // Systems without thermal states are treated as always running cool.
+  if (NIIsThermalStateSupported()) {
+    switch (processInfo.thermalState) {
+      case NSProcessInfoThermalStateFair:
+        imageDecodeCount = MAX(1, imageDecodeCount - 1);
+        break;
+      case NSProcessInfoThermalStateSerious:
+        networkOperationCount = MAX(1, networkOperationCount / 2);
+        imageDecodeCount = 1;
+        prefetchDepthScale *= 0.5;
+        break;
+      case NSProcessInfoThermalStateCritical:
+        networkOperationCount = 1;
+        imageDecodeCount = 1;
+        prefetchDepthScale = 0;
+        break;
+      default:
+        break;
+    }
+  }
+
+  sNimbusRecentNetworkThroughput = throughput;
+  BOOL didChange = (networkOperationCount != sNimbusMaxConcurrentNetworkOperationCount
+                    || imageDecodeCount != sNimbusMaxConcurrentImageDecodeCount
+                    || prefetchDepthScale != sNimbusPrefetchDepthScale);
+  sNimbusMaxConcurrentNetworkOperationCount = networkOperationCount;
+  sNimbusMaxConcurrentImageDecodeCount = imageDecodeCount;
+  sNimbusPrefetchDepthScale = prefetchDepthScale;
+  // The limits don't apply to anything while Nimbus isn't adapting.
+  if (didChange && sNimbusAdaptsToDeviceConditions) {
+    sNimbusGlobalOperationQueue.maxConcurrentOperationCount = networkOperationCount;
+    [[NSNotificationCenter defaultCenter] postNotificationName:NIDeviceConditionsDidChangeNotification
+                                                        object:nil];
+  }
+}
+
++ (void)setNeedsDeviceConditionsUpdate {
+  NIDASSERT([NSThread isMainThread]);
+  if (CACurrentMediaTime() - sNimbusDeviceConditionsUpdateTime >= kNIDeviceConditionsUpdateInterval) {
+    [self updateForDeviceConditions];
+  }
+}
+
 @end
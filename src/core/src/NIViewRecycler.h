@@ -17,6 +17,8 @@
 #import <Foundation/Foundation.h>
 #import <UIKit/UIKit.h>
 
+#import "NIMemoryPressure.h"
+
 /**
  * For recycling views in scroll views.
  *
@@ -70,11 +72,24 @@ if (nil == view) {
  */
 @interface NIViewRecycler : NSObject
 
++ (NIViewRecycler *)sharedRecycler;
+
 - (UIView<NIRecyclableView> *)dequeueReusableViewWithIdentifier:(NSString *)reuseIdentifier;
 
 - (void)recycleView:(UIView<NIRecyclableView> *)view;
+- (void)removeView:(UIView<NIRecyclableView> *)view;
+
+- (NSUInteger)numberOfViewsWithReuseIdentifier:(NSString *)reuseIdentifier;
+
+@property (nonatomic) NSUInteger defaultMaxNumberOfViews; // Default: 0 (unlimited)
+- (void)setMaxNumberOfViews:(NSUInteger)maxNumberOfViews forReuseIdentifier:(NSString *)reuseIdentifier;
+- (NSUInteger)maxNumberOfViewsForReuseIdentifier:(NSString *)reuseIdentifier;
 
+- (void)prewarmViewsWithIdentifier:(NSString *)reuseIdentifier count:(NSUInteger)count factory:(UIView<NIRecyclableView>* (^)(void))factory;
+
+- (void)trimToNumberOfViews:(NSUInteger)numberOfViews;
 - (void)removeAllViews;
+- (void)reduceMemoryUsageForPressureLevel:(NIMemoryPressureLevel)level;
 
 @end
 
@@ -124,6 +139,23 @@ if (nil == view) {
 
 /**@}*/ // End of View Recyling
 
+/**
+ * Returns a recycler that any number of containers can share.
+ *
+ * Pools are already kept apart by reuse identifier, so containers that show the same kinds of
+ * views can draw from one recycler. Set it as the viewRecycler of each NIPagingScrollView,
+ * NILauncherView or photo album scroll view and the views that one screen built are reused by
+ * the next screen that shows the same views, rather than every container building its own.
+ *
+ * The shared recycler keeps at most 8 views for each reuse identifier by default. Use
+ * setMaxNumberOfViews:forReuseIdentifier: to give an identifier a different bound, or
+ * prewarmViewsWithIdentifier:count:factory: to fill a pool before the first container appears.
+ *
+ * Must only be used from the main thread.
+ *
+ * @fn NIViewRecycler::sharedRecycler
+ */
+
 /**
  * Dequeues a reusable view from the recycled views pool if one exists, otherwise returns nil.
  *
@@ -139,12 +171,90 @@ if (nil == view) {
  *                    via the NIRecyclableView protocol.
  */
 
+/**
+ * Removes a given view from the recycled views pool, if it is there.
+ *
+ * Containers that share a recycler use this to release the views that they recycled without
+ * emptying the pools that other containers are using.
+ *
+ * @fn NIViewRecycler::removeView:
+ */
+
+/**
+ * Returns the number of views with the given identifier that are waiting to be dequeued.
+ *
+ * @fn NIViewRecycler::numberOfViewsWithReuseIdentifier:
+ */
+
+/**
+ * The most views that are kept for any reuse identifier without its own maximum.
+ *
+ * Once a pool is full, recycling another view releases the least recently recycled view in the
+ * pool. Defaults to 0, which is special cased to represent an unlimited number of views.
+ *
+ * @fn NIViewRecycler::defaultMaxNumberOfViews
+ */
+
+/**
+ * Sets the most views that are kept for the given reuse identifier.
+ *
+ * The pool is trimmed right away if it holds more views than the new maximum. 0 means the
+ * pool is unlimited.
+ *
+ * @fn NIViewRecycler::setMaxNumberOfViews:forReuseIdentifier:
+ */
+
+/**
+ * Returns the most views that are kept for the given reuse identifier.
+ *
+ * Returns defaultMaxNumberOfViews if the identifier has no maximum of its own.
+ *
+ * @fn NIViewRecycler::maxNumberOfViewsForReuseIdentifier:
+ */
+
+/**
+ * Builds views ahead of time so that the first scroll does not have to.
+ *
+ * The factory is called from the shared NIIdleScheduler, one view per call, until the pool for
+ * the identifier holds count views or reaches its maximum. Views that are recycled in the
+ * meantime count toward the total. Prewarming stops early if the memory pressure becomes
+ * critical.
+ *
+ * Must be called from the main thread.
+ *
+ * @param reuseIdentifier  The identifier the views will be dequeued with.
+ * @param count            The number of views the pool should hold.
+ * @param factory          Returns a new view with the given identifier.
+ * @fn NIViewRecycler::prewarmViewsWithIdentifier:count:factory:
+ */
+
+/**
+ * Releases the least recently recycled views until no pool holds more than the given number
+ * of views.
+ *
+ * @fn NIViewRecycler::trimToNumberOfViews:
+ */
+
 /**
  * Removes all of the views from the recycled views pool.
  *
+ * Pending prewarming is cancelled as well.
+ *
  * @fn NIViewRecycler::removeAllViews
  */
 
+/**
+ * Reduces the recycled views pool in proportion to the given memory pressure.
+ *
+ * The least recently recycled half of the views for each reuse identifier are removed at the
+ * warning and background levels so that scrolling stays smooth once the app is back on screen.
+ * Every view is removed and prewarming is cancelled when the pressure is critical.
+ *
+ * Called automatically when the NIMemoryPressureCoordinator reports a change.
+ *
+ * @fn NIViewRecycler::reduceMemoryUsageForPressureLevel:
+ */
+
 /**
  * Initializes a newly allocated view with the given reuse identifier.
  *
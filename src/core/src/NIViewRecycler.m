@@ -22,35 +22,144 @@
 #error "Nimbus requires ARC support."
 #endif
 
+// A pending request to fill a pool with views ahead of time.
+@interface NIViewRecyclerPrewarmRequest : NSObject
+@property (nonatomic, copy) NSString* reuseIdentifier;
+@property (nonatomic) NSUInteger count;
+@property (nonatomic, copy) UIView<NIRecyclableView>* (^factory)(void);
+@end
+
+@implementation NIViewRecyclerPrewarmRequest
+@end
+
 @interface NIViewRecycler()
 @property (nonatomic, strong) NSMutableDictionary* reuseIdentifiersToRecycledViews;
+@property (nonatomic, strong) NSMutableDictionary* reuseIdentifiersToMaxNumberOfViews;
+@property (nonatomic, strong) NSMutableArray* prewarmRequests;
+@property (nonatomic, strong) NIIdleTaskToken* prewarmTask;
 @end
 
 @implementation NIViewRecycler
 
 - (void)dealloc {
   [[NSNotificationCenter defaultCenter] removeObserver:self];
+  [self stopPrewarming];
 }
 
 - (id)init {
   if ((self = [super init])) {
     _reuseIdentifiersToRecycledViews = [[NSMutableDictionary alloc] init];
+    _reuseIdentifiersToMaxNumberOfViews = [[NSMutableDictionary alloc] init];
+    _prewarmRequests = [[NSMutableArray alloc] init];
 
-    NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
-    [nc addObserver:self
-           selector:@selector(reduceMemoryUsage)
-               name:UIApplicationDidReceiveMemoryWarningNotification
-             object:nil];
+    [[NIMemoryPressureCoordinator sharedCoordinator] addObserver:self
+                                                         selector:@selector(didReceiveMemoryPressure:)];
   }
   return self;
 }
 
++ (NIViewRecycler *)sharedRecycler {
+  static NIViewRecycler* sharedRecycler = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sharedRecycler = [[NIViewRecycler alloc] init];
+    // Views left behind by screens that are gone shouldn't pile up.
+    sharedRecycler.defaultMaxNumberOfViews = 8;
+  });
+  return sharedRecycler;
+}
+
 #pragma mark - Memory Warnings
 
 - (void)reduceMemoryUsage {
   [self removeAllViews];
 }
 
+- (void)reduceMemoryUsageForPressureLevel:(NIMemoryPressureLevel)level {
+  switch (level) {
+    case NIMemoryPressureLevelNormal:
+      break;
+    case NIMemoryPressureLevelBackground:
+    case NIMemoryPressureLevelWarning:
+      for (NSMutableArray* views in [_reuseIdentifiersToRecycledViews objectEnumerator]) {
+        [self trimViews:views toNumberOfViews:views.count - views.count / 2];
+      }
+      break;
+    case NIMemoryPressureLevelCritical:
+      [self reduceMemoryUsage];
+      break;
+  }
+}
+
+- (void)didReceiveMemoryPressure:(NSNotification *)notification {
+  [self reduceMemoryUsageForPressureLevel:NIMemoryPressureLevelFromNotification(notification)];
+}
+
+#pragma mark - Pools
+
+- (NSMutableArray *)viewsWithReuseIdentifier:(NSString *)reuseIdentifier {
+  NSMutableArray* views = [_reuseIdentifiersToRecycledViews objectForKey:reuseIdentifier];
+  if (nil == views) {
+    views = [[NSMutableArray alloc] init];
+    [_reuseIdentifiersToRecycledViews setObject:views forKey:reuseIdentifier];
+  }
+  return views;
+}
+
+// Views are recycled onto and dequeued from the end of each pool, so the least recently
+// recycled views are at the front.
+- (void)trimViews:(NSMutableArray *)views toNumberOfViews:(NSUInteger)numberOfViews {
+  if (views.count > numberOfViews) {
+    [views removeObjectsInRange:NSMakeRange(0, views.count - numberOfViews)];
+  }
+}
+
+- (BOOL)isPoolFull:(NSMutableArray *)views reuseIdentifier:(NSString *)reuseIdentifier {
+  NSUInteger maxNumberOfViews = [self maxNumberOfViewsForReuseIdentifier:reuseIdentifier];
+  return (maxNumberOfViews > 0 && views.count >= maxNumberOfViews);
+}
+
+#pragma mark - Prewarming
+
+- (void)startPrewarming {
+  if (nil != self.prewarmTask) {
+    return;
+  }
+  __weak NIViewRecycler* weakSelf = self;
+  self.prewarmTask = [[NIIdleScheduler sharedScheduler] scheduleTaskWithPriority:NIIdleTaskPriorityDefault block:^BOOL{
+    return [weakSelf prewarmNextView];
+  }];
+}
+
+- (void)stopPrewarming {
+  [self.prewarmTask cancel];
+  self.prewarmTask = nil;
+}
+
+// Builds one view for the oldest prewarm request. Returns NO once every request is satisfied.
+- (BOOL)prewarmNextView {
+  while (self.prewarmRequests.count > 0) {
+    NIViewRecyclerPrewarmRequest* request = [self.prewarmRequests firstObject];
+    NSMutableArray* views = [self viewsWithReuseIdentifier:request.reuseIdentifier];
+    if (views.count >= request.count || [self isPoolFull:views reuseIdentifier:request.reuseIdentifier]) {
+      [self.prewarmRequests removeObjectAtIndex:0];
+      continue;
+    }
+    UIView<NIRecyclableView>* view = request.factory();
+    NIDASSERT(nil != view);
+    if (nil == view) {
+      [self.prewarmRequests removeObjectAtIndex:0];
+      continue;
+    }
+    // Prewarmed views go to the front of the pool so that trimming releases them before the
+    // views that were actually recycled.
+    [views insertObject:view atIndex:0];
+    return YES;
+  }
+  self.prewarmTask = nil;
+  return NO;
+}
+
 #pragma mark - Public
 
 - (UIView<NIRecyclableView> *)dequeueReusableViewWithIdentifier:(NSString *)reuseIdentifier {
@@ -65,31 +174,95 @@
   return view;
 }
 
-- (void)recycleView:(UIView<NIRecyclableView> *)view {
-  NIDASSERT([view isKindOfClass:[UIView class]]);
-
+- (NSString *)reuseIdentifierForView:(UIView<NIRecyclableView> *)view {
   NSString* reuseIdentifier = nil;
   if ([view respondsToSelector:@selector(reuseIdentifier)]) {
-    reuseIdentifier = [view reuseIdentifier];;
+    reuseIdentifier = [view reuseIdentifier];
   }
   if (nil == reuseIdentifier) {
     reuseIdentifier = NSStringFromClass([view class]);
   }
+  return reuseIdentifier;
+}
+
+- (void)recycleView:(UIView<NIRecyclableView> *)view {
+  NIDASSERT([view isKindOfClass:[UIView class]]);
+
+  NSString* reuseIdentifier = [self reuseIdentifierForView:view];
 
   NIDASSERT(nil != reuseIdentifier);
   if (nil == reuseIdentifier) {
     return;
   }
 
-  NSMutableArray* views = [_reuseIdentifiersToRecycledViews objectForKey:reuseIdentifier];
-  if (nil == views) {
-    views = [[NSMutableArray alloc] init];
-    [_reuseIdentifiersToRecycledViews setObject:views forKey:reuseIdentifier];
+  NSMutableArray* views = [self viewsWithReuseIdentifier:reuseIdentifier];
+  if ([self isPoolFull:views reuseIdentifier:reuseIdentifier]) {
+    [views removeObjectAtIndex:0];
   }
   [views addObject:view];
 }
 
+- (void)removeView:(UIView<NIRecyclableView> *)view {
+  NSString* reuseIdentifier = [self reuseIdentifierForView:view];
+  if (nil == reuseIdentifier) {
+    return;
+  }
+  [[_reuseIdentifiersToRecycledViews objectForKey:reuseIdentifier] removeObjectIdenticalTo:view];
+}
+
+- (NSUInteger)numberOfViewsWithReuseIdentifier:(NSString *)reuseIdentifier {
+  return [[_reuseIdentifiersToRecycledViews objectForKey:reuseIdentifier] count];
+}
+
+- (void)setMaxNumberOfViews:(NSUInteger)maxNumberOfViews forReuseIdentifier:(NSString *)reuseIdentifier {
+  NIDASSERT(nil != reuseIdentifier);
+  if (nil == reuseIdentifier) {
+    return;
+  }
+  [_reuseIdentifiersToMaxNumberOfViews setObject:@(maxNumberOfViews) forKey:reuseIdentifier];
+  if (maxNumberOfViews > 0) {
+    [self trimViews:[_reuseIdentifiersToRecycledViews objectForKey:reuseIdentifier] toNumberOfViews:maxNumberOfViews];
+  }
+}
+
+- (NSUInteger)maxNumberOfViewsForReuseIdentifier:(NSString *)reuseIdentifier {
+  NSNumber* maxNumberOfViews = [_reuseIdentifiersToMaxNumberOfViews objectForKey:reuseIdentifier];
+  return (nil != maxNumberOfViews) ? [maxNumberOfViews unsignedIntegerValue] : self.defaultMaxNumberOfViews;
+}
+
+- (void)setDefaultMaxNumberOfViews:(NSUInteger)defaultMaxNumberOfViews {
+  _defaultMaxNumberOfViews = defaultMaxNumberOfViews;
+  [_reuseIdentifiersToRecycledViews enumerateKeysAndObjectsUsingBlock:^(NSString* reuseIdentifier, NSMutableArray* views, BOOL *stop) {
+    NSUInteger maxNumberOfViews = [self maxNumberOfViewsForReuseIdentifier:reuseIdentifier];
+    if (maxNumberOfViews > 0) {
+      [self trimViews:views toNumberOfViews:maxNumberOfViews];
+    }
+  }];
+}
+
+- (void)prewarmViewsWithIdentifier:(NSString *)reuseIdentifier count:(NSUInteger)count factory:(UIView<NIRecyclableView>* (^)(void))factory {
+  NIDASSERT([NSThread isMainThread]);
+  NIDASSERT(nil != reuseIdentifier && nil != factory);
+  if (nil == reuseIdentifier || nil == factory || 0 == count) {
+    return;
+  }
+  NIViewRecyclerPrewarmRequest* request = [[NIViewRecyclerPrewarmRequest alloc] init];
+  request.reuseIdentifier = reuseIdentifier;
+  request.count = count;
+  request.factory = factory;
+  [self.prewarmRequests addObject:request];
+  [self startPrewarming];
+}
+
+- (void)trimToNumberOfViews:(NSUInteger)numberOfViews {
+  for (NSMutableArray* views in [_reuseIdentifiersToRecycledViews objectEnumerator]) {
+    [self trimViews:views toNumberOfViews:numberOfViews];
+  }
+}
+
 - (void)removeAllViews {
+  [self.prewarmRequests removeAllObjects];
+  [self stopPrewarming];
   [_reuseIdentifiersToRecycledViews removeAllObjects];
 }
 
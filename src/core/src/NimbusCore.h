@@ -99,21 +99,33 @@ view.autoresizingMask = (UIViewAutoresizingFlexibleLeftMargin
 #import <UIKit/UIKit.h>
 
 #import "NIActions.h"
+#import "NIBitmapBufferPool.h"
+#import "NIBloomFilter.h"
 #import "NIButtonUtilities.h"
 #import "NICommonMetrics.h"
+#import "NIConcurrentQueue.h"
 #import "NIDataStructures.h"  // Deprecated. Will be removed after Feb 28, 2014
 #import "NIDebuggingTools.h"
 #import "NIDeviceOrientation.h"
+#import "NIDiskCache.h"
 #import "NIError.h"
+#import "NIFastLock.h"
 #import "NIFoundationMethods.h"
+#import "NIIdleScheduler.h"
+#import "NIImageTable.h"
 #import "NIImageUtilities.h"
 #import "NIInMemoryCache.h"
+#import "NILaunchProfile.h"
+#import "NIMemoryCacheAdmissionPolicy.h"
+#import "NIMemoryPressure.h"
 #import "NINavigationAppearance.h"  // Deprecated. Will be removed after Feb 28, 2014
 #import "NINetworkActivity.h"
 #import "NINonEmptyCollectionTesting.h"
 #import "NINonRetainingCollections.h"
+#import "NIOperationPipeline.h"
 #import "NIOperations.h"
 #import "NIPaths.h"
+#import "NIPrefetchWindow.h"
 #import "NIPreprocessorMacros.h"
 #import "NIRuntimeClassModifications.h"
 #import "NISDKAvailability.h"
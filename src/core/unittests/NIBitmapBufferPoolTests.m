@@ -0,0 +1,87 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NIBitmapBufferPool.h"
+
+@interface NIBitmapBufferPoolTests : XCTestCase
+@end
+
+@implementation NIBitmapBufferPoolTests
+
+- (void)testSizeClassesRoundUpByAtMostAQuarter {
+  size_t pageSize = (size_t)getpagesize();
+  XCTAssertEqual([NIBitmapBufferPool sizeClassForLength:1], pageSize, @"Lengths round up to a page.");
+  XCTAssertEqual([NIBitmapBufferPool sizeClassForLength:pageSize * 4], pageSize * 4, @"Small sizes are exact.");
+  XCTAssertEqual([NIBitmapBufferPool sizeClassForLength:pageSize * 9], pageSize * 10, @"9 pages fall into the 10 page class.");
+
+  for (size_t length = 1; length < 4 * 1024 * 1024; length = length * 3 / 2 + 1) {
+    size_t sizeClass = [NIBitmapBufferPool sizeClassForLength:length];
+    XCTAssertGreaterThanOrEqual(sizeClass, length, @"A size class must fit its length.");
+    size_t pages = (length + pageSize - 1) / pageSize;
+    XCTAssertLessThanOrEqual(sizeClass, MAX(pages * pageSize * 5 / 4, pageSize), @"Size classes waste at most a quarter.");
+  }
+}
+
+- (void)testBuffersAreReturnedWhenImagesAreReleased {
+  NIBitmapBufferPool* pool = [[NIBitmapBufferPool alloc] initWithMaxNumberOfBytes:1024 * 1024];
+
+  CGContextRef context = [pool newBitmapContextWithWidth:100 height:100 bitmapInfo:(CGBitmapInfo)kCGImageAlphaPremultipliedLast];
+  XCTAssertTrue(NULL != context, @"The context should be created.");
+  void* bytes = CGBitmapContextGetData(context);
+
+  CGContextSetRGBFillColor(context, 1, 0, 0, 1);
+  CGContextFillRect(context, CGRectMake(0, 0, 100, 100));
+  CGImageRef imageRef = [pool newImageFromBitmapContext:context];
+  CGContextRelease(context);
+
+  XCTAssertEqual(pool.numberOfBytes, (NSUInteger)0, @"The image still owns the buffer.");
+  XCTAssertEqual(CGImageGetWidth(imageRef), (size_t)100, @"The image should match the context.");
+
+  CGImageRelease(imageRef);
+  XCTAssertGreaterThan(pool.numberOfBytes, (NSUInteger)0, @"The buffer should be back in the pool.");
+
+  context = [pool newBitmapContextWithWidth:100 height:100 bitmapInfo:(CGBitmapInfo)kCGImageAlphaPremultipliedLast];
+  XCTAssertEqual(CGBitmapContextGetData(context), bytes, @"The pooled buffer should be reused.");
+  XCTAssertEqual(pool.numberOfBytes, (NSUInteger)0, @"The buffer should be checked out again.");
+  XCTAssertEqual(((uint32_t *)bytes)[0], (uint32_t)0, @"Reused buffers should be cleared.");
+  CGContextRelease(context);
+}
+
+- (void)testPoolIsBoundedAndTrimmedUnderPressure {
+  NIBitmapBufferPool* pool = [[NIBitmapBufferPool alloc] initWithMaxNumberOfBytes:[NIBitmapBufferPool sizeClassForLength:100 * 100 * 4] * 2];
+
+  CGContextRef contexts[3];
+  for (NSInteger ix = 0; ix < 3; ++ix) {
+    contexts[ix] = [pool newBitmapContextWithWidth:100 height:100 bitmapInfo:(CGBitmapInfo)kCGImageAlphaPremultipliedLast];
+  }
+  for (NSInteger ix = 0; ix < 3; ++ix) {
+    CGContextRelease(contexts[ix]);
+  }
+  XCTAssertEqual(pool.numberOfBytes, pool.maxNumberOfBytes, @"Buffers beyond the limit should be freed.");
+
+  [pool reduceMemoryUsageForPressureLevel:NIMemoryPressureLevelWarning];
+  XCTAssertEqual(pool.numberOfBytes, pool.maxNumberOfBytes / 2, @"Warnings should free half of the pool.");
+
+  [pool reduceMemoryUsageForPressureLevel:NIMemoryPressureLevelCritical];
+  XCTAssertEqual(pool.numberOfBytes, (NSUInteger)0, @"Critical pressure should empty the pool.");
+}
+
+@end
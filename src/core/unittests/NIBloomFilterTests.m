@@ -0,0 +1,84 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NIBloomFilter.h"
+#import "NSDate+UnitTesting.h"
+
+@interface NIBloomFilterTests : XCTestCase
+@end
+
+@implementation NIBloomFilterTests
+
+- (void)testBloomFilterHasNoFalseNegatives {
+  NIBloomFilter* filter = [[NIBloomFilter alloc] initWithCapacity:1000 falsePositiveRate:0.01 retentionInterval:0];
+
+  for (NSInteger ix = 0; ix < 1000; ++ix) {
+    [filter addString:[NSString stringWithFormat:@"http://example.com/images/%d.png", (int)ix]];
+  }
+  for (NSInteger ix = 0; ix < 1000; ++ix) {
+    NSString* string = [NSString stringWithFormat:@"http://example.com/images/%d.png", (int)ix];
+    XCTAssertTrue([filter mightContainString:string], @"Every added string should be found.");
+  }
+
+  NSUInteger numberOfFalsePositives = 0;
+  for (NSInteger ix = 0; ix < 10000; ++ix) {
+    NSString* string = [NSString stringWithFormat:@"http://example.com/other/%d.png", (int)ix];
+    if ([filter mightContainString:string]) {
+      ++numberOfFalsePositives;
+    }
+  }
+  XCTAssertTrue(numberOfFalsePositives < 300, @"The false positive rate should be near 1%%, was %d in 10000.", (int)numberOfFalsePositives);
+
+  [filter removeAllStrings];
+  XCTAssertFalse([filter mightContainString:@"http://example.com/images/0.png"], @"The filter should be empty.");
+}
+
+- (void)testBloomFilterForgetsStringsAfterRetentionInterval {
+  NSDate* now = [NSDate date];
+  NIBloomFilter* filter = [[NIBloomFilter alloc] initWithCapacity:100 falsePositiveRate:0.01 retentionInterval:60];
+  [filter addString:@"old"];
+
+  // This makes [NSDate date] call our fakeDate implementation so that the filter ages without
+  // the test having to wait.
+  [NSDate setFakeDate:[now dateByAddingTimeInterval:40]];
+  [NSDate swizzleMethodsForUnitTesting];
+
+  [filter addString:@"new"];
+  XCTAssertTrue([filter mightContainString:@"old"], @"Strings should last the retention interval.");
+
+  [NSDate setFakeDate:[now dateByAddingTimeInterval:59]];
+  XCTAssertTrue([filter mightContainString:@"old"], @"Strings should last the retention interval.");
+
+  [NSDate setFakeDate:[now dateByAddingTimeInterval:76]];
+  XCTAssertFalse([filter mightContainString:@"old"], @"Old strings should have been forgotten.");
+  XCTAssertTrue([filter mightContainString:@"new"], @"Newer strings should still be remembered.");
+
+  [NSDate setFakeDate:[now dateByAddingTimeInterval:1000]];
+  XCTAssertFalse([filter mightContainString:@"new"], @"Every string should have been forgotten.");
+
+  [filter addString:@"new"];
+  XCTAssertTrue([filter mightContainString:@"new"], @"The filter should keep working after a long gap.");
+
+  // Reset the class implementations when we're done with them.
+  [NSDate swizzleMethodsForUnitTesting];
+}
+
+@end
@@ -0,0 +1,120 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NIConcurrentQueue.h"
+
+@interface NIConcurrentQueueTests : XCTestCase
+@end
+
+@implementation NIConcurrentQueueTests
+
+- (void)testSingleProducerQueueIsFirstInFirstOut {
+  NISingleProducerQueue* queue = [[NISingleProducerQueue alloc] initWithCapacity:4];
+
+  XCTAssertEqual(queue.capacity, (NSUInteger)4, @"The capacity should be a power of two.");
+  for (NSInteger ix = 0; ix < 4; ++ix) {
+    XCTAssertTrue([queue enqueueObject:@(ix)], @"There should be room for the object.");
+  }
+  XCTAssertFalse([queue enqueueObject:@4], @"A full queue should refuse objects.");
+
+  XCTAssertEqualObjects([queue dequeueObject], @0, @"The oldest object should come out first.");
+  XCTAssertTrue([queue enqueueObject:@4], @"Dequeuing should make room.");
+  XCTAssertEqualObjects([queue dequeueAllObjects], (@[@1, @2, @3, @4]), @"Objects should stay in order.");
+  XCTAssertNil([queue dequeueObject], @"The queue should be empty.");
+}
+
+- (void)testMultiProducerQueueKeepsEveryObject {
+  NIMultiProducerQueue* queue = [[NIMultiProducerQueue alloc] initWithCapacity:4096];
+  NSInteger numberOfProducers = 4;
+  NSInteger numberOfObjectsPerProducer = 1000;
+
+  dispatch_apply((size_t)numberOfProducers, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t producer) {
+    for (NSInteger ix = 0; ix < numberOfObjectsPerProducer; ++ix) {
+      [queue enqueueObject:@[@(producer), @(ix)]];
+    }
+  });
+
+  NSArray* objects = [queue dequeueAllObjects];
+  XCTAssertEqual(objects.count, (NSUInteger)(numberOfProducers * numberOfObjectsPerProducer),
+                 @"Every object should have been enqueued.");
+
+  // Each producer's objects should come out in the order it enqueued them.
+  NSMutableDictionary* lastIndexByProducer = [NSMutableDictionary dictionary];
+  for (NSArray* object in objects) {
+    NSNumber* lastIndex = lastIndexByProducer[object[0]];
+    XCTAssertTrue(nil == lastIndex || [lastIndex integerValue] < [object[1] integerValue],
+                  @"Objects from one producer should stay in order.");
+    lastIndexByProducer[object[0]] = object[1];
+  }
+}
+
+- (void)testMainThreadDrainDeliversBatches {
+  NIMultiProducerQueue* queue = [[NIMultiProducerQueue alloc] initWithCapacity:256];
+  __block NSUInteger numberOfDrains = 0;
+  NSMutableArray* drainedObjects = [NSMutableArray array];
+  queue.mainThreadDrainBlock = ^(NSArray* objects) {
+    XCTAssertTrue([NSThread isMainThread], @"Drains should happen on the main thread.");
+    ++numberOfDrains;
+    [drainedObjects addObjectsFromArray:objects];
+  };
+
+  dispatch_sync(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    for (NSInteger ix = 0; ix < 100; ++ix) {
+      [queue enqueueObject:@(ix)];
+    }
+  });
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (drainedObjects.count < 100 && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+
+  XCTAssertEqual(drainedObjects.count, (NSUInteger)100, @"Every object should be drained.");
+  XCTAssertEqual(numberOfDrains, (NSUInteger)1, @"The burst should be drained in one block.");
+}
+
+- (void)testObjectsEnqueuedBeforeTheDrainBlockAreDeliveredInOrder {
+  NIMultiProducerQueue* queue = [[NIMultiProducerQueue alloc] initWithCapacity:256];
+  for (NSInteger ix = 0; ix < 10; ++ix) {
+    [queue enqueueObject:@(ix)];
+  }
+
+  NSMutableArray* drainedObjects = [NSMutableArray array];
+  queue.mainThreadDrainBlock = ^(NSArray* objects) {
+    [drainedObjects addObjectsFromArray:objects];
+  };
+  dispatch_sync(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    for (NSInteger ix = 10; ix < 20; ++ix) {
+      [queue enqueueObject:@(ix)];
+    }
+  });
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (drainedObjects.count < 20 && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+
+  XCTAssertEqual(drainedObjects.count, (NSUInteger)20, @"Every object should be drained.");
+  for (NSUInteger ix = 0; ix < drainedObjects.count; ++ix) {
+    XCTAssertEqualObjects(drainedObjects[ix], @(ix), @"Objects should be drained in order.");
+  }
+}
+
+@end
@@ -105,6 +105,35 @@
                 @"Query: %@", query);
 }
 
+- (void)testNSString_enumerateQueryParameters {
+  NSMutableArray* keys = [NSMutableArray array];
+  NSMutableArray* values = [NSMutableArray array];
+  NIEnumerateQueryParametersInStringUsingEncoding(@"a=1;b&c=%E2%9C%93&d=%zz&e=2", NSUTF8StringEncoding,
+                                                  ^(NSString* key, NSString* value, BOOL* stop) {
+    [keys addObject:key];
+    [values addObject:(nil != value) ? value : [NSNull null]];
+    *stop = [key isEqualToString:@"d"];
+  });
+  XCTAssertEqualObjects(keys, (@[@"a", @"b", @"c", @"d"]), @"Should stop after d.");
+  XCTAssertEqualObjects(values, (@[@"1", [NSNull null], @"\u2713", @"%zz"]),
+                        @"Malformed escapes should be kept.");
+
+  XCTAssertEqualObjects(NIStringByAddingPercentEscapesForURLParameterString(@"a b&c=\u2713~"),
+                        @"a%20b%26c%3D%E2%9C%93~", @"Only unreserved characters should be kept.");
+}
+
+- (void)testNSString_enumerateQueryParametersInOtherEncodings {
+  NSDictionary* query = NIQueryDictionaryFromStringUsingEncoding(@"q=caf%E9&r=\u00e9t\u00e9",
+                                                                 NSISOLatin1StringEncoding);
+  XCTAssertEqualObjects(query[@"q"], @[@"caf\u00e9"], @"Escapes should use the given encoding.");
+  XCTAssertEqualObjects(query[@"r"], @[@"\u00e9t\u00e9"],
+                        @"Literal characters should be kept as they are.");
+
+  query = NIQueryDictionaryFromStringUsingEncoding(@"q=%82%A0&r=1", NSShiftJISStringEncoding);
+  XCTAssertEqualObjects(query[@"q"], @[@"\u3042"], @"Multibyte escapes should decode.");
+  XCTAssertEqualObjects(query[@"r"], @[@"1"], @"Query: %@", query);
+}
+
 - (void)testNSString_stringByAddingQueryDictionary {
   NSString* baseUrl = @"http://google.com/search";
   XCTAssertTrue([NIStringByAddingQueryDictionaryToString(baseUrl, nil) isEqualToString:
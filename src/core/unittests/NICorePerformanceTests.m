@@ -0,0 +1,235 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NimbusCore.h"
+
+// Record baselines for these tests per device with Xcode's "Set Baseline". They are stored in
+// Nimbus.xcodeproj's xcshareddata, and a run that is slower than its baseline by more than the
+// allowed deviation fails.
+
+static const NSUInteger kNumberOfLinkedListObjects = 100000;
+static const NSUInteger kNumberOfCacheNames = 20000;
+static const NSUInteger kNumberOfImages = 1000;
+static const NSUInteger kNumberOfRecycledViews = 10000;
+
+@interface NIPerformanceRecyclableView : UIView <NIRecyclableView>
+@property (nonatomic, copy) NSString* reuseIdentifier;
+@end
+
+@implementation NIPerformanceRecyclableView
+@end
+
+@interface NICorePerformanceTests : XCTestCase
+@end
+
+@implementation NICorePerformanceTests
+
+- (NSArray *)numbersWithCount:(NSUInteger)count {
+  NSMutableArray* numbers = [NSMutableArray arrayWithCapacity:count];
+  for (NSUInteger ix = 0; ix < count; ++ix) {
+    [numbers addObject:@(ix)];
+  }
+  return numbers;
+}
+
+- (NSArray *)namesWithCount:(NSUInteger)count {
+  NSMutableArray* names = [NSMutableArray arrayWithCapacity:count];
+  for (NSUInteger ix = 0; ix < count; ++ix) {
+    [names addObject:[NSString stringWithFormat:@"http://nimbuskit.info/image/%lu.png", (unsigned long)ix]];
+  }
+  return names;
+}
+
+#pragma mark - NILinkedList
+
+- (void)testLinkedListAddPerformance {
+  NSArray* numbers = [self numbersWithCount:kNumberOfLinkedListObjects * 10];
+  [self measureBlock:^{
+    NILinkedList* list = [[NILinkedList alloc] init];
+    for (NSNumber* number in numbers) {
+      [list addObject:number];
+    }
+  }];
+}
+
+- (void)testLinkedListRemoveByLocationPerformance {
+  NSArray* numbers = [self numbersWithCount:kNumberOfLinkedListObjects];
+  [self measureBlock:^{
+    NILinkedList* list = [[NILinkedList alloc] init];
+    NSMutableArray* locations = [NSMutableArray arrayWithCapacity:numbers.count];
+    for (NSNumber* number in numbers) {
+      [locations addObject:[list addObject:number]];
+    }
+    for (NILinkedListLocation* location in locations) {
+      [list removeObjectAtLocation:location];
+    }
+  }];
+}
+
+- (void)testLinkedListRemoveFirstObjectPerformance {
+  NSArray* numbers = [self numbersWithCount:kNumberOfLinkedListObjects * 10];
+  [self measureBlock:^{
+    NILinkedList* list = [[NILinkedList alloc] initWithArray:numbers];
+    while (list.count > 0) {
+      [list removeFirstObject];
+    }
+  }];
+}
+
+- (void)testLinkedListEnumerationPerformance {
+  NILinkedList* list = [[NILinkedList alloc] initWithArray:[self numbersWithCount:kNumberOfLinkedListObjects * 10]];
+  [self measureBlock:^{
+    NSUInteger sum = 0;
+    for (NSNumber* number in list) {
+      sum += [number unsignedIntegerValue];
+    }
+    XCTAssertTrue(sum > 0, @"Every object should be visited.");
+  }];
+}
+
+#pragma mark - NIUnrolledLinkedList
+
+- (void)testUnrolledLinkedListEnumerationPerformance {
+  NIUnrolledLinkedList* list =
+      [[NIUnrolledLinkedList alloc] initWithArray:[self numbersWithCount:kNumberOfLinkedListObjects * 10]];
+  [self measureBlock:^{
+    NSUInteger sum = 0;
+    for (NSNumber* number in list) {
+      sum += [number unsignedIntegerValue];
+    }
+    XCTAssertTrue(sum > 0, @"Every object should be visited.");
+  }];
+}
+
+#pragma mark - NIMemoryCache
+
+- (void)testMemoryCacheHitPerformance {
+  NSArray* names = [self namesWithCount:kNumberOfCacheNames];
+  NIMemoryCache* cache = [[NIMemoryCache alloc] init];
+  for (NSString* name in names) {
+    [cache storeObject:name withName:name];
+  }
+  [self measureBlock:^{
+    for (NSString* name in names) {
+      [cache objectWithName:name];
+    }
+  }];
+}
+
+- (void)testMemoryCacheMissPerformance {
+  NSArray* names = [self namesWithCount:kNumberOfCacheNames];
+  NIMemoryCache* cache = [[NIMemoryCache alloc] init];
+  [self measureBlock:^{
+    for (NSString* name in names) {
+      [cache objectWithName:name];
+    }
+  }];
+}
+
+- (void)testMemoryCacheStoreUnderLRUPressurePerformance {
+  NSArray* names = [self namesWithCount:kNumberOfCacheNames];
+  [self measureBlock:^{
+    NIMemoryCache* cache = [[NIMemoryCache alloc] init];
+    for (NSString* name in names) {
+      [cache storeObject:name withName:name expiresAfter:nil cost:1];
+      // Keep the cache at a quarter of the names so every store past that point evicts.
+      if ([cache numberOfBytesInMemoryBudget] > kNumberOfCacheNames / 4) {
+        [cache reduceMemoryUsageByNumberOfBytes:1];
+      }
+    }
+  }];
+}
+
+// Eight threads reading and writing the same names, one write for every eight reads.
+- (void)measureConcurrentAccessToCache:(NIMemoryCache *)cache {
+  NSArray* names = [self namesWithCount:512];
+  [self measureBlock:^{
+    dispatch_apply(8, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t thread) {
+      for (NSUInteger ix = 0; ix < kNumberOfCacheNames; ++ix) {
+        NSString* name = names[(ix * 31 + thread * 7) % names.count];
+        if (0 == ix % 8) {
+          [cache storeObject:name withName:name];
+        } else {
+          [cache objectWithName:name];
+        }
+      }
+    });
+    XCTAssertEqual([cache count], names.count, @"Every name should be stored.");
+  }];
+}
+
+- (void)testMemoryCacheConcurrentAccessPerformance {
+  [self measureConcurrentAccessToCache:[[NIMemoryCache alloc] init]];
+}
+
+- (void)testSegmentedMemoryCacheConcurrentAccessPerformance {
+  [self measureConcurrentAccessToCache:[[NIMemoryCache alloc] initWithCapacity:0 numberOfSegments:16]];
+}
+
+#pragma mark - NIImageMemoryCache
+
+- (void)testImageMemoryCacheEvictionAtPixelLimitPerformance {
+  NSArray* names = [self namesWithCount:kNumberOfImages];
+  NSMutableArray* images = [NSMutableArray arrayWithCapacity:kNumberOfImages];
+  for (NSUInteger ix = 0; ix < kNumberOfImages; ++ix) {
+    // Every image needs its own CGImage; images that share one are only counted once.
+    UIGraphicsBeginImageContextWithOptions(CGSizeMake(16, 16), YES, 1);
+    [[UIColor colorWithWhite:(CGFloat)ix / kNumberOfImages alpha:1] setFill];
+    UIRectFill(CGRectMake(0, 0, 16, 16));
+    [images addObject:UIGraphicsGetImageFromCurrentImageContext()];
+    UIGraphicsEndImageContext();
+  }
+
+  [self measureBlock:^{
+    NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] init];
+    cache.maxNumberOfPixels = 16 * 16 * kNumberOfImages / 4;
+    for (NSUInteger ix = 0; ix < kNumberOfImages; ++ix) {
+      [cache storeObject:images[ix] withName:names[ix]];
+    }
+    XCTAssertTrue(cache.numberOfPixels <= cache.maxNumberOfPixels, @"Should have evicted down to the limit.");
+  }];
+}
+
+#pragma mark - NIViewRecycler
+
+- (void)testViewRecyclerDequeueAndRecyclePerformance {
+  NIViewRecycler* recycler = [[NIViewRecycler alloc] init];
+  NSMutableArray* views = [NSMutableArray arrayWithCapacity:16];
+  for (NSUInteger ix = 0; ix < 16; ++ix) {
+    NIPerformanceRecyclableView* view = [[NIPerformanceRecyclableView alloc] init];
+    view.reuseIdentifier = (ix % 2) ? @"even" : @"odd";
+    [views addObject:view];
+  }
+
+  [self measureBlock:^{
+    for (UIView* view in views) {
+      [recycler recycleView:view];
+    }
+    for (NSUInteger ix = 0; ix < kNumberOfRecycledViews; ++ix) {
+      NSString* identifier = (ix % 2) ? @"even" : @"odd";
+      UIView* view = [recycler dequeueReusableViewWithIdentifier:identifier];
+      [recycler recycleView:view];
+    }
+    [recycler removeAllViews];
+  }];
+}
+
+@end
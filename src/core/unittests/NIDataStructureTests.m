@@ -363,6 +363,38 @@
   STAssertEquals(ll.lastObject, object3, @"Tail should be the third object.");
 }
 
+- (void)testLinkedListStaleLocationAfterNodeReuse {
+  NILinkedList* ll = [[NILinkedList alloc] initWithCapacity:1];
+
+  id object1 = [NSArray array];
+  id object2 = [NSDictionary dictionary];
+  NILinkedListLocation* location = [ll addObject:object1];
+  [ll removeFirstObject];
+
+  // The list reuses the only node it has for the second object.
+  [ll addObject:object2];
+
+  STAssertNil([ll objectAtLocation:location], @"A stale location should not refer to anything.");
+  [ll removeObjectAtLocation:location];
+  STAssertEquals(ll.count, (NSUInteger)1, @"Removing at a stale location should do nothing.");
+  STAssertEquals(ll.firstObject, object2, @"The second object should still be in the list.");
+}
+
+- (void)testLinkedListAsQueue {
+  NILinkedList* ll = [[NILinkedList alloc] initWithCapacity:4];
+
+  for (NSInteger ix = 0; ix < 1000; ++ix) {
+    [ll appendObject:[NSNumber numberWithInteger:ix]];
+    if (ll.count > 3) {
+      [ll removeFirstObject];
+    }
+  }
+
+  STAssertEquals(ll.count, (NSUInteger)3, @"There should be exactly three objects.");
+  STAssertEqualObjects(ll.firstObject, [NSNumber numberWithInteger:997], @"Head should be the oldest object.");
+  STAssertEqualObjects(ll.lastObject, [NSNumber numberWithInteger:999], @"Tail should be the newest object.");
+}
+
 - (void)testLinkedListIteration {
   NILinkedList* ll = [[NILinkedList alloc] init];
 
@@ -439,4 +471,151 @@
   STAssertEquals(ll2.lastObject, object3, @"Tail should be the third object.");
 }
 
+
+#pragma mark - Unrolled Linked List
+
+
+- (void)testUnrolledLinkedListLocationsSurviveRemovals {
+  NSMutableArray* numbers = [NSMutableArray array];
+  for (NSInteger ix = 0; ix < 100; ++ix) {
+    [numbers addObject:[NSNumber numberWithInteger:ix]];
+  }
+  NIUnrolledLinkedList* ll = [NIUnrolledLinkedList linkedListWithArray:numbers];
+  NIUnrolledLinkedListLocation* location = [ll locationOfObject:[numbers objectAtIndex:70]];
+  NIUnrolledLinkedListLocation* removedLocation = [ll locationOfObject:[numbers objectAtIndex:50]];
+
+  [ll removeObjectAtLocation:removedLocation];
+  [ll removeObject:[numbers objectAtIndex:69]];
+  [ll removeFirstObject];
+  [ll removeLastObject];
+  for (NSInteger ix = 0; ix < 32; ++ix) {
+    [ll removeFirstObject];
+  }
+
+  STAssertEquals(ll.count, (NSUInteger)64, @"Removals should be counted.");
+  STAssertEqualObjects([ll objectAtLocation:location], [numbers objectAtIndex:70],
+                       @"A location should follow its object as its node is compacted.");
+  STAssertNil([ll objectAtLocation:removedLocation], @"A removed object's location is stale.");
+  STAssertEqualObjects(ll.firstObject, [numbers objectAtIndex:33], @"The head should advance.");
+  STAssertEqualObjects(ll.lastObject, [numbers objectAtIndex:98], @"The tail should retreat.");
+
+  NSMutableArray* enumerated = [NSMutableArray array];
+  for (id object in ll) {
+    [enumerated addObject:object];
+  }
+  STAssertEqualObjects(enumerated, [ll allObjects], @"Fast enumeration should visit every node.");
+  STAssertEqualObjects([[ll objectEnumerator] allObjects], enumerated,
+                       @"The enumerator should agree.");
+
+  NSData* data = [NSKeyedArchiver archivedDataWithRootObject:ll];
+  NIUnrolledLinkedList* decoded = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+  STAssertEqualObjects([decoded allObjects], enumerated, @"Coding should preserve the order.");
+  STAssertEqualObjects([[ll copy] allObjects], enumerated, @"Copies should preserve the order.");
+
+  [ll removeAllObjects];
+  STAssertNil(ll.firstObject, @"An empty list has no first object.");
+  STAssertNil([ll objectAtLocation:location], @"Locations are stale once their objects are gone.");
+}
+
+
+#pragma mark - Ring Buffer
+
+
+- (void)testRingBufferOverwritesOldestObjects {
+  NIRingBuffer* buffer = [[NIRingBuffer alloc] initWithCapacity:3];
+
+  STAssertNil([buffer addObject:@1], @"Nothing should be overwritten while there's room.");
+  [buffer addObject:@2];
+  [buffer addObject:@3];
+  STAssertEqualObjects([buffer addObject:@4], @1, @"The oldest object should be overwritten.");
+
+  STAssertEquals(buffer.count, (NSUInteger)3, @"The buffer should stay at its capacity.");
+  STAssertEqualObjects(buffer.firstObject, @2, @"The first object should be the oldest remaining.");
+  STAssertEqualObjects(buffer.lastObject, @4, @"The last object should be the newest.");
+  STAssertEqualObjects(buffer[1], @3, @"Objects should be indexed from the first object.");
+}
+
+- (void)testRingBufferBothEnds {
+  NIRingBuffer* buffer = [[NIRingBuffer alloc] initWithCapacity:3];
+
+  [buffer addObject:@2];
+  [buffer prependObject:@1];
+  [buffer addObject:@3];
+  STAssertEqualObjects([buffer prependObject:@0], @3, @"Prepending to a full buffer should overwrite the last object.");
+  STAssertEqualObjects([buffer allObjects], (@[@0, @1, @2]), @"Objects should be in order.");
+
+  STAssertEqualObjects([buffer removeFirstObject], @0, @"The first object should be removed.");
+  STAssertEqualObjects([buffer removeLastObject], @2, @"The last object should be removed.");
+  STAssertEquals(buffer.count, (NSUInteger)1, @"There should be exactly one object.");
+
+  [buffer removeAllObjects];
+  STAssertNil([buffer removeFirstObject], @"An empty buffer has nothing to remove.");
+  STAssertNil(buffer.lastObject, @"An empty buffer has no last object.");
+}
+
+- (void)testRingBufferEnumerationWrapsAround {
+  NIRingBuffer* buffer = [[NIRingBuffer alloc] initWithCapacity:4];
+  for (NSInteger ix = 0; ix < 10; ++ix) {
+    [buffer addObject:[NSNumber numberWithInteger:ix]];
+  }
+
+  NSMutableArray* objects = [NSMutableArray array];
+  for (NSNumber* number in buffer) {
+    [objects addObject:number];
+  }
+  STAssertEqualObjects(objects, (@[@6, @7, @8, @9]), @"Enumeration should run from first to last.");
+  STAssertEqualObjects([[buffer objectEnumerator] allObjects], objects, @"The enumerator should agree.");
+}
+
+
+#pragma mark - Priority Queue
+
+
+- (NIPriorityQueue *)ascendingQueueWithObjects:(NSArray *)objects {
+  return [[NIPriorityQueue alloc] initWithComparator:^NSComparisonResult(id object1, id object2) {
+    return [object1 compare:object2];
+  } objects:objects];
+}
+
+- (void)testPriorityQueueRemovesObjectsInOrder {
+  NSMutableArray* numbers = [NSMutableArray array];
+  for (NSInteger ix = 0; ix < 100; ++ix) {
+    [numbers addObject:[NSNumber numberWithInteger:(ix * 37) % 100]];
+  }
+  NIPriorityQueue* queue = [self ascendingQueueWithObjects:numbers];
+  [queue addObject:[NSNumber numberWithInteger:-1]];
+
+  STAssertEquals(queue.count, (NSUInteger)101, @"Every object should be in the queue.");
+  STAssertEqualObjects([queue removeFirstObject], [NSNumber numberWithInteger:-1], @"The smallest object should come first.");
+  for (NSInteger ix = 0; ix < 100; ++ix) {
+    STAssertEqualObjects([queue removeFirstObject], [NSNumber numberWithInteger:ix], @"Objects should come out in order.");
+  }
+  STAssertNil([queue removeFirstObject], @"The queue should be empty.");
+}
+
+- (void)testPriorityQueueHandles {
+  NIPriorityQueue* queue = [[NIPriorityQueue alloc] initWithComparator:^NSComparisonResult(NSMutableArray* object1, NSMutableArray* object2) {
+    return [object1[0] compare:object2[0]];
+  }];
+  NSMutableArray* object1 = [NSMutableArray arrayWithObject:@1];
+  NSMutableArray* object2 = [NSMutableArray arrayWithObject:@2];
+  NSMutableArray* object3 = [NSMutableArray arrayWithObject:@3];
+  [queue addObject:object1];
+  NIPriorityQueueHandle* handle2 = [queue addObject:object2];
+  NIPriorityQueueHandle* handle3 = [queue addObject:object3];
+
+  // Decrease the key of the last object.
+  object3[0] = @0;
+  [queue updateObjectWithHandle:handle3];
+  STAssertEquals(queue.firstObject, object3, @"The updated object should move to the front.");
+
+  [queue removeObjectWithHandle:handle2];
+  STAssertNil([queue objectWithHandle:handle2], @"A removed handle should not refer to anything.");
+  [queue removeObjectWithHandle:handle2];
+  STAssertEquals(queue.count, (NSUInteger)2, @"Removing twice should do nothing.");
+
+  STAssertEquals([queue removeFirstObject], object3, @"The updated object should come first.");
+  STAssertEquals([queue removeFirstObject], object1, @"The remaining object should come last.");
+}
+
 @end
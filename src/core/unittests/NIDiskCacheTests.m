@@ -0,0 +1,190 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import <UIKit/UIKit.h>
+
+#import "NIDiskCache.h"
+#import "NIInMemoryCache.h"
+
+@interface NIDiskCacheTests : XCTestCase
+@property (nonatomic, copy) NSString* path;
+@end
+
+@implementation NIDiskCacheTests
+
+- (void)setUp {
+  [super setUp];
+
+  self.path = [NSTemporaryDirectory() stringByAppendingPathComponent:
+               [NSString stringWithFormat:@"NIDiskCacheTests-%@", [[NSProcessInfo processInfo] globallyUniqueString]]];
+}
+
+- (void)tearDown {
+  [[NSFileManager defaultManager] removeItemAtPath:self.path error:nil];
+
+  [super tearDown];
+}
+
+- (NSData *)dataWithLength:(NSUInteger)length {
+  return [NSMutableData dataWithLength:length];
+}
+
+#pragma mark - Disk Cache
+
+
+- (void)testInitialization {
+  NIDiskCache* cache = [[NIDiskCache alloc] initWithPath:self.path];
+
+  XCTAssertEqual([cache count], (NSUInteger)0, @"Cache should be empty after initialization.");
+  XCTAssertEqual(cache.numberOfBytes, (unsigned long long)0, @"Cache should have zero bytes.");
+}
+
+- (void)testStoringData {
+  NIDiskCache* cache = [[NIDiskCache alloc] initWithPath:self.path];
+
+  NSData* data = [@"Nimbus" dataUsingEncoding:NSUTF8StringEncoding];
+  [cache storeData:data withName:@"obj1"];
+
+  // Pending writes are readable right away.
+  XCTAssertEqualObjects([cache dataWithName:@"obj1"], data, @"Data should be equal.");
+
+  [cache waitUntilAllWritesAreFinished];
+
+  XCTAssertEqualObjects([cache dataWithName:@"obj1"], data, @"Data should be equal.");
+  XCTAssertTrue([cache containsDataWithName:@"obj1"], @"obj1 should exist in the cache.");
+  XCTAssertFalse([cache containsDataWithName:@"obj2"], @"obj2 should not exist in the cache.");
+  XCTAssertEqual(cache.numberOfBytes, (unsigned long long)data.length, @"Cache should count the stored bytes.");
+}
+
+- (void)testStoringFiles {
+  NIDiskCache* cache = [[NIDiskCache alloc] initWithPath:self.path];
+
+  NSData* data = [@"Nimbus" dataUsingEncoding:NSUTF8StringEncoding];
+  NSURL* fileURL = [cache temporaryFileURL];
+  XCTAssertTrue([data writeToURL:fileURL atomically:NO], @"The temporary file should be writable.");
+  XCTAssertEqual([cache count], (NSUInteger)0, @"Temporary files should not be part of the cache.");
+
+  [cache storeFileAtURL:fileURL withName:@"obj1"];
+
+  // The file can be read back before it has been moved.
+  XCTAssertEqualObjects([cache dataWithName:@"obj1"], data, @"Data should be equal.");
+
+  [cache waitUntilAllWritesAreFinished];
+
+  XCTAssertEqualObjects([cache dataWithName:@"obj1"], data, @"Data should be equal.");
+  XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:fileURL.path], @"The file should have been moved.");
+  XCTAssertEqual(cache.numberOfBytes, (unsigned long long)data.length, @"Cache should count the stored bytes.");
+}
+
+- (void)testNewCachesOnlyRemoveTemporaryFilesOfEarlierLaunches {
+  NIDiskCache* cache = [[NIDiskCache alloc] initWithPath:self.path];
+  NSURL* fileURL = [cache temporaryFileURL];
+  XCTAssertTrue([[@"Nimbus" dataUsingEncoding:NSUTF8StringEncoding] writeToURL:fileURL atomically:NO]);
+  NSString* stalePath = [self.path stringByAppendingPathComponent:@".partial-stale"];
+  XCTAssertTrue([[NSData data] writeToFile:stalePath atomically:NO]);
+
+  NIDiskCache* otherCache = [[NIDiskCache alloc] initWithPath:self.path];
+  [otherCache waitUntilAllWritesAreFinished];
+
+  XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:fileURL.path],
+                @"A file that another cache is filling in should be kept.");
+  XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:stalePath],
+                 @"A file left behind by an earlier launch should be removed.");
+}
+
+- (void)testRemovingData {
+  NIDiskCache* cache = [[NIDiskCache alloc] initWithPath:self.path];
+
+  [cache storeData:[self dataWithLength:10] withName:@"obj1"];
+  [cache storeData:[self dataWithLength:10] withName:@"obj2"];
+  [cache removeDataWithName:@"obj1"];
+  [cache waitUntilAllWritesAreFinished];
+
+  XCTAssertNil([cache dataWithName:@"obj1"], @"obj1 should have been removed.");
+  XCTAssertEqual([cache count], (NSUInteger)1, @"Cache should have one file.");
+
+  [cache removeAllData];
+  [cache waitUntilAllWritesAreFinished];
+
+  XCTAssertEqual([cache count], (NSUInteger)0, @"Cache should be empty.");
+  XCTAssertEqual(cache.numberOfBytes, (unsigned long long)0, @"Cache should have zero bytes.");
+}
+
+- (void)testLeastRecentlyUsedEviction {
+  NIDiskCache* cache = [[NIDiskCache alloc] initWithPath:self.path];
+  cache.maxNumberOfBytes = 20;
+
+  [cache storeData:[self dataWithLength:10] withName:@"obj1"];
+  [cache storeData:[self dataWithLength:10] withName:@"obj2"];
+
+  // Make obj1 the most recently used file.
+  [cache dataWithName:@"obj1"];
+
+  [cache storeData:[self dataWithLength:10] withName:@"obj3"];
+  [cache waitUntilAllWritesAreFinished];
+
+  XCTAssertEqual([cache count], (NSUInteger)2, @"Cache should have two files.");
+  XCTAssertNotNil([cache dataWithName:@"obj1"], @"obj1 should still be around.");
+  XCTAssertNil([cache dataWithName:@"obj2"], @"obj2 should have been evicted.");
+  XCTAssertNotNil([cache dataWithName:@"obj3"], @"obj3 should still be around.");
+}
+
+- (void)testPersistence {
+  NIDiskCache* cache = [[NIDiskCache alloc] initWithPath:self.path];
+
+  NSData* data = [@"Nimbus" dataUsingEncoding:NSUTF8StringEncoding];
+  [cache storeData:data withName:@"obj1"];
+  [cache waitUntilAllWritesAreFinished];
+  cache = nil;
+
+  NIDiskCache* reopenedCache = [[NIDiskCache alloc] initWithPath:self.path];
+  XCTAssertEqual([reopenedCache count], (NSUInteger)1, @"The journal should have been read.");
+  XCTAssertEqualObjects([reopenedCache dataWithName:@"obj1"], data, @"Data should be equal.");
+}
+
+#pragma mark - Tiered Cache
+
+
+- (void)testTieredCachePromotesDiskHits {
+  NIMemoryCache* memoryCache = [[NIMemoryCache alloc] init];
+  NIDiskCache* diskCache = [[NIDiskCache alloc] initWithPath:self.path];
+  NITieredCache* cache = [[NITieredCache alloc] initWithMemoryCache:memoryCache diskCache:diskCache];
+  cache.dataFromObject = ^NSData *(NSString* object) {
+    return [object dataUsingEncoding:NSUTF8StringEncoding];
+  };
+  cache.objectFromData = ^id(NSData* data) {
+    return [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+  };
+
+  [cache storeObject:@"Nimbus" data:[@"Nimbus" dataUsingEncoding:NSUTF8StringEncoding] withName:@"obj1"];
+  [diskCache waitUntilAllWritesAreFinished];
+
+  // Simulate a cold launch.
+  [memoryCache removeAllObjects];
+
+  XCTAssertTrue([cache containsObjectWithName:@"obj1"], @"obj1 should still be on disk.");
+  XCTAssertEqualObjects([cache objectWithName:@"obj1"], @"Nimbus", @"obj1 should be read from disk.");
+  XCTAssertTrue([memoryCache containsObjectWithName:@"obj1"], @"obj1 should have been promoted.");
+
+  [cache removeObjectWithName:@"obj1"];
+  XCTAssertNil([cache objectWithName:@"obj1"], @"obj1 should have been removed from both tiers.");
+}
+
+@end
@@ -0,0 +1,73 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NIFastLock.h"
+
+@interface NIFastLockTests : XCTestCase
+@end
+
+@implementation NIFastLockTests
+
+// Returns YES if another thread can not take the lock.
+static BOOL NIFastLockIsHeldByAnyThread(NIFastLock* lock) {
+  __block BOOL wasTaken = NO;
+  dispatch_sync(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    wasTaken = NIFastLockTryLock(lock);
+    if (wasTaken) {
+      NIFastLockUnlock(lock);
+    }
+  });
+  return !wasTaken;
+}
+
+- (void)testRecursiveLocksAreReleasedByTheOutermostScope {
+  NIFastLock lock;
+  NIFastLockInit(&lock, NIFastLockOptionRecursive | NIFastLockOptionCountsContention);
+
+  {
+    NI_LOCK_SCOPE(&lock);
+    {
+      NI_LOCK_SCOPE(&lock);
+      XCTAssertTrue(NIFastLockIsHeldByAnyThread(&lock));
+    }
+    XCTAssertTrue(NIFastLockIsHeldByAnyThread(&lock), @"The inner scope must not release the lock.");
+  }
+  XCTAssertFalse(NIFastLockIsHeldByAnyThread(&lock), @"The outer scope should release the lock.");
+
+  NIFastLockStatistics statistics = NIFastLockGetStatistics(&lock);
+  XCTAssertEqual(statistics.numberOfAcquisitions, 2ULL, @"Only the outer scope and the last try should count.");
+  XCTAssertEqual(statistics.numberOfContentions, 0ULL);
+
+  NIFastLockResetStatistics(&lock);
+  XCTAssertEqual(NIFastLockGetStatistics(&lock).numberOfAcquisitions, 0ULL);
+  NIFastLockDestroy(&lock);
+}
+
+- (void)testLocksWithoutCountersDoNotCount {
+  NIFastLock lock;
+  NIFastLockInit(&lock, NIFastLockOptionNone);
+  NIFastLockLock(&lock);
+  XCTAssertTrue(NIFastLockIsHeldByAnyThread(&lock));
+  NIFastLockUnlock(&lock);
+  XCTAssertEqual(NIFastLockGetStatistics(&lock).numberOfAcquisitions, 0ULL);
+  NIFastLockDestroy(&lock);
+}
+
+@end
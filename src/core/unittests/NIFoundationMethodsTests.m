@@ -21,6 +21,7 @@
 #import <XCTest/XCTest.h>
 
 #import "NIFoundationMethods.h"
+#import "NIInMemoryCache.h"
 
 @interface NIFoundationMethodsTests : XCTestCase {
 }
@@ -55,6 +56,23 @@
 }
 
 
+- (void)testStringMeasurementsAreCached {
+  NIMemoryCache* cache = NIStringMeasurementCache();
+  [cache resetStatistics];
+
+  UIFont* font = [UIFont systemFontOfSize:14];
+  CGSize first = NISizeOfStringWithLabelProperties(@"Nimbus measures this once.", CGSizeMake(100, CGFLOAT_MAX),
+                                                   font, NSLineBreakByWordWrapping, 0);
+  CGSize second = NISizeOfStringWithLabelProperties(@"Nimbus measures this once.", CGSizeMake(100, CGFLOAT_MAX),
+                                                    font, NSLineBreakByWordWrapping, 0);
+  XCTAssertTrue(CGSizeEqualToSize(first, second), @"Should be equal.");
+  XCTAssertEqual([cache statistics].numberOfHits, 1ULL, @"The second measurement should be a hit.");
+
+  NISizeOfStringWithLabelProperties(@"Nimbus measures this once.", CGSizeMake(200, CGFLOAT_MAX),
+                                    font, NSLineBreakByWordWrapping, 0);
+  XCTAssertEqual([cache statistics].numberOfHits, 1ULL, @"A new width should be measured again.");
+}
+
 #pragma mark - NSRange Methods
 
 
@@ -82,6 +100,44 @@
                 @"SHA1 hashes don't match.");
 }
 
+#pragma mark - Fast Hashing Methods
+
+
+- (void)testFastHashing {
+  XCTAssertEqual(NIHash64FromBytes("", 0), 0xef46db3751d8e999ULL, @"Should match xxHash64.");
+  XCTAssertEqual(NIHash64FromBytes("abc", 3), 0x44bc2cf5ad770999ULL, @"Should match xxHash64.");
+  XCTAssertEqual(NIHash64FromString(@"abc"), 0x44bc2cf5ad770999ULL, @"Strings should hash as UTF8.");
+
+  NSString* string = @"Nobody inspects the spammish repetition \u00e9\u00e8 and more than one stripe.";
+  NSData* data = [string dataUsingEncoding:NSUTF8StringEncoding];
+  XCTAssertEqual(NIHash64FromString(string), NIHash64FromData(data), @"Should be equal.");
+
+  NIHash128 hash = NIHash128FromString(string);
+  XCTAssertEqual(hash.low, NIHash64FromData(data), @"The low half should be the 64-bit hash.");
+  XCTAssertNotEqual(hash.low, hash.high, @"The halves should be independent.");
+  XCTAssertEqual([NIHexStringFromHash128(hash) length], (NSUInteger)32, @"Should be 32 hex characters.");
+}
+
+- (void)testStreamingHashMatchesOneShot {
+  NSMutableData* data = [NSMutableData dataWithLength:1000];
+  uint8_t* bytes = [data mutableBytes];
+  for (NSUInteger ix = 0; ix < data.length; ++ix) {
+    bytes[ix] = (uint8_t)(ix * 7);
+  }
+
+  NIHash128State state;
+  NIHash128StateInit(&state);
+  for (NSUInteger location = 0; location < data.length;) {
+    NSUInteger length = MIN((location % 5) + 1, data.length - location);
+    NIHash128StateUpdate(&state, bytes + location, length);
+    location += length;
+  }
+  NIHash128 streamed = NIHash128StateDigest(&state);
+  NIHash128 oneShot = NIHash128FromData(data);
+  XCTAssertEqual(streamed.low, oneShot.low, @"Should be equal.");
+  XCTAssertEqual(streamed.high, oneShot.high, @"Should be equal.");
+}
+
 #pragma mark - NSString Methods
 
 
@@ -0,0 +1,87 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NIIdleScheduler.h"
+
+@interface NIIdleSchedulerTests : XCTestCase
+@end
+
+@implementation NIIdleSchedulerTests
+
+- (void)runUntilIdleTasksFinish:(NIIdleScheduler *)scheduler {
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  while ([scheduler numberOfTasks] > 0 && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+}
+
+- (void)testTasksRunInPriorityOrder {
+  NIIdleScheduler* scheduler = [[NIIdleScheduler alloc] init];
+  NSMutableArray* order = [NSMutableArray array];
+  [scheduler scheduleTaskWithPriority:NIIdleTaskPriorityLow block:^BOOL{
+    [order addObject:@"low"];
+    return NO;
+  }];
+  [scheduler scheduleTaskWithPriority:NIIdleTaskPriorityDefault block:^BOOL{
+    [order addObject:@"default"];
+    return NO;
+  }];
+  NIIdleTaskToken* high = [scheduler scheduleTaskWithPriority:NIIdleTaskPriorityHigh block:^BOOL{
+    [order addObject:@"high"];
+    return NO;
+  }];
+  XCTAssertEqual(order.count, (NSUInteger)0, @"Tasks should wait for the run loop to go idle.");
+
+  [self runUntilIdleTasksFinish:scheduler];
+
+  XCTAssertEqualObjects(order, (@[@"high", @"default", @"low"]), @"Higher priorities should run first.");
+  XCTAssertTrue(high.isFinished, @"The task should have finished.");
+}
+
+- (void)testTasksAreCalledUntilDone {
+  NIIdleScheduler* scheduler = [[NIIdleScheduler alloc] init];
+  __block NSInteger numberOfCalls = 0;
+  [scheduler scheduleTaskWithPriority:NIIdleTaskPriorityDefault block:^BOOL{
+    ++numberOfCalls;
+    return numberOfCalls < 10;
+  }];
+
+  [self runUntilIdleTasksFinish:scheduler];
+
+  XCTAssertEqual(numberOfCalls, (NSInteger)10, @"The task should be called until it returns NO.");
+}
+
+- (void)testCancelledTasksDoNotRun {
+  NIIdleScheduler* scheduler = [[NIIdleScheduler alloc] init];
+  __block BOOL didRun = NO;
+  NIIdleTaskToken* token = [scheduler scheduleTaskWithPriority:NIIdleTaskPriorityDefault block:^BOOL{
+    didRun = YES;
+    return NO;
+  }];
+  [token cancel];
+  XCTAssertTrue(token.isCancelled, @"The token should be cancelled.");
+  XCTAssertEqual([scheduler numberOfTasks], (NSUInteger)0, @"Cancelled tasks should be removed.");
+
+  [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+  XCTAssertFalse(didRun, @"Cancelled tasks should never run.");
+}
+
+@end
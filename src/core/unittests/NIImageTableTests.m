@@ -0,0 +1,122 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NIImageTable.h"
+
+@interface NIImageTableTests : XCTestCase
+@end
+
+@implementation NIImageTableTests {
+  NSString* _path;
+}
+
+static UIImage* NISolidColorImage(UIColor* color, CGSize size) {
+  UIGraphicsBeginImageContextWithOptions(size, YES, 1);
+  [color setFill];
+  UIRectFill(CGRectMake(0, 0, size.width, size.height));
+  UIImage* image = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  return image;
+}
+
+// Returns the BGRA pixel in the middle of the image.
+static uint32_t NICenterPixel(UIImage* image) {
+  CGImageRef imageRef = image.CGImage;
+  CFDataRef data = CGDataProviderCopyData(CGImageGetDataProvider(imageRef));
+  const uint8_t* bytes = CFDataGetBytePtr(data);
+  size_t offset = (CGImageGetHeight(imageRef) / 2) * CGImageGetBytesPerRow(imageRef) + (CGImageGetWidth(imageRef) / 2) * 4;
+  uint32_t pixel = *(const uint32_t *)(bytes + offset);
+  CFRelease(data);
+  return pixel;
+}
+
+- (void)setUp {
+  [super setUp];
+  _path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+}
+
+- (void)tearDown {
+  [[NSFileManager defaultManager] removeItemAtPath:_path error:nil];
+  [super tearDown];
+}
+
+- (NIImageTable *)tableWithCapacity:(NSUInteger)capacity {
+  return [[NIImageTable alloc] initWithPath:_path imageSize:CGSizeMake(20, 10) scale:2 capacity:capacity];
+}
+
+- (void)testStoredImagesAreReadBackAtTheTableSize {
+  NIImageTable* table = [self tableWithCapacity:4];
+
+  XCTAssertTrue([table storeImage:NISolidColorImage([UIColor redColor], CGSizeMake(100, 100)) withName:@"red"],
+                @"The image should be stored.");
+  XCTAssertTrue([table containsImageWithName:@"red"], @"The table should contain the image.");
+  XCTAssertEqual(table.count, (NSUInteger)1, @"There should be one image.");
+
+  UIImage* image = [table imageWithName:@"red"];
+  XCTAssertTrue(CGSizeEqualToSize(image.size, CGSizeMake(20, 10)), @"Images fill the table's size.");
+  XCTAssertEqual(image.scale, (CGFloat)2, @"Images have the table's scale.");
+  XCTAssertEqual(NICenterPixel(image), (uint32_t)0xffff0000, @"The pixels should be red.");
+
+  XCTAssertNil([table imageWithName:@"blue"], @"Missing images should be nil.");
+}
+
+- (void)testImagesSurviveReopeningTheTable {
+  @autoreleasepool {
+    NIImageTable* table = [self tableWithCapacity:4];
+    [table storeImage:NISolidColorImage([UIColor blueColor], CGSizeMake(20, 10)) withName:@"blue"];
+    [table storeImage:NISolidColorImage([UIColor greenColor], CGSizeMake(20, 10)) withName:@"green"];
+    [table removeImageWithName:@"green"];
+  }
+
+  NIImageTable* table = [self tableWithCapacity:4];
+  XCTAssertEqual(table.count, (NSUInteger)1, @"Only the stored image should be reloaded.");
+  XCTAssertEqual(NICenterPixel([table imageWithName:@"blue"]), (uint32_t)0xff0000ff, @"The pixels should be blue.");
+  XCTAssertFalse([table containsImageWithName:@"green"], @"Removed images should stay removed.");
+
+  NIImageTable* resizedTable = [[NIImageTable alloc] initWithPath:_path imageSize:CGSizeMake(10, 10) scale:2 capacity:4];
+  XCTAssertEqual(resizedTable.count, (NSUInteger)0, @"Images of another size should be ignored.");
+}
+
+- (void)testLeastRecentlyUsedUnpinnedImagesAreReplaced {
+  NIImageTable* table = [self tableWithCapacity:2];
+  UIImage* source = NISolidColorImage([UIColor whiteColor], CGSizeMake(20, 10));
+
+  [table storeImage:source withName:@"a"];
+  [table storeImage:source withName:@"b"];
+
+  // "a" is more recently used than "b", but it is also being displayed.
+  UIImage* displayed = [table imageWithName:@"a"];
+  [table storeImage:source withName:@"c"];
+  XCTAssertTrue([table containsImageWithName:@"a"], @"Recently used images should be kept.");
+  XCTAssertFalse([table containsImageWithName:@"b"], @"The least recently used image should be replaced.");
+
+  @autoreleasepool {
+    // Both slots are now in use.
+    UIImage* displayedToo = [table imageWithName:@"c"];
+    XCTAssertFalse([table storeImage:source withName:@"d"], @"Slots backing live images must not be replaced.");
+    XCTAssertNotNil(displayedToo, @"The image should be valid while it is displayed.");
+  }
+
+  XCTAssertTrue([table storeImage:source withName:@"d"], @"Released slots can be reused.");
+  XCTAssertNotNil(displayed, @"The displayed image should still be valid.");
+}
+
+@end
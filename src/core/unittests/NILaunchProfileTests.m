@@ -0,0 +1,89 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NILaunchProfile.h"
+
+@interface NILaunchProfileTests : XCTestCase
+@end
+
+@implementation NILaunchProfileTests
+
+- (void)tearDown {
+  NILaunchProfileSetEnabled(NO);
+}
+
+// Returns the entries recorded for the given components, in the order they were recorded.
+- (NSArray *)entriesForComponents:(NSArray *)components {
+  NSMutableArray* entries = [NSMutableArray array];
+  for (NSDictionary* entry in NILaunchProfileEntries()) {
+    if ([components containsObject:entry[@"component"]]) {
+      [entries addObject:entry];
+    }
+  }
+  return entries;
+}
+
+- (void)testFirstUsesAreRecordedInOrder {
+  NILaunchProfileSetEnabled(YES);
+  NSString* suffix = [[NSProcessInfo processInfo] globallyUniqueString];
+  NSString* first = [@"first " stringByAppendingString:suffix];
+  NSString* second = [@"second " stringByAppendingString:suffix];
+
+  __block NSUInteger numberOfRuns = 0;
+  NIMeasureFirstUse(first, ^{
+    ++numberOfRuns;
+    [NSThread sleepForTimeInterval:0.01];
+  });
+  NIMeasureFirstUse(second, ^{
+    ++numberOfRuns;
+  });
+  NIMeasureFirstUse(first, ^{
+    ++numberOfRuns;
+  });
+  XCTAssertEqual(numberOfRuns, (NSUInteger)3, @"Every measured block should run.");
+
+  NSArray* entries = [self entriesForComponents:@[first, second]];
+  XCTAssertEqual(entries.count, (NSUInteger)2, @"Only the first use of each component should be recorded.");
+  XCTAssertEqualObjects(entries[0][@"component"], first);
+  XCTAssertEqualObjects(entries[1][@"component"], second);
+  for (NSDictionary* entry in entries) {
+    XCTAssertGreaterThanOrEqual([entry[@"duration"] doubleValue], 0.0);
+  }
+  XCTAssertGreaterThanOrEqual([entries[0][@"duration"] doubleValue], 0.01, @"The sleep should be measured.");
+  XCTAssertLessThanOrEqual([entries[0][@"timeSinceLaunch"] doubleValue],
+                           [entries[1][@"timeSinceLaunch"] doubleValue],
+                           @"The second use started after the first.");
+}
+
+- (void)testNothingIsRecordedWhileDisabled {
+  NILaunchProfileSetEnabled(NO);
+  NSString* component = [[NSProcessInfo processInfo] globallyUniqueString];
+
+  __block BOOL didRun = NO;
+  NIMeasureFirstUse(component, ^{
+    didRun = YES;
+  });
+
+  XCTAssertTrue(didRun, @"The block should run whether or not profiling is enabled.");
+  XCTAssertEqual([self entriesForComponents:@[component]].count, (NSUInteger)0);
+}
+
+@end
@@ -22,6 +22,7 @@
 
 #import "NIDebuggingTools.h"
 #import "NIInMemoryCache.h"
+#import "NIMemoryCacheAdmissionPolicy.h"
 #import "NSDate+UnitTesting.h"
 
 @interface NIMemoryCacheTests : XCTestCase {
@@ -29,6 +30,39 @@
 
 @end
 
+// Records the removals it's told about and whether the cache could be used at the time.
+@interface NIMemoryCacheTestsRemovalCache : NIMemoryCache
+@property (nonatomic, strong) NSMutableArray* removedNames;
+@property (nonatomic, assign) BOOL wasStillInCache;
+@end
+
+@implementation NIMemoryCacheTestsRemovalCache
+
+- (void)didRemoveObject:(id)object withName:(NSString *)name {
+  if (nil == self.removedNames) {
+    self.removedNames = [NSMutableArray array];
+  }
+  [self.removedNames addObject:name];
+  self.wasStillInCache = self.wasStillInCache || [self containsObjectWithName:name];
+}
+
+@end
+
+// Calls the block from dealloc.
+@interface NIMemoryCacheTestsDeallocTracker : NSObject
+@property (nonatomic, copy) void (^deallocBlock)(void);
+@end
+
+@implementation NIMemoryCacheTestsDeallocTracker
+
+- (void)dealloc {
+  if (nil != _deallocBlock) {
+    _deallocBlock();
+  }
+}
+
+@end
+
 @implementation NIMemoryCacheTests
 
 
@@ -91,6 +125,37 @@
   XCTAssertEqual([cache count], (NSUInteger)1, @"Cache should have one object.");
 }
 
+- (void)testRemovingCachePrefixesWithPrefixIndex {
+  NIMemoryCache* cache = [[NIMemoryCache alloc] init];
+  [cache storeObject:[NSArray array] withName:@"user1/feed1/a"];
+  cache.indexesNamesByPrefix = YES;
+
+  [cache storeObject:[NSArray array] withName:@"user1/feed1/b"];
+  [cache storeObject:[NSArray array] withName:@"user1/feed2/a"];
+  [cache storeObject:[NSArray array] withName:@"user1/feed"];
+  [cache storeObject:[NSArray array] withName:@"user2/feed1/a"];
+
+  NSArray* names = [[cache namesOfObjectsWithPrefix:@"user1/feed1"] sortedArrayUsingSelector:@selector(compare:)];
+  XCTAssertEqualObjects(names, (@[@"user1/feed1/a", @"user1/feed1/b"]),
+                        @"Only the names with the prefix should be returned.");
+  XCTAssertEqual([cache namesOfObjectsWithPrefix:@"user1/f"].count, (NSUInteger)4,
+                 @"Prefixes that end in the middle of an edge should match.");
+  XCTAssertEqual([cache namesOfObjectsWithPrefix:@"user3"].count, (NSUInteger)0,
+                 @"No names should match.");
+
+  [cache removeObjectWithName:@"user1/feed"];
+  XCTAssertEqual([cache namesOfObjectsWithPrefix:@"user1/feed"].count, (NSUInteger)3,
+                 @"Removing a name should remove it from the index.");
+
+  [cache removeAllObjectsWithPrefix:@"user1/feed1"];
+  XCTAssertEqual([cache count], (NSUInteger)2, @"Cache should have two objects.");
+  XCTAssertTrue([cache containsObjectWithName:@"user1/feed2/a"], @"user1/feed2/a should still be around.");
+  XCTAssertTrue([cache containsObjectWithName:@"user2/feed1/a"], @"user2/feed1/a should still be around.");
+
+  [cache removeAllObjectsWithPrefix:@""];
+  XCTAssertEqual([cache count], (NSUInteger)0, @"The empty prefix should match every name.");
+}
+
 - (void)testRemovingAllObjects {
   NIMemoryCache* cache = [[NIMemoryCache alloc] init];
 
@@ -378,6 +443,44 @@
                  @"The most recently used object should be object 1.");
 }
 
+- (void)testLeastAndMostRecentlyUsedObjectsAfterRemoval {
+  NIMemoryCache* cache = [[NIMemoryCache alloc] init];
+
+  [cache storeObject:[NSArray array] withName:@"obj1"];
+  [cache storeObject:[NSDictionary dictionary] withName:@"obj2"];
+  [cache storeObject:[NSSet set] withName:@"obj3"];
+
+  // Remove the middle of the list.
+  [cache removeObjectWithName:@"obj2"];
+
+  XCTAssertEqual(@"obj1", [cache nameOfLeastRecentlyUsedObject],
+                 @"The least recently used object should be object 1.");
+  XCTAssertEqual(@"obj3", [cache nameOfMostRecentlyUsedObject],
+                 @"The most recently used object should be object 3.");
+
+  // Remove both ends of the list.
+  [cache removeObjectWithName:@"obj1"];
+  XCTAssertEqual(@"obj3", [cache nameOfLeastRecentlyUsedObject],
+                 @"The only object should be both the least and most recently used object.");
+  XCTAssertEqual(@"obj3", [cache nameOfMostRecentlyUsedObject],
+                 @"The only object should be both the least and most recently used object.");
+
+  [cache removeObjectWithName:@"obj3"];
+  XCTAssertNil([cache nameOfLeastRecentlyUsedObject],
+               @"There should not be a least-recently-used object.");
+  XCTAssertNil([cache nameOfMostRecentlyUsedObject],
+               @"There should not be a most-recently-used object.");
+
+  // Storing over an existing name counts as an access.
+  [cache storeObject:[NSArray array] withName:@"obj1"];
+  [cache storeObject:[NSArray array] withName:@"obj2"];
+  [cache storeObject:[NSArray array] withName:@"obj1"];
+  XCTAssertEqual(@"obj2", [cache nameOfLeastRecentlyUsedObject],
+                 @"The least recently used object should be object 2.");
+  XCTAssertEqual(@"obj1", [cache nameOfMostRecentlyUsedObject],
+                 @"The most recently used object should be object 1.");
+}
+
 - (void)testReduceMemoryUsage {
   NIMemoryCache* cache = [[NIMemoryCache alloc] init];
 
@@ -412,6 +515,430 @@
   [NSDate swizzleMethodsForUnitTesting];
 }
 
+- (void)testRemoveExpiredObjectsOnlyRemovesExpiredObjects {
+  NIMemoryCache* cache = [[NIMemoryCache alloc] init];
+
+  // Store the objects out of expiration order.
+  for (NSInteger ix = 10; ix > 0; --ix) {
+    [cache storeObject:@(ix)
+              withName:[NSString stringWithFormat:@"obj%zd", ix]
+          expiresAfter:[NSDate dateWithTimeIntervalSinceNow:ix * 10]];
+  }
+  [cache storeObject:@0 withName:@"forever"];
+
+  // Replacing an object replaces its expiration date.
+  [cache storeObject:@3 withName:@"obj3" expiresAfter:[NSDate dateWithTimeIntervalSinceNow:1000]];
+
+  // Build both dates before faking the current time.
+  NSDate* muchLater = [NSDate dateWithTimeIntervalSinceNow:95];
+  [NSDate setFakeDate:[NSDate dateWithTimeIntervalSinceNow:55]];
+
+  // This makes [NSDate date] call our fakeDate implementation, which allows us to fake the
+  // current time so that we don't have to pause the tests while we wait for the object to
+  // expire.
+  [NSDate swizzleMethodsForUnitTesting];
+
+  [cache removeExpiredObjects];
+
+  XCTAssertEqual([cache count], (NSUInteger)7, @"obj1, obj2, obj4 and obj5 should have expired.");
+  XCTAssertTrue([cache containsObjectWithName:@"obj3"], @"obj3 should still be around.");
+  XCTAssertTrue([cache containsObjectWithName:@"obj6"], @"obj6 should still be around.");
+  XCTAssertTrue([cache containsObjectWithName:@"forever"], @"Objects without expiration dates never expire.");
+
+  // Removing objects from the middle of the heap should keep it ordered.
+  [cache removeObjectWithName:@"obj8"];
+  [NSDate setFakeDate:muchLater];
+  [cache removeExpiredObjects];
+
+  XCTAssertEqual([cache count], (NSUInteger)3, @"Only obj3, obj10 and forever should be left.");
+  XCTAssertTrue([cache containsObjectWithName:@"obj10"], @"obj10 should still be around.");
+
+  // Reset the class implementations when we're done with them.
+  [NSDate swizzleMethodsForUnitTesting];
+}
+
+- (void)testStatisticsCountLookupsAndExpirations {
+  NIMemoryCache* cache = [[NIMemoryCache alloc] init];
+
+  [cache storeObject:@1 withName:@"obj1"];
+  [cache storeObject:@2 withName:@"obj2" expiresAfter:[NSDate dateWithTimeIntervalSinceNow:10]];
+  [cache objectWithName:@"obj1"];
+  [cache objectWithName:@"obj1"];
+  [cache objectWithName:@"missing"];
+  [cache removeObjectWithName:@"obj1"];
+
+  NIMemoryCacheStatistics* statistics = [cache statistics];
+  XCTAssertEqual(statistics.numberOfStores, (unsigned long long)2, @"Both stores should be counted.");
+  XCTAssertEqual(statistics.numberOfHits, (unsigned long long)2, @"obj1 was found twice.");
+  XCTAssertEqual(statistics.numberOfMisses, (unsigned long long)1, @"missing was never stored.");
+  XCTAssertEqualWithAccuracy(statistics.hitRate, 2.0 / 3.0, 0.0001, @"Two of three lookups hit.");
+  XCTAssertEqual(statistics.numberOfEvictions + statistics.numberOfExpirations, (unsigned long long)0,
+                 @"Explicit removals are not evictions.");
+  XCTAssertTrue(statistics.numberOfLockHolds > 0, @"The lock was held by every store and lookup.");
+
+  [NSDate setFakeDate:[NSDate dateWithTimeIntervalSinceNow:20]];
+  [NSDate swizzleMethodsForUnitTesting];
+
+  XCTAssertNil([cache objectWithName:@"obj2"], @"obj2 should have expired.");
+
+  [NSDate swizzleMethodsForUnitTesting];
+
+  statistics = [cache statistics];
+  XCTAssertEqual(statistics.numberOfExpirations, (unsigned long long)1, @"obj2 expired.");
+  XCTAssertEqual(statistics.numberOfMisses, (unsigned long long)2, @"Expired objects are misses.");
+
+  [cache resetStatistics];
+  statistics = [cache statistics];
+  XCTAssertEqual(statistics.numberOfStores + statistics.numberOfHits + statistics.numberOfMisses
+                 + statistics.numberOfExpirations + statistics.numberOfLockHolds, (unsigned long long)0,
+                 @"Resetting should clear every counter.");
+}
+
+- (void)testBatchStoreAndLookup {
+  NIMemoryCache* cache = [[NIMemoryCache alloc] init];
+  [cache storeObject:@0 withName:@"obj0"];
+  [cache storeObjects:@[@1, @2, @3] withNames:@[@"obj1", @"obj2", @"obj3"] expiresAfter:nil];
+
+  XCTAssertEqual([cache count], (NSUInteger)4, @"All of the objects should be stored.");
+  XCTAssertEqualObjects([cache nameOfMostRecentlyUsedObject], @"obj3", @"The last object should be the most recently used.");
+
+  NSDictionary* objects = [cache objectsWithNames:@[@"obj2", @"missing", @"obj0"]];
+  XCTAssertEqualObjects(objects, (@{@"obj2": @2, @"obj0": @0}), @"Only the names in the cache should be returned.");
+  XCTAssertEqualObjects([cache nameOfLeastRecentlyUsedObject], @"obj1", @"obj1 is the only object that wasn't looked up.");
+  XCTAssertEqualObjects([cache nameOfMostRecentlyUsedObject], @"obj0", @"The lookups should happen in order.");
+
+  NIMemoryCacheStatistics* statistics = [cache statistics];
+  XCTAssertEqual(statistics.numberOfHits, (unsigned long long)2, @"Two of the names were found.");
+  XCTAssertEqual(statistics.numberOfMisses, (unsigned long long)1, @"One of the names was missing.");
+}
+
+- (void)testBatchLookupSkipsExpiredObjects {
+  NIMemoryCache* cache = [[NIMemoryCache alloc] initWithCapacity:0 numberOfSegments:4];
+  [cache storeObjects:@[@1, @2] withNames:@[@"obj1", @"obj2"] expiresAfter:[NSDate dateWithTimeIntervalSinceNow:10]];
+  [cache storeObject:@3 withName:@"obj3"];
+
+  [NSDate setFakeDate:[NSDate dateWithTimeIntervalSinceNow:20]];
+  [NSDate swizzleMethodsForUnitTesting];
+
+  NSDictionary* objects = [cache objectsWithNames:@[@"obj1", @"obj2", @"obj3"]];
+
+  [NSDate swizzleMethodsForUnitTesting];
+
+  XCTAssertEqualObjects(objects, (@{@"obj3": @3}), @"The expired objects should not be returned.");
+  XCTAssertEqual([cache count], (NSUInteger)1, @"The expired objects should be removed.");
+}
+
+#pragma mark - Admission Policies
+
+- (void)testTinyLFUSketchCountsAndAges {
+  NITinyLFUAdmissionPolicy* policy = [[NITinyLFUAdmissionPolicy alloc] initWithExpectedNumberOfObjects:16];
+
+  for (NSInteger ix = 0; ix < 5; ++ix) {
+    [policy recordAccessOfName:@"hot"];
+  }
+  [policy recordAccessOfName:@"cold"];
+
+  XCTAssertTrue([policy estimatedFrequencyOfName:@"hot"] >= 5, @"Every access should be counted.");
+  XCTAssertTrue([policy shouldAdmitName:@"hot" evictingName:@"cold"], @"The more frequent name should win.");
+  XCTAssertFalse([policy shouldAdmitName:@"cold" evictingName:@"hot"], @"The less frequent name should lose.");
+
+  // Ten accesses per column age the sketch, after which old counts are halved.
+  for (NSInteger ix = 0; ix < 160; ++ix) {
+    [policy recordAccessOfName:[NSString stringWithFormat:@"scan%zd", ix]];
+  }
+  XCTAssertTrue([policy estimatedFrequencyOfName:@"hot"] < 5, @"Aging should halve the counts.");
+}
+
+- (void)testTinyLFUResistsScans {
+  // A small hot set interleaved with long scans of names that are only seen once.
+  NSMutableArray* trace = [NSMutableArray array];
+  NSInteger scanIndex = 0;
+  for (NSInteger round = 0; round < 20; ++round) {
+    for (NSInteger ix = 0; ix < 10; ++ix) {
+      [trace addObject:[NSString stringWithFormat:@"hot%zd", ix]];
+    }
+    for (NSInteger ix = 0; ix < 50; ++ix) {
+      [trace addObject:[NSString stringWithFormat:@"scan%zd", scanIndex++]];
+    }
+  }
+
+  NIMemoryCacheStatistics* lru = [NIMemoryCacheTraceReplay statisticsForReplayingTrace:trace
+                                                                      numberOfObjects:20
+                                                                      admissionPolicy:nil];
+  NITinyLFUAdmissionPolicy* policy = [[NITinyLFUAdmissionPolicy alloc] initWithExpectedNumberOfObjects:256];
+  NIMemoryCacheStatistics* tinyLFU = [NIMemoryCacheTraceReplay statisticsForReplayingTrace:trace
+                                                                          numberOfObjects:20
+                                                                          admissionPolicy:policy];
+
+  XCTAssertEqual(lru.numberOfHits, 0ULL, @"Each scan should flush the hot set out of an LRU cache.");
+  XCTAssertTrue(tinyLFU.hitRate > 0.1, @"The hot set should survive the scans, got %f.", tinyLFU.hitRate);
+}
+
+- (void)testImageCacheAdmissionPolicyKeepsFrequentImages {
+  NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] init];
+  cache.maxNumberOfPixels = 2;
+  cache.admissionPolicy = [[NITinyLFUAdmissionPolicy alloc] init];
+
+  UIImage* image = [self emptyImageWithSize:CGSizeMake(1, 1)];
+  [cache storeObject:image withName:@"hot"];
+  for (NSInteger ix = 0; ix < 5; ++ix) {
+    [cache objectWithName:@"hot"];
+  }
+  [cache storeObject:image withName:@"warm"];
+  [cache objectWithName:@"warm"];
+
+  [cache storeObject:image withName:@"once"];
+
+  XCTAssertTrue([cache containsObjectWithName:@"hot"], @"The frequently used image should stay.");
+  XCTAssertTrue([cache containsObjectWithName:@"warm"], @"The image used twice should stay.");
+  XCTAssertFalse([cache containsObjectWithName:@"once"], @"The new image should not be admitted.");
+}
+
+#pragma mark - Lower Tiers
+
+- (void)testWeakTierFindsEvictedObjectsThatAreStillAlive {
+  NIMemoryCache* cache = [[NIMemoryCache alloc] init];
+  cache.keepsWeakReferencesToEvictedObjects = YES;
+
+  NSObject* retainedObject = [[NSObject alloc] init];
+  @autoreleasepool {
+    [cache storeObject:retainedObject withName:@"retained" cost:1];
+    [cache storeObject:[[NSObject alloc] init] withName:@"released" cost:1];
+    [cache reduceMemoryUsageByNumberOfBytes:2];
+  }
+
+  XCTAssertEqual([cache count], (NSUInteger)0, @"Both objects should have been evicted.");
+  XCTAssertEqual([cache objectWithName:@"retained"], retainedObject, @"The live object should be found.");
+  XCTAssertEqual([cache count], (NSUInteger)0, @"Weak hits should not be stored again.");
+  XCTAssertNil([cache objectWithName:@"released"], @"The released object should be gone.");
+
+  [cache removeObjectWithName:@"retained"];
+  XCTAssertNil([cache objectWithName:@"retained"], @"Removing an object should drop its weak reference.");
+}
+
+- (void)testEncodedTierDecodesEvictedObjects {
+  NIMemoryCache* cache = [[NIMemoryCache alloc] init];
+  cache.maxNumberOfEncodedBytes = 8;
+  cache.dataFromObject = ^NSData *(id object) {
+    return [object dataUsingEncoding:NSUTF8StringEncoding];
+  };
+  cache.objectFromData = ^id(NSData* data) {
+    return [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+  };
+
+  [cache storeObject:@"abcd" withName:@"obj1" cost:100];
+  [cache storeObject:@"efgh" withName:@"obj2" cost:100];
+  [cache storeObject:@"ijkl" withName:@"obj3" cost:100];
+  [cache reduceMemoryUsageByNumberOfBytes:300];
+
+  XCTAssertEqual([cache count], (NSUInteger)0, @"All objects should have been evicted.");
+  XCTAssertNil([cache objectWithName:@"obj1"], @"Only the 8 most recently evicted bytes should be kept.");
+  XCTAssertEqualObjects([cache objectWithName:@"obj2"], @"efgh", @"The object should be decoded.");
+  XCTAssertEqual([cache count], (NSUInteger)1, @"Decoded objects should be stored again.");
+  XCTAssertEqualObjects([cache objectWithName:@"obj3"], @"ijkl", @"The object should be decoded.");
+  XCTAssertEqual([cache statistics].numberOfHits, 2ULL, @"Decoded objects should count as hits.");
+}
+
+- (void)testEvictedObjectsAreEncodedWithoutTheCacheLocked {
+  NIMemoryCache* cache = [[NIMemoryCache alloc] init];
+  cache.maxNumberOfEncodedBytes = 1024;
+  __weak NIMemoryCache* weakCache = cache;
+  __block BOOL couldReadWhileEncoding = NO;
+  cache.dataFromObject = ^NSData *(id object) {
+    // Another thread can only read the cache if the evicting thread doesn't hold its lock.
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+      [weakCache count];
+      dispatch_semaphore_signal(semaphore);
+    });
+    couldReadWhileEncoding = (0 == dispatch_semaphore_wait(semaphore,
+                                                           dispatch_time(DISPATCH_TIME_NOW, NSEC_PER_SEC)));
+    return [object dataUsingEncoding:NSUTF8StringEncoding];
+  };
+  cache.objectFromData = ^id(NSData* data) {
+    return [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+  };
+
+  [cache storeObject:@"abcd" withName:@"obj1" cost:100];
+  [cache reduceMemoryUsageByNumberOfBytes:100];
+
+  XCTAssertTrue(couldReadWhileEncoding, @"Encoding should not block other readers.");
+  XCTAssertEqualObjects([cache objectWithName:@"obj1"], @"abcd", @"The object should be decoded.");
+}
+
+- (void)testObjectsStoredAgainAreNotReplacedByTheirEncoding {
+  NIMemoryCache* cache = [[NIMemoryCache alloc] init];
+  cache.maxNumberOfEncodedBytes = 1024;
+  __weak NIMemoryCache* weakCache = cache;
+  cache.dataFromObject = ^NSData *(id object) {
+    // The name is stored again before the encoding is kept.
+    [weakCache storeObject:@"new" withName:@"obj1"];
+    [weakCache removeObjectWithName:@"obj1"];
+    return [object dataUsingEncoding:NSUTF8StringEncoding];
+  };
+  cache.objectFromData = ^id(NSData* data) {
+    return [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+  };
+
+  [cache storeObject:@"old" withName:@"obj1" cost:100];
+  [cache reduceMemoryUsageByNumberOfBytes:100];
+
+  XCTAssertNil([cache objectWithName:@"obj1"], @"A late encoding should not bring back a removed object.");
+}
+
+#pragma mark - Removals
+
+- (void)testStoringAnExpiredObjectDropsItsEvictedCopies {
+  NIMemoryCache* cache = [[NIMemoryCache alloc] init];
+  cache.maxNumberOfEncodedBytes = 1024;
+  cache.dataFromObject = ^NSData *(id object) {
+    return [object dataUsingEncoding:NSUTF8StringEncoding];
+  };
+  cache.objectFromData = ^id(NSData* data) {
+    return [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+  };
+
+  [cache storeObject:@"old" withName:@"obj1" cost:100];
+  [cache reduceMemoryUsageByNumberOfBytes:100];
+  [cache storeObject:@"new" withName:@"obj1" expiresAfter:[NSDate dateWithTimeIntervalSinceNow:-1]];
+
+  XCTAssertNil([cache objectWithName:@"obj1"], @"The evicted copy should not outlive an expired store.");
+}
+
+- (void)testRemovalsAreReportedAfterTheyComplete {
+  NIMemoryCacheTestsRemovalCache* cache = [[NIMemoryCacheTestsRemovalCache alloc] init];
+  [cache storeObject:@"a" withName:@"obj1" cost:1];
+  [cache storeObject:@"b" withName:@"obj2" cost:1];
+  [cache storeObject:@"c" withName:@"obj3" cost:1];
+
+  [cache removeObjectWithName:@"obj1"];
+  [cache reduceMemoryUsageByNumberOfBytes:1];
+
+  NSArray* expectedNames = @[@"obj1", @"obj2"];
+  XCTAssertEqualObjects(cache.removedNames, expectedNames, @"Both removals should be reported in order.");
+  XCTAssertFalse(cache.wasStillInCache, @"Objects should be gone by the time they're reported.");
+}
+
+- (void)testRemovedObjectsCanBeReleasedInBackground {
+  NIMemoryCache* cache = [[NIMemoryCache alloc] init];
+  cache.releasesRemovedObjectsInBackground = YES;
+
+  __block BOOL wasReleased = NO;
+  __block BOOL wasReleasedOnMainThread = NO;
+  @autoreleasepool {
+    NIMemoryCacheTestsDeallocTracker* tracker = [[NIMemoryCacheTestsDeallocTracker alloc] init];
+    tracker.deallocBlock = ^{
+      @synchronized(self) {
+        wasReleased = YES;
+        wasReleasedOnMainThread = [NSThread isMainThread];
+      }
+    };
+    [cache storeObject:tracker withName:@"tracker"];
+    [cache removeObjectWithName:@"tracker"];
+  }
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  BOOL released = NO;
+  while (!released && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    @synchronized(self) {
+      released = wasReleased;
+    }
+  }
+  XCTAssertTrue(released, @"The removed object should have been released.");
+  XCTAssertFalse(wasReleasedOnMainThread, @"The removed object should be released in the background.");
+}
+
+#pragma mark - Segmented In-Memory Cache
+
+
+- (void)testSegmentedCacheStoresAndRemovesObjects {
+  NIMemoryCache* cache = [[NIMemoryCache alloc] initWithCapacity:0 numberOfSegments:4];
+
+  XCTAssertEqual(cache.numberOfSegments, (NSUInteger)4, @"Cache should have four segments.");
+
+  for (NSInteger ix = 0; ix < 100; ++ix) {
+    [cache storeObject:@(ix) withName:[NSString stringWithFormat:@"obj%zd", ix]];
+  }
+
+  XCTAssertEqual([cache count], (NSUInteger)100, @"Cache should have 100 objects in it.");
+  XCTAssertEqualObjects([cache objectWithName:@"obj42"], @42, @"Cache object should be equal.");
+  XCTAssertTrue([cache containsObjectWithName:@"obj7"], @"obj7 should exist in the cache.");
+  XCTAssertEqualObjects(@"obj42", [cache nameOfMostRecentlyUsedObject],
+                        @"The most recently used object should be object 42.");
+  XCTAssertEqualObjects(@"obj0", [cache nameOfLeastRecentlyUsedObject],
+                        @"The least recently used object should be object 0.");
+
+  [cache removeObjectWithName:@"obj42"];
+  XCTAssertNil([cache objectWithName:@"obj42"], @"obj42 should have been removed.");
+
+  [cache removeAllObjectsWithPrefix:@"obj1"];
+  XCTAssertEqual([cache count], (NSUInteger)88, @"obj1 and obj10-obj19 should have been removed.");
+
+  [cache removeAllObjects];
+  XCTAssertEqual([cache count], (NSUInteger)0, @"Cache should now be empty.");
+}
+
+- (void)testSegmentedImageCacheEnforcesGlobalLimit {
+  NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] initWithCapacity:0 numberOfSegments:4];
+
+  static const NSUInteger numberOfPixelsInOneImage = 10 * 10;
+  cache.maxNumberOfPixels = numberOfPixelsInOneImage * 4;
+  cache.maxNumberOfPixelsUnderStress = numberOfPixelsInOneImage * 2;
+
+  for (NSInteger ix = 0; ix < 10; ++ix) {
+    [cache storeObject:[self emptyImageWithSize:CGSizeMake(10, 10)]
+              withName:[NSString stringWithFormat:@"img%zd", ix]];
+  }
+
+  XCTAssertEqual([cache count], (NSUInteger)4, @"Cache should have four images.");
+  XCTAssertEqual(cache.numberOfPixels, (unsigned long long)(numberOfPixelsInOneImage * 4),
+                 @"The pixel count should be summed across segments.");
+  for (NSInteger ix = 6; ix < 10; ++ix) {
+    XCTAssertTrue([cache containsObjectWithName:[NSString stringWithFormat:@"img%zd", ix]],
+                  @"The most recently stored images should still be around.");
+  }
+
+  [cache reduceMemoryUsage];
+
+  XCTAssertEqual([cache count], (NSUInteger)2, @"Cache should have two images.");
+  XCTAssertTrue([cache containsObjectWithName:@"img8"], @"Image 8 should still be around.");
+  XCTAssertTrue([cache containsObjectWithName:@"img9"], @"Image 9 should still be around.");
+}
+
+- (void)testSegmentedCacheUnderConcurrentReadsAndWrites {
+  NIMemoryCache* cache = [[NIMemoryCache alloc] initWithCapacity:0 numberOfSegments:16];
+
+  static const NSUInteger kNumberOfNames = 512;
+  NSMutableArray* names = [NSMutableArray arrayWithCapacity:kNumberOfNames];
+  for (NSUInteger ix = 0; ix < kNumberOfNames; ++ix) {
+    [names addObject:[NSString stringWithFormat:@"http://example.com/image/%zd.png", ix]];
+  }
+
+  __block int32_t numberOfMismatches = 0;
+  dispatch_apply(8, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t thread) {
+    for (NSUInteger ix = 0; ix < 20000; ++ix) {
+      NSString* name = names[(ix * 31 + thread * 7) % kNumberOfNames];
+
+      // One write for every eight reads.
+      if (0 == ix % 8) {
+        [cache storeObject:name withName:name];
+      } else {
+        id object = [cache objectWithName:name];
+        if (nil != object && ![object isEqual:name]) {
+          __atomic_fetch_add(&numberOfMismatches, 1, __ATOMIC_RELAXED);
+        }
+      }
+    }
+  });
+
+  XCTAssertEqual(numberOfMismatches, (int32_t)0, @"Every read should find the object stored under its name.");
+  XCTAssertEqual([cache count], kNumberOfNames, @"Every name should have been stored exactly once.");
+  for (NSString* name in names) {
+    XCTAssertEqualObjects([cache objectWithName:name], name, @"Each segment should keep its own entries.");
+  }
+}
+
 #pragma mark - Image In-Memory Cache
 
 
@@ -447,6 +974,61 @@
   XCTAssertNotNil([cache objectWithName:@"obj2"], @"Image 2 should still be around.");
 }
 
+- (void)testImageCacheStoresImagesInPurgeableMemory {
+  NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] init];
+  cache.storesImagesInPurgeableMemory = YES;
+
+  UIImage* image = [self emptyImageWithSize:CGSizeMake(100, 50)];
+  [cache storeObject:image withName:@"obj1"];
+
+  UIImage* cachedImage = [cache objectWithName:@"obj1"];
+  XCTAssertNotNil(cachedImage, @"The image should be in the cache.");
+  XCTAssertTrue(cachedImage != image, @"The cache should hand out images drawing from its own copy.");
+  XCTAssertTrue(CGSizeEqualToSize(cachedImage.size, image.size), @"The copy should be the same size.");
+  XCTAssertEqual(cache.numberOfPixels, (unsigned long long)(100 * 50), @"The copy should be charged its pixels.");
+
+  [cache removeObjectWithName:@"obj1"];
+  XCTAssertEqual(cache.numberOfPixels, (unsigned long long)0, @"Cache should have zero pixels.");
+  XCTAssertEqual(cache.numberOfBytes, (unsigned long long)0, @"Cache should have zero bytes.");
+  XCTAssertNotNil(cachedImage.CGImage, @"Images that were handed out should outlive the entry.");
+}
+
+- (void)testEvictedPurgeableImagesReachTheEncodedTier {
+  NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] init];
+  cache.storesImagesInPurgeableMemory = YES;
+  cache.keepsWeakReferencesToEvictedObjects = YES;
+  cache.maxNumberOfEncodedBytes = 1024 * 1024;
+
+  UIImage* image = [self emptyImageWithSize:CGSizeMake(100, 50)];
+  [cache storeObject:image withName:@"obj1"];
+  [cache reduceMemoryUsageByNumberOfBytes:ULLONG_MAX];
+  XCTAssertEqual([cache count], (NSUInteger)0, @"The image should have been evicted.");
+
+  UIImage* decodedImage = [cache objectWithName:@"obj1"];
+  XCTAssertNotNil(decodedImage, @"The evicted copy should be decoded from the encoded tier.");
+  XCTAssertEqual(CGImageGetWidth(decodedImage.CGImage), CGImageGetWidth(image.CGImage),
+                 @"The decoded image should have the original's pixels.");
+}
+
+- (void)testEncodedImagesKeepTheirScaleAndOrientation {
+  NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] init];
+  cache.maxNumberOfEncodedBytes = 1024 * 1024;
+
+  UIImage* pixels = [self emptyImageWithSize:CGSizeMake(30, 20)];
+  CGFloat scale = ([[UIScreen mainScreen] scale] == 3) ? 2 : 3;
+  UIImage* image = [UIImage imageWithCGImage:pixels.CGImage scale:scale orientation:UIImageOrientationRight];
+  [cache storeObject:image withName:@"obj1"];
+  [cache reduceMemoryUsageByNumberOfBytes:ULLONG_MAX];
+  XCTAssertEqual([cache count], (NSUInteger)0, @"The image should have been evicted.");
+
+  UIImage* decodedImage = [cache objectWithName:@"obj1"];
+  XCTAssertNotNil(decodedImage, @"The image should be decoded from the encoded tier.");
+  XCTAssertEqual(decodedImage.scale, scale, @"The decoded image should keep its scale.");
+  XCTAssertEqual(decodedImage.imageOrientation, UIImageOrientationRight,
+                 @"The decoded image should keep its orientation.");
+  XCTAssertTrue(CGSizeEqualToSize(decodedImage.size, image.size), @"The decoded image should keep its size.");
+}
+
 - (void)testImageCacheRemoveAllObjects {
   NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] init];
 
@@ -512,6 +1094,150 @@
   NIDebugAssertionsShouldBreak = YES;
 }
 
+- (unsigned long long)numberOfBytesInImage:(UIImage *)image {
+  return CGImageGetBytesPerRow(image.CGImage) * CGImageGetHeight(image.CGImage);
+}
+
+- (void)testImageCacheCountsBytes {
+  NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] init];
+
+  UIImage* img1 = [self emptyImageWithSize:CGSizeMake(100, 100)];
+  UIImage* img2 = [self emptyImageWithSize:CGSizeMake(50, 50)];
+  [cache storeObject:img1 withName:@"obj1"];
+  [cache storeObject:img2 withName:@"obj2"];
+
+  XCTAssertEqual(cache.numberOfBytes, [self numberOfBytesInImage:img1] + [self numberOfBytesInImage:img2],
+                 @"The cache should count the decoded bytes of each image.");
+
+  [cache removeObjectWithName:@"obj1"];
+  XCTAssertEqual(cache.numberOfBytes, [self numberOfBytesInImage:img2],
+                 @"Removing an image should stop counting its bytes.");
+
+  // Replacing an image should count the new image's bytes instead of the old image's.
+  [cache storeObject:img1 withName:@"obj2"];
+  XCTAssertEqual(cache.numberOfBytes, [self numberOfBytesInImage:img1],
+                 @"Replacing an image should count the new image's bytes.");
+  XCTAssertEqual(cache.numberOfPixels, (unsigned long long)(100 * 100),
+                 @"Replacing an image should count the new image's pixels.");
+}
+
+- (void)testImageCacheCountsSharedBitmapsOnce {
+  NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] init];
+
+  UIImage* img1 = [self emptyImageWithSize:CGSizeMake(100, 100)];
+  UIImage* img2 = [UIImage imageWithCGImage:img1.CGImage scale:2 orientation:UIImageOrientationUp];
+  [cache storeObject:img1 withName:@"obj1"];
+  [cache storeObject:img2 withName:@"obj2"];
+
+  XCTAssertEqual(cache.numberOfBytes, [self numberOfBytesInImage:img1],
+                 @"Images that share a bitmap should only be counted once.");
+
+  [cache removeObjectWithName:@"obj1"];
+  XCTAssertEqual(cache.numberOfBytes, [self numberOfBytesInImage:img1],
+                 @"The shared bitmap is still in use by the second image.");
+
+  [cache removeObjectWithName:@"obj2"];
+  XCTAssertEqual(cache.numberOfBytes, (unsigned long long)0, @"Cache should have zero bytes.");
+}
+
+- (void)testImageCacheExplicitCost {
+  NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] init];
+  cache.maxNumberOfBytes = 1000;
+
+  [cache storeObject:[self emptyImageWithSize:CGSizeMake(100, 100)] withName:@"obj1" cost:600];
+  XCTAssertEqual(cache.numberOfBytes, (unsigned long long)600, @"The explicit cost should be used.");
+
+  // This second image will push out the first image.
+  [cache storeObject:[self emptyImageWithSize:CGSizeMake(100, 100)] withName:@"obj2" cost:600];
+
+  XCTAssertEqual([cache count], (NSUInteger)1, @"Cache should have one object.");
+  XCTAssertNil([cache objectWithName:@"obj1"], @"Image 1 should not still be around.");
+  XCTAssertEqual(cache.numberOfBytes, (unsigned long long)600, @"Only image 2 should be counted.");
+}
+
+- (void)testImageCacheReleasesExplicitCostOnReplaceAndRemove {
+  NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] init];
+
+  [cache storeObject:[self emptyImageWithSize:CGSizeMake(100, 100)] withName:@"obj1" cost:600];
+  [cache storeObject:[self emptyImageWithSize:CGSizeMake(50, 50)] withName:@"obj1" cost:200];
+  XCTAssertEqual(cache.numberOfBytes, (unsigned long long)200,
+                 @"Replacing an image should release the cost it was stored with.");
+
+  UIImage* img = [self emptyImageWithSize:CGSizeMake(10, 10)];
+  [cache storeObject:img withName:@"obj1"];
+  XCTAssertEqual(cache.numberOfBytes, [self numberOfBytesInImage:img],
+                 @"Replacing a costed image with an uncosted one should count the bitmap only.");
+
+  [cache storeObject:img withName:@"obj1" cost:300];
+  [cache removeObjectWithName:@"obj1"];
+  XCTAssertEqual(cache.numberOfBytes, (unsigned long long)0, @"Cache should have zero bytes.");
+}
+
+- (void)testImageCacheReduceMemoryUsageByBytes {
+  NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] init];
+
+  UIImage* img1 = [self emptyImageWithSize:CGSizeMake(100, 100)];
+  UIImage* img2 = [self emptyImageWithSize:CGSizeMake(100, 100)];
+  cache.maxNumberOfBytesUnderStress = [self numberOfBytesInImage:img1];
+
+  [cache storeObject:img1 withName:@"obj1"];
+  [cache storeObject:img2 withName:@"obj2"];
+
+  [cache reduceMemoryUsage];
+
+  XCTAssertEqual([cache count], (NSUInteger)1, @"Cache should have one object.");
+  XCTAssertNil([cache objectWithName:@"obj1"], @"Image 1 should not still be around.");
+  XCTAssertNotNil([cache objectWithName:@"obj2"], @"Image 2 should still be around.");
+}
+
+- (void)testImageCacheStatisticsSplitEvictionsByCause {
+  NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] initWithCapacity:0 numberOfSegments:2];
+
+  UIImage* img1 = [self emptyImageWithSize:CGSizeMake(100, 100)];
+  UIImage* img2 = [self emptyImageWithSize:CGSizeMake(100, 100)];
+  UIImage* img3 = [self emptyImageWithSize:CGSizeMake(100, 100)];
+  unsigned long long numberOfBytesInOneImage = [self numberOfBytesInImage:img1];
+  cache.maxNumberOfBytes = numberOfBytesInOneImage * 2;
+  cache.maxNumberOfBytesUnderStress = numberOfBytesInOneImage;
+
+  [cache storeObject:img1 withName:@"obj1"];
+  [cache storeObject:img2 withName:@"obj2"];
+  [cache storeObject:img3 withName:@"obj3"];
+
+  NIMemoryCacheStatistics* statistics = [cache statistics];
+  XCTAssertEqual(statistics.numberOfEvictions, (unsigned long long)1, @"Image 1 should have been evicted.");
+  XCTAssertEqual(statistics.numberOfStressEvictions, (unsigned long long)0, @"Nothing is under stress yet.");
+
+  [cache reduceMemoryUsage];
+
+  statistics = [cache statistics];
+  XCTAssertEqual(statistics.numberOfStressEvictions, (unsigned long long)1, @"Image 2 should have been evicted.");
+  XCTAssertEqual(statistics.numberOfBytesEvicted, numberOfBytesInOneImage * 2,
+                 @"Both evicted images should be counted.");
+}
+
+- (void)testImageCacheMemoryPressureLevels {
+  NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] init];
+  cache.maxNumberOfPixelsUnderStress = 100 * 100;
+
+  for (NSInteger ix = 0; ix < 4; ++ix) {
+    [cache storeObject:[self emptyImageWithSize:CGSizeMake(100, 100)]
+              withName:[NSString stringWithFormat:@"obj%zd", ix]];
+  }
+
+  [cache reduceMemoryUsageForPressureLevel:NIMemoryPressureLevelNormal];
+  XCTAssertEqual([cache count], (NSUInteger)4, @"Nothing should be removed without pressure.");
+
+  [cache reduceMemoryUsageForPressureLevel:NIMemoryPressureLevelWarning];
+  XCTAssertEqual([cache count], (NSUInteger)2, @"Half of the images should be removed.");
+  XCTAssertNotNil([cache objectWithName:@"obj2"], @"The most recently used images should be kept.");
+  XCTAssertNotNil([cache objectWithName:@"obj3"], @"The most recently used images should be kept.");
+
+  [cache reduceMemoryUsageForPressureLevel:NIMemoryPressureLevelCritical];
+  XCTAssertEqual([cache count], (NSUInteger)1, @"The cache should be down to its stress limit.");
+  XCTAssertNotNil([cache objectWithName:@"obj3"], @"The most recently used image should be kept.");
+}
+
 - (void)testImageCacheStoreTooMuch {
   NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] init];
 
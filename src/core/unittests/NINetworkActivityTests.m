@@ -36,4 +36,46 @@
   // test when it gets changed.
 }
 
+- (void)testConcurrentTasksLeaveTheIndicatorMatchingTheCount {
+  UIApplication* application = [UIApplication sharedApplication];
+  dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+
+  // Many threads cross between idle and busy at once while one task stays open.
+  dispatch_apply(1000, queue, ^(size_t ix) {
+    NINetworkActivityTaskDidStart();
+    NINetworkActivityTaskDidFinish();
+  });
+  NINetworkActivityTaskDidStart();
+  dispatch_apply(1000, queue, ^(size_t ix) {
+    NINetworkActivityTaskDidStart();
+    NINetworkActivityTaskDidFinish();
+  });
+  [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.3]];
+  XCTAssertTrue(application.networkActivityIndicatorVisible, @"A task is still running.");
+
+  NINetworkActivityTaskDidFinish();
+  [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.5]];
+  XCTAssertFalse(application.networkActivityIndicatorVisible, @"Every task has finished.");
+}
+
+- (void)testTaskMetricsAreRecordedWhenTasksFinish {
+  NSInteger numberOfActiveTasks = NINetworkTaskMetricsNumberOfActiveTasks();
+  NINetworkTaskMetrics metrics =
+      NINetworkTaskMetricsDidStart([NSURL URLWithString:@"http://nimbuskit.info/image.png"]);
+  XCTAssertEqual(NINetworkTaskMetricsNumberOfActiveTasks(), numberOfActiveTasks + 1);
+  XCTAssertTrue(metrics.timeToFirstByte < 0, @"No bytes have been received yet.");
+
+  NINetworkTaskMetricsDidReceiveBytes(&metrics, 100);
+  NINetworkTaskMetricsDidReceiveBytes(&metrics, 50);
+  NINetworkTaskMetricsDidFinish(&metrics);
+  XCTAssertEqual(NINetworkTaskMetricsNumberOfActiveTasks(), numberOfActiveTasks);
+
+  NINetworkTaskMetrics recentMetrics[1];
+  XCTAssertEqual(NINetworkTaskMetricsCopyRecent(recentMetrics, 1), (NSUInteger)1);
+  XCTAssertEqual(recentMetrics[0].numberOfBytes, 150ULL);
+  XCTAssertEqualObjects([NSString stringWithUTF8String:recentMetrics[0].host], @"nimbuskit.info");
+  XCTAssertTrue(recentMetrics[0].timeToFirstByte >= 0);
+  XCTAssertTrue(recentMetrics[0].duration >= recentMetrics[0].timeToFirstByte);
+}
+
 @end
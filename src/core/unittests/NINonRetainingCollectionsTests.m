@@ -31,4 +31,43 @@
 
 @implementation NINonRetainingCollectionsTests
 
+
+- (void)testPointerMapComparesByIdentityAcrossGrowthAndRemoval {
+  NIPointerMap* map = [[NIPointerMap alloc] initWithOptions:NIPointerCollectionOptionRetainKeys];
+  NSMutableArray* keys = [NSMutableArray array];
+  for (NSInteger ix = 0; ix < 100; ++ix) {
+    NSMutableString* key = [NSMutableString stringWithString:@"key"];
+    [keys addObject:key];
+    [map setObject:[NSNumber numberWithInteger:ix] forKey:key];
+  }
+  XCTAssertEqual(map.count, (NSUInteger)100, @"Equal keys are distinct objects.");
+  XCTAssertNil([map objectForKey:[NSMutableString stringWithString:@"key"]],
+               @"Lookups should not fall back to isEqual:.");
+
+  for (NSInteger ix = 0; ix < 100; ix += 2) {
+    [map removeObjectForKey:[keys objectAtIndex:ix]];
+  }
+  for (NSInteger ix = 0; ix < 100; ++ix) {
+    id expected = (ix % 2) ? [NSNumber numberWithInteger:ix] : nil;
+    XCTAssertEqualObjects([map objectForKey:[keys objectAtIndex:ix]], expected,
+                          @"Removals should not hide the keys that probed past them.");
+  }
+
+  NSUInteger numberOfKeys = 0;
+  for (id key in map) {
+    XCTAssertNotNil([map objectForKey:key]);
+    ++numberOfKeys;
+  }
+  XCTAssertEqual(numberOfKeys, (NSUInteger)50);
+
+  NIPointerSet* set = [[NIPointerSet alloc] initWithOptions:NIPointerCollectionOptionNone];
+  [set addObject:[keys objectAtIndex:1]];
+  [set addObject:[keys objectAtIndex:1]];
+  XCTAssertEqual(set.count, (NSUInteger)1);
+  XCTAssertTrue([set containsObject:[keys objectAtIndex:1]]);
+  XCTAssertFalse([set containsObject:[keys objectAtIndex:3]]);
+  [set removeAllObjects];
+  XCTAssertEqual(set.count, (NSUInteger)0);
+}
+
 @end
@@ -0,0 +1,135 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NIOperationPipeline.h"
+#import "NIOperations.h"
+
+@interface NIOperationsTests : XCTestCase
+@end
+
+@implementation NIOperationsTests
+
+- (void)testDuplicateOperationsAreAttached {
+  NIOperationQueue* queue = [[NIOperationQueue alloc] init];
+  queue.suspended = YES;
+
+  NIOperation* first = [[NIOperation alloc] init];
+  first.deduplicationKey = @"http://nimbuskit.info/page/1";
+  NIOperation* second = [[NIOperation alloc] init];
+  second.deduplicationKey = @"http://nimbuskit.info/page/1";
+  second.queuePriority = NSOperationQueuePriorityHigh;
+
+  XCTAssertEqual([queue addNimbusOperation:first], first, @"The first operation should be added.");
+  XCTAssertEqual([queue addNimbusOperation:second], first, @"The second operation should be attached.");
+  XCTAssertEqual(queue.operationCount, (NSUInteger)1, @"Only one operation should be queued.");
+  XCTAssertEqual(first.queuePriority, NSOperationQueuePriorityHigh, @"The priority should be raised.");
+  XCTAssertEqual([queue operationWithDeduplicationKey:@"http://nimbuskit.info/page/1"], first,
+                 @"Should be the first operation.");
+
+  [first cancel];
+  NIOperation* third = [[NIOperation alloc] init];
+  third.deduplicationKey = @"http://nimbuskit.info/page/1";
+  XCTAssertEqual([queue addNimbusOperation:third], third, @"Cancelled operations should not be joined.");
+}
+
+- (void)testPrioritiesCanBeChangedByTag {
+  NIOperationQueue* queue = [[NIOperationQueue alloc] init];
+  queue.suspended = YES;
+
+  NIOperation* visible = [[NIOperation alloc] init];
+  visible.tag = 1;
+  NIOperation* offscreen = [[NIOperation alloc] init];
+  offscreen.tag = 2;
+  [queue addNimbusOperation:visible];
+  [queue addNimbusOperation:offscreen];
+
+  [queue setQueuePriority:NSOperationQueuePriorityVeryLow forOperationsWithTag:2];
+  XCTAssertEqual(offscreen.queuePriority, NSOperationQueuePriorityVeryLow, @"Should be lowered.");
+  XCTAssertEqual(visible.queuePriority, NSOperationQueuePriorityNormal, @"Should be untouched.");
+  [queue cancelAllOperations];
+}
+
+- (void)testPipelinePassesResultsBetweenStages {
+  NSOperationQueue* queue = [[NSOperationQueue alloc] init];
+  NIOperationPipeline* pipeline = [[NIOperationPipeline alloc] init];
+  [pipeline addStageWithName:@"double" queue:queue block:^id(NSNumber* input, NIOperation* operation, NSError** error) {
+    XCTAssertFalse([NSThread isMainThread], @"Stages should run on their queue.");
+    return @([input integerValue] * 2);
+  }];
+  NIOperationPipelineStage* increment =
+  [pipeline addStageWithName:@"increment" queue:queue block:^id(NSNumber* input, NIOperation* operation, NSError** error) {
+    [NSThread sleepForTimeInterval:0.01];
+    return @([input integerValue] + 1);
+  }];
+
+  __block id pipelineResult = nil;
+  [pipeline startWithInput:@(20) completion:^(NIOperationPipeline* finishedPipeline, id result, NSError* error) {
+    pipelineResult = result;
+  }];
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  while (nil == pipelineResult && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertEqualObjects(pipelineResult, @(41), @"Each stage should receive the previous result.");
+  XCTAssertTrue(pipeline.isFinished, @"Should be finished.");
+  XCTAssertTrue(increment.duration >= 0.01, @"Stages should be timed.");
+  XCTAssertTrue(pipeline.duration >= increment.duration, @"The pipeline spans its stages.");
+}
+
+- (void)testCancellingAStageFromItsQueueCancelsThePipeline {
+  NSOperationQueue* queue = [[NSOperationQueue alloc] init];
+  dispatch_semaphore_t didStart = dispatch_semaphore_create(0);
+  dispatch_semaphore_t mayFinish = dispatch_semaphore_create(0);
+  __block BOOL didRunLastStage = NO;
+  __block BOOL didComplete = NO;
+  __weak NIOperationPipeline* weakPipeline = nil;
+
+  @autoreleasepool {
+    NIOperationPipeline* pipeline = [[NIOperationPipeline alloc] init];
+    [pipeline addStageWithName:@"wait" queue:queue block:^id(id input, NIOperation* operation, NSError** error) {
+      dispatch_semaphore_signal(didStart);
+      dispatch_semaphore_wait(mayFinish, DISPATCH_TIME_FOREVER);
+      return input;
+    }];
+    [pipeline addStageWithName:@"last" queue:queue block:^id(id input, NIOperation* operation, NSError** error) {
+      didRunLastStage = YES;
+      return input;
+    }];
+    [pipeline startWithInput:@(1) completion:^(NIOperationPipeline* finishedPipeline, id result, NSError* error) {
+      didComplete = YES;
+    }];
+    weakPipeline = pipeline;
+
+    dispatch_semaphore_wait(didStart, DISPATCH_TIME_FOREVER);
+    [queue cancelAllOperations];
+    XCTAssertTrue(pipeline.isCancelled, @"Cancelling a stage should cancel its pipeline.");
+    dispatch_semaphore_signal(mayFinish);
+    [queue waitUntilAllOperationsAreFinished];
+  }
+  [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+
+  XCTAssertFalse(didRunLastStage, @"Later stages should not run without an input.");
+  XCTAssertFalse(didComplete, @"A cancelled pipeline doesn't complete.");
+  XCTAssertNil(weakPipeline, @"A cancelled pipeline should stop keeping itself alive.");
+}
+
+@end
@@ -0,0 +1,79 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <XCTest/XCTest.h>
+
+#import "NIPrefetchWindow.h"
+
+@interface NIPrefetchWindowTestObject : NSObject <NIPrefetchingObject>
+@property (atomic, assign) BOOL prepared;
+@property (nonatomic, assign) BOOL cancelled;
+@end
+
+@implementation NIPrefetchWindowTestObject
+
+- (void)prepareForDisplayInBackground {
+  self.prepared = YES;
+}
+
+- (void)cancelPrepare {
+  self.cancelled = YES;
+}
+
+@end
+
+@interface NIPrefetchWindowTests : XCTestCase
+@end
+
+@implementation NIPrefetchWindowTests
+
+- (void)testObjectsArePreparedAndCancelled {
+  NIPrefetchWindow* window = [[NIPrefetchWindow alloc] init];
+  NIPrefetchWindowTestObject* shown = [[NIPrefetchWindowTestObject alloc] init];
+  NIPrefetchWindowTestObject* skipped = [[NIPrefetchWindowTestObject alloc] init];
+  [window prefetchObjects:@[shown, skipped, @"not prefetching"] visibleObjects:nil];
+  XCTAssertEqual([window numberOfPrefetchedObjects], (NSUInteger)2, @"Only prefetching objects should be in the window.");
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  while (!(shown.prepared && skipped.prepared) && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertTrue(shown.prepared && skipped.prepared, @"Both objects should have been prepared.");
+
+  [window prefetchObjects:nil visibleObjects:@[shown]];
+  XCTAssertFalse(shown.cancelled, @"An object that scrolled on screen should not be cancelled.");
+  XCTAssertTrue(skipped.cancelled, @"An object that left the window should be cancelled.");
+  XCTAssertEqual([window numberOfPrefetchedObjects], (NSUInteger)0, @"The window should be empty.");
+}
+
+- (void)testLookAheadRectFollowsScrolling {
+  NIPrefetchWindow* window = [[NIPrefetchWindow alloc] init];
+  UIScrollView* scrollView = [[UIScrollView alloc] initWithFrame:CGRectMake(0, 0, 320, 400)];
+  scrollView.contentSize = CGSizeMake(320, 4000);
+
+  CGRect rect = [window lookAheadRectForScrollView:scrollView];
+  XCTAssertEqual(CGRectGetMinY(rect), (CGFloat)400, @"The window should start below the screen.");
+  XCTAssertEqual(CGRectGetHeight(rect), (CGFloat)200, @"At rest the window should be half a screen.");
+
+  scrollView.contentOffset = CGPointMake(0, 2000);
+  [window lookAheadRectForScrollView:scrollView];
+  scrollView.contentOffset = CGPointMake(0, 1990);
+  rect = [window lookAheadRectForScrollView:scrollView];
+  XCTAssertEqual(CGRectGetMaxY(rect), (CGFloat)1990, @"Scrolling up should look above the screen.");
+}
+
+@end
@@ -21,6 +21,8 @@
 #import "NIPreprocessorMacros.h"
 #import "NIRuntimeClassModifications.h"
 
+#import <objc/runtime.h>
+
 #pragma mark - Unit Test Documentation
 
 /**
@@ -35,8 +37,30 @@
  * - [test] Swap two static methods on a class.
  */
 
+/**
+ * @fn NIReplaceInstanceMethodImplementation(Class, SEL, IMP)
+ *
+ * - [test] Replace an inherited method on a subclass without changing its superclass.
+ */
+
 static NSInteger sClassValue = 0;
 
+@interface NIRuntimeTestBaseObject : NSObject
+- (NSInteger)value;
+@end
+
+@implementation NIRuntimeTestBaseObject
+- (NSInteger)value {
+  return 1;
+}
+@end
+
+@interface NIRuntimeTestSubclassObject : NIRuntimeTestBaseObject
+@end
+
+@implementation NIRuntimeTestSubclassObject
+@end
+
 @interface NIRuntimeClassModificationsTests : XCTestCase {
 @private
   NSInteger _value;
@@ -92,6 +116,20 @@ static NSInteger sClassValue = 0;
   XCTAssertEqual(sClassValue, (NSInteger)3, @"value should be 3");
 }
 
+- (void)testReplaceInheritedInstanceMethod {
+  __block IMP previousImp = NULL;
+  IMP imp = imp_implementationWithBlock(^NSInteger(id object) {
+    return ((NSInteger (*)(id, SEL))previousImp)(object, @selector(value)) + 10;
+  });
+  previousImp = NIReplaceInstanceMethodImplementation([NIRuntimeTestSubclassObject class],
+                                                      @selector(value), imp);
+  XCTAssertTrue(NULL != previousImp);
+
+  XCTAssertEqual([[[NIRuntimeTestSubclassObject alloc] init] value], (NSInteger)11);
+  XCTAssertEqual([[[NIRuntimeTestBaseObject alloc] init] value], (NSInteger)1,
+                 @"The superclass should keep its implementation.");
+}
+
 #pragma mark - Class Methods
 
 
@@ -44,4 +44,31 @@
   XCTAssertEqual([Nimbus networkOperationQueue], queue, @"Singleton object should have been set.");
 }
 
+- (void)testMemoryBudgetEvictsLowestPriorityFirst {
+  NIMemoryCache* lowCache = [[NIMemoryCache alloc] init];
+  NIMemoryCache* highCache = [[NIMemoryCache alloc] init];
+  for (NSInteger ix = 0; ix < 4; ++ix) {
+    NSString* name = [NSString stringWithFormat:@"obj%zd", ix];
+    [lowCache storeObject:@(ix) withName:name cost:100];
+    [highCache storeObject:@(ix) withName:name cost:100];
+  }
+  [Nimbus addMemoryBudgetConsumer:lowCache priority:NIMemoryBudgetPriorityLow];
+  [Nimbus addMemoryBudgetConsumer:highCache priority:NIMemoryBudgetPriorityHigh];
+
+  [Nimbus setMemoryBudget:[Nimbus numberOfBytesInMemoryBudget] - 300];
+
+  XCTAssertEqual([lowCache count], (NSUInteger)1, @"The low priority cache should pay for the budget.");
+  XCTAssertTrue([lowCache containsObjectWithName:@"obj3"], @"The most recently used object should be kept.");
+  XCTAssertEqual([highCache count], (NSUInteger)4, @"The high priority cache should be left alone.");
+
+  [Nimbus setMemoryBudget:[Nimbus numberOfBytesInMemoryBudget] - 400];
+
+  XCTAssertEqual([lowCache count], (NSUInteger)0, @"The low priority cache should be empty.");
+  XCTAssertEqual([highCache count], (NSUInteger)1, @"The rest should come from the high priority cache.");
+
+  [Nimbus setMemoryBudget:0];
+  [Nimbus removeMemoryBudgetConsumer:lowCache];
+  [Nimbus removeMemoryBudgetConsumer:highCache];
+}
+
 @end
@@ -0,0 +1,42 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import <malloc/malloc.h>
+
+/**
+ * Runs the block once and logs the blocks and bytes it left allocated, along with how much the
+ * malloc zones grew to hold everything it allocated.
+ *
+ * measureBlock: only reports time, so performance tests run each phase through this once before
+ * measuring it. Allocations freed before the block returns only show up in the zones' growth.
+ *
+ * Shared by the performance tests of every module, so it is defined here rather than compiled
+ * into each test target.
+ */
+static inline void NITestLogAllocationsOfPhase(NSString* phase, void (^block)(void)) {
+  malloc_statistics_t before;
+  malloc_statistics_t after;
+  malloc_zone_statistics(NULL, &before);
+  @autoreleasepool {
+    block();
+  }
+  malloc_zone_statistics(NULL, &after);
+  NSLog(@"%@: %ld blocks, %ld bytes still allocated; zones grew by %ld bytes", phase,
+        (long)after.blocks_in_use - (long)before.blocks_in_use,
+        (long)after.size_in_use - (long)before.size_in_use,
+        (long)after.size_allocated - (long)before.size_allocated);
+}
@@ -0,0 +1,52 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Serves canned responses to requests for hosts under nimbus.test, so that tests never touch the
+ * network.
+ *
+ * Shared by the unit tests of every module that loads from the network; each test target that
+ * uses it compiles NITestURLProtocol.m.
+ *
+ * Register it with NSURLProtocol for connection-based requests, or add it to a session
+ * configuration's protocolClasses for session-based ones. URLs without a canned response get
+ * an empty 404. Every request is recorded. Bodies are delivered in two chunks by default, so
+ * that code that streams responses sees more than one write.
+ */
+@interface NITestURLProtocol : NSURLProtocol
+
++ (void)setData:(NSData *)data
+     statusCode:(NSInteger)statusCode
+   headerFields:(NSDictionary *)headerFields
+         forURL:(NSURL *)url;
+
+// Requests for the URL fail with NSURLErrorNotConnectedToInternet.
++ (void)setFailureForURL:(NSURL *)url;
+
+// How long each response waits before it is sent. Default: 0
++ (void)setResponseDelay:(NSTimeInterval)responseDelay;
+
+// Delivers bodies in chunks of at most this many bytes. Default: 0, for two halves.
++ (void)setChunkLength:(NSUInteger)chunkLength;
+
++ (NSArray *)requestsForURL:(NSURL *)url;
+
+// Forgets every canned response and recorded request and clears the delay and chunk length.
++ (void)reset;
+
+@end
@@ -0,0 +1,190 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NITestURLProtocol.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+@interface NITestURLResponse : NSObject
+@property (nonatomic, strong) NSData* data;
+@property (nonatomic, assign) NSInteger statusCode;
+@property (nonatomic, copy) NSDictionary* headerFields;
+@property (nonatomic, assign) BOOL fails;
+@end
+
+@implementation NITestURLResponse
+@end
+
+static NSMutableDictionary* sResponsesByURL = nil;
+static NSMutableDictionary* sRequestsByURL = nil;
+static NSTimeInterval sResponseDelay = 0;
+static NSUInteger sChunkLength = 0;
+
+@implementation NITestURLProtocol {
+  BOOL _isStopped;
+}
+
++ (NSString *)keyForURL:(NSURL *)url {
+  return url.absoluteString;
+}
+
++ (void)setResponse:(NITestURLResponse *)response forURL:(NSURL *)url {
+  @synchronized(self) {
+    if (nil == sResponsesByURL) {
+      sResponsesByURL = [[NSMutableDictionary alloc] init];
+    }
+    sResponsesByURL[[self keyForURL:url]] = response;
+  }
+}
+
++ (void)setData:(NSData *)data
+     statusCode:(NSInteger)statusCode
+   headerFields:(NSDictionary *)headerFields
+         forURL:(NSURL *)url {
+  NITestURLResponse* response = [[NITestURLResponse alloc] init];
+  response.data = data;
+  response.statusCode = statusCode;
+  response.headerFields = headerFields;
+  [self setResponse:response forURL:url];
+}
+
++ (void)setFailureForURL:(NSURL *)url {
+  NITestURLResponse* response = [[NITestURLResponse alloc] init];
+  response.fails = YES;
+  [self setResponse:response forURL:url];
+}
+
++ (void)setResponseDelay:(NSTimeInterval)responseDelay {
+  @synchronized(self) {
+    sResponseDelay = responseDelay;
+  }
+}
+
++ (void)setChunkLength:(NSUInteger)chunkLength {
+  @synchronized(self) {
+    sChunkLength = chunkLength;
+  }
+}
+
++ (NSArray *)requestsForURL:(NSURL *)url {
+  @synchronized(self) {
+    return [sRequestsByURL[[self keyForURL:url]] copy] ?: @[];
+  }
+}
+
++ (void)reset {
+  @synchronized(self) {
+    [sResponsesByURL removeAllObjects];
+    [sRequestsByURL removeAllObjects];
+    sResponseDelay = 0;
+    sChunkLength = 0;
+  }
+}
+
+#pragma mark - NSURLProtocol
+
++ (BOOL)canInitWithRequest:(NSURLRequest *)request {
+  NSString* host = [request.URL.host lowercaseString];
+  return [host isEqualToString:@"nimbus.test"] || [host hasSuffix:@".nimbus.test"];
+}
+
++ (NSURLRequest *)canonicalRequestForRequest:(NSURLRequest *)request {
+  return request;
+}
+
+- (void)startLoading {
+  NSTimeInterval delay = 0;
+  Class cls = [self class];
+  @synchronized(cls) {
+    if (nil == sRequestsByURL) {
+      sRequestsByURL = [[NSMutableDictionary alloc] init];
+    }
+    NSString* key = [cls keyForURL:self.request.URL];
+    NSMutableArray* requests = sRequestsByURL[key];
+    if (nil == requests) {
+      requests = [NSMutableArray array];
+      sRequestsByURL[key] = requests;
+    }
+    [requests addObject:self.request];
+    delay = sResponseDelay;
+  }
+
+  if (delay <= 0) {
+    [self sendResponse];
+    return;
+  }
+  // The client must be called back on the thread that is loading the request.
+  NSThread* thread = [NSThread currentThread];
+  NSString* mode = [[NSRunLoop currentRunLoop] currentMode] ?: NSDefaultRunLoopMode;
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)),
+                 dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    [self performSelector:@selector(sendResponse)
+                 onThread:thread
+               withObject:nil
+            waitUntilDone:NO
+                    modes:@[mode]];
+  });
+}
+
+- (void)sendResponse {
+  if (_isStopped) {
+    return;
+  }
+  NITestURLResponse* cannedResponse = nil;
+  NSUInteger chunkLength = 0;
+  @synchronized([self class]) {
+    cannedResponse = sResponsesByURL[[[self class] keyForURL:self.request.URL]];
+    chunkLength = sChunkLength;
+  }
+
+  if (cannedResponse.fails) {
+    [self.client URLProtocol:self
+            didFailWithError:[NSError errorWithDomain:NSURLErrorDomain
+                                                 code:NSURLErrorNotConnectedToInternet
+                                             userInfo:nil]];
+    return;
+  }
+
+  NSInteger statusCode = (nil != cannedResponse) ? cannedResponse.statusCode : 404;
+  NSData* data = cannedResponse.data ?: [NSData data];
+  NSMutableDictionary* headerFields = [NSMutableDictionary dictionary];
+  headerFields[@"Content-Length"] = [@(data.length) stringValue];
+  [headerFields addEntriesFromDictionary:cannedResponse.headerFields];
+  NSHTTPURLResponse* response = [[NSHTTPURLResponse alloc] initWithURL:self.request.URL
+                                                            statusCode:statusCode
+                                                           HTTPVersion:@"HTTP/1.1"
+                                                          headerFields:headerFields];
+  [self.client URLProtocol:self
+        didReceiveResponse:response
+        cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+
+  if (0 == chunkLength) {
+    chunkLength = MAX((NSUInteger)1, (data.length + 1) / 2);
+  }
+  for (NSUInteger offset = 0; offset < data.length; offset += chunkLength) {
+    NSRange range = NSMakeRange(offset, MIN(chunkLength, data.length - offset));
+    [self.client URLProtocol:self didLoadData:[data subdataWithRange:range]];
+  }
+  [self.client URLProtocolDidFinishLoading:self];
+}
+
+- (void)stopLoading {
+  _isStopped = YES;
+}
+
+@end
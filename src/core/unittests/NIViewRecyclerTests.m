@@ -124,6 +124,25 @@
   XCTAssertNil([recycler dequeueReusableViewWithIdentifier:reuseIdentifier], @"Should be no views left.");
 }
 
+- (void)testMemoryPressureWarningKeepsHalfOfTheViews {
+  NIViewRecycler* recycler = [[NIViewRecycler alloc] init];
+  NSString* reuseIdentifier = NSStringFromClass([RecyclableView class]);
+  NSMutableArray* views = [NSMutableArray array];
+  for (NSInteger ix = 0; ix < 4; ++ix) {
+    RecyclableView* view = [[RecyclableView alloc] init];
+    view.reuseIdentifier = reuseIdentifier;
+    [recycler recycleView:view];
+    [views addObject:view];
+  }
+  [[NIMemoryPressureCoordinator sharedCoordinator] postMemoryPressureWithLevel:NIMemoryPressureLevelWarning];
+
+  XCTAssertEqual([recycler dequeueReusableViewWithIdentifier:reuseIdentifier], views[3], @"The most recently recycled view should be kept.");
+  XCTAssertEqual([recycler dequeueReusableViewWithIdentifier:reuseIdentifier], views[2], @"The two most recently recycled views should be kept.");
+  XCTAssertNil([recycler dequeueReusableViewWithIdentifier:reuseIdentifier], @"Should be no views left.");
+
+  [[NIMemoryPressureCoordinator sharedCoordinator] postMemoryPressureWithLevel:NIMemoryPressureLevelNormal];
+}
+
 - (void)testRemoveAllViews {
   NIViewRecycler* recycler = [[NIViewRecycler alloc] init];
   NSString* reuseIdentifier = NSStringFromClass([RecyclableView class]);
@@ -136,6 +155,74 @@
   XCTAssertNil([recycler dequeueReusableViewWithIdentifier:reuseIdentifier], @"Should be no views left.");
 }
 
+- (void)testMaxNumberOfViewsReleasesLeastRecentlyRecycledViews {
+  NIViewRecycler* recycler = [[NIViewRecycler alloc] init];
+  [recycler setMaxNumberOfViews:2 forReuseIdentifier:@"1"];
+  XCTAssertEqual([recycler maxNumberOfViewsForReuseIdentifier:@"1"], (NSUInteger)2, @"The maximum should be set.");
+  XCTAssertEqual([recycler maxNumberOfViewsForReuseIdentifier:@"2"], (NSUInteger)0, @"Other pools should be unlimited.");
+
+  NSMutableArray* views = [NSMutableArray array];
+  for (NSInteger ix = 0; ix < 3; ++ix) {
+    RecyclableView* view = [[RecyclableView alloc] init];
+    view.reuseIdentifier = @"1";
+    [recycler recycleView:view];
+    [views addObject:view];
+  }
+  XCTAssertEqual([recycler numberOfViewsWithReuseIdentifier:@"1"], (NSUInteger)2, @"The pool should be capped.");
+  XCTAssertEqual([recycler dequeueReusableViewWithIdentifier:@"1"], views[2], @"The newest view should be kept.");
+  XCTAssertEqual([recycler dequeueReusableViewWithIdentifier:@"1"], views[1], @"The oldest view should have been released.");
+
+  for (NSInteger ix = 0; ix < 3; ++ix) {
+    RecyclableView* view = [[RecyclableView alloc] init];
+    view.reuseIdentifier = @"2";
+    [recycler recycleView:view];
+  }
+  recycler.defaultMaxNumberOfViews = 1;
+  XCTAssertEqual([recycler numberOfViewsWithReuseIdentifier:@"2"], (NSUInteger)1, @"Lowering the default should trim.");
+
+  [recycler trimToNumberOfViews:0];
+  XCTAssertEqual([recycler numberOfViewsWithReuseIdentifier:@"2"], (NSUInteger)0, @"Trimming to zero should empty the pools.");
+}
+
+- (void)testSharedRecyclerRemovesOnlyTheGivenViews {
+  NIViewRecycler* recycler = [NIViewRecycler sharedRecycler];
+  XCTAssertEqual(recycler, [NIViewRecycler sharedRecycler]);
+  XCTAssertEqual([recycler maxNumberOfViewsForReuseIdentifier:@"shared"], (NSUInteger)8, @"The shared pools should be bounded.");
+
+  RecyclableView* firstView = [[RecyclableView alloc] init];
+  firstView.reuseIdentifier = @"shared";
+  RecyclableView* secondView = [[RecyclableView alloc] init];
+  secondView.reuseIdentifier = @"shared";
+  [recycler recycleView:firstView];
+  [recycler recycleView:secondView];
+
+  [recycler removeView:firstView];
+  XCTAssertEqual([recycler numberOfViewsWithReuseIdentifier:@"shared"], (NSUInteger)1);
+  XCTAssertEqual([recycler dequeueReusableViewWithIdentifier:@"shared"], secondView, @"Other views should stay in the pool.");
+}
+
+- (void)testPrewarmBuildsViewsWhenIdle {
+  NIViewRecycler* recycler = [[NIViewRecycler alloc] init];
+  [recycler setMaxNumberOfViews:3 forReuseIdentifier:@"1"];
+  __block NSInteger numberOfViewsBuilt = 0;
+  [recycler prewarmViewsWithIdentifier:@"1" count:5 factory:^UIView<NIRecyclableView> *{
+    ++numberOfViewsBuilt;
+    RecyclableView* view = [[RecyclableView alloc] init];
+    view.reuseIdentifier = @"1";
+    return view;
+  }];
+  XCTAssertEqual(numberOfViewsBuilt, (NSInteger)0, @"Views should not be built right away.");
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  while ([recycler numberOfViewsWithReuseIdentifier:@"1"] < 3 && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+
+  XCTAssertEqual([recycler numberOfViewsWithReuseIdentifier:@"1"], (NSUInteger)3, @"Prewarming should stop at the pool's maximum.");
+  XCTAssertEqual(numberOfViewsBuilt, (NSInteger)3, @"No views should be built past the maximum.");
+}
+
 @end
 
 
@@ -68,18 +68,36 @@ function start(watchPath,bonjour) {
      * If files have changed since the last time a watch request was made then the changed
      * files will be returned immediately.
      * Otherwise the consume method will be stowed away until a file does change.
+     *
+     * Clients that ask for deltas get the contents of the changed files in the response as
+     * {"files": {"/path.css": "contents"}} so that they don't have to request each file.
      */
-    function onWatch(request, response) {
+    function onWatch(request, response, wantsDeltas) {
 	console.log("Client connected from", request.connection.remoteAddress);
         var sendResponse = function () {
-            response.writeHead(200, { 'Content-Type':'text/plain' });
             var changed = [];
             for (var key in changeSet) {
                 changed.push(key);
             }
+            changeSet = {};
+
+            if (wantsDeltas) {
+                var files = {};
+                for (var i = 0; i < changed.length; ++i) {
+                    try {
+                        files[changed[i]] = fs.readFileSync(path.join(watchPath, changed[i]), 'utf-8');
+                    } catch (e) {
+                        console.log("Unable to read", changed[i]);
+                    }
+                }
+                response.writeHead(200, { 'Content-Type':'application/json' });
+                response.end(JSON.stringify({ files: files }), 'utf-8');
+                return;
+            }
+
+            response.writeHead(200, { 'Content-Type':'text/plain' });
             response.write(changed.join("\n"), 'utf-8');
             response.end("", 'utf-8');
-            changeSet = {};
         };
 
         var anyKeys = false;
@@ -103,10 +121,11 @@ function start(watchPath,bonjour) {
      * The general purpose entry-point for HTTP requests.
      */
     function onRequest(request, response) {
-        var pathname = url.parse(request.url).pathname;
+        var parsedUrl = url.parse(request.url, true);
+        var pathname = parsedUrl.pathname;
 
         if (pathname == "/watch") {
-            onWatch(request, response);
+            onWatch(request, response, !!parsedUrl.query.deltas);
 
         } else {
             onServeFile(request, response, pathname);
@@ -29,18 +29,12 @@
 
 #define yy_create_buffer css_create_buffer
 #define yy_delete_buffer css_delete_buffer
-#define yy_flex_debug css_flex_debug
 #define yy_init_buffer css_init_buffer
 #define yy_flush_buffer css_flush_buffer
 #define yy_load_buffer_state css_load_buffer_state
 #define yy_switch_to_buffer css_switch_to_buffer
-#define yyin cssin
-#define yyleng cssleng
 #define yylex csslex
-#define yylineno csslineno
-#define yyout cssout
 #define yyrestart cssrestart
-#define yytext csstext
 #define yywrap csswrap
 #define yyalloc cssalloc
 #define yyrealloc cssrealloc
@@ -159,24 +153,41 @@ typedef unsigned int flex_uint32_t;
  */
 #define YY_SC_TO_UI(c) ((unsigned int) (unsigned char) c)
 
+/* An opaque pointer. */
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
+
+/* For convenience, these vars (plus the bison vars far below)
+   are macros in the reentrant scanner. */
+#define yyin yyg->yyin_r
+#define yyout yyg->yyout_r
+#define yyextra yyg->yyextra_r
+#define yyleng yyg->yyleng_r
+#define yytext yyg->yytext_r
+#define yylineno (YY_CURRENT_BUFFER_LVALUE->yy_bs_lineno)
+#define yycolumn (YY_CURRENT_BUFFER_LVALUE->yy_bs_column)
+#define yy_flex_debug yyg->yy_flex_debug_r
+
 /* Enter a start condition.  This macro really ought to take a parameter,
  * but we do it the disgusting crufty way forced on us by the ()-less
  * definition of BEGIN.
  */
-#define BEGIN (yy_start) = 1 + 2 *
+#define BEGIN yyg->yy_start = 1 + 2 *
 
 /* Translate the current start state into a value that can be later handed
  * to BEGIN to return to the state.  The YYSTATE alias is for lex
  * compatibility.
  */
-#define YY_START (((yy_start) - 1) / 2)
+#define YY_START ((yyg->yy_start - 1) / 2)
 #define YYSTATE YY_START
 
 /* Action number for EOF rule of a given start state. */
 #define YY_STATE_EOF(state) (YY_END_OF_BUFFER + state + 1)
 
 /* Special action meaning "start processing a new file". */
-#define YY_NEW_FILE cssrestart(cssin  )
+#define YY_NEW_FILE cssrestart(yyin ,yyscanner )
 
 #define YY_END_OF_BUFFER_CHAR 0
 
@@ -199,10 +210,6 @@ typedef struct yy_buffer_state *YY_BUFFER_STATE;
 typedef size_t yy_size_t;
 #endif
 
-extern yy_size_t cssleng;
-
-extern FILE *cssin, *cssout;
-
 #define EOB_ACT_CONTINUE_SCAN 0
 #define EOB_ACT_END_OF_FILE 1
 #define EOB_ACT_LAST_MATCH 2
@@ -213,17 +220,17 @@ extern FILE *cssin, *cssout;
 #define yyless(n) \
 	do \
 		{ \
-		/* Undo effects of setting up csstext. */ \
+		/* Undo effects of setting up yytext. */ \
         int yyless_macro_arg = (n); \
         YY_LESS_LINENO(yyless_macro_arg);\
-		*yy_cp = (yy_hold_char); \
+		*yy_cp = yyg->yy_hold_char; \
 		YY_RESTORE_YY_MORE_OFFSET \
-		(yy_c_buf_p) = yy_cp = yy_bp + yyless_macro_arg - YY_MORE_ADJ; \
-		YY_DO_BEFORE_ACTION; /* set up csstext again */ \
+		yyg->yy_c_buf_p = yy_cp = yy_bp + yyless_macro_arg - YY_MORE_ADJ; \
+		YY_DO_BEFORE_ACTION; /* set up yytext again */ \
 		} \
 	while ( 0 )
 
-#define unput(c) yyunput( c, (yytext_ptr)  )
+#define unput(c) yyunput( c, yyg->yytext_ptr , yyscanner )
 
 #ifndef YY_STRUCT_YY_BUFFER_STATE
 #define YY_STRUCT_YY_BUFFER_STATE
@@ -283,78 +290,58 @@ struct yy_buffer_state
 	 *
 	 * When we actually see the EOF, we change the status to "new"
 	 * (via cssrestart()), so that the user can continue scanning by
-	 * just pointing cssin at a new input file.
+	 * just pointing yyin at a new input file.
 	 */
 #define YY_BUFFER_EOF_PENDING 2
 
 	};
 #endif /* !YY_STRUCT_YY_BUFFER_STATE */
 
-/* Stack of input buffers. */
-static size_t yy_buffer_stack_top = 0; /**< index of top of stack. */
-static size_t yy_buffer_stack_max = 0; /**< capacity of stack. */
-static YY_BUFFER_STATE * yy_buffer_stack = 0; /**< Stack as an array. */
-
 /* We provide macros for accessing buffer states in case in the
  * future we want to put the buffer states in a more general
  * "scanner state".
  *
  * Returns the top of the stack, or NULL.
  */
-#define YY_CURRENT_BUFFER ( (yy_buffer_stack) \
-                          ? (yy_buffer_stack)[(yy_buffer_stack_top)] \
+#define YY_CURRENT_BUFFER ( yyg->yy_buffer_stack \
+                          ? yyg->yy_buffer_stack[yyg->yy_buffer_stack_top] \
                           : NULL)
 
 /* Same as previous macro, but useful when we know that the buffer stack is not
  * NULL or when we need an lvalue. For internal use only.
  */
-#define YY_CURRENT_BUFFER_LVALUE (yy_buffer_stack)[(yy_buffer_stack_top)]
+#define YY_CURRENT_BUFFER_LVALUE yyg->yy_buffer_stack[yyg->yy_buffer_stack_top]
 
-/* yy_hold_char holds the character lost when csstext is formed. */
-static char yy_hold_char;
-static yy_size_t yy_n_chars;		/* number of characters read into yy_ch_buf */
-yy_size_t cssleng;
+void cssrestart (FILE *input_file ,yyscan_t yyscanner);
+void css_switch_to_buffer (YY_BUFFER_STATE new_buffer ,yyscan_t yyscanner);
+YY_BUFFER_STATE css_create_buffer (FILE *file,int size ,yyscan_t yyscanner);
+void css_delete_buffer (YY_BUFFER_STATE b ,yyscan_t yyscanner);
+void css_flush_buffer (YY_BUFFER_STATE b ,yyscan_t yyscanner);
+void csspush_buffer_state (YY_BUFFER_STATE new_buffer ,yyscan_t yyscanner);
+void csspop_buffer_state (yyscan_t yyscanner );
 
-/* Points to current character in buffer. */
-static char *yy_c_buf_p = (char *) 0;
-static int yy_init = 0;		/* whether we need to initialize */
-static int yy_start = 0;	/* start state number */
+static void cssensure_buffer_stack (yyscan_t yyscanner );
+static void css_load_buffer_state (yyscan_t yyscanner );
+static void css_init_buffer (YY_BUFFER_STATE b,FILE *file ,yyscan_t yyscanner);
 
-/* Flag which is used to allow csswrap()'s to do buffer switches
- * instead of setting up a fresh cssin.  A bit of a hack ...
- */
-static int yy_did_buffer_switch_on_eof;
-
-void cssrestart (FILE *input_file  );
-void css_switch_to_buffer (YY_BUFFER_STATE new_buffer  );
-YY_BUFFER_STATE css_create_buffer (FILE *file,int size  );
-void css_delete_buffer (YY_BUFFER_STATE b  );
-void css_flush_buffer (YY_BUFFER_STATE b  );
-void csspush_buffer_state (YY_BUFFER_STATE new_buffer  );
-void csspop_buffer_state (void );
-
-static void cssensure_buffer_stack (void );
-static void css_load_buffer_state (void );
-static void css_init_buffer (YY_BUFFER_STATE b,FILE *file  );
+#define YY_FLUSH_BUFFER css_flush_buffer(YY_CURRENT_BUFFER ,yyscanner )
 
-#define YY_FLUSH_BUFFER css_flush_buffer(YY_CURRENT_BUFFER )
+YY_BUFFER_STATE css_scan_buffer (char *base,yy_size_t size ,yyscan_t yyscanner);
+YY_BUFFER_STATE css_scan_string (yyconst char *yy_str ,yyscan_t yyscanner);
+YY_BUFFER_STATE css_scan_bytes (yyconst char *bytes,yy_size_t len ,yyscan_t yyscanner);
 
-YY_BUFFER_STATE css_scan_buffer (char *base,yy_size_t size  );
-YY_BUFFER_STATE css_scan_string (yyconst char *yy_str  );
-YY_BUFFER_STATE css_scan_bytes (yyconst char *bytes,yy_size_t len  );
-
-void *cssalloc (yy_size_t  );
-void *cssrealloc (void *,yy_size_t  );
-void cssfree (void *  );
+void *cssalloc (yy_size_t ,yyscan_t yyscanner);
+void *cssrealloc (void *,yy_size_t ,yyscan_t yyscanner);
+void cssfree (void * ,yyscan_t yyscanner);
 
 #define yy_new_buffer css_create_buffer
 
 #define yy_set_interactive(is_interactive) \
 	{ \
 	if ( ! YY_CURRENT_BUFFER ){ \
-        cssensure_buffer_stack (); \
+        cssensure_buffer_stack (yyscanner ); \
 		YY_CURRENT_BUFFER_LVALUE =    \
-            css_create_buffer(cssin,YY_BUF_SIZE ); \
+            css_create_buffer(yyin,YY_BUF_SIZE ,yyscanner ); \
 	} \
 	YY_CURRENT_BUFFER_LVALUE->yy_is_interactive = is_interactive; \
 	}
@@ -362,9 +349,9 @@ void cssfree (void *  );
 #define yy_set_bol(at_bol) \
 	{ \
 	if ( ! YY_CURRENT_BUFFER ){\
-        cssensure_buffer_stack (); \
+        cssensure_buffer_stack (yyscanner ); \
 		YY_CURRENT_BUFFER_LVALUE =    \
-            css_create_buffer(cssin,YY_BUF_SIZE ); \
+            css_create_buffer(yyin,YY_BUF_SIZE ,yyscanner ); \
 	} \
 	YY_CURRENT_BUFFER_LVALUE->yy_at_bol = at_bol; \
 	}
@@ -375,31 +362,24 @@ void cssfree (void *  );
 
 typedef unsigned char YY_CHAR;
 
-FILE *cssin = (FILE *) 0, *cssout = (FILE *) 0;
-
 typedef int yy_state_type;
 
-extern int csslineno;
+#define yytext_ptr yytext_r
 
-int csslineno = 1;
-
-extern char *csstext;
-#define yytext_ptr csstext
-
-static yy_state_type yy_get_previous_state (void );
-static yy_state_type yy_try_NUL_trans (yy_state_type current_state  );
-static int yy_get_next_buffer (void );
-static void yy_fatal_error (yyconst char msg[]  );
+static yy_state_type yy_get_previous_state (yyscan_t yyscanner );
+static yy_state_type yy_try_NUL_trans (yy_state_type current_state ,yyscan_t yyscanner);
+static int yy_get_next_buffer (yyscan_t yyscanner );
+static void yy_fatal_error (yyconst char msg[] ,yyscan_t yyscanner);
 
 /* Done after the current pattern has been matched and before the
- * corresponding action - sets up csstext.
+ * corresponding action - sets up yytext.
  */
 #define YY_DO_BEFORE_ACTION \
-	(yytext_ptr) = yy_bp; \
-	cssleng = (yy_size_t) (yy_cp - yy_bp); \
-	(yy_hold_char) = *yy_cp; \
+	yyg->yytext_ptr = yy_bp; \
+	yyleng = (yy_size_t) (yy_cp - yy_bp); \
+	yyg->yy_hold_char = *yy_cp; \
 	*yy_cp = '\0'; \
-	(yy_c_buf_p) = yy_cp;
+	yyg->yy_c_buf_p = yy_cp;
 
 #define YY_NUM_RULES 41
 #define YY_END_OF_BUFFER 42
@@ -2086,12 +2066,6 @@ static yyconst flex_int16_t yy_chk[6701] =
 
     } ;
 
-static yy_state_type yy_last_accepting_state;
-static char *yy_last_accepting_cpos;
-
-extern int css_flex_debug;
-int css_flex_debug = 0;
-
 /* The intent behind this definition is that it'll catch
  * any uses of REJECT which flex missed.
  */
@@ -2099,7 +2073,6 @@ int css_flex_debug = 0;
 #define yymore() yymore_used_but_not_detected
 #define YY_MORE_ADJ 0
 #define YY_RESTORE_YY_MORE_OFFSET
-char *csstext;
 #line 1 "css.grammar"
 #define YY_NO_INPUT 1
 #line 2084 "lex.css.c"
@@ -2118,36 +2091,74 @@ char *csstext;
 #define YY_EXTRA_TYPE void *
 #endif
 
-static int yy_init_globals (void );
+/* Holds the entire state of the reentrant scanner. */
+struct yyguts_t
+    {
+
+    /* User-defined. Not touched by flex. */
+    YY_EXTRA_TYPE yyextra_r;
+
+    /* The rest are the same as the globals declared in the non-reentrant scanner. */
+    FILE *yyin_r, *yyout_r;
+    size_t yy_buffer_stack_top; /**< index of top of stack. */
+    size_t yy_buffer_stack_max; /**< capacity of stack. */
+    YY_BUFFER_STATE * yy_buffer_stack; /**< Stack as an array. */
+    char yy_hold_char;
+    yy_size_t yy_n_chars;
+    yy_size_t yyleng_r;
+    char *yy_c_buf_p;
+    int yy_init;
+    int yy_start;
+    int yy_did_buffer_switch_on_eof;
+    int yy_start_stack_ptr;
+    int yy_start_stack_depth;
+    int *yy_start_stack;
+    yy_state_type yy_last_accepting_state;
+    char* yy_last_accepting_cpos;
+
+    int yylineno_r;
+    int yy_flex_debug_r;
+
+    char *yytext_r;
+    int yy_more_flag;
+    int yy_more_len;
+
+    }; /* end struct yyguts_t */
+
+static int yy_init_globals (yyscan_t yyscanner );
+
+int csslex_init (yyscan_t* scanner);
+
+int csslex_init_extra (YY_EXTRA_TYPE user_defined,yyscan_t* scanner);
 
 /* Accessor methods to globals.
    These are made visible to non-reentrant scanners for convenience. */
 
-int csslex_destroy (void );
+int csslex_destroy (yyscan_t yyscanner );
 
-int cssget_debug (void );
+int cssget_debug (yyscan_t yyscanner );
 
-void cssset_debug (int debug_flag  );
+void cssset_debug (int debug_flag ,yyscan_t yyscanner);
 
-YY_EXTRA_TYPE cssget_extra (void );
+YY_EXTRA_TYPE cssget_extra (yyscan_t yyscanner );
 
-void cssset_extra (YY_EXTRA_TYPE user_defined  );
+void cssset_extra (YY_EXTRA_TYPE user_defined ,yyscan_t yyscanner);
 
-FILE *cssget_in (void );
+FILE *cssget_in (yyscan_t yyscanner );
 
-void cssset_in  (FILE * in_str  );
+void cssset_in  (FILE * in_str ,yyscan_t yyscanner);
 
-FILE *cssget_out (void );
+FILE *cssget_out (yyscan_t yyscanner );
 
-void cssset_out  (FILE * out_str  );
+void cssset_out  (FILE * out_str ,yyscan_t yyscanner);
 
-yy_size_t cssget_leng (void );
+yy_size_t cssget_leng (yyscan_t yyscanner );
 
-char *cssget_text (void );
+char *cssget_text (yyscan_t yyscanner );
 
-int cssget_lineno (void );
+int cssget_lineno (yyscan_t yyscanner );
 
-void cssset_lineno (int line_number  );
+void cssset_lineno (int line_number ,yyscan_t yyscanner);
 
 /* Macros after this point can all be overridden by user definitions in
  * section 1.
@@ -2157,24 +2168,24 @@ void cssset_lineno (int line_number  );
 #ifdef __cplusplus
 extern "C" int csswrap (void );
 #else
-extern int csswrap (void );
+extern int csswrap (yyscan_t yyscanner );
 #endif
 #endif
 
 #ifndef yytext_ptr
-static void yy_flex_strncpy (char *,yyconst char *,int );
+static void yy_flex_strncpy (char *,yyconst char *,int ,yyscan_t yyscanner);
 #endif
 
 #ifdef YY_NEED_STRLEN
-static int yy_flex_strlen (yyconst char * );
+static int yy_flex_strlen (yyconst char * ,yyscan_t yyscanner);
 #endif
 
 #ifndef YY_NO_INPUT
 
 #ifdef __cplusplus
-static int yyinput (void );
+static int yyinput (yyscan_t yyscanner );
 #else
-static int input (void );
+static int input (yyscan_t yyscanner );
 #endif
 
 #endif
@@ -2189,7 +2200,7 @@ static int input (void );
 /* This used to be an fputs(), but since the string might contain NUL's,
  * we now use fwrite().
  */
-#define ECHO fwrite( csstext, cssleng, 1, cssout )
+#define ECHO fwrite( yytext, yyleng, 1, yyout )
 #endif
 
 /* Gets input and stuffs it into "buf".  number of characters read, or YY_NULL,
@@ -2202,18 +2213,18 @@ static int input (void );
 		int c = '*'; \
 		yy_size_t n; \
 		for ( n = 0; n < max_size && \
-			     (c = getc( cssin )) != EOF && c != '\n'; ++n ) \
+			     (c = getc( yyin )) != EOF && c != '\n'; ++n ) \
 			buf[n] = (char) c; \
 		if ( c == '\n' ) \
 			buf[n++] = (char) c; \
-		if ( c == EOF && ferror( cssin ) ) \
+		if ( c == EOF && ferror( yyin ) ) \
 			YY_FATAL_ERROR( "input in flex scanner failed" ); \
 		result = n; \
 		} \
 	else \
 		{ \
 		errno=0; \
-		while ( (result = fread(buf, 1, max_size, cssin))==0 && ferror(cssin)) \
+		while ( (result = fread(buf, 1, max_size, yyin))==0 && ferror(yyin)) \
 			{ \
 			if( errno != EINTR) \
 				{ \
@@ -2221,7 +2232,7 @@ static int input (void );
 				break; \
 				} \
 			errno=0; \
-			clearerr(cssin); \
+			clearerr(yyin); \
 			} \
 		}\
 \
@@ -2243,7 +2254,7 @@ static int input (void );
 
 /* Report a fatal error. */
 #ifndef YY_FATAL_ERROR
-#define YY_FATAL_ERROR(msg) yy_fatal_error( msg )
+#define YY_FATAL_ERROR(msg) yy_fatal_error( msg ,yyscanner )
 #endif
 
 /* end tables serialization structures and prototypes */
@@ -2254,12 +2265,12 @@ static int input (void );
 #ifndef YY_DECL
 #define YY_DECL_IS_OURS 1
 
-extern int csslex (void);
+extern int csslex (yyscan_t yyscanner);
 
-#define YY_DECL int csslex (void)
+#define YY_DECL int csslex (yyscan_t yyscanner)
 #endif /* !YY_DECL */
 
-/* Code executed at the beginning of each rule, after csstext and cssleng
+/* Code executed at the beginning of each rule, after yytext and yyleng
  * have been set up.
  */
 #ifndef YY_USER_ACTION
@@ -2281,59 +2292,60 @@ YY_DECL
 	register yy_state_type yy_current_state;
 	register char *yy_cp, *yy_bp;
 	register int yy_act;
-    
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+
 #line 22 "css.grammar"
 
 
 #line 2267 "lex.css.c"
 
-	if ( !(yy_init) )
+	if ( !yyg->yy_init )
 		{
-		(yy_init) = 1;
+		yyg->yy_init = 1;
 
 #ifdef YY_USER_INIT
 		YY_USER_INIT;
 #endif
 
-		if ( ! (yy_start) )
-			(yy_start) = 1;	/* first start state */
+		if ( ! yyg->yy_start )
+			yyg->yy_start = 1;	/* first start state */
 
-		if ( ! cssin )
-			cssin = stdin;
+		if ( ! yyin )
+			yyin = stdin;
 
-		if ( ! cssout )
-			cssout = stdout;
+		if ( ! yyout )
+			yyout = stdout;
 
 		if ( ! YY_CURRENT_BUFFER ) {
-			cssensure_buffer_stack ();
+			cssensure_buffer_stack (yyscanner );
 			YY_CURRENT_BUFFER_LVALUE =
-				css_create_buffer(cssin,YY_BUF_SIZE );
+				css_create_buffer(yyin,YY_BUF_SIZE ,yyscanner );
 		}
 
-		css_load_buffer_state( );
+		css_load_buffer_state(yyscanner );
 		}
 
 	while ( 1 )		/* loops until end-of-file is reached */
 		{
-		yy_cp = (yy_c_buf_p);
+		yy_cp = yyg->yy_c_buf_p;
 
-		/* Support of csstext. */
-		*yy_cp = (yy_hold_char);
+		/* Support of yytext. */
+		*yy_cp = yyg->yy_hold_char;
 
 		/* yy_bp points to the position in yy_ch_buf of the start of
 		 * the current run.
 		 */
 		yy_bp = yy_cp;
 
-		yy_current_state = (yy_start);
+		yy_current_state = yyg->yy_start;
 yy_match:
 		do
 			{
 			register YY_CHAR yy_c = yy_ec[YY_SC_TO_UI(*yy_cp)];
 			if ( yy_accept[yy_current_state] )
 				{
-				(yy_last_accepting_state) = yy_current_state;
-				(yy_last_accepting_cpos) = yy_cp;
+				yyg->yy_last_accepting_state = yy_current_state;
+				yyg->yy_last_accepting_cpos = yy_cp;
 				}
 			while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 				{
@@ -2350,8 +2362,8 @@ yy_find_action:
 		yy_act = yy_accept[yy_current_state];
 		if ( yy_act == 0 )
 			{ /* have to back up */
-			yy_cp = (yy_last_accepting_cpos);
-			yy_current_state = (yy_last_accepting_state);
+			yy_cp = yyg->yy_last_accepting_cpos;
+			yy_current_state = yyg->yy_last_accepting_state;
 			yy_act = yy_accept[yy_current_state];
 			}
 
@@ -2363,9 +2375,9 @@ do_action:	/* This label is used only to access EOF actions. */
 	{ /* beginning of action switch */
 			case 0: /* must back up */
 			/* undo the effects of YY_DO_BEFORE_ACTION */
-			*yy_cp = (yy_hold_char);
-			yy_cp = (yy_last_accepting_cpos);
-			yy_current_state = (yy_last_accepting_state);
+			*yy_cp = yyg->yy_hold_char;
+			yy_cp = yyg->yy_last_accepting_cpos;
+			yy_current_state = yyg->yy_last_accepting_state;
 			goto yy_find_action;
 
 case 1:
@@ -2404,24 +2416,24 @@ case 7:
 /* rule 7 can match eol */
 YY_RULE_SETUP
 #line 33 "css.grammar"
-{cssConsume(csstext, CSSSTRING);}
+{cssConsume(yyextra, yytext, CSSSTRING);}
 	YY_BREAK
 case 8:
 /* rule 8 can match eol */
 YY_RULE_SETUP
 #line 35 "css.grammar"
-{cssConsume(csstext, CSSIDENT);}
+{cssConsume(yyextra, yytext, CSSIDENT);}
 	YY_BREAK
 case 9:
 /* rule 9 can match eol */
 YY_RULE_SETUP
 #line 37 "css.grammar"
-{cssConsume(csstext, CSSHASH);}
+{cssConsume(yyextra, yytext, CSSHASH);}
 	YY_BREAK
 case 10:
 YY_RULE_SETUP
 #line 39 "css.grammar"
-{cssConsume(csstext, CSSIMPORT);}
+{cssConsume(yyextra, yytext, CSSIMPORT);}
 	YY_BREAK
 case 11:
 YY_RULE_SETUP
@@ -2431,7 +2443,7 @@ YY_RULE_SETUP
 case 12:
 YY_RULE_SETUP
 #line 41 "css.grammar"
-{cssConsume(csstext, CSSMEDIA);}
+{cssConsume(yyextra, yytext, CSSMEDIA);}
 	YY_BREAK
 case 13:
 YY_RULE_SETUP
@@ -2456,126 +2468,126 @@ YY_RULE_SETUP
 case 17:
 YY_RULE_SETUP
 #line 48 "css.grammar"
-{cssConsume(csstext, CSSEMS);}
+{cssConsume(yyextra, yytext, CSSEMS);}
 	YY_BREAK
 case 18:
 YY_RULE_SETUP
 #line 49 "css.grammar"
-{cssConsume(csstext, CSSEXS);}
+{cssConsume(yyextra, yytext, CSSEXS);}
 	YY_BREAK
 case 19:
 YY_RULE_SETUP
 #line 50 "css.grammar"
-{cssConsume(csstext, CSSLENGTH);}
+{cssConsume(yyextra, yytext, CSSLENGTH);}
 	YY_BREAK
 case 20:
 YY_RULE_SETUP
 #line 51 "css.grammar"
-{cssConsume(csstext, CSSLENGTH);}
+{cssConsume(yyextra, yytext, CSSLENGTH);}
 	YY_BREAK
 case 21:
 YY_RULE_SETUP
 #line 52 "css.grammar"
-{cssConsume(csstext, CSSLENGTH);}
+{cssConsume(yyextra, yytext, CSSLENGTH);}
 	YY_BREAK
 case 22:
 YY_RULE_SETUP
 #line 53 "css.grammar"
-{cssConsume(csstext, CSSLENGTH);}
+{cssConsume(yyextra, yytext, CSSLENGTH);}
 	YY_BREAK
 case 23:
 YY_RULE_SETUP
 #line 54 "css.grammar"
-{cssConsume(csstext, CSSLENGTH);}
+{cssConsume(yyextra, yytext, CSSLENGTH);}
 	YY_BREAK
 case 24:
 YY_RULE_SETUP
 #line 55 "css.grammar"
-{cssConsume(csstext, CSSLENGTH);}
+{cssConsume(yyextra, yytext, CSSLENGTH);}
 	YY_BREAK
 case 25:
 YY_RULE_SETUP
 #line 56 "css.grammar"
-{cssConsume(csstext, CSSANGLE);}
+{cssConsume(yyextra, yytext, CSSANGLE);}
 	YY_BREAK
 case 26:
 YY_RULE_SETUP
 #line 57 "css.grammar"
-{cssConsume(csstext, CSSANGLE);}
+{cssConsume(yyextra, yytext, CSSANGLE);}
 	YY_BREAK
 case 27:
 YY_RULE_SETUP
 #line 58 "css.grammar"
-{cssConsume(csstext, CSSANGLE);}
+{cssConsume(yyextra, yytext, CSSANGLE);}
 	YY_BREAK
 case 28:
 YY_RULE_SETUP
 #line 59 "css.grammar"
-{cssConsume(csstext, CSSTIME);}
+{cssConsume(yyextra, yytext, CSSTIME);}
 	YY_BREAK
 case 29:
 YY_RULE_SETUP
 #line 60 "css.grammar"
-{cssConsume(csstext, CSSTIME);}
+{cssConsume(yyextra, yytext, CSSTIME);}
 	YY_BREAK
 case 30:
 YY_RULE_SETUP
 #line 61 "css.grammar"
-{cssConsume(csstext, CSSFREQ);}
+{cssConsume(yyextra, yytext, CSSFREQ);}
 	YY_BREAK
 case 31:
 YY_RULE_SETUP
 #line 62 "css.grammar"
-{cssConsume(csstext, CSSFREQ);}
+{cssConsume(yyextra, yytext, CSSFREQ);}
 	YY_BREAK
 case 32:
 /* rule 32 can match eol */
 YY_RULE_SETUP
 #line 63 "css.grammar"
-{cssConsume(csstext, CSSDIMEN);}
+{cssConsume(yyextra, yytext, CSSDIMEN);}
 	YY_BREAK
 case 33:
 YY_RULE_SETUP
 #line 64 "css.grammar"
-{cssConsume(csstext, CSSPERCENTAGE);}
+{cssConsume(yyextra, yytext, CSSPERCENTAGE);}
 	YY_BREAK
 case 34:
 YY_RULE_SETUP
 #line 65 "css.grammar"
-{cssConsume(csstext, CSSNUMBER);}
+{cssConsume(yyextra, yytext, CSSNUMBER);}
 	YY_BREAK
 case 35:
 /* rule 35 can match eol */
 YY_RULE_SETUP
 #line 67 "css.grammar"
-{cssConsume(csstext, CSSURI);}
+{cssConsume(yyextra, yytext, CSSURI);}
 	YY_BREAK
 case 36:
 /* rule 36 can match eol */
 YY_RULE_SETUP
 #line 68 "css.grammar"
-{cssConsume(csstext, CSSURI);}
+{cssConsume(yyextra, yytext, CSSURI);}
 	YY_BREAK
 case 37:
 /* rule 37 can match eol */
 YY_RULE_SETUP
 #line 69 "css.grammar"
-{cssConsume(csstext, CSSFUNCTION);}
+{cssConsume(yyextra, yytext, CSSFUNCTION);}
 	YY_BREAK
 case 38:
 YY_RULE_SETUP
 #line 71 "css.grammar"
-{cssConsume(csstext, CSSUNICODERANGE);}
+{cssConsume(yyextra, yytext, CSSUNICODERANGE);}
 	YY_BREAK
 case 39:
 YY_RULE_SETUP
 #line 72 "css.grammar"
-{cssConsume(csstext, CSSUNICODERANGE);}
+{cssConsume(yyextra, yytext, CSSUNICODERANGE);}
 	YY_BREAK
 case 40:
 YY_RULE_SETUP
 #line 74 "css.grammar"
-{cssConsume(csstext, CSSUNKNOWN);}
+{cssConsume(yyextra, yytext, CSSUNKNOWN);}
 	YY_BREAK
 case 41:
 YY_RULE_SETUP
@@ -2589,25 +2601,25 @@ case YY_STATE_EOF(INITIAL):
 	case YY_END_OF_BUFFER:
 		{
 		/* Amount of text matched not including the EOB char. */
-		int yy_amount_of_matched_text = (int) (yy_cp - (yytext_ptr)) - 1;
+		int yy_amount_of_matched_text = (int) (yy_cp - yyg->yytext_ptr) - 1;
 
 		/* Undo the effects of YY_DO_BEFORE_ACTION. */
-		*yy_cp = (yy_hold_char);
+		*yy_cp = yyg->yy_hold_char;
 		YY_RESTORE_YY_MORE_OFFSET
 
 		if ( YY_CURRENT_BUFFER_LVALUE->yy_buffer_status == YY_BUFFER_NEW )
 			{
 			/* We're scanning a new file or input source.  It's
 			 * possible that this happened because the user
-			 * just pointed cssin at a new source and called
+			 * just pointed yyin at a new source and called
 			 * csslex().  If so, then we have to assure
 			 * consistency between YY_CURRENT_BUFFER and our
 			 * globals.  Here is the right place to do so, because
 			 * this is the first action (other than possibly a
 			 * back-up) that will match for the new input source.
 			 */
-			(yy_n_chars) = YY_CURRENT_BUFFER_LVALUE->yy_n_chars;
-			YY_CURRENT_BUFFER_LVALUE->yy_input_file = cssin;
+			yyg->yy_n_chars = YY_CURRENT_BUFFER_LVALUE->yy_n_chars;
+			YY_CURRENT_BUFFER_LVALUE->yy_input_file = yyin;
 			YY_CURRENT_BUFFER_LVALUE->yy_buffer_status = YY_BUFFER_NORMAL;
 			}
 
@@ -2618,13 +2630,13 @@ case YY_STATE_EOF(INITIAL):
 		 * end-of-buffer state).  Contrast this with the test
 		 * in input().
 		 */
-		if ( (yy_c_buf_p) <= &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars)] )
+		if ( yyg->yy_c_buf_p <= &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars] )
 			{ /* This was really a NUL. */
 			yy_state_type yy_next_state;
 
-			(yy_c_buf_p) = (yytext_ptr) + yy_amount_of_matched_text;
+			yyg->yy_c_buf_p = yyg->yytext_ptr + yy_amount_of_matched_text;
 
-			yy_current_state = yy_get_previous_state(  );
+			yy_current_state = yy_get_previous_state(yyscanner );
 
 			/* Okay, we're now positioned to make the NUL
 			 * transition.  We couldn't have
@@ -2635,43 +2647,43 @@ case YY_STATE_EOF(INITIAL):
 			 * will run more slowly).
 			 */
 
-			yy_next_state = yy_try_NUL_trans( yy_current_state );
+			yy_next_state = yy_try_NUL_trans( yy_current_state ,yyscanner );
 
-			yy_bp = (yytext_ptr) + YY_MORE_ADJ;
+			yy_bp = yyg->yytext_ptr + YY_MORE_ADJ;
 
 			if ( yy_next_state )
 				{
 				/* Consume the NUL. */
-				yy_cp = ++(yy_c_buf_p);
+				yy_cp = ++yyg->yy_c_buf_p;
 				yy_current_state = yy_next_state;
 				goto yy_match;
 				}
 
 			else
 				{
-				yy_cp = (yy_c_buf_p);
+				yy_cp = yyg->yy_c_buf_p;
 				goto yy_find_action;
 				}
 			}
 
-		else switch ( yy_get_next_buffer(  ) )
+		else switch ( yy_get_next_buffer(yyscanner ) )
 			{
 			case EOB_ACT_END_OF_FILE:
 				{
-				(yy_did_buffer_switch_on_eof) = 0;
+				yyg->yy_did_buffer_switch_on_eof = 0;
 
-				if ( csswrap( ) )
+				if ( csswrap(yyscanner ) )
 					{
 					/* Note: because we've taken care in
 					 * yy_get_next_buffer() to have set up
-					 * csstext, we can now set up
+					 * yytext, we can now set up
 					 * yy_c_buf_p so that if some total
 					 * hoser (like flex itself) wants to
 					 * call the scanner after we return the
 					 * YY_NULL, it'll still work - another
 					 * YY_NULL will get returned.
 					 */
-					(yy_c_buf_p) = (yytext_ptr) + YY_MORE_ADJ;
+					yyg->yy_c_buf_p = yyg->yytext_ptr + YY_MORE_ADJ;
 
 					yy_act = YY_STATE_EOF(YY_START);
 					goto do_action;
@@ -2679,30 +2691,30 @@ case YY_STATE_EOF(INITIAL):
 
 				else
 					{
-					if ( ! (yy_did_buffer_switch_on_eof) )
+					if ( ! yyg->yy_did_buffer_switch_on_eof )
 						YY_NEW_FILE;
 					}
 				break;
 				}
 
 			case EOB_ACT_CONTINUE_SCAN:
-				(yy_c_buf_p) =
-					(yytext_ptr) + yy_amount_of_matched_text;
+				yyg->yy_c_buf_p =
+					yyg->yytext_ptr + yy_amount_of_matched_text;
 
-				yy_current_state = yy_get_previous_state(  );
+				yy_current_state = yy_get_previous_state(yyscanner );
 
-				yy_cp = (yy_c_buf_p);
-				yy_bp = (yytext_ptr) + YY_MORE_ADJ;
+				yy_cp = yyg->yy_c_buf_p;
+				yy_bp = yyg->yytext_ptr + YY_MORE_ADJ;
 				goto yy_match;
 
 			case EOB_ACT_LAST_MATCH:
-				(yy_c_buf_p) =
-				&YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars)];
+				yyg->yy_c_buf_p =
+				&YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars];
 
-				yy_current_state = yy_get_previous_state(  );
+				yy_current_state = yy_get_previous_state(yyscanner );
 
-				yy_cp = (yy_c_buf_p);
-				yy_bp = (yytext_ptr) + YY_MORE_ADJ;
+				yy_cp = yyg->yy_c_buf_p;
+				yy_bp = yyg->yytext_ptr + YY_MORE_ADJ;
 				goto yy_find_action;
 			}
 		break;
@@ -2722,20 +2734,21 @@ case YY_STATE_EOF(INITIAL):
  *	EOB_ACT_CONTINUE_SCAN - continue scanning from current position
  *	EOB_ACT_END_OF_FILE - end of file
  */
-static int yy_get_next_buffer (void)
+static int yy_get_next_buffer (yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
     	register char *dest = YY_CURRENT_BUFFER_LVALUE->yy_ch_buf;
-	register char *source = (yytext_ptr);
+	register char *source = yyg->yytext_ptr;
 	register int number_to_move, i;
 	int ret_val;
 
-	if ( (yy_c_buf_p) > &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars) + 1] )
+	if ( yyg->yy_c_buf_p > &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars + 1] )
 		YY_FATAL_ERROR(
 		"fatal flex scanner internal error--end of buffer missed" );
 
 	if ( YY_CURRENT_BUFFER_LVALUE->yy_fill_buffer == 0 )
 		{ /* Don't try to fill the buffer, so this is an EOF. */
-		if ( (yy_c_buf_p) - (yytext_ptr) - YY_MORE_ADJ == 1 )
+		if ( yyg->yy_c_buf_p - yyg->yytext_ptr - YY_MORE_ADJ == 1 )
 			{
 			/* We matched a single character, the EOB, so
 			 * treat this as a final EOF.
@@ -2755,7 +2768,7 @@ static int yy_get_next_buffer (void)
 	/* Try to read more data. */
 
 	/* First move last chars to start of buffer. */
-	number_to_move = (int) ((yy_c_buf_p) - (yytext_ptr)) - 1;
+	number_to_move = (int) (yyg->yy_c_buf_p - yyg->yytext_ptr) - 1;
 
 	for ( i = 0; i < number_to_move; ++i )
 		*(dest++) = *(source++);
@@ -2764,7 +2777,7 @@ static int yy_get_next_buffer (void)
 		/* don't do the read, it's not guaranteed to return an EOF,
 		 * just force an EOF
 		 */
-		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars) = 0;
+		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = yyg->yy_n_chars = 0;
 
 	else
 		{
@@ -2778,7 +2791,7 @@ static int yy_get_next_buffer (void)
 			YY_BUFFER_STATE b = YY_CURRENT_BUFFER;
 
 			int yy_c_buf_p_offset =
-				(int) ((yy_c_buf_p) - b->yy_ch_buf);
+				(int) (yyg->yy_c_buf_p - b->yy_ch_buf);
 
 			if ( b->yy_is_our_buffer )
 				{
@@ -2791,7 +2804,7 @@ static int yy_get_next_buffer (void)
 
 				b->yy_ch_buf = (char *)
 					/* Include room in for 2 EOB chars. */
-					cssrealloc((void *) b->yy_ch_buf,b->yy_buf_size + 2  );
+					cssrealloc((void *) b->yy_ch_buf,b->yy_buf_size + 2 ,yyscanner );
 				}
 			else
 				/* Can't grow it, we don't own it. */
@@ -2801,7 +2814,7 @@ static int yy_get_next_buffer (void)
 				YY_FATAL_ERROR(
 				"fatal error - scanner input buffer overflow" );
 
-			(yy_c_buf_p) = &b->yy_ch_buf[yy_c_buf_p_offset];
+			yyg->yy_c_buf_p = &b->yy_ch_buf[yy_c_buf_p_offset];
 
 			num_to_read = YY_CURRENT_BUFFER_LVALUE->yy_buf_size -
 						number_to_move - 1;
@@ -2813,17 +2826,17 @@ static int yy_get_next_buffer (void)
 
 		/* Read in more data. */
 		YY_INPUT( (&YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[number_to_move]),
-			(yy_n_chars), num_to_read );
+			yyg->yy_n_chars, num_to_read );
 
-		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars);
+		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = yyg->yy_n_chars;
 		}
 
-	if ( (yy_n_chars) == 0 )
+	if ( yyg->yy_n_chars == 0 )
 		{
 		if ( number_to_move == YY_MORE_ADJ )
 			{
 			ret_val = EOB_ACT_END_OF_FILE;
-			cssrestart(cssin  );
+			cssrestart(yyin ,yyscanner );
 			}
 
 		else
@@ -2837,39 +2850,40 @@ static int yy_get_next_buffer (void)
 	else
 		ret_val = EOB_ACT_CONTINUE_SCAN;
 
-	if ((yy_size_t) ((yy_n_chars) + number_to_move) > YY_CURRENT_BUFFER_LVALUE->yy_buf_size) {
+	if ((yy_size_t) (yyg->yy_n_chars + number_to_move) > YY_CURRENT_BUFFER_LVALUE->yy_buf_size) {
 		/* Extend the array by 50%, plus the number we really need. */
-		yy_size_t new_size = (yy_n_chars) + number_to_move + ((yy_n_chars) >> 1);
-		YY_CURRENT_BUFFER_LVALUE->yy_ch_buf = (char *) cssrealloc((void *) YY_CURRENT_BUFFER_LVALUE->yy_ch_buf,new_size  );
+		yy_size_t new_size = yyg->yy_n_chars + number_to_move + (yyg->yy_n_chars >> 1);
+		YY_CURRENT_BUFFER_LVALUE->yy_ch_buf = (char *) cssrealloc((void *) YY_CURRENT_BUFFER_LVALUE->yy_ch_buf,new_size ,yyscanner );
 		if ( ! YY_CURRENT_BUFFER_LVALUE->yy_ch_buf )
 			YY_FATAL_ERROR( "out of dynamic memory in yy_get_next_buffer()" );
 	}
 
-	(yy_n_chars) += number_to_move;
-	YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars)] = YY_END_OF_BUFFER_CHAR;
-	YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars) + 1] = YY_END_OF_BUFFER_CHAR;
+	yyg->yy_n_chars += number_to_move;
+	YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars] = YY_END_OF_BUFFER_CHAR;
+	YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars + 1] = YY_END_OF_BUFFER_CHAR;
 
-	(yytext_ptr) = &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[0];
+	yyg->yytext_ptr = &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[0];
 
 	return ret_val;
 }
 
 /* yy_get_previous_state - get the state just before the EOB char was reached */
 
-    static yy_state_type yy_get_previous_state (void)
+    static yy_state_type yy_get_previous_state (yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	register yy_state_type yy_current_state;
 	register char *yy_cp;
     
-	yy_current_state = (yy_start);
+	yy_current_state = yyg->yy_start;
 
-	for ( yy_cp = (yytext_ptr) + YY_MORE_ADJ; yy_cp < (yy_c_buf_p); ++yy_cp )
+	for ( yy_cp = yyg->yytext_ptr + YY_MORE_ADJ; yy_cp < yyg->yy_c_buf_p; ++yy_cp )
 		{
 		register YY_CHAR yy_c = (*yy_cp ? yy_ec[YY_SC_TO_UI(*yy_cp)] : 1);
 		if ( yy_accept[yy_current_state] )
 			{
-			(yy_last_accepting_state) = yy_current_state;
-			(yy_last_accepting_cpos) = yy_cp;
+			yyg->yy_last_accepting_state = yy_current_state;
+			yyg->yy_last_accepting_cpos = yy_cp;
 			}
 		while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 			{
@@ -2888,16 +2902,17 @@ static int yy_get_next_buffer (void)
  * synopsis
  *	next_state = yy_try_NUL_trans( current_state );
  */
-    static yy_state_type yy_try_NUL_trans  (yy_state_type yy_current_state )
+    static yy_state_type yy_try_NUL_trans  (yy_state_type yy_current_state ,yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	register int yy_is_jam;
-    	register char *yy_cp = (yy_c_buf_p);
+    	register char *yy_cp = yyg->yy_c_buf_p;
 
 	register YY_CHAR yy_c = 1;
 	if ( yy_accept[yy_current_state] )
 		{
-		(yy_last_accepting_state) = yy_current_state;
-		(yy_last_accepting_cpos) = yy_cp;
+		yyg->yy_last_accepting_state = yy_current_state;
+		yyg->yy_last_accepting_cpos = yy_cp;
 		}
 	while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 		{
@@ -2913,32 +2928,32 @@ static int yy_get_next_buffer (void)
 
 #ifndef YY_NO_INPUT
 #ifdef __cplusplus
-    static int yyinput (void)
+    static int yyinput (yyscan_t yyscanner)
 #else
-    static int input  (void)
+    static int input  (yyscan_t yyscanner)
 #endif
 
 {
 	int c;
     
-	*(yy_c_buf_p) = (yy_hold_char);
+	*yyg->yy_c_buf_p = yyg->yy_hold_char;
 
-	if ( *(yy_c_buf_p) == YY_END_OF_BUFFER_CHAR )
+	if ( *yyg->yy_c_buf_p == YY_END_OF_BUFFER_CHAR )
 		{
 		/* yy_c_buf_p now points to the character we want to return.
 		 * If this occurs *before* the EOB characters, then it's a
 		 * valid NUL; if not, then we've hit the end of the buffer.
 		 */
-		if ( (yy_c_buf_p) < &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars)] )
+		if ( yyg->yy_c_buf_p < &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars] )
 			/* This was really a NUL. */
-			*(yy_c_buf_p) = '\0';
+			*yyg->yy_c_buf_p = '\0';
 
 		else
 			{ /* need more input */
-			yy_size_t offset = (yy_c_buf_p) - (yytext_ptr);
-			++(yy_c_buf_p);
+			yy_size_t offset = yyg->yy_c_buf_p - yyg->yytext_ptr;
+			++yyg->yy_c_buf_p;
 
-			switch ( yy_get_next_buffer(  ) )
+			switch ( yy_get_next_buffer(yyscanner ) )
 				{
 				case EOB_ACT_LAST_MATCH:
 					/* This happens because yy_g_n_b()
@@ -2952,34 +2967,34 @@ static int yy_get_next_buffer (void)
 					 */
 
 					/* Reset buffer status. */
-					cssrestart(cssin );
+					cssrestart(yyin ,yyscanner );
 
 					/*FALLTHROUGH*/
 
 				case EOB_ACT_END_OF_FILE:
 					{
-					if ( csswrap( ) )
+					if ( csswrap(yyscanner ) )
 						return 0;
 
-					if ( ! (yy_did_buffer_switch_on_eof) )
+					if ( ! yyg->yy_did_buffer_switch_on_eof )
 						YY_NEW_FILE;
 #ifdef __cplusplus
-					return yyinput();
+					return yyinput(yyscanner );
 #else
-					return input();
+					return input(yyscanner );
 #endif
 					}
 
 				case EOB_ACT_CONTINUE_SCAN:
-					(yy_c_buf_p) = (yytext_ptr) + offset;
+					yyg->yy_c_buf_p = yyg->yytext_ptr + offset;
 					break;
 				}
 			}
 		}
 
-	c = *(unsigned char *) (yy_c_buf_p);	/* cast for 8-bit char's */
-	*(yy_c_buf_p) = '\0';	/* preserve csstext */
-	(yy_hold_char) = *++(yy_c_buf_p);
+	c = *(unsigned char *) yyg->yy_c_buf_p;	/* cast for 8-bit char's */
+	*yyg->yy_c_buf_p = '\0';	/* preserve yytext */
+	yyg->yy_hold_char = *++yyg->yy_c_buf_p;
 
 	return c;
 }
@@ -2990,60 +3005,63 @@ static int yy_get_next_buffer (void)
  * 
  * @note This function does not reset the start condition to @c INITIAL .
  */
-    void cssrestart  (FILE * input_file )
+    void cssrestart  (FILE * input_file ,yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
     
 	if ( ! YY_CURRENT_BUFFER ){
-        cssensure_buffer_stack ();
+        cssensure_buffer_stack (yyscanner );
 		YY_CURRENT_BUFFER_LVALUE =
-            css_create_buffer(cssin,YY_BUF_SIZE );
+            css_create_buffer(yyin,YY_BUF_SIZE ,yyscanner );
 	}
 
-	css_init_buffer(YY_CURRENT_BUFFER,input_file );
-	css_load_buffer_state( );
+	css_init_buffer(YY_CURRENT_BUFFER,input_file ,yyscanner );
+	css_load_buffer_state(yyscanner );
 }
 
 /** Switch to a different input buffer.
  * @param new_buffer The new input buffer.
  * 
  */
-    void css_switch_to_buffer  (YY_BUFFER_STATE  new_buffer )
+    void css_switch_to_buffer  (YY_BUFFER_STATE  new_buffer ,yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
     
 	/* TODO. We should be able to replace this entire function body
 	 * with
 	 *		csspop_buffer_state();
 	 *		csspush_buffer_state(new_buffer);
      */
-	cssensure_buffer_stack ();
+	cssensure_buffer_stack (yyscanner );
 	if ( YY_CURRENT_BUFFER == new_buffer )
 		return;
 
 	if ( YY_CURRENT_BUFFER )
 		{
 		/* Flush out information for old buffer. */
-		*(yy_c_buf_p) = (yy_hold_char);
-		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = (yy_c_buf_p);
-		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars);
+		*yyg->yy_c_buf_p = yyg->yy_hold_char;
+		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = yyg->yy_c_buf_p;
+		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = yyg->yy_n_chars;
 		}
 
 	YY_CURRENT_BUFFER_LVALUE = new_buffer;
-	css_load_buffer_state( );
+	css_load_buffer_state(yyscanner );
 
 	/* We don't actually know whether we did this switch during
 	 * EOF (csswrap()) processing, but the only time this flag
 	 * is looked at is after csswrap() is called, so it's safe
 	 * to go ahead and always set it.
 	 */
-	(yy_did_buffer_switch_on_eof) = 1;
+	yyg->yy_did_buffer_switch_on_eof = 1;
 }
 
-static void css_load_buffer_state  (void)
+static void css_load_buffer_state  (yyscan_t yyscanner)
 {
-    	(yy_n_chars) = YY_CURRENT_BUFFER_LVALUE->yy_n_chars;
-	(yytext_ptr) = (yy_c_buf_p) = YY_CURRENT_BUFFER_LVALUE->yy_buf_pos;
-	cssin = YY_CURRENT_BUFFER_LVALUE->yy_input_file;
-	(yy_hold_char) = *(yy_c_buf_p);
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    	yyg->yy_n_chars = YY_CURRENT_BUFFER_LVALUE->yy_n_chars;
+	yyg->yytext_ptr = yyg->yy_c_buf_p = YY_CURRENT_BUFFER_LVALUE->yy_buf_pos;
+	yyin = YY_CURRENT_BUFFER_LVALUE->yy_input_file;
+	yyg->yy_hold_char = *yyg->yy_c_buf_p;
 }
 
 /** Allocate and initialize an input buffer state.
@@ -3052,11 +3070,12 @@ static void css_load_buffer_state  (void)
  * 
  * @return the allocated buffer state.
  */
-    YY_BUFFER_STATE css_create_buffer  (FILE * file, int  size )
+    YY_BUFFER_STATE css_create_buffer  (FILE * file, int  size ,yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	YY_BUFFER_STATE b;
     
-	b = (YY_BUFFER_STATE) cssalloc(sizeof( struct yy_buffer_state )  );
+	b = (YY_BUFFER_STATE) cssalloc(sizeof( struct yy_buffer_state ) ,yyscanner );
 	if ( ! b )
 		YY_FATAL_ERROR( "out of dynamic memory in css_create_buffer()" );
 
@@ -3065,13 +3084,13 @@ static void css_load_buffer_state  (void)
 	/* yy_ch_buf has to be 2 characters longer than the size given because
 	 * we need to put in 2 end-of-buffer characters.
 	 */
-	b->yy_ch_buf = (char *) cssalloc(b->yy_buf_size + 2  );
+	b->yy_ch_buf = (char *) cssalloc(b->yy_buf_size + 2 ,yyscanner );
 	if ( ! b->yy_ch_buf )
 		YY_FATAL_ERROR( "out of dynamic memory in css_create_buffer()" );
 
 	b->yy_is_our_buffer = 1;
 
-	css_init_buffer(b,file );
+	css_init_buffer(b,file ,yyscanner );
 
 	return b;
 }
@@ -3080,8 +3099,9 @@ static void css_load_buffer_state  (void)
  * @param b a buffer created with css_create_buffer()
  * 
  */
-    void css_delete_buffer (YY_BUFFER_STATE  b )
+    void css_delete_buffer (YY_BUFFER_STATE  b ,yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
     
 	if ( ! b )
 		return;
@@ -3090,9 +3110,9 @@ static void css_load_buffer_state  (void)
 		YY_CURRENT_BUFFER_LVALUE = (YY_BUFFER_STATE) 0;
 
 	if ( b->yy_is_our_buffer )
-		cssfree((void *) b->yy_ch_buf  );
+		cssfree((void *) b->yy_ch_buf ,yyscanner );
 
-	cssfree((void *) b  );
+	cssfree((void *) b ,yyscanner );
 }
 
 #ifndef __cplusplus
@@ -3103,12 +3123,13 @@ extern int isatty (int );
  * This function is sometimes called more than once on the same buffer,
  * such as during a cssrestart() or at EOF.
  */
-    static void css_init_buffer  (YY_BUFFER_STATE  b, FILE * file )
+    static void css_init_buffer  (YY_BUFFER_STATE  b, FILE * file ,yyscan_t yyscanner)
 
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	int oerrno = errno;
     
-	css_flush_buffer(b );
+	css_flush_buffer(b ,yyscanner );
 
 	b->yy_input_file = file;
 	b->yy_fill_buffer = 1;
@@ -3131,8 +3152,9 @@ extern int isatty (int );
  * @param b the buffer state to be flushed, usually @c YY_CURRENT_BUFFER.
  * 
  */
-    void css_flush_buffer (YY_BUFFER_STATE  b )
+    void css_flush_buffer (YY_BUFFER_STATE  b ,yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
     	if ( ! b )
 		return;
 
@@ -3151,7 +3173,7 @@ extern int isatty (int );
 	b->yy_buffer_status = YY_BUFFER_NEW;
 
 	if ( b == YY_CURRENT_BUFFER )
-		css_load_buffer_state( );
+		css_load_buffer_state(yyscanner );
 }
 
 /** Pushes the new state onto the stack. The new state becomes
@@ -3160,95 +3182,96 @@ extern int isatty (int );
  *  @param new_buffer The new state.
  *  
  */
-void csspush_buffer_state (YY_BUFFER_STATE new_buffer )
+void csspush_buffer_state (YY_BUFFER_STATE new_buffer ,yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
     	if (new_buffer == NULL)
 		return;
 
-	cssensure_buffer_stack();
+	cssensure_buffer_stack(yyscanner );
 
 	/* This block is copied from css_switch_to_buffer. */
 	if ( YY_CURRENT_BUFFER )
 		{
 		/* Flush out information for old buffer. */
-		*(yy_c_buf_p) = (yy_hold_char);
-		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = (yy_c_buf_p);
-		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars);
+		*yyg->yy_c_buf_p = yyg->yy_hold_char;
+		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = yyg->yy_c_buf_p;
+		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = yyg->yy_n_chars;
 		}
 
 	/* Only push if top exists. Otherwise, replace top. */
 	if (YY_CURRENT_BUFFER)
-		(yy_buffer_stack_top)++;
+		yyg->yy_buffer_stack_top++;
 	YY_CURRENT_BUFFER_LVALUE = new_buffer;
 
 	/* copied from css_switch_to_buffer. */
-	css_load_buffer_state( );
-	(yy_did_buffer_switch_on_eof) = 1;
+	css_load_buffer_state(yyscanner );
+	yyg->yy_did_buffer_switch_on_eof = 1;
 }
 
 /** Removes and deletes the top of the stack, if present.
  *  The next element becomes the new top.
  *  
  */
-void csspop_buffer_state (void)
+void csspop_buffer_state (yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
     	if (!YY_CURRENT_BUFFER)
 		return;
 
-	css_delete_buffer(YY_CURRENT_BUFFER );
+	css_delete_buffer(YY_CURRENT_BUFFER ,yyscanner );
 	YY_CURRENT_BUFFER_LVALUE = NULL;
-	if ((yy_buffer_stack_top) > 0)
-		--(yy_buffer_stack_top);
+	if (yyg->yy_buffer_stack_top > 0)
+		--yyg->yy_buffer_stack_top;
 
 	if (YY_CURRENT_BUFFER) {
-		css_load_buffer_state( );
-		(yy_did_buffer_switch_on_eof) = 1;
+		css_load_buffer_state(yyscanner );
+		yyg->yy_did_buffer_switch_on_eof = 1;
 	}
 }
 
 /* Allocates the stack if it does not exist.
  *  Guarantees space for at least one push.
  */
-static void cssensure_buffer_stack (void)
+static void cssensure_buffer_stack (yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	yy_size_t num_to_alloc;
     
-	if (!(yy_buffer_stack)) {
+	if (!yyg->yy_buffer_stack) {
 
 		/* First allocation is just for 2 elements, since we don't know if this
 		 * scanner will even need a stack. We use 2 instead of 1 to avoid an
 		 * immediate realloc on the next call.
          */
 		num_to_alloc = 1;
-		(yy_buffer_stack) = (struct yy_buffer_state**)cssalloc
-								(num_to_alloc * sizeof(struct yy_buffer_state*)
-								);
-		if ( ! (yy_buffer_stack) )
+		yyg->yy_buffer_stack = (struct yy_buffer_state**)cssalloc
+								(num_to_alloc * sizeof(struct yy_buffer_state*) ,yyscanner );
+		if ( ! yyg->yy_buffer_stack )
 			YY_FATAL_ERROR( "out of dynamic memory in cssensure_buffer_stack()" );
 								  
-		memset((yy_buffer_stack), 0, num_to_alloc * sizeof(struct yy_buffer_state*));
+		memset(yyg->yy_buffer_stack, 0, num_to_alloc * sizeof(struct yy_buffer_state*));
 				
-		(yy_buffer_stack_max) = num_to_alloc;
-		(yy_buffer_stack_top) = 0;
+		yyg->yy_buffer_stack_max = num_to_alloc;
+		yyg->yy_buffer_stack_top = 0;
 		return;
 	}
 
-	if ((yy_buffer_stack_top) >= ((yy_buffer_stack_max)) - 1){
+	if (yyg->yy_buffer_stack_top >= (yyg->yy_buffer_stack_max) - 1){
 
 		/* Increase the buffer to prepare for a possible push. */
 		int grow_size = 8 /* arbitrary grow size */;
 
-		num_to_alloc = (yy_buffer_stack_max) + grow_size;
-		(yy_buffer_stack) = (struct yy_buffer_state**)cssrealloc
-								((yy_buffer_stack),
-								num_to_alloc * sizeof(struct yy_buffer_state*)
-								);
-		if ( ! (yy_buffer_stack) )
+		num_to_alloc = yyg->yy_buffer_stack_max + grow_size;
+		yyg->yy_buffer_stack = (struct yy_buffer_state**)cssrealloc
+								(yyg->yy_buffer_stack,
+								num_to_alloc * sizeof(struct yy_buffer_state*) ,yyscanner );
+		if ( ! yyg->yy_buffer_stack )
 			YY_FATAL_ERROR( "out of dynamic memory in cssensure_buffer_stack()" );
 
 		/* zero only the new slots.*/
-		memset((yy_buffer_stack) + (yy_buffer_stack_max), 0, grow_size * sizeof(struct yy_buffer_state*));
-		(yy_buffer_stack_max) = num_to_alloc;
+		memset(yyg->yy_buffer_stack + yyg->yy_buffer_stack_max, 0, grow_size * sizeof(struct yy_buffer_state*));
+		yyg->yy_buffer_stack_max = num_to_alloc;
 	}
 }
 
@@ -3258,8 +3281,9 @@ static void cssensure_buffer_stack (void)
  * 
  * @return the newly allocated buffer state object. 
  */
-YY_BUFFER_STATE css_scan_buffer  (char * base, yy_size_t  size )
+YY_BUFFER_STATE css_scan_buffer  (char * base, yy_size_t  size ,yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	YY_BUFFER_STATE b;
     
 	if ( size < 2 ||
@@ -3268,7 +3292,7 @@ YY_BUFFER_STATE css_scan_buffer  (char * base, yy_size_t  size )
 		/* They forgot to leave room for the EOB's. */
 		return 0;
 
-	b = (YY_BUFFER_STATE) cssalloc(sizeof( struct yy_buffer_state )  );
+	b = (YY_BUFFER_STATE) cssalloc(sizeof( struct yy_buffer_state ) ,yyscanner );
 	if ( ! b )
 		YY_FATAL_ERROR( "out of dynamic memory in css_scan_buffer()" );
 
@@ -3282,7 +3306,7 @@ YY_BUFFER_STATE css_scan_buffer  (char * base, yy_size_t  size )
 	b->yy_fill_buffer = 0;
 	b->yy_buffer_status = YY_BUFFER_NEW;
 
-	css_switch_to_buffer(b  );
+	css_switch_to_buffer(b ,yyscanner );
 
 	return b;
 }
@@ -3295,10 +3319,10 @@ YY_BUFFER_STATE css_scan_buffer  (char * base, yy_size_t  size )
  * @note If you want to scan bytes that may contain NUL values, then use
  *       css_scan_bytes() instead.
  */
-YY_BUFFER_STATE css_scan_string (yyconst char * yystr )
+YY_BUFFER_STATE css_scan_string (yyconst char * yystr ,yyscan_t yyscanner)
 {
     
-	return css_scan_bytes(yystr,strlen(yystr) );
+	return css_scan_bytes(yystr,strlen(yystr) ,yyscanner );
 }
 
 /** Setup the input buffer state to scan the given bytes. The next call to csslex() will
@@ -3308,15 +3332,16 @@ YY_BUFFER_STATE css_scan_string (yyconst char * yystr )
  * 
  * @return the newly allocated buffer state object.
  */
-YY_BUFFER_STATE css_scan_bytes  (yyconst char * yybytes, yy_size_t  _yybytes_len )
+YY_BUFFER_STATE css_scan_bytes  (yyconst char * yybytes, yy_size_t  _yybytes_len ,yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	YY_BUFFER_STATE b;
 	char *buf;
 	yy_size_t n, i;
     
 	/* Get memory for full buffer, including space for trailing EOB's. */
 	n = _yybytes_len + 2;
-	buf = (char *) cssalloc(n  );
+	buf = (char *) cssalloc(n ,yyscanner );
 	if ( ! buf )
 		YY_FATAL_ERROR( "out of dynamic memory in css_scan_bytes()" );
 
@@ -3325,7 +3350,7 @@ YY_BUFFER_STATE css_scan_bytes  (yyconst char * yybytes, yy_size_t  _yybytes_len
 
 	buf[_yybytes_len] = buf[_yybytes_len+1] = YY_END_OF_BUFFER_CHAR;
 
-	b = css_scan_buffer(buf,n );
+	b = css_scan_buffer(buf,n ,yyscanner );
 	if ( ! b )
 		YY_FATAL_ERROR( "bad buffer in css_scan_bytes()" );
 
@@ -3341,7 +3366,7 @@ YY_BUFFER_STATE css_scan_bytes  (yyconst char * yybytes, yy_size_t  _yybytes_len
 #define YY_EXIT_FAILURE 2
 #endif
 
-static void yy_fatal_error (yyconst char* msg )
+static void yy_fatal_error (yyconst char* msg ,yyscan_t yyscanner)
 {
     	(void) fprintf( stderr, "%s\n", msg );
 	exit( YY_EXIT_FAILURE );
@@ -3353,69 +3378,119 @@ static void yy_fatal_error (yyconst char* msg )
 #define yyless(n) \
 	do \
 		{ \
-		/* Undo effects of setting up csstext. */ \
+		/* Undo effects of setting up yytext. */ \
         int yyless_macro_arg = (n); \
         YY_LESS_LINENO(yyless_macro_arg);\
-		csstext[cssleng] = (yy_hold_char); \
-		(yy_c_buf_p) = csstext + yyless_macro_arg; \
-		(yy_hold_char) = *(yy_c_buf_p); \
-		*(yy_c_buf_p) = '\0'; \
-		cssleng = yyless_macro_arg; \
+		yytext[yyleng] = yyg->yy_hold_char; \
+		yyg->yy_c_buf_p = yytext + yyless_macro_arg; \
+		yyg->yy_hold_char = *yyg->yy_c_buf_p; \
+		*yyg->yy_c_buf_p = '\0'; \
+		yyleng = yyless_macro_arg; \
 		} \
 	while ( 0 )
 
 /* Accessor  methods (get/set functions) to struct members. */
 
+/** Get the user-defined data for this scanner.
+ * 
+ */
+YY_EXTRA_TYPE cssget_extra  (yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yyextra;
+}
+
 /** Get the current line number.
  * 
  */
-int cssget_lineno  (void)
+int cssget_lineno  (yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    
+        if (! YY_CURRENT_BUFFER)
+            return 0;
+    
+    return yylineno;
+}
+
+/** Get the column number.
+ * 
+ */
+int cssget_column  (yyscan_t yyscanner)
 {
-        
-    return csslineno;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    
+        if (! YY_CURRENT_BUFFER)
+            return 0;
+    
+    return yycolumn;
 }
 
 /** Get the input stream.
  * 
  */
-FILE *cssget_in  (void)
+FILE *cssget_in  (yyscan_t yyscanner)
 {
-        return cssin;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+        return yyin;
 }
 
 /** Get the output stream.
  * 
  */
-FILE *cssget_out  (void)
+FILE *cssget_out  (yyscan_t yyscanner)
 {
-        return cssout;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+        return yyout;
 }
 
 /** Get the length of the current token.
  * 
  */
-yy_size_t cssget_leng  (void)
+yy_size_t cssget_leng  (yyscan_t yyscanner)
 {
-        return cssleng;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+        return yyleng;
 }
 
 /** Get the current token.
  * 
  */
 
-char *cssget_text  (void)
+char *cssget_text  (yyscan_t yyscanner)
 {
-        return csstext;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+        return yytext;
 }
 
 /** Set the current line number.
  * @param line_number
  * 
  */
-void cssset_lineno (int  line_number )
+void cssset_lineno (int  line_number ,yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
     
-    csslineno = line_number;
+        /* lineno is only valid if an input buffer exists. */
+        if (! YY_CURRENT_BUFFER )
+           yy_fatal_error( "cssset_lineno called with no buffer" ,yyscanner );
+    
+    yylineno = line_number;
+}
+
+/** Set the current column.
+ * @param line_number
+ * 
+ */
+void cssset_column (int  column_no ,yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    
+        /* column is only valid if an input buffer exists. */
+        if (! YY_CURRENT_BUFFER )
+           yy_fatal_error( "cssset_column called with no buffer" ,yyscanner );
+    
+    yycolumn = column_no;
 }
 
 /** Set the input stream. This does not discard the current
@@ -3424,46 +3499,129 @@ void cssset_lineno (int  line_number )
  * 
  * @see css_switch_to_buffer
  */
-void cssset_in (FILE *  in_str )
+void cssset_in (FILE *  in_str ,yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+        yyin = in_str ;
+}
+
+void cssset_out (FILE *  out_str ,yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+        yyout = out_str ;
+}
+
+/** Set the user-defined data. This data is never touched by the scanner.
+ * @param user_defined The data to be associated with this scanner.
+ * 
+ */
+void cssset_extra (YY_EXTRA_TYPE  user_defined ,yyscan_t yyscanner)
 {
-        cssin = in_str ;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    yyextra = user_defined ;
 }
 
-void cssset_out (FILE *  out_str )
+int cssget_debug  (yyscan_t yyscanner)
 {
-        cssout = out_str ;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+        return yy_flex_debug;
 }
 
-int cssget_debug  (void)
+void cssset_debug (int  bdebug ,yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+        yy_flex_debug = bdebug ;
+}
+
+/* User-visible API */
+
+/* csslex_init is special because it creates the scanner itself, so it is
+ * the ONLY reentrant function that doesn't take the scanner as the last argument.
+ * That's why we explicitly handle the declaration, instead of using our macros.
+ */
+
+int csslex_init(yyscan_t* ptr_yy_globals)
+
 {
-        return css_flex_debug;
+    if (ptr_yy_globals == NULL){
+        errno = EINVAL;
+        return 1;
+    }
+
+    *ptr_yy_globals = (yyscan_t) cssalloc ( sizeof( struct yyguts_t ), NULL );
+
+    if (*ptr_yy_globals == NULL){
+        errno = ENOMEM;
+        return 1;
+    }
+
+    /* By setting to 0xAA, we expose bugs in yy_init_globals. Leave at 0x00 for releases. */
+    memset(*ptr_yy_globals,0x00,sizeof(struct yyguts_t));
+
+    return yy_init_globals ( *ptr_yy_globals );
 }
 
-void cssset_debug (int  bdebug )
+/* csslex_init_extra has the same functionality as csslex_init, but follows the
+ * convention of taking the scanner as the last argument. Note however, that
+ * this is a *pointer* to a scanner, as it will be allocated by this call (and
+ * is the reason, too, why this function also must handle its own declaration).
+ * The user defined value in the first argument will be available to cssalloc in
+ * the yyextra field.
+ */
+
+int csslex_init_extra(YY_EXTRA_TYPE yy_user_defined,yyscan_t* ptr_yy_globals )
+
 {
-        css_flex_debug = bdebug ;
+    struct yyguts_t dummy_yyguts;
+
+    cssset_extra (yy_user_defined, &dummy_yyguts );
+
+    if (ptr_yy_globals == NULL){
+        errno = EINVAL;
+        return 1;
+    }
+	
+    *ptr_yy_globals = (yyscan_t) cssalloc ( sizeof( struct yyguts_t ), &dummy_yyguts );
+	
+    if (*ptr_yy_globals == NULL){
+        errno = ENOMEM;
+        return 1;
+    }
+    
+    /* By setting to 0xAA, we expose bugs in
+    yy_init_globals. Leave at 0x00 for releases. */
+    memset(*ptr_yy_globals,0x00,sizeof(struct yyguts_t));
+    
+    cssset_extra (yy_user_defined, *ptr_yy_globals );
+    
+    return yy_init_globals ( *ptr_yy_globals );
 }
 
-static int yy_init_globals (void)
+static int yy_init_globals (yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
         /* Initialization is the same as for the non-reentrant scanner.
      * This function is called from csslex_destroy(), so don't allocate here.
      */
 
-    (yy_buffer_stack) = 0;
-    (yy_buffer_stack_top) = 0;
-    (yy_buffer_stack_max) = 0;
-    (yy_c_buf_p) = (char *) 0;
-    (yy_init) = 0;
-    (yy_start) = 0;
+    yyg->yy_buffer_stack = 0;
+    yyg->yy_buffer_stack_top = 0;
+    yyg->yy_buffer_stack_max = 0;
+    yyg->yy_c_buf_p = (char *) 0;
+    yyg->yy_init = 0;
+    yyg->yy_start = 0;
+
+    yyg->yy_start_stack_ptr = 0;
+    yyg->yy_start_stack_depth = 0;
+    yyg->yy_start_stack =  NULL;
 
 /* Defined in main.c */
 #ifdef YY_STDINIT
-    cssin = stdin;
-    cssout = stdout;
+    yyin = stdin;
+    yyout = stdout;
 #else
-    cssin = (FILE *) 0;
-    cssout = (FILE *) 0;
+    yyin = (FILE *) 0;
+    yyout = (FILE *) 0;
 #endif
 
     /* For future reference: Set errno on error, since we are called by
@@ -3473,24 +3631,32 @@ static int yy_init_globals (void)
 }
 
 /* csslex_destroy is for both reentrant and non-reentrant scanners. */
-int csslex_destroy  (void)
+int csslex_destroy  (yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
     
     /* Pop the buffer stack, destroying each element. */
 	while(YY_CURRENT_BUFFER){
-		css_delete_buffer(YY_CURRENT_BUFFER  );
+		css_delete_buffer(YY_CURRENT_BUFFER ,yyscanner );
 		YY_CURRENT_BUFFER_LVALUE = NULL;
-		csspop_buffer_state();
+		csspop_buffer_state(yyscanner );
 	}
 
 	/* Destroy the stack itself. */
-	cssfree((yy_buffer_stack) );
-	(yy_buffer_stack) = NULL;
+	cssfree(yyg->yy_buffer_stack ,yyscanner );
+	yyg->yy_buffer_stack = NULL;
+
+    /* Destroy the start condition stack. */
+        cssfree(yyg->yy_start_stack ,yyscanner );
+        yyg->yy_start_stack = NULL;
 
     /* Reset the globals. This is important in a non-reentrant scanner so the next time
      * csslex() is called, initialization will occur. */
-    yy_init_globals( );
+    yy_init_globals(yyscanner );
 
+    /* Destroy the main struct (reentrant only). */
+    cssfree ( yyscanner ,yyscanner );
+    yyscanner = NULL;
     return 0;
 }
 
@@ -3499,7 +3665,7 @@ int csslex_destroy  (void)
  */
 
 #ifndef yytext_ptr
-static void yy_flex_strncpy (char* s1, yyconst char * s2, int n )
+static void yy_flex_strncpy (char* s1, yyconst char * s2, int n ,yyscan_t yyscanner)
 {
 	register int i;
 	for ( i = 0; i < n; ++i )
@@ -3508,7 +3674,7 @@ static void yy_flex_strncpy (char* s1, yyconst char * s2, int n )
 #endif
 
 #ifdef YY_NEED_STRLEN
-static int yy_flex_strlen (yyconst char * s )
+static int yy_flex_strlen (yyconst char * s ,yyscan_t yyscanner)
 {
 	register int n;
 	for ( n = 0; s[n]; ++n )
@@ -3518,12 +3684,12 @@ static int yy_flex_strlen (yyconst char * s )
 }
 #endif
 
-void *cssalloc (yy_size_t  size )
+void *cssalloc (yy_size_t  size ,yyscan_t yyscanner)
 {
 	return (void *) malloc( size );
 }
 
-void *cssrealloc  (void * ptr, yy_size_t  size )
+void *cssrealloc  (void * ptr, yy_size_t  size ,yyscan_t yyscanner)
 {
 	/* The cast to (char *) in the following accommodates both
 	 * implementations that use char* generic pointers, and those
@@ -3535,9 +3701,9 @@ void *cssrealloc  (void * ptr, yy_size_t  size )
 	return (void *) realloc( (char *) ptr, size );
 }
 
-void cssfree (void * ptr )
+void cssfree (void * ptr ,yyscan_t yyscanner)
 {
-	free( (char *) ptr );	/* see cssrealloc() for (char *) cast */
+	free( (char *) ptr );	/* see cssrealloc(yyscanner ) for (char *) cast */
 }
 
 #define YYTABLES_NAME "yytables"
@@ -3546,6 +3712,6 @@ void cssfree (void * ptr )
 
 
 
-int csswrap(void){return 1;}
+int csswrap(yyscan_t yyscanner){return 1;}
 
 #endif  // __clang_analyzer__
@@ -45,8 +45,17 @@ extern const char* cssnames[];
 typedef void* yyscan_t;
 #endif
 
-extern FILE *cssin;
+#ifndef YY_TYPEDEF_YY_BUFFER_STATE
+#define YY_TYPEDEF_YY_BUFFER_STATE
+typedef struct yy_buffer_state *YY_BUFFER_STATE;
+#endif
+
+int csslex_init_extra(void* user_defined, yyscan_t* scanner);
+int csslex_destroy(yyscan_t scanner);
+void cssset_in(FILE* in_str, yyscan_t scanner);
 
-int csslex(void);
-int cssConsume(char* text, int token);
-int cssget_lineno(void);
+// Scans size - 2 bytes of base in place. The last two bytes of base must both be NUL.
+YY_BUFFER_STATE css_scan_buffer(char* base, size_t size, yyscan_t scanner);
+int csslex(yyscan_t scanner);
+int cssConsume(void* context, char* text, int token);
+int cssget_lineno(yyscan_t scanner);
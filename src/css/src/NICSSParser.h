@@ -18,6 +18,8 @@
 
 extern NSString* const kPropertyOrderKey;
 extern NSString* const kDependenciesSelectorKey;
+extern NSString* const kPortraitMediaScopePrefix;
+extern NSString* const kLandscapeMediaScopePrefix;
 
 @protocol NICSSParserDelegate;
 
@@ -33,7 +35,14 @@ extern NSString* const kDependenciesSelectorKey;
  * Terminology note: CSS selectors are referred to as "scopes" to avoid confusion with
  * Objective-C selectors.
  *
- * This object is not thread-safe.
+ * Device media types such as `iPad` or `retina` are resolved while parsing, so rulesets for
+ * other devices are dropped. The `portrait` and `landscape` media types can change while the
+ * app runs, so rulesets in such a block are kept with their scope prefixed by
+ * kPortraitMediaScopePrefix or kLandscapeMediaScopePrefix, and NIStylesheet picks them
+ * for the current orientation.
+ *
+ * Each parser lexes with its own reentrant scanner, so separate parser instances may be used
+ * concurrently from background threads. A single instance is not thread-safe.
  */
 @interface NICSSParser : NSObject {
 @private
@@ -45,6 +54,7 @@ extern NSString* const kDependenciesSelectorKey;
   NSString* _currentPropertyName;
   NSMutableArray* _importedFilenames;
   BOOL droppingCurrentRules;
+  int _mediaOrientations; // The orientations the active @media block applies to.
 
   union {
     struct {
@@ -60,6 +70,8 @@ extern NSString* const kDependenciesSelectorKey;
   // Parser state
   NSString* _lastTokenText;
   int _lastToken;
+  CFMutableDictionaryRef _stringsForTokenText;
+  CFMutableDictionaryRef _lowercaseStringsForTokenText;
 
   // Result state
   BOOL _didFailToParse;
@@ -72,6 +84,13 @@ extern NSString* const kDependenciesSelectorKey;
 - (NSDictionary *)dictionaryForPath:(NSString *)path pathPrefix:(NSString *)rootPath;
 - (NSDictionary *)dictionaryForPath:(NSString *)path;
 
+- (NSDictionary *)dictionaryForData:(NSData *)data
+                         pathPrefix:(NSString *)pathPrefix
+                           delegate:(id<NICSSParserDelegate>)delegate;
+
+- (NSDictionary *)dictionaryForData:(NSData *)data pathPrefix:(NSString *)pathPrefix;
+- (NSDictionary *)dictionaryForData:(NSData *)data;
+
 @property (nonatomic, readonly, assign) BOOL didFailToParse;
 
 @end
@@ -88,6 +107,9 @@ extern NSString* const kDependenciesSelectorKey;
  *
  * If nil is returned then the given filename will be used.
  *
+ * Imported files are parsed concurrently, so this method may be called from background threads,
+ * several at a time.
+ *
  * Example:
  * This is used by the Chameleon observer to hash filenames with md5, effectively flattening
  * the path structure so that the files can be accessed without creating subdirectories.
@@ -105,6 +127,11 @@ extern NSString* const kDependenciesSelectorKey;
  * statement "@import url('user/profile.css')", the loaded file will be
  * "/bundle/css/user/profile.css".
  *
+ * The import graph is resolved before anything is merged: each imported file is parsed on a
+ * background queue as soon as the file importing it has been read, so independent imports are
+ * parsed in parallel. The rulesets are then merged in the same cascade order as if every file had
+ * been read in turn. This method blocks until all of the files have been parsed.
+ *
  * @fn NICSSParser::dictionaryForPath:pathPrefix:delegate:
  * @param path         The path of the file to be read.
  * @param pathPrefix   [optional] A prefix path that will be prepended to the given path
@@ -123,6 +150,32 @@ extern NSString* const kDependenciesSelectorKey;
  * @sa NICSSParser::dictionaryForPath:pathPrefix:delegate:
  */
 
+/**
+ * Parses CSS held in memory and returns a dictionary of raw CSS rule sets.
+ *
+ * The data is lexed directly from memory, so stylesheets that were downloaded or built at runtime
+ * don't need to be written to disk first. Any files imported by the data are loaded from disk
+ * relative to pathPrefix and are listed as dependencies of the result.
+ *
+ * Files on disk are lexed the same way: they're memory-mapped rather than read through stdio.
+ *
+ * @fn NICSSParser::dictionaryForData:pathPrefix:delegate:
+ * @param data         The UTF-8 encoded CSS to be parsed.
+ * @param pathPrefix   [optional] A prefix path that will be prepended to any imported files.
+ * @param delegate     [optional] A delegate that can reprocess the paths of imported files.
+ * @returns A dictionary mapping CSS scopes to dictionaries of property names to values.
+ */
+
+/**
+ * @fn NICSSParser::dictionaryForData:pathPrefix:
+ * @sa NICSSParser::dictionaryForData:pathPrefix:delegate:
+ */
+
+/**
+ * @fn NICSSParser::dictionaryForData:
+ * @sa NICSSParser::dictionaryForData:pathPrefix:delegate:
+ */
+
 /**
  * Will be YES after retrieving a dictionary if the parser failed to parse the file in any way.
  *
@@ -17,30 +17,93 @@
 #import "NICSSParser.h"
 
 #import "CSSTokens.h"
+#import "NICSSRuleset.h"
 #import "NimbusCore.h"
 
-#import <pthread.h>
+#import <fcntl.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <unistd.h>
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "Nimbus requires ARC support."
 #endif
 
-static pthread_mutex_t gMutex = PTHREAD_MUTEX_INITIALIZER;
 NSString* const kPropertyOrderKey = @"__kRuleSetOrder__";
 NSString* const kDependenciesSelectorKey = @"__kDependencies__";
+NSString* const kPortraitMediaScopePrefix = @"@portrait ";
+NSString* const kLandscapeMediaScopePrefix = @"@landscape ";
 
-// Damn you, flex. Due to the nature of flex we can only have one active parser at any given time.
-NICSSParser* gActiveParser = nil;
+typedef enum {
+  NICSSMediaOrientationPortrait = 1 << 0,
+  NICSSMediaOrientationLandscape = 1 << 1,
+  NICSSMediaOrientationAll = NICSSMediaOrientationPortrait | NICSSMediaOrientationLandscape,
+} NICSSMediaOrientation;
+
+// Returns the orientations in which rulesets scoped to the given lowercase media type apply on
+// this device. Media types that don't apply to this device, or that aren't known, return 0.
+//
+// The device doesn't change while the app runs, so its media types are only resolved once
+// rather than for every @media block of every stylesheet.
+static int NICSSMediaOrientationsForType(NSString* mediaType) {
+  static NSDictionary* sMediaTypeToOrientations = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    BOOL isPad = NIIsPad();
+    BOOL isPhone = NIIsPhone();
+    BOOL isRetina = NIScreenScale() != 1.0;
+    NSNumber* all = [NSNumber numberWithInt:NICSSMediaOrientationAll];
+    NSNumber* none = [NSNumber numberWithInt:0];
+    sMediaTypeToOrientations = @{
+      @"ipad": isPad ? all : none,
+      @"iphone": isPhone ? all : none,
+      @"retina": isRetina ? all : none,
+      @"nonretina": !isRetina ? all : none,
+      @"ipad-retina": (isPad && isRetina) ? all : none,
+      @"ipad-nonretina": (isPad && !isRetina) ? all : none,
+      @"iphone-retina": (isPhone && isRetina) ? all : none,
+      @"iphone-nonretina": (isPhone && !isRetina) ? all : none,
+      @"portrait": [NSNumber numberWithInt:NICSSMediaOrientationPortrait],
+      @"landscape": [NSNumber numberWithInt:NICSSMediaOrientationLandscape],
+    };
+  });
+  return [[sMediaTypeToOrientations objectForKey:mediaType] intValue];
+}
+
+// Token texts key the parser's string tables. The scanner reuses its buffer, so keys are copied.
+static const void* NICSSRetainTokenText(CFAllocatorRef allocator, const void* text) {
+  return strdup(text);
+}
+
+static void NICSSReleaseTokenText(CFAllocatorRef allocator, const void* text) {
+  free((void *)text);
+}
+
+static Boolean NICSSTokenTextIsEqual(const void* text1, const void* text2) {
+  return 0 == strcmp(text1, text2);
+}
+
+// FNV-1a.
+static CFHashCode NICSSHashTokenText(const void* text) {
+  CFHashCode hash = 2166136261u;
+  for (const unsigned char* c = text; '\0' != *c; ++c) {
+    hash = (hash ^ *c) * 16777619u;
+  }
+  return hash;
+}
+
+static const CFDictionaryKeyCallBacks kNICSSTokenTextKeyCallBacks = {
+  0, NICSSRetainTokenText, NICSSReleaseTokenText, NULL, NICSSTokenTextIsEqual, NICSSHashTokenText
+};
 
-int cssConsume(char* text, int token);
 @interface NICSSParser()
 - (void)consumeToken:(int)token text:(char*)text;
 @end
 
 // The entry point of the flex css parser.
-// Flex is inherently designed to operate as a singleton.
-int cssConsume(char* text, int token) {
-  [gActiveParser consumeToken:token text:text];
+// The scanner is reentrant and carries the parser that created it as its extra context.
+int cssConsume(void* context, char* text, int token) {
+  [(__bridge NICSSParser *)context consumeToken:token text:text];
   return 0;
 }
 
@@ -48,6 +111,10 @@ int cssConsume(char* text, int token) {
 
 
 
+- (void)dealloc {
+  [self shutdown];
+}
+
 - (void)shutdown {
   _rulesets = nil;
   _scopesForActiveRuleset = nil;
@@ -56,6 +123,15 @@ int cssConsume(char* text, int token) {
   _currentPropertyName = nil;
   _importedFilenames = nil;
   _lastTokenText = nil;
+
+  if (NULL != _stringsForTokenText) {
+    CFRelease(_stringsForTokenText);
+    _stringsForTokenText = NULL;
+  }
+  if (NULL != _lowercaseStringsForTokenText) {
+    CFRelease(_lowercaseStringsForTokenText);
+    _lowercaseStringsForTokenText = NULL;
+  }
 }
 
 - (void)setFailFlag {
@@ -71,13 +147,42 @@ int cssConsume(char* text, int token) {
   [_mutatingScope removeAllObjects];
 }
 
+// The same property names and values appear throughout a stylesheet, so each distinct token
+// text is only decoded once and every ruleset of the parse shares the resulting string.
+- (NSString *)stringForTokenText:(const char *)text {
+  NSString* string = (__bridge NSString *)CFDictionaryGetValue(_stringsForTokenText, text);
+  if (nil == string) {
+    string = [[NSString alloc] initWithCString:text encoding:NSUTF8StringEncoding];
+    if (nil != string) {
+      CFDictionarySetValue(_stringsForTokenText, text, (__bridge const void *)string);
+    }
+  }
+  return string;
+}
+
+- (NSString *)lowercaseStringForTokenText:(const char *)text string:(NSString *)string {
+  NSString* lowercaseString = (__bridge NSString *)CFDictionaryGetValue(_lowercaseStringsForTokenText, text);
+  if (nil == lowercaseString && nil != string) {
+    lowercaseString = [string lowercaseString];
+    // Known property names become the keys that NICSSRuleset looks them up with.
+    NSString* propertyName = [NICSSRuleset propertyNameForName:lowercaseString];
+    if (nil != propertyName) {
+      lowercaseString = propertyName;
+    } else if ([lowercaseString isEqualToString:string]) {
+      lowercaseString = string;
+    }
+    CFDictionarySetValue(_lowercaseStringsForTokenText, text, (__bridge const void *)lowercaseString);
+  }
+  return lowercaseString;
+}
+
 - (void)consumeToken:(int)token text:(char*)text {
   if (_didFailToParse) {
     return;
   }
 
-  NSString* textAsString = [[NSString alloc] initWithCString:text encoding:NSUTF8StringEncoding];
-  NSString* lowercaseTextAsString = [textAsString lowercaseString];
+  NSString* textAsString = [self stringForTokenText:text];
+  NSString* lowercaseTextAsString = [self lowercaseStringForTokenText:text string:textAsString];
 
   switch (token) {
     case CSSMEDIA: // @media { }
@@ -85,40 +190,16 @@ int cssConsume(char* text, int token) {
         [self setFailFlag];
       }
       _state.Flags.ReadingMedia = YES;
+      _mediaOrientations = 0;
       droppingCurrentRules = YES; // at least one must match to undo this
       break;
     case CSSHASH: // #{name}
     case CSSIDENT: { // {ident}(:{ident})?
 
       if (_state.Flags.ReadingMedia) {
-        if (!droppingCurrentRules) {
-          // No point in running these checks if we've already decided
-          break;
-        } else if ([textAsString caseInsensitiveCompare:@"ipad"] == NSOrderedSame) {
-          if ([UIDevice currentDevice].userInterfaceIdiom == UIUserInterfaceIdiomPad) { droppingCurrentRules = NO; }
-          break;
-        } else if ([textAsString caseInsensitiveCompare:@"iphone"] == NSOrderedSame) {
-          if ([UIDevice currentDevice].userInterfaceIdiom == UIUserInterfaceIdiomPhone) { droppingCurrentRules = NO; }
-          break;
-        } else if ([textAsString caseInsensitiveCompare:@"retina"] == NSOrderedSame) {
-          if ([UIScreen mainScreen].scale != 1.0) { droppingCurrentRules = NO; }
-          break;
-        } else if ([textAsString caseInsensitiveCompare:@"nonretina"] == NSOrderedSame) {
-          if ([UIScreen mainScreen].scale == 1.0) { droppingCurrentRules = NO; }
-          break;
-        } else if ([textAsString caseInsensitiveCompare:@"ipad-retina"] == NSOrderedSame) {
-          if ([UIScreen mainScreen].scale != 1.0 && [UIDevice currentDevice].userInterfaceIdiom == UIUserInterfaceIdiomPad) { droppingCurrentRules = NO; }
-          break;
-        } else if ([textAsString caseInsensitiveCompare:@"ipad-nonretina"] == NSOrderedSame) {
-          if ([UIScreen mainScreen].scale == 1.0 && [UIDevice currentDevice].userInterfaceIdiom == UIUserInterfaceIdiomPad) { droppingCurrentRules = NO; }
-          break;
-        } else if ([textAsString caseInsensitiveCompare:@"iphone-retina"] == NSOrderedSame) {
-          if ([UIScreen mainScreen].scale != 1.0 && [UIDevice currentDevice].userInterfaceIdiom == UIUserInterfaceIdiomPhone) { droppingCurrentRules = NO; }
-          break;
-        } else if ([textAsString caseInsensitiveCompare:@"iphone-nonretina"] == NSOrderedSame) {
-          if ([UIScreen mainScreen].scale == 1.0 && [UIDevice currentDevice].userInterfaceIdiom == UIUserInterfaceIdiomPhone) { droppingCurrentRules = NO; }
-          break;
-        }
+        _mediaOrientations |= NICSSMediaOrientationsForType(lowercaseTextAsString);
+        droppingCurrentRules = (0 == _mediaOrientations);
+        break;
       }
       else if (_state.Flags.InsideRuleset) {
         NIDASSERT(nil != _mutatingRuleset);
@@ -253,10 +334,17 @@ int cssConsume(char* text, int token) {
           if (_state.Flags.InsideMedia && !_mutatingRuleset) {
             // End of a media tag
             _state.Flags.InsideMedia = NO;
+            _mediaOrientations = 0;
             droppingCurrentRules = NO;
           } else {
             if (!droppingCurrentRules) {
-              for (NSString* name in _scopesForActiveRuleset) {
+              for (NSString* scope in _scopesForActiveRuleset) {
+                NSString* name = scope;
+                if (_mediaOrientations == NICSSMediaOrientationPortrait) {
+                  name = [kPortraitMediaScopePrefix stringByAppendingString:scope];
+                } else if (_mediaOrientations == NICSSMediaOrientationLandscape) {
+                  name = [kLandscapeMediaScopePrefix stringByAppendingString:scope];
+                }
                 NSMutableDictionary* existingProperties = [_rulesets objectForKey:name];
                 
                 if (nil == existingProperties) {
@@ -331,17 +419,87 @@ int cssConsume(char* text, int token) {
   _scopesForActiveRuleset = [[NSMutableArray alloc] init];
   _mutatingScope = [[NSMutableArray alloc] init];
   _importedFilenames = [[NSMutableArray alloc] init];
+  _stringsForTokenText = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, &kNICSSTokenTextKeyCallBacks,
+                                                   &kCFTypeDictionaryValueCallBacks);
+  _lowercaseStringsForTokenText = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, &kNICSSTokenTextKeyCallBacks,
+                                                            &kCFTypeDictionaryValueCallBacks);
+}
+
+// flex scans a buffer in place and requires it to end with two NUL bytes.
+static const size_t kScanBufferSentinelLength = 2;
+
+// Lexes the first length bytes of bytes. The two bytes following them must be NUL.
+- (void)parseBytes:(char *)bytes length:(size_t)length {
+  // Each parse owns its scanner, so any number of files may be lexed at once.
+  yyscan_t scanner = NULL;
+  if (0 != csslex_init_extra((__bridge void *)self, &scanner)) {
+    [self setFailFlag];
+    return;
+  }
+  if (NULL == css_scan_buffer(bytes, length + kScanBufferSentinelLength, scanner)) {
+    [self setFailFlag];
+  } else {
+    NI_SIGNPOST_BEGIN(NISignpostCategoryCSS, "Parse", bytes, "%zu bytes", length);
+    csslex(scanner);
+    NI_SIGNPOST_END(NISignpostCategoryCSS, "Parse", bytes);
+  }
+  csslex_destroy(scanner);
+}
+
+- (void)parseData:(NSData *)data {
+  // The scanner writes into its buffer, so it gets a private, NUL-terminated copy.
+  size_t length = [data length];
+  char* bytes = malloc(length + kScanBufferSentinelLength);
+  if (NULL == bytes) {
+    [self setFailFlag];
+    return;
+  }
+  [data getBytes:bytes length:length];
+  memset(bytes + length, 0, kScanBufferSentinelLength);
+  [self parseBytes:bytes length:length];
+  free(bytes);
 }
 
 - (void)parseFileAtPath:(NSString *)path {
-  // flex is not thread-safe so we force it to be by creating a single-access lock here.
-  pthread_mutex_lock(&gMutex); {
-    cssin = fopen([path UTF8String], "r");
-    gActiveParser = self;
-    csslex();
-    fclose(cssin);
+  int fd = open([path fileSystemRepresentation], O_RDONLY);
+  if (fd < 0) {
+    [self setFailFlag];
+    return;
+  }
+
+  struct stat fileStat;
+  if (0 != fstat(fd, &fileStat)) {
+    close(fd);
+    [self setFailFlag];
+    return;
+  }
+
+  // A private mapping is copy-on-write, and the bytes between the end of the file and the end
+  // of its last page read as zero, so whenever those bytes have room for the sentinel the file
+  // can be scanned straight out of the page cache.
+  size_t length = (size_t)fileStat.st_size;
+  size_t pageSize = (size_t)getpagesize();
+  size_t tailLength = length % pageSize;
+  if (length > 0 && tailLength > 0 && pageSize - tailLength >= kScanBufferSentinelLength) {
+    void* mapping = mmap(NULL, length + kScanBufferSentinelLength, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == mapping) {
+      [self setFailFlag];
+      return;
+    }
+    [self parseBytes:mapping length:length];
+    munmap(mapping, length + kScanBufferSentinelLength);
+    return;
+  }
+  close(fd);
+
+  NSData* data = [[NSData alloc] initWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nil];
+  if (nil == data) {
+    [self setFailFlag];
+    return;
   }
-  pthread_mutex_unlock(&gMutex);
+  [self parseData:data];
 }
 
 - (NSDictionary *)mergeCompositeRulesets:(NSMutableArray *)compositeRulesets dependencyFilenames:(NSSet *)dependencyFilenames {
@@ -402,6 +560,118 @@ int cssConsume(char* text, int token) {
   return result;
 }
 
+// Parses the given file on a background queue and then, as soon as its imports are known,
+// schedules each of them in turn. Parsers are recorded by filename; files that don't exist are
+// recorded as NSNull.
+- (void)scheduleParseOfFilename:(NSString *)filename
+              parsersByFilename:(NSMutableDictionary *)parsersByFilename
+                          group:(dispatch_group_t)group
+                     pathPrefix:(NSString *)pathPrefix
+                       delegate:(id<NICSSParserDelegate>)delegate {
+  NICSSParser* parser = [[[self class] alloc] init];
+  @synchronized(parsersByFilename) {
+    // Each file is parsed at most once, which also breaks import cycles.
+    if (nil != [parsersByFilename objectForKey:filename]) {
+      return;
+    }
+    [parsersByFilename setObject:parser forKey:filename];
+  }
+
+  dispatch_group_async(group, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    NSString* path = filename;
+
+    // Allow the delegate to rename the file.
+    if ([delegate respondsToSelector:@selector(cssParser:pathFromPath:)]) {
+      NSString* reprocessedFilename = [delegate cssParser:self pathFromPath:path];
+      if (nil != reprocessedFilename) {
+        path = reprocessedFilename;
+      }
+    }
+
+    // Add the prefix, if it exists.
+    if (pathPrefix.length > 0) {
+      path = [pathPrefix stringByAppendingPathComponent:path];
+    }
+
+    // Verify that the file exists.
+    if (![[NSFileManager defaultManager] fileExistsAtPath:path]) {
+      @synchronized(parsersByFilename) {
+        [parsersByFilename setObject:[NSNull null] forKey:filename];
+      }
+      return;
+    }
+
+    [parser setup];
+    [parser parseFileAtPath:path];
+    if (parser.didFailToParse) {
+      return;
+    }
+    for (NSString* importedFilename in parser->_importedFilenames) {
+      [self scheduleParseOfFilename:importedFilename
+                  parsersByFilename:parsersByFilename
+                              group:group
+                         pathPrefix:pathPrefix
+                           delegate:delegate];
+    }
+  });
+}
+
+// Parses the given files and everything that they import, appending the rulesets to
+// compositeRulesets in cascade order. Returns NO if any of the files could not be parsed.
+- (BOOL)parseImportGraphOfFilenames:(NSArray *)filenames
+                  compositeRulesets:(NSMutableArray *)compositeRulesets
+                 processedFilenames:(NSMutableSet *)processedFilenames
+                         pathPrefix:(NSString *)pathPrefix
+                           delegate:(id<NICSSParserDelegate>)delegate {
+  // Resolve and parse the whole import graph first. Every file is lexed by its own parser as soon
+  // as the file importing it has been lexed, so independent imports are parsed concurrently.
+  NSMutableDictionary* parsersByFilename = [NSMutableDictionary dictionary];
+  dispatch_group_t group = dispatch_group_create();
+  for (NSString* filename in filenames) {
+    [self scheduleParseOfFilename:filename
+                parsersByFilename:parsersByFilename
+                            group:group
+                       pathPrefix:pathPrefix
+                         delegate:delegate];
+  }
+  dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+
+  // Then walk the graph breadth-first in import order, which is the order in which the files
+  // would have been read one after another.
+  NSMutableOrderedSet* filenameQueue = [NSMutableOrderedSet orderedSetWithArray:filenames];
+
+  while ([filenameQueue count] > 0) {
+    // Om nom nom
+    NSString* filename = [filenameQueue firstObject];
+    [filenameQueue removeObjectAtIndex:0];
+
+    // Skip files that we've already processed in order to avoid infinite loops.
+    if ([processedFilenames containsObject:filename]) {
+      continue;
+    }
+    [processedFilenames addObject:filename];
+
+    id parser = [parsersByFilename objectForKey:filename];
+    if ([parser isKindOfClass:[NSNull class]]) {
+      return NO;
+    }
+    if ([parser didFailToParse]) {
+      _didFailToParse = YES;
+      return NO;
+    }
+
+    [filenameQueue addObjectsFromArray:((NICSSParser *)parser)->_importedFilenames];
+    [compositeRulesets addObject:((NICSSParser *)parser)->_rulesets];
+  }
+
+  for (id parser in [parsersByFilename allValues]) {
+    if ([parser isKindOfClass:[NICSSParser class]]) {
+      [parser shutdown];
+    }
+  }
+  return YES;
+}
+
 #pragma mark - Public
 
 
@@ -431,62 +701,69 @@ int cssConsume(char* text, int token) {
   // 2) To collect a list of dependencies for this stylesheet.
   NSMutableSet* processedFilenames = [[NSMutableSet alloc] init];
 
-  // Imported CSS files will be added to the queue.
-  NSMutableOrderedSet* filenameQueue = [NSMutableOrderedSet orderedSet];
-  [filenameQueue addObject:aPath];
-
-  while ([filenameQueue count] > 0) {
-    // Om nom nom
-    NSString* path = [filenameQueue firstObject];
-    [filenameQueue removeObjectAtIndex:0];
+  NSDictionary* result = nil;
 
-    // Skip files that we've already processed in order to avoid infinite loops.
-    if ([processedFilenames containsObject:path]) {
-      continue;
-    }
-    [processedFilenames addObject:path];
+  if ([self parseImportGraphOfFilenames:[NSArray arrayWithObject:aPath]
+                      compositeRulesets:compositeRulesets
+                     processedFilenames:processedFilenames
+                             pathPrefix:pathPrefix
+                               delegate:delegate]) {
+    // processedFilenames will be the set of dependencies, so remove the initial path.
+    [processedFilenames removeObject:aPath];
 
-    // Allow the delegate to rename the file.
-    if ([delegate respondsToSelector:@selector(cssParser:pathFromPath:)]) {
-      NSString* reprocessedFilename = [delegate cssParser:self pathFromPath:path];
-      if (nil != reprocessedFilename) {
-        path = reprocessedFilename;
-      }
-    }
+    result = [self mergeCompositeRulesets:compositeRulesets
+                      dependencyFilenames:processedFilenames];
+  }
 
-    // Add the prefix, if it exists.
-    if (pathPrefix.length > 0) {
-      path = [pathPrefix stringByAppendingPathComponent:path];
-    }
+  [self shutdown];
 
-    // Verify that the file exists.
-    if (![[NSFileManager defaultManager] fileExistsAtPath:path]) {
-      [self shutdown];
-      return nil;
-    }
+  return result;
+}
 
-    [self setup];
-    [self parseFileAtPath:path];
-    if (self.didFailToParse) {
-      break;
-    }
+- (NSDictionary *)dictionaryForData:(NSData *)data {
+  return [self dictionaryForData:data pathPrefix:nil delegate:nil];
+}
 
-    [filenameQueue addObjectsFromArray:_importedFilenames];
-    [_importedFilenames removeAllObjects];
+- (NSDictionary *)dictionaryForData:(NSData *)data pathPrefix:(NSString *)pathPrefix {
+  return [self dictionaryForData:data pathPrefix:pathPrefix delegate:nil];
+}
 
-    [compositeRulesets addObject:_rulesets];
-    [self shutdown];
+- (NSDictionary *)dictionaryForData:(NSData *)data
+                         pathPrefix:(NSString *)pathPrefix
+                           delegate:(id<NICSSParserDelegate>)delegate {
+  if (nil == data) {
+    _didFailToParse = YES;
+    return nil;
   }
 
+  _didFailToParse = NO;
+
+  NSMutableArray* compositeRulesets = [[NSMutableArray alloc] init];
+  NSMutableSet* processedFilenames = [[NSMutableSet alloc] init];
+
   NSDictionary* result = nil;
 
-  if (!self.didFailToParse) {
-    // processedFilenames will be the set of dependencies, so remove the initial path.
-    [processedFilenames removeObject:aPath];
+  NICSSParser* parser = [[[self class] alloc] init];
+  [parser setup];
+  [parser parseData:data];
 
-    result = [self mergeCompositeRulesets:compositeRulesets
-                      dependencyFilenames:processedFilenames];
+  if (parser.didFailToParse) {
+    _didFailToParse = YES;
 
+  } else {
+    NSArray* imports = [parser->_importedFilenames copy];
+    [compositeRulesets addObject:parser->_rulesets];
+    [parser shutdown];
+
+    // Every imported file is a dependency; the data itself has no path.
+    if ([self parseImportGraphOfFilenames:imports
+                        compositeRulesets:compositeRulesets
+                       processedFilenames:processedFilenames
+                               pathPrefix:pathPrefix
+                                 delegate:delegate]) {
+      result = [self mergeCompositeRulesets:compositeRulesets
+                        dependencyFilenames:processedFilenames];
+    }
   }
 
   [self shutdown];
@@ -35,6 +35,64 @@ typedef struct {
 	CGFloat value;
 } NICSSUnit;
 
+/**
+ * The typed properties of a ruleset, in the order of their presence bits.
+ */
+typedef enum {
+  NICSSRulesetPropertyTextColor,
+  NICSSRulesetPropertyHighlightedTextColor,
+  NICSSRulesetPropertyTextAlignment,
+  NICSSRulesetPropertyFont,
+  NICSSRulesetPropertyTextShadowColor,
+  NICSSRulesetPropertyTextShadowOffset,
+  NICSSRulesetPropertyLineBreakMode,
+  NICSSRulesetPropertyNumberOfLines,
+  NICSSRulesetPropertyMinimumFontSize,
+  NICSSRulesetPropertyAdjustsFontSize,
+  NICSSRulesetPropertyBaselineAdjustment,
+  NICSSRulesetPropertyOpacity,
+  NICSSRulesetPropertyBackgroundColor,
+  NICSSRulesetPropertyBackgroundImage,
+  NICSSRulesetPropertyBackgroundStretchInsets,
+  NICSSRulesetPropertyImage,
+  NICSSRulesetPropertyBorderRadius,
+  NICSSRulesetPropertyBorderColor,
+  NICSSRulesetPropertyBorderWidth,
+  NICSSRulesetPropertyTintColor,
+  NICSSRulesetPropertyActivityIndicatorStyle,
+  NICSSRulesetPropertyAutoresizing,
+  NICSSRulesetPropertyTableViewCellSeparatorStyle,
+  NICSSRulesetPropertyScrollViewIndicatorStyle,
+  NICSSRulesetPropertyVerticalAlign,
+  NICSSRulesetPropertyHorizontalAlign,
+  NICSSRulesetPropertyWidth,
+  NICSSRulesetPropertyHeight,
+  NICSSRulesetPropertyTop,
+  NICSSRulesetPropertyBottom,
+  NICSSRulesetPropertyLeft,
+  NICSSRulesetPropertyRight,
+  NICSSRulesetPropertyFrameHorizontalAlign,
+  NICSSRulesetPropertyFrameVerticalAlign,
+  NICSSRulesetPropertyVisible,
+  NICSSRulesetPropertyTitleInsets,
+  NICSSRulesetPropertyContentInsets,
+  NICSSRulesetPropertyImageInsets,
+  NICSSRulesetPropertyRelativeToId,
+  NICSSRulesetPropertyMarginTop,
+  NICSSRulesetPropertyMarginLeft,
+  NICSSRulesetPropertyMarginRight,
+  NICSSRulesetPropertyMarginBottom,
+  NICSSRulesetPropertyMinWidth,
+  NICSSRulesetPropertyMinHeight,
+  NICSSRulesetPropertyMaxWidth,
+  NICSSRulesetPropertyMaxHeight,
+  NICSSRulesetPropertyTextKey,
+  NICSSRulesetPropertyButtonAdjust,
+  NICSSRulesetPropertyHorizontalPadding,
+  NICSSRulesetPropertyVerticalPadding,
+  NICSSRulesetPropertyCount
+} NICSSRulesetProperty;
+
 typedef enum {
   NICSSButtonAdjustNone = 0,
   NICSSButtonAdjustHighlighted = 1,
@@ -49,10 +107,16 @@ typedef enum {
  * Objective-C values are created on-demand and cached. These ruleset objects are cached
  * by NIStylesheet for a given CSS scope. When a memory warning is received, all ruleset objects
  * are removed from every stylesheet.
+ *
+ * Which properties are present is recorded as a bit per NICSSRulesetProperty when entries are
+ * added, so the has* methods never touch the raw CSS. NIStylesheet compiles every ruleset it
+ * hands out, so the views sharing a ruleset only ever read typed values.
  */
 @interface NICSSRuleset : NSObject {
 @private
   NSMutableDictionary* _ruleset;
+  uint64_t _present;
+  BOOL _isCompiled;
   
   UIColor* _textColor;
   UIColor* _highlightedTextColor;
@@ -103,6 +167,8 @@ typedef enum {
   NICSSUnit _minWidth;
   NICSSUnit _maxHeight;
   NICSSUnit _maxWidth;
+  NICSSUnit _horizontalPadding;
+  NICSSUnit _verticalPadding;
   
   union {
     struct {
@@ -168,6 +234,11 @@ typedef enum {
 - (void)addEntriesFromDictionary:(NSDictionary *)dictionary;
 - (id)cssRuleForKey: (NSString*)key;
 
+- (BOOL)hasProperty:(NICSSRulesetProperty)property;
+- (void)compile;
+
++ (NSString *)propertyNameForName:(NSString *)name;
+
 - (BOOL)hasTextColor;
 - (UIColor *)textColor; // color
 
@@ -328,6 +399,40 @@ typedef enum {
  * @fn NICSSRuleset::addEntriesFromDictionary:
  */
 
+/**
+ * Returns YES if the ruleset defines the given property.
+ *
+ * This is a single bit test; the has* methods are shorthands for it.
+ *
+ * @fn NICSSRuleset::hasProperty:
+ */
+
+/**
+ * Parses every property the ruleset defines into its typed value.
+ *
+ * Values are otherwise parsed on first access. Compiling up front means that a ruleset shared
+ * by many views is parsed exactly once, before any of them is styled, and is only read from then
+ * on. Adding entries to the ruleset discards the compiled values.
+ *
+ * A compiled ruleset is only ever read, so it can be shared across threads, such as with code
+ * that sizes cells on a background queue. Its values are kept under memory pressure, when
+ * NIStylesheet releases the ruleset instead.
+ *
+ * @fn NICSSRuleset::compile
+ */
+
+/**
+ * Returns the string that rulesets look the given lowercase property name up with, or nil if
+ * rulesets don't know the property.
+ *
+ * NICSSParser keys the rulesets it builds with these strings, so that every ruleset shares one
+ * copy of each property name and looking a property up compares pointers.
+ *
+ * This method may be called from any thread.
+ *
+ * @fn NICSSRuleset::propertyNameForName:
+ */
+
 /**
  * Returns YES if the ruleset has a 'color' property.
  *
@@ -57,6 +57,18 @@ static NSString* const kVPaddingKey = @"-mobile-vpadding";
 // This color table is generated on-demand and is released when a memory warning is encountered.
 static NSDictionary* sColorTable = nil;
 
+// Fonts and colors are interned for every ruleset, so that identical styles share one object and
+// resolving a value that has been seen before is a lookup. Both are released under critical
+// memory pressure along with the color table.
+static NSMutableDictionary* sInternedFonts = nil; // Family, or @"" for the system font => key => font
+static NSMutableDictionary* sInternedColors = nil; // Packed RGBA => color
+
+static NSDictionary* NICSSRulesetKeyToProperties(void);
+static uint64_t NICSSRulesetPropertiesForKey(NSString* key);
+static UIFont* NICSSInternedFont(NSString* fontName, CGFloat fontSize, BOOL isBold, BOOL isItalic);
+static UIColor* NICSSInternedColor(CGFloat red, CGFloat green, CGFloat blue, CGFloat alpha);
+static void NICSSPurgeInternedValues(void);
+
 @interface NICSSRuleset()
 // Instantiates the color table if it does not already exist.
 + (NSDictionary *)colorTable;
@@ -69,7 +81,7 @@ static NSDictionary* sColorTable = nil;
 #define RULE_ELEMENT(name,Name,cssKey,type,converter) \
 static NSString* const k ## Name ## Key = cssKey; \
 -(BOOL)has ## Name { \
-return nil != [_ruleset objectForKey: k ## Name ## Key]; \
+return [self hasProperty:NICSSRulesetProperty ## Name]; \
 } \
 -(type)name { \
 NIDASSERT([self has ## Name]); \
@@ -82,6 +94,19 @@ return _##name; \
 
 @implementation NICSSRuleset
 
++ (void)initialize {
+  if ([NICSSRuleset class] != self) {
+    return;
+  }
+  // Rule sets are created while a stylesheet loads, but colors are only looked up when styles
+  // are applied, so the color table can usually be built in between, while the app is idle.
+  dispatch_async(dispatch_get_main_queue(), ^{
+    NIScheduleDeferredInitialization(@"NICSSRuleset color table", ^{
+      [NICSSRuleset colorTable];
+    });
+  });
+}
+
 
 - (void)dealloc {
   [[NSNotificationCenter defaultCenter] removeObserver:self];
@@ -91,11 +116,8 @@ return _##name; \
   if ((self = [super init])) {
     _ruleset = [[NSMutableDictionary alloc] init];
 
-    NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
-    [nc addObserver: self
-           selector: @selector(didReceiveMemoryWarning:)
-               name: UIApplicationDidReceiveMemoryWarningNotification
-             object: nil];
+    [[NIMemoryPressureCoordinator sharedCoordinator] addObserver:self
+                                                         selector:@selector(didReceiveMemoryPressure:)];
   }
   return self;
 }
@@ -107,6 +129,14 @@ return _##name; \
   NSMutableArray* order = [_ruleset objectForKey:kPropertyOrderKey];
   [_ruleset addEntriesFromDictionary:dictionary];
 
+  for (NSString* key in dictionary) {
+    _present |= NICSSRulesetPropertiesForKey(key);
+  }
+
+  // The new entries may override values that have already been parsed.
+  memset(&_is, 0, sizeof(_is));
+  _isCompiled = NO;
+
   if (nil != order) {
     [order addObjectsFromArray:[dictionary objectForKey:kPropertyOrderKey]];
     [_ruleset setObject:order forKey:kPropertyOrderKey];
@@ -118,8 +148,82 @@ return _##name; \
     return [_ruleset objectForKey:key];
 }
 
+- (BOOL)hasProperty:(NICSSRulesetProperty)property {
+  return 0 != (_present & (1ULL << property));
+}
+
++ (NSString *)propertyNameForName:(NSString *)name {
+  static NSSet* sPropertyNames = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sPropertyNames = [[NSSet alloc] initWithArray:[NICSSRulesetKeyToProperties() allKeys]];
+  });
+  return [sPropertyNames member:name];
+}
+
+// Reads every present property once so that its typed value is cached.
+#define COMPILE_ELEMENT(name,Name) \
+if ([self has ## Name]) { \
+[self name]; \
+}
+
+- (void)compile {
+  COMPILE_ELEMENT(textColor, TextColor)
+  COMPILE_ELEMENT(highlightedTextColor, HighlightedTextColor)
+  COMPILE_ELEMENT(textAlignment, TextAlignment)
+  COMPILE_ELEMENT(font, Font)
+  COMPILE_ELEMENT(textShadowColor, TextShadowColor)
+  COMPILE_ELEMENT(textShadowOffset, TextShadowOffset)
+  COMPILE_ELEMENT(lineBreakMode, LineBreakMode)
+  COMPILE_ELEMENT(numberOfLines, NumberOfLines)
+  COMPILE_ELEMENT(minimumFontSize, MinimumFontSize)
+  COMPILE_ELEMENT(adjustsFontSize, AdjustsFontSize)
+  COMPILE_ELEMENT(baselineAdjustment, BaselineAdjustment)
+  COMPILE_ELEMENT(opacity, Opacity)
+  COMPILE_ELEMENT(backgroundColor, BackgroundColor)
+  COMPILE_ELEMENT(backgroundImage, BackgroundImage)
+  COMPILE_ELEMENT(backgroundStretchInsets, BackgroundStretchInsets)
+  COMPILE_ELEMENT(image, Image)
+  COMPILE_ELEMENT(borderRadius, BorderRadius)
+  COMPILE_ELEMENT(borderColor, BorderColor)
+  COMPILE_ELEMENT(borderWidth, BorderWidth)
+  COMPILE_ELEMENT(tintColor, TintColor)
+  COMPILE_ELEMENT(activityIndicatorStyle, ActivityIndicatorStyle)
+  COMPILE_ELEMENT(autoresizing, Autoresizing)
+  COMPILE_ELEMENT(tableViewCellSeparatorStyle, TableViewCellSeparatorStyle)
+  COMPILE_ELEMENT(scrollViewIndicatorStyle, ScrollViewIndicatorStyle)
+  COMPILE_ELEMENT(verticalAlign, VerticalAlign)
+  COMPILE_ELEMENT(horizontalAlign, HorizontalAlign)
+  COMPILE_ELEMENT(width, Width)
+  COMPILE_ELEMENT(height, Height)
+  COMPILE_ELEMENT(top, Top)
+  COMPILE_ELEMENT(bottom, Bottom)
+  COMPILE_ELEMENT(left, Left)
+  COMPILE_ELEMENT(right, Right)
+  COMPILE_ELEMENT(frameHorizontalAlign, FrameHorizontalAlign)
+  COMPILE_ELEMENT(frameVerticalAlign, FrameVerticalAlign)
+  COMPILE_ELEMENT(visible, Visible)
+  COMPILE_ELEMENT(titleInsets, TitleInsets)
+  COMPILE_ELEMENT(contentInsets, ContentInsets)
+  COMPILE_ELEMENT(imageInsets, ImageInsets)
+  COMPILE_ELEMENT(relativeToId, RelativeToId)
+  COMPILE_ELEMENT(marginTop, MarginTop)
+  COMPILE_ELEMENT(marginLeft, MarginLeft)
+  COMPILE_ELEMENT(marginRight, MarginRight)
+  COMPILE_ELEMENT(marginBottom, MarginBottom)
+  COMPILE_ELEMENT(minWidth, MinWidth)
+  COMPILE_ELEMENT(minHeight, MinHeight)
+  COMPILE_ELEMENT(maxWidth, MaxWidth)
+  COMPILE_ELEMENT(maxHeight, MaxHeight)
+  COMPILE_ELEMENT(textKey, TextKey)
+  COMPILE_ELEMENT(buttonAdjust, ButtonAdjust)
+  COMPILE_ELEMENT(horizontalPadding, HorizontalPadding)
+  COMPILE_ELEMENT(verticalPadding, VerticalPadding)
+  _isCompiled = YES;
+}
+
 - (BOOL)hasTextColor {
-  return nil != [_ruleset objectForKey:kTextColorKey];
+  return [self hasProperty:NICSSRulesetPropertyTextColor];
 }
 
 - (UIColor *)textColor {
@@ -133,7 +237,7 @@ return _##name; \
 }
 
 - (BOOL)hasHighlightedTextColor {
-    return nil != [_ruleset objectForKey:kHighlightedTextColorKey];
+  return [self hasProperty:NICSSRulesetPropertyHighlightedTextColor];
 }
 
 - (UIColor *)highlightedTextColor {
@@ -147,7 +251,7 @@ return _##name; \
 }
 
 - (BOOL)hasTextAlignment {
-  return nil != [_ruleset objectForKey:kTextAlignmentKey];
+  return [self hasProperty:NICSSRulesetPropertyTextAlignment];
 }
 
 - (NSTextAlignment)textAlignment {
@@ -160,11 +264,19 @@ return _##name; \
 }
 
 -(BOOL)hasHorizontalPadding {
-  return nil != [_ruleset objectForKey:kPaddingKey] || nil != [_ruleset objectForKey:kHPaddingKey];
+  return [self hasProperty:NICSSRulesetPropertyHorizontalPadding];
 }
 
 -(NICSSUnit)horizontalPadding {
   NIDASSERT([self hasHorizontalPadding]);
+  if (!_is.cached.HorizontalPadding) {
+    _horizontalPadding = [self horizontalPaddingFromCssValues];
+    _is.cached.HorizontalPadding = YES;
+  }
+  return _horizontalPadding;
+}
+
+- (NICSSUnit)horizontalPaddingFromCssValues {
   NSArray *css = [_ruleset objectForKey:kHPaddingKey];
   if (css && css.count > 0) {
     return [NICSSRuleset unitFromCssValues:css];
@@ -185,11 +297,19 @@ return _##name; \
 }
 
 -(BOOL)hasVerticalPadding {
-  return nil != [_ruleset objectForKey:kPaddingKey] || nil != [_ruleset objectForKey:kVPaddingKey];
+  return [self hasProperty:NICSSRulesetPropertyVerticalPadding];
 }
 
 -(NICSSUnit)verticalPadding {
   NIDASSERT([self hasVerticalPadding]);
+  if (!_is.cached.VerticalPadding) {
+    _verticalPadding = [self verticalPaddingFromCssValues];
+    _is.cached.VerticalPadding = YES;
+  }
+  return _verticalPadding;
+}
+
+- (NICSSUnit)verticalPaddingFromCssValues {
   NSArray *css = [_ruleset objectForKey:kVPaddingKey];
   if (css && css.count > 0) {
     return [NICSSRuleset unitFromCssValues:css];
@@ -207,11 +327,7 @@ return _##name; \
 }
 
 - (BOOL)hasFont {
-  return (nil != [_ruleset objectForKey:kFontKey]
-          || nil != [_ruleset objectForKey:kFontSizeKey]
-          || nil != [_ruleset objectForKey:kFontWeightKey]
-          || nil != [_ruleset objectForKey:kFontStyleKey]
-          || nil != [_ruleset objectForKey:kFontFamilyKey]);
+  return [self hasProperty:NICSSRulesetPropertyFont];
 }
 
 - (UIFont *)font {
@@ -288,28 +404,10 @@ return _##name; \
     }
   }
   
-  UIFont* font = nil;
-  if (hasSetFontName) {
-    // If you wish to set the weight and style for a non-standard font family then you will need
-    // to set the font family to the given style manually.
-    NIDASSERT(!fontIsItalic && !fontIsBold);
-    font = [UIFont fontWithName:fontName size:fontSize];
-
-  } else if (fontIsItalic && fontIsBold) {
-    // There is no easy way to create a bold italic font using the exposed UIFont methods.
-    // Please consider using the exact font name instead. E.g. font-name: Helvetica-BoldObliquei
-    NIDASSERT(!(fontIsItalic && fontIsBold));
-    font = [UIFont systemFontOfSize:fontSize];
-
-  } else if (fontIsItalic) {
-    font = [UIFont italicSystemFontOfSize:fontSize];
-
-  } else if (fontIsBold) {
-    font = [UIFont boldSystemFontOfSize:fontSize];
-
-  } else {
-    font = [UIFont systemFontOfSize:fontSize];
-  }
+  // If you wish to set the weight and style for a non-standard font family then you will need
+  // to set the font family to the given style manually.
+  NIDASSERT(!hasSetFontName || (!fontIsItalic && !fontIsBold));
+  UIFont* font = NICSSInternedFont(hasSetFontName ? fontName : nil, fontSize, fontIsBold, fontIsItalic);
 
   _font = font;
   _is.cached.Font = YES;
@@ -318,7 +416,7 @@ return _##name; \
 }
 
 - (BOOL)hasTextShadowColor {
-  return nil != [_ruleset objectForKey:kTextShadowKey];
+  return [self hasProperty:NICSSRulesetPropertyTextShadowColor];
 }
 
 - (UIColor *)textShadowColor {
@@ -332,7 +430,7 @@ return _##name; \
 }
 
 - (BOOL)hasTextShadowOffset {
-  return nil != [_ruleset objectForKey:kTextShadowKey];
+  return [self hasProperty:NICSSRulesetPropertyTextShadowOffset];
 }
 
 - (CGSize)textShadowOffset {
@@ -355,7 +453,7 @@ return _##name; \
 }
 
 - (BOOL)hasLineBreakMode {
-  return nil != [_ruleset objectForKey:kLineBreakModeKey];
+  return [self hasProperty:NICSSRulesetPropertyLineBreakMode];
 }
 
 - (NSLineBreakMode)lineBreakMode {
@@ -385,7 +483,7 @@ return _##name; \
 }
 
 - (BOOL)hasNumberOfLines {
-  return nil != [_ruleset objectForKey:kNumberOfLinesKey];
+  return [self hasProperty:NICSSRulesetPropertyNumberOfLines];
 }
 
 - (NSInteger)numberOfLines {
@@ -400,7 +498,7 @@ return _##name; \
 }
 
 - (BOOL)hasMinimumFontSize {
-  return nil != [_ruleset objectForKey:kMinimumFontSizeKey];
+  return [self hasProperty:NICSSRulesetPropertyMinimumFontSize];
 }
 
 - (CGFloat)minimumFontSize {
@@ -415,7 +513,7 @@ return _##name; \
 }
 
 - (BOOL)hasAdjustsFontSize {
-  return nil != [_ruleset objectForKey:kAdjustsFontSizeKey];
+  return [self hasProperty:NICSSRulesetPropertyAdjustsFontSize];
 }
 
 - (BOOL)adjustsFontSize {
@@ -430,7 +528,7 @@ return _##name; \
 }
 
 - (BOOL)hasBaselineAdjustment {
-  return nil != [_ruleset objectForKey:kBaselineAdjustmentKey];
+  return [self hasProperty:NICSSRulesetPropertyBaselineAdjustment];
 }
 
 - (UIBaselineAdjustment)baselineAdjustment {
@@ -452,7 +550,7 @@ return _##name; \
 }
 
 - (BOOL)hasOpacity {
-  return nil != [_ruleset objectForKey:kOpacityKey];
+  return [self hasProperty:NICSSRulesetPropertyOpacity];
 }
 
 - (CGFloat)opacity {
@@ -467,7 +565,7 @@ return _##name; \
 }
 
 - (BOOL)hasBackgroundColor {
-  return nil != [_ruleset objectForKey:kBackgroundColorKey];
+  return [self hasProperty:NICSSRulesetPropertyBackgroundColor];
 }
 
 - (UIColor *)backgroundColor {
@@ -481,7 +579,7 @@ return _##name; \
 }
 
 - (BOOL)hasBorderRadius {
-  return nil != [_ruleset objectForKey:kBorderRadiusKey];
+  return [self hasProperty:NICSSRulesetPropertyBorderRadius];
 }
 
 - (CGFloat)borderRadius {
@@ -496,8 +594,7 @@ return _##name; \
 }
 
 - (BOOL)hasBorderColor {
-  return (nil != [_ruleset objectForKey:kBorderColorKey]
-          || nil != [_ruleset objectForKey:kBorderKey]);
+  return [self hasProperty:NICSSRulesetPropertyBorderColor];
 }
 
 - (void)cacheBorderValues {
@@ -548,26 +645,29 @@ return _##name; \
     }
   }
   
-  _is.cached.BorderColor = hasSetBorderColor;
-  _is.cached.BorderWidth = hasSetBorderWidth;
+  _is.cached.BorderColor = YES;
+  _is.cached.BorderWidth = YES;
 }
 
 - (UIColor *)borderColor {
   NIDASSERT([self hasBorderColor]);
 
-  [self cacheBorderValues];
+  if (!_is.cached.BorderColor) {
+    [self cacheBorderValues];
+  }
   return _borderColor;
 }
 
 - (BOOL)hasBorderWidth {
-  return (nil != [_ruleset objectForKey:kBorderWidthKey]
-          || nil != [_ruleset objectForKey:kBorderKey]);
+  return [self hasProperty:NICSSRulesetPropertyBorderWidth];
 }
 
 - (CGFloat)borderWidth {
   NIDASSERT([self hasBorderWidth]);
 
-  [self cacheBorderValues];
+  if (!_is.cached.BorderWidth) {
+    [self cacheBorderValues];
+  }
   return _borderWidth;
 }
 
@@ -601,7 +701,7 @@ RULE_ELEMENT(verticalAlign, VerticalAlign, @"-mobile-content-valign", UIControlC
 RULE_ELEMENT(horizontalAlign, HorizontalAlign, @"-mobile-content-halign", UIControlContentHorizontalAlignment, controlHorizontalAlignFromCssValues)
 
 - (BOOL)hasTintColor {
-  return nil != [_ruleset objectForKey:kTintColorKey];
+  return [self hasProperty:NICSSRulesetPropertyTintColor];
 }
 
 - (UIColor *)tintColor {
@@ -615,7 +715,7 @@ RULE_ELEMENT(horizontalAlign, HorizontalAlign, @"-mobile-content-halign", UICont
 }
 
 - (BOOL)hasActivityIndicatorStyle {
-  return nil != [_ruleset objectForKey:kActivityIndicatorStyleKey];
+  return [self hasProperty:NICSSRulesetPropertyActivityIndicatorStyle];
 }
 
 - (UIActivityIndicatorViewStyle)activityIndicatorStyle {
@@ -637,7 +737,7 @@ RULE_ELEMENT(horizontalAlign, HorizontalAlign, @"-mobile-content-halign", UICont
 }
 
 - (BOOL)hasAutoresizing {
-  return nil != [_ruleset objectForKey:kAutoresizingKey];
+  return [self hasProperty:NICSSRulesetPropertyAutoresizing];
 }
 
 - (UIViewAutoresizing)autoresizing {
@@ -673,7 +773,7 @@ RULE_ELEMENT(horizontalAlign, HorizontalAlign, @"-mobile-content-halign", UICont
 }
 
 - (BOOL)hasTableViewCellSeparatorStyle {
-  return nil != [_ruleset objectForKey:kTableViewCellSeparatorStyleKey];
+  return [self hasProperty:NICSSRulesetPropertyTableViewCellSeparatorStyle];
 }
 
 - (UITableViewCellSeparatorStyle)tableViewCellSeparatorStyle {
@@ -695,7 +795,7 @@ RULE_ELEMENT(horizontalAlign, HorizontalAlign, @"-mobile-content-halign", UICont
 }
 
 - (BOOL)hasScrollViewIndicatorStyle {
-  return nil != [_ruleset objectForKey:kScrollViewIndicatorStyleKey];
+  return [self hasProperty:NICSSRulesetPropertyScrollViewIndicatorStyle];
 }
 
 - (UIScrollViewIndicatorStyle)scrollViewIndicatorStyle {
@@ -721,7 +821,15 @@ RULE_ELEMENT(horizontalAlign, HorizontalAlign, @"-mobile-content-halign", UICont
 
 
 - (void)reduceMemory {
-  sColorTable = nil;
+  @synchronized([NICSSRuleset class]) {
+    sColorTable = nil;
+  }
+  NICSSPurgeInternedValues();
+
+  // Compiled rulesets may be being read on other threads.
+  if (_isCompiled) {
+    return;
+  }
 
   _textColor = nil;
   _font = nil;
@@ -733,220 +841,233 @@ RULE_ELEMENT(horizontalAlign, HorizontalAlign, @"-mobile-content-halign", UICont
   memset(&_is, 0, sizeof(_is));
 }
 
-- (void)didReceiveMemoryWarning:(void*)object {
-  [self reduceMemory];
+- (void)didReceiveMemoryPressure:(NSNotification *)notification {
+  // The parsed values are small and re-parsing them is slow, so hold on to them until the
+  // pressure is critical.
+  if (NIMemoryPressureLevelCritical == NIMemoryPressureLevelFromNotification(notification)) {
+    [self reduceMemory];
+  }
 }
 
 #pragma mark - Color Tables
 
 
 + (NSDictionary *)colorTable {
-  if (nil == sColorTable) {
-    // This color table was generated from http://www.w3.org/TR/css3-color/
-    //
-    // The output was sorted,
-    // > pbpaste | sort | pbcopy
-    //
-    // reformatted using a regex,
-    // ^(.+)\t(.+)\t(.+) => RGBCOLOR($3), @"$1",
-    //
-    // and then uniq'd
-    // > pbpaste | uniq | pbcopy
-    NSMutableDictionary* colorTable =
-    [[NSMutableDictionary alloc] initWithObjectsAndKeys:
-     RGBCOLOR(240,248,255), @"aliceblue",
-     RGBCOLOR(250,235,215), @"antiquewhite",
-     RGBCOLOR(0,255,255), @"aqua",
-     RGBCOLOR(127,255,212), @"aquamarine",
-     RGBCOLOR(240,255,255), @"azure",
-     RGBCOLOR(245,245,220), @"beige",
-     RGBCOLOR(255,228,196), @"bisque",
-     RGBCOLOR(0,0,0), @"black",
-     RGBCOLOR(255,235,205), @"blanchedalmond",
-     RGBCOLOR(0,0,255), @"blue",
-     RGBCOLOR(138,43,226), @"blueviolet",
-     RGBCOLOR(165,42,42), @"brown",
-     RGBCOLOR(222,184,135), @"burlywood",
-     RGBCOLOR(95,158,160), @"cadetblue",
-     RGBCOLOR(127,255,0), @"chartreuse",
-     RGBCOLOR(210,105,30), @"chocolate",
-     RGBCOLOR(255,127,80), @"coral",
-     RGBCOLOR(100,149,237), @"cornflowerblue",
-     RGBCOLOR(255,248,220), @"cornsilk",
-     RGBCOLOR(220,20,60), @"crimson",
-     RGBCOLOR(0,255,255), @"cyan",
-     RGBCOLOR(0,0,139), @"darkblue",
-     RGBCOLOR(0,139,139), @"darkcyan",
-     RGBCOLOR(184,134,11), @"darkgoldenrod",
-     RGBCOLOR(169,169,169), @"darkgray",
-     RGBCOLOR(0,100,0), @"darkgreen",
-     RGBCOLOR(169,169,169), @"darkgrey",
-     RGBCOLOR(189,183,107), @"darkkhaki",
-     RGBCOLOR(139,0,139), @"darkmagenta",
-     RGBCOLOR(85,107,47), @"darkolivegreen",
-     RGBCOLOR(255,140,0), @"darkorange",
-     RGBCOLOR(153,50,204), @"darkorchid",
-     RGBCOLOR(139,0,0), @"darkred",
-     RGBCOLOR(233,150,122), @"darksalmon",
-     RGBCOLOR(143,188,143), @"darkseagreen",
-     RGBCOLOR(72,61,139), @"darkslateblue",
-     RGBCOLOR(47,79,79), @"darkslategray",
-     RGBCOLOR(47,79,79), @"darkslategrey",
-     RGBCOLOR(0,206,209), @"darkturquoise",
-     RGBCOLOR(148,0,211), @"darkviolet",
-     RGBCOLOR(255,20,147), @"deeppink",
-     RGBCOLOR(0,191,255), @"deepskyblue",
-     RGBCOLOR(105,105,105), @"dimgray",
-     RGBCOLOR(105,105,105), @"dimgrey",
-     RGBCOLOR(30,144,255), @"dodgerblue",
-     RGBCOLOR(178,34,34), @"firebrick",
-     RGBCOLOR(255,250,240), @"floralwhite",
-     RGBCOLOR(34,139,34), @"forestgreen",
-     RGBCOLOR(255,0,255), @"fuchsia",
-     RGBCOLOR(220,220,220), @"gainsboro",
-     RGBCOLOR(248,248,255), @"ghostwhite",
-     RGBCOLOR(255,215,0), @"gold",
-     RGBCOLOR(218,165,32), @"goldenrod",
-     RGBCOLOR(128,128,128), @"gray",
-     RGBCOLOR(0,128,0), @"green",
-     RGBCOLOR(173,255,47), @"greenyellow",
-     RGBCOLOR(128,128,128), @"grey",
-     RGBCOLOR(240,255,240), @"honeydew",
-     RGBCOLOR(255,105,180), @"hotpink",
-     RGBCOLOR(205,92,92), @"indianred",
-     RGBCOLOR(75,0,130), @"indigo",
-     RGBCOLOR(255,255,240), @"ivory",
-     RGBCOLOR(240,230,140), @"khaki",
-     RGBCOLOR(230,230,250), @"lavender",
-     RGBCOLOR(255,240,245), @"lavenderblush",
-     RGBCOLOR(124,252,0), @"lawngreen",
-     RGBCOLOR(255,250,205), @"lemonchiffon",
-     RGBCOLOR(173,216,230), @"lightblue",
-     RGBCOLOR(240,128,128), @"lightcoral",
-     RGBCOLOR(224,255,255), @"lightcyan",
-     RGBCOLOR(250,250,210), @"lightgoldenrodyellow",
-     RGBCOLOR(211,211,211), @"lightgray",
-     RGBCOLOR(144,238,144), @"lightgreen",
-     RGBCOLOR(211,211,211), @"lightgrey",
-     RGBCOLOR(255,182,193), @"lightpink",
-     RGBCOLOR(255,160,122), @"lightsalmon",
-     RGBCOLOR(32,178,170), @"lightseagreen",
-     RGBCOLOR(135,206,250), @"lightskyblue",
-     RGBCOLOR(119,136,153), @"lightslategray",
-     RGBCOLOR(119,136,153), @"lightslategrey",
-     RGBCOLOR(176,196,222), @"lightsteelblue",
-     RGBCOLOR(255,255,224), @"lightyellow",
-     RGBCOLOR(0,255,0), @"lime",
-     RGBCOLOR(50,205,50), @"limegreen",
-     RGBCOLOR(250,240,230), @"linen",
-     RGBCOLOR(255,0,255), @"magenta",
-     RGBCOLOR(128,0,0), @"maroon",
-     RGBCOLOR(102,205,170), @"mediumaquamarine",
-     RGBCOLOR(0,0,205), @"mediumblue",
-     RGBCOLOR(186,85,211), @"mediumorchid",
-     RGBCOLOR(147,112,219), @"mediumpurple",
-     RGBCOLOR(60,179,113), @"mediumseagreen",
-     RGBCOLOR(123,104,238), @"mediumslateblue",
-     RGBCOLOR(0,250,154), @"mediumspringgreen",
-     RGBCOLOR(72,209,204), @"mediumturquoise",
-     RGBCOLOR(199,21,133), @"mediumvioletred",
-     RGBCOLOR(25,25,112), @"midnightblue",
-     RGBCOLOR(245,255,250), @"mintcream",
-     RGBCOLOR(255,228,225), @"mistyrose",
-     RGBCOLOR(255,228,181), @"moccasin",
-     RGBCOLOR(255,222,173), @"navajowhite",
-     RGBCOLOR(0,0,128), @"navy",
-     RGBCOLOR(253,245,230), @"oldlace",
-     RGBCOLOR(128,128,0), @"olive",
-     RGBCOLOR(107,142,35), @"olivedrab",
-     RGBCOLOR(255,165,0), @"orange",
-     RGBCOLOR(255,69,0), @"orangered",
-     RGBCOLOR(218,112,214), @"orchid",
-     RGBCOLOR(238,232,170), @"palegoldenrod",
-     RGBCOLOR(152,251,152), @"palegreen",
-     RGBCOLOR(175,238,238), @"paleturquoise",
-     RGBCOLOR(219,112,147), @"palevioletred",
-     RGBCOLOR(255,239,213), @"papayawhip",
-     RGBCOLOR(255,218,185), @"peachpuff",
-     RGBCOLOR(205,133,63), @"peru",
-     RGBCOLOR(255,192,203), @"pink",
-     RGBCOLOR(221,160,221), @"plum",
-     RGBCOLOR(176,224,230), @"powderblue",
-     RGBCOLOR(128,0,128), @"purple",
-     RGBCOLOR(255,0,0), @"red",
-     RGBCOLOR(188,143,143), @"rosybrown",
-     RGBCOLOR(65,105,225), @"royalblue",
-     RGBCOLOR(139,69,19), @"saddlebrown",
-     RGBCOLOR(250,128,114), @"salmon",
-     RGBCOLOR(244,164,96), @"sandybrown",
-     RGBCOLOR(46,139,87), @"seagreen",
-     RGBCOLOR(255,245,238), @"seashell",
-     RGBCOLOR(160,82,45), @"sienna",
-     RGBCOLOR(192,192,192), @"silver",
-     RGBCOLOR(135,206,235), @"skyblue",
-     RGBCOLOR(106,90,205), @"slateblue",
-     RGBCOLOR(112,128,144), @"slategray",
-     RGBCOLOR(112,128,144), @"slategrey",
-     RGBCOLOR(255,250,250), @"snow",
-     RGBCOLOR(0,255,127), @"springgreen",
-     RGBCOLOR(70,130,180), @"steelblue",
-     RGBCOLOR(210,180,140), @"tan",
-     RGBCOLOR(0,128,128), @"teal",
-     RGBCOLOR(216,191,216), @"thistle",
-     RGBCOLOR(255,99,71), @"tomato",
-     RGBCOLOR(64,224,208), @"turquoise",
-     RGBCOLOR(238,130,238), @"violet",
-     RGBCOLOR(245,222,179), @"wheat",
-     RGBCOLOR(255,255,255), @"white",
-     RGBCOLOR(245,245,245), @"whitesmoke",
-     RGBCOLOR(255,255,0), @"yellow",
-     RGBCOLOR(154,205,50), @"yellowgreen",
-     
-     // System colors
-     [UIColor lightTextColor],                @"lightTextColor",
-     [UIColor darkTextColor],                 @"darkTextColor",
-     [UIColor groupTableViewBackgroundColor], @"groupTableViewBackgroundColor",
-     [UIColor viewFlipsideBackgroundColor],   @"viewFlipsideBackgroundColor",
-     nil];
-    
-    if ([UIColor respondsToSelector:@selector(scrollViewTexturedBackgroundColor)]) {
-      // 3.2 and up
-      UIColor* color = [UIColor scrollViewTexturedBackgroundColor];
-      if (nil != color) {
-        [colorTable setObject:color
-                       forKey:@"scrollViewTexturedBackgroundColor"];
-      }
-    }
-    
-    if ([UIColor respondsToSelector:@selector(underPageBackgroundColor)]) {
-      // 5.0 and up
-      UIColor* color = [UIColor underPageBackgroundColor];
-      if (nil != color) {
-        [colorTable setObject:color
-                       forKey:@"underPageBackgroundColor"];
-      }
+  // Rulesets may be compiled on any thread, so the table is guarded like the interned values.
+  @synchronized([NICSSRuleset class]) {
+    if (nil == sColorTable) {
+      NIMeasureFirstUse(@"NICSSRuleset color table", ^{
+        [self buildColorTable];
+      });
     }
+    return sColorTable;
+  }
+}
 
-    // Replace the web colors with their system color equivalents.
-    [colorTable setObject:[UIColor blackColor] forKey:@"black"];
-    [colorTable setObject:[UIColor darkGrayColor] forKey:@"darkGray"];
-    [colorTable setObject:[UIColor lightGrayColor] forKey:@"lightGray"];
-    [colorTable setObject:[UIColor whiteColor] forKey:@"white"];
-    [colorTable setObject:[UIColor grayColor] forKey:@"gray"];
-    [colorTable setObject:[UIColor redColor] forKey:@"red"];
-    [colorTable setObject:[UIColor greenColor] forKey:@"green"];
-    [colorTable setObject:[UIColor blueColor] forKey:@"blue"];
-    [colorTable setObject:[UIColor cyanColor] forKey:@"cyan"];
-    [colorTable setObject:[UIColor yellowColor] forKey:@"yellow"];
-    [colorTable setObject:[UIColor magentaColor] forKey:@"magenta"];
-    [colorTable setObject:[UIColor orangeColor] forKey:@"orange"];
-    [colorTable setObject:[UIColor purpleColor] forKey:@"purple"];
-    [colorTable setObject:[UIColor brownColor] forKey:@"brown"];
-    [colorTable setObject:[UIColor clearColor] forKey:@"clear"];
-
-    sColorTable = [colorTable copy];
++ (void)buildColorTable {
+  // This color table was generated from http://www.w3.org/TR/css3-color/
+  //
+  // The output was sorted,
+  // > pbpaste | sort | pbcopy
+  //
+  // reformatted using a regex,
+  // ^(.+)\t(.+)\t(.+) => RGBCOLOR($3), @"$1",
+  //
+  // and then uniq'd
+  // > pbpaste | uniq | pbcopy
+  NSMutableDictionary* colorTable =
+  [[NSMutableDictionary alloc] initWithObjectsAndKeys:
+   RGBCOLOR(240,248,255), @"aliceblue",
+   RGBCOLOR(250,235,215), @"antiquewhite",
+   RGBCOLOR(0,255,255), @"aqua",
+   RGBCOLOR(127,255,212), @"aquamarine",
+   RGBCOLOR(240,255,255), @"azure",
+   RGBCOLOR(245,245,220), @"beige",
+   RGBCOLOR(255,228,196), @"bisque",
+   RGBCOLOR(0,0,0), @"black",
+   RGBCOLOR(255,235,205), @"blanchedalmond",
+   RGBCOLOR(0,0,255), @"blue",
+   RGBCOLOR(138,43,226), @"blueviolet",
+   RGBCOLOR(165,42,42), @"brown",
+   RGBCOLOR(222,184,135), @"burlywood",
+   RGBCOLOR(95,158,160), @"cadetblue",
+   RGBCOLOR(127,255,0), @"chartreuse",
+   RGBCOLOR(210,105,30), @"chocolate",
+   RGBCOLOR(255,127,80), @"coral",
+   RGBCOLOR(100,149,237), @"cornflowerblue",
+   RGBCOLOR(255,248,220), @"cornsilk",
+   RGBCOLOR(220,20,60), @"crimson",
+   RGBCOLOR(0,255,255), @"cyan",
+   RGBCOLOR(0,0,139), @"darkblue",
+   RGBCOLOR(0,139,139), @"darkcyan",
+   RGBCOLOR(184,134,11), @"darkgoldenrod",
+   RGBCOLOR(169,169,169), @"darkgray",
+   RGBCOLOR(0,100,0), @"darkgreen",
+   RGBCOLOR(169,169,169), @"darkgrey",
+   RGBCOLOR(189,183,107), @"darkkhaki",
+   RGBCOLOR(139,0,139), @"darkmagenta",
+   RGBCOLOR(85,107,47), @"darkolivegreen",
+   RGBCOLOR(255,140,0), @"darkorange",
+   RGBCOLOR(153,50,204), @"darkorchid",
+   RGBCOLOR(139,0,0), @"darkred",
+   RGBCOLOR(233,150,122), @"darksalmon",
+   RGBCOLOR(143,188,143), @"darkseagreen",
+   RGBCOLOR(72,61,139), @"darkslateblue",
+   RGBCOLOR(47,79,79), @"darkslategray",
+   RGBCOLOR(47,79,79), @"darkslategrey",
+   RGBCOLOR(0,206,209), @"darkturquoise",
+   RGBCOLOR(148,0,211), @"darkviolet",
+   RGBCOLOR(255,20,147), @"deeppink",
+   RGBCOLOR(0,191,255), @"deepskyblue",
+   RGBCOLOR(105,105,105), @"dimgray",
+   RGBCOLOR(105,105,105), @"dimgrey",
+   RGBCOLOR(30,144,255), @"dodgerblue",
+   RGBCOLOR(178,34,34), @"firebrick",
+   RGBCOLOR(255,250,240), @"floralwhite",
+   RGBCOLOR(34,139,34), @"forestgreen",
+   RGBCOLOR(255,0,255), @"fuchsia",
+   RGBCOLOR(220,220,220), @"gainsboro",
+   RGBCOLOR(248,248,255), @"ghostwhite",
+   RGBCOLOR(255,215,0), @"gold",
+   RGBCOLOR(218,165,32), @"goldenrod",
+   RGBCOLOR(128,128,128), @"gray",
+   RGBCOLOR(0,128,0), @"green",
+   RGBCOLOR(173,255,47), @"greenyellow",
+   RGBCOLOR(128,128,128), @"grey",
+   RGBCOLOR(240,255,240), @"honeydew",
+   RGBCOLOR(255,105,180), @"hotpink",
+   RGBCOLOR(205,92,92), @"indianred",
+   RGBCOLOR(75,0,130), @"indigo",
+   RGBCOLOR(255,255,240), @"ivory",
+   RGBCOLOR(240,230,140), @"khaki",
+   RGBCOLOR(230,230,250), @"lavender",
+   RGBCOLOR(255,240,245), @"lavenderblush",
+   RGBCOLOR(124,252,0), @"lawngreen",
+   RGBCOLOR(255,250,205), @"lemonchiffon",
+   RGBCOLOR(173,216,230), @"lightblue",
+   RGBCOLOR(240,128,128), @"lightcoral",
+   RGBCOLOR(224,255,255), @"lightcyan",
+   RGBCOLOR(250,250,210), @"lightgoldenrodyellow",
+   RGBCOLOR(211,211,211), @"lightgray",
+   RGBCOLOR(144,238,144), @"lightgreen",
+   RGBCOLOR(211,211,211), @"lightgrey",
+   RGBCOLOR(255,182,193), @"lightpink",
+   RGBCOLOR(255,160,122), @"lightsalmon",
+   RGBCOLOR(32,178,170), @"lightseagreen",
+   RGBCOLOR(135,206,250), @"lightskyblue",
+   RGBCOLOR(119,136,153), @"lightslategray",
+   RGBCOLOR(119,136,153), @"lightslategrey",
+   RGBCOLOR(176,196,222), @"lightsteelblue",
+   RGBCOLOR(255,255,224), @"lightyellow",
+   RGBCOLOR(0,255,0), @"lime",
+   RGBCOLOR(50,205,50), @"limegreen",
+   RGBCOLOR(250,240,230), @"linen",
+   RGBCOLOR(255,0,255), @"magenta",
+   RGBCOLOR(128,0,0), @"maroon",
+   RGBCOLOR(102,205,170), @"mediumaquamarine",
+   RGBCOLOR(0,0,205), @"mediumblue",
+   RGBCOLOR(186,85,211), @"mediumorchid",
+   RGBCOLOR(147,112,219), @"mediumpurple",
+   RGBCOLOR(60,179,113), @"mediumseagreen",
+   RGBCOLOR(123,104,238), @"mediumslateblue",
+   RGBCOLOR(0,250,154), @"mediumspringgreen",
+   RGBCOLOR(72,209,204), @"mediumturquoise",
+   RGBCOLOR(199,21,133), @"mediumvioletred",
+   RGBCOLOR(25,25,112), @"midnightblue",
+   RGBCOLOR(245,255,250), @"mintcream",
+   RGBCOLOR(255,228,225), @"mistyrose",
+   RGBCOLOR(255,228,181), @"moccasin",
+   RGBCOLOR(255,222,173), @"navajowhite",
+   RGBCOLOR(0,0,128), @"navy",
+   RGBCOLOR(253,245,230), @"oldlace",
+   RGBCOLOR(128,128,0), @"olive",
+   RGBCOLOR(107,142,35), @"olivedrab",
+   RGBCOLOR(255,165,0), @"orange",
+   RGBCOLOR(255,69,0), @"orangered",
+   RGBCOLOR(218,112,214), @"orchid",
+   RGBCOLOR(238,232,170), @"palegoldenrod",
+   RGBCOLOR(152,251,152), @"palegreen",
+   RGBCOLOR(175,238,238), @"paleturquoise",
+   RGBCOLOR(219,112,147), @"palevioletred",
+   RGBCOLOR(255,239,213), @"papayawhip",
+   RGBCOLOR(255,218,185), @"peachpuff",
+   RGBCOLOR(205,133,63), @"peru",
+   RGBCOLOR(255,192,203), @"pink",
+   RGBCOLOR(221,160,221), @"plum",
+   RGBCOLOR(176,224,230), @"powderblue",
+   RGBCOLOR(128,0,128), @"purple",
+   RGBCOLOR(255,0,0), @"red",
+   RGBCOLOR(188,143,143), @"rosybrown",
+   RGBCOLOR(65,105,225), @"royalblue",
+   RGBCOLOR(139,69,19), @"saddlebrown",
+   RGBCOLOR(250,128,114), @"salmon",
+   RGBCOLOR(244,164,96), @"sandybrown",
+   RGBCOLOR(46,139,87), @"seagreen",
+   RGBCOLOR(255,245,238), @"seashell",
+   RGBCOLOR(160,82,45), @"sienna",
+   RGBCOLOR(192,192,192), @"silver",
+   RGBCOLOR(135,206,235), @"skyblue",
+   RGBCOLOR(106,90,205), @"slateblue",
+   RGBCOLOR(112,128,144), @"slategray",
+   RGBCOLOR(112,128,144), @"slategrey",
+   RGBCOLOR(255,250,250), @"snow",
+   RGBCOLOR(0,255,127), @"springgreen",
+   RGBCOLOR(70,130,180), @"steelblue",
+   RGBCOLOR(210,180,140), @"tan",
+   RGBCOLOR(0,128,128), @"teal",
+   RGBCOLOR(216,191,216), @"thistle",
+   RGBCOLOR(255,99,71), @"tomato",
+   RGBCOLOR(64,224,208), @"turquoise",
+   RGBCOLOR(238,130,238), @"violet",
+   RGBCOLOR(245,222,179), @"wheat",
+   RGBCOLOR(255,255,255), @"white",
+   RGBCOLOR(245,245,245), @"whitesmoke",
+   RGBCOLOR(255,255,0), @"yellow",
+   RGBCOLOR(154,205,50), @"yellowgreen",
+   
+   // System colors
+   [UIColor lightTextColor],                @"lightTextColor",
+   [UIColor darkTextColor],                 @"darkTextColor",
+   [UIColor groupTableViewBackgroundColor], @"groupTableViewBackgroundColor",
+   [UIColor viewFlipsideBackgroundColor],   @"viewFlipsideBackgroundColor",
+   nil];
+  
+  if ([UIColor respondsToSelector:@selector(scrollViewTexturedBackgroundColor)]) {
+    // 3.2 and up
+    UIColor* color = [UIColor scrollViewTexturedBackgroundColor];
+    if (nil != color) {
+      [colorTable setObject:color
+                     forKey:@"scrollViewTexturedBackgroundColor"];
+    }
+  }
+  
+  if ([UIColor respondsToSelector:@selector(underPageBackgroundColor)]) {
+    // 5.0 and up
+    UIColor* color = [UIColor underPageBackgroundColor];
+    if (nil != color) {
+      [colorTable setObject:color
+                     forKey:@"underPageBackgroundColor"];
+    }
   }
-  return sColorTable;
+
+  // Replace the web colors with their system color equivalents.
+  [colorTable setObject:[UIColor blackColor] forKey:@"black"];
+  [colorTable setObject:[UIColor darkGrayColor] forKey:@"darkGray"];
+  [colorTable setObject:[UIColor lightGrayColor] forKey:@"lightGray"];
+  [colorTable setObject:[UIColor whiteColor] forKey:@"white"];
+  [colorTable setObject:[UIColor grayColor] forKey:@"gray"];
+  [colorTable setObject:[UIColor redColor] forKey:@"red"];
+  [colorTable setObject:[UIColor greenColor] forKey:@"green"];
+  [colorTable setObject:[UIColor blueColor] forKey:@"blue"];
+  [colorTable setObject:[UIColor cyanColor] forKey:@"cyan"];
+  [colorTable setObject:[UIColor yellowColor] forKey:@"yellow"];
+  [colorTable setObject:[UIColor magentaColor] forKey:@"magenta"];
+  [colorTable setObject:[UIColor orangeColor] forKey:@"orange"];
+  [colorTable setObject:[UIColor purpleColor] forKey:@"purple"];
+  [colorTable setObject:[UIColor brownColor] forKey:@"brown"];
+  [colorTable setObject:[UIColor clearColor] forKey:@"clear"];
+
+  sColorTable = [colorTable copy];
 }
 
 + (NICSSUnit)unitFromCssValues:(NSArray*)cssValues {
@@ -1033,17 +1154,18 @@ RULE_ELEMENT(horizontalAlign, HorizontalAlign, @"-mobile-content-halign", UICont
 
   if ([cssValues count] >= 6 && [[cssValues objectAtIndex:0] isEqualToString:@"rgba("]) {
     // rgba( x x x x )
-    color = RGBACOLOR([[cssValues objectAtIndex:1] floatValue],
-                      [[cssValues objectAtIndex:2] floatValue],
-                      [[cssValues objectAtIndex:3] floatValue],
-                      [[cssValues objectAtIndex:4] floatValue]);
+    color = NICSSInternedColor([[cssValues objectAtIndex:1] floatValue],
+                               [[cssValues objectAtIndex:2] floatValue],
+                               [[cssValues objectAtIndex:3] floatValue],
+                               [[cssValues objectAtIndex:4] floatValue]);
     *pNumberOfConsumedTokens = 6;
 
   } else if ([cssValues count] >= 5 && [[cssValues objectAtIndex:0] isEqualToString:@"rgb("]) {
     // rgb( x x x )
-    color = RGBCOLOR([[cssValues objectAtIndex:1] floatValue],
-                     [[cssValues objectAtIndex:2] floatValue],
-                     [[cssValues objectAtIndex:3] floatValue]);
+    color = NICSSInternedColor([[cssValues objectAtIndex:1] floatValue],
+                               [[cssValues objectAtIndex:2] floatValue],
+                               [[cssValues objectAtIndex:3] floatValue],
+                               1);
     *pNumberOfConsumedTokens = 5;
     
   } else if ([cssValues count] == 1 && [[cssValues objectAtIndex:0] hasPrefix:@"url("]) {
@@ -1069,9 +1191,10 @@ RULE_ELEMENT(horizontalAlign, HorizontalAlign, @"-mobile-content-halign", UICont
         colorValue = strtol([cssString UTF8String] + 1, nil, 16);
       }
 
-      color = RGBCOLOR(((colorValue & 0xFF0000) >> 16),
-                       ((colorValue & 0xFF00) >> 8),
-                       (colorValue & 0xFF));
+      color = NICSSInternedColor(((colorValue & 0xFF0000) >> 16),
+                                 ((colorValue & 0xFF00) >> 8),
+                                 (colorValue & 0xFF),
+                                 1);
     } else if ([cssString caseInsensitiveCompare:@"none"] == NSOrderedSame) {
       // Special case to "undo" a color that was set by some other rule
       color = nil;
@@ -1187,3 +1310,169 @@ RULE_ELEMENT(horizontalAlign, HorizontalAlign, @"-mobile-content-halign", UICont
 }
 
 @end
+
+#define NIPropertyBit(property) (1ULL << (property))
+
+// Maps each CSS property name to the ruleset properties that are derived from it.
+static NSDictionary* NICSSRulesetKeyToProperties(void) {
+  static NSDictionary* sKeyToProperties = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    NSMutableDictionary* keyToProperties = [[NSMutableDictionary alloc] init];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyTextColor)) forKey:kTextColorKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyHighlightedTextColor)) forKey:kHighlightedTextColorKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyTextAlignment)) forKey:kTextAlignmentKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyFont)) forKey:kFontKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyFont)) forKey:kFontSizeKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyFont)) forKey:kFontStyleKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyFont)) forKey:kFontWeightKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyFont)) forKey:kFontFamilyKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyTextShadowColor) | NIPropertyBit(NICSSRulesetPropertyTextShadowOffset)) forKey:kTextShadowKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyLineBreakMode)) forKey:kLineBreakModeKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyNumberOfLines)) forKey:kNumberOfLinesKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyMinimumFontSize)) forKey:kMinimumFontSizeKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyAdjustsFontSize)) forKey:kAdjustsFontSizeKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyBaselineAdjustment)) forKey:kBaselineAdjustmentKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyOpacity)) forKey:kOpacityKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyBackgroundColor)) forKey:kBackgroundColorKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyBorderRadius)) forKey:kBorderRadiusKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyBorderColor) | NIPropertyBit(NICSSRulesetPropertyBorderWidth)) forKey:kBorderKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyBorderColor)) forKey:kBorderColorKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyBorderWidth)) forKey:kBorderWidthKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyTintColor)) forKey:kTintColorKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyActivityIndicatorStyle)) forKey:kActivityIndicatorStyleKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyAutoresizing)) forKey:kAutoresizingKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyTableViewCellSeparatorStyle)) forKey:kTableViewCellSeparatorStyleKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyScrollViewIndicatorStyle)) forKey:kScrollViewIndicatorStyleKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyHorizontalPadding) | NIPropertyBit(NICSSRulesetPropertyVerticalPadding)) forKey:kPaddingKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyHorizontalPadding)) forKey:kHPaddingKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyVerticalPadding)) forKey:kVPaddingKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyWidth)) forKey:kWidthKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyHeight)) forKey:kHeightKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyTop)) forKey:kTopKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyBottom)) forKey:kBottomKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyRight)) forKey:kRightKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyLeft)) forKey:kLeftKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyMinWidth)) forKey:kMinWidthKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyMinHeight)) forKey:kMinHeightKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyMaxWidth)) forKey:kMaxWidthKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyMaxHeight)) forKey:kMaxHeightKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyFrameHorizontalAlign)) forKey:kFrameHorizontalAlignKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyFrameVerticalAlign)) forKey:kFrameVerticalAlignKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyBackgroundStretchInsets)) forKey:kBackgroundStretchInsetsKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyBackgroundImage)) forKey:kBackgroundImageKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyImage)) forKey:kImageKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyVisible)) forKey:kVisibleKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyTitleInsets)) forKey:kTitleInsetsKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyContentInsets)) forKey:kContentInsetsKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyImageInsets)) forKey:kImageInsetsKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyRelativeToId)) forKey:kRelativeToIdKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyMarginTop)) forKey:kMarginTopKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyMarginBottom)) forKey:kMarginBottomKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyMarginLeft)) forKey:kMarginLeftKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyMarginRight)) forKey:kMarginRightKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyTextKey)) forKey:kTextKeyKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyButtonAdjust)) forKey:kButtonAdjustKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyVerticalAlign)) forKey:kVerticalAlignKey];
+    [keyToProperties setObject:@(NIPropertyBit(NICSSRulesetPropertyHorizontalAlign)) forKey:kHorizontalAlignKey];
+    sKeyToProperties = [keyToProperties copy];
+  });
+  return sKeyToProperties;
+}
+
+static uint64_t NICSSRulesetPropertiesForKey(NSString* key) {
+  return [[NICSSRulesetKeyToProperties() objectForKey:key] unsignedLongLongValue];
+}
+
+#pragma mark - Interned Values
+
+// Font sizes are kept to a 64th of a point so that the key stays a small, allocation-free number.
+static NSNumber* NICSSFontKey(CGFloat fontSize, BOOL isBold, BOOL isItalic) {
+  long long size = (long long)lround(MAX(0, fontSize) * 64);
+  return [NSNumber numberWithLongLong:(size << 2) | (isBold ? 2 : 0) | (isItalic ? 1 : 0)];
+}
+
+static UIFont* NICSSInternedFont(NSString* fontName, CGFloat fontSize, BOOL isBold, BOOL isItalic) {
+  NSString* family = (nil != fontName) ? fontName : @"";
+  NSNumber* key = NICSSFontKey(fontSize, isBold, isItalic);
+
+  @synchronized([NICSSRuleset class]) {
+    UIFont* font = [[sInternedFonts objectForKey:family] objectForKey:key];
+    if (nil != font) {
+      return font;
+    }
+  }
+
+  UIFont* font = nil;
+  if (nil != fontName) {
+    font = [UIFont fontWithName:fontName size:fontSize];
+
+  } else if (isItalic && isBold) {
+    // There is no easy way to create a bold italic font using the exposed UIFont methods.
+    // Please consider using the exact font name instead. E.g. font-name: Helvetica-BoldObliquei
+    NIDASSERT(!(isItalic && isBold));
+    font = [UIFont systemFontOfSize:fontSize];
+
+  } else if (isItalic) {
+    font = [UIFont italicSystemFontOfSize:fontSize];
+
+  } else if (isBold) {
+    font = [UIFont boldSystemFontOfSize:fontSize];
+
+  } else {
+    font = [UIFont systemFontOfSize:fontSize];
+  }
+  if (nil == font) {
+    return nil;
+  }
+
+  @synchronized([NICSSRuleset class]) {
+    if (nil == sInternedFonts) {
+      sInternedFonts = [[NSMutableDictionary alloc] init];
+    }
+    NSMutableDictionary* fonts = [sInternedFonts objectForKey:family];
+    if (nil == fonts) {
+      fonts = [[NSMutableDictionary alloc] init];
+      [sInternedFonts setObject:fonts forKey:family];
+    }
+    UIFont* internedFont = [fonts objectForKey:key];
+    if (nil != internedFont) {
+      return internedFont;
+    }
+    [fonts setObject:font forKey:key];
+  }
+  return font;
+}
+
+// Packs each channel into 14 bits, which is exact for 8-bit channels and keeps the key small
+// enough for NSNumber not to allocate.
+static NSNumber* NICSSColorKey(CGFloat red, CGFloat green, CGFloat blue, CGFloat alpha) {
+  unsigned long long r = (unsigned long long)lround(MIN(MAX(red, 0), 255) * 64);
+  unsigned long long g = (unsigned long long)lround(MIN(MAX(green, 0), 255) * 64);
+  unsigned long long b = (unsigned long long)lround(MIN(MAX(blue, 0), 255) * 64);
+  unsigned long long a = (unsigned long long)lround(MIN(MAX(alpha, 0), 1) * 0x3FFF);
+  return [NSNumber numberWithUnsignedLongLong:(r << 42) | (g << 28) | (b << 14) | a];
+}
+
+// The channels are given as in CSS: red, green and blue from 0 to 255 and alpha from 0 to 1.
+static UIColor* NICSSInternedColor(CGFloat red, CGFloat green, CGFloat blue, CGFloat alpha) {
+  NSNumber* key = NICSSColorKey(red, green, blue, alpha);
+  @synchronized([NICSSRuleset class]) {
+    UIColor* color = [sInternedColors objectForKey:key];
+    if (nil == color) {
+      color = RGBACOLOR(red, green, blue, alpha);
+      if (nil == sInternedColors) {
+        sInternedColors = [[NSMutableDictionary alloc] init];
+      }
+      [sInternedColors setObject:color forKey:key];
+    }
+    return color;
+  }
+}
+
+static void NICSSPurgeInternedValues(void) {
+  @synchronized([NICSSRuleset class]) {
+    sInternedFonts = nil;
+    sInternedColors = nil;
+  }
+}
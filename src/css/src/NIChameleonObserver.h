@@ -78,6 +78,12 @@ extern NSString* const NIJSONDidChangeNameKey;
  * When changes are detected the Chameleon observer downloads the new CSS files, reloads them,
  * and then fires the appropriate notifications.
  *
+ * Servers that support it send the changed files along with the change itself, saving a
+ * request per file. Each reloaded stylesheet is compared with its previous rulesets, and
+ * NIStylesheetDidChangeNotification is only fired for stylesheets whose rulesets changed, with
+ * the changed scopes under NIStylesheetChangedScopesKey. An NIDOM then only restyles the views
+ * that those scopes apply to.
+ *
  * @fn NIChameleonObserver::watchSkinChanges
  */
 
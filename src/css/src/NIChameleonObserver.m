@@ -89,49 +89,107 @@ NSString* const NIJSONDidChangeNameKey = @"NIJSONNameKey";
   return self;
 }
 
-- (void)downloadStylesheetWithFilename:(NSString *)path {
-  NSURL* url = [NSURL URLWithString:[_host stringByAppendingString:path]];
-  NSMutableURLRequest* request = [NSMutableURLRequest requestWithURL:url];
+// The path of a file relative to the watched folder, as the Chameleon server reports it.
+- (NSString *)resultPathForURL:(NSURL *)url {
+  NSArray* pathParts = [[url absoluteString] pathComponents];
+  return [[pathParts subarrayWithRange:NSMakeRange(2, [pathParts count] - 2)]
+          componentsJoinedByString:@"/"];
+}
 
-  AFHTTPRequestOperation* requestOp = [[AFHTTPRequestOperation alloc] initWithRequest:request];
+- (NSString *)writeData:(NSData *)data forResultPath:(NSString *)resultPath {
+  NSString* rootPath = NIPathForDocumentsResource(nil);
+  NSString* hashedPath = [self pathFromPath:resultPath];
+  NSString* diskPath = [rootPath stringByAppendingPathComponent:hashedPath];
+  [data writeToFile:diskPath atomically:YES];
+  return diskPath;
+}
 
-  [requestOp setCompletionBlockWithSuccess:^(AFHTTPRequestOperation *operation, id responseObject) {
-    NSMutableArray* changedStylesheets = [NSMutableArray array];
-    NSArray* pathParts = [[operation.request.URL absoluteString] pathComponents];
-    NSString* resultPath = [[pathParts subarrayWithRange:NSMakeRange(2, [pathParts count] - 2)]
-                            componentsJoinedByString:@"/"];
-    NSString* rootPath = NIPathForDocumentsResource(nil);
-    NSString* hashedPath = [self pathFromPath:resultPath];
-    NSString* diskPath = [rootPath stringByAppendingPathComponent:hashedPath];
-    [responseObject writeToFile:diskPath atomically:YES];
-    
-    NIStylesheet* stylesheet = [_stylesheetCache stylesheetWithPath:resultPath loadFromDisk:NO];
-    if ([stylesheet loadFromPath:resultPath pathPrefix:rootPath delegate:self]) {
-      [changedStylesheets addObject:stylesheet];
-    }
-    
-    for (NSString* iteratingPath in _stylesheetPaths) {
-      stylesheet = [_stylesheetCache stylesheetWithPath:iteratingPath loadFromDisk:NO];
-      if ([stylesheet.dependencies containsObject:resultPath]) {
-        // This stylesheet has the changed stylesheet as a dependency so let's refresh it.
-        if ([stylesheet loadFromPath:iteratingPath pathPrefix:rootPath delegate:self]) {
-          [changedStylesheets addObject:stylesheet];
-        }
+- (void)didReceiveStylesheetData:(NSData *)data forResultPath:(NSString *)resultPath {
+  NSMutableArray* changedStylesheets = [NSMutableArray array];
+  NSString* rootPath = NIPathForDocumentsResource(nil);
+  [self writeData:data forResultPath:resultPath];
+
+  NIStylesheet* stylesheet = [_stylesheetCache stylesheetWithPath:resultPath loadFromDisk:NO];
+  if ([stylesheet loadFromPath:resultPath pathPrefix:rootPath delegate:self]) {
+    [changedStylesheets addObject:stylesheet];
+  }
+
+  for (NSString* iteratingPath in _stylesheetPaths) {
+    stylesheet = [_stylesheetCache stylesheetWithPath:iteratingPath loadFromDisk:NO];
+    if ([stylesheet.dependencies containsObject:resultPath]) {
+      // This stylesheet has the changed stylesheet as a dependency so let's refresh it.
+      if ([stylesheet loadFromPath:iteratingPath pathPrefix:rootPath delegate:self]) {
+        [changedStylesheets addObject:stylesheet];
       }
     }
+  }
 
-    NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
-    for (NIStylesheet* changedStylesheet in changedStylesheets) {
-      [nc postNotificationName:NIStylesheetDidChangeNotification
-                        object:changedStylesheet
-                      userInfo:nil];
+  NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
+  for (NIStylesheet* changedStylesheet in changedStylesheets) {
+    // Saving a file without changing any of its rulesets, e.g. by editing a comment, leaves
+    // every view alone.
+    NSSet* changedScopes = changedStylesheet.changedScopes;
+    if ([changedScopes count] == 0) {
+      continue;
     }
+    [nc postNotificationName:NIStylesheetDidChangeNotification
+                      object:changedStylesheet
+                    userInfo:@{NIStylesheetChangedScopesKey: changedScopes}];
+  }
+}
 
-  } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+- (void)didReceiveStringsData:(NSData *)data forResultPath:(NSString *)resultPath {
+  NSString* diskPath = [self writeData:data forResultPath:resultPath];
+
+  NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
+  [nc postNotificationName:NIStringsDidChangeNotification object:nil userInfo:@{
+      NIStringsDidChangeFilePathKey: diskPath
+   }];
+}
+
+- (void)didReceiveJSONData:(NSData *)data forResultPath:(NSString *)resultPath name:(NSString *)name {
+  NSString* diskPath = [self writeData:data forResultPath:resultPath];
+
+  NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
+  [nc postNotificationName:NIJSONDidChangeNotification object:nil userInfo:@{
+      NIJSONDidChangeFilePathKey: diskPath,
+      NIJSONDidChangeNameKey: name
+   }];
+}
+
+// Reports the operation's size and timings to NINetworkActivity's task metrics, then queues it.
+// Must be called after the operation's completion blocks are set.
+- (void)addRequestOperation:(AFHTTPRequestOperation *)requestOp {
+  // Progress is reported on the main queue, so the metrics are only touched there.
+  __block NINetworkTaskMetrics metrics = NINetworkTaskMetricsDidStart(requestOp.request.URL);
+  [requestOp setDownloadProgressBlock:^(NSUInteger bytesRead, long long totalBytesRead, long long totalBytesExpectedToRead) {
+    NINetworkTaskMetricsDidReceiveBytes(&metrics, bytesRead);
   }];
+  void (^completionBlock)(void) = requestOp.completionBlock;
+  requestOp.completionBlock = ^{
+    dispatch_async(dispatch_get_main_queue(), ^{
+      NINetworkTaskMetricsDidFinish(&metrics);
+    });
+    if (nil != completionBlock) {
+      completionBlock();
+    }
+  };
   [_queue addOperation:requestOp];
 }
 
+- (void)downloadStylesheetWithFilename:(NSString *)path {
+  NSURL* url = [NSURL URLWithString:[_host stringByAppendingString:path]];
+  NSMutableURLRequest* request = [NSMutableURLRequest requestWithURL:url];
+
+  AFHTTPRequestOperation* requestOp = [[AFHTTPRequestOperation alloc] initWithRequest:request];
+
+  [requestOp setCompletionBlockWithSuccess:^(AFHTTPRequestOperation *operation, id responseObject) {
+    [self didReceiveStylesheetData:responseObject forResultPath:[self resultPathForURL:operation.request.URL]];
+  } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+  }];
+  [self addRequestOperation:requestOp];
+}
+
 - (void)downloadStringsWithFilename:(NSString *)path {
   NSURL* url = [NSURL URLWithString:[_host stringByAppendingString:path]];
   NSMutableURLRequest* request = [NSMutableURLRequest requestWithURL:url];
@@ -139,21 +197,10 @@ NSString* const NIJSONDidChangeNameKey = @"NIJSONNameKey";
   AFHTTPRequestOperation* requestOp = [[AFHTTPRequestOperation alloc] initWithRequest:request];
   
   [requestOp setCompletionBlockWithSuccess:^(AFHTTPRequestOperation *operation, id responseObject) {
-    NSArray* pathParts = [[operation.request.URL absoluteString] pathComponents];
-    NSString* resultPath = [[pathParts subarrayWithRange:NSMakeRange(2, [pathParts count] - 2)]
-                            componentsJoinedByString:@"/"];
-    NSString* rootPath = NIPathForDocumentsResource(nil);
-    NSString* hashedPath = [self pathFromPath:resultPath];
-    NSString* diskPath = [rootPath stringByAppendingPathComponent:hashedPath];
-    [responseObject writeToFile:diskPath atomically:YES];
-    
-    NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
-    [nc postNotificationName:NIStringsDidChangeNotification object:nil userInfo:@{
-        NIStringsDidChangeFilePathKey: diskPath
-     }];
+    [self didReceiveStringsData:responseObject forResultPath:[self resultPathForURL:operation.request.URL]];
   } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
   }];
-  [_queue addOperation:requestOp];
+  [self addRequestOperation:requestOp];
 }
 
 - (void)downloadJSONWithFilename:(NSString *)path {
@@ -163,22 +210,56 @@ NSString* const NIJSONDidChangeNameKey = @"NIJSONNameKey";
     AFHTTPRequestOperation* requestOp = [[AFHTTPRequestOperation alloc] initWithRequest:request];
     
     [requestOp setCompletionBlockWithSuccess:^(AFHTTPRequestOperation *operation, id responseObject) {
-        NSArray* pathParts = [[operation.request.URL absoluteString] pathComponents];
-        NSString* resultPath = [[pathParts subarrayWithRange:NSMakeRange(2, [pathParts count] - 2)]
-                                componentsJoinedByString:@"/"];
-        NSString* rootPath = NIPathForDocumentsResource(nil);
-        NSString* hashedPath = [self pathFromPath:resultPath];
-        NSString* diskPath = [rootPath stringByAppendingPathComponent:hashedPath];
-        [responseObject writeToFile:diskPath atomically:YES];
-        
-        NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
-        [nc postNotificationName:NIJSONDidChangeNotification object:nil userInfo:@{
-            NIJSONDidChangeFilePathKey: diskPath,
-            NIJSONDidChangeNameKey: path
-         }];
+        [self didReceiveJSONData:responseObject forResultPath:[self resultPathForURL:operation.request.URL] name:path];
     } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
     }];
-    [_queue addOperation:requestOp];
+    [self addRequestOperation:requestOp];
+}
+
+// Servers that support deltas answer a watch request with the contents of every changed file,
+// which saves a round trip per file:
+//
+// {"files": {"/common.css": "...", "/strings/en.strings": "..."}}
+//
+// Returns NO if the response is the plain list of filenames that older servers send.
+- (BOOL)didReceiveWatchDeltas:(NSData *)data {
+  const char* bytes = [data bytes];
+  NSUInteger length = [data length];
+  NSUInteger ix = 0;
+  while (ix < length && isspace((unsigned char)bytes[ix])) {
+    ++ix;
+  }
+  if (ix >= length || bytes[ix] != '{') {
+    return NO;
+  }
+
+  NSDictionary* deltas = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+  NSDictionary* files = [deltas isKindOfClass:[NSDictionary class]] ? [deltas objectForKey:@"files"] : nil;
+  if (![files isKindOfClass:[NSDictionary class]]) {
+    NIDERROR(@"Unable to read the Chameleon deltas.");
+    return YES;
+  }
+
+  for (NSString* filename in files) {
+    NSString* contents = [files objectForKey:filename];
+    if (![contents isKindOfClass:[NSString class]]) {
+      continue;
+    }
+    NSData* fileData = [contents dataUsingEncoding:NSUTF8StringEncoding];
+    NSString* resultPath = filename;
+    while ([resultPath hasPrefix:@"/"]) {
+      resultPath = [resultPath substringFromIndex:1];
+    }
+
+    if ([[filename lowercaseString] hasSuffix:@".strings"]) {
+      [self didReceiveStringsData:fileData forResultPath:resultPath];
+    } else if ([[filename lowercaseString] hasSuffix:@".json"]) {
+      [self didReceiveJSONData:fileData forResultPath:resultPath name:filename];
+    } else {
+      [self didReceiveStylesheetData:fileData forResultPath:resultPath];
+    }
+  }
+  return YES;
 }
 
 - (NSString *)pathFromPath:(NSString *)path {
@@ -200,16 +281,18 @@ NSString* const NIJSONDidChangeNameKey = @"NIJSONNameKey";
 }
 
 - (void)watchSkinChanges {
-  NSURL* url = [NSURL URLWithString:[_host stringByAppendingString:@"watch"]];
+  NSURL* url = [NSURL URLWithString:[_host stringByAppendingString:@"watch?deltas=1"]];
   NSMutableURLRequest* request = [NSMutableURLRequest requestWithURL:url];
   request.timeoutInterval = kTimeoutInterval;
   AFHTTPRequestOperation* requestOp = [[AFHTTPRequestOperation alloc] initWithRequest:request];
 
   [requestOp setCompletionBlockWithSuccess:^(AFHTTPRequestOperation *operation, id responseObject) {
-    NSString* stringData = [[NSString alloc] initWithData:responseObject
-                                                 encoding:NSUTF8StringEncoding];
-
-    NSArray* files = [stringData componentsSeparatedByString:@"\n"];
+    NSArray* files = nil;
+    if (![self didReceiveWatchDeltas:responseObject]) {
+      NSString* stringData = [[NSString alloc] initWithData:responseObject
+                                                   encoding:NSUTF8StringEncoding];
+      files = [stringData componentsSeparatedByString:@"\n"];
+    }
     for (NSString* filename in files) {
       if ([[filename lowercaseString] hasSuffix:@".strings"]) {
         [self downloadStringsWithFilename: filename];
@@ -235,7 +318,7 @@ NSString* const NIJSONDidChangeNameKey = @"NIJSONNameKey";
     }
   }];
 
-  [_queue addOperation:requestOp];
+  [self addRequestOperation:requestOp];
 }
 
 -(void)enableBonjourDiscovery:(NSString *)serviceName
@@ -0,0 +1,86 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+
+/**
+ * A parsed stylesheet stored in a compact binary form.
+ *
+ * Parsing CSS runs the flex tokenizer and NICSSParser over every imported file and then builds
+ * the map of significant scopes that NIStylesheet uses to find rule sets. A compiled stylesheet
+ * stores the results of both, so loading one is a matter of mapping the file and reading
+ * a string table and a few arrays of indices.
+ *
+ * Stylesheets are compiled ahead of time with
+ * NIStylesheet::compileStylesheetAtPath:pathPrefix:toPath: and loaded by NIStylesheet whenever
+ * a compiled file sits next to the CSS file and is newer than it and all of its imports.
+ *
+ * @ingroup NimbusCSS
+ */
+@interface NICompiledStylesheet : NSObject
+
++ (NSData *)dataWithRulesets:(NSDictionary *)rulesets significantScopeToScopes:(NSDictionary *)significantScopeToScopes;
+
+// Designated initializer.
+- (id)initWithData:(NSData *)data;
+- (id)initWithContentsOfFile:(NSString *)path;
+
+@property (nonatomic, readonly, copy) NSDictionary* rulesets;
+@property (nonatomic, readonly, copy) NSDictionary* significantScopeToScopes;
+
+@end
+
+/** @name Compiling a Stylesheet */
+
+/**
+ * Returns the binary form of parsed rule sets and their scope map.
+ *
+ * The rule sets are the dictionary returned by NICSSParser, and may include the set of
+ * dependencies under kDependenciesSelectorKey.
+ *
+ * @fn NICompiledStylesheet::dataWithRulesets:significantScopeToScopes:
+ */
+
+/** @name Loading a Compiled Stylesheet */
+
+/**
+ * Reads a compiled stylesheet from the given data.
+ *
+ * Returns nil if the data is not a compiled stylesheet of this version or is truncated.
+ *
+ * @fn NICompiledStylesheet::initWithData:
+ */
+
+/**
+ * Maps the file at the given path and reads the compiled stylesheet from it.
+ *
+ * @fn NICompiledStylesheet::initWithContentsOfFile:
+ */
+
+/** @name Accessing the Stylesheet */
+
+/**
+ * The rule sets as NICSSParser would have returned them, including mutable property orders.
+ *
+ * @fn NICompiledStylesheet::rulesets
+ */
+
+/**
+ * The map of the most significant part of each scope to the scopes that end with it.
+ *
+ * @fn NICompiledStylesheet::significantScopeToScopes
+ */
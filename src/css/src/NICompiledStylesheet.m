@@ -0,0 +1,245 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NICompiledStylesheet.h"
+
+#import "NICSSParser.h"
+#import "NimbusCore.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// "NCSS" when read as bytes.
+static const uint32_t kCompiledStylesheetMagic = 0x5353434e;
+static const uint32_t kCompiledStylesheetVersion = 2;
+
+// A compiled stylesheet is a list of little-endian 32 bit integers:
+//
+// magic, version
+// number of strings, then each string as its UTF-8 length followed by its bytes
+// number of rule sets, then for each: scope, number of properties, then for each property its
+//     name, number of values and values
+// number of dependencies, then the dependencies
+// number of significant scopes, then for each: significant scope, number of scopes, scopes
+//
+// Every string after the string table is written as its index into the table, so that each
+// scope, property name and value is only stored and decoded once.
+
+#pragma mark - Writing
+
+static void NIAppendUInt32(NSMutableData* data, uint32_t value) {
+  uint32_t littleEndianValue = CFSwapInt32HostToLittle(value);
+  [data appendBytes:&littleEndianValue length:sizeof(littleEndianValue)];
+}
+
+static void NIAppendString(NSMutableData* data, NSMutableDictionary* stringTable, NSMutableArray* strings, NSString* string) {
+  NSNumber* index = [stringTable objectForKey:string];
+  if (nil == index) {
+    index = @(strings.count);
+    [stringTable setObject:index forKey:string];
+    [strings addObject:string];
+  }
+  NIAppendUInt32(data, [index unsignedIntValue]);
+}
+
+// The collection is an array or a set of strings.
+static void NIAppendStrings(NSMutableData* data, NSMutableDictionary* stringTable, NSMutableArray* strings, id collection) {
+  NIAppendUInt32(data, (uint32_t)[collection count]);
+  for (NSString* string in collection) {
+    NIAppendString(data, stringTable, strings, string);
+  }
+}
+
+#pragma mark - Reading
+
+typedef struct {
+  const uint8_t* bytes;
+  NSUInteger length;
+  NSUInteger offset;
+  BOOL failed;
+} NICompiledStylesheetReader;
+
+static uint32_t NIReadUInt32(NICompiledStylesheetReader* reader) {
+  if (reader->failed || reader->length - reader->offset < sizeof(uint32_t)) {
+    reader->failed = YES;
+    return 0;
+  }
+  uint32_t value = 0;
+  // The string table leaves the integers after it unaligned.
+  memcpy(&value, reader->bytes + reader->offset, sizeof(value));
+  reader->offset += sizeof(value);
+  return CFSwapInt32LittleToHost(value);
+}
+
+// Reads a count of things that take up at least four bytes each, so that a corrupt count can't
+// make us allocate more than the file could possibly hold.
+static uint32_t NIReadCount(NICompiledStylesheetReader* reader) {
+  uint32_t count = NIReadUInt32(reader);
+  if (!reader->failed && count > (reader->length - reader->offset) / sizeof(uint32_t)) {
+    reader->failed = YES;
+    return 0;
+  }
+  return count;
+}
+
+static NSString* NIReadString(NICompiledStylesheetReader* reader, NSArray* strings) {
+  uint32_t index = NIReadUInt32(reader);
+  if (reader->failed || index >= strings.count) {
+    reader->failed = YES;
+    return nil;
+  }
+  return [strings objectAtIndex:index];
+}
+
+static NSMutableArray* NIReadStrings(NICompiledStylesheetReader* reader, NSArray* strings) {
+  uint32_t count = NIReadCount(reader);
+  NSMutableArray* result = [[NSMutableArray alloc] initWithCapacity:count];
+  for (uint32_t ix = 0; ix < count && !reader->failed; ++ix) {
+    NSString* string = NIReadString(reader, strings);
+    if (nil != string) {
+      [result addObject:string];
+    }
+  }
+  return result;
+}
+
+@implementation NICompiledStylesheet
+
++ (NSData *)dataWithRulesets:(NSDictionary *)rulesets significantScopeToScopes:(NSDictionary *)significantScopeToScopes {
+  NSMutableDictionary* stringTable = [[NSMutableDictionary alloc] init];
+  NSMutableArray* strings = [[NSMutableArray alloc] init];
+  NSMutableData* body = [[NSMutableData alloc] init];
+
+  NSSet* dependencies = [rulesets objectForKey:kDependenciesSelectorKey];
+  NSMutableArray* scopes = [[rulesets allKeys] mutableCopy];
+  [scopes removeObject:kDependenciesSelectorKey];
+
+  NIAppendUInt32(body, (uint32_t)scopes.count);
+  for (NSString* scope in scopes) {
+    NSDictionary* properties = [rulesets objectForKey:scope];
+    NIAppendString(body, stringTable, strings, scope);
+    NIAppendUInt32(body, (uint32_t)properties.count);
+    for (NSString* name in properties) {
+      NIAppendString(body, stringTable, strings, name);
+      NIAppendStrings(body, stringTable, strings, [properties objectForKey:name]);
+    }
+  }
+
+  NIAppendStrings(body, stringTable, strings, dependencies ?: [NSSet set]);
+
+  NIAppendUInt32(body, (uint32_t)significantScopeToScopes.count);
+  for (NSString* significantScope in significantScopeToScopes) {
+    NIAppendString(body, stringTable, strings, significantScope);
+    NIAppendStrings(body, stringTable, strings, [significantScopeToScopes objectForKey:significantScope]);
+  }
+
+  NSMutableData* data = [[NSMutableData alloc] initWithCapacity:body.length];
+  NIAppendUInt32(data, kCompiledStylesheetMagic);
+  NIAppendUInt32(data, kCompiledStylesheetVersion);
+  NIAppendUInt32(data, (uint32_t)strings.count);
+  for (NSString* string in strings) {
+    NSData* utf8 = [string dataUsingEncoding:NSUTF8StringEncoding];
+    NIAppendUInt32(data, (uint32_t)utf8.length);
+    [data appendData:utf8];
+  }
+  [data appendData:body];
+  return data;
+}
+
+- (id)initWithData:(NSData *)data {
+  if ((self = [super init])) {
+    NICompiledStylesheetReader reader = { data.bytes, data.length, 0, NO };
+    if (kCompiledStylesheetMagic != NIReadUInt32(&reader)
+        || kCompiledStylesheetVersion != NIReadUInt32(&reader)) {
+      return nil;
+    }
+
+    uint32_t numberOfStrings = NIReadCount(&reader);
+    NSMutableArray* strings = [[NSMutableArray alloc] initWithCapacity:numberOfStrings];
+    for (uint32_t ix = 0; ix < numberOfStrings && !reader.failed; ++ix) {
+      uint32_t length = NIReadUInt32(&reader);
+      if (reader.failed || length > reader.length - reader.offset) {
+        return nil;
+      }
+      NSString* string = [[NSString alloc] initWithBytes:reader.bytes + reader.offset
+                                                  length:length
+                                                encoding:NSUTF8StringEncoding];
+      if (nil == string) {
+        return nil;
+      }
+      reader.offset += length;
+      [strings addObject:string];
+    }
+
+    // Property values and orders are mutable because that is how the parser returns them and
+    // NICSSRuleset appends to the orders when it composites rule sets.
+    uint32_t numberOfRulesets = NIReadCount(&reader);
+    NSMutableDictionary* rulesets = [[NSMutableDictionary alloc] initWithCapacity:numberOfRulesets + 1];
+    for (uint32_t ix = 0; ix < numberOfRulesets && !reader.failed; ++ix) {
+      NSString* scope = NIReadString(&reader, strings);
+      uint32_t numberOfProperties = NIReadCount(&reader);
+      NSMutableDictionary* properties = [[NSMutableDictionary alloc] initWithCapacity:numberOfProperties];
+      for (uint32_t propertyIndex = 0; propertyIndex < numberOfProperties && !reader.failed; ++propertyIndex) {
+        NSString* name = NIReadString(&reader, strings);
+        NSMutableArray* values = NIReadStrings(&reader, strings);
+        if (nil != name) {
+          [properties setObject:values forKey:name];
+        }
+      }
+      if (nil != scope) {
+        [rulesets setObject:properties forKey:scope];
+      }
+    }
+
+    NSArray* dependencies = NIReadStrings(&reader, strings);
+    if (dependencies.count > 0) {
+      [rulesets setObject:[NSSet setWithArray:dependencies] forKey:kDependenciesSelectorKey];
+    }
+
+    uint32_t numberOfSignificantScopes = NIReadCount(&reader);
+    NSMutableDictionary* significantScopeToScopes = [[NSMutableDictionary alloc] initWithCapacity:numberOfSignificantScopes];
+    for (uint32_t ix = 0; ix < numberOfSignificantScopes && !reader.failed; ++ix) {
+      NSString* significantScope = NIReadString(&reader, strings);
+      NSMutableArray* scopes = NIReadStrings(&reader, strings);
+      if (nil != significantScope) {
+        [significantScopeToScopes setObject:scopes forKey:significantScope];
+      }
+    }
+
+    if (reader.failed) {
+      return nil;
+    }
+    _rulesets = [rulesets copy];
+    _significantScopeToScopes = [significantScopeToScopes copy];
+  }
+  return self;
+}
+
+- (id)initWithContentsOfFile:(NSString *)path {
+  NSData* data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nil];
+  if (nil == data) {
+    return nil;
+  }
+  return [self initWithData:data];
+}
+
+- (id)init {
+  return [self initWithData:nil];
+}
+
+@end
@@ -29,11 +29,21 @@
  * automatically apply any applicable styles from the attached stylesheet. If the stylesheet
  * changes you can refresh the DOM and all registered views will be updated accordingly.
  *
+ * Changes that happen after a view is registered, such as adding a CSS class or the stylesheet
+ * being reloaded, only mark the views they affect as needing to be restyled. Those views are
+ * restyled together, in a single CATransaction, just before the main run loop next waits.
+ * Call refreshIfNeeded to restyle them right away.
+ *
  * Because NimbusCSS supports positioning and sizing using percentages and relative units,
  * the order of view registration is important. Generally, you should register superviews
  * first, so that any size calculations on their children can occur after their own
- * size has been determined. It's not feasible (or at least advisable) to try and
- * untangle these dependencies automatically.
+ * size has been determined.
+ *
+ * When views are restyled together, and when buildSubviews:inDOM: registers the views
+ * it builds, their sizing and positioning are held back until every view's other styles have
+ * been applied. Each view is then laid out once, after its superview and after the views it is
+ * positioned relative to. A cycle of relative positions is reported with NIDERROR and broken
+ * at the view that closes it.
  *
  * <h2>Example Use</h2>
  *
@@ -56,7 +66,9 @@ _dom = [[NIDOM alloc] initWithStylesheet:stylesheet];
 [_dom registerView:self.view withCSSClass:@"background"];
 @endcode
  *
- * Once the view controller unloads its view you must unregister all of the views from your DOM.
+ * The DOM only holds weak references to its views, so a view that is deallocated drops out of the
+ * DOM on its own. Views that outlive their use, such as those of a view controller that unloads
+ * its view, should still be unregistered so that they are no longer restyled.
  *
 @code
 - (void)viewDidUnload {
@@ -74,6 +86,7 @@ _dom = [[NIDOM alloc] initWithStylesheet:stylesheet];
 + (id)domWithStylesheetWithPathPrefix:(NSString *)pathPrefix paths:(NSString *)path, ...;
 
 + (id)domWithStylesheet:(NIStylesheet *)stylesheet andParentStyles: (NIStylesheet*) parentStyles;
++ (id)domWithStylesheets:(NSArray *)stylesheets;
 
 - (void)registerView:(UIView *)view;
 - (void)registerView:(UIView *)view withCSSClass:(NSString *)cssClass;
@@ -87,6 +100,11 @@ _dom = [[NIDOM alloc] initWithStylesheet:stylesheet];
 - (void)refresh;
 - (void)refreshView: (UIView*) view;
 
+- (void)setNeedsRefresh;
+- (void)setNeedsRefreshView:(UIView *)view;
+- (void)setNeedsRefreshView:(UIView *)view forPseudoClass:(NSString *)pseudoClass;
+- (void)refreshIfNeeded;
+
 -(UIView*)viewById: (NSString*) viewId;
 
 -(NSString*)descriptionForView: (UIView*) view withName: (NSString*) viewName;
@@ -122,6 +140,20 @@ _dom = [[NIDOM alloc] initWithStylesheet:stylesheet];
  * or view controller specific style sheets.
  *
  * @fn NIDOM::domWithStylesheet:andParentStyles:
+ * @sa NIDOM::domWithStylesheets:
+ */
+
+/**
+ * Returns an autoreleased DOM initialized with a chain of stylesheets, each of which runs after
+ * the ones before it.
+ *
+ * The DOM styles its views with an NIStylesheet::initWithLayeredStylesheets: stylesheet, which
+ * caches the flattened ruleset of each selector for the whole chain. Registering a view costs
+ * the same however deep the chain is, and a change to one of the stylesheets only drops the
+ * rulesets that it affects.
+ *
+ * @fn NIDOM::domWithStylesheets:
+ * @param stylesheets  The NIStylesheets to apply, from the least to the most important.
  */
 
 /** @name Registering Views */
@@ -174,6 +206,42 @@ _dom = [[NIDOM alloc] initWithStylesheet:stylesheet];
  * @fn NIDOM::refreshView:
  */
 
+/**
+ * Marks every registered view as needing to be restyled.
+ *
+ * @fn NIDOM::setNeedsRefresh
+ */
+
+/**
+ * Marks the given view as needing to be restyled.
+ *
+ * @fn NIDOM::setNeedsRefreshView:
+ */
+
+/**
+ * Marks the given view as needing the styles of the given pseudo-class to be applied again,
+ * e.g. after the state that the pseudo-class reflects has changed.
+ *
+ * Only the view's selectors from the first one with this pseudo-class onward are applied, so the
+ * styles of less specific selectors registered before them are left alone.
+ *
+ * @fn NIDOM::setNeedsRefreshView:forPseudoClass:
+ * @param view         A registered view.
+ * @param pseudoClass  The pseudo-class, with or without the leading colon.
+ */
+
+/**
+ * Restyles the views that have been marked as needing it, in the order they were registered.
+ *
+ * This happens on its own before the main run loop waits, so only call it when the styles are
+ * needed sooner, e.g. to read a view's frame right after adding a CSS class.
+ *
+ * When the stylesheet, or the parent stylesheet, posts NIStylesheetDidChangeNotification, the
+ * views with selectors that NIStylesheet::didChangeRulesetsForClassName: reports are marked.
+ *
+ * @fn NIDOM::refreshIfNeeded
+ */
+
 /**
  * Removes the association of a view with a CSS class. Note that this doesn't
  * "undo" the styles that the CSS class generated, it just stops applying them
@@ -184,7 +252,9 @@ _dom = [[NIDOM alloc] initWithStylesheet:stylesheet];
 
 /**
  * Create an association of a view with a CSS class and apply relevant styles
- * immediately.
+ * before the next frame.
+ *
+ * Only the rulesets for the new class and its pseudo-classes are applied.
  *
  * @fn NIDOM::addCssClass:toView:
  */
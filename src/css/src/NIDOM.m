@@ -16,23 +16,71 @@
 
 #import "NIDOM.h"
 
+#import "NICSSRuleset.h"
 #import "NIStylesheet.h"
 #import "NimbusCore.h"
+#import <QuartzCore/QuartzCore.h>
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "Nimbus requires ARC support."
 #endif
 
+// Everything a DOM knows about one registered view.
+@interface NIDOMViewRecord : NSObject
+// The selectors to apply to the view, from the least to the most important.
+@property (nonatomic, readonly, strong) NSMutableArray* selectors;
+// The index of the first selector that must be applied again, or NSNotFound if the view is clean.
+// A view's later selectors override its earlier ones, so they must all be applied again too.
+@property (nonatomic, assign) NSUInteger firstDirtySelectorIndex;
+@property (nonatomic, assign, getter = isRegistered) BOOL registered;
+@end
+
+@implementation NIDOMViewRecord
+
+- (id)init {
+  if ((self = [super init])) {
+    _selectors = [[NSMutableArray alloc] init];
+    _firstDirtySelectorIndex = NSNotFound;
+  }
+  return self;
+}
+
+@end
+
 @interface NIDOM ()
 @property (nonatomic,strong) NIStylesheet* stylesheet;
-@property (nonatomic,strong) NSMutableArray* registeredViews;
-@property (nonatomic,strong) NSMutableDictionary* viewToSelectorsMap;
-@property (nonatomic,strong) NSMutableDictionary* idToViewMap;
-@property (nonatomic,strong) NIDOM *parent;
 @end
 
-@implementation NIDOM
+// Implemented in UIView+NIStyleable.m.
+@interface UIView (NIDOMLayoutPass)
+- (void)applyOrDescribeLayout: (BOOL) apply ruleSet: (NICSSRuleset*) ruleSet inDOM: (NIDOM*)dom withViewName: (NSString*) name description: (NSMutableString*) desc;
+- (UIView *)relativeViewForRuleSet:(NICSSRuleset *)ruleSet inDOM:(NIDOM *)dom;
+@end
 
+// How far a layout pass has got with a view.
+typedef enum {
+  NIDOMLayoutVisitInProgress = 1,
+  NIDOMLayoutVisitDone,
+} NIDOMLayoutVisit;
+
+@implementation NIDOM {
+  // The DOM doesn't keep views alive. Views are compared by identity and their records go away
+  // with them, so forgetting to unregister a view doesn't leak it.
+  NSPointerArray* _registeredViews;
+  NSMapTable* _viewToRecord;
+  NSMapTable* _idToView;
+  CFRunLoopObserverRef _flushObserver;
+
+  // The layout that the current layout pass has deferred, by view in the order it was deferred.
+  NSInteger _layoutPassDepth;
+  NSMutableArray* _pendingLayoutViews;
+  NIPointerMap* _pendingLayoutRuleSets;
+}
+
+- (void)dealloc {
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
+  [self cancelFlush];
+}
 
 + (id)domWithStylesheet:(NIStylesheet *)stylesheet {
   return [[self alloc] initWithStylesheet:stylesheet];
@@ -62,18 +110,35 @@
 
 +(id)domWithStylesheet:(NIStylesheet *)stylesheet andParentStyles:(NIStylesheet *)parentStyles
 {
-  NIDOM *dom = [[self alloc] initWithStylesheet:stylesheet];
-  if (parentStyles) {
-    dom.parent = [NIDOM domWithStylesheet:parentStyles andParentStyles:nil];
+  if (nil == parentStyles || nil == stylesheet) {
+    return [[self alloc] initWithStylesheet:(nil != stylesheet) ? stylesheet : parentStyles];
   }
-  return dom;
+  return [self domWithStylesheets:@[ parentStyles, stylesheet ]];
+}
+
++ (id)domWithStylesheets:(NSArray *)stylesheets {
+  // Styling through one layered stylesheet resolves and caches each selector once for the whole
+  // chain, rather than once for each stylesheet and view.
+  return [[self alloc] initWithStylesheet:[[NIStylesheet alloc] initWithLayeredStylesheets:stylesheets]];
 }
 
 - (id)initWithStylesheet:(NIStylesheet *)stylesheet {
   if ((self = [super init])) {
     _stylesheet = stylesheet;
-    _registeredViews = [[NSMutableArray alloc] init];
-    _viewToSelectorsMap = [[NSMutableDictionary alloc] init];
+    _registeredViews = [NSPointerArray weakObjectsPointerArray];
+    _viewToRecord = [NSMapTable weakToStrongObjectsMapTable];
+    _idToView = [NSMapTable strongToWeakObjectsMapTable];
+
+    if (nil != stylesheet) {
+      [[NSNotificationCenter defaultCenter] addObserver:self
+                                               selector:@selector(stylesheetDidChange:)
+                                                   name:NIStylesheetDidChangeNotification
+                                                 object:stylesheet];
+    }
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(mediaOrientationDidChange:)
+                                                 name:NIStylesheetMediaOrientationDidChangeNotification
+                                               object:nil];
   }
   return self;
 }
@@ -82,33 +147,247 @@
 
 
 - (void)refreshStyleForView:(UIView *)view withSelectorName:(NSString *)selectorName {
-  if (self.parent) {
-    [self.parent.stylesheet applyStyleToView:view withClassName:selectorName inDOM:self];
-  }
   [_stylesheet applyStyleToView:view withClassName:selectorName inDOM:self];
 }
 
+#pragma mark - Dirty Tracking
+
+
+- (void)setNeedsRefreshView:(UIView *)view fromSelectorAtIndex:(NSUInteger)selectorIndex {
+  NIDOMViewRecord* record = [_viewToRecord objectForKey:view];
+  if (nil == record) {
+    return;
+  }
+  record.firstDirtySelectorIndex = MIN(record.firstDirtySelectorIndex, selectorIndex);
+  [self scheduleFlush];
+}
+
+- (void)scheduleFlush {
+  if (NULL != _flushObserver) {
+    return;
+  }
+  // Flush before Core Animation commits the run loop turn's changes, whatever the run loop mode.
+  __weak NIDOM* weakSelf = self;
+  _flushObserver = CFRunLoopObserverCreateWithHandler(kCFAllocatorDefault, kCFRunLoopBeforeWaiting, NO, 0, ^(CFRunLoopObserverRef observer, CFRunLoopActivity activity) {
+    [weakSelf refreshIfNeeded];
+  });
+  CFRunLoopAddObserver(CFRunLoopGetMain(), _flushObserver, kCFRunLoopCommonModes);
+}
+
+- (void)cancelFlush {
+  if (NULL != _flushObserver) {
+    CFRunLoopObserverInvalidate(_flushObserver);
+    CFRelease(_flushObserver);
+    _flushObserver = NULL;
+  }
+}
+
+- (void)refreshIfNeeded {
+  // A scheduled flush is the only sign that a view is dirty.
+  if (NULL == _flushObserver) {
+    return;
+  }
+  [self cancelFlush];
+  [self compactRegisteredViews];
+
+  [CATransaction begin];
+  [CATransaction setDisableActions:YES];
+  [self beginLayoutPass];
+  // Views are restyled in the order they were registered so that superviews are sized first.
+  for (UIView* view in [_registeredViews allObjects]) {
+    NIDOMViewRecord* record = [_viewToRecord objectForKey:view];
+    NSUInteger firstDirtyIndex = record.firstDirtySelectorIndex;
+    if (nil == record || NSNotFound == firstDirtyIndex) {
+      continue;
+    }
+    record.firstDirtySelectorIndex = NSNotFound;
+    NSArray* selectors = [record.selectors copy];
+    for (NSUInteger ix = firstDirtyIndex; ix < [selectors count]; ++ix) {
+      [self refreshStyleForView:view withSelectorName:[selectors objectAtIndex:ix]];
+    }
+  }
+  [self endLayoutPass];
+  [CATransaction commit];
+}
+
+// Drops the slots of views that have been deallocated.
+- (void)compactRegisteredViews {
+  // -compact only removes NULLs that were added explicitly, so add one to make it do its job.
+  [_registeredViews addPointer:NULL];
+  [_registeredViews compact];
+}
+
+// Marks each view from its first selector for which the test returns YES.
+- (void)setNeedsRefreshViewsWithSelectorsPassingTest:(BOOL (^)(NSString* selector))test {
+  // Many views share selectors, so each is only tested once.
+  NSMutableDictionary* selectorDidPass = [NSMutableDictionary dictionary];
+  for (UIView* view in [_registeredViews allObjects]) {
+    NSArray* selectors = [[_viewToRecord objectForKey:view] selectors];
+    for (NSUInteger ix = 0; ix < [selectors count]; ++ix) {
+      NSString* selector = [selectors objectAtIndex:ix];
+      NSNumber* didPass = [selectorDidPass objectForKey:selector];
+      if (nil == didPass) {
+        didPass = [NSNumber numberWithBool:test(selector)];
+        [selectorDidPass setObject:didPass forKey:selector];
+      }
+      if ([didPass boolValue]) {
+        [self setNeedsRefreshView:view fromSelectorAtIndex:ix];
+        break;
+      }
+    }
+  }
+}
+
+- (void)stylesheetDidChange:(NSNotification *)notification {
+  NIStylesheet* stylesheet = notification.object;
+  [self setNeedsRefreshViewsWithSelectorsPassingTest:^BOOL(NSString* selector) {
+    return [stylesheet didChangeRulesetsForClassName:selector];
+  }];
+}
+
+- (void)mediaOrientationDidChange:(NSNotification *)notification {
+  // The stylesheet has cached rulesets for each orientation, so only the views with rulesets
+  // for just one orientation need to be restyled.
+  NIStylesheet* stylesheet = _stylesheet;
+  [self setNeedsRefreshViewsWithSelectorsPassingTest:^BOOL(NSString* selector) {
+    return [stylesheet hasMediaRulesetsForClassName:selector];
+  }];
+}
+
+#pragma mark - Layout Pass
+
+
+// Positioning a view reads the frames of its superview and of the views it's positioned relative
+// to, so styling views one at a time can position a view against a sibling that is then moved by
+// its own styles. During a layout pass, appearance is applied as usual but layout is collected,
+// and when the outermost pass ends every view is laid out once, after the views it depends on.
+- (void)beginLayoutPass {
+  if (0 == _layoutPassDepth++) {
+    _pendingLayoutViews = [[NSMutableArray alloc] init];
+    _pendingLayoutRuleSets =
+        [[NIPointerMap alloc] initWithOptions:NIPointerCollectionOptionRetainKeys];
+  }
+}
+
+- (void)endLayoutPass {
+  NIDASSERT(_layoutPassDepth > 0);
+  if (_layoutPassDepth > 0 && 0 == --_layoutPassDepth) {
+    [self layOutPendingViews];
+  }
+}
+
+- (BOOL)deferLayoutOfView:(UIView *)view withRuleSet:(NICSSRuleset *)ruleSet {
+  if (0 == _layoutPassDepth) {
+    return NO;
+  }
+  NSMutableArray* ruleSets = [_pendingLayoutRuleSets objectForKey:view];
+  if (nil == ruleSets) {
+    ruleSets = [[NSMutableArray alloc] init];
+    [_pendingLayoutRuleSets setObject:ruleSets forKey:view];
+    [_pendingLayoutViews addObject:view];
+  }
+  [ruleSets addObject:ruleSet];
+  return YES;
+}
+
+- (void)layOutPendingViews {
+  NSArray* views = _pendingLayoutViews;
+  NIPointerMap* viewToRuleSets = _pendingLayoutRuleSets;
+  _pendingLayoutViews = nil;
+  _pendingLayoutRuleSets = nil;
+
+  // A view depends on its superview and on the views it's positioned relative to, as long as they
+  // are being laid out in this pass too.
+  NIPointerMap* viewToDependencies =
+      [[NIPointerMap alloc] initWithOptions:NIPointerCollectionOptionRetainKeys];
+  for (UIView* view in views) {
+    NSMutableArray* dependencies = [NSMutableArray array];
+    if (nil != view.superview && nil != [viewToRuleSets objectForKey:view.superview]) {
+      [dependencies addObject:view.superview];
+    }
+    for (NICSSRuleset* ruleSet in [viewToRuleSets objectForKey:view]) {
+      UIView* relative = [view relativeViewForRuleSet:ruleSet inDOM:self];
+      if (nil != relative && nil != [viewToRuleSets objectForKey:relative]) {
+        [dependencies addObject:relative];
+      }
+    }
+    [viewToDependencies setObject:dependencies forKey:view];
+  }
+
+  NSMutableArray* layoutOrder = [NSMutableArray arrayWithCapacity:[views count]];
+  NIPointerMap* visits = [[NIPointerMap alloc] initWithOptions:NIPointerCollectionOptionRetainKeys];
+  NSMutableArray* path = [NSMutableArray array];
+  for (UIView* view in views) {
+    [self addView:view toLayoutOrder:layoutOrder dependencies:viewToDependencies visits:visits path:path];
+  }
+
+  for (UIView* view in layoutOrder) {
+    for (NICSSRuleset* ruleSet in [viewToRuleSets objectForKey:view]) {
+      [view applyOrDescribeLayout:YES ruleSet:ruleSet inDOM:self withViewName:nil description:nil];
+    }
+  }
+}
+
+// Sorts the views topologically, depth first, so that views that don't depend on each other keep
+// the order in which they were styled.
+- (void)addView:(UIView *)view
+  toLayoutOrder:(NSMutableArray *)layoutOrder
+   dependencies:(NIPointerMap *)viewToDependencies
+         visits:(NIPointerMap *)visits
+           path:(NSMutableArray *)path {
+  NIDOMLayoutVisit visit = [[visits objectForKey:view] intValue];
+  if (NIDOMLayoutVisitDone == visit) {
+    return;
+  }
+  if (NIDOMLayoutVisitInProgress == visit) {
+    // The view at the end of the path is laid out without waiting for this one.
+    NSMutableArray* names = [NSMutableArray array];
+    for (NSUInteger ix = [path indexOfObjectIdenticalTo:view]; ix < [path count]; ++ix) {
+      [names addObject:[self debugNameForView:[path objectAtIndex:ix]]];
+    }
+    [names addObject:[self debugNameForView:view]];
+    NIDERROR(@"Layout cycle %@. %@ will be laid out before the view it depends on.",
+             [names componentsJoinedByString:@" -> "], [self debugNameForView:[path lastObject]]);
+    return;
+  }
+
+  [visits setObject:[NSNumber numberWithInt:NIDOMLayoutVisitInProgress] forKey:view];
+  [path addObject:view];
+  for (UIView* dependency in [viewToDependencies objectForKey:view]) {
+    [self addView:dependency toLayoutOrder:layoutOrder dependencies:viewToDependencies visits:visits path:path];
+  }
+  [path removeLastObject];
+  [visits setObject:[NSNumber numberWithInt:NIDOMLayoutVisitDone] forKey:view];
+  [layoutOrder addObject:view];
+}
+
+// The view's id if it has one, so that layout errors can be traced back to the stylesheet.
+- (NSString *)debugNameForView:(UIView *)view {
+  for (NSString* selector in [[_viewToRecord objectForKey:view] selectors]) {
+    if ([selector hasPrefix:@"#"]) {
+      return selector;
+    }
+  }
+  return [NSString stringWithFormat:@"<%@: %p>", NSStringFromClass([view class]), view];
+}
+
 #pragma mark - Public
 
 
-- (id)keyForView:(UIView *)view {
-  return [NSNumber numberWithLong:(long)view];
+- (NIDOMViewRecord *)recordForView:(UIView *)view {
+  NIDOMViewRecord* record = [_viewToRecord objectForKey:view];
+  if (nil == record) {
+    record = [[NIDOMViewRecord alloc] init];
+    [_viewToRecord setObject:record forKey:view];
+  }
+  return record;
 }
 
 - (void)registerSelector:(NSString *)selector withView:(UIView *)view {
-  id key = [self keyForView:view];
-  NSMutableArray* selectors = [_viewToSelectorsMap objectForKey:key];
-  if (nil == selectors) {
-    selectors = [[NSMutableArray alloc] init];
-    [_viewToSelectorsMap setObject:selectors forKey:key];
-  }
-  [selectors addObject:selector];
+  [[self recordForView:view].selectors addObject:selector];
 }
 
 - (void)registerView:(UIView *)view {
-  if (self.parent) {
-    [self.parent registerView:view];
-  }
   NSString* selector = NSStringFromClass([view class]);
   [self registerSelector:selector withView:view];
   
@@ -122,7 +401,11 @@
     }
   }
   
-  [_registeredViews addObject:view];
+  NIDOMViewRecord* record = [self recordForView:view];
+  if (!record.isRegistered) {
+    record.registered = YES;
+    [_registeredViews addPointer:(__bridge void *)view];
+  }
   [self refreshStyleForView:view withSelectorName:selector];
   if (pseudos) {
     for (NSString *ps in pseudos) {
@@ -139,27 +422,18 @@
   NSArray *pseudos = nil;
   if (viewId) {
     if (![viewId hasPrefix:@"#"]) { viewId = [@"#" stringByAppendingString:viewId]; }
-    if (self.parent) {
-      [self.parent registerSelector:viewId withView:view];
-    }
     [self registerSelector:viewId withView:view];
     
     if ([view respondsToSelector:@selector(pseudoClasses)]) {
       pseudos = (NSArray*) [view performSelector:@selector(pseudoClasses)];
       if (pseudos) {
         for (NSString *ps in pseudos) {
-          if (self.parent) {
-            [self.parent registerSelector:[viewId stringByAppendingString:ps] withView:view];
-          }
           [self registerSelector:[viewId stringByAppendingString:ps] withView:view];
         }
       }
     }
 
-    if (!_idToViewMap) {
-      _idToViewMap = [[NSMutableDictionary alloc] init];
-    }
-    [_idToViewMap setObject:view forKey:viewId];
+    [_idToView setObject:view forKey:viewId];
     // Run the id selectors last so they take precedence
     [self refreshStyleForView:view withSelectorName:viewId];
     if (pseudos) {
@@ -173,9 +447,6 @@
 - (void)registerView:(UIView *)view withCSSClass:(NSString *)cssClass registerMainView: (BOOL) registerMainView
 {
   if (registerMainView) {
-    if (self.parent) {
-      [self.parent registerView:view withCSSClass:cssClass registerMainView:NO];
-    }
     [self registerView:view];
   }
   
@@ -205,24 +476,21 @@
     }
   }
   
-  [self refreshStyleForView:view withSelectorName:selector];
-  if (pseudos) {
-    for (NSString *ps in pseudos) {
-      [self refreshStyleForView:view withSelectorName:[selector stringByAppendingString:ps]];
-    }
-  }
+  // Only the new selectors need to be applied, and they were registered last.
+  NSUInteger selectorCount = [[self recordForView:view].selectors count];
+  [self setNeedsRefreshView:view fromSelectorAtIndex:selectorCount - 1 - [pseudos count]];
 }
 
 -(void)removeCssClass:(NSString *)cssClass fromView:(UIView *)view {
   NSString* selector = [@"." stringByAppendingString:cssClass];
   NSString* pseudoBase = [selector stringByAppendingString:@":"];
-  NSMutableArray *selectors = [_viewToSelectorsMap objectForKey:[self keyForView:view]];
+  NSMutableArray *selectors = [[_viewToRecord objectForKey:view] selectors];
   if (selectors) {
     // Iterate over the selectors finding the id selector (if any) so we can
     // also remove it from the id map
     for (NSUInteger i = selectors.count; i >= 1; i--) {
       NSString *s = [selectors objectAtIndex:i - 1];
-      if ([s isEqualToString:selector] && [s hasPrefix:pseudoBase]) {
+      if ([s isEqualToString:selector] || [s hasPrefix:pseudoBase]) {
         [selectors removeObjectAtIndex:i - 1];
       }
     }
@@ -230,44 +498,74 @@
 }
 
 - (void)unregisterView:(UIView *)view {
-  [_registeredViews removeObject:view];
-  NSArray *selectors = [_viewToSelectorsMap objectForKey:[self keyForView:view]];
+  for (NSUInteger ix = 0; ix < [_registeredViews count]; ++ix) {
+    if ([_registeredViews pointerAtIndex:ix] == (__bridge void *)view) {
+      [_registeredViews removePointerAtIndex:ix];
+      break;
+    }
+  }
+  NSArray *selectors = [[_viewToRecord objectForKey:view] selectors];
   if (selectors) {
     // Iterate over the selectors finding the id selector (if any) so we can
     // also remove it from the id map
     for (NSString *s in selectors) {
       if ([s characterAtIndex:0] == '#') {
-        [_idToViewMap removeObjectForKey:s];
+        [_idToView removeObjectForKey:s];
       }
     }
   }
-  [_viewToSelectorsMap removeObjectForKey:[self keyForView:view]];
+  [_viewToRecord removeObjectForKey:view];
+  // A view unregistered during a layout pass is no longer the DOM's to lay out.
+  if (nil != [_pendingLayoutRuleSets objectForKey:view]) {
+    [_pendingLayoutRuleSets removeObjectForKey:view];
+    [_pendingLayoutViews removeObjectIdenticalTo:view];
+  }
 }
 
 - (void)unregisterAllViews {
-  [_registeredViews removeAllObjects];
-  [_viewToSelectorsMap removeAllObjects];
-  [_idToViewMap removeAllObjects];
+  _registeredViews = [NSPointerArray weakObjectsPointerArray];
+  [_viewToRecord removeAllObjects];
+  [_idToView removeAllObjects];
+  [_pendingLayoutViews removeAllObjects];
+  [_pendingLayoutRuleSets removeAllObjects];
+  [self cancelFlush];
 }
 
-- (void)refresh {
-  for (UIView* view in _registeredViews) {
-    for (NSString* selector in [_viewToSelectorsMap objectForKey:[self keyForView:view]]) {
-      [self refreshStyleForView:view withSelectorName:selector];
-    }
+- (void)setNeedsRefresh {
+  for (UIView* view in [_registeredViews allObjects]) {
+    [self setNeedsRefreshView:view fromSelectorAtIndex:0];
+  }
+}
+
+- (void)setNeedsRefreshView:(UIView *)view {
+  [self setNeedsRefreshView:view fromSelectorAtIndex:0];
+}
+
+- (void)setNeedsRefreshView:(UIView *)view forPseudoClass:(NSString *)pseudoClass {
+  NSString* suffix = [pseudoClass hasPrefix:@":"] ? pseudoClass : [@":" stringByAppendingString:pseudoClass];
+  NSArray* selectors = [[_viewToRecord objectForKey:view] selectors];
+  NSUInteger ix = [selectors indexOfObjectPassingTest:^BOOL(NSString* selector, NSUInteger idx, BOOL *stop) {
+    return [selector hasSuffix:suffix];
+  }];
+  if (ix != NSNotFound) {
+    [self setNeedsRefreshView:view fromSelectorAtIndex:ix];
   }
 }
 
+- (void)refresh {
+  [self setNeedsRefresh];
+  [self refreshIfNeeded];
+}
+
 - (void)refreshView:(UIView *)view {
-    for (NSString* selector in [_viewToSelectorsMap objectForKey:[self keyForView:view]]) {
-        [self refreshStyleForView:view withSelectorName:selector];
-    }
+  [self setNeedsRefreshView:view];
+  [self refreshIfNeeded];
 }
 
 -(UIView *)viewById:(NSString *)viewId
 {
   if (![viewId hasPrefix:@"#"]) { viewId = [@"#" stringByAppendingString:viewId]; }
-  return [_idToViewMap objectForKey:viewId];
+  return [_idToView objectForKey:viewId];
 }
 
 -(NSString *)descriptionForView:(UIView *)view withName:(NSString *)viewName
@@ -275,21 +573,11 @@
   NSMutableString *description = [[NSMutableString alloc] init];
   BOOL appendedStyleInfo = NO;
   
-  for (NSString *selector in [_viewToSelectorsMap objectForKey:[self keyForView:view]]) {
-    BOOL appendedSelectorInfo = NO;
-    NSString *additional = nil;
-    if (self.parent) {
-      additional = [self.parent.stylesheet descriptionForView: view withClassName: selector inDOM:self andViewName: viewName];
-      if (additional && additional.length) {
-        if (!appendedStyleInfo) { appendedStyleInfo = YES; [description appendFormat:@"// Styles for %@\n", viewName]; }
-        if (!appendedSelectorInfo) { appendedSelectorInfo = YES; [description appendFormat:@"// Selector %@\n", selector]; }
-        [description appendString:additional];
-      }
-    }
-    additional = [_stylesheet descriptionForView:view withClassName: selector inDOM:self andViewName: viewName];
+  for (NSString *selector in [[_viewToRecord objectForKey:view] selectors]) {
+    NSString *additional = [_stylesheet descriptionForView:view withClassName: selector inDOM:self andViewName: viewName];
     if (additional && additional.length) {
       if (!appendedStyleInfo) { appendedStyleInfo = YES; [description appendFormat:@"// Styles for %@\n", viewName]; }
-      if (!appendedSelectorInfo) { [description appendFormat:@"// Selector %@\n", selector]; }
+      [description appendFormat:@"// Selector %@\n", selector];
       [description appendString:additional];
     }
   }
@@ -299,12 +587,12 @@
 -(NSString *)descriptionForAllViews {
   NSMutableString *description = [[NSMutableString alloc] init];
   int viewCount = 0;
-  for (UIView *view in _registeredViews) {
+  for (UIView *view in [_registeredViews allObjects]) {
     [description appendString:@"\n///////////////////////////////////////////////////////////////////////////////////////////////////\n"];
     viewCount++;
     // This is a little hokey - because we don't get individual view names we have to come up with some.
     __block NSString *vid = nil;
-    [[_viewToSelectorsMap objectForKey:[self keyForView:view]] enumerateObjectsUsingBlock:^(NSString *selector, NSUInteger idx, BOOL *stop) {
+    [[[_viewToRecord objectForKey:view] selectors] enumerateObjectsUsingBlock:^(NSString *selector, NSUInteger idx, BOOL *stop) {
       if ([selector hasPrefix:@"#"]) {
         vid = [selector substringFromIndex:1];
         *stop = YES;
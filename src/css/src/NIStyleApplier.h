@@ -0,0 +1,80 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+@class NICSSRuleset;
+@class NIDOM;
+
+/**
+ * Sets one or more style properties on a view.
+ *
+ * @ingroup NimbusCSS
+ */
+typedef void (^NIStyleSetter)(id view, NIDOM* dom);
+
+/**
+ * Applies a compiled ruleset to views of one class.
+ *
+ * @ingroup NimbusCSS
+ *
+ * Building an applier works out once which properties the ruleset has and how the view class
+ * applies them, leaving a short list of setters. Applying the style to another view of the same
+ * class then only runs those setters, without testing every property of the ruleset again.
+ *
+ * UIView and UILabel properties are set directly. Views whose classes override the NIStyleable
+ * methods are styled by calling those methods, so custom styling keeps working.
+ *
+ * NIStylesheet caches an applier for every class name and view class that it styles.
+ */
+@interface NIStyleApplier : NSObject
+
++ (NIStyleApplier *)applierForViewClass:(Class)viewClass
+                                ruleSet:(NICSSRuleset *)ruleSet
+                            pseudoClass:(NSString *)pseudoClass;
+
+- (void)applyToView:(UIView *)view inDOM:(NIDOM *)dom;
+
+@property (nonatomic, readonly, copy) NSArray* setters;
+
+@end
+
+/**
+ * Returns an applier for views of the given class.
+ *
+ * @fn NIStyleApplier::applierForViewClass:ruleSet:pseudoClass:
+ * @param viewClass    The class of the views that the applier will style.
+ * @param ruleSet      The compiled ruleset to apply.
+ * @param pseudoClass  [optional] The pseudo-class of the ruleset, without the leading colon.
+ *                          Views that implement applyStyleWithRuleSet:forPseudoClass:inDOM:
+ *                          are given it.
+ */
+
+/**
+ * Runs every setter of this applier on the given view.
+ *
+ * @fn NIStyleApplier::applyToView:inDOM:
+ * @param view  A view of the class that this applier was built for.
+ * @param dom   [optional] The DOM responsible for applying this style.
+ */
+
+/**
+ * The NIStyleSetter blocks run by applyToView:inDOM:, in order.
+ *
+ * @fn NIStyleApplier::setters
+ */
@@ -0,0 +1,248 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIStyleApplier.h"
+
+#import "NICSSRuleset.h"
+#import "NIStyleable.h"
+#import "NIUserInterfaceString.h"
+#import "UILabel+NIStyleable.h"
+#import "UIView+NIStyleable.h"
+#import "NimbusCore.h"
+#import <QuartzCore/QuartzCore.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+@interface UIView (NIStyleApplierLayout)
+- (void)applyOrDescribeLayout: (BOOL) apply ruleSet: (NICSSRuleset*) ruleSet inDOM: (NIDOM*)dom withViewName: (NSString*) name description: (NSMutableString*) desc;
+@end
+
+@interface NIStyleApplier()
+@property (nonatomic, copy) NSArray* setters;
+@end
+
+// The ways in which a view class may have its style applied, most direct first.
+typedef enum {
+  NIStyleApplierKindPseudoClass,
+  NIStyleApplierKindLabel,
+  NIStyleApplierKindView,
+  NIStyleApplierKindStyleable,
+} NIStyleApplierKind;
+
+static BOOL NIClassUsesImplementationOf(Class viewClass, Class baseClass, SEL selector) {
+  return [viewClass instanceMethodForSelector:selector] == [baseClass instanceMethodForSelector:selector];
+}
+
+static NIStyleApplierKind NIStyleApplierKindForViewClass(Class viewClass, NSString* pseudoClass) {
+  if (nil != pseudoClass
+      && [viewClass instancesRespondToSelector:@selector(applyStyleWithRuleSet:forPseudoClass:inDOM:)]) {
+    return NIStyleApplierKindPseudoClass;
+  }
+  // Setting properties directly is only equivalent to calling the NIStyleable methods when the
+  // class does not override any of the methods that they call.
+  if (![viewClass isSubclassOfClass:[UIView class]]
+      || !NIClassUsesImplementationOf(viewClass, [UIView class], @selector(applyViewStyleWithRuleSet:inDOM:))) {
+    return NIStyleApplierKindStyleable;
+  }
+  if ([viewClass isSubclassOfClass:[UILabel class]]) {
+    if (NIClassUsesImplementationOf(viewClass, [UILabel class], @selector(applyStyleWithRuleSet:inDOM:))
+        && NIClassUsesImplementationOf(viewClass, [UILabel class], @selector(applyLabelStyleBeforeViewWithRuleSet:inDOM:))
+        && NIClassUsesImplementationOf(viewClass, [UILabel class], @selector(applyLabelStyleWithRuleSet:inDOM:))) {
+      return NIStyleApplierKindLabel;
+    }
+    return NIStyleApplierKindStyleable;
+  }
+  if (NIClassUsesImplementationOf(viewClass, [UIView class], @selector(applyStyleWithRuleSet:inDOM:))) {
+    return NIStyleApplierKindView;
+  }
+  return NIStyleApplierKindStyleable;
+}
+
+static BOOL NIRuleSetHasLayout(NICSSRuleset* ruleSet) {
+  return ([ruleSet hasWidth] || [ruleSet hasHeight]
+          || [ruleSet hasHorizontalPadding] || [ruleSet hasVerticalPadding]
+          || [ruleSet hasMinWidth] || [ruleSet hasMinHeight]
+          || [ruleSet hasMaxWidth] || [ruleSet hasMaxHeight]
+          || [ruleSet hasTop] || [ruleSet hasLeft] || [ruleSet hasRight] || [ruleSet hasBottom]
+          || [ruleSet hasFrameHorizontalAlign] || [ruleSet hasFrameVerticalAlign]
+          || [ruleSet hasRelativeToId]);
+}
+
+// Mirrors -[UIView applyOrDescribe:ruleSet:inDOM:withViewName:].
+static void NIAddViewStyleSetters(NICSSRuleset* ruleSet, NSMutableArray* setters) {
+  if ([ruleSet hasBackgroundColor]) {
+    UIColor* backgroundColor = ruleSet.backgroundColor;
+    [setters addObject:^(UIView* view, NIDOM* dom) { view.backgroundColor = backgroundColor; }];
+  }
+  if ([ruleSet hasOpacity]) {
+    CGFloat opacity = ruleSet.opacity;
+    [setters addObject:^(UIView* view, NIDOM* dom) { view.alpha = opacity; }];
+  }
+  if ([ruleSet hasBorderRadius]) {
+    CGFloat borderRadius = ruleSet.borderRadius;
+    [setters addObject:^(UIView* view, NIDOM* dom) { view.layer.cornerRadius = borderRadius; }];
+  }
+  if ([ruleSet hasBorderWidth]) {
+    CGFloat borderWidth = ruleSet.borderWidth;
+    [setters addObject:^(UIView* view, NIDOM* dom) { view.layer.borderWidth = borderWidth; }];
+  }
+  if ([ruleSet hasBorderColor]) {
+    UIColor* borderColor = ruleSet.borderColor;
+    [setters addObject:^(UIView* view, NIDOM* dom) { view.layer.borderColor = borderColor.CGColor; }];
+  }
+  if ([ruleSet hasAutoresizing]) {
+    UIViewAutoresizing autoresizing = ruleSet.autoresizing;
+    [setters addObject:^(UIView* view, NIDOM* dom) { view.autoresizingMask = autoresizing; }];
+  }
+  if ([ruleSet hasVisible]) {
+    BOOL hidden = !ruleSet.visible;
+    [setters addObject:^(UIView* view, NIDOM* dom) { view.hidden = hidden; }];
+  }
+
+  // Sizing and positioning read the superview, the DOM and the results of each other, so they
+  // stay one setter that runs the same code as applyViewStyleWithRuleSet:inDOM:.
+  if (NIRuleSetHasLayout(ruleSet)) {
+    [setters addObject:^(UIView* view, NIDOM* dom) {
+      [view applyOrDescribeLayout:YES ruleSet:ruleSet inDOM:dom withViewName:nil description:nil];
+    }];
+  }
+}
+
+// Mirrors -[UILabel applyLabelStyleBeforeViewWithRuleSet:inDOM:].
+static void NIAddLabelStyleBeforeViewSetters(NICSSRuleset* ruleSet, NSMutableArray* setters) {
+  if ([ruleSet hasTextKey]) {
+    NSString* textKey = ruleSet.textKey;
+    [setters addObject:^(UILabel* label, NIDOM* dom) {
+      NIUserInterfaceString *nis = [[NIUserInterfaceString alloc] initWithKey:textKey];
+      [nis attach:label withSelector:@selector(setText:)];
+    }];
+  }
+}
+
+// Mirrors -[UILabel applyLabelStyleWithRuleSet:inDOM:].
+static void NIAddLabelStyleSetters(NICSSRuleset* ruleSet, NSMutableArray* setters) {
+  if ([ruleSet hasTextColor]) {
+    UIColor* textColor = ruleSet.textColor;
+    [setters addObject:^(UILabel* label, NIDOM* dom) { label.textColor = textColor; }];
+  }
+  if ([ruleSet hasHighlightedTextColor]) {
+    UIColor* highlightedTextColor = ruleSet.highlightedTextColor;
+    [setters addObject:^(UILabel* label, NIDOM* dom) { label.highlightedTextColor = highlightedTextColor; }];
+  }
+  if ([ruleSet hasTextAlignment]) {
+    NSTextAlignment textAlignment = ruleSet.textAlignment;
+    [setters addObject:^(UILabel* label, NIDOM* dom) { label.textAlignment = textAlignment; }];
+  }
+  if ([ruleSet hasFont]) {
+    UIFont* font = ruleSet.font;
+    [setters addObject:^(UILabel* label, NIDOM* dom) { label.font = font; }];
+  }
+  if ([ruleSet hasTextShadowColor]) {
+    UIColor* shadowColor = ruleSet.textShadowColor;
+    [setters addObject:^(UILabel* label, NIDOM* dom) { label.shadowColor = shadowColor; }];
+  }
+  if ([ruleSet hasTextShadowOffset]) {
+    CGSize shadowOffset = ruleSet.textShadowOffset;
+    [setters addObject:^(UILabel* label, NIDOM* dom) { label.shadowOffset = shadowOffset; }];
+  }
+  if ([ruleSet hasLineBreakMode]) {
+    NSLineBreakMode lineBreakMode = ruleSet.lineBreakMode;
+    [setters addObject:^(UILabel* label, NIDOM* dom) { label.lineBreakMode = lineBreakMode; }];
+  }
+  if ([ruleSet hasNumberOfLines]) {
+    NSInteger numberOfLines = ruleSet.numberOfLines;
+    [setters addObject:^(UILabel* label, NIDOM* dom) { label.numberOfLines = numberOfLines; }];
+  }
+  if ([ruleSet hasMinimumFontSize]) {
+    CGFloat minimumFontSize = ruleSet.minimumFontSize;
+    [setters addObject:^(UILabel* label, NIDOM* dom) { label.minimumFontSize = minimumFontSize; }];
+  }
+  if ([ruleSet hasAdjustsFontSize]) {
+    BOOL adjustsFontSize = ruleSet.adjustsFontSize;
+    [setters addObject:^(UILabel* label, NIDOM* dom) { label.adjustsFontSizeToFitWidth = adjustsFontSize; }];
+  }
+  if ([ruleSet hasBaselineAdjustment]) {
+    UIBaselineAdjustment baselineAdjustment = ruleSet.baselineAdjustment;
+    [setters addObject:^(UILabel* label, NIDOM* dom) { label.baselineAdjustment = baselineAdjustment; }];
+  }
+}
+
+@implementation NIStyleApplier
+
++ (NIStyleApplier *)applierForViewClass:(Class)viewClass
+                                ruleSet:(NICSSRuleset *)ruleSet
+                            pseudoClass:(NSString *)pseudoClass {
+  NIDASSERT(nil != viewClass);
+  NIDASSERT(nil != ruleSet);
+  [ruleSet compile];
+
+  NSMutableArray* setters = [NSMutableArray array];
+  NIStyleApplierKind kind = NIStyleApplierKindForViewClass(viewClass, pseudoClass);
+  switch (kind) {
+    case NIStyleApplierKindPseudoClass: {
+      NSString* pseudo = [pseudoClass copy];
+      [setters addObject:^(id<NIStyleable> view, NIDOM* dom) {
+        [view applyStyleWithRuleSet:ruleSet forPseudoClass:pseudo inDOM:dom];
+      }];
+      break;
+    }
+    case NIStyleApplierKindLabel:
+      // Positioning may depend on the label's text, so the text is set before the view styles.
+      NIAddLabelStyleBeforeViewSetters(ruleSet, setters);
+      NIAddViewStyleSetters(ruleSet, setters);
+      NIAddLabelStyleSetters(ruleSet, setters);
+      break;
+    case NIStyleApplierKindView:
+      NIAddViewStyleSetters(ruleSet, setters);
+      break;
+    case NIStyleApplierKindStyleable:
+      if ([viewClass instancesRespondToSelector:@selector(applyStyleWithRuleSet:inDOM:)]) {
+        [setters addObject:^(id<NIStyleable> view, NIDOM* dom) {
+          [view applyStyleWithRuleSet:ruleSet inDOM:dom];
+        }];
+      }
+      break;
+  }
+
+  // Classes that still only implement the deprecated method are given the ruleset through it too.
+  // UILabel's own implementation just applies the same styles again without a DOM.
+  if (kind != NIStyleApplierKindPseudoClass
+      && [viewClass instancesRespondToSelector:@selector(applyStyleWithRuleSet:)]
+      && !(kind == NIStyleApplierKindLabel
+           && NIClassUsesImplementationOf(viewClass, [UILabel class], @selector(applyStyleWithRuleSet:)))) {
+    [setters addObject:^(id<NIStyleable> view, NIDOM* dom) {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+      [view applyStyleWithRuleSet:ruleSet];
+#pragma clang diagnostic pop
+    }];
+  }
+
+  NIStyleApplier* applier = [[self alloc] init];
+  applier.setters = setters;
+  return applier;
+}
+
+- (void)applyToView:(UIView *)view inDOM:(NIDOM *)dom {
+  for (NIStyleSetter setter in _setters) {
+    setter(view, dom);
+  }
+}
+
+@end
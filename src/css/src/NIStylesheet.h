@@ -29,10 +29,32 @@
  * This notification will be sent with the stylesheet as the object. Listeners should add
  * themselves using the stylesheet object that they are interested in.
  *
- * The NSNotification userInfo object will be nil.
+ * The NSNotification userInfo may hold the scopes that changed under
+ * NIStylesheetChangedScopesKey. Listeners that only care about some views can use this, or
+ * NIStylesheet::didChangeRulesetsForClassName:, to leave the others alone.
  */
 extern NSString* const NIStylesheetDidChangeNotification;
 
+/**
+ * The NSSet of scopes whose rulesets changed, in the userInfo of an
+ * NIStylesheetDidChangeNotification.
+ *
+ * @ingroup NimbusCSS
+ */
+extern NSString* const NIStylesheetChangedScopesKey;
+
+/**
+ * The notification key for when NIStylesheet::mediaOrientation changes between portrait and
+ * landscape.
+ *
+ * @ingroup NimbusCSS
+ *
+ * This notification is sent without an object. Views styled by rulesets from
+ * @htmlonly@media portrait@endhtmlonly or @htmlonly@media landscape@endhtmlonly blocks need to
+ * be restyled; NIDOM does this for the views it manages.
+ */
+extern NSString* const NIStylesheetMediaOrientationDidChangeNotification;
+
 /**
  * Loads and caches information regarding a specific stylesheet.
  *
@@ -44,15 +66,29 @@ extern NSString* const NIStylesheetDidChangeNotification;
  * Stylesheets can be merged using the addStylesheet: method.
  *
  * Cached rulesets are released when a memory warning is received.
+ *
+ * Rulesets can be looked up from any thread, for example to size cells with the fonts and
+ * paddings their views will be styled with on a background queue. Each ruleset is compiled
+ * before it is handed out and is never changed afterwards. Applying styles to views must still
+ * happen on the main thread.
  */
 @interface NIStylesheet : NSObject {
 @private
   NSDictionary* _rawRulesets;
   NSMutableDictionary* _ruleSets;
   NSDictionary* _significantScopeToScopes;
+  NSMutableDictionary* _styleAppliers;
+  NSSet* _changedScopes;
+  NSDictionary* _changedSignificantScopeToScopes;
+  BOOL _hasMediaScopes;
+  NSArray* _layeredStylesheets;
 }
 
 @property (nonatomic, readonly, copy) NSSet* dependencies;
+@property (nonatomic, readonly, copy) NSSet* changedScopes;
+@property (nonatomic, readonly, copy) NSArray* layeredStylesheets;
+
+- (id)initWithLayeredStylesheets:(NSArray *)stylesheets;
 
 - (BOOL)loadFromPath:(NSString *)path
           pathPrefix:(NSString *)pathPrefix
@@ -60,6 +96,13 @@ extern NSString* const NIStylesheetDidChangeNotification;
 - (BOOL)loadFromPath:(NSString *)path pathPrefix:(NSString *)path;
 - (BOOL)loadFromPath:(NSString *)path;
 
+- (BOOL)loadFromData:(NSData *)data
+          pathPrefix:(NSString *)pathPrefix
+            delegate:(id<NICSSParserDelegate>)delegate;
+
++ (BOOL)compileStylesheetAtPath:(NSString *)path pathPrefix:(NSString *)pathPrefix toPath:(NSString *)compiledPath;
++ (NSString *)compiledPathForPath:(NSString *)path;
+
 - (void)addStylesheet:(NIStylesheet *)stylesheet;
 
 - (void)applyStyleToView:(UIView *)view withClassName:(NSString *)className inDOM: (NIDOM*)dom;
@@ -67,6 +110,16 @@ extern NSString* const NIStylesheetDidChangeNotification;
 - (NSString*)descriptionForView:(UIView *)view withClassName:(NSString *)className inDOM: (NIDOM*)dom andViewName: (NSString*) viewName;
 
 - (NICSSRuleset *)rulesetForClassName:(NSString *)className;
+- (NICSSRuleset *)rulesetForViewClassName:(NSString *)viewClassName
+                                 cssClass:(NSString *)cssClass
+                                   viewId:(NSString *)viewId
+                              pseudoClass:(NSString *)pseudoClass;
+
+- (BOOL)didChangeRulesetsForClassName:(NSString *)className;
+- (BOOL)hasMediaRulesetsForClassName:(NSString *)className;
+
++ (UIInterfaceOrientation)mediaOrientation;
++ (void)setMediaOrientation:(UIInterfaceOrientation)orientation;
 
 /**
  * The class to create for rule sets. Default is NICSSRuleset
@@ -88,12 +141,51 @@ extern NSString* const NIStylesheetDidChangeNotification;
  * @fn NIStylesheet::dependencies
  */
 
+/**
+ * The scopes whose rulesets the last load or addStylesheet: added, removed or modified.
+ *
+ * Reloading a stylesheet whose rulesets are all unchanged leaves this empty.
+ *
+ * @fn NIStylesheet::changedScopes
+ */
+
+/**
+ * The stylesheets that a layered stylesheet resolves its rulesets from, from the least to the
+ * most important, or nil if the stylesheet has its own rulesets.
+ *
+ * @fn NIStylesheet::layeredStylesheets
+ */
+
+/** @name Creating Stylesheets */
+
+/**
+ * Initializes a stylesheet that resolves each class name from the given stylesheets in order.
+ *
+ * The ruleset of a class name is that of each stylesheet applied over the ones before it,
+ * whatever the specificity of their scopes, which is what applying each stylesheet in turn used
+ * to do. It is cached once for the whole chain, so looking it up costs the same however many
+ * stylesheets there are.
+ *
+ * The layers are not copied. When one of them posts NIStylesheetDidChangeNotification, only the
+ * cached rulesets of the class names its changes apply to are dropped, and the layered
+ * stylesheet posts the notification in turn. A layered stylesheet has no rulesets of its own, so
+ * it should not be loaded or have stylesheets added to it.
+ *
+ * @fn NIStylesheet::initWithLayeredStylesheets:
+ * @param stylesheets  The NIStylesheets to layer, from the least to the most important. They
+ *                         may themselves be layered.
+ */
 
 /** @name Loading Stylesheets */
 
 /**
  * Loads and parses a CSS file from disk.
  *
+ * When no delegate is given and a compiled stylesheet exists at
+ * NIStylesheet::compiledPathForPath:, the compiled stylesheet is loaded instead of parsing
+ * the CSS, as long as it is newer than the CSS file and every file it imports. Editing any of
+ * them, or loading with a delegate as the Chameleon observer does, parses the CSS again.
+ *
  * @fn NIStylesheet::loadFromPath:pathPrefix:delegate:
  * @param path         The path of the file to be read.
  * @param pathPrefix   [optional] A prefix path that will be prepended to the given path
@@ -112,6 +204,46 @@ extern NSString* const NIStylesheetDidChangeNotification;
  * @sa NIStylesheet::loadFromPath:pathPrefix:delegate:
  */
 
+/**
+ * Loads and caches information regarding a CSS stylesheet held in memory.
+ *
+ * Use this for stylesheets that arrive at runtime, e.g. over the network, to avoid writing them
+ * to disk just so that they can be parsed. Imported files are still loaded from disk.
+ *
+ * @fn NIStylesheet::loadFromData:pathPrefix:delegate:
+ * @param data        The UTF-8 encoded CSS of the stylesheet.
+ * @param pathPrefix  [optional] A prefix path that will be prepended to any imported files.
+ * @param delegate    [optional] A delegate that can reprocess the paths of imported files.
+ * @returns YES if the data was successfully parsed; NO otherwise.
+ */
+
+/** @name Compiling Stylesheets */
+
+/**
+ * Parses a CSS file and its imports and writes the result in a form that loads without parsing.
+ *
+ * Run this at build time, e.g. from a script phase that launches a small tool in the simulator,
+ * and ship the compiled files next to the CSS files in the app bundle. The compiled file must
+ * stay newer than the CSS it was built from, which copying both into the bundle preserves.
+ *
+ * @fn NIStylesheet::compileStylesheetAtPath:pathPrefix:toPath:
+ * @param path          The path of the CSS file, as it would be given to loadFromPath:pathPrefix:.
+ * @param pathPrefix    [optional] A prefix path that will be prepended to the given path
+ *                          as well as any imported files.
+ * @param compiledPath  [optional] Where to write the compiled stylesheet. Defaults to
+ *                          NIStylesheet::compiledPathForPath: of the prefixed path.
+ * @returns YES if the CSS file was parsed and the compiled stylesheet was written.
+ * @see NICompiledStylesheet
+ */
+
+/**
+ * The path where loadFromPath: looks for the compiled form of the CSS file at the given path.
+ *
+ * The compiled file has the same name with a "cssbin" extension.
+ *
+ * @fn NIStylesheet::compiledPathForPath:
+ */
+
 /** @name Compositing Stylesheets */
 
 /**
@@ -134,14 +266,74 @@ extern NSString* const NIStylesheetDidChangeNotification;
  * @param className  Either the view's class as a string using NSStringFromClass([view class]);
  *                        or a CSS class selector such as ".myClassSelector".
  * @param dom        The DOM responsible for applying this style
+ *
+ * The ruleset is compiled into an NIStyleApplier the first time it is applied to a view of a
+ * given class, so styling further views of that class only sets the properties that it has.
  */
 
 /**
  * Returns an autoreleased ruleset for the given class name.
  *
+ * Every ruleset whose last compound selector matches is merged into the result in order of CSS
+ * specificity, so `#submit` overrides `.primary`, which overrides `UIButton`. Scopes such as
+ * `.root UIButton` match any UIButton; their leading parts only add to their specificity.
+ * A pseudo-class only matches rulesets with the same pseudo-class.
+ *
+ * The result is cached, so styling another view with the same class name is a single lookup.
+ *
  * @fn NIStylesheet::rulesetForClassName:
  * @param className  Either the view's class as a string using NSStringFromClass([view class]);
- *                        or a CSS class selector such as ".myClassSelector".
+ *                        a CSS class selector such as ".myClassSelector"; or a compound
+ *                        selector such as "UIButton.primary#submit:selected".
+ */
+
+/**
+ * Returns an autoreleased ruleset combining every ruleset that applies to a view with the given
+ * class, CSS class and id, in the given pseudo-class state.
+ *
+ * @fn NIStylesheet::rulesetForViewClassName:cssClass:viewId:pseudoClass:
+ * @param viewClassName  [optional] The view's class, e.g. NSStringFromClass([view class]).
+ * @param cssClass       [optional] The view's CSS class, without the leading period.
+ * @param viewId         [optional] The view's id, with or without the leading #.
+ * @param pseudoClass    [optional] The pseudo-class, without the leading colon.
+ * @sa NIStylesheet::rulesetForClassName:
+ */
+
+/**
+ * Returns YES if the last load or addStylesheet: added, removed or modified a ruleset that
+ * applies to the given class name.
+ *
+ * NIDOM uses this when the stylesheet changes to restyle only the views it affects.
+ *
+ * @fn NIStylesheet::didChangeRulesetsForClassName:
+ * @param className  A class name as given to rulesetForClassName:.
+ */
+
+/** @name Orientation */
+
+/**
+ * The orientation that @htmlonly@media portrait@endhtmlonly and
+ * @htmlonly@media landscape@endhtmlonly rulesets are resolved for.
+ *
+ * This follows the status bar orientation. Rulesets are cached for each orientation, so after a
+ * rotation has styled a view once, rotating again only looks up the cached rulesets.
+ *
+ * Setting an orientation with a different aspect posts
+ * NIStylesheetMediaOrientationDidChangeNotification.
+ *
+ * @fn NIStylesheet::mediaOrientation
+ */
+
+/**
+ * @fn NIStylesheet::setMediaOrientation:
+ * @sa NIStylesheet::mediaOrientation
+ */
+
+/**
+ * Returns YES if a ruleset that only applies in one orientation applies to the given class name.
+ *
+ * @fn NIStylesheet::hasMediaRulesetsForClassName:
+ * @param className  A class name as given to rulesetForClassName:.
  */
 
 /** @name Debugging */
@@ -18,6 +18,8 @@
 
 #import "NICSSParser.h"
 #import "NICSSRuleset.h"
+#import "NICompiledStylesheet.h"
+#import "NIStyleApplier.h"
 #import "NIStyleable.h"
 #import "NimbusCore.h"
 
@@ -26,93 +28,505 @@
 #endif
 
 NSString* const NIStylesheetDidChangeNotification = @"NIStylesheetDidChangeNotification";
+NSString* const NIStylesheetChangedScopesKey = @"NIStylesheetChangedScopesKey";
+NSString* const NIStylesheetMediaOrientationDidChangeNotification = @"NIStylesheetMediaOrientationDidChangeNotification";
 static Class _rulesetClass;
-
-@interface NIStylesheet()
+static UIInterfaceOrientation sMediaOrientation = UIInterfaceOrientationPortrait;
+static NSString* const kCompiledStylesheetPathExtension = @"cssbin";
+
+@interface NIStylesheet() {
+  // Guards the rulesets and the caches built from them, so that rulesets can be looked up from
+  // any thread. Layered stylesheets take their layers' locks while holding their own, never the
+  // other way around.
+  NIFastLock _lock;
+}
 @property (nonatomic, readonly, copy) NSDictionary* rawRulesets;
 @property (nonatomic, readonly, copy) NSDictionary* significantScopeToScopes;
 @end
 
+// The orientations that a ruleset applies in. Rulesets from @media portrait or @media landscape
+// blocks only apply in their orientation; all others apply in any.
+typedef enum {
+  NIStylesheetMediaContextAny,
+  NIStylesheetMediaContextPortrait,
+  NIStylesheetMediaContextLandscape,
+} NIStylesheetMediaContext;
+
+// A scope broken down into the parts that take part in matching and in the cascade. Only the last
+// compound selector of a scope is matched against views; the others still count towards its
+// specificity, as they do in CSS.
+@interface NIStylesheetSelector : NSObject
+- (id)initWithScope:(NSString *)scope;
+@property (nonatomic, readonly, copy) NSString* scope;
+@property (nonatomic, readonly, assign) NIStylesheetMediaContext mediaContext;
+@property (nonatomic, readonly, copy) NSString* tagName;
+@property (nonatomic, readonly, copy) NSArray* cssClasses;
+@property (nonatomic, readonly, copy) NSString* viewId;
+@property (nonatomic, readonly, copy) NSString* pseudoClass;
+@property (nonatomic, readonly, assign) NSUInteger specificity;
+- (NSString *)bucket;
+- (NSArray *)candidateBuckets;
+- (BOOL)isSatisfiedBySelector:(NIStylesheetSelector *)query;
+@end
+
+// Packs the (ids, classes and pseudo-classes, tags) counts into one comparable number.
+static NSUInteger NISpecificity(NSUInteger ids, NSUInteger classes, NSUInteger tags) {
+  return (MIN(ids, 0xFF) << 16) | (MIN(classes, 0xFF) << 8) | MIN(tags, 0xFF);
+}
+
+@implementation NIStylesheetSelector
+
+- (id)initWithScope:(NSString *)scope {
+  if ((self = [super init])) {
+    _scope = [scope copy];
+
+    // The media prefix that the parser gives orientation rulesets isn't part of the selector.
+    if ([scope hasPrefix:kPortraitMediaScopePrefix]) {
+      _mediaContext = NIStylesheetMediaContextPortrait;
+      scope = [scope substringFromIndex:[kPortraitMediaScopePrefix length]];
+    } else if ([scope hasPrefix:kLandscapeMediaScopePrefix]) {
+      _mediaContext = NIStylesheetMediaContextLandscape;
+      scope = [scope substringFromIndex:[kLandscapeMediaScopePrefix length]];
+    }
+
+    NSArray* compounds = [scope componentsSeparatedByString:@" "];
+    NSUInteger ids = 0;
+    NSUInteger classes = 0;
+    NSUInteger tags = 0;
+    for (NSUInteger ix = 0; ix < [compounds count]; ++ix) {
+      NSString* tagName = nil;
+      NSMutableArray* cssClasses = [NSMutableArray array];
+      NSString* viewId = nil;
+      NSString* pseudoClass = nil;
+
+      NSScanner* scanner = [NSScanner scannerWithString:[compounds objectAtIndex:ix]];
+      scanner.charactersToBeSkipped = nil;
+      NSCharacterSet* delimiters = [NSCharacterSet characterSetWithCharactersInString:@".#:"];
+      NSString* part = nil;
+      if ([scanner scanUpToCharactersFromSet:delimiters intoString:&part]) {
+        tagName = part;
+        tags++;
+      }
+      while (![scanner isAtEnd]) {
+        unichar delimiter = [scanner.string characterAtIndex:scanner.scanLocation];
+        scanner.scanLocation++;
+        part = @"";
+        [scanner scanUpToCharactersFromSet:delimiters intoString:&part];
+        if ('.' == delimiter) {
+          [cssClasses addObject:part];
+          classes++;
+        } else if ('#' == delimiter) {
+          viewId = part;
+          ids++;
+        } else {
+          pseudoClass = part;
+          classes++;
+        }
+      }
+
+      if (ix + 1 == [compounds count]) {
+        _tagName = [tagName copy];
+        _cssClasses = [cssClasses copy];
+        _viewId = [viewId copy];
+        _pseudoClass = [pseudoClass copy];
+      }
+    }
+    _specificity = NISpecificity(ids, classes, tags);
+  }
+  return self;
+}
+
+- (NSString *)bucketForPart:(NSString *)part {
+  return (nil != _pseudoClass) ? [NSString stringWithFormat:@"%@:%@", part, _pseudoClass] : part;
+}
+
+- (NSString *)bucket {
+  if (nil != _viewId) {
+    return [self bucketForPart:[@"#" stringByAppendingString:_viewId]];
+  } else if ([_cssClasses count] > 0) {
+    return [self bucketForPart:[@"." stringByAppendingString:[_cssClasses objectAtIndex:0]]];
+  }
+  return [self bucketForPart:(nil != _tagName) ? _tagName : @""];
+}
+
+- (NSArray *)candidateBuckets {
+  NSMutableArray* buckets = [NSMutableArray array];
+  if (nil != _tagName) {
+    [buckets addObject:[self bucketForPart:_tagName]];
+  }
+  for (NSString* cssClass in _cssClasses) {
+    [buckets addObject:[self bucketForPart:[@"." stringByAppendingString:cssClass]]];
+  }
+  if (nil != _viewId) {
+    [buckets addObject:[self bucketForPart:[@"#" stringByAppendingString:_viewId]]];
+  }
+  return buckets;
+}
+
+- (BOOL)isSatisfiedBySelector:(NIStylesheetSelector *)query {
+  if (nil != _tagName && ![_tagName isEqualToString:query.tagName]) {
+    return NO;
+  }
+  if (nil != _viewId && ![_viewId isEqualToString:query.viewId]) {
+    return NO;
+  }
+  if ((nil != _pseudoClass || nil != query.pseudoClass) && ![_pseudoClass isEqualToString:query.pseudoClass]) {
+    return NO;
+  }
+  for (NSString* cssClass in _cssClasses) {
+    if (![query.cssClasses containsObject:cssClass]) {
+      return NO;
+    }
+  }
+  return YES;
+}
+
+@end
+
+// Orders selectors from the least to the most specific. Rulesets are keyed by scope, so the parser
+// doesn't preserve source order between them; of two equally specific scopes, the one that only
+// applies in the current orientation wins, and others fall back to comparing their text so that
+// the cascade is at least stable.
+static NSComparisonResult NICompareSelectorsBySpecificity(NIStylesheetSelector* selector1,
+                                                          NIStylesheetSelector* selector2) {
+  if (selector1.specificity != selector2.specificity) {
+    return (selector1.specificity < selector2.specificity) ? NSOrderedAscending : NSOrderedDescending;
+  }
+  BOOL isMediaScope1 = (NIStylesheetMediaContextAny != selector1.mediaContext);
+  BOOL isMediaScope2 = (NIStylesheetMediaContextAny != selector2.mediaContext);
+  if (isMediaScope1 != isMediaScope2) {
+    return isMediaScope1 ? NSOrderedDescending : NSOrderedAscending;
+  }
+  return [selector1.scope compare:selector2.scope];
+}
+
 @implementation NIStylesheet
 
 
 
++ (void)initialize {
+  if ([NIStylesheet class] != self) {
+    return;
+  }
+  // Stylesheets may first be used while loading in the background, but UIApplication may only be
+  // asked for the orientation on the main thread.
+  dispatch_async(dispatch_get_main_queue(), ^{
+    NIMeasureFirstUse(@"NIStylesheet orientation observer", ^{
+      [[NSNotificationCenter defaultCenter] addObserverForName:UIApplicationDidChangeStatusBarOrientationNotification
+                                                        object:nil
+                                                         queue:nil
+                                                    usingBlock:^(NSNotification *notification) {
+                                                      [NIStylesheet setMediaOrientation:[UIApplication sharedApplication].statusBarOrientation];
+                                                    }];
+      if (nil != [UIApplication sharedApplication]) {
+        [NIStylesheet setMediaOrientation:[UIApplication sharedApplication].statusBarOrientation];
+      }
+    });
+  });
+}
+
 - (void)dealloc {
   [[NSNotificationCenter defaultCenter] removeObserver:self];
+  NIFastLockDestroy(&_lock);
 }
 
 - (id)init {
   if ((self = [super init])) {
-    _ruleSets = [[NSMutableDictionary alloc] init];
+    NIFastLockInit(&_lock, NIFastLockOptionNone);
+    [self resetCaches];
 
-    NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
-    [nc addObserver: self
-           selector: @selector(didReceiveMemoryWarning:)
-               name: UIApplicationDidReceiveMemoryWarningNotification
-             object: nil];
+    [[NIMemoryPressureCoordinator sharedCoordinator] addObserver:self
+                                                         selector:@selector(didReceiveMemoryPressure:)];
   }
 
   return self;
 }
 
+- (id)initWithLayeredStylesheets:(NSArray *)stylesheets {
+  if ((self = [self init])) {
+    _layeredStylesheets = [stylesheets copy];
+    [self resetCaches];
+
+    for (NIStylesheet* stylesheet in _layeredStylesheets) {
+      [[NSNotificationCenter defaultCenter] addObserver:self
+                                               selector:@selector(layeredStylesheetDidChange:)
+                                                   name:NIStylesheetDidChangeNotification
+                                                 object:stylesheet];
+    }
+  }
+  return self;
+}
+
 #pragma mark - Rule Sets
 
 
-// Builds a map of significant scopes to full scopes.
+// Builds an index of the rulesets bucketed by the most specific part of each scope's last
+// compound selector: its #id, else its first .class, else its tag. Pseudo-classes only ever match
+// the same pseudo-class, so they're appended to the bucket.
 //
 // For example, consider the following rulesets:
 //
 // .root UIButton {
 // }
-// .apple UIButton {
+// UIButton.primary {
 // }
-// UIButton UIView {
+// UIButton:selected {
 // }
-// UIView {
+// #submit {
 // }
 //
-// The generated scope map will look like:
+// The generated index will look like:
 //
-// UIButton => (.root UIButton, .apple UIButton)
-// UIView => (UIButton UIView, UIView)
+// UIButton => (.root UIButton)
+// .primary => (UIButton.primary)
+// UIButton:selected => (UIButton:selected)
+// #submit => (#submit)
 //
+// Each bucket is sorted from the least to the most specific scope.
 - (void)rebuildSignificantScopeToScopes {
   NSMutableDictionary* significantScopeToScopes =
   [[NSMutableDictionary alloc] initWithCapacity:[_rawRulesets count]];
 
   for (NSString* scope in _rawRulesets) {
-    NSArray* parts = [scope componentsSeparatedByString:@" "];
-    NSString* mostSignificantScopePart = [parts lastObject];
-
-    // TODO (jverkoey Oct 6, 2011): We should respect CSS specificity. Right now this will
-    // give higher precedance to newer styles. Instead, we should prefer styles that have more
-    // selectors.
-    NSMutableArray* scopes = [significantScopeToScopes objectForKey:mostSignificantScopePart];
-    if (nil == scopes) {
-      scopes = [[NSMutableArray alloc] initWithObjects:scope, nil];
-      [significantScopeToScopes setObject:scopes forKey:mostSignificantScopePart];
+    if ([scope isEqualToString:kDependenciesSelectorKey]) {
+      continue;
+    }
+    NIStylesheetSelector* selector = [[NIStylesheetSelector alloc] initWithScope:scope];
+    NSString* bucket = [selector bucket];
+
+    NSMutableArray* selectors = [significantScopeToScopes objectForKey:bucket];
+    if (nil == selectors) {
+      selectors = [[NSMutableArray alloc] initWithObjects:selector, nil];
+      [significantScopeToScopes setObject:selectors forKey:bucket];
       
     } else {
-      [scopes addObject:scope];
+      [selectors addObject:selector];
     }
   }
 
+  for (NSString* bucket in [significantScopeToScopes allKeys]) {
+    NSArray* selectors = [[significantScopeToScopes objectForKey:bucket]
+                          sortedArrayUsingComparator:^NSComparisonResult(id selector1, id selector2) {
+                            return NICompareSelectorsBySpecificity(selector1, selector2);
+                          }];
+    [significantScopeToScopes setObject:[selectors valueForKey:@"scope"] forKey:bucket];
+  }
+
+  _significantScopeToScopes = [significantScopeToScopes copy];
+}
+
+// Adds scopes that are new to the rulesets to the index built by rebuildSignificantScopeToScopes,
+// re-sorting only the buckets they fall in.
+- (void)indexAddedScopes:(NSSet *)scopes {
+  NSMutableDictionary* significantScopeToScopes =
+  [NSMutableDictionary dictionaryWithDictionary:_significantScopeToScopes];
+
+  NSMutableDictionary* addedSelectors = [[NSMutableDictionary alloc] init];
+  for (NSString* scope in scopes) {
+    NIStylesheetSelector* selector = [[NIStylesheetSelector alloc] initWithScope:scope];
+    NSMutableArray* selectors = [addedSelectors objectForKey:[selector bucket]];
+    if (nil == selectors) {
+      selectors = [[NSMutableArray alloc] init];
+      [addedSelectors setObject:selectors forKey:[selector bucket]];
+    }
+    [selectors addObject:selector];
+  }
+
+  for (NSString* bucket in addedSelectors) {
+    NSMutableArray* selectors = [addedSelectors objectForKey:bucket];
+    for (NSString* scope in [significantScopeToScopes objectForKey:bucket]) {
+      [selectors addObject:[[NIStylesheetSelector alloc] initWithScope:scope]];
+    }
+    [selectors sortUsingComparator:^NSComparisonResult(id selector1, id selector2) {
+      return NICompareSelectorsBySpecificity(selector1, selector2);
+    }];
+    [significantScopeToScopes setObject:[selectors valueForKey:@"scope"] forKey:bucket];
+  }
+
   _significantScopeToScopes = [significantScopeToScopes copy];
 }
 
+// Indexes the scopes that were added, removed or modified since the given rulesets the same way
+// as rebuildSignificantScopeToScopes, so that a class name is only compared with the scopes it
+// could match.
+- (void)recordChangedScopesSinceRulesets:(NSDictionary *)previousRulesets {
+  NSMutableSet* scopes = [NSMutableSet setWithArray:[previousRulesets allKeys]];
+  [scopes addObjectsFromArray:[_rawRulesets allKeys]];
+  [self recordChangedScopes:scopes sinceRulesets:previousRulesets];
+}
+
+// As recordChangedScopesSinceRulesets:, comparing only the given scopes.
+- (void)recordChangedScopes:(NSSet *)candidateScopes sinceRulesets:(NSDictionary *)previousRulesets {
+  NSMutableSet* scopes = [candidateScopes mutableCopy];
+  [scopes removeObject:kDependenciesSelectorKey];
+
+  NSMutableSet* changedScopes = [NSMutableSet set];
+  NSMutableDictionary* changedSignificantScopeToScopes = [[NSMutableDictionary alloc] init];
+  for (NSString* scope in scopes) {
+    NSDictionary* previousRuleset = [previousRulesets objectForKey:scope];
+    NSDictionary* ruleset = [_rawRulesets objectForKey:scope];
+    if (previousRuleset == ruleset || [previousRuleset isEqual:ruleset]) {
+      continue;
+    }
+    [changedScopes addObject:scope];
+    NIStylesheetSelector* selector = [[NIStylesheetSelector alloc] initWithScope:scope];
+    NSMutableArray* selectors = [changedSignificantScopeToScopes objectForKey:[selector bucket]];
+    if (nil == selectors) {
+      selectors = [[NSMutableArray alloc] init];
+      [changedSignificantScopeToScopes setObject:selectors forKey:[selector bucket]];
+    }
+    [selectors addObject:selector];
+  }
+  _changedScopes = [changedScopes copy];
+  _changedSignificantScopeToScopes = [changedSignificantScopeToScopes copy];
+}
+
+- (void)resetCaches {
+  _ruleSets = [[NSMutableDictionary alloc] init];
+  _styleAppliers = [[NSMutableDictionary alloc] init];
+
+  _hasMediaScopes = NO;
+  for (NIStylesheet* stylesheet in _layeredStylesheets) {
+    NI_LOCK_SCOPE(&stylesheet->_lock);
+    if (stylesheet->_hasMediaScopes) {
+      _hasMediaScopes = YES;
+      break;
+    }
+  }
+  for (NSString* scope in _rawRulesets) {
+    if ([scope hasPrefix:kPortraitMediaScopePrefix] || [scope hasPrefix:kLandscapeMediaScopePrefix]) {
+      _hasMediaScopes = YES;
+      break;
+    }
+  }
+}
+
 - (void)ruleSetsDidChange {
+  [self resetCaches];
   [self rebuildSignificantScopeToScopes];
 }
 
+// Drops the cached rulesets and appliers of the class names that the changes recorded by
+// recordChangedScopes:sinceRulesets: apply to, keeping every other class name's.
+- (void)evictCachesForChangedScopes {
+  for (NSMutableDictionary* caches in @[ _ruleSets, _styleAppliers ]) {
+    for (NSMutableDictionary* cache in [caches objectEnumerator]) {
+      NSMutableArray* classNames = [NSMutableArray array];
+      for (NSString* className in cache) {
+        if ([self changedRulesetsApplyToClassName:className]) {
+          [classNames addObject:className];
+        }
+      }
+      [cache removeObjectsForKeys:classNames];
+    }
+  }
+
+  if (!_hasMediaScopes) {
+    for (NSString* scope in _changedScopes) {
+      if ([scope hasPrefix:kPortraitMediaScopePrefix] || [scope hasPrefix:kLandscapeMediaScopePrefix]) {
+        _hasMediaScopes = YES;
+        break;
+      }
+    }
+  }
+}
+
+#pragma mark - Media
+
+
+- (NIStylesheetMediaContext)activeMediaContext {
+  if (!_hasMediaScopes) {
+    return NIStylesheetMediaContextAny;
+  }
+  return (UIInterfaceOrientationIsLandscape(sMediaOrientation)
+          ? NIStylesheetMediaContextLandscape
+          : NIStylesheetMediaContextPortrait);
+}
+
+// Rulesets and appliers are cached separately for each media context, so rotating back and forth
+// swaps between caches that have already been built.
+- (NSMutableDictionary *)cacheForMediaContext:(NIStylesheetMediaContext)mediaContext
+                                     inCaches:(NSMutableDictionary *)caches {
+  NSNumber* key = [NSNumber numberWithInt:mediaContext];
+  NSMutableDictionary* cache = [caches objectForKey:key];
+  if (nil == cache) {
+    NIDASSERT(nil != caches);
+    cache = [[NSMutableDictionary alloc] init];
+    [caches setObject:cache forKey:key];
+  }
+  return cache;
+}
+
++ (UIInterfaceOrientation)mediaOrientation {
+  return sMediaOrientation;
+}
+
++ (void)setMediaOrientation:(UIInterfaceOrientation)orientation {
+  BOOL didChange = (UIInterfaceOrientationIsLandscape(orientation)
+                    != UIInterfaceOrientationIsLandscape(sMediaOrientation));
+  sMediaOrientation = orientation;
+  if (didChange) {
+    [[NSNotificationCenter defaultCenter] postNotificationName:NIStylesheetMediaOrientationDidChangeNotification
+                                                        object:nil];
+  }
+}
+
+- (BOOL)hasMediaRulesetsForClassName:(NSString *)className {
+  if (nil == className) {
+    return NO;
+  }
+  NI_LOCK_SCOPE(&_lock);
+  if (!_hasMediaScopes) {
+    return NO;
+  }
+  for (NIStylesheet* stylesheet in _layeredStylesheets) {
+    if ([stylesheet hasMediaRulesetsForClassName:className]) {
+      return YES;
+    }
+  }
+  NIStylesheetSelector* query = [[NIStylesheetSelector alloc] initWithScope:className];
+  for (NSString* bucket in [query candidateBuckets]) {
+    for (NSString* scope in [_significantScopeToScopes objectForKey:bucket]) {
+      NIStylesheetSelector* selector = [[NIStylesheetSelector alloc] initWithScope:scope];
+      if (NIStylesheetMediaContextAny != selector.mediaContext && [selector isSatisfiedBySelector:query]) {
+        return YES;
+      }
+    }
+  }
+  return NO;
+}
+
 #pragma mark - NSNotifications
 
 
 - (void)reduceMemory {
-  _ruleSets = [[NSMutableDictionary alloc] init];
+  NI_LOCK_SCOPE(&_lock);
+  [self resetCaches];
+}
+
+- (void)layeredStylesheetDidChange:(NSNotification *)notification {
+  NIStylesheet* stylesheet = notification.object;
+  {
+    NI_LOCK_SCOPE(&_lock);
+    // The layer's changes are this stylesheet's changes, so they restyle the same views.
+    {
+      NI_LOCK_SCOPE(&stylesheet->_lock);
+      _changedScopes = stylesheet->_changedScopes;
+      _changedSignificantScopeToScopes = stylesheet->_changedSignificantScopeToScopes;
+    }
+    [self evictCachesForChangedScopes];
+  }
+  [[NSNotificationCenter defaultCenter] postNotificationName:NIStylesheetDidChangeNotification
+                                                      object:self
+                                                    userInfo:notification.userInfo];
 }
 
-- (void)didReceiveMemoryWarning:(void*)object {
-  [self reduceMemory];
+- (void)didReceiveMemoryPressure:(NSNotification *)notification {
+  // Everything here can be rebuilt, but only at the cost of restyling, so only give it up when
+  // the pressure is critical.
+  if (NIMemoryPressureLevelCritical == NIMemoryPressureLevelFromNotification(notification)) {
+    [self reduceMemory];
+  }
 }
 
 #pragma mark - Public
@@ -131,11 +545,26 @@ static Class _rulesetClass;
             delegate:(id<NICSSParserDelegate>)delegate {
   BOOL loadDidSucceed = NO;
 
-  @synchronized(self) {
+  {
+    NI_LOCK_SCOPE(&_lock);
+    NSDictionary* previousRulesets = _rawRulesets;
     _rawRulesets = nil;
     _significantScopeToScopes = nil;
 
-    _ruleSets = [[NSMutableDictionary alloc] init];
+    [self resetCaches];
+
+    // Delegates may rename the files, so only the paths as given can be checked for changes.
+    if (nil == delegate) {
+      NICompiledStylesheet* compiledStylesheet = [[self class] compiledStylesheetForPath:path
+                                                                              pathPrefix:pathPrefix];
+      if (nil != compiledStylesheet) {
+        _rawRulesets = compiledStylesheet.rulesets;
+        _significantScopeToScopes = compiledStylesheet.significantScopeToScopes;
+        [self resetCaches];
+        [self recordChangedScopesSinceRulesets:previousRulesets];
+        return YES;
+      }
+    }
 
     NICSSParser* parser = [[NICSSParser alloc] init];
 
@@ -150,33 +579,144 @@ static Class _rulesetClass;
     if (loadDidSucceed) {
       [self ruleSetsDidChange];
     }
+    [self recordChangedScopesSinceRulesets:previousRulesets];
+  }
+
+  return loadDidSucceed;
+}
+
+- (BOOL)loadFromData:(NSData *)data
+          pathPrefix:(NSString *)pathPrefix
+            delegate:(id<NICSSParserDelegate>)delegate {
+  BOOL loadDidSucceed = NO;
+
+  {
+    NI_LOCK_SCOPE(&_lock);
+    NSDictionary* previousRulesets = _rawRulesets;
+    _rawRulesets = nil;
+    _significantScopeToScopes = nil;
+
+    [self resetCaches];
+
+    NICSSParser* parser = [[NICSSParser alloc] init];
+
+    NSDictionary* results = [parser dictionaryForData:data
+                                           pathPrefix:pathPrefix
+                                             delegate:delegate];
+    if (nil != results && ![parser didFailToParse]) {
+      _rawRulesets = results;
+      loadDidSucceed = YES;
+    }
+
+    if (loadDidSucceed) {
+      [self ruleSetsDidChange];
+    }
+    [self recordChangedScopesSinceRulesets:previousRulesets];
   }
 
   return loadDidSucceed;
 }
 
+#pragma mark Compiled Stylesheets
+
+
++ (NSString *)compiledPathForPath:(NSString *)path {
+  return [[path stringByDeletingPathExtension] stringByAppendingPathExtension:kCompiledStylesheetPathExtension];
+}
+
++ (NSString *)prefixedPath:(NSString *)path pathPrefix:(NSString *)pathPrefix {
+  return (pathPrefix.length > 0) ? [pathPrefix stringByAppendingPathComponent:path] : path;
+}
+
++ (NSDate *)modificationDateOfFileAtPath:(NSString *)path {
+  return [[[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil] fileModificationDate];
+}
+
+// Returns the compiled stylesheet for the given CSS file, or nil if there isn't one or if the
+// CSS file or one of its imports has changed since it was compiled.
++ (NICompiledStylesheet *)compiledStylesheetForPath:(NSString *)path pathPrefix:(NSString *)pathPrefix {
+  if (path.length == 0) {
+    return nil;
+  }
+  NSString* prefixedPath = [self prefixedPath:path pathPrefix:pathPrefix];
+  NSString* compiledPath = [self compiledPathForPath:prefixedPath];
+  NSDate* compiledDate = [self modificationDateOfFileAtPath:compiledPath];
+  if (nil == compiledDate) {
+    return nil;
+  }
+  NSDate* sourceDate = [self modificationDateOfFileAtPath:prefixedPath];
+  if (nil == sourceDate || [sourceDate compare:compiledDate] == NSOrderedDescending) {
+    return nil;
+  }
+
+  NICompiledStylesheet* compiledStylesheet = [[NICompiledStylesheet alloc] initWithContentsOfFile:compiledPath];
+  if (nil == compiledStylesheet) {
+    NIDERROR(@"Ignoring unreadable compiled stylesheet %@", compiledPath);
+    return nil;
+  }
+  for (NSString* dependency in [compiledStylesheet.rulesets objectForKey:kDependenciesSelectorKey]) {
+    NSDate* dependencyDate = [self modificationDateOfFileAtPath:[self prefixedPath:dependency pathPrefix:pathPrefix]];
+    if (nil == dependencyDate || [dependencyDate compare:compiledDate] == NSOrderedDescending) {
+      return nil;
+    }
+  }
+  return compiledStylesheet;
+}
+
++ (BOOL)compileStylesheetAtPath:(NSString *)path pathPrefix:(NSString *)pathPrefix toPath:(NSString *)compiledPath {
+  NICSSParser* parser = [[NICSSParser alloc] init];
+  NSDictionary* rulesets = [parser dictionaryForPath:path pathPrefix:pathPrefix delegate:nil];
+  if (nil == rulesets || [parser didFailToParse]) {
+    return NO;
+  }
+
+  // Build the scope map the same way loading would.
+  NIStylesheet* stylesheet = [[self alloc] init];
+  stylesheet->_rawRulesets = rulesets;
+  [stylesheet rebuildSignificantScopeToScopes];
+
+  NSData* data = [NICompiledStylesheet dataWithRulesets:rulesets
+                               significantScopeToScopes:stylesheet.significantScopeToScopes];
+  if (nil == compiledPath) {
+    compiledPath = [self compiledPathForPath:[self prefixedPath:path pathPrefix:pathPrefix]];
+  }
+  NSError* error = nil;
+  if (![data writeToFile:compiledPath options:NSDataWritingAtomic error:&error]) {
+    NIDERROR(@"Failed to write the compiled stylesheet %@: %@", compiledPath, error);
+    return NO;
+  }
+  return YES;
+}
+
 - (void)addStylesheet:(NIStylesheet *)stylesheet {
   NIDASSERT(nil != stylesheet);
   if (nil == stylesheet) {
     return;
   }
 
-  @synchronized(self) {
-    NSMutableDictionary* compositeRuleSets = [self.rawRulesets mutableCopy];
+  NSDictionary* incomingRulesets = stylesheet.rawRulesets;
+  {
+    NI_LOCK_SCOPE(&_lock);
+    NSDictionary* previousRulesets = _rawRulesets;
+    NSMutableDictionary* compositeRuleSets = [NSMutableDictionary dictionaryWithDictionary:previousRulesets];
 
-    BOOL ruleSetsDidChange = NO;
+    NSMutableSet* mergedScopes = [NSMutableSet set];
+    NSMutableSet* addedScopes = [NSMutableSet set];
 
-    for (NSString* selector in stylesheet.rawRulesets) {
-      NSDictionary* incomingRuleSet   = [stylesheet.rawRulesets objectForKey:selector];
-      NSDictionary* existingRuleSet = [self.rawRulesets objectForKey:selector];
+    for (NSString* selector in incomingRulesets) {
+      NSDictionary* incomingRuleSet   = [incomingRulesets objectForKey:selector];
+      NSDictionary* existingRuleSet = [previousRulesets objectForKey:selector];
 
       // Don't bother adding empty rulesets.
       if ([incomingRuleSet count] > 0) {
-        ruleSetsDidChange = YES;
+        [mergedScopes addObject:selector];
 
         if (nil == existingRuleSet) {
           // There is no rule set of this selector - simply add the new one.
           [compositeRuleSets setObject:incomingRuleSet forKey:selector];
+          if (![selector isEqualToString:kDependenciesSelectorKey]) {
+            [addedScopes addObject:selector];
+          }
           continue;
         }
 
@@ -190,9 +730,14 @@ static Class _rulesetClass;
 
     _rawRulesets = [compositeRuleSets copy];
 
-    if (ruleSetsDidChange) {
-      [self ruleSetsDidChange];
+    // Only the merged scopes can have changed, so only they are indexed and only the class names
+    // they apply to are restyled from scratch. Layering several stylesheets at launch then costs
+    // as much as the stylesheets being layered rather than the sheet they are layered on.
+    [self recordChangedScopes:mergedScopes sinceRulesets:previousRulesets];
+    if ([addedScopes count] > 0) {
+      [self indexAddedScopes:addedScopes];
     }
+    [self evictCachesForChangedScopes];
   }
 }
 
@@ -217,61 +762,178 @@ static Class _rulesetClass;
 #pragma mark Applying Styles to Views
 
 
-- (void)applyRuleSet:(NICSSRuleset *)ruleSet toView:(UIView *)view inDOM: (NIDOM*)dom {
-  if ([view respondsToSelector:@selector(applyStyleWithRuleSet:inDOM:)]) {
-    [(id<NIStyleable>)view applyStyleWithRuleSet:ruleSet inDOM:dom];
-  }
-  if ([view respondsToSelector:@selector(applyStyleWithRuleSet:)]) {
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wdeprecated-declarations"
-    [(id<NIStyleable>)view applyStyleWithRuleSet:ruleSet];
-#pragma clang diagnostic pop
+- (NIStyleApplier *)styleApplierForViewClass:(Class)viewClass withClassName:(NSString *)className {
+  NI_LOCK_SCOPE(&_lock);
+  NSMutableDictionary* styleAppliers = [self cacheForMediaContext:[self activeMediaContext]
+                                                         inCaches:_styleAppliers];
+  NSMutableDictionary* appliers = [styleAppliers objectForKey:className];
+  NIStyleApplier* applier = [appliers objectForKey:viewClass];
+  if (nil == applier) {
+    NICSSRuleset *ruleset = [self cachedRulesetForClassName:className];
+    if (nil == ruleset) {
+      return nil;
+    }
+    NSRange r = [className rangeOfString:@":"];
+    NSString* pseudoClass = (r.location != NSNotFound) ? [className substringFromIndex:r.location+1] : nil;
+    applier = [NIStyleApplier applierForViewClass:viewClass ruleSet:ruleset pseudoClass:pseudoClass];
+
+    if (nil == appliers) {
+      appliers = [[NSMutableDictionary alloc] init];
+      [styleAppliers setObject:appliers forKey:className];
+    }
+    [appliers setObject:applier forKey:(id<NSCopying>)viewClass];
   }
+  return applier;
 }
 
 - (void)applyStyleToView:(UIView *)view withClassName:(NSString *)className inDOM:(NIDOM *)dom {
-  NICSSRuleset *ruleset = [self rulesetForClassName:className];
-  if (nil != ruleset) {
-    NSRange r = [className rangeOfString:@":"];
-    if (r.location != NSNotFound && [view respondsToSelector:@selector(applyStyleWithRuleSet:forPseudoClass:inDOM:)]) {
-      [(id<NIStyleable>)view applyStyleWithRuleSet:ruleset forPseudoClass: [className substringFromIndex:r.location+1] inDOM:dom];
-    } else {
-      [self applyRuleSet:ruleset toView:view inDOM:dom];
+  NI_SIGNPOST_BEGIN(NISignpostCategoryCSS, "Apply", view, "%{public}@", className);
+  [[self styleApplierForViewClass:[view class] withClassName:className] applyToView:view inDOM:dom];
+  NI_SIGNPOST_END(NISignpostCategoryCSS, "Apply", view);
+}
+
+// Adds the rulesets of every scope in this media context whose last compound selector is
+// satisfied by the query to the given ruleset, letting more specific scopes override less
+// specific ones. Layered stylesheets add each of their layers' in turn.
+- (BOOL)addRulesetsForSelector:(NIStylesheetSelector *)query
+                  mediaContext:(NIStylesheetMediaContext)mediaContext
+                     toRuleset:(NICSSRuleset *)ruleSet {
+  if (nil != _layeredStylesheets) {
+    BOOL didAddRulesets = NO;
+    for (NIStylesheet* stylesheet in _layeredStylesheets) {
+      NI_LOCK_SCOPE(&stylesheet->_lock);
+      if ([stylesheet addRulesetsForSelector:query mediaContext:mediaContext toRuleset:ruleSet]) {
+        didAddRulesets = YES;
+      }
     }
+    return didAddRulesets;
   }
-}
 
-- (NICSSRuleset*) addSelectors: (NSArray*) selectors toRuleset: (NICSSRuleset*) ruleSet forClassName: (NSString*) className
-{
-  if ([selectors count] > 0) {
-    // Gather all of the rule sets for this view into a composite rule set.
-    ruleSet = ruleSet ?: [_ruleSets objectForKey:className];
-    
-    if (nil == ruleSet) {
-      ruleSet = [[[NIStylesheet rulesetClass] alloc] init];
-      
-      // Composite the rule sets into one.
-      for (NSString* selector in selectors) {
-        [ruleSet addEntriesFromDictionary:[_rawRulesets objectForKey:selector]];
+  NSMutableArray* selectors = [NSMutableArray array];
+  for (NSString* bucket in [query candidateBuckets]) {
+    for (NSString* scope in [_significantScopeToScopes objectForKey:bucket]) {
+      NIStylesheetSelector* selector = [[NIStylesheetSelector alloc] initWithScope:scope];
+      if ((NIStylesheetMediaContextAny == selector.mediaContext || mediaContext == selector.mediaContext)
+          && [selector isSatisfiedBySelector:query]) {
+        [selectors addObject:selector];
       }
-      
-      NIDASSERT(nil != _ruleSets);
-      [_ruleSets setObject:ruleSet forKey:className];
     }
   }
-  
+  if ([selectors count] == 0) {
+    return NO;
+  }
+
+  [selectors sortUsingComparator:^NSComparisonResult(id selector1, id selector2) {
+    return NICompareSelectorsBySpecificity(selector1, selector2);
+  }];
+  for (NIStylesheetSelector* selector in selectors) {
+    [ruleSet addEntriesFromDictionary:[_rawRulesets objectForKey:selector.scope]];
+  }
+  return YES;
+}
+
+- (NICSSRuleset *)compositeRulesetForSelector:(NIStylesheetSelector *)query
+                                 mediaContext:(NIStylesheetMediaContext)mediaContext {
+  NICSSRuleset* ruleSet = [[[NIStylesheet rulesetClass] alloc] init];
+  if (![self addRulesetsForSelector:query mediaContext:mediaContext toRuleset:ruleSet]) {
+    return nil;
+  }
+
+  // The ruleset is shared by every view with this class name, so parse its values once up front.
+  [ruleSet compile];
   return ruleSet;
 }
 
 - (NICSSRuleset *)rulesetForClassName:(NSString *)className {
-  NSArray* selectors = [_significantScopeToScopes objectForKey:className];
-  return [self addSelectors:selectors toRuleset:nil forClassName:className];
+  if (nil == className) {
+    return nil;
+  }
+  NI_LOCK_SCOPE(&_lock);
+  return [self cachedRulesetForClassName:className];
+}
+
+// The ruleset is compiled before it is cached and is never changed afterwards, so it can be
+// read from any thread once it has been handed out.
+- (NICSSRuleset *)cachedRulesetForClassName:(NSString *)className {
+  if (nil == className) {
+    return nil;
+  }
+
+  // Misses are cached too, so that restyling a view is always a single lookup.
+  NIStylesheetMediaContext mediaContext = [self activeMediaContext];
+  NSMutableDictionary* ruleSets = [self cacheForMediaContext:mediaContext inCaches:_ruleSets];
+  id ruleSet = [ruleSets objectForKey:className];
+  if (nil == ruleSet) {
+    ruleSet = [self compositeRulesetForSelector:[[NIStylesheetSelector alloc] initWithScope:className]
+                                   mediaContext:mediaContext];
+    [ruleSets setObject:(nil != ruleSet) ? ruleSet : [NSNull null] forKey:className];
+  }
+  return [ruleSet isKindOfClass:[NSNull class]] ? nil : ruleSet;
+}
+
+- (NICSSRuleset *)rulesetForViewClassName:(NSString *)viewClassName
+                                 cssClass:(NSString *)cssClass
+                                   viewId:(NSString *)viewId
+                              pseudoClass:(NSString *)pseudoClass {
+  NSMutableString* compound = [NSMutableString string];
+  if (nil != viewClassName) {
+    [compound appendString:viewClassName];
+  }
+  if (nil != cssClass) {
+    [compound appendFormat:@".%@", cssClass];
+  }
+  if (nil != viewId) {
+    [compound appendString:[viewId hasPrefix:@"#"] ? viewId : [@"#" stringByAppendingString:viewId]];
+  }
+  if (nil != pseudoClass) {
+    [compound appendFormat:@":%@", pseudoClass];
+  }
+  if ([compound length] == 0) {
+    return nil;
+  }
+  return [self rulesetForClassName:compound];
+}
+
+- (BOOL)didChangeRulesetsForClassName:(NSString *)className {
+  NI_LOCK_SCOPE(&_lock);
+  return [self changedRulesetsApplyToClassName:className];
+}
+
+- (BOOL)changedRulesetsApplyToClassName:(NSString *)className {
+  if (nil == className || [_changedSignificantScopeToScopes count] == 0) {
+    return NO;
+  }
+  NIStylesheetSelector* query = [[NIStylesheetSelector alloc] initWithScope:className];
+  for (NSString* bucket in [query candidateBuckets]) {
+    for (NIStylesheetSelector* selector in [_changedSignificantScopeToScopes objectForKey:bucket]) {
+      if ([selector isSatisfiedBySelector:query]) {
+        return YES;
+      }
+    }
+  }
+  return NO;
 }
 
 - (NSSet *)dependencies {
+  NI_LOCK_SCOPE(&_lock);
   return [_rawRulesets objectForKey:kDependenciesSelectorKey];
 }
 
+- (NSSet *)changedScopes {
+  NI_LOCK_SCOPE(&_lock);
+  return _changedScopes;
+}
+
+- (NSDictionary *)rawRulesets {
+  NI_LOCK_SCOPE(&_lock);
+  return _rawRulesets;
+}
+
+- (NSDictionary *)significantScopeToScopes {
+  NI_LOCK_SCOPE(&_lock);
+  return _significantScopeToScopes;
+}
+
 +(Class)rulesetClass
 {
   return _rulesetClass ?: [NICSSRuleset class];
@@ -47,9 +47,17 @@ NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
 @private
   NSMutableDictionary* _pathToStylesheet;
   NSString* _pathPrefix;
+  NSMutableArray* _leastRecentlyUsedPaths;
+  NSMutableDictionary* _pathToNumberOfBytes;
+  NSMapTable* _evictedStylesheets;
+  NSMutableDictionary* _pathToCompletionBlocks;
+  unsigned long long _numberOfBytes;
+  unsigned long long _maxNumberOfBytes;
 }
 
 @property (nonatomic, readonly, copy) NSString* pathPrefix;
+@property (nonatomic) unsigned long long maxNumberOfBytes; // Default: 0 (unlimited)
+@property (nonatomic, readonly) unsigned long long numberOfBytes;
 
 // Designated initializer.
 - (id)initWithPathPrefix:(NSString *)pathPrefix;
@@ -57,6 +65,9 @@ NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
 - (NIStylesheet *)stylesheetWithPath:(NSString *)path loadFromDisk:(BOOL)loadFromDisk;
 - (NIStylesheet *)stylesheetWithPath:(NSString *)path;
 
+- (void)loadStylesheetWithPath:(NSString *)path completion:(void (^)(NIStylesheet* stylesheet))completion;
+- (void)preloadStylesheetsWithPaths:(NSArray *)paths;
+
 @end
 
 /**
@@ -65,6 +76,24 @@ NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
  * @fn NIStylesheetCache::pathPrefix
  */
 
+/**
+ * The most bytes of CSS that the cached stylesheets may have been parsed from.
+ *
+ * Once the stylesheets add up to more than this, the least recently used ones are removed from
+ * the cache until they fit, so that the stylesheets of screens that are rarely visited don't
+ * stay in memory. A stylesheet counts the size of its CSS file and of every file it imports.
+ * An evicted stylesheet that is still in use, e.g. by an NIDOM, is handed out again rather than
+ * parsed anew, so that everyone keeps sharing it.
+ *
+ * @fn NIStylesheetCache::maxNumberOfBytes
+ */
+
+/**
+ * The bytes of CSS that the cached stylesheets were parsed from.
+ *
+ * @fn NIStylesheetCache::numberOfBytes
+ */
+
 /**
  * Initializes a newly allocated stylesheet cache with a given path prefix.
  *
@@ -85,3 +114,28 @@ NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
  *
  * @fn NIStylesheetCache::stylesheetWithPath:
  */
+
+/** @name Loading Stylesheets in the Background */
+
+/**
+ * Fetches a stylesheet from the in-memory cache if it exists or loads it from disk on a
+ * background queue.
+ *
+ * The completion block is called on the main queue with the stylesheet, or nil if it could not
+ * be loaded. Screens that ask for the same stylesheet while it is loading share a single parse.
+ *
+ * @fn NIStylesheetCache::loadStylesheetWithPath:completion:
+ */
+
+/**
+ * Loads the given stylesheets on a background queue so that they are in the cache by the time
+ * they are needed.
+ *
+ * Call this at launch with the stylesheets of the first few screens.
+ *
+@code
+[stylesheetCache preloadStylesheetsWithPaths:@[@"common.css", @"root/root.css"]];
+@endcode
+ *
+ * @fn NIStylesheetCache::preloadStylesheetsWithPaths:
+ */
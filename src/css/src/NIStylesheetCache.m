@@ -31,6 +31,10 @@
   if ((self = [super init])) {
     _pathToStylesheet = [[NSMutableDictionary alloc] init];
     _pathPrefix = [pathPrefix copy];
+    _leastRecentlyUsedPaths = [[NSMutableArray alloc] init];
+    _pathToNumberOfBytes = [[NSMutableDictionary alloc] init];
+    _evictedStylesheets = [NSMapTable strongToWeakObjectsMapTable];
+    _pathToCompletionBlocks = [[NSMutableDictionary alloc] init];
   }
   return self;
 }
@@ -41,28 +45,137 @@
   return [self initWithPathPrefix:nil];
 }
 
-- (NIStylesheet *)stylesheetWithPath:(NSString *)path loadFromDisk:(BOOL)loadFromDisk {
+#pragma mark - Least Recently Used
+
+
+// Stylesheets hold on to roughly as much as the CSS they were parsed from, imports included.
+- (unsigned long long)numberOfBytesForStylesheet:(NIStylesheet *)stylesheet withPath:(NSString *)path {
+  NSFileManager* fm = [NSFileManager defaultManager];
+  NSMutableSet* paths = [NSMutableSet setWithObject:path];
+  [paths unionSet:stylesheet.dependencies];
+
+  unsigned long long numberOfBytes = 0;
+  for (NSString* dependency in paths) {
+    NSString* fullPath = (nil != _pathPrefix) ? [_pathPrefix stringByAppendingPathComponent:dependency] : dependency;
+    numberOfBytes += [[fm attributesOfItemAtPath:fullPath error:nil] fileSize];
+  }
+  return numberOfBytes;
+}
+
+// Must be called while synchronized on self.
+- (void)touchPath:(NSString *)path {
+  [_leastRecentlyUsedPaths removeObject:path];
+  [_leastRecentlyUsedPaths addObject:path];
+}
+
+// Must be called while synchronized on self.
+- (void)storeStylesheet:(NIStylesheet *)stylesheet withPath:(NSString *)path numberOfBytes:(unsigned long long)numberOfBytes {
+  _numberOfBytes -= [[_pathToNumberOfBytes objectForKey:path] unsignedLongLongValue];
+  [_pathToStylesheet setObject:stylesheet forKey:path];
+  [_pathToNumberOfBytes setObject:[NSNumber numberWithUnsignedLongLong:numberOfBytes] forKey:path];
+  [_evictedStylesheets removeObjectForKey:path];
+  _numberOfBytes += numberOfBytes;
+  [self touchPath:path];
+  [self evictStylesheetsIfNeeded];
+}
+
+// Must be called while synchronized on self.
+- (void)removeStylesheetWithPath:(NSString *)path {
+  _numberOfBytes -= [[_pathToNumberOfBytes objectForKey:path] unsignedLongLongValue];
+  [_pathToNumberOfBytes removeObjectForKey:path];
+  [_pathToStylesheet removeObjectForKey:path];
+  [_leastRecentlyUsedPaths removeObject:path];
+}
+
+// Must be called while synchronized on self.
+- (void)evictStylesheetsIfNeeded {
+  if (0 == _maxNumberOfBytes) {
+    return;
+  }
+  // The most recently used stylesheet stays even if it is over the limit on its own.
+  while (_numberOfBytes > _maxNumberOfBytes && [_leastRecentlyUsedPaths count] > 1) {
+    NSString* path = [_leastRecentlyUsedPaths objectAtIndex:0];
+    NIStylesheet* stylesheet = [_pathToStylesheet objectForKey:path];
+    [self removeStylesheetWithPath:path];
+
+    // DOMs may still be styling views with this stylesheet. Handing the same object back while it
+    // is alive keeps them listening to the stylesheet that Chameleon reloads.
+    if (nil != stylesheet) {
+      [_evictedStylesheets setObject:stylesheet forKey:path];
+    }
+  }
+}
+
+// Must be called while synchronized on self.
+- (NIStylesheet *)cachedStylesheetWithPath:(NSString *)path {
   NIStylesheet* stylesheet = [_pathToStylesheet objectForKey:path];
+  if (nil != stylesheet) {
+    [self touchPath:path];
+    return stylesheet;
+  }
+  stylesheet = [_evictedStylesheets objectForKey:path];
+  if (nil != stylesheet) {
+    [self storeStylesheet:stylesheet
+                 withPath:path
+            numberOfBytes:[self numberOfBytesForStylesheet:stylesheet withPath:path]];
+  }
+  return stylesheet;
+}
 
-  if (nil == stylesheet) {
-    stylesheet = [[NIStylesheet alloc] init];
-    if (loadFromDisk) {
-      BOOL didSucceed = [stylesheet loadFromPath:path
-                                      pathPrefix:_pathPrefix];
+- (void)setMaxNumberOfBytes:(unsigned long long)maxNumberOfBytes {
+  @synchronized(self) {
+    _maxNumberOfBytes = maxNumberOfBytes;
+    [self evictStylesheetsIfNeeded];
+  }
+}
 
-      if (didSucceed) {
-        [_pathToStylesheet setObject:stylesheet forKey:path];
+- (unsigned long long)maxNumberOfBytes {
+  @synchronized(self) {
+    return _maxNumberOfBytes;
+  }
+}
 
-      } else {
-        [_pathToStylesheet removeObjectForKey:path];
-        stylesheet = nil;
-      }
+- (unsigned long long)numberOfBytes {
+  @synchronized(self) {
+    return _numberOfBytes;
+  }
+}
+
+#pragma mark - Public
 
-    } else {
-      [_pathToStylesheet setObject:stylesheet forKey:path];
+
+- (NIStylesheet *)stylesheetWithPath:(NSString *)path loadFromDisk:(BOOL)loadFromDisk {
+  @synchronized(self) {
+    NIStylesheet* stylesheet = [self cachedStylesheetWithPath:path];
+    if (nil != stylesheet) {
+      return stylesheet;
+    }
+    if (!loadFromDisk) {
+      stylesheet = [[NIStylesheet alloc] init];
+      [self storeStylesheet:stylesheet withPath:path numberOfBytes:0];
+      return stylesheet;
     }
   }
-  
+
+  // Parse outside of the lock so that other stylesheets can be fetched in the meantime.
+  NIStylesheet* stylesheet = [[NIStylesheet alloc] init];
+  BOOL didSucceed = [stylesheet loadFromPath:path
+                                  pathPrefix:_pathPrefix];
+  unsigned long long numberOfBytes = didSucceed ? [self numberOfBytesForStylesheet:stylesheet withPath:path] : 0;
+
+  @synchronized(self) {
+    // Another thread may have loaded the same stylesheet in the meantime. Everyone must share one
+    // object so that change notifications reach every listener.
+    NIStylesheet* cachedStylesheet = [self cachedStylesheetWithPath:path];
+    if (nil != cachedStylesheet) {
+      return cachedStylesheet;
+    }
+    if (!didSucceed) {
+      [self removeStylesheetWithPath:path];
+      return nil;
+    }
+    [self storeStylesheet:stylesheet withPath:path numberOfBytes:numberOfBytes];
+  }
   return stylesheet;
 }
 
@@ -70,4 +183,64 @@
   return [self stylesheetWithPath:path loadFromDisk:YES];
 }
 
+- (void)loadStylesheetWithPath:(NSString *)path completion:(void (^)(NIStylesheet* stylesheet))completion {
+  [self loadStylesheetWithPath:path priority:DISPATCH_QUEUE_PRIORITY_DEFAULT completion:completion];
+}
+
+- (void)loadStylesheetWithPath:(NSString *)path
+                      priority:(dispatch_queue_priority_t)priority
+                    completion:(void (^)(NIStylesheet* stylesheet))completion {
+  NIDASSERT(nil != path);
+  void (^block)(NIStylesheet*) = [completion copy];
+
+  @synchronized(self) {
+    NIStylesheet* stylesheet = [self cachedStylesheetWithPath:path];
+    if (nil != stylesheet) {
+      if (nil != block) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+          block(stylesheet);
+        });
+      }
+      return;
+    }
+
+    // Only parse each stylesheet once, however many screens are waiting for it.
+    NSMutableArray* completionBlocks = [_pathToCompletionBlocks objectForKey:path];
+    if (nil != completionBlocks) {
+      if (nil != block) {
+        [completionBlocks addObject:block];
+      }
+      return;
+    }
+    completionBlocks = [[NSMutableArray alloc] init];
+    if (nil != block) {
+      [completionBlocks addObject:block];
+    }
+    [_pathToCompletionBlocks setObject:completionBlocks forKey:path];
+  }
+
+  dispatch_async(dispatch_get_global_queue(priority, 0), ^{
+    NIStylesheet* stylesheet = [self stylesheetWithPath:path loadFromDisk:YES];
+
+    NSArray* completionBlocks = nil;
+    @synchronized(self) {
+      completionBlocks = [_pathToCompletionBlocks objectForKey:path];
+      [_pathToCompletionBlocks removeObjectForKey:path];
+    }
+    if ([completionBlocks count] > 0) {
+      dispatch_async(dispatch_get_main_queue(), ^{
+        for (void (^completionBlock)(NIStylesheet*) in completionBlocks) {
+          completionBlock(stylesheet);
+        }
+      });
+    }
+  });
+}
+
+- (void)preloadStylesheetsWithPaths:(NSArray *)paths {
+  for (NSString* path in paths) {
+    [self loadStylesheetWithPath:path priority:DISPATCH_QUEUE_PRIORITY_BACKGROUND completion:nil];
+  }
+}
+
 @end
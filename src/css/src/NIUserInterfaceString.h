@@ -45,8 +45,9 @@ extern NSString* const NIStringsDidChangeFilePathKey;
 @protocol NIUserInterfaceStringResolver
 @required
 /**
- * The default resolver will just call NSLocalizedString, but also watch the notification center
- * for incoming updates from Chameleon
+ * The default resolver reads the main bundle's Localizable.strings once, the way
+ * NSLocalizedString would, but also watches the notification center for incoming updates from
+ * Chameleon. Only the attached elements of strings whose values changed are updated.
  */
 -(NSString*)stringForKey: (NSString*) key withDefaultValue: (NSString*) value;
 /**
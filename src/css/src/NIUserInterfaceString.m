@@ -16,8 +16,11 @@
 
 #import "NIUserInterfaceString.h"
 #import "NIDebuggingTools.h"
+#import "NILaunchProfile.h"
 #import <objc/runtime.h>
 
+// Key => NSPointerArray of the attachments of the key's strings. The attachments are owned by the
+// elements they are attached to, so the map only holds them weakly.
 static NSMutableDictionary*               sStringToViewMap;
 static char                               sBaseStringAssocationKey;
 static id<NIUserInterfaceStringResolver>  sResolver;
@@ -30,7 +33,7 @@ NSString* const NIStringsDidChangeFilePathKey = @"NIStringsPathKey";
  * Information about an attachment
  */
 @interface NIUserInterfaceStringAttachment : NSObject
-@property (unsafe_unretained,nonatomic) id element;
+@property (weak,nonatomic) id element;
 @property (assign) SEL setter;
 @property (assign) UIControlState controlState;
 @property (assign) BOOL setterIsWithControlState;
@@ -44,6 +47,7 @@ NSString* const NIStringsDidChangeFilePathKey = @"NIStringsPathKey";
  */
 @interface NIUserInterfaceStringDeallocTracker : NSObject
 +(void)attachString: (NIUserInterfaceString*) string withInfo: (NIUserInterfaceStringAttachment*) attachment;
++(void)detachInfo: (NIUserInterfaceStringAttachment*) attachment fromElement: (id) element;
 @property (strong, nonatomic) NIUserInterfaceStringAttachment *attachment;
 @property (strong, nonatomic) NIUserInterfaceString *string;
 @end
@@ -58,8 +62,31 @@ NIUserInterfaceStringResolver
 // For dev/debug purposes, if we read "/* SHOW KEYS */" at the front of the file, we'll
 // just return all keys in the UI
 @property (nonatomic,assign) BOOL returnKeys;
+// The main bundle's Localizable.strings, or nil if it couldn't be read and lookups go through
+// NSLocalizedString instead
+@property (nonatomic,strong,readonly) NSDictionary *bundleStrings;
 @end
 
+@interface NIUserInterfaceString ()
+-(void)detachAttachment: (NIUserInterfaceStringAttachment*) attachment;
+@end
+
+////////////////////////////////////////////////////////////////////////////////
+// Strings files are built into binary property lists, so they are mapped and parsed in one go
+// rather than looking every string up through NSLocalizedString. Text strings files, such as the
+// ones Chameleon sends, parse the same way.
+static NSDictionary* NIStringsTableAtPath(NSString* path) {
+  if (nil == path) {
+    return nil;
+  }
+  NSData *data = [[NSData alloc] initWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nil];
+  if (nil == data) {
+    return nil;
+  }
+  id table = [NSPropertyListSerialization propertyListWithData:data options:NSPropertyListImmutable format:NULL error:nil];
+  return [table isKindOfClass:[NSDictionary class]] ? table : nil;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 @implementation NIUserInterfaceString
 
@@ -70,7 +97,12 @@ NIUserInterfaceStringResolver
 
 +(id<NIUserInterfaceStringResolver>)stringResolver
 {
-  return sResolver ?: (sResolver = [[NIUserInterfaceStringResolverDefault alloc] init]);
+  if (nil == sResolver) {
+    NIMeasureFirstUse(@"NIUserInterfaceString default resolver", ^{
+      sResolver = [[NIUserInterfaceStringResolverDefault alloc] init];
+    });
+  }
+  return sResolver;
 }
 
 -(NSMutableDictionary*) viewMap
@@ -143,21 +175,12 @@ NIUserInterfaceStringResolver
     @synchronized (viewMap) {
       // Call this first, because if there's an existing association, it will detach it in dealloc
       [NIUserInterfaceStringDeallocTracker attachString:self withInfo:attachment];
-      id existing = [viewMap objectForKey:_originalKey];
-      if (!existing) {
-        // Simple, no map exists, make one
-        [viewMap setObject:attachment forKey:_originalKey];
-      } else if ([existing isKindOfClass: [NIUserInterfaceStringAttachment class]]) {
-        // An attachment exists, convert it to a list
-        NSMutableArray *list = [[NSMutableArray alloc] initWithCapacity:2];
-        [list addObject:existing];
-        [list addObject:attachment];
-        [viewMap setObject:list forKey:_originalKey];
-      } else {
-        // NSMutableArray*
-        NSMutableArray *a = (NSMutableArray*) existing;
-        [a addObject: attachment];
+      NSPointerArray *attachments = [viewMap objectForKey:_originalKey];
+      if (!attachments) {
+        attachments = [NSPointerArray weakObjectsPointerArray];
+        [viewMap setObject:attachments forKey:_originalKey];
       }
+      [attachments addPointer:(__bridge void *)attachment];
     }
   }
   [attachment attach: _string];
@@ -169,6 +192,8 @@ NIUserInterfaceStringResolver
   if ([view respondsToSelector:@selector(setText:)]) {
     // UILabel
     [self detach: view withSelector:@selector(setText:) withControlState:UIControlStateNormal hasControlState:NO];
+  } else if ([view respondsToSelector:@selector(setTitle:forState:)]) {
+    [self detach: view withSelector:@selector(setTitle:forState:) withControlState:UIControlStateNormal hasControlState:YES];
   } else if ([view respondsToSelector:@selector(setTitle:)]) {
     [self detach: view withSelector:@selector(setTitle:) withControlState:UIControlStateNormal hasControlState:NO];
   } else {
@@ -191,14 +216,46 @@ NIUserInterfaceStringResolver
 {
   NSMutableDictionary *viewMap = self.viewMap;
   @synchronized (viewMap) {
-    
+    for (NIUserInterfaceStringAttachment *attachment in [[viewMap objectForKey:_originalKey] allObjects]) {
+      if (attachment.element == element
+          && sel_isEqual(attachment.setter, selector)
+          && attachment.setterIsWithControlState == hasControlState
+          && (!hasControlState || attachment.controlState == state)) {
+        [self detachAttachment:attachment];
+        [NIUserInterfaceStringDeallocTracker detachInfo:attachment fromElement:element];
+      }
+    }
+  }
+}
+
+-(void)detachAttachment:(NIUserInterfaceStringAttachment *)attachment
+{
+  NSMutableDictionary *viewMap = self.viewMap;
+  @synchronized (viewMap) {
+    NSPointerArray *attachments = [viewMap objectForKey:_originalKey];
+    for (NSUInteger ix = 0; ix < attachments.count; ix++) {
+      if ([attachments pointerAtIndex:ix] == (__bridge void *)attachment) {
+        [attachments removePointerAtIndex:ix];
+        break;
+      }
+    }
+    // Attachments that went away with their elements leave NULLs behind. -compact only removes
+    // them once a NULL has been added explicitly.
+    [attachments addPointer:NULL];
+    [attachments compact];
+    if (attachments && 0 == attachments.count) {
+      [viewMap removeObjectForKey:_originalKey];
+    }
   }
 }
 
 @end
 
 ////////////////////////////////////////////////////////////////////////////////
-@implementation NIUserInterfaceStringResolverDefault
+@implementation NIUserInterfaceStringResolverDefault {
+  NSDictionary *_bundleStrings;
+  BOOL _didLoadBundleStrings;
+}
 
 -(id)init
 {
@@ -219,28 +276,60 @@ NIUserInterfaceStringResolver
   NSString *path = [notification.userInfo objectForKey:NIStringsDidChangeFilePathKey];
   NSString *content = [[NSString alloc] initWithContentsOfFile:path encoding:NSUTF8StringEncoding error:nil];
 
+  NSDictionary *previousOverrides = self.overrides;
+  BOOL previousReturnKeys = self.returnKeys;
   if ([content hasPrefix:@"/* SHOW KEYS */"]) {
     self.returnKeys = YES;
   } else {
     self.returnKeys = NO;
   }
-  self.overrides = [[NSDictionary alloc] initWithContentsOfFile:path];
-  if (sStringToViewMap && self.overrides.count > 0) {
-    @synchronized (sStringToViewMap) {
-      [sStringToViewMap enumerateKeysAndObjectsUsingBlock:^(NSString* key, id obj, BOOL *stop) {
-        NSString *o = self.returnKeys ? key : [self.overrides objectForKey:key];
-        if (o) {
-          if ([obj isKindOfClass:[NIUserInterfaceStringAttachment class]]) {
-            [((NIUserInterfaceStringAttachment*)obj) attach: o];
-          } else {
-            NSArray *attachments = (NSArray*) obj;
-            for (NIUserInterfaceStringAttachment *a in attachments) {
-              [a attach:o];
-            }
-          }
+  self.overrides = NIStringsTableAtPath(path);
+  if (!sStringToViewMap) {
+    return;
+  }
+  @synchronized (sStringToViewMap) {
+    // Only the strings whose value changed need to be sent to their elements again.
+    NSMutableSet *changedKeys = nil;
+    if (self.returnKeys != previousReturnKeys) {
+      changedKeys = [NSMutableSet setWithArray:[sStringToViewMap allKeys]];
+    } else if (!self.returnKeys) {
+      changedKeys = [NSMutableSet setWithArray:[previousOverrides allKeys]];
+      [changedKeys addObjectsFromArray:[self.overrides allKeys]];
+      for (NSString *key in [changedKeys allObjects]) {
+        NSString *previous = [previousOverrides objectForKey:key];
+        NSString *current = [self.overrides objectForKey:key];
+        if (previous == current || [previous isEqualToString:current]) {
+          [changedKeys removeObject:key];
         }
-      }];
+      }
+    }
+    for (NSString *key in changedKeys) {
+      NSPointerArray *attachments = [sStringToViewMap objectForKey:key];
+      if (attachments.count == 0) {
+        continue;
+      }
+      // A removed override reverts to the bundle's string, or to whatever NSLocalizedString
+      // makes of the key if the bundle's strings couldn't be read or don't have it.
+      NSString *o = self.returnKeys ? key : ([self.overrides objectForKey:key]
+                                             ?: [self.bundleStrings objectForKey:key]
+                                             ?: NSLocalizedString(key, nil));
+      for (NIUserInterfaceStringAttachment *a in [attachments allObjects]) {
+        [a attach:o];
+      }
+    }
+  }
+}
+
+-(NSDictionary *)bundleStrings
+{
+  @synchronized (self) {
+    if (!_bundleStrings && !_didLoadBundleStrings) {
+      NIMeasureFirstUse(@"NIUserInterfaceString bundle strings", ^{
+        self->_bundleStrings = NIStringsTableAtPath([[NSBundle mainBundle] pathForResource:@"Localizable" ofType:@"strings"]);
+      });
+      _didLoadBundleStrings = YES;
     }
+    return _bundleStrings;
   }
 }
 
@@ -255,7 +344,12 @@ NIUserInterfaceStringResolver
       return overridden;
     }
   }
-  return NSLocalizedStringWithDefaultValue(key, nil, [NSBundle mainBundle], value, nil);
+  NSDictionary *bundleStrings = self.bundleStrings;
+  if (!bundleStrings) {
+    return NSLocalizedStringWithDefaultValue(key, nil, [NSBundle mainBundle], value, nil);
+  }
+  // Missing strings fall back the way NSLocalizedString does.
+  return [bundleStrings objectForKey:key] ?: (value.length > 0 ? value : key);
 }
 
 -(BOOL)isChangeTrackingEnabled
@@ -302,8 +396,21 @@ NIUserInterfaceStringResolver
   objc_setAssociatedObject(attachment.element, key, tracker, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
 }
 
++(void)detachInfo:(NIUserInterfaceStringAttachment *)attachment fromElement:(id)element
+{
+  char* key = &sBaseStringAssocationKey;
+  if (attachment.setterIsWithControlState) {
+    key += attachment.controlState;
+  }
+  NIUserInterfaceStringDeallocTracker *tracker = objc_getAssociatedObject(element, key);
+  if (tracker.attachment == attachment) {
+    objc_setAssociatedObject(element, key, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+  }
+}
+
 -(void)dealloc
 {
-  [self.string detach:self.attachment.element withSelector:self.attachment.setter withControlState:self.attachment.controlState hasControlState:self.attachment.setterIsWithControlState];
+  // By now the element may be deallocating, so the attachment is detached by identity.
+  [self.string detachAttachment:self.attachment];
 }
 @end
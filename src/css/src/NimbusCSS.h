@@ -260,8 +260,10 @@ _chameleonObserver = [[NIChameleonObserver alloc] initWithStylesheetCache:_style
 
 #import "NICSSRuleSet.h"
 #import "NICSSParser.h"
+#import "NICompiledStylesheet.h"
 #import "NIDOM.h"
 #import "NIStyleable.h"
+#import "NIStyleApplier.h"
 #import "NIStylesheet.h"
 #import "NIStylesheetCache.h"
 #import "NIChameleonObserver.h"
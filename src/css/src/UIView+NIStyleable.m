@@ -49,6 +49,14 @@ NSString* const NICSSViewBackgroundColorKey = @"bg";
 // We split this up because we want to add all the subviews to the DOM in the order they were created
 @interface UIView (NIStyleablePrivate)
 -(void)_buildSubviews:(NSArray *)viewSpecs inDOM:(NIDOM *)dom withViewArray: (NSMutableArray*) subviews;
+- (UIView *)relativeViewForRuleSet:(NICSSRuleset *)ruleSet inDOM:(NIDOM *)dom;
+@end
+
+// Implemented in NIDOM.m.
+@interface NIDOM (NIStyleableLayoutPass)
+- (void)beginLayoutPass;
+- (void)endLayoutPass;
+- (BOOL)deferLayoutOfView:(UIView *)view withRuleSet:(NICSSRuleset *)ruleSet;
 @end
 
 NI_FIX_CATEGORY_BUG(UIView_NIStyleable)
@@ -78,6 +86,13 @@ CGFloat NICSSUnitToPixels(NICSSUnit unit, CGFloat container);
 
 - (NSString*)applyOrDescribe: (BOOL) apply ruleSet: (NICSSRuleset*) ruleSet inDOM: (NIDOM*)dom withViewName: (NSString*) name {
   NSMutableString *desc = apply ? nil : [[NSMutableString alloc] init];
+  [self applyOrDescribeAppearance:apply ruleSet:ruleSet withViewName:name description:desc];
+  [self applyOrDescribeLayout:apply ruleSet:ruleSet inDOM:dom withViewName:name description:desc];
+  return desc;
+}
+
+// The properties that can be set independently of one another and of the view hierarchy.
+- (void)applyOrDescribeAppearance: (BOOL) apply ruleSet: (NICSSRuleset*) ruleSet withViewName: (NSString*) name description: (NSMutableString*) desc {
   //      [desc appendFormat:@"%@. = %f;\n"];
   if ([ruleSet hasBackgroundColor]) {
     if (apply) {
@@ -132,7 +147,15 @@ CGFloat NICSSUnitToPixels(NICSSUnit unit, CGFloat container);
       [desc appendFormat:@"%@.hidden = %@;\n", name, ruleSet.visible ? @"NO" : @"YES"];
     }
   }
-  
+}
+
+// Sizing and positioning, which depend on the superview, the DOM and on each other, so are always
+// applied together and in this order.
+- (void)applyOrDescribeLayout: (BOOL) apply ruleSet: (NICSSRuleset*) ruleSet inDOM: (NIDOM*)dom withViewName: (NSString*) name description: (NSMutableString*) desc {
+  // During a layout pass the DOM positions each view once, after the views it depends on.
+  if (apply && [dom deferLayoutOfView:self withRuleSet:ruleSet]) {
+    return;
+  }
     // View sizing
     // Special case auto/auto height and width
   if ([ruleSet hasWidth] && [ruleSet hasHeight] &&
@@ -482,30 +505,7 @@ CGFloat NICSSUnitToPixels(NICSSUnit unit, CGFloat container);
   
     // Relative positioning to other identified views
     if (ruleSet.hasRelativeToId) {
-    NSString *viewSpec = ruleSet.relativeToId;
-    UIView* relative = nil;
-    if ([viewSpec characterAtIndex:0] == '.') {
-      if ([viewSpec caseInsensitiveCompare:@".next"] == NSOrderedSame) {
-        NSInteger ix = [self.superview.subviews indexOfObject:self];
-        if (++ix < self.superview.subviews.count) {
-          relative = [self.superview.subviews objectAtIndex:ix];
-        }
-      } else if ([viewSpec caseInsensitiveCompare:@".prev"] == NSOrderedSame) {
-        NSInteger ix = [self.superview.subviews indexOfObject:self];
-        if (ix > 0) {
-          relative = [self.superview.subviews objectAtIndex:ix-1];
-        }
-      } else if ([viewSpec caseInsensitiveCompare:@".first"] == NSOrderedSame) {
-        relative = [self.superview.subviews objectAtIndex:0];
-        if (relative == self) { relative = nil; }
-      } else if ([viewSpec caseInsensitiveCompare:@".last"] == NSOrderedSame) {
-        relative = [self.superview.subviews lastObject];
-        if (relative == self) { relative = nil; }
-      }
-    } else {
-      // For performance, I'm not going to try and fix up your bad selectors. Start with a # or it will fail.
-      relative = [dom viewById:ruleSet.relativeToId];
-    }
+    UIView* relative = [self relativeViewForRuleSet:ruleSet inDOM:dom];
     if (relative) {
       CGPoint anchor;
       
@@ -631,7 +631,6 @@ CGFloat NICSSUnitToPixels(NICSSUnit unit, CGFloat container);
       }
     }
   }
-  return desc;
 }
 
 -(NSArray *)buildSubviews:(NSArray *)viewSpecs inDOM:(NIDOM *)dom
@@ -639,6 +638,8 @@ CGFloat NICSSUnitToPixels(NICSSUnit unit, CGFloat container);
   NSMutableArray *subviews = [[NSMutableArray alloc] init];
   [self _buildSubviews:viewSpecs inDOM:dom withViewArray:subviews];
   
+  // Views may be positioned relative to siblings that are registered after them.
+  [dom beginLayoutPass];
   for (NSUInteger ix = 0, ct = subviews.count; ix < ct; ix++) {
     NIPrivateViewInfo *viewInfo = [subviews objectAtIndex:ix];
     NSString *firstClass = [viewInfo.cssClasses count] ? [viewInfo.cssClasses objectAtIndex:0] : nil;
@@ -660,6 +661,7 @@ CGFloat NICSSUnitToPixels(NICSSUnit unit, CGFloat container);
     }
     [subviews replaceObjectAtIndex:ix withObject:viewInfo.view];
   }
+  [dom endLayoutPass];
   return subviews;
 }
 
@@ -770,6 +772,38 @@ CGFloat NICSSUnitToPixels(NICSSUnit unit, CGFloat container)
 }
 
 @implementation UIView (NIStyleablePrivate)
+
+- (UIView *)relativeViewForRuleSet:(NICSSRuleset *)ruleSet inDOM:(NIDOM *)dom {
+  if (!ruleSet.hasRelativeToId) {
+    return nil;
+  }
+  NSString *viewSpec = ruleSet.relativeToId;
+  UIView* relative = nil;
+  if ([viewSpec characterAtIndex:0] == '.') {
+    if ([viewSpec caseInsensitiveCompare:@".next"] == NSOrderedSame) {
+      NSInteger ix = [self.superview.subviews indexOfObject:self];
+      if (++ix < self.superview.subviews.count) {
+        relative = [self.superview.subviews objectAtIndex:ix];
+      }
+    } else if ([viewSpec caseInsensitiveCompare:@".prev"] == NSOrderedSame) {
+      NSInteger ix = [self.superview.subviews indexOfObject:self];
+      if (ix > 0) {
+        relative = [self.superview.subviews objectAtIndex:ix-1];
+      }
+    } else if ([viewSpec caseInsensitiveCompare:@".first"] == NSOrderedSame) {
+      relative = [self.superview.subviews objectAtIndex:0];
+      if (relative == self) { relative = nil; }
+    } else if ([viewSpec caseInsensitiveCompare:@".last"] == NSOrderedSame) {
+      relative = [self.superview.subviews lastObject];
+      if (relative == self) { relative = nil; }
+    }
+  } else {
+    // For performance, I'm not going to try and fix up your bad selectors. Start with a # or it will fail.
+    relative = [dom viewById:ruleSet.relativeToId];
+  }
+  return relative;
+}
+
 -(void)_buildSubviews:(NSArray *)viewSpecs inDOM:(NIDOM *)dom withViewArray:(NSMutableArray *)subviews
 {
   NIPrivateViewInfo *active = nil;
@@ -186,4 +186,60 @@
   XCTAssertTrue([[[[rulesets objectForKey:@"UIButton"] objectForKey:@"height"] objectAtIndex:0] isEqualToString:@"20px"], @"Value should match.");
 }
 
+- (void)testConcurrentParsersProduceIdenticalResults {
+  NSString* pathPrefix = NIPathForBundleResource(_unitTestBundle, nil);
+  NSDictionary* expected = [[[NICSSParser alloc] init] dictionaryForPath:@"includer.css" pathPrefix:pathPrefix];
+  XCTAssertNotNil(expected, @"The file should have been parsed.");
+
+  const size_t numberOfParsers = 16;
+  NSMutableArray* results = [NSMutableArray array];
+  dispatch_apply(numberOfParsers, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t ix) {
+    NICSSParser* parser = [[NICSSParser alloc] init];
+    NSDictionary* rulesets = [parser dictionaryForPath:@"includer.css" pathPrefix:pathPrefix];
+    @synchronized(results) {
+      [results addObject:(nil != rulesets) ? rulesets : [NSNull null]];
+    }
+  });
+
+  XCTAssertEqual([results count], numberOfParsers, @"Every parser should have finished.");
+  for (NSDictionary* rulesets in results) {
+    XCTAssertEqualObjects(rulesets, expected, @"Concurrent parses should not interfere with each other.");
+  }
+}
+
+- (void)testDataMatchesFile {
+  NSString* pathPrefix = NIPathForBundleResource(_unitTestBundle, nil);
+  NSDictionary* expected = [[[NICSSParser alloc] init] dictionaryForPath:@"includer.css" pathPrefix:pathPrefix];
+
+  NSData* data = [NSData dataWithContentsOfFile:[pathPrefix stringByAppendingPathComponent:@"includer.css"]];
+  NICSSParser* parser = [[NICSSParser alloc] init];
+  NSDictionary* rulesets = [parser dictionaryForData:data pathPrefix:pathPrefix];
+  XCTAssertFalse(parser.didFailToParse, @"The data should have been parsed.");
+  XCTAssertEqualObjects(rulesets, expected, @"Parsing the data should match parsing the file.");
+
+  NSData* css = [@"UILabel { font-size: 12; }" dataUsingEncoding:NSUTF8StringEncoding];
+  rulesets = [parser dictionaryForData:css];
+  XCTAssertTrue([[[[rulesets objectForKey:@"UILabel"] objectForKey:@"font-size"] objectAtIndex:0] isEqualToString:@"12"], @"Value should match.");
+  XCTAssertNil([rulesets objectForKey:kDependenciesSelectorKey], @"There should be no dependencies.");
+
+  XCTAssertNil([parser dictionaryForData:nil], @"Parsing nil data should result in nil.");
+}
+
+- (void)testRulesetsShareTokenStrings {
+  NSData* css = [@"UILabel { COLOR: #fff; width: 10px; }\nUIButton { color: #fff; height: 10px; }"
+                 dataUsingEncoding:NSUTF8StringEncoding];
+  NSDictionary* rulesets = [[[NICSSParser alloc] init] dictionaryForData:css];
+  NSDictionary* label = [rulesets objectForKey:@"UILabel"];
+  NSDictionary* button = [rulesets objectForKey:@"UIButton"];
+
+  NSString* labelPropertyName = [[label objectForKey:kPropertyOrderKey] objectAtIndex:0];
+  NSString* buttonPropertyName = [[button objectForKey:kPropertyOrderKey] objectAtIndex:0];
+  XCTAssertEqualObjects(labelPropertyName, @"color", @"Property names should be lowercase.");
+  XCTAssertEqual(labelPropertyName, buttonPropertyName, @"Property names should be one string.");
+  XCTAssertEqual(labelPropertyName, [NICSSRuleset propertyNameForName:@"color"], @"Property names should be the ruleset's keys.");
+  XCTAssertEqual([[label objectForKey:@"color"] objectAtIndex:0], [[button objectForKey:@"color"] objectAtIndex:0], @"Equal values should be one string.");
+  XCTAssertEqual([[label objectForKey:@"width"] objectAtIndex:0], [[button objectForKey:@"height"] objectAtIndex:0]);
+  XCTAssertNil([NICSSRuleset propertyNameForName:@"not-a-property"]);
+}
+
 @end
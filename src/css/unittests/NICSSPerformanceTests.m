@@ -0,0 +1,180 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NimbusCSS.h"
+#import "NITestAllocationLogging.h"
+
+// The fixtures approximate a large app theme styling a dense screen.
+static const NSInteger kThemeClassCount = 1000;
+static const NSInteger kViewCount = 1000;
+static const NSInteger kToggleCount = 200;
+
+/**
+ * Builds a theme with five rulesets for each of kThemeClassCount CSS classes: the class itself,
+ * a view class qualified by it, a descendant scope, a pseudo-class and an id.
+ */
+static NSData* NIBenchmarkThemeData(void) {
+  NSMutableString* css = [NSMutableString string];
+  [css appendString:@"UIView { background-color: white; }\n"];
+  [css appendString:@"UILabel { color: black; font-size: 14; }\n"];
+  [css appendString:@".active { background-color: #FF0000; }\n"];
+  for (NSInteger ix = 0; ix < kThemeClassCount; ++ix) {
+    [css appendFormat:@".theme%zd { background-color: #%06zX; opacity: 0.9; }\n", ix, ix * 16];
+    [css appendFormat:@"UILabel.theme%zd { color: rgb(%zd, 0, 0); font-size: %zd; }\n",
+     ix, ix % 256, 10 + ix % 10];
+    [css appendFormat:@".root .theme%zd { border-width: 1; border-color: black; }\n", ix];
+    [css appendFormat:@".theme%zd:selected { color: blue; }\n", ix];
+    [css appendFormat:@"#view%zd { width: %zd; height: 20; }\n", ix, 100 + ix % 50];
+  }
+  return [css dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+static NIStylesheet* NIBenchmarkStylesheet(NSData* data) {
+  NIStylesheet* stylesheet = [[NIStylesheet alloc] init];
+  [stylesheet loadFromData:data pathPrefix:nil delegate:nil];
+  return stylesheet;
+}
+
+@interface NICSSPerformanceTests : XCTestCase {
+@private
+  NSData* _themeData;
+}
+
+@end
+
+
+@implementation NICSSPerformanceTests
+
+
+- (void)setUp {
+  _themeData = NIBenchmarkThemeData();
+}
+
+- (void)tearDown {
+  _themeData = nil;
+}
+
+- (NSArray *)viewsForBenchmark {
+  NSMutableArray* views = [NSMutableArray arrayWithCapacity:kViewCount];
+  UIView* rootView = [[UIView alloc] initWithFrame:CGRectMake(0, 0, 320, 480)];
+  for (NSInteger ix = 0; ix < kViewCount; ++ix) {
+    UILabel* label = [[UILabel alloc] init];
+    [rootView addSubview:label];
+    [views addObject:label];
+  }
+  return views;
+}
+
+- (NIDOM *)domForViews:(NSArray *)views stylesheet:(NIStylesheet *)stylesheet {
+  NIDOM* dom = [NIDOM domWithStylesheet:stylesheet];
+  NSInteger ix = 0;
+  for (UIView* view in views) {
+    [dom registerView:view
+         withCSSClass:[NSString stringWithFormat:@"theme%zd", ix % kThemeClassCount]
+                andId:[NSString stringWithFormat:@"view%zd", ix]];
+    ++ix;
+  }
+  return dom;
+}
+
+- (void)testPerformanceOfParsingTheme {
+  NITestLogAllocationsOfPhase(@"Parse", ^{
+    NIBenchmarkStylesheet(_themeData);
+  });
+  [self measureBlock:^{
+    @autoreleasepool {
+      NIStylesheet* stylesheet = NIBenchmarkStylesheet(_themeData);
+      XCTAssertNotNil([stylesheet rulesetForClassName:@".theme0"]);
+    }
+  }];
+}
+
+- (void)testPerformanceOfResolvingRulesets {
+  NSMutableArray* classNames = [NSMutableArray arrayWithCapacity:kThemeClassCount];
+  for (NSInteger ix = 0; ix < kThemeClassCount; ++ix) {
+    [classNames addObject:[NSString stringWithFormat:@"UILabel.theme%zd#view%zd", ix, ix]];
+  }
+  void (^resolve)(NIStylesheet*) = ^(NIStylesheet* stylesheet) {
+    for (NSString* className in classNames) {
+      [stylesheet rulesetForClassName:className];
+    }
+  };
+  NITestLogAllocationsOfPhase(@"Resolve", ^{
+    resolve(NIBenchmarkStylesheet(_themeData));
+  });
+
+  // Each iteration resolves against a fresh stylesheet so that none of the rulesets are cached.
+  [self measureMetrics:[[self class] defaultPerformanceMetrics]
+automaticallyStartMeasuring:NO
+              forBlock:^{
+    @autoreleasepool {
+      NIStylesheet* stylesheet = NIBenchmarkStylesheet(_themeData);
+      [self startMeasuring];
+      resolve(stylesheet);
+      [self stopMeasuring];
+    }
+  }];
+}
+
+- (void)testPerformanceOfStylingDOM {
+  NIStylesheet* stylesheet = NIBenchmarkStylesheet(_themeData);
+  NITestLogAllocationsOfPhase(@"Style", ^{
+    NIDOM* dom = [self domForViews:[self viewsForBenchmark] stylesheet:stylesheet];
+    [dom refreshIfNeeded];
+  });
+
+  [self measureMetrics:[[self class] defaultPerformanceMetrics]
+automaticallyStartMeasuring:NO
+              forBlock:^{
+    @autoreleasepool {
+      NSArray* views = [self viewsForBenchmark];
+      [self startMeasuring];
+      NIDOM* dom = [self domForViews:views stylesheet:stylesheet];
+      [dom refreshIfNeeded];
+      [self stopMeasuring];
+    }
+  }];
+}
+
+- (void)testPerformanceOfTogglingClasses {
+  NIStylesheet* stylesheet = NIBenchmarkStylesheet(_themeData);
+  NSArray* views = [self viewsForBenchmark];
+  NIDOM* dom = [self domForViews:views stylesheet:stylesheet];
+  [dom refreshIfNeeded];
+
+  void (^toggle)(void) = ^{
+    for (NSInteger ix = 0; ix < kToggleCount; ++ix) {
+      UIView* view = views[(ix * 7) % views.count];
+      [dom addCssClass:@"active" toView:view];
+      [dom refreshIfNeeded];
+      [dom removeCssClass:@"active" fromView:view];
+      [dom refreshIfNeeded];
+    }
+  };
+  NITestLogAllocationsOfPhase(@"Toggle", toggle);
+  [self measureBlock:^{
+    @autoreleasepool {
+      toggle();
+    }
+  }];
+}
+
+@end
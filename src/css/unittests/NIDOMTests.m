@@ -0,0 +1,108 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NimbusCSS.h"
+
+// Implemented in NIDOM.m.
+@interface NIDOM (NIDOMTestsLayoutPass)
+- (void)beginLayoutPass;
+- (void)endLayoutPass;
+@end
+
+@interface NIDOMTests : XCTestCase
+@end
+
+
+@implementation NIDOMTests
+
+
+- (NIDOM *)domWithCSS:(NSString *)css {
+  NIStylesheet* stylesheet = [[NIStylesheet alloc] init];
+  XCTAssertTrue([stylesheet loadFromData:[css dataUsingEncoding:NSUTF8StringEncoding]
+                              pathPrefix:nil
+                                delegate:nil]);
+  return [NIDOM domWithStylesheet:stylesheet];
+}
+
+- (void)testViewsAreLaidOutAfterTheViewsTheyArePositionedRelativeTo {
+  NIDOM* dom = [self domWithCSS:
+                @"#first { -mobile-relative: #second; margin-top: 10px; width: 10px; height: 10px; }\n"
+                @"#second { top: 100px; width: 10px; height: 20px; }\n"];
+  UIView* container = [[UIView alloc] initWithFrame:CGRectMake(0, 0, 320, 480)];
+  UIView* first = [[UIView alloc] init];
+  UIView* second = [[UIView alloc] init];
+  [container addSubview:first];
+  [container addSubview:second];
+
+  // The first view is styled first, but is positioned relative to a view registered later.
+  [dom registerView:first withCSSClass:nil andId:@"first"];
+  [dom registerView:second withCSSClass:nil andId:@"second"];
+  second.frame = CGRectZero;
+
+  [dom refresh];
+
+  XCTAssertEqual(second.frame.origin.y, (CGFloat)100);
+  XCTAssertEqual(first.frame.origin.y, (CGFloat)130,
+                 @"The first view should be positioned against the second view's new frame.");
+}
+
+- (void)testLayoutCyclesAreBrokenAndEveryViewIsLaidOut {
+  NIDOM* dom = [self domWithCSS:
+                @"#first { -mobile-relative: #second; margin-top: 10px; width: 10px; height: 10px; }\n"
+                @"#second { -mobile-relative: #first; margin-top: 10px; width: 20px; height: 20px; }\n"];
+  UIView* container = [[UIView alloc] initWithFrame:CGRectMake(0, 0, 320, 480)];
+  UIView* first = [[UIView alloc] init];
+  UIView* second = [[UIView alloc] init];
+  [container addSubview:first];
+  [container addSubview:second];
+  [dom registerView:first withCSSClass:nil andId:@"first"];
+  [dom registerView:second withCSSClass:nil andId:@"second"];
+  first.frame = CGRectZero;
+  second.frame = CGRectZero;
+
+  [dom refresh];
+
+  XCTAssertTrue(CGSizeEqualToSize(first.frame.size, CGSizeMake(10, 10)), @"The first view should be laid out.");
+  XCTAssertTrue(CGSizeEqualToSize(second.frame.size, CGSizeMake(20, 20)), @"The second view should be laid out.");
+}
+
+- (void)testUnregisteredViewsAreDroppedFromThePendingLayout {
+  NIDOM* dom = [self domWithCSS:@"#first { width: 10px; height: 10px; }\n"
+                                @"#second { width: 20px; height: 20px; }\n"];
+  UIView* first = [[UIView alloc] init];
+  UIView* second = [[UIView alloc] init];
+  [dom registerView:first withCSSClass:nil andId:@"first"];
+  [dom registerView:second withCSSClass:nil andId:@"second"];
+  first.frame = CGRectZero;
+  second.frame = CGRectZero;
+
+  // The outer pass holds on to the layout that the refresh defers.
+  [dom beginLayoutPass];
+  [dom refresh];
+  XCTAssertTrue(CGRectEqualToRect(first.frame, CGRectZero), @"The layout should have been deferred.");
+  [dom unregisterView:first];
+  [dom endLayoutPass];
+
+  XCTAssertTrue(CGRectEqualToRect(first.frame, CGRectZero), @"The unregistered view should not be laid out.");
+  XCTAssertTrue(CGSizeEqualToSize(second.frame.size, CGSizeMake(20, 20)), @"The other view should be laid out.");
+}
+
+@end
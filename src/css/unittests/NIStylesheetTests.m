@@ -50,6 +50,333 @@
   XCTAssertFalse([stylesheet loadFromPath:@"nonexistent_file"], @"Parsing invalid file should fail.");
 }
 
+- (void)testCompiledStylesheetsSkipParsingUntilTheCSSChanges {
+  NSFileManager* fileManager = [NSFileManager defaultManager];
+  NSString* directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+  XCTAssertTrue([fileManager createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil]);
+  for (NSString* filename in @[@"includer.css", @"includee.css"]) {
+    XCTAssertTrue([fileManager copyItemAtPath:NIPathForBundleResource(_unitTestBundle, filename)
+                                       toPath:[directory stringByAppendingPathComponent:filename]
+                                        error:nil]);
+  }
+
+  XCTAssertTrue([NIStylesheet compileStylesheetAtPath:@"includer.css" pathPrefix:directory toPath:nil],
+                @"The stylesheet should compile.");
+  NSString* compiledPath = [NIStylesheet compiledPathForPath:[directory stringByAppendingPathComponent:@"includer.css"]];
+  NICompiledStylesheet* compiledStylesheet = [[NICompiledStylesheet alloc] initWithContentsOfFile:compiledPath];
+  NSDictionary* rulesets = [[[NICSSParser alloc] init] dictionaryForPath:@"includer.css" pathPrefix:directory];
+  XCTAssertEqualObjects(compiledStylesheet.rulesets, rulesets, @"Compiling should preserve every rule set.");
+  XCTAssertEqualObjects([compiledStylesheet.significantScopeToScopes objectForKey:@"UIButton"], @[@"UIButton"]);
+
+  NSData* data = [NSData dataWithContentsOfFile:compiledPath];
+  XCTAssertNil([[NICompiledStylesheet alloc] initWithData:[data subdataWithRange:NSMakeRange(0, data.length - 1)]],
+               @"Truncated stylesheets should be rejected.");
+
+  // Change the CSS but make it look older than the compiled stylesheet.
+  NSString* includerPath = [directory stringByAppendingPathComponent:@"includer.css"];
+  [@"UIButton { height: 99px; }" writeToFile:includerPath atomically:YES encoding:NSUTF8StringEncoding error:nil];
+  [fileManager setAttributes:@{NSFileModificationDate: [NSDate dateWithTimeIntervalSinceNow:-3600]}
+                ofItemAtPath:includerPath
+                       error:nil];
+
+  NIStylesheet* stylesheet = [[NIStylesheet alloc] init];
+  XCTAssertTrue([stylesheet loadFromPath:@"includer.css" pathPrefix:directory]);
+  XCTAssertEqualObjects([[stylesheet rulesetForClassName:@"UIButton"] cssRuleForKey:@"height"], @[@"20px"],
+                        @"The compiled stylesheet should have been loaded.");
+  XCTAssertEqualObjects(stylesheet.dependencies, [NSSet setWithObject:@"includee.css"]);
+
+  // Touching an import makes the compiled stylesheet stale.
+  [fileManager setAttributes:@{NSFileModificationDate: [NSDate dateWithTimeIntervalSinceNow:3600]}
+                ofItemAtPath:[directory stringByAppendingPathComponent:@"includee.css"]
+                       error:nil];
+  stylesheet = [[NIStylesheet alloc] init];
+  XCTAssertTrue([stylesheet loadFromPath:@"includer.css" pathPrefix:directory]);
+  XCTAssertEqualObjects([[stylesheet rulesetForClassName:@"UIButton"] cssRuleForKey:@"height"], @[@"99px"],
+                        @"A stale compiled stylesheet should be ignored.");
+
+  [fileManager removeItemAtPath:directory error:nil];
+}
+
+// Writes each of the given files to a new temporary directory and returns the directory.
+- (NSString *)directoryWithStylesheets:(NSDictionary *)filenameToCSS {
+  NSString* directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+  XCTAssertTrue([[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil]);
+  for (NSString* filename in filenameToCSS) {
+    [filenameToCSS[filename] writeToFile:[directory stringByAppendingPathComponent:filename]
+                              atomically:YES
+                                encoding:NSUTF8StringEncoding
+                                   error:nil];
+  }
+  return directory;
+}
+
+- (void)testStylesheetCacheLoadsInTheBackground {
+  NSString* directory = [self directoryWithStylesheets:@{@"a.css": @"UIButton { width: 10px; }"}];
+  NIStylesheetCache* cache = [[NIStylesheetCache alloc] initWithPathPrefix:directory];
+
+  NSMutableArray* stylesheets = [NSMutableArray array];
+  __block BOOL didCompleteOnMainThread = YES;
+  __block BOOL didCompleteMissing = NO;
+  __block NIStylesheet* missingStylesheet = nil;
+  for (NSInteger ix = 0; ix < 2; ++ix) {
+    [cache loadStylesheetWithPath:@"a.css" completion:^(NIStylesheet* stylesheet) {
+      didCompleteOnMainThread = didCompleteOnMainThread && [NSThread isMainThread];
+      [stylesheets addObject:stylesheet ?: [NSNull null]];
+    }];
+  }
+  [cache loadStylesheetWithPath:@"missing.css" completion:^(NIStylesheet* stylesheet) {
+    missingStylesheet = stylesheet;
+    didCompleteMissing = YES;
+  }];
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while ((stylesheets.count < 2 || !didCompleteMissing) && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+
+  XCTAssertEqual(stylesheets.count, (NSUInteger)2);
+  XCTAssertTrue(didCompleteOnMainThread, @"Completions should be called on the main queue.");
+  XCTAssertTrue([stylesheets.firstObject isKindOfClass:[NIStylesheet class]]);
+  XCTAssertEqual(stylesheets.firstObject, stylesheets.lastObject, @"Both loads should share one parse.");
+  XCTAssertEqual([cache stylesheetWithPath:@"a.css" loadFromDisk:NO], stylesheets.firstObject,
+                 @"The loaded stylesheet should be cached.");
+  XCTAssertTrue(didCompleteMissing);
+  XCTAssertNil(missingStylesheet, @"Stylesheets that can't be loaded complete with nil.");
+
+  [[NSFileManager defaultManager] removeItemAtPath:directory error:nil];
+}
+
+- (void)testStylesheetCacheEvictsTheLeastRecentlyUsed {
+  NSString* css = @"UIButton { width: 10px; }";
+  unsigned long long numberOfBytes = [css lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+  NSString* directory = [self directoryWithStylesheets:@{@"a.css": css, @"b.css": css, @"c.css": css}];
+  NIStylesheetCache* cache = [[NIStylesheetCache alloc] initWithPathPrefix:directory];
+  cache.maxNumberOfBytes = numberOfBytes * 2;
+
+  NIStylesheet* a = [cache stylesheetWithPath:@"a.css"];
+  __weak NIStylesheet* weakB = nil;
+  @autoreleasepool {
+    weakB = [cache stylesheetWithPath:@"b.css"];
+  }
+  XCTAssertNotNil(weakB, @"The cache should hold on to b.");
+  XCTAssertEqual(cache.numberOfBytes, numberOfBytes * 2);
+
+  // Using a makes b the least recently used.
+  XCTAssertEqual([cache stylesheetWithPath:@"a.css"], a);
+  NIStylesheet* c = [cache stylesheetWithPath:@"c.css"];
+  XCTAssertNotNil(c);
+  XCTAssertEqual(cache.numberOfBytes, numberOfBytes * 2, @"The cache should stay within its budget.");
+  XCTAssertNil(weakB, @"b should have been evicted and released.");
+
+  // Loading b again evicts a, which is still in use and so is handed out again rather than parsed anew.
+  XCTAssertNotNil([cache stylesheetWithPath:@"b.css"]);
+  XCTAssertEqual([cache stylesheetWithPath:@"a.css"], a, @"Evicted stylesheets in use should be shared.");
+  XCTAssertEqual(cache.numberOfBytes, numberOfBytes * 2);
+
+  [[NSFileManager defaultManager] removeItemAtPath:directory error:nil];
+}
+
+- (void)testRulesetsCanBeLookedUpFromAnyThread {
+  NSMutableString* css = [NSMutableString string];
+  for (NSInteger ix = 0; ix < 50; ++ix) {
+    [css appendFormat:@".cell%d { color: red; width: %dpx; }\n", (int)ix, (int)ix];
+  }
+  NIStylesheet* stylesheet = [[NIStylesheet alloc] init];
+  XCTAssertTrue([stylesheet loadFromData:[css dataUsingEncoding:NSUTF8StringEncoding] pathPrefix:nil delegate:nil]);
+
+  __block NSInteger numberOfMismatches = 0;
+  dispatch_apply(200, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t iteration) {
+    NSInteger ix = (NSInteger)(iteration % 50);
+    NICSSRuleset* ruleset = [stylesheet rulesetForClassName:[NSString stringWithFormat:@".cell%d", (int)ix]];
+    NSString* width = [NSString stringWithFormat:@"%dpx", (int)ix];
+    if (![ruleset hasTextColor] || nil == [ruleset textColor] || ![[ruleset cssRuleForKey:@"width"] isEqual:@[width]]) {
+      @synchronized(stylesheet) {
+        numberOfMismatches++;
+      }
+    }
+  });
+  XCTAssertEqual(numberOfMismatches, (NSInteger)0, @"Concurrent lookups should see complete rulesets.");
+
+  NICSSRuleset* ruleset = [stylesheet rulesetForClassName:@".cell7"];
+  XCTAssertEqual([stylesheet rulesetForClassName:@".cell7"], ruleset,
+                 @"Rulesets looked up concurrently should still be cached once.");
+}
+
+- (void)testRulesetsCascadeBySpecificity {
+  NSString* css = (@"#submit { width: 3px; }\n"
+                   @".primary { width: 2px; }\n"
+                   @"UIButton { width: 1px; height: 5px; }\n"
+                   @".root UIButton { height: 6px; }\n"
+                   @"UIButton:selected { width: 9px; }\n");
+  NIStylesheet* stylesheet = [[NIStylesheet alloc] init];
+  XCTAssertTrue([stylesheet loadFromData:[css dataUsingEncoding:NSUTF8StringEncoding] pathPrefix:nil delegate:nil]);
+
+  NICSSRuleset* ruleset = [stylesheet rulesetForClassName:@"UIButton"];
+  XCTAssertEqualObjects([ruleset cssRuleForKey:@"width"], @[@"1px"]);
+  XCTAssertEqualObjects([ruleset cssRuleForKey:@"height"], @[@"6px"], @"Descendant scopes should be more specific.");
+  XCTAssertEqual([stylesheet rulesetForClassName:@"UIButton"], ruleset, @"Rulesets should be cached.");
+
+  ruleset = [stylesheet rulesetForViewClassName:@"UIButton" cssClass:@"primary" viewId:nil pseudoClass:nil];
+  XCTAssertEqualObjects([ruleset cssRuleForKey:@"width"], @[@"2px"], @"Classes should override tags.");
+  XCTAssertEqualObjects([ruleset cssRuleForKey:@"height"], @[@"6px"]);
+
+  ruleset = [stylesheet rulesetForViewClassName:@"UIButton" cssClass:@"primary" viewId:@"submit" pseudoClass:nil];
+  XCTAssertEqualObjects([ruleset cssRuleForKey:@"width"], @[@"3px"], @"Ids should override classes.");
+
+  ruleset = [stylesheet rulesetForViewClassName:@"UIButton" cssClass:nil viewId:nil pseudoClass:@"selected"];
+  XCTAssertEqualObjects([ruleset cssRuleForKey:@"width"], @[@"9px"]);
+  XCTAssertNil([ruleset cssRuleForKey:@"height"], @"Pseudo-classes should only match their own rulesets.");
+
+  XCTAssertNil([stylesheet rulesetForClassName:@"UILabel"]);
+}
+
+- (void)testOrientationRulesetsAreResolvedForEachOrientation {
+  NSString* css = (@"UILabel { width: 1px; height: 5px; }\n"
+                   @"@media landscape {\n"
+                   @"UILabel { width: 2px; }\n"
+                   @"}\n"
+                   @"@media portrait, landscape {\n"
+                   @"UIButton { width: 3px; }\n"
+                   @"}\n");
+  NIStylesheet* stylesheet = [[NIStylesheet alloc] init];
+  XCTAssertTrue([stylesheet loadFromData:[css dataUsingEncoding:NSUTF8StringEncoding] pathPrefix:nil delegate:nil]);
+  XCTAssertTrue([stylesheet hasMediaRulesetsForClassName:@"UILabel"]);
+  XCTAssertFalse([stylesheet hasMediaRulesetsForClassName:@"UIButton"], @"Rulesets for every orientation aren't media rulesets.");
+
+  UIInterfaceOrientation orientation = [NIStylesheet mediaOrientation];
+  [NIStylesheet setMediaOrientation:UIInterfaceOrientationPortrait];
+  NICSSRuleset* portraitRuleset = [stylesheet rulesetForClassName:@"UILabel"];
+  XCTAssertEqualObjects([portraitRuleset cssRuleForKey:@"width"], @[@"1px"]);
+
+  [NIStylesheet setMediaOrientation:UIInterfaceOrientationLandscapeLeft];
+  NICSSRuleset* landscapeRuleset = [stylesheet rulesetForClassName:@"UILabel"];
+  XCTAssertEqualObjects([landscapeRuleset cssRuleForKey:@"width"], @[@"2px"], @"Orientation rulesets should win.");
+  XCTAssertEqualObjects([landscapeRuleset cssRuleForKey:@"height"], @[@"5px"]);
+  XCTAssertEqualObjects([[stylesheet rulesetForClassName:@"UIButton"] cssRuleForKey:@"width"], @[@"3px"]);
+
+  [NIStylesheet setMediaOrientation:UIInterfaceOrientationPortraitUpsideDown];
+  XCTAssertEqual([stylesheet rulesetForClassName:@"UILabel"], portraitRuleset, @"Each orientation should keep its rulesets.");
+  [NIStylesheet setMediaOrientation:orientation];
+}
+
+- (void)testRulesetsRecordWhichPropertiesArePresent {
+  NICSSRuleset* ruleset = [[NICSSRuleset alloc] init];
+  XCTAssertFalse([ruleset hasProperty:NICSSRulesetPropertyBorderWidth]);
+
+  [ruleset addEntriesFromDictionary:@{@"border": @[@"2", @"solid", @"red"], @"padding": @[@"4"],
+                                      kPropertyOrderKey: [@[@"border", @"padding"] mutableCopy]}];
+  XCTAssertTrue([ruleset hasBorderWidth]);
+  XCTAssertTrue([ruleset hasBorderColor]);
+  XCTAssertTrue([ruleset hasHorizontalPadding]);
+  XCTAssertTrue([ruleset hasVerticalPadding]);
+  XCTAssertFalse([ruleset hasTextColor]);
+
+  [ruleset compile];
+  XCTAssertEqual([ruleset borderWidth], (CGFloat)2);
+  [self assertColor:[ruleset borderColor] equalsColor:[UIColor redColor]];
+
+  // Adding entries discards the compiled values.
+  [ruleset addEntriesFromDictionary:@{@"border-width": @[@"5"], kPropertyOrderKey: @[@"border-width"]}];
+  XCTAssertEqual([ruleset borderWidth], (CGFloat)5);
+}
+
+- (void)testStylesheetsRecordWhichRulesetsChanged {
+  NIStylesheet* stylesheet = [[NIStylesheet alloc] init];
+  NSString* css = @"UILabel { width: 1px; }\n.title { width: 2px; }\n";
+  XCTAssertTrue([stylesheet loadFromData:[css dataUsingEncoding:NSUTF8StringEncoding] pathPrefix:nil delegate:nil]);
+  XCTAssertTrue([stylesheet didChangeRulesetsForClassName:@"UILabel"], @"Every ruleset of a first load is new.");
+
+  css = @"UILabel { width: 1px; }\n.title { width: 3px; }\n";
+  XCTAssertTrue([stylesheet loadFromData:[css dataUsingEncoding:NSUTF8StringEncoding] pathPrefix:nil delegate:nil]);
+  XCTAssertFalse([stylesheet didChangeRulesetsForClassName:@"UILabel"]);
+  XCTAssertFalse([stylesheet didChangeRulesetsForClassName:@".subtitle"]);
+  XCTAssertTrue([stylesheet didChangeRulesetsForClassName:@".title"]);
+  XCTAssertTrue([stylesheet didChangeRulesetsForClassName:@"UILabel.title"]);
+  XCTAssertEqualObjects(stylesheet.changedScopes, [NSSet setWithObject:@".title"]);
+
+  XCTAssertTrue([stylesheet loadFromData:[css dataUsingEncoding:NSUTF8StringEncoding] pathPrefix:nil delegate:nil]);
+  XCTAssertEqual([stylesheet.changedScopes count], (NSUInteger)0, @"Reloading the same CSS changes nothing.");
+}
+
+- (void)testAddingStylesheetsOnlyRecompilesTheRulesetsTheyChange {
+  NIStylesheet* stylesheet = [[NIStylesheet alloc] init];
+  NSString* css = @"UILabel { width: 1px; }\n.title { color: red; }\n";
+  XCTAssertTrue([stylesheet loadFromData:[css dataUsingEncoding:NSUTF8StringEncoding] pathPrefix:nil delegate:nil]);
+  NICSSRuleset* labelRuleset = [stylesheet rulesetForClassName:@"UILabel"];
+  XCTAssertNotNil([stylesheet rulesetForClassName:@".title"]);
+  XCTAssertNil([stylesheet rulesetForClassName:@".subtitle"]);
+
+  NIStylesheet* layer = [[NIStylesheet alloc] init];
+  css = @".title { color: blue; }\n.subtitle { color: green; }\n";
+  XCTAssertTrue([layer loadFromData:[css dataUsingEncoding:NSUTF8StringEncoding] pathPrefix:nil delegate:nil]);
+  [stylesheet addStylesheet:layer];
+
+  XCTAssertEqualObjects(stylesheet.changedScopes, ([NSSet setWithObjects:@".title", @".subtitle", nil]));
+  XCTAssertEqual([stylesheet rulesetForClassName:@"UILabel"], labelRuleset,
+                 @"Rulesets that the added stylesheet doesn't touch should stay cached.");
+  XCTAssertEqualObjects([[stylesheet rulesetForClassName:@".title"] textColor], [UIColor blueColor]);
+  XCTAssertTrue([[stylesheet rulesetForClassName:@".subtitle"] hasTextColor],
+                @"Cached misses should be dropped when a matching scope is added.");
+  XCTAssertTrue([[stylesheet rulesetForClassName:@"UILabel.subtitle"] hasWidth]);
+}
+
+- (void)testLayeredStylesheetsApplyEachLayerOverThePreviousOnes {
+  NIStylesheet* base = [[NIStylesheet alloc] init];
+  NSString* css = @"#title { color: red; width: 1px; }\n";
+  XCTAssertTrue([base loadFromData:[css dataUsingEncoding:NSUTF8StringEncoding] pathPrefix:nil delegate:nil]);
+  NIStylesheet* theme = [[NIStylesheet alloc] init];
+  css = @"UILabel { color: blue; }\n";
+  XCTAssertTrue([theme loadFromData:[css dataUsingEncoding:NSUTF8StringEncoding] pathPrefix:nil delegate:nil]);
+
+  NIStylesheet* stylesheet = [[NIStylesheet alloc] initWithLayeredStylesheets:@[ base, theme ]];
+  NICSSRuleset* ruleset = [stylesheet rulesetForClassName:@"UILabel#title"];
+  XCTAssertEqualObjects([ruleset textColor], [UIColor blueColor],
+                        @"Later layers should override earlier ones whatever the specificity.");
+  XCTAssertTrue([ruleset hasWidth]);
+  XCTAssertEqual([stylesheet rulesetForClassName:@"UILabel#title"], ruleset);
+
+  css = @"UILabel { color: green; }\n";
+  XCTAssertTrue([theme loadFromData:[css dataUsingEncoding:NSUTF8StringEncoding] pathPrefix:nil delegate:nil]);
+  [[NSNotificationCenter defaultCenter] postNotificationName:NIStylesheetDidChangeNotification object:theme];
+  XCTAssertTrue([stylesheet didChangeRulesetsForClassName:@"UILabel#title"]);
+  XCTAssertEqualObjects([[stylesheet rulesetForClassName:@"UILabel#title"] textColor], [UIColor greenColor]);
+}
+
+- (void)testStyleAppliersOnlySetPresentProperties {
+  NSString* css = (@".title { color: red; background-color: blue; width: 10px; }\n"
+                   @".title:selected { color: green; }\n");
+  NIStylesheet* stylesheet = [[NIStylesheet alloc] init];
+  XCTAssertTrue([stylesheet loadFromData:[css dataUsingEncoding:NSUTF8StringEncoding] pathPrefix:nil delegate:nil]);
+  NICSSRuleset* ruleset = [stylesheet rulesetForClassName:@".title"];
+
+  NIStyleApplier* applier = [NIStyleApplier applierForViewClass:[UILabel class] ruleSet:ruleset pseudoClass:nil];
+  XCTAssertEqual([applier.setters count], (NSUInteger)3, @"Background color, sizing and text color.");
+
+  applier = [NIStyleApplier applierForViewClass:[UIView class] ruleSet:ruleset pseudoClass:nil];
+  XCTAssertEqual([applier.setters count], (NSUInteger)2, @"Views have no text color.");
+
+  // UITableView overrides the NIStyleable methods, so they are called instead.
+  applier = [NIStyleApplier applierForViewClass:[UITableView class] ruleSet:ruleset pseudoClass:nil];
+  XCTAssertEqual([applier.setters count], (NSUInteger)2);
+
+  ruleset = [stylesheet rulesetForClassName:@".title:selected"];
+  applier = [NIStyleApplier applierForViewClass:[UIButton class] ruleSet:ruleset pseudoClass:@"selected"];
+  XCTAssertEqual([applier.setters count], (NSUInteger)1);
+}
+
+- (void)testRulesetsShareInternedColors {
+  NICSSRuleset* ruleset1 = [[NICSSRuleset alloc] init];
+  [ruleset1 addEntriesFromDictionary:@{@"color": @[@"#f00"], kPropertyOrderKey: [@[@"color"] mutableCopy]}];
+  NICSSRuleset* ruleset2 = [[NICSSRuleset alloc] init];
+  [ruleset2 addEntriesFromDictionary:@{@"color": @[@"rgb(", @"255", @"0", @"0", @")"],
+                                       @"background-color": @[@"#ff0001"],
+                                       kPropertyOrderKey: [@[@"color", @"background-color"] mutableCopy]}];
+
+  XCTAssertEqual([ruleset1 textColor], [ruleset2 textColor], @"Equal colors should be one object.");
+  XCTAssertNotEqual([ruleset1 textColor], [ruleset2 backgroundColor]);
+  [self assertColor:[ruleset1 textColor] equalsColor:[UIColor colorWithRed:1 green:0 blue:0 alpha:1]];
+}
+
 - (void)assertColor:(UIColor *)color1 equalsColor:(UIColor *)color2 {
   size_t nColors1 = CGColorGetNumberOfComponents(color1.CGColor);
   size_t nColors2 = CGColorGetNumberOfComponents(color2.CGColor);
@@ -0,0 +1,64 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NimbusCSS.h"
+#import "NIUserInterfaceString.h"
+
+@interface NIUserInterfaceStringTests : XCTestCase
+@end
+
+
+@implementation NIUserInterfaceStringTests
+
+
+- (void)postStringsFileWithContents:(NSString *)contents {
+  NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:
+                    [[[NSProcessInfo processInfo] globallyUniqueString] stringByAppendingPathExtension:@"strings"]];
+  XCTAssertTrue([contents writeToFile:path atomically:YES encoding:NSUTF8StringEncoding error:nil]);
+  [[NSNotificationCenter defaultCenter] postNotificationName:NIStringsDidChangeNotification
+                                                      object:nil
+                                                    userInfo:@{NIStringsDidChangeFilePathKey: path}];
+  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (void)testRemovedOverridesRevertToTheLocalizedString {
+  [NIUserInterfaceString setStringResolver:nil];
+  XCTAssertTrue([[NIUserInterfaceString stringResolver] isChangeTrackingEnabled],
+                @"Strings are only tracked in debug builds.");
+
+  // The key isn't in the bundle's strings, so NSLocalizedString falls back to the key itself.
+  NSString* key = [NSString stringWithFormat:@"nimbus.test.%@", [[NSProcessInfo processInfo] globallyUniqueString]];
+  UILabel* label = [[UILabel alloc] init];
+  NIUserInterfaceString* string = [[NIUserInterfaceString alloc] initWithKey:key];
+  [string attach:label];
+  XCTAssertEqualObjects(label.text, NSLocalizedString(key, nil));
+
+  [self postStringsFileWithContents:[NSString stringWithFormat:@"\"%@\" = \"Overridden\";\n", key]];
+  XCTAssertEqualObjects(label.text, @"Overridden", @"The override should be applied to the label.");
+
+  [self postStringsFileWithContents:@"\"nimbus.test.other\" = \"Other\";\n"];
+  XCTAssertEqualObjects(label.text, NSLocalizedString(key, nil),
+                        @"Removing the override should revert the label to the localized string.");
+
+  [string detach:label];
+}
+
+@end
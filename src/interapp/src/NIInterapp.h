@@ -119,6 +119,8 @@
 #pragma mark Custom Application
 
 + (BOOL)applicationIsInstalledWithScheme:(NSString *)applicationScheme;
++ (void)registerApplicationSchemes:(NSArray *)applicationSchemes;
++ (void)refreshInstalledApplications;
 + (BOOL)applicationWithScheme:(NSString *)applicationScheme;
 + (BOOL)applicationWithScheme:(NSString *)applicationScheme andAppStoreId:(NSString *)appStoreId;
 + (BOOL)applicationWithScheme:(NSString *)applicationScheme andPath:(NSString *)path;
@@ -342,9 +344,33 @@
 /**
  * Returns YES if the supplied application is installed.
  *
+ * Answers come from a cache of scheme availability. A scheme that has not been asked about or
+ * registered before is probed with canOpenURL: once and then joins the registered schemes, which
+ * are probed again together each time the app enters the foreground. The built-in
+ * *IsInstalled methods use the same cache.
+ *
  * @fn NIInterapp::applicationIsInstalledWithScheme:
  */
 
+/**
+ * Adds schemes to the set that is probed in one batch and cached.
+ *
+ * Register every scheme a screen will ask about, e.g. each app in a share sheet, before it
+ * appears. The schemes are probed together on the main queue after the current run loop
+ * iteration, rather than one at a time as they are asked about.
+ *
+ * @fn NIInterapp::registerApplicationSchemes:
+ */
+
+/**
+ * Probes all registered schemes again on the main queue.
+ *
+ * This is called automatically on UIApplicationWillEnterForegroundNotification. Cached answers
+ * are returned until the probe has run. Calls made before a scheduled probe runs are coalesced.
+ *
+ * @fn NIInterapp::refreshInstalledApplications
+ */
+
 /**
  * Opens the supplied application.
  *
@@ -71,7 +71,7 @@ static NSString* const sGoogleChromeHttpScheme = @"googlechrome:";
 static NSString* const sGoogleChromeHttpsScheme = @"googlechromes:";
 
 + (BOOL)googleChromeIsInstalled {
-  return [[UIApplication sharedApplication] canOpenURL:[NSURL URLWithString:sGoogleChromeHttpScheme]];
+  return [self applicationIsInstalledWithScheme:sGoogleChromeHttpScheme];
 }
 
 + (BOOL)googleChromeWithURL:(NSURL *)url {
@@ -112,7 +112,7 @@ static NSString* const sGoogleChromeHttpsScheme = @"googlechromes:";
 static NSString* const sGoogleMapsScheme = @"comgooglemaps:";
 
 + (BOOL)googleMapsIsInstalled {
-  return [[UIApplication sharedApplication] canOpenURL:[NSURL URLWithString:sGoogleMapsScheme]];
+  return [self applicationIsInstalledWithScheme:sGoogleMapsScheme];
 }
 
 + (BOOL)googleMaps {
@@ -274,7 +274,7 @@ static NSString* const sMailScheme = @"mailto:";
 static NSString* const sIBooksScheme = @"itms-books:";
 
 + (BOOL)iBooksIsInstalled {
-  return [[UIApplication sharedApplication] canOpenURL:[NSURL URLWithString:sIBooksScheme]];
+  return [self applicationIsInstalledWithScheme:sIBooksScheme];
 }
 
 + (BOOL)iBooks {
@@ -296,7 +296,7 @@ static NSString* const sIBooksScheme = @"itms-books:";
 static NSString* const sFacebookScheme = @"fb:";
 
 + (BOOL)facebookIsInstalled {
-  return [[UIApplication sharedApplication] canOpenURL:[NSURL URLWithString:sFacebookScheme]];
+  return [self applicationIsInstalledWithScheme:sFacebookScheme];
 }
 
 + (BOOL)facebook {
@@ -323,7 +323,7 @@ static NSString* const sFacebookScheme = @"fb:";
 static NSString* const sTwitterScheme = @"twitter:";
 
 + (BOOL)twitterIsInstalled {
-  return [[UIApplication sharedApplication] canOpenURL:[NSURL URLWithString:sTwitterScheme]];
+  return [self applicationIsInstalledWithScheme:sTwitterScheme];
 }
 
 + (BOOL)twitter {
@@ -354,8 +354,94 @@ static NSString* const sTwitterScheme = @"twitter:";
 
 #pragma mark - Application
 
+// Maps each registered scheme to an NSNumber saying whether it could be opened when last probed.
+// Guarded by synchronizing on NIInterapp.
+static NSMutableDictionary* sSchemeAvailability = nil;
+static NSMutableSet* sRegisteredSchemes = nil;
+static BOOL sIsRefreshScheduled = NO;
+
+// Must be called while synchronized on NIInterapp.
+static void NICreateSchemeCachesIfNeeded(void) {
+  if (nil == sRegisteredSchemes) {
+    sRegisteredSchemes = [[NSMutableSet alloc] init];
+    sSchemeAvailability = [[NSMutableDictionary alloc] init];
+  }
+}
+
++ (void)observeForegroundNotificationIfNeeded {
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    // Apps may have been installed or removed while we were in the background.
+    [[NSNotificationCenter defaultCenter] addObserverForName:UIApplicationWillEnterForegroundNotification
+                                                      object:nil
+                                                       queue:[NSOperationQueue mainQueue]
+                                                  usingBlock:^(NSNotification* note) {
+                                                    [NIInterapp refreshInstalledApplications];
+                                                  }];
+  });
+}
+
++ (void)registerApplicationSchemes:(NSArray *)applicationSchemes {
+  [self observeForegroundNotificationIfNeeded];
+
+  @synchronized(self) {
+    NICreateSchemeCachesIfNeeded();
+    [sRegisteredSchemes addObjectsFromArray:applicationSchemes];
+  }
+  [self refreshInstalledApplications];
+}
+
++ (void)refreshInstalledApplications {
+  @synchronized(self) {
+    if (sIsRefreshScheduled || 0 == sRegisteredSchemes.count) {
+      return;
+    }
+    sIsRefreshScheduled = YES;
+  }
+
+  // canOpenURL: must be called on the main thread, so rather than probing each scheme when it is
+  // asked about we probe the whole set in one pass once the current run loop iteration is done.
+  dispatch_async(dispatch_get_main_queue(), ^{
+    NSSet* schemes = nil;
+    @synchronized(self) {
+      sIsRefreshScheduled = NO;
+      schemes = [sRegisteredSchemes copy];
+    }
+
+    UIApplication* application = [UIApplication sharedApplication];
+    NSMutableDictionary* availability = [NSMutableDictionary dictionaryWithCapacity:schemes.count];
+    for (NSString* scheme in schemes) {
+      [availability setObject:@([application canOpenURL:[NSURL URLWithString:scheme]]) forKey:scheme];
+    }
+
+    @synchronized(self) {
+      [sSchemeAvailability addEntriesFromDictionary:availability];
+    }
+  });
+}
+
 + (BOOL)applicationIsInstalledWithScheme:(NSString *)applicationScheme {
-    return [[UIApplication sharedApplication] canOpenURL:[NSURL URLWithString:applicationScheme]];
+  if (nil == applicationScheme) {
+    return NO;
+  }
+
+  NSNumber* isInstalled = nil;
+  @synchronized(self) {
+    isInstalled = [sSchemeAvailability objectForKey:applicationScheme];
+  }
+  if (nil != isInstalled) {
+    return [isInstalled boolValue];
+  }
+
+  // Not probed yet; answer now and register the scheme so that it is refreshed with the rest.
+  BOOL canOpen = [[UIApplication sharedApplication] canOpenURL:[NSURL URLWithString:applicationScheme]];
+  @synchronized(self) {
+    NICreateSchemeCachesIfNeeded();
+    [sRegisteredSchemes addObject:applicationScheme];
+    [sSchemeAvailability setObject:@(canOpen) forKey:applicationScheme];
+  }
+  [self observeForegroundNotificationIfNeeded];
+  return canOpen;
 }
 
 + (BOOL)applicationWithScheme:(NSString *)applicationScheme {
@@ -407,7 +493,7 @@ static NSString* const sTwitterScheme = @"twitter:";
 static NSString* const sInstagramScheme = @"instagram:";
 
 + (BOOL)instagramIsInstalled {
-  return [[UIApplication sharedApplication] canOpenURL:[NSURL URLWithString:sInstagramScheme]];
+  return [self applicationIsInstalledWithScheme:sInstagramScheme];
 }
 
 + (BOOL)instagram {
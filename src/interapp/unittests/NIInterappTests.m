@@ -23,11 +23,115 @@
 @interface NIInterappTests : XCTestCase
 @end
 
+// Stands in for the apps installed on the device. Guarded by synchronizing on NIInterappTests.
+static NSMutableSet* sInstalledSchemes = nil;
+static NSCountedSet* sProbedSchemes = nil;
+
+@interface UIApplication (NIInterappTests)
+- (BOOL)nitest_canOpenURL:(NSURL *)url;
+@end
+
+@implementation UIApplication (NIInterappTests)
+
+- (BOOL)nitest_canOpenURL:(NSURL *)url {
+  @synchronized([NIInterappTests class]) {
+    [sProbedSchemes addObject:url.absoluteString];
+    return [sInstalledSchemes containsObject:url.absoluteString];
+  }
+}
+
+@end
+
 
 @implementation NIInterappTests
 
 
+- (void)setUp {
+  [super setUp];
+  sInstalledSchemes = [[NSMutableSet alloc] init];
+  sProbedSchemes = [[NSCountedSet alloc] init];
+  NISwapInstanceMethods([UIApplication class], @selector(canOpenURL:), @selector(nitest_canOpenURL:));
+}
+
+- (void)tearDown {
+  // Swapping again puts the original implementation back.
+  NISwapInstanceMethods([UIApplication class], @selector(canOpenURL:), @selector(nitest_canOpenURL:));
+  [super tearDown];
+}
+
+// The scheme cache outlives each test, so every test asks about schemes of its own.
+- (NSString *)uniqueScheme {
+  return [NSString stringWithFormat:@"nitest-%@:", [[[NSUUID UUID] UUIDString] lowercaseString]];
+}
+
+- (NSUInteger)numberOfProbesOfScheme:(NSString *)scheme {
+  @synchronized([NIInterappTests class]) {
+    return [sProbedSchemes countForObject:scheme];
+  }
+}
+
+- (void)runMainQueue {
+  [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+}
+
 - (void)testNothing {
 }
 
+- (void)testSchemesAreProbedOnceAndThenAnsweredFromTheCache {
+  NSString* installedScheme = [self uniqueScheme];
+  NSString* missingScheme = [self uniqueScheme];
+  [sInstalledSchemes addObject:installedScheme];
+
+  XCTAssertTrue([NIInterapp applicationIsInstalledWithScheme:installedScheme]);
+  XCTAssertFalse([NIInterapp applicationIsInstalledWithScheme:missingScheme]);
+  XCTAssertEqual([self numberOfProbesOfScheme:installedScheme], (NSUInteger)1, @"A miss should be probed.");
+
+  XCTAssertTrue([NIInterapp applicationIsInstalledWithScheme:installedScheme]);
+  XCTAssertFalse([NIInterapp applicationIsInstalledWithScheme:missingScheme]);
+  XCTAssertEqual([self numberOfProbesOfScheme:installedScheme], (NSUInteger)1, @"A hit should come from the cache.");
+  XCTAssertEqual([self numberOfProbesOfScheme:missingScheme], (NSUInteger)1, @"Negative answers are cached too.");
+  XCTAssertFalse([NIInterapp applicationIsInstalledWithScheme:nil]);
+}
+
+- (void)testRegisteredSchemesAreProbedTogetherLater {
+  NSString* firstScheme = [self uniqueScheme];
+  NSString* secondScheme = [self uniqueScheme];
+  [sInstalledSchemes addObject:secondScheme];
+
+  [NIInterapp registerApplicationSchemes:@[firstScheme, secondScheme]];
+  XCTAssertEqual([self numberOfProbesOfScheme:firstScheme], (NSUInteger)0, @"Probing should wait for the main queue.");
+  [self runMainQueue];
+  XCTAssertEqual([self numberOfProbesOfScheme:firstScheme], (NSUInteger)1);
+  XCTAssertEqual([self numberOfProbesOfScheme:secondScheme], (NSUInteger)1);
+
+  XCTAssertFalse([NIInterapp applicationIsInstalledWithScheme:firstScheme]);
+  XCTAssertTrue([NIInterapp applicationIsInstalledWithScheme:secondScheme]);
+  XCTAssertEqual([self numberOfProbesOfScheme:secondScheme], (NSUInteger)1, @"Registered schemes are already cached.");
+
+  [NIInterapp refreshInstalledApplications];
+  [NIInterapp refreshInstalledApplications];
+  [NIInterapp refreshInstalledApplications];
+  [self runMainQueue];
+  XCTAssertEqual([self numberOfProbesOfScheme:secondScheme], (NSUInteger)2, @"Scheduled refreshes should be coalesced.");
+}
+
+- (void)testRefreshingPicksUpInstalledAndRemovedApps {
+  NSString* scheme = [self uniqueScheme];
+  [sInstalledSchemes addObject:scheme];
+  XCTAssertTrue([NIInterapp applicationIsInstalledWithScheme:scheme]);
+
+  // The app is removed while we are in the background.
+  [sInstalledSchemes removeObject:scheme];
+  XCTAssertTrue([NIInterapp applicationIsInstalledWithScheme:scheme], @"The cached answer stands until a refresh.");
+  [[NSNotificationCenter defaultCenter] postNotificationName:UIApplicationWillEnterForegroundNotification object:nil];
+  [self runMainQueue];
+  XCTAssertFalse([NIInterapp applicationIsInstalledWithScheme:scheme], @"Entering the foreground should refresh the cache.");
+
+  [sInstalledSchemes addObject:scheme];
+  [NIInterapp refreshInstalledApplications];
+  XCTAssertFalse([NIInterapp applicationIsInstalledWithScheme:scheme], @"Cached answers are served until the probe runs.");
+  [self runMainQueue];
+  XCTAssertTrue([NIInterapp applicationIsInstalledWithScheme:scheme]);
+}
+
 @end
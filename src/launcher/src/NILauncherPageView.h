@@ -40,6 +40,14 @@
 @property (nonatomic, assign) CGSize viewSize;
 @property (nonatomic, assign) CGSize viewMargins;
 
+@property (nonatomic, copy) NSArray* viewFrames; // Default: nil
+
++ (NSArray *)viewFramesForNumberOfViews:(NSInteger)numberOfViews
+                           inBoundsSize:(CGSize)boundsSize
+                           contentInset:(UIEdgeInsets)contentInset
+                               viewSize:(CGSize)viewSize
+                            viewMargins:(CGSize)viewMargins;
+
 @end
 
 /** @name Recyclable Views */
@@ -47,8 +55,9 @@
 /**
  * A shared view recycler for this page's recyclable views.
  *
- * When this page view is preparing for reuse it will add each of its button views to the recycler.
- * This recycler should be the same recycler used by all pages in the launcher view.
+ * When this page view is removed from its superview or is preparing for reuse it will add each of
+ * its button views to the recycler. This recycler should be the same recycler used by all pages in
+ * the launcher view.
  *
  * @fn NILauncherPageView::viewRecycler
  */
@@ -97,3 +106,25 @@
  *
  * @fn NILauncherPageView::viewMargins
  */
+
+/** @name Precomputed Layouts */
+
+/**
+ * A precomputed frame for each recyclable view, stored as NSValue-wrapped CGRects.
+ *
+ * When this array holds at least one frame per recyclable view, layoutSubviews assigns these
+ * frames as-is rather than recomputing the grid. NILauncherView shares one table between every
+ * page of the same size, so rotating a launcher only swaps tables.
+ *
+ * Changing contentInset, viewSize, or viewMargins clears this property.
+ *
+ * @fn NILauncherPageView::viewFrames
+ */
+
+/**
+ * Returns the frames of a page's recyclable views as NSValue-wrapped CGRects.
+ *
+ * This is the grid that layoutSubviews calculates when no viewFrames are provided.
+ *
+ * @fn NILauncherPageView::viewFramesForNumberOfViews:inBoundsSize:contentInset:viewSize:viewMargins:
+ */
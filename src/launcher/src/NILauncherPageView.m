@@ -38,16 +38,16 @@
   return self;
 }
 
-- (void)layoutSubviews {
-  [super layoutSubviews];
-
-  const CGFloat leftEdge = self.contentInset.left;
-  const CGFloat topEdge = self.contentInset.top;
-  const CGFloat rightEdge = self.bounds.size.width - self.contentInset.right;
-  const CGSize viewSize = self.viewSize;
-  const CGSize viewMargins = self.viewMargins;
-
-  CGFloat contentWidth = (self.bounds.size.width - self.contentInset.left - self.contentInset.right);
++ (NSArray *)viewFramesForNumberOfViews:(NSInteger)numberOfViews
+                           inBoundsSize:(CGSize)boundsSize
+                           contentInset:(UIEdgeInsets)contentInset
+                               viewSize:(CGSize)viewSize
+                            viewMargins:(CGSize)viewMargins {
+  const CGFloat leftEdge = contentInset.left;
+  const CGFloat topEdge = contentInset.top;
+  const CGFloat rightEdge = boundsSize.width - contentInset.right;
+
+  CGFloat contentWidth = (boundsSize.width - contentInset.left - contentInset.right);
   NSInteger numberOfColumns = floorf((contentWidth + viewMargins.width) / (viewSize.width + viewMargins.width));
   CGFloat viewWidth = numberOfColumns * viewSize.width;
   CGFloat distributedHorizontalMargin = floorf((contentWidth - viewWidth) / (CGFloat)(numberOfColumns + 1));
@@ -58,20 +58,66 @@
   CGFloat x = leftEdge + distributedHorizontalMargin;
   CGFloat y = topEdge;
 
-  for (UIView* view in self.mutableRecyclableViews) {
-    view.frame = CGRectMake(x, y, viewSize.width, viewSize.height);
+  NSMutableArray* viewFrames = [NSMutableArray arrayWithCapacity:MAX(0, numberOfViews)];
+  for (NSInteger ix = 0; ix < numberOfViews; ++ix) {
+    [viewFrames addObject:[NSValue valueWithCGRect:CGRectMake(x, y, viewSize.width, viewSize.height)]];
     x += horizontalDelta;
     if (x + viewSize.width > rightEdge) {
       x = leftEdge + distributedHorizontalMargin;
       y += verticalDelta;
     }
   }
+  return viewFrames;
+}
+
+- (void)layoutSubviews {
+  [super layoutSubviews];
+
+  NSArray* viewFrames = self.viewFrames;
+  if (viewFrames.count < self.mutableRecyclableViews.count) {
+    viewFrames = [[self class] viewFramesForNumberOfViews:self.mutableRecyclableViews.count
+                                             inBoundsSize:self.bounds.size
+                                             contentInset:self.contentInset
+                                                 viewSize:self.viewSize
+                                              viewMargins:self.viewMargins];
+  }
+
+  NSInteger viewIndex = 0;
+  for (UIView* view in self.mutableRecyclableViews) {
+    view.frame = [[viewFrames objectAtIndex:viewIndex] CGRectValue];
+    ++viewIndex;
+  }
 }
 
 #pragma mark - NIRecyclableView
 
 
 - (void)prepareForReuse {
+  [self recycleViews];
+}
+
+#pragma mark - UIView
+
+
+- (void)didMoveToSuperview {
+  [super didMoveToSuperview];
+
+  // Pages that scroll off-screen wait in the paging scroll view's recycler until they are
+  // dequeued again. Handing their views to the shared recycler now lets the on-screen pages reuse
+  // them, so a launcher holds the same number of views however many pages it has.
+  if (nil == self.superview) {
+    [self recycleViews];
+  }
+}
+
+#pragma mark - Private
+
+
+- (void)recycleViews {
+  if (0 == self.mutableRecyclableViews.count) {
+    return;
+  }
+
   // You forgot to provide a view recycler.
   NIDASSERT(nil != self.viewRecycler);
 
@@ -97,19 +143,41 @@
 }
 
 - (void)setContentInset:(UIEdgeInsets)contentInset {
+  if (UIEdgeInsetsEqualToEdgeInsets(_contentInset, contentInset)) {
+    return;
+  }
   _contentInset = contentInset;
+  _viewFrames = nil;
 
   [self setNeedsLayout];
 }
 
-- (void)setviewSize:(CGSize)viewSize {
+- (void)setViewSize:(CGSize)viewSize {
+  if (CGSizeEqualToSize(_viewSize, viewSize)) {
+    return;
+  }
   _viewSize = viewSize;
+  _viewFrames = nil;
 
   [self setNeedsLayout];
 }
 
-- (void)setviewMargins:(CGSize)viewMargins {
+- (void)setViewMargins:(CGSize)viewMargins {
+  if (CGSizeEqualToSize(_viewMargins, viewMargins)) {
+    return;
+  }
   _viewMargins = viewMargins;
+  _viewFrames = nil;
+
+  [self setNeedsLayout];
+}
+
+- (void)setViewFrames:(NSArray *)viewFrames {
+  // Pages of the same size share a table, so an identical table means the frames are unchanged.
+  if (_viewFrames == viewFrames) {
+    return;
+  }
+  _viewFrames = [viewFrames copy];
 
   [self setNeedsLayout];
 }
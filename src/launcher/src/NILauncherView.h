@@ -48,6 +48,7 @@ extern const NSInteger NILauncherViewGridBasedOnButtonSize;
 @property (nonatomic, weak) id<NILauncherDataSource> dataSource;
 
 - (UIView<NILauncherButtonView> *)dequeueReusableViewWithIdentifier:(NSString *)identifier;
+@property (nonatomic, strong) NIViewRecycler* viewRecycler; // Default: a recycler of its own
 
 - (void)willRotateToInterfaceOrientation:(UIInterfaceOrientation)toInterfaceOrientation duration:(NSTimeInterval)duration;
 - (void)willAnimateRotationToInterfaceOrientation:(UIInterfaceOrientation)toInterfaceOrientation duration:(NSTimeInterval)duration;
@@ -213,6 +214,17 @@ extern const NSInteger NILauncherViewGridBasedOnButtonSize;
  * @fn NILauncherView::dequeueReusableViewWithIdentifier:
  */
 
+/**
+ * The recycler that button views are recycled into and dequeued from.
+ *
+ * Launcher views with the same kinds of buttons can share NIViewRecycler::sharedRecycler so that
+ * each new launcher reuses the buttons that the previous one built.
+ *
+ * Setting this to nil gives the launcher a new recycler of its own.
+ *
+ * @fn NILauncherView::viewRecycler
+ */
+
 /** @name Managing the Delegate and the Data Source */
 
 /**
@@ -257,5 +269,9 @@ extern const NSInteger NILauncherViewGridBasedOnButtonSize;
 /**
  * Updates the frame of the launcher view while maintaining the current visible page's state.
  *
+ * The launcher caches the button frames it calculates for each page size and button count, so
+ * rotating back to an orientation it has already displayed reuses those frames rather than
+ * recalculating the grid. Only the visible pages are updated.
+ *
  * @fn NILauncherView::willAnimateRotationToInterfaceOrientation:duration:
  */
@@ -33,12 +33,27 @@ const NSInteger NILauncherViewGridBasedOnButtonSize = -1;
 static const CGFloat kDefaultButtonDimensions = 80;
 static const CGFloat kDefaultPadding = 10;
 
+/**
+ * The grid metrics for one page size and the frame tables built from them.
+ *
+ * Frame tables are keyed by the number of buttons on the page so that pages of the same size and
+ * button count share a single immutable table.
+ */
+@interface NILauncherPageLayout : NSObject
+@property (nonatomic, assign) CGSize buttonDimensions;
+@property (nonatomic, assign) CGSize buttonMargins;
+@property (nonatomic, strong) NSMutableDictionary* frameTables;
+@end
+
+@implementation NILauncherPageLayout
+@end
+
 
 @interface NILauncherView() <NIPagingScrollViewDataSource, NIPagingScrollViewDelegate>
 @property (nonatomic, strong) NIPagingScrollView* pagingScrollView;
 @property (nonatomic, strong) UIPageControl* pager;
 @property (nonatomic, assign) NSInteger numberOfPages;
-@property (nonatomic, strong) NIViewRecycler* viewRecycler;
+@property (nonatomic, strong) NSMutableDictionary* pageLayouts;
 - (void)updateLayoutForPage:(NILauncherPageView *)page;
 @end
 
@@ -52,6 +67,7 @@ static const CGFloat kDefaultPadding = 10;
   [self setAutoresizesSubviews:NO];
 
   _viewRecycler = [[NIViewRecycler alloc] init];
+  _pageLayouts = [NSMutableDictionary dictionary];
 
   _buttonSize = CGSizeMake(kDefaultButtonDimensions, kDefaultButtonDimensions);
   _numberOfColumns = NILauncherViewGridBasedOnButtonSize;
@@ -184,20 +200,56 @@ static const CGFloat kDefaultPadding = 10;
   pButtonMargins->height = buttonVerticalSpacing;
 }
 
+- (NILauncherPageLayout *)pageLayoutForSize:(CGSize)size {
+  NSValue* key = [NSValue valueWithCGSize:size];
+  NILauncherPageLayout* pageLayout = [self.pageLayouts objectForKey:key];
+  if (nil == pageLayout) {
+    CGSize buttonDimensions = CGSizeZero;
+    NSInteger numberOfRows = 0;
+    NSInteger numberOfColumns = 0;
+    CGSize buttonMargins = CGSizeZero;
+    [self calculateLayoutForFrame:CGRectMake(0, 0, size.width, size.height)
+                 buttonDimensions:&buttonDimensions
+                     numberOfRows:&numberOfRows
+                  numberOfColumns:&numberOfColumns
+                    buttonMargins:&buttonMargins];
+
+    pageLayout = [[NILauncherPageLayout alloc] init];
+    pageLayout.buttonDimensions = buttonDimensions;
+    pageLayout.buttonMargins = buttonMargins;
+    pageLayout.frameTables = [NSMutableDictionary dictionary];
+    [self.pageLayouts setObject:pageLayout forKey:key];
+  }
+  return pageLayout;
+}
+
 - (void)updateLayoutForPage:(NILauncherPageView *)page {
-  CGSize buttonDimensions = CGSizeZero;
-  NSInteger numberOfRows = 0;
-  NSInteger numberOfColumns = 0;
-  CGSize buttonMargins = CGSizeZero;
-  [self calculateLayoutForFrame:self.pagingScrollView.frame
-               buttonDimensions:&buttonDimensions
-                   numberOfRows:&numberOfRows
-                numberOfColumns:&numberOfColumns
-                  buttonMargins:&buttonMargins];
-  
+  // Every page is the size of the paging scroll view, so the metrics and frames only need to be
+  // calculated once per orientation. Rotating back to an orientation we've seen reuses its tables.
+  CGSize pageSize = self.pagingScrollView.bounds.size;
+  NILauncherPageLayout* pageLayout = [self pageLayoutForSize:pageSize];
+
+  NSNumber* numberOfButtons = [NSNumber numberWithUnsignedInteger:page.recyclableViews.count];
+  NSArray* viewFrames = [pageLayout.frameTables objectForKey:numberOfButtons];
+  if (nil == viewFrames) {
+    viewFrames = [NILauncherPageView viewFramesForNumberOfViews:[numberOfButtons integerValue]
+                                                   inBoundsSize:pageSize
+                                                   contentInset:self.contentInsetForPages
+                                                       viewSize:pageLayout.buttonDimensions
+                                                    viewMargins:pageLayout.buttonMargins];
+    viewFrames = [viewFrames copy];
+    [pageLayout.frameTables setObject:viewFrames forKey:numberOfButtons];
+  }
+
   page.contentInset = self.contentInsetForPages;
-  page.viewSize = buttonDimensions;
-  page.viewMargins = buttonMargins;
+  page.viewSize = pageLayout.buttonDimensions;
+  page.viewMargins = pageLayout.buttonMargins;
+  page.viewFrames = viewFrames;
+}
+
+- (void)invalidatePageLayouts {
+  [self.pageLayouts removeAllObjects];
+  [self setNeedsLayout];
 }
 
 #pragma mark - UIPageControl Change Notifications
@@ -272,10 +324,9 @@ static const CGFloat kDefaultPadding = 10;
   NILauncherPageView* page = (NILauncherPageView *)[self.pagingScrollView dequeueReusablePageWithIdentifier:kPageReuseIdentifier];
   if (nil == page) {
     page = [[NILauncherPageView alloc] initWithReuseIdentifier:kPageReuseIdentifier];
-    page.viewRecycler = self.viewRecycler;
   }
-
-  [self updateLayoutForPage:page];
+  // The recycler may have been replaced since the page was built.
+  page.viewRecycler = self.viewRecycler;
 
   NSInteger numberOfButtons = [self.dataSource launcherView:self numberOfButtonsInPage:pageIndex];
   numberOfButtons = MIN(numberOfButtons, self.maxNumberOfButtonsPerPage);
@@ -287,6 +338,9 @@ static const CGFloat kDefaultPadding = 10;
     [page addRecyclableView:(UIView<NIRecyclableView> *)buttonView];
   }
 
+  // The frame table depends on the number of buttons, so look it up once they're all added.
+  [self updateLayoutForPage:page];
+
   return page;
 }
 
@@ -309,10 +363,18 @@ static const CGFloat kDefaultPadding = 10;
   }
 
   self.pager.numberOfPages = _numberOfPages;
+
+  // The data source may now provide a different grid.
+  [self.pageLayouts removeAllObjects];
+
   [self.pagingScrollView reloadData];
   [self setNeedsLayout];
 }
 
+- (void)setViewRecycler:(NIViewRecycler *)viewRecycler {
+  _viewRecycler = (nil != viewRecycler) ? viewRecycler : [[NIViewRecycler alloc] init];
+}
+
 - (UIView<NILauncherButtonView> *)dequeueReusableViewWithIdentifier:(NSString *)identifier {
   NIDASSERT(nil != identifier);
   if (nil == identifier) {
@@ -322,20 +384,28 @@ static const CGFloat kDefaultPadding = 10;
   return (UIView<NILauncherButtonView> *)[self.viewRecycler dequeueReusableViewWithIdentifier:identifier];
 }
 
-- (void)setcontentInsetForPages:(UIEdgeInsets)contentInsetForPages {
+- (void)setContentInsetForPages:(UIEdgeInsets)contentInsetForPages {
   _contentInsetForPages = contentInsetForPages;
 
-  for (NILauncherPageView* pageView in self.pagingScrollView.visiblePages) {
-    pageView.contentInset = contentInsetForPages;
-  }
+  [self invalidatePageLayouts];
 }
 
 - (void)setButtonSize:(CGSize)buttonSize {
   _buttonSize = buttonSize;
 
-  for (NILauncherPageView* pageView in self.pagingScrollView.visiblePages) {
-    pageView.viewSize = buttonSize;
-  }
+  [self invalidatePageLayouts];
+}
+
+- (void)setNumberOfRows:(NSInteger)numberOfRows {
+  _numberOfRows = numberOfRows;
+
+  [self invalidatePageLayouts];
+}
+
+- (void)setNumberOfColumns:(NSInteger)numberOfColumns {
+  _numberOfColumns = numberOfColumns;
+
+  [self invalidatePageLayouts];
 }
 
 - (void)willRotateToInterfaceOrientation:(UIInterfaceOrientation)toInterfaceOrientation duration:(NSTimeInterval)duration {
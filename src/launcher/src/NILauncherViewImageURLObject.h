@@ -0,0 +1,84 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NILauncherViewObject.h"
+
+/**
+ * A launcher view object whose image is read from a file or URL and decoded off the main thread.
+ *
+ * The image is loaded the first time the object is displayed. It is decoded and scaled to fit the
+ * launcher's button size on a background queue and is then stored in
+ * [Nimbus imageMemoryCache] so that other objects with the same image URL and size share the
+ * decoded bitmap. Until the image has loaded the button is displayed without one.
+ *
+ * The decoded image is not archived when the object is encoded; only the image URL is.
+ *
+ * @ingroup NimbusLauncherModel
+ */
+@interface NILauncherViewImageURLObject : NILauncherViewObject
+
+// Designated initializer.
+- (id)initWithTitle:(NSString *)title imageURL:(NSURL *)imageURL;
++ (id)objectWithTitle:(NSString *)title imageURL:(NSURL *)imageURL;
++ (id)objectWithTitle:(NSString *)title imagePath:(NSString *)imagePath;
+
+@property (nonatomic, copy, readonly) NSURL* imageURL;
+
+- (void)loadImageWithSize:(CGSize)size completion:(void (^)(void))completion;
+
+@end
+
+/**
+ * Initializes a newly allocated launcher view object with a given title and image URL.
+ *
+ * The URL may be a file URL or a remote URL.
+ *
+ * This is the designated initializer.
+ *
+ * @fn NILauncherViewImageURLObject::initWithTitle:imageURL:
+ */
+
+/**
+ * Allocates and returns an autoreleased launcher view object with a given title and image URL.
+ *
+ * @fn NILauncherViewImageURLObject::objectWithTitle:imageURL:
+ */
+
+/**
+ * Allocates and returns an autoreleased launcher view object whose image is read from the file
+ * at the given path.
+ *
+ * @fn NILauncherViewImageURLObject::objectWithTitle:imagePath:
+ */
+
+/**
+ * The URL the image is loaded from.
+ *
+ * @fn NILauncherViewImageURLObject::imageURL
+ */
+
+/**
+ * Loads and decodes the image so that it fits within the given size.
+ *
+ * If a decoded image of this size is already in the image memory cache it is used immediately.
+ * Otherwise the image is read and decoded on a background queue. Calls made while a load is in
+ * flight do not start another one; their completion blocks are called when the first load
+ * finishes. Completion blocks are always called on the main thread, even if the image failed
+ * to load.
+ *
+ * @fn NILauncherViewImageURLObject::loadImageWithSize:completion:
+ */
@@ -0,0 +1,210 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NILauncherViewImageURLObject.h"
+
+#import "NimbusCore.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+static NSString* const kTitleCodingKey = @"title";
+static NSString* const kImageURLCodingKey = @"imageURL";
+static NSString* const kIdentifierCodingKey = @"identifier";
+
+@interface NILauncherViewImageURLObject()
+@property (nonatomic, copy) NSURL* imageURL;
+@property (nonatomic, strong) NSMutableArray* pendingCompletions;
+@property (nonatomic, assign) CGSize loadingSize;
+@end
+
+@implementation NILauncherViewImageURLObject
+
+- (id)initWithTitle:(NSString *)title imageURL:(NSURL *)imageURL {
+  if ((self = [super initWithTitle:title image:nil])) {
+    _imageURL = [imageURL copy];
+  }
+  return self;
+}
+
+- (id)initWithTitle:(NSString *)title image:(UIImage *)image {
+  if ((self = [self initWithTitle:title imageURL:nil])) {
+    self.image = image;
+  }
+  return self;
+}
+
++ (id)objectWithTitle:(NSString *)title imageURL:(NSURL *)imageURL {
+  return [[self alloc] initWithTitle:title imageURL:imageURL];
+}
+
++ (id)objectWithTitle:(NSString *)title imagePath:(NSString *)imagePath {
+  return [[self alloc] initWithTitle:title imageURL:[NSURL fileURLWithPath:imagePath]];
+}
+
+- (NSString *)imageKey {
+  return [super imageKey] ?: self.imageURL.absoluteString;
+}
+
+#pragma mark - Image Loading
+
+
++ (dispatch_queue_t)decodingQueue {
+  static dispatch_queue_t queue = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    // Serial so that a page full of icons does not spawn a thread per icon.
+    queue = dispatch_queue_create("com.nimbus.launcher.imagedecoding", DISPATCH_QUEUE_SERIAL);
+    dispatch_set_target_queue(queue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+  });
+  return queue;
+}
+
++ (NSString *)cacheKeyForImageURL:(NSURL *)imageURL size:(CGSize)size {
+  return [NSString stringWithFormat:@"%@#%.0fx%.0f", imageURL.absoluteString, size.width, size.height];
+}
+
+// Decodes the image data into a bitmap that fits within size. Safe to call off the main thread.
++ (UIImage *)decodedImageWithData:(NSData *)data size:(CGSize)size scale:(CGFloat)scale {
+  UIImage* image = [UIImage imageWithData:data];
+  if (nil == image || image.size.width <= 0 || image.size.height <= 0) {
+    return nil;
+  }
+
+  CGFloat ratio = MIN(1, MIN(size.width / image.size.width, size.height / image.size.height));
+  CGSize scaledSize = CGSizeMake(floorf(image.size.width * ratio), floorf(image.size.height * ratio));
+
+  // Drawing into a bitmap context forces the decode now rather than on the main thread the first
+  // time the image is rendered.
+  UIGraphicsBeginImageContextWithOptions(scaledSize, NO, scale);
+  [image drawInRect:CGRectMake(0, 0, scaledSize.width, scaledSize.height)];
+  UIImage* decodedImage = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  return decodedImage;
+}
+
+- (void)loadImageWithSize:(CGSize)size completion:(void (^)(void))completion {
+  NIDASSERT([NSThread isMainThread]);
+
+  if (nil == self.imageURL) {
+    if (nil != completion) {
+      completion();
+    }
+    return;
+  }
+
+  NSString* cacheKey = [[self class] cacheKeyForImageURL:self.imageURL size:size];
+  UIImage* cachedImage = [[Nimbus imageMemoryCache] objectWithName:cacheKey];
+  if (nil != cachedImage) {
+    self.image = cachedImage;
+    if (nil != completion) {
+      completion();
+    }
+    return;
+  }
+
+  if (nil != self.pendingCompletions && CGSizeEqualToSize(size, self.loadingSize)) {
+    if (nil != completion) {
+      [self.pendingCompletions addObject:[completion copy]];
+    }
+    return;
+  }
+
+  // Completions waiting on a load of another size are carried over to this one.
+  self.loadingSize = size;
+  if (nil == self.pendingCompletions) {
+    self.pendingCompletions = [NSMutableArray array];
+  }
+  if (nil != completion) {
+    [self.pendingCompletions addObject:[completion copy]];
+  }
+
+  NSURL* imageURL = self.imageURL;
+  CGFloat scale = [UIScreen mainScreen].scale;
+  Class objectClass = [self class];
+  __weak NILauncherViewImageURLObject* weakSelf = self;
+
+  void (^decodeAndDeliver)(NSData *) = ^(NSData* data) {
+    dispatch_async([objectClass decodingQueue], ^{
+      UIImage* image = (nil != data) ? [objectClass decodedImageWithData:data size:size scale:scale] : nil;
+
+      dispatch_async(dispatch_get_main_queue(), ^{
+        if (nil != image) {
+          [[Nimbus imageMemoryCache] storeObject:image withName:cacheKey];
+        }
+        [weakSelf didLoadImage:image size:size];
+      });
+    });
+  };
+
+  if (imageURL.isFileURL) {
+    dispatch_async([objectClass decodingQueue], ^{
+      decodeAndDeliver([NSData dataWithContentsOfURL:imageURL]);
+    });
+
+  } else if (nil != NSClassFromString(@"NSURLSession")) {
+    [[[NSURLSession sharedSession] dataTaskWithURL:imageURL
+                                 completionHandler:^(NSData* data, NSURLResponse* response, NSError* error) {
+                                   decodeAndDeliver(error ? nil : data);
+                                 }] resume];
+
+  } else {
+    // NSURLSession is only available from iOS 7.
+    [NSURLConnection sendAsynchronousRequest:[NSURLRequest requestWithURL:imageURL]
+                                       queue:[NSOperationQueue mainQueue]
+                           completionHandler:^(NSURLResponse* response, NSData* data, NSError* error) {
+                             decodeAndDeliver(error ? nil : data);
+                           }];
+  }
+}
+
+- (void)didLoadImage:(UIImage *)image size:(CGSize)size {
+  if (!CGSizeEqualToSize(size, self.loadingSize)) {
+    // A load of a different size has since been started; its result will be delivered instead.
+    return;
+  }
+
+  if (nil != image) {
+    self.image = image;
+  }
+
+  NSArray* completions = self.pendingCompletions;
+  self.pendingCompletions = nil;
+  for (void (^completion)(void) in completions) {
+    completion();
+  }
+}
+
+#pragma mark NSCoding
+
+
+- (void)encodeWithCoder:(NSCoder *)coder {
+  [coder encodeObject:self.title forKey:kTitleCodingKey];
+  [coder encodeObject:self.imageURL forKey:kImageURLCodingKey];
+  [coder encodeObject:self.identifier forKey:kIdentifierCodingKey];
+}
+
+- (id)initWithCoder:(NSCoder *)decoder {
+  if ((self = [self initWithTitle:[decoder decodeObjectForKey:kTitleCodingKey]
+                         imageURL:[decoder decodeObjectForKey:kImageURLCodingKey]])) {
+    self.identifier = [decoder decodeObjectForKey:kIdentifierCodingKey];
+  }
+  return self;
+}
+
+@end
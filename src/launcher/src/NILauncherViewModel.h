@@ -19,6 +19,13 @@
 @protocol NILauncherViewObject;
 @protocol NILauncherViewModelDelegate;
 
+/**
+ * Creates a launcher view object from an entry in a layout file.
+ *
+ * @ingroup NimbusLauncherModel
+ */
+typedef id<NILauncherViewObject> (^NILauncherViewObjectFactory)(NSString* identifier, NSString* title, NSString* imageKey);
+
 /**
  * A launcher view model that complies to the NILauncherDataSource protocol.
  *
@@ -26,20 +33,31 @@
  * It also conforms to the NSCoding protocol, allowing you to read and write your model to disk
  * so that you can store the state of your launcher.
  *
+ * Archiving with NSCoding stores every object including its image. To store only the layout,
+ * use writeLayoutToFile: and initWithContentsOfLayoutFile:objectFactory:delegate: instead. A
+ * layout file holds each object's identifier, title and image key in a compact binary form,
+ * and once a model is backed by one, appending and moving objects append a small record to
+ * the file rather than rewriting it.
+ *
  * @ingroup NimbusLauncherModel
  */
 @interface NILauncherViewModel : NSObject <NILauncherDataSource, NSCoding>
 
 // Designated initializer.
 - (id)initWithArrayOfPages:(NSArray *)pages delegate:(id<NILauncherViewModelDelegate>)delegate;
+- (id)initWithContentsOfLayoutFile:(NSString *)path objectFactory:(NILauncherViewObjectFactory)objectFactory delegate:(id<NILauncherViewModelDelegate>)delegate;
 
 - (void)appendPage:(NSArray *)page;
 - (void)appendObject:(id<NILauncherViewObject>)object toPage:(NSInteger)pageIndex;
+- (void)moveObjectAtIndex:(NSInteger)index pageIndex:(NSInteger)pageIndex toIndex:(NSInteger)toIndex pageIndex:(NSInteger)toPageIndex;
 
 - (id<NILauncherViewObject>)objectAtIndex:(NSInteger)index pageIndex:(NSInteger)pageIndex;
 
 @property (nonatomic, weak) id<NILauncherViewModelDelegate> delegate;
 
+- (BOOL)writeLayoutToFile:(NSString *)path;
+@property (nonatomic, copy, readonly) NSString* layoutPath;
+
 @end
 
 /**
@@ -98,6 +116,42 @@
  */
 - (Class)buttonViewClass;
 
+@optional
+
+/** @name Loading the Image Asynchronously */
+
+/**
+ * Asks the receiver to load its image at the given size.
+ *
+ * Implement this method when the image is expensive to produce, e.g. when it must be read from
+ * disk and decoded. The receiver should do the work off the main thread, set its image property
+ * and then call the completion block on the main thread. If the image is already available the
+ * completion block may be called immediately.
+ *
+ * NILauncherViewModel calls this method for objects without an image after they have been
+ * assigned to a button view and passes the launcher view's button size. When the completion
+ * block is called the button view is updated again with shouldUpdateViewWithObject: if it is
+ * still displaying the object.
+ */
+- (void)loadImageWithSize:(CGSize)size completion:(void (^)(void))completion;
+
+/** @name Saving the Object in a Layout File */
+
+/**
+ * A string that identifies this object in a layout file.
+ *
+ * If not implemented the title is used.
+ */
+- (NSString *)identifier;
+
+/**
+ * A string from which the object factory can recreate this object's image, e.g. an image name
+ * or URL.
+ *
+ * If not implemented or nil the object is saved without an image.
+ */
+- (NSString *)imageKey;
+
 @end
 
 /**
@@ -130,6 +184,20 @@
  * @fn NILauncherViewModel::initWithArrayOfPages:delegate:
  */
 
+/**
+ * Initializes a newly allocated launcher view model with the layout stored in the given file.
+ *
+ * The object factory is called for each object in the layout. If it is nil, objects whose image
+ * key is a URL are created as NILauncherViewImageURLObjects and all other objects are created
+ * as NILauncherViewObjects with the image named by the image key.
+ *
+ * Further changes to the model are appended to the file. If the end of the file was cut short,
+ * e.g. because the app was killed while writing, the changes before it are kept.
+ *
+ * @returns An initialized launcher view model, or nil if the file is not a layout file.
+ * @fn NILauncherViewModel::initWithContentsOfLayoutFile:objectFactory:delegate:
+ */
+
 /** @name Accessing Objects */
 
 /**
@@ -147,6 +215,14 @@
  * @fn NILauncherViewModel::appendObject:toPage:
  */
 
+/**
+ * Moves an object to another position, possibly on another page.
+ *
+ * The destination index is the object's index after it has been removed from its old position.
+ *
+ * @fn NILauncherViewModel::moveObjectAtIndex:pageIndex:toIndex:pageIndex:
+ */
+
 /**
  * Returns the object at the given index in the page at the given page index.
  *
@@ -163,3 +239,21 @@
 /**
  * The delegate for this launcher view model.
  */
+
+/** @name Saving the Layout */
+
+/**
+ * Writes the identifiers, titles and image keys of every object to the given file.
+ *
+ * The file is written atomically and becomes the receiver's layoutPath, so that later changes
+ * are appended to it.
+ *
+ * @returns YES if the file was written.
+ * @fn NILauncherViewModel::writeLayoutToFile:
+ */
+
+/**
+ * The layout file that changes to the model are appended to.
+ *
+ * @fn NILauncherViewModel::layoutPath
+ */
@@ -17,6 +17,7 @@
 #import "NILauncherViewModel.h"
 
 #import "NILauncherView.h"
+#import "NILauncherViewImageURLObject.h"
 #import "NILauncherViewObject.h"
 #import "NimbusCore.h"
 
@@ -24,8 +25,159 @@
 #error "Nimbus requires ARC support."
 #endif
 
+// "NILL" when read as bytes.
+static const uint32_t kLayoutFileMagic = 0x4c4c494e;
+static const uint32_t kLayoutFileVersion = 1;
+
+// Once this many records have been appended the file is rewritten as a single layout record.
+static const NSUInteger kMaximumNumberOfAppendedRecords = 128;
+
+// A layout file is a list of little-endian 32 bit integers and strings, each string stored as
+// its UTF-8 length followed by its bytes:
+//
+// magic, version
+// then any number of records, each its type followed by:
+//
+// kLayoutRecordLayout: number of pages, then for each page its number of objects and the objects
+// kLayoutRecordAppendPage: number of objects, then the objects
+// kLayoutRecordAppendObject: page index, then the object
+// kLayoutRecordMove: page index, index, destination page index, destination index
+//
+// where each object is its identifier, title and image key. The file always starts with a
+// layout record; the records after it replay changes made since it was written.
+typedef enum {
+  kLayoutRecordLayout = 1,
+  kLayoutRecordAppendPage,
+  kLayoutRecordAppendObject,
+  kLayoutRecordMove,
+} NILauncherLayoutRecordType;
+
+static void NIAppendUInt32(NSMutableData* data, uint32_t value) {
+  uint32_t littleEndianValue = CFSwapInt32HostToLittle(value);
+  [data appendBytes:&littleEndianValue length:sizeof(littleEndianValue)];
+}
+
+static void NIAppendString(NSMutableData* data, NSString* string) {
+  NSData* utf8 = [(string ?: @"") dataUsingEncoding:NSUTF8StringEncoding];
+  NIAppendUInt32(data, (uint32_t)utf8.length);
+  [data appendData:utf8];
+}
+
+static void NIAppendObject(NSMutableData* data, id<NILauncherViewObject> object) {
+  NSString* identifier = nil;
+  if ([object respondsToSelector:@selector(identifier)]) {
+    identifier = [object identifier];
+  }
+  NSString* imageKey = nil;
+  if ([object respondsToSelector:@selector(imageKey)]) {
+    imageKey = [object imageKey];
+  }
+  NIAppendString(data, identifier ?: object.title);
+  NIAppendString(data, object.title);
+  NIAppendString(data, imageKey);
+}
+
+static void NIAppendPage(NSMutableData* data, NSArray* page) {
+  NIAppendUInt32(data, (uint32_t)page.count);
+  for (id<NILauncherViewObject> object in page) {
+    NIAppendObject(data, object);
+  }
+}
+
+typedef struct {
+  const uint8_t* bytes;
+  NSUInteger length;
+  NSUInteger offset;
+  BOOL failed;
+} NILauncherLayoutReader;
+
+static uint32_t NIReadUInt32(NILauncherLayoutReader* reader) {
+  if (reader->failed || reader->length - reader->offset < sizeof(uint32_t)) {
+    reader->failed = YES;
+    return 0;
+  }
+  uint32_t value = 0;
+  // Strings leave the integers after them unaligned.
+  memcpy(&value, reader->bytes + reader->offset, sizeof(value));
+  reader->offset += sizeof(value);
+  return CFSwapInt32LittleToHost(value);
+}
+
+static NSString* NIReadString(NILauncherLayoutReader* reader) {
+  uint32_t length = NIReadUInt32(reader);
+  if (reader->failed || length > reader->length - reader->offset) {
+    reader->failed = YES;
+    return nil;
+  }
+  NSString* string = [[NSString alloc] initWithBytes:reader->bytes + reader->offset
+                                              length:length
+                                            encoding:NSUTF8StringEncoding];
+  if (nil == string) {
+    reader->failed = YES;
+    return nil;
+  }
+  reader->offset += length;
+  return string;
+}
+
+static id<NILauncherViewObject> NIReadObject(NILauncherLayoutReader* reader, NILauncherViewObjectFactory objectFactory) {
+  NSString* identifier = NIReadString(reader);
+  NSString* title = NIReadString(reader);
+  NSString* imageKey = NIReadString(reader);
+  if (reader->failed) {
+    return nil;
+  }
+  id<NILauncherViewObject> object = objectFactory(identifier, title, imageKey.length > 0 ? imageKey : nil);
+  if (nil == object) {
+    reader->failed = YES;
+  }
+  return object;
+}
+
+static NSMutableArray* NIReadPage(NILauncherLayoutReader* reader, NILauncherViewObjectFactory objectFactory) {
+  uint32_t numberOfObjects = NIReadUInt32(reader);
+  // Every object takes at least twelve bytes, so a corrupt count can't make us allocate more
+  // than the file could possibly hold.
+  if (reader->failed || numberOfObjects > (reader->length - reader->offset) / (3 * sizeof(uint32_t))) {
+    reader->failed = YES;
+    return nil;
+  }
+  NSMutableArray* page = [[NSMutableArray alloc] initWithCapacity:numberOfObjects];
+  for (uint32_t ix = 0; ix < numberOfObjects && !reader->failed; ++ix) {
+    id<NILauncherViewObject> object = NIReadObject(reader, objectFactory);
+    if (nil != object) {
+      [page addObject:object];
+    }
+  }
+  return reader->failed ? nil : page;
+}
+
+static BOOL NIMoveObject(NSMutableArray* pages, NSInteger pageIndex, NSInteger index, NSInteger toPageIndex, NSInteger toIndex) {
+  if (pageIndex < 0 || pageIndex >= (NSInteger)pages.count
+      || toPageIndex < 0 || toPageIndex >= (NSInteger)pages.count) {
+    return NO;
+  }
+  NSMutableArray* page = [pages objectAtIndex:pageIndex];
+  NSMutableArray* toPage = [pages objectAtIndex:toPageIndex];
+  NSInteger toPageCount = (NSInteger)toPage.count - (page == toPage ? 1 : 0);
+  if (index < 0 || index >= (NSInteger)page.count || toIndex < 0 || toIndex > toPageCount) {
+    return NO;
+  }
+  id object = [page objectAtIndex:index];
+  [page removeObjectAtIndex:index];
+  [toPage insertObject:object atIndex:toIndex];
+  return YES;
+}
+
 @interface NILauncherViewModel()
 @property (nonatomic, strong) NSMutableArray* pages;
+@property (nonatomic, copy) NSString* layoutPath;
+@property (nonatomic, strong) NSFileHandle* layoutFileHandle;
+@property (nonatomic, assign) NSUInteger numberOfAppendedRecords;
+
+// Maps each button view to the object it is currently displaying so that asynchronously loaded
+// images are only delivered to buttons that have not been reused for another object.
+@property (nonatomic, strong) NSMapTable* objectsByButtonView;
 @end
 
 @implementation NILauncherViewModel
@@ -49,6 +201,136 @@
   return self;
 }
 
+- (id)initWithContentsOfLayoutFile:(NSString *)path objectFactory:(NILauncherViewObjectFactory)objectFactory delegate:(id<NILauncherViewModelDelegate>)delegate {
+  NSData* data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nil];
+  if (nil == data) {
+    return nil;
+  }
+
+  if (nil == objectFactory) {
+    objectFactory = [[self class] defaultObjectFactory];
+  }
+
+  NILauncherLayoutReader reader = { data.bytes, data.length, 0, NO };
+  if (kLayoutFileMagic != NIReadUInt32(&reader)
+      || kLayoutFileVersion != NIReadUInt32(&reader)
+      || kLayoutRecordLayout != NIReadUInt32(&reader)) {
+    return nil;
+  }
+
+  uint32_t numberOfPages = NIReadUInt32(&reader);
+  NSMutableArray* pages = [NSMutableArray array];
+  for (uint32_t ix = 0; ix < numberOfPages && !reader.failed; ++ix) {
+    NSMutableArray* page = NIReadPage(&reader, objectFactory);
+    if (nil != page) {
+      [pages addObject:page];
+    }
+  }
+  if (reader.failed) {
+    return nil;
+  }
+
+  // Replay the records appended since the layout was written. A torn record at the end of the
+  // file is dropped along with anything after it.
+  NSUInteger numberOfAppendedRecords = 0;
+  while (reader.offset < reader.length) {
+    NILauncherLayoutReader recordReader = reader;
+    uint32_t type = NIReadUInt32(&recordReader);
+    BOOL applied = NO;
+
+    if (kLayoutRecordAppendPage == type) {
+      NSMutableArray* page = NIReadPage(&recordReader, objectFactory);
+      if (nil != page) {
+        [pages addObject:page];
+        applied = YES;
+      }
+
+    } else if (kLayoutRecordAppendObject == type) {
+      uint32_t pageIndex = NIReadUInt32(&recordReader);
+      id<NILauncherViewObject> object = NIReadObject(&recordReader, objectFactory);
+      if (nil != object && pageIndex < pages.count) {
+        [[pages objectAtIndex:pageIndex] addObject:object];
+        applied = YES;
+      }
+
+    } else if (kLayoutRecordMove == type) {
+      uint32_t pageIndex = NIReadUInt32(&recordReader);
+      uint32_t index = NIReadUInt32(&recordReader);
+      uint32_t toPageIndex = NIReadUInt32(&recordReader);
+      uint32_t toIndex = NIReadUInt32(&recordReader);
+      applied = !recordReader.failed && NIMoveObject(pages, pageIndex, index, toPageIndex, toIndex);
+    }
+
+    if (!applied) {
+      NIDWARNING(@"Ignoring the end of launcher layout file %@ from offset %lu",
+                 path, (unsigned long)reader.offset);
+      break;
+    }
+    reader = recordReader;
+    ++numberOfAppendedRecords;
+  }
+
+  if ((self = [self initWithArrayOfPages:pages delegate:delegate])) {
+    _layoutPath = [path copy];
+    _numberOfAppendedRecords = numberOfAppendedRecords;
+    if (reader.offset < data.length) {
+      // Rewrite the file so that new records don't follow the part we couldn't read.
+      [self writeLayoutToFile:path];
+    }
+  }
+  return self;
+}
+
++ (NILauncherViewObjectFactory)defaultObjectFactory {
+  return ^id<NILauncherViewObject>(NSString* identifier, NSString* title, NSString* imageKey) {
+    NSURL* imageURL = (nil != imageKey) ? [NSURL URLWithString:imageKey] : nil;
+    NILauncherViewObject* object = nil;
+    if (nil != imageURL.scheme) {
+      object = [NILauncherViewImageURLObject objectWithTitle:title imageURL:imageURL];
+    } else {
+      object = [NILauncherViewObject objectWithTitle:title
+                                               image:(nil != imageKey) ? [UIImage imageNamed:imageKey] : nil];
+      object.imageKey = imageKey;
+    }
+    object.identifier = identifier;
+    return object;
+  };
+}
+
+- (NSMapTable *)objectsByButtonView {
+  if (nil == _objectsByButtonView) {
+    _objectsByButtonView = [NSMapTable weakToWeakObjectsMapTable];
+  }
+  return _objectsByButtonView;
+}
+
+- (void)loadImageForObject:(id<NILauncherViewObject>)object
+                buttonView:(UIView<NILauncherButtonView> *)buttonView
+                      size:(CGSize)size {
+  [self.objectsByButtonView setObject:object forKey:buttonView];
+
+  if (nil != object.image || ![object respondsToSelector:@selector(loadImageWithSize:completion:)]) {
+    return;
+  }
+
+  __weak NILauncherViewModel* weakSelf = self;
+  __weak UIView<NILauncherButtonView>* weakButtonView = buttonView;
+  __weak id<NILauncherViewObject> weakObject = object;
+  [object loadImageWithSize:size completion:^{
+    NILauncherViewModel* strongSelf = weakSelf;
+    UIView<NILauncherButtonView>* strongButtonView = weakButtonView;
+    id<NILauncherViewObject> strongObject = weakObject;
+    if (nil == strongObject
+        || [strongSelf.objectsByButtonView objectForKey:strongButtonView] != strongObject) {
+      // The button view has since been reused for another object.
+      return;
+    }
+    if ([strongButtonView respondsToSelector:@selector(shouldUpdateViewWithObject:)]) {
+      [strongButtonView performSelector:@selector(shouldUpdateViewWithObject:) withObject:strongObject];
+    }
+  }];
+}
+
 - (NSMutableArray *)_pageAtIndex:(NSInteger)pageIndex {
   NIDASSERT(self.pages.count > pageIndex && pageIndex >= 0);
   return [self.pages objectAtIndex:pageIndex];
@@ -56,12 +338,100 @@
 
 - (void)appendPage:(NSArray *)page {
   [self.pages addObject:[page mutableCopy]];
+
+  [self appendLayoutRecord:kLayoutRecordAppendPage withBlock:^(NSMutableData* data) {
+    NIAppendPage(data, page);
+  }];
 }
 
 - (void)appendObject:(id<NILauncherViewObject>)object toPage:(NSInteger)pageIndex {
   NSAssert(self.pages.count > pageIndex && pageIndex >= 0, @"Page index is out of bounds.");
 
   [[self _pageAtIndex:pageIndex] addObject:object];
+
+  [self appendLayoutRecord:kLayoutRecordAppendObject withBlock:^(NSMutableData* data) {
+    NIAppendUInt32(data, (uint32_t)pageIndex);
+    NIAppendObject(data, object);
+  }];
+}
+
+- (void)moveObjectAtIndex:(NSInteger)index pageIndex:(NSInteger)pageIndex toIndex:(NSInteger)toIndex pageIndex:(NSInteger)toPageIndex {
+  BOOL didMove = NIMoveObject(self.pages, pageIndex, index, toPageIndex, toIndex);
+  NSAssert(didMove, @"Index is out of bounds.");
+  if (!didMove) {
+    return;
+  }
+
+  [self appendLayoutRecord:kLayoutRecordMove withBlock:^(NSMutableData* data) {
+    NIAppendUInt32(data, (uint32_t)pageIndex);
+    NIAppendUInt32(data, (uint32_t)index);
+    NIAppendUInt32(data, (uint32_t)toPageIndex);
+    NIAppendUInt32(data, (uint32_t)toIndex);
+  }];
+}
+
+#pragma mark - Layout Files
+
+
+- (BOOL)writeLayoutToFile:(NSString *)path {
+  NSMutableData* data = [NSMutableData data];
+  NIAppendUInt32(data, kLayoutFileMagic);
+  NIAppendUInt32(data, kLayoutFileVersion);
+  NIAppendUInt32(data, kLayoutRecordLayout);
+  NIAppendUInt32(data, (uint32_t)self.pages.count);
+  for (NSArray* page in self.pages) {
+    NIAppendPage(data, page);
+  }
+
+  [self.layoutFileHandle closeFile];
+  self.layoutFileHandle = nil;
+
+  NSError* error = nil;
+  if (![data writeToFile:path options:NSDataWritingAtomic error:&error]) {
+    NIDERROR(@"Failed to write the launcher layout %@: %@", path, error);
+    return NO;
+  }
+  self.layoutPath = path;
+  self.numberOfAppendedRecords = 0;
+  return YES;
+}
+
+- (void)appendLayoutRecord:(NILauncherLayoutRecordType)type withBlock:(void (^)(NSMutableData* data))block {
+  if (nil == self.layoutPath) {
+    return;
+  }
+
+  if (self.numberOfAppendedRecords >= kMaximumNumberOfAppendedRecords) {
+    [self writeLayoutToFile:self.layoutPath];
+    return;
+  }
+
+  if (nil == self.layoutFileHandle) {
+    self.layoutFileHandle = [NSFileHandle fileHandleForWritingAtPath:self.layoutPath];
+    if (nil == self.layoutFileHandle) {
+      // The file has gone away; start it again from the current layout.
+      [self writeLayoutToFile:self.layoutPath];
+      return;
+    }
+  }
+
+  NSMutableData* data = [NSMutableData data];
+  NIAppendUInt32(data, type);
+  block(data);
+
+  @try {
+    [self.layoutFileHandle seekToEndOfFile];
+    [self.layoutFileHandle writeData:data];
+    self.numberOfAppendedRecords++;
+
+  } @catch (NSException* exception) {
+    NIDERROR(@"Failed to append to the launcher layout %@: %@", self.layoutPath, exception);
+    [self writeLayoutToFile:self.layoutPath];
+  }
+}
+
+- (void)dealloc {
+  [_layoutFileHandle closeFile];
 }
 
 - (id<NILauncherViewObject>)objectAtIndex:(NSInteger)index pageIndex:(NSInteger)pageIndex {
@@ -144,6 +514,8 @@
     [buttonView performSelector:@selector(shouldUpdateViewWithObject:) withObject:object];
   }
 
+  [self loadImageForObject:object buttonView:buttonView size:launcherView.buttonSize];
+
   // Give the delegate a chance to customize this button.
   [self.delegate launcherViewModel:self
                configureButtonView:buttonView
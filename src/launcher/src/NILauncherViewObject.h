@@ -27,6 +27,9 @@
 - (id)initWithTitle:(NSString *)title image:(UIImage *)image;
 + (id)objectWithTitle:(NSString *)title image:(UIImage *)image;
 
+@property (nonatomic, copy) NSString* identifier;
+@property (nonatomic, copy) NSString* imageKey;
+
 @end
 
 /**
@@ -42,3 +45,18 @@
  *
  * @fn NILauncherViewObject::objectWithTitle:image:
  */
+
+/**
+ * A string that identifies this object in a layout file.
+ *
+ * If nil the title is used.
+ *
+ * @fn NILauncherViewObject::identifier
+ */
+
+/**
+ * A string from which the object's image can be recreated when a layout file is read, e.g. the
+ * name of the image in the app bundle.
+ *
+ * @fn NILauncherViewObject::imageKey
+ */
@@ -23,6 +23,8 @@
 
 static NSString* const kTitleCodingKey = @"title";
 static NSString* const kImageCodingKey = @"image";
+static NSString* const kIdentifierCodingKey = @"identifier";
+static NSString* const kImageKeyCodingKey = @"imageKey";
 
 @implementation NILauncherViewObject
 
@@ -51,12 +53,16 @@ static NSString* const kImageCodingKey = @"image";
 - (void)encodeWithCoder:(NSCoder *)coder {
   [coder encodeObject:self.title forKey:kTitleCodingKey];
   [coder encodeObject:self.image forKey:kImageCodingKey];
+  [coder encodeObject:self.identifier forKey:kIdentifierCodingKey];
+  [coder encodeObject:self.imageKey forKey:kImageKeyCodingKey];
 }
 
 - (id)initWithCoder:(NSCoder *)decoder {
   if ((self = [super init])) {
     _title = [decoder decodeObjectForKey:kTitleCodingKey];
     _image = [decoder decodeObjectForKey:kImageCodingKey];
+    _identifier = [decoder decodeObjectForKey:kIdentifierCodingKey];
+    _imageKey = [decoder decodeObjectForKey:kImageKeyCodingKey];
   }
   return self;
 }
@@ -99,6 +99,7 @@
 #import "NILauncherButtonView.h"
 #import "NILauncherViewModel.h"
 #import "NILauncherViewObject.h"
+#import "NILauncherViewImageURLObject.h"
 #import "NILauncherViewController.h"
 #import "NILauncherView.h"
 
@@ -19,6 +19,8 @@
 #import <XCTest/XCTest.h>
 
 #import "NimbusAttributedLabel.h"
+#import "NimbusLauncher.h"
+#import "NILauncherPageView.h"
 
 @interface NILauncherViewTests : XCTestCase
 @end
@@ -30,4 +32,144 @@
 - (void)testNothing {
 }
 
+- (void)testPageRecyclesButtonViewsWhenRemovedFromSuperview {
+  NIViewRecycler* recycler = [[NIViewRecycler alloc] init];
+  NILauncherPageView* page = [[NILauncherPageView alloc] initWithReuseIdentifier:@"page"];
+  page.viewRecycler = recycler;
+
+  UIView* container = [[UIView alloc] init];
+  [container addSubview:page];
+  NILauncherButtonView* buttonView = [[NILauncherButtonView alloc] initWithReuseIdentifier:@"button"];
+  [page addRecyclableView:buttonView];
+  XCTAssertEqual(page.recyclableViews.count, (NSUInteger)1);
+
+  [page removeFromSuperview];
+  XCTAssertEqual(page.recyclableViews.count, (NSUInteger)0);
+  XCTAssertNil(buttonView.superview);
+  XCTAssertEqual([recycler dequeueReusableViewWithIdentifier:@"button"], buttonView,
+                 @"Off-screen pages should hand their buttons to the shared recycler.");
+}
+
+- (void)testPageUsesPrecomputedViewFrames {
+  NILauncherPageView* page = [[NILauncherPageView alloc] initWithReuseIdentifier:@"page"];
+  page.frame = CGRectMake(0, 0, 320, 480);
+  page.viewSize = CGSizeMake(80, 80);
+  [page addRecyclableView:[[NILauncherButtonView alloc] initWithReuseIdentifier:@"button"]];
+  [page addRecyclableView:[[NILauncherButtonView alloc] initWithReuseIdentifier:@"button"]];
+
+  NSArray* viewFrames = [NILauncherPageView viewFramesForNumberOfViews:2
+                                                          inBoundsSize:page.bounds.size
+                                                          contentInset:UIEdgeInsetsZero
+                                                              viewSize:page.viewSize
+                                                           viewMargins:CGSizeZero];
+  [page layoutIfNeeded];
+  XCTAssertEqualObjects([NSValue valueWithCGRect:[page.recyclableViews[1] frame]], viewFrames[1],
+                        @"The shared frame table should match the page's own grid.");
+
+  NSArray* table = @[[NSValue valueWithCGRect:CGRectMake(1, 2, 3, 4)],
+                     [NSValue valueWithCGRect:CGRectMake(5, 6, 7, 8)]];
+  page.viewFrames = table;
+  [page layoutIfNeeded];
+  XCTAssertTrue(CGRectEqualToRect([page.recyclableViews[1] frame], CGRectMake(5, 6, 7, 8)));
+
+  page.viewSize = CGSizeMake(60, 60);
+  XCTAssertNil(page.viewFrames, @"Changing the grid metrics should discard a stale table.");
+}
+
+- (void)testImageURLObjectArchivesOnlyTheImageURL {
+  NILauncherViewImageURLObject* object =
+      [NILauncherViewImageURLObject objectWithTitle:@"Title" imagePath:@"/tmp/icon.png"];
+  object.image = [[UIImage alloc] init];
+
+  NSData* data = [NSKeyedArchiver archivedDataWithRootObject:object];
+  NILauncherViewImageURLObject* decoded = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+  XCTAssertEqualObjects(decoded.title, @"Title");
+  XCTAssertEqualObjects(decoded.imageURL, [NSURL fileURLWithPath:@"/tmp/icon.png"]);
+  XCTAssertNil(decoded.image, @"Decoded images should be reloaded rather than archived.");
+}
+
+- (void)testImageURLObjectsDecodeInTheBackgroundAndShareTheResult {
+  NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"NILauncherViewTests.png"];
+  UIGraphicsBeginImageContextWithOptions(CGSizeMake(100, 50), YES, 1);
+  UIImage* sourceImage = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  [UIImagePNGRepresentation(sourceImage) writeToFile:path atomically:YES];
+  NIImageMemoryCache* originalCache = [Nimbus imageMemoryCache];
+  [Nimbus setImageMemoryCache:[[NIImageMemoryCache alloc] init]];
+
+  NILauncherViewImageURLObject* object = [NILauncherViewImageURLObject objectWithTitle:@"Icon" imagePath:path];
+  __block NSInteger numberOfCompletions = 0;
+  __block BOOL completedOnMainThread = YES;
+  void (^completion)(void) = ^{
+    numberOfCompletions++;
+    completedOnMainThread = completedOnMainThread && [NSThread isMainThread];
+  };
+  [object loadImageWithSize:CGSizeMake(40, 40) completion:completion];
+  [object loadImageWithSize:CGSizeMake(40, 40) completion:completion];
+  XCTAssertNil(object.image, @"The image should be decoded off the main thread.");
+  XCTAssertEqual(numberOfCompletions, (NSInteger)0);
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (numberOfCompletions < 2 && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertEqual(numberOfCompletions, (NSInteger)2, @"Both callers should be told once the one load finishes.");
+  XCTAssertTrue(completedOnMainThread);
+  XCTAssertTrue(CGSizeEqualToSize(object.image.size, CGSizeMake(40, 20)),
+                @"The image should be scaled to fit the button.");
+
+  // Another object with the same icon gets the decoded bitmap right away.
+  NILauncherViewImageURLObject* otherObject = [NILauncherViewImageURLObject objectWithTitle:@"Other" imagePath:path];
+  __block BOOL didCompleteRightAway = NO;
+  [otherObject loadImageWithSize:CGSizeMake(40, 40) completion:^{
+    didCompleteRightAway = YES;
+  }];
+  XCTAssertTrue(didCompleteRightAway);
+  XCTAssertEqual(otherObject.image, object.image);
+
+  NILauncherViewImageURLObject* missingObject =
+      [NILauncherViewImageURLObject objectWithTitle:@"Missing" imagePath:@"/nonexistent/icon.png"];
+  __block BOOL didCompleteMissing = NO;
+  [missingObject loadImageWithSize:CGSizeMake(40, 40) completion:^{
+    didCompleteMissing = YES;
+  }];
+  timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (!didCompleteMissing && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertTrue(didCompleteMissing, @"Failed loads should still complete.");
+  XCTAssertNil(missingObject.image);
+
+  [Nimbus setImageMemoryCache:originalCache];
+  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (void)testLayoutFileReplaysAppendedMoves {
+  NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"NILauncherViewTests.layout"];
+  NILauncherViewObject* first = [NILauncherViewObject objectWithTitle:@"First" image:nil];
+  first.identifier = @"first";
+  NILauncherViewObject* second = [NILauncherViewObject objectWithTitle:@"Second" image:nil];
+  second.imageKey = @"second.png";
+  NILauncherViewModel* model = [[NILauncherViewModel alloc] initWithArrayOfPages:@[@[first, second], @[]]
+                                                                        delegate:nil];
+  XCTAssertTrue([model writeLayoutToFile:path]);
+  unsigned long long layoutSize = [[[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil] fileSize];
+
+  [model moveObjectAtIndex:0 pageIndex:0 toIndex:0 pageIndex:1];
+  unsigned long long movedSize = [[[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil] fileSize];
+  XCTAssertEqual(movedSize - layoutSize, (unsigned long long)(5 * sizeof(uint32_t)), @"A move should only append one record.");
+
+  NILauncherViewModel* loadedModel = [[NILauncherViewModel alloc] initWithContentsOfLayoutFile:path
+                                                                                 objectFactory:nil
+                                                                                      delegate:nil];
+  XCTAssertEqual([loadedModel numberOfPagesInLauncherView:nil], (NSInteger)2);
+  NILauncherViewObject* loadedSecond = (NILauncherViewObject *)[loadedModel objectAtIndex:0 pageIndex:0];
+  NILauncherViewObject* loadedFirst = (NILauncherViewObject *)[loadedModel objectAtIndex:0 pageIndex:1];
+  XCTAssertEqualObjects(loadedSecond.title, @"Second");
+  XCTAssertEqualObjects(loadedSecond.imageKey, @"second.png");
+  XCTAssertEqualObjects(loadedFirst.identifier, @"first");
+
+  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
 @end
@@ -18,6 +18,7 @@
 #import <UIKit/UIKit.h>
 
 #import "NIPreprocessorMacros.h" /* for weak */
+#import "NIState.h"
 
 /**
  * The NIGroupedCellAppearance protocol provides support for each cell to adjust their appearance.
@@ -52,7 +53,7 @@ typedef enum {
  *
  * @ingroup TableCellBackgrounds
  */
-@interface NIGroupedCellBackground : NSObject
+@interface NIGroupedCellBackground : NSObject <NIMemoryBudgetConsumer>
 
 - (void)tableView:(UITableView *)tableView willDisplayCell:(UITableViewCell *)cell forRowAtIndexPath:(NSIndexPath *)indexPath;
 
@@ -62,6 +63,8 @@ typedef enum {
 - (id)cacheKeyForFirst:(BOOL)first last:(BOOL)last highlighted:(BOOL)highlighted drawDivider:(BOOL)drawDivider;
 - (NSInteger)backgroundTagForFirst:(BOOL)isFirst last:(BOOL)isLast drawDivider:(BOOL)drawDivider;
 
+- (void)prerenderImagesInBackground;
+
 @property (nonatomic, strong) UIColor* innerBackgroundColor; // Default: [UIColor whiteColor]
 @property (nonatomic, strong) NSMutableArray* highlightedInnerGradientColors; // Default: RGBCOLOR(53, 141, 245), RGBCOLOR(16, 93, 230)
 @property (nonatomic, assign) CGFloat shadowWidth; // Default: 4
@@ -71,13 +74,18 @@ typedef enum {
 @property (nonatomic, strong) UIColor* dividerColor; // Default: RGBCOLOR(230, 230, 230)
 @property (nonatomic, assign) CGFloat borderRadius; // Default: 5
 
+// NIMemoryBudgetConsumer
+- (unsigned long long)numberOfBytesInMemoryBudget;
+- (void)reduceMemoryUsageByNumberOfBytes:(unsigned long long)numberOfBytes;
+
 @end
 
 /**
  * Returns an image for use with the given cell configuration.
  *
  * The returned image is cached internally after the first request. Changing any of the display
- * properties will invalidate the cached images.
+ * properties will invalidate the cached images. Backgrounds of the same class with the same
+ * properties share their images through a bounded cache that is emptied on memory warnings.
  *
  * @param first YES will round the top corners.
  * @param last  YES will round the bottom corners.
@@ -90,7 +98,8 @@ typedef enum {
  * Returns an image for use with the given cell configuration.
  *
  * The returned image is cached internally after the first request. Changing any of the display
- * properties will invalidate the cached images.
+ * properties will invalidate the cached images. Backgrounds of the same class with the same
+ * properties share their images.
  *
  *      @param first YES will round the top corners.
  *      @param last  YES will round the bottom corners.
@@ -129,3 +138,33 @@ typedef enum {
  *      @returns A tag for an image that matches the given parameters.
  *      @fn NIGroupedCellBackground::backgroundTagForFirst:last:drawDivider:
 */
+
+/**
+ * Draws every variant of the background's images on a background queue.
+ *
+ * Images are shared by every background with the same class and properties, so calling this at
+ * launch on a background configured like the ones the app's tables use means that no table
+ * draws its backgrounds the first time it scrolls. Configure the background before calling
+ * this; the drawing stops if its properties change.
+ *
+ * @fn NIGroupedCellBackground::prerenderImagesInBackground
+ */
+
+/**
+ * Returns the number of bytes in the decoded bitmaps of the cached images.
+ *
+ * Add the background to the global memory budget with Nimbus::addMemoryBudgetConsumer:priority:
+ * to have its images count against the budget.
+ *
+ * @fn NIGroupedCellBackground::numberOfBytesInMemoryBudget
+ */
+
+/**
+ * Removes all of the cached images, including the images of this style that are shared with
+ * other backgrounds.
+ *
+ * The images are cheap to draw again, so they are all dropped no matter how few bytes were
+ * asked for.
+ *
+ * @fn NIGroupedCellBackground::reduceMemoryUsageByNumberOfBytes:
+ */
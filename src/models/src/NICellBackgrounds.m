@@ -25,8 +25,55 @@
 static const CGFloat kBorderSize = 1;
 static const CGSize kCellImageSize = {44, 44};
 
+// Room for the sixteen variants of a handful of styles at 3x.
+static const NSUInteger kSharedImagesCostLimit = 2 * 1024 * 1024;
+
+// Backgrounds with the same style share their images through this cache, so each variant is only
+// drawn once per process rather than once per table controller. The images can always be drawn
+// again, so the cache is bounded and emptied when memory runs low.
+static NSCache* NIGroupedCellBackgroundSharedImages(void) {
+  static NSCache* sSharedImages = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sSharedImages = [[NSCache alloc] init];
+    sSharedImages.totalCostLimit = kSharedImagesCostLimit;
+    [[NSNotificationCenter defaultCenter] addObserverForName:UIApplicationDidReceiveMemoryWarningNotification
+                                                      object:nil
+                                                       queue:nil
+                                                  usingBlock:^(NSNotification* notification) {
+                                                    [sSharedImages removeAllObjects];
+                                                  }];
+  });
+  return sSharedImages;
+}
+
+static NSUInteger NIGroupedCellBackgroundImageCost(UIImage* image) {
+  CGImageRef imageRef = image.CGImage;
+  return CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef);
+}
+
+// Describes a color by its components so that equal colors created separately have equal keys.
+static NSString* NIGroupedCellBackgroundColorKey(CGColorRef color) {
+  if (NULL == color) {
+    return @"-";
+  }
+  NSMutableString* key = [NSMutableString string];
+  CGPatternRef pattern = CGColorGetPattern(color);
+  if (NULL != pattern) {
+    [key appendFormat:@"%p", pattern];
+  }
+  const CGFloat* components = CGColorGetComponents(color);
+  size_t numberOfComponents = CGColorGetNumberOfComponents(color);
+  [key appendFormat:@"%d", (int)CGColorSpaceGetModel(CGColorGetColorSpace(color))];
+  for (size_t ix = 0; ix < numberOfComponents; ++ix) {
+    [key appendFormat:@",%g", components[ix]];
+  }
+  return key;
+}
+
 @interface NIGroupedCellBackground()
 @property (nonatomic, strong) NSMutableDictionary* cachedImages;
+@property (nonatomic, copy) NSString* styleKey;
 @end
 
 
@@ -369,8 +416,59 @@ static const CGSize kCellImageSize = {44, 44};
   return [NSNumber numberWithInteger:flags];
 }
 
+- (NSString *)_styleKey {
+  @synchronized(self.cachedImages) {
+    if (nil == self.styleKey) {
+      NSMutableString* key = [NSMutableString stringWithString:NSStringFromClass([self class])];
+      [key appendFormat:@"|%@", NIGroupedCellBackgroundColorKey(self.innerBackgroundColor.CGColor)];
+      for (id color in self.highlightedInnerGradientColors) {
+        [key appendFormat:@"|%@", NIGroupedCellBackgroundColorKey((__bridge CGColorRef)color)];
+      }
+      [key appendFormat:@"|%g|%@", self.shadowWidth, NSStringFromCGSize(self.shadowOffset)];
+      [key appendFormat:@"|%@", NIGroupedCellBackgroundColorKey(self.shadowColor.CGColor)];
+      [key appendFormat:@"|%@", NIGroupedCellBackgroundColorKey(self.borderColor.CGColor)];
+      [key appendFormat:@"|%@", NIGroupedCellBackgroundColorKey(self.dividerColor.CGColor)];
+      [key appendFormat:@"|%g|%g|", self.borderRadius, [[self class] minPixelOffset]];
+      self.styleKey = key;
+    }
+    return self.styleKey;
+  }
+}
+
 - (void)_invalidateCache {
-  [self.cachedImages removeAllObjects];
+  // The memory budget may ask for the images to be released from any thread.
+  @synchronized(self.cachedImages) {
+    [self.cachedImages removeAllObjects];
+    self.styleKey = nil;
+  }
+}
+
+#pragma mark - NIMemoryBudgetConsumer
+
+
+- (unsigned long long)numberOfBytesInMemoryBudget {
+  unsigned long long numberOfBytes = 0;
+  @synchronized(self.cachedImages) {
+    for (UIImage* image in [self.cachedImages objectEnumerator]) {
+      numberOfBytes += NIGroupedCellBackgroundImageCost(image);
+    }
+  }
+  return numberOfBytes;
+}
+
+- (void)reduceMemoryUsageByNumberOfBytes:(unsigned long long)numberOfBytes {
+  NSString* styleKey = [self _styleKey];
+  [self _invalidateCache];
+
+  // Other backgrounds with this style hold on to the images they have already used.
+  NSCache* sharedImages = NIGroupedCellBackgroundSharedImages();
+  for (NSInteger variant = 0; variant < 16; ++variant) {
+    id cacheKey = [self cacheKeyForFirst:(variant & 0x01) != 0
+                                    last:(variant & 0x02) != 0
+                             highlighted:(variant & 0x04) != 0
+                             drawDivider:(variant & 0x08) != 0];
+    [sharedImages removeObjectForKey:[styleKey stringByAppendingString:[cacheKey description]]];
+  }
 }
 
 #pragma mark - Public
@@ -414,14 +512,43 @@ static const CGSize kCellImageSize = {44, 44};
 
 - (UIImage *)imageForFirst:(BOOL)first last:(BOOL)last highlighted:(BOOL)highlighted drawDivider:(BOOL)drawDivider {
   id cacheKey = [self cacheKeyForFirst:first last:last highlighted:highlighted drawDivider:drawDivider];
-  UIImage* image = [self.cachedImages objectForKey:cacheKey];
+  UIImage* image = nil;
+  @synchronized(self.cachedImages) {
+    image = [self.cachedImages objectForKey:cacheKey];
+  }
   if (nil == image) {
-    image = [self _imageForFirst:first last:last highlighted:highlighted drawDivider:drawDivider];
-    [self.cachedImages setObject:image forKey:cacheKey];
+    NSCache* sharedImages = NIGroupedCellBackgroundSharedImages();
+    NSString* sharedKey = [[self _styleKey] stringByAppendingString:[cacheKey description]];
+    image = [sharedImages objectForKey:sharedKey];
+    if (nil == image) {
+      image = [self _imageForFirst:first last:last highlighted:highlighted drawDivider:drawDivider];
+      [sharedImages setObject:image forKey:sharedKey cost:NIGroupedCellBackgroundImageCost(image)];
+    }
+    @synchronized(self.cachedImages) {
+      [self.cachedImages setObject:image forKey:cacheKey];
+    }
   }
   return image;
 }
 
+- (void)prerenderImagesInBackground {
+  NSString* styleKey = [self _styleKey];
+  __weak NIGroupedCellBackground* weakSelf = self;
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+    for (NSInteger variant = 0; variant < 16; ++variant) {
+      NIGroupedCellBackground* strongSelf = weakSelf;
+      // Stop if the style changed; its images would be drawn for nothing.
+      if (![[strongSelf _styleKey] isEqualToString:styleKey]) {
+        return;
+      }
+      [strongSelf imageForFirst:(variant & 0x01) != 0
+                           last:(variant & 0x02) != 0
+                    highlighted:(variant & 0x04) != 0
+                    drawDivider:(variant & 0x08) != 0];
+    }
+  });
+}
+
 - (void)setInnerBackgroundColor:(UIColor *)innerBackgroundColor {
   if (_innerBackgroundColor != innerBackgroundColor) {
     _innerBackgroundColor = innerBackgroundColor;
@@ -443,6 +570,13 @@ static const CGSize kCellImageSize = {44, 44};
   }
 }
 
+- (void)setShadowOffset:(CGSize)shadowOffset {
+  if (!CGSizeEqualToSize(_shadowOffset, shadowOffset)) {
+    _shadowOffset = shadowOffset;
+    [self _invalidateCache];
+  }
+}
+
 - (void)setShadowColor:(UIColor *)shadowColor {
   if (_shadowColor != shadowColor) {
     _shadowColor = shadowColor;
@@ -464,4 +598,11 @@ static const CGSize kCellImageSize = {44, 44};
   }
 }
 
+- (void)setBorderRadius:(CGFloat)borderRadius {
+  if (_borderRadius != borderRadius) {
+    _borderRadius = borderRadius;
+    [self _invalidateCache];
+  }
+}
+
 @end
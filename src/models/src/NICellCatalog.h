@@ -21,6 +21,12 @@ typedef CGFloat (^NICellDrawRectBlock)(CGRect rect, id object, UITableViewCell*
 /**
  * An object that will draw the contents of the cell using a provided block.
  *
+ * Set drawsAsynchronously for blocks that are too slow to run on the main thread while the table
+ * scrolls. The block then draws into a bitmap on a background queue and is passed a nil cell.
+ * Each bitmap is cached for the size it was drawn at, so a row that scrolls back into view is
+ * shown without drawing again. The bitmaps of all objects share one cache that is limited to 16MB
+ * and emptied on memory warnings. Changing the block or the object drops the bitmaps.
+ *
  * @ingroup TableCellCatalog
  */
 @interface NIDrawRectBlockCellObject : NICellObject
@@ -29,6 +35,7 @@ typedef CGFloat (^NICellDrawRectBlock)(CGRect rect, id object, UITableViewCell*
 + (id)objectWithBlock:(NICellDrawRectBlock)block object:(id)object;
 @property (nonatomic, copy) NICellDrawRectBlock block;
 @property (nonatomic, strong) id object;
+@property (nonatomic, assign) BOOL drawsAsynchronously; // Default: NO
 @end
 
 /**
@@ -85,6 +92,10 @@ typedef CGFloat (^NICellDrawRectBlock)(CGRect rect, id object, UITableViewCell*
 /**
  * A cell that renders its contents using a block.
  *
+ * When the object draws asynchronously, blockView is hidden and the rendered bitmap is set as the
+ * contents of another view's layer. A render that hasn't finished when the cell is reused or
+ * given another object is abandoned.
+ *
  * @ingroup TableCellCatalog
  */
 @interface NIDrawRectBlockCell : UITableViewCell <NICell>
@@ -23,6 +23,39 @@
 #error "Nimbus requires ARC support."
 #endif
 
+static dispatch_queue_t NIDrawRectBlockCellRenderQueue(void) {
+  return dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+}
+
+// Room for a few screens of rows at 2x.
+static const NSUInteger kRenderedImagesCostLimit = 16 * 1024 * 1024;
+
+// Rendered bitmaps of every object, so that their total is bounded rather than growing with the
+// number of rows that have been shown. Emptied when memory runs low.
+static NSCache* NIDrawRectBlockCellRenderedImages(void) {
+  static NSCache* sRenderedImages = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sRenderedImages = [[NSCache alloc] init];
+    sRenderedImages.totalCostLimit = kRenderedImagesCostLimit;
+    [[NSNotificationCenter defaultCenter] addObserverForName:UIApplicationDidReceiveMemoryWarningNotification
+                                                      object:nil
+                                                       queue:nil
+                                                  usingBlock:^(NSNotification* notification) {
+                                                    [sRenderedImages removeAllObjects];
+                                                  }];
+  });
+  return sRenderedImages;
+}
+
+@interface NIDrawRectBlockCellObject ()
+// Identifies this object's current block and object in the rendered images cache. A new one is
+// taken whenever either changes, so the old bitmaps are never found again. Only used on the main
+// thread.
+@property (nonatomic, assign) NSUInteger renderIdentifier;
+@end
+
+
 @implementation NIDrawRectBlockCellObject
 
 
@@ -31,6 +64,7 @@
   if ((self = [super initWithCellClass:[NIDrawRectBlockCell class]])) {
     _block = block;
     _object = object;
+    [self _takeNewRenderIdentifier];
   }
   return self;
 }
@@ -39,6 +73,37 @@
   return [[self alloc] initWithBlock:block object:object];
 }
 
+- (void)_takeNewRenderIdentifier {
+  static NSUInteger sNextRenderIdentifier = 0;
+  self.renderIdentifier = ++sNextRenderIdentifier;
+}
+
+- (NSString *)_renderKeyForSize:(CGSize)size scale:(CGFloat)scale {
+  return [NSString stringWithFormat:@"%lu|%gx%g@%g",
+          (unsigned long)self.renderIdentifier, size.width, size.height, scale];
+}
+
+- (void)setBlock:(NICellDrawRectBlock)block {
+  _block = [block copy];
+  [self _takeNewRenderIdentifier];
+}
+
+- (void)setObject:(id)object {
+  _object = object;
+  [self _takeNewRenderIdentifier];
+}
+
+- (UIImage *)renderedImageForSize:(CGSize)size scale:(CGFloat)scale {
+  return [NIDrawRectBlockCellRenderedImages() objectForKey:[self _renderKeyForSize:size scale:scale]];
+}
+
+- (void)setRenderedImage:(UIImage *)image forSize:(CGSize)size scale:(CGFloat)scale {
+  CGImageRef imageRef = image.CGImage;
+  [NIDrawRectBlockCellRenderedImages() setObject:image
+                                          forKey:[self _renderKeyForSize:size scale:scale]
+                                            cost:CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef)];
+}
+
 @end
 
 
@@ -185,6 +250,15 @@
 @end
 
 
+@interface NIDrawRectBlockCell ()
+@property (nonatomic, strong) NIDrawRectBlockCellObject* asyncObject;
+@property (nonatomic, strong) UIView* asyncContentView;
+@property (nonatomic, assign) CGSize asyncContentSize;
+// Read on the render queue so that abandoned renders don't draw.
+@property (atomic, assign) NSUInteger asyncRenderGeneration;
+@end
+
+
 @implementation NIDrawRectBlockCell
 
 - (id)initWithStyle:(UITableViewCellStyle)style reuseIdentifier:(NSString *)reuseIdentifier {
@@ -203,8 +277,90 @@
   return self;
 }
 
+- (void)prepareForReuse {
+  [super prepareForReuse];
+  ++self.asyncRenderGeneration;
+  self.asyncContentView.layer.contents = nil;
+  self.asyncContentSize = CGSizeZero;
+}
+
+- (void)layoutSubviews {
+  [super layoutSubviews];
+  if (nil != self.asyncObject && !CGSizeEqualToSize(self.asyncContentView.bounds.size, self.asyncContentSize)) {
+    [self renderAsynchronously];
+  }
+}
+
+- (void)renderAsynchronously {
+  ++self.asyncRenderGeneration;
+  CGSize size = self.asyncContentView.bounds.size;
+  self.asyncContentSize = size;
+  if (size.width <= 0 || size.height <= 0) {
+    self.asyncContentView.layer.contents = nil;
+    return;
+  }
+
+  NIDrawRectBlockCellObject* object = self.asyncObject;
+  CGFloat scale = (nil != self.window) ? self.window.screen.scale : [UIScreen mainScreen].scale;
+  UIImage* image = [object renderedImageForSize:size scale:scale];
+  self.asyncContentView.layer.contentsScale = scale;
+  self.asyncContentView.layer.contents = (id)image.CGImage;
+  if (nil != image) {
+    return;
+  }
+
+  NICellDrawRectBlock block = object.block;
+  id blockObject = object.object;
+  NSUInteger generation = self.asyncRenderGeneration;
+  __weak NIDrawRectBlockCell* weakSelf = self;
+  dispatch_async(NIDrawRectBlockCellRenderQueue(), ^{
+    if (weakSelf.asyncRenderGeneration != generation || nil == block) {
+      return;
+    }
+    UIGraphicsBeginImageContextWithOptions(size, NO, scale);
+    block(CGRectMake(0, 0, size.width, size.height), blockObject, nil);
+    UIImage* renderedImage = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+      // The image is still good for the object even if this cell has moved on.
+      if (nil != renderedImage && object.block == block && object.object == blockObject) {
+        [object setRenderedImage:renderedImage forSize:size scale:scale];
+      }
+      NIDrawRectBlockCell* cell = weakSelf;
+      if (cell.asyncRenderGeneration == generation) {
+        cell.asyncContentView.layer.contents = (id)renderedImage.CGImage;
+      }
+    });
+  });
+}
+
 - (BOOL)shouldUpdateCellWithObject:(NIDrawRectBlockCellObject *)object {
   NIDrawRectBlockView* blockView = (NIDrawRectBlockView *)self.blockView;
+  if (object.drawsAsynchronously) {
+    if (nil == self.asyncContentView) {
+      self.asyncContentView = [[UIView alloc] initWithFrame:self.contentView.bounds];
+      self.asyncContentView.autoresizingMask = UIViewAutoresizingFlexibleDimensions;
+      self.asyncContentView.backgroundColor = [UIColor clearColor];
+      self.asyncContentView.userInteractionEnabled = NO;
+      [self.contentView addSubview:self.asyncContentView];
+    }
+    blockView.hidden = YES;
+    blockView.block = nil;
+    blockView.object = nil;
+    self.asyncContentView.hidden = NO;
+    self.asyncObject = object;
+    // Rendered once the cell has been laid out at its final size.
+    self.asyncContentSize = CGSizeZero;
+    [self setNeedsLayout];
+    return YES;
+  }
+
+  ++self.asyncRenderGeneration;
+  self.asyncObject = nil;
+  self.asyncContentView.hidden = YES;
+  self.asyncContentView.layer.contents = nil;
+  blockView.hidden = NO;
   blockView.block = object.block;
   blockView.object = object.object;
   blockView.cell = self;
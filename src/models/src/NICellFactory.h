@@ -111,6 +111,95 @@ _model.delegate = (id)[NICellFactory class];
  */
 - (CGFloat)tableView:(UITableView *)tableView heightForRowAtIndexPath:(NSIndexPath *)indexPath model:(NITableViewModel *)model;
 
+/**
+ * Whether the heights returned by tableView:heightForRowAtIndexPath:model: are cached.
+ *
+ * Turn this on when heightForObject:atIndexPath:tableView: is expensive, e.g. when it measures
+ * text, so that reloading the table only asks for the heights of new objects.
+ *
+ * Heights are cached for each object, compared by pointer, and for each table width, so a table
+ * that rotates keeps the heights of both orientations. The cache is emptied whenever the model is
+ * an NIMutableTableViewModel and it adds, inserts or removes objects or sections. Call
+ * invalidateRowHeightForObject: when an object changes in a way that changes its height.
+ *
+ * Default: NO
+ */
+@property (nonatomic, assign) BOOL cachesRowHeights;
+
+/**
+ * Drops the cached heights of the given object at every table width.
+ */
+- (void)invalidateRowHeightForObject:(id)object;
+
+/**
+ * Drops every cached height.
+ *
+ * This also stops precomputeRowHeightsForTableView:model:.
+ */
+- (void)invalidateRowHeights;
+
+/**
+ * Computes the heights of the model's rows on a background queue and caches them.
+ *
+ * Only cells that implement heightForObject:atIndexPath:tableWidth: are precomputed; the rest are
+ * measured when the table asks for them. Heights arrive in chunks, and each chunk is applied with
+ * one pair of beginUpdates/endUpdates calls so that the table adopts them without reloading.
+ * The table only asks for estimates if its delegate implements
+ * tableView:estimatedHeightForRowAtIndexPath:, so forward that to
+ * tableView:estimatedHeightForRowAtIndexPath:model: alongside the row heights:
+ *
+@code
+- (CGFloat)tableView:(UITableView *)tableView heightForRowAtIndexPath:(NSIndexPath *)indexPath {
+  return [self.cellFactory tableView:tableView heightForRowAtIndexPath:indexPath model:self.model];
+}
+
+- (CGFloat)tableView:(UITableView *)tableView estimatedHeightForRowAtIndexPath:(NSIndexPath *)indexPath {
+  return [self.cellFactory tableView:tableView estimatedHeightForRowAtIndexPath:indexPath model:self.model];
+}
+@endcode
+ *
+ * Without it every row is measured on the main thread when the table first loads, as if nothing
+ * had been precomputed.
+ *
+ * Mutating the model, changing the table's width or calling this again discards the results that
+ * have not been applied yet.
+ *
+ * This turns on cachesRowHeights and must be called on the main thread.
+ */
+- (void)precomputeRowHeightsForTableView:(UITableView *)tableView model:(NITableViewModel *)model;
+
+/**
+ * Returns the cached height of the row at the given index path, or estimatedRowHeight if it has
+ * not been computed yet.
+ *
+ * Unlike tableView:heightForRowAtIndexPath:model:, this never measures the row.
+ */
+- (CGFloat)tableView:(UITableView *)tableView estimatedHeightForRowAtIndexPath:(NSIndexPath *)indexPath model:(NITableViewModel *)model;
+
+/**
+ * The height reported for rows whose height has not been computed.
+ *
+ * If zero, tableView.rowHeight is used.
+ *
+ * Default: 0
+ */
+@property (nonatomic, assign) CGFloat estimatedRowHeight;
+
+/**
+ * Whether the rows of NINibCellObjects are measured with a prototype cell.
+ *
+ * The factory keeps one cell instantiated from each nib and updates it with each object that is
+ * measured, so sizing a long nib-based form doesn't instantiate the nib for every row. If the
+ * prototype's class implements heightForObject:atIndexPath:tableView: then it is used; otherwise
+ * the prototype is laid out at the table's width and the height that its content view's
+ * constraints require is used. Without either, tableView.rowHeight is returned as before.
+ *
+ * Prototype cells are used on the main thread only.
+ *
+ * Default: NO
+ */
+@property (nonatomic, assign) BOOL sizesNibCellsWithPrototypes;
+
 /**
  * Returns the height for a row at a given index path.
  *
@@ -152,6 +241,20 @@ _model.delegate = (id)[NICellFactory class];
 @optional
 /** The style of UITableViewCell to be used when initializing the cell for the first time. */
 - (UITableViewCellStyle)cellStyle;
+
+/**
+ * A number that changes whenever the object's displayed contents change.
+ *
+ * When implemented, the cell factory records the object and version that each cell was last
+ * configured with and skips @link NICell::shouldUpdateCellWithObject: shouldUpdateCellWithObject:@endlink
+ * when a dequeued cell already displays this exact version of this object. Increment the version
+ * whenever a property that affects the cell changes.
+ *
+ * Only implement this for objects whose cells keep their contents in prepareForReuse; a cell
+ * that clears itself on reuse must always be reconfigured. Nib cell objects may implement this
+ * method as well.
+ */
+- (NSUInteger)cellObjectVersion;
 @end
 
 /**
@@ -219,6 +322,16 @@ _model.delegate = (id)[NICellFactory class];
  */
 + (CGFloat)heightForObject:(id)object atIndexPath:(NSIndexPath *)indexPath tableView:(UITableView *)tableView;
 
+/**
+ * Asks the receiver to calculate its height in a table of the given width.
+ *
+ * NICellFactory::precomputeRowHeightsForTableView:model: calls this on a background queue, so
+ * the implementation must not create or measure views. Measuring strings with
+ * boundingRectWithSize:options:attributes:context: is safe. If the cell also implements
+ * heightForObject:atIndexPath:tableView:, both must return the same height.
+ */
++ (CGFloat)heightForObject:(id)object atIndexPath:(NSIndexPath *)indexPath tableWidth:(CGFloat)tableWidth;
+
 @end
 
 /**
@@ -16,15 +16,119 @@
 
 #import "NICellFactory.h"
 #import "NICellFactory+Private.h"
+#import "NITableViewModel+Private.h"
 
 #import "NimbusCore.h"
+#import <objc/runtime.h>
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "Nimbus requires ARC support."
 #endif
 
+// Rotating between two orientations only ever needs the heights of two widths.
+static const NSUInteger kMaximumNumberOfCachedRowWidths = 2;
+
+// Applying heights in chunks keeps each beginUpdates/endUpdates pass short.
+static const NSUInteger kNumberOfPrecomputedRowHeightsPerChunk = 100;
+
+static dispatch_queue_t NICellFactoryRowHeightQueue(void) {
+  static dispatch_queue_t sQueue = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sQueue = dispatch_queue_create("com.nimbuskit.models.rowheights", DISPATCH_QUEUE_SERIAL);
+    dispatch_set_target_queue(sQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+  });
+  return sQueue;
+}
+
+// Returns the reuse identifier for cells of the given class showing objects of the given class.
+// The identifiers are built once for each pair, so no strings are created for each row.
+static NSString* NICellFactoryReuseIdentifier(Class cellClass, Class objectClass) {
+  static NSMutableDictionary* sCellClassToIdentifiers = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sCellClassToIdentifiers = [[NSMutableDictionary alloc] init];
+  });
+
+  @synchronized(sCellClassToIdentifiers) {
+    // Either the identifier or, for cells that append the object class, a dictionary of object
+    // class => identifier.
+    id identifiers = [sCellClassToIdentifiers objectForKey:cellClass];
+    if (nil == identifiers) {
+      if ([cellClass respondsToSelector:@selector(shouldAppendObjectClassToReuseIdentifier)]
+          && [cellClass shouldAppendObjectClassToReuseIdentifier]) {
+        identifiers = [NSMutableDictionary dictionary];
+      } else {
+        identifiers = NSStringFromClass(cellClass);
+      }
+      [sCellClassToIdentifiers setObject:identifiers forKey:(id<NSCopying>)cellClass];
+    }
+    if ([identifiers isKindOfClass:[NSString class]]) {
+      return identifiers;
+    }
+
+    NSString* identifier = [identifiers objectForKey:objectClass];
+    if (nil == identifier) {
+      identifier = [NSString stringWithFormat:@"%@.%@", NSStringFromClass(cellClass), NSStringFromClass(objectClass)];
+      [identifiers setObject:identifier forKey:(id<NSCopying>)objectClass];
+    }
+    return identifier;
+  }
+}
+
+static char sCellConfigurationKey;
+
+// The object and version that a cell was last configured with.
+@interface NICellConfiguration : NSObject
+@property (nonatomic, weak) id object;
+@property (nonatomic, assign) NSUInteger version;
+@end
+
+@implementation NICellConfiguration
+@end
+
+// Configures the cell with the object unless the cell already displays this version of it.
+static void NICellFactoryUpdateCellWithObject(UITableViewCell* cell, id object) {
+  if (![cell respondsToSelector:@selector(shouldUpdateCellWithObject:)]) {
+    return;
+  }
+
+  if (![object respondsToSelector:@selector(cellObjectVersion)]) {
+    // Forget any previous configuration so that a later versioned object is always applied.
+    if (nil != objc_getAssociatedObject(cell, &sCellConfigurationKey)) {
+      objc_setAssociatedObject(cell, &sCellConfigurationKey, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    }
+    [(id<NICell>)cell shouldUpdateCellWithObject:object];
+    return;
+  }
+
+  NSUInteger version = [object cellObjectVersion];
+  NICellConfiguration* configuration = objc_getAssociatedObject(cell, &sCellConfigurationKey);
+  if (nil != configuration && configuration.object == object && configuration.version == version) {
+    return;
+  }
+
+  if (nil == configuration) {
+    configuration = [[NICellConfiguration alloc] init];
+    objc_setAssociatedObject(cell, &sCellConfigurationKey, configuration, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+  }
+  configuration.object = object;
+  configuration.version = version;
+
+  [(id<NICell>)cell shouldUpdateCellWithObject:object];
+}
+
 @interface NICellFactory()
 @property (nonatomic, copy) NSMutableDictionary* objectToCellMap;
+// Object class => the cell class mapped to its nearest superclass, or [NSNull class] if there is
+// none. Cleared whenever a class is mapped.
+@property (nonatomic, strong) NSMutableDictionary* resolvedObjectToCellMap;
+@property (nonatomic, strong) NSMutableDictionary* nibIdentifierToPrototypeCell; // NSString => UITableViewCell
+@property (nonatomic, strong) NSMutableDictionary* widthToRowHeights; // NSNumber => NSMapTable of object => NSNumber
+@property (nonatomic, weak) NITableViewModel* rowHeightModel;
+@property (nonatomic, assign) NSUInteger rowHeightModelMutationCount;
+// Read by the background queue to stop precomputing heights that will be discarded.
+@property (atomic, assign) NSUInteger rowHeightPrecomputationGeneration;
 @end
 
 
@@ -35,6 +139,7 @@
 - (id)init {
   if ((self = [super init])) {
     _objectToCellMap = [[NSMutableDictionary alloc] init];
+    _resolvedObjectToCellMap = [[NSMutableDictionary alloc] init];
   }
   return self;
 }
@@ -44,12 +149,7 @@
                             object:(id)object {
   UITableViewCell* cell = nil;
 
-  NSString* identifier = NSStringFromClass(cellClass);
-
-  if ([cellClass respondsToSelector:@selector(shouldAppendObjectClassToReuseIdentifier)]
-      && [cellClass shouldAppendObjectClassToReuseIdentifier]) {
-    identifier = [identifier stringByAppendingFormat:@".%@", NSStringFromClass([object class])];
-  }
+  NSString* identifier = NICellFactoryReuseIdentifier(cellClass, [object class]);
 
   cell = [tableView dequeueReusableCellWithIdentifier:identifier];
 
@@ -62,9 +162,7 @@
   }
 
   // Allow the cell to configure itself with the object's information.
-  if ([cell respondsToSelector:@selector(shouldUpdateCellWithObject:)]) {
-    [(id<NICell>)cell shouldUpdateCellWithObject:object];
-  }
+  NICellFactoryUpdateCellWithObject(cell, object);
 
   return cell;
 }
@@ -76,14 +174,27 @@
   UITableViewCell* cell = nil;
 
   NSString* identifier = NSStringFromClass([object class]);
-  [tableView registerNib:cellNib forCellReuseIdentifier:identifier];
+
+  // Nibs are registered the first time each table view needs them rather than for every row.
+  static NSMapTable* sTableViewToRegisteredNibs = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sTableViewToRegisteredNibs = [NSMapTable weakToStrongObjectsMapTable];
+  });
+  NSMutableDictionary* registeredNibs = [sTableViewToRegisteredNibs objectForKey:tableView];
+  if (nil == registeredNibs) {
+    registeredNibs = [NSMutableDictionary dictionary];
+    [sTableViewToRegisteredNibs setObject:registeredNibs forKey:tableView];
+  }
+  if ([registeredNibs objectForKey:identifier] != cellNib) {
+    [tableView registerNib:cellNib forCellReuseIdentifier:identifier];
+    [registeredNibs setObject:cellNib forKey:identifier];
+  }
 
   cell = [tableView dequeueReusableCellWithIdentifier:identifier forIndexPath:indexPath];
 
   // Allow the cell to configure itself with the object's information.
-  if ([cell respondsToSelector:@selector(shouldUpdateCellWithObject:)]) {
-    [(id<NICell>)cell shouldUpdateCellWithObject:object];
-  }
+  NICellFactoryUpdateCellWithObject(cell, object);
 
   return cell;
 }
@@ -112,6 +223,24 @@
   return cell;
 }
 
+- (Class)_inheritedCellClassForObjectClass:(Class)objectClass {
+  Class cellClass = [self.resolvedObjectToCellMap objectForKey:objectClass];
+  if (nil == cellClass) {
+    // Objects use the mapping of their nearest mapped superclass.
+    for (Class superclass = [objectClass superclass]; nil != superclass; superclass = [superclass superclass]) {
+      cellClass = [self.objectToCellMap objectForKey:superclass];
+      if (nil != cellClass) {
+        break;
+      }
+    }
+    if (nil == cellClass) {
+      cellClass = [NSNull class];
+    }
+    [self.resolvedObjectToCellMap setObject:cellClass forKey:(id<NSCopying>)objectClass];
+  }
+  return (cellClass == [NSNull class]) ? nil : cellClass;
+}
+
 - (Class)cellClassFromObject:(id)object {
   if (nil == object) {
     return nil;
@@ -120,13 +249,17 @@
   Class cellClass = [self.objectToCellMap objectForKey:objectClass];
 
   BOOL hasExplicitMapping = (nil != cellClass && cellClass != [NSNull class]);
+  if (hasExplicitMapping) {
+    return cellClass;
+  }
 
-  if (!hasExplicitMapping && [object respondsToSelector:@selector(cellClass)]) {
+  cellClass = nil;
+  if ([object respondsToSelector:@selector(cellClass)]) {
     cellClass = [object cellClass];
   }
 
   if (nil == cellClass) {
-    cellClass = [NIActions objectFromKeyClass:objectClass map:self.objectToCellMap];
+    cellClass = [self _inheritedCellClassForObjectClass:objectClass];
   }
 
   return cellClass;
@@ -157,22 +290,241 @@
 
 - (void)mapObjectClass:(Class)objectClass toCellClass:(Class)cellClass {
   [self.objectToCellMap setObject:cellClass forKey:(id<NSCopying>)objectClass];
+  // Subclasses of the object class may have resolved to another cell class.
+  [self.resolvedObjectToCellMap removeAllObjects];
 }
 
 - (CGFloat)tableView:(UITableView *)tableView heightForRowAtIndexPath:(NSIndexPath *)indexPath model:(NITableViewModel *)model {
-  CGFloat height = tableView.rowHeight;
   id object = [model objectAtIndexPath:indexPath];
-  Class cellClass = [self cellClassFromObject:object];
+  if (!self.cachesRowHeights || nil == object) {
+    return [self tableView:tableView heightForObject:object atIndexPath:indexPath];
+  }
+
+  NSMapTable* rowHeights = [self rowHeightsForTableView:tableView model:model];
+  NSNumber* height = [rowHeights objectForKey:object];
+  if (nil == height) {
+    height = [NSNumber numberWithDouble:[self tableView:tableView heightForObject:object atIndexPath:indexPath]];
+    [rowHeights setObject:height forKey:object];
+  }
+  return (CGFloat)[height doubleValue];
+}
+
+- (UITableViewCell *)prototypeCellForNib:(UINib *)cellNib identifier:(NSString *)identifier {
+  UITableViewCell* cell = [self.nibIdentifierToPrototypeCell objectForKey:identifier];
+  if (nil == cell) {
+    for (id topLevelObject in [cellNib instantiateWithOwner:nil options:nil]) {
+      if ([topLevelObject isKindOfClass:[UITableViewCell class]]) {
+        cell = topLevelObject;
+        break;
+      }
+    }
+    NIDASSERT(nil != cell);
+    if (nil == cell) {
+      return nil;
+    }
+    if (nil == self.nibIdentifierToPrototypeCell) {
+      self.nibIdentifierToPrototypeCell = [NSMutableDictionary dictionary];
+    }
+    [self.nibIdentifierToPrototypeCell setObject:cell forKey:identifier];
+  }
+  return cell;
+}
+
+- (CGFloat)tableView:(UITableView *)tableView heightForNibObject:(id)object atIndexPath:(NSIndexPath *)indexPath {
+  UITableViewCell* cell = [self prototypeCellForNib:[object cellNib] identifier:NSStringFromClass([object class])];
+  Class cellClass = [cell class];
   if ([cellClass respondsToSelector:@selector(heightForObject:atIndexPath:tableView:)]) {
+    return [cellClass heightForObject:object atIndexPath:indexPath tableView:tableView];
+  }
+  if (nil == cell) {
+    return 0;
+  }
+
+  if ([cell respondsToSelector:@selector(shouldUpdateCellWithObject:)]) {
+    [(id<NICell>)cell shouldUpdateCellWithObject:object];
+  }
+  CGRect frame = cell.bounds;
+  frame.size.width = tableView.bounds.size.width;
+  cell.bounds = frame;
+  [cell setNeedsLayout];
+  [cell layoutIfNeeded];
+
+  CGFloat height = [cell.contentView systemLayoutSizeFittingSize:UILayoutFittingCompressedSize].height;
+  if (height <= 0) {
+    return height;
+  }
+  CGFloat scale = NIScreenScale();
+  if (UITableViewCellSeparatorStyleNone != tableView.separatorStyle) {
+    // The table view makes the content view shorter than the row by the separator, which is one
+    // pixel high, so the row needs that pixel on top of the content.
+    height += 1 / scale;
+  }
+  // Fitting sizes can be fractions of a pixel; rounding down would clip the content.
+  return ceil(height * scale) / scale;
+}
+
+- (CGFloat)tableView:(UITableView *)tableView heightForObject:(id)object atIndexPath:(NSIndexPath *)indexPath {
+  CGFloat height = tableView.rowHeight;
+  Class cellClass = [self cellClassFromObject:object];
+  if (nil == cellClass && self.sizesNibCellsWithPrototypes && [object respondsToSelector:@selector(cellNib)]) {
+    CGFloat cellHeight = [self tableView:tableView heightForNibObject:object atIndexPath:indexPath];
+    if (cellHeight > 0) {
+      height = cellHeight;
+    }
+
+  } else if ([cellClass respondsToSelector:@selector(heightForObject:atIndexPath:tableView:)]) {
     CGFloat cellHeight = [cellClass heightForObject:object
                                         atIndexPath:indexPath tableView:tableView];
     if (cellHeight > 0) {
       height = cellHeight;
     }
+
+  } else if ([cellClass respondsToSelector:@selector(heightForObject:atIndexPath:tableWidth:)]) {
+    CGFloat cellHeight = [cellClass heightForObject:object
+                                        atIndexPath:indexPath
+                                         tableWidth:tableView.bounds.size.width];
+    if (cellHeight > 0) {
+      height = cellHeight;
+    }
   }
   return height;
 }
 
+- (NSMapTable *)rowHeightsForTableView:(UITableView *)tableView model:(NITableViewModel *)model {
+  // Objects may be moved to index paths where they have a different height.
+  if (self.rowHeightModel != model || self.rowHeightModelMutationCount != model.mutationCount) {
+    [self invalidateRowHeights];
+    self.rowHeightModel = model;
+    self.rowHeightModelMutationCount = model.mutationCount;
+  }
+
+  NSNumber* width = [NSNumber numberWithDouble:tableView.bounds.size.width];
+  NSMapTable* rowHeights = [self.widthToRowHeights objectForKey:width];
+  if (nil == rowHeights) {
+    if (nil == self.widthToRowHeights) {
+      self.widthToRowHeights = [NSMutableDictionary dictionary];
+    } else if (self.widthToRowHeights.count >= kMaximumNumberOfCachedRowWidths) {
+      [self.widthToRowHeights removeAllObjects];
+    }
+    rowHeights = [NSMapTable mapTableWithKeyOptions:(NSPointerFunctionsWeakMemory
+                                                     | NSPointerFunctionsObjectPointerPersonality)
+                                       valueOptions:NSPointerFunctionsStrongMemory];
+    [self.widthToRowHeights setObject:rowHeights forKey:width];
+  }
+  return rowHeights;
+}
+
+- (void)invalidateRowHeightForObject:(id)object {
+  if (nil == object) {
+    return;
+  }
+  for (NSMapTable* rowHeights in [self.widthToRowHeights objectEnumerator]) {
+    [rowHeights removeObjectForKey:object];
+  }
+}
+
+- (void)invalidateRowHeights {
+  [self.widthToRowHeights removeAllObjects];
+  ++self.rowHeightPrecomputationGeneration;
+}
+
+- (CGFloat)tableView:(UITableView *)tableView estimatedHeightForRowAtIndexPath:(NSIndexPath *)indexPath model:(NITableViewModel *)model {
+  id object = [model objectAtIndexPath:indexPath];
+  if (self.cachesRowHeights && nil != object) {
+    NSNumber* height = [[self rowHeightsForTableView:tableView model:model] objectForKey:object];
+    if (nil != height) {
+      return (CGFloat)[height doubleValue];
+    }
+  }
+  return (self.estimatedRowHeight > 0) ? self.estimatedRowHeight : tableView.rowHeight;
+}
+
+- (void)precomputeRowHeightsForTableView:(UITableView *)tableView model:(NITableViewModel *)model {
+  NIDASSERT([NSThread isMainThread]);
+  self.cachesRowHeights = YES;
+  NSMapTable* rowHeights = [self rowHeightsForTableView:tableView model:model];
+  NSUInteger generation = ++self.rowHeightPrecomputationGeneration;
+
+  // The model and the explicit mappings may only be read on the main thread, so everything the
+  // background queue needs is gathered up front.
+  NSMutableArray* objects = [NSMutableArray array];
+  NSMutableArray* cellClasses = [NSMutableArray array];
+  NSMutableArray* indexPaths = [NSMutableArray array];
+  NSInteger numberOfSections = [model numberOfSectionsInTableView:tableView];
+  for (NSInteger section = 0; section < numberOfSections; ++section) {
+    NSInteger numberOfRows = [model tableView:tableView numberOfRowsInSection:section];
+    for (NSInteger row = 0; row < numberOfRows; ++row) {
+      NSIndexPath* indexPath = [NSIndexPath indexPathForRow:row inSection:section];
+      id object = [model objectAtIndexPath:indexPath];
+      Class cellClass = [self cellClassFromObject:object];
+      if (nil == [rowHeights objectForKey:object]
+          && [cellClass respondsToSelector:@selector(heightForObject:atIndexPath:tableWidth:)]) {
+        [objects addObject:object];
+        [cellClasses addObject:cellClass];
+        [indexPaths addObject:indexPath];
+      }
+    }
+  }
+  if (0 == objects.count) {
+    return;
+  }
+
+  CGFloat tableWidth = tableView.bounds.size.width;
+  CGFloat defaultHeight = tableView.rowHeight;
+  __weak NICellFactory* weakSelf = self;
+  __weak UITableView* weakTableView = tableView;
+  __weak NITableViewModel* weakModel = model;
+  dispatch_async(NICellFactoryRowHeightQueue(), ^{
+    for (NSUInteger first = 0; first < objects.count; first += kNumberOfPrecomputedRowHeightsPerChunk) {
+      if (weakSelf.rowHeightPrecomputationGeneration != generation) {
+        return;
+      }
+      NSRange chunk = NSMakeRange(first, MIN(kNumberOfPrecomputedRowHeightsPerChunk, objects.count - first));
+      NSMutableArray* heights = [NSMutableArray arrayWithCapacity:chunk.length];
+      for (NSUInteger ix = chunk.location; ix < NSMaxRange(chunk); ++ix) {
+        CGFloat height = [[cellClasses objectAtIndex:ix] heightForObject:[objects objectAtIndex:ix]
+                                                             atIndexPath:[indexPaths objectAtIndex:ix]
+                                                              tableWidth:tableWidth];
+        [heights addObject:[NSNumber numberWithDouble:(height > 0) ? height : defaultHeight]];
+      }
+      NSArray* chunkObjects = [objects subarrayWithRange:chunk];
+      dispatch_async(dispatch_get_main_queue(), ^{
+        [weakSelf applyRowHeights:heights
+                       forObjects:chunkObjects
+                        tableView:weakTableView
+                            model:weakModel
+                       tableWidth:tableWidth
+                       generation:generation];
+      });
+    }
+  });
+}
+
+- (void)applyRowHeights:(NSArray *)heights
+             forObjects:(NSArray *)objects
+              tableView:(UITableView *)tableView
+                  model:(NITableViewModel *)model
+             tableWidth:(CGFloat)tableWidth
+             generation:(NSUInteger)generation {
+  if (nil == tableView || nil == model
+      || generation != self.rowHeightPrecomputationGeneration
+      || tableWidth != tableView.bounds.size.width) {
+    return;
+  }
+  // Looking up the cache drops it, and bumps the generation, if the model has mutated since.
+  NSMapTable* rowHeights = [self rowHeightsForTableView:tableView model:model];
+  if (generation != self.rowHeightPrecomputationGeneration) {
+    return;
+  }
+  [objects enumerateObjectsUsingBlock:^(id object, NSUInteger ix, BOOL *stop) {
+    if (nil == [rowHeights objectForKey:object]) {
+      [rowHeights setObject:[heights objectAtIndex:ix] forKey:object];
+    }
+  }];
+  [tableView beginUpdates];
+  [tableView endUpdates];
+}
+
 + (CGFloat)tableView:(UITableView *)tableView heightForRowAtIndexPath:(NSIndexPath *)indexPath model:(NITableViewModel *)model {
   CGFloat height = tableView.rowHeight;
   id object = [model objectAtIndexPath:indexPath];
@@ -186,6 +538,14 @@
     if (cellHeight > 0) {
       height = cellHeight;
     }
+
+  } else if ([cellClass respondsToSelector:@selector(heightForObject:atIndexPath:tableWidth:)]) {
+    CGFloat cellHeight = [cellClass heightForObject:object
+                                        atIndexPath:indexPath
+                                         tableWidth:tableView.bounds.size.width];
+    if (cellHeight > 0) {
+      height = cellHeight;
+    }
   }
   return height;
 }
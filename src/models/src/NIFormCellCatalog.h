@@ -16,6 +16,15 @@
 
 #import "NICellFactory.h"
 
+@class NIFormElement;
+
+/**
+ * A block invoked after the value of a form element has changed.
+ *
+ * @ingroup TableCellCatalog
+ */
+typedef void (^NIFormElementValueObserver)(id element);
+
 #pragma mark Form Elements
 
 /**
@@ -34,6 +43,13 @@
 
 @property (nonatomic, assign) NSInteger elementID;
 
+// Value observation
+- (id)addValueObserver:(NIFormElementValueObserver)observer;
+- (void)removeValueObserver:(id)observerToken;
+
+// Subclasses call this after their value changes.
+- (void)didChangeValue;
+
 @end
 
 /**
@@ -211,12 +227,18 @@
 /**
  * The base class for form element cells.
  *
- * Doesn't do anything particularly interesting other than retaining the element.
+ * A form element cell binds itself to its element while it is displaying it. Changes made to the
+ * element's properties while the cell is bound are pushed straight into the cell's controls, so
+ * forms never need to reload a row just to reflect a new value.
  *
  * @ingroup TableCellCatalog
  */
 @interface NIFormElementCell : UITableViewCell <NICell>
 @property (nonatomic, readonly, strong) NIFormElement* element;
+
+// Subclass hooks for in-place updates
+- (void)elementValueDidChange;
+- (void)elementDisplayDidChange;
 @end
 
 /**
@@ -288,3 +310,51 @@
 @property (nonatomic, readonly, strong) UIDatePicker *datePicker;
 @end
 
+/** @name Value Observation */
+
+/**
+ * Registers a block that is called after the element's value changes.
+ *
+ * Observers are coalesced: any number of value changes within a single run loop turn result in
+ * one call to each observer on the main thread, after which the element holds its latest value.
+ * Use this to update dependent elements, such as a label that mirrors a slider, without
+ * reloading rows.
+ *
+ * @returns An opaque token that can be passed to removeValueObserver:.
+ * @fn NIFormElement::addValueObserver:
+ */
+
+/**
+ * Unregisters an observer previously added with addValueObserver:.
+ *
+ * @fn NIFormElement::removeValueObserver:
+ */
+
+/**
+ * Notifies the bound cell and schedules the value observers.
+ *
+ * The built-in elements call this from their value setters. Custom elements should call it
+ * whenever their value changes.
+ *
+ * @fn NIFormElement::didChangeValue
+ */
+
+/** @name Subclass Hooks */
+
+/**
+ * Called when the bound element's value changes.
+ *
+ * Subclasses should update their control only if it differs from the element's value so that
+ * changes originating from the control itself are not reapplied.
+ *
+ * @fn NIFormElementCell::elementValueDidChange
+ */
+
+/**
+ * Called when a displayed property of the bound element, such as its label, changes.
+ *
+ * Subclasses update their labels here and request layout. The default implementation calls
+ * setNeedsLayout, which UIKit coalesces into a single layout pass per run loop turn.
+ *
+ * @fn NIFormElementCell::elementDisplayDidChange
+ */
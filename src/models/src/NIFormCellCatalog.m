@@ -30,6 +30,15 @@ static const CGFloat kImageViewRightMargin = 10;
 static const CGFloat kSegmentedControlMargin = 5;
 static const CGFloat kDatePickerTextFieldRightMargin = 5;
 
+@interface NIFormElement()
+// The cell currently displaying this element, if any.
+@property (nonatomic, weak) NIFormElementCell* boundCell;
+@property (nonatomic, strong) NSMutableArray* valueObservers;
+@property (nonatomic, assign) BOOL valueObserverNotificationScheduled;
+- (void)didChangeDisplay;
+@end
+
+
 @implementation NIFormElement
 
 
@@ -46,6 +55,56 @@ static const CGFloat kDatePickerTextFieldRightMargin = 5;
   return nil;
 }
 
+#pragma mark - Value Observation
+
+
+- (id)addValueObserver:(NIFormElementValueObserver)observer {
+  NIDASSERT(nil != observer);
+  if (nil == observer) {
+    return nil;
+  }
+  if (nil == _valueObservers) {
+    _valueObservers = [[NSMutableArray alloc] init];
+  }
+  id observerToken = [observer copy];
+  [_valueObservers addObject:observerToken];
+  return observerToken;
+}
+
+- (void)removeValueObserver:(id)observerToken {
+  if (nil != observerToken) {
+    [_valueObservers removeObjectIdenticalTo:observerToken];
+  }
+}
+
+- (void)didChangeValue {
+  [self.boundCell elementValueDidChange];
+
+  if (_valueObservers.count == 0 || self.valueObserverNotificationScheduled) {
+    return;
+  }
+
+  // Coalesce every change made during this run loop turn into a single notification.
+  self.valueObserverNotificationScheduled = YES;
+  __weak NIFormElement* weakSelf = self;
+  dispatch_async(dispatch_get_main_queue(), ^{
+    NIFormElement* strongSelf = weakSelf;
+    if (nil == strongSelf) {
+      return;
+    }
+    strongSelf.valueObserverNotificationScheduled = NO;
+
+    // Observers may remove themselves while being notified.
+    for (NIFormElementValueObserver observer in [strongSelf.valueObservers copy]) {
+      observer(strongSelf);
+    }
+  });
+}
+
+- (void)didChangeDisplay {
+  [self.boundCell elementDisplayDidChange];
+}
+
 @end
 
 
@@ -75,6 +134,22 @@ static const CGFloat kDatePickerTextFieldRightMargin = 5;
   return [self passwordInputElementWithID:elementID placeholderText:placeholderText value:value delegate:nil];
 }
 
+- (void)setValue:(NSString *)value {
+  if (_value == value || [_value isEqualToString:value]) {
+    return;
+  }
+  _value = [value copy];
+  [self didChangeValue];
+}
+
+- (void)setPlaceholderText:(NSString *)placeholderText {
+  if (_placeholderText == placeholderText || [_placeholderText isEqualToString:placeholderText]) {
+    return;
+  }
+  _placeholderText = [placeholderText copy];
+  [self didChangeDisplay];
+}
+
 - (Class)cellClass {
   return [NITextInputFormElementCell class];
 }
@@ -99,6 +174,22 @@ static const CGFloat kDatePickerTextFieldRightMargin = 5;
   return [self switchElementWithID:elementID labelText:labelText value:value didChangeTarget:nil didChangeSelector:nil];
 }
 
+- (void)setValue:(BOOL)value {
+  if (_value == value) {
+    return;
+  }
+  _value = value;
+  [self didChangeValue];
+}
+
+- (void)setLabelText:(NSString *)labelText {
+  if (_labelText == labelText || [_labelText isEqualToString:labelText]) {
+    return;
+  }
+  _labelText = [labelText copy];
+  [self didChangeDisplay];
+}
+
 - (Class)cellClass {
   return [NISwitchFormElementCell class];
 }
@@ -125,6 +216,38 @@ static const CGFloat kDatePickerTextFieldRightMargin = 5;
   return [self sliderElementWithID:elementID labelText:labelText value:value minimumValue:minimumValue maximumValue:maximumValue didChangeTarget:nil didChangeSelector:nil];
 }
 
+- (void)setValue:(float)value {
+  if (_value == value) {
+    return;
+  }
+  _value = value;
+  [self didChangeValue];
+}
+
+- (void)setMinimumValue:(float)minimumValue {
+  if (_minimumValue == minimumValue) {
+    return;
+  }
+  _minimumValue = minimumValue;
+  [self didChangeDisplay];
+}
+
+- (void)setMaximumValue:(float)maximumValue {
+  if (_maximumValue == maximumValue) {
+    return;
+  }
+  _maximumValue = maximumValue;
+  [self didChangeDisplay];
+}
+
+- (void)setLabelText:(NSString *)labelText {
+  if (_labelText == labelText || [_labelText isEqualToString:labelText]) {
+    return;
+  }
+  _labelText = [labelText copy];
+  [self didChangeDisplay];
+}
+
 - (Class)cellClass {
   return [NISliderFormElementCell class];
 }
@@ -205,12 +328,21 @@ static const CGFloat kDatePickerTextFieldRightMargin = 5;
 - (void)prepareForReuse {
   [super prepareForReuse];
   
+  [self unbindElement];
   _element = nil;
 }
 
+- (void)unbindElement {
+  if (_element.boundCell == self) {
+    _element.boundCell = nil;
+  }
+}
+
 - (BOOL)shouldUpdateCellWithObject:(id)object {
   if (_element != object) {
+    [self unbindElement];
     _element = object;
+    _element.boundCell = self;
 
     self.tag = _element.elementID;
 
@@ -220,6 +352,14 @@ static const CGFloat kDatePickerTextFieldRightMargin = 5;
   return NO;
 }
 
+- (void)elementValueDidChange {
+  // No-op. Subclasses update their controls here.
+}
+
+- (void)elementDisplayDidChange {
+  [self setNeedsLayout];
+}
+
 @end
 
 
@@ -258,7 +398,7 @@ static const CGFloat kDatePickerTextFieldRightMargin = 5;
 - (BOOL)shouldUpdateCellWithObject:(NITextInputFormElement *)textInputElement {
   if ([super shouldUpdateCellWithObject:textInputElement]) {
     _textField.placeholder = textInputElement.placeholderText;
-    _textField.text = textInputElement.value;
+    [self elementValueDidChange];
     _textField.delegate = textInputElement.delegate;
     _textField.secureTextEntry = textInputElement.isPassword;
 
@@ -270,6 +410,20 @@ static const CGFloat kDatePickerTextFieldRightMargin = 5;
   return NO;
 }
 
+- (void)elementValueDidChange {
+  NITextInputFormElement* textInputElement = (NITextInputFormElement *)self.element;
+  if (_textField.text != textInputElement.value
+      && ![_textField.text isEqualToString:textInputElement.value]) {
+    _textField.text = textInputElement.value;
+  }
+}
+
+- (void)elementDisplayDidChange {
+  NITextInputFormElement* textInputElement = (NITextInputFormElement *)self.element;
+  _textField.placeholder = textInputElement.placeholderText;
+  [super elementDisplayDidChange];
+}
+
 - (void)textFieldDidChangeValue {
   NITextInputFormElement* textInputElement = (NITextInputFormElement *)self.element;
   textInputElement.value = _textField.text;
@@ -327,7 +481,7 @@ static const CGFloat kDatePickerTextFieldRightMargin = 5;
 
 - (BOOL)shouldUpdateCellWithObject:(NISwitchFormElement *)switchElement {
   if ([super shouldUpdateCellWithObject:switchElement]) {
-    _switchControl.on = switchElement.value;
+    [self elementValueDidChange];
     self.textLabel.text = switchElement.labelText;
 
     _switchControl.tag = self.tag;
@@ -338,6 +492,19 @@ static const CGFloat kDatePickerTextFieldRightMargin = 5;
   return NO;
 }
 
+- (void)elementValueDidChange {
+  NISwitchFormElement* switchElement = (NISwitchFormElement *)self.element;
+  if (_switchControl.on != switchElement.value) {
+    _switchControl.on = switchElement.value;
+  }
+}
+
+- (void)elementDisplayDidChange {
+  NISwitchFormElement* switchElement = (NISwitchFormElement *)self.element;
+  self.textLabel.text = switchElement.labelText;
+  [super elementDisplayDidChange];
+}
+
 - (void)switchDidChangeValue {
   NISwitchFormElement* switchElement = (NISwitchFormElement *)self.element;
   switchElement.value = _switchControl.on;
@@ -407,7 +574,7 @@ static const CGFloat kDatePickerTextFieldRightMargin = 5;
   if ([super shouldUpdateCellWithObject:sliderElement]) {
     _sliderControl.minimumValue = sliderElement.minimumValue;
     _sliderControl.maximumValue = sliderElement.maximumValue;
-    _sliderControl.value = sliderElement.value;
+    [self elementValueDidChange];
     self.textLabel.text = sliderElement.labelText;
 
     _sliderControl.tag = self.tag;
@@ -418,6 +585,22 @@ static const CGFloat kDatePickerTextFieldRightMargin = 5;
   return NO;
 }
 
+- (void)elementValueDidChange {
+  NISliderFormElement* sliderElement = (NISliderFormElement *)self.element;
+  if (_sliderControl.value != sliderElement.value) {
+    _sliderControl.value = sliderElement.value;
+  }
+}
+
+- (void)elementDisplayDidChange {
+  NISliderFormElement* sliderElement = (NISliderFormElement *)self.element;
+  _sliderControl.minimumValue = sliderElement.minimumValue;
+  _sliderControl.maximumValue = sliderElement.maximumValue;
+  _sliderControl.value = sliderElement.value;
+  self.textLabel.text = sliderElement.labelText;
+  [super elementDisplayDidChange];
+}
+
 - (void)sliderDidChangeValue {
   NISliderFormElement* sliderElement = (NISliderFormElement *)self.element;
   sliderElement.value = _sliderControl.value;
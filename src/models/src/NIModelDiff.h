@@ -0,0 +1,56 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+// The parts of a model section that a diff compares.
+@protocol NIModelDiffSection <NSObject>
+@property (nonatomic, readonly, copy) NSString* headerTitle;
+@property (nonatomic, readonly, strong) NSArray* rows;
+@end
+
+/**
+ * The changes from one list of model sections to another, shared by NITableViewModelDiff and
+ * NICollectionViewModelDiff.
+ *
+ * Index paths hold the section followed by the row or item. Not part of the public API.
+ */
+@interface NIModelDiff : NSObject
+
+// Both arrays hold id<NIModelDiffSection>.
++ (NIModelDiff *)diffFromSections:(NSArray *)fromSections toSections:(NSArray *)toSections;
+
+@property (nonatomic, readonly, strong) NSArray* toSections;
+@property (nonatomic, readonly, copy) NSArray* fromSectionTitles; // NSString or NSNull
+@property (nonatomic, readonly, copy) NSArray* fromSectionRowCounts; // NSNumber
+
+@property (nonatomic, readonly, copy) NSIndexSet* deletedSections;
+@property (nonatomic, readonly, copy) NSIndexSet* insertedSections;
+@property (nonatomic, readonly, copy) NSArray* movedFromSections; // NSNumber
+@property (nonatomic, readonly, copy) NSArray* movedToSections; // NSNumber
+
+@property (nonatomic, readonly, copy) NSArray* deletedIndexPaths;
+@property (nonatomic, readonly, copy) NSArray* insertedIndexPaths;
+@property (nonatomic, readonly, copy) NSArray* movedFromIndexPaths;
+@property (nonatomic, readonly, copy) NSArray* movedToIndexPaths;
+@property (nonatomic, readonly, copy) NSArray* reloadedIndexPaths;
+
+@property (nonatomic, readonly, assign) BOOL hasChanges;
+
+// Whether the diff was computed from sections with the same titles and numbers of rows.
+- (BOOL)isDiffFromSections:(NSArray *)sections;
+
+@end
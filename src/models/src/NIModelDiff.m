@@ -0,0 +1,292 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIModelDiff.h"
+
+#import "NimbusCore.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+/**
+ * Matches each new item to an old one, first by identity and then by equality.
+ *
+ * Repeated items are paired in order. Items without a match are left at NSNotFound.
+ */
+static void NIMatchItems(NSArray* oldItems, NSArray* newItems, NSUInteger* oldToNew, NSUInteger* newToOld) {
+  for (NSUInteger ix = 0; ix < oldItems.count; ++ix) {
+    oldToNew[ix] = NSNotFound;
+  }
+  for (NSUInteger ix = 0; ix < newItems.count; ++ix) {
+    newToOld[ix] = NSNotFound;
+  }
+
+  NSPointerFunctionsOptions personalities[] = {
+    NSPointerFunctionsObjectPointerPersonality,
+    NSPointerFunctionsObjectPersonality
+  };
+  for (NSUInteger pass = 0; pass < sizeof(personalities) / sizeof(personalities[0]); ++pass) {
+    NSMapTable* oldIndexesForItem =
+        [[NSMapTable alloc] initWithKeyOptions:(NSPointerFunctionsStrongMemory | personalities[pass])
+                                  valueOptions:NSPointerFunctionsStrongMemory
+                                      capacity:oldItems.count];
+    // Walking backwards leaves the first occurrence of each item on top of its stack.
+    for (NSUInteger ix = oldItems.count; ix > 0; --ix) {
+      if (NSNotFound != oldToNew[ix - 1]) {
+        continue;
+      }
+      id item = [oldItems objectAtIndex:ix - 1];
+      NSMutableArray* oldIndexes = [oldIndexesForItem objectForKey:item];
+      if (nil == oldIndexes) {
+        oldIndexes = [NSMutableArray array];
+        [oldIndexesForItem setObject:oldIndexes forKey:item];
+      }
+      [oldIndexes addObject:[NSNumber numberWithUnsignedInteger:ix - 1]];
+    }
+    for (NSUInteger ix = 0; ix < newItems.count; ++ix) {
+      if (NSNotFound != newToOld[ix]) {
+        continue;
+      }
+      NSMutableArray* oldIndexes = [oldIndexesForItem objectForKey:[newItems objectAtIndex:ix]];
+      if (oldIndexes.count > 0) {
+        NSUInteger oldIndex = [[oldIndexes lastObject] unsignedIntegerValue];
+        [oldIndexes removeLastObject];
+        newToOld[ix] = oldIndex;
+        oldToNew[oldIndex] = ix;
+      }
+    }
+  }
+}
+
+// Table and collection views both read the section and the second index of an index path.
+static NSIndexPath* NIModelDiffIndexPath(NSUInteger section, NSUInteger row) {
+  NSUInteger indexes[] = {section, row};
+  return [NSIndexPath indexPathWithIndexes:indexes length:2];
+}
+
+@implementation NIModelDiff
+
++ (NIModelDiff *)diffFromSections:(NSArray *)fromSections toSections:(NSArray *)toSections {
+  NIModelDiff* diff = [[self alloc] init];
+  diff->_toSections = toSections;
+  NI_SIGNPOST_BEGIN(NISignpostCategoryModels, "Diff", diff);
+
+  NSMutableArray* oldTitles = [NSMutableArray arrayWithCapacity:fromSections.count];
+  NSMutableArray* oldRowCounts = [NSMutableArray arrayWithCapacity:fromSections.count];
+  NSMutableArray* oldItems = [NSMutableArray array];
+  for (id<NIModelDiffSection> section in fromSections) {
+    [oldTitles addObject:section.headerTitle ?: [NSNull null]];
+    [oldRowCounts addObject:[NSNumber numberWithUnsignedInteger:section.rows.count]];
+    [oldItems addObjectsFromArray:section.rows];
+  }
+  NSMutableArray* newTitles = [NSMutableArray arrayWithCapacity:toSections.count];
+  NSMutableArray* newItems = [NSMutableArray array];
+  for (id<NIModelDiffSection> section in toSections) {
+    [newTitles addObject:section.headerTitle ?: [NSNull null]];
+    [newItems addObjectsFromArray:section.rows];
+  }
+  diff->_fromSectionTitles = [oldTitles copy];
+  diff->_fromSectionRowCounts = [oldRowCounts copy];
+
+  NSUInteger oldSectionCount = oldTitles.count;
+  NSUInteger newSectionCount = newTitles.count;
+  NSUInteger oldItemCount = oldItems.count;
+  NSUInteger newItemCount = newItems.count;
+
+  // Every per-item and per-section table lives in one allocation.
+  NSUInteger numberOfIndexes = (2 * oldSectionCount + 2 * newSectionCount
+                                + 5 * oldItemCount + 5 * newItemCount);
+  NSUInteger* indexes = malloc(sizeof(NSUInteger) * MAX(numberOfIndexes, (NSUInteger)1));
+  NSUInteger* oldSectionToNew = indexes;
+  NSUInteger* newSectionToOld = oldSectionToNew + oldSectionCount;
+  NSUInteger* oldToNew = newSectionToOld + newSectionCount;
+  NSUInteger* newToOld = oldToNew + oldItemCount;
+  NSUInteger* oldSectionOfItem = newToOld + newItemCount;
+  NSUInteger* oldRowOfItem = oldSectionOfItem + oldItemCount;
+  NSUInteger* newSectionOfItem = oldRowOfItem + oldItemCount;
+  NSUInteger* newRowOfItem = newSectionOfItem + newItemCount;
+  // The row each item would have if only the rows entering and leaving its section moved it.
+  NSUInteger* oldShiftedRowOfItem = newRowOfItem + newItemCount;
+  NSUInteger* newShiftedRowOfItem = oldShiftedRowOfItem + oldItemCount;
+  NSUInteger* oldSectionLeaving = newShiftedRowOfItem + newItemCount;
+  NSUInteger* newSectionArriving = oldSectionLeaving + oldSectionCount;
+  NSUInteger* oldItemLeaves = newSectionArriving + newSectionCount;
+  NSUInteger* newItemArrives = oldItemLeaves + oldItemCount;
+
+  NIMatchItems(oldTitles, newTitles, oldSectionToNew, newSectionToOld);
+
+  NSMutableIndexSet* deletedSections = [NSMutableIndexSet indexSet];
+  NSMutableIndexSet* insertedSections = [NSMutableIndexSet indexSet];
+  for (NSUInteger ix = 0; ix < oldSectionCount; ++ix) {
+    if (NSNotFound == oldSectionToNew[ix]) {
+      [deletedSections addIndex:ix];
+    }
+  }
+  for (NSUInteger ix = 0; ix < newSectionCount; ++ix) {
+    if (NSNotFound == newSectionToOld[ix]) {
+      [insertedSections addIndex:ix];
+    }
+  }
+  NSMutableArray* movedFromSections = [NSMutableArray array];
+  NSMutableArray* movedToSections = [NSMutableArray array];
+  for (NSUInteger ix = 0; ix < oldSectionCount; ++ix) {
+    NSUInteger newIndex = oldSectionToNew[ix];
+    if (NSNotFound != newIndex
+        && (ix - [deletedSections countOfIndexesInRange:NSMakeRange(0, ix)]
+            != newIndex - [insertedSections countOfIndexesInRange:NSMakeRange(0, newIndex)])) {
+      [movedFromSections addObject:[NSNumber numberWithUnsignedInteger:ix]];
+      [movedToSections addObject:[NSNumber numberWithUnsignedInteger:newIndex]];
+    }
+  }
+
+  NSUInteger itemIndex = 0;
+  for (NSUInteger sectionIndex = 0; sectionIndex < oldSectionCount; ++sectionIndex) {
+    NSUInteger rowCount = [[[fromSections objectAtIndex:sectionIndex] rows] count];
+    for (NSUInteger row = 0; row < rowCount; ++row, ++itemIndex) {
+      oldSectionOfItem[itemIndex] = sectionIndex;
+      oldRowOfItem[itemIndex] = row;
+    }
+  }
+  itemIndex = 0;
+  for (NSUInteger sectionIndex = 0; sectionIndex < newSectionCount; ++sectionIndex) {
+    NSUInteger rowCount = [[[toSections objectAtIndex:sectionIndex] rows] count];
+    for (NSUInteger row = 0; row < rowCount; ++row, ++itemIndex) {
+      newSectionOfItem[itemIndex] = sectionIndex;
+      newRowOfItem[itemIndex] = row;
+    }
+  }
+
+  NIMatchItems(oldItems, newItems, oldToNew, newToOld);
+
+  NSMutableArray* deletedIndexPaths = [NSMutableArray array];
+  NSMutableArray* insertedIndexPaths = [NSMutableArray array];
+  NSMutableArray* movedFromIndexPaths = [NSMutableArray array];
+  NSMutableArray* movedToIndexPaths = [NSMutableArray array];
+  NSMutableArray* reloadedIndexPaths = [NSMutableArray array];
+
+  // Rows of deleted and inserted sections come and go with their sections. A row can't move into
+  // an inserted section or out of a deleted one, so it is deleted and inserted instead.
+  for (NSUInteger ix = 0; ix < oldItemCount; ++ix) {
+    oldItemLeaves[ix] = NO;
+    if (NSNotFound == oldSectionToNew[oldSectionOfItem[ix]]) {
+      continue;
+    }
+    NSUInteger newIndex = oldToNew[ix];
+    if (NSNotFound == newIndex || NSNotFound == newSectionToOld[newSectionOfItem[newIndex]]) {
+      [deletedIndexPaths addObject:NIModelDiffIndexPath(oldSectionOfItem[ix], oldRowOfItem[ix])];
+      oldItemLeaves[ix] = YES;
+
+    } else if (oldSectionToNew[oldSectionOfItem[ix]] != newSectionOfItem[newIndex]) {
+      oldItemLeaves[ix] = YES;
+    }
+  }
+  for (NSUInteger ix = 0; ix < newItemCount; ++ix) {
+    newItemArrives[ix] = NO;
+    if (NSNotFound == newSectionToOld[newSectionOfItem[ix]]) {
+      continue;
+    }
+    NSUInteger oldIndex = newToOld[ix];
+    if (NSNotFound == oldIndex || NSNotFound == oldSectionToNew[oldSectionOfItem[oldIndex]]) {
+      [insertedIndexPaths addObject:NIModelDiffIndexPath(newSectionOfItem[ix], newRowOfItem[ix])];
+      newItemArrives[ix] = YES;
+
+    } else if (newSectionToOld[newSectionOfItem[ix]] != oldSectionOfItem[oldIndex]) {
+      newItemArrives[ix] = YES;
+    }
+  }
+
+  for (NSUInteger ix = 0; ix < oldSectionCount; ++ix) {
+    oldSectionLeaving[ix] = 0;
+  }
+  for (NSUInteger ix = 0; ix < newSectionCount; ++ix) {
+    newSectionArriving[ix] = 0;
+  }
+  for (NSUInteger ix = 0; ix < oldItemCount; ++ix) {
+    oldShiftedRowOfItem[ix] = oldRowOfItem[ix] - oldSectionLeaving[oldSectionOfItem[ix]];
+    oldSectionLeaving[oldSectionOfItem[ix]] += oldItemLeaves[ix];
+  }
+  for (NSUInteger ix = 0; ix < newItemCount; ++ix) {
+    newShiftedRowOfItem[ix] = newRowOfItem[ix] - newSectionArriving[newSectionOfItem[ix]];
+    newSectionArriving[newSectionOfItem[ix]] += newItemArrives[ix];
+  }
+
+  for (NSUInteger ix = 0; ix < oldItemCount; ++ix) {
+    NSUInteger newIndex = oldToNew[ix];
+    if (NSNotFound == newIndex
+        || NSNotFound == oldSectionToNew[oldSectionOfItem[ix]]
+        || NSNotFound == newSectionToOld[newSectionOfItem[newIndex]]) {
+      continue;
+    }
+    NSIndexPath* fromIndexPath = NIModelDiffIndexPath(oldSectionOfItem[ix], oldRowOfItem[ix]);
+    NSIndexPath* toIndexPath = NIModelDiffIndexPath(newSectionOfItem[newIndex], newRowOfItem[newIndex]);
+    BOOL isIdentical = ([oldItems objectAtIndex:ix] == [newItems objectAtIndex:newIndex]);
+    BOOL isMoved = (oldItemLeaves[ix] || oldShiftedRowOfItem[ix] != newShiftedRowOfItem[newIndex]);
+
+    if (!isMoved) {
+      if (!isIdentical) {
+        [reloadedIndexPaths addObject:fromIndexPath];
+      }
+
+    } else if (isIdentical) {
+      [movedFromIndexPaths addObject:fromIndexPath];
+      [movedToIndexPaths addObject:toIndexPath];
+
+    } else {
+      // Neither UITableView nor UICollectionView can reload a row that they are also moving.
+      [deletedIndexPaths addObject:fromIndexPath];
+      [insertedIndexPaths addObject:toIndexPath];
+    }
+  }
+
+  free(indexes);
+
+  diff->_deletedSections = [deletedSections copy];
+  diff->_insertedSections = [insertedSections copy];
+  diff->_movedFromSections = [movedFromSections copy];
+  diff->_movedToSections = [movedToSections copy];
+  diff->_deletedIndexPaths = [deletedIndexPaths copy];
+  diff->_insertedIndexPaths = [insertedIndexPaths copy];
+  diff->_movedFromIndexPaths = [movedFromIndexPaths copy];
+  diff->_movedToIndexPaths = [movedToIndexPaths copy];
+  diff->_reloadedIndexPaths = [reloadedIndexPaths copy];
+  NI_SIGNPOST_END(NISignpostCategoryModels, "Diff", diff);
+  return diff;
+}
+
+- (BOOL)hasChanges {
+  return (_deletedSections.count > 0 || _insertedSections.count > 0 || _movedFromSections.count > 0
+          || _deletedIndexPaths.count > 0 || _insertedIndexPaths.count > 0
+          || _movedFromIndexPaths.count > 0 || _reloadedIndexPaths.count > 0);
+}
+
+- (BOOL)isDiffFromSections:(NSArray *)sections {
+  if (sections.count != _fromSectionTitles.count) {
+    return NO;
+  }
+  NSUInteger sectionIndex = 0;
+  for (id<NIModelDiffSection> section in sections) {
+    if (![[_fromSectionTitles objectAtIndex:sectionIndex] isEqual:section.headerTitle ?: [NSNull null]]
+        || [[_fromSectionRowCounts objectAtIndex:sectionIndex] unsignedIntegerValue] != section.rows.count) {
+      return NO;
+    }
+    ++sectionIndex;
+  }
+  return YES;
+}
+
+@end
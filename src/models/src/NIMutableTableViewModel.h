@@ -17,6 +17,7 @@
 #import "NITableViewModel.h"
 
 @class NIMutableTableViewModel;
+@class NITableViewModelDiff;
 
 /**
  * A protocol for NIMutableTableViewModel to handle editing states for objects.
@@ -132,6 +133,11 @@ NSIndexSet* indexSet = [self.model addSectionWithTitle:@"New section"];
 - (NSIndexSet *)insertSectionWithTitle:(NSString *)title atIndex:(NSUInteger)index;
 - (NSIndexSet *)removeSectionAtIndex:(NSUInteger)index;
 
+- (NITableViewModelDiff *)setSectionedArray:(NSArray *)sectionedArray diffingWithTableView:(UITableView *)tableView;
+- (void)applyDiff:(NITableViewModelDiff *)diff withTableView:(UITableView *)tableView;
+
+- (NITableViewModelDiff *)performBatchUpdates:(void (^)(NIMutableTableViewModel* model))updates;
+
 - (void)updateSectionIndex;
 
 @property (nonatomic, weak) id<NIMutableTableViewModelDelegate> delegate;
@@ -224,12 +230,75 @@ NSIndexSet* indexSet = [self.model addSectionWithTitle:@"New section"];
  * @fn NIMutableTableViewModel::removeSectionAtIndex:
  */
 
+/** @name Replacing the Contents */
+
+/**
+ * Replaces the model's contents and animates the difference in the table view.
+ *
+ * Rows that are in both the old and the new contents keep their cells and the table keeps its
+ * scroll position. All of the changes are applied in a single batch update.
+ *
+ * @param sectionedArray The new contents, in the format of
+ *                            NITableViewModel::initWithSectionedArray:delegate:.
+ * @param tableView      The table view that displays this model.
+ * @returns The changes that were applied to the table view.
+ * @fn NIMutableTableViewModel::setSectionedArray:diffingWithTableView:
+ * @sa NITableViewModelDiff
+ */
+
+/**
+ * Replaces the model's contents with the new contents of a diff and applies the diff to the
+ * table view.
+ *
+ * Use this to compute the diff of a very large model off the main thread:
+ *
+@code
+dispatch_async(queue, ^{
+  NITableViewModelDiff* diff = [NITableViewModelDiff diffFromSectionedArray:oldContents
+                                                           toSectionedArray:newContents];
+  dispatch_async(dispatch_get_main_queue(), ^{
+    [model applyDiff:diff withTableView:tableView];
+  });
+});
+@endcode
+ *
+ * The diff must start from the model's current contents. If the model has changed since, the new
+ * contents are still adopted but the table view is reloaded instead.
+ *
+ * @fn NIMutableTableViewModel::applyDiff:withTableView:
+ */
+
+/** @name Batching Modifications */
+
+/**
+ * Performs many modifications as one and returns their combined effect.
+ *
+ * The object index and the section index are brought up to date once, after the block returns,
+ * instead of after each modification; calls to updateSectionIndex within the block are deferred
+ * until then. The index paths returned by the individual methods within the block are only valid
+ * at the time of the call and may be ignored. Instead, apply the returned diff to the table view:
+ *
+@code
+NITableViewModelDiff* diff = [self.model performBatchUpdates:^(NIMutableTableViewModel* model) {
+  [model addObjectsFromArray:page];
+  [model updateSectionIndex];
+}];
+[diff applyToTableView:self.tableView withRowAnimation:UITableViewRowAnimationAutomatic];
+@endcode
+ *
+ * Batches may be nested. Only the outermost batch returns a diff; the inner ones return nil and
+ * their changes are included in the outer diff.
+ *
+ * @fn NIMutableTableViewModel::performBatchUpdates:
+ */
+
 /** @name Updating the Section Index */
 
 /**
  * Updates the section index with the current section index settings.
  *
  * This method should be called after modifying the model if a section index is being used.
+ * Within performBatchUpdates: the update happens once, when the batch ends.
  *
  * @fn NIMutableTableViewModel::updateSectionIndex
  */
@@ -21,6 +21,12 @@
 #import "NimbusCore.h"
 
 
+@interface NIMutableTableViewModel ()
+@property (nonatomic, assign) NSInteger batchUpdateDepth;
+@property (nonatomic, assign) BOOL needsSectionIndexUpdate;
+@end
+
+
 @implementation NIMutableTableViewModel
 
 
@@ -31,16 +37,22 @@
 - (NSArray *)addObject:(id)object {
   NITableViewModelSection* section = self.sections.count == 0 ? [self _appendSection] : self.sections.lastObject;
   [section.mutableRows addObject:object];
-  return [NSArray arrayWithObject:[NSIndexPath indexPathForRow:section.mutableRows.count - 1
-                                                     inSection:self.sections.count - 1]];
+  NSIndexPath* indexPath = [NSIndexPath indexPathForRow:section.mutableRows.count - 1
+                                              inSection:self.sections.count - 1];
+  [self _indexObject:object atIndexPath:indexPath];
+  ++self.mutationCount;
+  return [NSArray arrayWithObject:indexPath];
 }
 
 - (NSArray *)addObject:(id)object toSection:(NSUInteger)sectionIndex {
   NIDASSERT(sectionIndex >= 0 && sectionIndex < self.sections.count);
   NITableViewModelSection *section = [self.sections objectAtIndex:sectionIndex];
   [section.mutableRows addObject:object];
-  return [NSArray arrayWithObject:[NSIndexPath indexPathForRow:section.mutableRows.count - 1
-                                                     inSection:sectionIndex]];
+  NSIndexPath* indexPath = [NSIndexPath indexPathForRow:section.mutableRows.count - 1
+                                              inSection:sectionIndex];
+  [self _indexObject:object atIndexPath:indexPath];
+  ++self.mutationCount;
+  return [NSArray arrayWithObject:indexPath];
 }
 
 - (NSArray *)addObjectsFromArray:(NSArray *)array {
@@ -55,7 +67,11 @@
   NIDASSERT(sectionIndex >= 0 && sectionIndex < self.sections.count);
   NITableViewModelSection *section = [self.sections objectAtIndex:sectionIndex];
   [section.mutableRows insertObject:object atIndex:row];
-  return [NSArray arrayWithObject:[NSIndexPath indexPathForRow:row inSection:sectionIndex]];
+  [self _offsetIndexedRowsInSection:sectionIndex fromRow:row + 1 sectionDelta:0 rowDelta:1];
+  NSIndexPath* indexPath = [NSIndexPath indexPathForRow:row inSection:sectionIndex];
+  [self _indexObject:object atIndexPath:indexPath];
+  ++self.mutationCount;
+  return [NSArray arrayWithObject:indexPath];
 }
 
 - (NSArray *)removeObjectAtIndexPath:(NSIndexPath *)indexPath {
@@ -68,29 +84,117 @@
   if (indexPath.row >= (NSInteger)section.mutableRows.count) {
     return nil;
   }
+  id object = [section.mutableRows objectAtIndex:indexPath.row];
+  [self _unindexObject:object atIndexPath:indexPath];
   [section.mutableRows removeObjectAtIndex:indexPath.row];
+  [self _offsetIndexedRowsInSection:indexPath.section fromRow:indexPath.row sectionDelta:0 rowDelta:-1];
+  [self _reindexObjects:[NSArray arrayWithObject:object]];
+  ++self.mutationCount;
   return [NSArray arrayWithObject:indexPath];
 }
 
 - (NSIndexSet *)addSectionWithTitle:(NSString *)title {
   NITableViewModelSection* section = [self _appendSection];
   section.headerTitle = title;
+  [self _insertSectionIntoSectionIndexAtIndex:self.sections.count - 1];
+  ++self.mutationCount;
   return [NSIndexSet indexSetWithIndex:self.sections.count - 1];
 }
 
 - (NSIndexSet *)insertSectionWithTitle:(NSString *)title atIndex:(NSUInteger)index {
   NITableViewModelSection* section = [self _insertSectionAtIndex:index];
   section.headerTitle = title;
+  [self _insertSectionIntoSectionIndexAtIndex:index];
+  [self _offsetIndexedSectionsFromSection:index + 1 by:1];
+  ++self.mutationCount;
   return [NSIndexSet indexSetWithIndex:index];
 }
 
 - (NSIndexSet *)removeSectionAtIndex:(NSUInteger)index {
   NIDASSERT(index >= 0 && index < self.sections.count);
+  NSArray* rows = [[self.sections objectAtIndex:index] rows];
+  [rows enumerateObjectsUsingBlock:^(id object, NSUInteger rowIndex, BOOL *stop) {
+    [self _unindexObject:object atIndexPath:[NSIndexPath indexPathForRow:rowIndex inSection:index]];
+  }];
+  [self _removeSectionFromSectionIndexAtIndex:index title:[[self.sections objectAtIndex:index] headerTitle]];
   [self.sections removeObjectAtIndex:index];
+  [self _offsetIndexedSectionsFromSection:index by:-1];
+  [self _reindexObjects:rows];
+  ++self.mutationCount;
   return [NSIndexSet indexSetWithIndex:index];
 }
 
+- (NITableViewModelDiff *)setSectionedArray:(NSArray *)sectionedArray diffingWithTableView:(UITableView *)tableView {
+  NITableViewModelDiff* diff = [NITableViewModelDiff diffFromSections:self.sections
+                                                           toSections:[NITableViewModelDiff sectionsForSectionedArray:sectionedArray]];
+  [self applyDiff:diff withTableView:tableView];
+  return diff;
+}
+
+- (void)applyDiff:(NITableViewModelDiff *)diff withTableView:(UITableView *)tableView {
+  BOOL isDiffFromContents = [diff isDiffFromSections:self.sections];
+
+  // A diff may be applied to more than one model, so each gets its own mutable sections.
+  NSMutableArray* sections = [NSMutableArray arrayWithCapacity:diff.toSections.count];
+  for (NITableViewModelSection* diffSection in diff.toSections) {
+    NITableViewModelSection* section = [NITableViewModelSection section];
+    section.headerTitle = diffSection.headerTitle;
+    section.footerTitle = diffSection.footerTitle;
+    section.rows = (nil != diffSection.rows) ? [diffSection.rows mutableCopy] : [NSMutableArray array];
+    [sections addObject:section];
+  }
+  self.sections = sections;
+  self.sectionsForPrefix = nil;
+  [self _rebuildObjectIndex];
+  if (NITableViewModelSectionIndexNone != self.sectionIndexType) {
+    [self _compileSectionIndex];
+  }
+  ++self.mutationCount;
+
+  if (isDiffFromContents) {
+    [diff applyToTableView:tableView withRowAnimation:UITableViewRowAnimationAutomatic];
+  } else {
+    [tableView reloadData];
+  }
+}
+
+- (NITableViewModelDiff *)performBatchUpdates:(void (^)(NIMutableTableViewModel* model))updates {
+  if (self.batchUpdateDepth > 0) {
+    ++self.batchUpdateDepth;
+    updates(self);
+    --self.batchUpdateDepth;
+    return nil;
+  }
+
+  // The rows are modified in place, so the diff needs a copy of what they were.
+  NSMutableArray* fromSections = [NSMutableArray arrayWithCapacity:self.sections.count];
+  for (NITableViewModelSection* section in self.sections) {
+    NITableViewModelSection* fromSection = [NITableViewModelSection section];
+    fromSection.headerTitle = section.headerTitle;
+    fromSection.rows = [section.rows copy];
+    [fromSections addObject:fromSection];
+  }
+
+  // Without an object index the modifications skip keeping it up to date; it is rebuilt once below.
+  self.objectIndex = nil;
+  self.needsSectionIndexUpdate = NO;
+  self.batchUpdateDepth = 1;
+  updates(self);
+  self.batchUpdateDepth = 0;
+
+  [self _rebuildObjectIndex];
+  if (self.needsSectionIndexUpdate) {
+    self.needsSectionIndexUpdate = NO;
+    [self _compileSectionIndex];
+  }
+  return [NITableViewModelDiff diffFromSections:fromSections toSections:self.sections];
+}
+
 - (void)updateSectionIndex {
+  if (self.batchUpdateDepth > 0) {
+    self.needsSectionIndexUpdate = YES;
+    return;
+  }
   [self _compileSectionIndex];
 }
 
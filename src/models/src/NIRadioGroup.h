@@ -39,6 +39,11 @@
  * select. The radio group delegate is notified immediately when a selection is made and the
  * tapped cell is also updated to reflect the new selection.
  *
+ * When the selection changes, only the previously checked cell and the newly checked cell have
+ * their accessories updated; no rows are reloaded. The previous cell is found with the model's
+ * indexPathForObject:, so set the model's objectIndexType to make that a single lookup in long
+ * tables.
+ *
  * @ingroup ModelTools
  */
 @interface NIRadioGroup : NSObject <NICellObject, UITableViewDelegate>
@@ -216,6 +216,22 @@ static const NSInteger kInvalidSelection = NSIntegerMin;
   return [self.objectOrder copy];
 }
 
+#pragma mark - Cell Updates
+
+
+// indexPathForObject: is a single lookup when the model maintains an object index.
+- (void)updateAccessoryOfCellAtIndexPath:(NSIndexPath *)indexPath inTableView:(UITableView *)tableView withObject:(id)object {
+  if (nil == indexPath) {
+    return;
+  }
+  UITableViewCell* cell = [tableView cellForRowAtIndexPath:indexPath];
+  if (nil != cell) {
+    cell.accessoryType = ([self isObjectSelected:object]
+                          ? UITableViewCellAccessoryCheckmark
+                          : UITableViewCellAccessoryNone);
+  }
+}
+
 #pragma mark - UITableViewDelegate
 
 
@@ -267,19 +283,20 @@ static const NSInteger kInvalidSelection = NSIntegerMin;
       NSInteger newSelection = [self identifierForObject:object];
 
       if (newSelection != self.selectedIdentifier) {
+        id previousObject = (self.hasSelection
+                             ? [self.objectMap objectForKey:[self keyForIdentifier:self.selectedIdentifier]]
+                             : nil);
         [self setSelectedIdentifier:newSelection];
 
-        // It's easiest to simply reload the visible table cells. Reloading only the radio group
-        // cells would require iterating through the visible cell objects and determining whether
-        // each was in the radio group. This is more complex behavior that should be relegated to
-        // the controller.
-        [tableView reloadRowsAtIndexPaths:tableView.indexPathsForVisibleRows
-                         withRowAnimation:UITableViewRowAnimationNone];
-
-        // After we reload the table view the selection will be lost, so set the selection again.
-        [tableView selectRowAtIndexPath:indexPath
-                               animated:NO
-                         scrollPosition:UITableViewScrollPositionNone];
+        // Only the previously checked cell and the tapped cell change, so update their accessories
+        // in place rather than reloading rows. Cells that are offscreen are updated in
+        // willDisplayCell: when they next appear.
+        [self updateAccessoryOfCellAtIndexPath:indexPath inTableView:tableView withObject:object];
+        if (nil != previousObject) {
+          [self updateAccessoryOfCellAtIndexPath:[model indexPathForObject:previousObject]
+                                     inTableView:tableView
+                                      withObject:previousObject];
+        }
 
         [self.delegate radioGroup:self didSelectIdentifier:newSelection];
       }
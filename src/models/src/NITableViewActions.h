@@ -72,6 +72,10 @@ tableView.delegate = [self.actions forwardingTo:self];
  * This method allows you to insert the actions into the call chain for the table view's
  * delegate methods.
  *
+ * Methods that the actions don't implement, such as tableView:heightForRowAtIndexPath:, are
+ * sent straight to the first forward delegate that implements them. Which delegate that is gets
+ * worked out whenever a delegate is added or removed, not on every call.
+ *
  * Example:
  *
 @code
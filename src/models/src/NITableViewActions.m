@@ -20,7 +20,6 @@
 #import "NITableViewModel.h"
 #import "NimbusCore.h"
 #import "NIActions+Subclassing.h"
-#import <objc/runtime.h>
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "Nimbus requires ARC support."
@@ -28,6 +27,7 @@
 
 @interface NITableViewActions()
 @property (nonatomic, strong) NSMutableSet* forwardDelegates;
+@property (nonatomic, strong) NIForwardingTable* forwardingTable; // Rebuilt when forwardDelegates changes.
 @end
 
 @implementation NITableViewActions
@@ -45,63 +45,34 @@
 #pragma mark - Forward Invocations
 
 
-- (BOOL)shouldForwardSelector:(SEL)selector {
-  struct objc_method_description description;
-  description = protocol_getMethodDescription(@protocol(UITableViewDelegate), selector, NO, YES);
-  return (description.name != NULL && description.types != NULL);
-}
-
 - (BOOL)respondsToSelector:(SEL)selector {
   if ([super respondsToSelector:selector]) {
     return YES;
-    
-  } else if ([self shouldForwardSelector:selector]) {
-    for (id delegate in self.forwardDelegates) {
-      if ([delegate respondsToSelector:selector]) {
-        return YES;
-      }
-    }
   }
-  return NO;
+  return (nil != [self.forwardingTable delegateForSelector:selector]);
 }
 
-- (NSMethodSignature *)methodSignatureForSelector:(SEL)selector {
-  NSMethodSignature *signature = [super methodSignatureForSelector:selector];
-  if (signature == nil) {
-    for (id delegate in self.forwardDelegates) {
-      if ([delegate respondsToSelector:selector]) {
-        signature = [delegate methodSignatureForSelector:selector];
-      }
-    }
-  }
-  return signature;
+- (id)forwardingTargetForSelector:(SEL)selector {
+  // Every forwarded method goes to the first delegate that implements it, so it's sent straight
+  // to that delegate rather than through an invocation.
+  id delegate = [self.forwardingTable delegateForSelector:selector];
+  return (nil != delegate) ? delegate : [super forwardingTargetForSelector:selector];
 }
 
-- (void)forwardInvocation:(NSInvocation *)invocation {
-  BOOL didForward = NO;
-  
-  if ([self shouldForwardSelector:invocation.selector]) {
-    for (id delegate in self.forwardDelegates) {
-      if ([delegate respondsToSelector:invocation.selector]) {
-        [invocation invokeWithTarget:delegate];
-        didForward = YES;
-        break;
-      }
-    }
-  }
-  
-  if (!didForward) {
-    [super forwardInvocation:invocation];
-  }
+- (void)forwardDelegatesDidChange {
+  self.forwardingTable = [[NIForwardingTable alloc] initWithProtocol:@protocol(UITableViewDelegate)
+                                                          delegates:self.forwardDelegates];
 }
 
 - (id<UITableViewDelegate>)forwardingTo:(id<UITableViewDelegate>)forwardDelegate {
   [self.forwardDelegates addObject:forwardDelegate];
+  [self forwardDelegatesDidChange];
   return self;
 }
 
 - (void)removeForwarding:(id<UITableViewDelegate>)forwardDelegate {
   [self.forwardDelegates removeObject:forwardDelegate];
+  [self forwardDelegatesDidChange];
 }
 
 #pragma mark - Object State
@@ -16,20 +16,60 @@
 
 #import <Foundation/Foundation.h>
 
+#import "NITableViewModelDiff.h"
+#import "NIModelDiff.h"
+
 @interface NITableViewModel()
 
 @property (nonatomic, strong) NSArray* sections; // Array of NITableViewModelSection
 @property (nonatomic, strong) NSArray* sectionIndexTitles;
 @property (nonatomic, strong) NSDictionary* sectionPrefixToSectionIndex;
+// Object => NSIndexPath of its first row. An NIPointerMap for identity indexes, otherwise an
+// NSMapTable; both respond to objectForKey:, setObject:forKey: and removeObjectForKey:.
+@property (nonatomic, strong) id objectIndex;
+@property (nonatomic, assign) BOOL objectIndexHasDuplicates;
+@property (nonatomic, assign) NSUInteger mutationCount; // Incremented by every change to a mutable model
+@property (nonatomic, strong) NSMutableDictionary* sectionsForPrefix; // Title prefix => NSMutableIndexSet of sections
+@property (nonatomic, strong) NIPrefetchWindow* prefetchWindow; // Created on first use
 
 - (void)_resetCompiledData;
 - (void)_compileDataWithListArray:(NSArray *)listArray;
 - (void)_compileDataWithSectionedArray:(NSArray *)sectionedArray;
 - (void)_compileSectionIndex;
 
+// Keeping sectionsForPrefix up to date as sections are inserted and removed.
+- (void)_insertSectionIntoSectionIndexAtIndex:(NSUInteger)index;
+- (void)_removeSectionFromSectionIndexAtIndex:(NSUInteger)index title:(NSString *)title;
+
+// Finds the object without the object index.
+- (NSIndexPath *)_scanIndexPathForObject:(id)object;
+
+// Keeping the object index up to date. Each does nothing without an objectIndexType.
+- (void)_rebuildObjectIndex;
+- (void)_indexObject:(id)object atIndexPath:(NSIndexPath *)indexPath;
+- (void)_unindexObject:(id)object atIndexPath:(NSIndexPath *)indexPath;
+- (void)_reindexObjects:(NSArray *)objects;
+- (void)_offsetIndexedRowsInSection:(NSUInteger)sectionIndex fromRow:(NSUInteger)row
+                       sectionDelta:(NSInteger)sectionDelta rowDelta:(NSInteger)rowDelta;
+- (void)_offsetIndexedSectionsFromSection:(NSUInteger)sectionIndex by:(NSInteger)delta;
+
+@end
+
+@interface NITableViewModelDiff ()
+
++ (NSArray *)sectionsForSectionedArray:(NSArray *)sectionedArray;
++ (NITableViewModelDiff *)diffFromSections:(NSArray *)fromSections toSections:(NSArray *)toSections;
+
+@property (nonatomic, readonly, strong) NSArray* toSections; // Array of NITableViewModelSection
+@property (nonatomic, readonly, copy) NSArray* fromSectionTitles; // NSString or NSNull
+@property (nonatomic, readonly, copy) NSArray* fromSectionRowCounts; // NSNumber
+
+// Whether the diff was computed from sections with the same titles and numbers of rows.
+- (BOOL)isDiffFromSections:(NSArray *)sections;
+
 @end
 
-@interface NITableViewModelSection : NSObject
+@interface NITableViewModelSection : NSObject <NIModelDiffSection>
 
 + (id)section;
 
@@ -24,6 +24,7 @@ typedef UITableViewCell* (^NITableViewModelCellForIndexPathBlock)(UITableView* t
 #endif // #if NS_BLOCKS_AVAILABLE
 
 @protocol NITableViewModelDelegate;
+@class NIPrefetchWindow;
 
 
 #pragma mark Sectioned Array Objects
@@ -37,6 +38,12 @@ typedef enum {
   NITableViewModelSectionIndexAlphabetical, // Generates an alphabetical section index.
 } NITableViewModelSectionIndex;
 
+typedef enum {
+  NITableViewModelObjectIndexNone, // indexPathForObject: compares every row with isEqual:.
+  NITableViewModelObjectIndexEquality, // Rows are indexed by hash and isEqual:.
+  NITableViewModelObjectIndexIdentity, // Rows are indexed by pointer.
+} NITableViewModelObjectIndex;
+
 /**
  * A non-mutable table view model that complies to the UITableViewDataSource protocol.
  *
@@ -58,13 +65,24 @@ typedef enum {
 // Each NSString in the array starts a new section. Any other object is a new row (with exception of certain model-specific objects).
 - (id)initWithSectionedArray:(NSArray *)sectionedArray delegate:(id<NITableViewModelDelegate>)delegate;
 
+#if NS_BLOCKS_AVAILABLE
+// Collates the objects into alphabetical sections on a background queue.
++ (void)modelWithCollatedObjects:(NSArray *)objects
+         collationStringSelector:(SEL)selector
+                        delegate:(id<NITableViewModelDelegate>)delegate
+                      completion:(void (^)(id model))completion;
+#endif // #if NS_BLOCKS_AVAILABLE
+
 #pragma mark Accessing Objects
 
 - (id)objectAtIndexPath:(NSIndexPath *)indexPath;
 
-// This method is not appropriate for performance critical codepaths.
+// Scans the model unless objectIndexType is set.
 - (NSIndexPath *)indexPathForObject:(id)object;
 
+// Immediately indexes every row.
+@property (nonatomic, assign) NITableViewModelObjectIndex objectIndexType; // Default: NITableViewModelObjectIndexNone
+
 #pragma mark Configuration
 
 // Immediately compiles the section index.
@@ -84,6 +102,13 @@ typedef enum {
 @property (nonatomic, copy) NITableViewModelCellForIndexPathBlock createCellBlock;
 #endif // #if NS_BLOCKS_AVAILABLE
 
+#pragma mark Prefetching
+
+// Call from the table view delegate's scrollViewDidScroll:.
+- (void)prefetchObjectsForTableView:(UITableView *)tableView;
+
+@property (nonatomic, readonly, strong) NIPrefetchWindow* prefetchWindow;
+
 @end
 
 /**
@@ -186,6 +211,39 @@ typedef enum {
  */
 
 
+#if NS_BLOCKS_AVAILABLE
+
+/**
+ * Creates a model from objects in no particular order, grouped into sections by the current
+ * UILocalizedIndexedCollation and with an alphabetical section index.
+ *
+ * Sorting and grouping a long list is the slow part of showing it with a section index, so it
+ * runs on a background queue. The model is created there too and handed to the completion block
+ * on the main queue, ready to be given to the table view.
+ *
+ * Call this from the main thread. NSStrings start sections in a sectioned array, so the objects
+ * should be cell objects such as NITitleCellObject rather than strings.
+ *
+@code
+[NITableViewModel modelWithCollatedObjects:contacts
+                   collationStringSelector:@selector(title)
+                                  delegate:(id)[NICellFactory class]
+                                completion:^(NITableViewModel* model) {
+  self.model = model;
+  self.tableView.dataSource = model;
+  [self.tableView reloadData];
+}];
+@endcode
+ *
+ * @fn NITableViewModel::modelWithCollatedObjects:collationStringSelector:delegate:completion:
+ * @param objects     The rows of the model.
+ * @param selector    A selector returning the NSString each object is collated by.
+ * @param delegate    The delegate of the new model.
+ * @param completion  Called on the main queue with a new instance of the receiving class.
+ */
+
+#endif // #if NS_BLOCKS_AVAILABLE
+
 /** @name Accessing Objects */
 
 /**
@@ -200,17 +258,38 @@ typedef enum {
 /**
  * Returns the index path of the given object within the model.
  *
- * If the model does not contain the object then nil will be returned.
+ * If the model does not contain the object then nil will be returned. If it contains the object
+ * more than once then the first index path is returned.
+ *
+ * This scans every row unless NITableViewModel::objectIndexType is set, in which case it is a
+ * single lookup.
  *
  * @fn NITableViewModel::indexPathForObject:
  */
 
+/**
+ * How indexPathForObject: finds objects.
+ *
+ * Setting an index type builds a map from each row to its index path, which
+ * NIMutableTableViewModel keeps up to date as objects and sections are added and removed. Use
+ * NITableViewModelObjectIndexIdentity when callers always pass the objects that were added to
+ * the model; it doesn't call hash or isEqual: at all. NITableViewModelObjectIndexEquality finds
+ * equal objects, as the scan does, and requires objects whose hash doesn't change while they are
+ * in the model.
+ *
+ * NITableViewModelObjectIndexNone by default.
+ *
+ * @fn NITableViewModel::objectIndexType
+ */
+
 /** @name Configuration */
 
 /**
  * Configures the model's section index properties.
  *
  * Calling this method will compile the section index depending on the index type chosen.
+ * NIMutableTableViewModel keeps track of the sections' titles as sections are added and
+ * removed, so recompiling an alphabetical index after a change doesn't walk every section again.
  *
  * @param sectionIndexType The type of section index to display.
  * @param showsSearch      Whether or not to show the search icon at the top of the index.
@@ -262,3 +341,30 @@ typedef enum {
  */
 
 #endif // #if NS_BLOCKS_AVAILABLE
+
+/** @name Prefetching */
+
+/**
+ * Prepares the objects of the rows that are about to scroll on screen.
+ *
+ * Objects that conform to NIPrefetchingObject are sent prepareForDisplayInBackground on a
+ * background queue once their row enters the look-ahead window, so that images or text layout
+ * are ready by the time tableView:cellForRowAtIndexPath: is called. The window grows with the
+ * scroll velocity. Call this from scrollViewDidScroll::
+ *
+@code
+- (void)scrollViewDidScroll:(UIScrollView *)scrollView {
+  [self.model prefetchObjectsForTableView:self.tableView];
+}
+@endcode
+ *
+ * @fn NITableViewModel::prefetchObjectsForTableView:
+ */
+
+/**
+ * The look-ahead window used by prefetchObjectsForTableView:.
+ *
+ * Use this to tune how far ahead objects are prepared.
+ *
+ * @fn NITableViewModel::prefetchWindow
+ */
@@ -24,6 +24,10 @@
 #error "Nimbus requires ARC support."
 #endif
 
+static NSString* NISectionIndexPrefixForTitle(NSString* title) {
+  return ([title length] > 0) ? [title substringToIndex:1] : nil;
+}
+
 @implementation NITableViewModel
 
 #if NS_BLOCKS_AVAILABLE
@@ -68,6 +72,9 @@
   self.sections = nil;
   self.sectionIndexTitles = nil;
   self.sectionPrefixToSectionIndex = nil;
+  [self.objectIndex removeAllObjects];
+  self.objectIndexHasDuplicates = NO;
+  self.sectionsForPrefix = nil;
 }
 
 - (void)_compileDataWithListArray:(NSArray *)listArray {
@@ -78,6 +85,7 @@
     section.rows = listArray;
     self.sections = [NSArray arrayWithObject:section];
   }
+  [self _rebuildObjectIndex];
 }
 
 - (void)_compileDataWithSectionedArray:(NSArray *)sectionedArray {
@@ -139,10 +147,68 @@
 
   // Update the compiled information for this data source.
   self.sections = sections;
+  [self _rebuildObjectIndex];
+}
+
+- (void)_rebuildSectionsForPrefix {
+  NSMutableDictionary* sectionsForPrefix = [NSMutableDictionary dictionary];
+  NSUInteger sectionIndex = 0;
+  for (NITableViewModelSection* section in _sections) {
+    NSString* prefix = NISectionIndexPrefixForTitle(section.headerTitle);
+    if (nil != prefix) {
+      NSMutableIndexSet* sections = [sectionsForPrefix objectForKey:prefix];
+      if (nil == sections) {
+        sections = [NSMutableIndexSet indexSet];
+        [sectionsForPrefix setObject:sections forKey:prefix];
+      }
+      [sections addIndex:sectionIndex];
+    }
+    ++sectionIndex;
+  }
+  self.sectionsForPrefix = sectionsForPrefix;
+}
+
+- (void)_insertSectionIntoSectionIndexAtIndex:(NSUInteger)index {
+  if (nil == self.sectionsForPrefix) {
+    return;
+  }
+  // Each prefix's index set shifts its ranges, so this doesn't walk the sections.
+  for (NSMutableIndexSet* sections in [self.sectionsForPrefix objectEnumerator]) {
+    [sections shiftIndexesStartingAtIndex:index by:1];
+  }
+  NSString* prefix = NISectionIndexPrefixForTitle([[_sections objectAtIndex:index] headerTitle]);
+  if (nil != prefix) {
+    NSMutableIndexSet* sections = [self.sectionsForPrefix objectForKey:prefix];
+    if (nil == sections) {
+      sections = [NSMutableIndexSet indexSet];
+      [self.sectionsForPrefix setObject:sections forKey:prefix];
+    }
+    [sections addIndex:index];
+  }
+}
+
+- (void)_removeSectionFromSectionIndexAtIndex:(NSUInteger)index title:(NSString *)title {
+  if (nil == self.sectionsForPrefix) {
+    return;
+  }
+  NSString* prefix = NISectionIndexPrefixForTitle(title);
+  if (nil != prefix) {
+    NSMutableIndexSet* sections = [self.sectionsForPrefix objectForKey:prefix];
+    [sections removeIndex:index];
+    if (0 == sections.count) {
+      [self.sectionsForPrefix removeObjectForKey:prefix];
+    }
+  }
+  for (NSMutableIndexSet* sections in [self.sectionsForPrefix objectEnumerator]) {
+    [sections shiftIndexesStartingAtIndex:index + 1 by:-1];
+  }
 }
 
 - (void)_compileSectionIndex {
   _sectionIndexTitles = nil;
+  if (nil == self.sectionsForPrefix) {
+    [self _rebuildSectionsForPrefix];
+  }
 
   // Prime the section index and the map
   NSMutableArray* titles = nil;
@@ -161,9 +227,8 @@
   // sections are ordered (this may not be alphabetical).
   if (NITableViewModelSectionIndexDynamic == _sectionIndexType) {
     for (NITableViewModelSection* section in _sections) {
-      NSString* headerTitle = section.headerTitle;
-      if ([headerTitle length] > 0) {
-        NSString* prefix = [headerTitle substringToIndex:1];
+      NSString* prefix = NISectionIndexPrefixForTitle(section.headerTitle);
+      if (nil != prefix) {
         [titles addObject:prefix];
       }
     }
@@ -193,17 +258,9 @@
   if (NITableViewModelSectionIndexNone != _sectionIndexType) {
 
     // Map all of the sections to indices.
-    NSInteger sectionIndex = 0;
-    for (NITableViewModelSection* section in _sections) {
-      NSString* headerTitle = section.headerTitle;
-      if ([headerTitle length] > 0) {
-        NSString* prefix = [headerTitle substringToIndex:1];
-        if (nil == [sectionPrefixToSectionIndex objectForKey:prefix]) {
-          [sectionPrefixToSectionIndex setObject:[NSNumber numberWithInteger:sectionIndex] forKey:prefix];
-        }
-      }
-      ++sectionIndex;
-    }
+    [self.sectionsForPrefix enumerateKeysAndObjectsUsingBlock:^(NSString* prefix, NSIndexSet* sections, BOOL *stop) {
+      [sectionPrefixToSectionIndex setObject:[NSNumber numberWithInteger:[sections firstIndex]] forKey:prefix];
+    }];
 
     // Map the unmapped section titles to the next closest earlier section.
     NSInteger lastIndex = 0;
@@ -222,6 +279,123 @@
   self.sectionPrefixToSectionIndex = sectionPrefixToSectionIndex;
 }
 
+#pragma mark - Object Index
+
+
+- (NSIndexPath *)_scanIndexPathForObject:(id)object {
+  BOOL matchesIdentity = (NITableViewModelObjectIndexIdentity == _objectIndexType);
+  NSArray *sections = self.sections;
+  for (NSUInteger sectionIndex = 0; sectionIndex < [sections count]; sectionIndex++) {
+    NSArray* rows = [[sections objectAtIndex:sectionIndex] rows];
+    NSUInteger rowIndex = (matchesIdentity
+                           ? [rows indexOfObjectIdenticalTo:object]
+                           : [rows indexOfObject:object]);
+    if (NSNotFound != rowIndex) {
+      return [NSIndexPath indexPathForRow:rowIndex inSection:sectionIndex];
+    }
+  }
+  return nil;
+}
+
+- (void)_rebuildObjectIndex {
+  self.objectIndexHasDuplicates = NO;
+  if (NITableViewModelObjectIndexNone == _objectIndexType) {
+    self.objectIndex = nil;
+    return;
+  }
+
+  if (NITableViewModelObjectIndexIdentity == _objectIndexType) {
+    // Identity lookups hash the pointer directly instead of sending hash and isEqual:.
+    self.objectIndex = [[NIPointerMap alloc] initWithOptions:NIPointerCollectionOptionRetainKeys];
+
+  } else {
+    NSPointerFunctionsOptions keyOptions = (NSPointerFunctionsStrongMemory
+                                            | NSPointerFunctionsObjectPersonality);
+    self.objectIndex = [[NSMapTable alloc] initWithKeyOptions:keyOptions
+                                                 valueOptions:NSPointerFunctionsStrongMemory
+                                                     capacity:0];
+  }
+  NSUInteger sectionIndex = 0;
+  for (NITableViewModelSection* section in self.sections) {
+    NSUInteger rowIndex = 0;
+    for (id object in section.rows) {
+      [self _indexObject:object atIndexPath:[NSIndexPath indexPathForRow:rowIndex inSection:sectionIndex]];
+      ++rowIndex;
+    }
+    ++sectionIndex;
+  }
+}
+
+- (void)_indexObject:(id)object atIndexPath:(NSIndexPath *)indexPath {
+  if (nil == self.objectIndex) {
+    return;
+  }
+  NSIndexPath* firstIndexPath = [self.objectIndex objectForKey:object];
+  if (nil != firstIndexPath) {
+    self.objectIndexHasDuplicates = YES;
+    // Like the scan, the index finds the first of several equal objects.
+    if (NSOrderedDescending != [firstIndexPath compare:indexPath]) {
+      return;
+    }
+  }
+  [self.objectIndex setObject:indexPath forKey:object];
+}
+
+- (void)_unindexObject:(id)object atIndexPath:(NSIndexPath *)indexPath {
+  if ([[self.objectIndex objectForKey:object] isEqual:indexPath]) {
+    [self.objectIndex removeObjectForKey:object];
+  }
+}
+
+- (void)_reindexObjects:(NSArray *)objects {
+  // A removed object can only still be in the model if something was added twice.
+  if (nil == self.objectIndex || !self.objectIndexHasDuplicates) {
+    return;
+  }
+  for (id object in objects) {
+    if (nil == [self.objectIndex objectForKey:object]) {
+      NSIndexPath* indexPath = [self _scanIndexPathForObject:object];
+      if (nil != indexPath) {
+        [self.objectIndex setObject:indexPath forKey:object];
+      }
+    }
+  }
+}
+
+- (void)_offsetIndexedRowsInSection:(NSUInteger)sectionIndex fromRow:(NSUInteger)row
+                       sectionDelta:(NSInteger)sectionDelta rowDelta:(NSInteger)rowDelta {
+  if (nil == self.objectIndex) {
+    return;
+  }
+  NSArray* rows = [[self.sections objectAtIndex:sectionIndex] rows];
+  if (row >= rows.count) {
+    return;
+  }
+  // Rows that moved down are visited last to first so that an updated index path is never
+  // mistaken for the previous index path of a later duplicate.
+  NSEnumerationOptions options = (rowDelta > 0) ? NSEnumerationReverse : 0;
+  NSIndexSet* rowIndexes = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(row, rows.count - row)];
+  [rows enumerateObjectsAtIndexes:rowIndexes options:options usingBlock:^(id object, NSUInteger rowIndex, BOOL *stop) {
+    NSIndexPath* previousIndexPath = [NSIndexPath indexPathForRow:(NSInteger)rowIndex - rowDelta
+                                                        inSection:(NSInteger)sectionIndex - sectionDelta];
+    if ([[self.objectIndex objectForKey:object] isEqual:previousIndexPath]) {
+      [self.objectIndex setObject:[NSIndexPath indexPathForRow:rowIndex inSection:sectionIndex]
+                           forKey:object];
+    }
+  }];
+}
+
+- (void)_offsetIndexedSectionsFromSection:(NSUInteger)sectionIndex by:(NSInteger)delta {
+  if (nil == self.objectIndex) {
+    return;
+  }
+  NSUInteger numberOfSections = self.sections.count;
+  for (NSUInteger ix = sectionIndex; ix < numberOfSections; ++ix) {
+    NSUInteger offsetSectionIndex = (delta > 0) ? numberOfSections - 1 - (ix - sectionIndex) : ix;
+    [self _offsetIndexedRowsInSection:offsetSectionIndex fromRow:0 sectionDelta:delta rowDelta:0];
+  }
+}
+
 #pragma mark - UITableViewDataSource
 
 
@@ -310,6 +484,52 @@
 #pragma mark - Public
 
 
+#if NS_BLOCKS_AVAILABLE
+
++ (void)modelWithCollatedObjects:(NSArray *)objects
+         collationStringSelector:(SEL)selector
+                        delegate:(id<NITableViewModelDelegate>)delegate
+                      completion:(void (^)(id model))completion {
+  NIDASSERT([NSThread isMainThread]);
+  NIDASSERT(nil != completion);
+
+  UILocalizedIndexedCollation* collation = [UILocalizedIndexedCollation currentCollation];
+  NSArray* sectionTitles = [collation sectionTitles];
+  NSArray* rows = [objects copy];
+  Class modelClass = self;
+
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    NSMutableArray* sections = [NSMutableArray arrayWithCapacity:sectionTitles.count];
+    for (NSUInteger ix = 0; ix < sectionTitles.count; ++ix) {
+      [sections addObject:[NSMutableArray array]];
+    }
+    for (id object in rows) {
+      NSInteger sectionIndex = [collation sectionForObject:object collationStringSelector:selector];
+      [[sections objectAtIndex:sectionIndex] addObject:object];
+    }
+
+    // Empty sections are left out of the model; the index maps their titles to earlier sections.
+    NSMutableArray* sectionedArray = [NSMutableArray arrayWithCapacity:rows.count + sectionTitles.count];
+    [sections enumerateObjectsUsingBlock:^(NSArray* sectionRows, NSUInteger sectionIndex, BOOL *stop) {
+      if (sectionRows.count > 0) {
+        [sectionedArray addObject:[sectionTitles objectAtIndex:sectionIndex]];
+        [sectionedArray addObjectsFromArray:[collation sortedArrayFromArray:sectionRows
+                                                    collationStringSelector:selector]];
+      }
+    }];
+
+    NITableViewModel* model = [[modelClass alloc] initWithSectionedArray:sectionedArray delegate:delegate];
+    [model _rebuildSectionsForPrefix];
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+      [model setSectionIndexType:NITableViewModelSectionIndexAlphabetical showsSearch:NO showsSummary:NO];
+      completion(model);
+    });
+  });
+}
+
+#endif // #if NS_BLOCKS_AVAILABLE
+
 - (id)objectAtIndexPath:(NSIndexPath *)indexPath {
   if (nil == indexPath) {
     return nil;
@@ -337,18 +557,17 @@
   if (nil == object) {
     return nil;
   }
-
-  NSArray *sections = self.sections;
-  for (NSUInteger sectionIndex = 0; sectionIndex < [sections count]; sectionIndex++) {
-    NSArray* rows = [[sections objectAtIndex:sectionIndex] rows];
-    for (NSUInteger rowIndex = 0; rowIndex < [rows count]; rowIndex++) {
-      if ([object isEqual:[rows objectAtIndex:rowIndex]]) {
-        return [NSIndexPath indexPathForRow:rowIndex inSection:sectionIndex];
-      }
-    }
+  if (nil != self.objectIndex) {
+    return [self.objectIndex objectForKey:object];
   }
+  return [self _scanIndexPathForObject:object];
+}
 
-  return nil;
+- (void)setObjectIndexType:(NITableViewModelObjectIndex)objectIndexType {
+  if (_objectIndexType != objectIndexType) {
+    _objectIndexType = objectIndexType;
+    [self _rebuildObjectIndex];
+  }
 }
 
 - (void)setSectionIndexType:(NITableViewModelSectionIndex)sectionIndexType showsSearch:(BOOL)showsSearch showsSummary:(BOOL)showsSummary {
@@ -363,6 +582,35 @@
   }
 }
 
+- (NIPrefetchWindow *)prefetchWindow {
+  if (nil == _prefetchWindow) {
+    _prefetchWindow = [[NIPrefetchWindow alloc] init];
+  }
+  return _prefetchWindow;
+}
+
+- (void)prefetchObjectsForTableView:(UITableView *)tableView {
+  NIPrefetchWindow* prefetchWindow = self.prefetchWindow;
+  CGRect lookAheadRect = [prefetchWindow lookAheadRectForScrollView:tableView];
+  NSArray* indexPaths = CGRectIsEmpty(lookAheadRect) ? nil : [tableView indexPathsForRowsInRect:lookAheadRect];
+
+  NSMutableArray* objects = [NSMutableArray arrayWithCapacity:indexPaths.count];
+  for (NSIndexPath* indexPath in indexPaths) {
+    id object = [self objectAtIndexPath:indexPath];
+    if (nil != object) {
+      [objects addObject:object];
+    }
+  }
+  NSMutableArray* visibleObjects = [NSMutableArray array];
+  for (NSIndexPath* indexPath in [tableView indexPathsForVisibleRows]) {
+    id object = [self objectAtIndexPath:indexPath];
+    if (nil != object) {
+      [visibleObjects addObject:object];
+    }
+  }
+  [prefetchWindow prefetchObjects:objects visibleObjects:visibleObjects];
+}
+
 @end
 
 
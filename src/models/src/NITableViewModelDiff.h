@@ -0,0 +1,143 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+/**
+ * The changes that turn one sectioned array into another, in the form UITableView's batch
+ * updates expect.
+ *
+ * Sections are matched by header title and rows by object. Each row is matched first to the
+ * identical object and then to an equal one, using hash and isEqual:, so the diff takes linear
+ * time. Equal but not identical rows are reloaded; unmatched rows are inserted or deleted; matched
+ * rows whose position changed other than by the insertions and deletions around them are moved.
+ *
+ * Diffs only read the arrays they are given and may be computed on any thread. This lets a very
+ * large model compute its diff in the background and apply it on the main thread with
+ * NIMutableTableViewModel::applyDiff:withTableView:.
+ *
+ * @ingroup TableViewModels
+ */
+@interface NITableViewModelDiff : NSObject
+
+// Both arrays use the format of NITableViewModel::initWithSectionedArray:delegate:.
++ (NITableViewModelDiff *)diffFromSectionedArray:(NSArray *)fromSectionedArray toSectionedArray:(NSArray *)toSectionedArray;
+
+@property (nonatomic, readonly, copy) NSIndexSet* deletedSections;
+@property (nonatomic, readonly, copy) NSIndexSet* insertedSections;
+@property (nonatomic, readonly, copy) NSArray* movedFromSections; // NSNumber
+@property (nonatomic, readonly, copy) NSArray* movedToSections; // NSNumber
+
+@property (nonatomic, readonly, copy) NSArray* deletedIndexPaths;
+@property (nonatomic, readonly, copy) NSArray* insertedIndexPaths;
+@property (nonatomic, readonly, copy) NSArray* movedFromIndexPaths;
+@property (nonatomic, readonly, copy) NSArray* movedToIndexPaths;
+@property (nonatomic, readonly, copy) NSArray* reloadedIndexPaths;
+
+@property (nonatomic, readonly, assign) BOOL hasChanges;
+
+- (void)applyToTableView:(UITableView *)tableView withRowAnimation:(UITableViewRowAnimation)animation;
+
+@end
+
+/** @name Computing Diffs */
+
+/**
+ * Returns the changes from one sectioned array to another.
+ *
+ * @fn NITableViewModelDiff::diffFromSectionedArray:toSectionedArray:
+ */
+
+/** @name Changes */
+
+/**
+ * The indexes of the sections that were removed, in the old contents.
+ *
+ * The rows of these sections are not listed in deletedIndexPaths.
+ *
+ * @fn NITableViewModelDiff::deletedSections
+ */
+
+/**
+ * The indexes of the sections that were added, in the new contents.
+ *
+ * The rows of these sections are not listed in insertedIndexPaths.
+ *
+ * @fn NITableViewModelDiff::insertedSections
+ */
+
+/**
+ * The old indexes of the moved sections. movedToSections holds the new index at the same position.
+ *
+ * @fn NITableViewModelDiff::movedFromSections
+ */
+
+/**
+ * @fn NITableViewModelDiff::movedToSections
+ * @sa NITableViewModelDiff::movedFromSections
+ */
+
+/**
+ * The old index paths of the rows that were removed.
+ *
+ * @fn NITableViewModelDiff::deletedIndexPaths
+ */
+
+/**
+ * The new index paths of the rows that were added.
+ *
+ * @fn NITableViewModelDiff::insertedIndexPaths
+ */
+
+/**
+ * The old index paths of the moved rows. movedToIndexPaths holds the new index path at the same
+ * position.
+ *
+ * @fn NITableViewModelDiff::movedFromIndexPaths
+ */
+
+/**
+ * @fn NITableViewModelDiff::movedToIndexPaths
+ * @sa NITableViewModelDiff::movedFromIndexPaths
+ */
+
+/**
+ * The old index paths of the rows that were replaced by an equal object.
+ *
+ * A row that was replaced and moved is deleted and inserted instead.
+ *
+ * @fn NITableViewModelDiff::reloadedIndexPaths
+ */
+
+/**
+ * NO if the two arrays have the same sections and rows.
+ *
+ * Footer titles are not compared; reload the table to show a changed footer.
+ *
+ * @fn NITableViewModelDiff::hasChanges
+ */
+
+/** @name Applying Diffs */
+
+/**
+ * Performs every change in one beginUpdates/endUpdates batch.
+ *
+ * The table view's data source must already return the new contents.
+ *
+ * @fn NITableViewModelDiff::applyToTableView:withRowAnimation:
+ */
@@ -0,0 +1,138 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NITableViewModelDiff.h"
+
+#import "NITableViewModel.h"
+#import "NITableViewModel+Private.h"
+#import "NIModelDiff.h"
+#import "NimbusCore.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+@implementation NITableViewModelDiff {
+  NIModelDiff* _changes;
+}
+
++ (NITableViewModelDiff *)diffFromSectionedArray:(NSArray *)fromSectionedArray toSectionedArray:(NSArray *)toSectionedArray {
+  return [self diffFromSections:[self sectionsForSectionedArray:fromSectionedArray]
+                     toSections:[self sectionsForSectionedArray:toSectionedArray]];
+}
+
++ (NSArray *)sectionsForSectionedArray:(NSArray *)sectionedArray {
+  // Compiling the array only creates model objects, so this is safe off the main thread.
+  NITableViewModel* model = [[NITableViewModel alloc] initWithSectionedArray:sectionedArray delegate:nil];
+  return model.sections;
+}
+
++ (NITableViewModelDiff *)diffFromSections:(NSArray *)fromSections toSections:(NSArray *)toSections {
+  NITableViewModelDiff* diff = [[self alloc] init];
+  diff->_changes = [NIModelDiff diffFromSections:fromSections toSections:toSections];
+  return diff;
+}
+
+- (NSArray *)toSections {
+  return _changes.toSections;
+}
+
+- (NSArray *)fromSectionTitles {
+  return _changes.fromSectionTitles;
+}
+
+- (NSArray *)fromSectionRowCounts {
+  return _changes.fromSectionRowCounts;
+}
+
+- (NSIndexSet *)deletedSections {
+  return _changes.deletedSections;
+}
+
+- (NSIndexSet *)insertedSections {
+  return _changes.insertedSections;
+}
+
+- (NSArray *)movedFromSections {
+  return _changes.movedFromSections;
+}
+
+- (NSArray *)movedToSections {
+  return _changes.movedToSections;
+}
+
+- (NSArray *)deletedIndexPaths {
+  return _changes.deletedIndexPaths;
+}
+
+- (NSArray *)insertedIndexPaths {
+  return _changes.insertedIndexPaths;
+}
+
+- (NSArray *)movedFromIndexPaths {
+  return _changes.movedFromIndexPaths;
+}
+
+- (NSArray *)movedToIndexPaths {
+  return _changes.movedToIndexPaths;
+}
+
+- (NSArray *)reloadedIndexPaths {
+  return _changes.reloadedIndexPaths;
+}
+
+- (BOOL)hasChanges {
+  return _changes.hasChanges;
+}
+
+- (BOOL)isDiffFromSections:(NSArray *)sections {
+  return [_changes isDiffFromSections:sections];
+}
+
+- (void)applyToTableView:(UITableView *)tableView withRowAnimation:(UITableViewRowAnimation)animation {
+  if (!_changes.hasChanges) {
+    return;
+  }
+
+  [tableView beginUpdates];
+  if (_changes.deletedSections.count > 0) {
+    [tableView deleteSections:_changes.deletedSections withRowAnimation:animation];
+  }
+  if (_changes.insertedSections.count > 0) {
+    [tableView insertSections:_changes.insertedSections withRowAnimation:animation];
+  }
+  for (NSUInteger ix = 0; ix < _changes.movedFromSections.count; ++ix) {
+    [tableView moveSection:[[_changes.movedFromSections objectAtIndex:ix] integerValue]
+                 toSection:[[_changes.movedToSections objectAtIndex:ix] integerValue]];
+  }
+  if (_changes.deletedIndexPaths.count > 0) {
+    [tableView deleteRowsAtIndexPaths:_changes.deletedIndexPaths withRowAnimation:animation];
+  }
+  if (_changes.insertedIndexPaths.count > 0) {
+    [tableView insertRowsAtIndexPaths:_changes.insertedIndexPaths withRowAnimation:animation];
+  }
+  for (NSUInteger ix = 0; ix < _changes.movedFromIndexPaths.count; ++ix) {
+    [tableView moveRowAtIndexPath:[_changes.movedFromIndexPaths objectAtIndex:ix]
+                      toIndexPath:[_changes.movedToIndexPaths objectAtIndex:ix]];
+  }
+  if (_changes.reloadedIndexPaths.count > 0) {
+    [tableView reloadRowsAtIndexPaths:_changes.reloadedIndexPaths withRowAnimation:animation];
+  }
+  [tableView endUpdates];
+}
+
+@end
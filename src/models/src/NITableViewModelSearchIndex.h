@@ -0,0 +1,148 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+@class NITableViewModel;
+@class NIMutableTableViewModel;
+
+#if NS_BLOCKS_AVAILABLE
+// Returns the text that an object is found by. Called on the search queue.
+typedef NSString* (^NITableViewModelSearchKeyBlock)(id object);
+#endif // #if NS_BLOCKS_AVAILABLE
+
+/**
+ * Searches the rows of a table view model in the background and shows the results in a second,
+ * mutable model.
+ *
+ * The index is built from a snapshot of the model on a serial background queue. Each row is found
+ * by the words of its search key: a query matches the rows in which every query word is the
+ * start of a word of the key, ignoring case and diacritics. One and two letter words are looked
+ * up directly by prefix; longer words narrow the rows down by their trigrams (runs of three
+ * characters) before the prefixes are checked, so a query only visits rows that share them.
+ *
+ * Searches are meant to be made on every keystroke. A search that is superseded before it
+ * finishes is abandoned, and a query that extends the previous one only checks the previous
+ * results. The results are published on the main thread as an NITableViewModelDiff applied to
+ * searchResultsModel, which keeps the matching rows under the titles of their sections.
+ *
+@code
+self.searchIndex = [[NITableViewModelSearchIndex alloc] initWithModel:self.model
+                                                       searchKeyBlock:^NSString *(NITitleCellObject* object) {
+  return object.title;
+}];
+self.searchIndex.tableView = self.searchDisplayController.searchResultsTableView;
+self.searchDisplayController.searchResultsDataSource = self.searchIndex.searchResultsModel;
+
+- (BOOL)searchDisplayController:(UISearchDisplayController *)controller shouldReloadTableForSearchString:(NSString *)searchString {
+  [self.searchIndex searchForText:searchString];
+  return NO;
+}
+@endcode
+ *
+ * @ingroup TableViewModels
+ */
+@interface NITableViewModelSearchIndex : NSObject
+
+#pragma mark Creating Search Indexes
+
+#if NS_BLOCKS_AVAILABLE
+// Designated initializer.
+- (id)initWithModel:(NITableViewModel *)model searchKeyBlock:(NITableViewModelSearchKeyBlock)searchKeyBlock;
+#endif // #if NS_BLOCKS_AVAILABLE
+
+- (void)reloadWithModel:(NITableViewModel *)model;
+
+#pragma mark Searching
+
+- (void)searchForText:(NSString *)text;
+- (void)cancelSearch;
+
+@property (nonatomic, readonly, copy) NSString* searchText;
+
+#pragma mark Showing Results
+
+@property (nonatomic, readonly, strong) NIMutableTableViewModel* searchResultsModel;
+@property (nonatomic, weak) UITableView* tableView;
+
+@end
+
+/** @name Creating Search Indexes */
+
+/**
+ * Initializes a newly allocated search index for the rows of the given model.
+ *
+ * searchResultsModel uses the delegate of the given model and is empty until the first search.
+ *
+ * @fn NITableViewModelSearchIndex::initWithModel:searchKeyBlock:
+ * @param model           The model to search.
+ * @param searchKeyBlock  Returns the text each row is found by. It is called on the search
+ *                             queue, so it must only read state that doesn't change while
+ *                             the index is built.
+ */
+
+/**
+ * Rebuilds the index from the current rows of the given model.
+ *
+ * Call this after changing the model. The rows are copied on the calling thread and indexed in
+ * the background, after which the current search is run again.
+ *
+ * @fn NITableViewModelSearchIndex::reloadWithModel:
+ */
+
+/** @name Searching */
+
+/**
+ * Starts searching for the rows matching the given text and returns immediately.
+ *
+ * Any search that hasn't published its results yet is abandoned. Searching for an empty string
+ * shows every row.
+ *
+ * @fn NITableViewModelSearchIndex::searchForText:
+ */
+
+/**
+ * Abandons the current search without changing searchResultsModel.
+ *
+ * @fn NITableViewModelSearchIndex::cancelSearch
+ */
+
+/**
+ * The text of the last call to searchForText:.
+ *
+ * @fn NITableViewModelSearchIndex::searchText
+ */
+
+/** @name Showing Results */
+
+/**
+ * A model holding the rows that match the last search to finish.
+ *
+ * Use it as the data source of the table view that shows the results. It is changed on the main
+ * thread and should not be modified elsewhere.
+ *
+ * @fn NITableViewModelSearchIndex::searchResultsModel
+ */
+
+/**
+ * The table view that shows searchResultsModel.
+ *
+ * Each change to the results is applied to it with batch updates.
+ *
+ * @fn NITableViewModelSearchIndex::tableView
+ */
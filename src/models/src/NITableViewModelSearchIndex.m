@@ -0,0 +1,337 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NITableViewModelSearchIndex.h"
+
+#import "NIMutableTableViewModel.h"
+#import "NITableViewModel+Private.h"
+#import "NimbusCore.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// How many rows are checked between looks at whether the search was superseded.
+static const NSUInteger kRowsPerCancellationCheck = 256;
+
+// The words of the given text, folded so that case and diacritics don't matter.
+static NSArray* NISearchWordsOfText(NSString* text) {
+  if ([text length] == 0) {
+    return [NSArray array];
+  }
+  NSString* folded = [text stringByFoldingWithOptions:(NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch)
+                                               locale:[NSLocale currentLocale]];
+  NSCharacterSet* separators = [[NSCharacterSet alphanumericCharacterSet] invertedSet];
+  NSMutableArray* words = [NSMutableArray array];
+  for (NSString* word in [folded componentsSeparatedByCharactersInSet:separators]) {
+    if ([word length] > 0) {
+      [words addObject:word];
+    }
+  }
+  return words;
+}
+
+static void NIAddRowToIndex(NSMutableDictionary* index, NSString* key, NSUInteger row) {
+  NSMutableIndexSet* rows = [index objectForKey:key];
+  if (nil == rows) {
+    rows = [NSMutableIndexSet indexSet];
+    [index setObject:rows forKey:key];
+  }
+  [rows addIndex:row];
+}
+
+static NSIndexSet* NIIntersectIndexSets(NSIndexSet* first, NSIndexSet* second) {
+  if (nil == first) {
+    return second;
+  }
+  NSIndexSet* smaller = (first.count < second.count) ? first : second;
+  NSIndexSet* larger = (smaller == first) ? second : first;
+  return [smaller indexesPassingTest:^BOOL(NSUInteger idx, BOOL *stop) {
+    return [larger containsIndex:idx];
+  }];
+}
+
+@interface NITableViewModelSearchIndex ()
+@property (nonatomic, copy) NITableViewModelSearchKeyBlock searchKeyBlock;
+@property (nonatomic, strong) NIMutableTableViewModel* searchResultsModel;
+@property (nonatomic, copy) NSString* searchText;
+@property (nonatomic, strong) dispatch_queue_t queue;
+@property (atomic, assign) NSUInteger searchGeneration;
+
+// Everything below is only used on the queue.
+@property (nonatomic, strong) NSArray* indexedSections; // NITableViewModelSection without rows
+@property (nonatomic, strong) NSArray* rows; // Every row of the model, in order
+@property (nonatomic, strong) NSData* rowSections; // NSUInteger section of each row
+@property (nonatomic, strong) NSArray* rowWords; // NSArray of the words of each row's search key
+@property (nonatomic, strong) NSDictionary* prefixIndex; // One or two characters => NSIndexSet of rows
+@property (nonatomic, strong) NSDictionary* trigramIndex; // Three characters => NSIndexSet of rows
+@property (nonatomic, strong) NSArray* publishedSections; // What searchResultsModel holds
+@property (nonatomic, copy) NSArray* publishedWords;
+@property (nonatomic, strong) NSIndexSet* publishedRows;
+@end
+
+
+@implementation NITableViewModelSearchIndex
+
+
+- (id)initWithModel:(NITableViewModel *)model searchKeyBlock:(NITableViewModelSearchKeyBlock)searchKeyBlock {
+  if ((self = [super init])) {
+    NIDASSERT(nil != searchKeyBlock);
+    _searchKeyBlock = [searchKeyBlock copy];
+    _searchResultsModel = [[NIMutableTableViewModel alloc] initWithDelegate:model.delegate];
+    _queue = dispatch_queue_create("com.nimbuskit.models.search", DISPATCH_QUEUE_SERIAL);
+    _publishedSections = [NSArray array];
+    [self reloadWithModel:model];
+  }
+  return self;
+}
+
+- (id)init {
+  return [self initWithModel:nil searchKeyBlock:^NSString *(id object) { return nil; }];
+}
+
+#pragma mark - Indexing
+
+
+- (void)_indexSections:(NSArray *)sections {
+  NSMutableArray* indexedSections = [NSMutableArray arrayWithCapacity:sections.count];
+  NSMutableArray* rows = [NSMutableArray array];
+  NSMutableData* rowSections = [NSMutableData data];
+  NSMutableArray* rowWords = [NSMutableArray array];
+  NSMutableDictionary* prefixIndex = [NSMutableDictionary dictionary];
+  NSMutableDictionary* trigramIndex = [NSMutableDictionary dictionary];
+
+  NSUInteger sectionIndex = 0;
+  for (NITableViewModelSection* section in sections) {
+    NITableViewModelSection* indexedSection = [NITableViewModelSection section];
+    indexedSection.headerTitle = section.headerTitle;
+    indexedSection.footerTitle = section.footerTitle;
+    [indexedSections addObject:indexedSection];
+
+    for (id object in section.rows) {
+      NSUInteger row = rows.count;
+      NSArray* words = NISearchWordsOfText(self.searchKeyBlock(object));
+      for (NSString* word in words) {
+        NSUInteger length = [word length];
+        NIAddRowToIndex(prefixIndex, [word substringToIndex:1], row);
+        if (length >= 2) {
+          NIAddRowToIndex(prefixIndex, [word substringToIndex:2], row);
+        }
+        for (NSUInteger ix = 0; ix + 3 <= length; ++ix) {
+          NIAddRowToIndex(trigramIndex, [word substringWithRange:NSMakeRange(ix, 3)], row);
+        }
+      }
+      [rows addObject:object];
+      [rowSections appendBytes:&sectionIndex length:sizeof(sectionIndex)];
+      [rowWords addObject:words];
+    }
+    ++sectionIndex;
+  }
+
+  self.indexedSections = indexedSections;
+  self.rows = rows;
+  self.rowSections = rowSections;
+  self.rowWords = rowWords;
+  self.prefixIndex = prefixIndex;
+  self.trigramIndex = trigramIndex;
+
+  // The previous results refer to rows that may no longer exist.
+  self.publishedWords = nil;
+  self.publishedRows = nil;
+}
+
+#pragma mark - Searching
+
+
+// The rows that may contain a word starting with the given word. This is exact for words of one
+// or two characters.
+- (NSIndexSet *)_candidateRowsForWord:(NSString *)word {
+  NSUInteger length = [word length];
+  if (length <= 2) {
+    return [self.prefixIndex objectForKey:word] ?: [NSIndexSet indexSet];
+  }
+  NSIndexSet* candidates = nil;
+  for (NSUInteger ix = 0; ix + 3 <= length; ++ix) {
+    NSIndexSet* rows = [self.trigramIndex objectForKey:[word substringWithRange:NSMakeRange(ix, 3)]];
+    candidates = NIIntersectIndexSets(candidates, rows ?: [NSIndexSet indexSet]);
+    if (candidates.count == 0) {
+      break;
+    }
+  }
+  return candidates;
+}
+
+// A query that only adds to the previous one can only match rows that the previous one matched.
+- (BOOL)_isRefinementOfPublishedWords:(NSArray *)words {
+  if (nil == self.publishedRows || self.publishedWords.count == 0 || self.publishedWords.count > words.count) {
+    return NO;
+  }
+  for (NSUInteger ix = 0; ix < self.publishedWords.count; ++ix) {
+    if (![[words objectAtIndex:ix] hasPrefix:[self.publishedWords objectAtIndex:ix]]) {
+      return NO;
+    }
+  }
+  return YES;
+}
+
+// Returns nil if the search was superseded.
+- (NSIndexSet *)_rowsMatchingWords:(NSArray *)words generation:(NSUInteger)generation {
+  if (words.count == 0) {
+    return [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, self.rows.count)];
+  }
+
+  NSIndexSet* candidates = [self _isRefinementOfPublishedWords:words] ? self.publishedRows : nil;
+  NSMutableArray* wordsToCheck = [NSMutableArray array];
+  for (NSString* word in words) {
+    candidates = NIIntersectIndexSets(candidates, [self _candidateRowsForWord:word]);
+    if (candidates.count == 0) {
+      return candidates;
+    }
+    if ([word length] > 2) {
+      [wordsToCheck addObject:word];
+    }
+  }
+  if (wordsToCheck.count == 0) {
+    return candidates;
+  }
+
+  // Sharing trigrams doesn't mean that a word starts with the query word.
+  NSMutableIndexSet* matches = [NSMutableIndexSet indexSet];
+  __block NSUInteger numberOfCheckedRows = 0;
+  __block BOOL superseded = NO;
+  [candidates enumerateIndexesUsingBlock:^(NSUInteger row, BOOL *stop) {
+    if (++numberOfCheckedRows % kRowsPerCancellationCheck == 0
+        && generation != self.searchGeneration) {
+      superseded = YES;
+      *stop = YES;
+      return;
+    }
+    NSArray* rowWords = [self.rowWords objectAtIndex:row];
+    for (NSString* word in wordsToCheck) {
+      BOOL found = NO;
+      for (NSString* rowWord in rowWords) {
+        if ([rowWord hasPrefix:word]) {
+          found = YES;
+          break;
+        }
+      }
+      if (!found) {
+        return;
+      }
+    }
+    [matches addIndex:row];
+  }];
+  return superseded ? nil : matches;
+}
+
+- (NSArray *)_sectionsForRows:(NSIndexSet *)rows {
+  const NSUInteger* rowSections = [self.rowSections bytes];
+  NSMutableArray* sections = [NSMutableArray array];
+  __block NSUInteger lastSectionIndex = NSNotFound;
+  __block NSMutableArray* sectionRows = nil;
+  [rows enumerateIndexesUsingBlock:^(NSUInteger row, BOOL *stop) {
+    NSUInteger sectionIndex = rowSections[row];
+    if (sectionIndex != lastSectionIndex) {
+      NITableViewModelSection* indexedSection = [self.indexedSections objectAtIndex:sectionIndex];
+      NITableViewModelSection* section = [NITableViewModelSection section];
+      section.headerTitle = indexedSection.headerTitle;
+      section.footerTitle = indexedSection.footerTitle;
+      sectionRows = [NSMutableArray array];
+      section.rows = sectionRows;
+      [sections addObject:section];
+      lastSectionIndex = sectionIndex;
+    }
+    [sectionRows addObject:[self.rows objectAtIndex:row]];
+  }];
+  return sections;
+}
+
+- (void)_searchForText:(NSString *)text generation:(NSUInteger)generation {
+  if (generation != self.searchGeneration) {
+    return;
+  }
+  NSArray* words = NISearchWordsOfText(text);
+  NSIndexSet* rows = [self _rowsMatchingWords:words generation:generation];
+  if (nil == rows) {
+    return;
+  }
+  NSArray* sections = [self _sectionsForRows:rows];
+  NITableViewModelDiff* diff = [NITableViewModelDiff diffFromSections:self.publishedSections toSections:sections];
+  if (generation != self.searchGeneration) {
+    return;
+  }
+
+  // Once a diff is on its way it is always applied, so that each diff starts from what the
+  // results model holds.
+  self.publishedSections = sections;
+  self.publishedWords = words;
+  self.publishedRows = rows;
+  if (!diff.hasChanges) {
+    return;
+  }
+  __weak NITableViewModelSearchIndex* weakSelf = self;
+  dispatch_async(dispatch_get_main_queue(), ^{
+    NITableViewModelSearchIndex* strongSelf = weakSelf;
+    [strongSelf.searchResultsModel applyDiff:diff withTableView:strongSelf.tableView];
+  });
+}
+
+#pragma mark - Public
+
+
+- (void)reloadWithModel:(NITableViewModel *)model {
+  NIDASSERT([NSThread isMainThread]);
+
+  // The model may change on the main thread while it's indexed, so the rows are copied here.
+  NSMutableArray* sections = [NSMutableArray arrayWithCapacity:model.sections.count];
+  for (NITableViewModelSection* section in model.sections) {
+    NITableViewModelSection* snapshot = [NITableViewModelSection section];
+    snapshot.headerTitle = section.headerTitle;
+    snapshot.footerTitle = section.footerTitle;
+    snapshot.rows = [section.rows copy];
+    [sections addObject:snapshot];
+  }
+
+  NSString* text = self.searchText;
+  NSUInteger generation = ++self.searchGeneration;
+  __weak NITableViewModelSearchIndex* weakSelf = self;
+  dispatch_async(self.queue, ^{
+    NITableViewModelSearchIndex* strongSelf = weakSelf;
+    [strongSelf _indexSections:sections];
+    if (nil != text) {
+      [strongSelf _searchForText:text generation:generation];
+    }
+  });
+}
+
+- (void)searchForText:(NSString *)text {
+  NIDASSERT([NSThread isMainThread]);
+  self.searchText = (nil != text) ? text : @"";
+
+  NSString* searchText = self.searchText;
+  NSUInteger generation = ++self.searchGeneration;
+  __weak NITableViewModelSearchIndex* weakSelf = self;
+  dispatch_async(self.queue, ^{
+    [weakSelf _searchForText:searchText generation:generation];
+  });
+}
+
+- (void)cancelSearch {
+  ++self.searchGeneration;
+}
+
+@end
@@ -0,0 +1,63 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+#import "NITableViewModel.h"
+
+/**
+ * An immutable table view model that may be created on any thread.
+ *
+ * Turning a large response into a model takes long enough to interrupt scrolling when it is done
+ * on the main thread. A snapshot is created with the same sectioned and list arrays as
+ * NITableViewModel, but keeps every row in one contiguous array with the offset of each section,
+ * rather than an array of rows for each section. Nothing about it changes once it is initialized
+ * and configured, so it can be built on a background queue, read from any thread, and swapped in
+ * as the table view's data source on the main thread:
+ *
+@code
+dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+  NSArray* sectionedArray = [self sectionedArrayForResponse:response];
+  NITableViewModelSnapshot* model =
+      [[NITableViewModelSnapshot alloc] initWithSectionedArray:sectionedArray
+                                                      delegate:(id)[NICellFactory class]];
+  dispatch_async(dispatch_get_main_queue(), ^{
+    self.model = model;
+    self.tableView.dataSource = model;
+    [self.tableView reloadData];
+  });
+});
+@endcode
+ *
+ * Configure the object index and section index before handing the snapshot to another thread;
+ * they are the only state that can be changed after initialization. Use NIMutableTableViewModel
+ * and NITableViewModelDiff for models whose rows change in place.
+ *
+ * @ingroup TableViewModels
+ */
+@interface NITableViewModelSnapshot : NITableViewModel
+
+@property (nonatomic, readonly, assign) NSUInteger numberOfObjects;
+
+@end
+
+/**
+ * The number of rows in all of the sections.
+ *
+ * @fn NITableViewModelSnapshot::numberOfObjects
+ */
@@ -0,0 +1,152 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NITableViewModelSnapshot.h"
+
+#import "NITableViewModel+Private.h"
+#import "NimbusCore.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+@interface NITableViewModelSnapshot ()
+@property (nonatomic, copy) NSArray* objects; // Every row, section by section
+@property (nonatomic, copy) NSData* sectionOffsets; // NSUInteger index of each section's first row, then the number of rows
+@end
+
+
+@implementation NITableViewModelSnapshot
+
+
+#pragma mark - Compiling Data
+
+
+// The base class compiles the sections, which are then flattened so that only their titles are kept.
+- (void)_compactSections {
+  NSUInteger numberOfObjects = 0;
+  for (NITableViewModelSection* section in self.sections) {
+    numberOfObjects += section.rows.count;
+  }
+
+  NSMutableArray* objects = [NSMutableArray arrayWithCapacity:numberOfObjects];
+  NSMutableData* sectionOffsets = [NSMutableData dataWithLength:(self.sections.count + 1) * sizeof(NSUInteger)];
+  NSUInteger* offsets = [sectionOffsets mutableBytes];
+  NSUInteger sectionIndex = 0;
+  for (NITableViewModelSection* section in self.sections) {
+    offsets[sectionIndex++] = objects.count;
+    if (nil != section.rows) {
+      [objects addObjectsFromArray:section.rows];
+    }
+    section.rows = nil;
+  }
+  offsets[sectionIndex] = objects.count;
+
+  self.objects = objects;
+  self.sectionOffsets = sectionOffsets;
+}
+
+- (void)_compileDataWithListArray:(NSArray *)listArray {
+  [super _compileDataWithListArray:listArray];
+  [self _compactSections];
+  [self _rebuildObjectIndex];
+}
+
+- (void)_compileDataWithSectionedArray:(NSArray *)sectionedArray {
+  [super _compileDataWithSectionedArray:sectionedArray];
+  [self _compactSections];
+  [self _rebuildObjectIndex];
+}
+
+- (NSRange)_rangeOfSection:(NSUInteger)section {
+  const NSUInteger* offsets = [self.sectionOffsets bytes];
+  return NSMakeRange(offsets[section], offsets[section + 1] - offsets[section]);
+}
+
+- (NSIndexPath *)_indexPathForObjectAtIndex:(NSUInteger)index {
+  // The last section that starts at or before the index contains it.
+  const NSUInteger* offsets = [self.sectionOffsets bytes];
+  NSUInteger low = 0;
+  NSUInteger high = self.sections.count;
+  while (high - low > 1) {
+    NSUInteger middle = low + (high - low) / 2;
+    if (offsets[middle] <= index) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+  return [NSIndexPath indexPathForRow:index - offsets[low] inSection:low];
+}
+
+#pragma mark - Object Index
+
+
+- (NSIndexPath *)_scanIndexPathForObject:(id)object {
+  NSUInteger index = ((NITableViewModelObjectIndexIdentity == self.objectIndexType)
+                      ? [self.objects indexOfObjectIdenticalTo:object]
+                      : [self.objects indexOfObject:object]);
+  return (NSNotFound != index) ? [self _indexPathForObjectAtIndex:index] : nil;
+}
+
+- (void)_rebuildObjectIndex {
+  // Before the rows are compacted the base class has nothing to index.
+  if (nil == self.sectionOffsets) {
+    return;
+  }
+  [super _rebuildObjectIndex];
+  if (nil == self.objectIndex) {
+    return;
+  }
+  [self.objects enumerateObjectsUsingBlock:^(id object, NSUInteger index, BOOL *stop) {
+    [self _indexObject:object atIndexPath:[self _indexPathForObjectAtIndex:index]];
+  }];
+}
+
+#pragma mark - NITableViewModel
+
+
+- (NSUInteger)numberOfObjects {
+  return self.objects.count;
+}
+
+- (id)objectAtIndexPath:(NSIndexPath *)indexPath {
+  if (nil == indexPath) {
+    return nil;
+  }
+  NSUInteger section = (NSUInteger)indexPath.section;
+  NSUInteger row = (NSUInteger)indexPath.row;
+  NIDASSERT(section < self.sections.count);
+  if (section >= self.sections.count) {
+    return nil;
+  }
+  NSRange range = [self _rangeOfSection:section];
+  NIDASSERT(row < range.length);
+  if (row >= range.length) {
+    return nil;
+  }
+  return [self.objects objectAtIndex:range.location + row];
+}
+
+- (NSInteger)tableView:(UITableView *)tableView numberOfRowsInSection:(NSInteger)section {
+  if ((NSUInteger)section < self.sections.count) {
+    return (NSInteger)[self _rangeOfSection:section].length;
+  }
+  return 0;
+}
+
+@end
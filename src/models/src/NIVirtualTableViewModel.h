@@ -0,0 +1,111 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+#import "NITableViewModel.h"
+
+#if NS_BLOCKS_AVAILABLE
+// Returns the objects for the given rows of the given section, in order.
+typedef NSArray* (^NIVirtualTableViewModelPageBlock)(NSUInteger section, NSRange rows);
+#endif // #if NS_BLOCKS_AVAILABLE
+
+/**
+ * A table view model that only knows how many rows each section has and fetches row objects in
+ * pages when they are needed.
+ *
+ * Use this model for lists that are too large to hold in memory. Pages are kept in an LRU cache
+ * that holds a fixed number of them, so as the table view scrolls it keeps the pages around the
+ * rows it last displayed and memory use doesn't grow with the size of the list.
+ *
+ * Cells are created from the fetched objects exactly as with NITableViewModel, so the model
+ * works with NICellFactory. Every row whose height is asked for is fetched, though, so implement
+ * tableView:estimatedHeightForRowAtIndexPath: in large tables to only fetch the visible rows.
+ *
+ * @ingroup TableViewModels
+ */
+@interface NIVirtualTableViewModel : NITableViewModel
+
+#pragma mark Creating Virtual Table View Models
+
+#if NS_BLOCKS_AVAILABLE
+// Designated initializer.
+- (id)initWithSectionTitles:(NSArray *)sectionTitles
+                  rowCounts:(NSArray *)rowCounts
+                  pageBlock:(NIVirtualTableViewModelPageBlock)pageBlock
+                   delegate:(id<NITableViewModelDelegate>)delegate;
+#endif // #if NS_BLOCKS_AVAILABLE
+
+#pragma mark Changing the Contents
+
+- (void)reloadWithSectionTitles:(NSArray *)sectionTitles rowCounts:(NSArray *)rowCounts;
+- (void)invalidatePages;
+
+#pragma mark Configuring Pages
+
+@property (nonatomic, assign) NSUInteger pageSize; // Default: 50
+@property (nonatomic, assign) NSUInteger maximumNumberOfCachedPages; // Default: 10
+
+@end
+
+/** @name Creating Virtual Table View Models */
+
+/**
+ * Initializes a newly allocated virtual table view model.
+ *
+ * @param sectionTitles [optional] The header title of each section, or NSNull for a section
+ *                           without one. If nil, every section is untitled.
+ * @param rowCounts     An NSNumber with the number of rows in each section.
+ * @param pageBlock     Called on the main thread with a range of rows whenever one of them is
+ *                           needed and its page isn't cached. It must return one object for
+ *                           each row in the range.
+ * @param delegate      The delegate that creates cells for the fetched objects.
+ * @fn NIVirtualTableViewModel::initWithSectionTitles:rowCounts:pageBlock:delegate:
+ */
+
+/** @name Changing the Contents */
+
+/**
+ * Replaces the sections and drops every cached page.
+ *
+ * Reload the table view after calling this.
+ *
+ * @fn NIVirtualTableViewModel::reloadWithSectionTitles:rowCounts:
+ */
+
+/**
+ * Drops every cached page so that rows are fetched again the next time they are displayed.
+ *
+ * @fn NIVirtualTableViewModel::invalidatePages
+ */
+
+/** @name Configuring Pages */
+
+/**
+ * The number of rows fetched by each call to the page block.
+ *
+ * Changing the page size drops every cached page.
+ *
+ * @fn NIVirtualTableViewModel::pageSize
+ */
+
+/**
+ * The number of pages kept in memory. The least recently used page is dropped first.
+ *
+ * @fn NIVirtualTableViewModel::maximumNumberOfCachedPages
+ */
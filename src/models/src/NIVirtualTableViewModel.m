@@ -0,0 +1,192 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIVirtualTableViewModel.h"
+
+#import "NITableViewModel+Private.h"
+#import "NimbusCore.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+@interface NIVirtualTableViewModel ()
+@property (nonatomic, copy) NIVirtualTableViewModelPageBlock pageBlock;
+@property (nonatomic, copy) NSArray* rowCounts;
+@property (nonatomic, strong) NIMemoryCache* pageCache;
+// Consecutive rows are nearly always on the same page, so it is kept outside of the cache.
+@property (nonatomic, strong) NSArray* lastPage;
+@property (nonatomic, assign) NSUInteger lastPageSection;
+@property (nonatomic, assign) NSUInteger lastPageIndex;
+@end
+
+
+@implementation NIVirtualTableViewModel
+
+
+- (id)initWithSectionTitles:(NSArray *)sectionTitles
+                  rowCounts:(NSArray *)rowCounts
+                  pageBlock:(NIVirtualTableViewModelPageBlock)pageBlock
+                   delegate:(id<NITableViewModelDelegate>)delegate {
+  if ((self = [super initWithDelegate:delegate])) {
+    NIDASSERT(nil != pageBlock);
+    _pageBlock = [pageBlock copy];
+    _pageSize = 50;
+    _maximumNumberOfCachedPages = 10;
+    _pageCache = [[NIMemoryCache alloc] init];
+    [self reloadWithSectionTitles:sectionTitles rowCounts:rowCounts];
+  }
+  return self;
+}
+
+- (id)initWithDelegate:(id<NITableViewModelDelegate>)delegate {
+  return [self initWithSectionTitles:nil
+                           rowCounts:nil
+                           pageBlock:^NSArray *(NSUInteger section, NSRange rows) { return nil; }
+                            delegate:delegate];
+}
+
+#pragma mark - Public
+
+
+- (void)reloadWithSectionTitles:(NSArray *)sectionTitles rowCounts:(NSArray *)rowCounts {
+  NIDASSERT(nil == sectionTitles || sectionTitles.count == rowCounts.count);
+  [self _resetCompiledData];
+
+  // The sections only hold titles so that the section index and headers work as they do for
+  // any other model.
+  NSMutableArray* sections = [NSMutableArray arrayWithCapacity:rowCounts.count];
+  for (NSUInteger ix = 0; ix < rowCounts.count; ++ix) {
+    NITableViewModelSection* section = [NITableViewModelSection section];
+    id title = (ix < sectionTitles.count) ? [sectionTitles objectAtIndex:ix] : nil;
+    section.headerTitle = [title isKindOfClass:[NSString class]] ? title : nil;
+    [sections addObject:section];
+  }
+  self.sections = sections;
+  self.rowCounts = rowCounts;
+  [self invalidatePages];
+}
+
+- (void)invalidatePages {
+  [self.pageCache removeAllObjects];
+  self.lastPage = nil;
+}
+
+- (void)setPageSize:(NSUInteger)pageSize {
+  NIDASSERT(pageSize > 0);
+  if (_pageSize != pageSize && pageSize > 0) {
+    _pageSize = pageSize;
+    [self invalidatePages];
+  }
+}
+
+- (void)setMaximumNumberOfCachedPages:(NSUInteger)maximumNumberOfCachedPages {
+  _maximumNumberOfCachedPages = MAX(maximumNumberOfCachedPages, (NSUInteger)1);
+  [self evictPagesIfNeeded];
+}
+
+#pragma mark - Pages
+
+
+- (NSArray *)pageAtIndex:(NSUInteger)pageIndex inSection:(NSUInteger)section {
+  if (nil != self.lastPage && self.lastPageSection == section && self.lastPageIndex == pageIndex) {
+    return self.lastPage;
+  }
+
+  NSString* name = [NSString stringWithFormat:@"%lu:%lu", (unsigned long)section, (unsigned long)pageIndex];
+  NSArray* page = [self.pageCache objectWithName:name];
+  if (nil == page) {
+    NSUInteger numberOfRows = [[self.rowCounts objectAtIndex:section] unsignedIntegerValue];
+    NSUInteger firstRow = pageIndex * _pageSize;
+    NSRange rows = NSMakeRange(firstRow, MIN(_pageSize, numberOfRows - firstRow));
+    page = self.pageBlock(section, rows) ?: [NSArray array];
+    NIDASSERT(page.count == rows.length);
+    [self.pageCache storeObject:page withName:name];
+    [self evictPagesIfNeeded];
+  }
+
+  self.lastPage = page;
+  self.lastPageSection = section;
+  self.lastPageIndex = pageIndex;
+  return page;
+}
+
+- (void)evictPagesIfNeeded {
+  while (self.pageCache.count > _maximumNumberOfCachedPages) {
+    NSString* name = [self.pageCache nameOfLeastRecentlyUsedObject];
+    if (nil == name) {
+      break;
+    }
+    [self.pageCache removeObjectWithName:name];
+  }
+}
+
+#pragma mark - NITableViewModel
+
+
+- (id)objectAtIndexPath:(NSIndexPath *)indexPath {
+  if (nil == indexPath) {
+    return nil;
+  }
+  NSUInteger section = (NSUInteger)indexPath.section;
+  NSUInteger row = (NSUInteger)indexPath.row;
+  NIDASSERT(section < self.rowCounts.count);
+  if (section >= self.rowCounts.count) {
+    return nil;
+  }
+  NIDASSERT(row < [[self.rowCounts objectAtIndex:section] unsignedIntegerValue]);
+  if (row >= [[self.rowCounts objectAtIndex:section] unsignedIntegerValue]) {
+    return nil;
+  }
+
+  NSArray* page = [self pageAtIndex:row / _pageSize inSection:section];
+  NSUInteger rowInPage = row % _pageSize;
+  return (rowInPage < page.count) ? [page objectAtIndex:rowInPage] : nil;
+}
+
+- (NSIndexPath *)indexPathForObject:(id)object {
+  // Only the cached pages can be searched without fetching the whole list.
+  if (nil == object) {
+    return nil;
+  }
+  for (NSString* name in [self.pageCache namesOfObjectsWithPrefix:@""]) {
+    NSArray* components = [name componentsSeparatedByString:@":"];
+    NSArray* page = [self.pageCache objectWithName:name];
+    NSUInteger rowInPage = [page indexOfObject:object];
+    if (NSNotFound != rowInPage) {
+      NSInteger section = [[components objectAtIndex:0] integerValue];
+      NSInteger pageIndex = [[components objectAtIndex:1] integerValue];
+      return [NSIndexPath indexPathForRow:pageIndex * _pageSize + rowInPage inSection:section];
+    }
+  }
+  return nil;
+}
+
+- (NSInteger)tableView:(UITableView *)tableView numberOfRowsInSection:(NSInteger)section {
+  NIDASSERT((NSUInteger)section < self.rowCounts.count || 0 == self.rowCounts.count);
+  if ((NSUInteger)section < self.rowCounts.count) {
+    return [[self.rowCounts objectAtIndex:section] integerValue];
+  }
+  return 0;
+}
+
+- (void)setObjectIndexType:(NITableViewModelObjectIndex)objectIndexType {
+  // Indexing every object would fetch every page.
+  NIDASSERT(NITableViewModelObjectIndexNone == objectIndexType);
+}
+
+@end
@@ -477,6 +477,10 @@ typedef enum {
 
 #import "NITableViewModel.h"
 #import "NIMutableTableViewModel.h"
+#import "NITableViewModelDiff.h"
+#import "NIVirtualTableViewModel.h"
+#import "NITableViewModelSearchIndex.h"
+#import "NITableViewModelSnapshot.h"
 #import "NICellBackgrounds.h"
 #import "NICellCatalog.h"
 #import "NICellFactory.h"
@@ -0,0 +1,70 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <XCTest/XCTest.h>
+
+#import "NimbusCore.h"
+#import "NimbusModels.h"
+
+@interface NICellBackgroundsTests : XCTestCase
+@end
+
+@implementation NICellBackgroundsTests
+
+- (void)testBackgroundsWithTheSameStyleShareImages {
+  NIGroupedCellBackground* background = [[NIGroupedCellBackground alloc] init];
+  NIGroupedCellBackground* otherBackground = [[NIGroupedCellBackground alloc] init];
+  UIImage* image = [background imageForFirst:YES last:NO highlighted:NO drawDivider:YES];
+  XCTAssertEqual(image, [otherBackground imageForFirst:YES last:NO highlighted:NO drawDivider:YES],
+                 @"Backgrounds with the same style should share their images.");
+
+  otherBackground.borderRadius = 10;
+  XCTAssertNotEqual(image, [otherBackground imageForFirst:YES last:NO highlighted:NO drawDivider:YES],
+                    @"Changing the style should draw a new image.");
+  XCTAssertEqual(image, [background imageForFirst:YES last:NO highlighted:NO drawDivider:YES],
+                 @"Other backgrounds should keep their images.");
+}
+
+- (void)testPrerenderedImagesAreShared {
+  NIGroupedCellBackground* background = [[NIGroupedCellBackground alloc] init];
+  background.innerBackgroundColor = [UIColor colorWithRed:0.1 green:0.2 blue:0.3 alpha:1];
+  [background prerenderImagesInBackground];
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while ([background numberOfBytesInMemoryBudget] == 0 && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertTrue([background numberOfBytesInMemoryBudget] > 0, @"The images should have been drawn.");
+}
+
+- (void)testMemoryWarningsEmptyTheSharedImages {
+  NIGroupedCellBackground* background = [[NIGroupedCellBackground alloc] init];
+  background.borderRadius = 7;
+  UIImage* image = [background imageForFirst:NO last:YES highlighted:NO drawDivider:NO];
+
+  [[NSNotificationCenter defaultCenter] postNotificationName:UIApplicationDidReceiveMemoryWarningNotification
+                                                      object:[UIApplication sharedApplication]];
+
+  NIGroupedCellBackground* otherBackground = [[NIGroupedCellBackground alloc] init];
+  otherBackground.borderRadius = 7;
+  XCTAssertNotEqual(image, [otherBackground imageForFirst:NO last:YES highlighted:NO drawDivider:NO],
+                    @"The shared images should have been released.");
+  XCTAssertEqual(image, [background imageForFirst:NO last:YES highlighted:NO drawDivider:NO],
+                 @"Backgrounds should keep the images they have already used.");
+}
+
+@end
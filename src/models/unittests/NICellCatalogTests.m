@@ -41,6 +41,98 @@
                 @"%@'s designated initializer override did not run.", [subtitleCellObject class]);
 }
 
+- (void)testAsynchronousDrawRectBlock {
+  __block NSUInteger numberOfDraws = 0;
+  __block BOOL drewOnMainThread = NO;
+  NIDrawRectBlockCellObject* object =
+      [NIDrawRectBlockCellObject objectWithBlock:^CGFloat(CGRect rect, id drawObject, UITableViewCell *cell) {
+        if (nil == cell) {
+          @synchronized(self) {
+            ++numberOfDraws;
+            drewOnMainThread = drewOnMainThread || [NSThread isMainThread];
+          }
+        }
+        [[UIColor redColor] set];
+        UIRectFill(rect);
+        return 44;
+      } object:nil];
+  object.drawsAsynchronously = YES;
+
+  NIDrawRectBlockCell* cell = [[NIDrawRectBlockCell alloc] initWithStyle:UITableViewCellStyleDefault reuseIdentifier:nil];
+  cell.frame = CGRectMake(0, 0, 320, 44);
+  [cell shouldUpdateCellWithObject:object];
+  [cell layoutIfNeeded];
+  XCTAssertTrue(cell.blockView.hidden, @"The block view doesn't draw asynchronous objects.");
+
+  CALayer* contentLayer = nil;
+  for (UIView* view in cell.contentView.subviews) {
+    if (view != cell.blockView && !view.hidden) {
+      contentLayer = view.layer;
+    }
+  }
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (nil == contentLayer.contents && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertNotNil(contentLayer.contents, @"The rendered bitmap should be the layer's contents.");
+  XCTAssertFalse(drewOnMainThread, @"The block should have drawn on a background queue.");
+
+  // A reused cell showing the same object at the same size uses the kept bitmap.
+  [cell prepareForReuse];
+  [cell shouldUpdateCellWithObject:object];
+  [cell layoutIfNeeded];
+  XCTAssertNotNil(contentLayer.contents, @"The kept bitmap should be shown immediately.");
+  XCTAssertEqual(numberOfDraws, (NSUInteger)1, @"The object should only have been drawn once.");
+
+  // Memory warnings drop the kept bitmaps, so the next reuse draws again.
+  [[NSNotificationCenter defaultCenter] postNotificationName:UIApplicationDidReceiveMemoryWarningNotification
+                                                      object:[UIApplication sharedApplication]];
+  [cell prepareForReuse];
+  [cell shouldUpdateCellWithObject:object];
+  [cell layoutIfNeeded];
+  timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  NSUInteger numberOfDrawsAfterWarning = 0;
+  while (numberOfDrawsAfterWarning < 2 && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    @synchronized(self) {
+      numberOfDrawsAfterWarning = numberOfDraws;
+    }
+  }
+  XCTAssertEqual(numberOfDrawsAfterWarning, (NSUInteger)2, @"The object should have been drawn again.");
+}
+
+- (void)testFormElementValueBinding {
+  NISliderFormElement* slider = [NISliderFormElement sliderElementWithID:1 labelText:@"Volume" value:0.25f minimumValue:0 maximumValue:1];
+  NISliderFormElementCell* cell = [[NISliderFormElementCell alloc] initWithStyle:UITableViewCellStyleDefault reuseIdentifier:nil];
+  [cell shouldUpdateCellWithObject:slider];
+
+  __block NSUInteger numberOfNotifications = 0;
+  __block float observedValue = 0;
+  [slider addValueObserver:^(NISliderFormElement* element) {
+    ++numberOfNotifications;
+    observedValue = element.value;
+  }];
+
+  slider.value = 0.5f;
+  slider.value = 0.75f;
+  slider.labelText = @"Level";
+  XCTAssertEqualWithAccuracy(cell.sliderControl.value, 0.75f, 0.0001f, @"The bound control should update in place.");
+  XCTAssertEqualObjects(cell.textLabel.text, @"Level", @"The bound label should update in place.");
+  XCTAssertEqual(numberOfNotifications, (NSUInteger)0, @"Observers are notified on the next run loop turn.");
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (0 == numberOfNotifications && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertEqual(numberOfNotifications, (NSUInteger)1, @"Changes within one turn should be coalesced.");
+  XCTAssertEqualWithAccuracy(observedValue, 0.75f, 0.0001f, @"Observers should see the latest value.");
+
+  // A reused cell no longer follows the element.
+  [cell prepareForReuse];
+  slider.value = 0.1f;
+  XCTAssertEqualWithAccuracy(cell.sliderControl.value, 0.75f, 0.0001f, @"An unbound cell should not update.");
+}
+
 @end
 
 @implementation TestTitleCellObject
@@ -21,6 +21,78 @@
 #import "NimbusCore.h"
 #import "NimbusModels.h"
 
+static NSInteger sNumberOfHeightCalculations = 0;
+
+@interface NICellFactoryTestsHeightCell : UITableViewCell <NICell>
+@end
+
+@implementation NICellFactoryTestsHeightCell
+
+- (BOOL)shouldUpdateCellWithObject:(id)object {
+  return YES;
+}
+
++ (CGFloat)heightForObject:(id)object atIndexPath:(NSIndexPath *)indexPath tableView:(UITableView *)tableView {
+  ++sNumberOfHeightCalculations;
+  return 10 + indexPath.row;
+}
+
+@end
+
+@interface NICellFactoryTestsWidthCell : UITableViewCell <NICell>
+@end
+
+@implementation NICellFactoryTestsWidthCell
+
+- (BOOL)shouldUpdateCellWithObject:(id)object {
+  return YES;
+}
+
++ (CGFloat)heightForObject:(id)object atIndexPath:(NSIndexPath *)indexPath tableWidth:(CGFloat)tableWidth {
+  return tableWidth / 10 + indexPath.row;
+}
+
+@end
+
+static NSInteger sNumberOfCellUpdates = 0;
+
+@interface NICellFactoryTestsVersionedObject : NSObject <NICellObject>
+@property (nonatomic, assign) NSUInteger cellObjectVersion;
+@end
+
+@interface NICellFactoryTestsCountingCell : UITableViewCell <NICell>
+@end
+
+@implementation NICellFactoryTestsCountingCell
+
+- (BOOL)shouldUpdateCellWithObject:(id)object {
+  ++sNumberOfCellUpdates;
+  return YES;
+}
+
+@end
+
+@implementation NICellFactoryTestsVersionedObject
+
+- (Class)cellClass {
+  return [NICellFactoryTestsCountingCell class];
+}
+
+@end
+
+// Always hands back the same cell, as a table view does when a row scrolls out and back in.
+@interface NICellFactoryTestsReusingTableView : UITableView
+@property (nonatomic, strong) UITableViewCell* reusableCell;
+@end
+
+@implementation NICellFactoryTestsReusingTableView
+
+- (id)dequeueReusableCellWithIdentifier:(NSString *)identifier {
+  return self.reusableCell;
+}
+
+@end
+
 @interface NICellFactoryTests : XCTestCase
 @end
 
@@ -47,4 +119,176 @@
   XCTAssertEqual(map.count, (NSUInteger)3, @"Should now be three classes mapped.");
 }
 
+- (void)testCellClassResolutionFollowsRemapping {
+  NICellFactory* factory = [[NICellFactory alloc] init];
+  UITableView* tableView = [[UITableView alloc] initWithFrame:CGRectMake(0, 0, 320, 480)];
+  NSIndexPath* indexPath = [NSIndexPath indexPathForRow:0 inSection:0];
+
+  // @"" is the constant NSString class, so it resolves through its superclass's mapping.
+  [factory mapObjectClass:[NSString class] toCellClass:[NICellFactoryTestsHeightCell class]];
+  UITableViewCell* cell = [factory tableViewModel:nil cellForTableView:tableView atIndexPath:indexPath withObject:@""];
+  XCTAssertTrue([cell isKindOfClass:[NICellFactoryTestsHeightCell class]], @"The superclass mapping should be used.");
+  XCTAssertEqualObjects(cell.reuseIdentifier, @"NICellFactoryTestsHeightCell");
+
+  [factory mapObjectClass:[NSString class] toCellClass:[NICellFactoryTestsWidthCell class]];
+  cell = [factory tableViewModel:nil cellForTableView:tableView atIndexPath:indexPath withObject:@""];
+  XCTAssertTrue([cell isKindOfClass:[NICellFactoryTestsWidthCell class]],
+                @"Mapping a class should replace what its subclasses resolved to.");
+  XCTAssertEqualObjects(cell.reuseIdentifier, @"NICellFactoryTestsWidthCell");
+}
+
+- (void)testActionsResolveClassesAttachedAfterLookup {
+  NIActions* actions = [[NIActions alloc] init];
+  [actions attachToClass:[NSNumber class] tapBlock:^BOOL(id object, id target, NSIndexPath* indexPath) {
+    return YES;
+  }];
+
+  XCTAssertTrue([actions isObjectActionable:@1], @"Subclasses of NSNumber should be actionable.");
+  XCTAssertFalse([actions isObjectActionable:@""], @"Strings should not be actionable.");
+  XCTAssertFalse([actions isObjectActionable:@""], @"Strings should still not be actionable.");
+
+  [actions attachToClass:[NSString class] detailBlock:^BOOL(id object, id target, NSIndexPath* indexPath) {
+    return YES;
+  }];
+  XCTAssertEqual([actions attachedActionTypesForObject:@""], NIActionTypeDetail,
+                 @"Attaching to a class should replace what its subclasses resolved to before.");
+  XCTAssertEqual([actions attachedActionTypesForObject:@1], NIActionTypeTap,
+                 @"Other resolutions should be unaffected.");
+
+  [actions attachToClass:[@"" class] tapBlock:^BOOL(id object, id target, NSIndexPath* indexPath) {
+    return YES;
+  }];
+  XCTAssertEqual([actions attachedActionTypesForObject:@""], NIActionTypeTap,
+                 @"The nearest ancestor's actions should win.");
+  XCTAssertEqual([actions attachedActionTypesForObject:[NSMutableString string]], NIActionTypeDetail,
+                 @"Attaching to a subclass should not change the actions of its superclass.");
+}
+
+- (void)testActionsAttachedToManyObjects {
+  NIActions* actions = [[NIActions alloc] init];
+  NSArray* objects = @[[[NSObject alloc] init], [[NSObject alloc] init], [[NSObject alloc] init]];
+  NSArray* attached = [actions attachToObjects:objects tapBlock:^BOOL(id object, id target, NSIndexPath* indexPath) {
+    return YES;
+  }];
+  XCTAssertEqual(attached, objects, @"The objects should be returned.");
+  for (id object in objects) {
+    XCTAssertEqual([actions attachedActionTypesForObject:object], NIActionTypeTap, @"Every object should be tappable.");
+  }
+
+  // Changing one object's actions must not leak into the objects it shares actions with.
+  [actions attachToObject:objects[0] detailSelector:@selector(description)];
+  XCTAssertEqual([actions attachedActionTypesForObject:objects[0]], NIActionTypeTap | NIActionTypeDetail,
+                 @"The changed object should have both actions.");
+  XCTAssertEqual([actions attachedActionTypesForObject:objects[1]], NIActionTypeTap,
+                 @"The other objects should be unchanged.");
+
+  [actions attachToObjects:@[objects[0], objects[1]] navigationSelector:@selector(description)];
+  XCTAssertEqual([actions attachedActionTypesForObject:objects[0]], NIActionTypeTap | NIActionTypeDetail | NIActionTypeNavigate,
+                 @"Existing actions should be kept.");
+  XCTAssertEqual([actions attachedActionTypesForObject:objects[1]], NIActionTypeTap | NIActionTypeNavigate,
+                 @"Existing actions should be kept.");
+  XCTAssertEqual([actions attachedActionTypesForObject:objects[2]], NIActionTypeTap,
+                 @"Objects left out should be unchanged.");
+}
+
+- (void)testActionsAttachedByPredicate {
+  NIActions* actions = [[NIActions alloc] init];
+  [actions attachToClass:[NSString class] tapSelector:@selector(description)];
+  [actions attachToObjectsMatchingPredicate:[NSPredicate predicateWithFormat:@"SELF BEGINSWITH 'Setting'"]
+                                detailBlock:^BOOL(id object, id target, NSIndexPath* indexPath) {
+                                  return YES;
+                                }];
+
+  XCTAssertEqual([actions attachedActionTypesForObject:@"Setting 1"], NIActionTypeDetail,
+                 @"Predicates should be checked before classes.");
+  XCTAssertEqual([actions attachedActionTypesForObject:@"Other"], NIActionTypeTap,
+                 @"Objects that don't match should fall back to their class.");
+
+  NSString* object = @"Setting 2";
+  [actions attachToObject:object navigationSelector:@selector(description)];
+  XCTAssertEqual([actions attachedActionTypesForObject:object], NIActionTypeNavigate,
+                 @"Objects should be checked before predicates.");
+}
+
+- (void)testCachedRowHeights {
+  NICellFactory* factory = [[NICellFactory alloc] init];
+  [factory mapObjectClass:[NSString class] toCellClass:[NICellFactoryTestsHeightCell class]];
+  factory.cachesRowHeights = YES;
+  NIMutableTableViewModel* model = [[NIMutableTableViewModel alloc] initWithDelegate:factory];
+  [model addObject:[NSMutableString stringWithString:@"First"]];
+  [model addObject:[NSMutableString stringWithString:@"Second"]];
+  UITableView* tableView = [[UITableView alloc] initWithFrame:CGRectMake(0, 0, 320, 480)];
+  NSIndexPath* secondIndexPath = [NSIndexPath indexPathForRow:1 inSection:0];
+
+  sNumberOfHeightCalculations = 0;
+  XCTAssertEqual([factory tableView:tableView heightForRowAtIndexPath:secondIndexPath model:model], (CGFloat)11);
+  XCTAssertEqual([factory tableView:tableView heightForRowAtIndexPath:secondIndexPath model:model], (CGFloat)11);
+  XCTAssertEqual(sNumberOfHeightCalculations, 1, @"The second height should have come from the cache.");
+
+  tableView.frame = CGRectMake(0, 0, 480, 320);
+  [factory tableView:tableView heightForRowAtIndexPath:secondIndexPath model:model];
+  XCTAssertEqual(sNumberOfHeightCalculations, 2, @"A new width should be measured again.");
+  tableView.frame = CGRectMake(0, 0, 320, 480);
+  [factory tableView:tableView heightForRowAtIndexPath:secondIndexPath model:model];
+  XCTAssertEqual(sNumberOfHeightCalculations, 2, @"The first width should still be cached.");
+
+  [model removeObjectAtIndexPath:[NSIndexPath indexPathForRow:0 inSection:0]];
+  XCTAssertEqual([factory tableView:tableView heightForRowAtIndexPath:[NSIndexPath indexPathForRow:0 inSection:0] model:model],
+                 (CGFloat)10, @"Mutating the model should drop the cached heights.");
+
+  [factory tableView:tableView heightForRowAtIndexPath:[NSIndexPath indexPathForRow:0 inSection:0] model:model];
+  XCTAssertEqual(sNumberOfHeightCalculations, 3);
+  [factory invalidateRowHeightForObject:[model objectAtIndexPath:[NSIndexPath indexPathForRow:0 inSection:0]]];
+  [factory tableView:tableView heightForRowAtIndexPath:[NSIndexPath indexPathForRow:0 inSection:0] model:model];
+  XCTAssertEqual(sNumberOfHeightCalculations, 4, @"An invalidated object should be measured again.");
+}
+
+- (void)testUnchangedObjectVersionsSkipCellUpdates {
+  NICellFactoryTestsReusingTableView* tableView = [[NICellFactoryTestsReusingTableView alloc] initWithFrame:CGRectMake(0, 0, 320, 480)];
+  tableView.reusableCell = [[NICellFactoryTestsCountingCell alloc] initWithStyle:UITableViewCellStyleDefault reuseIdentifier:nil];
+  NICellFactoryTestsVersionedObject* object = [[NICellFactoryTestsVersionedObject alloc] init];
+  NICellFactoryTestsVersionedObject* otherObject = [[NICellFactoryTestsVersionedObject alloc] init];
+  NSIndexPath* indexPath = [NSIndexPath indexPathForRow:0 inSection:0];
+
+  sNumberOfCellUpdates = 0;
+  [NICellFactory tableViewModel:nil cellForTableView:tableView atIndexPath:indexPath withObject:object];
+  [NICellFactory tableViewModel:nil cellForTableView:tableView atIndexPath:indexPath withObject:object];
+  XCTAssertEqual(sNumberOfCellUpdates, 1, @"The same object version should only be applied once.");
+
+  object.cellObjectVersion++;
+  [NICellFactory tableViewModel:nil cellForTableView:tableView atIndexPath:indexPath withObject:object];
+  XCTAssertEqual(sNumberOfCellUpdates, 2, @"A new version should be applied.");
+
+  [NICellFactory tableViewModel:nil cellForTableView:tableView atIndexPath:indexPath withObject:otherObject];
+  XCTAssertEqual(sNumberOfCellUpdates, 3, @"A different object should be applied.");
+}
+
+- (void)testPrecomputedRowHeights {
+  NICellFactory* factory = [[NICellFactory alloc] init];
+  [factory mapObjectClass:[NSNumber class] toCellClass:[NICellFactoryTestsWidthCell class]];
+  factory.estimatedRowHeight = 5;
+  NIMutableTableViewModel* model = [[NIMutableTableViewModel alloc] initWithDelegate:factory];
+  for (NSInteger ix = 0; ix < 250; ++ix) {
+    [model addObject:[NSNumber numberWithInteger:ix]];
+  }
+  UITableView* tableView = [[UITableView alloc] initWithFrame:CGRectMake(0, 0, 320, 480)];
+  NSIndexPath* lastIndexPath = [NSIndexPath indexPathForRow:249 inSection:0];
+
+  [factory precomputeRowHeightsForTableView:tableView model:model];
+  XCTAssertTrue(factory.cachesRowHeights, @"Precomputing should turn on the cache.");
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  while ([factory tableView:tableView estimatedHeightForRowAtIndexPath:lastIndexPath model:model] == 5
+         && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertEqual([factory tableView:tableView estimatedHeightForRowAtIndexPath:lastIndexPath model:model], (CGFloat)281,
+                 @"Every chunk's heights should have been applied.");
+
+  [model addObject:[NSNumber numberWithInteger:250]];
+  XCTAssertEqual([factory tableView:tableView estimatedHeightForRowAtIndexPath:lastIndexPath model:model], (CGFloat)5,
+                 @"Mutating the model should drop the precomputed heights.");
+  XCTAssertEqual([factory tableView:tableView heightForRowAtIndexPath:lastIndexPath model:model], (CGFloat)281,
+                 @"Cells with only a table width sizing method should be measured on demand.");
+}
+
 @end
@@ -141,4 +141,121 @@
   XCTAssertTrue([[model tableView:nil titleForHeaderInSection:0] isEqual:@"Section 0"], @"The section title should have been set.");
 }
 
+- (void)testSectionIndexFollowsSectionChanges {
+  NIMutableTableViewModel* model = [[NIMutableTableViewModel alloc] initWithDelegate:nil];
+  [model addSectionWithTitle:@"Banana"];
+  [model addSectionWithTitle:@"Cherry"];
+  [model setSectionIndexType:NITableViewModelSectionIndexDynamic showsSearch:NO showsSummary:NO];
+
+  [model insertSectionWithTitle:@"Apple" atIndex:0];
+  [model insertSectionWithTitle:@"Blueberry" atIndex:2];
+  [model removeSectionAtIndex:1];
+  [model updateSectionIndex];
+
+  NSArray* expectedTitles = [NSArray arrayWithObjects:@"A", @"B", @"C", nil];
+  XCTAssertEqualObjects([model sectionIndexTitlesForTableView:nil], expectedTitles, @"Each section's prefix should be in the index.");
+  XCTAssertEqual([model tableView:nil sectionForSectionIndexTitle:@"A" atIndex:0], 0, @"Apple is the first section.");
+  XCTAssertEqual([model tableView:nil sectionForSectionIndexTitle:@"B" atIndex:1], 1, @"Blueberry replaced Banana.");
+  XCTAssertEqual([model tableView:nil sectionForSectionIndexTitle:@"C" atIndex:2], 2, @"Cherry moved down by one.");
+}
+
+- (void)assertObjectIndexOfModel:(NIMutableTableViewModel *)model matchesObjects:(NSArray *)objects {
+  NITableViewModelObjectIndex objectIndexType = model.objectIndexType;
+  NSMutableArray* indexPaths = [NSMutableArray array];
+  for (id object in objects) {
+    [indexPaths addObject:[model indexPathForObject:object] ?: [NSNull null]];
+  }
+  model.objectIndexType = NITableViewModelObjectIndexNone;
+  for (NSUInteger ix = 0; ix < objects.count; ++ix) {
+    id indexPath = [model indexPathForObject:[objects objectAtIndex:ix]] ?: [NSNull null];
+    XCTAssertEqualObjects([indexPaths objectAtIndex:ix], indexPath,
+                          @"The index should match a scan for %@.", [objects objectAtIndex:ix]);
+  }
+  model.objectIndexType = objectIndexType;
+}
+
+- (void)testObjectIndexFollowsMutations {
+  NIMutableTableViewModel* model = [[NIMutableTableViewModel alloc] initWithDelegate:nil];
+  model.objectIndexType = NITableViewModelObjectIndexEquality;
+  NSArray* objects = @[@"a", @"b", @"c", @"d", @"e"];
+
+  [model addObjectsFromArray:objects];
+  [model addSectionWithTitle:@"Second"];
+  [model addObject:@"b" toSection:1];
+  [model addObject:@"f" toSection:1];
+  XCTAssertEqualObjects([model indexPathForObject:@"b"], [NSIndexPath indexPathForRow:1 inSection:0]);
+  XCTAssertEqualObjects([model indexPathForObject:@"f"], [NSIndexPath indexPathForRow:1 inSection:1]);
+
+  [model insertObject:@"c" atRow:0 inSection:0];
+  XCTAssertEqualObjects([model indexPathForObject:@"c"], [NSIndexPath indexPathForRow:0 inSection:0]);
+  XCTAssertEqualObjects([model indexPathForObject:@"e"], [NSIndexPath indexPathForRow:5 inSection:0]);
+  [self assertObjectIndexOfModel:model matchesObjects:[objects arrayByAddingObject:@"f"]];
+
+  [model removeObjectAtIndexPath:[NSIndexPath indexPathForRow:2 inSection:0]];
+  XCTAssertEqualObjects([model indexPathForObject:@"b"], [NSIndexPath indexPathForRow:0 inSection:1],
+                        @"Removing the first b should find the second one.");
+
+  [model insertSectionWithTitle:@"First" atIndex:0];
+  [model addObject:@"g" toSection:0];
+  XCTAssertEqualObjects([model indexPathForObject:@"f"], [NSIndexPath indexPathForRow:1 inSection:2]);
+  [self assertObjectIndexOfModel:model matchesObjects:[objects arrayByAddingObjectsFromArray:@[@"f", @"g"]]];
+
+  [model removeSectionAtIndex:1];
+  XCTAssertNil([model indexPathForObject:@"a"]);
+  XCTAssertEqualObjects([model indexPathForObject:@"b"], [NSIndexPath indexPathForRow:0 inSection:1]);
+  [self assertObjectIndexOfModel:model matchesObjects:[objects arrayByAddingObjectsFromArray:@[@"f", @"g"]]];
+}
+
+- (void)testIdentityObjectIndex {
+  NIMutableTableViewModel* model = [[NIMutableTableViewModel alloc] initWithDelegate:nil];
+  NSMutableString* object = [NSMutableString stringWithString:@"row"];
+  [model addObject:[NSMutableString stringWithString:@"row"]];
+  [model addObject:object];
+
+  model.objectIndexType = NITableViewModelObjectIndexIdentity;
+  XCTAssertEqualObjects([model indexPathForObject:object], [NSIndexPath indexPathForRow:1 inSection:0],
+                        @"An identity index should not match an equal object.");
+}
+
+- (void)testBatchUpdatesReturnOneDiff {
+  NIMutableTableViewModel* model = [[NIMutableTableViewModel alloc] initWithDelegate:nil];
+  model.objectIndexType = NITableViewModelObjectIndexIdentity;
+  [model addObjectsFromArray:@[@1, @2]];
+
+  NSMutableArray* page = [NSMutableArray array];
+  for (NSInteger ix = 0; ix < 500; ++ix) {
+    [page addObject:[NSNumber numberWithInteger:100 + ix]];
+  }
+  NITableViewModelDiff* diff = [model performBatchUpdates:^(NIMutableTableViewModel* batchModel) {
+    [batchModel removeObjectAtIndexPath:[NSIndexPath indexPathForRow:0 inSection:0]];
+    NITableViewModelDiff* innerDiff = [batchModel performBatchUpdates:^(NIMutableTableViewModel* innerModel) {
+      [innerModel addObjectsFromArray:page];
+    }];
+    XCTAssertNil(innerDiff, @"Nested batches are part of the outer batch.");
+    [batchModel updateSectionIndex];
+  }];
+
+  XCTAssertEqual(diff.deletedIndexPaths.count, (NSUInteger)1, @"One row was removed.");
+  XCTAssertEqual(diff.insertedIndexPaths.count, (NSUInteger)500, @"The page should be inserted.");
+  XCTAssertEqualObjects(diff.insertedIndexPaths.lastObject, [NSIndexPath indexPathForRow:500 inSection:0],
+                        @"Inserted rows should have their final index paths.");
+  XCTAssertEqualObjects([model indexPathForObject:[page lastObject]], [NSIndexPath indexPathForRow:500 inSection:0],
+                        @"The object index should be rebuilt after the batch.");
+}
+
+- (void)testApplyingAStaleDiffAdoptsItsContents {
+  NIMutableTableViewModel* model = [[NIMutableTableViewModel alloc] initWithDelegate:nil];
+  [model addObjectsFromArray:@[@1, @2]];
+  NITableViewModelDiff* diff = [NITableViewModelDiff diffFromSectionedArray:@[@1, @2]
+                                                           toSectionedArray:@[@1, @2, @3]];
+
+  // The model changes while the diff is computed elsewhere.
+  [model addObject:@4];
+  [model applyDiff:diff withTableView:nil];
+
+  XCTAssertEqual([model tableView:nil numberOfRowsInSection:0], (NSInteger)3,
+                 @"The diff's contents should replace the model's.");
+  XCTAssertEqualObjects([model objectAtIndexPath:[NSIndexPath indexPathForRow:2 inSection:0]], @3);
+}
+
 @end
@@ -0,0 +1,92 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NimbusCore.h"
+#import "NimbusModels.h"
+
+@interface NITableViewActionsTestsDelegate : NSObject <UITableViewDelegate>
+@end
+
+@implementation NITableViewActionsTestsDelegate
+
+- (CGFloat)tableView:(UITableView *)tableView heightForRowAtIndexPath:(NSIndexPath *)indexPath {
+  return 80;
+}
+
+@end
+
+// Forwards the table's estimated heights to a cell factory, as NICellFactory's docs describe.
+@interface NITableViewActionsTestsEstimatingDelegate : NSObject <UITableViewDelegate>
+@property (nonatomic, strong) NICellFactory* cellFactory;
+@property (nonatomic, strong) NITableViewModel* model;
+@end
+
+@implementation NITableViewActionsTestsEstimatingDelegate
+
+- (CGFloat)tableView:(UITableView *)tableView estimatedHeightForRowAtIndexPath:(NSIndexPath *)indexPath {
+  return [self.cellFactory tableView:tableView estimatedHeightForRowAtIndexPath:indexPath model:self.model];
+}
+
+@end
+
+@interface NITableViewActionsTests : XCTestCase
+@end
+
+
+@implementation NITableViewActionsTests
+
+
+- (void)testForwardedMethodsAreSentStraightToTheDelegate {
+  NITableViewActions* actions = [[NITableViewActions alloc] initWithTarget:nil];
+  NITableViewActionsTestsDelegate* delegate = [[NITableViewActionsTestsDelegate alloc] init];
+  SEL heightSelector = @selector(tableView:heightForRowAtIndexPath:);
+
+  XCTAssertFalse([actions respondsToSelector:heightSelector]);
+
+  id<UITableViewDelegate> tableViewDelegate = [actions forwardingTo:delegate];
+  XCTAssertTrue([tableViewDelegate respondsToSelector:heightSelector]);
+  XCTAssertEqual([actions forwardingTargetForSelector:heightSelector], delegate);
+  XCTAssertEqual([tableViewDelegate tableView:nil heightForRowAtIndexPath:nil], (CGFloat)80);
+  XCTAssertFalse([actions respondsToSelector:@selector(tableView:viewForHeaderInSection:)],
+                 @"Methods that no delegate implements should not be claimed.");
+
+  [actions removeForwarding:delegate];
+  XCTAssertFalse([actions respondsToSelector:heightSelector]);
+}
+
+- (void)testEstimatedHeightsAreForwardedToTheCellFactory {
+  NITableViewActions* actions = [[NITableViewActions alloc] initWithTarget:nil];
+  NITableViewActionsTestsEstimatingDelegate* delegate =
+      [[NITableViewActionsTestsEstimatingDelegate alloc] init];
+  delegate.cellFactory = [[NICellFactory alloc] init];
+  delegate.cellFactory.estimatedRowHeight = 33;
+  delegate.model = [[NITableViewModel alloc] initWithListArray:@[@"a"] delegate:delegate.cellFactory];
+  UITableView* tableView = [[UITableView alloc] initWithFrame:CGRectMake(0, 0, 320, 480)];
+  tableView.dataSource = delegate.model;
+  tableView.delegate = [actions forwardingTo:delegate];
+
+  NSIndexPath* indexPath = [NSIndexPath indexPathForRow:0 inSection:0];
+  XCTAssertTrue([tableView.delegate respondsToSelector:@selector(tableView:estimatedHeightForRowAtIndexPath:)],
+                @"The table should see the estimate through the actions.");
+  XCTAssertEqual([tableView.delegate tableView:tableView estimatedHeightForRowAtIndexPath:indexPath],
+                 (CGFloat)33);
+}
+
+@end
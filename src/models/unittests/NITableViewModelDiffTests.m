@@ -0,0 +1,90 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NimbusCore.h"
+#import "NimbusModels.h"
+
+static NSIndexPath* NIRow(NSInteger row, NSInteger section) {
+  return [NSIndexPath indexPathForRow:row inSection:section];
+}
+
+@interface NITableViewModelDiffTests : XCTestCase
+@end
+
+
+@implementation NITableViewModelDiffTests
+
+
+- (void)testIdenticalContentsHaveNoChanges {
+  NSArray* contents = @[@"Section", @1, @2, @3];
+  NITableViewModelDiff* diff = [NITableViewModelDiff diffFromSectionedArray:contents toSectionedArray:[contents copy]];
+  XCTAssertFalse(diff.hasChanges, @"The same contents should not change anything.");
+}
+
+- (void)testRowChangesWithinASection {
+  NITableViewModelDiff* diff = [NITableViewModelDiff diffFromSectionedArray:@[@1, @2, @3, @4]
+                                                           toSectionedArray:@[@2, @1, @4, @5]];
+  XCTAssertEqualObjects(diff.deletedIndexPaths, @[NIRow(2, 0)], @"The 3 should be deleted.");
+  XCTAssertEqualObjects(diff.insertedIndexPaths, @[NIRow(3, 0)], @"The 5 should be inserted.");
+  XCTAssertTrue([diff.movedToIndexPaths containsObject:NIRow(0, 0)], @"The 2 should move up.");
+  XCTAssertFalse([diff.movedFromIndexPaths containsObject:NIRow(3, 0)],
+                 @"The 4 is only shifted by the deletion before it.");
+  XCTAssertEqual(diff.reloadedIndexPaths.count, (NSUInteger)0, @"Nothing should be reloaded.");
+}
+
+- (void)testRowsOfRemovedSectionsAreInserted {
+  NITableViewModelDiff* diff = [NITableViewModelDiff diffFromSectionedArray:@[@"A", @1, @"B", @2]
+                                                           toSectionedArray:@[@"B", @2, @1]];
+  XCTAssertEqualObjects(diff.deletedSections, [NSIndexSet indexSetWithIndex:0], @"Section A should be deleted.");
+  XCTAssertEqual(diff.insertedSections.count, (NSUInteger)0, @"No section should be inserted.");
+  XCTAssertEqual(diff.movedFromSections.count, (NSUInteger)0,
+                 @"Section B is only shifted by the deletion before it.");
+  XCTAssertEqual(diff.deletedIndexPaths.count, (NSUInteger)0, @"Rows of deleted sections go with them.");
+  XCTAssertEqualObjects(diff.insertedIndexPaths, @[NIRow(1, 0)],
+                        @"A row can't move out of a deleted section, so it is inserted.");
+}
+
+- (void)testEqualObjectsAreReloaded {
+  NSDictionary* oldRow = [NSDictionary dictionaryWithObject:@"Row" forKey:@"title"];
+  NSDictionary* newRow = [NSDictionary dictionaryWithObject:@"Row" forKey:@"title"];
+  NITableViewModelDiff* diff = [NITableViewModelDiff diffFromSectionedArray:@[@1, oldRow]
+                                                           toSectionedArray:@[@1, newRow]];
+  XCTAssertEqualObjects(diff.reloadedIndexPaths, @[NIRow(1, 0)], @"Equal objects should be reloaded.");
+  XCTAssertEqual(diff.insertedIndexPaths.count + diff.deletedIndexPaths.count, (NSUInteger)0,
+                 @"Equal objects should be matched.");
+}
+
+- (void)testSettingSectionedArrayReplacesContents {
+  NIMutableTableViewModel* model = [[NIMutableTableViewModel alloc] initWithDelegate:nil];
+  model.objectIndexType = NITableViewModelObjectIndexEquality;
+  [model addObjectsFromArray:@[@1, @2, @3]];
+
+  NITableViewModelDiff* diff = [model setSectionedArray:@[@3, @"Second", @1, @4] diffingWithTableView:nil];
+  XCTAssertTrue(diff.hasChanges, @"The contents changed.");
+  XCTAssertEqual([model numberOfSectionsInTableView:nil], 2, @"There should be two sections.");
+  XCTAssertEqualObjects([model indexPathForObject:@1], NIRow(0, 1), @"The object index should be updated.");
+  XCTAssertNil([model indexPathForObject:@2], @"Removed objects should be gone.");
+
+  [model addObject:@5];
+  XCTAssertEqual([model tableView:nil numberOfRowsInSection:1], 3, @"The new contents should be mutable.");
+}
+
+@end
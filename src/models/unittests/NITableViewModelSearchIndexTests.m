@@ -0,0 +1,89 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NimbusCore.h"
+#import "NimbusModels.h"
+
+@interface NITableViewModelSearchIndexTests : XCTestCase
+@end
+
+
+@implementation NITableViewModelSearchIndexTests
+
+
+- (NSArray *)titlesOfModel:(NITableViewModel *)model {
+  NSMutableArray* titles = [NSMutableArray array];
+  NSInteger numberOfSections = [model numberOfSectionsInTableView:nil];
+  for (NSInteger section = 0; section < numberOfSections; ++section) {
+    NSInteger numberOfRows = [model tableView:nil numberOfRowsInSection:section];
+    for (NSInteger row = 0; row < numberOfRows; ++row) {
+      id object = [model objectAtIndexPath:[NSIndexPath indexPathForRow:row inSection:section]];
+      [titles addObject:[object objectForKey:@"title"]];
+    }
+  }
+  return titles;
+}
+
+- (BOOL)waitForModel:(NITableViewModel *)model toHaveTitles:(NSArray *)titles {
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (![[self titlesOfModel:model] isEqualToArray:titles] && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  return [[self titlesOfModel:model] isEqualToArray:titles];
+}
+
+- (void)testSearchMatchesPrefixesOfWords {
+  NSArray* contents = @[@"Fruit",
+                        @{@"title": @"Apple"},
+                        @{@"title": @"Apricot"},
+                        @{@"title": @"Blood Orange"},
+                        @"Vegetables",
+                        @{@"title": @"Artichoke"},
+                        @{@"title": @"Broccoli"}];
+  NITableViewModel* model = [[NITableViewModel alloc] initWithSectionedArray:contents delegate:nil];
+  NITableViewModelSearchIndex* searchIndex =
+      [[NITableViewModelSearchIndex alloc] initWithModel:model searchKeyBlock:^NSString *(id object) {
+        return [object objectForKey:@"title"];
+      }];
+
+  [searchIndex searchForText:@"a"];
+  XCTAssertTrue([self waitForModel:searchIndex.searchResultsModel toHaveTitles:@[@"Apple", @"Apricot", @"Artichoke"]]);
+  XCTAssertEqual([searchIndex.searchResultsModel numberOfSectionsInTableView:nil], 2,
+                 @"Rows should stay in their sections.");
+
+  [searchIndex searchForText:@"APR"];
+  XCTAssertTrue([self waitForModel:searchIndex.searchResultsModel toHaveTitles:@[@"Apricot"]]);
+  XCTAssertEqualObjects([searchIndex.searchResultsModel tableView:nil titleForHeaderInSection:0], @"Fruit");
+
+  [searchIndex searchForText:@"ora"];
+  [searchIndex searchForText:@"ran"];
+  XCTAssertTrue([self waitForModel:searchIndex.searchResultsModel toHaveTitles:@[]],
+                @"Words should only match from their start.");
+
+  [searchIndex searchForText:@"bl ora"];
+  XCTAssertTrue([self waitForModel:searchIndex.searchResultsModel toHaveTitles:@[@"Blood Orange"]]);
+
+  [searchIndex searchForText:@""];
+  XCTAssertTrue([self waitForModel:searchIndex.searchResultsModel
+                      toHaveTitles:@[@"Apple", @"Apricot", @"Blood Orange", @"Artichoke", @"Broccoli"]]);
+}
+
+@end
@@ -0,0 +1,71 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NimbusCore.h"
+#import "NimbusModels.h"
+
+@interface NITableViewModelSnapshotTests : XCTestCase
+@end
+
+
+@implementation NITableViewModelSnapshotTests
+
+
+- (void)testSnapshotBuiltInTheBackground {
+  NSArray* contents = @[@"Section 1",
+                        @1, @2, @3,
+                        [NITableViewModelFooter footerWithTitle:@"Footer 1"],
+                        @"Empty",
+                        @"Section 3",
+                        @4, @3];
+
+  __block NITableViewModelSnapshot* model = nil;
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    NITableViewModelSnapshot* snapshot = [[NITableViewModelSnapshot alloc] initWithSectionedArray:contents delegate:nil];
+    dispatch_async(dispatch_get_main_queue(), ^{
+      model = snapshot;
+    });
+  });
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (nil == model && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertNotNil(model, @"The snapshot should have been built.");
+
+  XCTAssertEqual([model numberOfSectionsInTableView:nil], 3, @"There should be three sections.");
+  XCTAssertEqual(model.numberOfObjects, (NSUInteger)5, @"Every row should be stored.");
+  XCTAssertEqual([model tableView:nil numberOfRowsInSection:0], 3);
+  XCTAssertEqual([model tableView:nil numberOfRowsInSection:1], 0, @"Empty sections have no rows.");
+  XCTAssertEqual([model tableView:nil numberOfRowsInSection:2], 2);
+  XCTAssertEqualObjects([model tableView:nil titleForFooterInSection:0], @"Footer 1");
+  XCTAssertEqualObjects([model tableView:nil titleForHeaderInSection:2], @"Section 3");
+  XCTAssertEqualObjects([model objectAtIndexPath:[NSIndexPath indexPathForRow:1 inSection:2]], @3);
+
+  XCTAssertEqualObjects([model indexPathForObject:@4], [NSIndexPath indexPathForRow:0 inSection:2]);
+  XCTAssertEqualObjects([model indexPathForObject:@3], [NSIndexPath indexPathForRow:2 inSection:0],
+                        @"The first of two equal rows should be found.");
+  model.objectIndexType = NITableViewModelObjectIndexEquality;
+  XCTAssertEqualObjects([model indexPathForObject:@4], [NSIndexPath indexPathForRow:0 inSection:2],
+                        @"The object index should cover the compacted rows.");
+  XCTAssertEqualObjects([model indexPathForObject:@3], [NSIndexPath indexPathForRow:2 inSection:0]);
+}
+
+@end
@@ -0,0 +1,68 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NimbusCore.h"
+#import "NimbusModels.h"
+
+@interface NIVirtualTableViewModelTests : XCTestCase
+@end
+
+
+@implementation NIVirtualTableViewModelTests
+
+
+- (void)testRowsAreFetchedInPages {
+  NSMutableArray* fetchedRanges = [NSMutableArray array];
+  NIVirtualTableViewModel* model =
+      [[NIVirtualTableViewModel alloc] initWithSectionTitles:@[@"Contacts", [NSNull null]]
+                                                   rowCounts:@[@200000, @3]
+                                                   pageBlock:^NSArray *(NSUInteger section, NSRange rows) {
+                                                     [fetchedRanges addObject:[NSValue valueWithRange:rows]];
+                                                     NSMutableArray* objects = [NSMutableArray array];
+                                                     for (NSUInteger row = rows.location; row < NSMaxRange(rows); ++row) {
+                                                       [objects addObject:[NSString stringWithFormat:@"%lu-%lu", (unsigned long)section, (unsigned long)row]];
+                                                     }
+                                                     return objects;
+                                                   }
+                                                    delegate:nil];
+  model.pageSize = 100;
+  model.maximumNumberOfCachedPages = 2;
+
+  XCTAssertEqual([model numberOfSectionsInTableView:nil], 2, @"There should be two sections.");
+  XCTAssertEqual([model tableView:nil numberOfRowsInSection:0], 200000, @"Counts come from the row counts.");
+  XCTAssertEqualObjects([model tableView:nil titleForHeaderInSection:0], @"Contacts", @"Titles should be kept.");
+  XCTAssertNil([model tableView:nil titleForHeaderInSection:1], @"NSNull is an untitled section.");
+
+  XCTAssertEqualObjects([model objectAtIndexPath:[NSIndexPath indexPathForRow:150 inSection:0]], @"0-150");
+  XCTAssertEqualObjects([model objectAtIndexPath:[NSIndexPath indexPathForRow:199 inSection:0]], @"0-199");
+  XCTAssertEqual(fetchedRanges.count, (NSUInteger)1, @"Rows on the same page should be fetched once.");
+  XCTAssertEqualObjects([model objectAtIndexPath:[NSIndexPath indexPathForRow:2 inSection:1]], @"1-2");
+  XCTAssertTrue(NSEqualRanges([[fetchedRanges lastObject] rangeValue], NSMakeRange(0, 3)),
+                @"The last page should be clipped to the section.");
+
+  [model objectAtIndexPath:[NSIndexPath indexPathForRow:199999 inSection:0]];
+  [model objectAtIndexPath:[NSIndexPath indexPathForRow:150 inSection:0]];
+  XCTAssertEqual(fetchedRanges.count, (NSUInteger)4, @"The least recently used page should have been dropped.");
+  XCTAssertEqualObjects([model indexPathForObject:@"0-199999"], [NSIndexPath indexPathForRow:199999 inSection:0],
+                        @"Objects on cached pages can be found.");
+}
+
+@end
@@ -16,6 +16,22 @@
 
 #import <UIKit/UIKit.h>
 
+@class NIMutableTableViewModel;
+@class NIStreamingTableModelBuilder;
+@class NITableViewModelSnapshot;
+
+/**
+ * The block a page fetch calls once it has finished, on the main thread.
+ *
+ * @param objects The objects on the page, in the format accepted by
+ *                     NIMutableTableViewModel::addObjectsFromArray:. nil if the fetch failed.
+ * @param hasMorePages Whether there is another page after this one.
+ * @param error The error if the fetch failed.
+ *
+ * @ingroup NimbusNetworkControllers
+ */
+typedef void (^NINetworkTableViewPageCompletion)(NSArray* objects, BOOL hasMorePages, NSError* error);
+
 /**
  * The NINetworkTableViewController class provides a similar implementation to UITableViewController
  * but with a more structured view hierarchy.
@@ -29,6 +45,28 @@
  * In this particular implementation we include an activity indicator component which may be used
  * to show that data is currently being loaded.
  *
+ * <h2>Pagination</h2>
+ *
+ * To load a list one page at a time, set model to a NIMutableTableViewModel, set
+ * paginationEnabled to YES and override fetchPage:completion:. The first page is fetched when the
+ * view appears, with the full-screen activity indicator. Each following page is fetched as soon
+ * as a row within prefetchDistance rows of the end of the table is displayed, so the next page is
+ * usually in before the user reaches the end. An activity indicator is shown in the table footer
+ * meanwhile. Its objects are appended to the model in one batch and only the new rows are
+ * inserted into the table; the table is never reloaded. Only one page is ever fetched at a
+ * time.
+ *
+ * The controller is the table view's delegate and uses tableView:willDisplayCell:forRowAtIndexPath:
+ * to watch for the end. Subclasses that implement it must call super.
+ *
+ * <h2>Streaming</h2>
+ *
+ * To show a single large JSON response, build its rows with an NIStreamingTableModelBuilder and
+ * pass it to loadModelWithRequest:builder:. The response is parsed on a background queue as it
+ * downloads, and the first rows are shown as soon as the builder has made them. Every later
+ * snapshot only inserts its new rows at the end of the table. Starting a stream sets model to nil,
+ * so don't combine it with pagination.
+ *
  * @ingroup NimbusNetworkControllers
  */
 @interface NINetworkTableViewController : UIViewController <UITableViewDelegate, UITableViewDataSource>
@@ -42,6 +80,25 @@
 
 - (void)setIsLoading:(BOOL)isLoading;
 
+// Pagination
+@property (nonatomic, strong) NIMutableTableViewModel* model;
+@property (nonatomic, assign) BOOL paginationEnabled; // Default: NO
+@property (nonatomic, assign) NSInteger prefetchDistance; // Default: 10
+@property (nonatomic, readonly, assign) NSInteger numberOfLoadedPages;
+@property (nonatomic, readonly, assign) BOOL hasMorePages;
+@property (nonatomic, readonly, assign, getter = isLoadingPage) BOOL loadingPage;
+@property (nonatomic, readonly, strong) NSError* pageError;
+- (void)loadNextPage;
+- (void)resetPagination;
+
+// Streaming
+- (void)loadModelWithRequest:(NSURLRequest *)request builder:(NIStreamingTableModelBuilder *)builder;
+@property (nonatomic, readonly, strong) NITableViewModelSnapshot* streamedModel;
+@property (nonatomic, readonly, strong) NSError* streamError;
+
+// Subclassing
+- (void)fetchPage:(NSInteger)pageIndex completion:(NINetworkTableViewPageCompletion)completion;
+
 @end
 
 /**
@@ -52,3 +109,108 @@
  *                       When NO, the table view will be shown and the activity indicator hidden.
  * @fn NINetworkTableViewController::setIsLoading:
  */
+
+/** @name Paginating */
+
+/**
+ * The model that fetched pages are appended to.
+ *
+ * Setting a model makes it the table view's data source.
+ *
+ * @fn NINetworkTableViewController::model
+ */
+
+/**
+ * Whether pages are fetched automatically.
+ *
+ * @fn NINetworkTableViewController::paginationEnabled
+ */
+
+/**
+ * How many rows from the end of the table the user may scroll before the next page is fetched.
+ *
+ * @fn NINetworkTableViewController::prefetchDistance
+ */
+
+/**
+ * The number of pages that have been appended to the model.
+ *
+ * @fn NINetworkTableViewController::numberOfLoadedPages
+ */
+
+/**
+ * Whether the last page fetched said there is another page after it.
+ *
+ * YES until the first page has been fetched.
+ *
+ * @fn NINetworkTableViewController::hasMorePages
+ */
+
+/**
+ * Whether a page is being fetched.
+ *
+ * @fn NINetworkTableViewController::loadingPage
+ */
+
+/**
+ * The error of the last page fetch, if it failed.
+ *
+ * Pages are not fetched automatically while there is an error, so that a failing request is not
+ * retried every time a row is displayed. Call loadNextPage to try again.
+ *
+ * @fn NINetworkTableViewController::pageError
+ */
+
+/**
+ * Fetches the next page unless one is already being fetched or there are no more pages.
+ *
+ * @fn NINetworkTableViewController::loadNextPage
+ */
+
+/**
+ * Forgets every loaded page, empties the model and fetches the first page again.
+ *
+ * The completion of a fetch that is in flight when this is called is ignored.
+ *
+ * @fn NINetworkTableViewController::resetPagination
+ */
+
+/** @name Streaming */
+
+/**
+ * Starts streaming the response of the request into the table through the builder.
+ *
+ * Cancels any stream that is in progress and sets model to nil. The full-screen activity indicator
+ * is shown until the builder delivers its first snapshot. The builder's snapshotBlock is replaced.
+ *
+ * @fn NINetworkTableViewController::loadModelWithRequest:builder:
+ */
+
+/**
+ * The latest snapshot delivered by the stream.
+ *
+ * The controller stays the table view's data source and forwards to this snapshot, so that the
+ * table view sees a single data source whose rows only grow.
+ *
+ * @fn NINetworkTableViewController::streamedModel
+ */
+
+/**
+ * The error of the last stream, if it failed.
+ *
+ * The rows of the last snapshot stay in the table.
+ *
+ * @fn NINetworkTableViewController::streamError
+ */
+
+/** @name Subclassing */
+
+/**
+ * Fetches a page of objects. Subclasses must override this to use pagination.
+ *
+ * Call completion exactly once, on the main thread. The default implementation completes
+ * immediately with no objects and no more pages.
+ *
+ * @param pageIndex The index of the page to fetch, starting at 0.
+ * @fn NINetworkTableViewController::fetchPage:completion:
+ */
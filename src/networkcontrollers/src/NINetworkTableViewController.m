@@ -16,7 +16,9 @@
 
 #import "NINetworkTableViewController.h"
 
+#import "NIStreamingTableModelBuilder.h"
 #import "NimbusCore+Additions.h"
+#import "NimbusModels.h"
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "Nimbus requires ARC support."
@@ -25,6 +27,18 @@
 @interface NINetworkTableViewController()
 @property (nonatomic, assign) UIActivityIndicatorViewStyle activityIndicatorStyle;
 @property (nonatomic, assign) UITableViewStyle tableViewStyle;
+
+@property (nonatomic, assign) NSInteger numberOfLoadedPages;
+@property (nonatomic, assign) BOOL hasMorePages;
+@property (nonatomic, assign) BOOL loadingPage;
+@property (nonatomic, strong) NSError* pageError;
+// Incremented by resetPagination so that the completion of a fetch started before it is ignored.
+@property (nonatomic, assign) NSUInteger paginationGeneration;
+@property (nonatomic, strong) UIActivityIndicatorView* pageActivityIndicator;
+
+@property (nonatomic, strong) NIStreamingTableModelBuilder* modelBuilder;
+@property (nonatomic, strong) NITableViewModelSnapshot* streamedModel;
+@property (nonatomic, strong) NSError* streamError;
 @end
 
 
@@ -33,6 +47,7 @@
 
 
 - (void)dealloc {
+  [_modelBuilder cancel];
   _tableView.delegate = nil;
   _tableView.dataSource = nil;
 }
@@ -42,6 +57,8 @@
     self.tableViewStyle = style;
     self.activityIndicatorStyle = activityIndicatorStyle;
     self.clearsSelectionOnViewWillAppear = YES;
+    _prefetchDistance = 10;
+    _hasMorePages = YES;
   }
   return self;
 }
@@ -57,7 +74,7 @@
   self.tableView = [[UITableView alloc] initWithFrame:self.view.bounds style:self.tableViewStyle];
   self.tableView.autoresizingMask = UIViewAutoresizingFlexibleDimensions;
   self.tableView.delegate = self;
-  self.tableView.dataSource = self;
+  self.tableView.dataSource = [self modelDataSource];
   [self.view addSubview:self.tableView];
 
   self.activityIndicator = [[UIActivityIndicatorView alloc] initWithActivityIndicatorStyle:self.activityIndicatorStyle];
@@ -74,22 +91,268 @@
     [self.tableView deselectRowAtIndexPath:self.tableView.indexPathForSelectedRow
                                   animated:animated];
   }
+
+  if (self.paginationEnabled && 0 == self.numberOfLoadedPages) {
+    [self loadNextPage];
+  }
 }
 
 #pragma mark - UITableViewDataSource
 
 
+// While streaming, the controller stays the table view's data source and forwards to the latest
+// snapshot. This way the table view's row counts only change when rows are inserted.
+
+- (NSInteger)numberOfSectionsInTableView:(UITableView *)tableView {
+  if (nil != self.streamedModel) {
+    return [self.streamedModel numberOfSectionsInTableView:tableView];
+  }
+  return 1;
+}
+
 - (NSInteger)tableView:(UITableView *)tableView numberOfRowsInSection:(NSInteger)section {
-  return 0;
+  return [self.streamedModel tableView:tableView numberOfRowsInSection:section];
 }
 
 - (UITableViewCell *)tableView:(UITableView *)tableView cellForRowAtIndexPath:(NSIndexPath *)indexPath {
-  return nil;
+  return [self.streamedModel tableView:tableView cellForRowAtIndexPath:indexPath];
+}
+
+- (NSString *)tableView:(UITableView *)tableView titleForHeaderInSection:(NSInteger)section {
+  return [self.streamedModel tableView:tableView titleForHeaderInSection:section];
+}
+
+- (NSString *)tableView:(UITableView *)tableView titleForFooterInSection:(NSInteger)section {
+  return [self.streamedModel tableView:tableView titleForFooterInSection:section];
+}
+
+#pragma mark - UITableViewDelegate
+
+
+- (void)tableView:(UITableView *)tableView willDisplayCell:(UITableViewCell *)cell forRowAtIndexPath:(NSIndexPath *)indexPath {
+  if ([self isIndexPathNearEnd:indexPath]) {
+    [self loadNextPageIfNeeded];
+  }
+}
+
+#pragma mark - Pagination
+
+
+- (BOOL)isIndexPathNearEnd:(NSIndexPath *)indexPath {
+  NSInteger lastSection = [self.tableView numberOfSections] - 1;
+  if (lastSection < 0) {
+    return YES;
+  }
+  // Rows in earlier sections count toward the distance as well.
+  NSInteger numberOfRowsAfter = [self.tableView numberOfRowsInSection:indexPath.section] - indexPath.row - 1;
+  for (NSInteger section = indexPath.section + 1; section <= lastSection && numberOfRowsAfter < self.prefetchDistance; ++section) {
+    numberOfRowsAfter += [self.tableView numberOfRowsInSection:section];
+  }
+  return numberOfRowsAfter < self.prefetchDistance;
+}
+
+- (void)loadNextPageIfNeeded {
+  if (self.paginationEnabled && nil == self.pageError) {
+    [self loadNextPage];
+  }
+}
+
+- (void)setPageActivityIndicatorVisible:(BOOL)visible {
+  if (visible && 0 < self.numberOfLoadedPages) {
+    if (nil == self.pageActivityIndicator) {
+      self.pageActivityIndicator = [[UIActivityIndicatorView alloc] initWithActivityIndicatorStyle:self.activityIndicatorStyle];
+      [self.pageActivityIndicator sizeToFit];
+      CGRect frame = self.pageActivityIndicator.frame;
+      frame.size.height += 20;
+      self.pageActivityIndicator.frame = frame;
+    }
+    [self.pageActivityIndicator startAnimating];
+    self.tableView.tableFooterView = self.pageActivityIndicator;
+
+  } else if (self.tableView.tableFooterView == self.pageActivityIndicator) {
+    [self.pageActivityIndicator stopAnimating];
+    self.tableView.tableFooterView = nil;
+  }
+}
+
+- (void)loadNextPage {
+  if (self.loadingPage || !self.hasMorePages) {
+    return;
+  }
+
+  self.loadingPage = YES;
+  self.pageError = nil;
+  if (0 == self.numberOfLoadedPages) {
+    [self setIsLoading:YES];
+  } else {
+    [self setPageActivityIndicatorVisible:YES];
+  }
+
+  NSUInteger generation = self.paginationGeneration;
+  NSInteger pageIndex = self.numberOfLoadedPages;
+  __weak NINetworkTableViewController* weakSelf = self;
+  [self fetchPage:pageIndex completion:^(NSArray* objects, BOOL hasMorePages, NSError* error) {
+    NIDASSERT([NSThread isMainThread]);
+    NINetworkTableViewController* strongSelf = weakSelf;
+    if (nil == strongSelf || generation != strongSelf.paginationGeneration) {
+      return;
+    }
+    [strongSelf didFetchPageWithObjects:objects hasMorePages:hasMorePages error:error];
+  }];
+}
+
+- (void)didFetchPageWithObjects:(NSArray *)objects hasMorePages:(BOOL)hasMorePages error:(NSError *)error {
+  // The completion must only be called once.
+  NIDASSERT(self.loadingPage);
+  if (!self.loadingPage) {
+    return;
+  }
+
+  self.loadingPage = NO;
+  [self setIsLoading:NO];
+  [self setPageActivityIndicatorVisible:NO];
+
+  if (nil != error) {
+    self.pageError = error;
+    return;
+  }
+
+  self.numberOfLoadedPages++;
+  self.hasMorePages = hasMorePages;
+
+  if (objects.count > 0) {
+    NITableViewModelDiff* diff = [self.model performBatchUpdates:^(NIMutableTableViewModel* model) {
+      [model addObjectsFromArray:objects];
+    }];
+    [diff applyToTableView:self.tableView withRowAnimation:UITableViewRowAnimationNone];
+  }
+
+  // A short page may not fill the table, in which case no more rows will be displayed to ask for
+  // the next one.
+  NSIndexPath* lastVisibleIndexPath = [[self.tableView indexPathsForVisibleRows] lastObject];
+  if (nil == lastVisibleIndexPath || [self isIndexPathNearEnd:lastVisibleIndexPath]) {
+    // A fetch that completes synchronously would otherwise recurse once per page.
+    NSUInteger generation = self.paginationGeneration;
+    __weak NINetworkTableViewController* weakSelf = self;
+    dispatch_async(dispatch_get_main_queue(), ^{
+      NINetworkTableViewController* strongSelf = weakSelf;
+      if (nil != strongSelf && generation == strongSelf.paginationGeneration) {
+        [strongSelf loadNextPageIfNeeded];
+      }
+    });
+  }
+}
+
+- (void)resetPagination {
+  self.paginationGeneration++;
+  self.loadingPage = NO;
+  self.pageError = nil;
+  self.numberOfLoadedPages = 0;
+  self.hasMorePages = YES;
+  [self setPageActivityIndicatorVisible:NO];
+
+  if (nil != self.model) {
+    [self.model setSectionedArray:@[] diffingWithTableView:self.tableView];
+  }
+
+  if (self.paginationEnabled && [self isViewLoaded]) {
+    [self loadNextPage];
+  }
+}
+
+- (void)fetchPage:(NSInteger)pageIndex completion:(NINetworkTableViewPageCompletion)completion {
+  completion(@[], NO, nil);
+}
+
+#pragma mark - Streaming
+
+
+- (id<UITableViewDataSource>)modelDataSource {
+  return (nil != self.model) ? (id<UITableViewDataSource>)self.model : self;
+}
+
+- (void)loadModelWithRequest:(NSURLRequest *)request builder:(NIStreamingTableModelBuilder *)builder {
+  [self.modelBuilder cancel];
+  self.modelBuilder = builder;
+  self.streamError = nil;
+
+  // The stream replaces both the model and the rows of any earlier stream.
+  _model = nil;
+  self.streamedModel = nil;
+  if ([self isViewLoaded]) {
+    self.tableView.dataSource = self;
+    [self.tableView reloadData];
+  }
+  [self setIsLoading:YES];
+
+  __weak NINetworkTableViewController* weakSelf = self;
+  __weak NIStreamingTableModelBuilder* weakBuilder = builder;
+  builder.snapshotBlock = ^(NITableViewModelSnapshot* snapshot, BOOL isFinished, NSError* error) {
+    [weakSelf builder:weakBuilder didDeliverSnapshot:snapshot isFinished:isFinished error:error];
+  };
+  [builder startWithRequest:request];
+}
+
+- (void)builder:(NIStreamingTableModelBuilder *)builder didDeliverSnapshot:(NITableViewModelSnapshot *)snapshot isFinished:(BOOL)isFinished error:(NSError *)error {
+  if (nil == builder || builder != self.modelBuilder) {
+    return;
+  }
+  if (isFinished) {
+    self.modelBuilder = nil;
+  }
+  [self setIsLoading:NO];
+
+  if (nil != error) {
+    self.streamError = error;
+    return;
+  }
+  [self showStreamedModel:snapshot];
+}
+
+- (void)showStreamedModel:(NITableViewModelSnapshot *)snapshot {
+  NITableViewModelSnapshot* previousSnapshot = self.streamedModel;
+  self.streamedModel = snapshot;
+  NIDASSERT(nil == self.model);
+  if (![self isViewLoaded]) {
+    return;
+  }
+
+  // Each snapshot of a stream only adds rows to the end of its one section, so only those rows
+  // need to be inserted.
+  NSUInteger numberOfPreviousObjects = previousSnapshot.numberOfObjects;
+  if (0 == numberOfPreviousObjects || snapshot.numberOfObjects < numberOfPreviousObjects
+      || 1 != [self.tableView numberOfSections]) {
+    [self.tableView reloadData];
+    return;
+  }
+
+  NSMutableArray* indexPaths = [NSMutableArray arrayWithCapacity:snapshot.numberOfObjects - numberOfPreviousObjects];
+  for (NSUInteger row = numberOfPreviousObjects; row < snapshot.numberOfObjects; ++row) {
+    [indexPaths addObject:[NSIndexPath indexPathForRow:(NSInteger)row inSection:0]];
+  }
+  if (indexPaths.count > 0) {
+    [self.tableView insertRowsAtIndexPaths:indexPaths withRowAnimation:UITableViewRowAnimationNone];
+  }
 }
 
 #pragma mark - Public
 
 
+- (void)setModel:(NIMutableTableViewModel *)model {
+  if (nil != model) {
+    // A model replaces the streamed rows, so the stream that is delivering them is stopped.
+    [self.modelBuilder cancel];
+    self.modelBuilder = nil;
+    self.streamedModel = nil;
+  }
+  _model = model;
+  if ([self isViewLoaded]) {
+    self.tableView.dataSource = [self modelDataSource];
+    [self.tableView reloadData];
+  }
+}
+
+
 - (void)setIsLoading:(BOOL)isLoading {
   self.tableView.hidden = isLoading;
 
@@ -0,0 +1,172 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+@class NITableViewModelSnapshot;
+@protocol NITableViewModelDelegate;
+
+/**
+ * The block that turns one element of the streamed array into a row, on the parsing queue.
+ *
+ * @param JSONObject The element, parsed by NSJSONSerialization.
+ * @returns The object to add to the model, or nil to skip the element.
+ *
+ * @ingroup NimbusNetworkControllers
+ */
+typedef id (^NIStreamingTableModelObjectBlock)(id JSONObject);
+
+/**
+ * The block that receives each snapshot, on the main thread.
+ *
+ * @param snapshot Every row produced so far. nil if the stream failed.
+ * @param isFinished Whether this is the last snapshot.
+ * @param error The error if the stream failed.
+ *
+ * @ingroup NimbusNetworkControllers
+ */
+typedef void (^NIStreamingTableModelSnapshotBlock)(NITableViewModelSnapshot* snapshot,
+                                                  BOOL isFinished,
+                                                  NSError* error);
+
+/**
+ * Builds a table view model from a JSON response while the response is still downloading.
+ *
+ * The usual way of showing a JSON list downloads the whole payload, parses it into Foundation
+ * objects and then builds cell objects from them, so the payload, the parsed objects and the
+ * cell objects are all in memory at once and nothing shows until all three exist. This builder
+ * parses the response as it arrives on a serial background queue instead. It finds the array of
+ * rows in the document, parses each element of the array on its own as soon as its last byte
+ * arrives, and turns it into a row with objectBlock. The element's bytes and Foundation objects
+ * are released before the next element is parsed, so only the rows are kept.
+ *
+ * The rows are delivered as immutable NITableViewModelSnapshot list models on the main thread.
+ * The first snapshot is delivered as soon as numberOfObjectsInFirstSnapshot rows exist, so the
+ * first screen renders long before the payload has been parsed. Each later snapshot holds twice
+ * as many rows as the one before, which keeps the cost of building them linear, and the last
+ * holds every row. Each snapshot only adds rows to the end of the previous one.
+ *
+ * @code
+ * NIStreamingTableModelBuilder* builder =
+ *     [[NIStreamingTableModelBuilder alloc] initWithDelegate:(id)[NICellFactory class]
+ *                                                objectBlock:^id(NSDictionary* post) {
+ *   return [NISubtitleCellObject objectWithTitle:post[@"title"] subtitle:post[@"author"]];
+ * }];
+ * builder.keyPath = @[@"data", @"posts"];
+ * [self loadModelWithRequest:request builder:builder]; // in an NINetworkTableViewController
+ * @endcode
+ *
+ * Elements are parsed with NSJSONSerialization, so a malformed element fails the stream with
+ * NSJSONSerialization's error. A document that never closes the array fails with
+ * NIMalformedJSON in NINimbusErrorDomain.
+ *
+ * @ingroup NimbusNetworkControllers
+ */
+@interface NIStreamingTableModelBuilder : NSObject <NSURLConnectionDataDelegate>
+
+// Designated initializer.
+- (id)initWithDelegate:(id<NITableViewModelDelegate>)delegate objectBlock:(NIStreamingTableModelObjectBlock)objectBlock;
+
+@property (nonatomic, copy) NSArray* keyPath; // Default: nil
+@property (nonatomic, assign) NSUInteger numberOfObjectsInFirstSnapshot; // Default: 20
+@property (nonatomic, copy) NIStreamingTableModelSnapshotBlock snapshotBlock;
+
+- (void)startWithRequest:(NSURLRequest *)request;
+
+- (void)appendData:(NSData *)data;
+- (void)finish;
+
+- (void)cancel;
+@property (atomic, readonly, getter = isCancelled) BOOL cancelled;
+
+@end
+
+/** @name Creating a Builder */
+
+/**
+ * Initializes a builder whose snapshots use the given delegate to create cells.
+ *
+ * @param delegate The delegate of every snapshot, usually [NICellFactory class].
+ * @param objectBlock Turns each element of the array into a row. Called on the parsing queue.
+ * @fn NIStreamingTableModelBuilder::initWithDelegate:objectBlock:
+ */
+
+/** @name Configuring the Builder */
+
+/**
+ * The keys of the objects that lead from the top of the document to the array of rows.
+ *
+ * nil means the document itself is the array. Must be set before any data is parsed.
+ *
+ * @fn NIStreamingTableModelBuilder::keyPath
+ */
+
+/**
+ * The number of rows that the first snapshot is delivered with.
+ *
+ * Enough rows to fill the first screen is a good choice.
+ *
+ * @fn NIStreamingTableModelBuilder::numberOfObjectsInFirstSnapshot
+ */
+
+/**
+ * Receives each snapshot on the main thread.
+ *
+ * Not called once the builder has been cancelled.
+ *
+ * @fn NIStreamingTableModelBuilder::snapshotBlock
+ */
+
+/** @name Streaming */
+
+/**
+ * Downloads the request and parses the response as it arrives.
+ *
+ * A response with an HTTP status code of 400 or above fails the stream with
+ * NSURLErrorBadServerResponse.
+ *
+ * @fn NIStreamingTableModelBuilder::startWithRequest:
+ */
+
+/**
+ * Parses the next piece of a response that is being downloaded some other way.
+ *
+ * May be called from any thread. The data is parsed on the builder's queue, in the order it was
+ * appended.
+ *
+ * @fn NIStreamingTableModelBuilder::appendData:
+ */
+
+/**
+ * Tells the builder that every piece of the response has been appended.
+ *
+ * The last snapshot is delivered once the appended data has been parsed.
+ *
+ * @fn NIStreamingTableModelBuilder::finish
+ */
+
+/**
+ * Stops the download and parsing and drops every snapshot that hasn't been delivered.
+ *
+ * @fn NIStreamingTableModelBuilder::cancel
+ */
+
+/**
+ * Whether cancel has been called.
+ *
+ * @fn NIStreamingTableModelBuilder::cancelled
+ */
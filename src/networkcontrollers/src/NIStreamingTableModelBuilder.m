@@ -0,0 +1,394 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NIStreamingTableModelBuilder.h"
+
+#import "NimbusCore.h"
+#import "NimbusModels.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// Finds the elements of one array in a JSON document that arrives in pieces.
+//
+// The scanner only tracks enough of the document's structure to know where each element of the
+// array begins and ends; the elements themselves are left to NSJSONSerialization. Bytes are
+// dropped as soon as nothing that is still being read needs them.
+@interface NIJSONArrayScanner : NSObject
+
+- (id)initWithKeyPath:(NSArray *)keyPath;
+
+// Calls the block with the bytes of every element that ends within the data. Returns NO if the
+// document is malformed.
+- (BOOL)scanData:(NSData *)data elementBlock:(void (^)(NSData* elementData))elementBlock;
+
+@property (nonatomic, readonly) BOOL didFinishArray;
+
+@end
+
+@implementation NIJSONArrayScanner {
+  NSArray* _keyPath;
+
+  NSMutableData* _buffer;
+  NSUInteger _offset; // The next byte of the buffer to scan.
+
+  NSMutableData* _containers; // '{' or '[' for each open container, outermost first.
+  NSMutableArray* _keys; // The last key read in each open container, NSNull if there isn't one.
+  BOOL _isInString;
+  BOOL _isEscaped;
+  BOOL _isExpectingKey;
+
+  NSUInteger _keyStart; // The opening quote of the key being read, or NSNotFound.
+  NSUInteger _elementStart; // The first byte of the element being read, or NSNotFound.
+  NSUInteger _arrayDepth; // The number of containers open when inside the array, 0 otherwise.
+}
+
+- (id)initWithKeyPath:(NSArray *)keyPath {
+  if ((self = [super init])) {
+    _keyPath = [keyPath copy];
+    _buffer = [[NSMutableData alloc] init];
+    _containers = [[NSMutableData alloc] init];
+    _keys = [[NSMutableArray alloc] init];
+    _keyStart = NSNotFound;
+    _elementStart = NSNotFound;
+  }
+  return self;
+}
+
+- (BOOL)isAtKeyPath {
+  if (_containers.length != _keyPath.count + 1) {
+    return NO;
+  }
+  const char* containers = [_containers bytes];
+  for (NSUInteger ix = 0; ix < _keyPath.count; ++ix) {
+    if ('{' != containers[ix] || ![[_keyPath objectAtIndex:ix] isEqual:[_keys objectAtIndex:ix]]) {
+      return NO;
+    }
+  }
+  return YES;
+}
+
+- (id)keyWithBytes:(const char *)bytes length:(NSUInteger)length {
+  // Escaped keys are rare, so the JSON parser is only asked to unescape those.
+  if (NULL == memchr(bytes + 1, '\\', length - 2)) {
+    NSString* key = [[NSString alloc] initWithBytes:bytes + 1
+                                             length:length - 2
+                                           encoding:NSUTF8StringEncoding];
+    return (nil != key) ? key : [NSNull null];
+  }
+  id key = [NSJSONSerialization JSONObjectWithData:[NSData dataWithBytes:bytes length:length]
+                                           options:NSJSONReadingAllowFragments
+                                             error:nil];
+  return [key isKindOfClass:[NSString class]] ? key : [NSNull null];
+}
+
+- (void)popContainer {
+  [_containers setLength:_containers.length - 1];
+  [_keys removeLastObject];
+}
+
+- (BOOL)scanData:(NSData *)data elementBlock:(void (^)(NSData* elementData))elementBlock {
+  if (_didFinishArray) {
+    return YES;
+  }
+  [_buffer appendData:data];
+
+  const char* bytes = [_buffer bytes];
+  NSUInteger length = _buffer.length;
+  for (; _offset < length && !_didFinishArray; ++_offset) {
+    char c = bytes[_offset];
+
+    if (_isInString) {
+      if (_isEscaped) {
+        _isEscaped = NO;
+
+      } else if ('\\' == c) {
+        _isEscaped = YES;
+
+      } else if ('"' == c) {
+        _isInString = NO;
+        if (NSNotFound != _keyStart) {
+          [_keys replaceObjectAtIndex:_keys.count - 1
+                           withObject:[self keyWithBytes:bytes + _keyStart
+                                                  length:_offset - _keyStart + 1]];
+          _keyStart = NSNotFound;
+        }
+      }
+      continue;
+    }
+
+    NSUInteger depth = _containers.length;
+    BOOL isInArray = (0 != _arrayDepth);
+    BOOL isBetweenElements = (isInArray && depth == _arrayDepth);
+    if (isBetweenElements && NSNotFound == _elementStart
+        && !isspace((unsigned char)c) && ',' != c && ']' != c) {
+      _elementStart = _offset;
+    }
+
+    switch (c) {
+      case '"':
+        _isInString = YES;
+        if (!isInArray && _isExpectingKey) {
+          _keyStart = _offset;
+        }
+        _isExpectingKey = NO;
+        break;
+
+      case '{':
+      case '[':
+        [_containers appendBytes:&c length:1];
+        [_keys addObject:[NSNull null]];
+        _isExpectingKey = ('{' == c);
+        if ('[' == c && !isInArray && [self isAtKeyPath]) {
+          _arrayDepth = _containers.length;
+        }
+        break;
+
+      case '}':
+      case ']': {
+        char opening = ('}' == c) ? '{' : '[';
+        if (0 == depth || opening != ((const char *)[_containers bytes])[depth - 1]) {
+          return NO;
+        }
+        if (isBetweenElements) {
+          if (NSNotFound != _elementStart) {
+            elementBlock([NSData dataWithBytes:bytes + _elementStart
+                                        length:_offset - _elementStart]);
+            _elementStart = NSNotFound;
+          }
+          _arrayDepth = 0;
+          _didFinishArray = YES;
+        }
+        [self popContainer];
+        _isExpectingKey = NO;
+        break;
+      }
+
+      case ',':
+        if (isBetweenElements) {
+          if (NSNotFound == _elementStart) {
+            return NO;
+          }
+          elementBlock([NSData dataWithBytes:bytes + _elementStart length:_offset - _elementStart]);
+          _elementStart = NSNotFound;
+        }
+        _isExpectingKey = (0 < depth && '{' == ((const char *)[_containers bytes])[depth - 1]);
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  // Keep only the bytes of the key or element that is still being read.
+  NSUInteger firstNeededByte = MIN(MIN(_keyStart, _elementStart), _offset);
+  if (0 < firstNeededByte) {
+    [_buffer replaceBytesInRange:NSMakeRange(0, firstNeededByte) withBytes:NULL length:0];
+    _offset -= firstNeededByte;
+    if (NSNotFound != _keyStart) {
+      _keyStart -= firstNeededByte;
+    }
+    if (NSNotFound != _elementStart) {
+      _elementStart -= firstNeededByte;
+    }
+  }
+  if (_didFinishArray) {
+    _buffer = nil;
+  }
+  return YES;
+}
+
+@end
+
+@interface NIStreamingTableModelBuilder()
+@property (nonatomic, weak) id<NITableViewModelDelegate> delegate;
+@property (nonatomic, copy) NIStreamingTableModelObjectBlock objectBlock;
+@property (nonatomic, strong) NSOperationQueue* parsingQueue;
+@property (nonatomic, strong) NSURLConnection* connection;
+@property (atomic, assign) BOOL cancelled;
+
+// Only used on the parsing queue.
+@property (nonatomic, strong) NIJSONArrayScanner* scanner;
+@property (nonatomic, strong) NSMutableArray* objects;
+@property (nonatomic, assign) NSUInteger numberOfObjectsInNextSnapshot;
+@property (nonatomic, assign) BOOL didFinish;
+@end
+
+
+@implementation NIStreamingTableModelBuilder
+
+
+- (id)initWithDelegate:(id<NITableViewModelDelegate>)delegate objectBlock:(NIStreamingTableModelObjectBlock)objectBlock {
+  if ((self = [super init])) {
+    _delegate = delegate;
+    _objectBlock = [objectBlock copy];
+    _numberOfObjectsInFirstSnapshot = 20;
+    _objects = [[NSMutableArray alloc] init];
+
+    _parsingQueue = [[NSOperationQueue alloc] init];
+    _parsingQueue.maxConcurrentOperationCount = 1;
+    _parsingQueue.name = @"com.nimbuskit.streamingtablemodelbuilder";
+  }
+  return self;
+}
+
+- (id)init {
+  return [self initWithDelegate:nil objectBlock:nil];
+}
+
+#pragma mark - Parsing Queue
+
+
+- (void)parseData:(NSData *)data {
+  if (self.cancelled || self.didFinish) {
+    return;
+  }
+  if (nil == self.scanner) {
+    self.scanner = [[NIJSONArrayScanner alloc] initWithKeyPath:self.keyPath];
+    self.numberOfObjectsInNextSnapshot = MAX(1u, self.numberOfObjectsInFirstSnapshot);
+  }
+
+  __block NSError* error = nil;
+  NIStreamingTableModelObjectBlock objectBlock = self.objectBlock;
+  NSMutableArray* objects = self.objects;
+  BOOL isWellFormed = [self.scanner scanData:data elementBlock:^(NSData* elementData) {
+    if (nil != error) {
+      return;
+    }
+    // Each element's Foundation objects are released before the next element is parsed.
+    @autoreleasepool {
+      id JSONObject = [NSJSONSerialization JSONObjectWithData:elementData
+                                                      options:NSJSONReadingAllowFragments
+                                                        error:&error];
+      id object = (nil != JSONObject && nil != objectBlock) ? objectBlock(JSONObject) : nil;
+      if (nil != object) {
+        [objects addObject:object];
+      }
+    }
+  }];
+
+  if (!isWellFormed || nil != error) {
+    [self failWithError:(nil != error) ? error : [self malformedJSONError]];
+    return;
+  }
+
+  if (objects.count >= self.numberOfObjectsInNextSnapshot) {
+    [self deliverSnapshotIsFinished:NO];
+    self.numberOfObjectsInNextSnapshot = objects.count * 2;
+  }
+}
+
+- (void)finishParsing {
+  if (self.cancelled || self.didFinish) {
+    return;
+  }
+  if (!self.scanner.didFinishArray) {
+    [self failWithError:[self malformedJSONError]];
+    return;
+  }
+  self.didFinish = YES;
+  [self deliverSnapshotIsFinished:YES];
+}
+
+- (NSError *)malformedJSONError {
+  return [NSError errorWithDomain:NINimbusErrorDomain code:NIMalformedJSON userInfo:nil];
+}
+
+- (void)deliverSnapshotIsFinished:(BOOL)isFinished {
+  NITableViewModelSnapshot* snapshot =
+      [[NITableViewModelSnapshot alloc] initWithListArray:self.objects delegate:self.delegate];
+  [self deliverSnapshot:snapshot isFinished:isFinished error:nil];
+}
+
+- (void)failWithError:(NSError *)error {
+  self.didFinish = YES;
+  self.objects = nil;
+  [self.connection cancel];
+  [self deliverSnapshot:nil isFinished:YES error:error];
+}
+
+- (void)deliverSnapshot:(NITableViewModelSnapshot *)snapshot isFinished:(BOOL)isFinished error:(NSError *)error {
+  NIStreamingTableModelSnapshotBlock snapshotBlock = self.snapshotBlock;
+  if (nil == snapshotBlock) {
+    return;
+  }
+  dispatch_async(dispatch_get_main_queue(), ^{
+    if (!self.cancelled) {
+      snapshotBlock(snapshot, isFinished, error);
+    }
+  });
+}
+
+#pragma mark - NSURLConnectionDataDelegate
+
+
+- (void)connection:(NSURLConnection *)connection didReceiveResponse:(NSURLResponse *)response {
+  if ([response isKindOfClass:[NSHTTPURLResponse class]]
+      && [(NSHTTPURLResponse *)response statusCode] >= 400) {
+    [self failWithError:[NSError errorWithDomain:NSURLErrorDomain
+                                            code:NSURLErrorBadServerResponse
+                                        userInfo:nil]];
+  }
+}
+
+- (void)connection:(NSURLConnection *)connection didReceiveData:(NSData *)data {
+  [self parseData:data];
+}
+
+- (void)connectionDidFinishLoading:(NSURLConnection *)connection {
+  [self finishParsing];
+}
+
+- (void)connection:(NSURLConnection *)connection didFailWithError:(NSError *)error {
+  if (!self.didFinish) {
+    [self failWithError:error];
+  }
+}
+
+#pragma mark - Public
+
+
+- (void)startWithRequest:(NSURLRequest *)request {
+  NIDASSERT(nil == self.connection);
+  self.connection = [[NSURLConnection alloc] initWithRequest:request
+                                                    delegate:self
+                                            startImmediately:NO];
+  // The connection calls back on the parsing queue, so the data is parsed where it arrives.
+  [self.connection setDelegateQueue:self.parsingQueue];
+  [self.connection start];
+}
+
+- (void)appendData:(NSData *)data {
+  NSData* dataCopy = [data copy];
+  [self.parsingQueue addOperationWithBlock:^{
+    [self parseData:dataCopy];
+  }];
+}
+
+- (void)finish {
+  [self.parsingQueue addOperationWithBlock:^{
+    [self finishParsing];
+  }];
+}
+
+- (void)cancel {
+  self.cancelled = YES;
+  [self.connection cancel];
+  [self.parsingQueue cancelAllOperations];
+}
+
+@end
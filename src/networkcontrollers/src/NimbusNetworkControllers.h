@@ -40,5 +40,6 @@
 #import <UIKit/UIKit.h>
 
 #import "NINetworkTableViewController.h"
+#import "NIStreamingTableModelBuilder.h"
 
 /**@}*/
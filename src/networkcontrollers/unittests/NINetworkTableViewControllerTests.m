@@ -18,11 +18,45 @@
 
 #import <XCTest/XCTest.h>
 
+#import "NimbusModels.h"
 #import "NimbusNetworkControllers.h"
+#import "NITestURLProtocol.h"
 
 @interface NINetworkTableViewControllerTests : XCTestCase
 @end
 
+@interface NITestPagingController : NINetworkTableViewController
+@property (nonatomic, strong) NSMutableArray* pendingCompletions;
+@end
+
+@implementation NITestPagingController
+
+- (void)fetchPage:(NSInteger)pageIndex completion:(NINetworkTableViewPageCompletion)completion {
+  if (nil == self.pendingCompletions) {
+    self.pendingCompletions = [NSMutableArray array];
+  }
+  [self.pendingCompletions addObject:[completion copy]];
+}
+
+@end
+
+// Completes every fetch right away, with three pages in all.
+@interface NITestSynchronousPagingController : NINetworkTableViewController
+@property (nonatomic, assign) NSInteger fetchDepth;
+@property (nonatomic, assign) NSInteger maximumFetchDepth;
+@end
+
+@implementation NITestSynchronousPagingController
+
+- (void)fetchPage:(NSInteger)pageIndex completion:(NINetworkTableViewPageCompletion)completion {
+  self.fetchDepth++;
+  self.maximumFetchDepth = MAX(self.maximumFetchDepth, self.fetchDepth);
+  completion(@[@(pageIndex)], pageIndex < 2, nil);
+  self.fetchDepth--;
+}
+
+@end
+
 
 @implementation NINetworkTableViewControllerTests
 
@@ -30,4 +64,127 @@
 - (void)testNothing {
 }
 
+- (void)testOnlyOnePageIsFetchedAtATime {
+  NITestPagingController* controller = [[NITestPagingController alloc] initWithStyle:UITableViewStylePlain
+                                                              activityIndicatorStyle:UIActivityIndicatorViewStyleGray];
+  controller.model = [[NIMutableTableViewModel alloc] initWithDelegate:nil];
+  controller.paginationEnabled = YES;
+
+  [controller loadNextPage];
+  [controller loadNextPage];
+  XCTAssertEqual(controller.pendingCompletions.count, (NSUInteger)1);
+  XCTAssertTrue(controller.isLoadingPage);
+
+  NINetworkTableViewPageCompletion completion = controller.pendingCompletions[0];
+  completion(@[@"a", @"b"], NO, nil);
+  XCTAssertFalse(controller.isLoadingPage);
+  XCTAssertEqual(controller.numberOfLoadedPages, (NSInteger)1);
+  XCTAssertFalse(controller.hasMorePages);
+
+  [controller loadNextPage];
+  XCTAssertEqual(controller.pendingCompletions.count, (NSUInteger)1,
+                 @"No page should be fetched once the last page has been loaded.");
+}
+
+- (void)testSynchronousFetchesDoNotRecurse {
+  NITestSynchronousPagingController* controller =
+      [[NITestSynchronousPagingController alloc] initWithStyle:UITableViewStylePlain
+                                        activityIndicatorStyle:UIActivityIndicatorViewStyleGray];
+  controller.model = [[NIMutableTableViewModel alloc] initWithDelegate:nil];
+  controller.paginationEnabled = YES;
+
+  [controller loadNextPage];
+  XCTAssertEqual(controller.numberOfLoadedPages, (NSInteger)1, @"The next page should be loaded later.");
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  while (controller.hasMorePages && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertEqual(controller.numberOfLoadedPages, (NSInteger)3, @"The empty table should keep asking for pages.");
+  XCTAssertEqual(controller.maximumFetchDepth, (NSInteger)1, @"Fetches should not be nested.");
+}
+
+- (void)testStreamedArrayElementsBecomeSnapshotRowsInOrder {
+  NIStreamingTableModelBuilder* builder =
+      [[NIStreamingTableModelBuilder alloc] initWithDelegate:nil objectBlock:^id(id JSONObject) {
+        return JSONObject[@"t"];
+      }];
+  builder.keyPath = @[@"data"];
+  builder.numberOfObjectsInFirstSnapshot = 2;
+
+  __block NITableViewModelSnapshot* finalSnapshot = nil;
+  __block NSUInteger numberOfSnapshots = 0;
+  builder.snapshotBlock = ^(NITableViewModelSnapshot* snapshot, BOOL isFinished, NSError* error) {
+    XCTAssertNil(error);
+    numberOfSnapshots++;
+    if (isFinished) {
+      finalSnapshot = snapshot;
+    }
+  };
+
+  NSData* data = [@"{\"meta\":[1,2],\"data\":[{\"t\":\"a\"},{\"t\":\"b]\\\"\"},"
+                  @"{\"t\":\"c\"},{\"t\":\"d\"},{\"t\":\"e\"}]}"
+                  dataUsingEncoding:NSUTF8StringEncoding];
+  for (NSUInteger offset = 0; offset < data.length; offset += 3) {
+    NSRange range = NSMakeRange(offset, MIN((NSUInteger)3, data.length - offset));
+    [builder appendData:[data subdataWithRange:range]];
+  }
+  [builder finish];
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (nil == finalSnapshot && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+
+  XCTAssertEqual(finalSnapshot.numberOfObjects, (NSUInteger)5);
+  XCTAssertEqualObjects([finalSnapshot objectAtIndexPath:[NSIndexPath indexPathForRow:1
+                                                                             inSection:0]],
+                        @"b]\"", @"Brackets and escapes inside strings must not end elements.");
+  XCTAssertEqualObjects([finalSnapshot objectAtIndexPath:[NSIndexPath indexPathForRow:4
+                                                                             inSection:0]],
+                        @"e");
+  XCTAssertGreaterThan(numberOfSnapshots, (NSUInteger)1);
+}
+
+- (void)testStreamReplacesTheModelAndGrowsTheTable {
+  NINetworkTableViewController* controller =
+      [[NINetworkTableViewController alloc] initWithStyle:UITableViewStylePlain
+                                   activityIndicatorStyle:UIActivityIndicatorViewStyleGray];
+  controller.model = [[NIMutableTableViewModel alloc] initWithDelegate:nil];
+  [controller view];
+
+  NIStreamingTableModelBuilder* builder =
+      [[NIStreamingTableModelBuilder alloc] initWithDelegate:(id)[NICellFactory class]
+                                                 objectBlock:^id(id JSONObject) {
+        return [NITitleCellObject objectWithTitle:JSONObject];
+      }];
+  builder.numberOfObjectsInFirstSnapshot = 1;
+
+  // Small chunks so that the rows arrive over several writes.
+  NSURL* url = [NSURL URLWithString:@"http://rows.nimbus.test/"];
+  [NITestURLProtocol setData:[@"[\"a\",\"b\",\"c\",\"d\",\"e\"]" dataUsingEncoding:NSUTF8StringEncoding]
+                  statusCode:200
+                headerFields:nil
+                      forURL:url];
+  [NITestURLProtocol setChunkLength:4];
+  [NSURLProtocol registerClass:[NITestURLProtocol class]];
+  [controller loadModelWithRequest:[NSURLRequest requestWithURL:url] builder:builder];
+  XCTAssertNil(controller.model);
+  XCTAssertEqual(controller.tableView.dataSource, (id<UITableViewDataSource>)controller);
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (controller.streamedModel.numberOfObjects < 5 && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  [NSURLProtocol unregisterClass:[NITestURLProtocol class]];
+  [NITestURLProtocol reset];
+
+  XCTAssertNil(controller.streamError);
+  XCTAssertEqual(controller.streamedModel.numberOfObjects, (NSUInteger)5);
+  XCTAssertEqual(controller.tableView.dataSource, (id<UITableViewDataSource>)controller,
+                 @"The controller must stay the data source while rows are inserted.");
+  XCTAssertEqual([controller.tableView numberOfRowsInSection:0], (NSInteger)5);
+  XCTAssertFalse(controller.tableView.hidden);
+}
+
 @end
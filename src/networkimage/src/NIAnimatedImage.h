@@ -0,0 +1,119 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+/**
+ * Processes a single decoded frame of an animated image for display.
+ *
+ * Called on a background queue. Returning nil skips the frame.
+ */
+typedef UIImage* (^NIAnimatedImageFrameBlock)(UIImage* frame);
+
+/**
+ * An animated image that decodes its frames as they are needed.
+ *
+ * UIImage's animated images hold every decoded frame in memory, so a long GIF can cost more
+ * than an entire image cache. An NIAnimatedImage keeps the encoded data instead and decodes a
+ * small window of frames ahead of the one being displayed on a background queue. Frames that
+ * fall behind the window are released.
+ *
+ * The image itself is the first frame, so an NIAnimatedImage can be displayed and cached
+ * anywhere a UIImage can. NINetworkImageView plays it using a CADisplayLink.
+ *
+ * @ingroup NimbusNetworkImage
+ */
+@interface NIAnimatedImage : UIImage
+
++ (NIAnimatedImage *)animatedImageWithData:(NSData *)data frameBlock:(NIAnimatedImageFrameBlock)frameBlock;
+
+@property (nonatomic, readonly) NSUInteger numberOfFrames;
+@property (nonatomic, readonly) NSUInteger loopCount;
+@property (nonatomic, readonly) NSUInteger frameCacheSize;
+@property (nonatomic, readonly) unsigned long long memoryCost;
+
+- (NSTimeInterval)durationOfFrameAtIndex:(NSUInteger)index;
+- (UIImage *)frameAtIndex:(NSUInteger)index;
+
+@end
+
+/** @name Creating an Animated Image */
+
+/**
+ * Returns an animated image that decodes its frames from the given data.
+ *
+ * frameBlock is applied to every frame after it has been decoded, which is where frames are
+ * resized for display. It may be nil.
+ *
+ * Returns nil if the data holds fewer than two frames, in which case it should be decoded as
+ * an ordinary image.
+ *
+ * @fn NIAnimatedImage::animatedImageWithData:frameBlock:
+ */
+
+/** @name Animation Properties */
+
+/**
+ * The number of frames in the animation.
+ *
+ * @fn NIAnimatedImage::numberOfFrames
+ */
+
+/**
+ * The number of times the animation plays, or 0 if it loops forever.
+ *
+ * @fn NIAnimatedImage::loopCount
+ */
+
+/**
+ * The number of decoded frames, starting with the one being displayed, that are kept in memory.
+ *
+ * The first frame is kept in addition to these because it is the image itself.
+ *
+ * @fn NIAnimatedImage::frameCacheSize
+ */
+
+/**
+ * The largest number of bytes that this image will hold on to.
+ *
+ * This counts the encoded data and a full window of decoded frames. Store the image in an
+ * NIImageMemoryCache with this cost so that the cache charges the frames that will actually be
+ * decoded rather than just the first one.
+ *
+ * @fn NIAnimatedImage::memoryCost
+ */
+
+/** @name Accessing Frames */
+
+/**
+ * Returns how long the frame at the given index should be displayed.
+ *
+ * Very short durations are raised to 0.1 seconds, which is how browsers treat them.
+ *
+ * @fn NIAnimatedImage::durationOfFrameAtIndex:
+ */
+
+/**
+ * Returns the frame at the given index if it has been decoded, or nil if it has not.
+ *
+ * Asking for a frame also decodes the frames that follow it in the background and releases
+ * the frames that precede it. Callers that get nil should keep showing the current frame and
+ * ask again on the next screen refresh.
+ *
+ * @fn NIAnimatedImage::frameAtIndex:
+ */
@@ -0,0 +1,218 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIAnimatedImage.h"
+
+#import "NIImageProcessing.h"
+
+#import <ImageIO/ImageIO.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// The number of frames, including the one being displayed, that are kept decoded.
+static const NSUInteger kNIAnimatedImageFrameCacheSize = 5;
+
+// Browsers show frames with delays shorter than this for 0.1 seconds, and GIFs are authored
+// with that in mind.
+static const NSTimeInterval kNIAnimatedImageMinimumFrameDuration = 0.02;
+static const NSTimeInterval kNIAnimatedImageDefaultFrameDuration = 0.1;
+
+@interface NIAnimatedImage()
+@property (nonatomic, strong) NSData* data;
+@property (nonatomic, copy) NIAnimatedImageFrameBlock frameBlock;
+@property (nonatomic, copy) NSArray* frameDurations;
+@property (nonatomic, assign) NSUInteger numberOfFrames;
+@property (nonatomic, assign) NSUInteger loopCount;
+@property (nonatomic, assign) NSUInteger frameCacheSize;
+@end
+
+@implementation NIAnimatedImage {
+  CGImageSourceRef _imageSource;
+  dispatch_queue_t _decodeQueue;
+
+  // Decoded frames keyed by index. The first frame is the image itself and is never stored.
+  NSMutableDictionary* _frames;
+  NSMutableIndexSet* _framesBeingDecoded;
+}
+
+- (void)dealloc {
+  if (NULL != _imageSource) {
+    CFRelease(_imageSource);
+  }
+}
+
+static NSTimeInterval NIDurationOfFrame(CGImageSourceRef imageSource, size_t index) {
+  NSDictionary* properties = CFBridgingRelease(CGImageSourceCopyPropertiesAtIndex(imageSource, index, NULL));
+  NSDictionary* gifProperties = properties[(__bridge NSString *)kCGImagePropertyGIFDictionary];
+  NSNumber* delayTime = gifProperties[(__bridge NSString *)kCGImagePropertyGIFUnclampedDelayTime];
+  if (nil == delayTime) {
+    delayTime = gifProperties[(__bridge NSString *)kCGImagePropertyGIFDelayTime];
+  }
+  NSTimeInterval duration = [delayTime doubleValue];
+  return (duration < kNIAnimatedImageMinimumFrameDuration) ? kNIAnimatedImageDefaultFrameDuration : duration;
+}
+
++ (UIImage *)processedFrameFromImageRef:(CGImageRef)imageRef frameBlock:(NIAnimatedImageFrameBlock)frameBlock {
+  if (NULL == imageRef) {
+    return nil;
+  }
+  UIImage* frame = [UIImage imageWithCGImage:imageRef];
+  if (nil != frameBlock) {
+    return frameBlock(frame);
+  }
+  return [NIImageProcessing decodedImageFromImage:frame];
+}
+
++ (NIAnimatedImage *)animatedImageWithData:(NSData *)data frameBlock:(NIAnimatedImageFrameBlock)frameBlock {
+  if (0 == data.length) {
+    return nil;
+  }
+  CGImageSourceRef imageSource = CGImageSourceCreateWithData((__bridge CFDataRef)data, NULL);
+  if (NULL == imageSource) {
+    return nil;
+  }
+  size_t numberOfFrames = CGImageSourceGetCount(imageSource);
+  if (numberOfFrames < 2) {
+    CFRelease(imageSource);
+    return nil;
+  }
+
+  // The first frame is decoded right away so that there is always something to display.
+  CGImageRef firstFrameRef = CGImageSourceCreateImageAtIndex(imageSource, 0, NULL);
+  UIImage* firstFrame = [self processedFrameFromImageRef:firstFrameRef frameBlock:frameBlock];
+  if (NULL != firstFrameRef) {
+    CGImageRelease(firstFrameRef);
+  }
+  if (nil == firstFrame.CGImage) {
+    CFRelease(imageSource);
+    return nil;
+  }
+
+  NIAnimatedImage* image = [[self alloc] initWithCGImage:firstFrame.CGImage
+                                                   scale:firstFrame.scale
+                                             orientation:firstFrame.imageOrientation];
+  image->_imageSource = imageSource;
+  image->_decodeQueue = dispatch_queue_create("com.nimbuskit.networkimage.animatedimage", DISPATCH_QUEUE_SERIAL);
+  image->_frames = [[NSMutableDictionary alloc] init];
+  image->_framesBeingDecoded = [[NSMutableIndexSet alloc] init];
+  image.data = data;
+  image.frameBlock = frameBlock;
+  image.numberOfFrames = numberOfFrames;
+  image.frameCacheSize = MIN(kNIAnimatedImageFrameCacheSize, numberOfFrames);
+
+  NSMutableArray* frameDurations = [NSMutableArray arrayWithCapacity:numberOfFrames];
+  for (size_t ix = 0; ix < numberOfFrames; ++ix) {
+    [frameDurations addObject:@(NIDurationOfFrame(imageSource, ix))];
+  }
+  image.frameDurations = frameDurations;
+
+  NSDictionary* properties = CFBridgingRelease(CGImageSourceCopyProperties(imageSource, NULL));
+  NSDictionary* gifProperties = properties[(__bridge NSString *)kCGImagePropertyGIFDictionary];
+  image.loopCount = [gifProperties[(__bridge NSString *)kCGImagePropertyGIFLoopCount] unsignedIntegerValue];
+
+  return image;
+}
+
+- (unsigned long long)memoryCost {
+  CGImageRef imageRef = self.CGImage;
+  unsigned long long numberOfBytesPerFrame = (unsigned long long)CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef);
+  return self.data.length + numberOfBytesPerFrame * (1 + self.frameCacheSize);
+}
+
+- (NSTimeInterval)durationOfFrameAtIndex:(NSUInteger)index {
+  if (index >= self.frameDurations.count) {
+    return 0;
+  }
+  return [self.frameDurations[index] doubleValue];
+}
+
+#pragma mark - Frames
+
+// Returns whether the frame is within the window of frames that starts at currentIndex.
+- (BOOL)isFrame:(NSUInteger)index inWindowAfterIndex:(NSUInteger)currentIndex {
+  NSUInteger distance = (index + self.numberOfFrames - currentIndex) % self.numberOfFrames;
+  return distance < self.frameCacheSize;
+}
+
+- (UIImage *)frameAtIndex:(NSUInteger)index {
+  if (index >= self.numberOfFrames) {
+    return nil;
+  }
+
+  UIImage* frame = nil;
+  NSMutableIndexSet* framesToDecode = [NSMutableIndexSet indexSet];
+  @synchronized(self) {
+    frame = (0 == index) ? self : _frames[@(index)];
+
+    // Let go of the frames that have already been shown.
+    for (NSNumber* frameIndex in [_frames allKeys]) {
+      if (![self isFrame:[frameIndex unsignedIntegerValue] inWindowAfterIndex:index]) {
+        [_frames removeObjectForKey:frameIndex];
+      }
+    }
+
+    for (NSUInteger distance = 0; distance < self.frameCacheSize; ++distance) {
+      NSUInteger frameIndex = (index + distance) % self.numberOfFrames;
+      if (0 != frameIndex && nil == _frames[@(frameIndex)]
+          && ![_framesBeingDecoded containsIndex:frameIndex]) {
+        [framesToDecode addIndex:frameIndex];
+      }
+    }
+    [_framesBeingDecoded addIndexes:framesToDecode];
+  }
+
+  [framesToDecode enumerateIndexesUsingBlock:^(NSUInteger frameIndex, BOOL *stop) {
+    [self decodeFrameAtIndex:frameIndex];
+  }];
+
+  return frame;
+}
+
+- (void)decodeFrameAtIndex:(NSUInteger)frameIndex {
+  __weak NIAnimatedImage* weakSelf = self;
+  CGImageSourceRef imageSource = _imageSource;
+  CFRetain(imageSource);
+  NIAnimatedImageFrameBlock frameBlock = self.frameBlock;
+
+  dispatch_async(_decodeQueue, ^{
+    UIImage* frame = nil;
+    // Images that have since been released don't need their frames.
+    if (nil != weakSelf) {
+      CGImageRef imageRef = CGImageSourceCreateImageAtIndex(imageSource, frameIndex, NULL);
+      frame = [NIAnimatedImage processedFrameFromImageRef:imageRef frameBlock:frameBlock];
+      if (NULL != imageRef) {
+        CGImageRelease(imageRef);
+      }
+    }
+    CFRelease(imageSource);
+
+    NIAnimatedImage* strongSelf = weakSelf;
+    if (nil == strongSelf) {
+      return;
+    }
+    @synchronized(strongSelf) {
+      [strongSelf->_framesBeingDecoded removeIndex:frameIndex];
+      if (nil != frame) {
+        strongSelf->_frames[@(frameIndex)] = frame;
+      }
+    }
+  });
+}
+
+@end
@@ -0,0 +1,140 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+/**
+ * An object that can decode one or more encoded image formats.
+ *
+ * NIImageResponseSerializer asks each of its decoders in turn whether it can decode a response,
+ * and the first one that can is used. Decoders are told how large the decoded image needs to be,
+ * so they can skip decoding pixels that would only be thrown away when the image is scaled down
+ * for display.
+ *
+ * Decoders are used from background threads and must be thread-safe.
+ *
+ * @ingroup NimbusNetworkImage
+ */
+@protocol NIImageDecoder <NSObject>
+@required
+
+- (NSArray *)contentTypes;
+- (BOOL)canDecodeData:(NSData *)data;
+- (CGSize)pixelSizeOfImageWithData:(NSData *)data;
+- (UIImage *)imageWithData:(NSData *)data maxPixelSize:(CGFloat)maxPixelSize;
+
+@end
+
+/**
+ * Decodes any image format that ImageIO supports on this device.
+ *
+ * The images are decoded as they are created, so they can be drawn without further work on the
+ * main thread. Decoders for a specific format report no content types and decode nothing when
+ * the device lacks support for that format.
+ *
+ * @ingroup NimbusNetworkImage
+ */
+@interface NIImageIODecoder : NSObject <NIImageDecoder>
+
++ (NIImageIODecoder *)decoder;
++ (NIImageIODecoder *)HEICDecoder;
++ (NIImageIODecoder *)WebPDecoder;
+
+- (id)initWithTypeIdentifier:(NSString *)typeIdentifier contentTypes:(NSArray *)contentTypes;
+
+@property (nonatomic, readonly, copy) NSString* typeIdentifier;
+@property (nonatomic, readonly, assign, getter=isAvailable) BOOL available;
+
+@end
+
+/**
+ * Returns the MIME types of the images this decoder can decode, most preferred first.
+ *
+ * These are advertised to servers in the Accept header of image requests. Returns an empty
+ * array if the decoder can't decode anything on this device.
+ *
+ * @fn NIImageDecoder::contentTypes
+ */
+
+/**
+ * Returns whether the data is an image that this decoder can decode.
+ *
+ * This should only look at the first few bytes of the data.
+ *
+ * @fn NIImageDecoder::canDecodeData:
+ */
+
+/**
+ * Returns the size in pixels of the image that the data decodes to, without decoding it.
+ *
+ * The size must account for the image's orientation. Returns CGSizeZero if the size can't be
+ * determined cheaply, in which case the image is decoded at its full size.
+ *
+ * @fn NIImageDecoder::pixelSizeOfImageWithData:
+ */
+
+/**
+ * Returns the decoded image, or nil if the data can't be decoded.
+ *
+ * The returned image must already be decoded and must draw upright.
+ *
+ * @param maxPixelSize The largest either dimension of the image needs to be. The image may be
+ *                          decoded at any size between this and its full size. 0 means the
+ *                          full size.
+ * @fn NIImageDecoder::imageWithData:maxPixelSize:
+ */
+
+/**
+ * Returns a decoder for every format that ImageIO can read.
+ *
+ * This decoder reports no content types, since it accepts them all.
+ *
+ * @fn NIImageIODecoder::decoder
+ */
+
+/**
+ * Returns a decoder for HEIC images, which ImageIO supports from iOS 11.
+ *
+ * @fn NIImageIODecoder::HEICDecoder
+ */
+
+/**
+ * Returns a decoder for WebP images, which ImageIO supports from iOS 14.
+ *
+ * @fn NIImageIODecoder::WebPDecoder
+ */
+
+/**
+ * Initializes a decoder for a single format.
+ *
+ * @param typeIdentifier The uniform type identifier of the format, or nil for any format.
+ * @param contentTypes   The MIME types of the format, most preferred first.
+ * @fn NIImageIODecoder::initWithTypeIdentifier:contentTypes:
+ */
+
+/**
+ * The uniform type identifier of the format this decoder decodes, or nil for any format.
+ *
+ * @fn NIImageIODecoder::typeIdentifier
+ */
+
+/**
+ * Whether ImageIO can decode this decoder's format on this device.
+ *
+ * @fn NIImageIODecoder::isAvailable
+ */
@@ -0,0 +1,189 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIImageDecoder.h"
+
+#import "NimbusCore.h"
+
+#import <ImageIO/ImageIO.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// Maps EXIF orientations to the orientation UIKit needs to draw the image upright.
+static UIImageOrientation NIImageOrientationFromEXIFOrientation(NSInteger orientation) {
+  switch (orientation) {
+    case 2: return UIImageOrientationUpMirrored;
+    case 3: return UIImageOrientationDown;
+    case 4: return UIImageOrientationDownMirrored;
+    case 5: return UIImageOrientationLeftMirrored;
+    case 6: return UIImageOrientationRight;
+    case 7: return UIImageOrientationRightMirrored;
+    case 8: return UIImageOrientationLeft;
+    default: return UIImageOrientationUp;
+  }
+}
+
+@implementation NIImageIODecoder {
+  NSArray* _contentTypes;
+}
+
++ (NIImageIODecoder *)decoder {
+  static NIImageIODecoder* sDecoder = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sDecoder = [[self alloc] initWithTypeIdentifier:nil contentTypes:nil];
+  });
+  return sDecoder;
+}
+
++ (NIImageIODecoder *)HEICDecoder {
+  static NIImageIODecoder* sDecoder = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sDecoder = [[self alloc] initWithTypeIdentifier:@"public.heic"
+                                       contentTypes:@[@"image/heic", @"image/heif"]];
+  });
+  return sDecoder;
+}
+
++ (NIImageIODecoder *)WebPDecoder {
+  static NIImageIODecoder* sDecoder = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sDecoder = [[self alloc] initWithTypeIdentifier:@"org.webmproject.webp"
+                                       contentTypes:@[@"image/webp"]];
+  });
+  return sDecoder;
+}
+
+- (id)initWithTypeIdentifier:(NSString *)typeIdentifier contentTypes:(NSArray *)contentTypes {
+  if ((self = [super init])) {
+    _typeIdentifier = [typeIdentifier copy];
+    _contentTypes = (nil != contentTypes) ? [contentTypes copy] : @[];
+
+    if (nil == typeIdentifier) {
+      _available = YES;
+    } else {
+      NSArray* typeIdentifiers = (__bridge_transfer NSArray *)CGImageSourceCopyTypeIdentifiers();
+      _available = [typeIdentifiers containsObject:typeIdentifier];
+    }
+  }
+  return self;
+}
+
+- (id)init {
+  return [self initWithTypeIdentifier:nil contentTypes:nil];
+}
+
+// Creating an image source only reads enough of the data to identify its format.
+- (CGImageSourceRef)newImageSourceWithData:(NSData *)data CF_RETURNS_RETAINED {
+  if (!_available || 0 == data.length) {
+    return NULL;
+  }
+  CGImageSourceRef imageSource = CGImageSourceCreateWithData((__bridge CFDataRef)data, NULL);
+  if (NULL == imageSource) {
+    return NULL;
+  }
+  if (nil != _typeIdentifier
+      && ![(__bridge NSString *)CGImageSourceGetType(imageSource) isEqualToString:_typeIdentifier]) {
+    CFRelease(imageSource);
+    return NULL;
+  }
+  return imageSource;
+}
+
+#pragma mark - NIImageDecoder
+
+
+- (NSArray *)contentTypes {
+  return _available ? _contentTypes : @[];
+}
+
+- (BOOL)canDecodeData:(NSData *)data {
+  CGImageSourceRef imageSource = [self newImageSourceWithData:data];
+  if (NULL == imageSource) {
+    return NO;
+  }
+  CFRelease(imageSource);
+  return YES;
+}
+
+- (CGSize)pixelSizeOfImageWithData:(NSData *)data {
+  CGImageSourceRef imageSource = [self newImageSourceWithData:data];
+  if (NULL == imageSource) {
+    return CGSizeZero;
+  }
+
+  // Reading the properties only parses the image header; nothing is decoded yet.
+  NSDictionary* properties = (__bridge_transfer NSDictionary *)CGImageSourceCopyPropertiesAtIndex(imageSource, 0, NULL);
+  CFRelease(imageSource);
+  CGSize pixelSize = CGSizeMake([properties[(__bridge NSString *)kCGImagePropertyPixelWidth] floatValue],
+                                [properties[(__bridge NSString *)kCGImagePropertyPixelHeight] floatValue]);
+
+  // EXIF orientations 5 through 8 are rotated by 90 degrees, and the image will be created
+  // with the orientation applied.
+  NSInteger orientation = [properties[(__bridge NSString *)kCGImagePropertyOrientation] integerValue];
+  if (orientation >= 5 && orientation <= 8) {
+    pixelSize = CGSizeMake(pixelSize.height, pixelSize.width);
+  }
+  return pixelSize;
+}
+
+- (UIImage *)imageWithData:(NSData *)data maxPixelSize:(CGFloat)maxPixelSize {
+  CGImageSourceRef imageSource = [self newImageSourceWithData:data];
+  if (NULL == imageSource) {
+    return nil;
+  }
+
+  UIImage* image = nil;
+  if (maxPixelSize > 0) {
+    NSDictionary* options = @{
+      (__bridge NSString *)kCGImageSourceCreateThumbnailFromImageAlways: @YES,
+      (__bridge NSString *)kCGImageSourceCreateThumbnailWithTransform: @YES,
+      (__bridge NSString *)kCGImageSourceShouldCacheImmediately: @YES,
+      (__bridge NSString *)kCGImageSourceThumbnailMaxPixelSize: @(maxPixelSize),
+    };
+    CGImageRef imageRef = CGImageSourceCreateThumbnailAtIndex(imageSource, 0,
+                                                              (__bridge CFDictionaryRef)options);
+    if (NULL != imageRef) {
+      image = [UIImage imageWithCGImage:imageRef];
+      CGImageRelease(imageRef);
+    }
+
+  } else {
+    // Thumbnails bake the orientation into their pixels, but full size images can be drawn
+    // upright by UIKit instead.
+    NSDictionary* options = @{(__bridge NSString *)kCGImageSourceShouldCacheImmediately: @YES};
+    CGImageRef imageRef = CGImageSourceCreateImageAtIndex(imageSource, 0,
+                                                          (__bridge CFDictionaryRef)options);
+    if (NULL != imageRef) {
+      NSDictionary* properties = (__bridge_transfer NSDictionary *)CGImageSourceCopyPropertiesAtIndex(imageSource, 0, NULL);
+      NSInteger orientation = [properties[(__bridge NSString *)kCGImagePropertyOrientation] integerValue];
+      image = [UIImage imageWithCGImage:imageRef
+                                  scale:1
+                            orientation:NIImageOrientationFromEXIFOrientation(orientation)];
+      CGImageRelease(imageRef);
+    }
+  }
+
+  CFRelease(imageSource);
+  return image;
+}
+
+@end
@@ -0,0 +1,182 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+/**
+ * A stage of image processing that runs after an image has been cropped and resized.
+ *
+ * Processors must be safe to run from any thread, and must always produce the same image from
+ * the same input. The identifier names that behavior: it becomes part of the memory cache key
+ * of every image the processor touches, so two processors with the same identifier must be
+ * interchangeable. Include any parameters in it, e.g. @"blur(8)".
+ *
+ * @ingroup NimbusNetworkImage
+ */
+@protocol NIImageProcessor <NSObject>
+@required
+@property (nonatomic, readonly, copy) NSString* processorIdentifier;
+- (UIImage *)processedImageFromImage:(UIImage *)image;
+@end
+
+/**
+ * An image processor that runs a block.
+ *
+ * @ingroup NimbusNetworkImage
+ */
+@interface NIBlockImageProcessor : NSObject <NIImageProcessor>
+
+// Designated initializer.
+- (id)initWithIdentifier:(NSString *)identifier block:(UIImage* (^)(UIImage* image))block;
++ (instancetype)processorWithIdentifier:(NSString *)identifier block:(UIImage* (^)(UIImage* image))block;
+
+@end
+
+/**
+ * Runs images through a list of processors on a concurrent queue.
+ *
+ * Image views that show the same image through different processors often share the first few
+ * stages, e.g. [crop, blur] and [crop, blur, tint]. The pipeline keeps the result of every
+ * stage for a short while, keyed by the name of the source image and the identifiers of the
+ * stages that produced it, so that a shared prefix is only run once. Requests for a stage that
+ * is already running wait for it rather than running it again.
+ *
+ * @ingroup NimbusNetworkImage
+ */
+@interface NIImagePipeline : NSObject
+
++ (NIImagePipeline *)sharedPipeline;
+
+// Designated initializer.
+- (id)initWithQueue:(dispatch_queue_t)queue;
+
+@property (nonatomic, readonly, strong) dispatch_queue_t queue;
+@property (nonatomic, assign) NSUInteger maxIntermediateImageCost; // Default: 8MB
+@property (nonatomic, assign) NSUInteger maxConcurrentStageCount; // Default: 0
+
+- (void)processImage:(UIImage *)image
+            withName:(NSString *)name
+          processors:(NSArray *)processors
+          completion:(void (^)(UIImage* image))completion;
+
+- (void)removeAllIntermediateImages;
+
++ (NSString *)identifierForProcessors:(NSArray *)processors;
+
+@end
+
+/** @name Describing a Processor */
+
+/**
+ * A string that names what this processor does to an image, including its parameters.
+ *
+ * @fn NIImageProcessor::processorIdentifier
+ */
+
+/**
+ * Returns the processed image, or nil if the image couldn't be processed.
+ *
+ * Called on the pipeline's queue, possibly on many threads at once.
+ *
+ * @fn NIImageProcessor::processedImageFromImage:
+ */
+
+/** @name Creating a Block Processor */
+
+/**
+ * Initializes a newly allocated processor that runs the given block.
+ *
+ * @fn NIBlockImageProcessor::initWithIdentifier:block:
+ */
+
+/**
+ * Returns an autoreleased processor that runs the given block.
+ *
+ * @fn NIBlockImageProcessor::processorWithIdentifier:block:
+ */
+
+/** @name Accessing the Shared Pipeline */
+
+/**
+ * The pipeline used by NINetworkImageView by default. Runs on the default priority global queue,
+ * with as many stages at once as the device conditions allow.
+ *
+ * @fn NIImagePipeline::sharedPipeline
+ */
+
+/** @name Creating a Pipeline */
+
+/**
+ * Initializes a newly allocated pipeline that runs its stages on the given queue.
+ *
+ * The queue should be concurrent so that independent stages don't wait on each other.
+ *
+ * @fn NIImagePipeline::initWithQueue:
+ */
+
+/** @name Configuring a Pipeline */
+
+/**
+ * The queue that stages run on.
+ *
+ * @fn NIImagePipeline::queue
+ */
+
+/**
+ * The most bytes of decoded stage results that are kept for other requests to build on.
+ *
+ * Stage results are also dropped when the system runs low on memory.
+ *
+ * @fn NIImagePipeline::maxIntermediateImageCost
+ */
+
+/**
+ * The most stages that may run at once, or 0 for no limit.
+ *
+ * Stages beyond the limit wait for a running stage to finish. The shared pipeline follows
+ * Nimbus::adaptiveMaxConcurrentImageDecodeCount, so it backs off when the device is throttling.
+ *
+ * @fn NIImagePipeline::maxConcurrentStageCount
+ */
+
+/** @name Processing Images */
+
+/**
+ * Runs an image through each processor in order and calls the completion block on the main
+ * thread with the result.
+ *
+ * The name identifies the source image and everything that was done to it before it reached
+ * the pipeline. Processing a different image under a name that was used before discards the
+ * stages kept for the previous image. If a processor returns nil the remaining stages are skipped and the completion
+ * block receives nil. An empty list of processors completes with the source image.
+ *
+ * @fn NIImagePipeline::processImage:withName:processors:completion:
+ */
+
+/**
+ * Drops every intermediate image.
+ *
+ * @fn NIImagePipeline::removeAllIntermediateImages
+ */
+
+/**
+ * Returns the identifiers of the given processors joined into a single string, or nil if
+ * there are none.
+ *
+ * @fn NIImagePipeline::identifierForProcessors:
+ */
@@ -0,0 +1,327 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIImagePipeline.h"
+
+#import "NimbusCore.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+static const NSUInteger kDefaultMaxIntermediateImageCost = 8 * 1024 * 1024;
+
+static NSUInteger NIImagePipelineCostOfImage(UIImage* image) {
+  CGImageRef imageRef = image.CGImage;
+  return (NULL != imageRef) ? CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef) : 0;
+}
+
+@implementation NIBlockImageProcessor {
+  UIImage* (^_block)(UIImage* image);
+}
+
+@synthesize processorIdentifier = _processorIdentifier;
+
+- (id)initWithIdentifier:(NSString *)identifier block:(UIImage* (^)(UIImage* image))block {
+  NIDASSERT(NIIsStringWithAnyText(identifier));
+  NIDASSERT(nil != block);
+  if ((self = [super init])) {
+    _processorIdentifier = [identifier copy];
+    _block = [block copy];
+  }
+  return self;
+}
+
++ (instancetype)processorWithIdentifier:(NSString *)identifier block:(UIImage* (^)(UIImage* image))block {
+  return [[self alloc] initWithIdentifier:identifier block:block];
+}
+
+- (id)init {
+  return [self initWithIdentifier:nil block:nil];
+}
+
+- (UIImage *)processedImageFromImage:(UIImage *)image {
+  return (nil != _block) ? _block(image) : image;
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@ %@>", [super description], _processorIdentifier];
+}
+
+@end
+
+// The source image last processed under a name, and the generation its stages are keyed by.
+@interface NIImagePipelineSource : NSObject
+@property (nonatomic, weak) UIImage* image;
+@property (nonatomic, assign) NSUInteger generation;
+@end
+
+@implementation NIImagePipelineSource
+@end
+
+@implementation NIImagePipeline {
+  // Stage results keyed by the source name and generation followed by the identifiers of the
+  // stages so far.
+  NSCache* _stageImages;
+
+  // The current source of each name. Generations are never reused, so a name whose source was
+  // evicted from here can't pick up the stages of an earlier source.
+  NSCache* _sources;
+  NSUInteger _lastGeneration;
+
+  // Blocks waiting on a stage that is running, keyed like _stageImages.
+  NSMutableDictionary* _waitingBlocks;
+
+  // Stages that are waiting for one of the running stages to finish, oldest first.
+  NSMutableArray* _pendingStageBlocks;
+  NSUInteger _numberOfRunningStages;
+}
+
++ (NIImagePipeline *)sharedPipeline {
+  static NIImagePipeline* sPipeline = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sPipeline = [[NIImagePipeline alloc] initWithQueue:dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0)];
+    sPipeline.maxConcurrentStageCount = [Nimbus adaptiveMaxConcurrentImageDecodeCount];
+    [[NSNotificationCenter defaultCenter] addObserver:sPipeline
+                                             selector:@selector(deviceConditionsDidChange:)
+                                                 name:NIDeviceConditionsDidChangeNotification
+                                               object:nil];
+  });
+  return sPipeline;
+}
+
+- (void)deviceConditionsDidChange:(NSNotification *)notification {
+  self.maxConcurrentStageCount = [Nimbus adaptiveMaxConcurrentImageDecodeCount];
+}
+
+- (id)initWithQueue:(dispatch_queue_t)queue {
+  NIDASSERT(NULL != queue);
+  if ((self = [super init])) {
+    _queue = queue;
+    _stageImages = [[NSCache alloc] init];
+    _sources = [[NSCache alloc] init];
+    _waitingBlocks = [[NSMutableDictionary alloc] init];
+    _pendingStageBlocks = [[NSMutableArray alloc] init];
+    self.maxIntermediateImageCost = kDefaultMaxIntermediateImageCost;
+  }
+  return self;
+}
+
+- (id)init {
+  return [self initWithQueue:dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0)];
+}
+
+- (void)setMaxIntermediateImageCost:(NSUInteger)maxIntermediateImageCost {
+  _maxIntermediateImageCost = maxIntermediateImageCost;
+  _stageImages.totalCostLimit = maxIntermediateImageCost;
+}
+
+- (void)setMaxConcurrentStageCount:(NSUInteger)maxConcurrentStageCount {
+  // Raising the limit starts waiting stages right away. Lowering it lets the running stages
+  // finish and holds back the waiting ones until they fit.
+  NSMutableArray* blocksToRun = [NSMutableArray array];
+  @synchronized(self) {
+    _maxConcurrentStageCount = maxConcurrentStageCount;
+    while (_pendingStageBlocks.count > 0
+           && (0 == maxConcurrentStageCount || _numberOfRunningStages < maxConcurrentStageCount)) {
+      [blocksToRun addObject:_pendingStageBlocks[0]];
+      [_pendingStageBlocks removeObjectAtIndex:0];
+      _numberOfRunningStages++;
+    }
+  }
+  for (dispatch_block_t block in blocksToRun) {
+    [self dispatchStageBlock:block];
+  }
+}
+
+- (NSUInteger)maxConcurrentStageCount {
+  @synchronized(self) {
+    return _maxConcurrentStageCount;
+  }
+}
+
+// Runs the block on the queue once fewer than maxConcurrentStageCount stages are running.
+- (void)runStageBlock:(dispatch_block_t)block {
+  @synchronized(self) {
+    if (0 != _maxConcurrentStageCount && _numberOfRunningStages >= _maxConcurrentStageCount) {
+      [_pendingStageBlocks addObject:[block copy]];
+      return;
+    }
+    _numberOfRunningStages++;
+  }
+  [self dispatchStageBlock:block];
+}
+
+// Runs a stage that has already been counted as running, followed by the next waiting stage if
+// there is room for it.
+- (void)dispatchStageBlock:(dispatch_block_t)block {
+  dispatch_async(_queue, ^{
+    block();
+
+    dispatch_block_t nextBlock = nil;
+    @synchronized(self) {
+      // This stage still counts as running, so the next one takes over its slot.
+      if (_pendingStageBlocks.count > 0
+          && (0 == _maxConcurrentStageCount || _numberOfRunningStages <= _maxConcurrentStageCount)) {
+        nextBlock = _pendingStageBlocks[0];
+        [_pendingStageBlocks removeObjectAtIndex:0];
+      } else {
+        _numberOfRunningStages--;
+      }
+    }
+    if (nil != nextBlock) {
+      [self dispatchStageBlock:nextBlock];
+    }
+  });
+}
+
++ (NSString *)identifierForProcessors:(NSArray *)processors {
+  if (0 == processors.count) {
+    return nil;
+  }
+  NSMutableArray* identifiers = [NSMutableArray arrayWithCapacity:processors.count];
+  for (id<NIImageProcessor> processor in processors) {
+    [identifiers addObject:processor.processorIdentifier];
+  }
+  return [identifiers componentsJoinedByString:@","];
+}
+
+// Returns the generation of the source image. Processing a different image under a name that
+// was used before starts a new generation, so that the stages of the old image aren't reused.
+- (NSUInteger)generationOfSourceImage:(UIImage *)image withName:(NSString *)name {
+  @synchronized(self) {
+    NIImagePipelineSource* source = [_sources objectForKey:name];
+    if (nil == source || source.image != image) {
+      source = [[NIImagePipelineSource alloc] init];
+      source.image = image;
+      source.generation = ++_lastGeneration;
+      [_sources setObject:source forKey:name];
+    }
+    return source.generation;
+  }
+}
+
+- (NSString *)keyForStage:(NSUInteger)stage
+             ofProcessors:(NSArray *)processors
+                     name:(NSString *)name
+               generation:(NSUInteger)generation {
+  NSMutableString* key = [NSMutableString stringWithFormat:@"%@#%lu", name, (unsigned long)generation];
+  for (NSUInteger ix = 0; ix < stage; ++ix) {
+    [key appendFormat:@"|%@", [processors[ix] processorIdentifier]];
+  }
+  return key;
+}
+
+- (void)processImage:(UIImage *)image
+            withName:(NSString *)name
+          processors:(NSArray *)processors
+          completion:(void (^)(UIImage* image))completion {
+  NIDASSERT(NIIsStringWithAnyText(name));
+  if (nil == image || 0 == processors.count) {
+    dispatch_async(dispatch_get_main_queue(), ^{
+      completion(image);
+    });
+    return;
+  }
+
+  [self imageForStage:processors.count
+         ofProcessors:[processors copy]
+          sourceImage:image
+                 name:name
+           generation:[self generationOfSourceImage:image withName:name]
+           completion:^(UIImage* result) {
+             dispatch_async(dispatch_get_main_queue(), ^{
+               completion(result);
+             });
+           }];
+}
+
+// Calls the completion block with the result of the given number of stages, reusing and
+// joining earlier results where possible. The completion block may be called on any thread.
+- (void)imageForStage:(NSUInteger)stage
+         ofProcessors:(NSArray *)processors
+          sourceImage:(UIImage *)sourceImage
+                 name:(NSString *)name
+           generation:(NSUInteger)generation
+           completion:(void (^)(UIImage* image))completion {
+  if (0 == stage) {
+    completion(sourceImage);
+    return;
+  }
+
+  NSString* key = [self keyForStage:stage ofProcessors:processors name:name generation:generation];
+  UIImage* stageImage = [_stageImages objectForKey:key];
+  if (nil != stageImage) {
+    completion(stageImage);
+    return;
+  }
+
+  BOOL isRunning = NO;
+  @synchronized(self) {
+    NSMutableArray* waitingBlocks = [_waitingBlocks objectForKey:key];
+    isRunning = (nil != waitingBlocks);
+    if (!isRunning) {
+      waitingBlocks = [[NSMutableArray alloc] init];
+      [_waitingBlocks setObject:waitingBlocks forKey:key];
+    }
+    [waitingBlocks addObject:[completion copy]];
+  }
+  if (isRunning) {
+    return;
+  }
+
+  id<NIImageProcessor> processor = processors[stage - 1];
+  NSCache* stageImages = _stageImages;
+  [self imageForStage:stage - 1
+         ofProcessors:processors
+          sourceImage:sourceImage
+                 name:name
+           generation:generation
+           completion:^(UIImage* input) {
+             [self runStageBlock:^{
+               UIImage* output = nil;
+               if (nil != input) {
+                 @autoreleasepool {
+                   NI_SIGNPOST_BEGIN(NISignpostCategoryImages, "Process", input);
+                   output = [processor processedImageFromImage:input];
+                   NI_SIGNPOST_END(NISignpostCategoryImages, "Process", input);
+                 }
+               }
+               // The result is cached before the waiting blocks are taken so that a request
+               // arriving in between finds one or the other.
+               if (nil != output) {
+                 [stageImages setObject:output forKey:key cost:NIImagePipelineCostOfImage(output)];
+               }
+               NSArray* waitingBlocks = nil;
+               @synchronized(self) {
+                 waitingBlocks = [_waitingBlocks objectForKey:key];
+                 [_waitingBlocks removeObjectForKey:key];
+               }
+               for (void (^waitingBlock)(UIImage*) in waitingBlocks) {
+                 waitingBlock(output);
+               }
+             }];
+           }];
+}
+
+- (void)removeAllIntermediateImages {
+  [_stageImages removeAllObjects];
+  [_sources removeAllObjects];
+}
+
+@end
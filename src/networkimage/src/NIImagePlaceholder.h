@@ -0,0 +1,74 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+/**
+ * A stand-in for an image that can be shown while the image itself loads.
+ *
+ * Placeholders are made from an image's processed pixels right after they have been drawn, so
+ * they cost a pass over a display-sized bitmap rather than another decode of the full image.
+ * They are a few hundred bytes each and are meant to outlive the images they stand in for.
+ *
+ * @ingroup NimbusNetworkImage
+ */
+@interface NIImagePlaceholder : NSObject
+
++ (instancetype)placeholderWithImage:(UIImage *)image;
+
+// Designated initializer.
+- (id)initWithAverageColor:(UIColor *)averageColor thumbnail:(UIImage *)thumbnail;
+
+@property (nonatomic, readonly, strong) UIColor* averageColor;
+@property (nonatomic, readonly, strong) UIImage* thumbnail;
+
+- (unsigned long long)cost;
+
+@end
+
+/**
+ * Returns a placeholder for the image, or nil if the image has no bitmap.
+ *
+ * The image is drawn into a bitmap no larger than 16 pixels on its longest side, which is
+ * blurred with vImage and averaged with vDSP. Animated images return nil.
+ *
+ * @fn NIImagePlaceholder::placeholderWithImage:
+ */
+
+/**
+ * The average color of the image's pixels, taking their transparency into account.
+ *
+ * Useful as a background color for views whose images cover them exactly.
+ *
+ * @fn NIImagePlaceholder::averageColor
+ */
+
+/**
+ * A blurred image no larger than 16 pixels on its longest side.
+ *
+ * Image views scale the thumbnail up smoothly, so it can be shown in place of the image.
+ *
+ * @fn NIImagePlaceholder::thumbnail
+ */
+
+/**
+ * The number of bytes that the placeholder's thumbnail takes up, for use as its memory cache
+ * cost.
+ *
+ * @fn NIImagePlaceholder::cost
+ */
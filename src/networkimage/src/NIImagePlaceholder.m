@@ -0,0 +1,138 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIImagePlaceholder.h"
+
+#import "NIAnimatedImage.h"
+
+#import <Accelerate/Accelerate.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// The longest side of a placeholder's thumbnail, in pixels.
+static const size_t kNIPlaceholderThumbnailPixelSize = 16;
+
+// Matches the display-native layout that NIImageProcessing draws into: BGRA in memory.
+static const CGBitmapInfo kNIPlaceholderBitmapInfo = (kCGBitmapByteOrder32Little
+                                                      | kCGImageAlphaPremultipliedFirst);
+
+@implementation NIImagePlaceholder
+
++ (instancetype)placeholderWithImage:(UIImage *)image {
+  CGImageRef imageRef = image.CGImage;
+  if (nil == imageRef || [image isKindOfClass:[NIAnimatedImage class]]) {
+    return nil;
+  }
+  size_t imageWidth = CGImageGetWidth(imageRef);
+  size_t imageHeight = CGImageGetHeight(imageRef);
+  if (0 == imageWidth || 0 == imageHeight) {
+    return nil;
+  }
+
+  size_t width = kNIPlaceholderThumbnailPixelSize;
+  size_t height = kNIPlaceholderThumbnailPixelSize;
+  if (imageWidth > imageHeight) {
+    height = MAX(1, (size_t)roundf((float)kNIPlaceholderThumbnailPixelSize * imageHeight / imageWidth));
+  } else {
+    width = MAX(1, (size_t)roundf((float)kNIPlaceholderThumbnailPixelSize * imageWidth / imageHeight));
+  }
+
+  // Rows are packed so that vDSP can treat each channel as one strided vector.
+  size_t rowBytes = width * 4;
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGContextRef context = CGBitmapContextCreate(NULL, width, height, 8, rowBytes, colorSpace,
+                                               kNIPlaceholderBitmapInfo);
+  CGColorSpaceRelease(colorSpace);
+  if (nil == context) {
+    return nil;
+  }
+  CGContextSetInterpolationQuality(context, kCGInterpolationMedium);
+  CGContextDrawImage(context, CGRectMake(0, 0, width, height), imageRef);
+
+  vImage_Buffer buffer = {
+    .data = CGBitmapContextGetData(context),
+    .height = height,
+    .width = width,
+    .rowBytes = rowBytes,
+  };
+
+  // Average each channel of the premultiplied pixels, then undo the premultiplication once.
+  vDSP_Length numberOfPixels = width * height;
+  float* channel = malloc(numberOfPixels * sizeof(float));
+  float means[4] = {0, 0, 0, 0};
+  if (NULL != channel) {
+    for (NSUInteger ix = 0; ix < 4; ++ix) {
+      vDSP_vfltu8((const unsigned char *)buffer.data + ix, 4, channel, 1, numberOfPixels);
+      vDSP_meanv(channel, 1, &means[ix], numberOfPixels);
+    }
+    free(channel);
+  }
+  float alpha = means[3];
+  UIColor* averageColor = ((alpha > 0)
+                           ? [UIColor colorWithRed:means[2] / alpha
+                                             green:means[1] / alpha
+                                              blue:means[0] / alpha
+                                             alpha:alpha / 255]
+                           : [UIColor clearColor]);
+
+  // The tent filter treats the channels independently, so the byte order doesn't matter.
+  void* scratch = malloc(rowBytes * height);
+  if (NULL != scratch) {
+    vImage_Buffer blurred = buffer;
+    blurred.data = scratch;
+    vImage_Error error = vImageTentConvolve_ARGB8888(&buffer, &blurred, NULL, 0, 0, 5, 5, NULL,
+                                                     kvImageEdgeExtend);
+    if (kvImageNoError == error) {
+      memcpy(buffer.data, scratch, rowBytes * height);
+    }
+    free(scratch);
+  }
+
+  CGImageRef thumbnailRef = CGBitmapContextCreateImage(context);
+  CGContextRelease(context);
+  UIImage* thumbnail = nil;
+  if (nil != thumbnailRef) {
+    thumbnail = [UIImage imageWithCGImage:thumbnailRef scale:1 orientation:image.imageOrientation];
+    CGImageRelease(thumbnailRef);
+  }
+
+  return [[self alloc] initWithAverageColor:averageColor thumbnail:thumbnail];
+}
+
+- (id)initWithAverageColor:(UIColor *)averageColor thumbnail:(UIImage *)thumbnail {
+  if ((self = [super init])) {
+    _averageColor = averageColor;
+    _thumbnail = thumbnail;
+  }
+  return self;
+}
+
+- (id)init {
+  return [self initWithAverageColor:nil thumbnail:nil];
+}
+
+- (unsigned long long)cost {
+  CGImageRef thumbnailRef = self.thumbnail.CGImage;
+  if (nil == thumbnailRef) {
+    return 0;
+  }
+  return CGImageGetBytesPerRow(thumbnailRef) * CGImageGetHeight(thumbnailRef);
+}
+
+@end
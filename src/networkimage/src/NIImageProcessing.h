@@ -19,6 +19,9 @@
 
 #import "NINetworkImageView.h"  // For NINetworkImageViewScaleOptions
 
+@class NIImageStyle;
+@protocol NIImageDecoder;
+
 #import "NimbusCore.h"
 
 @interface NIImageProcessing : NSObject
@@ -50,4 +53,115 @@
                 scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions
         interpolationQuality:(CGInterpolationQuality)interpolationQuality;
 
+/**
+ * Takes a source image and resizes/crops it using the given resampling engine.
+ *
+ * The other parameters behave exactly as they do in
+ * imageFromSource:withContentMode:cropRect:displaySize:scaleOptions:interpolationQuality:,
+ * which always uses NINetworkImageViewResamplingEngineCoreGraphics.
+ *
+ * @param resamplingEngine The engine used to resample the source. If vImage can't process
+ *                              the image then CoreGraphics is used instead.
+ *
+ * @returns The resized and cropped image.
+ */
++ (UIImage *)imageFromSource:(UIImage *)src
+             withContentMode:(UIViewContentMode)contentMode
+                    cropRect:(CGRect)cropRect
+                 displaySize:(CGSize)displaySize
+                scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions
+        interpolationQuality:(CGInterpolationQuality)interpolationQuality
+            resamplingEngine:(NINetworkImageViewResamplingEngine)resamplingEngine;
+
+/**
+ * Decodes encoded image data directly at the resolution needed to display it.
+ *
+ * Rather than decoding the full bitmap and then scaling it down, ImageIO is asked to produce
+ * a thumbnail whose largest dimension is just big enough to cover displaySize on this device's
+ * screen. The thumbnail is then cropped and resized using
+ * imageFromSource:withContentMode:cropRect:displaySize:scaleOptions:interpolationQuality:resamplingEngine:.
+ *
+ * Returns nil when downsampling does not apply: when a crop rect is provided, when there is
+ * no display size, when the content mode does not scale the image, or when the image is
+ * no larger than needed. In these cases the caller should decode the full image instead.
+ *
+ * @returns The resized and cropped image, or nil if the data was not downsampled.
+ */
++ (UIImage *)imageFromData:(NSData *)data
+           withContentMode:(UIViewContentMode)contentMode
+                  cropRect:(CGRect)cropRect
+               displaySize:(CGSize)displaySize
+              scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions
+      interpolationQuality:(CGInterpolationQuality)interpolationQuality
+          resamplingEngine:(NINetworkImageViewResamplingEngine)resamplingEngine;
+
+/**
+ * Decodes encoded image data with the given decoder directly at the resolution needed to
+ * display it.
+ *
+ * Behaves exactly like
+ * imageFromData:withContentMode:cropRect:displaySize:scaleOptions:interpolationQuality:resamplingEngine:,
+ * which uses NIImageIODecoder::decoder, and returns nil in the same cases. It also returns nil
+ * if the decoder can't tell how large the image is.
+ *
+ * @returns The resized and cropped image, or nil if the data was not downsampled.
+ */
++ (UIImage *)imageFromData:(NSData *)data
+               withDecoder:(id<NIImageDecoder>)decoder
+               contentMode:(UIViewContentMode)contentMode
+                  cropRect:(CGRect)cropRect
+               displaySize:(CGSize)displaySize
+              scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions
+      interpolationQuality:(CGInterpolationQuality)interpolationQuality
+          resamplingEngine:(NINetworkImageViewResamplingEngine)resamplingEngine;
+
+/**
+ * Returns a copy of the image that has been fully decoded into a display-native pixel format.
+ *
+ * Images created from encoded data are usually decoded lazily the first time they are drawn,
+ * which happens on the main thread. Calling this method on a background thread moves this cost
+ * off of the main thread. Animated images and images without a CGImage are returned as-is.
+ *
+ * Images returned by the other methods in this class are already decoded.
+ *
+ * @returns The decoded image.
+ */
++ (UIImage *)decodedImageFromImage:(UIImage *)image;
+
+/**
+ * Returns a copy of the image with the style's corners, border and background drawn into it.
+ *
+ * The image keeps its size and scale. The result is decoded into a display-native bitmap,
+ * which is opaque when the style is. Returns the image unchanged when style is nil and for
+ * animated images.
+ *
+ * This is meant to be called on the same background queue that resizes the image, so that
+ * image views can drop layer.cornerRadius and masksToBounds altogether.
+ *
+ * @returns The styled image.
+ */
++ (UIImage *)imageFromImage:(UIImage *)image withStyle:(NIImageStyle *)style;
+
+/** @name Storing Processed Images */
+
+/**
+ * Returns the decoded pixels of the image in a form that can be memory mapped.
+ *
+ * The data is a small header followed by the image's rows in a display-native pixel format.
+ * Images that are not already decoded are decoded first, so this should be called on a
+ * background thread. Returns nil for animated images.
+ *
+ * @see imageFromMappableData:
+ */
++ (NSData *)mappableDataFromImage:(UIImage *)image;
+
+/**
+ * Returns an image that draws directly from data created by mappableDataFromImage:.
+ *
+ * The image retains the data and uses its bytes as-is, so nothing is decoded or copied. When
+ * the data is a memory-mapped file the pixels are paged in from disk as they are needed.
+ * Returns nil if the data is not a mappable image.
+ */
++ (UIImage *)imageFromMappableData:(NSData *)data;
+
 @end
@@ -15,12 +15,42 @@
 //
 
 #import "NIImageProcessing.h"
+
+#import "NIImageDecoder.h"
+#import "NIImageStyle.h"
 #import "NimbusCore.h"
 
+#import <Accelerate/Accelerate.h>
+
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "Nimbus requires ARC support."
 #endif
 
+// Core Animation can display 32 bit little-endian BGRA bitmaps without converting them first.
+static const CGBitmapInfo kNIDisplayNativeBitmapInfo = (kCGBitmapByteOrder32Little
+                                                        | kCGImageAlphaPremultipliedFirst);
+
+// The header that precedes the pixels of a mappable image. The pixels start on a 64 byte
+// boundary so that the rows stay aligned once the file has been mapped.
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t width;
+  uint32_t height;
+  uint32_t bytesPerRow;
+  uint32_t bitmapInfo;
+  uint32_t orientation;
+  float scale;
+  uint8_t reserved[32];
+} NIMappableImageHeader;
+
+static const uint32_t kNIMappableImageMagic = 0x494d494e; // "NIMI"
+static const uint32_t kNIMappableImageVersion = 1;
+
+static void NIMappableImageReleaseData(void* info, const void* data, size_t size) {
+  CFBridgingRelease(info);
+}
+
 @implementation NIImageProcessing
 
 /**
@@ -151,12 +181,141 @@
   }
 }
 
+/**
+ * Render the source image into a new bitmap of the given pixel size using CoreGraphics.
+ *
+ * The returned image must be released by the caller.
+ */
++ (CGImageRef)newImageByDrawingImage:(CGImageRef)srcImageRef
+                         toPixelSize:(CGSize)pixelSize
+                            blitRect:(CGRect)blitRect
+                interpolationQuality:(CGInterpolationQuality)interpolationQuality {
+  // Create a new bitmap context for the image with the same format as the source.
+  // See table "Supported Pixel Formats" in the following guide for support iOS bitmap formats:
+  // http://developer.apple.com/library/mac/#documentation/GraphicsImaging/Conceptual/drawingwithquartz2d/dq_context/dq_context.html
+  // Thumbnails tend to be processed at the same handful of sizes, so their backing stores are
+  // reused from the shared pool. Pooled contexts start out cleared.
+  NIBitmapBufferPool* pool = [NIBitmapBufferPool sharedPool];
+  CGContextRef dstBmp = [pool newBitmapContextWithWidth:(size_t)pixelSize.width
+                                                 height:(size_t)pixelSize.height
+                                             bitmapInfo:kNIDisplayNativeBitmapInfo];
+
+  // If this fails then we're likely creating an invalid bitmap and shit's about to go down.
+  // In production this will fail somewhat gracefully, in that we'll end up just using the
+  // source image instead of the cropped and resized image.
+  NIDASSERT(nil != dstBmp);
+
+  CGImageRef resultImageRef = nil;
+  if (nil != dstBmp) {
+    // Render the source image into the destination image.
+    CGContextSetInterpolationQuality(dstBmp, interpolationQuality);
+    CGContextDrawImage(dstBmp, blitRect, srcImageRef);
+
+    resultImageRef = [pool newImageFromBitmapContext:dstBmp];
+
+    CGContextRelease(dstBmp);
+  }
+
+  return resultImageRef;
+}
+
+/**
+ * Resample the source image into a new bitmap of the given pixel size using vImage.
+ *
+ * Returns nil if vImage can't handle this blit, in which case the CoreGraphics path should be
+ * used. The returned image must be released by the caller.
+ */
++ (CGImageRef)newImageByResamplingImage:(CGImageRef)srcImageRef
+                            toPixelSize:(CGSize)pixelSize
+                               blitRect:(CGRect)blitRect
+                   interpolationQuality:(CGInterpolationQuality)interpolationQuality {
+  // vImage only scales, so blits that would be clipped by the destination are left to
+  // CoreGraphics.
+  CGRect dstRect = CGRectMake(0, 0, pixelSize.width, pixelSize.height);
+  if (CGRectIsEmpty(blitRect) || !CGRectContainsRect(dstRect, blitRect)) {
+    return nil;
+  }
+
+  // Both buffers use the same premultiplied layout as the CoreGraphics path. vImage's ARGB8888
+  // functions treat the channels independently, so their order doesn't matter.
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  vImage_CGImageFormat format = {
+    .bitsPerComponent = 8,
+    .bitsPerPixel = 32,
+    .colorSpace = colorSpace,
+    .bitmapInfo = kNIDisplayNativeBitmapInfo,
+    .version = 0,
+    .decode = NULL,
+    .renderingIntent = kCGRenderingIntentDefault,
+  };
+
+  vImage_Buffer srcBuffer;
+  vImage_Error error = vImageBuffer_InitWithCGImage(&srcBuffer, &format, NULL, srcImageRef,
+                                                    kvImageNoFlags);
+  CGColorSpaceRelease(colorSpace);
+  if (kvImageNoError != error) {
+    return nil;
+  }
+
+  CGImageRef resultImageRef = nil;
+
+  // The pooled destination starts out transparent, which covers any area outside the blit.
+  NIBitmapBufferPool* pool = [NIBitmapBufferPool sharedPool];
+  CGContextRef dstBmp = [pool newBitmapContextWithWidth:(size_t)pixelSize.width
+                                                 height:(size_t)pixelSize.height
+                                             bitmapInfo:format.bitmapInfo];
+  if (nil != dstBmp) {
+    // Scale directly into the blit rect's region of the destination. Bitmap rows run from the
+    // top of the image, whereas blitRect's origin is at the bottom.
+    size_t height = CGBitmapContextGetHeight(dstBmp);
+    size_t rowBytes = CGBitmapContextGetBytesPerRow(dstBmp);
+    size_t blitX = (size_t)CGRectGetMinX(blitRect);
+    size_t blitY = height - (size_t)CGRectGetMaxY(blitRect);
+    vImage_Buffer blitBuffer = {
+      .data = (uint8_t *)CGBitmapContextGetData(dstBmp) + blitY * rowBytes + blitX * 4,
+      .height = (vImagePixelCount)CGRectGetHeight(blitRect),
+      .width = (vImagePixelCount)CGRectGetWidth(blitRect),
+      .rowBytes = rowBytes,
+    };
+
+    vImage_Flags flags = (kCGInterpolationHigh == interpolationQuality
+                          ? kvImageHighQualityResampling
+                          : kvImageNoFlags);
+    error = vImageScale_ARGB8888(&srcBuffer, &blitBuffer, NULL, flags);
+
+    if (kvImageNoError == error) {
+      resultImageRef = [pool newImageFromBitmapContext:dstBmp];
+    }
+    CGContextRelease(dstBmp);
+  }
+
+  free(srcBuffer.data);
+
+  return resultImageRef;
+}
+
 + (UIImage *)imageFromSource:(UIImage *)src
              withContentMode:(UIViewContentMode)contentMode
                     cropRect:(CGRect)cropRect
                  displaySize:(CGSize)displaySize
                 scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions
         interpolationQuality:(CGInterpolationQuality)interpolationQuality {
+  return [self imageFromSource:src
+               withContentMode:contentMode
+                      cropRect:cropRect
+                   displaySize:displaySize
+                  scaleOptions:scaleOptions
+          interpolationQuality:interpolationQuality
+              resamplingEngine:NINetworkImageViewResamplingEngineCoreGraphics];
+}
+
++ (UIImage *)imageFromSource:(UIImage *)src
+             withContentMode:(UIViewContentMode)contentMode
+                    cropRect:(CGRect)cropRect
+                 displaySize:(CGSize)displaySize
+                scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions
+        interpolationQuality:(CGInterpolationQuality)interpolationQuality
+            resamplingEngine:(NINetworkImageViewResamplingEngine)resamplingEngine {
 
   UIImage* resultImage = src;
 
@@ -258,57 +417,37 @@
     // Round any remainder on the display size dimensions.
     displaySize = CGSizeMake(roundf(displaySize.width), roundf(displaySize.height));
 
-    // See table "Supported Pixel Formats" in the following guide for support iOS bitmap formats:
-    // http://developer.apple.com/library/mac/#documentation/GraphicsImaging/Conceptual/drawingwithquartz2d/dq_context/dq_context.html
-    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
-    CGBitmapInfo bmi = (CGBitmapInfo)kCGImageAlphaPremultipliedLast;
-
     // For screen sizes with higher resolutions, we create a larger image with a scale value
     // so that it appears crisper on the screen.
     CGFloat screenScale = NIScreenScale();
 
-    // Create our final composite image.
-    CGContextRef dstBmp = CGBitmapContextCreate(NULL,
-                                                displaySize.width * screenScale,
-                                                displaySize.height * screenScale,
-                                                8,
-                                                0,
-                                                colorSpace,
-                                                bmi);
-
-    // If this fails then we're likely creating an invalid bitmap and shit's about to go down.
-    // In production this will fail somewhat gracefully, in that we'll end up just using the
-    // source image instead of the cropped and resized image.
-    NIDASSERT(nil != dstBmp);
-
-    if (nil != dstBmp) {
-      CGRect dstRect = CGRectMake(0, 0,
-                                  displaySize.width * screenScale,
+    CGSize pixelSize = CGSizeMake(displaySize.width * screenScale,
                                   displaySize.height * screenScale);
-
-      // Render the source image into the destination image.
-      CGContextClearRect(dstBmp, dstRect);
-      CGContextSetInterpolationQuality(dstBmp, interpolationQuality);
-
-      CGRect scaledBlitRect = CGRectMake(dstBlitRect.origin.x * screenScale,
-                                         dstBlitRect.origin.y * screenScale,
-                                         dstBlitRect.size.width * screenScale,
-                                         dstBlitRect.size.height * screenScale);
-      CGContextDrawImage(dstBmp, scaledBlitRect, srcImageRef);
-
-      CGImageRef resultImageRef = CGBitmapContextCreateImage(dstBmp);
-
-      if (nil != resultImageRef) {
-        resultImage = [UIImage imageWithCGImage:resultImageRef
-                                          scale:screenScale
-                                    orientation:src.imageOrientation];
-        CGImageRelease(resultImageRef);
-      }
-
-      CGContextRelease(dstBmp);
+    CGRect scaledBlitRect = CGRectMake(dstBlitRect.origin.x * screenScale,
+                                       dstBlitRect.origin.y * screenScale,
+                                       dstBlitRect.size.width * screenScale,
+                                       dstBlitRect.size.height * screenScale);
+
+    CGImageRef resultImageRef = nil;
+    if (NINetworkImageViewResamplingEngineVImage == resamplingEngine) {
+      resultImageRef = [self newImageByResamplingImage:srcImageRef
+                                           toPixelSize:pixelSize
+                                              blitRect:scaledBlitRect
+                                  interpolationQuality:interpolationQuality];
+    }
+    if (nil == resultImageRef) {
+      resultImageRef = [self newImageByDrawingImage:srcImageRef
+                                        toPixelSize:pixelSize
+                                           blitRect:scaledBlitRect
+                               interpolationQuality:interpolationQuality];
     }
 
-    CGColorSpaceRelease(colorSpace);
+    if (nil != resultImageRef) {
+      resultImage = [UIImage imageWithCGImage:resultImageRef
+                                        scale:screenScale
+                                  orientation:src.imageOrientation];
+      CGImageRelease(resultImageRef);
+    }
 
   } else if (nil != croppedImageRef) {
     resultImage = [UIImage imageWithCGImage:srcImageRef];
@@ -325,4 +464,307 @@
   return resultImage;
 }
 
+/**
+ * Calculate the largest pixel dimension a decoded image needs in order to be displayed at
+ * displaySize without upscaling, or 0 if the full image is needed.
+ */
++ (CGFloat)maxPixelSizeWithImagePixelSize:(CGSize)imagePixelSize
+                              displaySize:(CGSize)displaySize
+                              contentMode:(UIViewContentMode)contentMode {
+  if (imagePixelSize.width <= 0 || imagePixelSize.height <= 0) {
+    return 0;
+  }
+
+  CGFloat screenScale = NIScreenScale();
+  CGFloat widthScale = (displaySize.width * screenScale) / imagePixelSize.width;
+  CGFloat heightScale = (displaySize.height * screenScale) / imagePixelSize.height;
+
+  CGFloat scale;
+  switch (contentMode) {
+    case UIViewContentModeScaleAspectFit:
+      scale = MIN(widthScale, heightScale);
+      break;
+
+    case UIViewContentModeScaleAspectFill:
+    case UIViewContentModeScaleToFill:
+      // Both dimensions must cover the display, so the larger of the two scales wins.
+      scale = MAX(widthScale, heightScale);
+      break;
+
+    default:
+      // The remaining content modes show the source at its natural size.
+      return 0;
+  }
+
+  if (scale >= 1) {
+    // The image is already no larger than it needs to be.
+    return 0;
+  }
+
+  return ceilf(MAX(imagePixelSize.width, imagePixelSize.height) * scale);
+}
+
++ (UIImage *)imageFromData:(NSData *)data
+           withContentMode:(UIViewContentMode)contentMode
+                  cropRect:(CGRect)cropRect
+               displaySize:(CGSize)displaySize
+              scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions
+      interpolationQuality:(CGInterpolationQuality)interpolationQuality
+          resamplingEngine:(NINetworkImageViewResamplingEngine)resamplingEngine {
+  return [self imageFromData:data
+                 withDecoder:[NIImageIODecoder decoder]
+                 contentMode:contentMode
+                    cropRect:cropRect
+                 displaySize:displaySize
+                scaleOptions:scaleOptions
+        interpolationQuality:interpolationQuality
+            resamplingEngine:resamplingEngine];
+}
+
++ (UIImage *)imageFromData:(NSData *)data
+               withDecoder:(id<NIImageDecoder>)decoder
+               contentMode:(UIViewContentMode)contentMode
+                  cropRect:(CGRect)cropRect
+               displaySize:(CGSize)displaySize
+              scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions
+      interpolationQuality:(CGInterpolationQuality)interpolationQuality
+          resamplingEngine:(NINetworkImageViewResamplingEngine)resamplingEngine {
+  // Crop rects are expressed relative to the full source image, so we can't downsample them.
+  if (nil == data || nil == decoder
+      || (!CGRectIsEmpty(cropRect) && !CGRectEqualToRect(cropRect, CGRectMake(0, 0, 1, 1)))
+      || displaySize.width <= 0
+      || displaySize.height <= 0) {
+    return nil;
+  }
+
+  UIImage* resultImage = nil;
+  NI_SIGNPOST_BEGIN(NISignpostCategoryImages, "Decode", data);
+
+  CGFloat maxPixelSize = [self maxPixelSizeWithImagePixelSize:[decoder pixelSizeOfImageWithData:data]
+                                                  displaySize:displaySize
+                                                  contentMode:contentMode];
+  if (maxPixelSize > 0) {
+    UIImage* thumbnail = [decoder imageWithData:data maxPixelSize:maxPixelSize];
+    if (nil != thumbnail) {
+      resultImage = [self imageFromSource:thumbnail
+                          withContentMode:contentMode
+                                 cropRect:CGRectZero
+                              displaySize:displaySize
+                             scaleOptions:scaleOptions
+                     interpolationQuality:interpolationQuality
+                         resamplingEngine:resamplingEngine];
+    }
+  }
+
+  NI_SIGNPOST_END(NISignpostCategoryImages, "Decode", data);
+
+  return resultImage;
+}
+
++ (UIImage *)decodedImageFromImage:(UIImage *)image {
+  CGImageRef imageRef = image.CGImage;
+  if (nil == imageRef || nil != image.images) {
+    return image;
+  }
+
+  CGImageAlphaInfo alphaInfo = (CGImageAlphaInfo)(CGImageGetBitmapInfo(imageRef) & kCGBitmapAlphaInfoMask);
+  BOOL isOpaque = (kCGImageAlphaNone == alphaInfo
+                   || kCGImageAlphaNoneSkipFirst == alphaInfo
+                   || kCGImageAlphaNoneSkipLast == alphaInfo);
+  CGBitmapInfo bitmapInfo = (isOpaque
+                             ? (kCGBitmapByteOrder32Little | kCGImageAlphaNoneSkipFirst)
+                             : kNIDisplayNativeBitmapInfo);
+
+  size_t width = CGImageGetWidth(imageRef);
+  size_t height = CGImageGetHeight(imageRef);
+  NIBitmapBufferPool* pool = [NIBitmapBufferPool sharedPool];
+  CGContextRef context = [pool newBitmapContextWithWidth:width height:height bitmapInfo:bitmapInfo];
+  if (nil == context) {
+    return image;
+  }
+
+  // Drawing forces the image to decode, and the bitmap is already in the format Core Animation
+  // wants, so nothing is left to do when the image is first displayed.
+  NI_SIGNPOST_BEGIN(NISignpostCategoryImages, "Decode", imageRef);
+  CGContextDrawImage(context, CGRectMake(0, 0, width, height), imageRef);
+  NI_SIGNPOST_END(NISignpostCategoryImages, "Decode", imageRef);
+  CGImageRef decodedImageRef = [pool newImageFromBitmapContext:context];
+  CGContextRelease(context);
+
+  UIImage* decodedImage = image;
+  if (nil != decodedImageRef) {
+    decodedImage = [UIImage imageWithCGImage:decodedImageRef
+                                       scale:image.scale
+                                 orientation:image.imageOrientation];
+    CGImageRelease(decodedImageRef);
+  }
+  return decodedImage;
+}
+
++ (UIImage *)imageFromImage:(UIImage *)image withStyle:(NIImageStyle *)style {
+  if (nil == style || nil == image || nil != image.images
+      || image.size.width <= 0 || image.size.height <= 0) {
+    return image;
+  }
+
+  CGSize size = image.size;
+  CGFloat scale = image.scale;
+  size_t width = (size_t)NICGFloatCeil(size.width * scale);
+  size_t height = (size_t)NICGFloatCeil(size.height * scale);
+  CGBitmapInfo bitmapInfo = ([style isOpaque]
+                             ? (kCGBitmapByteOrder32Little | kCGImageAlphaNoneSkipFirst)
+                             : kNIDisplayNativeBitmapInfo);
+
+  NIBitmapBufferPool* pool = [NIBitmapBufferPool sharedPool];
+  CGContextRef context = [pool newBitmapContextWithWidth:width height:height bitmapInfo:bitmapInfo];
+  if (nil == context) {
+    return image;
+  }
+
+  // Draw in points with UIKit's coordinates so that the image's orientation is honored.
+  CGContextTranslateCTM(context, 0, height);
+  CGContextScaleCTM(context, scale, -scale);
+  UIGraphicsPushContext(context);
+
+  CGRect bounds = CGRectMake(0, 0, size.width, size.height);
+  if (nil != style.backgroundColor) {
+    [style.backgroundColor setFill];
+    UIRectFill(bounds);
+  }
+
+  CGRect clipRect = bounds;
+  CGFloat cornerRadius = MIN(style.cornerRadius, MIN(size.width, size.height) / 2);
+  if (style.clipsToCircle) {
+    CGFloat diameter = MIN(size.width, size.height);
+    clipRect = CGRectMake((size.width - diameter) / 2, (size.height - diameter) / 2, diameter, diameter);
+    cornerRadius = diameter / 2;
+  }
+  UIBezierPath* clipPath = (cornerRadius > 0
+                            ? [UIBezierPath bezierPathWithRoundedRect:clipRect cornerRadius:cornerRadius]
+                            : [UIBezierPath bezierPathWithRect:clipRect]);
+
+  CGContextSaveGState(context);
+  [clipPath addClip];
+  [image drawInRect:bounds];
+  CGContextRestoreGState(context);
+
+  if (nil != style.borderColor && style.borderWidth > 0) {
+    // Strokes are centered on the path, so inset it to keep the whole border inside the clip.
+    CGFloat inset = style.borderWidth / 2;
+    CGRect borderRect = CGRectInset(clipRect, inset, inset);
+    UIBezierPath* borderPath = (cornerRadius > 0
+                                ? [UIBezierPath bezierPathWithRoundedRect:borderRect
+                                                             cornerRadius:MAX(0, cornerRadius - inset)]
+                                : [UIBezierPath bezierPathWithRect:borderRect]);
+    borderPath.lineWidth = style.borderWidth;
+    [style.borderColor setStroke];
+    [borderPath stroke];
+  }
+
+  UIGraphicsPopContext();
+  CGImageRef styledImageRef = [pool newImageFromBitmapContext:context];
+  CGContextRelease(context);
+  if (nil == styledImageRef) {
+    return image;
+  }
+
+  UIImage* styledImage = [UIImage imageWithCGImage:styledImageRef scale:scale orientation:UIImageOrientationUp];
+  CGImageRelease(styledImageRef);
+  return styledImage;
+}
+
++ (NSData *)mappableDataFromImage:(UIImage *)image {
+  UIImage* decodedImage = [self decodedImageFromImage:image];
+  CGImageRef imageRef = decodedImage.CGImage;
+  if (nil == imageRef || nil != image.images) {
+    return nil;
+  }
+  // Only our own display-native format is stored, so reading never needs to convert.
+  CGBitmapInfo bitmapInfo = CGImageGetBitmapInfo(imageRef);
+  if (32 != CGImageGetBitsPerPixel(imageRef)
+      || (kCGBitmapByteOrder32Little != (bitmapInfo & kCGBitmapByteOrderMask))) {
+    return nil;
+  }
+
+  CFDataRef pixels = CGDataProviderCopyData(CGImageGetDataProvider(imageRef));
+  if (nil == pixels) {
+    return nil;
+  }
+
+  NIMappableImageHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = kNIMappableImageMagic;
+  header.version = kNIMappableImageVersion;
+  header.width = (uint32_t)CGImageGetWidth(imageRef);
+  header.height = (uint32_t)CGImageGetHeight(imageRef);
+  header.bytesPerRow = (uint32_t)CGImageGetBytesPerRow(imageRef);
+  header.bitmapInfo = (uint32_t)bitmapInfo;
+  header.orientation = (uint32_t)decodedImage.imageOrientation;
+  header.scale = (float)decodedImage.scale;
+
+  size_t numberOfPixelBytes = (size_t)header.bytesPerRow * header.height;
+  NSMutableData* data = nil;
+  if ((size_t)CFDataGetLength(pixels) >= numberOfPixelBytes) {
+    data = [NSMutableData dataWithCapacity:sizeof(header) + numberOfPixelBytes];
+    [data appendBytes:&header length:sizeof(header)];
+    [data appendBytes:CFDataGetBytePtr(pixels) length:numberOfPixelBytes];
+  }
+  CFRelease(pixels);
+  return data;
+}
+
++ (UIImage *)imageFromMappableData:(NSData *)data {
+  if (data.length < sizeof(NIMappableImageHeader)) {
+    return nil;
+  }
+  NIMappableImageHeader header;
+  memcpy(&header, data.bytes, sizeof(header));
+  if (kNIMappableImageMagic != header.magic
+      || kNIMappableImageVersion != header.version
+      || 0 == header.width || 0 == header.height
+      || header.bytesPerRow < header.width * 4
+      || header.scale <= 0) {
+    return nil;
+  }
+  size_t numberOfPixelBytes = (size_t)header.bytesPerRow * header.height;
+  if (data.length < sizeof(header) + numberOfPixelBytes) {
+    return nil;
+  }
+
+  // The provider points straight into the data, which for a mapped file means the pixels are
+  // paged in from disk as they are drawn rather than copied or decoded.
+  CGDataProviderRef provider = CGDataProviderCreateWithData((__bridge_retained void *)data,
+                                                            (const uint8_t *)data.bytes + sizeof(header),
+                                                            numberOfPixelBytes,
+                                                            NIMappableImageReleaseData);
+  if (nil == provider) {
+    CFBridgingRelease((__bridge void *)data);
+    return nil;
+  }
+
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGImageRef imageRef = CGImageCreate(header.width,
+                                      header.height,
+                                      8,
+                                      32,
+                                      header.bytesPerRow,
+                                      colorSpace,
+                                      (CGBitmapInfo)header.bitmapInfo,
+                                      provider,
+                                      NULL,
+                                      false,
+                                      kCGRenderingIntentDefault);
+  CGColorSpaceRelease(colorSpace);
+  CGDataProviderRelease(provider);
+
+  UIImage* image = nil;
+  if (nil != imageRef) {
+    image = [UIImage imageWithCGImage:imageRef
+                                scale:header.scale
+                          orientation:(UIImageOrientation)header.orientation];
+    CGImageRelease(imageRef);
+  }
+  return image;
+}
+
 @end
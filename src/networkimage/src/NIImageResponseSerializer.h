@@ -18,6 +18,9 @@
 
 #import "NINetworkImageView.h" // For NINetworkImageViewScaleOptions.
 
+@class NIImageStyle;
+@protocol NIImageDecoder;
+
 /**
  * The NIImageResponseSerializer class provides an implementation of the AFNetworking serializer
  * object for Nimbus network images.
@@ -32,4 +35,52 @@
 @property (nonatomic, assign) CGSize displaySize;
 @property (nonatomic, assign) NINetworkImageViewScaleOptions scaleOptions;
 @property (nonatomic, assign) CGInterpolationQuality interpolationQuality;
+@property (nonatomic, assign) NINetworkImageViewResamplingEngine resamplingEngine;
+@property (nonatomic, assign) BOOL forcesImageDecoding; // Default: NO
+@property (nonatomic, assign) BOOL decodesAnimatedImages; // Default: NO
+@property (nonatomic, copy) NIImageStyle* style; // Default: nil
+@property (nonatomic, copy) NSArray* imageDecoders; // Default: HEIC and WebP decoders
+@property (nonatomic, strong) NIMemoryCache* placeholderMemoryCache; // Default: nil
+@property (nonatomic, copy) NSString* placeholderName; // Default: nil
+
+- (NSString *)acceptHeaderValue;
 @end
+
+/**
+ * The decoders that are tried, in order, before falling back to UIImage.
+ *
+ * Each object conforms to NIImageDecoder. The first decoder that can decode a response decodes
+ * it, straight at the display size when the image is being scaled down. The result is then
+ * cropped, resized, styled and decoded exactly like any other image.
+ *
+ * Setting the decoders adds their content types to acceptableContentTypes. By default this
+ * contains NIImageIODecoder::HEICDecoder and NIImageIODecoder::WebPDecoder, which only accept
+ * their formats on devices that can decode them.
+ *
+ * @fn NIImageResponseSerializer::imageDecoders
+ */
+
+/**
+ * Returns the value of the Accept header that requests should be sent with.
+ *
+ * The content types of the image decoders are listed first, ahead of any other image type, so
+ * that servers which can encode more compact formats will send them.
+ *
+ * @fn NIImageResponseSerializer::acceptHeaderValue
+ */
+
+/**
+ * The cache that a placeholder of each processed image is stored in.
+ *
+ * When both this and placeholderName are set, an NIImagePlaceholder is made from every still
+ * image as soon as it has been processed, while its pixels are still in the CPU's caches, and
+ * stored under placeholderName.
+ *
+ * @fn NIImageResponseSerializer::placeholderMemoryCache
+ */
+
+/**
+ * The name that placeholders are stored under in the placeholderMemoryCache.
+ *
+ * @fn NIImageResponseSerializer::placeholderName
+ */
@@ -16,21 +16,171 @@
 
 #import "NIImageResponseSerializer.h"
 
+#import "NIAnimatedImage.h"
+#import "NIImageDecoder.h"
+#import "NIImagePlaceholder.h"
 #import "NIImageProcessing.h"
+#import "NIImageStyle.h"
 
 @implementation NIImageResponseSerializer
 
+- (id)init {
+  if ((self = [super init])) {
+    self.imageDecoders = @[[NIImageIODecoder HEICDecoder], [NIImageIODecoder WebPDecoder]];
+  }
+  return self;
+}
+
+- (void)setImageDecoders:(NSArray *)imageDecoders {
+  _imageDecoders = [imageDecoders copy];
+
+  NSMutableSet* contentTypes = [NSMutableSet setWithSet:self.acceptableContentTypes];
+  for (id<NIImageDecoder> decoder in _imageDecoders) {
+    [contentTypes addObjectsFromArray:[decoder contentTypes]];
+  }
+  self.acceptableContentTypes = contentTypes;
+}
+
+- (NSString *)acceptHeaderValue {
+  NSMutableArray* contentTypes = [NSMutableArray array];
+  for (id<NIImageDecoder> decoder in self.imageDecoders) {
+    for (NSString* contentType in [decoder contentTypes]) {
+      if (![contentTypes containsObject:contentType]) {
+        [contentTypes addObject:contentType];
+      }
+    }
+  }
+  [contentTypes addObject:@"image/*;q=0.8"];
+  return [contentTypes componentsJoinedByString:@","];
+}
+
+- (id<NIImageDecoder>)decoderForData:(NSData *)data {
+  for (id<NIImageDecoder> decoder in self.imageDecoders) {
+    if ([decoder canDecodeData:data]) {
+      return decoder;
+    }
+  }
+  return nil;
+}
+
+// Crops, resizes and styles a full size image for display.
+- (UIImage *)processedImageFromImage:(UIImage *)image {
+  image = [NIImageProcessing imageFromSource:image
+                             withContentMode:self.contentMode
+                                    cropRect:self.cropRect
+                                 displaySize:self.displaySize
+                                scaleOptions:self.scaleOptions
+                        interpolationQuality:self.interpolationQuality
+                            resamplingEngine:self.resamplingEngine];
+
+  // Images that were resized have already been drawn into a display-native bitmap. Anything
+  // else may still be lazily decoded, which would otherwise happen on the main thread.
+  // Styling draws the image too, so it decodes it along the way.
+  if (nil != self.style) {
+    image = [NIImageProcessing imageFromImage:image withStyle:self.style];
+
+  } else if (self.forcesImageDecoding
+             && !(self.displaySize.width > 0 && self.displaySize.height > 0)) {
+    image = [NIImageProcessing decodedImageFromImage:image];
+  }
+  return image;
+}
+
+// Frames are processed exactly like a still image would be.
+- (NIAnimatedImageFrameBlock)animatedImageFrameBlock {
+  UIViewContentMode contentMode = self.contentMode;
+  CGRect cropRect = self.cropRect;
+  CGSize displaySize = self.displaySize;
+  NINetworkImageViewScaleOptions scaleOptions = self.scaleOptions;
+  CGInterpolationQuality interpolationQuality = self.interpolationQuality;
+  NINetworkImageViewResamplingEngine resamplingEngine = self.resamplingEngine;
+  NIImageStyle* style = self.style;
+  return ^UIImage *(UIImage* frame) {
+    UIImage* processedFrame = [NIImageProcessing imageFromSource:frame
+                                                 withContentMode:contentMode
+                                                        cropRect:cropRect
+                                                     displaySize:displaySize
+                                                    scaleOptions:scaleOptions
+                                            interpolationQuality:interpolationQuality
+                                                resamplingEngine:resamplingEngine];
+    if (nil != style) {
+      processedFrame = [NIImageProcessing imageFromImage:processedFrame withStyle:style];
+    } else if (!(displaySize.width > 0 && displaySize.height > 0)) {
+      processedFrame = [NIImageProcessing decodedImageFromImage:processedFrame];
+    }
+    return processedFrame;
+  };
+}
+
 - (id)responseObjectForResponse:(NSURLResponse *)response
                            data:(NSData *)data
                           error:(NSError *__autoreleasing *)error {
-  id responseObject = [super responseObjectForResponse:response data:data error:error];
+  id responseObject = [self processedResponseObjectForResponse:response data:data error:error];
+
+  NIMemoryCache* placeholderMemoryCache = self.placeholderMemoryCache;
+  if (nil != placeholderMemoryCache && nil != self.placeholderName
+      && [responseObject isKindOfClass:[UIImage class]]) {
+    NIImagePlaceholder* placeholder = [NIImagePlaceholder placeholderWithImage:responseObject];
+    if (nil != placeholder) {
+      [placeholderMemoryCache storeObject:placeholder withName:self.placeholderName cost:[placeholder cost]];
+    }
+  }
+  return responseObject;
+}
+
+- (id)processedResponseObjectForResponse:(NSURLResponse *)response
+                                    data:(NSData *)data
+                                   error:(NSError *__autoreleasing *)error {
+  // Decoding straight to the display resolution avoids materializing the full bitmap. This
+  // only applies when the response is valid; errors are reported by the full decode path.
+  if ([self validateResponse:(NSHTTPURLResponse *)response data:data error:NULL]) {
+    if (self.decodesAnimatedImages) {
+      UIImage* animatedImage = [NIAnimatedImage animatedImageWithData:data frameBlock:[self animatedImageFrameBlock]];
+      if (nil != animatedImage) {
+        return animatedImage;
+      }
+    }
+
+    // Formats that UIImage can't decode must be decoded by one of the image decoders.
+    id<NIImageDecoder> decoder = [self decoderForData:data];
+    UIImage* downsampledImage = [NIImageProcessing imageFromData:data
+                                                     withDecoder:(nil != decoder) ? decoder : [NIImageIODecoder decoder]
+                                                     contentMode:self.contentMode
+                                                        cropRect:self.cropRect
+                                                     displaySize:self.displaySize
+                                                    scaleOptions:self.scaleOptions
+                                            interpolationQuality:self.interpolationQuality
+                                                resamplingEngine:self.resamplingEngine];
+    if (nil != downsampledImage) {
+      return [NIImageProcessing imageFromImage:downsampledImage withStyle:self.style];
+    }
+
+    if (nil != decoder) {
+      UIImage* image = [decoder imageWithData:data maxPixelSize:0];
+      if (nil == image) {
+        if (NULL != error) {
+          *error = [NSError errorWithDomain:AFURLResponseSerializationErrorDomain
+                                       code:NSURLErrorCannotDecodeContentData
+                                   userInfo:nil];
+        }
+        return nil;
+      }
+      return [self processedImageFromImage:image];
+    }
+  }
+
+  NSError* serializationError = nil;
+  id responseObject = [super responseObjectForResponse:response data:data error:&serializationError];
   if (nil != responseObject && [responseObject isKindOfClass:[UIImage class]]) {
-    responseObject = [NIImageProcessing imageFromSource:responseObject
-                                        withContentMode:self.contentMode
-                                               cropRect:self.cropRect
-                                            displaySize:self.displaySize
-                                           scaleOptions:self.scaleOptions
-                                   interpolationQuality:self.interpolationQuality];
+    responseObject = [self processedImageFromImage:responseObject];
+  } else if (nil == responseObject && nil == serializationError && data.length > 0) {
+    // A valid response whose body isn't an image is reported rather than passed on as nil.
+    serializationError = [NSError errorWithDomain:AFURLResponseSerializationErrorDomain
+                                             code:NSURLErrorCannotDecodeContentData
+                                         userInfo:nil];
+  }
+  if (NULL != error) {
+    *error = serializationError;
   }
   return responseObject;
 }
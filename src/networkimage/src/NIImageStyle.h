@@ -0,0 +1,98 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+/**
+ * Describes the corners, border and background to bake into a processed image.
+ *
+ * Setting layer.cornerRadius and masksToBounds on many image views makes Core Animation render
+ * each of them offscreen on every frame while they scroll. Drawing the same effect into the
+ * bitmap once, on the background queue that processes the image, leaves nothing to composite.
+ * When the style has an opaque background color the resulting image is opaque as well, so the
+ * image view can be marked opaque and is never blended with what lies beneath it.
+ *
+ * Styles are compared by value, so two image views with equal styles share their cached images.
+ *
+ * @ingroup NimbusNetworkImage
+ */
+@interface NIImageStyle : NSObject <NSCopying>
+
+@property (nonatomic, assign) CGFloat cornerRadius;     // Default: 0
+@property (nonatomic, assign) BOOL clipsToCircle;       // Default: NO
+@property (nonatomic, assign) CGFloat borderWidth;      // Default: 0
+@property (nonatomic, strong) UIColor* borderColor;     // Default: nil
+@property (nonatomic, strong) UIColor* backgroundColor; // Default: nil
+
+- (BOOL)isOpaque;
+- (NSString *)cacheName;
+
+@end
+
+/**
+ * The radius of the image's rounded corners.
+ *
+ * Ignored when clipsToCircle is YES.
+ *
+ * @fn NIImageStyle::cornerRadius
+ */
+
+/**
+ * Whether the image is clipped to the largest circle centered within it.
+ *
+ * @fn NIImageStyle::clipsToCircle
+ */
+
+/**
+ * The width of the border drawn just inside the edge of the clipped image.
+ *
+ * The border is only drawn when borderColor is set.
+ *
+ * @fn NIImageStyle::borderWidth
+ */
+
+/**
+ * The color of the border.
+ *
+ * @fn NIImageStyle::borderColor
+ */
+
+/**
+ * The color that fills the image behind its content, including the corners that are clipped
+ * away.
+ *
+ * Use the color of whatever the image view sits on so that the clipped corners blend in.
+ *
+ * @fn NIImageStyle::backgroundColor
+ */
+
+/**
+ * Returns whether images drawn with this style are opaque.
+ *
+ * This is the case when the background color is fully opaque.
+ *
+ * @fn NIImageStyle::isOpaque
+ */
+
+/**
+ * Returns a string that identifies this style in cache names.
+ *
+ * Equal styles have equal cache names.
+ *
+ * @fn NIImageStyle::cacheName
+ */
@@ -0,0 +1,86 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIImageStyle.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// Colors are compared by their RGBA components so that equal colors created in different ways
+// produce the same cache name.
+static NSString* NIStringFromColor(UIColor* color) {
+  if (nil == color) {
+    return @"-";
+  }
+  CGFloat red = 0, green = 0, blue = 0, alpha = 0;
+  if (![color getRed:&red green:&green blue:&blue alpha:&alpha]) {
+    CGFloat white = 0;
+    if ([color getWhite:&white alpha:&alpha]) {
+      red = green = blue = white;
+    }
+  }
+  return [NSString stringWithFormat:@"%02x%02x%02x%02x",
+          (unsigned int)(red * 255 + 0.5f), (unsigned int)(green * 255 + 0.5f),
+          (unsigned int)(blue * 255 + 0.5f), (unsigned int)(alpha * 255 + 0.5f)];
+}
+
+@implementation NIImageStyle
+
+- (id)copyWithZone:(NSZone *)zone {
+  NIImageStyle* style = [[[self class] allocWithZone:zone] init];
+  style.cornerRadius = self.cornerRadius;
+  style.clipsToCircle = self.clipsToCircle;
+  style.borderWidth = self.borderWidth;
+  style.borderColor = self.borderColor;
+  style.backgroundColor = self.backgroundColor;
+  return style;
+}
+
+- (BOOL)isOpaque {
+  if (nil == self.backgroundColor) {
+    return NO;
+  }
+  return (CGColorGetAlpha(self.backgroundColor.CGColor) >= 1);
+}
+
+- (NSString *)cacheName {
+  return [NSString stringWithFormat:@"{%@,%@,%@,%@,%@}",
+          [@(self.cornerRadius) stringValue], [@(self.clipsToCircle) stringValue],
+          [@(self.borderWidth) stringValue], NIStringFromColor(self.borderColor),
+          NIStringFromColor(self.backgroundColor)];
+}
+
+- (NSUInteger)hash {
+  return [[self cacheName] hash];
+}
+
+- (BOOL)isEqual:(id)object {
+  if (self == object) {
+    return YES;
+  }
+  if (![object isKindOfClass:[NIImageStyle class]]) {
+    return NO;
+  }
+  return [[self cacheName] isEqualToString:[object cacheName]];
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@ %@>", [super description], [self cacheName]];
+}
+
+@end
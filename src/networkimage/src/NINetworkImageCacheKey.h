@@ -0,0 +1,109 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+#import "NimbusCore.h"
+#import "NINetworkImageView.h"  // For NINetworkImageViewScaleOptions
+
+@class NIImageStyle;
+
+/**
+ * An immutable memory cache key for an image that has been cropped and resized for display.
+ *
+ * NINetworkImageView looks its images up several times per request. Hashing and comparing this
+ * key only touches its fields, so the cache name is only formatted the first time the memory
+ * cache sees a given key. The name matches the one that NINetworkImageView has always used, so
+ * images stored by name can be found by key and vice versa.
+ *
+ * @ingroup NimbusNetworkImage
+ */
+@interface NINetworkImageCacheKey : NSObject <NIMemoryCacheKey>
+
+// Designated initializer.
+- (id)initWithCacheIdentifier:(NSString *)cacheIdentifier
+                  displaySize:(CGSize)displaySize
+                     cropRect:(CGRect)cropRect
+                  contentMode:(UIViewContentMode)contentMode
+                 scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions
+               sizeForDisplay:(BOOL)sizeForDisplay
+                        style:(NIImageStyle *)style
+          processorIdentifier:(NSString *)processorIdentifier;
+- (id)initWithCacheIdentifier:(NSString *)cacheIdentifier
+                  displaySize:(CGSize)displaySize
+                     cropRect:(CGRect)cropRect
+                  contentMode:(UIViewContentMode)contentMode
+                 scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions
+               sizeForDisplay:(BOOL)sizeForDisplay
+                        style:(NIImageStyle *)style;
+- (id)initWithCacheIdentifier:(NSString *)cacheIdentifier
+                  displaySize:(CGSize)displaySize
+                     cropRect:(CGRect)cropRect
+                  contentMode:(UIViewContentMode)contentMode
+                 scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions
+               sizeForDisplay:(BOOL)sizeForDisplay;
+
+@property (nonatomic, readonly, copy) NSString* cacheIdentifier;
+@property (nonatomic, readonly) CGSize displaySize;
+@property (nonatomic, readonly) CGRect cropRect;
+@property (nonatomic, readonly) UIViewContentMode contentMode;
+@property (nonatomic, readonly) NINetworkImageViewScaleOptions scaleOptions;
+@property (nonatomic, readonly) BOOL sizeForDisplay;
+@property (nonatomic, readonly, copy) NIImageStyle* style;
+@property (nonatomic, readonly, copy) NSString* processorIdentifier;
+
+@property (nonatomic, readonly, copy) NSString* variantGroupName;
+
+@end
+
+/**
+ * Initializes a newly allocated key.
+ *
+ * When sizeForDisplay is NO, the display properties don't affect the image, so they are
+ * ignored when comparing keys and left out of the name.
+ *
+ * A style is baked into the image no matter whether it was sized for display, so it is always
+ * part of the key, as is the processor identifier. Keys without either have the same names they
+ * always had.
+ *
+ * @see NIImagePipeline::identifierForProcessors:
+ * @fn NINetworkImageCacheKey::initWithCacheIdentifier:displaySize:cropRect:contentMode:scaleOptions:sizeForDisplay:style:processorIdentifier:
+ */
+
+/**
+ * Initializes a newly allocated key for an image that wasn't run through any processors.
+ *
+ * @fn NINetworkImageCacheKey::initWithCacheIdentifier:displaySize:cropRect:contentMode:scaleOptions:sizeForDisplay:style:
+ */
+
+/**
+ * Initializes a newly allocated key for an image without a style.
+ *
+ * @fn NINetworkImageCacheKey::initWithCacheIdentifier:displaySize:cropRect:contentMode:scaleOptions:sizeForDisplay:
+ */
+
+/**
+ * The name shared by the keys of this image at every display size, or nil.
+ *
+ * Images that were only resized for display can be scaled down from a larger cached size
+ * instead of being processed again. Keys that crop, style or process the image, or whose content
+ * mode doesn't scale it, have no variant group because their images don't scale that way.
+ *
+ * @see NIImageMemoryCache::nameOfSmallestVariantInGroup:coveringSize:
+ * @fn NINetworkImageCacheKey::variantGroupName
+ */
@@ -0,0 +1,193 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NINetworkImageCacheKey.h"
+
+#import "NIImageStyle.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+static inline NSUInteger NIHashCombine(NSUInteger hash, NSUInteger value) {
+  return hash * 31 + value;
+}
+
+static inline NSUInteger NIHashFloat(CGFloat value) {
+  return (NSUInteger)(NSInteger)(value * 1000);
+}
+
+@implementation NINetworkImageCacheKey {
+  NSUInteger _hash;
+}
+
+- (id)initWithCacheIdentifier:(NSString *)cacheIdentifier
+                  displaySize:(CGSize)displaySize
+                     cropRect:(CGRect)cropRect
+                  contentMode:(UIViewContentMode)contentMode
+                 scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions
+               sizeForDisplay:(BOOL)sizeForDisplay
+                        style:(NIImageStyle *)style
+          processorIdentifier:(NSString *)processorIdentifier {
+  NIDASSERT(NIIsStringWithAnyText(cacheIdentifier));
+  if ((self = [super init])) {
+    _cacheIdentifier = [cacheIdentifier copy];
+    _sizeForDisplay = sizeForDisplay;
+    _style = [style copy];
+    _processorIdentifier = [processorIdentifier copy];
+    if (sizeForDisplay) {
+      _displaySize = displaySize;
+      _cropRect = cropRect;
+      _contentMode = contentMode;
+      _scaleOptions = scaleOptions;
+    }
+
+    NSUInteger hash = [_cacheIdentifier hash];
+    if (sizeForDisplay) {
+      hash = NIHashCombine(hash, NIHashFloat(_displaySize.width));
+      hash = NIHashCombine(hash, NIHashFloat(_displaySize.height));
+      hash = NIHashCombine(hash, NIHashFloat(_cropRect.origin.x));
+      hash = NIHashCombine(hash, NIHashFloat(_cropRect.origin.y));
+      hash = NIHashCombine(hash, NIHashFloat(_cropRect.size.width));
+      hash = NIHashCombine(hash, NIHashFloat(_cropRect.size.height));
+      hash = NIHashCombine(hash, (NSUInteger)_contentMode);
+      hash = NIHashCombine(hash, (NSUInteger)_scaleOptions);
+    }
+    if (nil != _style) {
+      hash = NIHashCombine(hash, [_style hash]);
+    }
+    if (nil != _processorIdentifier) {
+      hash = NIHashCombine(hash, [_processorIdentifier hash]);
+    }
+    _hash = hash;
+  }
+  return self;
+}
+
+- (id)initWithCacheIdentifier:(NSString *)cacheIdentifier
+                  displaySize:(CGSize)displaySize
+                     cropRect:(CGRect)cropRect
+                  contentMode:(UIViewContentMode)contentMode
+                 scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions
+               sizeForDisplay:(BOOL)sizeForDisplay
+                        style:(NIImageStyle *)style {
+  return [self initWithCacheIdentifier:cacheIdentifier
+                           displaySize:displaySize
+                              cropRect:cropRect
+                           contentMode:contentMode
+                          scaleOptions:scaleOptions
+                        sizeForDisplay:sizeForDisplay
+                                 style:style
+                   processorIdentifier:nil];
+}
+
+- (id)initWithCacheIdentifier:(NSString *)cacheIdentifier
+                  displaySize:(CGSize)displaySize
+                     cropRect:(CGRect)cropRect
+                  contentMode:(UIViewContentMode)contentMode
+                 scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions
+               sizeForDisplay:(BOOL)sizeForDisplay {
+  return [self initWithCacheIdentifier:cacheIdentifier
+                           displaySize:displaySize
+                              cropRect:cropRect
+                           contentMode:contentMode
+                          scaleOptions:scaleOptions
+                        sizeForDisplay:sizeForDisplay
+                                 style:nil
+                   processorIdentifier:nil];
+}
+
+- (id)init {
+  return [self initWithCacheIdentifier:nil
+                           displaySize:CGSizeZero
+                              cropRect:CGRectZero
+                           contentMode:UIViewContentModeScaleToFill
+                          scaleOptions:NINetworkImageViewScaleToFitLeavesExcessAndScaleToFillCropsExcess
+                        sizeForDisplay:NO
+                                 style:nil
+                   processorIdentifier:nil];
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+  // Keys are immutable.
+  return self;
+}
+
+- (NSUInteger)hash {
+  return _hash;
+}
+
+- (BOOL)isEqual:(id)object {
+  if (self == object) {
+    return YES;
+  }
+  if (![object isKindOfClass:[NINetworkImageCacheKey class]]) {
+    return NO;
+  }
+  NINetworkImageCacheKey* key = object;
+  return (_hash == key->_hash
+          && _sizeForDisplay == key->_sizeForDisplay
+          && _contentMode == key->_contentMode
+          && _scaleOptions == key->_scaleOptions
+          && CGSizeEqualToSize(_displaySize, key->_displaySize)
+          && CGRectEqualToRect(_cropRect, key->_cropRect)
+          && (_style == key->_style || [_style isEqual:key->_style])
+          && (_processorIdentifier == key->_processorIdentifier
+              || [_processorIdentifier isEqualToString:key->_processorIdentifier])
+          && [_cacheIdentifier isEqualToString:key->_cacheIdentifier]);
+}
+
+- (NSString *)memoryCacheName {
+  // Append the size to the key. This allows us to differentiate cache keys by image dimension.
+  // If the display size ever changes, we want to ensure that we're fetching the correct image
+  // from the cache.
+  NSString* name = _cacheIdentifier;
+  if (_sizeForDisplay) {
+    // The resulting cache key will look like:
+    // /path/to/image({width,height}{contentMode,cropImageForDisplay})
+    name = [name stringByAppendingFormat:@"%@%@{%@,%@}",
+            NSStringFromCGSize(_displaySize), NSStringFromCGRect(_cropRect),
+            [@(_contentMode) stringValue], [@(_scaleOptions) stringValue]];
+  }
+  if (nil != _style) {
+    name = [name stringByAppendingString:[_style cacheName]];
+  }
+  if (nil != _processorIdentifier) {
+    name = [name stringByAppendingFormat:@"<%@>", _processorIdentifier];
+  }
+  return name;
+}
+
+- (NSString *)variantGroupName {
+  if (!_sizeForDisplay || nil != _style || nil != _processorIdentifier
+      || !CGRectIsEmpty(_cropRect)) {
+    return nil;
+  }
+  if (UIViewContentModeScaleToFill != _contentMode
+      && UIViewContentModeScaleAspectFit != _contentMode
+      && UIViewContentModeScaleAspectFill != _contentMode) {
+    return nil;
+  }
+  return [_cacheIdentifier stringByAppendingFormat:@"{%@,%@}",
+          [@(_contentMode) stringValue], [@(_scaleOptions) stringValue]];
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@ %@>", [super description], [self memoryCacheName]];
+}
+
+@end
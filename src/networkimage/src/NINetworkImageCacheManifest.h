@@ -0,0 +1,174 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+#import "NimbusCore.h"
+
+/**
+ * Remembers which images were in use when the app went to the background, and loads them back
+ * into memory from the disk tier at the next launch.
+ *
+ * The memory cache starts empty at every launch, so without a manifest the first screen fills
+ * in one image at a time even when every image is on disk. Call startRecording once at launch,
+ * after replayWithCompletion:, and the manifest is rewritten each time the app enters the
+ * background.
+ *
+ * Only images that the image views stored in the processedImageDiskCache can be replayed,
+ * which leaves out animated images and images that expire.
+ *
+ * Must only be used from the main thread.
+ *
+ * @ingroup NimbusNetworkImage
+ */
+@interface NINetworkImageCacheManifest : NSObject
+
++ (instancetype)sharedManifest;
+
+// Designated initializer.
+- (id)initWithPath:(NSString *)path;
+
+@property (nonatomic, readonly, copy) NSString* path;
+
+@property (nonatomic, strong) NIImageMemoryCache* imageMemoryCache;   // Default: [Nimbus imageMemoryCache]
+@property (nonatomic, strong) NIDiskCache* processedImageDiskCache;   // Default: [Nimbus processedImageDiskCache]
+@property (nonatomic, assign) NSUInteger maxNumberOfNames;            // Default: 100
+@property (nonatomic, assign) NSTimeInterval replayTimeLimit;         // Default: 1
+@property (nonatomic, assign) unsigned long long replayByteLimit;     // Default: 8MB
+
+#pragma mark Recording
+
+- (void)startRecording;
+- (void)stopRecording;
+- (BOOL)isRecording;
+- (BOOL)writeManifest;
+
+#pragma mark Replaying
+
+- (NSArray *)namesInManifest;
+- (void)replayWithCompletion:(void (^)(NSUInteger numberOfImagesLoaded))completion;
+
+@end
+
+/**
+ * Returns the manifest that is kept in the caches directory.
+ *
+ * @fn NINetworkImageCacheManifest::sharedManifest
+ */
+
+/**
+ * Initializes a manifest that is kept in the file at the given path.
+ *
+ * @fn NINetworkImageCacheManifest::initWithPath:
+ */
+
+/**
+ * The file that the manifest is kept in.
+ *
+ * @fn NINetworkImageCacheManifest::path
+ */
+
+/** @name Configuring a Manifest */
+
+/**
+ * The memory cache whose names are recorded and that replayed images are stored in.
+ *
+ * This must be the cache that the image views use.
+ *
+ * @fn NINetworkImageCacheManifest::imageMemoryCache
+ */
+
+/**
+ * The disk cache that replayed images are read from.
+ *
+ * This must be the cache that the image views use.
+ *
+ * @fn NINetworkImageCacheManifest::processedImageDiskCache
+ */
+
+/**
+ * The most names that are recorded in the manifest.
+ *
+ * @fn NINetworkImageCacheManifest::maxNumberOfNames
+ */
+
+/**
+ * How long a replay may spend loading images before it stops.
+ *
+ * @fn NINetworkImageCacheManifest::replayTimeLimit
+ */
+
+/**
+ * How many bytes of image data a replay may read from disk before it stops.
+ *
+ * @fn NINetworkImageCacheManifest::replayByteLimit
+ */
+
+/** @name Recording */
+
+/**
+ * Writes the manifest each time the app enters the background.
+ *
+ * @fn NINetworkImageCacheManifest::startRecording
+ */
+
+/**
+ * Stops writing the manifest when the app enters the background.
+ *
+ * @fn NINetworkImageCacheManifest::stopRecording
+ */
+
+/**
+ * Whether the manifest is written each time the app enters the background.
+ *
+ * @fn NINetworkImageCacheManifest::isRecording
+ */
+
+/**
+ * Writes the names of the images in the memory cache that are most likely to be used first.
+ *
+ * Twice maxNumberOfNames of the most recently used names are considered. When the memory
+ * cache's admission policy can estimate how often each name is used, as NITinyLFUAdmissionPolicy
+ * can, the least frequently used of those are dropped. The names that are kept are written
+ * most recently used first, which is the order that they are replayed in.
+ *
+ * @returns YES if the manifest was written.
+ * @fn NINetworkImageCacheManifest::writeManifest
+ */
+
+/** @name Replaying */
+
+/**
+ * Returns the names in the manifest, in the order that they will be replayed.
+ *
+ * @fn NINetworkImageCacheManifest::namesInManifest
+ */
+
+/**
+ * Loads the images in the manifest from the disk cache into the memory cache.
+ *
+ * The replay begins after the current pass of the main run loop, so calling this from
+ * application:didFinishLaunchingWithOptions: does not hold up the first frame. Images are read
+ * and decoded on a background queue at a low priority. Images that are already in the memory
+ * cache are skipped, and the replay stops once either replayTimeLimit or replayByteLimit has
+ * been used up.
+ *
+ * @param completion Called on the main thread with the number of images that were loaded.
+ *                   May be nil.
+ * @fn NINetworkImageCacheManifest::replayWithCompletion:
+ */
@@ -0,0 +1,225 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NINetworkImageCacheManifest.h"
+
+#import "NIImageProcessing.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+static NSString* const kManifestNamesKey = @"names";
+
+@interface NINetworkImageCacheManifest ()
+@property (nonatomic, copy) NSString* path;
+@property (nonatomic, assign, getter=isRecording) BOOL recording;
+@end
+
+@implementation NINetworkImageCacheManifest
+
+- (void)dealloc {
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
++ (instancetype)sharedManifest {
+  static NINetworkImageCacheManifest* sharedManifest = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sharedManifest = [[self alloc] initWithPath:
+                      NIPathForCachesResource(@"NimbusImageCacheManifest.plist")];
+  });
+  return sharedManifest;
+}
+
+- (id)initWithPath:(NSString *)path {
+  if ((self = [super init])) {
+    _path = [path copy];
+    _imageMemoryCache = [Nimbus imageMemoryCache];
+    _processedImageDiskCache = [Nimbus processedImageDiskCache];
+    _maxNumberOfNames = 100;
+    _replayTimeLimit = 1;
+    _replayByteLimit = 8 * 1024 * 1024;
+  }
+  return self;
+}
+
+- (id)init {
+  return [self initWithPath:NIPathForCachesResource(@"NimbusImageCacheManifest.plist")];
+}
+
+#pragma mark - Recording
+
+- (void)startRecording {
+  if (self.isRecording) {
+    return;
+  }
+  self.recording = YES;
+  [[NSNotificationCenter defaultCenter] addObserver:self
+                                           selector:@selector(didEnterBackground:)
+                                               name:UIApplicationDidEnterBackgroundNotification
+                                             object:nil];
+}
+
+- (void)stopRecording {
+  if (!self.isRecording) {
+    return;
+  }
+  self.recording = NO;
+  [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                  name:UIApplicationDidEnterBackgroundNotification
+                                                object:nil];
+}
+
+- (void)didEnterBackground:(NSNotification *)notification {
+  [self writeManifest];
+}
+
+- (NSArray *)namesToRecord {
+  NIImageMemoryCache* memoryCache = self.imageMemoryCache;
+  NSUInteger maxNumberOfNames = self.maxNumberOfNames;
+  NSArray* names = [memoryCache namesOfMostRecentlyUsedObjectsWithLimit:maxNumberOfNames * 2];
+  if (names.count <= maxNumberOfNames) {
+    return names;
+  }
+
+  // Without frequencies the most recently used names are the best guess.
+  id<NIMemoryCacheAdmissionPolicy> policy = memoryCache.admissionPolicy;
+  if (![policy isKindOfClass:[NITinyLFUAdmissionPolicy class]]) {
+    return [names subarrayWithRange:NSMakeRange(0, maxNumberOfNames)];
+  }
+
+  // Names that were only on screen for a moment are recent but not worth replaying, so keep
+  // the most frequently used names and then put them back in order of recency.
+  NITinyLFUAdmissionPolicy* tinyLFU = (NITinyLFUAdmissionPolicy *)policy;
+  NSMutableArray* indices = [NSMutableArray arrayWithCapacity:names.count];
+  NSMutableArray* frequencies = [NSMutableArray arrayWithCapacity:names.count];
+  for (NSUInteger ix = 0; ix < names.count; ++ix) {
+    [indices addObject:@(ix)];
+    [frequencies addObject:@([tinyLFU estimatedFrequencyOfName:names[ix]])];
+  }
+  [indices sortUsingComparator:^NSComparisonResult(NSNumber* index1, NSNumber* index2) {
+    NSComparisonResult result = [frequencies[index2.unsignedIntegerValue]
+                                 compare:frequencies[index1.unsignedIntegerValue]];
+    return (NSOrderedSame != result) ? result : [index1 compare:index2];
+  }];
+  NSArray* keptIndices = [[indices subarrayWithRange:NSMakeRange(0, maxNumberOfNames)]
+                          sortedArrayUsingSelector:@selector(compare:)];
+
+  NSMutableArray* keptNames = [NSMutableArray arrayWithCapacity:maxNumberOfNames];
+  for (NSNumber* index in keptIndices) {
+    [keptNames addObject:names[index.unsignedIntegerValue]];
+  }
+  return keptNames;
+}
+
+- (BOOL)writeManifest {
+  if (nil == self.imageMemoryCache || nil == self.path) {
+    return NO;
+  }
+
+  NSDictionary* manifest = @{kManifestNamesKey: [self namesToRecord]};
+  NSError* error = nil;
+  NSData* data = [NSPropertyListSerialization dataWithPropertyList:manifest
+                                                            format:NSPropertyListBinaryFormat_v1_0
+                                                           options:0
+                                                             error:&error];
+  if (nil == data) {
+    NIDERROR(@"Failed to serialize the image cache manifest: %@", error);
+    return NO;
+  }
+  return [data writeToFile:self.path options:NSDataWritingAtomic error:NULL];
+}
+
+#pragma mark - Replaying
+
+- (NSArray *)namesInManifest {
+  NSData* data = [NSData dataWithContentsOfFile:self.path];
+  if (nil == data) {
+    return @[];
+  }
+  NSDictionary* manifest = [NSPropertyListSerialization propertyListWithData:data
+                                                                     options:NSPropertyListImmutable
+                                                                      format:NULL
+                                                                       error:NULL];
+  NSArray* names = [manifest isKindOfClass:[NSDictionary class]] ? manifest[kManifestNamesKey] : nil;
+  if (![names isKindOfClass:[NSArray class]]) {
+    return @[];
+  }
+  NSMutableArray* validNames = [NSMutableArray arrayWithCapacity:names.count];
+  for (id name in names) {
+    if ([name isKindOfClass:[NSString class]]) {
+      [validNames addObject:name];
+    }
+  }
+  return validNames;
+}
+
+- (void)replayWithCompletion:(void (^)(NSUInteger numberOfImagesLoaded))completion {
+  NIImageMemoryCache* memoryCache = self.imageMemoryCache;
+  NIDiskCache* diskCache = self.processedImageDiskCache;
+  NSString* path = self.path;
+  NSTimeInterval timeLimit = self.replayTimeLimit;
+  unsigned long long byteLimit = self.replayByteLimit;
+
+  void (^finish)(NSUInteger) = ^(NSUInteger numberOfImagesLoaded) {
+    if (nil != completion) {
+      dispatch_async(dispatch_get_main_queue(), ^{
+        completion(numberOfImagesLoaded);
+      });
+    }
+  };
+  if (nil == memoryCache || nil == diskCache) {
+    finish(0);
+    return;
+  }
+
+  // Wait for the current pass of the run loop so that the first frame is committed first.
+  dispatch_async(dispatch_get_main_queue(), ^{
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+      NINetworkImageCacheManifest* reader = [[NINetworkImageCacheManifest alloc] initWithPath:path];
+      NSArray* names = [reader namesInManifest];
+
+      CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+      unsigned long long numberOfBytesRead = 0;
+      NSUInteger numberOfImagesLoaded = 0;
+      for (NSString* name in names) {
+        if (CFAbsoluteTimeGetCurrent() - startTime >= timeLimit || numberOfBytesRead >= byteLimit) {
+          break;
+        }
+        if ([memoryCache containsObjectWithName:name]) {
+          continue;
+        }
+        NSData* data = [diskCache dataWithName:name];
+        if (nil == data) {
+          continue;
+        }
+        numberOfBytesRead += data.length;
+
+        UIImage* image = [NIImageProcessing imageFromMappableData:data];
+        // An image view may have loaded the image while it was being decoded.
+        if (nil != image && ![memoryCache containsObjectWithName:name]) {
+          [memoryCache storeObject:image withName:name];
+          ++numberOfImagesLoaded;
+        }
+      }
+      finish(numberOfImagesLoaded);
+    });
+  });
+}
+
+@end
@@ -0,0 +1,208 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+#import "NimbusCore.h"
+#import "NINetworkImageView.h"
+
+@class NINetworkImagePrefetcher;
+
+/**
+ * The direction a list is being scrolled in, which decides which rows are prefetched.
+ *
+ * @ingroup NimbusNetworkImage
+ */
+typedef enum {
+  NINetworkImagePrefetchDirectionForward,
+  NINetworkImagePrefetchDirectionBackward,
+} NINetworkImagePrefetchDirection;
+
+/**
+ * Implemented by model objects whose cells show network images.
+ *
+ * @ingroup NimbusNetworkImage
+ */
+@protocol NINetworkImagePrefetching <NSObject>
+@required
+
+/**
+ * Asks the object to prefetch the images its cell will show.
+ *
+ * Implementations call NINetworkImagePrefetcher::prefetchImageWithPath:displaySize:contentMode:
+ * with the same path, display size and content mode that the cell will use.
+ */
+- (void)prefetchNetworkImagesWithPrefetcher:(NINetworkImagePrefetcher *)prefetcher;
+
+@end
+
+/**
+ * Downloads and sizes network images into the memory cache before they are shown.
+ *
+ * Each prefetch is made the same way an NINetworkImageView would make it, at a low queue
+ * priority. An image view that asks for the same image while it is being prefetched joins the
+ * prefetch's request rather than starting another one, and raises it to its own priority.
+ *
+ * Prefetchers are usually driven from scrollViewDidScroll: with
+ * prefetchImagesAfterVisibleRowsOfTableView: or prefetchImagesAfterVisibleItemsOfCollectionView:.
+ * The table or collection view's data source must respond to objectAtIndexPath:, as
+ * NITableViewModel and NICollectionViewModel do, and its objects must conform to
+ * NINetworkImagePrefetching.
+ *
+ * Must only be used from the main thread.
+ *
+ * @ingroup NimbusNetworkImage
+ */
+@interface NINetworkImagePrefetcher : NSObject
+
+@property (nonatomic, strong) NIImageMemoryCache* imageMemoryCache;    // Default: [Nimbus imageMemoryCache]
+@property (nonatomic, strong) NSOperationQueue* networkOperationQueue; // Default: [Nimbus networkOperationQueue]
+@property (nonatomic, assign) NINetworkImageTransport transport;       // Default: NINetworkImageTransportOperation
+@property (nonatomic, copy) NINetworkImagePathVariantBlock pathVariantBlock; // Default: nil
+
+@property (nonatomic, assign) NSUInteger numberOfObjectsToPrefetch;    // Default: 10
+@property (nonatomic, assign) NSUInteger maxNumberOfPrefetches;        // Default: 20
+
+#pragma mark Prefetching Images
+
+- (void)prefetchImageWithPath:(NSString *)path displaySize:(CGSize)displaySize contentMode:(UIViewContentMode)contentMode;
+- (void)cancelPrefetchingImageWithPath:(NSString *)path displaySize:(CGSize)displaySize contentMode:(UIViewContentMode)contentMode;
+- (void)cancelAllPrefetches;
+- (NSUInteger)numberOfPrefetches;
+
+#pragma mark Prefetching Model Objects
+
+- (void)prefetchImagesForIndexPaths:(NSArray *)indexPaths model:(id)model direction:(NINetworkImagePrefetchDirection)direction;
+- (void)prefetchImagesAfterVisibleRowsOfTableView:(UITableView *)tableView;
+- (void)prefetchImagesAfterVisibleItemsOfCollectionView:(UICollectionView *)collectionView;
+
+@end
+
+/** @name Configuring a Prefetcher */
+
+/**
+ * The memory cache that prefetched images are stored in.
+ *
+ * This must be the cache that the image views use, or the prefetched images will never be
+ * found.
+ *
+ * @fn NINetworkImagePrefetcher::imageMemoryCache
+ */
+
+/**
+ * The queue that prefetch requests are added to.
+ *
+ * @fn NINetworkImagePrefetcher::networkOperationQueue
+ */
+
+/**
+ * How prefetch requests reach the network.
+ *
+ * Use NINetworkImageTransportBackgroundSession to let prefetches finish while the app is
+ * suspended. Forward the app delegate's
+ * application:handleEventsForBackgroundURLSession:completionHandler: to
+ * NINetworkImageSession::handleEventsForBackgroundURLSession:completionHandler: so that the
+ * system learns when those transfers have been handled.
+ *
+ * @see NINetworkImageView::transport
+ * @fn NINetworkImagePrefetcher::transport
+ */
+
+/**
+ * Picks which of the server's renditions of each image to prefetch.
+ *
+ * This must be the block that the image views use, or the prefetched renditions will never be
+ * found.
+ *
+ * @see NINetworkImageView::pathVariantBlock
+ * @fn NINetworkImagePrefetcher::pathVariantBlock
+ */
+
+/**
+ * How many rows past the visible rows are prefetched by the table and collection view methods.
+ *
+ * Both this and maxNumberOfPrefetches are scaled by Nimbus::adaptivePrefetchDepthScale, so
+ * fewer images are prefetched on slow connections and when the device is hot or in Low Power
+ * Mode.
+ *
+ * @fn NINetworkImagePrefetcher::numberOfObjectsToPrefetch
+ */
+
+/**
+ * The most prefetches that may be in flight at once. Further prefetches are ignored until some
+ * of them finish.
+ *
+ * @fn NINetworkImagePrefetcher::maxNumberOfPrefetches
+ */
+
+/** @name Prefetching Images */
+
+/**
+ * Starts loading the image into the memory cache unless it is already cached or being
+ * prefetched.
+ *
+ * @fn NINetworkImagePrefetcher::prefetchImageWithPath:displaySize:contentMode:
+ */
+
+/**
+ * Stops prefetching the image.
+ *
+ * The request is only cancelled if no image view has joined it.
+ *
+ * @fn NINetworkImagePrefetcher::cancelPrefetchingImageWithPath:displaySize:contentMode:
+ */
+
+/**
+ * Stops every prefetch.
+ *
+ * @fn NINetworkImagePrefetcher::cancelAllPrefetches
+ */
+
+/**
+ * Returns the number of prefetches that are in flight.
+ *
+ * @fn NINetworkImagePrefetcher::numberOfPrefetches
+ */
+
+/** @name Prefetching Model Objects */
+
+/**
+ * Prefetches the images of the model's objects at the given index paths.
+ *
+ * If the direction differs from the direction of the previous call, every prefetch still in
+ * flight is cancelled first since the rows it was for are no longer coming up.
+ *
+ * @param indexPaths The index paths of the objects, nearest to the visible rows first.
+ * @param model An object that responds to objectAtIndexPath:.
+ * @param direction The direction the list is being scrolled in.
+ * @fn NINetworkImagePrefetcher::prefetchImagesForIndexPaths:model:direction:
+ */
+
+/**
+ * Prefetches the images of the rows just past the visible rows, in the direction the table view
+ * has scrolled since the last call.
+ *
+ * @fn NINetworkImagePrefetcher::prefetchImagesAfterVisibleRowsOfTableView:
+ */
+
+/**
+ * Prefetches the images of the items just past the visible items, in the direction the
+ * collection view has scrolled since the last call.
+ *
+ * @fn NINetworkImagePrefetcher::prefetchImagesAfterVisibleItemsOfCollectionView:
+ */
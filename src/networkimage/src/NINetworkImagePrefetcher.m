@@ -0,0 +1,230 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NINetworkImagePrefetcher.h"
+
+#import "NINetworkImageView.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+@interface NINetworkImagePrefetcher () <NINetworkImageViewDelegate>
+// Each prefetch is an image view that is never displayed, so that prefetches share requests
+// with the image views that show the same images.
+@property (nonatomic, strong) NSMutableDictionary* keyToImageView;
+@property (nonatomic, assign) NINetworkImagePrefetchDirection lastDirection;
+@property (nonatomic, assign) CGPoint lastContentOffset;
+@end
+
+@implementation NINetworkImagePrefetcher
+
+- (void)dealloc {
+  [self cancelAllPrefetches];
+}
+
+- (id)init {
+  if ((self = [super init])) {
+    _keyToImageView = [[NSMutableDictionary alloc] init];
+    _imageMemoryCache = [Nimbus imageMemoryCache];
+    _networkOperationQueue = [Nimbus networkOperationQueue];
+    _transport = NINetworkImageTransportOperation;
+    _numberOfObjectsToPrefetch = 10;
+    _maxNumberOfPrefetches = 20;
+    _lastDirection = NINetworkImagePrefetchDirectionForward;
+  }
+  return self;
+}
+
+#pragma mark - Private
+
+- (NSString *)keyForPath:(NSString *)path displaySize:(CGSize)displaySize contentMode:(UIViewContentMode)contentMode {
+  return [path stringByAppendingFormat:@"%@{%@}", NSStringFromCGSize(displaySize), [@(contentMode) stringValue]];
+}
+
+- (void)removeImageView:(NINetworkImageView *)imageView {
+  NSArray* keys = [self.keyToImageView allKeysForObject:imageView];
+  [self.keyToImageView removeObjectsForKeys:keys];
+}
+
+// Returns up to count index paths that follow edge in the given direction, crossing sections.
++ (NSArray *)indexPathsFollowingIndexPath:(NSIndexPath *)edge
+                                direction:(NINetworkImagePrefetchDirection)direction
+                                    count:(NSUInteger)count
+                         numberOfSections:(NSInteger)numberOfSections
+                    numberOfItemsInSection:(NSInteger (^)(NSInteger section))numberOfItemsInSection {
+  NSMutableArray* indexPaths = [NSMutableArray arrayWithCapacity:count];
+  NSInteger section = edge.section;
+  NSInteger item = edge.item;
+  while (indexPaths.count < count) {
+    if (NINetworkImagePrefetchDirectionForward == direction) {
+      ++item;
+      while (section < numberOfSections && item >= numberOfItemsInSection(section)) {
+        ++section;
+        item = 0;
+      }
+      if (section >= numberOfSections) {
+        break;
+      }
+    } else {
+      --item;
+      while (section >= 0 && item < 0) {
+        --section;
+        item = (section >= 0) ? numberOfItemsInSection(section) - 1 : -1;
+      }
+      if (section < 0) {
+        break;
+      }
+    }
+    [indexPaths addObject:[NSIndexPath indexPathForItem:item inSection:section]];
+  }
+  return indexPaths;
+}
+
+// Works out which way the scroll view has moved since the last call along its scrolling axis.
+- (NINetworkImagePrefetchDirection)directionOfScrollView:(UIScrollView *)scrollView {
+  CGPoint offset = scrollView.contentOffset;
+  BOOL scrollsHorizontally = (scrollView.contentSize.width > scrollView.bounds.size.width
+                              && scrollView.contentSize.height <= scrollView.bounds.size.height);
+  CGFloat delta = scrollsHorizontally ? offset.x - self.lastContentOffset.x : offset.y - self.lastContentOffset.y;
+  self.lastContentOffset = offset;
+  if (delta > 0) {
+    return NINetworkImagePrefetchDirectionForward;
+  } else if (delta < 0) {
+    return NINetworkImagePrefetchDirectionBackward;
+  }
+  return self.lastDirection;
+}
+
+// Prefetching less deeply on slow or metered connections and on a hot or low-power device
+// leaves the bandwidth to the images that are on screen.
+- (NSUInteger)adaptiveNumberOfObjectsToPrefetch {
+  return (NSUInteger)floor(self.numberOfObjectsToPrefetch * [Nimbus adaptivePrefetchDepthScale]);
+}
+
+- (NSUInteger)adaptiveMaxNumberOfPrefetches {
+  return (NSUInteger)floor(self.maxNumberOfPrefetches * [Nimbus adaptivePrefetchDepthScale]);
+}
+
+#pragma mark - Public
+
+- (void)prefetchImageWithPath:(NSString *)path displaySize:(CGSize)displaySize contentMode:(UIViewContentMode)contentMode {
+  NIDASSERT([NSThread isMainThread]);
+  if (!NIIsStringWithAnyText(path) || self.keyToImageView.count >= [self adaptiveMaxNumberOfPrefetches]) {
+    return;
+  }
+  NSString* key = [self keyForPath:path displaySize:displaySize contentMode:contentMode];
+  if (nil != [self.keyToImageView objectForKey:key]) {
+    return;
+  }
+
+  NINetworkImageView* imageView = [[NINetworkImageView alloc] initWithFrame:CGRectMake(0, 0, displaySize.width, displaySize.height)];
+  imageView.imageMemoryCache = self.imageMemoryCache;
+  imageView.networkOperationQueue = self.networkOperationQueue;
+  imageView.transport = self.transport;
+  imageView.pathVariantBlock = self.pathVariantBlock;
+  imageView.networkOperationPriority = NSOperationQueuePriorityLow;
+  imageView.delegate = self;
+
+  // Images that are already cached finish synchronously, which removes the view again.
+  [self.keyToImageView setObject:imageView forKey:key];
+  [imageView setPathToNetworkImage:path forDisplaySize:displaySize contentMode:contentMode];
+}
+
+- (void)cancelPrefetchingImageWithPath:(NSString *)path displaySize:(CGSize)displaySize contentMode:(UIViewContentMode)contentMode {
+  NSString* key = [self keyForPath:path displaySize:displaySize contentMode:contentMode];
+  NINetworkImageView* imageView = [self.keyToImageView objectForKey:key];
+  [self.keyToImageView removeObjectForKey:key];
+  imageView.delegate = nil;
+  [imageView prepareForReuse];
+}
+
+- (void)cancelAllPrefetches {
+  NSArray* imageViews = [self.keyToImageView allValues];
+  [self.keyToImageView removeAllObjects];
+  for (NINetworkImageView* imageView in imageViews) {
+    imageView.delegate = nil;
+    [imageView prepareForReuse];
+  }
+}
+
+- (NSUInteger)numberOfPrefetches {
+  return self.keyToImageView.count;
+}
+
+- (void)prefetchImagesForIndexPaths:(NSArray *)indexPaths model:(id)model direction:(NINetworkImagePrefetchDirection)direction {
+  NIDASSERT(nil == model || [model respondsToSelector:@selector(objectAtIndexPath:)]);
+  if (direction != self.lastDirection) {
+    [self cancelAllPrefetches];
+    self.lastDirection = direction;
+  }
+  if (![model respondsToSelector:@selector(objectAtIndexPath:)]) {
+    return;
+  }
+  for (NSIndexPath* indexPath in indexPaths) {
+    id object = [model objectAtIndexPath:indexPath];
+    if ([object conformsToProtocol:@protocol(NINetworkImagePrefetching)]) {
+      [object prefetchNetworkImagesWithPrefetcher:self];
+    }
+  }
+}
+
+- (void)prefetchImagesAfterVisibleRowsOfTableView:(UITableView *)tableView {
+  NINetworkImagePrefetchDirection direction = [self directionOfScrollView:tableView];
+  NSArray* visibleIndexPaths = [[tableView indexPathsForVisibleRows] sortedArrayUsingSelector:@selector(compare:)];
+  if (0 == visibleIndexPaths.count) {
+    return;
+  }
+  NSIndexPath* edge = (NINetworkImagePrefetchDirectionForward == direction) ? [visibleIndexPaths lastObject] : visibleIndexPaths[0];
+  NSArray* indexPaths = [[self class] indexPathsFollowingIndexPath:edge
+                                                         direction:direction
+                                                             count:[self adaptiveNumberOfObjectsToPrefetch]
+                                                  numberOfSections:tableView.numberOfSections
+                                             numberOfItemsInSection:^NSInteger(NSInteger section) {
+                                               return [tableView numberOfRowsInSection:section];
+                                             }];
+  [self prefetchImagesForIndexPaths:indexPaths model:tableView.dataSource direction:direction];
+}
+
+- (void)prefetchImagesAfterVisibleItemsOfCollectionView:(UICollectionView *)collectionView {
+  NINetworkImagePrefetchDirection direction = [self directionOfScrollView:collectionView];
+  NSArray* visibleIndexPaths = [[collectionView indexPathsForVisibleItems] sortedArrayUsingSelector:@selector(compare:)];
+  if (0 == visibleIndexPaths.count) {
+    return;
+  }
+  NSIndexPath* edge = (NINetworkImagePrefetchDirectionForward == direction) ? [visibleIndexPaths lastObject] : visibleIndexPaths[0];
+  NSArray* indexPaths = [[self class] indexPathsFollowingIndexPath:edge
+                                                         direction:direction
+                                                             count:[self adaptiveNumberOfObjectsToPrefetch]
+                                                  numberOfSections:collectionView.numberOfSections
+                                             numberOfItemsInSection:^NSInteger(NSInteger section) {
+                                               return [collectionView numberOfItemsInSection:section];
+                                             }];
+  [self prefetchImagesForIndexPaths:indexPaths model:collectionView.dataSource direction:direction];
+}
+
+#pragma mark - NINetworkImageViewDelegate
+
+- (void)networkImageView:(NINetworkImageView *)imageView didLoadImage:(UIImage *)image {
+  [self removeImageView:imageView];
+}
+
+- (void)networkImageView:(NINetworkImageView *)imageView didFailWithError:(NSError *)error {
+  [self removeImageView:imageView];
+}
+
+@end
@@ -0,0 +1,78 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Limits how many network image operations run against each host at once.
+ *
+ * Operations beyond a host's limit wait in the scheduler instead of in the operation queue.
+ * When one of a host's operations finishes, the waiting operation with the highest queue
+ * priority is added to its queue next, so image views that are on screen get ahead of those
+ * that were prefetched or have scrolled away. Hosts are limited independently, so a slow
+ * host only holds up its own images.
+ *
+ * NINetworkImageView adds its requests through the shared scheduler. The shared scheduler
+ * also reports the type of the network connection to Nimbus::setNetworkConnectionType: and
+ * asks Nimbus to update its adaptive limits as requests finish. Must only be used from the main
+ * thread.
+ *
+ * @ingroup NimbusNetworkImage
+ */
+@interface NINetworkImageScheduler : NSObject
+
++ (NINetworkImageScheduler *)sharedScheduler;
+
+@property (nonatomic, assign) NSUInteger maxNumberOfConcurrentOperationsPerHost; // Default: 4
+
+- (void)addOperation:(NSOperation *)operation forHost:(NSString *)host toQueue:(NSOperationQueue *)queue;
+
+- (NSUInteger)numberOfWaitingOperationsForHost:(NSString *)host;
+
+@end
+
+/**
+ * Returns the scheduler used by every NINetworkImageView.
+ *
+ * @fn NINetworkImageScheduler::sharedScheduler
+ */
+
+/**
+ * The most operations for one host that may be in their queues at once.
+ *
+ * Defaults to 4. 0 is special cased to represent an unlimited number of operations.
+ * Raising the limit lets waiting operations in right away.
+ *
+ * @fn NINetworkImageScheduler::maxNumberOfConcurrentOperationsPerHost
+ */
+
+/**
+ * Adds the operation to the queue now if the host is under its limit, or once one of the
+ * host's operations finishes otherwise.
+ *
+ * Operations without a host, such as those for file URLs, are added to the queue right away.
+ * A waiting operation's queuePriority may be changed at any time to move it up or down the
+ * line.
+ *
+ * @fn NINetworkImageScheduler::addOperation:forHost:toQueue:
+ */
+
+/**
+ * Returns the number of operations for the host that are waiting for a slot.
+ *
+ * @fn NINetworkImageScheduler::numberOfWaitingOperationsForHost:
+ */
@@ -0,0 +1,211 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NINetworkImageScheduler.h"
+
+#import "NimbusCore.h"
+#import "AFNetworkReachabilityManager.h"
+
+#import <netinet/in.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// An operation that is waiting for its host to have a free slot.
+@interface NINetworkImageSchedulerEntry : NSObject
+@property (nonatomic, strong) NSOperation* operation;
+@property (nonatomic, strong) NSOperationQueue* queue;
+@end
+
+@implementation NINetworkImageSchedulerEntry
+@end
+
+@interface NINetworkImageScheduler ()
+@property (nonatomic, strong) NSMutableDictionary* hostToWaitingEntries;
+@property (nonatomic, strong) NSMutableDictionary* hostToNumberOfRunningOperations;
+@property (nonatomic, strong) AFNetworkReachabilityManager* reachabilityManager;
+@end
+
+@implementation NINetworkImageScheduler
+
+- (id)init {
+  if ((self = [super init])) {
+    _hostToWaitingEntries = [[NSMutableDictionary alloc] init];
+    _hostToNumberOfRunningOperations = [[NSMutableDictionary alloc] init];
+    _maxNumberOfConcurrentOperationsPerHost = 4;
+  }
+  return self;
+}
+
++ (NINetworkImageScheduler *)sharedScheduler {
+  static NINetworkImageScheduler* sScheduler = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sScheduler = [[NINetworkImageScheduler alloc] init];
+    [sScheduler startReportingConnectionType];
+  });
+  return sScheduler;
+}
+
+// Tells Nimbus what kind of connection image requests are going over, so that the network
+// operation queue can be sized for it. The app's shared reachability manager is left alone.
+- (void)startReportingConnectionType {
+  struct sockaddr_in address;
+  bzero(&address, sizeof(address));
+  address.sin_len = sizeof(address);
+  address.sin_family = AF_INET;
+  self.reachabilityManager = [AFNetworkReachabilityManager managerForAddress:&address];
+  // The block is called on the main queue.
+  [self.reachabilityManager setReachabilityStatusChangeBlock:^(AFNetworkReachabilityStatus status) {
+    switch (status) {
+      case AFNetworkReachabilityStatusNotReachable:
+        [Nimbus setNetworkConnectionType:NINetworkConnectionTypeNone];
+        break;
+      case AFNetworkReachabilityStatusReachableViaWWAN:
+        [Nimbus setNetworkConnectionType:NINetworkConnectionTypeCellular];
+        break;
+      case AFNetworkReachabilityStatusReachableViaWiFi:
+        [Nimbus setNetworkConnectionType:NINetworkConnectionTypeWiFi];
+        break;
+      default:
+        [Nimbus setNetworkConnectionType:NINetworkConnectionTypeUnknown];
+        break;
+    }
+  }];
+  [self.reachabilityManager startMonitoring];
+}
+
+#pragma mark - Private
+
+- (NSUInteger)numberOfRunningOperationsForHost:(NSString *)host {
+  return [[self.hostToNumberOfRunningOperations objectForKey:host] unsignedIntegerValue];
+}
+
+- (void)setNumberOfRunningOperations:(NSUInteger)numberOfRunningOperations forHost:(NSString *)host {
+  if (0 == numberOfRunningOperations) {
+    [self.hostToNumberOfRunningOperations removeObjectForKey:host];
+  } else {
+    [self.hostToNumberOfRunningOperations setObject:@(numberOfRunningOperations) forKey:host];
+  }
+}
+
+- (BOOL)hostHasFreeSlot:(NSString *)host {
+  return (0 == self.maxNumberOfConcurrentOperationsPerHost
+          || [self numberOfRunningOperationsForHost:host] < self.maxNumberOfConcurrentOperationsPerHost);
+}
+
+// Adds the operation to its queue along with a follower that frees the host's slot once the
+// operation has finished or been cancelled.
+- (void)startOperation:(NSOperation *)operation forHost:(NSString *)host queue:(NSOperationQueue *)queue {
+  [self setNumberOfRunningOperations:[self numberOfRunningOperationsForHost:host] + 1 forHost:host];
+
+  __weak NINetworkImageScheduler* weakSelf = self;
+  NSBlockOperation* follower = [NSBlockOperation blockOperationWithBlock:^{
+    dispatch_async(dispatch_get_main_queue(), ^{
+      [weakSelf operationDidFinishForHost:host];
+    });
+  }];
+  [follower addDependency:operation];
+  [queue addOperation:operation];
+  [queue addOperation:follower];
+}
+
+- (void)operationDidFinishForHost:(NSString *)host {
+  NSUInteger numberOfRunningOperations = [self numberOfRunningOperationsForHost:host];
+  NIDASSERT(numberOfRunningOperations > 0);
+  [self setNumberOfRunningOperations:(numberOfRunningOperations > 0 ? numberOfRunningOperations - 1 : 0) forHost:host];
+  // Each finished request adds to the measured throughput.
+  [Nimbus setNeedsDeviceConditionsUpdate];
+  [self startWaitingOperationsForHost:host];
+}
+
+- (void)startWaitingOperationsForHost:(NSString *)host {
+  NSMutableArray* entries = [self.hostToWaitingEntries objectForKey:host];
+  while (entries.count > 0 && [self hostHasFreeSlot:host]) {
+    // Priorities change while operations wait, so pick the highest one now. Earlier operations
+    // win ties.
+    NSUInteger indexOfBestEntry = 0;
+    NSOperationQueuePriority bestPriority = NSOperationQueuePriorityVeryLow;
+    for (NSUInteger ix = 0; ix < entries.count; ++ix) {
+      NINetworkImageSchedulerEntry* entry = entries[ix];
+      if (entry.operation.isCancelled) {
+        // Cancelled operations finish as soon as they start, so they don't need a slot.
+        [entry.queue addOperation:entry.operation];
+        [entries removeObjectAtIndex:ix];
+        --ix;
+        continue;
+      }
+      if (ix == 0 || entry.operation.queuePriority > bestPriority) {
+        indexOfBestEntry = ix;
+        bestPriority = entry.operation.queuePriority;
+      }
+    }
+    if (0 == entries.count) {
+      break;
+    }
+    NINetworkImageSchedulerEntry* entry = entries[indexOfBestEntry];
+    [entries removeObjectAtIndex:indexOfBestEntry];
+    [self startOperation:entry.operation forHost:host queue:entry.queue];
+  }
+  if (0 == entries.count) {
+    [self.hostToWaitingEntries removeObjectForKey:host];
+  }
+}
+
+#pragma mark - Public
+
+- (void)setMaxNumberOfConcurrentOperationsPerHost:(NSUInteger)maxNumberOfConcurrentOperationsPerHost {
+  _maxNumberOfConcurrentOperationsPerHost = maxNumberOfConcurrentOperationsPerHost;
+  for (NSString* host in [self.hostToWaitingEntries allKeys]) {
+    [self startWaitingOperationsForHost:host];
+  }
+}
+
+- (void)addOperation:(NSOperation *)operation forHost:(NSString *)host toQueue:(NSOperationQueue *)queue {
+  NIDASSERT([NSThread isMainThread]);
+  NIDASSERT(nil != operation && nil != queue);
+  if (nil == operation || nil == queue) {
+    return;
+  }
+  if (!NIIsStringWithAnyText(host)) {
+    [queue addOperation:operation];
+    return;
+  }
+  host = [host lowercaseString];
+
+  if ([self hostHasFreeSlot:host]) {
+    [self startOperation:operation forHost:host queue:queue];
+    return;
+  }
+
+  NINetworkImageSchedulerEntry* entry = [[NINetworkImageSchedulerEntry alloc] init];
+  entry.operation = operation;
+  entry.queue = queue;
+  NSMutableArray* entries = [self.hostToWaitingEntries objectForKey:host];
+  if (nil == entries) {
+    entries = [[NSMutableArray alloc] init];
+    [self.hostToWaitingEntries setObject:entries forKey:host];
+  }
+  [entries addObject:entry];
+}
+
+- (NSUInteger)numberOfWaitingOperationsForHost:(NSString *)host {
+  return [[self.hostToWaitingEntries objectForKey:[host lowercaseString]] count];
+}
+
+@end
@@ -0,0 +1,242 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+
+#import "AFURLResponseSerialization.h"
+
+@class NINetworkImageSessionOperation;
+
+/**
+ * A shared NSURLSession that network image requests can be made through.
+ *
+ * Every NINetworkImageView whose transport is NINetworkImageTransportSession makes its
+ * requests through the shared session, so they reuse the session's connections, multiplex
+ * over HTTP/2 where the server supports it, and share the session's URL cache. Requests made
+ * with NINetworkImageTransportBackgroundSession go through a background session instead, which
+ * keeps downloading while the app is suspended.
+ *
+ * Requests still run as NSOperations, wrapped by NINetworkImageSessionOperation, so that the
+ * NINetworkImageScheduler and operation queue priorities work for them just as they do for
+ * AFNetworking operations.
+ *
+ * @ingroup NimbusNetworkImage
+ */
+@interface NINetworkImageSession : NSObject
+
++ (BOOL)isAvailable;
+
++ (NINetworkImageSession *)sharedSession;
++ (NINetworkImageSession *)sharedBackgroundSession;
+
+// Designated initializer.
+- (id)initWithConfiguration:(NSURLSessionConfiguration *)configuration;
+
+@property (nonatomic, readonly, strong) NSURLSession* session;
+
++ (BOOL)handleEventsForBackgroundURLSession:(NSString *)identifier completionHandler:(void (^)(void))completionHandler;
+
+- (void)addImageHostWithURL:(NSURL *)url;
+- (void)removeImageHostWithURL:(NSURL *)url;
+- (NSArray *)imageHostURLs;
+- (void)prewarmConnections;
+
+@end
+
+/**
+ * An operation that runs one request as a task of an NINetworkImageSession.
+ *
+ * The interface mirrors the parts of AFHTTPRequestOperation that network images use. The
+ * response is serialized off the main thread, and the completion and progress blocks are
+ * called on the main thread.
+ *
+ * The operation's queuePriority is mirrored onto the task's priority, so that the session
+ * serves the images that are on screen before those that were prefetched.
+ *
+ * @ingroup NimbusNetworkImage
+ */
+@interface NINetworkImageSessionOperation : NSOperation
+
+// Designated initializer.
+- (id)initWithRequest:(NSURLRequest *)request session:(NINetworkImageSession *)session;
+
+@property (nonatomic, readonly, strong) NSURLRequest* request;
+@property (nonatomic, readonly, strong) NINetworkImageSession* session;
+@property (nonatomic, strong) id<AFURLResponseSerialization> responseSerializer;
+@property (nonatomic, copy) NSURL* outputFileURL; // Default: nil
+
+@property (readonly, strong) NSHTTPURLResponse* response;
+@property (readonly, strong) id responseObject;
+@property (readonly, strong) NSError* error;
+
+- (NSData *)responseData;
+
+- (void)setCompletionBlockWithSuccess:(void (^)(NINetworkImageSessionOperation* operation, id responseObject))success
+                              failure:(void (^)(NINetworkImageSessionOperation* operation, NSError* error))failure;
+- (void)setDownloadProgressBlock:(void (^)(NSUInteger bytesRead, long long totalBytesRead, long long totalBytesExpectedToRead))block;
+
+@end
+
+/** @name Accessing the Shared Sessions */
+
+/**
+ * Whether NSURLSession exists on this device.
+ *
+ * NSURLSession is only available from iOS 7. Before that the shared sessions are nil and image
+ * views load over NINetworkImageTransportOperation whatever their transport.
+ *
+ * @fn NINetworkImageSession::isAvailable
+ */
+
+/**
+ * The session used by NINetworkImageTransportSession.
+ *
+ * It uses the default session configuration, limited to four connections per host, with the
+ * shared URL cache. nil if the session is not available.
+ *
+ * @fn NINetworkImageSession::sharedSession
+ */
+
+/**
+ * The background session used by NINetworkImageTransportBackgroundSession.
+ *
+ * Background sessions can only download to files, so requests made through it never provide
+ * partial data for progressive loading. Its transfers continue while the app is suspended and
+ * complete once the app runs again. nil if the session is not available.
+ *
+ * @fn NINetworkImageSession::sharedBackgroundSession
+ */
+
+/**
+ * Initializes a newly allocated session with the given configuration.
+ *
+ * @fn NINetworkImageSession::initWithConfiguration:
+ */
+
+/**
+ * The underlying NSURLSession.
+ *
+ * @fn NINetworkImageSession::session
+ */
+
+/**
+ * Hands the completion handler of a background session event to the background session.
+ *
+ * Call this from your app delegate's application:handleEventsForBackgroundURLSession:completionHandler:.
+ * The handler is called once the session has delivered all of its events.
+ *
+ * @returns YES if the identifier belongs to the Nimbus background session, NO if the event is
+ *               for another session and should be handled elsewhere.
+ * @fn NINetworkImageSession::handleEventsForBackgroundURLSession:completionHandler:
+ */
+
+/** @name Warming Up Connections */
+
+/**
+ * Registers the host of the URL as one that images will be loaded from.
+ *
+ * The session opens a connection to the host right away and again each time the app returns
+ * to the foreground, by sending it a HEAD request. The first image request after launch or
+ * after a spell in the background then finds the host already resolved and a connection with
+ * TLS already negotiated, rather than paying for them itself. Register the hosts of images
+ * that are shown as soon as the app starts, such as avatars, from
+ * application:didFinishLaunchingWithOptions:.
+ *
+ * Only requests made through this session reuse its connections, so image views that should
+ * benefit need NINetworkImageTransportSession. Other requests still benefit from the host
+ * having been resolved. Background sessions don't warm up connections.
+ *
+ * @param url Any URL on the host. Only its scheme, host and port are used.
+ * @fn NINetworkImageSession::addImageHostWithURL:
+ */
+
+/**
+ * Stops warming up connections to the host of the URL.
+ *
+ * @fn NINetworkImageSession::removeImageHostWithURL:
+ */
+
+/**
+ * The root URLs of the registered image hosts.
+ *
+ * @fn NINetworkImageSession::imageHostURLs
+ */
+
+/**
+ * Opens a connection to each registered image host that hasn't been warmed up in the last
+ * thirty seconds.
+ *
+ * Called automatically when the app returns to the foreground.
+ *
+ * @fn NINetworkImageSession::prewarmConnections
+ */
+
+/** @name Running a Request */
+
+/**
+ * Initializes a newly allocated operation that will run the request in the given session.
+ *
+ * The task is created when the operation starts.
+ *
+ * @fn NINetworkImageSessionOperation::initWithRequest:session:
+ */
+
+/**
+ * The serializer that validates the response and turns its data into the response object.
+ *
+ * @fn NINetworkImageSessionOperation::responseSerializer
+ */
+
+/**
+ * The file that the response body is written to as it arrives.
+ *
+ * By default the body is collected in memory, which for a full resolution photo means holding
+ * every byte of it until it has been decoded. When this is set, each chunk is appended to the
+ * file instead and the serializer is handed the file mapped into memory, so an image decoder
+ * that downsamples only pages in the bytes it reads. Tasks in a background session move their
+ * finished download here.
+ *
+ * The file is replaced if it exists and is left in place once the operation finishes, for the
+ * caller to keep or delete. Must be set before the operation starts.
+ *
+ * @see NIDiskCache::temporaryFileURL
+ * @fn NINetworkImageSessionOperation::outputFileURL
+ */
+
+/**
+ * The bytes that have been received so far.
+ *
+ * Tasks in a background session write to a file, so this is nil until they finish. When
+ * outputFileURL is set this is the file's contents so far, mapped into memory.
+ *
+ * @fn NINetworkImageSessionOperation::responseData
+ */
+
+/**
+ * Sets the blocks to call on the main thread once the response has been serialized.
+ *
+ * failure is called with the serializer's error for unacceptable responses, which leaves the
+ * response available for inspection.
+ *
+ * @fn NINetworkImageSessionOperation::setCompletionBlockWithSuccess:failure:
+ */
+
+/**
+ * Sets the block to call on the main thread whenever more of the response arrives.
+ *
+ * @fn NINetworkImageSessionOperation::setDownloadProgressBlock:
+ */
@@ -0,0 +1,578 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NINetworkImageSession.h"
+
+#import "NimbusCore.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+static NSString* const kNINetworkImageBackgroundSessionIdentifier = @"com.nimbuskit.networkimage.background";
+
+// Matches the per-host limit of NINetworkImageScheduler.
+static const NSInteger kNINetworkImageSessionMaxConnectionsPerHost = 4;
+
+// Servers close idle connections after a while, so a host that was warmed up more recently than
+// this is assumed to still have one open.
+static const NSTimeInterval kNINetworkImageSessionPrewarmInterval = 30;
+
+// Set by the app delegate when the system relaunches the app for background session events.
+static void (^sBackgroundEventsCompletionHandler)(void) = nil;
+
+@interface NINetworkImageSessionOperation()
+- (void)setTask:(NSURLSessionTask *)task;
+- (void)didReceiveResponse:(NSURLResponse *)response;
+- (void)didReceiveData:(NSData *)data;
+- (void)didReceiveNumberOfBytes:(long long)numberOfBytes totalBytesReceived:(long long)totalBytesReceived totalBytesExpected:(long long)totalBytesExpected;
+- (void)didFinishDownloadingToURL:(NSURL *)location;
+- (void)didCompleteWithResponse:(NSURLResponse *)response error:(NSError *)error;
+@end
+
+@interface NINetworkImageSession() <NSURLSessionDataDelegate, NSURLSessionDownloadDelegate>
+@end
+
+@implementation NINetworkImageSession {
+  // The operations whose tasks are running, keyed by task identifier. Operations are retained
+  // until their tasks complete.
+  NSMutableDictionary* _operationsByTaskIdentifier;
+  BOOL _isBackgroundSession;
+
+  // The registered image hosts, mapped to when they were last warmed up.
+  NSMutableDictionary* _imageHostURLsToPrewarmDates;
+}
+
+- (void)dealloc {
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
++ (BOOL)isAvailable {
+  return (nil != NSClassFromString(@"NSURLSession"));
+}
+
++ (NINetworkImageSession *)sharedSession {
+  if (![self isAvailable]) {
+    return nil;
+  }
+  static NINetworkImageSession* sSession = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    NSURLSessionConfiguration* configuration = [NSURLSessionConfiguration defaultSessionConfiguration];
+    configuration.HTTPMaximumConnectionsPerHost = kNINetworkImageSessionMaxConnectionsPerHost;
+    configuration.URLCache = [NSURLCache sharedURLCache];
+    sSession = [[NINetworkImageSession alloc] initWithConfiguration:configuration];
+  });
+  return sSession;
+}
+
++ (NINetworkImageSession *)sharedBackgroundSession {
+  if (![self isAvailable]) {
+    return nil;
+  }
+  static NINetworkImageSession* sSession = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    NSURLSessionConfiguration* configuration = nil;
+    if ([NSURLSessionConfiguration respondsToSelector:@selector(backgroundSessionConfigurationWithIdentifier:)]) {
+      configuration = [NSURLSessionConfiguration backgroundSessionConfigurationWithIdentifier:kNINetworkImageBackgroundSessionIdentifier];
+    } else {
+      configuration = [NSURLSessionConfiguration backgroundSessionConfiguration:kNINetworkImageBackgroundSessionIdentifier];
+    }
+    configuration.HTTPMaximumConnectionsPerHost = kNINetworkImageSessionMaxConnectionsPerHost;
+    sSession = [[NINetworkImageSession alloc] initWithConfiguration:configuration];
+  });
+  return sSession;
+}
+
+- (id)initWithConfiguration:(NSURLSessionConfiguration *)configuration {
+  if ((self = [super init])) {
+    _operationsByTaskIdentifier = [[NSMutableDictionary alloc] init];
+    _isBackgroundSession = (nil != configuration.identifier);
+    _imageHostURLsToPrewarmDates = [[NSMutableDictionary alloc] init];
+
+    // Delegate callbacks for a task must arrive in order.
+    NSOperationQueue* delegateQueue = [[NSOperationQueue alloc] init];
+    delegateQueue.maxConcurrentOperationCount = 1;
+    _session = [NSURLSession sessionWithConfiguration:configuration delegate:self delegateQueue:delegateQueue];
+
+    if (!_isBackgroundSession) {
+      // Connections are usually closed while the app is in the background.
+      [[NSNotificationCenter defaultCenter] addObserver:self
+                                               selector:@selector(prewarmConnections)
+                                                   name:UIApplicationWillEnterForegroundNotification
+                                                 object:nil];
+    }
+  }
+  return self;
+}
+
++ (BOOL)handleEventsForBackgroundURLSession:(NSString *)identifier completionHandler:(void (^)(void))completionHandler {
+  if (![identifier isEqualToString:kNINetworkImageBackgroundSessionIdentifier]) {
+    return NO;
+  }
+  sBackgroundEventsCompletionHandler = [completionHandler copy];
+
+  // Creating the session reconnects it to the transfers that finished while the app wasn't
+  // running.
+  [self sharedBackgroundSession];
+  return YES;
+}
+
+#pragma mark - Image Hosts
+
+// The root URL of the host, which is what connections are opened to.
+static NSURL* NINetworkImageSessionHostURL(NSURL* url) {
+  NSString* scheme = [url.scheme lowercaseString];
+  if (!NIIsStringWithAnyText(url.host)
+      || !([scheme isEqualToString:@"http"] || [scheme isEqualToString:@"https"])) {
+    return nil;
+  }
+  NSURLComponents* components = [[NSURLComponents alloc] init];
+  components.scheme = scheme;
+  components.host = [url.host lowercaseString];
+  components.port = url.port;
+  components.path = @"/";
+  return components.URL;
+}
+
+- (void)addImageHostWithURL:(NSURL *)url {
+  NSURL* hostURL = NINetworkImageSessionHostURL(url);
+  if (nil == hostURL) {
+    return;
+  }
+  @synchronized(self) {
+    if (nil == _imageHostURLsToPrewarmDates[hostURL]) {
+      _imageHostURLsToPrewarmDates[hostURL] = [NSDate distantPast];
+    }
+  }
+  [self prewarmConnections];
+}
+
+- (void)removeImageHostWithURL:(NSURL *)url {
+  NSURL* hostURL = NINetworkImageSessionHostURL(url);
+  if (nil == hostURL) {
+    return;
+  }
+  @synchronized(self) {
+    [_imageHostURLsToPrewarmDates removeObjectForKey:hostURL];
+  }
+}
+
+- (NSArray *)imageHostURLs {
+  @synchronized(self) {
+    return [_imageHostURLsToPrewarmDates allKeys];
+  }
+}
+
+- (void)prewarmConnections {
+  if (_isBackgroundSession) {
+    return;
+  }
+
+  NSMutableArray* hostURLs = [NSMutableArray array];
+  NSDate* now = [NSDate date];
+  @synchronized(self) {
+    for (NSURL* hostURL in [_imageHostURLsToPrewarmDates allKeys]) {
+      NSDate* prewarmDate = _imageHostURLsToPrewarmDates[hostURL];
+      if ([now timeIntervalSinceDate:prewarmDate] >= kNINetworkImageSessionPrewarmInterval) {
+        _imageHostURLsToPrewarmDates[hostURL] = now;
+        [hostURLs addObject:hostURL];
+      }
+    }
+  }
+
+  for (NSURL* hostURL in hostURLs) {
+    // The response doesn't matter; opening the connection is the point. The task has no
+    // operation, so its delegate callbacks are dropped.
+    NSMutableURLRequest* request = [NSMutableURLRequest requestWithURL:hostURL
+                                                           cachePolicy:NSURLRequestReloadIgnoringLocalCacheData
+                                                       timeoutInterval:10];
+    request.HTTPMethod = @"HEAD";
+    [[self.session dataTaskWithRequest:request] resume];
+  }
+}
+
+#pragma mark - Tasks
+
+- (NSURLSessionTask *)startTaskWithRequest:(NSURLRequest *)request forOperation:(NINetworkImageSessionOperation *)operation {
+  NSURLSessionTask* task = (_isBackgroundSession
+                            ? [self.session downloadTaskWithRequest:request]
+                            : [self.session dataTaskWithRequest:request]);
+  @synchronized(self) {
+    _operationsByTaskIdentifier[@(task.taskIdentifier)] = operation;
+  }
+  [operation setTask:task];
+  [task resume];
+  return task;
+}
+
+- (NINetworkImageSessionOperation *)operationForTask:(NSURLSessionTask *)task {
+  @synchronized(self) {
+    return _operationsByTaskIdentifier[@(task.taskIdentifier)];
+  }
+}
+
+#pragma mark - NSURLSessionDataDelegate
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveResponse:(NSURLResponse *)response completionHandler:(void (^)(NSURLSessionResponseDisposition disposition))completionHandler {
+  [[self operationForTask:dataTask] didReceiveResponse:response];
+  completionHandler(NSURLSessionResponseAllow);
+}
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveData:(NSData *)data {
+  [[self operationForTask:dataTask] didReceiveData:data];
+}
+
+#pragma mark - NSURLSessionDownloadDelegate
+
+- (void)URLSession:(NSURLSession *)session downloadTask:(NSURLSessionDownloadTask *)downloadTask didWriteData:(int64_t)bytesWritten totalBytesWritten:(int64_t)totalBytesWritten totalBytesExpectedToWrite:(int64_t)totalBytesExpectedToWrite {
+  [[self operationForTask:downloadTask] didReceiveNumberOfBytes:bytesWritten
+                                             totalBytesReceived:totalBytesWritten
+                                             totalBytesExpected:totalBytesExpectedToWrite];
+}
+
+- (void)URLSession:(NSURLSession *)session downloadTask:(NSURLSessionDownloadTask *)downloadTask didFinishDownloadingToURL:(NSURL *)location {
+  // The file is deleted as soon as this method returns.
+  [[self operationForTask:downloadTask] didFinishDownloadingToURL:location];
+}
+
+- (void)URLSession:(NSURLSession *)session downloadTask:(NSURLSessionDownloadTask *)downloadTask didResumeAtOffset:(int64_t)fileOffset expectedTotalBytes:(int64_t)expectedTotalBytes {
+}
+
+#pragma mark - NSURLSessionTaskDelegate
+
+- (void)URLSession:(NSURLSession *)session task:(NSURLSessionTask *)task didCompleteWithError:(NSError *)error {
+  NINetworkImageSessionOperation* operation = nil;
+  @synchronized(self) {
+    operation = _operationsByTaskIdentifier[@(task.taskIdentifier)];
+    [_operationsByTaskIdentifier removeObjectForKey:@(task.taskIdentifier)];
+  }
+  // Transfers that outlived the app that started them have nobody left to deliver to.
+  [operation didCompleteWithResponse:task.response error:error];
+}
+
+#pragma mark - NSURLSessionDelegate
+
+- (void)URLSessionDidFinishEventsForBackgroundURLSession:(NSURLSession *)session {
+  dispatch_async(dispatch_get_main_queue(), ^{
+    void (^completionHandler)(void) = sBackgroundEventsCompletionHandler;
+    sBackgroundEventsCompletionHandler = nil;
+    if (nil != completionHandler) {
+      completionHandler();
+    }
+  });
+}
+
+@end
+
+static float NITaskPriorityFromQueuePriority(NSOperationQueuePriority queuePriority) {
+  if (queuePriority >= NSOperationQueuePriorityHigh) {
+    return NSURLSessionTaskPriorityHigh;
+  } else if (queuePriority <= NSOperationQueuePriorityLow) {
+    return NSURLSessionTaskPriorityLow;
+  }
+  return NSURLSessionTaskPriorityDefault;
+}
+
+@implementation NINetworkImageSessionOperation {
+  NSURLSessionTask* _task;
+  NSMutableData* _data;
+
+  // Only used when the body is written to the outputFileURL.
+  NSFileHandle* _fileHandle;
+  long long _numberOfBytesWritten;
+  BOOL _didFailToWriteFile;
+  NINetworkTaskMetrics _metrics;
+  BOOL _isExecuting;
+  BOOL _isFinished;
+
+  void (^_success)(NINetworkImageSessionOperation* operation, id responseObject);
+  void (^_failure)(NINetworkImageSessionOperation* operation, NSError* error);
+  void (^_progress)(NSUInteger bytesRead, long long totalBytesRead, long long totalBytesExpectedToRead);
+}
+
+@synthesize response = _response;
+@synthesize responseObject = _responseObject;
+@synthesize error = _error;
+
+- (id)initWithRequest:(NSURLRequest *)request session:(NINetworkImageSession *)session {
+  if ((self = [super init])) {
+    NIDASSERT(nil != request);
+    _request = request;
+    _session = session;
+    _data = [[NSMutableData alloc] init];
+  }
+  return self;
+}
+
+- (id)init {
+  return [self initWithRequest:nil session:nil];
+}
+
+#pragma mark - Blocks
+
+- (void)setCompletionBlockWithSuccess:(void (^)(NINetworkImageSessionOperation* operation, id responseObject))success
+                              failure:(void (^)(NINetworkImageSessionOperation* operation, NSError* error))failure {
+  @synchronized(self) {
+    _success = [success copy];
+    _failure = [failure copy];
+  }
+}
+
+- (void)setDownloadProgressBlock:(void (^)(NSUInteger bytesRead, long long totalBytesRead, long long totalBytesExpectedToRead))block {
+  @synchronized(self) {
+    _progress = [block copy];
+  }
+}
+
+#pragma mark - NSOperation
+
+- (BOOL)isConcurrent {
+  return YES;
+}
+
+- (BOOL)isAsynchronous {
+  return YES;
+}
+
+- (BOOL)isExecuting {
+  @synchronized(self) {
+    return _isExecuting;
+  }
+}
+
+- (BOOL)isFinished {
+  @synchronized(self) {
+    return _isFinished;
+  }
+}
+
+- (void)start {
+  if ([self isCancelled]) {
+    [self finish];
+    return;
+  }
+
+  [self willChangeValueForKey:@"isExecuting"];
+  @synchronized(self) {
+    _isExecuting = YES;
+  }
+  [self didChangeValueForKey:@"isExecuting"];
+
+  @synchronized(self) {
+    _metrics = NINetworkTaskMetricsDidStart(self.request.URL);
+  }
+  [self.session startTaskWithRequest:self.request forOperation:self];
+}
+
+- (void)cancel {
+  [super cancel];
+  NSURLSessionTask* task = nil;
+  @synchronized(self) {
+    task = _task;
+  }
+  // The task completes with NSURLErrorCancelled, which finishes the operation.
+  [task cancel];
+}
+
+- (void)setQueuePriority:(NSOperationQueuePriority)queuePriority {
+  [super setQueuePriority:queuePriority];
+  [self updateTaskPriority];
+}
+
+- (void)updateTaskPriority {
+  NSURLSessionTask* task = nil;
+  @synchronized(self) {
+    task = _task;
+  }
+  if ([task respondsToSelector:@selector(setPriority:)]) {
+    task.priority = NITaskPriorityFromQueuePriority(self.queuePriority);
+  }
+}
+
+- (void)finish {
+  [self willChangeValueForKey:@"isExecuting"];
+  [self willChangeValueForKey:@"isFinished"];
+  @synchronized(self) {
+    _isExecuting = NO;
+    _isFinished = YES;
+    _task = nil;
+  }
+  [self didChangeValueForKey:@"isFinished"];
+  [self didChangeValueForKey:@"isExecuting"];
+}
+
+#pragma mark - Task Events
+
+- (void)setTask:(NSURLSessionTask *)task {
+  @synchronized(self) {
+    _task = task;
+  }
+  [self updateTaskPriority];
+  if ([self isCancelled]) {
+    [task cancel];
+  }
+}
+
+- (NSData *)responseData {
+  // Written bytes are visible to a new mapping right away, without flushing the file.
+  if (nil != self.outputFileURL) {
+    return [NSData dataWithContentsOfURL:self.outputFileURL options:NSDataReadingMappedAlways error:nil];
+  }
+  @synchronized(self) {
+    return [_data copy];
+  }
+}
+
+- (void)didReceiveResponse:(NSURLResponse *)response {
+  @synchronized(self) {
+    if ([response isKindOfClass:[NSHTTPURLResponse class]]) {
+      _response = (NSHTTPURLResponse *)response;
+    }
+  }
+}
+
+- (void)didReceiveData:(NSData *)data {
+  long long totalBytesReceived = 0;
+  long long totalBytesExpected = 0;
+  @synchronized(self) {
+    if (nil != self.outputFileURL) {
+      [self writeDataToOutputFile:data];
+      totalBytesReceived = _numberOfBytesWritten;
+    } else {
+      [_data appendData:data];
+      totalBytesReceived = (long long)_data.length;
+    }
+    totalBytesExpected = (nil != _response) ? _response.expectedContentLength : NSURLResponseUnknownLength;
+  }
+  [self didReceiveNumberOfBytes:data.length
+             totalBytesReceived:totalBytesReceived
+             totalBytesExpected:totalBytesExpected];
+}
+
+- (void)didReceiveNumberOfBytes:(long long)numberOfBytes totalBytesReceived:(long long)totalBytesReceived totalBytesExpected:(long long)totalBytesExpected {
+  void (^progress)(NSUInteger, long long, long long) = nil;
+  @synchronized(self) {
+    NINetworkTaskMetricsDidReceiveBytes(&_metrics, (unsigned long long)MAX(0, numberOfBytes));
+    progress = _progress;
+  }
+  if (nil == progress) {
+    return;
+  }
+  dispatch_async(dispatch_get_main_queue(), ^{
+    progress((NSUInteger)numberOfBytes, totalBytesReceived, totalBytesExpected);
+  });
+}
+
+// Must be called while holding the lock.
+- (void)writeDataToOutputFile:(NSData *)data {
+  if (_didFailToWriteFile) {
+    return;
+  }
+  if (nil == _fileHandle) {
+    [[NSFileManager defaultManager] createFileAtPath:self.outputFileURL.path contents:nil attributes:nil];
+    _fileHandle = [NSFileHandle fileHandleForWritingToURL:self.outputFileURL error:nil];
+  }
+  // NSFileHandle reports write errors, such as a full disk, by raising.
+  @try {
+    [_fileHandle writeData:data];
+    _numberOfBytesWritten += (long long)data.length;
+  } @catch (NSException* exception) {
+    _didFailToWriteFile = YES;
+  }
+  if (nil == _fileHandle) {
+    _didFailToWriteFile = YES;
+  }
+}
+
+// The file at location is deleted as soon as this returns.
+- (void)didFinishDownloadingToURL:(NSURL *)location {
+  NSURL* outputFileURL = self.outputFileURL;
+  if (nil != outputFileURL) {
+    NSFileManager* fileManager = [NSFileManager defaultManager];
+    [fileManager removeItemAtURL:outputFileURL error:nil];
+    BOOL didMove = [fileManager moveItemAtURL:location toURL:outputFileURL error:nil];
+    @synchronized(self) {
+      _didFailToWriteFile = !didMove;
+    }
+    return;
+  }
+  NSData* data = [NSData dataWithContentsOfURL:location];
+  @synchronized(self) {
+    _data = [data mutableCopy];
+  }
+}
+
+- (void)didCompleteWithResponse:(NSURLResponse *)response error:(NSError *)error {
+  @synchronized(self) {
+    NINetworkTaskMetricsDidFinish(&_metrics);
+    [_fileHandle closeFile];
+    _fileHandle = nil;
+    if (_didFailToWriteFile && nil == error) {
+      error = [NSError errorWithDomain:NSURLErrorDomain
+                                  code:NSURLErrorCannotWriteToFile
+                              userInfo:@{NSURLErrorFailingURLErrorKey: self.request.URL}];
+    }
+  }
+  [self didReceiveResponse:response];
+  NSData* data = [self responseData];
+  NSHTTPURLResponse* httpResponse = self.response;
+  id<AFURLResponseSerialization> serializer = self.responseSerializer;
+
+  // Serializing decodes and processes the image, which is too slow for the delegate queue.
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    NSError* serializationError = error;
+    id responseObject = nil;
+    if (nil == serializationError) {
+      if (nil != serializer) {
+        responseObject = [serializer responseObjectForResponse:httpResponse data:data error:&serializationError];
+      } else {
+        responseObject = data;
+      }
+    }
+
+    @synchronized(self) {
+      _responseObject = responseObject;
+      _error = serializationError;
+    }
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+      void (^success)(NINetworkImageSessionOperation*, id) = nil;
+      void (^failure)(NINetworkImageSessionOperation*, NSError*) = nil;
+      @synchronized(self) {
+        success = _success;
+        failure = _failure;
+        // Break the cycles between the operation and the blocks that capture it.
+        _success = nil;
+        _failure = nil;
+        _progress = nil;
+      }
+
+      if (nil != serializationError) {
+        if (nil != failure) {
+          failure(self, serializationError);
+        }
+      } else if (nil != success) {
+        success(self, responseObject);
+      }
+      [self finish];
+    });
+  });
+}
+
+@end
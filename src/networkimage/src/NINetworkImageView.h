@@ -20,6 +20,8 @@
 #import "NIInMemoryCache.h"
 #import "NimbusCore.h"
 
+@class NIImagePipeline;
+@class NIImageStyle;
 @protocol NINetworkImageViewDelegate;
 @protocol ASICacheDelegate;
 
@@ -44,6 +46,20 @@ typedef enum {
   NINetworkImageViewScaleToFillLeavesExcess  = 0x02,
 } NINetworkImageViewScaleOptions;
 
+typedef enum {
+  NINetworkImageViewResamplingEngineCoreGraphics,
+  NINetworkImageViewResamplingEngineVImage,
+} NINetworkImageViewResamplingEngine;
+
+typedef enum {
+  NINetworkImageTransportOperation,
+  NINetworkImageTransportSession,
+  NINetworkImageTransportBackgroundSession,
+} NINetworkImageTransport;
+
+// Returns the path of the server's rendition of an image that best fits the given size in pixels.
+typedef NSString* (^NINetworkImagePathVariantBlock)(NSString* pathToNetworkImage, CGSize pixelSize);
+
 /**
  * A protocol defining the set of characteristics for an operation to be used with
  * NINetworkImageView.
@@ -79,11 +95,28 @@ typedef enum {
 @property (nonatomic, assign) BOOL sizeForDisplay;       // Default: YES
 @property (nonatomic, assign) NINetworkImageViewScaleOptions scaleOptions; // Default: NINetworkImageViewScaleToFitLeavesExcessAndScaleToFillCropsExcess
 @property (nonatomic, assign) CGInterpolationQuality interpolationQuality; // Default: kCGInterpolationDefault
+@property (nonatomic, assign) NINetworkImageViewResamplingEngine resamplingEngine; // Default: NINetworkImageViewResamplingEngineCoreGraphics
+@property (nonatomic, assign) BOOL forcesImageDecoding;  // Default: YES
+@property (nonatomic, assign) BOOL loadsProgressively;   // Default: NO
+@property (nonatomic, assign) NSTimeInterval progressiveUpdateInterval; // Default: 0.25
+@property (nonatomic, assign) BOOL loadsAnimatedImages;  // Default: NO
+@property (nonatomic, copy) NIImageStyle* imageStyle;    // Default: nil
+@property (nonatomic, copy) NSArray* imageProcessors;    // Default: nil
+@property (nonatomic, copy) NINetworkImagePathVariantBlock pathVariantBlock; // Default: nil
 
 #pragma mark Configurable Properties
 
 @property (nonatomic, strong) NIImageMemoryCache* imageMemoryCache;    // Default: [Nimbus imageMemoryCache]
 @property (nonatomic, strong) NSOperationQueue* networkOperationQueue; // Default: [Nimbus networkOperationQueue]
+@property (nonatomic, strong) NIBloomFilter* failedPathFilter;         // Default: [Nimbus failedNetworkPathFilter]
+@property (nonatomic, strong) NIDiskCache* processedImageDiskCache;    // Default: [Nimbus processedImageDiskCache]
+@property (nonatomic, strong) NIDiskCache* responseDiskCache;          // Default: nil
+@property (nonatomic, assign) NINetworkImageTransport transport;       // Default: NINetworkImageTransportOperation
+@property (nonatomic, strong) NIImagePipeline* imagePipeline;          // Default: [NIImagePipeline sharedPipeline]
+@property (nonatomic, strong) NIImageTable* imageTable;                // Default: nil
+@property (nonatomic, strong) NIMemoryCache* placeholderMemoryCache;   // Default: nil
+@property (nonatomic, assign) NSOperationQueuePriority networkOperationPriority; // Default: NSOperationQueuePriorityNormal
+@property (nonatomic, assign) CGFloat maxScrollSpeedForImageCommits;   // Default: 0 (no limit)
 
 @property (nonatomic, assign) NSTimeInterval maxAge;     // Default: 0
 
@@ -137,6 +170,13 @@ typedef enum {
  */
 - (void)networkImageView:(NINetworkImageView *)imageView didLoadImage:(UIImage *)image;
 
+/**
+ * A partial image has been displayed while the download continues.
+ *
+ * Only sent when loadsProgressively is enabled.
+ */
+- (void)networkImageView:(NINetworkImageView *)imageView didLoadPartialImage:(UIImage *)image;
+
 /**
  * The asynchronous download failed.
  */
@@ -408,9 +448,185 @@ typedef enum {
  * @fn NINetworkImageView::interpolationQuality
  */
 
+/**
+ * The engine used to resample the image to its display size.
+ *
+ * NINetworkImageViewResamplingEngineVImage scales premultiplied pixel buffers with the
+ * Accelerate framework instead of drawing through a CoreGraphics bitmap context. It is
+ * generally faster on older devices. If vImage is unable to process an image then the
+ * CoreGraphics engine is used instead.
+ *
+ * The default value is NINetworkImageViewResamplingEngineCoreGraphics.
+ *
+ * @see NINetworkImageViewResamplingEngine
+ * @fn NINetworkImageView::resamplingEngine
+ */
+
+/**
+ * Whether images are decoded on a background thread before they are cached and displayed.
+ *
+ * Images that have not been decoded are decompressed the first time they are drawn, which
+ * happens on the main thread and can drop frames while scrolling. When this is enabled, images
+ * that were not already resized for display are drawn into a display-native bitmap first, as
+ * are the images produced by custom NINetworkImageOperation objects.
+ *
+ * Set this to NO if your operations already produce decoded images.
+ *
+ * By default this is YES.
+ *
+ * @fn NINetworkImageView::forcesImageDecoding
+ */
+
+/**
+ * Whether partially downloaded images are shown while the rest of the image arrives.
+ *
+ * When enabled, the bytes received so far are decoded on a background queue as the download
+ * progresses, and each partial image is cropped and resized like the final image. Progressive
+ * JPEGs become sharper with each frame, while other formats fill in from the top. Partial
+ * images are never stored in the memory cache.
+ *
+ * This is most useful for large images on slow connections.
+ *
+ * By default this is NO.
+ *
+ * @see NIProgressiveImageDecoder
+ * @fn NINetworkImageView::loadsProgressively
+ */
+
+/**
+ * The least amount of time between two partial images when loading progressively.
+ *
+ * Each partial image decodes everything that has arrived so far, so updating too often wastes
+ * CPU time on slow devices.
+ *
+ * By default this is 0.25 seconds.
+ *
+ * @fn NINetworkImageView::progressiveUpdateInterval
+ */
+
+/**
+ * Whether animated images are loaded and played.
+ *
+ * When enabled, images with more than one frame are loaded as NIAnimatedImage objects. Only
+ * the first frame is decoded up front. The rest are decoded a few at a time on a background
+ * queue while the image view plays them, driven by a CADisplayLink while the view is in a
+ * window. Each frame is cropped and resized like a still image would be.
+ *
+ * Animated images are charged to the memory cache by their NIAnimatedImage::memoryCost. They
+ * are not stored in the processedImageDiskCache or the imageTable, both of which only hold
+ * a single frame.
+ *
+ * When disabled, only the first frame of an animated image is shown.
+ *
+ * By default this is NO.
+ *
+ * @fn NINetworkImageView::loadsAnimatedImages
+ */
+
+/**
+ * Corners, a border and a background to draw into the image once it has been processed.
+ *
+ * Use this rather than layer.cornerRadius and masksToBounds, which make Core Animation render
+ * every such image view offscreen while it scrolls. The style is drawn on the same background
+ * queue that resizes the image, so the image view has nothing left to composite. When the
+ * style's background color is opaque, the image is opaque too and the view can be marked
+ * opaque.
+ *
+ * The style is part of the memory cache key, so changing it loads the image again.
+ *
+ * By default this is nil.
+ *
+ * @see NIImageStyle
+ * @fn NINetworkImageView::imageStyle
+ */
+
+/**
+ * Objects conforming to NIImageProcessor that are run, in order, on the image once it has been
+ * cropped, resized and styled.
+ *
+ * Use processors for effects such as blurs and tints that would otherwise require subclassing.
+ * The processed image is what gets cached: the processors' identifiers are part of the memory
+ * cache key, so image views with different processors cache their images separately, while
+ * still sharing the download and any common leading processors.
+ *
+ * Partial images are not shown while processors are set, and animated images are not
+ * processed.
+ *
+ * By default this is nil.
+ *
+ * @see NIImagePipeline
+ * @fn NINetworkImageView::imageProcessors
+ */
+
+/**
+ * Picks which of the server's renditions of an image to download.
+ *
+ * Image servers and CDNs often serve each image at many widths. When this block is set, every
+ * path given to setPathToNetworkImage:forDisplaySize:contentMode:cropRect: is passed to it along
+ * with the display size multiplied by the screen scale. The block returns the path of the
+ * smallest rendition that is at least that large, usually by filling in a URL template, and
+ * that path is downloaded instead. Returning nil keeps the original path.
+ *
+ * The chosen path is the image's cache identifier, so images of different renditions never
+ * share cache entries, and views that choose the same rendition share one download.
+ *
+@code
+imageView.pathVariantBlock = ^NSString *(NSString* path, CGSize pixelSize) {
+  // Widths offered by the image server.
+  static const NSInteger widths[] = {64, 128, 256, 512, 1024};
+  NSInteger width = widths[4];
+  for (NSInteger ix = 0; ix < 5; ++ix) {
+    if (widths[ix] >= pixelSize.width) {
+      width = widths[ix];
+      break;
+    }
+  }
+  return [path stringByAppendingFormat:@"?w=%ld", (long)width];
+};
+@endcode
+ *
+ * The block is called on the main thread. The image is still resized for display locally, so
+ * the rendition only needs to be large enough.
+ *
+ * By default this is nil.
+ *
+ * @fn NINetworkImageView::pathVariantBlock
+ */
+
 
 /** @name Configurable Properties */
 
+/**
+ * How image requests reach the network.
+ *
+ * - NINetworkImageTransportOperation runs each request on its own NSURLConnection.
+ * - NINetworkImageTransportSession runs requests as tasks of
+ *   [NINetworkImageSession sharedSession], which shares connections and TLS sessions between
+ *   requests to the same host and can use HTTP/2 where the server supports it.
+ * - NINetworkImageTransportBackgroundSession runs requests as download tasks of
+ *   [NINetworkImageSession sharedBackgroundSession], which keep running after the app is
+ *   suspended. Background transfers don't report partial data, so loadsProgressively has no
+ *   effect with this transport. Meant for prefetching; see NINetworkImagePrefetcher.
+ *
+ * Every transport is scheduled by the networkOperationQueue and the NINetworkImageScheduler, and
+ * follows the effective network operation priority of the image view. Before iOS 7 there is no
+ * NSURLSession, so the session transports fall back to NINetworkImageTransportOperation.
+ *
+ * By default this is NINetworkImageTransportOperation.
+ *
+ * @fn NINetworkImageView::transport
+ */
+
+/**
+ * The pipeline that runs the imageProcessors.
+ *
+ * Create a pipeline with a queue of your own to control how much processing may run at once.
+ *
+ * By default this is [NIImagePipeline sharedPipeline].
+ *
+ * @fn NINetworkImageView::imagePipeline
+ */
+
 
 /**
  * The image memory cache used by this image view to store the image in memory.
@@ -461,11 +677,141 @@ typedef enum {
  * @fn NINetworkImageView::networkOperationQueue
  */
 
+/**
+ * The filter of network paths that recently failed to load.
+ *
+ * Paths that fail to load are added to this filter. Setting a path that the filter contains
+ * fails right away with NIPathFailedRecently instead of requesting the image again, until the
+ * filter's retention interval has passed. Only failures that would happen again are added:
+ * 404 and 410 responses and images that can't be decoded. Timeouts, going offline, server
+ * errors and cancelled requests are not.
+ *
+ * Because the filter is a Bloom filter, a path that never failed is very rarely treated as
+ * though it had. Use a filter with a lower false positive rate if that is a concern.
+ *
+ * By default this is [Nimbus failedNetworkPathFilter].
+ *
+ * @attention Setting this to nil will request every path no matter how recently it failed.
+ *
+ * @see Nimbus::failedNetworkPathFilter
+ * @fn NINetworkImageView::failedPathFilter
+ */
+
+/**
+ * The disk cache that keeps processed images between launches.
+ *
+ * When an image isn't in the memory cache the view checks this cache before making a network
+ * request. Images are stored after they have been cropped, resized and decoded, so an image read
+ * back from disk is mapped straight into memory and displayed without any further processing.
+ *
+ * Images are only written to disk when maxAge is 0 because the disk cache does not expire its
+ * contents.
+ *
+ * @attention Setting this to nil will disable the disk cache for this image view.
+ *
+ * @see Nimbus::processedImageDiskCache
+ * @fn NINetworkImageView::processedImageDiskCache
+ */
+
+/**
+ * The disk cache that response bodies are streamed into as they download.
+ *
+ * Full resolution photos are usually displayed far smaller than they were encoded. Without
+ * this cache each download is held in memory in its entirety until it has been decoded. With
+ * it, requests made through the session transports append each chunk of the body to a file in
+ * this cache as it arrives, and the image is decoded straight to the display size from the
+ * file mapped into memory. The peak memory of a download is then bounded by the decoded image
+ * rather than by the size of the payload. NINetworkImageTransportOperation still downloads
+ * into memory.
+ *
+ * Bodies are stored under the absolute string of the image's URL once the image has been
+ * decoded. A later request for the same URL at any display size is decoded from this cache
+ * instead of being downloaded again, so give the cache a maxNumberOfBytes.
+ *
+ * Like the processedImageDiskCache, this is only used when maxAge is 0.
+ *
+ * @fn NINetworkImageView::responseDiskCache
+ */
+
+/**
+ * An image table that keeps processed images of one fixed size.
+ *
+ * Image views with a fixed display size, such as avatars and grid thumbnails, can share an
+ * image table. Processed images that have exactly the table's size and scale are stored in
+ * it, and later requests for them are answered from the table's mapped file before the
+ * memory cache is even consulted, without any file reads or decoding.
+ *
+ * Images of other sizes are ignored by the table.
+ *
+ * By default this is nil.
+ *
+ * @fn NINetworkImageView::imageTable
+ */
+
+/**
+ * A cache of placeholders for the images that have been downloaded.
+ *
+ * When this is set, an NIImagePlaceholder is made from each downloaded image on the same
+ * background queue that processes it and is stored under the image's path. Later views of the
+ * same path, at any size, show the placeholder's thumbnail while the image is downloaded
+ * rather than the initialImage. Placeholders are not shown by views with imageProcessors,
+ * because they are made before the processors run.
+ *
+ * Placeholders are tiny, so a cache that holds thousands of them needs well under a megabyte.
+ *
+ * By default this is nil.
+ *
+ * @fn NINetworkImageView::placeholderMemoryCache
+ */
+
+/**
+ * The queue priority of the network requests made by this image view.
+ *
+ * The priority only applies in full while the image view is in a window. Until then the request
+ * runs at no more than NSOperationQueuePriorityLow, and once the view leaves its window the
+ * request drops to NSOperationQueuePriorityVeryLow. When image views share a request, the
+ * request runs at the highest of their priorities. NINetworkImagePrefetcher uses a low
+ * priority so that prefetches never hold up images that are on screen.
+ *
+ * Requests are handed to the NINetworkImageScheduler, which also limits how many requests run
+ * against each host at once.
+ *
+ * By default this is NSOperationQueuePriorityNormal.
+ *
+ * @fn NINetworkImageView::networkOperationPriority
+ */
+
+/**
+ * The speed, in points per second, above which the enclosing scroll view holds back images
+ * that have finished loading.
+ *
+ * Every image that arrives during a fling is set, along with whatever the delegate and
+ * subclasses do in response, in whichever frame it happens to arrive in. When many cells finish
+ * loading at once those commits land in the same few frames. When this is positive, images that
+ * arrive from the network or the disk while the nearest enclosing scroll view is moving faster
+ * than this are held. They are committed a couple per frame once the scroll view slows down, or
+ * as soon as the user lets go and the scroll view starts decelerating. On each frame the views
+ * nearest the middle of the visible area go first.
+ *
+ * Images found in memory are always shown right away, as are images for views that aren't in a
+ * scroll view. Reusing the view or loading another image drops a held image. A few thousand
+ * points per second is a reasonable limit for table views.
+ *
+ * By default this is 0, which never holds images back.
+ *
+ * @fn NINetworkImageView::maxScrollSpeedForImageCommits
+ */
+
 /**
  * The maximum amount of time that an image will stay in memory after the request completes.
  *
  * A negative value will cause this image to NOT be stored in the memory cache.
  *
+ * Once an image with a positive maxAge expires, the next request for it is made conditional on
+ * the ETag and Last-Modified validators that the server sent with it. If the server responds
+ * with 304 Not Modified, the image that was already processed is stored again with a fresh
+ * lifetime rather than being downloaded and processed again.
+ *
  * By default this is 0.
  *
  * @fn NINetworkImageView::maxAge
@@ -533,6 +879,10 @@ typedef enum {
  * Prepares this view for reuse by cancelling any existing requests and displaying the
  * initial image again.
  *
+ * Image views that request the same image with the same display settings while it is loading
+ * share a single request. The request is only cancelled once every image view waiting on it
+ * has been reused, deallocated or given another path.
+ *
  * @fn NINetworkImageView::prepareForReuse
  */
 
@@ -615,6 +965,10 @@ typedef enum {
  * Loads the image from the memory cache if possible, otherwise fires off a network request
  * with this object's network image information.
  *
+ * Paths that start with / are read straight from the file system on the network operation
+ * queue rather than requested over HTTP. The file is memory-mapped and decoded directly at the
+ * display size.
+ *
  * @param pathToNetworkImage  The network path to the image to be displayed.
  * @param cropRect            x/y, width/height are in percent coordinates.
  *                                 Valid range is [0..1] for all values.
@@ -20,15 +20,488 @@
 
 #import "NimbusCore.h"
 #import "AFNetworking.h"
+#import "NIAnimatedImage.h"
+#import "NIImagePipeline.h"
+#import "NIImagePlaceholder.h"
 #import "NIImageProcessing.h"
 #import "NIImageResponseSerializer.h"
+#import "NIImageStyle.h"
+#import "NINetworkImageCacheKey.h"
+#import "NINetworkImageScheduler.h"
+#import "NINetworkImageSession.h"
+#import "NIProgressiveImageDecoder.h"
+
+#import <QuartzCore/QuartzCore.h>
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "Nimbus requires ARC support."
 #endif
 
+// A network request that any number of image views may be waiting on.
+@interface NINetworkImageRequestSubscriber : NSObject
+@property (nonatomic, copy) void (^success)(UIImage* image);
+@property (nonatomic, copy) void (^failure)(NSError* error);
+@property (nonatomic, copy) void (^progress)(NSInteger totalBytesRead, NSInteger totalBytesExpectedToRead);
+@property (nonatomic, copy) void (^partialImage)(UIImage* image);
+@property (nonatomic, assign) NSOperationQueuePriority priority;
+@end
+
+@implementation NINetworkImageRequestSubscriber
+@end
+
+// Keeps its own copy of the bytes received so far for progressive decoding. The operation's
+// output stream is written on the network thread, so it can't be read while the request runs.
+@interface NIProgressiveHTTPRequestOperation : AFHTTPRequestOperation
+- (NSData *)receivedData;
+@end
+
+@implementation NIProgressiveHTTPRequestOperation {
+  NSMutableData* _receivedData;
+}
+
+- (id)initWithRequest:(NSURLRequest *)urlRequest {
+  if ((self = [super initWithRequest:urlRequest])) {
+    _receivedData = [[NSMutableData alloc] init];
+  }
+  return self;
+}
+
+- (void)connection:(NSURLConnection *)connection didReceiveData:(NSData *)data {
+  // Appended before the superclass reports progress, so the snapshot taken in response to the
+  // progress block includes these bytes.
+  @synchronized(_receivedData) {
+    [_receivedData appendData:data];
+  }
+  [super connection:connection didReceiveData:data];
+}
+
+- (NSData *)receivedData {
+  @synchronized(_receivedData) {
+    return [_receivedData copy];
+  }
+}
+
+@end
+
+@interface NINetworkImageRequest : NSObject
+@property (nonatomic, copy) NSString* key;
+// Either an AFHTTPRequestOperation or an NINetworkImageSessionOperation, depending on the
+// transport of the image view that started the request, or an NSBlockOperation for file URLs
+// and responses read from the responseDiskCache.
+@property (nonatomic, strong) NSOperation* operation;
+@property (nonatomic, strong) NSMutableArray* subscribers;
+
+// Only set for progressive requests.
+@property (nonatomic, strong) NIProgressiveImageDecoder* decoder;
+@property (nonatomic, assign) NSTimeInterval partialImageUpdateInterval;
+@property (nonatomic, assign) NSTimeInterval lastPartialImageTime;
+@property (nonatomic, assign) BOOL isDecodingPartialImage;
+@end
+
+@implementation NINetworkImageRequest
+
+// Only touched on the main thread, which is where requests are made and completed.
++ (NSMutableDictionary *)inFlightRequests {
+  static NSMutableDictionary* sRequests = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sRequests = [[NSMutableDictionary alloc] init];
+  });
+  return sRequests;
+}
+
+- (id)init {
+  if ((self = [super init])) {
+    _subscribers = [[NSMutableArray alloc] init];
+  }
+  return self;
+}
+
+- (void)removeFromInFlightRequests {
+  NSMutableDictionary* requests = [[self class] inFlightRequests];
+  if ([requests objectForKey:self.key] == self) {
+    [requests removeObjectForKey:self.key];
+  }
+}
+
+// Cancels the request once nobody is waiting on it any more.
+- (void)removeSubscriber:(NINetworkImageRequestSubscriber *)subscriber {
+  [self.subscribers removeObjectIdenticalTo:subscriber];
+  if (0 == self.subscribers.count) {
+    [self removeFromInFlightRequests];
+    [self.operation cancel];
+  } else {
+    [self updatePriority];
+  }
+}
+
+// Runs the request at the highest priority of the image views waiting on it.
+- (void)updatePriority {
+  if (0 == self.subscribers.count) {
+    return;
+  }
+  NSOperationQueuePriority priority = NSOperationQueuePriorityVeryLow;
+  for (NINetworkImageRequestSubscriber* subscriber in self.subscribers) {
+    priority = MAX(priority, subscriber.priority);
+  }
+  if (self.operation.queuePriority != priority) {
+    self.operation.queuePriority = priority;
+  }
+}
+
+// Partial images for every request are decoded one at a time so that they don't compete with
+// the requests themselves.
++ (dispatch_queue_t)partialImageQueue {
+  static dispatch_queue_t sQueue = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sQueue = dispatch_queue_create("com.nimbuskit.networkimage.partialimages", DISPATCH_QUEUE_SERIAL);
+  });
+  return sQueue;
+}
+
+- (NSData *)receivedData {
+  if ([self.operation isKindOfClass:[NINetworkImageSessionOperation class]]) {
+    return [(NINetworkImageSessionOperation *)self.operation responseData];
+  }
+  if ([self.operation isKindOfClass:[NIProgressiveHTTPRequestOperation class]]) {
+    return [(NIProgressiveHTTPRequestOperation *)self.operation receivedData];
+  }
+  return nil;
+}
+
+// Decodes the bytes that have arrived so far, unless a partial image was decoded too recently
+// or is still being decoded.
+- (void)decodePartialImageIfNeeded {
+  if (nil == self.decoder || self.isDecodingPartialImage) {
+    return;
+  }
+  NSTimeInterval now = [[NSDate date] timeIntervalSinceReferenceDate];
+  if (now - self.lastPartialImageTime < self.partialImageUpdateInterval) {
+    return;
+  }
+  NSData* data = [self receivedData];
+  if (0 == data.length) {
+    return;
+  }
+
+  self.isDecodingPartialImage = YES;
+  self.lastPartialImageTime = now;
+
+  NIProgressiveImageDecoder* decoder = self.decoder;
+  __weak NINetworkImageRequest* weakSelf = self;
+  dispatch_async([[self class] partialImageQueue], ^{
+    UIImage* image = [decoder partialImageWithData:data];
+    dispatch_async(dispatch_get_main_queue(), ^{
+      NINetworkImageRequest* strongSelf = weakSelf;
+      strongSelf.isDecodingPartialImage = NO;
+      if (nil == image) {
+        return;
+      }
+      // Finished requests have no subscribers left, so a late partial image can't replace the
+      // final one.
+      for (NINetworkImageRequestSubscriber* subscriber in [strongSelf.subscribers copy]) {
+        subscriber.partialImage(image);
+      }
+    });
+  });
+}
+
+// Removes the request from the in-flight table and returns the subscribers to notify.
+- (NSArray *)finish {
+  [self removeFromInFlightRequests];
+  NSArray* subscribers = [self.subscribers copy];
+  [self.subscribers removeAllObjects];
+  return subscribers;
+}
+
+@end
+
+// The validators of an image that expires, kept so that the image can be revalidated with a
+// conditional request once it has expired instead of being downloaded and processed again.
+@interface NINetworkImageValidators : NSObject
+@property (nonatomic, strong) UIImage* image;
+@property (nonatomic, copy) NSString* entityTag;
+@property (nonatomic, copy) NSString* lastModified;
+@end
+
+// Bounds the memory held by images that have expired from every image memory cache but may
+// still be revalidated.
+static const NSUInteger kNINetworkImageValidatorsCostLimit = 4 * 1024 * 1024;
+
+@implementation NINetworkImageValidators
+
+// Keyed by memory cache name. NSCache is thread-safe and lets go of entries under memory
+// pressure on its own.
++ (NSCache *)validatorsCache {
+  static NSCache* sCache = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sCache = [[NSCache alloc] init];
+    sCache.totalCostLimit = kNINetworkImageValidatorsCostLimit;
+  });
+  return sCache;
+}
+
++ (NINetworkImageValidators *)validatorsWithResponse:(NSHTTPURLResponse *)response image:(UIImage *)image {
+  NSDictionary* headers = response.allHeaderFields;
+  NSString* entityTag = headers[@"ETag"];
+  NSString* lastModified = headers[@"Last-Modified"];
+  if (nil == image || (nil == entityTag && nil == lastModified)) {
+    return nil;
+  }
+  NINetworkImageValidators* validators = [[self alloc] init];
+  validators.image = image;
+  validators.entityTag = entityTag;
+  validators.lastModified = lastModified;
+  return validators;
+}
+
+- (NSUInteger)cost {
+  CGImageRef imageRef = self.image.CGImage;
+  return (NULL != imageRef) ? CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef) : 0;
+}
+
+- (void)addToRequest:(NSMutableURLRequest *)request {
+  if (nil != self.entityTag) {
+    [request setValue:self.entityTag forHTTPHeaderField:@"If-None-Match"];
+  }
+  if (nil != self.lastModified) {
+    [request setValue:self.lastModified forHTTPHeaderField:@"If-Modified-Since"];
+  }
+  // The conditional headers are ours, so keep the URL cache from answering on its own.
+  request.cachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
+}
+
+@end
+
+// How many held images are committed per frame once their scroll view allows it.
+static const NSUInteger kNINetworkImageCommitBatchSize = 2;
+
+// An image that arrived while its scroll view was moving too fast to show it.
+@interface NINetworkImagePendingCommit : NSObject
+@property (nonatomic, strong) NINetworkImageView* imageView;
+@property (nonatomic, weak) UIScrollView* scrollView;
+@property (nonatomic, assign) CGFloat maxScrollSpeed;
+@property (nonatomic, copy) void (^block)(void);
+// Set once the scroll view starts decelerating, after which the commit no longer waits for
+// the scroll view to slow down.
+@property (nonatomic, assign) BOOL isReleased;
+@end
+
+@implementation NINetworkImagePendingCommit
+@end
+
+// The motion of a scroll view with pending commits, sampled once per frame.
+@interface NINetworkImageScrollSample : NSObject
+@property (nonatomic, assign) CGPoint contentOffset;
+@property (nonatomic, assign) CFTimeInterval timestamp;
+@property (nonatomic, assign) CGFloat speed;
+@property (nonatomic, assign) BOOL wasDecelerating;
+@end
+
+@implementation NINetworkImageScrollSample
+@end
+
+// Holds images for image views in scroll views that are moving faster than the views allow,
+// and commits them a few per frame, visible views first, once their scroll view slows down or
+// starts decelerating. Only used on the main thread.
+@interface NINetworkImageCommitQueue : NSObject
++ (NINetworkImageCommitQueue *)sharedQueue;
+- (void)addCommitForImageView:(NINetworkImageView *)imageView
+                   scrollView:(UIScrollView *)scrollView
+               maxScrollSpeed:(CGFloat)maxScrollSpeed
+                        block:(void (^)(void))block;
+- (void)removeCommitsForImageView:(NINetworkImageView *)imageView;
+@end
+
+@implementation NINetworkImageCommitQueue {
+  NSMutableArray* _commits;
+  NSMapTable* _samplesByScrollView;
+  CADisplayLink* _displayLink;
+}
+
++ (NINetworkImageCommitQueue *)sharedQueue {
+  static NINetworkImageCommitQueue* sQueue = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sQueue = [[NINetworkImageCommitQueue alloc] init];
+  });
+  return sQueue;
+}
+
+- (id)init {
+  if ((self = [super init])) {
+    _commits = [[NSMutableArray alloc] init];
+    _samplesByScrollView = [NSMapTable weakToStrongObjectsMapTable];
+  }
+  return self;
+}
+
+- (void)addCommitForImageView:(NINetworkImageView *)imageView
+                   scrollView:(UIScrollView *)scrollView
+               maxScrollSpeed:(CGFloat)maxScrollSpeed
+                        block:(void (^)(void))block {
+  // A scroll view at rest can't be moving too fast. One that is moving is sampled for a frame
+  // first, because its speed can only be measured between frames.
+  if (nil == scrollView || !(scrollView.isDragging || scrollView.isDecelerating)) {
+    block();
+    return;
+  }
+  [self removeCommitsForImageView:imageView];
+
+  NINetworkImagePendingCommit* commit = [[NINetworkImagePendingCommit alloc] init];
+  commit.imageView = imageView;
+  commit.scrollView = scrollView;
+  commit.maxScrollSpeed = maxScrollSpeed;
+  commit.block = block;
+  [_commits addObject:commit];
+
+  if (nil == [_samplesByScrollView objectForKey:scrollView]) {
+    NINetworkImageScrollSample* sample = [[NINetworkImageScrollSample alloc] init];
+    sample.contentOffset = scrollView.contentOffset;
+    sample.timestamp = CACurrentMediaTime();
+    // Unknown until the next frame, so the commit waits for it.
+    sample.speed = CGFLOAT_MAX;
+    sample.wasDecelerating = scrollView.isDecelerating;
+    [_samplesByScrollView setObject:sample forKey:scrollView];
+  }
+
+  if (nil == _displayLink) {
+    // The queue lives forever, so the display link retaining it is fine.
+    _displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(displayDidRefresh:)];
+    // Common modes keep the display link firing while a scroll view is being tracked.
+    [_displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+  }
+}
+
+- (void)removeCommitsForImageView:(NINetworkImageView *)imageView {
+  if (0 == _commits.count) {
+    return;
+  }
+  NSIndexSet* indexes = [_commits indexesOfObjectsPassingTest:^BOOL(NINetworkImagePendingCommit* commit, NSUInteger ix, BOOL* stop) {
+    return commit.imageView == imageView;
+  }];
+  [_commits removeObjectsAtIndexes:indexes];
+  [self stopIfIdle];
+}
+
+- (void)stopIfIdle {
+  if (0 == _commits.count) {
+    [_displayLink invalidate];
+    _displayLink = nil;
+    [_samplesByScrollView removeAllObjects];
+  }
+}
+
+- (void)sampleScrollViewsAtTime:(CFTimeInterval)timestamp {
+  for (UIScrollView* scrollView in [[_samplesByScrollView keyEnumerator] allObjects]) {
+    NINetworkImageScrollSample* sample = [_samplesByScrollView objectForKey:scrollView];
+    CGPoint contentOffset = scrollView.contentOffset;
+    CFTimeInterval elapsed = timestamp - sample.timestamp;
+    if (!(scrollView.isDragging || scrollView.isDecelerating)) {
+      sample.speed = 0;
+    } else if (elapsed > 0) {
+      CGFloat dx = contentOffset.x - sample.contentOffset.x;
+      CGFloat dy = contentOffset.y - sample.contentOffset.y;
+      sample.speed = (CGFloat)(sqrt(dx * dx + dy * dy) / elapsed);
+    }
+    sample.contentOffset = contentOffset;
+    sample.timestamp = timestamp;
+
+    // The user has let go, so what's on screen now is about to be looked at.
+    if (scrollView.isDecelerating && !sample.wasDecelerating) {
+      for (NINetworkImagePendingCommit* commit in _commits) {
+        if (commit.scrollView == scrollView) {
+          commit.isReleased = YES;
+        }
+      }
+    }
+    sample.wasDecelerating = scrollView.isDecelerating;
+  }
+}
+
+// Views that are on screen come first, nearest the middle of the scroll view first.
+- (CGFloat)distanceOfCommitFromVisibleCenter:(NINetworkImagePendingCommit *)commit {
+  UIScrollView* scrollView = commit.scrollView;
+  NINetworkImageView* imageView = commit.imageView;
+  if (nil == scrollView || nil == imageView.window) {
+    return CGFLOAT_MAX;
+  }
+  CGRect frame = [imageView convertRect:imageView.bounds toView:scrollView];
+  CGRect visibleBounds = scrollView.bounds;
+  if (!CGRectIntersectsRect(frame, visibleBounds)) {
+    return CGFLOAT_MAX / 2;
+  }
+  CGFloat dx = CGRectGetMidX(frame) - CGRectGetMidX(visibleBounds);
+  CGFloat dy = CGRectGetMidY(frame) - CGRectGetMidY(visibleBounds);
+  return (CGFloat)sqrt(dx * dx + dy * dy);
+}
+
+- (void)displayDidRefresh:(CADisplayLink *)displayLink {
+  [self sampleScrollViewsAtTime:displayLink.timestamp];
+
+  NSMutableArray* readyCommits = [NSMutableArray array];
+  for (NINetworkImagePendingCommit* commit in _commits) {
+    UIScrollView* scrollView = commit.scrollView;
+    NINetworkImageScrollSample* sample = (nil != scrollView) ? [_samplesByScrollView objectForKey:scrollView] : nil;
+    if (nil == sample || commit.isReleased || sample.speed <= commit.maxScrollSpeed) {
+      [readyCommits addObject:commit];
+    }
+  }
+  if (readyCommits.count > kNINetworkImageCommitBatchSize) {
+    NSMutableDictionary* distances = [NSMutableDictionary dictionaryWithCapacity:readyCommits.count];
+    for (NINetworkImagePendingCommit* commit in readyCommits) {
+      distances[[NSValue valueWithNonretainedObject:commit]] = @([self distanceOfCommitFromVisibleCenter:commit]);
+    }
+    [readyCommits sortWithOptions:NSSortStable usingComparator:^NSComparisonResult(id commit1, id commit2) {
+      return [distances[[NSValue valueWithNonretainedObject:commit1]]
+              compare:distances[[NSValue valueWithNonretainedObject:commit2]]];
+    }];
+    [readyCommits removeObjectsInRange:NSMakeRange(kNINetworkImageCommitBatchSize,
+                                                   readyCommits.count - kNINetworkImageCommitBatchSize)];
+  }
+
+  // Committing may start new loads, which add or remove commits of their own.
+  [_commits removeObjectsInArray:readyCommits];
+  for (NINetworkImagePendingCommit* commit in readyCommits) {
+    commit.block();
+  }
+  [self stopIfIdle];
+}
+
+@end
+
+// CADisplayLink retains its target, so the image view is only referenced weakly to let it be
+// deallocated while an animation is playing.
+@interface NINetworkImageViewDisplayLinkTarget : NSObject
+@property (nonatomic, weak) NINetworkImageView* imageView;
+@end
+
 @interface NINetworkImageView()
 @property (nonatomic, strong) NSOperation* operation;
+@property (nonatomic, strong) NINetworkImageRequest* request;
+@property (nonatomic, strong) NINetworkImageRequestSubscriber* requestSubscriber;
+@property (nonatomic, assign) BOOL didLeaveWindow;
+// Identifies the pending disk or variant lookup. Cleared when the view moves on to another image.
+@property (nonatomic, strong) NSObject* cacheLookup;
+
+// Animation state, only used while an NIAnimatedImage is being displayed.
+@property (nonatomic, strong) CADisplayLink* animationDisplayLink;
+@property (nonatomic, strong) UIImage* animationFrame;
+@property (nonatomic, assign) NSUInteger animationFrameIndex;
+@property (nonatomic, assign) NSUInteger animationLoopCount;
+@property (nonatomic, assign) NSTimeInterval animationFrameTime;
+
+- (void)displayDidRefresh:(CADisplayLink *)displayLink;
+@end
+
+@implementation NINetworkImageViewDisplayLinkTarget
+
+- (void)displayDidRefresh:(CADisplayLink *)displayLink {
+  [self.imageView displayDidRefresh:displayLink];
+}
+
 @end
 
 
@@ -37,6 +510,16 @@
 
 
 - (void)cancelOperation {
+  self.cacheLookup = nil;
+  [[NINetworkImageCommitQueue sharedQueue] removeCommitsForImageView:self];
+  if (nil != self.request) {
+    // Other image views may still be waiting on this request, so only stop waiting on it.
+    [self.request removeSubscriber:self.requestSubscriber];
+    self.request = nil;
+    self.requestSubscriber = nil;
+    self.operation = nil;
+    return;
+  }
   if ([self.operation isKindOfClass:[NIOperation class]]) {
     NIOperation* request = (NIOperation *)self.operation;
     // Clear the delegate so that we don't receive a didFail notification when we cancel the
@@ -47,6 +530,7 @@
 }
 
 - (void)dealloc {
+  [_animationDisplayLink invalidate];
   [self cancelOperation];
 }
 
@@ -54,9 +538,19 @@
   self.sizeForDisplay = YES;
   self.scaleOptions = NINetworkImageViewScaleToFitLeavesExcessAndScaleToFillCropsExcess;
   self.interpolationQuality = kCGInterpolationDefault;
+  self.resamplingEngine = NINetworkImageViewResamplingEngineCoreGraphics;
+  self.forcesImageDecoding = YES;
+  self.loadsProgressively = NO;
+  self.progressiveUpdateInterval = 0.25;
+  self.loadsAnimatedImages = NO;
+  self.imagePipeline = [NIImagePipeline sharedPipeline];
+  self.transport = NINetworkImageTransportOperation;
 
   self.imageMemoryCache = [Nimbus imageMemoryCache];
   self.networkOperationQueue = [Nimbus networkOperationQueue];
+  self.failedPathFilter = [Nimbus failedNetworkPathFilter];
+  self.processedImageDiskCache = [Nimbus processedImageDiskCache];
+  self.networkOperationPriority = NSOperationQueuePriorityNormal;
 }
 
 - (id)initWithImage:(UIImage *)image {
@@ -90,27 +584,50 @@
   return [self initWithImage:nil];
 }
 
-- (NSString *)cacheKeyForCacheIdentifier:(NSString *)cacheIdentifier
-                               imageSize:(CGSize)imageSize
-                                cropRect:(CGRect)cropRect
-                             contentMode:(UIViewContentMode)contentMode
-                            scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions {
-  NIDASSERT(NIIsStringWithAnyText(cacheIdentifier));
-
-  NSString* cacheKey = cacheIdentifier;
+- (NINetworkImageCacheKey *)cacheKeyForCacheIdentifier:(NSString *)cacheIdentifier
+                                              imageSize:(CGSize)imageSize
+                                               cropRect:(CGRect)cropRect
+                                            contentMode:(UIViewContentMode)contentMode
+                                           scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions {
+  return [[NINetworkImageCacheKey alloc] initWithCacheIdentifier:cacheIdentifier
+                                                     displaySize:imageSize
+                                                        cropRect:cropRect
+                                                     contentMode:contentMode
+                                                    scaleOptions:scaleOptions
+                                                  sizeForDisplay:self.sizeForDisplay
+                                                           style:self.imageStyle
+                                             processorIdentifier:[NIImagePipeline identifierForProcessors:self.imageProcessors]];
+}
 
-  // Append the size to the key. This allows us to differentiate cache keys by image dimension.
-  // If the display size ever changes, we want to ensure that we're fetching the correct image
-  // from the cache.
-  if (self.sizeForDisplay) {
-    cacheKey = [cacheKey stringByAppendingFormat:@"%@%@{%@,%@}",
-                NSStringFromCGSize(imageSize), NSStringFromCGRect(cropRect), [@(contentMode) stringValue], [@(scaleOptions) stringValue]];
+// Runs the image through the image processors. The name identifies the image as it is before
+// processing, so that image views sharing a prefix of processors share its results.
+- (void)processImage:(UIImage *)image withName:(NSString *)name completion:(void (^)(UIImage* image))completion {
+  NSArray* processors = self.imageProcessors;
+  // Processors work on a single bitmap, so animated images are passed through untouched.
+  if (0 == processors.count || nil == self.imagePipeline || nil == image
+      || [image isKindOfClass:[NIAnimatedImage class]]) {
+    completion(image);
+    return;
   }
+  [self.imagePipeline processImage:image withName:name processors:processors completion:completion];
+}
 
-  // The resulting cache key will look like:
-  // /path/to/image({width,height}{contentMode,cropImageForDisplay})
+- (NSString *)cacheNameForKey:(NINetworkImageCacheKey *)cacheKey {
+  // The memory cache remembers the names of the keys it has seen recently.
+  return (nil != self.imageMemoryCache
+          ? [self.imageMemoryCache nameForKey:cacheKey]
+          : [cacheKey memoryCacheName]);
+}
 
-  return cacheKey;
+// Lets lookups for smaller sizes of this image scale it down rather than load it again.
+- (void)addVariantWithKey:(NINetworkImageCacheKey *)cacheKey image:(UIImage *)image {
+  NSString* variantGroupName = cacheKey.variantGroupName;
+  if (nil == variantGroupName || [image isKindOfClass:[NIAnimatedImage class]]) {
+    return;
+  }
+  [self.imageMemoryCache addVariantWithName:[self cacheNameForKey:cacheKey]
+                                       size:cacheKey.displaySize
+                                    toGroup:variantGroupName];
 }
 
 - (NSDate *)expirationDate {
@@ -135,20 +652,74 @@
                        contentMode:(UIViewContentMode)contentMode
                       scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions
                     expirationDate:(NSDate *)expirationDate {
+  [self _storeLoadedImage:image
+          cacheIdentifier:cacheIdentifier
+              displaySize:displaySize
+                 cropRect:cropRect
+              contentMode:contentMode
+             scaleOptions:scaleOptions
+           expirationDate:expirationDate];
+  [self _displayLoadedImage:image];
+}
+
+// Stores a loaded image in the caches. Kept apart from displaying it so that an image whose
+// display is held back by the commit queue is cached even if the view moves on before then.
+- (void)_storeLoadedImage:(UIImage *)image
+          cacheIdentifier:(NSString *)cacheIdentifier
+              displaySize:(CGSize)displaySize
+                 cropRect:(CGRect)cropRect
+              contentMode:(UIViewContentMode)contentMode
+             scaleOptions:(NINetworkImageViewScaleOptions)scaleOptions
+           expirationDate:(NSDate *)expirationDate {
+  NINetworkImageCacheKey* cacheKey = [self cacheKeyForCacheIdentifier:cacheIdentifier
+                                                            imageSize:displaySize
+                                                             cropRect:cropRect
+                                                          contentMode:contentMode
+                                                         scaleOptions:scaleOptions];
+
   // Store the result image in the memory cache.
   if (nil != self.imageMemoryCache && nil != image) {
-    NSString* cacheKey = [self cacheKeyForCacheIdentifier:cacheIdentifier
-                                                imageSize:displaySize
-                                                 cropRect:cropRect
-                                              contentMode:contentMode
-                                             scaleOptions:scaleOptions];
-
-    // Store the image in the memory cache, possibly with an expiration date.
+    // Store the image in the memory cache, possibly with an expiration date. Animated images
+    // know better than the cache how many of their frames will be decoded.
+    unsigned long long cost = 0;
+    if ([image isKindOfClass:[NIAnimatedImage class]]) {
+      cost = [(NIAnimatedImage *)image memoryCost];
+    }
     [self.imageMemoryCache storeObject: image
-                              withName: cacheKey
-                          expiresAfter: expirationDate];
+                               withKey: cacheKey
+                          expiresAfter: expirationDate
+                                  cost: cost];
+    [self addVariantWithKey:cacheKey image:image];
+  }
+
+  // The disk cache and the image table would only keep the first frame.
+  BOOL isAnimated = [image isKindOfClass:[NIAnimatedImage class]];
+
+  // Image tables only hold images of exactly their size.
+  NIImageTable* imageTable = self.imageTable;
+  if (nil != imageTable && nil != image && !isAnimated && 0 == self.maxAge
+      && CGSizeEqualToSize(image.size, imageTable.imageSize) && image.scale == imageTable.scale) {
+    NSString* imageTableName = [self cacheNameForKey:cacheKey];
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+      [imageTable storeImage:image withName:imageTableName];
+    });
   }
 
+  // The disk cache has no notion of expiration, so only images that never expire are kept on
+  // disk.
+  NIDiskCache* diskCache = self.processedImageDiskCache;
+  if (nil != diskCache && nil != image && !isAnimated && 0 == self.maxAge) {
+    NSString* diskCacheName = [self cacheNameForKey:cacheKey];
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+      NSData* data = [NIImageProcessing mappableDataFromImage:image];
+      if (nil != data) {
+        [diskCache storeData:data withName:diskCacheName];
+      }
+    });
+  }
+}
+
+- (void)_displayLoadedImage:(UIImage *)image {
   if (nil != image) {
     // Display the new image.
     [self setImage:image];
@@ -187,13 +758,46 @@
   if (operation.isCancelled || operation != self.operation) {
     return;
   }
-  [self _didFinishLoadingWithImage:operation.imageCroppedAndSizedForDisplay
-                   cacheIdentifier:operation.cacheIdentifier
-                       displaySize:operation.imageDisplaySize
-                          cropRect:operation.imageCropRect
-                       contentMode:operation.imageContentMode
-                      scaleOptions:operation.scaleOptions
-                    expirationDate:[self expirationDate]];
+  UIImage* image = operation.imageCroppedAndSizedForDisplay;
+  if (!self.forcesImageDecoding || nil == image) {
+    [self didFinishOperation:operation withImage:image];
+    return;
+  }
+
+  // Custom operations make no promises about how their images are stored, so decode the image
+  // off of the main thread before it is cached and displayed.
+  __weak NINetworkImageView* weakSelf = self;
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    UIImage* decodedImage = [NIImageProcessing decodedImageFromImage:image];
+    dispatch_async(dispatch_get_main_queue(), ^{
+      NINetworkImageView* strongSelf = weakSelf;
+      if (operation.isCancelled || operation != strongSelf.operation) {
+        return;
+      }
+      [strongSelf didFinishOperation:operation withImage:decodedImage];
+    });
+  });
+}
+
+- (void)didFinishOperation:(NIOperation<NINetworkImageOperation> *)operation withImage:(UIImage *)image {
+  NSString* sourceName = [NSString stringWithFormat:@"%@%@%@{%@,%@}",
+                          operation.cacheIdentifier, NSStringFromCGSize(operation.imageDisplaySize),
+                          NSStringFromCGRect(operation.imageCropRect),
+                          [@(operation.imageContentMode) stringValue], [@(operation.scaleOptions) stringValue]];
+  __weak NINetworkImageView* weakSelf = self;
+  [self processImage:image withName:sourceName completion:^(UIImage* processedImage) {
+    NINetworkImageView* strongSelf = weakSelf;
+    if (operation.isCancelled || operation != strongSelf.operation) {
+      return;
+    }
+    [strongSelf _didFinishLoadingWithImage:processedImage
+                           cacheIdentifier:operation.cacheIdentifier
+                               displaySize:operation.imageDisplaySize
+                                  cropRect:operation.imageCropRect
+                               contentMode:operation.imageContentMode
+                              scaleOptions:operation.scaleOptions
+                            expirationDate:[strongSelf expirationDate]];
+  }];
 }
 
 - (void)nimbusOperationDidFail:(NIOperation *)operation withError:(NSError *)error {
@@ -257,6 +861,29 @@
   [self cancelOperation];
 
   if (NIIsStringWithAnyText(pathToNetworkImage)) {
+    // We explicitly do not allow negative display sizes. Check the call stack to figure
+    // out who is providing a negative display size. It's possible that displaySize is an
+    // uninitialized CGSize structure.
+    NIDASSERT(displaySize.width >= 0);
+    NIDASSERT(displaySize.height >= 0);
+    
+    // If an invalid display size IS provided, use the image view's frame instead.
+    if (0 >= displaySize.width || 0 >= displaySize.height) {
+      displaySize = self.frame.size;
+    }
+
+    // Download the server's smallest rendition that covers the display size. The chosen path
+    // identifies the image from here on, so it is also what the image is cached under.
+    if (nil != self.pathVariantBlock) {
+      CGFloat scale = NIScreenScale();
+      NSString* variantPath = self.pathVariantBlock(pathToNetworkImage,
+                                                    CGSizeMake(displaySize.width * scale,
+                                                               displaySize.height * scale));
+      if (NIIsStringWithAnyText(variantPath)) {
+        pathToNetworkImage = variantPath;
+      }
+    }
+
     NSURL* url = nil;
 
     // Check for file URLs.
@@ -273,28 +900,26 @@
     if (nil == url) {
       return;
     }
-    // We explicitly do not allow negative display sizes. Check the call stack to figure
-    // out who is providing a negative display size. It's possible that displaySize is an
-    // uninitialized CGSize structure.
-    NIDASSERT(displaySize.width >= 0);
-    NIDASSERT(displaySize.height >= 0);
-    
-    // If an invalid display size IS provided, use the image view's frame instead.
-    if (0 >= displaySize.width || 0 >= displaySize.height) {
-      displaySize = self.frame.size;
-    }
-    
+
     UIImage* image = nil;
     
     // Attempt to load the image from memory first.
-    NSString* cacheKey = nil;
-    if (nil != self.imageMemoryCache) {
-      cacheKey = [self cacheKeyForCacheIdentifier:pathToNetworkImage
-                                        imageSize:displaySize
-                                         cropRect:cropRect
-                                      contentMode:contentMode
-                                     scaleOptions:self.scaleOptions];
-      image = [self.imageMemoryCache objectWithName:cacheKey];
+    NINetworkImageCacheKey* cacheKey = [self cacheKeyForCacheIdentifier:pathToNetworkImage
+                                                              imageSize:displaySize
+                                                               cropRect:cropRect
+                                                            contentMode:contentMode
+                                                           scaleOptions:self.scaleOptions];
+    if (nil != self.imageTable) {
+      image = [self.imageTable imageWithName:[self cacheNameForKey:cacheKey]];
+    }
+    NSString* variantName = nil;
+    if (nil == image && nil != self.imageMemoryCache) {
+      image = [self.imageMemoryCache objectWithKey:cacheKey];
+      if (nil == image) {
+        // A larger size of the same image can be scaled down without touching the network.
+        variantName = [self.imageMemoryCache nameOfSmallestVariantInGroup:cacheKey.variantGroupName
+                                                             coveringSize:cacheKey.displaySize];
+      }
     }
 
     if (nil != image) {
@@ -307,68 +932,499 @@
       
       [self networkImageViewDidLoadImage:image];
 
+    } else if (nil != variantName) {
+      [self loadVariantImageWithName:variantName
+                                path:pathToNetworkImage
+                                 url:url
+                         displaySize:displaySize
+                         contentMode:contentMode
+                            cropRect:cropRect];
+
+    } else if ([self.failedPathFilter mightContainString:pathToNetworkImage]) {
+      // This path failed moments ago, so it would most likely fail again.
+      NSDictionary* userInfo = @{NSURLErrorFailingURLErrorKey: url};
+      [self _didFailToLoadWithError:[NSError errorWithDomain:NINimbusErrorDomain
+                                                        code:NIPathFailedRecently
+                                                    userInfo:userInfo]];
+
+    } else if (nil != self.processedImageDiskCache
+               && [self.processedImageDiskCache containsDataWithName:[self cacheNameForKey:cacheKey]]) {
+      [self loadDiskImageWithKey:cacheKey
+                            path:pathToNetworkImage
+                             url:url
+                     displaySize:displaySize
+                     contentMode:contentMode
+                        cropRect:cropRect];
+
     } else {
-      if (!self.sizeForDisplay) {
-        displaySize = CGSizeZero;
-        contentMode = UIViewContentModeScaleToFill;
+      [self loadNetworkImageWithPath:pathToNetworkImage
+                                 url:url
+                         displaySize:displaySize
+                         contentMode:contentMode
+                            cropRect:cropRect];
+    }
+  }
+}
+
+// Reads the processed image from disk without blocking the main thread. The network is only
+// used if the file turns out to be unreadable.
+- (void)loadDiskImageWithKey:(NINetworkImageCacheKey *)cacheKey
+                        path:(NSString *)path
+                         url:(NSURL *)url
+                 displaySize:(CGSize)displaySize
+                 contentMode:(UIViewContentMode)contentMode
+                    cropRect:(CGRect)cropRect {
+  NSObject* cacheLookup = [[NSObject alloc] init];
+  self.cacheLookup = cacheLookup;
+
+  NSString* diskCacheName = [self cacheNameForKey:cacheKey];
+  [self.processedImageDiskCache dataWithName:diskCacheName completion:^(NSData* data) {
+    if (self.cacheLookup != cacheLookup) {
+      // The view has moved on to another image.
+      return;
+    }
+    self.cacheLookup = nil;
+
+    UIImage* image = [NIImageProcessing imageFromMappableData:data];
+    if (nil == image) {
+      [self loadNetworkImageWithPath:path
+                                 url:url
+                         displaySize:displaySize
+                         contentMode:contentMode
+                            cropRect:cropRect];
+      return;
+    }
+
+    [self.imageMemoryCache storeObject:image withKey:cacheKey expiresAfter:nil];
+    [self addVariantWithKey:cacheKey image:image];
+    [self commitLoadedImage:^{
+      [self setImage:image];
+
+      if ([self.delegate respondsToSelector:@selector(networkImageView:didLoadImage:)]) {
+        [self.delegate networkImageView:self didLoadImage:self.image];
       }
 
-      NSURLRequest *request = [NSURLRequest requestWithURL:url];
-
-      AFHTTPRequestOperation* requestOperation = [[AFHTTPRequestOperation alloc] initWithRequest:request];
-
-      NIImageResponseSerializer* serializer = [NIImageResponseSerializer serializer];
-      // We handle image scaling ourselves in the image processing method, so we need to disable
-      // AFNetworking from doing so as well.
-      serializer.imageScale = 1;
-      serializer.contentMode = contentMode;
-      serializer.cropRect = cropRect;
-      serializer.displaySize = displaySize;
-      serializer.scaleOptions = self.scaleOptions;
-      serializer.interpolationQuality = self.interpolationQuality;
-      requestOperation.responseSerializer = serializer;
-
-      NSString* originalCacheKey = [self cacheKeyForCacheIdentifier:pathToNetworkImage
-                                                          imageSize:displaySize
-                                                           cropRect:cropRect
-                                                        contentMode:contentMode
-                                                       scaleOptions:self.scaleOptions];
-      requestOperation.userInfo = @{@"cacheKey":originalCacheKey};
-
-      [requestOperation setCompletionBlockWithSuccess:^(AFHTTPRequestOperation *operation, id responseObject) {
-        NSString* blockCacheKey = [self cacheKeyForCacheIdentifier:pathToNetworkImage
-                                                         imageSize:displaySize
-                                                          cropRect:cropRect
-                                                       contentMode:contentMode
-                                                      scaleOptions:self.scaleOptions];
-
-        // Only keep this result if it's for the most recent request.
-        if ([blockCacheKey isEqualToString:operation.userInfo[@"cacheKey"]]) {
-          [self _didFinishLoadingWithImage:responseObject
-                           cacheIdentifier:pathToNetworkImage
-                               displaySize:displaySize
-                                  cropRect:cropRect
-                               contentMode:contentMode
-                              scaleOptions:self.scaleOptions
-                            expirationDate:[self expirationDate]];
-        }
+      [self networkImageViewDidLoadImage:image];
+    }];
+  }];
+}
 
-      } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
-         [self _didFailToLoadWithError:error];
-      }];
+// Scales a larger cached size of the image down to the display size on a background queue. The
+// network is only used if the larger size has been evicted in the meantime.
+- (void)loadVariantImageWithName:(NSString *)variantName
+                            path:(NSString *)path
+                             url:(NSURL *)url
+                     displaySize:(CGSize)displaySize
+                     contentMode:(UIViewContentMode)contentMode
+                        cropRect:(CGRect)cropRect {
+  UIImage* variant = [self.imageMemoryCache objectWithName:variantName];
+  if (nil == variant) {
+    [self loadNetworkImageWithPath:path
+                               url:url
+                       displaySize:displaySize
+                       contentMode:contentMode
+                          cropRect:cropRect];
+    return;
+  }
 
-      [requestOperation setDownloadProgressBlock:^(NSUInteger bytesRead, NSInteger totalBytesRead, NSInteger totalBytesExpectedToRead) {
-          if ([self.delegate respondsToSelector:@selector(networkImageView:readBytes:totalBytes:)]) {
-              [self.delegate networkImageView:self readBytes:totalBytesRead totalBytes:totalBytesExpectedToRead];
-          }
+  NSObject* variantLookup = [[NSObject alloc] init];
+  self.cacheLookup = variantLookup;
+
+  NINetworkImageViewScaleOptions scaleOptions = self.scaleOptions;
+  CGInterpolationQuality interpolationQuality = self.interpolationQuality;
+  NINetworkImageViewResamplingEngine resamplingEngine = self.resamplingEngine;
+  NSDate* expirationDate = [self expirationDate];
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    // The variant was processed with the same crop, content mode and scale options at a larger
+    // size with the same aspect ratio, so processing it again only scales it down.
+    UIImage* image = [NIImageProcessing imageFromSource:variant
+                                        withContentMode:contentMode
+                                               cropRect:cropRect
+                                            displaySize:displaySize
+                                           scaleOptions:scaleOptions
+                                   interpolationQuality:interpolationQuality
+                                       resamplingEngine:resamplingEngine];
+    dispatch_async(dispatch_get_main_queue(), ^{
+      if (self.cacheLookup != variantLookup) {
+        // The view has moved on to another image.
+        return;
+      }
+      self.cacheLookup = nil;
+
+      if (nil == image) {
+        [self loadNetworkImageWithPath:path
+                                   url:url
+                           displaySize:displaySize
+                           contentMode:contentMode
+                              cropRect:cropRect];
+        return;
+      }
+      [self _didFinishLoadingWithImage:image
+                       cacheIdentifier:path
+                           displaySize:displaySize
+                              cropRect:cropRect
+                           contentMode:contentMode
+                          scaleOptions:scaleOptions
+                        expirationDate:expirationDate];
+    });
+  });
+}
+
+- (void)loadNetworkImageWithPath:(NSString *)pathToNetworkImage
+                             url:(NSURL *)url
+                     displaySize:(CGSize)displaySize
+                     contentMode:(UIViewContentMode)contentMode
+                        cropRect:(CGRect)cropRect {
+  if (!self.sizeForDisplay) {
+    displaySize = CGSizeZero;
+    contentMode = UIViewContentModeScaleToFill;
+  }
+
+  // Image views showing the same image with the same processing share one request. The
+  // transport decides how the request is made, so views with different transports don't share.
+  NSString* requestKey = [NSString stringWithFormat:@"%@%@%@{%@,%@,%@,%@,%@,%@,%@,%@}%@",
+                          url.absoluteString, NSStringFromCGSize(displaySize), NSStringFromCGRect(cropRect),
+                          [@(self.transport) stringValue],
+                          [@(contentMode) stringValue], [@(self.scaleOptions) stringValue],
+                          [@(self.interpolationQuality) stringValue], [@(self.resamplingEngine) stringValue],
+                          [@(self.forcesImageDecoding) stringValue], [@(self.loadsProgressively) stringValue],
+                          [@(self.loadsAnimatedImages) stringValue],
+                          (nil != self.imageStyle) ? [self.imageStyle cacheName] : @""];
+  NINetworkImageRequest* request = [[NINetworkImageRequest inFlightRequests] objectForKey:requestKey];
+  BOOL isNewRequest = (nil == request);
+  if (isNewRequest) {
+    NSString* validatorsName = nil;
+    if (self.maxAge > 0 && !url.isFileURL) {
+      // Only images that expire are ever revalidated.
+      NINetworkImageCacheKey* cacheKey = [self cacheKeyForCacheIdentifier:pathToNetworkImage
+                                                                imageSize:displaySize
+                                                                 cropRect:cropRect
+                                                              contentMode:contentMode
+                                                             scaleOptions:self.scaleOptions];
+      validatorsName = [self cacheNameForKey:cacheKey];
+    }
+    request = [self requestWithKey:requestKey
+                              path:pathToNetworkImage
+                               url:url
+                       displaySize:displaySize
+                       contentMode:contentMode
+                          cropRect:cropRect
+                    validatorsName:validatorsName];
+  }
+
+  // A placeholder from an earlier download of this image fills in until the image arrives.
+  UIImage* placeholderImage = nil;
+  if (nil != self.placeholderMemoryCache && 0 == self.imageProcessors.count) {
+    NIImagePlaceholder* placeholder = [self.placeholderMemoryCache objectWithName:pathToNetworkImage];
+    placeholderImage = placeholder.thumbnail;
+    if (nil != placeholderImage) {
+      [self setImage:placeholderImage];
+    }
+  }
+
+  NINetworkImageRequestSubscriber* subscriber = [[NINetworkImageRequestSubscriber alloc] init];
+  // Another subscriber's delegate may point this view at a new path while results are being
+  // delivered, in which case this result is stale.
+  __weak NINetworkImageRequestSubscriber* weakSubscriber = subscriber;
+  subscriber.success = ^(UIImage* image) {
+    if (self.requestSubscriber != weakSubscriber) {
+      return;
+    }
+    // Image views that differ only in their processors share the request and start processing
+    // from the same image.
+    [self processImage:image withName:requestKey completion:^(UIImage* processedImage) {
+      if (self.requestSubscriber != weakSubscriber) {
+        return;
+      }
+      self.request = nil;
+      self.requestSubscriber = nil;
+      // Only the display waits for the scroll view. The image is cached right away, so that it
+      // isn't fetched again if this view is reused before the commit.
+      [self _storeLoadedImage:processedImage
+              cacheIdentifier:pathToNetworkImage
+                  displaySize:displaySize
+                     cropRect:cropRect
+                  contentMode:contentMode
+                 scaleOptions:self.scaleOptions
+               expirationDate:[self expirationDate]];
+      [self commitLoadedImage:^{
+        [self _displayLoadedImage:processedImage];
       }];
+    }];
+  };
+  subscriber.failure = ^(NSError* error) {
+    if (self.requestSubscriber != weakSubscriber) {
+      return;
+    }
+    self.request = nil;
+    self.requestSubscriber = nil;
+    if (nil != placeholderImage && self.image == placeholderImage) {
+      [self setImage:self.initialImage];
+    }
+    [self _didFailToLoadWithError:error];
+  };
+  subscriber.progress = ^(NSInteger totalBytesRead, NSInteger totalBytesExpectedToRead) {
+    if ([self.delegate respondsToSelector:@selector(networkImageView:readBytes:totalBytes:)]) {
+      [self.delegate networkImageView:self readBytes:totalBytesRead totalBytes:totalBytesExpectedToRead];
+    }
+  };
+  subscriber.partialImage = ^(UIImage* image) {
+    // Partial images haven't been processed, and showing them would give away what a blur or
+    // a mask is meant to hide.
+    if (self.requestSubscriber != weakSubscriber || self.imageProcessors.count > 0) {
+      return;
+    }
+    [self setImage:image];
+    if ([self.delegate respondsToSelector:@selector(networkImageView:didLoadPartialImage:)]) {
+      [self.delegate networkImageView:self didLoadPartialImage:image];
+    }
+  };
+  subscriber.priority = [self effectiveNetworkOperationPriority];
+  [request.subscribers addObject:subscriber];
+  [request updatePriority];
 
-      self.operation = requestOperation;
+  self.request = request;
+  self.requestSubscriber = subscriber;
+  self.operation = request.operation;
 
-      [self _didStartLoading];
-      [self.networkOperationQueue addOperation:requestOperation];
+  [self _didStartLoading];
+  if (isNewRequest) {
+    [[NINetworkImageScheduler sharedScheduler] addOperation:request.operation
+                                                    forHost:url.host
+                                                    toQueue:self.networkOperationQueue];
+  }
+}
+
+// Creates a request and adds it to the in-flight table. The request delivers its result to every
+// image view that subscribes to it before it completes.
+- (NINetworkImageRequest *)requestWithKey:(NSString *)requestKey
+                                     path:(NSString *)path
+                                      url:(NSURL *)url
+                              displaySize:(CGSize)displaySize
+                              contentMode:(UIViewContentMode)contentMode
+                                 cropRect:(CGRect)cropRect
+                           validatorsName:(NSString *)validatorsName {
+  NINetworkImageRequest* request = [[NINetworkImageRequest alloc] init];
+  request.key = requestKey;
+
+  // An image that has expired but was served with validators can be revalidated for the cost of
+  // a 304 rather than downloaded, decoded and processed again.
+  NSCache* validatorsCache = [NINetworkImageValidators validatorsCache];
+  NINetworkImageValidators* validators = nil;
+  NSMutableURLRequest* urlRequest = [NSMutableURLRequest requestWithURL:url];
+  if (nil != validatorsName) {
+    validators = [validatorsCache objectForKey:validatorsName];
+    [validators addToRequest:urlRequest];
+  }
+
+  NIImageResponseSerializer* serializer = [NIImageResponseSerializer serializer];
+  // We handle image scaling ourselves in the image processing method, so we need to disable
+  // AFNetworking from doing so as well.
+  serializer.imageScale = 1;
+  serializer.contentMode = contentMode;
+  serializer.cropRect = cropRect;
+  serializer.displaySize = displaySize;
+  serializer.scaleOptions = self.scaleOptions;
+  serializer.interpolationQuality = self.interpolationQuality;
+  serializer.resamplingEngine = self.resamplingEngine;
+  serializer.forcesImageDecoding = self.forcesImageDecoding;
+  serializer.decodesAnimatedImages = self.loadsAnimatedImages;
+  serializer.style = self.imageStyle;
+  serializer.placeholderMemoryCache = self.placeholderMemoryCache;
+  serializer.placeholderName = path;
+
+  // Servers that can encode more compact formats are told which ones we can decode.
+  [urlRequest setValue:[serializer acceptHeaderValue] forHTTPHeaderField:@"Accept"];
+
+  // The in-flight table owns the request until it completes or loses its last subscriber.
+  __weak NINetworkImageRequest* weakRequest = request;
+  NIBloomFilter* failedPathFilter = self.failedPathFilter;
+
+  void (^didSucceed)(NSHTTPURLResponse*, id) = ^(NSHTTPURLResponse* response, id responseObject) {
+    if (nil != validatorsName) {
+      NINetworkImageValidators* newValidators = [NINetworkImageValidators validatorsWithResponse:response
+                                                                                           image:responseObject];
+      if (nil != newValidators) {
+        [validatorsCache setObject:newValidators forKey:validatorsName cost:[newValidators cost]];
+      } else {
+        [validatorsCache removeObjectForKey:validatorsName];
+      }
+    }
+    NI_SIGNPOST_END(NISignpostCategoryImages, "Fetch", requestKey);
+    for (NINetworkImageRequestSubscriber* subscriber in [weakRequest finish]) {
+      subscriber.success(responseObject);
+    }
+  };
+
+  void (^didFail)(NSHTTPURLResponse*, NSError*) = ^(NSHTTPURLResponse* response, NSError* error) {
+    NI_SIGNPOST_END(NISignpostCategoryImages, "Fetch", requestKey);
+
+    // The serializer only accepts 2xx responses, so a 304 ends up here. The image we already
+    // have is still good and goes back into the memory cache with a fresh lifetime.
+    if (nil != validators && 304 == response.statusCode) {
+      for (NINetworkImageRequestSubscriber* subscriber in [weakRequest finish]) {
+        subscriber.success(validators.image);
+      }
+      return;
     }
+
+    // Only failures that would happen again are remembered; timeouts, going offline and server
+    // errors say nothing about the path itself. A cached response that fails to decode has no
+    // HTTP response and is downloaded again instead.
+    BOOL isPathFailure = ((url.isFileURL || nil != response)
+                          && NIIsPermanentLoadFailure(response, error));
+    if (isPathFailure) {
+      [failedPathFilter addString:path];
+    }
+    for (NINetworkImageRequestSubscriber* subscriber in [weakRequest finish]) {
+      subscriber.failure(error);
+    }
+  };
+
+  void (^didProgress)(long long, long long) = ^(long long totalBytesRead, long long totalBytesExpectedToRead) {
+    for (NINetworkImageRequestSubscriber* subscriber in [weakRequest.subscribers copy]) {
+      subscriber.progress((NSInteger)totalBytesRead, (NSInteger)totalBytesExpectedToRead);
+    }
+    [weakRequest decodePartialImageIfNeeded];
+  };
+
+  // The disk cache has no notion of expiration, just like the processed image disk cache.
+  NIDiskCache* responseDiskCache = (0 == self.maxAge) ? self.responseDiskCache : nil;
+  NSString* responseName = url.absoluteString;
+  BOOL readsFromDisk = (url.isFileURL
+                        || (nil != responseDiskCache && [responseDiskCache containsDataWithName:responseName]));
+
+  if (readsFromDisk) {
+    request.operation = [self fileOperationWithURL:url
+                                         diskCache:(url.isFileURL ? nil : responseDiskCache)
+                                        serializer:serializer
+                                        didSucceed:didSucceed
+                                           didFail:didFail];
+
+  } else if (NINetworkImageTransportOperation == self.transport || ![NINetworkImageSession isAvailable]) {
+    Class operationClass = (self.loadsProgressively
+                            ? [NIProgressiveHTTPRequestOperation class]
+                            : [AFHTTPRequestOperation class]);
+    AFHTTPRequestOperation* requestOperation = [[operationClass alloc] initWithRequest:urlRequest];
+    requestOperation.responseSerializer = serializer;
+    // The operation's start isn't observable, so its metrics include the time spent queued.
+    // All of the operation's blocks run on the main queue.
+    __block NINetworkTaskMetrics metrics = NINetworkTaskMetricsDidStart(urlRequest.URL);
+    [requestOperation setCompletionBlockWithSuccess:^(AFHTTPRequestOperation *operation, id responseObject) {
+      NINetworkTaskMetricsDidFinish(&metrics);
+      didSucceed(operation.response, responseObject);
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+      NINetworkTaskMetricsDidFinish(&metrics);
+      didFail(operation.response, error);
+    }];
+    [requestOperation setDownloadProgressBlock:^(NSUInteger bytesRead, NSInteger totalBytesRead, NSInteger totalBytesExpectedToRead) {
+      NINetworkTaskMetricsDidReceiveBytes(&metrics, bytesRead);
+      didProgress(totalBytesRead, totalBytesExpectedToRead);
+    }];
+    request.operation = requestOperation;
+
+  } else {
+    NINetworkImageSession* session = ((NINetworkImageTransportBackgroundSession == self.transport)
+                                      ? [NINetworkImageSession sharedBackgroundSession]
+                                      : [NINetworkImageSession sharedSession]);
+    NINetworkImageSessionOperation* sessionOperation =
+        [[NINetworkImageSessionOperation alloc] initWithRequest:urlRequest session:session];
+    sessionOperation.responseSerializer = serializer;
+    // The body is only kept once it has been decoded, so a response that isn't an image never
+    // makes it into the cache.
+    sessionOperation.outputFileURL = [responseDiskCache temporaryFileURL];
+    [sessionOperation setCompletionBlockWithSuccess:^(NINetworkImageSessionOperation *operation, id responseObject) {
+      if (nil != operation.outputFileURL) {
+        [responseDiskCache storeFileAtURL:operation.outputFileURL withName:responseName];
+      }
+      didSucceed(operation.response, responseObject);
+    } failure:^(NINetworkImageSessionOperation *operation, NSError *error) {
+      if (nil != operation.outputFileURL) {
+        [[NSFileManager defaultManager] removeItemAtURL:operation.outputFileURL error:nil];
+      }
+      didFail(operation.response, error);
+    }];
+    [sessionOperation setDownloadProgressBlock:^(NSUInteger bytesRead, long long totalBytesRead, long long totalBytesExpectedToRead) {
+      didProgress(totalBytesRead, totalBytesExpectedToRead);
+    }];
+    request.operation = sessionOperation;
   }
+
+  // Files are read in one go, so there is nothing to show progressively.
+  if (self.loadsProgressively && !readsFromDisk) {
+    NIProgressiveImageDecoder* decoder = [[NIProgressiveImageDecoder alloc] init];
+    decoder.contentMode = contentMode;
+    decoder.cropRect = cropRect;
+    decoder.displaySize = displaySize;
+    decoder.scaleOptions = self.scaleOptions;
+    decoder.interpolationQuality = self.interpolationQuality;
+    decoder.resamplingEngine = self.resamplingEngine;
+    decoder.style = self.imageStyle;
+    request.decoder = decoder;
+    request.partialImageUpdateInterval = self.progressiveUpdateInterval;
+  }
+
+  [[NINetworkImageRequest inFlightRequests] setObject:request forKey:requestKey];
+  NI_SIGNPOST_BEGIN(NISignpostCategoryImages, "Fetch", requestKey, "%{public}@", path);
+  return request;
+}
+
+// Reads a local file, or the response for the URL from the disk cache when one is given,
+// without going through the URL loading system. The file is mapped rather than copied into
+// memory, which lets the serializer decode a thumbnail at the display size from only the bytes
+// it needs. The result is delivered on the main thread like a network response.
+- (NSOperation *)fileOperationWithURL:(NSURL *)url
+                            diskCache:(NIDiskCache *)diskCache
+                           serializer:(NIImageResponseSerializer *)serializer
+                           didSucceed:(void (^)(NSHTTPURLResponse* response, id responseObject))didSucceed
+                              didFail:(void (^)(NSHTTPURLResponse* response, NSError* error))didFail {
+  NSBlockOperation* fileOperation = [[NSBlockOperation alloc] init];
+  __weak NSBlockOperation* weakFileOperation = fileOperation;
+  [fileOperation addExecutionBlock:^{
+    if (weakFileOperation.isCancelled) {
+      return;
+    }
+    NSError* error = nil;
+    NSData* data = nil;
+    if (nil != diskCache) {
+      data = [diskCache dataWithName:url.absoluteString];
+      if (nil == data) {
+        // Evicted since the request was made.
+        error = [NSError errorWithDomain:NSURLErrorDomain
+                                    code:NSURLErrorFileDoesNotExist
+                                userInfo:@{NSURLErrorFailingURLErrorKey: url}];
+      }
+    } else {
+      data = [NSData dataWithContentsOfURL:url options:NSDataReadingMappedIfSafe error:&error];
+    }
+    id image = nil;
+    if (nil != data) {
+      // There is no HTTP response to validate, so the serializer goes straight to decoding.
+      image = [serializer responseObjectForResponse:nil data:data error:&error];
+      if (nil == image && nil == error) {
+        error = [NSError errorWithDomain:NSURLErrorDomain
+                                    code:NSURLErrorCannotDecodeContentData
+                                userInfo:@{NSURLErrorFailingURLErrorKey: url}];
+      }
+      if (nil == image) {
+        // The next request downloads the image again rather than failing the same way.
+        [diskCache removeDataWithName:url.absoluteString];
+      }
+    }
+    dispatch_async(dispatch_get_main_queue(), ^{
+      // Cancelled requests have already let go of their subscribers.
+      NSBlockOperation* strongFileOperation = weakFileOperation;
+      if (nil == strongFileOperation || strongFileOperation.isCancelled) {
+        return;
+      }
+      if (nil != image) {
+        didSucceed(nil, image);
+      } else {
+        didFail(nil, error);
+      }
+    });
+  }];
+  return fileOperation;
 }
 
 - (void)setNetworkImageOperation:(NIOperation<NINetworkImageOperation> *)operation forDisplaySize:(CGSize)displaySize contentMode:(UIViewContentMode)contentMode cropRect:(CGRect)cropRect {
@@ -390,12 +1446,12 @@
 
     // Attempt to load the image from memory first.
     if (nil != self.imageMemoryCache) {
-      NSString* cacheKey = [self cacheKeyForCacheIdentifier:operation.cacheIdentifier
-                                                  imageSize:displaySize
-                                                   cropRect:cropRect
-                                                contentMode:contentMode
-                                               scaleOptions:self.scaleOptions];
-      image = [self.imageMemoryCache objectWithName:cacheKey];
+      NINetworkImageCacheKey* cacheKey = [self cacheKeyForCacheIdentifier:operation.cacheIdentifier
+                                                                imageSize:displaySize
+                                                                 cropRect:cropRect
+                                                              contentMode:contentMode
+                                                             scaleOptions:self.scaleOptions];
+      image = [self.imageMemoryCache objectWithKey:cacheKey];
     }
 
     if (nil != image) {
@@ -429,10 +1485,151 @@
 
 - (void)prepareForReuse {
   [self cancelOperation];
+  self.didLeaveWindow = NO;
 
   [self setImage:self.initialImage];
 }
 
+#pragma mark - Visibility
+
+- (UIScrollView *)enclosingScrollView {
+  for (UIView* view = self.superview; nil != view; view = view.superview) {
+    if ([view isKindOfClass:[UIScrollView class]]) {
+      return (UIScrollView *)view;
+    }
+  }
+  return nil;
+}
+
+// Shows an image that arrived asynchronously, unless the enclosing scroll view is moving too
+// fast, in which case the commit queue shows it once the scroll view allows.
+- (void)commitLoadedImage:(void (^)(void))commit {
+  UIScrollView* scrollView = (self.maxScrollSpeedForImageCommits > 0) ? [self enclosingScrollView] : nil;
+  if (nil == scrollView) {
+    commit();
+    return;
+  }
+  [[NINetworkImageCommitQueue sharedQueue] addCommitForImageView:self
+                                                      scrollView:scrollView
+                                                  maxScrollSpeed:self.maxScrollSpeedForImageCommits
+                                                           block:commit];
+}
+
+// Views in a window are the ones the user is looking at. Views that haven't reached a window
+// yet are usually cells that are about to appear, and views that left one have scrolled away.
+- (NSOperationQueuePriority)effectiveNetworkOperationPriority {
+  if (nil != self.window) {
+    return self.networkOperationPriority;
+  } else if (self.didLeaveWindow) {
+    return NSOperationQueuePriorityVeryLow;
+  }
+  return MIN(self.networkOperationPriority, NSOperationQueuePriorityLow);
+}
+
+- (void)didMoveToWindow {
+  [super didMoveToWindow];
+
+  [self updateAnimation];
+
+  if (nil == self.window) {
+    self.didLeaveWindow = YES;
+  }
+  if (nil != self.requestSubscriber) {
+    self.requestSubscriber.priority = [self effectiveNetworkOperationPriority];
+    [self.request updatePriority];
+  }
+}
+
+#pragma mark - Animation
+
+
+- (void)setImage:(UIImage *)image {
+  BOOL didChangeImage = (image != self.image);
+  [super setImage:image];
+
+  if (didChangeImage) {
+    [self stopAnimation];
+    [self updateAnimation];
+  }
+}
+
+// Animated images only play while they can be seen.
+- (void)updateAnimation {
+  BOOL shouldAnimate = ([self.image isKindOfClass:[NIAnimatedImage class]] && nil != self.window);
+  if (shouldAnimate && nil == self.animationDisplayLink) {
+    NINetworkImageViewDisplayLinkTarget* target = [[NINetworkImageViewDisplayLinkTarget alloc] init];
+    target.imageView = self;
+    self.animationDisplayLink = [CADisplayLink displayLinkWithTarget:target
+                                                            selector:@selector(displayDidRefresh:)];
+    [self.animationDisplayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+
+    // Start decoding the frames that follow the one being shown.
+    [(NIAnimatedImage *)self.image frameAtIndex:self.animationFrameIndex];
+
+  } else if (!shouldAnimate && nil != self.animationDisplayLink) {
+    // Pausing keeps the current frame so that the animation resumes where it left off.
+    [self.animationDisplayLink invalidate];
+    self.animationDisplayLink = nil;
+  }
+}
+
+- (void)stopAnimation {
+  [self.animationDisplayLink invalidate];
+  self.animationDisplayLink = nil;
+  self.animationFrame = nil;
+  self.animationFrameIndex = 0;
+  self.animationLoopCount = 0;
+  self.animationFrameTime = 0;
+}
+
+- (void)displayDidRefresh:(CADisplayLink *)displayLink {
+  if (![self.image isKindOfClass:[NIAnimatedImage class]]) {
+    [self stopAnimation];
+    return;
+  }
+  NIAnimatedImage* animatedImage = (NIAnimatedImage *)self.image;
+
+  self.animationFrameTime += displayLink.duration;
+  NSTimeInterval frameDuration = [animatedImage durationOfFrameAtIndex:self.animationFrameIndex];
+  while (self.animationFrameTime >= frameDuration) {
+    NSUInteger nextFrameIndex = (self.animationFrameIndex + 1) % animatedImage.numberOfFrames;
+    BOOL completesLoop = (0 == nextFrameIndex);
+    if (completesLoop && animatedImage.loopCount > 0
+        && self.animationLoopCount + 1 >= animatedImage.loopCount) {
+      // Finished animations stay on their last frame.
+      [self.animationDisplayLink invalidate];
+      return;
+    }
+
+    UIImage* frame = [animatedImage frameAtIndex:nextFrameIndex];
+    if (nil == frame) {
+      // The frame is still being decoded, so hold the current one rather than skipping ahead
+      // once it arrives.
+      self.animationFrameTime = frameDuration;
+      return;
+    }
+
+    if (completesLoop) {
+      self.animationLoopCount++;
+    }
+    self.animationFrameTime -= frameDuration;
+    self.animationFrameIndex = nextFrameIndex;
+    self.animationFrame = frame;
+    [self.layer setNeedsDisplay];
+
+    frameDuration = [animatedImage durationOfFrameAtIndex:nextFrameIndex];
+  }
+}
+
+- (void)displayLayer:(CALayer *)layer {
+  if (nil != self.animationFrame) {
+    layer.contents = (__bridge id)self.animationFrame.CGImage;
+
+  } else if ([UIImageView instancesRespondToSelector:@selector(displayLayer:)]) {
+    [super displayLayer:layer];
+  }
+}
+
 #pragma mark - Properties
 
 
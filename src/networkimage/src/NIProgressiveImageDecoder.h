@@ -0,0 +1,59 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+#import "NINetworkImageView.h"  // For NINetworkImageViewScaleOptions
+
+@class NIImageStyle;
+
+/**
+ * Decodes partially downloaded image data into progressively sharper images.
+ *
+ * Give the decoder all of the data that has arrived so far each time more of it arrives.
+ * The decoder keeps an incremental image source between calls, so only the new bytes are
+ * parsed. Progressive JPEGs become sharper with each pass, while other formats fill in from
+ * the top. Each partial image is cropped and resized for display exactly as the final image
+ * would be.
+ *
+ * A decoder may be used from any thread, but only from one thread at a time.
+ *
+ * @ingroup NimbusNetworkImage
+ */
+@interface NIProgressiveImageDecoder : NSObject
+
+@property (nonatomic, assign) UIViewContentMode contentMode;
+@property (nonatomic, assign) CGRect cropRect;
+@property (nonatomic, assign) CGSize displaySize;
+@property (nonatomic, assign) NINetworkImageViewScaleOptions scaleOptions;
+@property (nonatomic, assign) CGInterpolationQuality interpolationQuality;
+@property (nonatomic, assign) NINetworkImageViewResamplingEngine resamplingEngine;
+@property (nonatomic, copy) NIImageStyle* style;
+
+- (UIImage *)partialImageWithData:(NSData *)data;
+
+@end
+
+/**
+ * Returns an image decoded from as much of the data as has been downloaded.
+ *
+ * data must contain every byte received so far, starting from the first. Returns nil until
+ * enough of the image has arrived to know its dimensions and decode some of its pixels.
+ *
+ * @fn NIProgressiveImageDecoder::partialImageWithData:
+ */
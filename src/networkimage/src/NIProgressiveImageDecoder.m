@@ -0,0 +1,87 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIProgressiveImageDecoder.h"
+
+#import "NIImageProcessing.h"
+
+#import <ImageIO/ImageIO.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+@implementation NIProgressiveImageDecoder {
+  CGImageSourceRef _imageSource;
+}
+
+- (void)dealloc {
+  if (NULL != _imageSource) {
+    CFRelease(_imageSource);
+  }
+}
+
+- (id)init {
+  if ((self = [super init])) {
+    _imageSource = CGImageSourceCreateIncremental(NULL);
+    _contentMode = UIViewContentModeScaleToFill;
+    _interpolationQuality = kCGInterpolationDefault;
+  }
+  return self;
+}
+
+- (UIImage *)partialImageWithData:(NSData *)data {
+  if (NULL == _imageSource || 0 == data.length) {
+    return nil;
+  }
+
+  CGImageSourceUpdateData(_imageSource, (__bridge CFDataRef)data, false);
+
+  // Until the header has arrived we don't know how large the image is.
+  if (CGImageSourceGetCount(_imageSource) < 1) {
+    return nil;
+  }
+  CGImageSourceStatus status = CGImageSourceGetStatusAtIndex(_imageSource, 0);
+  if (kCGImageStatusIncomplete != status && kCGImageStatusComplete != status) {
+    return nil;
+  }
+
+  CGImageRef imageRef = CGImageSourceCreateImageAtIndex(_imageSource, 0, NULL);
+  if (NULL == imageRef) {
+    return nil;
+  }
+  UIImage* image = [UIImage imageWithCGImage:imageRef];
+  CGImageRelease(imageRef);
+
+  // Processing draws the image, so the partial frame is decoded here rather than on the main
+  // thread.
+  UIImage* processedImage = [NIImageProcessing imageFromSource:image
+                                               withContentMode:self.contentMode
+                                                      cropRect:self.cropRect
+                                                   displaySize:self.displaySize
+                                                  scaleOptions:self.scaleOptions
+                                          interpolationQuality:self.interpolationQuality
+                                              resamplingEngine:self.resamplingEngine];
+  if (nil != self.style) {
+    processedImage = [NIImageProcessing imageFromImage:processedImage withStyle:self.style];
+  } else if (!(self.displaySize.width > 0 && self.displaySize.height > 0)) {
+    processedImage = [NIImageProcessing decodedImageFromImage:processedImage];
+  }
+  return processedImage;
+}
+
+@end
@@ -30,7 +30,10 @@
  * Required frameworks:
  *
  * - UIKit.framework
+ * - QuartzCore.framework
  * - CoreText.framework
+ * - Accelerate.framework
+ * - ImageIO.framework
  * - AFNetworking https://github.com/AFNetworking/AFNetworking
  *
  * Minimum Operating System: <b>iOS 4.0</b>
@@ -68,7 +71,18 @@
 #import <UIKit/UIKit.h>
 
 #import "NimbusCore.h"
+#import "NIAnimatedImage.h"
+#import "NIImageDecoder.h"
+#import "NIImagePipeline.h"
+#import "NIImagePlaceholder.h"
 #import "NIImageProcessing.h"
+#import "NIImageStyle.h"
+#import "NINetworkImageCacheKey.h"
+#import "NINetworkImageCacheManifest.h"
+#import "NINetworkImagePrefetcher.h"
+#import "NINetworkImageScheduler.h"
+#import "NINetworkImageSession.h"
 #import "NINetworkImageView.h"
+#import "NIProgressiveImageDecoder.h"
 
 /**@}*/
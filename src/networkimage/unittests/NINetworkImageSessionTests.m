@@ -0,0 +1,193 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NimbusNetworkImage.h"
+#import "NITestURLProtocol.h"
+
+@interface NINetworkImageSessionTests : XCTestCase
+@end
+
+
+@implementation NINetworkImageSessionTests
+
+
+- (void)tearDown {
+  [NITestURLProtocol reset];
+  [super tearDown];
+}
+
+- (NINetworkImageSession *)testSession {
+  NSURLSessionConfiguration* configuration = [NSURLSessionConfiguration ephemeralSessionConfiguration];
+  configuration.protocolClasses = [@[[NITestURLProtocol class]]
+                                   arrayByAddingObjectsFromArray:configuration.protocolClasses];
+  return [[NINetworkImageSession alloc] initWithConfiguration:configuration];
+}
+
+- (void)runOperation:(NINetworkImageSessionOperation *)operation {
+  NSOperationQueue* queue = [[NSOperationQueue alloc] init];
+  [queue addOperation:operation];
+  [self waitForOperation:operation];
+}
+
+- (void)waitForOperation:(NINetworkImageSessionOperation *)operation {
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (!operation.isFinished && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+}
+
+- (void)testImageHostsAreKeptByOrigin {
+  NINetworkImageSession* session = [self testSession];
+  [session addImageHostWithURL:[NSURL URLWithString:@"HTTP://Images.Nimbus.Test:8080/a/b.png"]];
+  [session addImageHostWithURL:[NSURL URLWithString:@"http://images.nimbus.test:8080/c.png"]];
+  [session addImageHostWithURL:[NSURL fileURLWithPath:@"/tmp/d.png"]];
+
+  NSArray* expectedHosts = @[[NSURL URLWithString:@"http://images.nimbus.test:8080/"]];
+  XCTAssertEqualObjects([session imageHostURLs], expectedHosts,
+                        @"Hosts should be normalized, deduplicated and limited to http and https.");
+
+  [session removeImageHostWithURL:[NSURL URLWithString:@"http://images.nimbus.test:8080/e.png"]];
+  XCTAssertEqual([session imageHostURLs].count, (NSUInteger)0);
+}
+
+- (void)testOperationsDeliverTheResponseOnTheMainThread {
+  NSURL* url = [NSURL URLWithString:@"http://images.nimbus.test/body"];
+  NSData* body = [@"Nimbus" dataUsingEncoding:NSUTF8StringEncoding];
+  [NITestURLProtocol setData:body statusCode:200 headerFields:nil forURL:url];
+
+  NINetworkImageSessionOperation* operation =
+      [[NINetworkImageSessionOperation alloc] initWithRequest:[NSURLRequest requestWithURL:url]
+                                                      session:[self testSession]];
+  __block id successObject = nil;
+  __block BOOL succeededOnMainThread = NO;
+  [operation setCompletionBlockWithSuccess:^(NINetworkImageSessionOperation* finishedOperation, id responseObject) {
+    successObject = responseObject;
+    succeededOnMainThread = [NSThread isMainThread];
+  } failure:nil];
+  [self runOperation:operation];
+
+  XCTAssertTrue(operation.isFinished);
+  XCTAssertEqualObjects(successObject, body, @"Without a serializer the body is the response object.");
+  XCTAssertTrue(succeededOnMainThread);
+  XCTAssertEqual(operation.response.statusCode, (NSInteger)200);
+  XCTAssertEqualObjects([operation responseData], body);
+}
+
+- (void)testOperationsReportFailures {
+  NSURL* url = [NSURL URLWithString:@"http://images.nimbus.test/offline"];
+  [NITestURLProtocol setFailureForURL:url];
+
+  NINetworkImageSessionOperation* operation =
+      [[NINetworkImageSessionOperation alloc] initWithRequest:[NSURLRequest requestWithURL:url]
+                                                      session:[self testSession]];
+  __block NSError* failureError = nil;
+  __block BOOL didSucceed = NO;
+  [operation setCompletionBlockWithSuccess:^(NINetworkImageSessionOperation* finishedOperation, id responseObject) {
+    didSucceed = YES;
+  } failure:^(NINetworkImageSessionOperation* finishedOperation, NSError* error) {
+    failureError = error;
+  }];
+  [self runOperation:operation];
+
+  XCTAssertFalse(didSucceed);
+  XCTAssertEqual(failureError.code, (NSInteger)NSURLErrorNotConnectedToInternet);
+  XCTAssertEqualObjects(operation.error, failureError);
+}
+
+- (void)testCancelledOperationsFinishWithoutSucceeding {
+  NSURL* url = [NSURL URLWithString:@"http://images.nimbus.test/slow"];
+  [NITestURLProtocol setData:[NSData dataWithBytes:"abc" length:3]
+                  statusCode:200
+                headerFields:nil
+                      forURL:url];
+  [NITestURLProtocol setResponseDelay:1];
+
+  NINetworkImageSessionOperation* operation =
+      [[NINetworkImageSessionOperation alloc] initWithRequest:[NSURLRequest requestWithURL:url]
+                                                      session:[self testSession]];
+  __block BOOL didSucceed = NO;
+  [operation setCompletionBlockWithSuccess:^(NINetworkImageSessionOperation* finishedOperation, id responseObject) {
+    didSucceed = YES;
+  } failure:nil];
+  NSOperationQueue* queue = [[NSOperationQueue alloc] init];
+  [queue addOperation:operation];
+  [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+  [operation cancel];
+  [self waitForOperation:operation];
+
+  XCTAssertTrue(operation.isFinished, @"Cancelling should finish the operation.");
+  XCTAssertFalse(didSucceed, @"A cancelled request must not be delivered.");
+}
+
+- (void)testOperationsStreamTheBodyToTheirOutputFile {
+  NSURL* url = [NSURL URLWithString:@"http://images.nimbus.test/file"];
+  NSMutableData* body = [NSMutableData dataWithLength:64 * 1024];
+  memset(body.mutableBytes, 'n', body.length);
+  [NITestURLProtocol setData:body statusCode:200 headerFields:nil forURL:url];
+
+  NSURL* outputFileURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:@"NINetworkImageSessionTests.out"]];
+  [[NSFileManager defaultManager] removeItemAtURL:outputFileURL error:nil];
+  NINetworkImageSessionOperation* operation =
+      [[NINetworkImageSessionOperation alloc] initWithRequest:[NSURLRequest requestWithURL:url]
+                                                      session:[self testSession]];
+  operation.outputFileURL = outputFileURL;
+  [self runOperation:operation];
+
+  XCTAssertNil(operation.error);
+  XCTAssertEqualObjects([NSData dataWithContentsOfURL:outputFileURL], body,
+                        @"Every chunk should have been written to the file.");
+  XCTAssertEqualObjects([operation responseData], body, @"The response data is read from the file.");
+  [[NSFileManager defaultManager] removeItemAtURL:outputFileURL error:nil];
+}
+
+- (void)testStreamedBodiesAreAdoptedByTheResponseDiskCache {
+  NSURL* url = [NSURL URLWithString:@"http://images.nimbus.test/streamed"];
+  NSMutableData* body = [NSMutableData dataWithLength:256 * 1024];
+  memset(body.mutableBytes, 'n', body.length);
+  [NITestURLProtocol setData:body statusCode:200 headerFields:nil forURL:url];
+
+  NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"NINetworkImageSessionTests"];
+  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+  NIDiskCache* responseDiskCache = [[NIDiskCache alloc] initWithPath:path];
+
+  // This is what image views with a responseDiskCache do with every session request.
+  NINetworkImageSessionOperation* operation =
+      [[NINetworkImageSessionOperation alloc] initWithRequest:[NSURLRequest requestWithURL:url]
+                                                      session:[self testSession]];
+  operation.outputFileURL = [responseDiskCache temporaryFileURL];
+  XCTAssertEqualObjects([operation.outputFileURL.path stringByDeletingLastPathComponent].stringByStandardizingPath,
+                        path.stringByStandardizingPath,
+                        @"Temporary files should be made inside the cache so adopting them is a rename.");
+  [self runOperation:operation];
+  XCTAssertNil(operation.error);
+
+  [responseDiskCache storeFileAtURL:operation.outputFileURL withName:url.absoluteString];
+  XCTAssertTrue([responseDiskCache containsDataWithName:url.absoluteString]);
+  XCTAssertEqualObjects([responseDiskCache dataWithName:url.absoluteString], body,
+                        @"Every chunk should have made it into the cached file.");
+  [responseDiskCache waitUntilAllWritesAreFinished];
+  XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:operation.outputFileURL.path],
+                 @"The temporary file should have been moved, not copied.");
+  XCTAssertEqual(responseDiskCache.numberOfBytes, (unsigned long long)body.length);
+
+  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+@end
@@ -19,15 +19,966 @@
 #import <XCTest/XCTest.h>
 
 #import "NimbusNetworkImage.h"
+#import "NIImageResponseSerializer.h"
+#import "NITestURLProtocol.h"
+
+#import <ImageIO/ImageIO.h>
+#import <MobileCoreServices/MobileCoreServices.h>
 
 @interface NINetworkImageViewTests : XCTestCase
 @end
 
+// A scroll view that claims to be dragged for as long as the test says so.
+@interface NIDraggedTestScrollView : UIScrollView
+@property (nonatomic, assign) BOOL isBeingDragged;
+@end
+
+@implementation NIDraggedTestScrollView
+
+- (BOOL)isDragging {
+  return self.isBeingDragged;
+}
+
+@end
+
+@interface NIPrefetchableTestObject : NSObject <NINetworkImagePrefetching>
+@property (nonatomic, copy) NSString* path;
+@end
+
+@implementation NIPrefetchableTestObject
+
+- (void)prefetchNetworkImagesWithPrefetcher:(NINetworkImagePrefetcher *)prefetcher {
+  [prefetcher prefetchImageWithPath:self.path displaySize:CGSizeMake(10, 10) contentMode:UIViewContentModeScaleAspectFill];
+}
+
+@end
+
+@interface NIRecordingImageViewDelegate : NSObject <NINetworkImageViewDelegate>
+@property (nonatomic, strong) UIImage* image;
+@property (nonatomic, strong) NSError* error;
+@end
+
+@implementation NIRecordingImageViewDelegate
+
+- (void)networkImageView:(NINetworkImageView *)imageView didLoadImage:(UIImage *)image {
+  self.image = image;
+}
+
+- (void)networkImageView:(NINetworkImageView *)imageView didFailWithError:(NSError *)error {
+  self.error = error;
+}
+
+@end
+
+@interface NIPrefetchableTestModel : NSObject
+@property (nonatomic, copy) NSArray* objects;
+@end
+
+@implementation NIPrefetchableTestModel
+
+- (id)objectAtIndexPath:(NSIndexPath *)indexPath {
+  return self.objects[indexPath.row];
+}
+
+@end
+
+
+static UIImage* NIGradientTestImage(CGSize size) {
+  UIGraphicsBeginImageContextWithOptions(size, NO, 1);
+  CGContextRef context = UIGraphicsGetCurrentContext();
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGFloat components[] = {1, 0, 0, 1,  0, 0, 1, 0.5};
+  CGGradientRef gradient = CGGradientCreateWithColorComponents(colorSpace, components, NULL, 2);
+  CGContextDrawLinearGradient(context, gradient, CGPointZero, CGPointMake(size.width, size.height), 0);
+  CGGradientRelease(gradient);
+  CGColorSpaceRelease(colorSpace);
+  UIImage* image = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  return image;
+}
+
+// Returns the mean absolute difference of all channels, in the range 0-255.
+static CGFloat NIMeanPixelDifference(UIImage* image1, UIImage* image2) {
+  size_t width = CGImageGetWidth(image1.CGImage);
+  size_t height = CGImageGetHeight(image1.CGImage);
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  uint8_t* pixels[2];
+  CGImageRef images[2] = {image1.CGImage, image2.CGImage};
+  for (NSInteger ix = 0; ix < 2; ++ix) {
+    pixels[ix] = calloc(height, width * 4);
+    CGContextRef context = CGBitmapContextCreate(pixels[ix], width, height, 8, width * 4, colorSpace,
+                                                 (CGBitmapInfo)kCGImageAlphaPremultipliedLast);
+    CGContextDrawImage(context, CGRectMake(0, 0, width, height), images[ix]);
+    CGContextRelease(context);
+  }
+  CGColorSpaceRelease(colorSpace);
+
+  unsigned long long totalDifference = 0;
+  for (size_t ix = 0; ix < width * height * 4; ++ix) {
+    totalDifference += abs((int)pixels[0][ix] - (int)pixels[1][ix]);
+  }
+  free(pixels[0]);
+  free(pixels[1]);
+  return (CGFloat)totalDifference / (CGFloat)(width * height * 4);
+}
 
 @implementation NINetworkImageViewTests
 
 
+- (void)tearDown {
+  [NSURLProtocol unregisterClass:[NITestURLProtocol class]];
+  [NITestURLProtocol reset];
+  [super tearDown];
+}
+
+// An image view that loads from NITestURLProtocol and caches nothing between tests.
+- (NINetworkImageView *)fixtureImageViewWithDelegate:(NIRecordingImageViewDelegate *)delegate {
+  [NSURLProtocol registerClass:[NITestURLProtocol class]];
+  NINetworkImageView* imageView = [[NINetworkImageView alloc] initWithFrame:CGRectMake(0, 0, 40, 40)];
+  imageView.delegate = delegate;
+  imageView.imageMemoryCache = [[NIImageMemoryCache alloc] init];
+  imageView.processedImageDiskCache = nil;
+  imageView.responseDiskCache = nil;
+  imageView.failedPathFilter = [[NIBloomFilter alloc] initWithCapacity:64
+                                                     falsePositiveRate:0.001
+                                                     retentionInterval:60];
+  imageView.networkOperationQueue = [[NSOperationQueue alloc] init];
+  return imageView;
+}
+
+- (void)waitForDelegate:(NIRecordingImageViewDelegate *)delegate {
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (nil == delegate.image && nil == delegate.error && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+}
+
 - (void)testNothing {
 }
 
+- (void)testCancellingOneSubscriberLeavesTheSharedRequestRunning {
+  NSString* path = @"http://images.nimbus.test/shared.png";
+  NSURL* url = [NSURL URLWithString:path];
+  [NITestURLProtocol setData:UIImagePNGRepresentation(NIGradientTestImage(CGSizeMake(40, 40)))
+                  statusCode:200
+                headerFields:@{@"Content-Type": @"image/png"}
+                      forURL:url];
+  [NITestURLProtocol setResponseDelay:0.3];
+
+  NIRecordingImageViewDelegate* cancelledDelegate = [[NIRecordingImageViewDelegate alloc] init];
+  NIRecordingImageViewDelegate* waitingDelegate = [[NIRecordingImageViewDelegate alloc] init];
+  NINetworkImageView* cancelledView = [self fixtureImageViewWithDelegate:cancelledDelegate];
+  NINetworkImageView* waitingView = [self fixtureImageViewWithDelegate:waitingDelegate];
+  [cancelledView setPathToNetworkImage:path forDisplaySize:CGSizeMake(40, 40)];
+  [waitingView setPathToNetworkImage:path forDisplaySize:CGSizeMake(40, 40)];
+  [cancelledView prepareForReuse];
+
+  [self waitForDelegate:waitingDelegate];
+  [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+
+  XCTAssertNotNil(waitingDelegate.image, @"The remaining subscriber should still get the image.");
+  XCTAssertNotNil(waitingView.image);
+  XCTAssertNil(cancelledDelegate.image, @"A cancelled subscriber must not be called back.");
+  XCTAssertNil(cancelledDelegate.error);
+  XCTAssertNil(cancelledView.image);
+  XCTAssertEqual([NITestURLProtocol requestsForURL:url].count, (NSUInteger)1,
+                 @"Both views should have shared one request.");
+}
+
+- (void)testNotModifiedResponsesReuseTheExpiredImage {
+  NSString* path = @"http://images.nimbus.test/revalidated.png";
+  NSURL* url = [NSURL URLWithString:path];
+  [NITestURLProtocol setData:UIImagePNGRepresentation(NIGradientTestImage(CGSizeMake(40, 40)))
+                  statusCode:200
+                headerFields:@{@"Content-Type": @"image/png", @"ETag": @"\"v1\""}
+                      forURL:url];
+
+  NIRecordingImageViewDelegate* delegate = [[NIRecordingImageViewDelegate alloc] init];
+  NINetworkImageView* imageView = [self fixtureImageViewWithDelegate:delegate];
+  imageView.maxAge = 0.2;
+  [imageView setPathToNetworkImage:path forDisplaySize:CGSizeMake(40, 40)];
+  [self waitForDelegate:delegate];
+  UIImage* originalImage = delegate.image;
+  XCTAssertNotNil(originalImage);
+
+  // Let the image expire, after which the server says it hasn't changed.
+  [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.3]];
+  [NITestURLProtocol setData:[NSData data] statusCode:304 headerFields:nil forURL:url];
+  [imageView prepareForReuse];
+  delegate.image = nil;
+  [imageView setPathToNetworkImage:path forDisplaySize:CGSizeMake(40, 40)];
+  [self waitForDelegate:delegate];
+
+  NSArray* requests = [NITestURLProtocol requestsForURL:url];
+  XCTAssertEqual(requests.count, (NSUInteger)2, @"The expired image should have been revalidated.");
+  XCTAssertEqualObjects([[requests lastObject] valueForHTTPHeaderField:@"If-None-Match"], @"\"v1\"");
+  XCTAssertNil(delegate.error, @"A 304 is not a failure.");
+  XCTAssertEqual(delegate.image, originalImage, @"The image we already had should be shown again.");
+
+  // The revalidated image is cached with a fresh lifetime, so it is shown without a request.
+  [imageView prepareForReuse];
+  [imageView setPathToNetworkImage:path forDisplaySize:CGSizeMake(40, 40)];
+  XCTAssertEqual(imageView.image, originalImage);
+  XCTAssertEqual([NITestURLProtocol requestsForURL:url].count, (NSUInteger)2);
+}
+
+- (void)testOnlyPermanentFailuresAreRemembered {
+  NIRecordingImageViewDelegate* delegate = [[NIRecordingImageViewDelegate alloc] init];
+  NINetworkImageView* imageView = [self fixtureImageViewWithDelegate:delegate];
+  NSString* unavailablePath = @"http://images.nimbus.test/unavailable.png";
+  NSString* offlinePath = @"http://images.nimbus.test/offline.png";
+  NSString* missingPath = @"http://images.nimbus.test/missing.png";
+  NSString* garbagePath = @"http://images.nimbus.test/garbage.png";
+  [NITestURLProtocol setData:[NSData data]
+                  statusCode:503
+                headerFields:nil
+                      forURL:[NSURL URLWithString:unavailablePath]];
+  [NITestURLProtocol setFailureForURL:[NSURL URLWithString:offlinePath]];
+  [NITestURLProtocol setData:[@"not an image" dataUsingEncoding:NSUTF8StringEncoding]
+                  statusCode:200
+                headerFields:@{@"Content-Type": @"image/png"}
+                      forURL:[NSURL URLWithString:garbagePath]];
+
+  for (NSString* path in @[unavailablePath, offlinePath, missingPath, garbagePath]) {
+    delegate.error = nil;
+    [imageView setPathToNetworkImage:path];
+    [self waitForDelegate:delegate];
+    XCTAssertNotNil(delegate.error, @"%@ should fail to load.", path);
+  }
+
+  XCTAssertFalse([imageView.failedPathFilter mightContainString:unavailablePath],
+                 @"Server errors are transient.");
+  XCTAssertFalse([imageView.failedPathFilter mightContainString:offlinePath],
+                 @"Being offline says nothing about the path.");
+  XCTAssertTrue([imageView.failedPathFilter mightContainString:missingPath],
+                @"A 404 will be a 404 next time too.");
+  XCTAssertTrue([imageView.failedPathFilter mightContainString:garbagePath],
+                @"Content that can't be decoded won't decode next time either.");
+
+  // A transient failure doesn't stop the path from being requested again.
+  delegate.error = nil;
+  [imageView setPathToNetworkImage:unavailablePath];
+  [self waitForDelegate:delegate];
+  XCTAssertEqual([NITestURLProtocol requestsForURL:[NSURL URLWithString:unavailablePath]].count,
+                 (NSUInteger)2);
+}
+
+- (void)testPathVariantsAreRequestedInsteadOfTheOriginal {
+  NSString* path = @"http://images.nimbus.test/photo.png";
+  NSString* variantPath = @"http://images.nimbus.test/photo.png?w=128";
+  NSData* imageData = UIImagePNGRepresentation(NIGradientTestImage(CGSizeMake(40, 40)));
+  for (NSString* servedPath in @[path, variantPath]) {
+    [NITestURLProtocol setData:imageData
+                    statusCode:200
+                  headerFields:@{@"Content-Type": @"image/png"}
+                        forURL:[NSURL URLWithString:servedPath]];
+  }
+
+  NIRecordingImageViewDelegate* delegate = [[NIRecordingImageViewDelegate alloc] init];
+  NINetworkImageView* imageView = [self fixtureImageViewWithDelegate:delegate];
+  __block NSString* requestedPath = nil;
+  __block CGSize requestedPixelSize = CGSizeZero;
+  imageView.pathVariantBlock = ^NSString *(NSString* pathToNetworkImage, CGSize pixelSize) {
+    requestedPath = pathToNetworkImage;
+    requestedPixelSize = pixelSize;
+    return variantPath;
+  };
+  [imageView setPathToNetworkImage:path forDisplaySize:CGSizeMake(40, 40)];
+  [self waitForDelegate:delegate];
+
+  XCTAssertEqualObjects(requestedPath, path);
+  CGFloat scale = NIScreenScale();
+  XCTAssertTrue(CGSizeEqualToSize(requestedPixelSize, CGSizeMake(40 * scale, 40 * scale)),
+                @"The block should be given the display size in pixels.");
+  XCTAssertNotNil(delegate.image);
+  XCTAssertEqual([NITestURLProtocol requestsForURL:[NSURL URLWithString:variantPath]].count,
+                 (NSUInteger)1);
+  XCTAssertEqual([NITestURLProtocol requestsForURL:[NSURL URLWithString:path]].count,
+                 (NSUInteger)0, @"The original path should not be downloaded.");
+
+  // Blocks that return nil or an empty string keep the original path.
+  for (NSString* noVariant in @[[NSNull null], @""]) {
+    NSUInteger numberOfRequests = [NITestURLProtocol requestsForURL:[NSURL URLWithString:path]].count;
+    NIRecordingImageViewDelegate* fallbackDelegate = [[NIRecordingImageViewDelegate alloc] init];
+    NINetworkImageView* fallbackView = [self fixtureImageViewWithDelegate:fallbackDelegate];
+    fallbackView.pathVariantBlock = ^NSString *(NSString* pathToNetworkImage, CGSize pixelSize) {
+      return [noVariant isKindOfClass:[NSString class]] ? (NSString *)noVariant : nil;
+    };
+    [fallbackView setPathToNetworkImage:path forDisplaySize:CGSizeMake(40, 40)];
+    [self waitForDelegate:fallbackDelegate];
+
+    XCTAssertNotNil(fallbackDelegate.image);
+    XCTAssertEqual([NITestURLProtocol requestsForURL:[NSURL URLWithString:path]].count,
+                   numberOfRequests + 1, @"The original path should be downloaded.");
+  }
+  XCTAssertEqual([NITestURLProtocol requestsForURL:[NSURL URLWithString:variantPath]].count,
+                 (NSUInteger)1);
+}
+
+- (void)testPrefetcherCancelsWhenDirectionFlips {
+  NINetworkImagePrefetcher* prefetcher = [[NINetworkImagePrefetcher alloc] init];
+  prefetcher.imageMemoryCache = [[NIImageMemoryCache alloc] init];
+  prefetcher.networkOperationQueue = [[NSOperationQueue alloc] init];
+  [prefetcher.networkOperationQueue setSuspended:YES];
+
+  NIPrefetchableTestObject* object = [[NIPrefetchableTestObject alloc] init];
+  object.path = @"http://example.com/avatar.png";
+  NIPrefetchableTestModel* model = [[NIPrefetchableTestModel alloc] init];
+  model.objects = @[object, [[NSObject alloc] init]];
+
+  NSArray* indexPaths = @[[NSIndexPath indexPathForRow:0 inSection:0], [NSIndexPath indexPathForRow:1 inSection:0]];
+  [prefetcher prefetchImagesForIndexPaths:indexPaths model:model direction:NINetworkImagePrefetchDirectionForward];
+  XCTAssertEqual([prefetcher numberOfPrefetches], (NSUInteger)1, @"Only prefetchable objects should be prefetched.");
+  XCTAssertEqual([[prefetcher.networkOperationQueue operations].firstObject queuePriority], NSOperationQueuePriorityLow,
+                 @"Prefetches should be made at a low priority.");
+
+  [prefetcher prefetchImagesForIndexPaths:indexPaths model:model direction:NINetworkImagePrefetchDirectionForward];
+  XCTAssertEqual([prefetcher numberOfPrefetches], (NSUInteger)1, @"An image should only be prefetched once.");
+
+  [prefetcher prefetchImagesForIndexPaths:@[] model:model direction:NINetworkImagePrefetchDirectionBackward];
+  XCTAssertEqual([prefetcher numberOfPrefetches], (NSUInteger)0, @"Flipping direction should cancel the prefetches.");
+}
+
+- (void)testSchedulerLimitsOperationsPerHost {
+  NINetworkImageScheduler* scheduler = [[NINetworkImageScheduler alloc] init];
+  scheduler.maxNumberOfConcurrentOperationsPerHost = 1;
+  NSOperationQueue* queue = [[NSOperationQueue alloc] init];
+  [queue setSuspended:YES];
+
+  NSMutableArray* order = [NSMutableArray array];
+  NSOperation* (^operationNamed)(NSString*) = ^NSOperation*(NSString* name) {
+    return [NSBlockOperation blockOperationWithBlock:^{
+      @synchronized(order) {
+        [order addObject:name];
+      }
+    }];
+  };
+  NSOperation* first = operationNamed(@"first");
+  NSOperation* low = operationNamed(@"low");
+  NSOperation* high = operationNamed(@"high");
+  NSOperation* other = operationNamed(@"other");
+  [scheduler addOperation:first forHost:@"slow.example.com" toQueue:queue];
+  [scheduler addOperation:low forHost:@"slow.example.com" toQueue:queue];
+  [scheduler addOperation:high forHost:@"slow.example.com" toQueue:queue];
+  [scheduler addOperation:other forHost:@"fast.example.com" toQueue:queue];
+
+  XCTAssertEqual([scheduler numberOfWaitingOperationsForHost:@"slow.example.com"], (NSUInteger)2, @"The slow host should be at its limit.");
+  XCTAssertEqual([scheduler numberOfWaitingOperationsForHost:@"fast.example.com"], (NSUInteger)0, @"Other hosts should not wait.");
+  XCTAssertTrue([queue.operations containsObject:other], @"The other host's operation should be queued.");
+
+  // Raising the priority of a waiting operation moves it up the line.
+  high.queuePriority = NSOperationQueuePriorityVeryHigh;
+  [queue setSuspended:NO];
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  while (![low isFinished] && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  NSArray* slowOrder = [order filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"SELF != 'other'"]];
+  XCTAssertEqualObjects(slowOrder, (@[@"first", @"high", @"low"]), @"Waiting operations should start by priority.");
+}
+
+- (void)testPrefetcherSkipsCachedImages {
+  NINetworkImagePrefetcher* prefetcher = [[NINetworkImagePrefetcher alloc] init];
+  prefetcher.imageMemoryCache = [[NIImageMemoryCache alloc] init];
+  prefetcher.networkOperationQueue = [[NSOperationQueue alloc] init];
+  [prefetcher.networkOperationQueue setSuspended:YES];
+
+  // Cache the image under the key that an image view for the same size would use.
+  NINetworkImageView* imageView = [[NINetworkImageView alloc] initWithFrame:CGRectMake(0, 0, 10, 10)];
+  NSString* path = @"http://example.com/cached.png";
+  NSString* cacheKey = [path stringByAppendingFormat:@"%@%@{%@,%@}",
+                        NSStringFromCGSize(CGSizeMake(10, 10)), NSStringFromCGRect(CGRectZero),
+                        [@(UIViewContentModeScaleAspectFill) stringValue], [@(imageView.scaleOptions) stringValue]];
+  UIGraphicsBeginImageContext(CGSizeMake(10, 10));
+  UIImage* image = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  [prefetcher.imageMemoryCache storeObject:image withName:cacheKey];
+
+  [prefetcher prefetchImageWithPath:path displaySize:CGSizeMake(10, 10) contentMode:UIViewContentModeScaleAspectFill];
+  XCTAssertEqual([prefetcher numberOfPrefetches], (NSUInteger)0, @"Cached images should not be fetched.");
+  XCTAssertEqual([prefetcher.networkOperationQueue operationCount], (NSUInteger)0, @"No request should have been made.");
+}
+
+- (void)testImageProcessingDownsamplesEncodedData {
+  UIGraphicsBeginImageContextWithOptions(CGSizeMake(400, 300), YES, 1);
+  [[UIColor redColor] setFill];
+  UIRectFill(CGRectMake(0, 0, 400, 300));
+  UIImage* image = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  NSData* data = UIImagePNGRepresentation(image);
+
+  CGSize displaySize = CGSizeMake(40, 40);
+  UIImage* downsampled = [NIImageProcessing imageFromData:data
+                                          withContentMode:UIViewContentModeScaleAspectFill
+                                                 cropRect:CGRectZero
+                                              displaySize:displaySize
+                                             scaleOptions:NINetworkImageViewScaleToFitLeavesExcessAndScaleToFillCropsExcess
+                                     interpolationQuality:kCGInterpolationDefault
+                                         resamplingEngine:NINetworkImageViewResamplingEngineCoreGraphics];
+  XCTAssertNotNil(downsampled, @"A large image should be downsampled.");
+  XCTAssertTrue(CGSizeEqualToSize(downsampled.size, displaySize), @"The image should fill the display size.");
+
+  XCTAssertNil([NIImageProcessing imageFromData:data
+                                withContentMode:UIViewContentModeScaleAspectFill
+                                       cropRect:CGRectMake(0.25, 0.25, 0.5, 0.5)
+                                    displaySize:displaySize
+                                   scaleOptions:NINetworkImageViewScaleToFitLeavesExcessAndScaleToFillCropsExcess
+                           interpolationQuality:kCGInterpolationDefault
+                               resamplingEngine:NINetworkImageViewResamplingEngineCoreGraphics],
+               @"Crop rects need the full source image.");
+  XCTAssertNil([NIImageProcessing imageFromData:data
+                                withContentMode:UIViewContentModeCenter
+                                       cropRect:CGRectZero
+                                    displaySize:displaySize
+                                   scaleOptions:NINetworkImageViewScaleToFitLeavesExcessAndScaleToFillCropsExcess
+                           interpolationQuality:kCGInterpolationDefault
+                               resamplingEngine:NINetworkImageViewResamplingEngineCoreGraphics],
+               @"Content modes that don't scale need the full source image.");
+}
+
+- (void)testFilePathsAreDecodedAtTheDisplaySize {
+  NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"NINetworkImageViewTests.png"];
+  [UIImagePNGRepresentation(NIGradientTestImage(CGSizeMake(400, 300))) writeToFile:path atomically:YES];
+
+  NINetworkImageView* imageView = [[NINetworkImageView alloc] init];
+  imageView.imageMemoryCache = [[NIImageMemoryCache alloc] init];
+  imageView.processedImageDiskCache = nil;
+  imageView.failedPathFilter = nil;
+  imageView.networkOperationQueue = [[NSOperationQueue alloc] init];
+  CGSize displaySize = CGSizeMake(40, 40);
+  [imageView setPathToNetworkImage:path forDisplaySize:displaySize contentMode:UIViewContentModeScaleAspectFill];
+  XCTAssertNil(imageView.image, @"The file should be read off the main thread.");
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (nil == imageView.image && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+
+  XCTAssertTrue(CGSizeEqualToSize(imageView.image.size, displaySize), @"The file should be decoded at the display size.");
+  XCTAssertEqual(imageView.imageMemoryCache.count, (NSUInteger)1, @"Files should be cached like network images.");
+}
+
+- (void)testImagesAreHeldWhileScrollingFast {
+  NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"NINetworkImageViewScrollTests.png"];
+  [UIImagePNGRepresentation(NIGradientTestImage(CGSizeMake(40, 40))) writeToFile:path atomically:YES];
+
+  NIDraggedTestScrollView* scrollView = [[NIDraggedTestScrollView alloc] initWithFrame:CGRectMake(0, 0, 100, 100)];
+  scrollView.contentSize = CGSizeMake(100, 100000);
+  scrollView.isBeingDragged = YES;
+  NINetworkImageView* imageView = [[NINetworkImageView alloc] initWithFrame:CGRectMake(0, 0, 40, 40)];
+  [scrollView addSubview:imageView];
+  imageView.imageMemoryCache = [[NIImageMemoryCache alloc] init];
+  imageView.processedImageDiskCache = nil;
+  imageView.failedPathFilter = nil;
+  imageView.networkOperationQueue = [[NSOperationQueue alloc] init];
+  imageView.maxScrollSpeedForImageCommits = 100;
+  [imageView setPathToNetworkImage:path forDisplaySize:CGSizeMake(40, 40)];
+
+  // Scroll far faster than the limit while the image loads.
+  NSDate* flingEnd = [NSDate dateWithTimeIntervalSinceNow:1];
+  while ([flingEnd timeIntervalSinceNow] > 0) {
+    scrollView.contentOffset = CGPointMake(0, scrollView.contentOffset.y + 50);
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertEqual(imageView.imageMemoryCache.count, (NSUInteger)1, @"The image should be cached before it is committed.");
+  XCTAssertNil(imageView.image, @"The image should be held while scrolling fast.");
+
+  scrollView.isBeingDragged = NO;
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (nil == imageView.image && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+
+  XCTAssertNotNil(imageView.image, @"The image should be committed once the scroll view stops.");
+}
+
+- (void)testHeldImagesStayCachedWhenTheViewIsReused {
+  NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"NINetworkImageViewReuseTests.png"];
+  [UIImagePNGRepresentation(NIGradientTestImage(CGSizeMake(40, 40))) writeToFile:path atomically:YES];
+
+  NIDraggedTestScrollView* scrollView = [[NIDraggedTestScrollView alloc] initWithFrame:CGRectMake(0, 0, 100, 100)];
+  scrollView.contentSize = CGSizeMake(100, 100000);
+  scrollView.isBeingDragged = YES;
+  NINetworkImageView* imageView = [[NINetworkImageView alloc] initWithFrame:CGRectMake(0, 0, 40, 40)];
+  [scrollView addSubview:imageView];
+  imageView.imageMemoryCache = [[NIImageMemoryCache alloc] init];
+  imageView.processedImageDiskCache = nil;
+  imageView.failedPathFilter = nil;
+  imageView.networkOperationQueue = [[NSOperationQueue alloc] init];
+  imageView.maxScrollSpeedForImageCommits = 100;
+  [imageView setPathToNetworkImage:path forDisplaySize:CGSizeMake(40, 40)];
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (0 == imageView.imageMemoryCache.count && [timeout timeIntervalSinceNow] > 0) {
+    scrollView.contentOffset = CGPointMake(0, scrollView.contentOffset.y + 50);
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertNil(imageView.image, @"The image should be held while scrolling fast.");
+
+  // A cell that scrolls away mid-fling is reused before its image is committed.
+  [imageView prepareForReuse];
+  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+
+  XCTAssertEqual(imageView.imageMemoryCache.count, (NSUInteger)1, @"Reuse must not drop the cached image.");
+  [imageView setPathToNetworkImage:path forDisplaySize:CGSizeMake(40, 40)];
+  XCTAssertNotNil(imageView.image, @"The image should come from the memory cache, not the deleted file.");
+}
+
+- (void)testResponseDiskCacheAnswersSessionRequests {
+  NSString* directory = [NSTemporaryDirectory() stringByAppendingPathComponent:@"NIResponseDiskCacheTests"];
+  [[NSFileManager defaultManager] removeItemAtPath:directory error:nil];
+  NIDiskCache* responseDiskCache = [[NIDiskCache alloc] initWithPath:directory];
+  // Nothing serves this host, so the image can only come from the disk cache.
+  NSString* path = @"http://images.nimbus.test/cached-response.png";
+  [responseDiskCache storeData:UIImagePNGRepresentation(NIGradientTestImage(CGSizeMake(80, 80))) withName:path];
+  [responseDiskCache waitUntilAllWritesAreFinished];
+
+  NIRecordingImageViewDelegate* delegate = [[NIRecordingImageViewDelegate alloc] init];
+  NINetworkImageView* imageView = [self fixtureImageViewWithDelegate:delegate];
+  imageView.transport = NINetworkImageTransportSession;
+  imageView.responseDiskCache = responseDiskCache;
+  [imageView setPathToNetworkImage:path forDisplaySize:CGSizeMake(40, 40)];
+  [self waitForDelegate:delegate];
+
+  XCTAssertNil(delegate.error);
+  XCTAssertTrue(CGSizeEqualToSize(delegate.image.size, CGSizeMake(40, 40)),
+                @"The cached response should be decoded at the display size.");
+  XCTAssertEqual([NITestURLProtocol requestsForURL:[NSURL URLWithString:path]].count, (NSUInteger)0);
+  [[NSFileManager defaultManager] removeItemAtPath:directory error:nil];
+}
+
+- (void)testImageDecodersNegotiateCompactFormats {
+  NSData* data = UIImagePNGRepresentation(NIGradientTestImage(CGSizeMake(40, 30)));
+  XCTAssertTrue([[NIImageIODecoder decoder] canDecodeData:data]);
+  XCTAssertTrue(CGSizeEqualToSize([[NIImageIODecoder decoder] pixelSizeOfImageWithData:data], CGSizeMake(40, 30)));
+  XCTAssertFalse([[NIImageIODecoder HEICDecoder] canDecodeData:data], @"Decoders should only decode their own format.");
+  XCTAssertFalse([[NIImageIODecoder WebPDecoder] canDecodeData:data], @"Decoders should only decode their own format.");
+
+  NIImageResponseSerializer* serializer = [NIImageResponseSerializer serializer];
+  XCTAssertTrue([[serializer acceptHeaderValue] hasSuffix:@"image/*;q=0.8"], @"Other image types should be accepted last.");
+  for (NSString* contentType in [[NIImageIODecoder WebPDecoder] contentTypes]) {
+    XCTAssertTrue([serializer.acceptableContentTypes containsObject:contentType]);
+    XCTAssertTrue([[serializer acceptHeaderValue] rangeOfString:contentType].location != NSNotFound);
+  }
+}
+
+- (void)testSerializersStorePlaceholdersOfProcessedImages {
+  UIGraphicsBeginImageContextWithOptions(CGSizeMake(80, 40), YES, 1);
+  [[UIColor colorWithRed:1 green:0.5 blue:0 alpha:1] setFill];
+  UIRectFill(CGRectMake(0, 0, 80, 40));
+  UIImage* source = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+
+  NIMemoryCache* placeholderMemoryCache = [[NIMemoryCache alloc] init];
+  NIImageResponseSerializer* serializer = [NIImageResponseSerializer serializer];
+  serializer.placeholderMemoryCache = placeholderMemoryCache;
+  serializer.placeholderName = @"orange";
+  XCTAssertNotNil([serializer responseObjectForResponse:nil data:UIImagePNGRepresentation(source) error:NULL]);
+
+  NIImagePlaceholder* placeholder = [placeholderMemoryCache objectWithName:@"orange"];
+  XCTAssertTrue(CGSizeEqualToSize(placeholder.thumbnail.size, CGSizeMake(16, 8)), @"Thumbnails should keep the aspect ratio.");
+  CGFloat red, green, blue, alpha;
+  XCTAssertTrue([placeholder.averageColor getRed:&red green:&green blue:&blue alpha:&alpha]);
+  XCTAssertEqualWithAccuracy(red, 1, 0.02);
+  XCTAssertEqualWithAccuracy(green, 0.5, 0.02);
+  XCTAssertEqualWithAccuracy(blue, 0, 0.02);
+  XCTAssertEqualWithAccuracy(alpha, 1, 0.02);
+}
+
+- (void)testVImageResamplingMatchesCoreGraphics {
+  UIImage* source = NIGradientTestImage(CGSizeMake(400, 300));
+  for (NSNumber* contentMode in @[@(UIViewContentModeScaleAspectFit), @(UIViewContentModeScaleAspectFill)]) {
+    UIImage* images[2];
+    NINetworkImageViewResamplingEngine engines[2] = {
+      NINetworkImageViewResamplingEngineCoreGraphics, NINetworkImageViewResamplingEngineVImage
+    };
+    for (NSInteger ix = 0; ix < 2; ++ix) {
+      images[ix] = [NIImageProcessing imageFromSource:source
+                                      withContentMode:[contentMode intValue]
+                                             cropRect:CGRectZero
+                                          displaySize:CGSizeMake(97, 61)
+                                         scaleOptions:NINetworkImageViewScaleToFitLeavesExcessAndScaleToFillCropsExcess
+                                 interpolationQuality:kCGInterpolationHigh
+                                     resamplingEngine:engines[ix]];
+    }
+    XCTAssertTrue(CGSizeEqualToSize(images[0].size, images[1].size), @"Both engines should produce the same size.");
+    XCTAssertEqual(images[0].scale, images[1].scale, @"Both engines should produce the same scale.");
+    XCTAssertLessThan(NIMeanPixelDifference(images[0], images[1]), (CGFloat)4,
+                      @"vImage should closely match CoreGraphics for content mode %@.", contentMode);
+  }
+}
+
+- (void)measureResamplingEngine:(NINetworkImageViewResamplingEngine)resamplingEngine {
+  UIImage* source = NIGradientTestImage(CGSizeMake(1600, 1200));
+  [self measureBlock:^{
+    for (NSInteger ix = 0; ix < 10; ++ix) {
+      @autoreleasepool {
+        [NIImageProcessing imageFromSource:source
+                           withContentMode:UIViewContentModeScaleAspectFill
+                                  cropRect:CGRectZero
+                               displaySize:CGSizeMake(80, 80)
+                              scaleOptions:NINetworkImageViewScaleToFitLeavesExcessAndScaleToFillCropsExcess
+                      interpolationQuality:kCGInterpolationHigh
+                          resamplingEngine:resamplingEngine];
+      }
+    }
+  }];
+}
+
+- (void)testPerformanceOfCoreGraphicsResampling {
+  [self measureResamplingEngine:NINetworkImageViewResamplingEngineCoreGraphics];
+}
+
+- (void)testPerformanceOfVImageResampling {
+  [self measureResamplingEngine:NINetworkImageViewResamplingEngineVImage];
+}
+
+- (void)testDecodedImagesAreDisplayNative {
+  UIImage* source = NIGradientTestImage(CGSizeMake(40, 30));
+  UIImage* image = [UIImage imageWithData:UIImagePNGRepresentation(source) scale:2];
+
+  UIImage* decoded = [NIImageProcessing decodedImageFromImage:image];
+  XCTAssertTrue(CGSizeEqualToSize(decoded.size, image.size), @"Decoding should not change the size.");
+  XCTAssertEqual(decoded.scale, image.scale, @"Decoding should not change the scale.");
+  CGBitmapInfo bitmapInfo = CGImageGetBitmapInfo(decoded.CGImage);
+  XCTAssertEqual((bitmapInfo & kCGBitmapByteOrderMask), (CGBitmapInfo)kCGBitmapByteOrder32Little, @"Decoded images should be BGRA.");
+  XCTAssertLessThan(NIMeanPixelDifference(source, decoded), (CGFloat)1, @"Decoding should not change the pixels.");
+}
+
+- (void)testMappableImagesRoundTrip {
+  UIImage* source = NIGradientTestImage(CGSizeMake(40, 30));
+  UIImage* image = [UIImage imageWithData:UIImagePNGRepresentation(source) scale:2];
+
+  NSData* data = [NIImageProcessing mappableDataFromImage:image];
+  XCTAssertNotNil(data, @"Decodable images should be mappable.");
+
+  UIImage* mapped = [NIImageProcessing imageFromMappableData:data];
+  XCTAssertTrue(CGSizeEqualToSize(mapped.size, image.size), @"Mapping should not change the size.");
+  XCTAssertEqual(mapped.scale, image.scale, @"Mapping should not change the scale.");
+  XCTAssertLessThan(NIMeanPixelDifference(source, mapped), (CGFloat)1, @"Mapping should not change the pixels.");
+
+  XCTAssertNil([NIImageProcessing imageFromMappableData:UIImagePNGRepresentation(source)],
+               @"Data that wasn't written as a mappable image should be rejected.");
+  XCTAssertNil([NIImageProcessing imageFromMappableData:[data subdataWithRange:NSMakeRange(0, data.length / 2)]],
+               @"Truncated data should be rejected.");
+}
+
+- (void)testProgressiveDecoderWaitsForTheHeader {
+  NSData* data = UIImageJPEGRepresentation(NIGradientTestImage(CGSizeMake(200, 150)), 0.8);
+
+  NIProgressiveImageDecoder* decoder = [[NIProgressiveImageDecoder alloc] init];
+  decoder.displaySize = CGSizeMake(40, 30);
+  decoder.contentMode = UIViewContentModeScaleAspectFill;
+
+  XCTAssertNil([decoder partialImageWithData:[data subdataWithRange:NSMakeRange(0, 8)]],
+               @"No image can be decoded before the header arrives.");
+
+  UIImage* image = [decoder partialImageWithData:data];
+  XCTAssertNotNil(image, @"The complete data should decode.");
+  XCTAssertTrue(CGSizeEqualToSize(image.size, decoder.displaySize), @"Partial images are sized for display.");
+}
+
+- (void)testAnimatedImagesDecodeFramesOnDemand {
+  NSArray* frames = @[NIGradientTestImage(CGSizeMake(40, 30)),
+                      NIGradientTestImage(CGSizeMake(40, 30)),
+                      NIGradientTestImage(CGSizeMake(40, 30))];
+  NSMutableData* data = [NSMutableData data];
+  CGImageDestinationRef destination = CGImageDestinationCreateWithData((__bridge CFMutableDataRef)data, kUTTypeGIF, frames.count, NULL);
+  NSDictionary* frameProperties = @{(__bridge NSString *)kCGImagePropertyGIFDictionary:
+                                      @{(__bridge NSString *)kCGImagePropertyGIFDelayTime: @0.5}};
+  for (UIImage* frame in frames) {
+    CGImageDestinationAddImage(destination, frame.CGImage, (__bridge CFDictionaryRef)frameProperties);
+  }
+  XCTAssertTrue(CGImageDestinationFinalize(destination), @"The GIF should be written.");
+  CFRelease(destination);
+
+  NIAnimatedImage* image = [NIAnimatedImage animatedImageWithData:data frameBlock:nil];
+  XCTAssertEqual(image.numberOfFrames, (NSUInteger)3, @"Every frame should be counted.");
+  XCTAssertEqualWithAccuracy([image durationOfFrameAtIndex:1], 0.5, 0.01, @"Frame durations come from the GIF.");
+  XCTAssertTrue(CGSizeEqualToSize(image.size, CGSizeMake(40, 30)), @"The image is its first frame.");
+  XCTAssertGreaterThan(image.memoryCost, (unsigned long long)data.length, @"Decoded frames are part of the cost.");
+
+  XCTAssertEqual([image frameAtIndex:0], image, @"The first frame is always available.");
+  UIImage* frame = nil;
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  while (nil == (frame = [image frameAtIndex:1]) && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertNotNil(frame, @"Later frames are decoded in the background.");
+
+  XCTAssertNil([NIAnimatedImage animatedImageWithData:UIImagePNGRepresentation(frames[0]) frameBlock:nil],
+               @"Still images are not animated.");
+}
+
+- (void)testImageStylesAreBakedIntoTheBitmap {
+  UIImage* source = NIGradientTestImage(CGSizeMake(40, 40));
+
+  NIImageStyle* style = [[NIImageStyle alloc] init];
+  style.clipsToCircle = YES;
+  style.backgroundColor = [UIColor colorWithRed:0 green:0 blue:1 alpha:1];
+  XCTAssertTrue([style isOpaque], @"An opaque background makes an opaque image.");
+
+  UIImage* styledImage = [NIImageProcessing imageFromImage:source withStyle:style];
+  XCTAssertTrue(CGSizeEqualToSize(styledImage.size, source.size), @"Styling keeps the size.");
+  CGImageAlphaInfo alphaInfo = (CGImageAlphaInfo)(CGImageGetBitmapInfo(styledImage.CGImage) & kCGBitmapAlphaInfoMask);
+  XCTAssertEqual(alphaInfo, kCGImageAlphaNoneSkipFirst, @"The styled image should have no alpha.");
+
+  CFDataRef data = CGDataProviderCopyData(CGImageGetDataProvider(styledImage.CGImage));
+  const uint8_t* corner = CFDataGetBytePtr(data);
+  XCTAssertEqual(corner[0], (uint8_t)255, @"The clipped corner should show the background's blue.");
+  XCTAssertEqual(corner[2], (uint8_t)0, @"The clipped corner should have no red.");
+  CFRelease(data);
+
+  NIImageStyle* equalStyle = [style copy];
+  XCTAssertEqualObjects(style, equalStyle, @"Styles are compared by value.");
+  NINetworkImageCacheKey* key = [[NINetworkImageCacheKey alloc] initWithCacheIdentifier:@"path"
+                                                                            displaySize:CGSizeMake(10, 10)
+                                                                               cropRect:CGRectZero
+                                                                            contentMode:UIViewContentModeScaleAspectFill
+                                                                           scaleOptions:NINetworkImageViewScaleToFitLeavesExcessAndScaleToFillCropsExcess
+                                                                         sizeForDisplay:NO
+                                                                                  style:style];
+  XCTAssertEqualObjects([key memoryCacheName], [@"path" stringByAppendingString:[style cacheName]],
+                        @"Styled images have their own cache names.");
+}
+
+- (void)testImagePipelineSharesLeadingStages {
+  __block NSInteger numberOfFlips = 0;
+  NIBlockImageProcessor* flip = [NIBlockImageProcessor processorWithIdentifier:@"flip" block:^UIImage *(UIImage *image) {
+    @synchronized(self) {
+      numberOfFlips++;
+    }
+    return [UIImage imageWithCGImage:image.CGImage scale:image.scale orientation:UIImageOrientationUpMirrored];
+  }];
+  NIBlockImageProcessor* identity = [NIBlockImageProcessor processorWithIdentifier:@"identity" block:^UIImage *(UIImage *image) {
+    return image;
+  }];
+  NIBlockImageProcessor* failure = [NIBlockImageProcessor processorWithIdentifier:@"failure" block:^UIImage *(UIImage *image) {
+    return nil;
+  }];
+  XCTAssertEqualObjects([NIImagePipeline identifierForProcessors:@[flip, identity]], @"flip,identity");
+  XCTAssertNil([NIImagePipeline identifierForProcessors:nil]);
+
+  NIImagePipeline* pipeline = [[NIImagePipeline alloc] initWithQueue:dispatch_queue_create("test", DISPATCH_QUEUE_CONCURRENT)];
+  UIImage* source = NIGradientTestImage(CGSizeMake(10, 10));
+  __block NSInteger numberOfCompletions = 0;
+  __block UIImage* failedImage = source;
+  void (^completion)(UIImage*) = ^(UIImage* image) {
+    XCTAssertEqual(image.imageOrientation, UIImageOrientationUpMirrored, @"Every stage should have run.");
+    numberOfCompletions++;
+  };
+  [pipeline processImage:source withName:@"source" processors:@[flip, identity] completion:completion];
+  [pipeline processImage:source withName:@"source" processors:@[flip] completion:completion];
+  [pipeline processImage:source withName:@"source" processors:@[flip, failure, identity] completion:^(UIImage* image) {
+    failedImage = image;
+    numberOfCompletions++;
+  }];
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (numberOfCompletions < 3 && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertEqual(numberOfCompletions, (NSInteger)3);
+  XCTAssertEqual(numberOfFlips, (NSInteger)1, @"The shared first stage should only run once.");
+  XCTAssertNil(failedImage, @"A failed stage should end the pipeline.");
+
+  NINetworkImageCacheKey* key = [[NINetworkImageCacheKey alloc] initWithCacheIdentifier:@"path"
+                                                                            displaySize:CGSizeZero
+                                                                               cropRect:CGRectZero
+                                                                            contentMode:UIViewContentModeScaleToFill
+                                                                           scaleOptions:NINetworkImageViewScaleToFitLeavesExcessAndScaleToFillCropsExcess
+                                                                         sizeForDisplay:NO
+                                                                                  style:nil
+                                                                    processorIdentifier:@"flip"];
+  XCTAssertEqualObjects([key memoryCacheName], @"path<flip>", @"Processed images have their own cache names.");
+}
+
+- (void)testImagePipelineDoesNotReuseStagesOfAnotherSourceWithTheSameName {
+  NIBlockImageProcessor* identity = [NIBlockImageProcessor processorWithIdentifier:@"identity" block:^UIImage *(UIImage *image) {
+    return image;
+  }];
+  NIImagePipeline* pipeline = [[NIImagePipeline alloc] initWithQueue:dispatch_queue_create("test", DISPATCH_QUEUE_CONCURRENT)];
+  UIImage* firstSource = NIGradientTestImage(CGSizeMake(10, 10));
+  UIImage* secondSource = NIGradientTestImage(CGSizeMake(20, 20));
+
+  __block UIImage* firstResult = nil;
+  [pipeline processImage:firstSource withName:@"source" processors:@[identity] completion:^(UIImage* image) {
+    firstResult = image;
+  }];
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (nil == firstResult && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+
+  __block UIImage* secondResult = nil;
+  [pipeline processImage:secondSource withName:@"source" processors:@[identity] completion:^(UIImage* image) {
+    secondResult = image;
+  }];
+  timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (nil == secondResult && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+
+  XCTAssertEqual(firstResult, firstSource);
+  XCTAssertEqual(secondResult, secondSource, @"A new source image should be processed again.");
+}
+
+- (void)testImagePipelineLimitsConcurrentStages {
+  __block NSInteger numberOfRunningStages = 0;
+  __block NSInteger maxNumberOfRunningStages = 0;
+  NIBlockImageProcessor* slow = [NIBlockImageProcessor processorWithIdentifier:@"slow" block:^UIImage *(UIImage *image) {
+    @synchronized(self) {
+      numberOfRunningStages++;
+      maxNumberOfRunningStages = MAX(maxNumberOfRunningStages, numberOfRunningStages);
+    }
+    [NSThread sleepForTimeInterval:0.01];
+    @synchronized(self) {
+      numberOfRunningStages--;
+    }
+    return image;
+  }];
+
+  NIImagePipeline* pipeline = [[NIImagePipeline alloc] initWithQueue:dispatch_queue_create("test", DISPATCH_QUEUE_CONCURRENT)];
+  pipeline.maxConcurrentStageCount = 2;
+  UIImage* source = NIGradientTestImage(CGSizeMake(10, 10));
+  __block NSInteger numberOfCompletions = 0;
+  for (NSInteger ix = 0; ix < 8; ++ix) {
+    [pipeline processImage:source withName:[@(ix) stringValue] processors:@[slow] completion:^(UIImage* image) {
+      numberOfCompletions++;
+    }];
+  }
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (numberOfCompletions < 8 && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertEqual(numberOfCompletions, (NSInteger)8, @"Waiting stages should all run eventually.");
+  XCTAssertTrue(maxNumberOfRunningStages <= 2, @"No more than the limit should run at once.");
+}
+
+- (void)testSessionsRegisterImageHostsOnce {
+  NINetworkImageSession* session = [[NINetworkImageSession alloc] initWithConfiguration:[NSURLSessionConfiguration ephemeralSessionConfiguration]];
+  [session addImageHostWithURL:[NSURL URLWithString:@"https://Images.example.invalid/avatars/1.png"]];
+  [session addImageHostWithURL:[NSURL URLWithString:@"https://images.example.invalid/avatars/2.png"]];
+  [session addImageHostWithURL:[NSURL URLWithString:@"https://images.example.invalid:8443/3.png"]];
+  [session addImageHostWithURL:[NSURL fileURLWithPath:@"/tmp/4.png"]];
+  NSSet* hostURLs = [NSSet setWithArray:[session imageHostURLs]];
+  NSSet* expectedHostURLs = [NSSet setWithObjects:
+                             [NSURL URLWithString:@"https://images.example.invalid/"],
+                             [NSURL URLWithString:@"https://images.example.invalid:8443/"],
+                             nil];
+  XCTAssertEqualObjects(hostURLs, expectedHostURLs, @"Hosts should be registered by scheme, host and port.");
+
+  [session removeImageHostWithURL:[NSURL URLWithString:@"https://images.example.invalid/5.png"]];
+  XCTAssertEqual([session imageHostURLs].count, (NSUInteger)1);
+}
+
+- (void)testCacheManifestsReplayRecentImagesFromDisk {
+  NSString* directory = [NSTemporaryDirectory() stringByAppendingPathComponent:@"NICacheManifestTests"];
+  [[NSFileManager defaultManager] removeItemAtPath:directory error:nil];
+  NIDiskCache* diskCache = [[NIDiskCache alloc] initWithPath:[directory stringByAppendingPathComponent:@"images"]];
+  NIImageMemoryCache* memoryCache = [[NIImageMemoryCache alloc] init];
+  NSData* data = [NIImageProcessing mappableDataFromImage:NIGradientTestImage(CGSizeMake(20, 20))];
+  for (NSString* name in @[@"a", @"b", @"c"]) {
+    [diskCache storeData:data withName:name];
+    [memoryCache storeObject:[NIImageProcessing imageFromMappableData:data] withName:name];
+  }
+  [diskCache waitUntilAllWritesAreFinished];
+  [memoryCache objectWithName:@"a"];
+
+  NINetworkImageCacheManifest* manifest = [[NINetworkImageCacheManifest alloc] initWithPath:[directory stringByAppendingPathComponent:@"manifest.plist"]];
+  manifest.imageMemoryCache = memoryCache;
+  manifest.processedImageDiskCache = diskCache;
+  manifest.maxNumberOfNames = 2;
+  XCTAssertTrue([manifest writeManifest]);
+  XCTAssertEqualObjects([manifest namesInManifest], (@[@"a", @"c"]), @"The most recently used names should be recorded first.");
+
+  [memoryCache removeAllObjects];
+  __block NSUInteger numberOfImagesLoaded = NSNotFound;
+  [manifest replayWithCompletion:^(NSUInteger count) {
+    numberOfImagesLoaded = count;
+  }];
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (NSNotFound == numberOfImagesLoaded && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertEqual(numberOfImagesLoaded, (NSUInteger)2);
+  XCTAssertTrue([memoryCache containsObjectWithName:@"a"]);
+  XCTAssertFalse([memoryCache containsObjectWithName:@"b"], @"Names left out of the manifest should not be replayed.");
+}
+
+- (void)testCacheKeysMatchCacheNames {
+  NSString* path = @"http://example.com/image.png";
+  NINetworkImageCacheKey* key = [[NINetworkImageCacheKey alloc] initWithCacheIdentifier:path
+                                                                            displaySize:CGSizeMake(10, 20)
+                                                                               cropRect:CGRectZero
+                                                                            contentMode:UIViewContentModeScaleAspectFill
+                                                                           scaleOptions:NINetworkImageViewScaleToFitLeavesExcessAndScaleToFillCropsExcess
+                                                                         sizeForDisplay:YES];
+  NINetworkImageCacheKey* equalKey = [[NINetworkImageCacheKey alloc] initWithCacheIdentifier:[path mutableCopy]
+                                                                                 displaySize:CGSizeMake(10, 20)
+                                                                                    cropRect:CGRectZero
+                                                                                 contentMode:UIViewContentModeScaleAspectFill
+                                                                                scaleOptions:NINetworkImageViewScaleToFitLeavesExcessAndScaleToFillCropsExcess
+                                                                              sizeForDisplay:YES];
+  NINetworkImageCacheKey* otherKey = [[NINetworkImageCacheKey alloc] initWithCacheIdentifier:path
+                                                                                 displaySize:CGSizeMake(20, 10)
+                                                                                    cropRect:CGRectZero
+                                                                                 contentMode:UIViewContentModeScaleAspectFill
+                                                                                scaleOptions:NINetworkImageViewScaleToFitLeavesExcessAndScaleToFillCropsExcess
+                                                                              sizeForDisplay:YES];
+  XCTAssertEqualObjects(key, equalKey, @"Keys with the same fields should be equal.");
+  XCTAssertEqual([key hash], [equalKey hash], @"Equal keys should have equal hashes.");
+  XCTAssertNotEqualObjects(key, otherKey, @"Keys with different sizes should differ.");
+
+  NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] init];
+  UIImage* image = NIGradientTestImage(CGSizeMake(10, 20));
+  [cache storeObject:image withName:[key memoryCacheName]];
+  XCTAssertEqual([cache objectWithKey:equalKey], image, @"Objects stored by name should be found by key.");
+  XCTAssertNil([cache objectWithKey:otherKey], @"Other keys should miss.");
+
+  [cache storeObject:image withKey:otherKey expiresAfter:nil];
+  XCTAssertTrue([cache containsObjectWithName:[otherKey memoryCacheName]], @"Objects stored by key should be found by name.");
+}
+
+- (void)testVariantLookupsFindTheSmallestCoveringSize {
+  NSString* path = @"http://example.com/avatar.png";
+  NINetworkImageCacheKey* (^keyOfSize)(CGSize) = ^(CGSize size) {
+    return [[NINetworkImageCacheKey alloc] initWithCacheIdentifier:path
+                                                       displaySize:size
+                                                          cropRect:CGRectZero
+                                                       contentMode:UIViewContentModeScaleAspectFill
+                                                      scaleOptions:NINetworkImageViewScaleToFitLeavesExcessAndScaleToFillCropsExcess
+                                                    sizeForDisplay:YES];
+  };
+  NINetworkImageCacheKey* smallKey = keyOfSize(CGSizeMake(60, 60));
+  NINetworkImageCacheKey* mediumKey = keyOfSize(CGSizeMake(120, 120));
+  NINetworkImageCacheKey* largeKey = keyOfSize(CGSizeMake(240, 240));
+  NINetworkImageCacheKey* wideKey = keyOfSize(CGSizeMake(240, 120));
+  XCTAssertEqualObjects(smallKey.variantGroupName, largeKey.variantGroupName, @"Sizes of one image should share a group.");
+
+  NIImageMemoryCache* cache = [[NIImageMemoryCache alloc] init];
+  for (NINetworkImageCacheKey* key in @[mediumKey, largeKey, wideKey]) {
+    [cache storeObject:NIGradientTestImage(key.displaySize) withKey:key expiresAfter:nil];
+    [cache addVariantWithName:[key memoryCacheName] size:key.displaySize toGroup:key.variantGroupName];
+  }
+
+  XCTAssertEqualObjects([cache nameOfSmallestVariantInGroup:smallKey.variantGroupName coveringSize:smallKey.displaySize],
+                        [mediumKey memoryCacheName], @"The smallest square variant should be picked.");
+
+  [cache removeObjectWithKey:mediumKey];
+  XCTAssertEqualObjects([cache nameOfSmallestVariantInGroup:smallKey.variantGroupName coveringSize:smallKey.displaySize],
+                        [largeKey memoryCacheName], @"Evicted variants should be skipped.");
+  XCTAssertNil([cache nameOfSmallestVariantInGroup:smallKey.variantGroupName coveringSize:CGSizeMake(480, 480)],
+               @"No variant should cover a larger size.");
+
+  NINetworkImageCacheKey* croppedKey = [[NINetworkImageCacheKey alloc] initWithCacheIdentifier:path
+                                                                                  displaySize:CGSizeMake(60, 60)
+                                                                                     cropRect:CGRectMake(0, 0, 10, 10)
+                                                                                  contentMode:UIViewContentModeScaleAspectFill
+                                                                                 scaleOptions:NINetworkImageViewScaleToFitLeavesExcessAndScaleToFillCropsExcess
+                                                                               sizeForDisplay:YES];
+  XCTAssertNil(croppedKey.variantGroupName, @"Cropped images don't scale and have no group.");
+}
+
 @end
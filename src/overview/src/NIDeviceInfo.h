@@ -25,6 +25,23 @@
 NSString* NIStringFromBytes(unsigned long long bytes);
 
 
+/**
+ * CPU usage of a single thread in this process.
+ *
+ * @ingroup Overview-Sensors
+ */
+typedef struct {
+  // The mach thread identifier, stable for the lifetime of the thread.
+  uint64_t threadID;
+
+  // 1.0 is one core's worth of time.
+  CGFloat CPUUsage;
+
+  // The thread's name, or the label of the dispatch queue it is running if it has none.
+  char name[64];
+} NIThreadCPUUsage;
+
+
 /**
  * An interface for accessing device information.
  *
@@ -99,6 +116,31 @@ NSString* NIStringFromBytes(unsigned long long bytes);
 + (UIDeviceBatteryState)batteryState;
 
 
+#pragma mark CPU /** @name CPU */
+
+/**
+ * The CPU usage of this process, where 1.0 is one core's worth of time.
+ *
+ * Calculated by adding the usage of every non-idle thread reported by task_threads.
+ */
++ (CGFloat)processCPUUsage;
+
+/**
+ * The number of threads in this process.
+ *
+ * Only the first 128 threads are sampled.
+ */
++ (NSUInteger)numberOfThreads;
+
+/**
+ * The CPU usage of the thread at the given index.
+ *
+ * Threads are not in any particular order. Read these between beginCachedDeviceInfo and
+ * endCachedDeviceInfo so that the indices refer to a single sample.
+ */
++ (NIThreadCPUUsage)CPUUsageOfThreadAtIndex:(NSUInteger)index;
+
+
 #pragma mark Caching /** @name Caching */
 
 /**
@@ -118,6 +160,10 @@ NSString* NIStringFromBytes(unsigned long long bytes);
  *
  *  [NIDeviceInfo endCachedDeviceInfo];
  * @endcode
+ *
+ * The cache is held by the calling thread until endCachedDeviceInfo, and other threads wait
+ * for it before reading device info. Keep the cached section short on the main thread since the
+ * Overview heartbeat samples the device from a background queue.
  */
 + (BOOL)beginCachedDeviceInfo;
 
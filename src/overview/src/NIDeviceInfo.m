@@ -25,13 +25,20 @@
 #error "Nimbus requires ARC support."
 #endif
 
-// Static local state.
+// Static local state. Everything below is guarded by sLock, which beginCachedDeviceInfo holds
+// until endCachedDeviceInfo so that the Overview heartbeat can sample off the main thread.
+static NIFastLock           sLock;
 static BOOL                 sIsCaching = NO;
 static BOOL                 sLastUpdateResult = NO;
 static vm_size_t            sPageSize = 0;
 static vm_statistics_data_t sVMStats;
 static NSDictionary*        sFileSystem = nil;
 
+enum { kMaxNumberOfSampledThreads = 128 };
+static CGFloat              sProcessCPUUsage = 0;
+static NSUInteger           sNumberOfThreads = 0;
+static NIThreadCPUUsage     sThreadCPUUsages[kMaxNumberOfSampledThreads];
+
 
 NSString* NIStringFromBytes(unsigned long long bytes) {
   static const void* sOrdersOfMagnitude[] = {
@@ -67,6 +74,10 @@ NSString* NIStringFromBytes(unsigned long long bytes) {
 
 
 + (void)initialize {
+  if (self != [NIDeviceInfo class]) {
+    return;
+  }
+  NIFastLockInit(&sLock, NIFastLockOptionRecursive);
   [[UIDevice currentDevice] setBatteryMonitoringEnabled:YES];
   memset(&sVMStats, 0, sizeof(sVMStats));
 }
@@ -91,28 +102,125 @@ NSString* NIStringFromBytes(unsigned long long bytes) {
   return (nil == error);
 }
 
+// Fills in the name of a thread, falling back to the label of the dispatch queue it is running.
+// Neither the thread nor its queue is owned by the caller, so nothing is read from either
+// without a guarantee that it is still alive.
+static void NIGetNameOfThread(thread_act_t thread, uint64_t dispatchQueueAddress,
+                              char* name, size_t length) {
+  name[0] = '\0';
+
+  // The kernel keeps its own copy of the name, and the caller's send right keeps the thread's
+  // kernel object alive, so this can't race with the thread exiting.
+  thread_extended_info_data_t extendedInfo;
+  mach_msg_type_number_t count = THREAD_EXTENDED_INFO_COUNT;
+  if (KERN_SUCCESS == thread_info(thread, THREAD_EXTENDED_INFO,
+                                  (thread_info_t)&extendedInfo, &count)) {
+    extendedInfo.pth_name[sizeof(extendedInfo.pth_name) - 1] = '\0';
+    strlcpy(name, extendedInfo.pth_name, length);
+  }
+  if ('\0' != name[0] || 0 == dispatchQueueAddress) {
+    return;
+  }
+
+  // A queue is only certain to be alive while a thread is running it, so the thread is held on
+  // its queue while the label is read. Nothing below takes a lock that the suspended thread
+  // could be holding. The calling thread is on its own queue already and can't suspend itself.
+  thread_act_t currentThread = mach_thread_self();
+  BOOL isCurrentThread = (thread == currentThread);
+  mach_port_deallocate(mach_task_self(), currentThread);
+  if (!isCurrentThread && KERN_SUCCESS != thread_suspend(thread)) {
+    return;
+  }
+
+  // dispatchQueueAddress is the address of the thread's current queue pointer. It is copied
+  // through the kernel in case the thread has already torn it down.
+  uintptr_t queueAddress = 0;
+  vm_size_t bytesCopied = 0;
+  if (KERN_SUCCESS == vm_read_overwrite(mach_task_self(),
+                                        (vm_address_t)dispatchQueueAddress,
+                                        sizeof(queueAddress), (vm_address_t)&queueAddress,
+                                        &bytesCopied)
+      && 0 != queueAddress) {
+    const char* label = dispatch_queue_get_label((__bridge dispatch_queue_t)(void *)queueAddress);
+    if (NULL != label) {
+      strlcpy(name, label, length);
+    }
+  }
+
+  if (!isCurrentThread) {
+    thread_resume(thread);
+  }
+}
+
++ (BOOL)updateThreadStatistics {
+  thread_act_array_t threads = NULL;
+  mach_msg_type_number_t numberOfThreads = 0;
+  if (KERN_SUCCESS != task_threads(mach_task_self(), &threads, &numberOfThreads)) {
+    return NO;
+  }
+
+  CGFloat processCPUUsage = 0;
+  NSUInteger numberOfSampledThreads = 0;
+  for (mach_msg_type_number_t ix = 0; ix < numberOfThreads; ++ix) {
+    thread_basic_info_data_t basicInfo;
+    mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+    if (numberOfSampledThreads < kMaxNumberOfSampledThreads
+        && KERN_SUCCESS == thread_info(threads[ix], THREAD_BASIC_INFO,
+                                       (thread_info_t)&basicInfo, &count)) {
+      CGFloat usage = ((basicInfo.flags & TH_FLAGS_IDLE)
+                       ? 0 : (CGFloat)basicInfo.cpu_usage / (CGFloat)TH_USAGE_SCALE);
+      processCPUUsage += usage;
+
+      thread_identifier_info_data_t identifierInfo;
+      count = THREAD_IDENTIFIER_INFO_COUNT;
+      if (KERN_SUCCESS != thread_info(threads[ix], THREAD_IDENTIFIER_INFO,
+                                      (thread_info_t)&identifierInfo, &count)) {
+        memset(&identifierInfo, 0, sizeof(identifierInfo));
+      }
+
+      NIThreadCPUUsage* threadUsage = &sThreadCPUUsages[numberOfSampledThreads++];
+      threadUsage->threadID = identifierInfo.thread_id;
+      threadUsage->CPUUsage = usage;
+      NIGetNameOfThread(threads[ix], identifierInfo.dispatch_qaddr,
+                        threadUsage->name, sizeof(threadUsage->name));
+    }
+    mach_port_deallocate(mach_task_self(), threads[ix]);
+  }
+  vm_deallocate(mach_task_self(), (vm_address_t)threads, sizeof(thread_t) * numberOfThreads);
+
+  sProcessCPUUsage = processCPUUsage;
+  sNumberOfThreads = numberOfSampledThreads;
+  return YES;
+}
+
 #pragma mark - Public
 
 
 + (unsigned long long)bytesOfFreeMemory {
-  if (!sIsCaching && ![self updateHostStatistics]) {
-    return 0;
+  {
+    NI_LOCK_SCOPE(&sLock);
+    if (!sIsCaching && ![self updateHostStatistics]) {
+      return 0;
+    }
+    unsigned long long mem_free = ((unsigned long long)sVMStats.free_count
+                                   * (unsigned long long)sPageSize);
+    return mem_free;
   }
-  unsigned long long mem_free = ((unsigned long long)sVMStats.free_count
-                                 * (unsigned long long)sPageSize);
-  return mem_free;
 }
 
 + (unsigned long long)bytesOfTotalMemory {
-  if (!sIsCaching && ![self updateHostStatistics]) {
-    return 0;
+  {
+    NI_LOCK_SCOPE(&sLock);
+    if (!sIsCaching && ![self updateHostStatistics]) {
+      return 0;
+    }
+    unsigned long long mem_free = (((unsigned long long)sVMStats.free_count
+                                    + (unsigned long long)sVMStats.active_count
+                                    + (unsigned long long)sVMStats.inactive_count
+                                    + (unsigned long long)sVMStats.wire_count)
+                                   * (unsigned long long)sPageSize);
+    return mem_free;
   }
-  unsigned long long mem_free = (((unsigned long long)sVMStats.free_count
-                                  + (unsigned long long)sVMStats.active_count
-                                  + (unsigned long long)sVMStats.inactive_count
-                                  + (unsigned long long)sVMStats.wire_count)
-                                 * (unsigned long long)sPageSize);
-  return mem_free;
 }
 
 + (void)simulateLowMemoryWarning
@@ -132,27 +240,33 @@ NSString* NIStringFromBytes(unsigned long long bytes) {
 }
 
 + (unsigned long long)bytesOfFreeDiskSpace {
-  if (!sIsCaching && ![self updateFileSystemAttributes]) {
-    return 0;
-  }
-	unsigned long long bytes = 0;
+  {
+    NI_LOCK_SCOPE(&sLock);
+    if (!sIsCaching && ![self updateFileSystemAttributes]) {
+      return 0;
+    }
+    unsigned long long bytes = 0;
 
-  NSNumber* number = [sFileSystem objectForKey:NSFileSystemFreeSize];
-	bytes = [number unsignedLongLongValue];
+    NSNumber* number = [sFileSystem objectForKey:NSFileSystemFreeSize];
+    bytes = [number unsignedLongLongValue];
 
-  return bytes;
+    return bytes;
+  }
 }
 
 + (unsigned long long)bytesOfTotalDiskSpace {
-  if (!sIsCaching && ![self updateFileSystemAttributes]) {
-    return 0;
+  {
+    NI_LOCK_SCOPE(&sLock);
+    if (!sIsCaching && ![self updateFileSystemAttributes]) {
+      return 0;
+    }
+    unsigned long long bytes = 0;
+
+    NSNumber* number = [sFileSystem objectForKey:NSFileSystemSize];
+    bytes = [number unsignedLongLongValue];
+
+    return bytes;
   }
-	unsigned long long bytes = 0;
-  
-  NSNumber* number = [sFileSystem objectForKey:NSFileSystemSize];
-  bytes = [number unsignedLongLongValue];
-  
-  return bytes;
 }
 
 + (CGFloat)batteryLevel {
@@ -163,15 +277,53 @@ NSString* NIStringFromBytes(unsigned long long bytes) {
   return [[UIDevice currentDevice] batteryState];
 }
 
++ (CGFloat)processCPUUsage {
+  {
+    NI_LOCK_SCOPE(&sLock);
+    if (!sIsCaching && ![self updateThreadStatistics]) {
+      return 0;
+    }
+    return sProcessCPUUsage;
+  }
+}
+
++ (NSUInteger)numberOfThreads {
+  {
+    NI_LOCK_SCOPE(&sLock);
+    if (!sIsCaching && ![self updateThreadStatistics]) {
+      return 0;
+    }
+    return sNumberOfThreads;
+  }
+}
+
++ (NIThreadCPUUsage)CPUUsageOfThreadAtIndex:(NSUInteger)index {
+  {
+    NI_LOCK_SCOPE(&sLock);
+    if (!sIsCaching) {
+      [self updateThreadStatistics];
+    }
+    NIDASSERT(index < sNumberOfThreads);
+    if (index >= sNumberOfThreads) {
+      NIThreadCPUUsage empty;
+      memset(&empty, 0, sizeof(empty));
+      return empty;
+    }
+    return sThreadCPUUsages[index];
+  }
+}
+
 #pragma mark - Caching
 
 
 + (BOOL)beginCachedDeviceInfo {
+  NIFastLockLock(&sLock);
   if (!sIsCaching) {
     sIsCaching = YES;
 
     sLastUpdateResult = [self updateHostStatistics];
     sLastUpdateResult = ([self updateFileSystemAttributes] && sLastUpdateResult);
+    sLastUpdateResult = ([self updateThreadStatistics] && sLastUpdateResult);
   }
 
   return sLastUpdateResult;
@@ -179,6 +331,7 @@ NSString* NIStringFromBytes(unsigned long long bytes) {
 
 + (void)endCachedDeviceInfo {
   sIsCaching = NO;
+  NIFastLockUnlock(&sLock);
 }
 
 @end
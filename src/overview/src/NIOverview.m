@@ -19,6 +19,7 @@
 #if defined(DEBUG) || defined(NI_DEBUG)
 
 #import "NIDeviceInfo.h"
+#import "NIOverviewConsoleCapture.h"
 #import "NIOverviewView.h"
 #import "NIOverviewPageView.h"
 #import "NIOverviewSwizzling.h"
@@ -63,33 +64,11 @@ void NIOverviewLogMethod(const char* message, unsigned length, BOOL withSyslogBa
  * Pipes NSLog messages to the Overview and stderr.
  *
  * This method is passed as an argument to _NSSetLogCStringFunction to pipe all NSLog
- * messages through here.
+ * messages through here. It runs on whichever thread logged, so it only copies the message into
+ * the console capture. Formatting and writing happen in batches on the capture's queue.
  */
 void NIOverviewLogMethod(const char* message, unsigned length, BOOL withSyslogBanner) {
-  static NSDateFormatter* formatter = nil;
-  if (nil == formatter) {
-    formatter = [[NSDateFormatter alloc] init];
-    [formatter setTimeStyle:NSDateFormatterMediumStyle];
-    [formatter setDateStyle:NSDateFormatterMediumStyle];
-  }
-
-  // Don't autorelease here in an attempt to minimize autorelease thrashing in tight
-  // loops.
-  
-  NSString* formattedLogMessage = [[NSString alloc] initWithCString: message
-                                                           encoding: NSUTF8StringEncoding];
-
-  dispatch_async(dispatch_get_main_queue(), ^{
-    NIOverviewConsoleLogEntry* entry = [[NIOverviewConsoleLogEntry alloc]
-                                        initWithLog:formattedLogMessage];
-
-    [[NIOverview logger] addConsoleLog:entry];
-  });
-
-  formattedLogMessage = [[NSString alloc] initWithFormat:
-                         @"%@: %s\n", [formatter stringFromDate:[NSDate date]], message];
-
-  fprintf(stderr, "%s", [formattedLogMessage UTF8String]);
+  [[NIOverviewConsoleCapture sharedCapture] captureBytes:message length:length];
 }
 
 #endif
@@ -197,7 +176,11 @@ void NIOverviewLogMethod(const char* message, unsigned length, BOOL withSyslogBa
     _NSSetLogCStringFunction(NIOverviewLogMethod);
 
     if (overrideStatusBarHeight) {
-      NIOverviewSwizzleMethods();
+      // The status bar height has to be overridden before the first layout pass, so this can't be
+      // deferred.
+      NIMeasureFirstUse(@"NIOverview swizzling", ^{
+        NIOverviewSwizzleMethods();
+      });
     }
 
     [[NSNotificationCenter defaultCenter] addObserver: self
@@ -236,10 +219,16 @@ void NIOverviewLogMethod(const char* message, unsigned length, BOOL withSyslogBa
   [sOverviewView setEnableDraggingVertically:enableDraggingVertically];
 
   [sOverviewView addPageView:[NIInspectionOverviewPageView page]];
+  [sOverviewView addPageView:[NIOverviewRenderingPageView page]];
   [sOverviewView addPageView:[NIOverviewMemoryPageView page]];
   [sOverviewView addPageView:[NIOverviewDiskPageView page]];
+  [sOverviewView addPageView:[NIOverviewCPUPageView page]];
+  [sOverviewView addPageView:[NIOverviewFrameRatePageView page]];
+  [sOverviewView addPageView:[NIOverviewNetworkPageView page]];
   [sOverviewView addPageView:[NIOverviewMemoryCachePageView page]];
   [sOverviewView addPageView:[NIOverviewConsoleLogPageView page]];
+  [sOverviewView addPageView:[NIOverviewStallPageView page]];
+  [sOverviewView addPageView:[NIOverviewProfilerPageView page]];
   [sOverviewView addPageView:[NIOverviewMaxLogLevelPageView page]];
 
   // Hide the view initially because the initial frame will be wrong when the device
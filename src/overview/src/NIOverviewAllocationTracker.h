@@ -0,0 +1,76 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Counts the live instances of selected classes and samples the malloc zones.
+ *
+ * @ingroup Overview-Sensors
+ *
+ * Tracking a class hooks its +allocWithZone: and -dealloc with
+ * NIReplaceClassMethodImplementation and NIReplaceInstanceMethodImplementation. The hooks only
+ * touch two atomic counters, and subclasses are counted with the classes they inherit from.
+ * Hooks can't be removed, so only track classes while debugging.
+ *
+ * Instances that were allocated before their class was tracked are never counted. When they
+ * are deallocated the live count would drop below the true number, so it is reported as no
+ * less than zero. Track classes as early as possible for accurate counts.
+ *
+ * Classes that allocate their instances without +allocWithZone:, such as many class clusters,
+ * can't be counted.
+ */
+@interface NIOverviewAllocationTracker : NSObject
+
+/**
+ * Returns the shared tracker.
+ */
++ (NIOverviewAllocationTracker *)sharedTracker;
+
+/**
+ * Begins counting the instances of the given class and its subclasses.
+ *
+ * Tracking a class more than once does nothing.
+ */
+- (void)trackClass:(Class)cls;
+
+/**
+ * The classes being tracked, in the order they were tracked.
+ */
+@property (nonatomic, readonly, copy) NSArray* trackedClasses;
+
+/**
+ * Returns the number of instances of the class that are alive, or 0 if it isn't tracked.
+ */
+- (NSInteger)numberOfLiveInstancesOfClass:(Class)cls;
+
+/**
+ * Returns the number of instances of the class that have been allocated since it was tracked.
+ */
+- (unsigned long long)numberOfAllocationsOfClass:(Class)cls;
+
+/**
+ * Returns the number of bytes in use across all malloc zones.
+ */
++ (unsigned long long)numberOfMallocBytesInUse;
+
+/**
+ * Returns the number of blocks in use across all malloc zones.
+ */
++ (unsigned long long)numberOfMallocBlocksInUse;
+
+@end
@@ -0,0 +1,190 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIOverviewAllocationTracker.h"
+
+#import "NimbusCore.h"
+
+#import <malloc/malloc.h>
+#import <objc/runtime.h>
+#import <stdatomic.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// Counters live as long as the hooks that update them, which is forever.
+typedef struct {
+  atomic_llong numberOfLiveInstances;
+  atomic_ullong numberOfAllocations;
+} NIOverviewInstanceCounter;
+
+// The hooks pass objects around as raw pointers. +allocWithZone: returns a +1 object that ARC
+// must not balance, and -dealloc receives an object that must not be retained again.
+typedef void* (*NIOverviewAllocWithZoneIMP)(Class cls, SEL sel, NSZone* zone);
+typedef void (*NIOverviewDeallocIMP)(void* object, SEL sel);
+
+static BOOL NIOverviewClassDefinesMethod(Class cls, SEL sel) {
+  unsigned int numberOfMethods = 0;
+  Method* methods = class_copyMethodList(cls, &numberOfMethods);
+  BOOL definesMethod = NO;
+  for (unsigned int ix = 0; ix < numberOfMethods && !definesMethod; ++ix) {
+    definesMethod = (method_getName(methods[ix]) == sel);
+  }
+  free(methods);
+  return definesMethod;
+}
+
+static void NIOverviewInstallInstanceCounter(Class cls, NIOverviewInstanceCounter* counter) {
+  SEL allocWithZoneSel = @selector(allocWithZone:);
+  // ARC doesn't allow @selector(dealloc).
+  SEL deallocSel = NSSelectorFromString(@"dealloc");
+
+  // The originals are read before the hooks are installed, so that a hook that runs on another
+  // thread the moment it is installed already has something to call.
+  NIOverviewAllocWithZoneIMP previousAllocWithZone = (NIOverviewAllocWithZoneIMP)
+      method_getImplementation(class_getClassMethod(cls, allocWithZoneSel));
+  NIOverviewDeallocIMP previousDealloc = (NIOverviewDeallocIMP)
+      method_getImplementation(class_getInstanceMethod(cls, deallocSel));
+  NIDASSERT(NULL != previousAllocWithZone && NULL != previousDealloc);
+  if (NULL == previousAllocWithZone || NULL == previousDealloc) {
+    return;
+  }
+
+  // A method that the class inherits is looked up in the superclass on every call instead, so
+  // that a superclass that is tracked later still counts the instances of this class.
+  Class superclass = class_getSuperclass(cls);
+  BOOL definesAllocWithZone = NIOverviewClassDefinesMethod(object_getClass(cls), allocWithZoneSel);
+  BOOL definesDealloc = NIOverviewClassDefinesMethod(cls, deallocSel);
+
+  IMP allocWithZone = imp_implementationWithBlock(^void*(Class allocatedClass, NSZone* zone) {
+    NIOverviewAllocWithZoneIMP originalAllocWithZone = (definesAllocWithZone
+        ? previousAllocWithZone
+        : (NIOverviewAllocWithZoneIMP)method_getImplementation(class_getClassMethod(superclass, allocWithZoneSel)));
+    void* object = originalAllocWithZone(allocatedClass, allocWithZoneSel, zone);
+    if (NULL != object) {
+      atomic_fetch_add_explicit(&counter->numberOfLiveInstances, 1, memory_order_relaxed);
+      atomic_fetch_add_explicit(&counter->numberOfAllocations, 1, memory_order_relaxed);
+    }
+    return object;
+  });
+
+  IMP dealloc = imp_implementationWithBlock(^(void* object) {
+    atomic_fetch_sub_explicit(&counter->numberOfLiveInstances, 1, memory_order_relaxed);
+    NIOverviewDeallocIMP originalDealloc = (definesDealloc
+        ? previousDealloc
+        : (NIOverviewDeallocIMP)method_getImplementation(class_getInstanceMethod(superclass, deallocSel)));
+    originalDealloc(object, deallocSel);
+  });
+
+  NIReplaceClassMethodImplementation(cls, allocWithZoneSel, allocWithZone);
+  NIReplaceInstanceMethodImplementation(cls, deallocSel, dealloc);
+}
+
+static malloc_statistics_t NIOverviewMallocStatistics(void) {
+  malloc_statistics_t statistics;
+  memset(&statistics, 0, sizeof(statistics));
+  // A NULL zone sums the statistics of every zone.
+  malloc_zone_statistics(NULL, &statistics);
+  return statistics;
+}
+
+@implementation NIOverviewAllocationTracker {
+  NSMutableArray* _trackedClasses;
+  NSMutableArray* _counters;
+}
+
++ (NIOverviewAllocationTracker *)sharedTracker {
+  static NIOverviewAllocationTracker* sSharedTracker = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sSharedTracker = [[NIOverviewAllocationTracker alloc] init];
+  });
+  return sSharedTracker;
+}
+
+- (id)init {
+  if ((self = [super init])) {
+    _trackedClasses = [[NSMutableArray alloc] init];
+    _counters = [[NSMutableArray alloc] init];
+  }
+  return self;
+}
+
+- (void)trackClass:(Class)cls {
+  NIDASSERT(nil != cls);
+  if (nil == cls) {
+    return;
+  }
+
+  @synchronized(self) {
+    if ([_trackedClasses containsObject:cls]) {
+      return;
+    }
+    NIOverviewInstanceCounter* counter = calloc(1, sizeof(NIOverviewInstanceCounter));
+    atomic_init(&counter->numberOfLiveInstances, 0);
+    atomic_init(&counter->numberOfAllocations, 0);
+    NIOverviewInstallInstanceCounter(cls, counter);
+
+    [_trackedClasses addObject:cls];
+    [_counters addObject:[NSValue valueWithPointer:counter]];
+  }
+}
+
+- (NSArray *)trackedClasses {
+  @synchronized(self) {
+    return [_trackedClasses copy];
+  }
+}
+
+- (NIOverviewInstanceCounter *)counterForClass:(Class)cls {
+  @synchronized(self) {
+    NSUInteger index = [_trackedClasses indexOfObject:cls];
+    if (NSNotFound == index) {
+      return NULL;
+    }
+    return [[_counters objectAtIndex:index] pointerValue];
+  }
+}
+
+- (NSInteger)numberOfLiveInstancesOfClass:(Class)cls {
+  NIOverviewInstanceCounter* counter = [self counterForClass:cls];
+  if (NULL == counter) {
+    return 0;
+  }
+  long long numberOfLiveInstances = atomic_load_explicit(&counter->numberOfLiveInstances,
+                                                         memory_order_relaxed);
+  return (NSInteger)MAX(0, numberOfLiveInstances);
+}
+
+- (unsigned long long)numberOfAllocationsOfClass:(Class)cls {
+  NIOverviewInstanceCounter* counter = [self counterForClass:cls];
+  if (NULL == counter) {
+    return 0;
+  }
+  return atomic_load_explicit(&counter->numberOfAllocations, memory_order_relaxed);
+}
+
++ (unsigned long long)numberOfMallocBytesInUse {
+  return NIOverviewMallocStatistics().size_in_use;
+}
+
++ (unsigned long long)numberOfMallocBlocksInUse {
+  return NIOverviewMallocStatistics().blocks_in_use;
+}
+
+@end
@@ -0,0 +1,69 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+
+@class NIOverviewLogger;
+
+/**
+ * Captures console logs for the Overview without blocking the threads that write them.
+ *
+ * @ingroup Overview-Sensors
+ *
+ * The Overview routes every NSLog through the shared capture. Logging a line only copies its
+ * bytes into a bounded NIMultiProducerQueue and, if the queue's consumer is idle, wakes it up.
+ * The consumer runs on a serial utility queue, where it
+ *
+ * - formats the timestamps and writes the whole batch to the file descriptor with a single
+ *   dispatch_io write, and
+ * - hands the raw bytes of the batch to the logger through an NISingleProducerQueue, which
+ *   delivers every batch drained since the main queue's last turn in one block.
+ *
+ * The logger keeps the raw bytes and only turns them into strings when they are read, which the
+ * console page does while it is visible.
+ *
+ * Logging never waits on the consumer. If the queue is full the line is dropped, and the next
+ * batch ends with a line saying how many were. Because writes are asynchronous, the last few
+ * lines before a crash may not make it to stderr.
+ */
+@interface NIOverviewConsoleCapture : NSObject
+
+/**
+ * Returns the capture that writes to stderr and adds logs to the shared logger.
+ */
++ (NIOverviewConsoleCapture *)sharedCapture;
+
+/**
+ * Designated initializer.
+ */
+- (id)initWithLogger:(NIOverviewLogger *)logger fileDescriptor:(int)fileDescriptor;
+
+/**
+ * Captures one console line. May be called from any thread.
+ *
+ * The bytes need not be terminated and should not include the trailing newline.
+ */
+- (void)captureBytes:(const char *)bytes length:(NSUInteger)length;
+
+/**
+ * Blocks until every line captured so far has been written to the file descriptor.
+ *
+ * Lines may still be on their way to the logger when this returns.
+ */
+- (void)flush;
+
+@end
@@ -0,0 +1,214 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIOverviewConsoleCapture.h"
+
+#import "NIOverviewLogger.h"
+#import "NimbusCore.h"
+
+#import <QuartzCore/QuartzCore.h>
+#import <stdatomic.h>
+#import <unistd.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+static const NSUInteger kNumberOfQueuedLines = 512;
+static const NSUInteger kNumberOfLoggedLines = 4096;
+
+// One captured line on its way from the thread that logged it to the capture's queue.
+@interface NIOverviewConsoleLine : NSObject
+@property (nonatomic, strong) NSData* bytes;
+@property (nonatomic) CFTimeInterval timestamp;
+@end
+
+@implementation NIOverviewConsoleLine
+@end
+
+@implementation NIOverviewConsoleCapture {
+  __weak NIOverviewLogger* _logger;
+  NIMultiProducerQueue* _lines;
+  atomic_ulong _numberOfDroppedLines;
+  atomic_bool _drainIsScheduled;
+
+  // Everything below is only touched on _queue.
+  dispatch_queue_t _queue;
+  dispatch_io_t _channel;
+  NISingleProducerQueue* _loggedLines;
+  unsigned long _numberOfLinesNotLogged;
+  NSDateFormatter* _formatter;
+  long long _formattedSecond;
+  NSData* _formattedDate;
+}
+
+- (void)dealloc {
+  dispatch_io_close(_channel, 0);
+}
+
++ (NIOverviewConsoleCapture *)sharedCapture {
+  static dispatch_once_t pred = 0;
+  static NIOverviewConsoleCapture* instance = nil;
+
+  dispatch_once(&pred, ^{
+    instance = [[NIOverviewConsoleCapture alloc] initWithLogger:[NIOverviewLogger sharedLogger]
+                                                 fileDescriptor:STDERR_FILENO];
+  });
+
+  return instance;
+}
+
+- (id)initWithLogger:(NIOverviewLogger *)logger fileDescriptor:(int)fileDescriptor {
+  if ((self = [super init])) {
+    _logger = logger;
+
+    _lines = [[NIMultiProducerQueue alloc] initWithCapacity:kNumberOfQueuedLines];
+    atomic_init(&_numberOfDroppedLines, 0);
+    atomic_init(&_drainIsScheduled, false);
+
+    if (&dispatch_queue_attr_make_with_qos_class != NULL) {
+      dispatch_queue_attr_t attributes =
+          dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0);
+      _queue = dispatch_queue_create("com.nimbuskit.overview.console", attributes);
+    } else {
+      // Quality of service classes are only available from iOS 8.
+      _queue = dispatch_queue_create("com.nimbuskit.overview.console", DISPATCH_QUEUE_SERIAL);
+      dispatch_set_target_queue(_queue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+    }
+    _channel = dispatch_io_create(DISPATCH_IO_STREAM, fileDescriptor, _queue, ^(int error) {});
+
+    // The drain is the only producer, and each main queue turn adds whatever it has logged since
+    // the last one.
+    _loggedLines = [[NISingleProducerQueue alloc] initWithCapacity:kNumberOfLoggedLines];
+    __weak NIOverviewLogger* weakLogger = logger;
+    _loggedLines.mainThreadDrainBlock = ^(NSArray* lines) {
+      NIOverviewLogger* strongLogger = weakLogger;
+      for (NIOverviewConsoleLine* line in lines) {
+        [strongLogger addConsoleLogData:line.bytes timestamp:line.timestamp];
+      }
+    };
+
+    _formatter = [[NSDateFormatter alloc] init];
+    [_formatter setTimeStyle:NSDateFormatterMediumStyle];
+    [_formatter setDateStyle:NSDateFormatterMediumStyle];
+    _formattedSecond = -1;
+  }
+  return self;
+}
+
+#pragma mark - Capturing
+
+
+- (void)captureBytes:(const char *)bytes length:(NSUInteger)length {
+  NIOverviewConsoleLine* line = [[NIOverviewConsoleLine alloc] init];
+  line.timestamp = CACurrentMediaTime();
+  line.bytes = [[NSData alloc] initWithBytes:bytes length:length];
+
+  if (![_lines enqueueObject:line]) {
+    // The drain is a full queue behind. Waiting for it would stall the thread that logged the
+    // line, so the line is dropped and the next drain reports how many were.
+    atomic_fetch_add_explicit(&_numberOfDroppedLines, 1, memory_order_relaxed);
+  }
+
+  if (!atomic_exchange_explicit(&_drainIsScheduled, true, memory_order_acq_rel)) {
+    dispatch_async(_queue, ^{
+      // Clear the flag before draining so that a line captured mid-drain schedules the next
+      // drain rather than being stranded.
+      atomic_store_explicit(&self->_drainIsScheduled, false, memory_order_release);
+      [self drain];
+    });
+  }
+}
+
+#pragma mark - Draining
+
+
+- (NSData *)formattedDateForAbsoluteTime:(CFAbsoluteTime)time {
+  // The formatter only shows whole seconds, so one string serves every line in that second.
+  long long second = (long long)floor(time);
+  if (second != _formattedSecond) {
+    _formattedSecond = second;
+    NSDate* date = [NSDate dateWithTimeIntervalSinceReferenceDate:time];
+    _formattedDate = [[_formatter stringFromDate:date] dataUsingEncoding:NSUTF8StringEncoding];
+  }
+  return _formattedDate;
+}
+
+- (NIOverviewConsoleLine *)reportLineForNumberOfDroppedLines:(unsigned long)numberOfDroppedLines {
+  NIOverviewConsoleLine* line = [[NIOverviewConsoleLine alloc] init];
+  line.timestamp = CACurrentMediaTime();
+  line.bytes = [[NSString stringWithFormat:@"[Nimbus] %lu console lines dropped", numberOfDroppedLines]
+                dataUsingEncoding:NSUTF8StringEncoding];
+  return line;
+}
+
+- (void)drain {
+  NSMutableArray* lines = [[_lines dequeueAllObjects] mutableCopy];
+  unsigned long numberOfDroppedLines =
+      atomic_exchange_explicit(&_numberOfDroppedLines, 0, memory_order_relaxed);
+  if (numberOfDroppedLines > 0) {
+    // Reported after the batch because the lines were dropped while it was waiting in the queue.
+    [lines addObject:[self reportLineForNumberOfDroppedLines:numberOfDroppedLines]];
+  }
+
+  if (0 == lines.count) {
+    return;
+  }
+
+  NSMutableData* output = [NSMutableData data];
+  CFAbsoluteTime absoluteTimeOffset = CFAbsoluteTimeGetCurrent() - CACurrentMediaTime();
+  for (NIOverviewConsoleLine* line in lines) {
+    [output appendData:[self formattedDateForAbsoluteTime:line.timestamp + absoluteTimeOffset]];
+    [output appendBytes:": " length:2];
+    [output appendData:line.bytes];
+    [output appendBytes:"\n" length:1];
+  }
+
+  dispatch_data_t data = dispatch_data_create(output.bytes, output.length, _queue,
+                                              DISPATCH_DATA_DESTRUCTOR_DEFAULT);
+  dispatch_io_write(_channel, 0, data, _queue,
+                    ^(bool done, dispatch_data_t remaining, int error) {});
+
+  if (nil == _logger) {
+    return;
+  }
+  // The lines have already been written, so if the main thread is too far behind to take them
+  // they are only left out of the Overview's console page, which says how many were.
+  if (_numberOfLinesNotLogged > 0
+      && [_loggedLines enqueueObject:[self reportLineForNumberOfDroppedLines:_numberOfLinesNotLogged]]) {
+    _numberOfLinesNotLogged = 0;
+  }
+  for (NIOverviewConsoleLine* line in lines) {
+    if (0 != _numberOfLinesNotLogged || ![_loggedLines enqueueObject:line]) {
+      ++_numberOfLinesNotLogged;
+    }
+  }
+}
+
+- (void)flush {
+  dispatch_sync(_queue, ^{
+    [self drain];
+  });
+
+  dispatch_semaphore_t written = dispatch_semaphore_create(0);
+  dispatch_io_barrier(_channel, ^{
+    dispatch_semaphore_signal(written);
+  });
+  dispatch_semaphore_wait(written, DISPATCH_TIME_FOREVER);
+}
+
+@end
@@ -32,6 +32,16 @@
  */
 @property (nonatomic, weak) id<NIOverviewGraphViewDataSource> dataSource;
 
+/**
+ * Fetches new points and events from the data source and renders them.
+ *
+ * If the data source supports incremental rendering, only the points added since the last
+ * reload are fetched. They are appended to the graph as a new segment layer, and the existing
+ * segments scroll left. The whole graph is rebuilt only when its scale changes. Other data
+ * sources are redrawn in full.
+ */
+- (void)reloadData;
+
 @end
 
 /**
@@ -76,4 +86,28 @@
                       xValue: (CGFloat *)xValue
                        color: (UIColor **)color;
 
+@optional
+
+/**
+ * Fetches the x value at the left edge of the graph.
+ *
+ * Defaults to 0. Data sources that implement this and resetPointIteratorAfterXValue: must
+ * report x values that don't change from one reload to the next, such as seconds since a fixed
+ * time.
+ */
+- (CGFloat)graphViewMinimumXValue:(NIOverviewGraphView *)graphView;
+
+/**
+ * Fetches the y value at the bottom of the graph's range. Defaults to 0.
+ */
+- (CGFloat)graphViewMinimumYValue:(NIOverviewGraphView *)graphView;
+
+/**
+ * The data source should reset its point iterator to the first point whose x value is greater
+ * than xValue.
+ *
+ * Implementing this enables incremental rendering.
+ */
+- (void)resetPointIteratorAfterXValue:(CGFloat)xValue;
+
 @end
@@ -24,17 +24,206 @@
 #error "Nimbus requires ARC support."
 #endif
 
-@implementation NIOverviewGraphView
+// Points are plotted within the middle 80% of the graph's height.
+static CGFloat NIOverviewGraphYPosition(CGFloat scaledY, CGFloat height) {
+  return height - (scaledY * 0.8f + 0.1f) * height;
+}
+
+// The strip's x scale is kept until the visible range drifts this far from it.
+static const CGFloat kStripScaleTolerance = 0.05f;
+
+@implementation NIOverviewGraphView {
+  // Holds one shape layer per appended segment, in strip coordinates where x is the data
+  // source's x value times _pixelsPerXValue. Scrolling translates the strip.
+  CALayer* _stripLayer;
+  NSMutableArray* _segmentLayers;
+  CALayer* _eventsLayer;
+
+  BOOL _hasLastPoint;
+  CGPoint _lastPoint;
+  CGFloat _pixelsPerXValue;
+  CGFloat _minimumYValue;
+  CGFloat _yRange;
+  CGSize _stripSize;
+}
 
 - (id)initWithFrame:(CGRect)frame {
   if ((self = [super initWithFrame:frame])) {
     self.opaque = NO;
+    self.clipsToBounds = YES;
+    // The background only depends on the bounds. The graph itself lives in sublayers.
+    self.contentMode = UIViewContentModeRedraw;
     self.layer.borderWidth = 1;
     self.layer.borderColor = [UIColor colorWithWhite:1 alpha:0.2f].CGColor;
+
+    _segmentLayers = [[NSMutableArray alloc] init];
+    _stripLayer = [CALayer layer];
+    _eventsLayer = [CALayer layer];
+    [self.layer addSublayer:_stripLayer];
+    [self.layer addSublayer:_eventsLayer];
   }
   return self;
 }
 
+- (BOOL)dataSourceRendersIncrementally {
+  return [self.dataSource respondsToSelector:@selector(resetPointIteratorAfterXValue:)];
+}
+
+- (CGFloat)minimumXValue {
+  return ([self.dataSource respondsToSelector:@selector(graphViewMinimumXValue:)]
+          ? [self.dataSource graphViewMinimumXValue:self] : 0);
+}
+
+- (CGFloat)minimumYValue {
+  return ([self.dataSource respondsToSelector:@selector(graphViewMinimumYValue:)]
+          ? [self.dataSource graphViewMinimumYValue:self] : 0);
+}
+
+- (void)removeSegments {
+  [_segmentLayers makeObjectsPerformSelector:@selector(removeFromSuperlayer)];
+  [_segmentLayers removeAllObjects];
+  _hasLastPoint = NO;
+}
+
+- (CGPoint)stripPointForPoint:(CGPoint)point {
+  CGFloat scaledY = (point.y - _minimumYValue) / _yRange;
+  return CGPointMake(point.x * _pixelsPerXValue,
+                     NIOverviewGraphYPosition(scaledY, _stripSize.height));
+}
+
+- (void)appendNewSegment {
+  CGMutablePathRef path = CGPathCreateMutable();
+  BOOL hasSegment = NO;
+  if (_hasLastPoint) {
+    CGPoint stripPoint = [self stripPointForPoint:_lastPoint];
+    CGPathMoveToPoint(path, NULL, stripPoint.x, stripPoint.y);
+  }
+  CGPoint point = CGPointZero;
+  while ([self.dataSource nextPointInGraphView:self point:&point]) {
+    CGPoint stripPoint = [self stripPointForPoint:point];
+    if (_hasLastPoint) {
+      CGPathAddLineToPoint(path, NULL, stripPoint.x, stripPoint.y);
+      hasSegment = YES;
+    } else {
+      CGPathMoveToPoint(path, NULL, stripPoint.x, stripPoint.y);
+    }
+    _lastPoint = point;
+    _hasLastPoint = YES;
+  }
+
+  if (hasSegment) {
+    CAShapeLayer* segmentLayer = [CAShapeLayer layer];
+    segmentLayer.path = path;
+    segmentLayer.fillColor = nil;
+    segmentLayer.lineWidth = 1;
+    segmentLayer.lineJoin = kCALineJoinRound;
+    segmentLayer.strokeColor = [UIColor colorWithWhite:1 alpha:0.6f].CGColor;
+    [_stripLayer addSublayer:segmentLayer];
+    [_segmentLayers addObject:segmentLayer];
+  }
+  CGPathRelease(path);
+}
+
+- (void)removeSegmentsLeftOfStripX:(CGFloat)stripX {
+  while (_segmentLayers.count > 1) {
+    CAShapeLayer* segmentLayer = [_segmentLayers objectAtIndex:0];
+    if (CGRectGetMaxX(CGPathGetBoundingBox(segmentLayer.path)) >= stripX) {
+      break;
+    }
+    [segmentLayer removeFromSuperlayer];
+    [_segmentLayers removeObjectAtIndex:0];
+  }
+}
+
+- (void)reloadEventsWithMinimumXValue:(CGFloat)minimumXValue xRange:(CGFloat)xRange {
+  CGSize size = self.bounds.size;
+  NSMutableDictionary* pathsByColor = [NSMutableDictionary dictionary];
+
+  [self.dataSource resetEventIterator];
+  CGFloat xValue = 0;
+  UIColor* color = nil;
+  while ([self.dataSource nextEventInGraphView:self xValue:&xValue color:&color]) {
+    CGFloat plotX = NICGFloatFloor((xValue - minimumXValue) / xRange * size.width) - 0.5f;
+    UIBezierPath* path = [pathsByColor objectForKey:color];
+    if (nil == path) {
+      path = [UIBezierPath bezierPath];
+      [pathsByColor setObject:path forKey:color];
+    }
+    [path moveToPoint:CGPointMake(plotX, 0)];
+    [path addLineToPoint:CGPointMake(plotX, size.height)];
+  }
+
+  _eventsLayer.sublayers = nil;
+  for (UIColor* eventColor in pathsByColor) {
+    CAShapeLayer* eventLayer = [CAShapeLayer layer];
+    eventLayer.path = [[pathsByColor objectForKey:eventColor] CGPath];
+    eventLayer.lineWidth = 1;
+    eventLayer.strokeColor = eventColor.CGColor;
+    [_eventsLayer addSublayer:eventLayer];
+  }
+}
+
+- (void)reloadData {
+  if (![self dataSourceRendersIncrementally]) {
+    [self setNeedsDisplay];
+    return;
+  }
+
+  CGSize size = self.bounds.size;
+  CGFloat xRange = [self.dataSource graphViewXRange:self];
+  CGFloat yRange = [self.dataSource graphViewYRange:self];
+
+  [CATransaction begin];
+  [CATransaction setDisableActions:YES];
+
+  if (xRange == 0 || yRange == 0 || size.width <= 0 || size.height <= 0) {
+    [self removeSegments];
+    _eventsLayer.sublayers = nil;
+
+  } else {
+    CGFloat minimumXValue = [self minimumXValue];
+    CGFloat minimumYValue = [self minimumYValue];
+    CGFloat pixelsPerXValue = size.width / xRange;
+
+    BOOL needsRebuild = (!_hasLastPoint
+                         || yRange != _yRange
+                         || minimumYValue != _minimumYValue
+                         || !CGSizeEqualToSize(size, _stripSize)
+                         || fabs(pixelsPerXValue - _pixelsPerXValue)
+                            > _pixelsPerXValue * kStripScaleTolerance);
+    if (needsRebuild) {
+      [self removeSegments];
+      _pixelsPerXValue = pixelsPerXValue;
+      _minimumYValue = minimumYValue;
+      _yRange = yRange;
+      _stripSize = size;
+      [self.dataSource resetPointIterator];
+    } else {
+      [self.dataSource resetPointIteratorAfterXValue:_lastPoint.x];
+    }
+    [self appendNewSegment];
+
+    CGFloat stripOffset = minimumXValue * _pixelsPerXValue;
+    _stripLayer.frame = self.bounds;
+    _stripLayer.transform = CATransform3DMakeTranslation(-stripOffset, 0, 0);
+    [self removeSegmentsLeftOfStripX:stripOffset];
+
+    _eventsLayer.frame = self.bounds;
+    [self reloadEventsWithMinimumXValue:minimumXValue xRange:xRange];
+  }
+
+  [CATransaction commit];
+}
+
+- (void)layoutSubviews {
+  [super layoutSubviews];
+
+  if ([self dataSourceRendersIncrementally]
+      && !CGSizeEqualToSize(self.bounds.size, _stripSize)) {
+    [self reloadData];
+  }
+}
+
 - (void)drawGraphWithContext:(CGContextRef)context {
   CGSize contentSize = self.bounds.size;
 
@@ -43,6 +232,8 @@
   if (xRange == 0 || yRange == 0) {
     return;
   }
+  CGFloat minimumXValue = [self minimumXValue];
+  CGFloat minimumYValue = [self minimumYValue];
 
   [self.dataSource resetPointIterator];
 
@@ -52,11 +243,12 @@
   BOOL isFirstPoint = YES;
   CGPoint point = CGPointZero;
   while ([self.dataSource nextPointInGraphView:self point:&point]) {
-    CGPoint scaledPoint = CGPointMake(point.x / xRange, point.y / yRange);
+    CGPoint scaledPoint = CGPointMake((point.x - minimumXValue) / xRange,
+                                      (point.y - minimumYValue) / yRange);
     CGPoint plotPoint = CGPointMake(NICGFloatFloor(scaledPoint.x * contentSize.width) - 0.5f,
-                                    contentSize.height
-                                    - NICGFloatFloor((scaledPoint.y * 0.8f + 0.1f)
-                                                     * contentSize.height) - 0.5f);
+                                    NICGFloatFloor(NIOverviewGraphYPosition(scaledPoint.y,
+                                                                            contentSize.height))
+                                    - 0.5f);
     if (!isFirstPoint) {
       CGContextAddLineToPoint(context, plotPoint.x, plotPoint.y);
     }
@@ -72,7 +264,7 @@
   CGFloat xValue = 0;
   UIColor* color = nil;
   while ([self.dataSource nextEventInGraphView:self xValue:&xValue color:&color]) {
-    CGFloat scaledXValue = xValue / xRange;
+    CGFloat scaledXValue = (xValue - minimumXValue) / xRange;
     CGFloat plotXValue = NICGFloatFloor(scaledXValue * contentSize.width) - 0.5f;
     CGContextMoveToPoint(context, plotXValue, 0);
     CGContextAddLineToPoint(context, plotXValue, contentSize.height);
@@ -89,7 +281,10 @@
   
   UIGraphicsPushContext(context);
 
-  [self drawGraphWithContext:context];
+  // Incremental data sources are rendered by the segment layers instead.
+  if (![self dataSourceRendersIncrementally]) {
+    [self drawGraphWithContext:context];
+  }
   
 	CGContextSetFillColorWithColor(context, [UIColor colorWithWhite:1 alpha:0.2f].CGColor);
 	CGContextFillRect(context, bounds);
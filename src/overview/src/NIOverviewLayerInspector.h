@@ -0,0 +1,102 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <QuartzCore/QuartzCore.h>
+
+typedef enum {
+  NIOverviewLayerIssueOffscreenMask,       // A mask or rounded corners that clip sublayers.
+  NIOverviewLayerIssueShadowWithoutPath,   // The shadow's shape has to be found offscreen.
+  NIOverviewLayerIssueBlending,            // Translucent content is blended over opaque content.
+  NIOverviewLayerIssueMisscaledImage,      // The image has more or fewer pixels than it shows.
+  NIOverviewLayerIssueRasterizationMiss,   // The rasterized bitmap can't be reused between frames.
+} NIOverviewLayerIssueType;
+
+/**
+ * Finds the layers in a layer tree that are likely to be expensive to composite.
+ *
+ * @ingroup Overview-Sensors
+ *
+ * Core Animation's render server does most of its work out of process, so the reasons that a
+ * screen composites slowly are hard to see from the app. The inspector walks the layer tree's
+ * model layers and flags these common costs:
+ *
+ * - Layers with a mask, or with a corner radius and masksToBounds that clip sublayers. These
+ *   are rendered offscreen every frame.
+ * - Layers with a shadow but no shadowPath. The shadow's shape is found by rendering the layer
+ *   offscreen.
+ * - Layers with a translucent background, partial opacity or an image with an alpha channel
+ *   that sit over an opaque layer. Every pixel has to be blended.
+ * - Layers whose image has a pixel size that doesn't match the size it is displayed at. This
+ *   usually means an NINetworkImageView was given the original image rather than one scaled to
+ *   fit its bounds.
+ * - Rasterized layers whose bitmap is rebuilt every frame because they animate, are too large
+ *   to cache, or are rasterized at a lower scale than they are shown.
+ *
+ * Hidden and fully transparent layers are skipped along with their sublayers.
+ *
+ * These are heuristics. Each issue says what was found, and Instruments has the final word.
+ */
+@interface NIOverviewLayerInspector : NSObject
+
+/**
+ * Returns the issues in the given layer tree, in the order the layers were visited.
+ *
+ * Must be called from the main thread.
+ *
+ *      @param rootLayer The layer to start from. Issue frames are in its coordinate space.
+ *      @param excludedLayers Layers that are skipped along with their sublayers, such as the
+ *                            Overview itself.
+ *      @returns An array of NIOverviewLayerIssue objects.
+ */
++ (NSArray *)issuesInLayerTree:(CALayer *)rootLayer excludingLayers:(NSSet *)excludedLayers;
+
+/**
+ * Returns the name of the given issue type.
+ */
++ (NSString *)nameOfIssueType:(NIOverviewLayerIssueType)type;
+
+@end
+
+/**
+ * A compositing cost found by NIOverviewLayerInspector.
+ *
+ * @ingroup Overview-Sensors
+ */
+@interface NIOverviewLayerIssue : NSObject
+
+/**
+ * The kind of cost.
+ */
+@property (nonatomic, readonly) NIOverviewLayerIssueType type;
+
+/**
+ * The layer with the cost.
+ */
+@property (nonatomic, readonly, weak) CALayer* layer;
+
+/**
+ * The layer's bounds in the coordinate space of the inspected root layer.
+ */
+@property (nonatomic, readonly) CGRect frame;
+
+/**
+ * What was found, e.g. "UIImageView: 1024x768 px image shown at 200x150 px".
+ */
+@property (nonatomic, readonly, copy) NSString* summary;
+
+@end
@@ -0,0 +1,245 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIOverviewLayerInspector.h"
+
+#import "NimbusCore.h"
+
+#import <UIKit/UIKit.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// Images are flagged when they have this many times more, or fewer, pixels along an axis than
+// they are displayed with.
+static const CGFloat kMaximumImageDownscale = 1.25f;
+static const CGFloat kMaximumImageUpscale = 0.8f;
+
+// Core Animation doesn't cache rasterized layers much larger than the screen.
+static const CGFloat kMaximumRasterizedScreenAreas = 2.5f;
+
+@interface NIOverviewLayerIssue()
+- (id)initWithType:(NIOverviewLayerIssueType)type layer:(CALayer *)layer frame:(CGRect)frame
+           summary:(NSString *)summary;
+@end
+
+static NSString* NIOverviewNameOfLayer(CALayer* layer) {
+  id delegate = layer.delegate;
+  if ([delegate isKindOfClass:[UIView class]]) {
+    return NSStringFromClass([delegate class]);
+  }
+  return NSStringFromClass([layer class]);
+}
+
+static BOOL NIOverviewLayerTreeIsAnimating(CALayer* layer) {
+  if ([layer animationKeys].count > 0) {
+    return YES;
+  }
+  for (CALayer* sublayer in layer.sublayers) {
+    if (NIOverviewLayerTreeIsAnimating(sublayer)) {
+      return YES;
+    }
+  }
+  return NO;
+}
+
+// The image contents of a layer, if it has any. Views that draw themselves have a backing store
+// instead, which this ignores.
+static CGImageRef NIOverviewImageOfLayer(CALayer* layer) {
+  id contents = layer.contents;
+  if (nil != contents && CFGetTypeID((__bridge CFTypeRef)contents) == CGImageGetTypeID()) {
+    return (__bridge CGImageRef)contents;
+  }
+  return NULL;
+}
+
+static BOOL NIOverviewImageHasAlpha(CGImageRef image) {
+  CGImageAlphaInfo alphaInfo = CGImageGetAlphaInfo(image);
+  return (kCGImageAlphaNone != alphaInfo
+          && kCGImageAlphaNoneSkipFirst != alphaInfo
+          && kCGImageAlphaNoneSkipLast != alphaInfo);
+}
+
+@implementation NIOverviewLayerInspector
+
++ (NSString *)nameOfIssueType:(NIOverviewLayerIssueType)type {
+  switch (type) {
+    case NIOverviewLayerIssueOffscreenMask:
+      return NSLocalizedString(@"Offscreen mask", @"Overview: Layer issue");
+    case NIOverviewLayerIssueShadowWithoutPath:
+      return NSLocalizedString(@"Shadow without path", @"Overview: Layer issue");
+    case NIOverviewLayerIssueBlending:
+      return NSLocalizedString(@"Blending", @"Overview: Layer issue");
+    case NIOverviewLayerIssueMisscaledImage:
+      return NSLocalizedString(@"Misscaled image", @"Overview: Layer issue");
+    case NIOverviewLayerIssueRasterizationMiss:
+      return NSLocalizedString(@"Rasterization miss", @"Overview: Layer issue");
+  }
+  return nil;
+}
+
++ (NSArray *)issuesInLayerTree:(CALayer *)rootLayer excludingLayers:(NSSet *)excludedLayers {
+  NIDASSERT([NSThread isMainThread]);
+  NSMutableArray* issues = [NSMutableArray array];
+  [self inspectLayer:rootLayer
+           rootLayer:rootLayer
+      excludedLayers:excludedLayers
+ isOverOpaqueContent:NO
+         screenScale:[UIScreen mainScreen].scale
+              issues:issues];
+  return issues;
+}
+
++ (void)inspectLayer:(CALayer *)layer
+           rootLayer:(CALayer *)rootLayer
+      excludedLayers:(NSSet *)excludedLayers
+ isOverOpaqueContent:(BOOL)isOverOpaqueContent
+         screenScale:(CGFloat)screenScale
+              issues:(NSMutableArray *)issues {
+  if (layer.hidden || layer.opacity <= 0 || [excludedLayers containsObject:layer]) {
+    return;
+  }
+
+  NSString* name = NIOverviewNameOfLayer(layer);
+  CGRect frame = [layer convertRect:layer.bounds toLayer:rootLayer];
+  void (^addIssue)(NIOverviewLayerIssueType, NSString*) = ^(NIOverviewLayerIssueType type,
+                                                           NSString* details) {
+    NSString* summary = [NSString stringWithFormat:@"%@: %@", name, details];
+    [issues addObject:[[NIOverviewLayerIssue alloc] initWithType:type layer:layer frame:frame
+                                                         summary:summary]];
+  };
+
+  if (nil != layer.mask) {
+    addIssue(NIOverviewLayerIssueOffscreenMask, @"mask layer");
+  } else if (layer.cornerRadius > 0 && layer.masksToBounds && layer.sublayers.count > 0) {
+    addIssue(NIOverviewLayerIssueOffscreenMask,
+             [NSString stringWithFormat:@"corner radius %.0f clips %lu sublayers",
+              layer.cornerRadius, (unsigned long)layer.sublayers.count]);
+  }
+
+  if (layer.shadowOpacity > 0 && NULL == layer.shadowPath
+      && NULL != layer.shadowColor && CGColorGetAlpha(layer.shadowColor) > 0) {
+    addIssue(NIOverviewLayerIssueShadowWithoutPath,
+             [NSString stringWithFormat:@"shadow radius %.0f without a shadowPath",
+              layer.shadowRadius]);
+  }
+
+  CGFloat backgroundAlpha = (NULL != layer.backgroundColor
+                             ? CGColorGetAlpha(layer.backgroundColor) : 0);
+  CGImageRef image = NIOverviewImageOfLayer(layer);
+  if (isOverOpaqueContent && !layer.opaque) {
+    NSMutableArray* reasons = [NSMutableArray array];
+    if (layer.opacity < 1) {
+      [reasons addObject:[NSString stringWithFormat:@"opacity %.2f", layer.opacity]];
+    }
+    if (backgroundAlpha > 0 && backgroundAlpha < 1) {
+      [reasons addObject:[NSString stringWithFormat:@"background alpha %.2f", backgroundAlpha]];
+    }
+    if (NULL != image && NIOverviewImageHasAlpha(image)) {
+      [reasons addObject:@"image with an alpha channel"];
+    }
+    if (reasons.count > 0) {
+      addIssue(NIOverviewLayerIssueBlending,
+               [NSString stringWithFormat:@"%@ over opaque content",
+                [reasons componentsJoinedByString:@", "]]);
+    }
+  }
+
+  if (NULL != image) {
+    [self inspectImage:image ofLayer:layer screenScale:screenScale addIssue:addIssue];
+  }
+
+  if (layer.shouldRasterize) {
+    CGSize screenSize = [UIScreen mainScreen].bounds.size;
+    CGFloat screenArea = screenSize.width * screenSize.height;
+    CGFloat area = layer.bounds.size.width * layer.bounds.size.height;
+    if (NIOverviewLayerTreeIsAnimating(layer)) {
+      addIssue(NIOverviewLayerIssueRasterizationMiss, @"rasterized while animating");
+    } else if (screenArea > 0 && area > screenArea * kMaximumRasterizedScreenAreas) {
+      addIssue(NIOverviewLayerIssueRasterizationMiss,
+               [NSString stringWithFormat:@"rasterized at %.1f screens, too large to cache",
+                area / screenArea]);
+    }
+  }
+
+  BOOL isOpaque = (layer.opaque || (backgroundAlpha >= 1 && layer.opacity >= 1));
+  for (CALayer* sublayer in [layer.sublayers copy]) {
+    [self inspectLayer:sublayer
+             rootLayer:rootLayer
+        excludedLayers:excludedLayers
+   isOverOpaqueContent:(isOverOpaqueContent || isOpaque)
+           screenScale:screenScale
+                issues:issues];
+  }
+}
+
++ (void)inspectImage:(CGImageRef)image
+             ofLayer:(CALayer *)layer
+         screenScale:(CGFloat)screenScale
+            addIssue:(void (^)(NIOverviewLayerIssueType, NSString*))addIssue {
+  // Other gravities draw the image at its own size.
+  NSString* gravity = layer.contentsGravity;
+  BOOL isResize = [gravity isEqualToString:kCAGravityResize];
+  BOOL isAspectFit = [gravity isEqualToString:kCAGravityResizeAspect];
+  BOOL isAspectFill = [gravity isEqualToString:kCAGravityResizeAspectFill];
+  if (!isResize && !isAspectFit && !isAspectFill) {
+    return;
+  }
+
+  CGFloat pixelWidth = CGImageGetWidth(image) * layer.contentsRect.size.width;
+  CGFloat pixelHeight = CGImageGetHeight(image) * layer.contentsRect.size.height;
+  CGFloat displayWidth = layer.bounds.size.width * screenScale;
+  CGFloat displayHeight = layer.bounds.size.height * screenScale;
+  if (pixelWidth <= 0 || pixelHeight <= 0 || displayWidth <= 0 || displayHeight <= 0) {
+    return;
+  }
+
+  CGFloat widthScale = pixelWidth / displayWidth;
+  CGFloat heightScale = pixelHeight / displayHeight;
+  CGFloat minimumScale = MIN(widthScale, heightScale);
+  CGFloat maximumScale = MAX(widthScale, heightScale);
+  if (isAspectFit) {
+    // The axis that fits decides the scale.
+    minimumScale = maximumScale;
+  } else if (isAspectFill) {
+    maximumScale = minimumScale;
+  }
+
+  if (maximumScale > kMaximumImageDownscale || minimumScale < kMaximumImageUpscale) {
+    addIssue(NIOverviewLayerIssueMisscaledImage,
+             [NSString stringWithFormat:@"%.0fx%.0f px image shown at %.0fx%.0f px",
+              pixelWidth, pixelHeight, displayWidth, displayHeight]);
+  }
+}
+
+@end
+
+@implementation NIOverviewLayerIssue
+
+- (id)initWithType:(NIOverviewLayerIssueType)type layer:(CALayer *)layer frame:(CGRect)frame
+           summary:(NSString *)summary {
+  if ((self = [super init])) {
+    _type = type;
+    _layer = layer;
+    _frame = frame;
+    _summary = [summary copy];
+  }
+  return self;
+}
+
+@end
@@ -17,14 +17,96 @@
 #import <Foundation/Foundation.h>
 #import <UIKit/UIKit.h>
 
+#import "NIPreprocessorMacros.h" /* for __NI_DEPRECATED_METHOD */
+
 extern NSString* const NIOverviewLoggerDidAddDeviceLog;
 extern NSString* const NIOverviewLoggerDidAddConsoleLog;
 extern NSString* const NIOverviewLoggerDidAddEventLog;
+extern NSString* const NIOverviewLoggerDidAddStallLog;
 
+@class NIRingBuffer;
 @class NIOverviewDeviceLogEntry;
 @class NIOverviewConsoleLogEntry;
 @class NIOverviewEventLogEntry;
 
+typedef enum {
+  NIOverviewEventDidReceiveMemoryWarning,
+  NIOverviewEventHitch, // A frame took longer than the frame rate page's hitch threshold.
+  NIOverviewEventStall, // The main thread stopped responding to the watchdog.
+} NIOverviewEventType;
+
+/**
+ * A single device measurement.
+ *
+ * @ingroup Overview-Logger-Entries
+ *
+ * Timestamps are monotonic CACurrentMediaTime() values.
+ */
+typedef struct {
+  CFTimeInterval timestamp;
+  unsigned long long bytesOfFreeMemory;
+  unsigned long long bytesOfTotalMemory;
+  unsigned long long bytesOfFreeDiskSpace;
+  unsigned long long bytesOfTotalDiskSpace;
+  CGFloat batteryLevel;
+  UIDeviceBatteryState batteryState;
+  CGFloat processCPUUsage; // 1.0 is one core's worth of time.
+} NIOverviewDeviceSample;
+
+/**
+ * A single console log.
+ *
+ * @ingroup Overview-Logger-Entries
+ *
+ * The log text is owned by the logger and is only valid until the sample is overwritten.
+ */
+typedef struct {
+  CFTimeInterval timestamp;
+  __unsafe_unretained NSString* log;
+} NIOverviewConsoleSample;
+
+/**
+ * A single event.
+ *
+ * @ingroup Overview-Logger-Entries
+ */
+typedef struct {
+  CFTimeInterval timestamp;
+  NSInteger type;
+} NIOverviewEventSample;
+
+/**
+ * A single displayed frame.
+ *
+ * @ingroup Overview-Logger-Entries
+ *
+ * timestamp is the display link timestamp of the frame and duration is the time since the
+ * previous frame.
+ */
+typedef struct {
+  CFTimeInterval timestamp;
+  CFTimeInterval duration;
+} NIOverviewFrameSample;
+
+enum {
+  NIOverviewStallSampleMaximumNumberOfFrames = 32,
+};
+
+/**
+ * A main thread stall recorded by NIOverviewWatchdog.
+ *
+ * @ingroup Overview-Logger-Entries
+ *
+ * frames holds the return addresses of the main thread's stack, innermost first, as captured
+ * while the main thread was stalled.
+ */
+typedef struct {
+  CFTimeInterval timestamp;
+  CFTimeInterval duration;
+  NSUInteger numberOfFrames;
+  uintptr_t frames[NIOverviewStallSampleMaximumNumberOfFrames];
+} NIOverviewStallSample;
+
 /**
  * The Overview logger.
  *
@@ -34,6 +116,11 @@ extern NSString* const NIOverviewLoggerDidAddEventLog;
  * Overview memory and disk pages, as well as the console log page.
  *
  * The primary log should be accessed by calling [NIOverview @link NIOverview::logger logger@endlink].
+ *
+ * Twice a second a heartbeat samples the device on a utility queue, so sampling continues while
+ * the main thread is tracking touches. The samples are added to the log on the main thread and
+ * NIOverviewLoggerDidAddDeviceLog is posted once per batch, however many samples arrived while
+ * the main thread was busy. All other methods must be called from the main thread.
  */
 @interface NIOverviewLogger : NSObject
 
@@ -54,50 +141,156 @@ extern NSString* const NIOverviewLoggerDidAddEventLog;
 
 #pragma mark Adding Log Entries /** @name Adding Log Entries */
 
+/**
+ * Add a device sample.
+ *
+ * This method will first prune expired samples and then add the new sample to the log.
+ */
+- (void)addDeviceSample:(NIOverviewDeviceSample)sample;
+
 /**
  * Add a device log.
  *
- * This method will first prune expired entries and then add the new entry to the log.
+ * The entry is copied into a device sample. Prefer addDeviceSample:.
  */
 - (void)addDeviceLog:(NIOverviewDeviceLogEntry *)logEntry;
 
 /**
  * Add a console log.
  *
- * This method will not prune console log entries.
+ * This method will not prune console log entries by age. Only the most recent 1000 console
+ * logs are kept.
  */
 - (void)addConsoleLog:(NIOverviewConsoleLogEntry *)logEntry;
 
+/**
+ * Add a console log from its raw bytes.
+ *
+ * The bytes are kept as they are and decoded the first time the sample is read with
+ * consoleSampleAtIndex:, so logs that nobody looks at are never turned into strings. The
+ * timestamp is in the CACurrentMediaTime() time base.
+ *
+ * NIOverviewLoggerDidAddConsoleLog is posted once on the next turn of the main queue, however many
+ * logs are added before then, and has no userInfo.
+ */
+- (void)addConsoleLogData:(NSData *)data timestamp:(CFTimeInterval)timestamp;
+
+/**
+ * Add an event sample.
+ *
+ * This method will first prune expired samples and then add the new sample to the log.
+ */
+- (void)addEventSample:(NIOverviewEventSample)sample;
+
 /**
  * Add a event log.
  *
- * This method will first prune expired entries and then add the new entry to the log.
+ * The entry is copied into an event sample.
  */
 - (void)addEventLog:(NIOverviewEventLogEntry *)logEntry;
 
+/**
+ * Add a frame sample.
+ *
+ * This method will first prune expired samples and then add the new sample to the log. Frames
+ * arrive at the display's refresh rate, so no notification is posted.
+ */
+- (void)addFrameSample:(NIOverviewFrameSample)sample;
+
+/**
+ * Add a stall sample.
+ *
+ * Stalls are not pruned by age. Only the most recent 64 stalls are kept.
+ */
+- (void)addStallSample:(NIOverviewStallSample)sample;
+
 
 #pragma mark Accessing Logs /** @name Accessing Logs */
 
 /**
- * The linked list of device logs.
+ * The number of device samples in the log.
+ */
+- (NSUInteger)numberOfDeviceSamples;
+
+/**
+ * The device sample at the given index.
  *
- * Log entries are in increasing chronological order.
+ * Samples are in increasing chronological order, so index 0 is the oldest sample. Samples are
+ * stored by value in a fixed-capacity ring buffer and reading them performs no allocations.
+ */
+- (NIOverviewDeviceSample)deviceSampleAtIndex:(NSUInteger)index;
+
+/**
+ * The number of console samples in the log.
  */
-@property (nonatomic, readonly, strong) NSMutableOrderedSet* deviceLogs;
+- (NSUInteger)numberOfConsoleSamples;
 
 /**
- * The linked list of console logs.
+ * The console sample at the given index.
  *
- * Log entries are in increasing chronological order.
+ * Samples are in increasing chronological order.
  */
-@property (nonatomic, readonly, strong) NSMutableOrderedSet* consoleLogs;
+- (NIOverviewConsoleSample)consoleSampleAtIndex:(NSUInteger)index;
 
 /**
- * The linked list of events.
+ * The number of event samples in the log.
+ */
+- (NSUInteger)numberOfEventSamples;
+
+/**
+ * The event sample at the given index.
+ *
+ * Samples are in increasing chronological order.
+ */
+- (NIOverviewEventSample)eventSampleAtIndex:(NSUInteger)index;
+
+/**
+ * The number of frame samples in the log.
+ */
+- (NSUInteger)numberOfFrameSamples;
+
+/**
+ * The frame sample at the given index.
  *
- * Log entries are in increasing chronological order.
+ * Samples are in increasing chronological order.
  */
-@property (nonatomic, readonly, strong) NSMutableOrderedSet* eventLogs;
+- (NIOverviewFrameSample)frameSampleAtIndex:(NSUInteger)index;
+
+/**
+ * The number of stall samples in the log.
+ */
+- (NSUInteger)numberOfStallSamples;
+
+/**
+ * The stall sample at the given index.
+ *
+ * Samples are in increasing chronological order.
+ */
+- (NIOverviewStallSample)stallSampleAtIndex:(NSUInteger)index;
+
+/**
+ * A ring buffer of device log entries made from the device samples.
+ *
+ * Log entries are in increasing chronological order. Every call allocates a new ring buffer and
+ * entries, so use numberOfDeviceSamples and deviceSampleAtIndex: instead.
+ */
+@property (nonatomic, readonly, strong) NIRingBuffer* deviceLogs __NI_DEPRECATED_METHOD; // Use deviceSampleAtIndex: instead. MAINTENANCE: Remove by Apr 15, 2027.
+
+/**
+ * A ring buffer of console log entries made from the console samples.
+ *
+ * Log entries are in increasing chronological order. Every call allocates a new ring buffer and
+ * entries, so use numberOfConsoleSamples and consoleSampleAtIndex: instead.
+ */
+@property (nonatomic, readonly, strong) NIRingBuffer* consoleLogs __NI_DEPRECATED_METHOD; // Use consoleSampleAtIndex: instead. MAINTENANCE: Remove by Apr 15, 2027.
+
+/**
+ * A ring buffer of event log entries made from the event samples.
+ *
+ * Log entries are in increasing chronological order. Every call allocates a new ring buffer and
+ * entries, so use numberOfEventSamples and eventSampleAtIndex: instead.
+ */
+@property (nonatomic, readonly, strong) NIRingBuffer* eventLogs __NI_DEPRECATED_METHOD; // Use eventSampleAtIndex: instead. MAINTENANCE: Remove by Apr 15, 2027.
 
 @end
 
@@ -168,6 +361,11 @@ extern NSString* const NIOverviewLoggerDidAddEventLog;
  */
 @property (nonatomic, assign) UIDeviceBatteryState batteryState;
 
+/**
+ * The CPU usage of the process, where 1.0 is one core's worth of time.
+ */
+@property (nonatomic, assign) CGFloat processCPUUsage;
+
 @end
 
 
@@ -196,10 +394,6 @@ extern NSString* const NIOverviewLoggerDidAddEventLog;
 @end
 
 
-typedef enum {
-  NIOverviewEventDidReceiveMemoryWarning,
-} NIOverviewEventType;
-
 /**
  * An event log entry.
  *
@@ -16,6 +16,8 @@
 
 #import "NIOverviewLogger.h"
 #import "NIDeviceInfo.h"
+#import "NimbusCore.h"
+#import <QuartzCore/QuartzCore.h>
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "Nimbus requires ARC support."
@@ -24,13 +26,115 @@
 NSString* const NIOverviewLoggerDidAddDeviceLog = @"NIOverviewLoggerDidAddDeviceLog";
 NSString* const NIOverviewLoggerDidAddConsoleLog = @"NIOverviewLoggerDidAddConsoleLog";
 NSString* const NIOverviewLoggerDidAddEventLog = @"NIOverviewLoggerDidAddEventLog";
+NSString* const NIOverviewLoggerDidAddStallLog = @"NIOverviewLoggerDidAddStallLog";
+
+// Device logs arrive twice a second, so this holds several minutes of them. The age limit
+// normally prunes them long before they are overwritten.
+static const NSUInteger kDeviceLogCapacity = 1024;
+static const NSUInteger kConsoleLogCapacity = 1000;
+static const NSUInteger kEventLogCapacity = 1024;
+static const NSUInteger kStallLogCapacity = 64;
+// Over a minute of frames at 60 frames per second.
+static const NSUInteger kFrameLogCapacity = 4096;
+// Heartbeat samples wait here until the main thread moves them into the device log. This only
+// fills up when the main thread has been stalled for several seconds.
+static const NSUInteger kPendingDeviceSampleCapacity = 16;
+static const NSTimeInterval kHeartbeatInterval = 0.5;
+
+// Console logs that arrive from the console capture keep their raw bytes until they are read.
+// The leading fields match NIOverviewConsoleSample.
+typedef struct {
+  CFTimeInterval timestamp;
+  __unsafe_unretained NSString* log;
+  __unsafe_unretained NSData* data;
+} NIOverviewConsoleRecord;
+
+// A fixed-capacity ring of equally sized samples. Every sample type begins with its
+// CFTimeInterval timestamp, which lets pruning work on any ring.
+typedef struct {
+  char* samples;
+  size_t sampleSize;
+  NSUInteger capacity;
+  NSUInteger head;
+  NSUInteger count;
+} NIOverviewSampleRing;
+
+static void NIOverviewSampleRingInit(NIOverviewSampleRing* ring, size_t sampleSize,
+                                     NSUInteger capacity) {
+  ring->samples = calloc(capacity, sampleSize);
+  ring->sampleSize = sampleSize;
+  ring->capacity = capacity;
+  ring->head = 0;
+  ring->count = 0;
+}
+
+static void* NIOverviewSampleRingSampleAtIndex(const NIOverviewSampleRing* ring,
+                                               NSUInteger index) {
+  NIDASSERT(index < ring->count);
+  return ring->samples + ((ring->head + index) % ring->capacity) * ring->sampleSize;
+}
+
+static void NIOverviewSampleRingRemoveFirst(NIOverviewSampleRing* ring) {
+  NIDASSERT(ring->count > 0);
+  ring->head = (ring->head + 1) % ring->capacity;
+  ring->count--;
+}
+
+// Returns the slot for a new sample at the end of the ring, dropping the oldest sample when the
+// ring is full.
+static void* NIOverviewSampleRingAppend(NIOverviewSampleRing* ring) {
+  if (ring->count == ring->capacity) {
+    NIOverviewSampleRingRemoveFirst(ring);
+  }
+  ring->count++;
+  return NIOverviewSampleRingSampleAtIndex(ring, ring->count - 1);
+}
+
+static void NIOverviewSampleRingPrune(NIOverviewSampleRing* ring, CFTimeInterval cutoff) {
+  while (ring->count > 0
+         && *(CFTimeInterval *)NIOverviewSampleRingSampleAtIndex(ring, 0) < cutoff) {
+    NIOverviewSampleRingRemoveFirst(ring);
+  }
+}
+
+static void NIOverviewConsoleRecordRelease(NIOverviewConsoleRecord* record) {
+  if (nil != record->log) {
+    CFRelease((__bridge CFTypeRef)record->log);
+  }
+  if (nil != record->data) {
+    CFRelease((__bridge CFTypeRef)record->data);
+  }
+}
+
+// Log entries are stamped with dates; samples use the monotonic media clock.
+static CFTimeInterval NIOverviewMediaTimeFromDate(NSDate* date) {
+  return CACurrentMediaTime() + (nil != date ? [date timeIntervalSinceNow] : 0);
+}
+
+static NSDate* NIOverviewDateFromMediaTime(CFTimeInterval mediaTime) {
+  return [NSDate dateWithTimeIntervalSinceNow:mediaTime - CACurrentMediaTime()];
+}
 
 @implementation NIOverviewLogger {
-  NSMutableOrderedSet* _deviceLogs;
-  NSMutableOrderedSet* _consoleLogs;
-  NSMutableOrderedSet* _eventLogs;
+  NIOverviewSampleRing _deviceSamples;
+  NIOverviewSampleRing _consoleSamples;
+  NIOverviewSampleRing _eventSamples;
+  NIOverviewSampleRing _frameSamples;
+  NIOverviewSampleRing _stallSamples;
   NSTimeInterval _oldestLogAge;
-  NSTimer* _heartbeatTimer;
+
+  // The heartbeat samples the device on a utility queue so that it neither costs the main thread
+  // anything nor stops while the main run loop is tracking touches.
+  dispatch_queue_t _heartbeatQueue;
+  dispatch_source_t _heartbeatTimer;
+
+  // Guards the pending samples and the refresh flag, which are shared with the heartbeat queue.
+  // Every other ring is only touched on the main thread.
+  NIFastLock _pendingLock;
+  NIOverviewSampleRing _pendingDeviceSamples;
+  BOOL _isDeviceRefreshScheduled;
+
+  BOOL _isConsoleNotificationScheduled;
 }
 
 + (NIOverviewLogger*)sharedLogger
@@ -47,77 +151,323 @@ NSString* const NIOverviewLoggerDidAddEventLog = @"NIOverviewLoggerDidAddEventLo
 
 - (id)init {
   if ((self = [super init])) {
-    _deviceLogs = [[NSMutableOrderedSet alloc] init];
-    _consoleLogs = [[NSMutableOrderedSet alloc] init];
-    _eventLogs = [[NSMutableOrderedSet alloc] init];
+    NIOverviewSampleRingInit(&_deviceSamples, sizeof(NIOverviewDeviceSample), kDeviceLogCapacity);
+    NIOverviewSampleRingInit(&_consoleSamples, sizeof(NIOverviewConsoleRecord), kConsoleLogCapacity);
+    NIOverviewSampleRingInit(&_eventSamples, sizeof(NIOverviewEventSample), kEventLogCapacity);
+    NIOverviewSampleRingInit(&_frameSamples, sizeof(NIOverviewFrameSample), kFrameLogCapacity);
+    NIOverviewSampleRingInit(&_stallSamples, sizeof(NIOverviewStallSample), kStallLogCapacity);
     
+    NIOverviewSampleRingInit(&_pendingDeviceSamples, sizeof(NIOverviewDeviceSample),
+                             kPendingDeviceSampleCapacity);
+    NIFastLockInit(&_pendingLock, NIFastLockOptionNone);
+
     _oldestLogAge = 60;
-    
-    _heartbeatTimer = [NSTimer scheduledTimerWithTimeInterval: 0.5
-                                                       target: self
-                                                     selector: @selector(heartbeat)
-                                                     userInfo: nil
-                                                      repeats: YES];
+
+    if (&dispatch_queue_attr_make_with_qos_class != NULL) {
+      dispatch_queue_attr_t attributes =
+          dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0);
+      _heartbeatQueue = dispatch_queue_create("com.nimbuskit.overview.heartbeat", attributes);
+    } else {
+      // Quality of service classes are only available from iOS 8.
+      _heartbeatQueue = dispatch_queue_create("com.nimbuskit.overview.heartbeat", DISPATCH_QUEUE_SERIAL);
+      dispatch_set_target_queue(_heartbeatQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+    }
+    _heartbeatTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, _heartbeatQueue);
+    uint64_t interval = (uint64_t)(kHeartbeatInterval * NSEC_PER_SEC);
+
+    // A little leeway lets the system coalesce the heartbeat with other timers.
+    dispatch_source_set_timer(_heartbeatTimer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)interval),
+                              interval, interval / 10);
+    __weak NIOverviewLogger* weakSelf = self;
+    dispatch_source_set_event_handler(_heartbeatTimer, ^{
+      [weakSelf heartbeat];
+    });
+    dispatch_resume(_heartbeatTimer);
   }
   return self;
 }
 
 - (void)dealloc {
-  [_heartbeatTimer invalidate];
-  _heartbeatTimer = nil;
+  dispatch_source_cancel(_heartbeatTimer);
+  NIFastLockDestroy(&_pendingLock);
+
+  for (NSUInteger ix = 0; ix < _consoleSamples.count; ++ix) {
+    NIOverviewConsoleRecordRelease(NIOverviewSampleRingSampleAtIndex(&_consoleSamples, ix));
+  }
+  free(_deviceSamples.samples);
+  free(_consoleSamples.samples);
+  free(_eventSamples.samples);
+  free(_frameSamples.samples);
+  free(_stallSamples.samples);
+  free(_pendingDeviceSamples.samples);
 }
 
+// Runs on the heartbeat queue.
 - (void)heartbeat {
+  NIOverviewDeviceSample sample;
+  memset(&sample, 0, sizeof(sample));
   [NIDeviceInfo beginCachedDeviceInfo];
-  NIOverviewDeviceLogEntry* logEntry =
-  [[NIOverviewDeviceLogEntry alloc] initWithTimestamp:[NSDate date]];
-  logEntry.bytesOfTotalDiskSpace = [NIDeviceInfo bytesOfTotalDiskSpace];
-  logEntry.bytesOfFreeDiskSpace = [NIDeviceInfo bytesOfFreeDiskSpace];
-  logEntry.bytesOfFreeMemory = [NIDeviceInfo bytesOfFreeMemory];
-  logEntry.bytesOfTotalMemory = [NIDeviceInfo bytesOfTotalMemory];
-  logEntry.batteryLevel = [NIDeviceInfo batteryLevel];
-  logEntry.batteryState = [NIDeviceInfo batteryState];
+  sample.timestamp = CACurrentMediaTime();
+  sample.bytesOfTotalDiskSpace = [NIDeviceInfo bytesOfTotalDiskSpace];
+  sample.bytesOfFreeDiskSpace = [NIDeviceInfo bytesOfFreeDiskSpace];
+  sample.bytesOfFreeMemory = [NIDeviceInfo bytesOfFreeMemory];
+  sample.bytesOfTotalMemory = [NIDeviceInfo bytesOfTotalMemory];
+  sample.processCPUUsage = [NIDeviceInfo processCPUUsage];
   [NIDeviceInfo endCachedDeviceInfo];
-  
-  [self addDeviceLog:logEntry];
+
+  BOOL shouldScheduleRefresh = NO;
+  {
+    NI_LOCK_SCOPE(&_pendingLock);
+    *(NIOverviewDeviceSample *)NIOverviewSampleRingAppend(&_pendingDeviceSamples) = sample;
+    shouldScheduleRefresh = !_isDeviceRefreshScheduled;
+    _isDeviceRefreshScheduled = YES;
+  }
+
+  // Samples taken while the main thread is busy are picked up by the refresh that is already
+  // scheduled, so the device pages redraw once no matter how far behind the main thread is.
+  if (shouldScheduleRefresh) {
+    __weak NIOverviewLogger* weakSelf = self;
+    dispatch_async(dispatch_get_main_queue(), ^{
+      [weakSelf addPendingDeviceSamples];
+    });
+  }
 }
 
-- (void)pruneEntriesFromLinkedList:(NSMutableOrderedSet *)ll {
-  NSDate* cutoffDate = [NSDate dateWithTimeIntervalSinceNow:-_oldestLogAge];
-  while ([[((NIOverviewLogEntry *)[ll firstObject])
-           timestamp] compare:cutoffDate] == NSOrderedAscending) {
-    [ll removeObjectAtIndex:0];
+- (void)addPendingDeviceSamples {
+  NIDASSERT([NSThread isMainThread]);
+  NIOverviewDeviceSample samples[kPendingDeviceSampleCapacity];
+  NSUInteger numberOfSamples = 0;
+  {
+    NI_LOCK_SCOPE(&_pendingLock);
+    numberOfSamples = _pendingDeviceSamples.count;
+    for (NSUInteger ix = 0; ix < numberOfSamples; ++ix) {
+      samples[ix] = *(NIOverviewDeviceSample *)
+          NIOverviewSampleRingSampleAtIndex(&_pendingDeviceSamples, ix);
+    }
+    _pendingDeviceSamples.head = 0;
+    _pendingDeviceSamples.count = 0;
+    _isDeviceRefreshScheduled = NO;
+  }
+  if (0 == numberOfSamples) {
+    return;
+  }
+
+  // UIDevice is read here rather than on the heartbeat queue because UIKit expects the main
+  // thread. The battery changes far too slowly for the difference in time to matter.
+  CGFloat batteryLevel = [NIDeviceInfo batteryLevel];
+  UIDeviceBatteryState batteryState = [NIDeviceInfo batteryState];
+
+  NIOverviewSampleRingPrune(&_deviceSamples, CACurrentMediaTime() - _oldestLogAge);
+  for (NSUInteger ix = 0; ix < numberOfSamples; ++ix) {
+    samples[ix].batteryLevel = batteryLevel;
+    samples[ix].batteryState = batteryState;
+    *(NIOverviewDeviceSample *)NIOverviewSampleRingAppend(&_deviceSamples) = samples[ix];
   }
+
+  [[NSNotificationCenter defaultCenter] postNotificationName:NIOverviewLoggerDidAddDeviceLog
+                                                      object:nil];
 }
 
-- (void)addDeviceLog:(NIOverviewDeviceLogEntry *)logEntry {
-  [self pruneEntriesFromLinkedList:_deviceLogs];
+#pragma mark - Adding Log Entries
+
+
+- (void)addDeviceSample:(NIOverviewDeviceSample)sample {
+  NIOverviewSampleRingPrune(&_deviceSamples, CACurrentMediaTime() - _oldestLogAge);
+
+  *(NIOverviewDeviceSample *)NIOverviewSampleRingAppend(&_deviceSamples) = sample;
 
-  [_deviceLogs addObject:logEntry];
-  
   [[NSNotificationCenter defaultCenter] postNotificationName:NIOverviewLoggerDidAddDeviceLog
-                                                      object:nil
-                                                    userInfo:@{@"entry":logEntry}];
+                                                      object:nil];
+}
+
+- (void)addDeviceLog:(NIOverviewDeviceLogEntry *)logEntry {
+  NIOverviewDeviceSample sample;
+  sample.timestamp = NIOverviewMediaTimeFromDate(logEntry.timestamp);
+  sample.bytesOfTotalDiskSpace = logEntry.bytesOfTotalDiskSpace;
+  sample.bytesOfFreeDiskSpace = logEntry.bytesOfFreeDiskSpace;
+  sample.bytesOfFreeMemory = logEntry.bytesOfFreeMemory;
+  sample.bytesOfTotalMemory = logEntry.bytesOfTotalMemory;
+  sample.batteryLevel = logEntry.batteryLevel;
+  sample.batteryState = logEntry.batteryState;
+  sample.processCPUUsage = logEntry.processCPUUsage;
+  [self addDeviceSample:sample];
 }
 
 - (void)addConsoleLog:(NIOverviewConsoleLogEntry *)logEntry {
-  [_consoleLogs addObject:logEntry];
-  
+  NIOverviewConsoleRecord* record = [self appendConsoleRecord];
+  record->timestamp = NIOverviewMediaTimeFromDate(logEntry.timestamp);
+  record->log = (__bridge NSString *)CFBridgingRetain(logEntry.log ?: @"");
+
+  // The console page formats the entry itself, and the entry already exists, so pass it along.
   [[NSNotificationCenter defaultCenter] postNotificationName:NIOverviewLoggerDidAddConsoleLog
                                                       object:nil
                                                     userInfo:@{@"entry":logEntry}];
 }
 
+- (void)addConsoleLogData:(NSData *)data timestamp:(CFTimeInterval)timestamp {
+  NIOverviewConsoleRecord* record = [self appendConsoleRecord];
+  record->timestamp = timestamp;
+  record->data = (__bridge NSData *)CFBridgingRetain(data ?: [NSData data]);
+
+  // Chatty threads add logs in bursts, so observers hear about a burst once.
+  if (!_isConsoleNotificationScheduled) {
+    _isConsoleNotificationScheduled = YES;
+    __weak NIOverviewLogger* weakSelf = self;
+    dispatch_async(dispatch_get_main_queue(), ^{
+      NIOverviewLogger* logger = weakSelf;
+      if (nil != logger) {
+        logger->_isConsoleNotificationScheduled = NO;
+        [[NSNotificationCenter defaultCenter] postNotificationName:NIOverviewLoggerDidAddConsoleLog
+                                                            object:nil];
+      }
+    });
+  }
+}
+
+- (NIOverviewConsoleRecord *)appendConsoleRecord {
+  if (_consoleSamples.count == _consoleSamples.capacity) {
+    NIOverviewConsoleRecordRelease(NIOverviewSampleRingSampleAtIndex(&_consoleSamples, 0));
+  }
+  NIOverviewConsoleRecord* record = NIOverviewSampleRingAppend(&_consoleSamples);
+  record->log = nil;
+  record->data = nil;
+  return record;
+}
+
+- (void)addEventSample:(NIOverviewEventSample)sample {
+  NIOverviewSampleRingPrune(&_eventSamples, CACurrentMediaTime() - _oldestLogAge);
+
+  *(NIOverviewEventSample *)NIOverviewSampleRingAppend(&_eventSamples) = sample;
+
+  [[NSNotificationCenter defaultCenter] postNotificationName:NIOverviewLoggerDidAddEventLog
+                                                      object:nil];
+}
+
 - (void)addEventLog:(NIOverviewEventLogEntry *)logEntry {
-  [self pruneEntriesFromLinkedList:_eventLogs];
+  NIOverviewSampleRingPrune(&_eventSamples, CACurrentMediaTime() - _oldestLogAge);
 
-  [_eventLogs addObject:logEntry];
+  NIOverviewEventSample* sample = NIOverviewSampleRingAppend(&_eventSamples);
+  sample->timestamp = NIOverviewMediaTimeFromDate(logEntry.timestamp);
+  sample->type = logEntry.type;
   
   [[NSNotificationCenter defaultCenter] postNotificationName:NIOverviewLoggerDidAddEventLog
                                                       object:nil
                                                     userInfo:@{@"entry":logEntry}];
 }
 
+- (void)addFrameSample:(NIOverviewFrameSample)sample {
+  NIOverviewSampleRingPrune(&_frameSamples, sample.timestamp - _oldestLogAge);
+
+  *(NIOverviewFrameSample *)NIOverviewSampleRingAppend(&_frameSamples) = sample;
+}
+
+- (void)addStallSample:(NIOverviewStallSample)sample {
+  *(NIOverviewStallSample *)NIOverviewSampleRingAppend(&_stallSamples) = sample;
+
+  [[NSNotificationCenter defaultCenter] postNotificationName:NIOverviewLoggerDidAddStallLog
+                                                      object:nil];
+}
+
+#pragma mark - Accessing Logs
+
+
+- (NSUInteger)numberOfDeviceSamples {
+  return _deviceSamples.count;
+}
+
+- (NIOverviewDeviceSample)deviceSampleAtIndex:(NSUInteger)index {
+  return *(NIOverviewDeviceSample *)NIOverviewSampleRingSampleAtIndex(&_deviceSamples, index);
+}
+
+- (NSUInteger)numberOfConsoleSamples {
+  return _consoleSamples.count;
+}
+
+- (NIOverviewConsoleSample)consoleSampleAtIndex:(NSUInteger)index {
+  NIOverviewConsoleRecord* record = NIOverviewSampleRingSampleAtIndex(&_consoleSamples, index);
+  if (nil == record->log) {
+    // Decode the captured bytes the first time anyone asks for them. Lines that aren't valid
+    // UTF-8 are shown as Latin-1 rather than dropped.
+    NSData* data = CFBridgingRelease((__bridge CFTypeRef)record->data);
+    record->data = nil;
+    NSString* log = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+    if (nil == log) {
+      log = [[NSString alloc] initWithData:data encoding:NSISOLatin1StringEncoding];
+    }
+    record->log = (__bridge NSString *)CFBridgingRetain(log ?: @"");
+  }
+  NIOverviewConsoleSample sample;
+  sample.timestamp = record->timestamp;
+  sample.log = record->log;
+  return sample;
+}
+
+- (NSUInteger)numberOfEventSamples {
+  return _eventSamples.count;
+}
+
+- (NIOverviewEventSample)eventSampleAtIndex:(NSUInteger)index {
+  return *(NIOverviewEventSample *)NIOverviewSampleRingSampleAtIndex(&_eventSamples, index);
+}
+
+- (NSUInteger)numberOfFrameSamples {
+  return _frameSamples.count;
+}
+
+- (NIOverviewFrameSample)frameSampleAtIndex:(NSUInteger)index {
+  return *(NIOverviewFrameSample *)NIOverviewSampleRingSampleAtIndex(&_frameSamples, index);
+}
+
+- (NSUInteger)numberOfStallSamples {
+  return _stallSamples.count;
+}
+
+- (NIOverviewStallSample)stallSampleAtIndex:(NSUInteger)index {
+  return *(NIOverviewStallSample *)NIOverviewSampleRingSampleAtIndex(&_stallSamples, index);
+}
+
+#pragma mark - Deprecated Log Entries
+
+- (NIRingBuffer *)deviceLogs {
+  NIRingBuffer* logs = [[NIRingBuffer alloc] initWithCapacity:_deviceSamples.capacity];
+  for (NSUInteger ix = 0; ix < _deviceSamples.count; ++ix) {
+    NIOverviewDeviceSample sample = [self deviceSampleAtIndex:ix];
+    NIOverviewDeviceLogEntry* entry =
+        [[NIOverviewDeviceLogEntry alloc] initWithTimestamp:NIOverviewDateFromMediaTime(sample.timestamp)];
+    entry.bytesOfFreeMemory = sample.bytesOfFreeMemory;
+    entry.bytesOfTotalMemory = sample.bytesOfTotalMemory;
+    entry.bytesOfFreeDiskSpace = sample.bytesOfFreeDiskSpace;
+    entry.bytesOfTotalDiskSpace = sample.bytesOfTotalDiskSpace;
+    entry.batteryLevel = sample.batteryLevel;
+    entry.batteryState = sample.batteryState;
+    entry.processCPUUsage = sample.processCPUUsage;
+    [logs addObject:entry];
+  }
+  return logs;
+}
+
+- (NIRingBuffer *)consoleLogs {
+  NIRingBuffer* logs = [[NIRingBuffer alloc] initWithCapacity:_consoleSamples.capacity];
+  for (NSUInteger ix = 0; ix < _consoleSamples.count; ++ix) {
+    NIOverviewConsoleSample sample = [self consoleSampleAtIndex:ix];
+    NIOverviewConsoleLogEntry* entry = [[NIOverviewConsoleLogEntry alloc] initWithLog:sample.log];
+    entry.timestamp = NIOverviewDateFromMediaTime(sample.timestamp);
+    [logs addObject:entry];
+  }
+  return logs;
+}
+
+- (NIRingBuffer *)eventLogs {
+  NIRingBuffer* logs = [[NIRingBuffer alloc] initWithCapacity:_eventSamples.capacity];
+  for (NSUInteger ix = 0; ix < _eventSamples.count; ++ix) {
+    NIOverviewEventSample sample = [self eventSampleAtIndex:ix];
+    NIOverviewEventLogEntry* entry = [[NIOverviewEventLogEntry alloc] initWithType:sample.type];
+    entry.timestamp = NIOverviewDateFromMediaTime(sample.timestamp);
+    [logs addObject:entry];
+  }
+  return logs;
+}
+
 @end
 
 
@@ -25,7 +25,7 @@
 #endif
 
 @interface NIMemoryCache(Private)
-@property (nonatomic, strong) NSMutableOrderedSet* lruCacheObjects;
+- (NSArray *)lruCacheObjects;
 @end
 
 // Anonymous private category for LRU cache objects.
@@ -36,6 +36,7 @@
 @interface NIOverviewMemoryCacheController()
 @property (nonatomic, readonly, strong) NIMemoryCache* cache;
 @property (nonatomic, strong) NITableViewModel* model;
+@property (nonatomic, strong) NSTimer* refreshTimer;
 @end
 
 @implementation NIOverviewMemoryCacheController
@@ -43,6 +44,8 @@
 - (void)dealloc {
   NSNotificationCenter *nc = [NSNotificationCenter defaultCenter];
   [nc removeObserver:self];
+
+  [_refreshTimer invalidate];
 }
 
 - (id)initWithMemoryCache:(NIMemoryCache *)cache {
@@ -55,7 +58,8 @@
                name: UIApplicationDidReceiveMemoryWarningNotification
              object: nil];
     UIBarButtonItem* refreshButton = [[UIBarButtonItem alloc] initWithBarButtonSystemItem:UIBarButtonSystemItemRefresh target:self action:@selector(didTapRefreshButton:)];
-    self.navigationItem.rightBarButtonItem = refreshButton;
+    UIBarButtonItem* resetButton = [[UIBarButtonItem alloc] initWithTitle:@"Reset" style:UIBarButtonItemStyleBordered target:self action:@selector(didTapResetButton:)];
+    self.navigationItem.rightBarButtonItems = @[refreshButton, resetButton];
   }
   return self;
 }
@@ -75,11 +79,15 @@
   if ([self.cache isKindOfClass:[NIImageMemoryCache class]]) {
     NIImageMemoryCache* imageCache = (NIImageMemoryCache *)self.cache;
     summary = [NSString stringWithFormat:
-               @"Number of images: %zd\nNumber of pixels: %@/%@\nStress limit: %@",
+               @"Number of images: %zd\nNumber of pixels: %@/%@\nStress limit: %@"
+               @"\nNumber of bytes: %@/%@\nStress limit: %@",
                self.cache.count,
                NIStringFromBytes(imageCache.numberOfPixels),
                NIStringFromBytes(imageCache.maxNumberOfPixels),
-               NIStringFromBytes(imageCache.maxNumberOfPixelsUnderStress)];
+               NIStringFromBytes(imageCache.maxNumberOfPixelsUnderStress),
+               NIStringFromBytes(imageCache.numberOfBytes),
+               NIStringFromBytes(imageCache.maxNumberOfBytes),
+               NIStringFromBytes(imageCache.maxNumberOfBytesUnderStress)];
 
   } else {
     summary = [NSString stringWithFormat:
@@ -88,6 +96,24 @@
   }
   [contents addObject:[NITableViewModelFooter footerWithTitle:summary]];
 
+  // Display the cache's activity so that its limits can be tuned on a device.
+  NIMemoryCacheStatistics* statistics = [self.cache statistics];
+  [contents addObject:@"Activity"];
+  [contents addObject:[NITableViewModelFooter footerWithTitle:
+                       [NSString stringWithFormat:
+                        @"Hits: %llu\nMisses: %llu\nHit rate: %.1f%%\nStores: %llu"
+                        @"\nEvictions: %llu\nExpirations: %llu\nStress evictions: %llu"
+                        @"\nBytes evicted: %@\nAverage lock hold: %.2f\u00B5s",
+                        statistics.numberOfHits,
+                        statistics.numberOfMisses,
+                        statistics.hitRate * 100,
+                        statistics.numberOfStores,
+                        statistics.numberOfEvictions,
+                        statistics.numberOfExpirations,
+                        statistics.numberOfStressEvictions,
+                        NIStringFromBytes(statistics.numberOfBytesEvicted),
+                        statistics.averageLockHoldTime * 1000000]]];
+
   NSDateFormatter* formatter = [[NSDateFormatter alloc] init];
   // We care more about time than date here.
   [formatter setDateStyle:NSDateFormatterShortStyle];
@@ -147,6 +173,28 @@
   [self refreshModel];
 }
 
+- (void)viewWillAppear:(BOOL)animated {
+  [super viewWillAppear:animated];
+
+  // Keep the statistics live while the controller is on screen. An appearance that wasn't
+  // matched by a disappearance, as when an interactive pop is cancelled, must not leave the
+  // previous timer running.
+  [self.refreshTimer invalidate];
+  self.refreshTimer = [NSTimer scheduledTimerWithTimeInterval:1
+                                                       target:self
+                                                     selector:@selector(refreshTimerDidFire:)
+                                                     userInfo:nil
+                                                      repeats:YES];
+}
+
+- (void)viewWillDisappear:(BOOL)animated {
+  [super viewWillDisappear:animated];
+
+  // The timer retains its target, so it has to be stopped for the controller to go away.
+  [self.refreshTimer invalidate];
+  self.refreshTimer = nil;
+}
+
 #if __IPHONE_OS_VERSION_MIN_REQUIRED < NIIOS_6_0
 
 - (BOOL)shouldAutorotateToInterfaceOrientation:(UIInterfaceOrientation)toInterfaceOrientation {
@@ -169,4 +217,13 @@
   [self refreshModel];
 }
 
+- (void)didTapResetButton:(UIBarButtonItem *)button {
+  [self.cache resetStatistics];
+  [self refreshModel];
+}
+
+- (void)refreshTimerDidFire:(NSTimer *)timer {
+  [self refreshModel];
+}
+
 @end
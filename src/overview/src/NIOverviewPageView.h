@@ -88,7 +88,7 @@
   UILabel* _label1;
   UILabel* _label2;
   NIOverviewGraphView* _graphView;
-  NSEnumerator* _eventEnumerator;
+  NSUInteger _eventIndex;
 }
 
 @property (nonatomic, readonly, strong) UILabel* label1;
@@ -107,7 +107,7 @@
  */
 @interface NIOverviewMemoryPageView : NIOverviewGraphPageView {
 @private
-  NSEnumerator* _enumerator;
+  NSUInteger _pointIndex;
   unsigned long long _minMemory;
 }
 
@@ -123,16 +123,95 @@
  */
 @interface NIOverviewDiskPageView : NIOverviewGraphPageView {
 @private
-  NSEnumerator* _enumerator;
+  NSUInteger _pointIndex;
   unsigned long long _minDiskUse;
 }
 
 @end
 
 
+/**
+ * A page that renders a graph showing the process's CPU usage.
+ *
+ * The busiest thread is shown by name, or by the label of the dispatch queue it is running.
+ *
+ * @ingroup Overview-Pages
+ */
+@interface NIOverviewCPUPageView : NIOverviewGraphPageView {
+@private
+  NSUInteger _pointIndex;
+}
+
+@end
+
+
+/**
+ * A page that renders a graph showing the frame rate.
+ *
+ * Frames are timed with a CADisplayLink while the page is in a window. Frames that take longer
+ * than hitchThreshold are added to the Overview's event log as NIOverviewEventHitch events so
+ * that they line up with the graphs on every page.
+ *
+ * @ingroup Overview-Pages
+ */
+@interface NIOverviewFrameRatePageView : NIOverviewGraphPageView
+
+/**
+ * Frames that take longer than this many seconds are logged as hitches.
+ *
+ * By default this is 0.05 seconds, or three frames at 60 frames per second.
+ */
+@property (nonatomic, assign) NSTimeInterval hitchThreshold;
+
+@end
+
+
+/**
+ * A page that renders a graph of the network tasks reported to NINetworkActivity's task metrics.
+ *
+ * The graph shows throughput, or the number of active tasks after tapping the page. The host with
+ * the most recently finished tasks is shown with its median and 95th percentile time to first
+ * byte.
+ *
+ * @ingroup Overview-Pages
+ */
+@interface NIOverviewNetworkPageView : NIOverviewGraphPageView
+@end
+
+
+/**
+ * A page that renders a graph of malloc usage and of the live instances of tracked classes.
+ *
+ * Samples come from NIOverviewAllocationTracker. Tapping the page cycles the graph from the
+ * bytes in use across all malloc zones through the live instance count of each tracked class,
+ * so that leaks and unbounded caches show up as lines that only go up.
+ *
+ * This page is opt-in because tracking a class hooks its allocations for the rest of the
+ * session:
+ *
+ * @code
+ * NSArray* classes = @[[UIImage class], [NICSSRuleset class]];
+ * [[NIOverview view] addPageView:[NIOverviewAllocationPageView pageWithTrackedClasses:classes]];
+ * @endcode
+ *
+ * @ingroup Overview-Pages
+ */
+@interface NIOverviewAllocationPageView : NIOverviewGraphPageView
+
+/**
+ * Returns a page that tracks the given classes with the shared NIOverviewAllocationTracker.
+ */
++ (id)pageWithTrackedClasses:(NSArray *)classes;
+
+@end
+
+
 /**
  * A page that shows all of the logs sent to the console.
  *
+ * New logs are only formatted while the page is visible. Logs that arrive while it is scrolled
+ * out of view are added the next time it is shown.
+ *
  * @image html overview-log1.png "The log page."
  *
  * @ingroup Overview-Pages
@@ -141,11 +220,36 @@
 @private
   UIScrollView* _logScrollView;
   UILabel* _logLabel;
+  CFTimeInterval _lastLogTimestamp;
+  BOOL _needsLogUpdate;
 }
 
 @end
 
 
+/**
+ * A page that lists the main thread stalls recorded by NIOverviewWatchdog.
+ *
+ * Stalls are listed newest first with their duration and symbolicated main thread stack.
+ *
+ * @ingroup Overview-Pages
+ */
+@interface NIOverviewStallPageView : NIOverviewPageView
+@end
+
+
+/**
+ * A page that records and summarizes main thread profiles with NIOverviewProfiler.
+ *
+ * Tap Record to start sampling and Stop to end the recording. The page then lists the functions
+ * that the most samples were spent in and the busiest paths of the call tree.
+ *
+ * @ingroup Overview-Pages
+ */
+@interface NIOverviewProfilerPageView : NIOverviewPageView
+@end
+
+
 /**
  * A page that allows you to modify NIMaxLogLevel.
  *
@@ -180,6 +284,19 @@
 @end
 
 
+/**
+ * A page that finds the layers that are expensive to composite.
+ *
+ * Tap Inspect to walk the key window's layer tree with NIOverviewLayerInspector. Each issue is
+ * outlined over the app in a color for its type and listed on the page. Tap Clear to remove
+ * the outlines.
+ *
+ * @ingroup Overview-Pages
+ */
+@interface NIOverviewRenderingPageView : NIOverviewPageView
+@end
+
+
 /**
  * A page that adds run-time inspection features.
  *
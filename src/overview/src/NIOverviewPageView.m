@@ -19,10 +19,14 @@
 #if defined(DEBUG) || defined(NI_DEBUG)
 
 #import "NIOverview.h"
+#import "NIOverviewAllocationTracker.h"
 #import "NIOverviewView.h"
 #import "NIDeviceInfo.h"
 #import "NIOverviewGraphView.h"
+#import "NIOverviewLayerInspector.h"
 #import "NIOverviewLogger.h"
+#import "NIOverviewProfiler.h"
+#import "NIOverviewWatchdog.h"
 #import "NimbusCore.h"
 #import <QuartzCore/QuartzCore.h>
 
@@ -33,10 +37,32 @@
 static UIEdgeInsets kPagePadding;
 static const CGFloat kGraphRightMargin = 5;
 
+// Graph x values are measured from a fixed point in time so that points already rendered by a
+// graph view keep their x values as old samples are pruned.
+static CFTimeInterval NIOverviewGraphEpoch(void) {
+  static CFTimeInterval sEpoch = 0;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sEpoch = CACurrentMediaTime();
+  });
+  return sEpoch;
+}
+
+static CGFloat NIMegabytesFromBytes(unsigned long long bytes) {
+  return (CGFloat)((double)bytes / 1024.0 / 1024.0);
+}
+
 @interface NSObject ()
 - (id)initWithMemoryCache:(NIMemoryCache *)memoryCache;
 @end
 
+@interface NIOverviewGraphPageView ()
+// The monotonic timestamp that graph x values are measured from.
+- (CFTimeInterval)initialTimestamp;
+// The index of the first device sample plotted after the given x value.
+- (NSUInteger)indexOfFirstDeviceSampleAfterXValue:(CGFloat)xValue;
+@end
+
 
 @implementation NIOverviewPageView
 
@@ -155,20 +181,31 @@ static const CGFloat kGraphRightMargin = 5;
 }
 
 - (void)update {
-  [_graphView setNeedsDisplay];
+  [_graphView reloadData];
 }
 
 #pragma mark - NIOverviewGraphViewDataSource
 
 
 - (CGFloat)graphViewXRange:(NIOverviewGraphView *)graphView {
-  NSMutableOrderedSet* deviceLogs = [[NIOverview logger] deviceLogs];
-  NIOverviewLogEntry* firstEntry = [deviceLogs firstObject];
-  NIOverviewLogEntry* lastEntry = [deviceLogs lastObject];
-  NSTimeInterval interval = [lastEntry.timestamp timeIntervalSinceDate:firstEntry.timestamp];
+  NIOverviewLogger* logger = [NIOverview logger];
+  NSUInteger numberOfSamples = [logger numberOfDeviceSamples];
+  if (numberOfSamples == 0) {
+    return 0;
+  }
+  CFTimeInterval interval = ([logger deviceSampleAtIndex:numberOfSamples - 1].timestamp
+                             - [logger deviceSampleAtIndex:0].timestamp);
   return (CGFloat)interval;
 }
 
+- (CGFloat)graphViewMinimumXValue:(NIOverviewGraphView *)graphView {
+  NIOverviewLogger* logger = [NIOverview logger];
+  if ([logger numberOfDeviceSamples] == 0) {
+    return 0;
+  }
+  return (CGFloat)([logger deviceSampleAtIndex:0].timestamp - [self initialTimestamp]);
+}
+
 - (CGFloat)graphViewYRange:(NIOverviewGraphView *)graphView {
   return 0;
 }
@@ -176,17 +213,28 @@ static const CGFloat kGraphRightMargin = 5;
 - (void)resetPointIterator {
 }
 
+- (NSUInteger)indexOfFirstDeviceSampleAfterXValue:(CGFloat)xValue {
+  // New samples are appended, so walking back from the end only visits the unrendered ones.
+  NIOverviewLogger* logger = [NIOverview logger];
+  CFTimeInterval timestamp = [self initialTimestamp] + xValue;
+  NSUInteger index = [logger numberOfDeviceSamples];
+  while (index > 0 && [logger deviceSampleAtIndex:index - 1].timestamp > timestamp) {
+    index--;
+  }
+  return index;
+}
+
 - (BOOL)nextPointInGraphView: (NIOverviewGraphView *)graphView
                        point: (CGPoint *)point {
   return NO;
 }
 
-- (NSDate *)initialTimestamp {
-  return nil;
+- (CFTimeInterval)initialTimestamp {
+  return NIOverviewGraphEpoch();
 }
 
 - (void)resetEventIterator {
-  _eventEnumerator = [[[NIOverview logger] eventLogs] objectEnumerator];
+  _eventIndex = 0;
 }
 
 - (BOOL)nextEventInGraphView: (NIOverviewGraphView *)graphView
@@ -196,15 +244,18 @@ static const CGFloat kGraphRightMargin = 5;
   if (nil == sEventColors) {
     sEventColors = [NSArray arrayWithObjects:
                      [UIColor redColor], // NIOverviewEventDidReceiveMemoryWarning
+                     [UIColor yellowColor], // NIOverviewEventHitch
+                     [UIColor orangeColor], // NIOverviewEventStall
                      nil];
   }
-  NIOverviewEventLogEntry* entry = [_eventEnumerator nextObject];
-  if (nil != entry) {
-    NSTimeInterval interval = [entry.timestamp timeIntervalSinceDate:[self initialTimestamp]];
-    *xValue = (CGFloat)interval;
-    *color = [sEventColors objectAtIndex:entry.type];
+  NIOverviewLogger* logger = [NIOverview logger];
+  if (_eventIndex >= [logger numberOfEventSamples]) {
+    return NO;
   }
-  return nil != entry;
+  NIOverviewEventSample sample = [logger eventSampleAtIndex:_eventIndex++];
+  *xValue = (CGFloat)(sample.timestamp - [self initialTimestamp]);
+  *color = [sEventColors objectAtIndex:sample.type];
+  return YES;
 }
 
 @end
@@ -230,15 +281,14 @@ static const CGFloat kGraphRightMargin = 5;
 - (void)update {
   [super update];
 
-  [NIDeviceInfo beginCachedDeviceInfo];
-
-  self.label1.text = [NSString stringWithFormat:@"%@ free",
-                      NIStringFromBytes([NIDeviceInfo bytesOfFreeMemory])];
-
-  self.label2.text = [NSString stringWithFormat:@"%@ total",
-                      NIStringFromBytes([NIDeviceInfo bytesOfTotalMemory])];
-
-  [NIDeviceInfo endCachedDeviceInfo];
+  // Show the heartbeat's latest sample rather than querying the device on the main thread.
+  NIOverviewLogger* logger = [NIOverview logger];
+  NSUInteger numberOfSamples = [logger numberOfDeviceSamples];
+  if (numberOfSamples > 0) {
+    NIOverviewDeviceSample sample = [logger deviceSampleAtIndex:numberOfSamples - 1];
+    self.label1.text = [NSString stringWithFormat:@"%@ free", NIStringFromBytes(sample.bytesOfFreeMemory)];
+    self.label2.text = [NSString stringWithFormat:@"%@ total", NIStringFromBytes(sample.bytesOfTotalMemory)];
+  }
 
   [self setNeedsLayout];
 }
@@ -252,42 +302,46 @@ static const CGFloat kGraphRightMargin = 5;
 
 
 - (CGFloat)graphViewYRange:(NIOverviewGraphView *)graphView {
-  NSMutableOrderedSet* deviceLogs = [[NIOverview logger] deviceLogs];
-  if ([deviceLogs count] == 0) {
+  NIOverviewLogger* logger = [NIOverview logger];
+  NSUInteger numberOfSamples = [logger numberOfDeviceSamples];
+  if (numberOfSamples == 0) {
     return 0;
   }
 
   unsigned long long minY = (unsigned long long)-1;
   unsigned long long maxY = 0;
-  for (NIOverviewDeviceLogEntry* entry in deviceLogs) {
-    minY = MIN(entry.bytesOfFreeMemory, minY);
-    maxY = MAX(entry.bytesOfFreeMemory, maxY);
+  for (NSUInteger ix = 0; ix < numberOfSamples; ++ix) {
+    NIOverviewDeviceSample sample = [logger deviceSampleAtIndex:ix];
+    minY = MIN(sample.bytesOfFreeMemory, minY);
+    maxY = MAX(sample.bytesOfFreeMemory, maxY);
   }
   unsigned long long range = maxY - minY;
   _minMemory = minY;
-  return (CGFloat)((double)range / 1024.0 / 1024.0);
+  return NIMegabytesFromBytes(range);
+}
+
+- (CGFloat)graphViewMinimumYValue:(NIOverviewGraphView *)graphView {
+  return NIMegabytesFromBytes(_minMemory);
 }
 
 - (void)resetPointIterator {
-  _enumerator = [[[NIOverview logger] deviceLogs] objectEnumerator];
+  _pointIndex = 0;
 }
 
-- (NSDate *)initialTimestamp {
-  NSMutableOrderedSet* deviceLogs = [[NIOverview logger] deviceLogs];
-  NIOverviewLogEntry* firstEntry = [deviceLogs firstObject];
-  return firstEntry.timestamp;
+- (void)resetPointIteratorAfterXValue:(CGFloat)xValue {
+  _pointIndex = [self indexOfFirstDeviceSampleAfterXValue:xValue];
 }
 
 - (BOOL)nextPointInGraphView: (NIOverviewGraphView *)graphView
                        point: (CGPoint *)point {
-  NIOverviewDeviceLogEntry* entry = [_enumerator nextObject];
-  if (nil != entry) {
-    NSTimeInterval interval = [entry.timestamp timeIntervalSinceDate:[self initialTimestamp]];
-    *point = CGPointMake((CGFloat)interval,
-                         (CGFloat)(((double)(entry.bytesOfFreeMemory - _minMemory))
-                                   / 1024.0 / 1024.0));
+  NIOverviewLogger* logger = [NIOverview logger];
+  if (_pointIndex >= [logger numberOfDeviceSamples]) {
+    return NO;
   }
-  return nil != entry;
+  NIOverviewDeviceSample sample = [logger deviceSampleAtIndex:_pointIndex++];
+  CFTimeInterval interval = sample.timestamp - [self initialTimestamp];
+  *point = CGPointMake((CGFloat)interval, NIMegabytesFromBytes(sample.bytesOfFreeMemory));
+  return YES;
 }
 
 @end
@@ -305,19 +359,113 @@ static const CGFloat kGraphRightMargin = 5;
   return self;
 }
 
+- (void)update {
+  [super update];
+
+  NIOverviewLogger* logger = [NIOverview logger];
+  NSUInteger numberOfSamples = [logger numberOfDeviceSamples];
+  if (numberOfSamples > 0) {
+    NIOverviewDeviceSample sample = [logger deviceSampleAtIndex:numberOfSamples - 1];
+    self.label1.text = [NSString stringWithFormat:@"%@ free", NIStringFromBytes(sample.bytesOfFreeDiskSpace)];
+    self.label2.text = [NSString stringWithFormat:@"%@ total", NIStringFromBytes(sample.bytesOfTotalDiskSpace)];
+  }
+
+  [self setNeedsLayout];
+}
+
+#pragma mark - NIOverviewGraphViewDataSource
+
+
+- (CGFloat)graphViewYRange:(NIOverviewGraphView *)graphView {
+  NIOverviewLogger* logger = [NIOverview logger];
+  NSUInteger numberOfSamples = [logger numberOfDeviceSamples];
+  if (numberOfSamples == 0) {
+    return 0;
+  }
+
+  unsigned long long minY = (unsigned long long)-1;
+  unsigned long long maxY = 0;
+  for (NSUInteger ix = 0; ix < numberOfSamples; ++ix) {
+    NIOverviewDeviceSample sample = [logger deviceSampleAtIndex:ix];
+    minY = MIN(sample.bytesOfFreeDiskSpace, minY);
+    maxY = MAX(sample.bytesOfFreeDiskSpace, maxY);
+  }
+  unsigned long long range = maxY - minY;
+  _minDiskUse = minY;
+  return NIMegabytesFromBytes(range);
+}
+
+- (CGFloat)graphViewMinimumYValue:(NIOverviewGraphView *)graphView {
+  return NIMegabytesFromBytes(_minDiskUse);
+}
+
+- (void)resetPointIterator {
+  _pointIndex = 0;
+}
+
+- (void)resetPointIteratorAfterXValue:(CGFloat)xValue {
+  _pointIndex = [self indexOfFirstDeviceSampleAfterXValue:xValue];
+}
+
+- (BOOL)nextPointInGraphView: (NIOverviewGraphView *)graphView
+                       point: (CGPoint *)point {
+  NIOverviewLogger* logger = [NIOverview logger];
+  if (_pointIndex >= [logger numberOfDeviceSamples]) {
+    return NO;
+  }
+  NIOverviewDeviceSample sample = [logger deviceSampleAtIndex:_pointIndex++];
+  CFTimeInterval interval = sample.timestamp - [self initialTimestamp];
+  *point = CGPointMake((CGFloat)interval, NIMegabytesFromBytes(sample.bytesOfFreeDiskSpace));
+  return YES;
+}
+
+@end
+
+
+@implementation NIOverviewCPUPageView
+
+
+- (id)initWithFrame:(CGRect)frame {
+  if ((self = [super initWithFrame:frame])) {
+    self.pageTitle = NSLocalizedString(@"CPU", @"Overview Page Title: CPU");
+
+    self.graphView.dataSource = self;
+  }
+  return self;
+}
+
 - (void)update {
   [super update];
 
   [NIDeviceInfo beginCachedDeviceInfo];
 
-  self.label1.text = [NSString stringWithFormat:@"%@ free",
-                      NIStringFromBytes([NIDeviceInfo bytesOfFreeDiskSpace])];
+  self.label1.text = [NSString stringWithFormat:@"%.0f%% cpu",
+                      [NIDeviceInfo processCPUUsage] * 100];
 
-  self.label2.text = [NSString stringWithFormat:@"%@ total",
-                      NIStringFromBytes([NIDeviceInfo bytesOfTotalDiskSpace])];
+  NIThreadCPUUsage busiestThread;
+  memset(&busiestThread, 0, sizeof(busiestThread));
+  NSUInteger numberOfThreads = [NIDeviceInfo numberOfThreads];
+  for (NSUInteger ix = 0; ix < numberOfThreads; ++ix) {
+    NIThreadCPUUsage thread = [NIDeviceInfo CPUUsageOfThreadAtIndex:ix];
+    if (thread.CPUUsage > busiestThread.CPUUsage) {
+      busiestThread = thread;
+    }
+  }
 
   [NIDeviceInfo endCachedDeviceInfo];
 
+  if (busiestThread.CPUUsage > 0) {
+    NSString* name = (('\0' != busiestThread.name[0])
+                      ? [NSString stringWithUTF8String:busiestThread.name] : nil);
+    if (nil == name) {
+      name = [NSString stringWithFormat:@"thread %llu", busiestThread.threadID];
+    }
+    self.label2.text = [NSString stringWithFormat:@"%@ %.0f%%",
+                        name, busiestThread.CPUUsage * 100];
+  } else {
+    self.label2.text = [NSString stringWithFormat:@"%zd threads", numberOfThreads];
+  }
+
   [self setNeedsLayout];
 }
 
@@ -325,42 +473,474 @@ static const CGFloat kGraphRightMargin = 5;
 
 
 - (CGFloat)graphViewYRange:(NIOverviewGraphView *)graphView {
-  NSMutableOrderedSet* deviceLogs = [[NIOverview logger] deviceLogs];
-  if ([deviceLogs count] == 0) {
+  NIOverviewLogger* logger = [NIOverview logger];
+  NSUInteger numberOfSamples = [logger numberOfDeviceSamples];
+  if (numberOfSamples == 0) {
     return 0;
   }
 
-  unsigned long long minY = (unsigned long long)-1;
-  unsigned long long maxY = 0;
-  for (NIOverviewDeviceLogEntry* entry in deviceLogs) {
-    minY = MIN(entry.bytesOfFreeDiskSpace, minY);
-    maxY = MAX(entry.bytesOfFreeDiskSpace, maxY);
+  // Always show at least one full core so that an idle app reads as a flat line.
+  CGFloat maxY = 1;
+  for (NSUInteger ix = 0; ix < numberOfSamples; ++ix) {
+    maxY = MAX([logger deviceSampleAtIndex:ix].processCPUUsage, maxY);
   }
-  unsigned long long range = maxY - minY;
-  _minDiskUse = minY;
-  return (CGFloat)((double)range / 1024.0 / 1024.0);
+  return maxY;
+}
+
+- (void)resetPointIterator {
+  _pointIndex = 0;
+}
+
+- (void)resetPointIteratorAfterXValue:(CGFloat)xValue {
+  _pointIndex = [self indexOfFirstDeviceSampleAfterXValue:xValue];
+}
+
+- (BOOL)nextPointInGraphView: (NIOverviewGraphView *)graphView
+                       point: (CGPoint *)point {
+  NIOverviewLogger* logger = [NIOverview logger];
+  if (_pointIndex >= [logger numberOfDeviceSamples]) {
+    return NO;
+  }
+  NIOverviewDeviceSample sample = [logger deviceSampleAtIndex:_pointIndex++];
+  *point = CGPointMake((CGFloat)(sample.timestamp - [self initialTimestamp]),
+                       sample.processCPUUsage);
+  return YES;
+}
+
+@end
+
+
+@implementation NIOverviewFrameRatePageView {
+  CADisplayLink* _displayLink;
+  CFTimeInterval _lastFrameTimestamp;
+  CFTimeInterval _frameInterval;
+
+  NSUInteger _pointIndex;
+}
+
+
+- (void)dealloc {
+  [_displayLink invalidate];
+}
+
+- (id)initWithFrame:(CGRect)frame {
+  if ((self = [super initWithFrame:frame])) {
+    self.pageTitle = NSLocalizedString(@"Frame Rate", @"Overview Page Title: Frame Rate");
+
+    _hitchThreshold = 0.05;
+    _frameInterval = 1.0 / 60.0;
+
+    self.graphView.dataSource = self;
+  }
+  return self;
+}
+
+- (void)didMoveToWindow {
+  [super didMoveToWindow];
+
+  // The display link retains its target, so it only runs while the page is on screen.
+  if (nil != self.window && nil == _displayLink) {
+    _lastFrameTimestamp = 0;
+    _displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(displayLinkDidFire:)];
+    [_displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+
+  } else if (nil == self.window) {
+    [_displayLink invalidate];
+    _displayLink = nil;
+  }
+}
+
+- (void)displayLinkDidFire:(CADisplayLink *)displayLink {
+  CFTimeInterval timestamp = displayLink.timestamp;
+  if (displayLink.duration > 0) {
+    _frameInterval = displayLink.duration;
+  }
+
+  if (_lastFrameTimestamp > 0) {
+    NIOverviewFrameSample sample = { timestamp, timestamp - _lastFrameTimestamp };
+    [[NIOverview logger] addFrameSample:sample];
+
+    if (sample.duration > self.hitchThreshold) {
+      NIOverviewEventSample event = { timestamp, NIOverviewEventHitch };
+      [[NIOverview logger] addEventSample:event];
+    }
+  }
+  _lastFrameTimestamp = timestamp;
+}
+
+- (NSInteger)numberOfDroppedFramesForSample:(NIOverviewFrameSample)sample {
+  return MAX(0, lround(sample.duration / _frameInterval) - 1);
+}
+
+- (void)update {
+  [super update];
+
+  NIOverviewLogger* logger = [NIOverview logger];
+  NSUInteger numberOfFrameSamples = [logger numberOfFrameSamples];
+  CFTimeInterval lastSecond = _lastFrameTimestamp - 1;
+  NSUInteger framesInLastSecond = 0;
+  NSInteger numberOfDroppedFrames = 0;
+  for (NSUInteger ix = 0; ix < numberOfFrameSamples; ++ix) {
+    NIOverviewFrameSample sample = [logger frameSampleAtIndex:ix];
+    if (sample.timestamp > lastSecond) {
+      framesInLastSecond++;
+    }
+    numberOfDroppedFrames += [self numberOfDroppedFramesForSample:sample];
+  }
+
+  self.label1.text = [NSString stringWithFormat:@"%zd fps", framesInLastSecond];
+  self.label2.text = [NSString stringWithFormat:@"%zd dropped", numberOfDroppedFrames];
+
+  [self setNeedsLayout];
+}
+
+#pragma mark - NIOverviewGraphViewDataSource
+
+
+- (CGFloat)graphViewYRange:(NIOverviewGraphView *)graphView {
+  if ([[NIOverview logger] numberOfFrameSamples] == 0) {
+    return 0;
+  }
+  return (CGFloat)(1.0 / _frameInterval);
+}
+
+- (void)resetPointIterator {
+  _pointIndex = 0;
+}
+
+- (void)resetPointIteratorAfterXValue:(CGFloat)xValue {
+  NIOverviewLogger* logger = [NIOverview logger];
+  CFTimeInterval timestamp = [self initialTimestamp] + xValue;
+  _pointIndex = [logger numberOfFrameSamples];
+  while (_pointIndex > 0 && [logger frameSampleAtIndex:_pointIndex - 1].timestamp > timestamp) {
+    _pointIndex--;
+  }
+}
+
+- (BOOL)nextPointInGraphView: (NIOverviewGraphView *)graphView
+                       point: (CGPoint *)point {
+  NIOverviewLogger* logger = [NIOverview logger];
+  if (_pointIndex >= [logger numberOfFrameSamples]) {
+    return NO;
+  }
+  NIOverviewFrameSample sample = [logger frameSampleAtIndex:_pointIndex++];
+  double framesPerSecond = MIN(1.0 / sample.duration, 1.0 / _frameInterval);
+  *point = CGPointMake((CGFloat)(sample.timestamp - [self initialTimestamp]),
+                       (CGFloat)framesPerSecond);
+  return YES;
+}
+
+@end
+
+
+@interface NIOverviewNetworkEntry : NSObject
+@property (nonatomic, assign) CFTimeInterval timestamp;
+@property (nonatomic, assign) double bytesPerSecond;
+@property (nonatomic, assign) NSInteger numberOfActiveTasks;
+@end
+@implementation NIOverviewNetworkEntry
+@end
+
+
+// The most task metrics that NINetworkActivity keeps.
+static const NSUInteger kMaximumNumberOfNetworkTasks = 256;
+
+static CFTimeInterval NIOverviewPercentile(NSArray* sortedValues, double percentile) {
+  NSUInteger index = (NSUInteger)(percentile * (sortedValues.count - 1) + 0.5);
+  return [[sortedValues objectAtIndex:index] doubleValue];
+}
+
+@implementation NIOverviewNetworkPageView {
+  NIRingBuffer* _history;
+  NSUInteger _pointIndex;
+  CFTimeInterval _lastUpdateTimestamp;
+  BOOL _showsActiveTasks;
+}
+
+
+- (id)initWithFrame:(CGRect)frame {
+  if ((self = [super initWithFrame:frame])) {
+    self.pageTitle = NSLocalizedString(@"Network", @"Overview Page Title: Network");
+
+    // Updates are driven by the device log heartbeat, so this matches its capacity.
+    _history = [[NIRingBuffer alloc] initWithCapacity:1024];
+    self.graphView.dataSource = self;
+
+    UITapGestureRecognizer* tap = [[UITapGestureRecognizer alloc] initWithTarget:self action:@selector(didTap:)];
+    // We still want to be able to drag the pages.
+    tap.cancelsTouchesInView = NO;
+    [self addGestureRecognizer:tap];
+  }
+  return self;
+}
+
+- (void)didTap:(UIGestureRecognizer *)gesture {
+  _showsActiveTasks = !_showsActiveTasks;
+  [self update];
+}
+
+- (void)updateLatencyLabelWithMetrics:(NINetworkTaskMetrics *)metrics count:(NSUInteger)count {
+  NSCountedSet* hosts = [[NSCountedSet alloc] init];
+  for (NSUInteger ix = 0; ix < count; ++ix) {
+    [hosts addObject:[NSString stringWithUTF8String:metrics[ix].host]];
+  }
+  NSString* busiestHost = nil;
+  for (NSString* host in hosts) {
+    if (nil == busiestHost || [hosts countForObject:host] > [hosts countForObject:busiestHost]) {
+      busiestHost = host;
+    }
+  }
+
+  NSMutableArray* latencies = [NSMutableArray array];
+  for (NSUInteger ix = 0; ix < count; ++ix) {
+    if (metrics[ix].timeToFirstByte >= 0
+        && 0 == strcmp(metrics[ix].host, [busiestHost UTF8String])) {
+      [latencies addObject:@(metrics[ix].timeToFirstByte)];
+    }
+  }
+  if (latencies.count == 0) {
+    self.label2.text = nil;
+    return;
+  }
+  [latencies sortUsingSelector:@selector(compare:)];
+  self.label2.text = [NSString stringWithFormat:@"%@ %.0f|%.0f ms",
+                      busiestHost,
+                      NIOverviewPercentile(latencies, 0.5) * 1000,
+                      NIOverviewPercentile(latencies, 0.95) * 1000];
+}
+
+- (void)update {
+  CFTimeInterval now = CACurrentMediaTime();
+  NINetworkTaskMetrics* metrics = malloc(sizeof(NINetworkTaskMetrics) * kMaximumNumberOfNetworkTasks);
+  NSUInteger count = NINetworkTaskMetricsCopyRecent(metrics, kMaximumNumberOfNetworkTasks);
+
+  if (_lastUpdateTimestamp > 0 && now > _lastUpdateTimestamp) {
+    unsigned long long numberOfBytes = 0;
+    for (NSUInteger ix = 0; ix < count; ++ix) {
+      CFTimeInterval finishTimestamp = metrics[ix].startTimestamp + metrics[ix].duration;
+      if (finishTimestamp > _lastUpdateTimestamp && finishTimestamp <= now) {
+        numberOfBytes += metrics[ix].numberOfBytes;
+      }
+    }
+
+    NIOverviewNetworkEntry* entry = [[NIOverviewNetworkEntry alloc] init];
+    entry.timestamp = now;
+    entry.bytesPerSecond = (double)numberOfBytes / (now - _lastUpdateTimestamp);
+    entry.numberOfActiveTasks = NINetworkTaskMetricsNumberOfActiveTasks();
+    [_history addObject:entry];
+
+    CFTimeInterval cutoff = now - [NIOverview logger].oldestLogAge;
+    while ([(NIOverviewNetworkEntry *)_history.firstObject timestamp] < cutoff) {
+      [_history removeFirstObject];
+    }
+  }
+  _lastUpdateTimestamp = now;
+
+  NIOverviewNetworkEntry* lastEntry = _history.lastObject;
+  if (_showsActiveTasks) {
+    self.label1.text = [NSString stringWithFormat:@"%zd active",
+                        NINetworkTaskMetricsNumberOfActiveTasks()];
+  } else {
+    self.label1.text = [NSString stringWithFormat:@"%@/s",
+                        NIStringFromBytes((unsigned long long)lastEntry.bytesPerSecond)];
+  }
+  [self updateLatencyLabelWithMetrics:metrics count:count];
+  free(metrics);
+
+  [super update];
+
+  [self setNeedsLayout];
+}
+
+- (CGFloat)valueOfEntry:(NIOverviewNetworkEntry *)entry {
+  return (_showsActiveTasks
+          ? (CGFloat)entry.numberOfActiveTasks
+          : (CGFloat)(entry.bytesPerSecond / 1024.0));
+}
+
+#pragma mark - NIOverviewGraphViewDataSource
+
+
+- (CGFloat)graphViewYRange:(NIOverviewGraphView *)graphView {
+  if (0 == _history.count) {
+    return 0;
+  }
+  // An idle network reads as a flat line rather than a noisy one.
+  CGFloat maxY = 1;
+  for (NIOverviewNetworkEntry* entry in _history) {
+    maxY = MAX([self valueOfEntry:entry], maxY);
+  }
+  return maxY;
 }
 
 - (void)resetPointIterator {
-  _enumerator = [[[NIOverview logger] deviceLogs] objectEnumerator];
+  _pointIndex = 0;
 }
 
-- (NSDate *)initialTimestamp {
-  NSMutableOrderedSet* deviceLogs = [[NIOverview logger] deviceLogs];
-  NIOverviewLogEntry* firstEntry = [deviceLogs firstObject];
-  return firstEntry.timestamp;
+- (void)resetPointIteratorAfterXValue:(CGFloat)xValue {
+  CFTimeInterval timestamp = [self initialTimestamp] + xValue;
+  _pointIndex = _history.count;
+  while (_pointIndex > 0
+         && [(NIOverviewNetworkEntry *)[_history objectAtIndex:_pointIndex - 1] timestamp]
+            > timestamp) {
+    _pointIndex--;
+  }
 }
 
 - (BOOL)nextPointInGraphView: (NIOverviewGraphView *)graphView
                        point: (CGPoint *)point {
-  NIOverviewDeviceLogEntry* entry = [_enumerator nextObject];
-  if (nil != entry) {
-    NSTimeInterval interval = [entry.timestamp timeIntervalSinceDate:[self initialTimestamp]];
-    double difference = ((double)entry.bytesOfFreeDiskSpace / 1024.0 / 1024.0
-                         - (double)_minDiskUse / 1024.0 / 1024.0);
-    *point = CGPointMake((CGFloat)interval, (CGFloat)difference);
+  if (_pointIndex >= _history.count) {
+    return NO;
   }
-  return nil != entry;
+  NIOverviewNetworkEntry* entry = [_history objectAtIndex:_pointIndex++];
+  *point = CGPointMake((CGFloat)(entry.timestamp - [self initialTimestamp]),
+                       [self valueOfEntry:entry]);
+  return YES;
+}
+
+@end
+
+
+@interface NIOverviewAllocationEntry : NSObject
+@property (nonatomic, assign) CFTimeInterval timestamp;
+@property (nonatomic, assign) unsigned long long numberOfMallocBytesInUse;
+// The live instance counts of the tracked classes, in the tracker's order.
+@property (nonatomic, copy) NSArray* numbersOfLiveInstances;
+@end
+@implementation NIOverviewAllocationEntry
+@end
+
+
+@implementation NIOverviewAllocationPageView {
+  NIRingBuffer* _history;
+  NSUInteger _pointIndex;
+  // 0 graphs malloc usage and n graphs the (n - 1)th tracked class.
+  NSUInteger _seriesIndex;
+  CGFloat _minValue;
+}
+
+
++ (id)pageWithTrackedClasses:(NSArray *)classes {
+  for (Class cls in classes) {
+    [[NIOverviewAllocationTracker sharedTracker] trackClass:cls];
+  }
+  return [self page];
+}
+
+- (id)initWithFrame:(CGRect)frame {
+  if ((self = [super initWithFrame:frame])) {
+    self.pageTitle = NSLocalizedString(@"Allocations", @"Overview Page Title: Allocations");
+
+    // Updates are driven by the device log heartbeat, so this matches its capacity.
+    _history = [[NIRingBuffer alloc] initWithCapacity:1024];
+    self.graphView.dataSource = self;
+
+    UITapGestureRecognizer* tap = [[UITapGestureRecognizer alloc] initWithTarget:self action:@selector(didTap:)];
+    // We still want to be able to drag the pages.
+    tap.cancelsTouchesInView = NO;
+    [self addGestureRecognizer:tap];
+  }
+  return self;
+}
+
+- (void)didTap:(UIGestureRecognizer *)gesture {
+  NSUInteger numberOfSeries = [NIOverviewAllocationTracker sharedTracker].trackedClasses.count + 1;
+  _seriesIndex = (_seriesIndex + 1) % numberOfSeries;
+  [self update];
+}
+
+- (void)update {
+  NIOverviewAllocationTracker* tracker = [NIOverviewAllocationTracker sharedTracker];
+  NSArray* trackedClasses = tracker.trackedClasses;
+
+  NIOverviewAllocationEntry* entry = [[NIOverviewAllocationEntry alloc] init];
+  entry.timestamp = CACurrentMediaTime();
+  entry.numberOfMallocBytesInUse = [NIOverviewAllocationTracker numberOfMallocBytesInUse];
+  NSMutableArray* numbersOfLiveInstances = [NSMutableArray arrayWithCapacity:trackedClasses.count];
+  for (Class cls in trackedClasses) {
+    [numbersOfLiveInstances addObject:@([tracker numberOfLiveInstancesOfClass:cls])];
+  }
+  entry.numbersOfLiveInstances = numbersOfLiveInstances;
+  [_history addObject:entry];
+
+  CFTimeInterval cutoff = entry.timestamp - [NIOverview logger].oldestLogAge;
+  while ([(NIOverviewAllocationEntry *)_history.firstObject timestamp] < cutoff) {
+    [_history removeFirstObject];
+  }
+
+  if (0 == _seriesIndex) {
+    self.label1.text = [NSString stringWithFormat:@"%@ malloc",
+                        NIStringFromBytes(entry.numberOfMallocBytesInUse)];
+    self.label2.text = [NSString stringWithFormat:@"%llu blocks",
+                        [NIOverviewAllocationTracker numberOfMallocBlocksInUse]];
+  } else {
+    Class cls = [trackedClasses objectAtIndex:_seriesIndex - 1];
+    self.label1.text = [NSString stringWithFormat:@"%@ %@", NSStringFromClass(cls),
+                        [numbersOfLiveInstances objectAtIndex:_seriesIndex - 1]];
+    self.label2.text = [NSString stringWithFormat:@"%llu allocated",
+                        [tracker numberOfAllocationsOfClass:cls]];
+  }
+
+  [super update];
+
+  [self setNeedsLayout];
+}
+
+- (CGFloat)valueOfEntry:(NIOverviewAllocationEntry *)entry {
+  if (0 == _seriesIndex) {
+    return NIMegabytesFromBytes(entry.numberOfMallocBytesInUse);
+  }
+  // Classes tracked after the entry was sampled had no counted instances yet.
+  NSUInteger index = _seriesIndex - 1;
+  return ((index < entry.numbersOfLiveInstances.count)
+          ? [[entry.numbersOfLiveInstances objectAtIndex:index] floatValue] : 0);
+}
+
+#pragma mark - NIOverviewGraphViewDataSource
+
+
+- (CGFloat)graphViewYRange:(NIOverviewGraphView *)graphView {
+  if (0 == _history.count) {
+    return 0;
+  }
+  CGFloat minY = CGFLOAT_MAX;
+  CGFloat maxY = 0;
+  for (NIOverviewAllocationEntry* entry in _history) {
+    CGFloat value = [self valueOfEntry:entry];
+    minY = MIN(value, minY);
+    maxY = MAX(value, maxY);
+  }
+  _minValue = minY;
+  return maxY - minY;
+}
+
+- (CGFloat)graphViewMinimumYValue:(NIOverviewGraphView *)graphView {
+  return _minValue;
+}
+
+- (void)resetPointIterator {
+  _pointIndex = 0;
+}
+
+- (void)resetPointIteratorAfterXValue:(CGFloat)xValue {
+  CFTimeInterval timestamp = [self initialTimestamp] + xValue;
+  _pointIndex = _history.count;
+  while (_pointIndex > 0
+         && [(NIOverviewAllocationEntry *)[_history objectAtIndex:_pointIndex - 1] timestamp]
+            > timestamp) {
+    _pointIndex--;
+  }
+}
+
+- (BOOL)nextPointInGraphView: (NIOverviewGraphView *)graphView
+                       point: (CGPoint *)point {
+  if (_pointIndex >= _history.count) {
+    return NO;
+  }
+  NIOverviewAllocationEntry* entry = [_history objectAtIndex:_pointIndex++];
+  *point = CGPointMake((CGFloat)(entry.timestamp - [self initialTimestamp]),
+                       [self valueOfEntry:entry]);
+  return YES;
 }
 
 @end
@@ -464,8 +1044,38 @@ static const CGFloat kGraphRightMargin = 5;
   self.titleLabel.frame = labelFrame;
 }
 
+- (BOOL)isVisibleInOverview {
+  return (nil != self.window && !self.hidden
+          && CGRectIntersectsRect(self.superview.bounds, self.frame));
+}
+
+- (void)update {
+  [super update];
+
+  // Picks up logs that arrived while the page was scrolled out of view.
+  if (_needsLogUpdate && [self isVisibleInOverview]) {
+    [self appendNewLogs];
+  }
+}
+
+- (void)didMoveToWindow {
+  [super didMoveToWindow];
+
+  if (_needsLogUpdate && [self isVisibleInOverview]) {
+    [self appendNewLogs];
+  }
+}
+
 - (void)didAddLog:(NSNotification *)notification {
-  NIOverviewConsoleLogEntry* entry = [[notification userInfo] objectForKey:@"entry"];
+  // Logs are only formatted while someone can read them.
+  _needsLogUpdate = YES;
+  if ([self isVisibleInOverview]) {
+    [self appendNewLogs];
+  }
+}
+
+- (void)appendNewLogs {
+  _needsLogUpdate = NO;
 
   static NSDateFormatter* formatter = nil;
   if (nil == formatter) {
@@ -474,15 +1084,29 @@ static const CGFloat kGraphRightMargin = 5;
     [formatter setDateStyle:NSDateFormatterNoStyle];
   }
 
-  NSString* formattedLog = [NSString stringWithFormat:@"%@: %@",
-                            [formatter stringFromDate:entry.timestamp],
-                            entry.log];
+  NIOverviewLogger* logger = [NIOverview logger];
+  NSUInteger numberOfSamples = [logger numberOfConsoleSamples];
+  NSUInteger firstIndex = numberOfSamples;
+  while (firstIndex > 0
+         && [logger consoleSampleAtIndex:firstIndex - 1].timestamp > _lastLogTimestamp) {
+    --firstIndex;
+  }
+  if (firstIndex == numberOfSamples) {
+    return;
+  }
 
-  if (nil != _logLabel.text) {
-    _logLabel.text = [_logLabel.text stringByAppendingFormat:@"\n%@", formattedLog];
-  } else {
-    _logLabel.text = formattedLog;
+  NSMutableString* text = [NSMutableString stringWithString:_logLabel.text ?: @""];
+  CFTimeInterval dateOffset = -CACurrentMediaTime();
+  for (NSUInteger ix = firstIndex; ix < numberOfSamples; ++ix) {
+    NIOverviewConsoleSample sample = [logger consoleSampleAtIndex:ix];
+    NSDate* date = [NSDate dateWithTimeIntervalSinceNow:sample.timestamp + dateOffset];
+    if (text.length > 0) {
+      [text appendString:@"\n"];
+    }
+    [text appendFormat:@"%@: %@", [formatter stringFromDate:date], sample.log];
+    _lastLogTimestamp = sample.timestamp;
   }
+  _logLabel.text = text;
 
   [self contentSizeChanged];
 }
@@ -490,6 +1114,231 @@ static const CGFloat kGraphRightMargin = 5;
 @end
 
 
+@implementation NIOverviewStallPageView {
+  UITextView* _textView;
+}
+
+
+- (void)dealloc {
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (id)initWithFrame:(CGRect)frame {
+  if ((self = [super initWithFrame:frame])) {
+    self.pageTitle = NSLocalizedString(@"Stalls", @"Overview Page Title: Stalls");
+
+    UILabel* label = [self label];
+    _textView = [[UITextView alloc] initWithFrame:self.bounds];
+    _textView.autoresizingMask = UIViewAutoresizingFlexibleWidth | UIViewAutoresizingFlexibleHeight;
+    _textView.editable = NO;
+    _textView.font = label.font;
+    _textView.textColor = label.textColor;
+    _textView.backgroundColor = [UIColor colorWithWhite:1 alpha:0.2f];
+    [self addSubview:_textView];
+
+    [[NSNotificationCenter defaultCenter] addObserver: self
+                                             selector: @selector(didAddStall:)
+                                                 name: NIOverviewLoggerDidAddStallLog
+                                               object: nil];
+    [self updateText];
+  }
+  return self;
+}
+
+- (void)layoutSubviews {
+  [super layoutSubviews];
+
+  CGRect labelFrame = self.titleLabel.frame;
+  labelFrame.origin.x = (self.bounds.size.width
+                         - kPagePadding.right - self.titleLabel.frame.size.width);
+  labelFrame.origin.y = (self.bounds.size.height
+                         - kPagePadding.bottom - self.titleLabel.frame.size.height);
+  self.titleLabel.frame = labelFrame;
+  [self bringSubviewToFront:self.titleLabel];
+}
+
+- (void)updateText {
+  NIOverviewLogger* logger = [NIOverview logger];
+  NSUInteger numberOfStalls = [logger numberOfStallSamples];
+  if (0 == numberOfStalls) {
+    _textView.text = ([[NIOverviewWatchdog sharedWatchdog] isRunning]
+                      ? NSLocalizedString(@"No stalls", @"Overview: No stalls recorded")
+                      : NSLocalizedString(@"The watchdog is not running",
+                                          @"Overview: Stall watchdog not started"));
+    return;
+  }
+
+  static NSDateFormatter* formatter = nil;
+  if (nil == formatter) {
+    formatter = [[NSDateFormatter alloc] init];
+    [formatter setTimeStyle:NSDateFormatterMediumStyle];
+    [formatter setDateStyle:NSDateFormatterNoStyle];
+  }
+
+  // Sample timestamps are on the monotonic media clock.
+  CFTimeInterval now = CACurrentMediaTime();
+  NSMutableString* text = [NSMutableString string];
+  for (NSUInteger ix = numberOfStalls; ix > 0; --ix) {
+    NIOverviewStallSample sample = [logger stallSampleAtIndex:ix - 1];
+    NSDate* date = [NSDate dateWithTimeIntervalSinceNow:sample.timestamp - now];
+    [text appendFormat:@"%@: %.0f ms\n",
+     [formatter stringFromDate:date], sample.duration * 1000];
+    for (NSUInteger frameIndex = 0; frameIndex < sample.numberOfFrames; ++frameIndex) {
+      [text appendFormat:@"  %zd %@\n",
+       frameIndex, NIOverviewStringFromStackFrame(sample.frames[frameIndex])];
+    }
+  }
+  _textView.text = text;
+}
+
+- (void)didAddStall:(NSNotification *)notification {
+  [self updateText];
+}
+
+@end
+
+
+// Call paths with a smaller share of the samples than this are left out of the summary.
+static const CGFloat kMinimumCallTreeShare = 0.02f;
+static const NSUInteger kNumberOfTopFunctions = 15;
+
+@implementation NIOverviewProfilerPageView {
+  UIButton* _recordButton;
+  UITextView* _textView;
+  NIOverviewProfile* _summarizedProfile;
+}
+
+
+- (id)initWithFrame:(CGRect)frame {
+  if ((self = [super initWithFrame:frame])) {
+    self.pageTitle = NSLocalizedString(@"Profiler", @"Overview Page Title: Profiler");
+
+    _recordButton = [UIButton buttonWithType:UIButtonTypeRoundedRect];
+    [_recordButton addTarget:self
+                      action:@selector(didTapRecordButton:)
+            forControlEvents:UIControlEventTouchUpInside];
+    [self addSubview:_recordButton];
+
+    UILabel* label = [self label];
+    _textView = [[UITextView alloc] initWithFrame:self.bounds];
+    _textView.editable = NO;
+    _textView.font = label.font;
+    _textView.textColor = label.textColor;
+    _textView.backgroundColor = [UIColor colorWithWhite:1 alpha:0.2f];
+    [self addSubview:_textView];
+
+    [self updateText];
+  }
+  return self;
+}
+
+- (void)layoutSubviews {
+  [super layoutSubviews];
+
+  [_recordButton sizeToFit];
+  CGRect buttonFrame = _recordButton.frame;
+  buttonFrame.origin = CGPointMake(kPagePadding.left, kPagePadding.top);
+  _recordButton.frame = buttonFrame;
+
+  CGFloat textTop = CGRectGetMaxY(buttonFrame) + kPagePadding.top;
+  _textView.frame = CGRectMake(0, textTop,
+                               self.bounds.size.width, self.bounds.size.height - textTop);
+
+  CGRect labelFrame = self.titleLabel.frame;
+  labelFrame.origin.x = (self.bounds.size.width
+                         - kPagePadding.right - self.titleLabel.frame.size.width);
+  labelFrame.origin.y = (self.bounds.size.height
+                         - kPagePadding.bottom - self.titleLabel.frame.size.height);
+  self.titleLabel.frame = labelFrame;
+  [self bringSubviewToFront:self.titleLabel];
+}
+
+- (void)update {
+  [super update];
+
+  [self updateText];
+}
+
+- (void)appendCallTreeNode:(NIOverviewProfileNode *)node
+          numberOfSamples:(NSUInteger)numberOfSamples
+                    depth:(NSUInteger)depth
+                   toText:(NSMutableString *)text {
+  for (NIOverviewProfileNode* child in node.children) {
+    CGFloat share = (CGFloat)child.numberOfSamples / (CGFloat)numberOfSamples;
+    if (share < kMinimumCallTreeShare) {
+      // Children are sorted, so the rest are smaller still.
+      break;
+    }
+    [text appendFormat:@"%5.1f%% %@%@\n", share * 100,
+     [@"" stringByPaddingToLength:depth withString:@" " startingAtIndex:0], child.name];
+    [self appendCallTreeNode:child numberOfSamples:numberOfSamples depth:depth + 1 toText:text];
+  }
+}
+
+- (void)updateText {
+  NIOverviewProfiler* profiler = [NIOverviewProfiler sharedProfiler];
+  NIOverviewProfile* profile = profiler.profile;
+
+  [_recordButton setTitle:([profiler isRecording]
+                           ? NSLocalizedString(@"Stop", @"Overview: Stop profiling")
+                           : NSLocalizedString(@"Record", @"Overview: Start profiling"))
+                 forState:UIControlStateNormal];
+  [self setNeedsLayout];
+
+  if ([profiler isRecording]) {
+    _summarizedProfile = nil;
+    _textView.text = [NSString stringWithFormat:
+                      NSLocalizedString(@"Recording... %lu samples",
+                                        @"Overview: Profiler is recording"),
+                      (unsigned long)[profile numberOfSamples]];
+    return;
+  }
+  if (nil == profile || 0 == [profile numberOfSamples]) {
+    _textView.text = NSLocalizedString(@"Tap Record to sample the main thread",
+                                       @"Overview: No profile recorded");
+    return;
+  }
+  if (_summarizedProfile == profile) {
+    return;
+  }
+
+  // Summarizing resolves symbols, so do it once per recording rather than on every update.
+  _summarizedProfile = profile;
+  NSUInteger numberOfSamples = [profile numberOfSamples];
+  CFTimeInterval duration = ([profile timestampOfSampleAtIndex:numberOfSamples - 1]
+                             - [profile timestampOfSampleAtIndex:0]);
+  NSMutableString* text = [NSMutableString stringWithFormat:@"%lu samples over %.1f s\n\n",
+                           (unsigned long)numberOfSamples, duration];
+
+  [text appendString:NSLocalizedString(@"Top functions (self, total)\n",
+                                       @"Overview: Profiler top functions heading")];
+  NSArray* topFunctions = [profile topFunctionsWithLimit:kNumberOfTopFunctions];
+  for (NIOverviewProfileFunction* function in topFunctions) {
+    [text appendFormat:@"%5.1f%% %5.1f%% %@\n",
+     (CGFloat)function.numberOfSelfSamples * 100 / (CGFloat)numberOfSamples,
+     (CGFloat)function.numberOfTotalSamples * 100 / (CGFloat)numberOfSamples,
+     function.name];
+  }
+
+  [text appendString:NSLocalizedString(@"\nCall tree\n", @"Overview: Profiler call tree heading")];
+  [self appendCallTreeNode:[profile callTree] numberOfSamples:numberOfSamples depth:0
+                    toText:text];
+  _textView.text = text;
+}
+
+- (void)didTapRecordButton:(UIButton *)button {
+  NIOverviewProfiler* profiler = [NIOverviewProfiler sharedProfiler];
+  if ([profiler isRecording]) {
+    [profiler stopRecording];
+  } else {
+    [profiler startRecording];
+  }
+  [self updateText];
+}
+
+@end
+
+
 @implementation NIOverviewMaxLogLevelPageView
 
 
@@ -591,7 +1440,7 @@ static const CGFloat kGraphRightMargin = 5;
 
 
 @interface NIOverviewMemoryCacheEntry : NSObject
-@property (nonatomic, retain) NSDate* timestamp;
+@property (nonatomic, assign) CFTimeInterval timestamp;
 @property (nonatomic, assign) NSUInteger numberOfObjects;
 @end
 @implementation NIOverviewMemoryCacheEntry
@@ -609,8 +1458,8 @@ static const CGFloat kGraphRightMargin = 5;
 
 @interface NIOverviewMemoryCachePageView()
 @property (nonatomic) unsigned long long minValue;
-@property (nonatomic, strong) NSEnumerator* enumerator;
-@property (nonatomic, strong) NSMutableOrderedSet* history;
+@property (nonatomic) NSUInteger pointIndex;
+@property (nonatomic, strong) NIRingBuffer* history;
 @end
 
 
@@ -623,7 +1472,8 @@ static const CGFloat kGraphRightMargin = 5;
     self.pageTitle = NSLocalizedString(@"Memory Cache", @"Overview Page Title: Memory Cache");
     self.cache = [Nimbus imageMemoryCache];
 
-    self.history = [[NSMutableOrderedSet alloc] init];
+    // Updates are driven by the device log heartbeat, so this matches its capacity.
+    self.history = [[NIRingBuffer alloc] initWithCapacity:1024];
     self.graphView.dataSource = self;
 
     UITapGestureRecognizer* tap = [[UITapGestureRecognizer alloc] initWithTarget:self action:@selector(didTap:)];
@@ -667,13 +1517,15 @@ static const CGFloat kGraphRightMargin = 5;
     entry = [[NIOverviewMemoryCacheEntry alloc] init];
   }
 
-  entry.timestamp = [NSDate date];
+  // Stamped with the same monotonic clock as the logger's samples so that the graph's events
+  // line up with this history.
+  entry.timestamp = CACurrentMediaTime();
   entry.numberOfObjects = self.cache.count;
   [self.history addObject:entry];
 
-  NSDate* cutoffDate = [NSDate dateWithTimeIntervalSinceNow:-[NIOverview logger].oldestLogAge];
-  while ([[(NIOverviewMemoryCacheEntry *)self.history.firstObject timestamp] compare:cutoffDate] == NSOrderedAscending) {
-    [self.history removeObjectAtIndex:0];
+  CFTimeInterval cutoff = entry.timestamp - [NIOverview logger].oldestLogAge;
+  while ([(NIOverviewMemoryCacheEntry *)self.history.firstObject timestamp] < cutoff) {
+    [self.history removeFirstObject];
   }
 
   [self setNeedsLayout];
@@ -718,7 +1570,7 @@ static const CGFloat kGraphRightMargin = 5;
     }
     unsigned long long range = maxY - minY;
     self.minValue = minY;
-    return (CGFloat)((double)range / 1024.0 / 1024.0);
+    return NIMegabytesFromBytes(range);
 
   } else {
     // For regular memory caches we'll just show the count of objects.
@@ -732,33 +1584,222 @@ static const CGFloat kGraphRightMargin = 5;
   }
 }
 
+- (CGFloat)graphViewMinimumYValue:(NIOverviewGraphView *)graphView {
+  if ([self.cache isKindOfClass:[NIImageMemoryCache class]]) {
+    return NIMegabytesFromBytes(self.minValue);
+  }
+  return (CGFloat)self.minValue;
+}
+
 - (void)resetPointIterator {
-  _enumerator = [self.history objectEnumerator];
+  self.pointIndex = 0;
 }
 
-- (NSDate *)initialTimestamp {
-  NIOverviewMemoryCacheEntry* entry = self.history.firstObject;
-  return entry.timestamp;
+- (void)resetPointIteratorAfterXValue:(CGFloat)xValue {
+  CFTimeInterval timestamp = [self initialTimestamp] + xValue;
+  NSUInteger index = self.history.count;
+  while (index > 0
+         && [(NIOverviewMemoryCacheEntry *)[self.history objectAtIndex:index - 1] timestamp]
+            > timestamp) {
+    index--;
+  }
+  self.pointIndex = index;
 }
 
 - (BOOL)nextPointInGraphView: (NIOverviewGraphView *)graphView
                        point: (CGPoint *)point {
-  NIOverviewMemoryCacheEntry* entry = [_enumerator nextObject];
-  if (nil != entry) {
-    NSTimeInterval interval = [entry.timestamp timeIntervalSinceDate:[self initialTimestamp]];
+  if (self.pointIndex >= self.history.count) {
+    return NO;
+  }
+  NIOverviewMemoryCacheEntry* entry = [self.history objectAtIndex:self.pointIndex];
+  self.pointIndex++;
+  CFTimeInterval interval = entry.timestamp - [self initialTimestamp];
+
+  if ([self.cache isKindOfClass:[NIImageMemoryCache class]]) {
+    NIOverviewImageMemoryCacheEntry* imageEntry = (NIOverviewImageMemoryCacheEntry *)entry;
+    *point = CGPointMake((CGFloat)interval, NIMegabytesFromBytes(imageEntry.numberOfPixels));
+
+  } else {
+    *point = CGPointMake((CGFloat)interval, (CGFloat)entry.numberOfObjects);
+  }
+  return YES;
+}
 
-    if ([self.cache isKindOfClass:[NIImageMemoryCache class]]) {
-      NIOverviewImageMemoryCacheEntry* imageEntry = (NIOverviewImageMemoryCacheEntry *)entry;
-      *point = CGPointMake((CGFloat)interval,
-                           (CGFloat)(((double)(imageEntry.numberOfPixels - self.minValue))
-                                     / 1024.0 / 1024.0));
+@end
 
-    } else {
-      *point = CGPointMake((CGFloat)interval,
-                           (CGFloat)(entry.numberOfObjects - self.minValue));
+static UIColor* NIOverviewColorOfLayerIssueType(NIOverviewLayerIssueType type) {
+  switch (type) {
+    case NIOverviewLayerIssueOffscreenMask:
+      return [UIColor redColor];
+    case NIOverviewLayerIssueShadowWithoutPath:
+      return [UIColor orangeColor];
+    case NIOverviewLayerIssueBlending:
+      return [UIColor magentaColor];
+    case NIOverviewLayerIssueMisscaledImage:
+      return [UIColor yellowColor];
+    case NIOverviewLayerIssueRasterizationMiss:
+      return [UIColor cyanColor];
+  }
+  return [UIColor whiteColor];
+}
+
+// Outlines layer issues over the app without getting in the way of its touches.
+@interface NIOverviewLayerIssueOverlayView : UIView
+@property (nonatomic, copy) NSArray* issues;
+@end
+
+@implementation NIOverviewLayerIssueOverlayView
+
+- (id)initWithFrame:(CGRect)frame {
+  if ((self = [super initWithFrame:frame])) {
+    self.userInteractionEnabled = NO;
+    self.opaque = NO;
+    self.backgroundColor = [UIColor clearColor];
+  }
+  return self;
+}
+
+- (void)setIssues:(NSArray *)issues {
+  _issues = [issues copy];
+  [self setNeedsDisplay];
+}
+
+- (void)drawRect:(CGRect)rect {
+  CGContextRef cx = UIGraphicsGetCurrentContext();
+  CGContextSetLineWidth(cx, 2);
+  for (NIOverviewLayerIssue* issue in self.issues) {
+    UIColor* color = NIOverviewColorOfLayerIssueType(issue.type);
+    CGRect frame = CGRectInset(issue.frame, 1, 1);
+    CGContextSetFillColorWithColor(cx, [color colorWithAlphaComponent:0.15f].CGColor);
+    CGContextFillRect(cx, frame);
+    CGContextSetStrokeColorWithColor(cx, color.CGColor);
+    CGContextStrokeRect(cx, frame);
+  }
+}
+
+@end
+
+@implementation NIOverviewRenderingPageView {
+  UIButton* _inspectButton;
+  UITextView* _textView;
+  NIOverviewLayerIssueOverlayView* _overlayView;
+}
+
+
+- (void)dealloc {
+  [_overlayView removeFromSuperview];
+}
+
+- (id)initWithFrame:(CGRect)frame {
+  if ((self = [super initWithFrame:frame])) {
+    self.pageTitle = NSLocalizedString(@"Rendering", @"Overview Page Title: Rendering");
+
+    _inspectButton = [UIButton buttonWithType:UIButtonTypeRoundedRect];
+    [_inspectButton setTitle:NSLocalizedString(@"Inspect", @"Overview: Inspect layers")
+                    forState:UIControlStateNormal];
+    [_inspectButton addTarget:self
+                       action:@selector(didTapInspectButton:)
+             forControlEvents:UIControlEventTouchUpInside];
+    [self addSubview:_inspectButton];
+
+    UILabel* label = [self label];
+    _textView = [[UITextView alloc] initWithFrame:self.bounds];
+    _textView.editable = NO;
+    _textView.font = label.font;
+    _textView.textColor = label.textColor;
+    _textView.backgroundColor = [UIColor colorWithWhite:1 alpha:0.2f];
+    _textView.text =
+        NSLocalizedString(@"Tap Inspect to find layers that are expensive to composite",
+                          @"Overview: Layers not inspected");
+    [self addSubview:_textView];
+  }
+  return self;
+}
+
+- (void)layoutSubviews {
+  [super layoutSubviews];
+
+  [_inspectButton sizeToFit];
+  CGRect buttonFrame = _inspectButton.frame;
+  buttonFrame.origin = CGPointMake(kPagePadding.left, kPagePadding.top);
+  _inspectButton.frame = buttonFrame;
+
+  CGFloat textTop = CGRectGetMaxY(buttonFrame) + kPagePadding.top;
+  _textView.frame = CGRectMake(0, textTop,
+                               self.bounds.size.width, self.bounds.size.height - textTop);
+
+  CGRect labelFrame = self.titleLabel.frame;
+  labelFrame.origin.x = (self.bounds.size.width
+                         - kPagePadding.right - self.titleLabel.frame.size.width);
+  labelFrame.origin.y = (self.bounds.size.height
+                         - kPagePadding.bottom - self.titleLabel.frame.size.height);
+  self.titleLabel.frame = labelFrame;
+  [self bringSubviewToFront:self.titleLabel];
+}
+
+- (void)didTapInspectButton:(UIButton *)button {
+  if (nil != _overlayView) {
+    [_overlayView removeFromSuperview];
+    _overlayView = nil;
+    [_inspectButton setTitle:NSLocalizedString(@"Inspect", @"Overview: Inspect layers")
+                    forState:UIControlStateNormal];
+    [self setNeedsLayout];
+    return;
+  }
+
+  UIWindow* window = [UIApplication sharedApplication].keyWindow;
+  if (nil == window) {
+    return;
+  }
+
+  // Leave the Overview out of its own report.
+  UIView* overviewView = self.superview;
+  while (nil != overviewView && ![overviewView isKindOfClass:[NIOverviewView class]]) {
+    overviewView = overviewView.superview;
+  }
+  NSSet* excludedLayers = (nil != overviewView ? [NSSet setWithObject:overviewView.layer] : nil);
+  NSArray* issues = [NIOverviewLayerInspector issuesInLayerTree:window.layer
+                                                excludingLayers:excludedLayers];
+
+  _overlayView = [[NIOverviewLayerIssueOverlayView alloc] initWithFrame:window.bounds];
+  _overlayView.autoresizingMask = UIViewAutoresizingFlexibleDimensions;
+  _overlayView.issues = issues;
+  [window addSubview:_overlayView];
+  if (nil != overviewView && overviewView.window == window) {
+    [window bringSubviewToFront:overviewView];
+  }
+
+  [_inspectButton setTitle:NSLocalizedString(@"Clear", @"Overview: Clear layer inspection")
+                  forState:UIControlStateNormal];
+  [self setNeedsLayout];
+  [self updateTextWithIssues:issues];
+}
+
+- (void)updateTextWithIssues:(NSArray *)issues {
+  if (0 == issues.count) {
+    _textView.text = NSLocalizedString(@"No issues found", @"Overview: No layer issues");
+    return;
+  }
+
+  // Group the list by type so that it reads in the same order as the legend.
+  NSMutableString* text = [NSMutableString string];
+  for (NIOverviewLayerIssueType type = NIOverviewLayerIssueOffscreenMask;
+       type <= NIOverviewLayerIssueRasterizationMiss; ++type) {
+    NSArray* issuesOfType = [issues filteredArrayUsingPredicate:
+                             [NSPredicate predicateWithBlock:^BOOL(NIOverviewLayerIssue* issue,
+                                                                   NSDictionary* bindings) {
+      return issue.type == type;
+    }]];
+    if (0 == issuesOfType.count) {
+      continue;
+    }
+    [text appendFormat:@"%@ (%lu)\n", [NIOverviewLayerInspector nameOfIssueType:type],
+     (unsigned long)issuesOfType.count];
+    for (NIOverviewLayerIssue* issue in issuesOfType) {
+      [text appendFormat:@"  %@\n", issue.summary];
     }
   }
-  return nil != entry;
+  _textView.text = text;
 }
 
 @end
@@ -0,0 +1,208 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+
+@class NIOverviewProfile;
+@class NIOverviewProfileNode;
+
+/**
+ * A sampling profiler for the main thread.
+ *
+ * @ingroup Overview-Sensors
+ *
+ * The watchdog catches long freezes. Jank is more often a run of 20-40 ms frames, which the
+ * profiler is meant to explain on devices that Instruments can't be attached to. While it is
+ * recording, a background thread suspends the main thread about once a millisecond and walks its
+ * frame pointers, just like NIOverviewWatchdog does for a stall. Each stack is copied into the
+ * current NIOverviewProfile. Symbols are not looked up until the profile is summarized or
+ * exported.
+ *
+ * Start and stop a recording from the Overview's profiler page or in code:
+ *
+ * @code
+ * [[NIOverviewProfiler sharedProfiler] startRecording];
+ * // Scroll through the slow screen.
+ * [[NIOverviewProfiler sharedProfiler] stopRecording];
+ * NSArray* functions = [[NIOverviewProfiler sharedProfiler].profile topFunctionsWithLimit:10];
+ * @endcode
+ *
+ * The profile is also written to the trace by NIOverviewTraceExporter.
+ */
+@interface NIOverviewProfiler : NSObject
+
+/**
+ * Returns the shared profiler.
+ */
++ (NIOverviewProfiler *)sharedProfiler;
+
+/**
+ * The time between samples while recording.
+ *
+ * Changes take effect at the start of the next recording.
+ *
+ * By default this is 1 millisecond.
+ */
+@property (nonatomic, assign) NSTimeInterval samplingInterval;
+
+/**
+ * The most samples a recording will hold. Samples are no longer taken once the profile is full.
+ *
+ * Every sample holds up to 64 frames, so the default of ten seconds at 1 kHz needs about 5 MB.
+ * Changes take effect at the start of the next recording.
+ *
+ * By default this is 10000.
+ */
+@property (nonatomic, assign) NSUInteger maximumNumberOfSamples;
+
+/**
+ * Whether a recording is in progress.
+ */
+@property (nonatomic, readonly, getter=isRecording) BOOL recording;
+
+/**
+ * The profile that is being recorded, or the one that was recorded last.
+ *
+ * nil until the first recording starts.
+ */
+@property (nonatomic, readonly, strong) NIOverviewProfile* profile;
+
+/**
+ * Discards the last profile and starts sampling the main thread into a new one. Does nothing if
+ * a recording is already in progress.
+ *
+ * Must be called from the main thread.
+ */
+- (void)startRecording;
+
+/**
+ * Stops sampling. The profile keeps the samples recorded so far.
+ */
+- (void)stopRecording;
+
+@end
+
+/**
+ * The samples recorded by one NIOverviewProfiler session.
+ *
+ * @ingroup Overview-Sensors
+ *
+ * Samples may be read while the profile is being recorded; samples that have been added never
+ * change. The summaries resolve each distinct return address with dladdr once and cache the
+ * result, so they must only be built on one thread at a time, normally the main thread.
+ */
+@interface NIOverviewProfile : NSObject
+
+/**
+ * The time between samples that the profile was recorded with.
+ */
+@property (nonatomic, readonly) NSTimeInterval samplingInterval;
+
+/**
+ * The number of samples taken so far.
+ */
+@property (nonatomic, readonly) NSUInteger numberOfSamples;
+
+/**
+ * The time of the sample at the given index, in the CACurrentMediaTime() time base.
+ */
+- (CFTimeInterval)timestampOfSampleAtIndex:(NSUInteger)index;
+
+/**
+ * The number of frames in the sample at the given index.
+ */
+- (NSUInteger)numberOfFramesInSampleAtIndex:(NSUInteger)index;
+
+/**
+ * The return addresses of the sample at the given index, innermost first.
+ */
+- (const uintptr_t *)framesOfSampleAtIndex:(NSUInteger)index;
+
+/**
+ * The start address of the function that contains the given frame, or the frame itself if it
+ * can't be symbolicated.
+ */
+- (uintptr_t)functionAddressOfFrame:(uintptr_t)frame;
+
+/**
+ * The name of the function that starts at the given address.
+ */
+- (NSString *)nameOfFunctionAtAddress:(uintptr_t)address;
+
+/**
+ * The functions that the most samples were spent in, ordered by their self samples.
+ *
+ *      @returns An array of NIOverviewProfileFunction objects.
+ */
+- (NSArray *)topFunctionsWithLimit:(NSUInteger)limit;
+
+/**
+ * The samples merged into a tree of calls, starting from the outermost frame.
+ *
+ * The root node has no name and counts every sample.
+ */
+- (NIOverviewProfileNode *)callTree;
+
+@end
+
+/**
+ * A function's share of an NIOverviewProfile.
+ *
+ * @ingroup Overview-Sensors
+ */
+@interface NIOverviewProfileFunction : NSObject
+
+/**
+ * The function's symbol, or its address if it couldn't be symbolicated.
+ */
+@property (nonatomic, readonly, copy) NSString* name;
+
+/**
+ * The number of samples in which the function was the innermost frame.
+ */
+@property (nonatomic, readonly) NSUInteger numberOfSelfSamples;
+
+/**
+ * The number of samples in which the function was anywhere on the stack.
+ */
+@property (nonatomic, readonly) NSUInteger numberOfTotalSamples;
+
+@end
+
+/**
+ * A node in an NIOverviewProfile's call tree.
+ *
+ * @ingroup Overview-Sensors
+ */
+@interface NIOverviewProfileNode : NSObject
+
+/**
+ * The function that was called.
+ */
+@property (nonatomic, readonly, copy) NSString* name;
+
+/**
+ * The number of samples that passed through this call.
+ */
+@property (nonatomic, readonly) NSUInteger numberOfSamples;
+
+/**
+ * The calls made from this one, with the most samples first.
+ */
+@property (nonatomic, readonly, copy) NSArray* children;
+
+@end
@@ -0,0 +1,341 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIOverviewProfiler.h"
+
+#import "NIOverviewWatchdog.h"
+#import "NimbusCore.h"
+
+#import <QuartzCore/QuartzCore.h>
+#import <dlfcn.h>
+#import <pthread.h>
+#import <stdatomic.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+enum { kMaximumNumberOfFramesPerSample = 64 };
+
+@interface NIOverviewProfile()
+- (id)initWithCapacity:(NSUInteger)capacity samplingInterval:(NSTimeInterval)samplingInterval;
+- (BOOL)isFull;
+- (void)recordSampleOfThread:(thread_t)thread;
+@end
+
+@interface NIOverviewProfileFunction()
+@property (nonatomic, copy) NSString* name;
+@property (nonatomic) NSUInteger numberOfSelfSamples;
+@property (nonatomic) NSUInteger numberOfTotalSamples;
+// The last sample that counted towards numberOfTotalSamples, so that recursion counts once.
+@property (nonatomic) NSUInteger lastSampleIndex;
+@end
+
+@interface NIOverviewProfileNode()
+@property (nonatomic, copy) NSString* name;
+@property (nonatomic) NSUInteger numberOfSamples;
+@property (nonatomic, copy) NSArray* children;
+// Function addresses to nodes while the tree is being built.
+@property (nonatomic, strong) NSMutableDictionary* childrenByAddress;
+@end
+
+@implementation NIOverviewProfiler {
+  NSThread* _thread;
+  thread_t _mainThread;
+}
+
++ (NIOverviewProfiler *)sharedProfiler {
+  static dispatch_once_t pred = 0;
+  static NIOverviewProfiler* instance = nil;
+
+  dispatch_once(&pred, ^{
+    instance = [[NIOverviewProfiler alloc] init];
+  });
+
+  return instance;
+}
+
+- (id)init {
+  if ((self = [super init])) {
+    _samplingInterval = 0.001;
+    _maximumNumberOfSamples = 10000;
+  }
+  return self;
+}
+
+- (BOOL)isRecording {
+  return nil != _thread;
+}
+
+- (void)startRecording {
+  NIDASSERT([NSThread isMainThread]);
+  if (nil != _thread) {
+    return;
+  }
+  _mainThread = pthread_mach_thread_np(pthread_self());
+  _profile = [[NIOverviewProfile alloc] initWithCapacity:self.maximumNumberOfSamples
+                                        samplingInterval:self.samplingInterval];
+
+  // Each recording gets its own profile so that a sampler thread that is still winding down
+  // never writes into the next recording.
+  _thread = [[NSThread alloc] initWithTarget:self
+                                    selector:@selector(samplerThreadMain:)
+                                      object:_profile];
+  _thread.name = @"com.nimbuskit.overview.profiler";
+  // The sampler has to wake up on time to keep its rate.
+  if ([_thread respondsToSelector:@selector(setQualityOfService:)]) {
+    _thread.qualityOfService = NSQualityOfServiceUserInteractive;
+  } else {
+    // Quality of service is only available from iOS 8.
+    _thread.threadPriority = 1.0;
+  }
+  [_thread start];
+}
+
+- (void)stopRecording {
+  [_thread cancel];
+  _thread = nil;
+}
+
+- (void)samplerThreadMain:(NIOverviewProfile *)profile {
+  NSThread* thread = [NSThread currentThread];
+  thread_t mainThread = _mainThread;
+  NSTimeInterval interval = profile.samplingInterval;
+  while (![thread isCancelled] && ![profile isFull]) {
+    [profile recordSampleOfThread:mainThread];
+    [NSThread sleepForTimeInterval:interval];
+  }
+
+  if ([profile isFull]) {
+    dispatch_async(dispatch_get_main_queue(), ^{
+      if (self->_profile == profile) {
+        [self stopRecording];
+      }
+    });
+  }
+}
+
+@end
+
+@implementation NIOverviewProfile {
+  NSUInteger _capacity;
+  CFTimeInterval* _timestamps;
+  uint8_t* _frameCounts;
+  uintptr_t* _frames;
+  // Written by the sampler thread. Samples below this index never change.
+  atomic_size_t _numberOfSamples;
+
+  // Symbol lookups, filled in lazily by whoever summarizes the profile.
+  NSMutableDictionary* _functionAddresses;
+  NSMutableDictionary* _functionNames;
+}
+
+- (void)dealloc {
+  free(_timestamps);
+  free(_frameCounts);
+  free(_frames);
+}
+
+- (id)initWithCapacity:(NSUInteger)capacity samplingInterval:(NSTimeInterval)samplingInterval {
+  if ((self = [super init])) {
+    _capacity = capacity;
+    _samplingInterval = samplingInterval;
+    _timestamps = calloc(capacity, sizeof(CFTimeInterval));
+    _frameCounts = calloc(capacity, sizeof(uint8_t));
+    _frames = calloc(capacity * kMaximumNumberOfFramesPerSample, sizeof(uintptr_t));
+    atomic_init(&_numberOfSamples, 0);
+    _functionAddresses = [NSMutableDictionary dictionary];
+    _functionNames = [NSMutableDictionary dictionary];
+  }
+  return self;
+}
+
+#pragma mark - Recording
+
+
+- (BOOL)isFull {
+  return atomic_load_explicit(&_numberOfSamples, memory_order_relaxed) >= _capacity;
+}
+
+- (void)recordSampleOfThread:(thread_t)thread {
+  // Only the sampler thread adds samples, so nobody else can claim this index.
+  size_t index = atomic_load_explicit(&_numberOfSamples, memory_order_relaxed);
+  if (index >= _capacity) {
+    return;
+  }
+  uintptr_t* frames = _frames + index * kMaximumNumberOfFramesPerSample;
+  NSUInteger numberOfFrames = NIOverviewBacktraceOfThread(thread, frames,
+                                                          kMaximumNumberOfFramesPerSample);
+  if (0 == numberOfFrames) {
+    return;
+  }
+  _timestamps[index] = CACurrentMediaTime();
+  _frameCounts[index] = (uint8_t)numberOfFrames;
+  atomic_store_explicit(&_numberOfSamples, index + 1, memory_order_release);
+}
+
+#pragma mark - Samples
+
+
+- (NSUInteger)numberOfSamples {
+  return atomic_load_explicit(&_numberOfSamples, memory_order_acquire);
+}
+
+- (CFTimeInterval)timestampOfSampleAtIndex:(NSUInteger)index {
+  NIDASSERT(index < self.numberOfSamples);
+  return _timestamps[index];
+}
+
+- (NSUInteger)numberOfFramesInSampleAtIndex:(NSUInteger)index {
+  NIDASSERT(index < self.numberOfSamples);
+  return _frameCounts[index];
+}
+
+- (const uintptr_t *)framesOfSampleAtIndex:(NSUInteger)index {
+  NIDASSERT(index < self.numberOfSamples);
+  return _frames + index * kMaximumNumberOfFramesPerSample;
+}
+
+#pragma mark - Symbols
+
+
+- (uintptr_t)functionAddressOfFrame:(uintptr_t)frame {
+  NSNumber* key = @(frame);
+  NSNumber* address = [_functionAddresses objectForKey:key];
+  if (nil == address) {
+    Dl_info info;
+    if (0 != dladdr((const void *)frame, &info) && NULL != info.dli_saddr) {
+      address = @((uintptr_t)info.dli_saddr);
+      if (nil == [_functionNames objectForKey:address] && NULL != info.dli_sname) {
+        [_functionNames setObject:@(info.dli_sname) forKey:address];
+      }
+    } else {
+      address = key;
+    }
+    [_functionAddresses setObject:address forKey:key];
+  }
+  return [address unsignedLongValue];
+}
+
+- (NSString *)nameOfFunctionAtAddress:(uintptr_t)address {
+  NSNumber* key = @(address);
+  NSString* name = [_functionNames objectForKey:key];
+  if (nil == name) {
+    name = [NSString stringWithFormat:@"0x%lx", (unsigned long)address];
+    [_functionNames setObject:name forKey:key];
+  }
+  return name;
+}
+
+#pragma mark - Summaries
+
+
+- (NSArray *)topFunctionsWithLimit:(NSUInteger)limit {
+  NSMutableDictionary* functions = [NSMutableDictionary dictionary];
+  NSUInteger numberOfSamples = self.numberOfSamples;
+  for (NSUInteger ix = 0; ix < numberOfSamples; ++ix) {
+    const uintptr_t* frames = [self framesOfSampleAtIndex:ix];
+    NSUInteger numberOfFrames = _frameCounts[ix];
+    for (NSUInteger frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex) {
+      NSNumber* address = @([self functionAddressOfFrame:frames[frameIndex]]);
+      NIOverviewProfileFunction* function = [functions objectForKey:address];
+      if (nil == function) {
+        function = [[NIOverviewProfileFunction alloc] init];
+        function.name = [self nameOfFunctionAtAddress:[address unsignedLongValue]];
+        function.lastSampleIndex = NSNotFound;
+        [functions setObject:function forKey:address];
+      }
+      if (0 == frameIndex) {
+        function.numberOfSelfSamples++;
+      }
+      if (function.lastSampleIndex != ix) {
+        function.lastSampleIndex = ix;
+        function.numberOfTotalSamples++;
+      }
+    }
+  }
+
+  NSArray* sortedFunctions = [[functions allValues] sortedArrayUsingComparator:
+                              ^NSComparisonResult(NIOverviewProfileFunction* function1,
+                                                  NIOverviewProfileFunction* function2) {
+    if (function1.numberOfSelfSamples != function2.numberOfSelfSamples) {
+      return (function1.numberOfSelfSamples > function2.numberOfSelfSamples
+              ? NSOrderedAscending : NSOrderedDescending);
+    }
+    if (function1.numberOfTotalSamples != function2.numberOfTotalSamples) {
+      return (function1.numberOfTotalSamples > function2.numberOfTotalSamples
+              ? NSOrderedAscending : NSOrderedDescending);
+    }
+    return [function1.name compare:function2.name];
+  }];
+  if (sortedFunctions.count > limit) {
+    sortedFunctions = [sortedFunctions subarrayWithRange:NSMakeRange(0, limit)];
+  }
+  return sortedFunctions;
+}
+
+static void NIOverviewProfileNodeFinish(NIOverviewProfileNode* node) {
+  NSArray* children = [[node.childrenByAddress allValues] sortedArrayUsingComparator:
+                       ^NSComparisonResult(NIOverviewProfileNode* node1,
+                                           NIOverviewProfileNode* node2) {
+    if (node1.numberOfSamples != node2.numberOfSamples) {
+      return (node1.numberOfSamples > node2.numberOfSamples
+              ? NSOrderedAscending : NSOrderedDescending);
+    }
+    return [node1.name compare:node2.name];
+  }];
+  for (NIOverviewProfileNode* child in children) {
+    NIOverviewProfileNodeFinish(child);
+  }
+  node.children = children;
+  node.childrenByAddress = nil;
+}
+
+- (NIOverviewProfileNode *)callTree {
+  NIOverviewProfileNode* root = [[NIOverviewProfileNode alloc] init];
+  root.childrenByAddress = [NSMutableDictionary dictionary];
+
+  NSUInteger numberOfSamples = self.numberOfSamples;
+  for (NSUInteger ix = 0; ix < numberOfSamples; ++ix) {
+    const uintptr_t* frames = [self framesOfSampleAtIndex:ix];
+    NIOverviewProfileNode* node = root;
+    node.numberOfSamples++;
+    for (NSUInteger frameIndex = _frameCounts[ix]; frameIndex > 0; --frameIndex) {
+      NSNumber* address = @([self functionAddressOfFrame:frames[frameIndex - 1]]);
+      NIOverviewProfileNode* child = [node.childrenByAddress objectForKey:address];
+      if (nil == child) {
+        child = [[NIOverviewProfileNode alloc] init];
+        child.name = [self nameOfFunctionAtAddress:[address unsignedLongValue]];
+        child.childrenByAddress = [NSMutableDictionary dictionary];
+        [node.childrenByAddress setObject:child forKey:address];
+      }
+      child.numberOfSamples++;
+      node = child;
+    }
+  }
+
+  NIOverviewProfileNodeFinish(root);
+  return root;
+}
+
+@end
+
+@implementation NIOverviewProfileFunction
+@end
+
+@implementation NIOverviewProfileNode
+@end
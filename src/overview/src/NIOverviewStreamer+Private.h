@@ -0,0 +1,23 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import <QuartzCore/QuartzCore.h>
+
+// Appends a stall record for the given symbolicated frames, dropping the frames that would
+// take the payload past its uint16 length.
+void NIOverviewStreamAppendStallRecord(NSMutableData* data, CFTimeInterval timestamp,
+                                       CFTimeInterval duration, NSArray* frames);
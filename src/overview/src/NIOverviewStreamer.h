@@ -0,0 +1,136 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+
+@class NIOverviewLogger;
+
+/**
+ * The Bonjour service type that streamers are published with.
+ *
+ * @ingroup Overview-Logger
+ */
+extern NSString* const NIOverviewStreamerServiceType;
+
+/**
+ * The version of the stream format that is written after the stream's magic bytes.
+ *
+ * @ingroup Overview-Logger
+ */
+extern const uint16_t NIOverviewStreamerVersion;
+
+/**
+ * The types of records in an Overview stream.
+ *
+ * @ingroup Overview-Logger
+ */
+typedef enum {
+  // float64 timestamp, float32 duration.
+  NIOverviewStreamRecordFrame = 1,
+  // float64 timestamp, uint64 bytes of free memory, uint64 bytes of total memory.
+  NIOverviewStreamRecordMemory = 2,
+  // float64 timestamp, float32 process CPU usage.
+  NIOverviewStreamRecordCPU = 3,
+  // float64 timestamp, uint32 number of objects, uint64 hits, uint64 misses, uint64 evictions,
+  // uint64 bytes evicted, then the cache's class name in UTF-8 for the rest of the record.
+  NIOverviewStreamRecordCacheStatistics = 4,
+  // float64 timestamp, float32 duration, uint16 number of frames, then each symbolicated frame
+  // as a uint16 length followed by that many bytes of UTF-8, at most 1024.
+  NIOverviewStreamRecordStall = 5,
+} NIOverviewStreamRecordType;
+
+/**
+ * Streams the Overview's measurements to desktop tools over a Bonjour-advertised socket.
+ *
+ * @ingroup Overview-Logger
+ *
+ * The streamer is the reverse of NIChameleonObserver's Bonjour discovery: the device publishes
+ * a service of type NIOverviewStreamerServiceType and any number of clients may connect to it.
+ * Because the streamer doesn't depend on the Overview being visible, long sessions can be
+ * charted on a desktop without the on-device overlay perturbing the measurements.
+ *
+ * @code
+ * [NIOverview applicationDidFinishLaunching];
+ * [[NIOverviewStreamer sharedStreamer] startWithServiceName:nil];
+ * @endcode
+ *
+ * <h2>Stream Format</h2>
+ *
+ * Each connection begins with the four bytes "NIOV" followed by a uint16 version and a uint16
+ * of reserved zeros. The rest of the stream is a sequence of records, each made of a uint8
+ * NIOverviewStreamRecordType, a reserved zero byte, a uint16 payload length, and the payload.
+ * All values are little-endian and timestamps are CACurrentMediaTime() seconds. Clients should
+ * skip records of unknown types using the payload length.
+ *
+ * Frames are measured by the streamer's own display link. Memory and CPU records come from the
+ * logger's device samples, stall records from the logger's stall samples, and cache statistics
+ * are sampled from memoryCaches every flush.
+ */
+@interface NIOverviewStreamer : NSObject
+
+/**
+ * Returns the shared streamer, which streams the shared logger.
+ */
++ (NIOverviewStreamer *)sharedStreamer;
+
+/**
+ * Designated initializer.
+ */
+- (id)initWithLogger:(NIOverviewLogger *)logger;
+
+/**
+ * The memory caches whose statistics are streamed.
+ *
+ * By default this is the Nimbus image memory cache.
+ */
+@property (nonatomic, copy) NSArray* memoryCaches;
+
+/**
+ * How often, in seconds, new records are sent to connected clients.
+ *
+ * By default this is 0.5 seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval flushInterval;
+
+/**
+ * Whether the streamer's service is published.
+ */
+@property (nonatomic, readonly, getter=isRunning) BOOL running;
+
+/**
+ * The number of clients currently connected to the streamer.
+ */
+@property (nonatomic, readonly) NSUInteger numberOfClients;
+
+/**
+ * Publishes the streamer's service and begins measuring frames.
+ *
+ * Must be called from the main thread. Does nothing if the streamer is already running, or
+ * before iOS 7, where NSNetService can't accept connections.
+ *
+ *      @param serviceName The Bonjour name of the service, or nil to use the device's name.
+ */
+- (void)startWithServiceName:(NSString *)serviceName;
+
+/**
+ * Disconnects all clients and unpublishes the streamer's service.
+ *
+ * Must be called from the main thread.
+ */
+- (void)stop;
+
+@end
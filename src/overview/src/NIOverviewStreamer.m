@@ -0,0 +1,469 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIOverviewStreamer.h"
+#import "NIOverviewStreamer+Private.h"
+
+#import "NIOverviewLogger.h"
+#import "NIOverviewWatchdog.h"
+#import "NimbusCore.h"
+
+#import <QuartzCore/QuartzCore.h>
+#import <libkern/OSByteOrder.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+NSString* const NIOverviewStreamerServiceType = @"_nimbusoverview._tcp.";
+const uint16_t NIOverviewStreamerVersion = 1;
+
+// Clients that fall this far behind are disconnected rather than buffered without bound.
+static const NSUInteger kMaximumNumberOfPendingBytes = 1024 * 1024;
+
+// Each record starts with a type byte, a reserved byte, and a uint16 payload length.
+static const NSUInteger kRecordHeaderLength = 4;
+
+// Long symbols, such as those of C++ templates, are cut short so that a stall record with every
+// frame, 14 + 32 * (2 + 1024) bytes, still fits a uint16 payload length.
+static const NSUInteger kMaximumStringLength = 1024;
+
+static void NIOverviewStreamAppendUInt8(NSMutableData* data, uint8_t value) {
+  [data appendBytes:&value length:sizeof(value)];
+}
+
+static void NIOverviewStreamAppendUInt16(NSMutableData* data, uint16_t value) {
+  value = OSSwapHostToLittleInt16(value);
+  [data appendBytes:&value length:sizeof(value)];
+}
+
+static void NIOverviewStreamAppendUInt32(NSMutableData* data, uint32_t value) {
+  value = OSSwapHostToLittleInt32(value);
+  [data appendBytes:&value length:sizeof(value)];
+}
+
+static void NIOverviewStreamAppendUInt64(NSMutableData* data, uint64_t value) {
+  value = OSSwapHostToLittleInt64(value);
+  [data appendBytes:&value length:sizeof(value)];
+}
+
+static void NIOverviewStreamAppendFloat32(NSMutableData* data, float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  NIOverviewStreamAppendUInt32(data, bits);
+}
+
+static void NIOverviewStreamAppendFloat64(NSMutableData* data, double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  NIOverviewStreamAppendUInt64(data, bits);
+}
+
+static void NIOverviewStreamAppendString(NSMutableData* data, NSString* string) {
+  NSData* bytes = [string dataUsingEncoding:NSUTF8StringEncoding];
+  const uint8_t* utf8 = bytes.bytes;
+  NSUInteger length = bytes.length;
+  if (length > kMaximumStringLength) {
+    // Don't split a multi-byte character.
+    length = kMaximumStringLength;
+    while (length > 0 && (utf8[length] & 0xC0) == 0x80) {
+      length--;
+    }
+  }
+  NIOverviewStreamAppendUInt16(data, (uint16_t)length);
+  [data appendBytes:utf8 length:length];
+}
+
+// Returns the offset of the record so that its length can be filled in once it is written.
+static NSUInteger NIOverviewStreamBeginRecord(NSMutableData* data,
+                                              NIOverviewStreamRecordType type) {
+  NSUInteger offset = data.length;
+  NIOverviewStreamAppendUInt8(data, (uint8_t)type);
+  NIOverviewStreamAppendUInt8(data, 0);
+  NIOverviewStreamAppendUInt16(data, 0);
+  return offset;
+}
+
+static void NIOverviewStreamEndRecord(NSMutableData* data, NSUInteger offset) {
+  NSUInteger payloadLength = data.length - offset - kRecordHeaderLength;
+  NIDASSERT(payloadLength <= UINT16_MAX);
+  uint16_t length = OSSwapHostToLittleInt16((uint16_t)MIN(payloadLength, (NSUInteger)UINT16_MAX));
+  [data replaceBytesInRange:NSMakeRange(offset + 2, sizeof(length)) withBytes:&length];
+}
+
+void NIOverviewStreamAppendStallRecord(NSMutableData* data, CFTimeInterval timestamp,
+                                       CFTimeInterval duration, NSArray* frames) {
+  NSUInteger offset = NIOverviewStreamBeginRecord(data, NIOverviewStreamRecordStall);
+  NIOverviewStreamAppendFloat64(data, timestamp);
+  NIOverviewStreamAppendFloat32(data, (float)duration);
+
+  // Only as many frames as fit the record are written, deepest last.
+  NSUInteger numberOfFramesOffset = data.length;
+  NIOverviewStreamAppendUInt16(data, 0);
+  uint16_t numberOfFrames = 0;
+  for (NSString* frame in frames) {
+    NSUInteger frameOffset = data.length;
+    NIOverviewStreamAppendString(data, frame);
+    if (data.length - offset - kRecordHeaderLength > UINT16_MAX || numberOfFrames == UINT16_MAX) {
+      [data setLength:frameOffset];
+      break;
+    }
+    numberOfFrames++;
+  }
+  uint16_t littleEndianNumberOfFrames = OSSwapHostToLittleInt16(numberOfFrames);
+  [data replaceBytesInRange:NSMakeRange(numberOfFramesOffset, sizeof(littleEndianNumberOfFrames))
+                  withBytes:&littleEndianNumberOfFrames];
+  NIOverviewStreamEndRecord(data, offset);
+}
+
+// A connected client and the bytes that its socket hasn't accepted yet.
+@interface NIOverviewStreamerClient : NSObject
+@property (nonatomic, strong) NSInputStream* inputStream;
+@property (nonatomic, strong) NSOutputStream* outputStream;
+@property (nonatomic, strong) NSMutableData* pendingData;
+@end
+
+@implementation NIOverviewStreamerClient
+@end
+
+@interface NIOverviewStreamer () <NSNetServiceDelegate, NSStreamDelegate>
+@end
+
+@implementation NIOverviewStreamer {
+  NIOverviewLogger* _logger;
+  NSNetService* _netService;
+  NSTimer* _flushTimer;
+  CADisplayLink* _displayLink;
+  NSMutableArray* _clients;
+
+  // Records that have been encoded since the last flush.
+  NSMutableData* _records;
+  CFTimeInterval _lastFrameTimestamp;
+  CFTimeInterval _lastDeviceSampleTimestamp;
+  CFTimeInterval _lastStallSampleTimestamp;
+}
+
++ (NIOverviewStreamer *)sharedStreamer {
+  static NIOverviewStreamer* sSharedStreamer = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sSharedStreamer = [[NIOverviewStreamer alloc] initWithLogger:[NIOverviewLogger sharedLogger]];
+  });
+  return sSharedStreamer;
+}
+
+- (void)dealloc {
+  [self stop];
+}
+
+- (id)initWithLogger:(NIOverviewLogger *)logger {
+  if ((self = [super init])) {
+    _logger = logger;
+    _flushInterval = 0.5;
+    _clients = [[NSMutableArray alloc] init];
+    _records = [[NSMutableData alloc] init];
+
+    NIMemoryCache* imageMemoryCache = [Nimbus imageMemoryCache];
+    _memoryCaches = (nil != imageMemoryCache) ? @[imageMemoryCache] : @[];
+  }
+  return self;
+}
+
+- (id)init {
+  return [self initWithLogger:[NIOverviewLogger sharedLogger]];
+}
+
+- (NSUInteger)numberOfClients {
+  return _clients.count;
+}
+
+#pragma mark - Publishing
+
+- (void)startWithServiceName:(NSString *)serviceName {
+  NIDASSERT([NSThread isMainThread]);
+  if (_running) {
+    return;
+  }
+  // NSNetServiceListenForConnections is only available from iOS 7, along with
+  // includesPeerToPeer.
+  if (![NSNetService instancesRespondToSelector:@selector(includesPeerToPeer)]) {
+    NIDERROR(@"The Overview streamer requires iOS 7 or later.");
+    return;
+  }
+  _running = YES;
+
+  // Only stream what happens from now on.
+  CFTimeInterval now = CACurrentMediaTime();
+  _lastFrameTimestamp = 0;
+  _lastDeviceSampleTimestamp = now;
+  _lastStallSampleTimestamp = now;
+  [_records setLength:0];
+
+  // An empty name makes Bonjour use the device's name.
+  _netService = [[NSNetService alloc] initWithDomain:@""
+                                                type:NIOverviewStreamerServiceType
+                                                name:(nil != serviceName) ? serviceName : @""
+                                                port:0];
+  _netService.delegate = self;
+  [_netService publishWithOptions:NSNetServiceListenForConnections];
+
+  // The display link and timer retain the streamer until it is stopped.
+  _displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(displayLinkDidFire:)];
+  [_displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+
+  _flushTimer = [NSTimer timerWithTimeInterval:self.flushInterval
+                                        target:self
+                                      selector:@selector(flushTimerDidFire:)
+                                      userInfo:nil
+                                       repeats:YES];
+  [[NSRunLoop mainRunLoop] addTimer:_flushTimer forMode:NSRunLoopCommonModes];
+}
+
+- (void)stop {
+  if (!_running) {
+    return;
+  }
+  _running = NO;
+
+  [_flushTimer invalidate];
+  _flushTimer = nil;
+  [_displayLink invalidate];
+  _displayLink = nil;
+
+  _netService.delegate = nil;
+  [_netService stop];
+  _netService = nil;
+
+  for (NIOverviewStreamerClient* client in [_clients copy]) {
+    [self disconnectClient:client];
+  }
+  [_records setLength:0];
+}
+
+#pragma mark - Clients
+
+- (void)disconnectClient:(NIOverviewStreamerClient *)client {
+  for (NSStream* stream in @[client.inputStream, client.outputStream]) {
+    stream.delegate = nil;
+    [stream removeFromRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+    [stream close];
+  }
+  [_clients removeObject:client];
+}
+
+- (NIOverviewStreamerClient *)clientForStream:(NSStream *)stream {
+  for (NIOverviewStreamerClient* client in _clients) {
+    if (client.inputStream == stream || client.outputStream == stream) {
+      return client;
+    }
+  }
+  return nil;
+}
+
+// Writes as much of the client's pending data as its socket will accept without blocking.
+- (void)writePendingDataToClient:(NIOverviewStreamerClient *)client {
+  NSMutableData* pendingData = client.pendingData;
+  NSUInteger offset = 0;
+  while (offset < pendingData.length && client.outputStream.hasSpaceAvailable) {
+    NSInteger bytesWritten = [client.outputStream write:(const uint8_t *)pendingData.bytes + offset
+                                              maxLength:pendingData.length - offset];
+    if (bytesWritten <= 0) {
+      [self disconnectClient:client];
+      return;
+    }
+    offset += (NSUInteger)bytesWritten;
+  }
+  [pendingData replaceBytesInRange:NSMakeRange(0, offset) withBytes:NULL length:0];
+}
+
+- (void)sendData:(NSData *)data toClient:(NIOverviewStreamerClient *)client {
+  if (client.pendingData.length + data.length > kMaximumNumberOfPendingBytes) {
+    NIDPRINT(@"Disconnecting an Overview stream client that fell too far behind.");
+    [self disconnectClient:client];
+    return;
+  }
+  [client.pendingData appendData:data];
+  [self writePendingDataToClient:client];
+}
+
+#pragma mark - Recording
+
+- (void)displayLinkDidFire:(CADisplayLink *)displayLink {
+  CFTimeInterval timestamp = displayLink.timestamp;
+  if (_lastFrameTimestamp > 0 && _clients.count > 0) {
+    NSUInteger offset = NIOverviewStreamBeginRecord(_records, NIOverviewStreamRecordFrame);
+    NIOverviewStreamAppendFloat64(_records, timestamp);
+    NIOverviewStreamAppendFloat32(_records, (float)(timestamp - _lastFrameTimestamp));
+    NIOverviewStreamEndRecord(_records, offset);
+  }
+  _lastFrameTimestamp = timestamp;
+}
+
+- (void)appendDeviceSampleRecords {
+  // Samples are ordered by time, so only the newest ones need to be visited.
+  NSUInteger numberOfSamples = [_logger numberOfDeviceSamples];
+  NSUInteger firstIndex = numberOfSamples;
+  while (firstIndex > 0
+         && [_logger deviceSampleAtIndex:firstIndex - 1].timestamp > _lastDeviceSampleTimestamp) {
+    firstIndex--;
+  }
+  for (NSUInteger ix = firstIndex; ix < numberOfSamples; ++ix) {
+    NIOverviewDeviceSample sample = [_logger deviceSampleAtIndex:ix];
+
+    NSUInteger offset = NIOverviewStreamBeginRecord(_records, NIOverviewStreamRecordMemory);
+    NIOverviewStreamAppendFloat64(_records, sample.timestamp);
+    NIOverviewStreamAppendUInt64(_records, sample.bytesOfFreeMemory);
+    NIOverviewStreamAppendUInt64(_records, sample.bytesOfTotalMemory);
+    NIOverviewStreamEndRecord(_records, offset);
+
+    offset = NIOverviewStreamBeginRecord(_records, NIOverviewStreamRecordCPU);
+    NIOverviewStreamAppendFloat64(_records, sample.timestamp);
+    NIOverviewStreamAppendFloat32(_records, (float)sample.processCPUUsage);
+    NIOverviewStreamEndRecord(_records, offset);
+
+    _lastDeviceSampleTimestamp = sample.timestamp;
+  }
+}
+
+- (void)appendStallSampleRecords {
+  NSUInteger numberOfSamples = [_logger numberOfStallSamples];
+  NSUInteger firstIndex = numberOfSamples;
+  while (firstIndex > 0
+         && [_logger stallSampleAtIndex:firstIndex - 1].timestamp > _lastStallSampleTimestamp) {
+    firstIndex--;
+  }
+  for (NSUInteger ix = firstIndex; ix < numberOfSamples; ++ix) {
+    NIOverviewStallSample sample = [_logger stallSampleAtIndex:ix];
+
+    NSMutableArray* frames = [NSMutableArray arrayWithCapacity:sample.numberOfFrames];
+    for (NSUInteger frameIndex = 0; frameIndex < sample.numberOfFrames; ++frameIndex) {
+      [frames addObject:NIOverviewStringFromStackFrame(sample.frames[frameIndex])];
+    }
+    NIOverviewStreamAppendStallRecord(_records, sample.timestamp, sample.duration, frames);
+
+    _lastStallSampleTimestamp = sample.timestamp;
+  }
+}
+
+- (void)appendMemoryCacheStatisticsRecords {
+  CFTimeInterval timestamp = CACurrentMediaTime();
+  for (NIMemoryCache* cache in self.memoryCaches) {
+    NIMemoryCacheStatistics* statistics = [cache statistics];
+
+    NSUInteger offset = NIOverviewStreamBeginRecord(_records,
+                                                    NIOverviewStreamRecordCacheStatistics);
+    NIOverviewStreamAppendFloat64(_records, timestamp);
+    NIOverviewStreamAppendUInt32(_records, (uint32_t)[cache count]);
+    NIOverviewStreamAppendUInt64(_records, statistics.numberOfHits);
+    NIOverviewStreamAppendUInt64(_records, statistics.numberOfMisses);
+    NIOverviewStreamAppendUInt64(_records, statistics.numberOfEvictions);
+    NIOverviewStreamAppendUInt64(_records, statistics.numberOfBytesEvicted);
+    NSData* name = [NSStringFromClass([cache class]) dataUsingEncoding:NSUTF8StringEncoding];
+    [_records appendBytes:name.bytes length:MIN(name.length, kMaximumStringLength)];
+    NIOverviewStreamEndRecord(_records, offset);
+  }
+}
+
+- (void)flushTimerDidFire:(NSTimer *)timer {
+  if (_clients.count == 0) {
+    // Keep the cursors current so that a new client doesn't receive a backlog.
+    _lastDeviceSampleTimestamp = CACurrentMediaTime();
+    _lastStallSampleTimestamp = _lastDeviceSampleTimestamp;
+    [_records setLength:0];
+    return;
+  }
+
+  [self appendDeviceSampleRecords];
+  [self appendStallSampleRecords];
+  [self appendMemoryCacheStatisticsRecords];
+
+  NSData* records = [_records copy];
+  [_records setLength:0];
+  for (NIOverviewStreamerClient* client in [_clients copy]) {
+    [self sendData:records toClient:client];
+  }
+}
+
+#pragma mark - NSNetServiceDelegate
+
+- (void)netService:(NSNetService *)sender didNotPublish:(NSDictionary *)errorDict {
+  NIDERROR(@"Failed to publish the Overview streamer: %@", errorDict);
+}
+
+- (void)netService:(NSNetService *)sender
+    didAcceptConnectionWithInputStream:(NSInputStream *)inputStream
+    outputStream:(NSOutputStream *)outputStream {
+  // Connections are accepted on an arbitrary thread.
+  dispatch_async(dispatch_get_main_queue(), ^{
+    if (!self->_running) {
+      [inputStream close];
+      [outputStream close];
+      return;
+    }
+
+    NIOverviewStreamerClient* client = [[NIOverviewStreamerClient alloc] init];
+    client.inputStream = inputStream;
+    client.outputStream = outputStream;
+    client.pendingData = [NSMutableData data];
+    [self->_clients addObject:client];
+
+    for (NSStream* stream in @[inputStream, outputStream]) {
+      stream.delegate = self;
+      [stream scheduleInRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+      [stream open];
+    }
+
+    NSMutableData* header = [NSMutableData dataWithBytes:"NIOV" length:4];
+    NIOverviewStreamAppendUInt16(header, NIOverviewStreamerVersion);
+    NIOverviewStreamAppendUInt16(header, 0);
+    [self sendData:header toClient:client];
+  });
+}
+
+#pragma mark - NSStreamDelegate
+
+- (void)stream:(NSStream *)stream handleEvent:(NSStreamEvent)eventCode {
+  NIOverviewStreamerClient* client = [self clientForStream:stream];
+  if (nil == client) {
+    return;
+  }
+
+  switch (eventCode) {
+    case NSStreamEventHasSpaceAvailable:
+      [self writePendingDataToClient:client];
+      break;
+
+    case NSStreamEventHasBytesAvailable: {
+      // Clients don't send anything yet, so discard whatever arrives.
+      uint8_t buffer[256];
+      while ([client.inputStream hasBytesAvailable]
+             && [client.inputStream read:buffer maxLength:sizeof(buffer)] > 0) {
+      }
+      break;
+    }
+
+    case NSStreamEventErrorOccurred:
+    case NSStreamEventEndEncountered:
+      [self disconnectClient:client];
+      break;
+
+    default:
+      break;
+  }
+}
+
+@end
@@ -0,0 +1,82 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+
+@class NIOverviewLogger;
+@class NIMemoryCache;
+@class NIOverviewProfile;
+
+/**
+ * Writes the Overview's logs to a Chrome trace-event file.
+ *
+ * @ingroup Overview-Logger
+ *
+ * The trace contains the logger's device samples as counters, its frames and stalls as
+ * complete events, and its events as instant events. It ends with a snapshot of each memory
+ * cache's statistics. A profile recorded by NIOverviewProfiler is added as stack samples of the
+ * main thread. Open the file in chrome://tracing or Perfetto.
+ *
+ * Entries are streamed from the logger's ring buffers through a small fixed buffer, so
+ * exporting doesn't build the whole document in memory.
+ *
+ * @code
+ * NSString* path = [NIOverviewTraceExporter exportTraceWithError:nil];
+ * UIActivityViewController* controller =
+ *     [[UIActivityViewController alloc] initWithActivityItems:@[[NSURL fileURLWithPath:path]]
+ *                                       applicationActivities:nil];
+ * @endcode
+ */
+@interface NIOverviewTraceExporter : NSObject
+
+/**
+ * Writes the shared logger's trace, with the Nimbus image memory cache's statistics, to a new
+ * file in the caches directory.
+ *
+ * Must be called from the main thread.
+ *
+ *      @returns The path of the trace file, or nil if it could not be written.
+ */
++ (NSString *)exportTraceWithError:(NSError **)error;
+
+/**
+ * Designated initializer.
+ */
+- (id)initWithLogger:(NIOverviewLogger *)logger;
+
+/**
+ * The memory caches whose statistics are included in the trace.
+ *
+ * By default this is the Nimbus image memory cache.
+ */
+@property (nonatomic, copy) NSArray* memoryCaches;
+
+/**
+ * The profile whose samples are included in the trace.
+ *
+ * By default this is the shared NIOverviewProfiler's profile, if it has recorded one.
+ */
+@property (nonatomic, strong) NIOverviewProfile* profile;
+
+/**
+ * Writes the trace to the given path, replacing any existing file.
+ *
+ * Must be called from the main thread.
+ */
+- (BOOL)writeTraceToPath:(NSString *)path error:(NSError **)error;
+
+@end
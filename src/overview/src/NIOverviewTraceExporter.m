@@ -0,0 +1,362 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIOverviewTraceExporter.h"
+
+#import "NIOverviewLogger.h"
+#import "NIOverviewProfiler.h"
+#import "NIOverviewWatchdog.h"
+#import "NimbusCore.h"
+
+#import <QuartzCore/QuartzCore.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+static const size_t kTraceWriterBufferSize = 16 * 1024;
+
+// Accumulates formatted output in a fixed buffer and flushes it to the stream when full.
+typedef struct {
+  __unsafe_unretained NSOutputStream* stream;
+  char* buffer;
+  size_t length;
+  BOOL needsSeparator;
+  BOOL failed;
+} NIOverviewTraceWriter;
+
+static void NIOverviewTraceWriterFlush(NIOverviewTraceWriter* writer) {
+  size_t offset = 0;
+  while (!writer->failed && offset < writer->length) {
+    NSInteger bytesWritten = [writer->stream write:(const uint8_t *)writer->buffer + offset
+                                         maxLength:writer->length - offset];
+    if (bytesWritten <= 0) {
+      writer->failed = YES;
+    } else {
+      offset += (size_t)bytesWritten;
+    }
+  }
+  writer->length = 0;
+}
+
+static void NIOverviewTraceWriterWriteFormat(NIOverviewTraceWriter* writer,
+                                             const char* format, ...) __printflike(2, 3);
+static void NIOverviewTraceWriterWriteFormat(NIOverviewTraceWriter* writer,
+                                             const char* format, ...) {
+  for (int attempt = 0; attempt < 2 && !writer->failed; ++attempt) {
+    size_t available = kTraceWriterBufferSize - writer->length;
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(writer->buffer + writer->length, available, format, args);
+    va_end(args);
+
+    if (length < 0) {
+      writer->failed = YES;
+    } else if ((size_t)length < available) {
+      writer->length += (size_t)length;
+      return;
+    } else {
+      // Try again with an empty buffer.
+      NIOverviewTraceWriterFlush(writer);
+    }
+  }
+  // Every formatted piece is far smaller than the buffer, so this is never expected.
+  NIDASSERT(writer->failed);
+  writer->failed = YES;
+}
+
+static void NIOverviewTraceWriterWriteByte(NIOverviewTraceWriter* writer, char byte) {
+  if (writer->length == kTraceWriterBufferSize) {
+    NIOverviewTraceWriterFlush(writer);
+  }
+  writer->buffer[writer->length++] = byte;
+}
+
+// Writes a quoted, escaped JSON string.
+static void NIOverviewTraceWriterWriteString(NIOverviewTraceWriter* writer, NSString* string) {
+  static const char kHexDigits[] = "0123456789abcdef";
+  NIOverviewTraceWriterWriteByte(writer, '"');
+  for (const char* byte = [string UTF8String]; NULL != byte && '\0' != *byte; ++byte) {
+    unsigned char character = (unsigned char)*byte;
+    if ('"' == character || '\\' == character) {
+      NIOverviewTraceWriterWriteByte(writer, '\\');
+      NIOverviewTraceWriterWriteByte(writer, (char)character);
+    } else if (character < 0x20) {
+      NIOverviewTraceWriterWriteFormat(writer, "\\u00%c%c",
+                                       kHexDigits[character >> 4], kHexDigits[character & 0xF]);
+    } else {
+      NIOverviewTraceWriterWriteByte(writer, (char)character);
+    }
+  }
+  NIOverviewTraceWriterWriteByte(writer, '"');
+}
+
+// Starts a new element of the traceEvents array.
+static void NIOverviewTraceWriterBeginEvent(NIOverviewTraceWriter* writer) {
+  if (writer->needsSeparator) {
+    NIOverviewTraceWriterWriteFormat(writer, ",\n");
+  }
+  writer->needsSeparator = YES;
+}
+
+// Trace timestamps are in microseconds.
+static double NIOverviewTraceTimestamp(CFTimeInterval timestamp) {
+  return timestamp * 1000000.0;
+}
+
+static const char* NIOverviewTraceNameOfEventType(NSInteger type) {
+  switch (type) {
+    case NIOverviewEventDidReceiveMemoryWarning:
+      return "Memory warning";
+    case NIOverviewEventHitch:
+      return "Hitch";
+    case NIOverviewEventStall:
+      return "Stall";
+    default:
+      return "Event";
+  }
+}
+
+@implementation NIOverviewTraceExporter {
+  NIOverviewLogger* _logger;
+}
+
++ (NSString *)exportTraceWithError:(NSError **)error {
+  NIOverviewTraceExporter* exporter =
+      [[NIOverviewTraceExporter alloc] initWithLogger:[NIOverviewLogger sharedLogger]];
+  NSString* fileName = [NSString stringWithFormat:@"NIOverviewTrace-%.0f.json",
+                        [[NSDate date] timeIntervalSince1970]];
+  NSString* path = NIPathForCachesResource(fileName);
+  return [exporter writeTraceToPath:path error:error] ? path : nil;
+}
+
+- (id)initWithLogger:(NIOverviewLogger *)logger {
+  if ((self = [super init])) {
+    _logger = logger;
+    NIMemoryCache* imageMemoryCache = [Nimbus imageMemoryCache];
+    _memoryCaches = (nil != imageMemoryCache) ? @[imageMemoryCache] : @[];
+    _profile = [NIOverviewProfiler sharedProfiler].profile;
+  }
+  return self;
+}
+
+- (id)init {
+  return [self initWithLogger:[NIOverviewLogger sharedLogger]];
+}
+
+- (void)writeDeviceSamplesWithWriter:(NIOverviewTraceWriter *)writer {
+  NSUInteger numberOfSamples = [_logger numberOfDeviceSamples];
+  for (NSUInteger ix = 0; ix < numberOfSamples && !writer->failed; ++ix) {
+    NIOverviewDeviceSample sample = [_logger deviceSampleAtIndex:ix];
+    double ts = NIOverviewTraceTimestamp(sample.timestamp);
+
+    NIOverviewTraceWriterBeginEvent(writer);
+    NIOverviewTraceWriterWriteFormat(writer,
+        "{\"name\":\"Memory\",\"ph\":\"C\",\"ts\":%.0f,\"pid\":1,\"tid\":1,"
+        "\"args\":{\"free\":%llu,\"total\":%llu}}",
+        ts, sample.bytesOfFreeMemory, sample.bytesOfTotalMemory);
+
+    NIOverviewTraceWriterBeginEvent(writer);
+    NIOverviewTraceWriterWriteFormat(writer,
+        "{\"name\":\"Disk\",\"ph\":\"C\",\"ts\":%.0f,\"pid\":1,\"tid\":1,"
+        "\"args\":{\"free\":%llu,\"total\":%llu}}",
+        ts, sample.bytesOfFreeDiskSpace, sample.bytesOfTotalDiskSpace);
+
+    NIOverviewTraceWriterBeginEvent(writer);
+    NIOverviewTraceWriterWriteFormat(writer,
+        "{\"name\":\"CPU\",\"ph\":\"C\",\"ts\":%.0f,\"pid\":1,\"tid\":1,"
+        "\"args\":{\"process\":%.3f}}",
+        ts, (double)sample.processCPUUsage);
+
+    NIOverviewTraceWriterBeginEvent(writer);
+    NIOverviewTraceWriterWriteFormat(writer,
+        "{\"name\":\"Battery\",\"ph\":\"C\",\"ts\":%.0f,\"pid\":1,\"tid\":1,"
+        "\"args\":{\"level\":%.2f}}",
+        ts, (double)sample.batteryLevel);
+  }
+}
+
+- (void)writeFrameSamplesWithWriter:(NIOverviewTraceWriter *)writer {
+  NSUInteger numberOfSamples = [_logger numberOfFrameSamples];
+  for (NSUInteger ix = 0; ix < numberOfSamples && !writer->failed; ++ix) {
+    NIOverviewFrameSample sample = [_logger frameSampleAtIndex:ix];
+    NIOverviewTraceWriterBeginEvent(writer);
+    NIOverviewTraceWriterWriteFormat(writer,
+        "{\"name\":\"Frame\",\"ph\":\"X\",\"ts\":%.0f,\"dur\":%.0f,\"pid\":1,\"tid\":1}",
+        NIOverviewTraceTimestamp(sample.timestamp - sample.duration),
+        NIOverviewTraceTimestamp(sample.duration));
+  }
+}
+
+- (void)writeEventSamplesWithWriter:(NIOverviewTraceWriter *)writer {
+  NSUInteger numberOfSamples = [_logger numberOfEventSamples];
+  for (NSUInteger ix = 0; ix < numberOfSamples && !writer->failed; ++ix) {
+    NIOverviewEventSample sample = [_logger eventSampleAtIndex:ix];
+    NIOverviewTraceWriterBeginEvent(writer);
+    NIOverviewTraceWriterWriteFormat(writer,
+        "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.0f,\"pid\":1,\"tid\":1}",
+        NIOverviewTraceNameOfEventType(sample.type),
+        NIOverviewTraceTimestamp(sample.timestamp));
+  }
+}
+
+- (void)writeStallSamplesWithWriter:(NIOverviewTraceWriter *)writer {
+  NSUInteger numberOfSamples = [_logger numberOfStallSamples];
+  for (NSUInteger ix = 0; ix < numberOfSamples && !writer->failed; ++ix) {
+    NIOverviewStallSample sample = [_logger stallSampleAtIndex:ix];
+    NIOverviewTraceWriterBeginEvent(writer);
+    NIOverviewTraceWriterWriteFormat(writer,
+        "{\"name\":\"Main thread stall\",\"ph\":\"X\",\"ts\":%.0f,\"dur\":%.0f,"
+        "\"pid\":1,\"tid\":1,\"args\":{\"stack\":[",
+        NIOverviewTraceTimestamp(sample.timestamp),
+        NIOverviewTraceTimestamp(sample.duration));
+    for (NSUInteger frameIndex = 0; frameIndex < sample.numberOfFrames; ++frameIndex) {
+      if (frameIndex > 0) {
+        NIOverviewTraceWriterWriteByte(writer, ',');
+      }
+      NIOverviewTraceWriterWriteString(writer,
+                                       NIOverviewStringFromStackFrame(sample.frames[frameIndex]));
+    }
+    NIOverviewTraceWriterWriteFormat(writer, "]}}");
+  }
+}
+
+- (void)writeMemoryCacheStatisticsWithWriter:(NIOverviewTraceWriter *)writer {
+  double ts = NIOverviewTraceTimestamp(CACurrentMediaTime());
+  for (NIMemoryCache* cache in self.memoryCaches) {
+    NIMemoryCacheStatistics* statistics = [cache statistics];
+    NIOverviewTraceWriterBeginEvent(writer);
+    NIOverviewTraceWriterWriteFormat(writer, "{\"name\":");
+    NIOverviewTraceWriterWriteString(writer, NSStringFromClass([cache class]));
+    NIOverviewTraceWriterWriteFormat(writer,
+        ",\"ph\":\"C\",\"ts\":%.0f,\"pid\":1,\"tid\":1,\"args\":{\"objects\":%lu,"
+        "\"hits\":%llu,\"misses\":%llu,\"evictions\":%llu,\"bytesEvicted\":%llu}}",
+        ts, (unsigned long)[cache count],
+        statistics.numberOfHits, statistics.numberOfMisses,
+        statistics.numberOfEvictions, statistics.numberOfBytesEvicted);
+  }
+}
+
+// Writes the profile in the trace format's stackFrames and samples sections. Stack frames form
+// a tree, so each distinct call path is written once and samples refer to its innermost frame.
+- (void)writeProfileWithWriter:(NIOverviewTraceWriter *)writer {
+  NIOverviewProfile* profile = self.profile;
+  NSUInteger numberOfSamples = [profile numberOfSamples];
+
+  // Frame identifiers start at 1. Each entry maps the functions called from that frame to the
+  // identifiers of their frames; entry 0 is the root.
+  NSMutableArray* childrenOfFrames =
+      [NSMutableArray arrayWithObject:[NSMutableDictionary dictionary]];
+  NSMutableData* leafFrames = [NSMutableData dataWithLength:numberOfSamples * sizeof(NSUInteger)];
+  NSUInteger* leaves = leafFrames.mutableBytes;
+
+  NIOverviewTraceWriterWriteFormat(writer, "\n],\"stackFrames\":{");
+  writer->needsSeparator = NO;
+  for (NSUInteger ix = 0; ix < numberOfSamples && !writer->failed; ++ix) {
+    const uintptr_t* frames = [profile framesOfSampleAtIndex:ix];
+    NSUInteger parent = 0;
+    for (NSUInteger frameIndex = [profile numberOfFramesInSampleAtIndex:ix]; frameIndex > 0;
+         --frameIndex) {
+      uintptr_t address = [profile functionAddressOfFrame:frames[frameIndex - 1]];
+      NSMutableDictionary* children = childrenOfFrames[parent];
+      NSNumber* identifier = [children objectForKey:@(address)];
+      if (nil == identifier) {
+        identifier = @(childrenOfFrames.count);
+        [children setObject:identifier forKey:@(address)];
+        [childrenOfFrames addObject:[NSMutableDictionary dictionary]];
+
+        NIOverviewTraceWriterBeginEvent(writer);
+        NIOverviewTraceWriterWriteFormat(writer, "\"%lu\":{\"name\":",
+                                         [identifier unsignedLongValue]);
+        NIOverviewTraceWriterWriteString(writer, [profile nameOfFunctionAtAddress:address]);
+        if (0 != parent) {
+          NIOverviewTraceWriterWriteFormat(writer, ",\"parent\":\"%lu\"", (unsigned long)parent);
+        }
+        NIOverviewTraceWriterWriteByte(writer, '}');
+      }
+      parent = [identifier unsignedIntegerValue];
+    }
+    leaves[ix] = parent;
+  }
+
+  NIOverviewTraceWriterWriteFormat(writer, "},\"samples\":[\n");
+  writer->needsSeparator = NO;
+  unsigned long weight = (unsigned long)MAX(1.0, round(profile.samplingInterval * 1000000.0));
+  for (NSUInteger ix = 0; ix < numberOfSamples && !writer->failed; ++ix) {
+    if (0 == leaves[ix]) {
+      continue;
+    }
+    NIOverviewTraceWriterBeginEvent(writer);
+    NIOverviewTraceWriterWriteFormat(writer,
+        "{\"name\":\"Main thread\",\"cpu\":0,\"tid\":1,\"ts\":%.0f,"
+        "\"sf\":\"%lu\",\"weight\":%lu}",
+        NIOverviewTraceTimestamp([profile timestampOfSampleAtIndex:ix]),
+        (unsigned long)leaves[ix], weight);
+  }
+}
+
+- (BOOL)writeTraceToPath:(NSString *)path error:(NSError **)error {
+  NIDASSERT([NSThread isMainThread]);
+
+  NSOutputStream* stream = [NSOutputStream outputStreamToFileAtPath:path append:NO];
+  [stream open];
+
+  NIOverviewTraceWriter writer;
+  memset(&writer, 0, sizeof(writer));
+  writer.stream = stream;
+  writer.buffer = malloc(kTraceWriterBufferSize);
+  writer.failed = (NSStreamStatusOpen != [stream streamStatus]);
+
+  NSString* processName = [[NSProcessInfo processInfo] processName];
+  NIOverviewTraceWriterWriteFormat(&writer, "{\"traceEvents\":[\n");
+  NIOverviewTraceWriterBeginEvent(&writer);
+  NIOverviewTraceWriterWriteFormat(&writer,
+      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":");
+  NIOverviewTraceWriterWriteString(&writer, processName);
+  NIOverviewTraceWriterWriteFormat(&writer, "}}");
+
+  [self writeDeviceSamplesWithWriter:&writer];
+  [self writeFrameSamplesWithWriter:&writer];
+  [self writeEventSamplesWithWriter:&writer];
+  [self writeStallSamplesWithWriter:&writer];
+  [self writeMemoryCacheStatisticsWithWriter:&writer];
+  if ([self.profile numberOfSamples] > 0) {
+    // Closes traceEvents and leaves the samples array open.
+    [self writeProfileWithWriter:&writer];
+  }
+
+  NIOverviewTraceWriterWriteFormat(&writer, "\n],\"displayTimeUnit\":\"ms\"}\n");
+  NIOverviewTraceWriterFlush(&writer);
+  free(writer.buffer);
+
+  NSError* streamError = [stream streamError];
+  [stream close];
+
+  if (writer.failed) {
+    if (nil != error) {
+      *error = (nil != streamError
+                ? streamError
+                : [NSError errorWithDomain:NSCocoaErrorDomain
+                                      code:NSFileWriteUnknownError
+                                  userInfo:@{NSFilePathErrorKey: path}]);
+    }
+    return NO;
+  }
+  return YES;
+}
+
+@end
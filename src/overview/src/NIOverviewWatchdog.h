@@ -0,0 +1,96 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <mach/mach.h>
+
+/**
+ * A watchdog that records main thread stalls in the Overview logger.
+ *
+ * @ingroup Overview-Sensors
+ *
+ * Once started, a background thread pings the main run loop every stallThreshold seconds. When
+ * a ping goes unanswered for longer than stallThreshold the watchdog suspends the main thread
+ * just long enough to walk its frame pointers, then waits for the ping to be answered. The
+ * stall's duration and stack are added to the logger as an NIOverviewStallSample and an
+ * NIOverviewEventStall event, and are shown on the Overview's stall page.
+ *
+ * The watchdog is opt-in. Start it after calling
+ * [NIOverview @link NIOverview::applicationDidFinishLaunching applicationDidFinishLaunching@endlink]:
+ *
+ * @code
+ * [[NIOverviewWatchdog sharedWatchdog] start];
+ * @endcode
+ *
+ * Stalls are measured from the moment the unanswered ping was sent, so a stall may have begun
+ * up to stallThreshold seconds earlier than recorded.
+ */
+@interface NIOverviewWatchdog : NSObject
+
+/**
+ * Returns the shared watchdog.
+ */
++ (NIOverviewWatchdog *)sharedWatchdog;
+
+/**
+ * Pings that go unanswered for longer than this many seconds are recorded as stalls.
+ *
+ * By default this is 0.25 seconds.
+ */
+@property (atomic, assign) NSTimeInterval stallThreshold;
+
+/**
+ * Whether the watchdog thread is running.
+ */
+@property (nonatomic, readonly, getter=isRunning) BOOL running;
+
+/**
+ * Starts the watchdog thread. Does nothing if the watchdog is already running.
+ *
+ * Must be called from the main thread.
+ */
+- (void)start;
+
+/**
+ * Stops the watchdog thread after its current ping completes.
+ */
+- (void)stop;
+
+@end
+
+/**
+ * Returns a human-readable description of a captured stack frame.
+ *
+ * @ingroup Overview-Sensors
+ *
+ * The frame is symbolicated with dladdr as "symbol + offset". Frames that can't be symbolicated
+ * are formatted as hexadecimal addresses.
+ */
+NSString* NIOverviewStringFromStackFrame(uintptr_t frame);
+
+/**
+ * Captures the return addresses of a thread by walking its frame pointers.
+ *
+ * @ingroup Overview-Sensors
+ *
+ * The thread is suspended while its stack is walked, so this must not be called from the thread
+ * itself. Frames are written innermost first, starting with the thread's program counter.
+ *
+ *      @returns The number of frames that were written to frames.
+ */
+NSUInteger NIOverviewBacktraceOfThread(thread_t thread, uintptr_t* frames,
+                                       NSUInteger maxNumberOfFrames);
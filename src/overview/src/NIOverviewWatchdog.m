@@ -0,0 +1,252 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIOverviewWatchdog.h"
+
+#import "NIOverview.h"
+#import "NIOverviewLogger.h"
+#import "NimbusCore.h"
+
+#import <QuartzCore/QuartzCore.h>
+#import <dlfcn.h>
+#import <mach/mach.h>
+#import <pthread.h>
+#if __has_feature(ptrauth_calls)
+#import <ptrauth.h>
+#endif
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+NSString* NIOverviewStringFromStackFrame(uintptr_t frame) {
+  Dl_info info;
+  if (0 != dladdr((const void *)frame, &info) && NULL != info.dli_sname) {
+    return [NSString stringWithFormat:@"%s + %lu",
+            info.dli_sname, (unsigned long)(frame - (uintptr_t)info.dli_saddr)];
+  }
+  return [NSString stringWithFormat:@"0x%lx", (unsigned long)frame];
+}
+
+// Reads memory that may not be mapped without faulting.
+static BOOL NIOverviewCopyMemory(uintptr_t address, void* destination, size_t length) {
+  vm_size_t bytesCopied = 0;
+  kern_return_t result = vm_read_overwrite(mach_task_self(), (vm_address_t)address,
+                                           (vm_size_t)length, (vm_address_t)destination,
+                                           &bytesCopied);
+  return KERN_SUCCESS == result && bytesCopied == length;
+}
+
+static uintptr_t NIOverviewStripPointer(uintptr_t pointer) {
+#if __has_feature(ptrauth_calls)
+  return (uintptr_t)ptrauth_strip((void *)pointer, ptrauth_key_return_address);
+#else
+  return pointer;
+#endif
+}
+
+// Fetches the program counter and frame pointer of a suspended thread.
+static BOOL NIOverviewGetThreadRegisters(thread_t thread, uintptr_t* pc, uintptr_t* fp) {
+#if defined(__arm64__)
+  arm_thread_state64_t state;
+  mach_msg_type_number_t count = ARM_THREAD_STATE64_COUNT;
+  if (KERN_SUCCESS != thread_get_state(thread, ARM_THREAD_STATE64,
+                                       (thread_state_t)&state, &count)) {
+    return NO;
+  }
+  *pc = (uintptr_t)arm_thread_state64_get_pc(state);
+  *fp = (uintptr_t)arm_thread_state64_get_fp(state);
+  return YES;
+
+#elif defined(__arm__)
+  arm_thread_state_t state;
+  mach_msg_type_number_t count = ARM_THREAD_STATE_COUNT;
+  if (KERN_SUCCESS != thread_get_state(thread, ARM_THREAD_STATE,
+                                       (thread_state_t)&state, &count)) {
+    return NO;
+  }
+  *pc = state.__pc;
+  *fp = state.__r[7];
+  return YES;
+
+#elif defined(__x86_64__)
+  x86_thread_state64_t state;
+  mach_msg_type_number_t count = x86_THREAD_STATE64_COUNT;
+  if (KERN_SUCCESS != thread_get_state(thread, x86_THREAD_STATE64,
+                                       (thread_state_t)&state, &count)) {
+    return NO;
+  }
+  *pc = (uintptr_t)state.__rip;
+  *fp = (uintptr_t)state.__rbp;
+  return YES;
+
+#elif defined(__i386__)
+  i386_thread_state_t state;
+  mach_msg_type_number_t count = i386_THREAD_STATE_COUNT;
+  if (KERN_SUCCESS != thread_get_state(thread, i386_THREAD_STATE,
+                                       (thread_state_t)&state, &count)) {
+    return NO;
+  }
+  *pc = state.__eip;
+  *fp = state.__ebp;
+  return YES;
+
+#else
+  return NO;
+#endif
+}
+
+// The thread is suspended for the duration of the walk, so nothing in here may allocate or take
+// a lock that the thread might be holding.
+NSUInteger NIOverviewBacktraceOfThread(thread_t thread, uintptr_t* frames,
+                                       NSUInteger maxNumberOfFrames) {
+  if (KERN_SUCCESS != thread_suspend(thread)) {
+    return 0;
+  }
+
+  NSUInteger numberOfFrames = 0;
+  uintptr_t pc = 0;
+  uintptr_t fp = 0;
+  if (NIOverviewGetThreadRegisters(thread, &pc, &fp)) {
+    frames[numberOfFrames++] = NIOverviewStripPointer(pc);
+
+    // Each frame begins with the caller's frame pointer followed by the return address.
+    uintptr_t frame[2];
+    while (numberOfFrames < maxNumberOfFrames && 0 != fp
+           && NIOverviewCopyMemory(fp, frame, sizeof(frame))) {
+      uintptr_t returnAddress = NIOverviewStripPointer(frame[1]);
+      if (0 == returnAddress) {
+        break;
+      }
+      frames[numberOfFrames++] = returnAddress;
+
+      // Stacks grow down, so a caller's frame must be above its callee's.
+      if (frame[0] <= fp) {
+        break;
+      }
+      fp = frame[0];
+    }
+  }
+
+  thread_resume(thread);
+  return numberOfFrames;
+}
+
+@implementation NIOverviewWatchdog {
+  NSThread* _thread;
+  thread_t _mainThread;
+
+  // Bumped by every start and stop, so that a thread left over from an earlier start that hasn't
+  // noticed it was cancelled yet neither records stalls nor keeps running alongside a new one.
+  NSUInteger _generation;
+}
+
++ (NIOverviewWatchdog *)sharedWatchdog {
+  static dispatch_once_t pred = 0;
+  static NIOverviewWatchdog* instance = nil;
+
+  dispatch_once(&pred, ^{
+    instance = [[NIOverviewWatchdog alloc] init];
+  });
+
+  return instance;
+}
+
+- (id)init {
+  if ((self = [super init])) {
+    _stallThreshold = 0.25;
+  }
+  return self;
+}
+
+- (BOOL)isRunning {
+  return nil != _thread;
+}
+
+- (void)start {
+  NIDASSERT([NSThread isMainThread]);
+  if (nil != _thread) {
+    return;
+  }
+  _mainThread = pthread_mach_thread_np(pthread_self());
+
+  NSUInteger generation = 0;
+  @synchronized(self) {
+    generation = ++_generation;
+  }
+  _thread = [[NSThread alloc] initWithTarget:self
+                                    selector:@selector(watchdogThreadMain:)
+                                      object:[NSNumber numberWithUnsignedInteger:generation]];
+  _thread.name = @"com.nimbuskit.overview.watchdog";
+  [_thread start];
+}
+
+- (void)stop {
+  @synchronized(self) {
+    ++_generation;
+  }
+  [_thread cancel];
+  _thread = nil;
+}
+
+- (BOOL)isCurrentGeneration:(NSUInteger)generation {
+  @synchronized(self) {
+    return generation == _generation;
+  }
+}
+
+- (void)watchdogThreadMain:(NSNumber *)generationNumber {
+  NSUInteger generation = [generationNumber unsignedIntegerValue];
+  while ([self isCurrentGeneration:generation]) {
+    @autoreleasepool {
+      NSTimeInterval threshold = self.stallThreshold;
+      dispatch_semaphore_t pong = dispatch_semaphore_create(0);
+      CFTimeInterval pingTime = CACurrentMediaTime();
+      dispatch_async(dispatch_get_main_queue(), ^{
+        dispatch_semaphore_signal(pong);
+      });
+
+      dispatch_time_t timeout = dispatch_time(DISPATCH_TIME_NOW,
+                                              (int64_t)(threshold * NSEC_PER_SEC));
+      if (0 != dispatch_semaphore_wait(pong, timeout)) {
+        NIOverviewStallSample sample;
+        sample.timestamp = pingTime;
+        sample.numberOfFrames =
+            NIOverviewBacktraceOfThread(_mainThread, sample.frames,
+                                        NIOverviewStallSampleMaximumNumberOfFrames);
+
+        // The stall lasts until the main thread gets around to answering.
+        dispatch_semaphore_wait(pong, DISPATCH_TIME_FOREVER);
+        sample.duration = CACurrentMediaTime() - pingTime;
+        if (![self isCurrentGeneration:generation]) {
+          break;
+        }
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+          NIOverviewLogger* logger = [NIOverview logger];
+          [logger addStallSample:sample];
+          NIOverviewEventSample event = { sample.timestamp, NIOverviewEventStall };
+          [logger addEventSample:event];
+        });
+      }
+
+      [NSThread sleepForTimeInterval:threshold];
+    }
+  }
+}
+
+@end
@@ -19,15 +19,404 @@
 #import <XCTest/XCTest.h>
 
 #import "NimbusOverview.h"
+#import "NIDeviceInfo.h"
+#import "NIOverviewAllocationTracker.h"
+#import "NIOverviewConsoleCapture.h"
+#import "NIOverviewLayerInspector.h"
+#import "NIOverviewLogger.h"
+#import "NIOverviewProfiler.h"
+#import "NIOverviewStreamer.h"
+#import "NIOverviewStreamer+Private.h"
+#import "NIOverviewTraceExporter.h"
+#import "NIOverviewWatchdog.h"
+#import <QuartzCore/QuartzCore.h>
+#import <fcntl.h>
+#import <libkern/OSByteOrder.h>
 
 @interface NIOverviewTests : XCTestCase
 @end
 
+@interface NIOverviewTrackedTestObject : NSObject
+@end
+
+@implementation NIOverviewTrackedTestObject
+@end
+
+@interface NIOverviewTrackedTestSubclassObject : NIOverviewTrackedTestObject
+@end
+
+@implementation NIOverviewTrackedTestSubclassObject
+@end
+
+@interface NIOverviewNestedTrackedTestObject : NSObject
+@end
+
+@implementation NIOverviewNestedTrackedTestObject
+@end
+
+@interface NIOverviewNestedTrackedTestSubclassObject : NIOverviewNestedTrackedTestObject
+@end
+
+@implementation NIOverviewNestedTrackedTestSubclassObject
+@end
+
+
+@implementation NIOverviewTests {
+  NSTimeInterval _stallThreshold;
+}
+
+- (void)setUp {
+  [super setUp];
+
+  _stallThreshold = [NIOverviewWatchdog sharedWatchdog].stallThreshold;
+}
+
+- (void)tearDown {
+  // The watchdog is shared, so it mustn't carry one test's settings into the next.
+  NIOverviewWatchdog* watchdog = [NIOverviewWatchdog sharedWatchdog];
+  [watchdog stop];
+  watchdog.stallThreshold = _stallThreshold;
 
-@implementation NIOverviewTests
+  [super tearDown];
+}
 
 
 - (void)testNothing {
 }
 
+- (void)testDeviceSamplesArePrunedByAge {
+  NIOverviewLogger* logger = [[NIOverviewLogger alloc] init];
+  logger.oldestLogAge = 10;
+
+  NIOverviewDeviceSample sample = {0};
+  sample.timestamp = CACurrentMediaTime() - 20;
+  sample.bytesOfFreeMemory = 1;
+  [logger addDeviceSample:sample];
+
+  sample.timestamp = CACurrentMediaTime();
+  sample.bytesOfFreeMemory = 2;
+  [logger addDeviceSample:sample];
+
+  XCTAssertEqual([logger numberOfDeviceSamples], (NSUInteger)1);
+  XCTAssertEqual([logger deviceSampleAtIndex:0].bytesOfFreeMemory, 2ULL);
+}
+
+- (void)testHeartbeatKeepsSamplingWhileTracking {
+  NIOverviewLogger* logger = [[NIOverviewLogger alloc] init];
+  NSUInteger numberOfSamples = [logger numberOfDeviceSamples];
+
+  // An NSTimer on the default run loop mode would never fire here.
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:3];
+  while ([logger numberOfDeviceSamples] == numberOfSamples
+         && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop mainRunLoop] runMode:UITrackingRunLoopMode
+                          beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+  }
+
+  XCTAssertGreaterThan([logger numberOfDeviceSamples], numberOfSamples);
+  NIOverviewDeviceSample sample = [logger deviceSampleAtIndex:[logger numberOfDeviceSamples] - 1];
+  XCTAssertGreaterThan(sample.bytesOfTotalMemory, 0ULL);
+}
+
+- (void)testConsoleCaptureBatchesLogsToFileAndLogger {
+  NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:
+                    [[NSProcessInfo processInfo] globallyUniqueString]];
+  int fileDescriptor = open([path fileSystemRepresentation], O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  XCTAssertTrue(fileDescriptor >= 0);
+
+  NIOverviewLogger* logger = [[NIOverviewLogger alloc] init];
+  NIOverviewConsoleCapture* capture =
+      [[NIOverviewConsoleCapture alloc] initWithLogger:logger fileDescriptor:fileDescriptor];
+
+  // Lines are captured whatever their length.
+  NSString* longLine = [@"" stringByPaddingToLength:1000 withString:@"x" startingAtIndex:0];
+  [capture captureBytes:"first" length:5];
+  [capture captureBytes:[longLine UTF8String] length:longLine.length];
+  [capture flush];
+
+  NSString* output = [NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding
+                                                  error:nil];
+  XCTAssertTrue([output rangeOfString:@": first\n"].location != NSNotFound);
+  XCTAssertTrue([output hasSuffix:[NSString stringWithFormat:@": %@\n", longLine]]);
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  while ([logger numberOfConsoleSamples] < 2 && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertEqual([logger numberOfConsoleSamples], (NSUInteger)2);
+  XCTAssertEqualObjects([logger consoleSampleAtIndex:0].log, @"first");
+  XCTAssertEqualObjects([logger consoleSampleAtIndex:1].log, longLine);
+
+  capture = nil;
+  close(fileDescriptor);
+  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (void)testConsoleCaptureDropsAndReportsLinesInsteadOfWaiting {
+  NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:
+                    [[NSProcessInfo processInfo] globallyUniqueString]];
+  int fileDescriptor = open([path fileSystemRepresentation], O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  XCTAssertTrue(fileDescriptor >= 0);
+
+  NIOverviewConsoleCapture* capture =
+      [[NIOverviewConsoleCapture alloc] initWithLogger:nil fileDescriptor:fileDescriptor];
+
+  // Far more lines than the queue holds, from several threads at once.
+  const NSUInteger numberOfThreads = 4;
+  const NSUInteger numberOfLinesPerThread = 5000;
+  dispatch_apply(numberOfThreads, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t ix) {
+    for (NSUInteger line = 0; line < numberOfLinesPerThread; ++line) {
+      [capture captureBytes:"line" length:4];
+    }
+  });
+  [capture flush];
+
+  NSString* output = [NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding
+                                                  error:nil];
+  NSUInteger numberOfWrittenLines = 0;
+  NSUInteger numberOfDroppedLines = 0;
+  for (NSString* line in [output componentsSeparatedByString:@"\n"]) {
+    if ([line hasSuffix:@": line"]) {
+      ++numberOfWrittenLines;
+    } else if ([line hasSuffix:@" console lines dropped"]) {
+      NSString* report = [line substringFromIndex:[line rangeOfString:@"[Nimbus] "].location + 9];
+      numberOfDroppedLines += (NSUInteger)[report integerValue];
+    }
+  }
+  XCTAssertEqual(numberOfWrittenLines + numberOfDroppedLines, numberOfThreads * numberOfLinesPerThread,
+                 @"Every line should either be written or counted as dropped.");
+
+  capture = nil;
+  close(fileDescriptor);
+  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (void)testTraceExportIsValidJSON {
+  NIOverviewLogger* logger = [[NIOverviewLogger alloc] init];
+  NIOverviewDeviceSample deviceSample = {0};
+  deviceSample.timestamp = CACurrentMediaTime();
+  [logger addDeviceSample:deviceSample];
+  NIOverviewFrameSample frameSample = { CACurrentMediaTime(), 1.0 / 60.0 };
+  [logger addFrameSample:frameSample];
+  NIOverviewStallSample stallSample = {0};
+  stallSample.timestamp = CACurrentMediaTime();
+  stallSample.duration = 0.5;
+  stallSample.numberOfFrames = 1;
+  stallSample.frames[0] = (uintptr_t)&NIOverviewStringFromStackFrame;
+  [logger addStallSample:stallSample];
+
+  NIOverviewTraceExporter* exporter = [[NIOverviewTraceExporter alloc] initWithLogger:logger];
+  exporter.memoryCaches = @[[[NIMemoryCache alloc] init]];
+  NSString* path = NIPathForCachesResource(@"NIOverviewTestTrace.json");
+  NSError* error = nil;
+  XCTAssertTrue([exporter writeTraceToPath:path error:&error], @"%@", error);
+
+  NSDictionary* trace = [NSJSONSerialization JSONObjectWithData:[NSData dataWithContentsOfFile:path]
+                                                        options:0
+                                                          error:&error];
+  XCTAssertNotNil(trace, @"%@", error);
+  // Process name, four device counters, a frame, a stall, and a cache snapshot.
+  XCTAssertEqual([trace[@"traceEvents"] count], (NSUInteger)8);
+
+  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (void)testThreadCPUUsageIncludesMainThread {
+  XCTAssertTrue([NIDeviceInfo beginCachedDeviceInfo]);
+  NSUInteger numberOfThreads = [NIDeviceInfo numberOfThreads];
+  CGFloat totalUsage = 0;
+  for (NSUInteger ix = 0; ix < numberOfThreads; ++ix) {
+    totalUsage += [NIDeviceInfo CPUUsageOfThreadAtIndex:ix].CPUUsage;
+  }
+  CGFloat processUsage = [NIDeviceInfo processCPUUsage];
+  [NIDeviceInfo endCachedDeviceInfo];
+
+  XCTAssertGreaterThan(numberOfThreads, (NSUInteger)0);
+  XCTAssertEqualWithAccuracy(totalUsage, processUsage, 0.001);
+}
+
+- (void)testWatchdogRecordsMainThreadStalls {
+  NIOverviewLogger* logger = [NIOverview logger];
+  NSUInteger numberOfStalls = [logger numberOfStallSamples];
+
+  NIOverviewWatchdog* watchdog = [NIOverviewWatchdog sharedWatchdog];
+  watchdog.stallThreshold = 0.05;
+  [watchdog start];
+
+  // Block the main thread for several thresholds.
+  [NSThread sleepForTimeInterval:0.3];
+
+  NSDate* deadline = [NSDate dateWithTimeIntervalSinceNow:2];
+  while ([logger numberOfStallSamples] == numberOfStalls && [deadline timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  [watchdog stop];
+
+  XCTAssertGreaterThan([logger numberOfStallSamples], numberOfStalls);
+  NIOverviewStallSample stall = [logger stallSampleAtIndex:[logger numberOfStallSamples] - 1];
+  XCTAssertGreaterThanOrEqual(stall.duration, 0.05);
+  XCTAssertGreaterThan(stall.numberOfFrames, (NSUInteger)0);
+}
+
+- (void)testProfilerSamplesMainThreadAndExportsStacks {
+  NIOverviewProfiler* profiler = [[NIOverviewProfiler alloc] init];
+  [profiler startRecording];
+  XCTAssertTrue([profiler isRecording]);
+
+  // Keep the main thread busy so that every sample has a stack.
+  NSDate* deadline = [NSDate dateWithTimeIntervalSinceNow:0.2];
+  while ([deadline timeIntervalSinceNow] > 0) {}
+  [profiler stopRecording];
+  XCTAssertFalse([profiler isRecording]);
+
+  // Let the sampler thread notice that it was cancelled.
+  [NSThread sleepForTimeInterval:0.05];
+
+  NIOverviewProfile* profile = profiler.profile;
+  NSUInteger numberOfSamples = [profile numberOfSamples];
+  XCTAssertGreaterThan(numberOfSamples, (NSUInteger)10);
+  XCTAssertEqual([profile callTree].numberOfSamples, numberOfSamples);
+
+  NIOverviewProfileFunction* topFunction = [[profile topFunctionsWithLimit:1] firstObject];
+  XCTAssertNotNil(topFunction.name);
+  XCTAssertGreaterThan(topFunction.numberOfSelfSamples, (NSUInteger)0);
+  XCTAssertLessThanOrEqual(topFunction.numberOfTotalSamples, numberOfSamples);
+
+  NIOverviewTraceExporter* exporter =
+      [[NIOverviewTraceExporter alloc] initWithLogger:[[NIOverviewLogger alloc] init]];
+  exporter.profile = profile;
+  NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"profile.json"];
+  XCTAssertTrue([exporter writeTraceToPath:path error:nil]);
+
+  NSDictionary* trace = [NSJSONSerialization JSONObjectWithData:[NSData dataWithContentsOfFile:path]
+                                                        options:0
+                                                          error:nil];
+  XCTAssertGreaterThan([trace[@"stackFrames"] count], (NSUInteger)0);
+  XCTAssertEqual([trace[@"samples"] count], numberOfSamples);
+  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (void)testLayerInspectorFlagsCompositingCosts {
+  CALayer* root = [CALayer layer];
+  root.bounds = CGRectMake(0, 0, 320, 480);
+  root.backgroundColor = [UIColor whiteColor].CGColor;
+
+  CALayer* roundedLayer = [CALayer layer];
+  roundedLayer.frame = CGRectMake(0, 0, 100, 100);
+  roundedLayer.cornerRadius = 8;
+  roundedLayer.masksToBounds = YES;
+  [roundedLayer addSublayer:[CALayer layer]];
+  [root addSublayer:roundedLayer];
+
+  CALayer* shadowLayer = [CALayer layer];
+  shadowLayer.frame = CGRectMake(0, 100, 100, 100);
+  shadowLayer.shadowOpacity = 0.5f;
+  [root addSublayer:shadowLayer];
+
+  CALayer* translucentLayer = [CALayer layer];
+  translucentLayer.frame = CGRectMake(100, 0, 100, 100);
+  translucentLayer.backgroundColor = [UIColor colorWithWhite:0 alpha:0.5f].CGColor;
+  [root addSublayer:translucentLayer];
+
+  // An opaque image with far more pixels than the layer shows.
+  UIGraphicsBeginImageContextWithOptions(CGSizeMake(400, 400), YES, 1);
+  UIImage* image = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  CALayer* imageLayer = [CALayer layer];
+  imageLayer.frame = CGRectMake(100, 100, 50, 50);
+  imageLayer.contents = (__bridge id)image.CGImage;
+  [root addSublayer:imageLayer];
+
+  CALayer* hiddenLayer = [CALayer layer];
+  hiddenLayer.frame = CGRectMake(200, 200, 100, 100);
+  hiddenLayer.shadowOpacity = 0.5f;
+  hiddenLayer.hidden = YES;
+  [root addSublayer:hiddenLayer];
+
+  NSArray* issues = [NIOverviewLayerInspector issuesInLayerTree:root excludingLayers:nil];
+  NSMutableDictionary* layersByType = [NSMutableDictionary dictionary];
+  for (NIOverviewLayerIssue* issue in issues) {
+    XCTAssertNotEqual(issue.layer, hiddenLayer);
+    [layersByType setObject:issue.layer forKey:@(issue.type)];
+  }
+  XCTAssertEqual(issues.count, (NSUInteger)4);
+  XCTAssertEqual(layersByType[@(NIOverviewLayerIssueOffscreenMask)], roundedLayer);
+  XCTAssertEqual(layersByType[@(NIOverviewLayerIssueShadowWithoutPath)], shadowLayer);
+  XCTAssertEqual(layersByType[@(NIOverviewLayerIssueBlending)], translucentLayer);
+  XCTAssertEqual(layersByType[@(NIOverviewLayerIssueMisscaledImage)], imageLayer);
+
+  shadowLayer.shadowPath = [UIBezierPath bezierPathWithRect:shadowLayer.bounds].CGPath;
+  issues = [NIOverviewLayerInspector issuesInLayerTree:root excludingLayers:
+            [NSSet setWithObjects:roundedLayer, translucentLayer, imageLayer, nil]];
+  XCTAssertEqual(issues.count, (NSUInteger)0);
+}
+
+- (void)testAllocationTrackerCountsLiveInstances {
+  NIOverviewAllocationTracker* tracker = [NIOverviewAllocationTracker sharedTracker];
+  Class cls = [NIOverviewTrackedTestObject class];
+  [tracker trackClass:cls];
+  XCTAssertTrue([tracker.trackedClasses containsObject:cls]);
+
+  @autoreleasepool {
+    NSArray* objects = @[[[NIOverviewTrackedTestObject alloc] init],
+                         [[NIOverviewTrackedTestSubclassObject alloc] init]];
+    XCTAssertEqual([tracker numberOfLiveInstancesOfClass:cls], (NSInteger)2,
+                   @"Subclasses should be counted with their tracked superclass.");
+    objects = nil;
+  }
+  XCTAssertEqual([tracker numberOfLiveInstancesOfClass:cls], (NSInteger)0);
+  XCTAssertEqual([tracker numberOfAllocationsOfClass:cls], 2ULL);
+  XCTAssertTrue([NIOverviewAllocationTracker numberOfMallocBytesInUse] > 0);
+}
+
+- (void)testAllocationTrackerCountsSubclassesTrackedBeforeTheirSuperclass {
+  NIOverviewAllocationTracker* tracker = [NIOverviewAllocationTracker sharedTracker];
+  Class superclass = [NIOverviewNestedTrackedTestObject class];
+  Class subclass = [NIOverviewNestedTrackedTestSubclassObject class];
+  [tracker trackClass:subclass];
+  [tracker trackClass:superclass];
+
+  @autoreleasepool {
+    id object = [[NIOverviewNestedTrackedTestSubclassObject alloc] init];
+    XCTAssertEqual([tracker numberOfLiveInstancesOfClass:subclass], (NSInteger)1);
+    XCTAssertEqual([tracker numberOfLiveInstancesOfClass:superclass], (NSInteger)1,
+                   @"The superclass should count the subclass even though it was tracked later.");
+    object = nil;
+  }
+  XCTAssertEqual([tracker numberOfLiveInstancesOfClass:subclass], (NSInteger)0);
+  XCTAssertEqual([tracker numberOfLiveInstancesOfClass:superclass], (NSInteger)0);
+  XCTAssertEqual([tracker numberOfAllocationsOfClass:superclass], 1ULL);
+}
+
+
+- (void)testStallRecordsFitTheirPayloadLength {
+  // A long, multi-byte symbol that has to be cut short.
+  NSString* symbol = [@"" stringByPaddingToLength:5000 withString:@"\u00e9" startingAtIndex:0];
+  NSMutableArray* frames = [NSMutableArray array];
+  for (NSUInteger ix = 0; ix < NIOverviewStallSampleMaximumNumberOfFrames; ++ix) {
+    [frames addObject:symbol];
+  }
+  NSMutableData* data = [NSMutableData data];
+  NIOverviewStreamAppendStallRecord(data, 1, 0.5, frames);
+
+  const uint8_t* bytes = data.bytes;
+  XCTAssertEqual(bytes[0], (uint8_t)NIOverviewStreamRecordStall);
+  uint16_t payloadLength = OSReadLittleInt16(bytes, 2);
+  XCTAssertEqual((NSUInteger)payloadLength + 4, data.length, @"The length should cover the whole record.");
+
+  NSUInteger offset = 4 + 8 + 4;
+  uint16_t numberOfFrames = OSReadLittleInt16(bytes, offset);
+  offset += 2;
+  XCTAssertEqual(numberOfFrames, (uint16_t)frames.count, @"Every frame should fit once cut short.");
+  for (uint16_t ix = 0; ix < numberOfFrames; ++ix) {
+    uint16_t length = OSReadLittleInt16(bytes, offset);
+    offset += 2;
+    XCTAssertTrue(length > 0 && length <= 1024);
+    NSString* frame = [[NSString alloc] initWithBytes:bytes + offset length:length encoding:NSUTF8StringEncoding];
+    XCTAssertNotNil(frame, @"Frames should not be cut in the middle of a character.");
+    offset += length;
+  }
+  XCTAssertEqual(offset, data.length, @"The frames should end with the record.");
+}
+
 @end
@@ -53,11 +53,15 @@ typedef enum {
 #pragma mark Data Source
 
 - (void)reloadData;
+- (void)reloadDataPreservingVisiblePages;
+- (void)insertPagesAtIndexes:(NSIndexSet *)indexes;
+- (void)deletePagesAtIndexes:(NSIndexSet *)indexes;
 @property (nonatomic, weak) id<NIPagingScrollViewDataSource> dataSource;
 @property (nonatomic, weak) id<NIPagingScrollViewDelegate> delegate;
 
 // It is highly recommended that you use this method to manage view recycling.
 - (UIView<NIPagingScrollViewPage> *)dequeueReusablePageWithIdentifier:(NSString *)identifier;
+@property (nonatomic, strong) NIViewRecycler* viewRecycler; // Default: a recycler of its own
 
 #pragma mark State
 
@@ -70,6 +74,12 @@ typedef enum {
 
 @property (nonatomic) CGFloat pageMargin;
 @property (nonatomic) NIPagingScrollViewType type; // Default: NIPagingScrollViewHorizontal
+@property (nonatomic) NSInteger numberOfPagesToPreload; // Default: 1
+
+#pragma mark Managing Memory
+
+@property (nonatomic) unsigned long long memoryBudget; // Default: 0 (unlimited)
+- (unsigned long long)estimatedMemoryCostOfPages;
 
 #pragma mark Visible Pages
 
@@ -86,6 +96,8 @@ typedef enum {
 
 - (void)willRotateToInterfaceOrientation:(UIInterfaceOrientation)toInterfaceOrientation duration:(NSTimeInterval)duration;
 - (void)willAnimateRotationToInterfaceOrientation:(UIInterfaceOrientation)toInterfaceOrientation duration:(NSTimeInterval)duration;
+- (void)didRotateFromInterfaceOrientation:(UIInterfaceOrientation)fromInterfaceOrientation;
+@property (nonatomic) BOOL usesSnapshotsDuringRotation; // Default: NO
 
 @end
 
@@ -149,6 +161,24 @@ typedef enum {
  */
 - (UIView<NIPagingScrollViewPage> *)pagingScrollView:(NIPagingScrollView *)pagingScrollView pageViewForIndex:(NSInteger)pageIndex;
 
+@optional
+
+#pragma mark Preparing Pages /** @name [NIPagingScrollViewDataSource] Preparing Pages */
+
+/**
+ * Prepares the content of a page that will soon be loaded, on a background queue.
+ *
+ * Use this to read, decode or lay out whatever pagingScrollView:pageViewForIndex: will need so
+ * that creating the page on the main thread is cheap. It is called for the preloaded pages and
+ * for the next page beyond them on either side, nearest to the center page first, and again for
+ * each page after reloadData.
+ *
+ * Calls are made one at a time on a serial queue. Do not use UIKit. The paging scroll view is
+ * not retained and may already have been deallocated, so only compare it with another paging
+ * scroll view; never message it.
+ */
+- (void)pagingScrollView:(NIPagingScrollView *)pagingScrollView prepareContentForPageAtIndex:(NSInteger)pageIndex;
+
 @end
 
 /**
@@ -189,6 +219,22 @@ typedef enum {
  */
 - (void)setFrameAndMaintainState:(CGRect)frame;
 
+/**
+ * The number of bytes that the page's content is holding on to, such as decoded images.
+ *
+ * Pages that don't implement this are treated as free.
+ */
+- (unsigned long long)estimatedMemoryCost;
+
+/**
+ * Called when the page is off-screen and the paging scroll view is over its memory budget.
+ *
+ * Release the expensive content and leave the page in a lightweight placeholder state. Before
+ * the page comes back next to the center page it is recycled and the data source is asked for
+ * it again. Pages that don't implement this are recycled instead.
+ */
+- (void)discardContent;
+
 @end
 
 /** @name Data Source */
@@ -215,6 +261,41 @@ typedef enum {
  * @fn NIPagingScrollView::reloadData
  */
 
+/**
+ * Updates the number of pages from the data source without reloading the visible pages.
+ *
+ * reloadData recycles every visible page and asks the data source for them again. When the
+ * pages that are already shown have not changed, for example when more pages have been appended
+ * to the end, this only asks the data source for the new number of pages and adjusts the content
+ * size. Visible pages that are now beyond the last page are recycled and the rest are kept as
+ * they are.
+ *
+ * If the pages have never been loaded this behaves like reloadData.
+ *
+ * @fn NIPagingScrollView::reloadDataPreservingVisiblePages
+ */
+
+/**
+ * Inserts pages at the given indexes, keeping the visible pages that are not affected.
+ *
+ * The indexes are those that the new pages have once they have been inserted, as with
+ * UITableView. The data source must already return the new number of pages. Visible pages after
+ * the inserted ones are moved along with their content, and the center page stays centered.
+ *
+ * @fn NIPagingScrollView::insertPagesAtIndexes:
+ */
+
+/**
+ * Deletes the pages at the given indexes, keeping the visible pages that are not affected.
+ *
+ * The indexes are those of the pages before they are deleted. The data source must already
+ * return the new number of pages. The deleted pages are recycled and the visible pages after
+ * them are moved back. If the center page is deleted, the page that followed it becomes the
+ * center page.
+ *
+ * @fn NIPagingScrollView::deletePagesAtIndexes:
+ */
+
 /**
  * Dequeues a reusable page from the set of recycled pages.
  *
@@ -224,6 +305,19 @@ typedef enum {
  * @fn NIPagingScrollView::dequeueReusablePageWithIdentifier:
  */
 
+/**
+ * The recycler that pages are recycled into and dequeued from.
+ *
+ * Paging scroll views that show the same kinds of pages can share NIViewRecycler::sharedRecycler,
+ * so that a newly pushed pager reuses the pages that the previous one built. When the pages
+ * are released, whether to meet the memoryBudget or because there is no data source, only the
+ * pages that this view recycled are removed from a shared recycler.
+ *
+ * Setting this to nil gives the view a new recycler of its own.
+ *
+ * @fn NIPagingScrollView::viewRecycler
+ */
+
 /**
  * The delegate for this paging view.
  *
@@ -234,6 +328,42 @@ typedef enum {
 
 /** @name Configuring Presentation */
 
+/**
+ * The number of pages on each side of the center page that are kept loaded.
+ *
+ * The pages next to the center page are loaded right after it is shown so that a swipe always
+ * reveals a page. Pages further away are created while the main run loop is idle, nearest
+ * first, so that turning a page finds the next one already built. Values below 1 behave like 1.
+ *
+ * While the user is turning pages quickly in one direction the window follows the motion: one
+ * more page is kept ahead and only the neighbor is kept behind.
+ *
+ * @fn NIPagingScrollView::numberOfPagesToPreload
+ */
+
+/** @name Managing Memory */
+
+/**
+ * The number of bytes that the pages, including recycled pages, may hold.
+ *
+ * Whenever the pages change, the cost of every page is added up from
+ * NIPagingScrollViewPage::estimatedMemoryCost. If that total is over the budget the recycled
+ * pages are released first, then the loaded pages furthest from the center page have their
+ * content discarded. The center page and its neighbors are never dropped, and preloading stops
+ * before a page that would take the pages over budget, assuming it costs as much as the center
+ * page.
+ *
+ * @fn NIPagingScrollView::memoryBudget
+ */
+
+/**
+ * Returns the sum of the estimated memory costs of the loaded and recycled pages.
+ *
+ * Pages whose content has been discarded are counted at their reduced cost.
+ *
+ * @fn NIPagingScrollView::estimatedMemoryCostOfPages
+ */
+
 /**
  * The number of pixels on either side of each page.
  *
@@ -362,6 +492,30 @@ typedef enum {
  * @fn NIPagingScrollView::willAnimateRotationToInterfaceOrientation:duration:
  */
 
+/**
+ * Lays out the pages for the new orientation once the rotation has finished.
+ *
+ * This must be called from the view controller's method by the same name when
+ * usesSnapshotsDuringRotation is enabled. It does nothing otherwise.
+ *
+ * @fn NIPagingScrollView::didRotateFromInterfaceOrientation:
+ */
+
+/**
+ * Whether snapshots of the visible pages are animated in place of the pages during rotation.
+ *
+ * Pages are normally laid out for the new orientation inside the rotation animation, which
+ * makes heavy pages such as zoomed photos and web views stutter. When this is enabled,
+ * willRotateToInterfaceOrientation:duration: replaces each visible page with a snapshot made
+ * by NISnapshotViewOfViewWithTransparency, the snapshots are animated to the new page frames,
+ * and the real pages are laid out once, in a single pass, by
+ * didRotateFromInterfaceOrientation:.
+ *
+ * By default this is NO.
+ *
+ * @fn NIPagingScrollView::usesSnapshotsDuringRotation
+ */
+
 /** @name Subclassing */
 
 /**
@@ -21,6 +21,7 @@
 #import "NimbusCore.h"
 
 #import <objc/runtime.h>
+#import <QuartzCore/QuartzCore.h>
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "Nimbus requires ARC support."
@@ -29,12 +30,35 @@
 const NSInteger NIPagingScrollViewUnknownNumberOfPages = -1;
 const CGFloat NIPagingScrollViewDefaultPageMargin = 10;
 
+// Page turns closer together than this mean the user is flipping through the pages.
+static const NSTimeInterval kQuickPageTurnInterval = 0.6;
+
+static dispatch_queue_t NIPagingScrollViewPrepareQueue(void) {
+  static dispatch_queue_t sQueue = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sQueue = dispatch_queue_create("com.nimbuskit.pagingscrollview.prepare", DISPATCH_QUEUE_SERIAL);
+    dispatch_set_target_queue(sQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+  });
+  return sQueue;
+}
+
 @implementation NIPagingScrollView {
-  NIViewRecycler* _viewRecycler;
   UIScrollView* _scrollView;
 
   NSMutableSet* _visiblePages;
 
+  // Preloading Pages
+  NIIdleTaskToken* _preloadTask;
+  NSMutableIndexSet* _preparedPageIndexes;
+  CFTimeInterval _lastPageTurnTime;
+  // +1 or -1 while the user is quickly turning pages in that direction, 0 otherwise.
+  NSInteger _quickPagingDirection;
+
+  // Memory Budget
+  NSHashTable* _recycledPages; // Weak, so pages that the recycler drops fall out.
+  NSMutableIndexSet* _discardedPageIndexes;
+
   // Animating to Pages
   NSInteger _animatingToPageIndex;
   BOOL _isKillingAnimation;
@@ -44,12 +68,15 @@ const CGFloat NIPagingScrollViewDefaultPageMargin = 10;
   // Rotation State
   NSInteger _firstVisiblePageIndexBeforeRotation;
   CGFloat _percentScrolledIntoFirstVisiblePage;
+  // Page indexes to the snapshots standing in for their pages, or nil when not rotating.
+  NSMutableDictionary* _rotationSnapshots;
 }
 
 - (void)commonInit {
   // Default state.
   self.pageMargin = NIPagingScrollViewDefaultPageMargin;
   self.type = NIPagingScrollViewHorizontal;
+  self.numberOfPagesToPreload = 1;
 
   // Internal state
   _animatingToPageIndex = -1;
@@ -59,6 +86,8 @@ const CGFloat NIPagingScrollViewDefaultPageMargin = 10;
   _numberOfPages = NIPagingScrollViewUnknownNumberOfPages;
 
   _viewRecycler = [[NIViewRecycler alloc] init];
+  _recycledPages = [NSHashTable weakObjectsHashTable];
+  _discardedPageIndexes = [[NSMutableIndexSet alloc] init];
 
   // The internal scroll view that powers this paging scroll view.
   _scrollView = [[UIScrollView alloc] initWithFrame:self.bounds];
@@ -195,8 +224,8 @@ const CGFloat NIPagingScrollViewDefaultPageMargin = 10;
 - (BOOL)isDisplayingPageForIndex:(NSInteger)pageIndex {
   BOOL foundPage = NO;
 
-  // There will never be more than 3 visible pages in this array, so this lookup is
-  // effectively O(C) constant time.
+  // There are never more than 2 * numberOfPagesToPreload + 1 pages in this array, so this lookup
+  // is effectively O(C) constant time.
   for (UIView <NIPagingScrollViewPage>* page in _visiblePages) {
     if (page.pageIndex == pageIndex) {
       foundPage = YES;
@@ -234,8 +263,19 @@ const CGFloat NIPagingScrollViewDefaultPageMargin = 10;
 
   NSInteger currentVisiblePageIndex = [self currentVisiblePageIndex];
 
-  NSInteger firstVisiblePageIndex = NIBoundi(currentVisiblePageIndex - 1, 0, self.numberOfPages - 1);
-  NSInteger lastVisiblePageIndex  = NIBoundi(currentVisiblePageIndex + 1, 0, self.numberOfPages - 1);
+  NSInteger numberOfPagesToPreload = MAX(1, self.numberOfPagesToPreload);
+  NSInteger numberOfPagesBefore = numberOfPagesToPreload;
+  NSInteger numberOfPagesAfter = numberOfPagesToPreload;
+  BOOL isPagingQuickly = (CACurrentMediaTime() - _lastPageTurnTime < kQuickPageTurnInterval);
+  if (isPagingQuickly && _quickPagingDirection > 0) {
+    numberOfPagesBefore = 1;
+    numberOfPagesAfter = numberOfPagesToPreload + 1;
+  } else if (isPagingQuickly && _quickPagingDirection < 0) {
+    numberOfPagesBefore = numberOfPagesToPreload + 1;
+    numberOfPagesAfter = 1;
+  }
+  NSInteger firstVisiblePageIndex = NIBoundi(currentVisiblePageIndex - numberOfPagesBefore, 0, self.numberOfPages - 1);
+  NSInteger lastVisiblePageIndex  = NIBoundi(currentVisiblePageIndex + numberOfPagesAfter, 0, self.numberOfPages - 1);
 
   return NSMakeRange(firstVisiblePageIndex, lastVisiblePageIndex - firstVisiblePageIndex + 1);
 }
@@ -261,13 +301,25 @@ const CGFloat NIPagingScrollViewDefaultPageMargin = 10;
   }
 }
 
+- (void)setViewRecycler:(NIViewRecycler *)viewRecycler {
+  if (_viewRecycler != viewRecycler) {
+    [self removeRecycledPages];
+    _viewRecycler = (nil != viewRecycler) ? viewRecycler : [[NIViewRecycler alloc] init];
+  }
+}
+
 - (UIView<NIPagingScrollViewPage> *)dequeueReusablePageWithIdentifier:(NSString *)identifier {
   NIDASSERT(nil != identifier);
   if (nil == identifier) {
     return nil;
   }
 
-  return (UIView<NIPagingScrollViewPage> *)[_viewRecycler dequeueReusableViewWithIdentifier:identifier];
+  UIView<NIPagingScrollViewPage>* page =
+      (UIView<NIPagingScrollViewPage> *)[_viewRecycler dequeueReusableViewWithIdentifier:identifier];
+  if (nil != page) {
+    [_recycledPages removeObject:page];
+  }
+  return page;
 }
 
 - (UIView<NIPagingScrollViewPage> *)loadPageAtIndex:(NSInteger)pageIndex {
@@ -298,27 +350,195 @@ const CGFloat NIPagingScrollViewDefaultPageMargin = 10;
   [_visiblePages addObject:page];
 }
 
+- (void)recyclePage:(UIView<NIPagingScrollViewPage> *)page {
+  [self removeRotationSnapshotOfPage:page];
+  [_viewRecycler recycleView:page];
+  [_recycledPages addObject:page];
+  [_discardedPageIndexes removeIndex:page.pageIndex];
+  [page removeFromSuperview];
+
+  [self didRecyclePage:page];
+
+  [_visiblePages removeObject:page];
+}
+
 - (void)recyclePageAtIndex:(NSInteger)pageIndex {
   for (UIView<NIPagingScrollViewPage>* page in [_visiblePages copy]) {
     if (page.pageIndex == pageIndex) {
-      [_viewRecycler recycleView:page];
-      [page removeFromSuperview];
+      [self recyclePage:page];
+    }
+  }
+}
+
+// Discarded pages are only placeholders, so they are loaded again before they can be seen.
+- (void)reloadDiscardedPageAtIndex:(NSInteger)pageIndex {
+  if ([_discardedPageIndexes containsIndex:pageIndex]) {
+    [self recyclePageAtIndex:pageIndex];
+  }
+}
+
+#pragma mark - Memory Budget
+
+- (unsigned long long)estimatedMemoryCostOfPage:(id<NIPagingScrollViewPage>)page {
+  return [page respondsToSelector:@selector(estimatedMemoryCost)] ? [page estimatedMemoryCost] : 0;
+}
+
+// Only the pages that this view recycled are removed, so that a shared recycler keeps the pages
+// of the other containers that use it.
+- (void)removeRecycledPages {
+  for (UIView<NIPagingScrollViewPage>* page in [_recycledPages allObjects]) {
+    [_viewRecycler removeView:page];
+  }
+  [_recycledPages removeAllObjects];
+}
+
+- (unsigned long long)estimatedMemoryCostOfPages {
+  unsigned long long cost = 0;
+  for (UIView<NIPagingScrollViewPage>* page in _visiblePages) {
+    cost += [self estimatedMemoryCostOfPage:page];
+  }
+  for (UIView<NIPagingScrollViewPage>* page in _recycledPages) {
+    // Another container sharing the recycler may have dequeued the page since.
+    if (nil == page.superview) {
+      cost += [self estimatedMemoryCostOfPage:page];
+    }
+  }
+  return cost;
+}
+
+- (BOOL)isOverMemoryBudget {
+  return (self.memoryBudget > 0 && [self estimatedMemoryCostOfPages] > self.memoryBudget);
+}
+
+- (void)enforceMemoryBudget {
+  if (![self isOverMemoryBudget]) {
+    return;
+  }
 
-      [self didRecyclePage:page];
+  // Recycled pages will be given new content when they are reused, so they go first.
+  [self removeRecycledPages];
+
+  // Then the loaded pages from the furthest in, leaving the center page and its neighbors.
+  NSArray* pages = [[_visiblePages allObjects] sortedArrayUsingComparator:^NSComparisonResult(id<NIPagingScrollViewPage> page1, id<NIPagingScrollViewPage> page2) {
+    NSInteger distance1 = labs(page1.pageIndex - _centerPageIndex);
+    NSInteger distance2 = labs(page2.pageIndex - _centerPageIndex);
+    return (distance1 > distance2) ? NSOrderedAscending : ((distance1 < distance2) ? NSOrderedDescending : NSOrderedSame);
+  }];
+  for (UIView<NIPagingScrollViewPage>* page in pages) {
+    if (![self isOverMemoryBudget] || labs(page.pageIndex - _centerPageIndex) <= 1) {
+      break;
+    }
+    if ([_discardedPageIndexes containsIndex:page.pageIndex]) {
+      continue;
+    }
+    if ([page respondsToSelector:@selector(discardContent)]) {
+      [page discardContent];
+      [_discardedPageIndexes addIndex:page.pageIndex];
 
-      [_visiblePages removeObject:page];
+    } else {
+      [self recyclePage:page];
+      // The recycled page must not stay in memory either.
+      [self removeRecycledPages];
     }
   }
 }
 
+
 - (void)preloadOffscreenPages {
+  // The neighbors of the center page are needed as soon as the user swipes.
   NSRange rangeOfVisiblePages = [self rangeOfVisiblePages];
-  for (NSUInteger pageIndex = rangeOfVisiblePages.location;
-       pageIndex < NSMaxRange(rangeOfVisiblePages); ++pageIndex) {
-    if (![self isDisplayingPageForIndex:pageIndex]) {
+  for (NSInteger pageIndex = _centerPageIndex - 1; pageIndex <= _centerPageIndex + 1; ++pageIndex) {
+    [self reloadDiscardedPageAtIndex:pageIndex];
+    if (pageIndex >= 0 && NSLocationInRange((NSUInteger)pageIndex, rangeOfVisiblePages)
+        && ![self isDisplayingPageForIndex:pageIndex]) {
       [self displayPageAtIndex:pageIndex];
     }
   }
+  [self enforceMemoryBudget];
+
+  // The rest are built when nothing else is going on.
+  [_preloadTask cancel];
+  _preloadTask = nil;
+  if (self.numberOfPagesToPreload > 1) {
+    __weak NIPagingScrollView* weakSelf = self;
+    _preloadTask = [[NIIdleScheduler sharedScheduler] scheduleTaskWithPriority:NIIdleTaskPriorityHigh block:^BOOL{
+      return [weakSelf preloadNextOffscreenPage];
+    }];
+  }
+}
+
+// Whether one more page, assumed to cost as much as the center page, would fit the memory budget.
+- (BOOL)canAffordAnotherPage {
+  if (self.memoryBudget == 0) {
+    return YES;
+  }
+  unsigned long long pageCost = [self estimatedMemoryCostOfPage:[self centerPageView]];
+  return ([self estimatedMemoryCostOfPages] + pageCost <= self.memoryBudget);
+}
+
+// Displays the missing page nearest to the center page. Returns NO once every page is loaded or
+// the next page would not fit the memory budget.
+- (BOOL)preloadNextOffscreenPage {
+  NSRange rangeOfVisiblePages = [self rangeOfVisiblePages];
+  for (NSInteger distance = 2; distance <= MAX(1, self.numberOfPagesToPreload); ++distance) {
+    for (NSInteger pageIndex = _centerPageIndex + distance; pageIndex >= _centerPageIndex - distance;
+         pageIndex -= 2 * distance) {
+      if (pageIndex >= 0 && NSLocationInRange((NSUInteger)pageIndex, rangeOfVisiblePages)
+          && ![self isDisplayingPageForIndex:pageIndex]) {
+        // Building a page only for enforceMemoryBudget to discard it would waste the work.
+        if (![self canAffordAnotherPage]) {
+          return NO;
+        }
+        [self displayPageAtIndex:pageIndex];
+        [self enforceMemoryBudget];
+        return YES;
+      }
+    }
+  }
+  return NO;
+}
+
+- (void)prepareContentForPagesAroundCenterPage {
+  id<NIPagingScrollViewDataSource> dataSource = self.dataSource;
+  if (![dataSource respondsToSelector:@selector(pagingScrollView:prepareContentForPageAtIndex:)]) {
+    return;
+  }
+  if (nil == _preparedPageIndexes) {
+    _preparedPageIndexes = [[NSMutableIndexSet alloc] init];
+  }
+
+  // Pages are prepared one beyond the preloaded ones so that they are ready when they are loaded.
+  NSInteger distance = MAX(1, self.numberOfPagesToPreload) + 1;
+  // Pages that fall out of range are prepared again if they come back.
+  NSInteger firstPageIndex = MAX(0, _centerPageIndex - distance);
+  [_preparedPageIndexes removeIndexesInRange:NSMakeRange(0, (NSUInteger)firstPageIndex)];
+  [_preparedPageIndexes removeIndexesInRange:NSMakeRange((NSUInteger)(_centerPageIndex + distance + 1),
+                                                         NSNotFound - (NSUInteger)(_centerPageIndex + distance + 1))];
+  NSMutableArray* pageIndexes = [NSMutableArray array];
+  for (NSInteger offset = 1; offset <= distance; ++offset) {
+    for (NSInteger pageIndex = _centerPageIndex + offset; pageIndex >= _centerPageIndex - offset;
+         pageIndex -= 2 * offset) {
+      if (pageIndex >= 0 && pageIndex < self.numberOfPages && ![self isDisplayingPageForIndex:pageIndex]
+          && ![_preparedPageIndexes containsIndex:pageIndex]) {
+        [_preparedPageIndexes addIndex:pageIndex];
+        [pageIndexes addObject:[NSNumber numberWithInteger:pageIndex]];
+      }
+    }
+  }
+  // The blocks must not hold on to the view, whose last release would then happen off the main
+  // thread. It is only passed along to identify it.
+  __unsafe_unretained NIPagingScrollView* pagingScrollView = self;
+  for (NSNumber* pageIndex in pageIndexes) {
+    NSInteger index = [pageIndex integerValue];
+    dispatch_async(NIPagingScrollViewPrepareQueue(), ^{
+      [dataSource pagingScrollView:pagingScrollView prepareContentForPageAtIndex:index];
+
+      // The data source is usually a view controller, so it is released on the main thread too.
+      dispatch_async(dispatch_get_main_queue(), ^{
+        [dataSource class];
+      });
+    });
+  }
 }
 
 - (void)updateVisiblePagesShouldNotifyDelegate:(BOOL)shouldNotifyDelegate {
@@ -334,12 +554,7 @@ const CGFloat NIPagingScrollViewDefaultPageMargin = 10;
   // iterating over it.
   for (UIView<NIPagingScrollViewPage>* page in [_visiblePages copy]) {
     if (!NSLocationInRange(page.pageIndex, rangeOfVisiblePages)) {
-      [_viewRecycler recycleView:page];
-      [page removeFromSuperview];
-
-      [self didRecyclePage:page];
-
-      [_visiblePages removeObject:page];
+      [self recyclePage:page];
     }
   }
 
@@ -348,6 +563,15 @@ const CGFloat NIPagingScrollViewDefaultPageMargin = 10;
   if (self.numberOfPages > 0) {
     _centerPageIndex = [self currentVisiblePageIndex];
 
+    if (oldCenterPageIndex >= 0 && oldCenterPageIndex != _centerPageIndex) {
+      CFTimeInterval now = CACurrentMediaTime();
+      BOOL isQuick = (now - _lastPageTurnTime < kQuickPageTurnInterval
+                      && labs(_centerPageIndex - oldCenterPageIndex) == 1);
+      _quickPagingDirection = isQuick ? (_centerPageIndex - oldCenterPageIndex) : 0;
+      _lastPageTurnTime = now;
+    }
+    [self reloadDiscardedPageAtIndex:_centerPageIndex];
+
     [self didChangeCenterPageIndexFrom:oldCenterPageIndex to:_centerPageIndex];
 
     // Prioritize displaying the currently visible page.
@@ -355,6 +579,8 @@ const CGFloat NIPagingScrollViewDefaultPageMargin = 10;
       [self displayPageAtIndex:_centerPageIndex];
     }
 
+    [self prepareContentForPagesAroundCenterPage];
+
     // Add missing pages after displaying the current page.
     [self performSelector:@selector(preloadOffscreenPages)
                withObject:nil
@@ -370,6 +596,14 @@ const CGFloat NIPagingScrollViewDefaultPageMargin = 10;
 }
 
 - (void)layoutVisiblePages {
+  // The pages themselves are laid out once the rotation completes.
+  if (nil != _rotationSnapshots) {
+    [_rotationSnapshots enumerateKeysAndObjectsUsingBlock:^(NSNumber* pageIndex, UIView* snapshot, BOOL* stop) {
+      snapshot.frame = [self frameForPageAtIndex:[pageIndex integerValue]];
+    }];
+    return;
+  }
+
   for (UIView<NIPagingScrollViewPage>* page in _visiblePages) {
     CGRect pageFrame = [self frameForPageAtIndex:page.pageIndex];
     if ([page respondsToSelector:@selector(setFrameAndMaintainState:)]) {
@@ -521,13 +755,23 @@ const CGFloat NIPagingScrollViewDefaultPageMargin = 10;
   _animatingToPageIndex = -1;
   NIDASSERT(nil != _dataSource);
 
+  [_preloadTask cancel];
+  _preloadTask = nil;
+  // The pages' content may have changed.
+  [_preparedPageIndexes removeAllIndexes];
+
+  [self removeRotationSnapshots];
+
   // Remove any visible pages from the view before we release the sets.
   for (UIView<NIPagingScrollViewPage>* page in _visiblePages) {
     [_viewRecycler recycleView:page];
+    [_recycledPages addObject:page];
     [(UIView *)page removeFromSuperview];
 
     [self didRecyclePage:page];
   }
+  [_discardedPageIndexes removeAllIndexes];
+  _quickPagingDirection = 0;
 
   _visiblePages = nil;
 
@@ -537,7 +781,7 @@ const CGFloat NIPagingScrollViewDefaultPageMargin = 10;
     _scrollView.contentOffset = CGPointZero;
 
     // May as well just get rid of all the views then.
-    [_viewRecycler removeAllViews];
+    [self removeRecycledPages];
 
     return;
   }
@@ -569,8 +813,162 @@ const CGFloat NIPagingScrollViewDefaultPageMargin = 10;
   [self updateVisiblePagesShouldNotifyDelegate:NO];
 }
 
+// Asks the data source for the number of pages again after the visible pages have been given
+// their new indexes, and centers the page now at centerPageIndex.
+- (void)reloadNumberOfPagesWithCenterPageIndex:(NSInteger)centerPageIndex {
+  _numberOfPages = [_dataSource numberOfPagesInPagingScrollView:self];
+  _scrollView.contentSize = [self contentSizeForPagingScrollView];
+
+  [self didReloadNumberOfPages];
+
+  for (UIView<NIPagingScrollViewPage>* page in [_visiblePages copy]) {
+    if (page.pageIndex >= self.numberOfPages) {
+      [self recyclePage:page];
+    }
+  }
+  NSUInteger numberOfPages = (NSUInteger)MAX(0, self.numberOfPages);
+  [_discardedPageIndexes removeIndexesInRange:NSMakeRange(numberOfPages, NSNotFound - numberOfPages)];
+  [_preparedPageIndexes removeIndexesInRange:NSMakeRange(numberOfPages, NSNotFound - numberOfPages)];
+  [self layoutVisiblePages];
+
+  if (_centerPageIndex >= 0) {
+    _centerPageIndex = NIBoundi(centerPageIndex, 0, self.numberOfPages - 1);
+
+    if (![_scrollView isTracking] && ![_scrollView isDragging]) {
+      CGPoint offset = [self frameForPageAtIndex:_centerPageIndex].origin;
+      offset = [self contentOffsetFromPageOffset:offset];
+      _scrollView.contentOffset = offset;
+
+      _isKillingAnimation = YES;
+    }
+  }
+
+  [self updateVisiblePagesShouldNotifyDelegate:NO];
+}
+
+// Returns NO if the pages have never been loaded, in which case they are loaded from scratch.
+- (BOOL)prepareToChangePages {
+  if (nil == _visiblePages || nil == _dataSource) {
+    [self reloadData];
+    return NO;
+  }
+  _animatingToPageIndex = -1;
+
+  [_preloadTask cancel];
+  _preloadTask = nil;
+  [self removeRotationSnapshots];
+  _quickPagingDirection = 0;
+  return YES;
+}
+
+- (void)reloadDataPreservingVisiblePages {
+  if ([self prepareToChangePages]) {
+    [self reloadNumberOfPagesWithCenterPageIndex:_centerPageIndex];
+  }
+}
+
+- (void)insertPagesAtIndexes:(NSIndexSet *)indexes {
+  if (![self prepareToChangePages]) {
+    return;
+  }
+
+  // The indexes are those of the inserted pages once inserted, so each one pushes back the pages
+  // at or after it, in ascending order.
+  NSInteger (^newPageIndex)(NSInteger) = ^NSInteger(NSInteger pageIndex) {
+    __block NSInteger newIndex = pageIndex;
+    [indexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL* stop) {
+      if ((NSInteger)index <= newIndex) {
+        newIndex++;
+      } else {
+        *stop = YES;
+      }
+    }];
+    return newIndex;
+  };
+  for (UIView<NIPagingScrollViewPage>* page in _visiblePages) {
+    page.pageIndex = newPageIndex(page.pageIndex);
+  }
+  [indexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL* stop) {
+    [_discardedPageIndexes shiftIndexesStartingAtIndex:index by:1];
+    [_preparedPageIndexes shiftIndexesStartingAtIndex:index by:1];
+  }];
+
+  [self reloadNumberOfPagesWithCenterPageIndex:(_centerPageIndex >= 0 ? newPageIndex(_centerPageIndex) : -1)];
+}
+
+- (void)deletePagesAtIndexes:(NSIndexSet *)indexes {
+  if (![self prepareToChangePages]) {
+    return;
+  }
+
+  for (UIView<NIPagingScrollViewPage>* page in [_visiblePages copy]) {
+    if ([indexes containsIndex:page.pageIndex]) {
+      [self recyclePage:page];
+    }
+  }
+
+  // The indexes are those of the deleted pages before deletion.
+  NSInteger (^newPageIndex)(NSInteger) = ^NSInteger(NSInteger pageIndex) {
+    return pageIndex - (NSInteger)[indexes countOfIndexesInRange:NSMakeRange(0, (NSUInteger)pageIndex)];
+  };
+  for (UIView<NIPagingScrollViewPage>* page in _visiblePages) {
+    page.pageIndex = newPageIndex(page.pageIndex);
+  }
+  [indexes enumerateIndexesWithOptions:NSEnumerationReverse usingBlock:^(NSUInteger index, BOOL* stop) {
+    [_discardedPageIndexes shiftIndexesStartingAtIndex:index + 1 by:-1];
+    [_preparedPageIndexes shiftIndexesStartingAtIndex:index + 1 by:-1];
+  }];
+
+  // A deleted center page is replaced by the page that followed it.
+  [self reloadNumberOfPagesWithCenterPageIndex:(_centerPageIndex >= 0 ? newPageIndex(_centerPageIndex) : -1)];
+}
+
+#pragma mark - Snapshot Rotation
+
+- (void)addRotationSnapshots {
+  _rotationSnapshots = [[NSMutableDictionary alloc] initWithCapacity:_visiblePages.count];
+  for (UIView<NIPagingScrollViewPage>* page in _visiblePages) {
+    UIImageView* snapshot = NISnapshotViewOfViewWithTransparency(page);
+    snapshot.contentMode = UIViewContentModeScaleAspectFit;
+    [_scrollView insertSubview:snapshot aboveSubview:page];
+    page.hidden = YES;
+    [_rotationSnapshots setObject:snapshot forKey:@(page.pageIndex)];
+  }
+}
+
+- (void)removeRotationSnapshotOfPage:(UIView<NIPagingScrollViewPage> *)page {
+  UIView* snapshot = [_rotationSnapshots objectForKey:@(page.pageIndex)];
+  if (nil != snapshot) {
+    [snapshot removeFromSuperview];
+    [_rotationSnapshots removeObjectForKey:@(page.pageIndex)];
+    page.hidden = NO;
+  }
+}
+
+- (void)removeRotationSnapshots {
+  if (nil == _rotationSnapshots) {
+    return;
+  }
+  for (UIView<NIPagingScrollViewPage>* page in _visiblePages) {
+    [self removeRotationSnapshotOfPage:page];
+  }
+  for (UIView* snapshot in [_rotationSnapshots objectEnumerator]) {
+    [snapshot removeFromSuperview];
+  }
+  _rotationSnapshots = nil;
+}
+
+#pragma mark - Rotation
+
 - (void)willRotateToInterfaceOrientation: (UIInterfaceOrientation)toInterfaceOrientation
                                 duration: (NSTimeInterval)duration {
+  // A rotation that began before the last one finished starts over from the real pages.
+  [self removeRotationSnapshots];
+  [self layoutVisiblePages];
+  if (self.usesSnapshotsDuringRotation) {
+    [self addRotationSnapshots];
+  }
+
   // Here, our pagingScrollView bounds have not yet been updated for the new interface
   // orientation. This is a good place to calculate the content offset that we will
   // need in the new orientation.
@@ -603,6 +1001,14 @@ const CGFloat NIPagingScrollViewDefaultPageMargin = 10;
   _scrollView.contentOffset = [self contentOffsetFromOffset:newOffset];
 }
 
+- (void)didRotateFromInterfaceOrientation:(UIInterfaceOrientation)fromInterfaceOrientation {
+  if (nil == _rotationSnapshots) {
+    return;
+  }
+  [self removeRotationSnapshots];
+  [self layoutVisiblePages];
+}
+
 - (BOOL)hasNext {
   return (self.centerPageIndex < self.numberOfPages - 1);
 }
@@ -19,8 +19,27 @@
 #import <XCTest/XCTest.h>
 
 #import "NimbusPagingScrollView.h"
+#import "NIPagingScrollView+Subclassing.h"
 
-@interface NIPagingScrollViewTests : XCTestCase
+@interface NIPagingScrollViewTestPage : NIPagingScrollViewPage
+@property (nonatomic, assign) BOOL discarded;
+@end
+
+@implementation NIPagingScrollViewTestPage
+
+- (unsigned long long)estimatedMemoryCost {
+  return self.discarded ? 0 : 100;
+}
+
+- (void)discardContent {
+  self.discarded = YES;
+}
+
+@end
+
+@interface NIPagingScrollViewTests : XCTestCase <NIPagingScrollViewDataSource>
+@property (nonatomic, strong) NSMutableIndexSet* preparedPageIndexes;
+@property (nonatomic, assign) NSInteger numberOfPages; // 0 means 10.
 @end
 
 
@@ -30,4 +49,111 @@
 - (void)testNothing {
 }
 
+- (NSInteger)numberOfPagesInPagingScrollView:(NIPagingScrollView *)pagingScrollView {
+  return (self.numberOfPages > 0) ? self.numberOfPages : 10;
+}
+
+- (UIView<NIPagingScrollViewPage> *)pagingScrollView:(NIPagingScrollView *)pagingScrollView pageViewForIndex:(NSInteger)pageIndex {
+  return [[NIPagingScrollViewTestPage alloc] initWithFrame:CGRectZero];
+}
+
+- (void)pagingScrollView:(NIPagingScrollView *)pagingScrollView prepareContentForPageAtIndex:(NSInteger)pageIndex {
+  @synchronized(self) {
+    [self.preparedPageIndexes addIndex:pageIndex];
+  }
+}
+
+- (void)testPagesArePreloadedAndPrepared {
+  self.preparedPageIndexes = [NSMutableIndexSet indexSet];
+  NIPagingScrollView* pagingScrollView = [[NIPagingScrollView alloc] initWithFrame:CGRectMake(0, 0, 320, 480)];
+  pagingScrollView.numberOfPagesToPreload = 2;
+  pagingScrollView.dataSource = self;
+  [pagingScrollView reloadData];
+  XCTAssertEqual(pagingScrollView.visiblePages.count, (NSUInteger)1, @"Only the center page should load right away.");
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  while (pagingScrollView.visiblePages.count < 3 && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertEqual(pagingScrollView.visiblePages.count, (NSUInteger)3,
+                 @"The first page and the two after it should have been loaded.");
+
+  timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  BOOL isPrepared = NO;
+  while (!isPrepared && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    @synchronized(self) {
+      isPrepared = [self.preparedPageIndexes containsIndexesInRange:NSMakeRange(1, 3)];
+    }
+  }
+  XCTAssertTrue(isPrepared, @"The pages after the first should have been prepared in the background.");
+}
+
+- (void)testPagesOverTheMemoryBudgetAreDiscarded {
+  NIPagingScrollView* pagingScrollView = [[NIPagingScrollView alloc] initWithFrame:CGRectMake(0, 0, 320, 480)];
+  pagingScrollView.numberOfPagesToPreload = 3;
+  pagingScrollView.memoryBudget = 250;
+  pagingScrollView.dataSource = self;
+  [pagingScrollView reloadData];
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  while (pagingScrollView.visiblePages.count < 2 && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  // Give the idle preloading a chance to go past the budget.
+  [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+
+  XCTAssertTrue([pagingScrollView estimatedMemoryCostOfPages] <= 250, @"The pages should fit the budget.");
+  XCTAssertEqual(pagingScrollView.visiblePages.count, (NSUInteger)2,
+                 @"A third page would go over the budget, so it should not be preloaded.");
+  for (NIPagingScrollViewTestPage* page in pagingScrollView.visiblePages) {
+    XCTAssertFalse(page.discarded, @"No page should be built only to be discarded.");
+  }
+}
+
+- (void)testInsertingAndDeletingPagesKeepsTheVisiblePages {
+  NIPagingScrollView* pagingScrollView = [[NIPagingScrollView alloc] initWithFrame:CGRectMake(0, 0, 320, 480)];
+  pagingScrollView.numberOfPagesToPreload = 0;
+  pagingScrollView.dataSource = self;
+  [pagingScrollView reloadData];
+  [pagingScrollView moveToPageAtIndex:3 animated:NO];
+  UIView<NIPagingScrollViewPage>* centerPage = [pagingScrollView centerPageView];
+
+  self.numberOfPages = 12;
+  [pagingScrollView insertPagesAtIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 2)]];
+  XCTAssertEqual(pagingScrollView.numberOfPages, (NSInteger)12);
+  XCTAssertEqual([pagingScrollView centerPageView], centerPage, @"The center page should not be reloaded.");
+  XCTAssertEqual(pagingScrollView.centerPageIndex, (NSInteger)5, @"The center page should move with the insertion.");
+
+  self.numberOfPages = 11;
+  [pagingScrollView deletePagesAtIndexes:[NSIndexSet indexSetWithIndex:0]];
+  XCTAssertEqual([pagingScrollView centerPageView], centerPage);
+  XCTAssertEqual(centerPage.pageIndex, (NSInteger)4);
+
+  self.numberOfPages = 20;
+  [pagingScrollView reloadDataPreservingVisiblePages];
+  XCTAssertEqual([pagingScrollView centerPageView], centerPage, @"Appending pages should not reload the center page.");
+  XCTAssertEqual(pagingScrollView.scrollView.contentSize.width, (CGFloat)(20 * pagingScrollView.scrollView.bounds.size.width));
+}
+
+- (void)testRotationSnapshotsStandInForPagesUntilTheRotationEnds {
+  NIPagingScrollView* pagingScrollView = [[NIPagingScrollView alloc] initWithFrame:CGRectMake(0, 0, 320, 480)];
+  pagingScrollView.numberOfPagesToPreload = 0;
+  pagingScrollView.usesSnapshotsDuringRotation = YES;
+  pagingScrollView.dataSource = self;
+  [pagingScrollView reloadData];
+  UIView<NIPagingScrollViewPage>* page = [pagingScrollView centerPageView];
+  CGRect frameBeforeRotation = page.frame;
+
+  [pagingScrollView willRotateToInterfaceOrientation:UIInterfaceOrientationLandscapeLeft duration:0.3];
+  pagingScrollView.frame = CGRectMake(0, 0, 480, 320);
+  [pagingScrollView willAnimateRotationToInterfaceOrientation:UIInterfaceOrientationLandscapeLeft duration:0.3];
+  XCTAssertTrue(page.hidden, @"The snapshot should be shown in place of the page.");
+  XCTAssertTrue(CGRectEqualToRect(page.frame, frameBeforeRotation), @"The page should not be laid out during the animation.");
+
+  [pagingScrollView didRotateFromInterfaceOrientation:UIInterfaceOrientationPortrait];
+  XCTAssertFalse(page.hidden);
+  XCTAssertEqual(CGRectGetHeight(page.frame), (CGFloat)320, @"The page should be laid out for the new bounds.");
+}
+
 @end
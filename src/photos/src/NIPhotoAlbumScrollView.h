@@ -54,6 +54,10 @@
 @property (nonatomic, assign, getter=isZoomingAboveOriginalSizeEnabled) BOOL zoomingAboveOriginalSizeIsEnabled;
 @property (nonatomic, strong) UIColor* photoViewBackgroundColor;
 
+#pragma mark Reducing Memory Usage
+
+@property (nonatomic, assign) BOOL limitsOriginalPhotosToCenterPage; // Default: NO
+
 #pragma mark Configuring Presentation
 
 @property (nonatomic, strong) UIImage* loadingImage;
@@ -138,6 +142,28 @@
  */
 
 
+/** @name Reducing Memory Usage */
+
+/**
+ * Whether only the center page may show an original-sized photo.
+ *
+ * When enabled, every other page that shows an original photo has it replaced with a copy
+ * scaled down to fit within half of the album, and originals that load for those pages are
+ * displayed the same way. Whichever page becomes the center asks the data source for its
+ * original again.
+ *
+ * When disabled again, the downgraded pages are restored from the data source one at a time
+ * while the app is idle, nearest to the center first.
+ *
+ * NIToolbarPhotoViewController enables this while the NIMemoryPressureCoordinator reports
+ * warning or critical memory pressure.
+ *
+ * By default this is NO.
+ *
+ * @fn NIPhotoAlbumScrollView::limitsOriginalPhotosToCenterPage
+ */
+
+
 /** @name Configuring Presentation */
 
 /**
@@ -166,5 +192,10 @@
  * The photo at the given index will only be replaced with the given image if photoSize
  * is of a higher quality than the currently-displayed photo's size.
  *
+ * Original-sized photos are expensive to decode, so they are not displayed while the user is
+ * swiping between photos. Once the album comes to rest the center photo is displayed first and
+ * its neighbors follow one at a time while the main thread is idle. Photos for pages that are
+ * recycled before they are displayed are dropped.
+ *
  * @fn NIPhotoAlbumScrollView::didLoadPhoto:atIndex:photoSize:
  */
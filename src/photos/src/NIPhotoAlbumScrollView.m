@@ -30,6 +30,14 @@
   UIImage* _loadingImage;
   BOOL _zoomingIsEnabled;
   BOOL _zoomingAboveOriginalSizeIsEnabled;
+
+  // Original-sized photos that have loaded but aren't displayed yet, keyed by page index.
+  NSMutableDictionary* _pendingOriginalPhotos;
+  NIIdleTaskToken* _pendingOriginalPhotosTask;
+
+  // Pages whose original photo was replaced with a smaller copy to save memory.
+  NSMutableIndexSet* _downgradedPageIndexes;
+  NIIdleTaskToken* _restoreDowngradedPhotosTask;
 }
 
 - (id)initWithFrame:(CGRect)frame {
@@ -37,10 +45,18 @@
     // Default state.
     self.zoomingIsEnabled = YES;
     self.zoomingAboveOriginalSizeIsEnabled = YES;
+
+    _pendingOriginalPhotos = [[NSMutableDictionary alloc] init];
+    _downgradedPageIndexes = [[NSMutableIndexSet alloc] init];
   }
   return self;
 }
 
+- (void)dealloc {
+  [_pendingOriginalPhotosTask cancel];
+  [_restoreDowngradedPhotosTask cancel];
+}
+
 - (void)setBackgroundColor:(UIColor *)backgroundColor {
   [super setBackgroundColor:backgroundColor];
 
@@ -58,6 +74,229 @@
   }
 }
 
+#pragma mark - Displaying Loaded Photos
+
+
+- (BOOL)isScrollingBetweenPages {
+  return [self.scrollView isDragging] || [self.scrollView isDecelerating];
+}
+
+- (NIPhotoScrollView *)visiblePageAtIndex:(NSInteger)pageIndex {
+  for (NIPhotoScrollView* page in self.visiblePages) {
+    if (page.pageIndex == pageIndex) {
+      return page;
+    }
+  }
+  return nil;
+}
+
+- (void)displayPhoto:(UIImage *)image onPage:(NIPhotoScrollView *)page photoSize:(NIPhotoScrollViewPhotoSize)photoSize {
+  // A downgraded page already shows everything it is allowed to.
+  if (NIPhotoScrollViewPhotoSizeOriginal == photoSize
+      && [self shouldDowngradePhotoOnPage:page]
+      && [_downgradedPageIndexes containsIndex:(NSUInteger)page.pageIndex]
+      && page.photoSize >= NIPhotoScrollViewPhotoSizeThumbnail) {
+    page.loading = NO;
+    return;
+  }
+
+  // Only replace the photo if it's of a higher quality than one we're already showing.
+  if (photoSize > page.photoSize) {
+    page.loading = NO;
+    [page setImage:image photoSize:photoSize];
+
+    page.zoomingIsEnabled = ([self isZoomingEnabled]
+                             && (NIPhotoScrollViewPhotoSizeOriginal == photoSize));
+
+    // Notify the delegate that the photo has been loaded.
+    if (NIPhotoScrollViewPhotoSizeOriginal == photoSize) {
+      [self notifyDelegatePhotoDidLoadAtIndex:page.pageIndex];
+    }
+
+    [self downgradePhotoOnPageIfNeeded:page];
+  }
+}
+
+- (void)displayPendingOriginalPhotoAtIndex:(NSInteger)pageIndex {
+  UIImage* image = _pendingOriginalPhotos[@(pageIndex)];
+  [_pendingOriginalPhotos removeObjectForKey:@(pageIndex)];
+
+  NIPhotoScrollView* page = [self visiblePageAtIndex:pageIndex];
+  if (nil != image && nil != page) {
+    [self displayPhoto:image onPage:page photoSize:NIPhotoScrollViewPhotoSizeOriginal];
+  }
+}
+
+// Displays the pending original nearest to the center page. Returns NO once there is nothing
+// left to display or the user has started swiping again.
+- (BOOL)displayNextPendingOriginalPhoto {
+  if (0 == _pendingOriginalPhotos.count || [self isScrollingBetweenPages]) {
+    return NO;
+  }
+
+  NSNumber* nearestPageIndex = nil;
+  for (NSNumber* pageIndex in _pendingOriginalPhotos) {
+    if (nil == nearestPageIndex
+        || (labs([pageIndex integerValue] - self.centerPageIndex)
+            < labs([nearestPageIndex integerValue] - self.centerPageIndex))) {
+      nearestPageIndex = pageIndex;
+    }
+  }
+  [self displayPendingOriginalPhotoAtIndex:[nearestPageIndex integerValue]];
+
+  return _pendingOriginalPhotos.count > 0;
+}
+
+- (void)displayPendingOriginalPhotos {
+  if (0 == _pendingOriginalPhotos.count || [self isScrollingBetweenPages]) {
+    return;
+  }
+
+  // The photo the user is looking at can't wait; its neighbors are displayed one at a time
+  // while the main thread is otherwise idle.
+  [self displayPendingOriginalPhotoAtIndex:self.centerPageIndex];
+
+  [_pendingOriginalPhotosTask cancel];
+  _pendingOriginalPhotosTask = nil;
+  if (_pendingOriginalPhotos.count > 0) {
+    __weak NIPhotoAlbumScrollView* weakSelf = self;
+    _pendingOriginalPhotosTask = [[NIIdleScheduler sharedScheduler] scheduleTaskWithPriority:NIIdleTaskPriorityHigh block:^BOOL{
+      return [weakSelf displayNextPendingOriginalPhoto];
+    }];
+  }
+}
+
+#pragma mark - Downgrading Photos
+
+
+- (BOOL)shouldDowngradePhotoOnPage:(NIPhotoScrollView *)page {
+  return self.limitsOriginalPhotosToCenterPage && page.pageIndex != self.centerPageIndex;
+}
+
+// A copy of the photo that fits within half of the album in each dimension, which is plenty for
+// a page that is off screen.
+- (UIImage *)downgradedCopyOfPhoto:(UIImage *)photo {
+  CGSize photoSize = photo.size;
+  CGSize boundsSize = self.bounds.size;
+  if (photoSize.width <= 0 || photoSize.height <= 0
+      || boundsSize.width <= 0 || boundsSize.height <= 0) {
+    return nil;
+  }
+  CGFloat scale = MIN(1, MIN(boundsSize.width / 2 / photoSize.width,
+                             boundsSize.height / 2 / photoSize.height));
+  CGSize size = CGSizeMake(MAX(1, NICGFloatFloor(photoSize.width * scale)),
+                           MAX(1, NICGFloatFloor(photoSize.height * scale)));
+
+  UIGraphicsBeginImageContextWithOptions(size, NO, 1);
+  [photo drawInRect:CGRectMake(0, 0, size.width, size.height)];
+  UIImage* copy = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  return copy;
+}
+
+- (void)downgradePhotoOnPageIfNeeded:(NIPhotoScrollView *)page {
+  if (NIPhotoScrollViewPhotoSizeOriginal != page.photoSize
+      || ![self shouldDowngradePhotoOnPage:page]) {
+    return;
+  }
+  UIImage* original = page.image;
+  UIImage* copy = [self downgradedCopyOfPhoto:original];
+  if (nil == copy) {
+    return;
+  }
+
+  // Keep the copy at the original's visual size so that restoring it doesn't snap.
+  if (CGSizeEqualToSize(page.photoDimensions, CGSizeZero)) {
+    page.photoDimensions = CGSizeMake(original.size.width * original.scale,
+                                      original.size.height * original.scale);
+  }
+  [page setImage:copy photoSize:NIPhotoScrollViewPhotoSizeThumbnail];
+  page.zoomingIsEnabled = NO;
+
+  [_downgradedPageIndexes addIndex:(NSUInteger)page.pageIndex];
+}
+
+- (void)restorePhotoAtIndex:(NSInteger)pageIndex {
+  [_downgradedPageIndexes removeIndex:(NSUInteger)pageIndex];
+
+  NIPhotoScrollView* page = [self visiblePageAtIndex:pageIndex];
+  if (nil == page) {
+    return;
+  }
+
+  // The data source may have let go of the original too, in which case it starts loading it
+  // again and we'll hear about it through didLoadPhoto:atIndex:photoSize:.
+  NIPhotoScrollViewPhotoSize photoSize = NIPhotoScrollViewPhotoSizeUnknown;
+  BOOL isLoading = NO;
+  CGSize originalPhotoDimensions = CGSizeZero;
+  UIImage* image = [self.dataSource photoAlbumScrollView: self
+                                            photoAtIndex: pageIndex
+                                               photoSize: &photoSize
+                                               isLoading: &isLoading
+                                 originalPhotoDimensions: &originalPhotoDimensions];
+  if (NIPhotoScrollViewPhotoSizeOriginal == photoSize && nil != image
+      && [self isScrollingBetweenPages]) {
+    // Like any other original, it waits for the album to come to rest.
+    _pendingOriginalPhotos[@(pageIndex)] = image;
+    page.loading = YES;
+    return;
+  }
+  if (nil != image) {
+    [self displayPhoto:image onPage:page photoSize:photoSize];
+  }
+  page.loading = isLoading;
+}
+
+// Restores the downgraded photo nearest to the center page. Returns NO once every photo has
+// been restored.
+- (BOOL)restoreNextDowngradedPhoto {
+  if (0 == _downgradedPageIndexes.count || self.limitsOriginalPhotosToCenterPage) {
+    return NO;
+  }
+
+  __block NSInteger nearestPageIndex = -1;
+  NSInteger centerPageIndex = self.centerPageIndex;
+  [_downgradedPageIndexes enumerateIndexesUsingBlock:^(NSUInteger pageIndex, BOOL *stop) {
+    if (nearestPageIndex < 0
+        || labs((NSInteger)pageIndex - centerPageIndex) < labs(nearestPageIndex - centerPageIndex)) {
+      nearestPageIndex = (NSInteger)pageIndex;
+    }
+  }];
+  [self restorePhotoAtIndex:nearestPageIndex];
+
+  return _downgradedPageIndexes.count > 0;
+}
+
+- (void)setLimitsOriginalPhotosToCenterPage:(BOOL)limitsOriginalPhotosToCenterPage {
+  if (_limitsOriginalPhotosToCenterPage == limitsOriginalPhotosToCenterPage) {
+    return;
+  }
+  _limitsOriginalPhotosToCenterPage = limitsOriginalPhotosToCenterPage;
+
+  [_restoreDowngradedPhotosTask cancel];
+  _restoreDowngradedPhotosTask = nil;
+
+  if (limitsOriginalPhotosToCenterPage) {
+    for (NIPhotoScrollView* page in self.visiblePages) {
+      [self downgradePhotoOnPageIfNeeded:page];
+    }
+    // Pending originals would only be downgraded as soon as they were displayed.
+    for (NSNumber* pageIndex in [_pendingOriginalPhotos allKeys]) {
+      if ([pageIndex integerValue] != self.centerPageIndex) {
+        [_pendingOriginalPhotos removeObjectForKey:pageIndex];
+        [_downgradedPageIndexes addIndex:[pageIndex unsignedIntegerValue]];
+      }
+    }
+
+  } else if (_downgradedPageIndexes.count > 0) {
+    // There's no hurry to get the originals back, so restore them while the app is idle.
+    __weak NIPhotoAlbumScrollView* weakSelf = self;
+    _restoreDowngradedPhotosTask = [[NIIdleScheduler sharedScheduler] scheduleTaskWithPriority:NIIdleTaskPriorityLow block:^BOOL{
+      return [weakSelf restoreNextDowngradedPhoto];
+    }];
+  }
+}
+
 #pragma mark - Visible Page Management
 
 
@@ -100,10 +339,15 @@
     if (updateImage && NIPhotoScrollViewPhotoSizeOriginal == photoSize) {
       [self notifyDelegatePhotoDidLoadAtIndex:page.pageIndex];
     }
+
+    [self downgradePhotoOnPageIfNeeded:page];
   }
 }
 
 - (void)didRecyclePage:(UIView<NIPagingScrollViewPage> *)page {
+  [_pendingOriginalPhotos removeObjectForKey:@(page.pageIndex)];
+  [_downgradedPageIndexes removeIndex:(NSUInteger)page.pageIndex];
+
   // Give the data source the opportunity to kill any asynchronous operations for this
   // now-recycled page.
   if ([self.dataSource respondsToSelector:
@@ -113,6 +357,46 @@
   }
 }
 
+- (void)didChangeCenterPageIndexFrom:(NSInteger)from to:(NSInteger)to {
+  [super didChangeCenterPageIndexFrom:from to:to];
+
+  if (self.limitsOriginalPhotosToCenterPage) {
+    // The page that was just left is now one to downgrade, and the new center gets its
+    // original back.
+    NIPhotoScrollView* previousPage = [self visiblePageAtIndex:from];
+    if (nil != previousPage) {
+      [self downgradePhotoOnPageIfNeeded:previousPage];
+    }
+    if ([_downgradedPageIndexes containsIndex:(NSUInteger)to]) {
+      [self restorePhotoAtIndex:to];
+    }
+  }
+}
+
+#pragma mark - UIScrollViewDelegate
+
+
+- (void)scrollViewWillBeginDragging:(UIScrollView *)scrollView {
+  [_pendingOriginalPhotosTask cancel];
+  _pendingOriginalPhotosTask = nil;
+
+  [super scrollViewWillBeginDragging:scrollView];
+}
+
+- (void)scrollViewDidEndDragging:(UIScrollView *)scrollView willDecelerate:(BOOL)decelerate {
+  [super scrollViewDidEndDragging:scrollView willDecelerate:decelerate];
+
+  if (!decelerate) {
+    [self displayPendingOriginalPhotos];
+  }
+}
+
+- (void)scrollViewDidEndDecelerating:(UIScrollView *)scrollView {
+  [super scrollViewDidEndDecelerating:scrollView];
+
+  [self displayPendingOriginalPhotos];
+}
+
 #pragma mark - NIPhotoScrollViewDelegate
 
 
@@ -150,25 +434,24 @@
   // This modifies the UI and therefor MUST be executed on the main thread.
   NIDASSERT([NSThread isMainThread]);
 
-  for (NIPhotoScrollView* page in self.visiblePages) {
-    if (page.pageIndex == pageIndex) {
-
-      // Only replace the photo if it's of a higher quality than one we're already showing.
-      if (photoSize > page.photoSize) {
-        page.loading = NO;
-        [page setImage:image photoSize:photoSize];
-
-        page.zoomingIsEnabled = ([self isZoomingEnabled]
-                                 && (NIPhotoScrollViewPhotoSizeOriginal == photoSize));
+  NIPhotoScrollView* page = [self visiblePageAtIndex:pageIndex];
+  if (nil == page || photoSize <= page.photoSize) {
+    return;
+  }
 
-        // Notify the delegate that the photo has been loaded.
-        if (NIPhotoScrollViewPhotoSizeOriginal == photoSize) {
-          [self notifyDelegatePhotoDidLoadAtIndex:pageIndex];
-        }
-      }
-      break;
-    }
+  // Decoding an original-sized photo can take long enough to drop frames, so originals wait
+  // until the pager comes to rest and then go center page first. Thumbnails are cheap enough
+  // to display right away.
+  if (NIPhotoScrollViewPhotoSizeOriginal == photoSize
+      && nil != image
+      && ([self isScrollingBetweenPages] || pageIndex != self.centerPageIndex)) {
+    _pendingOriginalPhotos[@(pageIndex)] = image;
+    [self displayPendingOriginalPhotos];
+    return;
   }
+
+  [_pendingOriginalPhotos removeObjectForKey:@(pageIndex)];
+  [self displayPhoto:image onPage:page photoSize:photoSize];
 }
 
 - (void)setZoomingAboveOriginalSizeIsEnabled:(BOOL)enabled {
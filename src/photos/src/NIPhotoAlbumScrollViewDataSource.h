@@ -83,6 +83,10 @@
  * When a photo is not immediately visible this method is called to allow the data
  * source to minimize the number of active asynchronous operations in place.
  *
+ * This is called as soon as the photo's page leaves the album's preload window
+ * (see NIPagingScrollView::numberOfPagesToPreload). Any photo that finishes loading for that
+ * page afterwards is ignored.
+ *
  * This method is optional, though recommended because it focuses the device's processing
  * power on the most immediately accessible photos.
  */
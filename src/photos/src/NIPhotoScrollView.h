@@ -43,6 +43,8 @@
 - (UIImage *)image;
 - (NIPhotoScrollViewPhotoSize)photoSize;
 - (void)setImage:(UIImage *)image photoSize:(NIPhotoScrollViewPhotoSize)photoSize;
+- (BOOL)setTiledImageWithContentsOfURL:(NSURL *)url;
+- (void)reduceMemoryUsage;
 @property (nonatomic, assign, getter = isLoading) BOOL loading;
 
 @property (nonatomic, assign) NSInteger pageIndex;
@@ -125,6 +127,29 @@
  * @fn NIPhotoScrollView::setImage:photoSize:
  */
 
+/**
+ * Display a very large photo from disk, drawing it in tiles as it is zoomed and panned.
+ *
+ * Only the image's header is read here. Tiles are decoded on background threads at the
+ * resolution of the current zoom level, so a huge photo never needs to be decoded or uploaded
+ * to the GPU in full just to fit it on the screen. Only zooming in to the photo's full
+ * resolution decodes it at full size.
+ *
+ * The current image, if any, is stretched beneath the tiles as a placeholder until they have
+ * been drawn. The photo size becomes NIPhotoScrollViewPhotoSizeOriginal. Setting a new image
+ * with setImage:photoSize: or reusing the view removes the tiled photo.
+ *
+ * Returns NO and leaves the current photo in place if the file could not be read as an image.
+ *
+ * @fn NIPhotoScrollView::setTiledImageWithContentsOfURL:
+ */
+
+/**
+ * Releases the decoded levels of a tiled photo. Tiles are decoded again as they are needed.
+ *
+ * @fn NIPhotoScrollView::reduceMemoryUsage
+ */
+
 /**
  * The index of this photo within a photo album.
  *
@@ -17,6 +17,7 @@
 #import "NIPhotoScrollView.h"
 
 #import "NIPhotoScrollViewDelegate.h"
+#import "NITiledImageView.h"
 
 #import "NimbusCore.h"
 
@@ -78,6 +79,8 @@
 @implementation NIPhotoScrollView {
   // The photo view to be zoomed.
   UIImageView* _imageView;
+  // Draws a very large photo in tiles on top of the image view, which then shows a placeholder.
+  NITiledImageView* _tiledImageView;
   // The scroll view.
   NICenteringScrollView* _scrollView;
   UIActivityIndicatorView* _loadingView;
@@ -215,6 +218,7 @@
 
 
 - (void)prepareForReuse {
+  [self removeTiledImageView];
   _imageView.image = nil;
   self.photoSize = NIPhotoScrollViewPhotoSizeUnknown;
   _scrollView.zoomScale = 1;
@@ -228,7 +232,14 @@
 #pragma mark - Public
 
 
+- (void)removeTiledImageView {
+  [_tiledImageView removeFromSuperview];
+  _tiledImageView = nil;
+}
+
 - (void)setImage:(UIImage *)image photoSize:(NIPhotoScrollViewPhotoSize)photoSize {
+  [self removeTiledImageView];
+
   _imageView.image = image;
   [_imageView sizeToFit];
 
@@ -257,6 +268,40 @@
   [self setNeedsLayout];
 }
 
+- (BOOL)setTiledImageWithContentsOfURL:(NSURL *)url {
+  NITiledImageView* tiledImageView = [[NITiledImageView alloc] initWithContentsOfURL:url];
+  if (nil == tiledImageView) {
+    return NO;
+  }
+
+  [self removeTiledImageView];
+  _tiledImageView = tiledImageView;
+
+  // The image view is stretched to the full size of the photo so that whatever it was showing
+  // stays visible beneath tiles that haven't been drawn yet.
+  CGSize imageSize = tiledImageView.imageSize;
+  _scrollView.zoomScale = 1;
+  _imageView.frame = CGRectMake(0, 0, imageSize.width, imageSize.height);
+  tiledImageView.frame = _imageView.bounds;
+  [_imageView addSubview:tiledImageView];
+
+  self.photoSize = NIPhotoScrollViewPhotoSizeOriginal;
+  _scrollView.contentSize = imageSize;
+
+  [self setMaxMinZoomScalesForCurrentBounds];
+
+  // Start off with the image fully-visible on the screen.
+  _scrollView.zoomScale = _scrollView.minimumZoomScale;
+
+  [self setNeedsLayout];
+
+  return YES;
+}
+
+- (void)reduceMemoryUsage {
+  [_tiledImageView reduceMemoryUsage];
+}
+
 - (void)setLoading:(BOOL)loading {
   _loading = loading;
 
@@ -274,7 +319,7 @@
 - (void)setZoomingIsEnabled:(BOOL)enabled {
   _zoomingIsEnabled = enabled;
 
-  if (nil != _imageView.image) {
+  if (nil != _imageView.image || nil != _tiledImageView) {
     [self setMaxMinZoomScalesForCurrentBounds];
 
     // Fit the image on screen.
@@ -393,10 +438,13 @@
   CGFloat minScale = 0;
   CGFloat maxScale = 0;
   
+  // Tiled photos are laid out at one point per pixel.
+  CGFloat photoScale = (nil != _tiledImageView) ? 1 : _imageView.image.scale;
+
   // Calculate the min/max scale for the image to be presented.
   [self minAndMaxScaleForDimensions: imageSize
                          boundsSize: boundsSize
-                         photoScale: _imageView.image.scale
+                         photoScale: photoScale
                           photoSize: self.photoSize
                            minScale: &minScale
                            maxScale: &maxScale];
@@ -19,6 +19,7 @@
 
 #import "NIPreprocessorMacros.h" /* for weak */
 
+@class NIImageTable;
 @protocol NIPhotoScrubberViewDataSource;
 @protocol NIPhotoScrubberViewDelegate;
 
@@ -75,6 +76,47 @@
 - (void)didLoadThumbnail: (UIImage *)image
                  atIndex: (NSInteger)photoIndex;
 
+#pragma mark Caching Thumbnails /** @name Caching Thumbnails */
+
+/**
+ * An image table that keeps the scrubber's thumbnails.
+ *
+ * When the data source implements photoScrubberView:thumbnailNameAtIndex:, thumbnails are looked
+ * up in the table before the data source is asked for them, and every thumbnail the data source
+ * provides is drawn into the table for next time. Because the table's images are backed by its
+ * mapped file, a scrubber with a table can show hundreds of thumbnails without decoding them or
+ * holding their pixels in malloced memory.
+ *
+ * The table's image size should match the size of the scrubber's thumbnails.
+ *
+ * By default this is nil.
+ */
+@property (nonatomic, strong) NIImageTable* thumbnailTable;
+
+/**
+ * Lets go of every thumbnail that isn't on screen.
+ *
+ * Recycled thumbnail views are released and, when usesThumbnailAtlas is enabled, the thumbnails
+ * that the atlas was drawn from are forgotten. The atlas itself stays on screen and its
+ * thumbnails are asked for again on the next layout pass.
+ */
+- (void)reduceMemoryUsage;
+
+#pragma mark Rendering Thumbnails /** @name Rendering Thumbnails */
+
+/**
+ * Whether the thumbnails are composited into a single image instead of one view each.
+ *
+ * When enabled, the sampled thumbnails are drawn into one backing image on a background queue
+ * and the scrubber shows that image in a single layer. The image is redrawn as thumbnails load,
+ * with loads that arrive together coalesced into one redraw. Layout then costs the same no
+ * matter how many photos the album has, which keeps scrubbing smooth on albums with thousands
+ * of photos. The selected thumbnail is still its own view.
+ *
+ * By default this is NO.
+ */
+@property (nonatomic, assign) BOOL usesThumbnailAtlas;
+
 #pragma mark Delegate /** @name Delegate */
 
 /**
@@ -141,6 +183,37 @@
 - (UIImage *)photoScrubberView: (NIPhotoScrubberView *)photoScrubberView
               thumbnailAtIndex: (NSInteger)thumbnailIndex;
 
+@optional
+
+#pragma mark Fetching Thumbnails in Bulk /** @name Fetching Thumbnails in Bulk */
+
+/**
+ * Fetch the thumbnail images for several photo indexes at once.
+ *
+ * When implemented, the scrubber calls this once per layout pass for every thumbnail that
+ * needs an image, instead of calling photoScrubberView:thumbnailAtIndex: for each one. This
+ * lets a data source that keeps its thumbnails in an NIMemoryCache fetch them all with a single
+ * call to NIMemoryCache::objectsWithNames:.
+ *
+ * @returns A dictionary mapping NSNumber photo indexes to UIImage thumbnails. Indexes whose
+ *               thumbnails aren't available yet may be left out.
+ */
+- (NSDictionary *)photoScrubberView: (NIPhotoScrubberView *)photoScrubberView
+                thumbnailsAtIndexes: (NSIndexSet *)thumbnailIndexes;
+
+#pragma mark Caching Thumbnails /** @name Caching Thumbnails */
+
+/**
+ * Fetch a name that uniquely identifies the thumbnail for the given photo index.
+ *
+ * The name is used to store the thumbnail in the scrubber's thumbnailTable, so it must stay the
+ * same for a given photo across launches. A photo's URL is a good choice.
+ *
+ * @returns The thumbnail's name, or nil if the thumbnail should not be kept in the table.
+ */
+- (NSString *)photoScrubberView: (NIPhotoScrubberView *)photoScrubberView
+          thumbnailNameAtIndex: (NSInteger)thumbnailIndex;
+
 @end
 
 /**
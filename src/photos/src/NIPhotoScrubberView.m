@@ -26,6 +26,28 @@
 
 static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
 
+// Atlases are drawn off the main thread, one at a time.
+static dispatch_queue_t NIPhotoScrubberViewAtlasQueue(void) {
+  static dispatch_queue_t queue = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    queue = dispatch_queue_create("com.nimbuskit.photoscrubber.atlas", DISPATCH_QUEUE_SERIAL);
+  });
+  return queue;
+}
+
+// The rect that draws an image of the given size so that it fills the frame, like
+// UIViewContentModeScaleAspectFill.
+static CGRect NIPhotoScrubberViewAspectFillRect(CGSize imageSize, CGRect frame) {
+  if (imageSize.width <= 0 || imageSize.height <= 0) {
+    return frame;
+  }
+  CGFloat scale = MAX(frame.size.width / imageSize.width, frame.size.height / imageSize.height);
+  CGSize size = CGSizeMake(imageSize.width * scale, imageSize.height * scale);
+  return CGRectMake(CGRectGetMidX(frame) - size.width / 2, CGRectGetMidY(frame) - size.height / 2,
+                    size.width, size.height);
+}
+
 @interface NIPhotoScrubberView()
 
 /**
@@ -74,6 +96,15 @@ static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
 
   // Cached display values
   NSInteger _numberOfVisiblePhotos;
+
+  // Thumbnail atlas
+  CALayer* _atlasLayer;
+  NSArray* _atlasPhotoIndexes;
+  NSMutableDictionary* _atlasThumbnails; // NSNumber photo index => UIImage
+  NSMutableIndexSet* _atlasRequestedPhotoIndexes;
+  CGSize _atlasSize;
+  NSUInteger _atlasGeneration;
+  BOOL _atlasRedrawIsScheduled;
 }
 
 - (id)initWithFrame:(CGRect)frame {
@@ -107,6 +138,9 @@ static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
     [self addSubview:_selectionView];
     
     _selectedPhotoIndex = -1;
+
+    _atlasThumbnails = [[NSMutableDictionary alloc] init];
+    _atlasRequestedPhotoIndexes = [[NSMutableIndexSet alloc] init];
 }
 
 #pragma mark - View Creation
@@ -281,6 +315,11 @@ static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
   // This will update the number of visible photos if the layout did indeed change.
   [self layoutIfNeeded];
 
+  if (self.usesThumbnailAtlas) {
+    [self updateThumbnailAtlas];
+    return;
+  }
+
   // Recycle any views that we no longer need.
   while ([_visiblePhotoViews count] > (NSUInteger)_numberOfVisiblePhotos) {
     UIView* photoView = [_visiblePhotoViews lastObject];
@@ -291,6 +330,10 @@ static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
     [_visiblePhotoViews removeLastObject];
   }
 
+  // The photo views whose photo index has changed, and so need a new thumbnail.
+  NSMutableArray* photoViewsNeedingThumbnails = [NSMutableArray array];
+  NSMutableIndexSet* photoIndexesNeedingThumbnails = [NSMutableIndexSet indexSet];
+
   // Lay out the visible photos.
   for (NSUInteger ix = 0; ix < (NSUInteger)_numberOfVisiblePhotos; ++ix) {
     UIImageView* photoView = nil;
@@ -321,16 +364,247 @@ static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
     if (photoView.tag != photoIndex) {
       photoView.tag = photoIndex;
 
-      UIImage* image = [self.dataSource photoScrubberView:self thumbnailAtIndex:photoIndex];
-      photoView.image = image;
+      [photoViewsNeedingThumbnails addObject:photoView];
+      [photoIndexesNeedingThumbnails addIndex:(NSUInteger)photoIndex];
+    }
 
-      if (_selectedPhotoIndex == photoIndex) {
-        _selectionView.image = image;
+    photoView.frame = [self frameForThumbAtIndex:ix];
+  }
+
+  if (0 == photoViewsNeedingThumbnails.count) {
+    return;
+  }
+
+  NSDictionary* thumbnails = [self thumbnailsAtIndexes:photoIndexesNeedingThumbnails];
+
+  for (UIImageView* photoView in photoViewsNeedingThumbnails) {
+    NSInteger photoIndex = photoView.tag;
+    UIImage* image = thumbnails[@(photoIndex)];
+    photoView.image = image;
+
+    if (_selectedPhotoIndex == photoIndex) {
+      _selectionView.image = image;
+    }
+  }
+}
+
+// Returns whichever of the thumbnails at the given indexes are available, keyed by NSNumber
+// photo index.
+- (NSDictionary *)thumbnailsAtIndexes:(NSIndexSet *)photoIndexes {
+  NSMutableIndexSet* photoIndexesNeedingThumbnails = [photoIndexes mutableCopy];
+  NSMutableDictionary* thumbnails = [NSMutableDictionary dictionary];
+
+  // Thumbnails in the table are ready to display without asking the data source.
+  if (nil != self.thumbnailTable) {
+    [photoIndexesNeedingThumbnails enumerateIndexesUsingBlock:^(NSUInteger photoIndex, BOOL *stop) {
+      NSString* name = [self thumbnailNameAtIndex:(NSInteger)photoIndex];
+      UIImage* image = (nil != name) ? [self.thumbnailTable imageWithName:name] : nil;
+      if (nil != image) {
+        thumbnails[@(photoIndex)] = image;
       }
+    }];
+    for (NSNumber* photoIndex in thumbnails) {
+      [photoIndexesNeedingThumbnails removeIndex:[photoIndex unsignedIntegerValue]];
     }
+  }
 
-    photoView.frame = [self frameForThumbAtIndex:ix];
+  if (0 == photoIndexesNeedingThumbnails.count) {
+    return thumbnails;
+  }
+
+  // Fetch all of the thumbnails at once if the data source can, which lets a data source
+  // backed by a memory cache look them all up with a single lock.
+  NSDictionary* bulkThumbnails = nil;
+  if ([self.dataSource respondsToSelector:@selector(photoScrubberView:thumbnailsAtIndexes:)]) {
+    bulkThumbnails = [self.dataSource photoScrubberView:self thumbnailsAtIndexes:photoIndexesNeedingThumbnails];
+  }
+
+  [photoIndexesNeedingThumbnails enumerateIndexesUsingBlock:^(NSUInteger photoIndex, BOOL *stop) {
+    UIImage* image = nil;
+    if (nil != bulkThumbnails) {
+      image = bulkThumbnails[@(photoIndex)];
+
+    } else {
+      image = [self.dataSource photoScrubberView:self thumbnailAtIndex:(NSInteger)photoIndex];
+    }
+    [self storeThumbnail:image atIndex:(NSInteger)photoIndex];
+    if (nil != image) {
+      thumbnails[@(photoIndex)] = image;
+    }
+  }];
+
+  return thumbnails;
+}
+
+#pragma mark - Thumbnail Atlas
+
+
+- (void)removeThumbnailAtlas {
+  [_atlasLayer removeFromSuperlayer];
+  _atlasLayer = nil;
+  _atlasPhotoIndexes = nil;
+  [_atlasThumbnails removeAllObjects];
+  [_atlasRequestedPhotoIndexes removeAllIndexes];
+  _atlasSize = CGSizeZero;
+
+  // Any atlas that is still being drawn is now stale.
+  ++_atlasGeneration;
+}
+
+- (void)updateThumbnailAtlas {
+  if (nil == _atlasLayer) {
+    _atlasLayer = [CALayer layer];
+    _atlasLayer.contentsScale = NIScreenScale();
+    [_containerView.layer addSublayer:_atlasLayer];
+  }
+  _atlasLayer.frame = _containerView.bounds;
+
+  NSMutableArray* photoIndexes = [NSMutableArray arrayWithCapacity:(NSUInteger)_numberOfVisiblePhotos];
+  NSMutableIndexSet* sampledPhotoIndexes = [NSMutableIndexSet indexSet];
+  for (NSInteger ix = 0; ix < _numberOfVisiblePhotos; ++ix) {
+    NSInteger photoIndex = [self photoIndexAtScrubberIndex:ix];
+    [photoIndexes addObject:@(photoIndex)];
+    [sampledPhotoIndexes addIndex:(NSUInteger)photoIndex];
+  }
+
+  BOOL needsRedraw = (![photoIndexes isEqualToArray:_atlasPhotoIndexes]
+                      || !CGSizeEqualToSize(_containerView.bounds.size, _atlasSize));
+  _atlasPhotoIndexes = photoIndexes;
+  _atlasSize = _containerView.bounds.size;
+
+  // Forget the photos that are no longer sampled so that they are asked for again if they come
+  // back.
+  for (NSNumber* photoIndex in [_atlasThumbnails allKeys]) {
+    if (![sampledPhotoIndexes containsIndex:[photoIndex unsignedIntegerValue]]) {
+      [_atlasThumbnails removeObjectForKey:photoIndex];
+    }
+  }
+  NSMutableIndexSet* unsampledPhotoIndexes = [_atlasRequestedPhotoIndexes mutableCopy];
+  [unsampledPhotoIndexes removeIndexes:sampledPhotoIndexes];
+  [_atlasRequestedPhotoIndexes removeIndexes:unsampledPhotoIndexes];
+
+  // Like the photo views, only ask for each thumbnail once; the rest arrive through
+  // didLoadThumbnail:atIndex:.
+  NSMutableIndexSet* photoIndexesNeedingThumbnails = [sampledPhotoIndexes mutableCopy];
+  [photoIndexesNeedingThumbnails removeIndexes:_atlasRequestedPhotoIndexes];
+  if (photoIndexesNeedingThumbnails.count > 0) {
+    [_atlasRequestedPhotoIndexes addIndexes:photoIndexesNeedingThumbnails];
+
+    NSDictionary* thumbnails = [self thumbnailsAtIndexes:photoIndexesNeedingThumbnails];
+    if (thumbnails.count > 0) {
+      [_atlasThumbnails addEntriesFromDictionary:thumbnails];
+      needsRedraw = YES;
+    }
+    if (_selectedPhotoIndex >= 0 && nil != thumbnails[@(_selectedPhotoIndex)]) {
+      _selectionView.image = thumbnails[@(_selectedPhotoIndex)];
+    }
+  }
+
+  if (needsRedraw) {
+    [self setNeedsAtlasRedraw];
+  }
+}
+
+// Coalesces every change made during this turn of the run loop into a single redraw.
+- (void)setNeedsAtlasRedraw {
+  if (_atlasRedrawIsScheduled) {
+    return;
+  }
+  _atlasRedrawIsScheduled = YES;
+
+  __weak NIPhotoScrubberView* weakSelf = self;
+  dispatch_async(dispatch_get_main_queue(), ^{
+    [weakSelf redrawAtlas];
+  });
+}
+
+- (void)redrawAtlas {
+  _atlasRedrawIsScheduled = NO;
+  if (nil == _atlasLayer) {
+    return;
+  }
+
+  NSUInteger generation = ++_atlasGeneration;
+  CGSize atlasSize = _atlasSize;
+  if (atlasSize.width <= 0 || atlasSize.height <= 0) {
+    _atlasLayer.contents = nil;
+    return;
+  }
+
+  // Snapshot everything the background queue needs.
+  NSMutableArray* frames = [NSMutableArray arrayWithCapacity:_atlasPhotoIndexes.count];
+  NSMutableArray* images = [NSMutableArray arrayWithCapacity:_atlasPhotoIndexes.count];
+  [_atlasPhotoIndexes enumerateObjectsUsingBlock:^(NSNumber* photoIndex, NSUInteger ix, BOOL *stop) {
+    [frames addObject:[NSValue valueWithCGRect:[self frameForThumbAtIndex:(NSInteger)ix]]];
+    UIImage* image = _atlasThumbnails[photoIndex];
+    [images addObject:(nil != image) ? image : [NSNull null]];
+  }];
+  CGFloat scale = NIScreenScale();
+
+  __weak NIPhotoScrubberView* weakSelf = self;
+  dispatch_async(NIPhotoScrubberViewAtlasQueue(), ^{
+    UIGraphicsBeginImageContextWithOptions(atlasSize, NO, scale);
+    CGContextRef context = UIGraphicsGetCurrentContext();
+
+    // Each thumbnail is drawn the way photoView styles its image views.
+    [frames enumerateObjectsUsingBlock:^(NSValue* frameValue, NSUInteger ix, BOOL *stop) {
+      CGRect frame = [frameValue CGRectValue];
+      [[UIColor blackColor] setFill];
+      UIRectFill(frame);
+
+      id image = images[ix];
+      if ([image isKindOfClass:[UIImage class]]) {
+        CGContextSaveGState(context);
+        UIRectClip(frame);
+        [(UIImage *)image drawInRect:NIPhotoScrubberViewAspectFillRect([(UIImage *)image size], frame)];
+        CGContextRestoreGState(context);
+      }
+
+      [[UIColor whiteColor] setStroke];
+      UIRectFrame(frame);
+    }];
+
+    UIImage* atlas = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+      [weakSelf didRedrawAtlas:atlas generation:generation];
+    });
+  });
+}
+
+- (void)didRedrawAtlas:(UIImage *)atlas generation:(NSUInteger)generation {
+  // A newer atlas has been requested since this one was drawn.
+  if (generation != _atlasGeneration) {
+    return;
+  }
+  _atlasLayer.contents = (__bridge id)atlas.CGImage;
+}
+
+#pragma mark - Thumbnail Table
+
+
+- (NSString *)thumbnailNameAtIndex:(NSInteger)photoIndex {
+  if (![self.dataSource respondsToSelector:@selector(photoScrubberView:thumbnailNameAtIndex:)]) {
+    return nil;
   }
+  return [self.dataSource photoScrubberView:self thumbnailNameAtIndex:photoIndex];
+}
+
+- (void)storeThumbnail:(UIImage *)image atIndex:(NSInteger)photoIndex {
+  NIImageTable* thumbnailTable = self.thumbnailTable;
+  if (nil == thumbnailTable || nil == image) {
+    return;
+  }
+  NSString* name = [self thumbnailNameAtIndex:photoIndex];
+  if (nil == name || [thumbnailTable containsImageWithName:name]) {
+    return;
+  }
+
+  // Drawing into the table is cheap but shouldn't hold up scrubbing.
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+    [thumbnailTable storeImage:image withName:name];
+  });
 }
 
 #pragma mark - Changing Selection
@@ -394,6 +668,15 @@ static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
 
 - (void)didLoadThumbnail: (UIImage *)image
                  atIndex: (NSInteger)photoIndex {
+  [self storeThumbnail:image atIndex:photoIndex];
+
+  if (self.usesThumbnailAtlas) {
+    if (nil != image && [_atlasPhotoIndexes containsObject:@(photoIndex)]) {
+      _atlasThumbnails[@(photoIndex)] = image;
+      [self setNeedsAtlasRedraw];
+    }
+  }
+
   for (UIImageView* thumbView in _visiblePhotoViews) {
     if (thumbView.tag == photoIndex) {
       thumbView.image = image;
@@ -422,6 +705,7 @@ static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
 
   _visiblePhotoViews = [[NSMutableArray alloc] init];
   _recycledPhotoViews = [[NSMutableSet alloc] init];
+  [self removeThumbnailAtlas];
 
   // Cache the number of photos.
   _numberOfPhotos = [_dataSource numberOfPhotosInScrubberView:self];
@@ -462,4 +746,33 @@ static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
   [self setSelectedPhotoIndex:photoIndex animated:NO];
 }
 
+- (void)reduceMemoryUsage {
+  [_recycledPhotoViews removeAllObjects];
+
+  [_atlasThumbnails removeAllObjects];
+  [_atlasRequestedPhotoIndexes removeAllIndexes];
+
+  // Ask for the forgotten thumbnails again so that the next redraw doesn't lose them.
+  if (self.usesThumbnailAtlas) {
+    [self setNeedsLayout];
+  }
+}
+
+- (void)setUsesThumbnailAtlas:(BOOL)usesThumbnailAtlas {
+  if (_usesThumbnailAtlas == usesThumbnailAtlas) {
+    return;
+  }
+  _usesThumbnailAtlas = usesThumbnailAtlas;
+
+  // Start over with whichever way of drawing thumbnails is now in use.
+  for (UIView* photoView in _visiblePhotoViews) {
+    [photoView removeFromSuperview];
+  }
+  [_visiblePhotoViews removeAllObjects];
+  [_recycledPhotoViews removeAllObjects];
+  [self removeThumbnailAtlas];
+
+  [self setNeedsLayout];
+}
+
 @end
@@ -0,0 +1,82 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+#import <ImageIO/ImageIO.h>
+
+/**
+ * A view that draws a very large image in tiles, decoding only what is on screen.
+ *
+ * The view is backed by a CATiledLayer and is sized to the image's pixel dimensions, one point
+ * per pixel. Tiles are drawn on background threads as they become visible. Each tile is cut from
+ * an image of the source decoded at the resolution of the current zoom level, so a zoomed-out
+ * 40 megapixel photo costs no more than the screen it is drawn on.
+ *
+ * @ingroup NimbusPhotos
+ */
+@interface NITiledImageView : UIView
+
+// Designated initializer.
+- (id)initWithImageSource:(CGImageSourceRef)imageSource;
+- (id)initWithContentsOfURL:(NSURL *)url;
+
+@property (nonatomic, readonly) CGImageSourceRef imageSource;
+@property (nonatomic, readonly) CGSize imageSize;
+
+- (void)reduceMemoryUsage;
+
+@end
+
+/**
+ * Initializes a tiled image view that draws the first image of the given image source.
+ *
+ * The source is retained. Only the image's properties are read here; nothing is decoded until
+ * the first tile is drawn.
+ *
+ * Returns nil if the source does not contain an image with known dimensions.
+ *
+ * @fn NITiledImageView::initWithImageSource:
+ */
+
+/**
+ * Initializes a tiled image view that draws the image stored at the given file URL.
+ *
+ * @fn NITiledImageView::initWithContentsOfURL:
+ */
+
+/**
+ * The image source that tiles are decoded from.
+ *
+ * @fn NITiledImageView::imageSource
+ */
+
+/**
+ * The dimensions of the image in pixels, with its EXIF orientation applied.
+ *
+ * This is also the size of the view's bounds.
+ *
+ * @fn NITiledImageView::imageSize
+ */
+
+/**
+ * Releases the decoded images that tiles are cut from.
+ *
+ * Tiles that have already been drawn stay on screen; new tiles will decode again on demand.
+ *
+ * @fn NITiledImageView::reduceMemoryUsage
+ */
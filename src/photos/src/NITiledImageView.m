@@ -0,0 +1,200 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NITiledImageView.h"
+
+#import "NimbusCore.h"
+
+#import <QuartzCore/QuartzCore.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// The width and height of a tile in pixels.
+static const CGFloat kTileSide = 512;
+
+// Decoded levels are large, so keep the one being drawn and the one we've just zoomed away from.
+static const NSUInteger kMaximumNumberOfCachedLevels = 2;
+
+@implementation NITiledImageView {
+  CGImageSourceRef _imageSource;
+  CGSize _imageSize;
+  NSUInteger _maximumDownsampleFactor;
+
+  // Maps downsample factors to images decoded at that resolution.
+  NSCache* _levelImages;
+}
+
++ (Class)layerClass {
+  return [CATiledLayer class];
+}
+
+- (void)dealloc {
+  if (nil != _imageSource) {
+    CFRelease(_imageSource);
+  }
+}
+
+- (id)initWithFrame:(CGRect)frame {
+  return [self initWithImageSource:nil];
+}
+
+- (id)initWithContentsOfURL:(NSURL *)url {
+  CGImageSourceRef imageSource = (nil != url
+                                  ? CGImageSourceCreateWithURL((__bridge CFURLRef)url, NULL)
+                                  : nil);
+  self = [self initWithImageSource:imageSource];
+  if (nil != imageSource) {
+    CFRelease(imageSource);
+  }
+  return self;
+}
+
+- (id)initWithImageSource:(CGImageSourceRef)imageSource {
+  if (nil == imageSource || CGImageSourceGetCount(imageSource) == 0) {
+    return nil;
+  }
+
+  // Reading the properties only parses the image header; nothing is decoded yet.
+  NSDictionary* properties = (__bridge_transfer NSDictionary *)CGImageSourceCopyPropertiesAtIndex(imageSource, 0, NULL);
+  CGSize imageSize = CGSizeMake([properties[(__bridge NSString *)kCGImagePropertyPixelWidth] floatValue],
+                                [properties[(__bridge NSString *)kCGImagePropertyPixelHeight] floatValue]);
+  if (imageSize.width <= 0 || imageSize.height <= 0) {
+    return nil;
+  }
+
+  // EXIF orientations 5 through 8 are rotated by 90 degrees. Every level is decoded with the
+  // orientation applied, so the view is laid out in the rotated dimensions.
+  NSInteger orientation = [properties[(__bridge NSString *)kCGImagePropertyOrientation] integerValue];
+  if (orientation >= 5 && orientation <= 8) {
+    imageSize = CGSizeMake(imageSize.height, imageSize.width);
+  }
+
+  if ((self = [super initWithFrame:CGRectMake(0, 0, imageSize.width, imageSize.height)])) {
+    _imageSource = (CGImageSourceRef)CFRetain(imageSource);
+    _imageSize = imageSize;
+
+    _levelImages = [[NSCache alloc] init];
+    _levelImages.countLimit = kMaximumNumberOfCachedLevels;
+
+    // Halve the resolution until the whole image fits in a single tile.
+    size_t levelsOfDetail = 1;
+    CGFloat longestSide = MAX(imageSize.width, imageSize.height);
+    while (longestSide / (CGFloat)(1 << levelsOfDetail) >= kTileSide && levelsOfDetail < 16) {
+      ++levelsOfDetail;
+    }
+    _maximumDownsampleFactor = 1 << (levelsOfDetail - 1);
+
+    CATiledLayer* tiledLayer = (CATiledLayer *)self.layer;
+    tiledLayer.tileSize = CGSizeMake(kTileSide, kTileSide);
+    tiledLayer.levelsOfDetail = levelsOfDetail;
+
+    self.opaque = NO;
+    self.backgroundColor = [UIColor clearColor];
+  }
+  return self;
+}
+
+#pragma mark - Decoding
+
+// The largest power of two that can be skipped without losing pixels at the given scale.
+- (NSUInteger)downsampleFactorForScale:(CGFloat)scale {
+  NSUInteger factor = 1;
+  while (factor < _maximumDownsampleFactor && (CGFloat)(factor * 2) * scale <= 1 + FLT_EPSILON) {
+    factor *= 2;
+  }
+  return factor;
+}
+
+- (UIImage *)imageForDownsampleFactor:(NSUInteger)factor {
+  NSNumber* key = @(factor);
+  UIImage* image = [_levelImages objectForKey:key];
+  if (nil != image) {
+    return image;
+  }
+
+  // Tiles are drawn on several threads at once; make sure each level is only decoded once.
+  @synchronized(self) {
+    image = [_levelImages objectForKey:key];
+    if (nil == image) {
+      CGFloat longestSide = MAX(_imageSize.width, _imageSize.height);
+      NSDictionary* options = @{
+        (__bridge NSString *)kCGImageSourceCreateThumbnailFromImageAlways: @YES,
+        (__bridge NSString *)kCGImageSourceCreateThumbnailWithTransform: @YES,
+        (__bridge NSString *)kCGImageSourceShouldCacheImmediately: @YES,
+        (__bridge NSString *)kCGImageSourceThumbnailMaxPixelSize: @(ceil(longestSide / (CGFloat)factor)),
+      };
+      CGImageRef imageRef = CGImageSourceCreateThumbnailAtIndex(_imageSource, 0,
+                                                                (__bridge CFDictionaryRef)options);
+      if (nil != imageRef) {
+        image = [UIImage imageWithCGImage:imageRef];
+        CGImageRelease(imageRef);
+
+        [_levelImages setObject:image forKey:key];
+      }
+    }
+  }
+  return image;
+}
+
+#pragma mark - UIView
+
+// Called by the tiled layer on background threads, once for each tile.
+- (void)drawRect:(CGRect)rect {
+  CGContextRef context = UIGraphicsGetCurrentContext();
+
+  // One point in this view is one image pixel, so the context's scale is the number of device
+  // pixels that each image pixel covers at the level of detail being drawn.
+  CGFloat scale = (CGFloat)fabs(CGContextGetCTM(context).a);
+  UIImage* levelImage = [self imageForDownsampleFactor:[self downsampleFactorForScale:scale]];
+  if (nil == levelImage) {
+    return;
+  }
+
+  // The decoded level may have been rounded, so map each axis separately.
+  CGImageRef levelImageRef = levelImage.CGImage;
+  CGSize levelSize = CGSizeMake(CGImageGetWidth(levelImageRef), CGImageGetHeight(levelImageRef));
+  CGFloat xRatio = levelSize.width / _imageSize.width;
+  CGFloat yRatio = levelSize.height / _imageSize.height;
+
+  CGRect levelRect = CGRectIntegral(CGRectMake(rect.origin.x * xRatio, rect.origin.y * yRatio,
+                                               rect.size.width * xRatio, rect.size.height * yRatio));
+  levelRect = CGRectIntersection(levelRect, CGRectMake(0, 0, levelSize.width, levelSize.height));
+  if (CGRectIsEmpty(levelRect)) {
+    return;
+  }
+
+  CGImageRef tileRef = CGImageCreateWithImageInRect(levelImageRef, levelRect);
+  if (nil == tileRef) {
+    return;
+  }
+  // Drawing through UIImage takes care of UIKit's flipped coordinate space.
+  UIImage* tile = [UIImage imageWithCGImage:tileRef];
+  CGImageRelease(tileRef);
+
+  [tile drawInRect:CGRectMake(levelRect.origin.x / xRatio, levelRect.origin.y / yRatio,
+                              levelRect.size.width / xRatio, levelRect.size.height / yRatio)];
+}
+
+#pragma mark - Public
+
+- (void)reduceMemoryUsage {
+  [_levelImages removeAllObjects];
+}
+
+@end
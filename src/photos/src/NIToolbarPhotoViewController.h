@@ -95,6 +95,7 @@
 
 - (void)setChromeVisibility:(BOOL)isVisible animated:(BOOL)animated;
 - (void)setChromeTitle;
+- (void)reduceMemoryUsageForPressureLevel:(NIMemoryPressureLevel)level;
 
 @end
 
@@ -199,3 +200,17 @@
  *
  * @fn NIToolbarPhotoViewController::previousButton
  */
+
+
+/** @name Subclassing */
+
+/**
+ * Called when the NIMemoryPressureCoordinator reports a change in memory pressure.
+ *
+ * Under warning or critical pressure only the center photo is kept at its original size (see
+ * NIPhotoAlbumScrollView::limitsOriginalPhotosToCenterPage) and the scrubber lets go of its
+ * off-screen thumbnails. Once the pressure is back to normal the album restores the originals
+ * while the app is idle. Call super if you override this to free memory of your own.
+ *
+ * @fn NIToolbarPhotoViewController::reduceMemoryUsageForPressureLevel:
+ */
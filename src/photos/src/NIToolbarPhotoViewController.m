@@ -53,6 +53,10 @@
 }
 
 
+- (void)dealloc {
+  [[NIMemoryPressureCoordinator sharedCoordinator] removeObserver:self];
+}
+
 - (void)shutdown_NIToolbarPhotoViewController {
   _toolbar = nil;
   _photoAlbumView = nil;
@@ -80,6 +84,9 @@
 
     // Allow the photos to display beneath the status bar.
     self.wantsFullScreenLayout = YES;
+
+    [[NIMemoryPressureCoordinator sharedCoordinator] addObserver:self
+                                                         selector:@selector(didReceiveMemoryPressure:)];
   }
   return self;
 }
@@ -203,6 +210,8 @@
   _photoAlbumView.autoresizingMask = (UIViewAutoresizingFlexibleWidth
                                       | UIViewAutoresizingFlexibleHeight);
   _photoAlbumView.delegate = self;
+  _photoAlbumView.limitsOriginalPhotosToCenterPage =
+    ([NIMemoryPressureCoordinator sharedCoordinator].level >= NIMemoryPressureLevelWarning);
 
   [self.view addSubview:_photoAlbumView];
   [self.view addSubview:_toolbar];
@@ -262,6 +271,12 @@
   }
 }
 
+- (void)didRotateFromInterfaceOrientation:(UIInterfaceOrientation)fromInterfaceOrientation {
+  [super didRotateFromInterfaceOrientation:fromInterfaceOrientation];
+
+  [self.photoAlbumView didRotateFromInterfaceOrientation:fromInterfaceOrientation];
+}
+
 - (UIView *)rotatingFooterView {
   return self.toolbar.hidden ? nil : self.toolbar;
 }
@@ -397,6 +412,29 @@
   [self setChromeVisibility:(_isChromeHidden || _isAnimatingChrome) animated:YES];
 }
 
+#pragma mark - Memory Pressure
+
+
+- (void)didReceiveMemoryPressure:(NSNotification *)notification {
+  [self reduceMemoryUsageForPressureLevel:NIMemoryPressureLevelFromNotification(notification)];
+}
+
+- (void)reduceMemoryUsageForPressureLevel:(NIMemoryPressureLevel)level {
+  switch (level) {
+    case NIMemoryPressureLevelNormal:
+      // The album brings the originals back on its own time.
+      self.photoAlbumView.limitsOriginalPhotosToCenterPage = NO;
+      break;
+    case NIMemoryPressureLevelBackground:
+      break;
+    case NIMemoryPressureLevelWarning:
+    case NIMemoryPressureLevelCritical:
+      self.photoAlbumView.limitsOriginalPhotosToCenterPage = YES;
+      [self.photoScrubberView reduceMemoryUsage];
+      break;
+  }
+}
+
 #pragma mark - UIGestureRecognizer
 
 
@@ -116,6 +116,7 @@
 #import "NIPhotoScrollViewDelegate.h"
 #import "NIPhotoScrollViewPhotoSize.h"
 #import "NIPhotoScrubberView.h"
+#import "NITiledImageView.h"
 #import "NIToolbarPhotoViewController.h"
 
 #import "NimbusPagingScrollView.h"
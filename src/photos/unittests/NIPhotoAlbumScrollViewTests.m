@@ -0,0 +1,121 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NimbusPhotos.h"
+#import "NIPagingScrollView+Subclassing.h"
+
+@interface NIPhotoAlbumScrollViewTests : XCTestCase <NIPhotoAlbumScrollViewDataSource>
+@property (nonatomic, assign) BOOL hasOriginals;
+@end
+
+
+@implementation NIPhotoAlbumScrollViewTests
+
+
+- (NSInteger)numberOfPagesInPagingScrollView:(NIPagingScrollView *)pagingScrollView {
+  return 5;
+}
+
+- (UIView<NIPagingScrollViewPage> *)pagingScrollView:(NIPagingScrollView *)pagingScrollView pageViewForIndex:(NSInteger)pageIndex {
+  return [(NIPhotoAlbumScrollView *)pagingScrollView pagingScrollView:pagingScrollView pageViewForIndex:pageIndex];
+}
+
+- (UIImage *)photoAlbumScrollView: (NIPhotoAlbumScrollView *)photoAlbumScrollView
+                     photoAtIndex: (NSInteger)photoIndex
+                        photoSize: (NIPhotoScrollViewPhotoSize *)photoSize
+                        isLoading: (BOOL *)isLoading
+          originalPhotoDimensions: (CGSize *)originalPhotoDimensions {
+  if (self.hasOriginals) {
+    *photoSize = NIPhotoScrollViewPhotoSizeOriginal;
+    return [self image];
+  }
+  *isLoading = YES;
+  return nil;
+}
+
+- (UIImage *)image {
+  UIGraphicsBeginImageContextWithOptions(CGSizeMake(1000, 1000), YES, 1);
+  UIImage* image = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  return image;
+}
+
+- (NIPhotoScrollView *)pageAtIndex:(NSInteger)pageIndex inAlbum:(NIPhotoAlbumScrollView *)album {
+  for (NIPhotoScrollView* page in album.visiblePages) {
+    if (page.pageIndex == pageIndex) {
+      return page;
+    }
+  }
+  return nil;
+}
+
+- (void)testOriginalsDisplayCenterPageFirst {
+  NIPhotoAlbumScrollView* album = [[NIPhotoAlbumScrollView alloc] initWithFrame:CGRectMake(0, 0, 320, 480)];
+  album.dataSource = self;
+  [album reloadData];
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  while (nil == [self pageAtIndex:1 inAlbum:album] && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  NIPhotoScrollView* neighbor = [self pageAtIndex:1 inAlbum:album];
+  XCTAssertNotNil(neighbor, @"The next page should have been preloaded.");
+
+  [album didLoadPhoto:[self image] atIndex:1 photoSize:NIPhotoScrollViewPhotoSizeOriginal];
+  XCTAssertEqual(neighbor.photoSize, NIPhotoScrollViewPhotoSizeUnknown, @"Neighbors wait for the main thread to be idle.");
+
+  [album didLoadPhoto:[self image] atIndex:0 photoSize:NIPhotoScrollViewPhotoSizeOriginal];
+  XCTAssertEqual([self pageAtIndex:0 inAlbum:album].photoSize, NIPhotoScrollViewPhotoSizeOriginal, @"The center page is displayed right away.");
+
+  timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  while (NIPhotoScrollViewPhotoSizeOriginal != neighbor.photoSize && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertEqual(neighbor.photoSize, NIPhotoScrollViewPhotoSizeOriginal, @"The neighbor should have been displayed once idle.");
+}
+
+- (void)testLimitingOriginalsToCenterPage {
+  self.hasOriginals = YES;
+  NIPhotoAlbumScrollView* album = [[NIPhotoAlbumScrollView alloc] initWithFrame:CGRectMake(0, 0, 320, 480)];
+  album.dataSource = self;
+  [album reloadData];
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  while (nil == [self pageAtIndex:1 inAlbum:album] && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  NIPhotoScrollView* neighbor = [self pageAtIndex:1 inAlbum:album];
+  XCTAssertEqual(neighbor.photoSize, NIPhotoScrollViewPhotoSizeOriginal, @"The data source has every original.");
+
+  album.limitsOriginalPhotosToCenterPage = YES;
+  XCTAssertEqual(neighbor.photoSize, NIPhotoScrollViewPhotoSizeThumbnail, @"The neighbor should have been downgraded.");
+  XCTAssertTrue(neighbor.image.size.width <= 160, @"The copy should fit within half of the album.");
+  XCTAssertEqual([self pageAtIndex:0 inAlbum:album].photoSize, NIPhotoScrollViewPhotoSizeOriginal, @"The center page keeps its original.");
+
+  album.limitsOriginalPhotosToCenterPage = NO;
+  timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  while (NIPhotoScrollViewPhotoSizeOriginal != neighbor.photoSize && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertEqual(neighbor.photoSize, NIPhotoScrollViewPhotoSizeOriginal, @"The original should have been restored once idle.");
+}
+
+@end
@@ -27,7 +27,39 @@
 @implementation NIPhotoScrollViewTests
 
 
-- (void)testNothing {
+- (NSURL *)temporaryImageURLWithSize:(CGSize)size {
+  UIGraphicsBeginImageContextWithOptions(size, YES, 1);
+  [[UIColor redColor] setFill];
+  UIRectFill(CGRectMake(0, 0, size.width, size.height));
+  UIImage* image = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+
+  NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"NIPhotoScrollViewTests.png"];
+  [UIImagePNGRepresentation(image) writeToFile:path atomically:YES];
+  return [NSURL fileURLWithPath:path];
+}
+
+- (void)testTiledImageView {
+  NITiledImageView* tiledImageView = [[NITiledImageView alloc] initWithContentsOfURL:[self temporaryImageURLWithSize:CGSizeMake(1200, 800)]];
+
+  XCTAssertNotNil(tiledImageView, @"The image should be readable.");
+  XCTAssertTrue(CGSizeEqualToSize(tiledImageView.imageSize, CGSizeMake(1200, 800)), @"The size should be read from the image's header.");
+  XCTAssertTrue(CGSizeEqualToSize(tiledImageView.bounds.size, CGSizeMake(1200, 800)), @"The view should be one point per pixel.");
+
+  XCTAssertNil([[NITiledImageView alloc] initWithContentsOfURL:[NSURL fileURLWithPath:@"/nonexistent.png"]], @"Missing files can't be tiled.");
+}
+
+- (void)testSetTiledImage {
+  NIPhotoScrollView* photoView = [[NIPhotoScrollView alloc] initWithFrame:CGRectMake(0, 0, 320, 480)];
+
+  XCTAssertTrue([photoView setTiledImageWithContentsOfURL:[self temporaryImageURLWithSize:CGSizeMake(1200, 800)]], @"The image should be readable.");
+  XCTAssertEqual(photoView.photoSize, NIPhotoScrollViewPhotoSizeOriginal, @"A tiled photo is the original photo.");
+
+  XCTAssertFalse([photoView setTiledImageWithContentsOfURL:[NSURL fileURLWithPath:@"/nonexistent.png"]], @"Missing files can't be tiled.");
+  XCTAssertEqual(photoView.photoSize, NIPhotoScrollViewPhotoSizeOriginal, @"The current photo should be kept.");
+
+  [photoView setImage:nil photoSize:NIPhotoScrollViewPhotoSizeUnknown];
+  XCTAssertEqual(photoView.photoSize, NIPhotoScrollViewPhotoSizeUnknown, @"Setting an image removes the tiled photo.");
 }
 
 @end
@@ -0,0 +1,172 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <XCTest/XCTest.h>
+
+#import "NimbusPhotos.h"
+
+// Layout methods of the scrubber that the tests check the atlas against.
+@interface NIPhotoScrubberView (Testing)
+- (NSInteger)photoIndexAtScrubberIndex:(NSInteger)scrubberIndex;
+- (NSInteger)numberOfVisiblePhotos;
+- (CGRect)frameForThumbAtIndex:(NSInteger)thumbIndex;
+@end
+
+@interface NIPhotoScrubberViewTests : XCTestCase <NIPhotoScrubberViewDataSource>
+@end
+
+
+@implementation NIPhotoScrubberViewTests {
+  NSCountedSet* _requestedPhotoIndexes;
+  NSMutableIndexSet* _unavailablePhotoIndexes;
+}
+
+
+- (void)setUp {
+  [super setUp];
+  _requestedPhotoIndexes = [[NSCountedSet alloc] init];
+  _unavailablePhotoIndexes = [[NSMutableIndexSet alloc] init];
+}
+
+// Every photo's thumbnail is a solid color that identifies it.
+- (UIColor *)colorForPhotoAtIndex:(NSInteger)photoIndex {
+  return [UIColor colorWithRed:(CGFloat)(photoIndex % 8) / 7
+                         green:(CGFloat)((photoIndex / 8) % 8) / 7
+                          blue:(CGFloat)((photoIndex / 64) % 8) / 7
+                         alpha:1];
+}
+
+- (UIImage *)thumbnailForPhotoAtIndex:(NSInteger)photoIndex {
+  UIGraphicsBeginImageContextWithOptions(CGSizeMake(8, 6), YES, 1);
+  [[self colorForPhotoAtIndex:photoIndex] setFill];
+  UIRectFill(CGRectMake(0, 0, 8, 6));
+  UIImage* image = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  return image;
+}
+
+// Reads the color of the atlas at a point in the container's coordinates.
+- (UIColor *)colorOfImage:(CGImageRef)image atPoint:(CGPoint)point scale:(CGFloat)scale {
+  uint8_t pixel[4] = {0};
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGContextRef context = CGBitmapContextCreate(pixel, 1, 1, 8, 4, colorSpace,
+                                               kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big);
+  CGColorSpaceRelease(colorSpace);
+  CGFloat width = (CGFloat)CGImageGetWidth(image);
+  CGFloat height = (CGFloat)CGImageGetHeight(image);
+  // Bitmap contexts are flipped relative to UIKit.
+  CGContextDrawImage(context,
+                     CGRectMake(-NICGFloatFloor(point.x * scale),
+                                -(height - 1 - NICGFloatFloor(point.y * scale)),
+                                width, height),
+                     image);
+  CGContextRelease(context);
+  return [UIColor colorWithRed:pixel[0] / 255.f green:pixel[1] / 255.f blue:pixel[2] / 255.f alpha:1];
+}
+
+- (BOOL)color:(UIColor *)color isCloseToColor:(UIColor *)otherColor {
+  CGFloat r1, g1, b1, a1, r2, g2, b2, a2;
+  [color getRed:&r1 green:&g1 blue:&b1 alpha:&a1];
+  [otherColor getRed:&r2 green:&g2 blue:&b2 alpha:&a2];
+  return (fabs(r1 - r2) < 0.02 && fabs(g1 - g2) < 0.02 && fabs(b1 - b2) < 0.02);
+}
+
+- (CGImageRef)waitForAtlasOfScrubber:(NIPhotoScrubberView *)scrubber
+                         afterAtlas:(CGImageRef)previousAtlas {
+  CALayer* atlasLayer = [scrubber.subviews[0].layer.sublayers lastObject];
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while ((nil == atlasLayer.contents || (__bridge CGImageRef)atlasLayer.contents == previousAtlas)
+         && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  return (__bridge CGImageRef)atlasLayer.contents;
+}
+
+- (void)testThumbnailAtlasPacksEverySampledThumbnail {
+  NIPhotoScrubberView* scrubber = [[NIPhotoScrubberView alloc] initWithFrame:CGRectMake(0, 0, 800, 96)];
+  scrubber.usesThumbnailAtlas = YES;
+  [_unavailablePhotoIndexes addIndex:0];
+  scrubber.dataSource = self;
+  [scrubber reloadData];
+  [scrubber layoutIfNeeded];
+
+  UIView* containerView = scrubber.subviews[0];
+  XCTAssertEqual(containerView.subviews.count, (NSUInteger)0, @"No view should be made per thumbnail.");
+  XCTAssertEqual(containerView.layer.sublayers.count, (NSUInteger)1,
+                 @"Every thumbnail should be drawn into the one atlas layer.");
+
+  NSInteger numberOfSampledPhotos = [scrubber numberOfVisiblePhotos];
+  XCTAssertGreaterThan(numberOfSampledPhotos, (NSInteger)1);
+  for (NSInteger ix = 0; ix < numberOfSampledPhotos; ++ix) {
+    NSNumber* photoIndex = @([scrubber photoIndexAtScrubberIndex:ix]);
+    XCTAssertEqual([_requestedPhotoIndexes countForObject:photoIndex], (NSUInteger)1,
+                   @"Each sampled thumbnail should be asked for once.");
+  }
+  XCTAssertEqual(_requestedPhotoIndexes.count, (NSUInteger)numberOfSampledPhotos,
+                 @"Only the sampled thumbnails should be asked for.");
+
+  CGFloat scale = NIScreenScale();
+  CGImageRef atlas = [self waitForAtlasOfScrubber:scrubber afterAtlas:NULL];
+  XCTAssertTrue(NULL != atlas);
+  XCTAssertEqual(CGImageGetWidth(atlas), (size_t)(containerView.bounds.size.width * scale));
+
+  // Each thumbnail is drawn in the frame its image view would have had.
+  for (NSInteger ix = 1; ix < numberOfSampledPhotos; ++ix) {
+    CGRect frame = [scrubber frameForThumbAtIndex:ix];
+    UIColor* color = [self colorOfImage:atlas
+                                atPoint:CGPointMake(CGRectGetMidX(frame), CGRectGetMidY(frame))
+                                  scale:scale];
+    NSInteger photoIndex = [scrubber photoIndexAtScrubberIndex:ix];
+    XCTAssertTrue([self color:color isCloseToColor:[self colorForPhotoAtIndex:photoIndex]],
+                  @"Thumbnail %ld should show photo %ld.", (long)ix, (long)photoIndex);
+  }
+  CGRect firstFrame = [scrubber frameForThumbAtIndex:0];
+  CGPoint firstCenter = CGPointMake(CGRectGetMidX(firstFrame), CGRectGetMidY(firstFrame));
+  XCTAssertTrue([self color:[self colorOfImage:atlas atPoint:firstCenter scale:scale]
+             isCloseToColor:[UIColor blackColor]],
+                @"Thumbnails that haven't loaded are drawn as empty frames.");
+
+  // A thumbnail that arrives later is drawn into the atlas in its place.
+  [_unavailablePhotoIndexes removeAllIndexes];
+  NSInteger firstPhotoIndex = [scrubber photoIndexAtScrubberIndex:0];
+  [scrubber didLoadThumbnail:[self thumbnailForPhotoAtIndex:firstPhotoIndex] atIndex:firstPhotoIndex];
+  atlas = [self waitForAtlasOfScrubber:scrubber afterAtlas:atlas];
+  XCTAssertTrue([self color:[self colorOfImage:atlas atPoint:firstCenter scale:scale]
+             isCloseToColor:[self colorForPhotoAtIndex:firstPhotoIndex]]);
+  XCTAssertEqual([_requestedPhotoIndexes countForObject:@(firstPhotoIndex)], (NSUInteger)1,
+                 @"A loaded thumbnail should not be asked for again.");
+}
+
+
+#pragma mark - NIPhotoScrubberViewDataSource
+
+
+- (NSInteger)numberOfPhotosInScrubberView:(NIPhotoScrubberView *)photoScrubberView {
+  return 300;
+}
+
+- (UIImage *)photoScrubberView:(NIPhotoScrubberView *)photoScrubberView
+              thumbnailAtIndex:(NSInteger)thumbnailIndex {
+  [_requestedPhotoIndexes addObject:@(thumbnailIndex)];
+  if ([_unavailablePhotoIndexes containsIndex:(NSUInteger)thumbnailIndex]) {
+    return nil;
+  }
+  return [self thumbnailForPhotoAtIndex:thumbnailIndex];
+}
+
+@end
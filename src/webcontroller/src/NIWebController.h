@@ -21,6 +21,18 @@
 
 #import "NIPreprocessorMacros.h" /* for weak */
 
+@class WKWebView;
+
+/**
+ * The web engine that an NIWebController displays its content with.
+ *
+ * @ingroup NimbusWebController
+ */
+typedef enum {
+  NIWebControllerEngineUIWebView,
+  NIWebControllerEngineWKWebView,
+} NIWebControllerEngine;
+
 /**
  * A simple web view controller implementation with a toolbar.
  *
@@ -37,6 +49,17 @@
  * - webView:didFailLoadWithError:
  * @endcode
  *
+ * When the engine is NIWebControllerEngineWKWebView the controller is the web view's
+ * WKNavigationDelegate instead and implements:
+ *
+ * @code
+ * - webView:decidePolicyForNavigationAction:decisionHandler:
+ * - webView:didStartProvisionalNavigation:
+ * - webView:didFinishNavigation:
+ * - webView:didFailNavigation:withError:
+ * - webView:didFailProvisionalNavigation:withError:
+ * @endcode
+ *
  * This view controller also implements UIActionSheetDelegate. If you want to implement methods of
  * this delegate then you should take care to call the super implementation if necessary. The
  * following UIActionSheetDelegate methods have implementations in this class:
@@ -72,6 +95,33 @@
  *  [webController setToolbarTintColor:[UIColor blackColor]];
  * @endcode
  *
+ *
+ * <h3>WKWebView</h3>
+ *
+ * The following settings display the content in a WKWebView taken from the shared
+ * NIWebViewPool, so that JavaScript runs out of process under the faster engine and the web
+ * content process is already running when the controller is presented.
+ *
+ * @code
+ *  [[NIWebViewPool sharedPool] prewarm]; // e.g. at launch
+ *  ...
+ *  webController.engine = NIWebControllerEngineWKWebView;
+ * @endcode
+ *
+ * If the link the user is likely to open next is known, start loading it ahead of time with
+ * NIWebViewPool::preloadURL:. A WKWebView controller initialized with the same URL adopts the
+ * preloaded page when its view loads.
+ *
+ *
+ * <h2>Recently Visited Pages</h2>
+ *
+ * When a web controller is popped or dismissed it hands its page to NIWebViewPool, which keeps
+ * a few recently visited pages within a memory budget. A controller later opened with the same
+ * URL shows the kept page immediately and revalidates it in the background: a WKWebView page is
+ * adopted whole and reloaded with a conditional request, and a UIWebView page is shown as a
+ * snapshot while its cached response is rendered and checked against the server. Set
+ * keepsVisitedPages to NO for pages that must always be loaded fresh.
+ *
  * @ingroup NimbusWebController
  */
 @interface NIWebController : UIViewController <UIWebViewDelegate, UIActionSheetDelegate>
@@ -90,7 +140,11 @@
 @property (nonatomic, assign, getter = isToolbarHidden) BOOL toolbarHidden;
 @property (nonatomic, weak) UIColor* toolbarTintColor;
 
+@property (nonatomic, assign) NIWebControllerEngine engine; // Default: NIWebControllerEngineUIWebView
 @property (nonatomic, readonly, strong) UIWebView* webView;
+@property (nonatomic, readonly, strong) WKWebView* wkWebView;
+
+@property (nonatomic, assign) BOOL keepsVisitedPages; // Default: YES
 
 // Subclassing
 - (BOOL)shouldPresentActionSheet:(UIActionSheet *)actionSheet;
@@ -178,12 +232,40 @@
 
 /** @name Accessing the Web View */
 
+/**
+ * The web engine used to display the content.
+ *
+ * Must be set before the controller's view is loaded. NIWebControllerEngineWKWebView falls
+ * back to NIWebControllerEngineUIWebView on devices without WKWebView.
+ *
+ * @fn NIWebController::engine
+ */
+
 /**
  * The internal web view.
  *
+ * nil if the content is displayed in a WKWebView.
+ *
  * @fn NIWebController::webView
  */
 
+/**
+ * The internal WKWebView, dequeued from the shared NIWebViewPool when the view loads.
+ *
+ * nil if the content is displayed in a UIWebView.
+ *
+ * @fn NIWebController::wkWebView
+ */
+
+/**
+ * Whether this controller shows a recently visited page kept by NIWebViewPool and keeps its own
+ * page when it leaves the screen.
+ *
+ * Must be set before the controller's view is loaded.
+ *
+ * @fn NIWebController::keepsVisitedPages
+ */
+
 /** @name Subclassing the Web Controller */
 
 /**
@@ -18,14 +18,16 @@
 
 #import "NIWebController.h"
 
+#import "NIWebViewPool.h"
 #import "NimbusCore.h"
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "Nimbus requires ARC support."
 #endif
 
-@interface NIWebController()
+@interface NIWebController() <WKNavigationDelegate>
 @property (nonatomic, strong) UIWebView* webView;
+@property (nonatomic, strong) WKWebView* wkWebView;
 @property (nonatomic, strong) UIToolbar* toolbar;
 @property (nonatomic, strong) UIActionSheet* actionSheet;
 
@@ -39,6 +41,11 @@
 @property (nonatomic, strong) NSURL* loadingURL;
 
 @property (nonatomic, strong) NSURLRequest* loadRequest;
+
+// Shown over a UIWebView until the visited page it was taken from has rendered again.
+@property (nonatomic, strong) UIImageView* snapshotView;
+// The URL this controller's page was kept under when it last left the screen.
+@property (nonatomic, copy) NSURL* visitedPageURL;
 @end
 
 @implementation NIWebController
@@ -48,11 +55,16 @@
 - (void)dealloc {
   _actionSheet.delegate = nil;
   _webView.delegate = nil;
+  // A kept web view may belong to another controller by now.
+  if (nil == _visitedPageURL) {
+    _wkWebView.navigationDelegate = nil;
+  }
 }
 
 - (id)initWithRequest:(NSURLRequest *)request {
   if ((self = [super initWithNibName:nil bundle:nil])) {
     self.hidesBottomBarWhenPushed = YES;
+    _keepsVisitedPages = YES;
 
     if ([self respondsToSelector:@selector(edgesForExtendedLayout)]) {
       self.edgesForExtendedLayout = UIRectEdgeNone;
@@ -74,20 +86,108 @@
 #pragma mark - Private
 
 
+// The view displaying the content, whichever engine is in use.
+- (UIView *)contentWebView {
+  return (nil != self.wkWebView) ? self.wkWebView : self.webView;
+}
+
 - (void)didTapBackButton {
-  [self.webView goBack];
+  if (nil != self.wkWebView) {
+    [self.wkWebView goBack];
+  } else {
+    [self.webView goBack];
+  }
 }
 
 - (void)didTapForwardButton {
-  [self.webView goForward];
+  if (nil != self.wkWebView) {
+    [self.wkWebView goForward];
+  } else {
+    [self.webView goForward];
+  }
 }
 
 - (void)didTapRefreshButton {
-  [self.webView reload];
+  if (nil != self.wkWebView) {
+    [self.wkWebView reload];
+  } else {
+    [self.webView reload];
+  }
 }
 
 - (void)didTapStopButton {
-  [self.webView stopLoading];
+  [self stopLoading];
+}
+
+- (void)stopLoading {
+  if (nil != self.wkWebView) {
+    [self.wkWebView stopLoading];
+  } else {
+    [self.webView stopLoading];
+  }
+}
+
+- (void)loadRequestInWebView:(NSURLRequest *)request {
+  if (nil != self.wkWebView) {
+    [self.wkWebView loadRequest:request];
+  } else {
+    [self.webView loadRequest:request];
+  }
+}
+
+- (BOOL)canGoBack {
+  return (nil != self.wkWebView) ? self.wkWebView.canGoBack : [self.webView canGoBack];
+}
+
+- (void)updateNavigationButtons {
+  if (nil != self.wkWebView) {
+    self.backButton.enabled = self.wkWebView.canGoBack;
+    self.forwardButton.enabled = self.wkWebView.canGoForward;
+  } else {
+    self.backButton.enabled = [self.webView canGoBack];
+    self.forwardButton.enabled = [self.webView canGoForward];
+  }
+}
+
+- (void)didStartLoading {
+  self.title = NSLocalizedString(@"Loading...", @"");
+  if (!self.navigationItem.rightBarButtonItem) {
+    [self.navigationItem setRightBarButtonItem:self.activityItem animated:YES];
+  }
+
+  NSInteger buttonIndex = 0;
+  for (UIBarButtonItem* button in self.toolbar.items) {
+    if (button.tag == 3) {
+      NSMutableArray* newItems = [NSMutableArray arrayWithArray:self.toolbar.items];
+      [newItems replaceObjectAtIndex:buttonIndex withObject:self.stopButton];
+      self.toolbar.items = newItems;
+      break;
+    }
+    ++buttonIndex;
+  }
+  [self updateNavigationButtons];
+}
+
+- (void)didFinishLoadingWithTitle:(NSString *)title {
+  self.loadingURL = nil;
+  [self.snapshotView removeFromSuperview];
+  self.snapshotView = nil;
+  self.title = title;
+  if (self.navigationItem.rightBarButtonItem == self.activityItem) {
+    [self.navigationItem setRightBarButtonItem:nil animated:YES];
+  }
+
+  NSInteger buttonIndex = 0;
+  for (UIBarButtonItem* button in self.toolbar.items) {
+    if (button.tag == 3) {
+      NSMutableArray* newItems = [NSMutableArray arrayWithArray:self.toolbar.items];
+      [newItems replaceObjectAtIndex:buttonIndex withObject:self.refreshButton];
+      self.toolbar.items = newItems;
+      break;
+    }
+    ++buttonIndex;
+  }
+  [self updateNavigationButtons];
 }
 
 - (void)didTapShareButton {
@@ -145,24 +245,177 @@
     toolbarFrame.origin.y = self.view.bounds.size.height - toolbarFrame.size.height;
     self.toolbar.frame = toolbarFrame;
 
-    CGRect webViewFrame = self.webView.frame;
+    UIView* webView = self.contentWebView;
+    CGRect webViewFrame = webView.frame;
     webViewFrame.size.height = self.view.bounds.size.height - toolbarFrame.size.height;
-    self.webView.frame = webViewFrame;
+    webView.frame = webViewFrame;
+
+  } else {
+    self.contentWebView.frame = self.view.bounds;
+  }
+}
+
+#pragma mark - Visited Pages
+
+
+// Pages are kept under the URL they were opened with so that opening the same link finds them,
+// unless the user has since followed a link away from it.
+- (NSURL *)URLForVisitedPage {
+  return (![self canGoBack] && nil != self.loadRequest.URL) ? self.loadRequest.URL : self.URL;
+}
+
+- (UIImage *)snapshotOfWebView {
+  UIView* webView = self.contentWebView;
+  if (CGRectIsEmpty(webView.bounds)) {
+    return nil;
+  }
+  UIGraphicsBeginImageContextWithOptions(webView.bounds.size, YES, 0);
+  [webView.layer renderInContext:UIGraphicsGetCurrentContext()];
+  UIImage* snapshot = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  return snapshot;
+}
+
+- (void)storeVisitedPage {
+  NSURL* URL = [self URLForVisitedPage];
+  if (nil == URL) {
+    return;
+  }
+
+  NIWebViewPool* pool = [NIWebViewPool sharedPool];
+  if (nil != self.wkWebView) {
+    [pool storeVisitedWebView:self.wkWebView forURL:URL];
+
+  } else if (nil != self.webView.request && ![self.webView isLoading]) {
+    NSCachedURLResponse* cachedResponse =
+      [[NSURLCache sharedURLCache] cachedResponseForRequest:self.webView.request];
+    [pool storeVisitedSnapshot:[self snapshotOfWebView] cachedResponse:cachedResponse forURL:URL];
 
   } else {
-    self.webView.frame = self.view.bounds;
+    return;
+  }
+  self.visitedPageURL = URL;
+}
+
+// Called if this controller is shown again after keeping its page.
+- (void)reclaimVisitedPage {
+  if (nil == self.visitedPageURL) {
+    return;
+  }
+  NIWebViewPool* pool = [NIWebViewPool sharedPool];
+  [pool removeVisitedPageForURL:self.visitedPageURL];
+  self.visitedPageURL = nil;
+
+  if (nil == self.wkWebView || self.wkWebView.superview == self.view) {
+    return;
+  }
+  BOOL wasAdoptedElsewhere = (nil != self.wkWebView.superview);
+  if (wasAdoptedElsewhere) {
+    self.wkWebView = [pool dequeueWebView];
+    [self configureContentWebView];
+  }
+  self.wkWebView.navigationDelegate = self;
+  [self.view insertSubview:self.wkWebView belowSubview:self.toolbar];
+  [self updateWebViewFrame];
+  if (wasAdoptedElsewhere && nil != self.loadRequest) {
+    [self loadRequestInWebView:self.loadRequest];
   }
 }
 
+- (void)showVisitedPageSnapshot:(NIVisitedWebPage *)page {
+  if (nil != page.snapshot) {
+    self.snapshotView = [[UIImageView alloc] initWithImage:page.snapshot];
+    self.snapshotView.contentMode = UIViewContentModeTopLeft;
+    self.snapshotView.clipsToBounds = YES;
+    self.snapshotView.frame = self.webView.frame;
+    self.snapshotView.autoresizingMask = self.webView.autoresizingMask;
+    [self.view insertSubview:self.snapshotView aboveSubview:self.webView];
+  }
+
+  NSCachedURLResponse* cachedResponse = page.cachedResponse;
+  if (nil == cachedResponse) {
+    [self loadRequestInWebView:self.loadRequest];
+    return;
+  }
+  [self.webView loadData:cachedResponse.data
+                MIMEType:cachedResponse.response.MIMEType
+        textEncodingName:cachedResponse.response.textEncodingName
+                 baseURL:page.URL];
+  [self revalidateCachedResponse:cachedResponse forURL:page.URL];
+}
+
+// Asks the server whether the page has changed since it was cached and shows the new page if it
+// has. The cached page stays on screen in the meantime.
+- (void)revalidateCachedResponse:(NSCachedURLResponse *)cachedResponse forURL:(NSURL *)URL {
+  // Start from the request the page was opened with so that its headers are sent again.
+  NSURLRequest* originalRequest = ([self.loadRequest.URL.absoluteString isEqualToString:URL.absoluteString]
+                                   ? self.loadRequest
+                                   : [NSURLRequest requestWithURL:URL]);
+  NSMutableURLRequest* request = [originalRequest mutableCopy];
+  request.cachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
+  request.timeoutInterval = 30;
+  if ([cachedResponse.response isKindOfClass:[NSHTTPURLResponse class]]) {
+    NSDictionary* headers = [(NSHTTPURLResponse *)cachedResponse.response allHeaderFields];
+    NSString* entityTag = [headers objectForKey:@"ETag"];
+    if (nil != entityTag) {
+      [request setValue:entityTag forHTTPHeaderField:@"If-None-Match"];
+    }
+    NSString* lastModified = [headers objectForKey:@"Last-Modified"];
+    if (nil != lastModified) {
+      [request setValue:lastModified forHTTPHeaderField:@"If-Modified-Since"];
+    }
+  }
+
+  __weak NIWebController* weakSelf = self;
+  [NSURLConnection sendAsynchronousRequest:request
+                                     queue:[NSOperationQueue mainQueue]
+                         completionHandler:^(NSURLResponse* response, NSData* data, NSError* error) {
+    // A 304 means the cached page is still current.
+    NSInteger statusCode = ([response isKindOfClass:[NSHTTPURLResponse class]]
+                            ? [(NSHTTPURLResponse *)response statusCode]
+                            : 0);
+    if (nil != error || 200 != statusCode || [data isEqualToData:cachedResponse.data]) {
+      return;
+    }
+    NSCachedURLResponse* freshResponse = [[NSCachedURLResponse alloc] initWithResponse:response
+                                                                                  data:data];
+    [[NSURLCache sharedURLCache] storeCachedResponse:freshResponse
+                                          forRequest:originalRequest];
+    [weakSelf didRevalidateCachedResponse:freshResponse forURL:URL];
+  }];
+}
+
+- (void)didRevalidateCachedResponse:(NSCachedURLResponse *)cachedResponse forURL:(NSURL *)URL {
+  // Leave the page alone if the user has moved on from it.
+  NSString* currentURLString = [self URLForVisitedPage].absoluteString;
+  if ([self canGoBack] || ![currentURLString isEqualToString:URL.absoluteString]) {
+    return;
+  }
+  [self.webView loadData:cachedResponse.data
+                MIMEType:cachedResponse.response.MIMEType
+        textEncodingName:cachedResponse.response.textEncodingName
+                 baseURL:URL];
+}
+
 #pragma mark - UIViewController
 
 
 - (void)updateWebViewFrame {
   if (self.toolbarHidden) {
-    self.webView.frame = self.view.bounds;
+    self.contentWebView.frame = self.view.bounds;
     
   } else {
-    self.webView.frame = NIRectContract(self.view.bounds, 0, self.toolbar.frame.size.height);
+    self.contentWebView.frame = NIRectContract(self.view.bounds, 0, self.toolbar.frame.size.height);
+  }
+}
+
+- (void)configureContentWebView {
+  UIView* webView = self.contentWebView;
+  webView.autoresizingMask = (UIViewAutoresizingFlexibleWidth
+                              | UIViewAutoresizingFlexibleHeight);
+
+  if ([UIColor respondsToSelector:@selector(underPageBackgroundColor)]) {
+    webView.backgroundColor = [UIColor underPageBackgroundColor];
   }
 }
 
@@ -246,28 +499,66 @@
                     self.actionButton,
                     nil];
 
-  self.webView = [[UIWebView alloc] initWithFrame:CGRectZero];
-  [self updateWebViewFrame];
-  self.webView.delegate = self;
-  self.webView.autoresizingMask = (UIViewAutoresizingFlexibleWidth
-                               | UIViewAutoresizingFlexibleHeight);
-  self.webView.scalesPageToFit = YES;
+  NIWebViewPool* pool = [NIWebViewPool sharedPool];
+  NIVisitedWebPage* visitedPage = nil;
+  if (self.keepsVisitedPages && nil != self.loadRequest.URL) {
+    visitedPage = [pool dequeueVisitedPageForURL:self.loadRequest.URL];
+  }
 
-  if ([UIColor respondsToSelector:@selector(underPageBackgroundColor)]) {
-    self.webView.backgroundColor = [UIColor underPageBackgroundColor];
+  BOOL didAdoptPreloadedWebView = NO;
+  BOOL didAdoptVisitedWebView = NO;
+  if (NIWebControllerEngineWKWebView == self.engine && [NIWebViewPool isAvailable]) {
+    self.wkWebView = [pool dequeuePreloadedWebViewForURL:self.loadRequest.URL];
+    didAdoptPreloadedWebView = (nil != self.wkWebView);
+    if (!didAdoptPreloadedWebView && nil != visitedPage.webView) {
+      self.wkWebView = visitedPage.webView;
+      didAdoptVisitedWebView = YES;
+    }
+    if (nil == self.wkWebView) {
+      self.wkWebView = [pool dequeueWebView];
+    }
+    self.wkWebView.navigationDelegate = self;
+
+  } else {
+    self.webView = [[UIWebView alloc] initWithFrame:CGRectZero];
+    self.webView.delegate = self;
+    self.webView.scalesPageToFit = YES;
   }
 
-  [self.view addSubview:self.webView];
+  [self configureContentWebView];
+  [self updateWebViewFrame];
+
+  [self.view addSubview:self.contentWebView];
   [self.view addSubview:self.toolbar];
 
-  if (nil != self.loadRequest) {
-    [self.webView loadRequest:self.loadRequest];
+  if (didAdoptPreloadedWebView) {
+    // The page started loading before we were its delegate, so catch the toolbar up.
+    if (self.wkWebView.isLoading) {
+      [self didStartLoading];
+    } else {
+      [self didFinishLoadingWithTitle:self.wkWebView.title];
+    }
+
+  } else if (didAdoptVisitedWebView) {
+    // The page is shown as it was left. Reloading revalidates it with a conditional request,
+    // and WebKit keeps showing it until a changed page arrives.
+    [self didFinishLoadingWithTitle:self.wkWebView.title];
+    [self.wkWebView reload];
+
+  } else if (nil != self.webView
+             && (nil != visitedPage.snapshot || nil != visitedPage.cachedResponse)) {
+    [self showVisitedPageSnapshot:visitedPage];
+
+  } else if (nil != self.loadRequest) {
+    [self loadRequestInWebView:self.loadRequest];
   }
 }
 
 - (void)viewWillAppear:(BOOL)animated {
   [super viewWillAppear:animated];
 
+  [self reclaimVisitedPage];
+
   [self updateToolbarWithOrientation:self.interfaceOrientation];
 }
 
@@ -279,6 +570,18 @@
   [super viewWillDisappear:animated];
 }
 
+- (void)viewDidDisappear:(BOOL)animated {
+  [super viewDidDisappear:animated];
+
+  // Only keep the page once the controller is gone for good, not when something covers it.
+  BOOL isLeaving = (self.isMovingFromParentViewController
+                    || self.isBeingDismissed
+                    || self.navigationController.isBeingDismissed);
+  if (self.keepsVisitedPages && isLeaving) {
+    [self storeVisitedPage];
+  }
+}
+
 - (BOOL)shouldAutorotateToInterfaceOrientation:(UIInterfaceOrientation)interfaceOrientation {
   return NIIsSupportedOrientation(interfaceOrientation);
 }
@@ -294,56 +597,48 @@
 
 - (BOOL)webView:(UIWebView*)webView shouldStartLoadWithRequest:(NSURLRequest*)request navigationType:(UIWebViewNavigationType)navigationType {
   self.loadingURL = [request.mainDocumentURL copy];
-  self.backButton.enabled = [self.webView canGoBack];
-  self.forwardButton.enabled = [self.webView canGoForward];
+  [self updateNavigationButtons];
   return YES;
 }
 
 - (void)webViewDidStartLoad:(UIWebView*)webView {
-  self.title = NSLocalizedString(@"Loading...", @"");
-  if (!self.navigationItem.rightBarButtonItem) {
-    [self.navigationItem setRightBarButtonItem:self.activityItem animated:YES];
-  }
-
-  NSInteger buttonIndex = 0;
-  for (UIBarButtonItem* button in self.toolbar.items) {
-    if (button.tag == 3) {
-      NSMutableArray* newItems = [NSMutableArray arrayWithArray:self.toolbar.items];
-      [newItems replaceObjectAtIndex:buttonIndex withObject:self.stopButton];
-      self.toolbar.items = newItems;
-      break;
-    }
-    ++buttonIndex;
-  }
-  self.backButton.enabled = [self.webView canGoBack];
-  self.forwardButton.enabled = [self.webView canGoForward];
+  [self didStartLoading];
 }
 
 - (void)webViewDidFinishLoad:(UIWebView*)webView {
+  [self didFinishLoadingWithTitle:[self.webView stringByEvaluatingJavaScriptFromString:@"document.title"]];
+}
+
+- (void)webView:(UIWebView*)webView didFailLoadWithError:(NSError*)error {
   self.loadingURL = nil;
-  self.title = [self.webView stringByEvaluatingJavaScriptFromString:@"document.title"];
-  if (self.navigationItem.rightBarButtonItem == self.activityItem) {
-    [self.navigationItem setRightBarButtonItem:nil animated:YES];
-  }
+  [self webViewDidFinishLoad:webView];
+}
 
-  NSInteger buttonIndex = 0;
-  for (UIBarButtonItem* button in self.toolbar.items) {
-    if (button.tag == 3) {
-      NSMutableArray* newItems = [NSMutableArray arrayWithArray:self.toolbar.items];
-      [newItems replaceObjectAtIndex:buttonIndex withObject:self.refreshButton];
-      self.toolbar.items = newItems;
-      break;
-    }
-    ++buttonIndex;
+#pragma mark - WKNavigationDelegate
+
+
+- (void)webView:(WKWebView *)webView decidePolicyForNavigationAction:(WKNavigationAction *)navigationAction decisionHandler:(void (^)(WKNavigationActionPolicy))decisionHandler {
+  if (navigationAction.targetFrame.isMainFrame) {
+    self.loadingURL = [navigationAction.request.URL copy];
   }
+  [self updateNavigationButtons];
+  decisionHandler(WKNavigationActionPolicyAllow);
+}
 
-  self.backButton.enabled = [self.webView canGoBack];
-  self.forwardButton.enabled = [self.webView canGoForward];
+- (void)webView:(WKWebView *)webView didStartProvisionalNavigation:(WKNavigation *)navigation {
+  [self didStartLoading];
 }
 
-- (void)webView:(UIWebView*)webView didFailLoadWithError:(NSError*)error {
-  self.loadingURL = nil;
-  [self webViewDidFinishLoad:webView];
+- (void)webView:(WKWebView *)webView didFinishNavigation:(WKNavigation *)navigation {
+  [self didFinishLoadingWithTitle:webView.title];
+}
+
+- (void)webView:(WKWebView *)webView didFailNavigation:(WKNavigation *)navigation withError:(NSError *)error {
+  [self didFinishLoadingWithTitle:webView.title];
+}
+
+- (void)webView:(WKWebView *)webView didFailProvisionalNavigation:(WKNavigation *)navigation withError:(NSError *)error {
+  [self didFinishLoadingWithTitle:webView.title];
 }
 
 #pragma mark - UIActionSheetDelegate
@@ -371,7 +666,10 @@
 
 
 - (NSURL *)URL {
-  return self.loadingURL ? self.loadingURL : self.webView.request.mainDocumentURL;
+  if (nil != self.loadingURL) {
+    return self.loadingURL;
+  }
+  return (nil != self.wkWebView) ? self.wkWebView.URL : self.webView.request.mainDocumentURL;
 }
 
 - (void)openURL:(NSURL*)URL {
@@ -384,17 +682,21 @@
 
   if ([self isViewLoaded]) {
     if (nil != request) {
-      [self.webView loadRequest:request];
+      [self loadRequestInWebView:request];
 
     } else {
-      [self.webView stopLoading];
+      [self stopLoading];
     }
   }
 }
 
 - (void)openHTMLString:(NSString*)htmlString baseURL:(NSURL*)baseUrl {
 	NIDASSERT([self isViewLoaded]);
-	[_webView loadHTMLString:htmlString baseURL:baseUrl];
+	if (nil != self.wkWebView) {
+		[self.wkWebView loadHTMLString:htmlString baseURL:baseUrl];
+	} else {
+		[self.webView loadHTMLString:htmlString baseURL:baseUrl];
+	}
 }
 
 - (void)setToolbarHidden:(BOOL)hidden {
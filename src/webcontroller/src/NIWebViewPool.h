@@ -0,0 +1,296 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+#import <WebKit/WebKit.h>
+
+@class NIVisitedWebPage;
+
+/**
+ * A small pool of WKWebViews that are created ahead of time and share one process pool.
+ *
+ * Creating the first WKWebView launches the web content process, and every web view that uses
+ * a new WKProcessPool launches another. Web views dequeued from this pool all share
+ * processPool, and the pool refills itself on the NIIdleScheduler after each dequeue, so
+ * presenting a web controller picks up a web view whose engine is already running.
+ *
+ * Web views are never returned to the pool; a used web view carries its history and page
+ * state, so the pool always hands out fresh ones.
+ *
+ * The pool can also start loading a URL the user is likely to open next with preloadURL:. The
+ * page loads in an off-screen web view, and a web controller that is later asked to display
+ * the same URL adopts that web view, page and all, instead of starting the load from scratch.
+ *
+ * The pool also keeps recently visited pages, so that going back to an article that was just
+ * closed shows it instantly. A WKWebView page is kept whole off-screen with its media paused; a
+ * UIWebView page is kept as a rendered snapshot plus the cached response for its main document.
+ * The visited pages are bounded by an estimate of the memory they hold, and the pages that keep
+ * a live web view are also bounded by count.
+ *
+ * The pool must only be used from the main thread.
+ *
+ * @ingroup NimbusWebController
+ */
+@interface NIWebViewPool : NSObject
+
++ (NIWebViewPool *)sharedPool;
+
++ (BOOL)isAvailable;
+
+@property (nonatomic, readonly, strong) WKProcessPool* processPool;
+@property (nonatomic, assign) NSUInteger capacity; // Default: 1
+
+- (WKWebView *)dequeueWebView;
+- (void)prewarm;
+
+- (NSUInteger)numberOfPrewarmedWebViews;
+
+- (void)preloadURL:(NSURL *)URL;
+- (WKWebView *)dequeuePreloadedWebViewForURL:(NSURL *)URL;
+- (void)cancelPreloadOfURL:(NSURL *)URL;
+- (void)cancelAllPreloads;
+@property (nonatomic, assign) NSUInteger maximumNumberOfPreloadedWebViews; // Default: 1
+@property (nonatomic, assign) NSTimeInterval preloadLifetime; // Default: 30
+
+- (NSUInteger)numberOfPreloadedWebViews;
+
+- (void)storeVisitedWebView:(WKWebView *)webView forURL:(NSURL *)URL;
+- (void)storeVisitedSnapshot:(UIImage *)snapshot cachedResponse:(NSCachedURLResponse *)cachedResponse forURL:(NSURL *)URL;
+- (NIVisitedWebPage *)dequeueVisitedPageForURL:(NSURL *)URL;
+- (void)removeVisitedPageForURL:(NSURL *)URL;
+- (void)removeAllVisitedPages;
+@property (nonatomic, assign) unsigned long long maxNumberOfVisitedPageBytes; // Default: 32MB
+@property (nonatomic, assign) NSTimeInterval visitedPageLifetime; // Default: 300
+@property (nonatomic, assign) NSUInteger maximumNumberOfVisitedWebViews; // Default: 1
+
+- (NSUInteger)numberOfVisitedPages;
+- (unsigned long long)numberOfVisitedPageBytes;
+
+@end
+
+/**
+ * A recently visited page kept by NIWebViewPool.
+ *
+ * Either webView is set, or snapshot is set along with cachedResponse when the main document
+ * was cacheable.
+ *
+ * @ingroup NimbusWebController
+ */
+@interface NIVisitedWebPage : NSObject
+
+@property (nonatomic, readonly, copy) NSURL* URL;
+@property (nonatomic, readonly, strong) WKWebView* webView;
+@property (nonatomic, readonly, strong) UIImage* snapshot;
+@property (nonatomic, readonly, strong) NSCachedURLResponse* cachedResponse;
+@property (nonatomic, readonly, assign) unsigned long long numberOfBytes;
+
+@end
+
+/**
+ * Returns the pool shared by every NIWebController.
+ *
+ * @fn NIWebViewPool::sharedPool
+ */
+
+/**
+ * Whether WKWebView is available on this device.
+ *
+ * WKWebView first shipped with iOS 8. Apps that support earlier versions must link
+ * WebKit.framework as Optional, and every other method of the pool returns nil or does nothing
+ * when this is NO.
+ *
+ * @fn NIWebViewPool::isAvailable
+ */
+
+/**
+ * The process pool shared by every web view that the pool creates.
+ *
+ * @fn NIWebViewPool::processPool
+ */
+
+/**
+ * The number of web views the pool keeps ready.
+ *
+ * Each prewarmed web view holds on to a few megabytes, so keep this small. Lowering the
+ * capacity releases the excess web views immediately.
+ *
+ * @fn NIWebViewPool::capacity
+ */
+
+/**
+ * Returns a prewarmed web view, or creates one if the pool is empty, and schedules the pool to
+ * be refilled.
+ *
+ * @fn NIWebViewPool::dequeueWebView
+ */
+
+/**
+ * Schedules the pool to be filled up to its capacity when the main run loop is next idle.
+ *
+ * Call this at launch, or before presenting a screen with links, so that the first web view is
+ * ready by the time a link is tapped.
+ *
+ * @fn NIWebViewPool::prewarm
+ */
+
+/**
+ * Returns the number of web views waiting in the pool.
+ *
+ * @fn NIWebViewPool::numberOfPrewarmedWebViews
+ */
+
+/** @name Preloading Pages */
+
+/**
+ * Starts loading the given URL in an off-screen web view.
+ *
+ * Does nothing if the URL is already being preloaded or if maximumNumberOfPreloadedWebViews is
+ * zero. If the budget is used up the oldest preload is discarded to make room.
+ *
+ * @fn NIWebViewPool::preloadURL:
+ */
+
+/**
+ * Removes and returns the web view preloading the given URL, or nil if there isn't one.
+ *
+ * The web view may still be loading. NIWebController calls this when its view loads.
+ *
+ * @fn NIWebViewPool::dequeuePreloadedWebViewForURL:
+ */
+
+/**
+ * Stops preloading the given URL and releases its web view.
+ *
+ * @fn NIWebViewPool::cancelPreloadOfURL:
+ */
+
+/**
+ * Stops every preload and releases their web views.
+ *
+ * @fn NIWebViewPool::cancelAllPreloads
+ */
+
+/**
+ * The largest number of pages that may be preloading or preloaded at once.
+ *
+ * A loaded page can easily take tens of megabytes in the web content process, so this is the
+ * preloading memory budget. Every preload is also discarded under memory pressure.
+ *
+ * @fn NIWebViewPool::maximumNumberOfPreloadedWebViews
+ */
+
+/**
+ * How long a preloaded page is kept if no controller adopts it.
+ *
+ * @fn NIWebViewPool::preloadLifetime
+ */
+
+/**
+ * Returns the number of pages that are preloading or preloaded.
+ *
+ * @fn NIWebViewPool::numberOfPreloadedWebViews
+ */
+
+/** @name Keeping Recently Visited Pages */
+
+/**
+ * Keeps a page that is leaving the screen, web view and all, so that it can be shown again
+ * without reloading it.
+ *
+ * The web view's navigation delegate is cleared, any audio or video on the page is paused and
+ * the web view is removed from its superview. Its cost is estimated as the tiles WebKit keeps
+ * for a few screenfuls of its content plus a fixed amount for the rest of the loaded page.
+ * Replaces any page already kept for the URL, discards the least recently visited web view if
+ * maximumNumberOfVisitedWebViews are already kept, and discards the least recently visited
+ * pages until the pages fit in maxNumberOfVisitedPageBytes. Does nothing if the page alone
+ * doesn't fit.
+ *
+ * @fn NIWebViewPool::storeVisitedWebView:forURL:
+ */
+
+/**
+ * Keeps a snapshot of a page that is leaving the screen along with the cached response of its
+ * main document.
+ *
+ * This is how UIWebView pages are kept; a UIWebView can't be moved between controllers. The
+ * snapshot is shown while the cached response is rendered. Either may be nil. Costs the
+ * snapshot's bitmap plus the response data; otherwise behaves like storeVisitedWebView:forURL:.
+ *
+ * @fn NIWebViewPool::storeVisitedSnapshot:cachedResponse:forURL:
+ */
+
+/**
+ * Removes and returns the page kept for the given URL, or nil if there isn't one.
+ *
+ * NIWebController calls this when its view loads and revalidates the page in the background.
+ *
+ * @fn NIWebViewPool::dequeueVisitedPageForURL:
+ */
+
+/**
+ * Discards the page kept for the given URL.
+ *
+ * @fn NIWebViewPool::removeVisitedPageForURL:
+ */
+
+/**
+ * Discards every kept page.
+ *
+ * Every kept page is also discarded under memory pressure.
+ *
+ * @fn NIWebViewPool::removeAllVisitedPages
+ */
+
+/**
+ * The most memory that kept pages may be estimated to hold.
+ *
+ * Lowering it discards the least recently visited pages until the rest fit. Set it to zero to
+ * stop keeping pages.
+ *
+ * @fn NIWebViewPool::maxNumberOfVisitedPageBytes
+ */
+
+/**
+ * How long a page is kept after it was visited.
+ *
+ * Pages older than this are not shown again, because they are likely to be stale.
+ *
+ * @fn NIWebViewPool::visitedPageLifetime
+ */
+
+/**
+ * The largest number of kept pages that may hold a live web view.
+ *
+ * A kept WKWebView keeps its whole page loaded in the web content process, which the byte
+ * estimate can only approximate, so these are also capped by count. Lowering it discards the
+ * least recently visited web views. Set it to zero to stop keeping WKWebView pages.
+ *
+ * @fn NIWebViewPool::maximumNumberOfVisitedWebViews
+ */
+
+/**
+ * Returns the number of kept pages.
+ *
+ * @fn NIWebViewPool::numberOfVisitedPages
+ */
+
+/**
+ * Returns the estimated number of bytes held by the kept pages.
+ *
+ * @fn NIWebViewPool::numberOfVisitedPageBytes
+ */
@@ -0,0 +1,435 @@
+//
+// Copyright 2011-2014 NimbusKit
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NIWebViewPool.h"
+
+#import "NimbusCore.h"
+#import <QuartzCore/QuartzCore.h>
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "Nimbus requires ARC support."
+#endif
+
+// WebKit keeps tiles for the screens around the viewport as well as the visible one.
+static const CGFloat kNumberOfTiledScreens = 3;
+
+// A rough floor for the DOM, scripts and decoded images of a page that stays loaded.
+static const unsigned long long kLiveWebPageBytes = 8 * 1024 * 1024;
+
+// Stops whatever the page is playing; a kept page is off-screen and shouldn't be heard.
+static NSString* const kPauseMediaScript =
+    @"Array.prototype.forEach.call(document.querySelectorAll('audio, video'),"
+    @" function(media) { media.pause(); });";
+
+@interface NIWebViewPreload : NSObject
+@property (nonatomic, copy) NSURL* URL;
+@property (nonatomic, strong) WKWebView* webView;
+@property (nonatomic, assign) CFTimeInterval expirationTime;
+@end
+
+@implementation NIWebViewPreload
+@end
+
+@interface NIVisitedWebPage()
+@property (nonatomic, copy) NSURL* URL;
+@property (nonatomic, strong) WKWebView* webView;
+@property (nonatomic, strong) UIImage* snapshot;
+@property (nonatomic, strong) NSCachedURLResponse* cachedResponse;
+@property (nonatomic, assign) unsigned long long numberOfBytes;
+@property (nonatomic, assign) CFTimeInterval expirationTime;
+@end
+
+@implementation NIVisitedWebPage
+@end
+
+@interface NIWebViewPool()
+@property (nonatomic, strong) NSMutableArray* preloads;
+@property (nonatomic, strong) WKProcessPool* processPool;
+@property (nonatomic, strong) NSMutableArray* webViews;
+@property (nonatomic, strong) NIIdleTaskToken* prewarmTask;
+// Least recently visited first.
+@property (nonatomic, strong) NSMutableArray* visitedPages;
+@property (nonatomic, assign) unsigned long long numberOfVisitedPageBytes;
+@end
+
+@implementation NIWebViewPool
+
+- (void)dealloc {
+  [[NIMemoryPressureCoordinator sharedCoordinator] removeObserver:self];
+  [_prewarmTask cancel];
+}
+
++ (NIWebViewPool *)sharedPool {
+  static NIWebViewPool* sharedPool = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sharedPool = [[self alloc] init];
+  });
+  return sharedPool;
+}
+
++ (BOOL)isAvailable {
+  return nil != NSClassFromString(@"WKWebView");
+}
+
+- (id)init {
+  if ((self = [super init])) {
+    _capacity = 1;
+    _webViews = [[NSMutableArray alloc] init];
+    _preloads = [[NSMutableArray alloc] init];
+    _maximumNumberOfPreloadedWebViews = 1;
+    _preloadLifetime = 30;
+    _visitedPages = [[NSMutableArray alloc] init];
+    _maxNumberOfVisitedPageBytes = 32 * 1024 * 1024;
+    _maximumNumberOfVisitedWebViews = 1;
+    _visitedPageLifetime = 300;
+    if ([[self class] isAvailable]) {
+      _processPool = [[WKProcessPool alloc] init];
+    }
+
+    [[NIMemoryPressureCoordinator sharedCoordinator] addObserver:self
+                                                         selector:@selector(didReceiveMemoryPressure:)];
+  }
+  return self;
+}
+
+- (void)didReceiveMemoryPressure:(NSNotification *)notification {
+  if (NIMemoryPressureLevelFromNotification(notification) > NIMemoryPressureLevelNormal) {
+    [self.prewarmTask cancel];
+    self.prewarmTask = nil;
+    [self.webViews removeAllObjects];
+    [self cancelAllPreloads];
+    [self removeAllVisitedPages];
+  }
+}
+
+- (WKWebView *)createWebView {
+  WKWebViewConfiguration* configuration = [[WKWebViewConfiguration alloc] init];
+  configuration.processPool = self.processPool;
+  return [[WKWebView alloc] initWithFrame:CGRectZero configuration:configuration];
+}
+
+- (void)setCapacity:(NSUInteger)capacity {
+  _capacity = capacity;
+  if (self.webViews.count > capacity) {
+    [self.webViews removeObjectsInRange:NSMakeRange(capacity, self.webViews.count - capacity)];
+  }
+}
+
+- (WKWebView *)dequeueWebView {
+  NIDASSERT([NSThread isMainThread]);
+  if (![[self class] isAvailable]) {
+    return nil;
+  }
+
+  WKWebView* webView = [self.webViews lastObject];
+  if (nil != webView) {
+    [self.webViews removeLastObject];
+  } else {
+    webView = [self createWebView];
+  }
+
+  [self prewarm];
+  return webView;
+}
+
+- (void)prewarm {
+  NIDASSERT([NSThread isMainThread]);
+  if (![[self class] isAvailable] || nil != self.prewarmTask) {
+    return;
+  }
+
+  __weak NIWebViewPool* weakSelf = self;
+  // Low priority because creating a web view takes a good part of a frame, and whatever else is
+  // waiting on the idle scheduler is more likely to be needed on this screen.
+  self.prewarmTask = [[NIIdleScheduler sharedScheduler] scheduleTaskWithPriority:NIIdleTaskPriorityLow block:^BOOL{
+    return [weakSelf prewarmNextWebView];
+  }];
+}
+
+// Creates one web view. Returns NO once the pool is full.
+- (BOOL)prewarmNextWebView {
+  if (self.webViews.count < self.capacity) {
+    [self.webViews addObject:[self createWebView]];
+  }
+  if (self.webViews.count < self.capacity) {
+    return YES;
+  }
+  self.prewarmTask = nil;
+  return NO;
+}
+
+- (NSUInteger)numberOfPrewarmedWebViews {
+  return self.webViews.count;
+}
+
+#pragma mark - Preloading
+
+// Preloads are matched on the absolute string so that equal URLs built differently match.
+- (NIWebViewPreload *)preloadForURL:(NSURL *)URL {
+  NSString* absoluteString = URL.absoluteString;
+  for (NIWebViewPreload* preload in self.preloads) {
+    if ([preload.URL.absoluteString isEqualToString:absoluteString]) {
+      return preload;
+    }
+  }
+  return nil;
+}
+
+- (void)removePreload:(NIWebViewPreload *)preload {
+  [preload.webView stopLoading];
+  [self.preloads removeObject:preload];
+}
+
+- (void)removeExpiredPreloads {
+  CFTimeInterval now = CACurrentMediaTime();
+  for (NIWebViewPreload* preload in [self.preloads copy]) {
+    if (preload.expirationTime <= now) {
+      [self removePreload:preload];
+    }
+  }
+}
+
+- (void)preloadURL:(NSURL *)URL {
+  NIDASSERT([NSThread isMainThread]);
+  if (nil == URL || 0 == self.maximumNumberOfPreloadedWebViews || ![[self class] isAvailable]) {
+    return;
+  }
+
+  [self removeExpiredPreloads];
+  if (nil != [self preloadForURL:URL]) {
+    return;
+  }
+
+  // Preloads are appended, so the oldest is at the front.
+  while (self.preloads.count >= self.maximumNumberOfPreloadedWebViews) {
+    [self removePreload:[self.preloads firstObject]];
+  }
+
+  NIWebViewPreload* preload = [[NIWebViewPreload alloc] init];
+  preload.URL = URL;
+  preload.webView = [self dequeueWebView];
+  // Lay the page out at the size it will most likely be shown at.
+  preload.webView.frame = [UIScreen mainScreen].bounds;
+  preload.expirationTime = CACurrentMediaTime() + self.preloadLifetime;
+  [self.preloads addObject:preload];
+  [preload.webView loadRequest:[NSURLRequest requestWithURL:URL]];
+
+  __weak NIWebViewPool* weakSelf = self;
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.preloadLifetime * NSEC_PER_SEC)),
+                 dispatch_get_main_queue(), ^{
+    [weakSelf removeExpiredPreloads];
+  });
+}
+
+- (WKWebView *)dequeuePreloadedWebViewForURL:(NSURL *)URL {
+  NIDASSERT([NSThread isMainThread]);
+  [self removeExpiredPreloads];
+
+  NIWebViewPreload* preload = [self preloadForURL:URL];
+  if (nil == preload) {
+    return nil;
+  }
+  [self.preloads removeObject:preload];
+  return preload.webView;
+}
+
+- (void)cancelPreloadOfURL:(NSURL *)URL {
+  NIWebViewPreload* preload = [self preloadForURL:URL];
+  if (nil != preload) {
+    [self removePreload:preload];
+  }
+}
+
+- (void)cancelAllPreloads {
+  for (NIWebViewPreload* preload in [self.preloads copy]) {
+    [self removePreload:preload];
+  }
+}
+
+- (void)setMaximumNumberOfPreloadedWebViews:(NSUInteger)maximumNumberOfPreloadedWebViews {
+  _maximumNumberOfPreloadedWebViews = maximumNumberOfPreloadedWebViews;
+  while (self.preloads.count > maximumNumberOfPreloadedWebViews) {
+    [self removePreload:[self.preloads firstObject]];
+  }
+}
+
+- (NSUInteger)numberOfPreloadedWebViews {
+  [self removeExpiredPreloads];
+  return self.preloads.count;
+}
+
+#pragma mark - Recently Visited Pages
+
+- (NIVisitedWebPage *)visitedPageForURL:(NSURL *)URL {
+  NSString* absoluteString = URL.absoluteString;
+  for (NIVisitedWebPage* page in self.visitedPages) {
+    if ([page.URL.absoluteString isEqualToString:absoluteString]) {
+      return page;
+    }
+  }
+  return nil;
+}
+
+- (void)removeVisitedPage:(NIVisitedWebPage *)page {
+  self.numberOfVisitedPageBytes -= page.numberOfBytes;
+  [self.visitedPages removeObject:page];
+}
+
+- (void)removeExpiredVisitedPages {
+  CFTimeInterval now = CACurrentMediaTime();
+  for (NIVisitedWebPage* page in [self.visitedPages copy]) {
+    if (page.expirationTime <= now) {
+      [self removeVisitedPage:page];
+    }
+  }
+}
+
+- (void)trimVisitedPagesToNumberOfBytes:(unsigned long long)numberOfBytes {
+  while (self.visitedPages.count > 0 && self.numberOfVisitedPageBytes > numberOfBytes) {
+    [self removeVisitedPage:[self.visitedPages firstObject]];
+  }
+}
+
+- (NSUInteger)numberOfVisitedWebViews {
+  NSUInteger numberOfWebViews = 0;
+  for (NIVisitedWebPage* page in self.visitedPages) {
+    if (nil != page.webView) {
+      ++numberOfWebViews;
+    }
+  }
+  return numberOfWebViews;
+}
+
+// Discards the least recently visited pages that keep a web view until no more than the given
+// number are left.
+- (void)trimVisitedWebViewsToCount:(NSUInteger)count {
+  NSUInteger numberOfWebViews = [self numberOfVisitedWebViews];
+  for (NIVisitedWebPage* page in [self.visitedPages copy]) {
+    if (numberOfWebViews <= count) {
+      break;
+    }
+    if (nil != page.webView) {
+      [self removeVisitedPage:page];
+      --numberOfWebViews;
+    }
+  }
+}
+
+- (void)storeVisitedPage:(NIVisitedWebPage *)page {
+  NIDASSERT([NSThread isMainThread]);
+  if (nil == page.URL || page.numberOfBytes > self.maxNumberOfVisitedPageBytes) {
+    return;
+  }
+  if (nil != page.webView && 0 == self.maximumNumberOfVisitedWebViews) {
+    return;
+  }
+
+  NIVisitedWebPage* previousPage = [self visitedPageForURL:page.URL];
+  if (nil != previousPage) {
+    [self removeVisitedPage:previousPage];
+  }
+  [self removeExpiredVisitedPages];
+  if (nil != page.webView) {
+    [self trimVisitedWebViewsToCount:self.maximumNumberOfVisitedWebViews - 1];
+  }
+  [self trimVisitedPagesToNumberOfBytes:self.maxNumberOfVisitedPageBytes - page.numberOfBytes];
+
+  page.expirationTime = CACurrentMediaTime() + self.visitedPageLifetime;
+  [self.visitedPages addObject:page];
+  self.numberOfVisitedPageBytes += page.numberOfBytes;
+}
+
+- (void)storeVisitedWebView:(WKWebView *)webView forURL:(NSURL *)URL {
+  if (nil == webView) {
+    return;
+  }
+  [webView stopLoading];
+  [webView evaluateJavaScript:kPauseMediaScript completionHandler:nil];
+  webView.navigationDelegate = nil;
+  [webView removeFromSuperview];
+
+  // The page stays loaded, so it costs its tiles plus everything the web content process holds
+  // for it.
+  CGFloat scale = [UIScreen mainScreen].scale;
+  CGSize size = webView.bounds.size;
+  unsigned long long tileBytes =
+      (unsigned long long)(size.width * scale * size.height * scale * 4 * kNumberOfTiledScreens);
+
+  NIVisitedWebPage* page = [[NIVisitedWebPage alloc] init];
+  page.URL = URL;
+  page.webView = webView;
+  page.numberOfBytes = tileBytes + kLiveWebPageBytes;
+  [self storeVisitedPage:page];
+}
+
+- (void)storeVisitedSnapshot:(UIImage *)snapshot cachedResponse:(NSCachedURLResponse *)cachedResponse forURL:(NSURL *)URL {
+  if (nil == snapshot && nil == cachedResponse) {
+    return;
+  }
+  CGImageRef imageRef = snapshot.CGImage;
+  unsigned long long snapshotBytes = ((NULL != imageRef)
+                                      ? CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef)
+                                      : 0);
+
+  NIVisitedWebPage* page = [[NIVisitedWebPage alloc] init];
+  page.URL = URL;
+  page.snapshot = snapshot;
+  page.cachedResponse = cachedResponse;
+  page.numberOfBytes = snapshotBytes + cachedResponse.data.length;
+  [self storeVisitedPage:page];
+}
+
+- (NIVisitedWebPage *)dequeueVisitedPageForURL:(NSURL *)URL {
+  NIDASSERT([NSThread isMainThread]);
+  [self removeExpiredVisitedPages];
+
+  NIVisitedWebPage* page = [self visitedPageForURL:URL];
+  if (nil != page) {
+    [self removeVisitedPage:page];
+  }
+  return page;
+}
+
+- (void)removeVisitedPageForURL:(NSURL *)URL {
+  NIVisitedWebPage* page = [self visitedPageForURL:URL];
+  if (nil != page) {
+    [self removeVisitedPage:page];
+  }
+}
+
+- (void)removeAllVisitedPages {
+  [self.visitedPages removeAllObjects];
+  self.numberOfVisitedPageBytes = 0;
+}
+
+- (void)setMaxNumberOfVisitedPageBytes:(unsigned long long)maxNumberOfVisitedPageBytes {
+  _maxNumberOfVisitedPageBytes = maxNumberOfVisitedPageBytes;
+  [self trimVisitedPagesToNumberOfBytes:maxNumberOfVisitedPageBytes];
+}
+
+- (void)setMaximumNumberOfVisitedWebViews:(NSUInteger)maximumNumberOfVisitedWebViews {
+  _maximumNumberOfVisitedWebViews = maximumNumberOfVisitedWebViews;
+  [self trimVisitedWebViewsToCount:maximumNumberOfVisitedWebViews];
+}
+
+- (NSUInteger)numberOfVisitedPages {
+  [self removeExpiredVisitedPages];
+  return self.visitedPages.count;
+}
+
+@end
@@ -55,3 +55,4 @@
 
 #import "NimbusCore.h"
 #import "NIWebController.h"
+#import "NIWebViewPool.h"
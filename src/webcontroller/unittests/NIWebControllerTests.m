@@ -30,4 +30,215 @@
 - (void)testNothing {
 }
 
+- (UIImage *)imageWithSize:(CGSize)size {
+  UIGraphicsBeginImageContextWithOptions(size, YES, 1);
+  UIImage* image = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  return image;
+}
+
+- (void)spinRunLoopUntil:(BOOL (^)(void))condition {
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (!condition() && [timeout timeIntervalSinceNow] > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+}
+
+- (void)testDequeuedWebViewsShareTheProcessPool {
+  if (![NIWebViewPool isAvailable]) {
+    return;
+  }
+  NIWebViewPool* pool = [[NIWebViewPool alloc] init];
+  WKWebView* first = [pool dequeueWebView];
+  WKWebView* second = [pool dequeueWebView];
+
+  XCTAssertNotNil(first, @"An empty pool should create a web view on demand.");
+  XCTAssertNotEqual(first, second, @"Web views should never be handed out twice.");
+  XCTAssertEqual(first.configuration.processPool, pool.processPool);
+  XCTAssertEqual(second.configuration.processPool, pool.processPool);
+}
+
+- (void)testPrewarmingFillsThePoolWhenIdle {
+  if (![NIWebViewPool isAvailable]) {
+    return;
+  }
+  NIWebViewPool* pool = [[NIWebViewPool alloc] init];
+  pool.capacity = 2;
+  [pool prewarm];
+  XCTAssertEqual(pool.numberOfPrewarmedWebViews, (NSUInteger)0, @"Web views should be created when idle.");
+
+  [self spinRunLoopUntil:^BOOL{ return pool.numberOfPrewarmedWebViews == 2; }];
+  XCTAssertEqual(pool.numberOfPrewarmedWebViews, (NSUInteger)2);
+
+  WKWebView* webView = [pool dequeueWebView];
+  XCTAssertEqual(webView.configuration.processPool, pool.processPool);
+  XCTAssertEqual(pool.numberOfPrewarmedWebViews, (NSUInteger)1, @"A prewarmed web view should be handed out.");
+  [self spinRunLoopUntil:^BOOL{ return pool.numberOfPrewarmedWebViews == 2; }];
+  XCTAssertEqual(pool.numberOfPrewarmedWebViews, (NSUInteger)2, @"Dequeuing should refill the pool.");
+
+  pool.capacity = 1;
+  XCTAssertEqual(pool.numberOfPrewarmedWebViews, (NSUInteger)1, @"Lowering the capacity releases the excess.");
+}
+
+- (void)testMemoryPressureEmptiesThePool {
+  if (![NIWebViewPool isAvailable]) {
+    return;
+  }
+  NIWebViewPool* pool = [[NIWebViewPool alloc] init];
+  [pool prewarm];
+  [self spinRunLoopUntil:^BOOL{ return pool.numberOfPrewarmedWebViews == 1; }];
+  [pool preloadURL:[NSURL URLWithString:@"http://example.com/preloaded"]];
+  [pool storeVisitedSnapshot:[self imageWithSize:CGSizeMake(10, 10)]
+              cachedResponse:nil
+                      forURL:[NSURL URLWithString:@"http://example.com/visited"]];
+  // Preloading takes the prewarmed web view, so wait for its replacement.
+  [self spinRunLoopUntil:^BOOL{ return pool.numberOfPrewarmedWebViews == 1; }];
+  XCTAssertEqual(pool.numberOfPrewarmedWebViews, (NSUInteger)1);
+  XCTAssertEqual(pool.numberOfPreloadedWebViews, (NSUInteger)1);
+  XCTAssertEqual(pool.numberOfVisitedPages, (NSUInteger)1);
+
+  NIMemoryPressureCoordinator* coordinator = [NIMemoryPressureCoordinator sharedCoordinator];
+  [coordinator postMemoryPressureWithLevel:NIMemoryPressureLevelWarning];
+  XCTAssertEqual(pool.numberOfPrewarmedWebViews, (NSUInteger)0);
+  XCTAssertEqual(pool.numberOfPreloadedWebViews, (NSUInteger)0);
+  XCTAssertEqual(pool.numberOfVisitedPages, (NSUInteger)0);
+
+  [coordinator postMemoryPressureWithLevel:NIMemoryPressureLevelNormal];
+  [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+  XCTAssertEqual(pool.numberOfPrewarmedWebViews, (NSUInteger)0, @"The pool shouldn't refill on its own.");
+}
+
+- (void)testPreloadedWebViewsAreHandedOutOnce {
+  if (![NIWebViewPool isAvailable]) {
+    return;
+  }
+  NIWebViewPool* pool = [[NIWebViewPool alloc] init];
+  pool.maximumNumberOfPreloadedWebViews = 2;
+  NSURL* URL = [NSURL URLWithString:@"http://example.com/article"];
+  [pool preloadURL:URL];
+  [pool preloadURL:URL];
+  XCTAssertEqual(pool.numberOfPreloadedWebViews, (NSUInteger)1, @"A URL should only be preloaded once.");
+
+  WKWebView* webView = [pool dequeuePreloadedWebViewForURL:[NSURL URLWithString:@"http://example.com/article"]];
+  XCTAssertNotNil(webView, @"Equal URLs should match even when they are different objects.");
+  XCTAssertEqual(webView.configuration.processPool, pool.processPool);
+  XCTAssertTrue(CGRectEqualToRect(webView.frame, [UIScreen mainScreen].bounds),
+                @"The page should be laid out at the size it will be shown at.");
+  XCTAssertNil([pool dequeuePreloadedWebViewForURL:URL], @"A preload should only be adopted once.");
+  XCTAssertEqual(pool.numberOfPreloadedWebViews, (NSUInteger)0);
+}
+
+- (void)testPreloadsStayWithinTheirBudget {
+  if (![NIWebViewPool isAvailable]) {
+    return;
+  }
+  NIWebViewPool* pool = [[NIWebViewPool alloc] init];
+  NSURL* first = [NSURL URLWithString:@"http://example.com/1"];
+  NSURL* second = [NSURL URLWithString:@"http://example.com/2"];
+  [pool preloadURL:first];
+  [pool preloadURL:second];
+  XCTAssertEqual(pool.numberOfPreloadedWebViews, (NSUInteger)1);
+  XCTAssertNil([pool dequeuePreloadedWebViewForURL:first], @"The oldest preload should make room.");
+  XCTAssertNotNil([pool dequeuePreloadedWebViewForURL:second]);
+
+  pool.maximumNumberOfPreloadedWebViews = 0;
+  [pool preloadURL:first];
+  XCTAssertEqual(pool.numberOfPreloadedWebViews, (NSUInteger)0, @"A budget of zero turns preloading off.");
+}
+
+- (void)testPreloadsExpire {
+  if (![NIWebViewPool isAvailable]) {
+    return;
+  }
+  NIWebViewPool* pool = [[NIWebViewPool alloc] init];
+  pool.preloadLifetime = 0.1;
+  NSURL* URL = [NSURL URLWithString:@"http://example.com/expiring"];
+  [pool preloadURL:URL];
+  XCTAssertEqual(pool.numberOfPreloadedWebViews, (NSUInteger)1);
+
+  [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.3]];
+  XCTAssertEqual(pool.numberOfPreloadedWebViews, (NSUInteger)0, @"Unadopted preloads should be let go.");
+  XCTAssertNil([pool dequeuePreloadedWebViewForURL:URL]);
+}
+
+- (void)testControllersAdoptPreloadedWebViews {
+  if (![NIWebViewPool isAvailable]) {
+    return;
+  }
+  NIWebViewPool* pool = [NIWebViewPool sharedPool];
+  [pool cancelAllPreloads];
+  [pool removeAllVisitedPages];
+  NSURL* URL = [NSURL URLWithString:@"http://example.com/adopted"];
+  [pool preloadURL:URL];
+  XCTAssertEqual(pool.numberOfPreloadedWebViews, (NSUInteger)1);
+
+  NIWebController* controller = [[NIWebController alloc] initWithURL:URL];
+  controller.engine = NIWebControllerEngineWKWebView;
+  [controller view];
+
+  XCTAssertEqual(pool.numberOfPreloadedWebViews, (NSUInteger)0, @"The controller should adopt the preload.");
+  XCTAssertNotNil(controller.wkWebView);
+  XCTAssertEqual(controller.wkWebView.navigationDelegate, (id<WKNavigationDelegate>)controller);
+  XCTAssertEqual(controller.wkWebView.superview, controller.view);
+
+  NIWebController* otherController = [[NIWebController alloc] initWithURL:[NSURL URLWithString:@"http://example.com/other"]];
+  otherController.engine = NIWebControllerEngineWKWebView;
+  [otherController view];
+  XCTAssertNotEqual(otherController.wkWebView, controller.wkWebView,
+                    @"Other URLs should get a fresh web view.");
+}
+
+- (void)testVisitedPagesStayWithinTheirByteBudget {
+  NIWebViewPool* pool = [[NIWebViewPool alloc] init];
+  UIImage* snapshot = [self imageWithSize:CGSizeMake(100, 100)];
+  unsigned long long snapshotBytes =
+      CGImageGetBytesPerRow(snapshot.CGImage) * CGImageGetHeight(snapshot.CGImage);
+  pool.maxNumberOfVisitedPageBytes = snapshotBytes * 2;
+
+  NSURL* first = [NSURL URLWithString:@"http://example.com/1"];
+  NSURL* second = [NSURL URLWithString:@"http://example.com/2"];
+  NSURL* third = [NSURL URLWithString:@"http://example.com/3"];
+  [pool storeVisitedSnapshot:snapshot cachedResponse:nil forURL:first];
+  [pool storeVisitedSnapshot:snapshot cachedResponse:nil forURL:second];
+  [pool storeVisitedSnapshot:snapshot cachedResponse:nil forURL:third];
+
+  XCTAssertEqual(pool.numberOfVisitedPages, (NSUInteger)2, @"The oldest page should be discarded.");
+  XCTAssertEqual(pool.numberOfVisitedPageBytes, snapshotBytes * 2);
+  XCTAssertNil([pool dequeueVisitedPageForURL:first]);
+
+  NIVisitedWebPage* page = [pool dequeueVisitedPageForURL:[third copy]];
+  XCTAssertEqualObjects(page.URL, third);
+  XCTAssertEqual(page.snapshot, snapshot);
+  XCTAssertEqual(pool.numberOfVisitedPages, (NSUInteger)1, @"Dequeued pages leave the pool.");
+
+  pool.maxNumberOfVisitedPageBytes = 0;
+  XCTAssertEqual(pool.numberOfVisitedPages, (NSUInteger)0);
+  XCTAssertEqual(pool.numberOfVisitedPageBytes, 0ULL);
+}
+
+- (void)testVisitedWebViewsAreCappedByCount {
+  if (![NIWebViewPool isAvailable]) {
+    return;
+  }
+  NIWebViewPool* pool = [[NIWebViewPool alloc] init];
+  pool.maxNumberOfVisitedPageBytes = ULLONG_MAX;
+  UIImage* snapshot = [self imageWithSize:CGSizeMake(10, 10)];
+
+  NSURL* first = [NSURL URLWithString:@"http://example.com/1"];
+  NSURL* second = [NSURL URLWithString:@"http://example.com/2"];
+  NSURL* third = [NSURL URLWithString:@"http://example.com/3"];
+  [pool storeVisitedWebView:[pool dequeueWebView] forURL:first];
+  [pool storeVisitedSnapshot:snapshot cachedResponse:nil forURL:second];
+  [pool storeVisitedWebView:[pool dequeueWebView] forURL:third];
+
+  XCTAssertEqual(pool.numberOfVisitedPages, (NSUInteger)2, @"Only one web view should be kept.");
+  XCTAssertNil([pool dequeueVisitedPageForURL:first], @"The older web view should be discarded.");
+  XCTAssertNotNil([pool dequeueVisitedPageForURL:second].snapshot, @"Snapshots don't count.");
+
+  pool.maximumNumberOfVisitedWebViews = 0;
+  XCTAssertEqual(pool.numberOfVisitedPages, (NSUInteger)0);
+  [pool storeVisitedWebView:[pool dequeueWebView] forURL:first];
+  XCTAssertEqual(pool.numberOfVisitedPages, (NSUInteger)0, @"No web views should be kept.");
+}
+
 @end